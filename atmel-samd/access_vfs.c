@@ -111,8 +111,14 @@ bool vfs_unload(bool unload)
 	return unload;
 }
 
-// TODO(tannewt): Transfer more than a single sector at a time if we need more
-// speed.
+// Sectors are moved over USB and to and from the block device this many at a
+// time. Each USB transfer then covers several packets and the block device can
+// read runs of sectors with a single command. The buffer is static because
+// transfers are run from the VM hook at any stack depth.
+#define SECTORS_PER_TRANSFER (4)
+
+COMPILER_WORD_ALIGNED static uint8_t transfer_buffer[SECTORS_PER_TRANSFER * FLASH_BLOCK_SIZE];
+
 //! This function transfers the memory data to the USB MSC interface
 //!
 //! @param addr         Sector address to start read
@@ -126,16 +132,16 @@ bool vfs_unload(bool unload)
 //!
 Ctrl_status vfs_usb_read_10(uint32_t addr, volatile uint16_t nb_sector)
 {
-    uint8_t sector_buffer[FLASH_BLOCK_SIZE];
-    for (uint16_t sector = 0; sector < nb_sector; sector++) {
-        DRESULT result = disk_read(VFS_INDEX, sector_buffer, addr + sector, 1);
+    for (uint16_t sector = 0; sector < nb_sector; sector += SECTORS_PER_TRANSFER) {
+        uint16_t count = MIN(nb_sector - sector, SECTORS_PER_TRANSFER);
+        DRESULT result = disk_read(VFS_INDEX, transfer_buffer, addr + sector, count);
         if (result == RES_PARERR) {
             return CTRL_NO_PRESENT;
         }
         if (result == RES_ERROR) {
             return CTRL_FAIL;
         }
-        if (!udi_msc_trans_block(true, sector_buffer, FLASH_BLOCK_SIZE, NULL)) {
+        if (!udi_msc_trans_block(true, transfer_buffer, count * FLASH_BLOCK_SIZE, NULL)) {
             return CTRL_FAIL; // transfer aborted
         }
     }
@@ -155,13 +161,13 @@ Ctrl_status vfs_usb_read_10(uint32_t addr, volatile uint16_t nb_sector)
 //!
 Ctrl_status vfs_usb_write_10(uint32_t addr, volatile uint16_t nb_sector)
 {
-    uint8_t sector_buffer[FLASH_BLOCK_SIZE];
-    for (uint16_t sector = 0; sector < nb_sector; sector++) {
-        if (!udi_msc_trans_block(false, sector_buffer, FLASH_BLOCK_SIZE, NULL)) {
+    for (uint16_t sector = 0; sector < nb_sector; sector += SECTORS_PER_TRANSFER) {
+        uint16_t count = MIN(nb_sector - sector, SECTORS_PER_TRANSFER);
+        if (!udi_msc_trans_block(false, transfer_buffer, count * FLASH_BLOCK_SIZE, NULL)) {
             return CTRL_FAIL; // transfer aborted
         }
         uint32_t sector_address = addr + sector;
-        DRESULT result = disk_write(VFS_INDEX, sector_buffer, sector_address, 1);
+        DRESULT result = disk_write(VFS_INDEX, transfer_buffer, sector_address, count);
         if (result == RES_PARERR) {
             return CTRL_NO_PRESENT;
         }
@@ -169,18 +175,19 @@ Ctrl_status vfs_usb_write_10(uint32_t addr, volatile uint16_t nb_sector)
             return CTRL_FAIL;
         }
         // Since by getting here we assume the mount is read-only to MicroPython
-        // lets update the cached FatFs sector if its the one we just wrote.
+        // lets update the cached FatFs sector if its one we just wrote.
         fs_user_mount_t *vfs =  MP_STATE_PORT(fs_user_mount)[VFS_INDEX];
-        volatile uint16_t x = addr;
-        (void) x;
         #if _MAX_SS != _MIN_SS
         if (vfs->ssize == FLASH_BLOCK_SIZE) {
         #else
         // The compiler can optimize this away.
         if (_MAX_SS == FLASH_BLOCK_SIZE) {
         #endif
-            if (sector_address == vfs->fatfs.winsect && sector_address > 0) {
-                memcpy(vfs->fatfs.win, sector_buffer, FLASH_BLOCK_SIZE);
+            uint32_t winsect = vfs->fatfs.winsect;
+            if (winsect > 0 && sector_address <= winsect && winsect < sector_address + count) {
+                memcpy(vfs->fatfs.win,
+                       transfer_buffer + (winsect - sector_address) * FLASH_BLOCK_SIZE,
+                       FLASH_BLOCK_SIZE);
             }
         }
     }
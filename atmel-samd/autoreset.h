@@ -28,8 +28,11 @@
 #define __MICROPY_INCLUDED_ATMEL_SAMD_AUTORESET_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 extern volatile bool reset_next_character;
+// Milliseconds left until the reset, or 0 when none is pending.
+extern volatile uint32_t autoreset_delay_ms;
 
 void autoreset_tick(void);
 
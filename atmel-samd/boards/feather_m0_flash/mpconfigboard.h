@@ -6,7 +6,7 @@
 
 #define MICROPY_HW_NEOPIXEL &pin_PA14
 
-#define SPI_FLASH_BAUDRATE  (1000000)
+#define SPI_FLASH_BAUDRATE  (8000000)
 
 // On-board flash
 #define SPI_FLASH_MUX_SETTING SPI_SIGNAL_MUX_SETTING_E
@@ -22,4 +22,4 @@
 
 #include "spi_flash.h"
 
-#define BOARD_FLASH_SIZE (0x00040000 - 0x2000)
+#define BOARD_FLASH_SIZE (0x00040000 - 0x2000 - 0x4000)
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "boot_phases.h"
+
+#include "tick.h"
+
+static mcu_boot_phase_t boot_phases[BOOT_PHASES_MAX];
+static size_t boot_phases_len;
+
+void boot_phases_clear(void) {
+    boot_phases_len = 0;
+}
+
+void boot_phase_end(qstr name) {
+    if (boot_phases_len < BOOT_PHASES_MAX) {
+        boot_phases[boot_phases_len].name = name;
+        boot_phases[boot_phases_len].us = tick_get_us();
+        boot_phases_len++;
+    }
+}
+
+size_t common_hal_mcu_get_boot_phases(const mcu_boot_phase_t **phases) {
+    *phases = boot_phases;
+    return boot_phases_len;
+}
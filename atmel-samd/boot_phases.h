@@ -0,0 +1,46 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_ATMEL_SAMD_BOOT_PHASES_H__
+#define __MICROPY_INCLUDED_ATMEL_SAMD_BOOT_PHASES_H__
+
+#include "shared-bindings/microcontroller/__init__.h"
+
+// The stages of starting up, each marked with the time it ended, in
+// microseconds from tick_init. They live outside of the heap so that they
+// last through reset_mp and can be read from boot.py and code.py with
+// microcontroller.boot_times().
+
+#define BOOT_PHASES_MAX (8)
+
+// Forget the phases of the last start, as a soft reboot starts again.
+void boot_phases_clear(void);
+
+// Mark the end of a phase. Phases past BOOT_PHASES_MAX are dropped.
+void boot_phase_end(qstr name);
+
+
+#endif  // __MICROPY_INCLUDED_ATMEL_SAMD_BOOT_PHASES_H__
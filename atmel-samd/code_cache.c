@@ -0,0 +1,279 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "code_cache.h"
+
+#include "lib/fatfs/ff.h"
+#include "py/emitglue.h"
+#include "py/mpprint.h"
+#include "py/mpstate.h"
+#include "py/nlr.h"
+#include "py/objlist.h"
+#include "py/runtime.h"
+
+// Compiled modules are kept on the internal flash, one file per source path,
+// named after a hash of the path. Each starts with a cache_header_t and the
+// source path followed by the .mpy stream.
+#define CACHE_DIR "/flash/.mpy_cache"
+#define CACHE_MAGIC 0x43
+
+typedef struct {
+    uint8_t magic;
+    uint8_t path_len;
+    uint16_t fdate;
+    uint16_t ftime;
+    uint32_t fsize;
+} cache_header_t;
+
+typedef struct {
+    FIL fp;
+    byte buf[32];
+    uint16_t len;
+    uint16_t pos;
+} cache_reader_t;
+
+typedef struct {
+    FIL fp;
+    bool failed;
+} cache_writer_t;
+
+static bool source_header(const char *source_file, cache_header_t *header) {
+    size_t path_len = strlen(source_file);
+    if (path_len > 0xff) {
+        return false;
+    }
+    FILINFO fno;
+    #if _USE_LFN
+    fno.lfname = NULL;
+    fno.lfsize = 0;
+    #endif
+    if (f_stat(source_file, &fno) != FR_OK) {
+        return false;
+    }
+    memset(header, 0, sizeof(*header));
+    header->magic = CACHE_MAGIC;
+    header->path_len = path_len;
+    header->fdate = fno.fdate;
+    header->ftime = fno.ftime;
+    header->fsize = fno.fsize;
+    return true;
+}
+
+static void cache_path(const char *source_file, char *path) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char *c = source_file; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+    memcpy(path, CACHE_DIR "/", sizeof(CACHE_DIR));
+    path += sizeof(CACHE_DIR);
+    for (int8_t shift = 28; shift >= 0; shift -= 4) {
+        *path++ = "0123456789abcdef"[(hash >> shift) & 0xf];
+    }
+    memcpy(path, ".mpy", 5);
+}
+
+#define CACHE_PATH_SIZE (sizeof(CACHE_DIR) + 8 + 5)
+
+// The cache paths of the files whose bytecode is being run in place. They
+// mustn't be rewritten until the heap is reset.
+#define in_place_paths MP_STATE_PORT(code_cache_in_place)
+
+void code_cache_init(void) {
+    in_place_paths = mp_obj_new_list(0, NULL);
+}
+
+bool code_cache_runs_in_place(void) {
+    mp_obj_list_t *paths = MP_OBJ_TO_PTR(in_place_paths);
+    return paths != NULL && paths->len > 0;
+}
+
+static bool path_in_place(const char *path) {
+    mp_obj_list_t *paths = MP_OBJ_TO_PTR(in_place_paths);
+    for (mp_uint_t i = 0; paths != NULL && i < paths->len; i++) {
+        if (strcmp(mp_obj_str_get_str(paths->items[i]), path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Only the internal flash is mapped in memory.
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP && !defined(SPI_FLASH_SERCOM)
+#define CACHE_IN_PLACE (1)
+#else
+#define CACHE_IN_PLACE (0)
+#endif
+
+#if CACHE_IN_PLACE
+// Where the whole of the open file can be read in place, or NULL if its
+// clusters aren't consecutive.
+static const byte *mapped_file(FIL *fp) {
+    FATFS *fs = fp->fs;
+    if (fp->sclust == 0) {
+        return NULL;
+    }
+    DWORD cluster_size = (DWORD) fs->csize * _MIN_SS;
+    for (DWORD ofs = cluster_size; ofs < fp->fsize; ofs += cluster_size) {
+        // Seeking just past the start of a cluster leaves fp->clust at it.
+        if (f_lseek(fp, ofs + 1) != FR_OK || fp->clust != fp->sclust + ofs / cluster_size) {
+            return NULL;
+        }
+    }
+    DWORD first = fs->database + (fp->sclust - 2) * fs->csize;
+    const byte *start = internal_flash_block_address(first);
+    const byte *end = internal_flash_block_address(first + (fp->fsize - 1) / _MIN_SS);
+    if (start == NULL || end == NULL || (DWORD) (end - start) != (fp->fsize - 1) / _MIN_SS * _MIN_SS) {
+        return NULL;
+    }
+    return start;
+}
+#endif
+
+static mp_uint_t cache_read_byte(void *data) {
+    cache_reader_t *reader = data;
+    if (reader->pos >= reader->len) {
+        UINT n;
+        if (f_read(&reader->fp, reader->buf, sizeof(reader->buf), &n) != FR_OK || n == 0) {
+            return (mp_uint_t) -1;
+        }
+        reader->len = n;
+        reader->pos = 0;
+    }
+    return reader->buf[reader->pos++];
+}
+
+mp_raw_code_t *mp_code_cache_load(const char *source_file) {
+    cache_header_t expected;
+    if (!source_header(source_file, &expected)) {
+        return NULL;
+    }
+    char path[CACHE_PATH_SIZE];
+    cache_path(source_file, path);
+    cache_reader_t reader;
+    if (f_open(&reader.fp, path, FA_READ) != FR_OK) {
+        return NULL;
+    }
+    reader.len = 0;
+    reader.pos = 0;
+
+    // A different source path with the same hash, or a source that has
+    // changed since, is treated as a miss and later overwritten.
+    cache_header_t header;
+    char cached_source[0x100];
+    UINT n;
+    mp_raw_code_t *raw_code = NULL;
+    bool relink = false;
+    if (f_read(&reader.fp, &header, sizeof(header), &n) == FR_OK && n == sizeof(header) &&
+        memcmp(&header, &expected, sizeof(header)) == 0 &&
+        f_read(&reader.fp, cached_source, header.path_len, &n) == FR_OK && n == header.path_len &&
+        memcmp(cached_source, source_file, header.path_len) == 0) {
+        mp_reader_t mp_reader = {&reader, cache_read_byte, NULL};
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            #if CACHE_IN_PLACE
+            size_t code_start = sizeof(header) + header.path_len;
+            const byte *file = mapped_file(&reader.fp);
+            if (file != NULL) {
+                raw_code = mp_raw_code_load_xip(file + code_start, reader.fp.fsize - code_start);
+                if (raw_code != NULL) {
+                    mp_obj_list_append(in_place_paths, mp_obj_new_str(path, strlen(path), false));
+                } else {
+                    // Saved when the qstrs had other ids. Copy it to the heap
+                    // this time and save it again with the current ids, which
+                    // are the same on the next boot if it imports the same
+                    // modules in the same order.
+                    raw_code = mp_raw_code_load_mem(file + code_start, reader.fp.fsize - code_start);
+                    relink = true;
+                }
+            } else
+            #endif
+            {
+                raw_code = mp_raw_code_load(&mp_reader);
+            }
+            nlr_pop();
+        } else {
+            // Truncated or from an incompatible version; compile again.
+            raw_code = NULL;
+            relink = false;
+        }
+    }
+    f_close(&reader.fp);
+    if (relink) {
+        mp_code_cache_store(source_file, raw_code);
+    }
+    return raw_code;
+}
+
+static void cache_print_strn(void *env, const char *str, size_t len) {
+    cache_writer_t *writer = env;
+    UINT n;
+    if (writer->failed || f_write(&writer->fp, str, len, &n) != FR_OK || n != len) {
+        writer->failed = true;
+    }
+}
+
+void mp_code_cache_store(const char *source_file, mp_raw_code_t *raw_code) {
+    cache_header_t header;
+    if (!source_header(source_file, &header)) {
+        return;
+    }
+    // Writes fail with FR_WRITE_PROTECTED while the host owns the file system
+    // over USB. The module is just compiled again next time.
+    FRESULT res = f_mkdir(CACHE_DIR);
+    if (res == FR_OK) {
+        f_chmod(CACHE_DIR, AM_HID, AM_HID);
+    } else if (res != FR_EXIST) {
+        return;
+    }
+    char path[CACHE_PATH_SIZE];
+    cache_path(source_file, path);
+    if (path_in_place(path)) {
+        return;
+    }
+    cache_writer_t writer;
+    if (f_open(&writer.fp, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return;
+    }
+    writer.failed = false;
+    mp_print_t print = {&writer, cache_print_strn};
+    cache_print_strn(&writer, (const char *) &header, sizeof(header));
+    cache_print_strn(&writer, source_file, header.path_len);
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        // Raises if the module contains native code.
+        mp_raw_code_save(raw_code, &print);
+        nlr_pop();
+    } else {
+        writer.failed = true;
+    }
+    if (f_close(&writer.fp) != FR_OK || writer.failed) {
+        f_unlink(path);
+    }
+}
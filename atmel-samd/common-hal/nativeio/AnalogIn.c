@@ -33,32 +33,86 @@
 #include "shared-bindings/nativeio/AnalogIn.h"
 
 #include "asf/sam0/drivers/adc/adc.h"
+#include "asf/sam0/drivers/tc/tc.h"
 
-void common_hal_nativeio_analogin_construct(nativeio_analogin_obj_t* self,
-        const mcu_pin_obj_t *pin) {
-    if (!pin->has_adc) {
-        // No ADC function on that pin
-        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError, "pin %q does not have ADC capabilities", pin->name));
-    }
+#include "shared_dma.h"
 
-    self->pin = pin;
+// We use ENABLE registers below we don't want to treat as a macro.
+#undef ENABLE
+
+// Timer and event channel used to pace captures. TC5 is the millisecond tick.
+#define CAPTURE_TC TC3
+#define CAPTURE_TC_OVF_EVENT EVSYS_ID_GEN_TC3_OVF
+#define CAPTURE_EVSYS_CHANNEL 0
+
+// Fastest rate a 12 bit conversion can keep up with at the capture prescaler.
+#define CAPTURE_MAX_RATE 100000
+
+// The second half of the double buffer. The first half uses the channel's own
+// descriptor.
+COMPILER_ALIGNED(16) static DmacDescriptor capture_second_half;
+
+// The AnalogIn that is capturing lives in MP_STATE_PORT so that it and its
+// buffer stay reachable by the GC.
+#define capture_owner MP_STATE_PORT(adc_capture_owner)
+
+// The object the shared ADC registers were last set up for. Only compared
+// against, never dereferenced, so it doesn't need to be a root pointer.
+void *nativeio_adc_config_owner = NULL;
+
+// Single reads oversample 16 times for a quiet result. Captures take one
+// sample per trigger so they can run at useful rates, left adjusted so the
+// 12 bits land at the top of each 16 bit value.
+static void configure_adc(nativeio_analogin_obj_t* self, bool capture) {
+    // An AnalogInScan may have left the ADC running and adc_init won't touch
+    // it while it is.
+    ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+    while (ADC->STATUS.bit.SYNCBUSY) {}
 
     struct adc_config config_adc;
     adc_get_config_defaults(&config_adc);
 
     config_adc.positive_input = self->pin->adc_input;
-    config_adc.resolution = ADC_RESOLUTION_CUSTOM;
-    config_adc.accumulate_samples = ADC_ACCUMULATE_SAMPLES_16;
-    config_adc.divide_result = ADC_DIVIDE_RESULT_16;
-    config_adc.clock_prescaler = ADC_CLOCK_PRESCALER_DIV128;
+    if (capture) {
+        config_adc.resolution = ADC_RESOLUTION_12BIT;
+        config_adc.clock_prescaler = ADC_CLOCK_PRESCALER_DIV32;
+        config_adc.left_adjust = true;
+        config_adc.event_action = ADC_EVENT_ACTION_START_CONV;
+    } else {
+        config_adc.resolution = ADC_RESOLUTION_CUSTOM;
+        config_adc.accumulate_samples = ADC_ACCUMULATE_SAMPLES_16;
+        config_adc.divide_result = ADC_DIVIDE_RESULT_16;
+        config_adc.clock_prescaler = ADC_CLOCK_PRESCALER_DIV128;
+    }
 
     adc_init(&self->adc_instance, ADC, &config_adc);
+    nativeio_adc_config_owner = self;
+}
+
+void common_hal_nativeio_analogin_construct(nativeio_analogin_obj_t* self,
+        const mcu_pin_obj_t *pin) {
+    if (!pin->has_adc) {
+        // No ADC function on that pin
+        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError, "pin %q does not have ADC capabilities", pin->name));
+    }
+
+    self->pin = pin;
+    self->capture_buffer = MP_OBJ_NULL;
+    configure_adc(self, false);
 }
 
 // TODO(tannewt): Don't turn it all on just for one read. This simplifies
 // handling of reading multiple inputs and surviving sleep though so for now its
 // ok.
 uint16_t common_hal_nativeio_analogin_get_value(nativeio_analogin_obj_t *self) {
+    if (capture_owner != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "ADC is busy capturing"));
+    }
+    // All AnalogIns share the one ADC so put our settings back if someone
+    // else has changed them.
+    if (nativeio_adc_config_owner != self) {
+        configure_adc(self, false);
+    }
     adc_enable(&self->adc_instance);
     adc_start_conversion(&self->adc_instance);
 
@@ -74,3 +128,102 @@ uint16_t common_hal_nativeio_analogin_get_value(nativeio_analogin_obj_t *self) {
     adc_disable(&self->adc_instance);
     return data;
 }
+
+void common_hal_nativeio_analogin_start_capture(nativeio_analogin_obj_t *self,
+        mp_obj_t buffer, uint16_t *data, size_t len, uint32_t sample_rate) {
+    if (capture_owner != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "ADC is busy capturing"));
+    }
+    if (len < 2 || len % 2 != 0 || len / 2 > 0xffff) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid capture buffer length."));
+    }
+    if (sample_rate == 0 || sample_rate > CAPTURE_MAX_RATE) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid sample rate."));
+    }
+
+    // Pick the smallest prescaler that lets the period fit in 16 bits.
+    static const uint16_t prescalers[] = {1, 2, 4, 8, 16, 64, 256, 1024};
+    uint32_t ticks = system_cpu_clock_get_hz() / sample_rate;
+    uint8_t prescaler_index = 0;
+    while (ticks / prescalers[prescaler_index] > 0x10000) {
+        prescaler_index++;
+        if (prescaler_index == MP_ARRAY_SIZE(prescalers)) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid sample rate."));
+        }
+    }
+
+    struct tc_config config_tc;
+    tc_get_config_defaults(&config_tc);
+    config_tc.counter_size = TC_COUNTER_SIZE_16BIT;
+    config_tc.wave_generation = TC_WAVE_GENERATION_MATCH_FREQ;
+    config_tc.clock_prescaler = TC_CTRLA_PRESCALER(prescaler_index);
+    config_tc.counter_16_bit.compare_capture_channel[0] = ticks / prescalers[prescaler_index] - 1;
+    if (tc_init(&self->tc_instance, CAPTURE_TC, &config_tc) != STATUS_OK) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "Capture timer in use."));
+    }
+    struct tc_events events_tc = { .generate_event_on_overflow = true };
+    tc_enable_events(&self->tc_instance, &events_tc);
+
+    // Route timer overflows to the ADC start conversion input.
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+    EVSYS->USER.reg = EVSYS_USER_CHANNEL(CAPTURE_EVSYS_CHANNEL + 1) |
+        EVSYS_USER_USER(EVSYS_ID_USER_ADC_START);
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(CAPTURE_EVSYS_CHANNEL) |
+        EVSYS_CHANNEL_EVGEN(CAPTURE_TC_OVF_EVENT) |
+        EVSYS_CHANNEL_PATH_ASYNCHRONOUS;
+
+    configure_adc(self, true);
+
+    // Each result is moved into the buffer as it's ready. The two halves are
+    // linked into a ring and each raises the block done flag when full.
+    shared_dma_init();
+    shared_dma_configure(SHARED_DMA_ADC_CHANNEL, ADC_DMAC_ID_RESRDY);
+    size_t half_len = len / 2;
+    DmacDescriptor *first_half = shared_dma_descriptor(SHARED_DMA_ADC_CHANNEL);
+    DmacDescriptor *halves[2] = {first_half, &capture_second_half};
+    for (int i = 0; i < 2; i++) {
+        halves[i]->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_DSTINC |
+            DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_BLOCKACT_INT;
+        halves[i]->BTCNT.reg = half_len;
+        halves[i]->SRCADDR.reg = (uint32_t) &ADC->RESULT.reg;
+        // With address increment enabled the DMAC wants the end address.
+        halves[i]->DSTADDR.reg = (uint32_t) (data + (i + 1) * half_len);
+        halves[i]->DESCADDR.reg = (uint32_t) halves[1 - i];
+    }
+
+    self->capture_buffer = buffer;
+    self->next_half = 0;
+    capture_owner = self;
+    shared_dma_block_done(SHARED_DMA_ADC_CHANNEL);
+    shared_dma_enable(SHARED_DMA_ADC_CHANNEL);
+    adc_enable(&self->adc_instance);
+    tc_enable(&self->tc_instance);
+}
+
+int8_t common_hal_nativeio_analogin_capture_ready(nativeio_analogin_obj_t *self) {
+    if (capture_owner != self || !shared_dma_block_done(SHARED_DMA_ADC_CHANNEL)) {
+        return -1;
+    }
+    int8_t half = self->next_half;
+    self->next_half = 1 - half;
+    return half;
+}
+
+void common_hal_nativeio_analogin_stop_capture(nativeio_analogin_obj_t *self) {
+    if (capture_owner != self) {
+        return;
+    }
+    tc_disable(&self->tc_instance);
+    tc_reset(&self->tc_instance);
+    shared_dma_abort(SHARED_DMA_ADC_CHANNEL);
+    adc_disable(&self->adc_instance);
+    configure_adc(self, false);
+    self->capture_buffer = MP_OBJ_NULL;
+    capture_owner = NULL;
+}
+
+void reset_analogin_capture(void) {
+    CAPTURE_TC->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    ADC->EVCTRL.reg = 0;
+    capture_owner = NULL;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/nlr.h"
+#include "py/runtime.h"
+#include "shared-bindings/nativeio/AnalogInScan.h"
+
+#include "asf/sam0/drivers/adc/adc.h"
+#include "asf/sam0/drivers/system/pinmux/pinmux.h"
+
+// We use ENABLE registers below we don't want to treat as a macro.
+#undef ENABLE
+
+// Shared with AnalogIn so that whoever uses the ADC next knows to set it up
+// again.
+extern void *nativeio_adc_config_owner;
+
+static void configure_adc(nativeio_analoginscan_obj_t* self) {
+    // Someone else may have left the ADC running and adc_init won't touch it
+    // while it is.
+    ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+    while (ADC->STATUS.bit.SYNCBUSY) {}
+
+    // Single left adjusted 12 bit samples so results are scaled to 16 bits
+    // like AnalogIn. The scan range isn't handed to ASF because it would
+    // switch every pin in the range to analog, not just ours.
+    struct adc_config config_adc;
+    adc_get_config_defaults(&config_adc);
+    config_adc.positive_input = self->first_input;
+    config_adc.resolution = ADC_RESOLUTION_12BIT;
+    config_adc.clock_prescaler = ADC_CLOCK_PRESCALER_DIV32;
+    config_adc.left_adjust = true;
+    adc_init(&self->adc_instance, ADC, &config_adc);
+
+    if (self->num_inputs > 1) {
+        ADC->INPUTCTRL.bit.INPUTSCAN = self->num_inputs - 1;
+        while (ADC->STATUS.bit.SYNCBUSY) {}
+    }
+    adc_enable(&self->adc_instance);
+    nativeio_adc_config_owner = self;
+}
+
+void common_hal_nativeio_analoginscan_construct(nativeio_analoginscan_obj_t* self,
+        const mcu_pin_obj_t **pins, size_t num_pins) {
+    if (MP_STATE_PORT(adc_capture_owner) != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "ADC is busy capturing"));
+    }
+    uint8_t first_input = 0xff;
+    uint8_t last_input = 0;
+    for (size_t i = 0; i < num_pins; i++) {
+        if (!pins[i]->has_adc) {
+            nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError, "pin %q does not have ADC capabilities", pins[i]->name));
+        }
+        uint8_t input = pins[i]->adc_input;
+        first_input = MIN(first_input, input);
+        last_input = MAX(last_input, input);
+    }
+    if (last_input - first_input >= NATIVEIO_ANALOGINSCAN_MAX_PINS) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Pins span too many ADC inputs."));
+    }
+
+    self->first_input = first_input;
+    self->num_inputs = last_input - first_input + 1;
+    self->num_pins = num_pins;
+    for (size_t i = 0; i < num_pins; i++) {
+        self->offsets[i] = pins[i]->adc_input - first_input;
+
+        struct system_pinmux_config config;
+        system_pinmux_get_config_defaults(&config);
+        config.input_pull = SYSTEM_PINMUX_PIN_PULL_NONE;
+        config.mux_position = 1;
+        system_pinmux_pin_set_config(pins[i]->pin, &config);
+    }
+
+    configure_adc(self);
+}
+
+void common_hal_nativeio_analoginscan_deinit(nativeio_analoginscan_obj_t* self) {
+    if (nativeio_adc_config_owner == self) {
+        adc_disable(&self->adc_instance);
+        nativeio_adc_config_owner = NULL;
+    }
+}
+
+void common_hal_nativeio_analoginscan_read(nativeio_analoginscan_obj_t *self, uint16_t *values) {
+    if (MP_STATE_PORT(adc_capture_owner) != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "ADC is busy capturing"));
+    }
+    if (nativeio_adc_config_owner != self) {
+        configure_adc(self);
+    }
+
+    // Each conversion moves the scan on to the next input and wraps back to
+    // the first after the last, so taking exactly num_inputs results leaves
+    // it ready for the next read.
+    uint16_t results[NATIVEIO_ANALOGINSCAN_MAX_PINS];
+    for (uint8_t i = 0; i < self->num_inputs; i++) {
+        adc_start_conversion(&self->adc_instance);
+        enum status_code status;
+        do {
+            status = adc_read(&self->adc_instance, &results[i]);
+        } while (status == STATUS_BUSY);
+    }
+    for (uint8_t i = 0; i < self->num_pins; i++) {
+        values[i] = results[self->offsets[i]];
+    }
+}
@@ -32,6 +32,28 @@
 #include "shared-bindings/nativeio/AnalogOut.h"
 
 #include "asf/sam0/drivers/dac/dac.h"
+#include "asf/sam0/drivers/tc/tc.h"
+
+#include "shared_dma.h"
+
+// We use ENABLE registers below we don't want to treat as a macro.
+#undef ENABLE
+
+// Timer whose overflows pace playback. TC3 paces AnalogIn captures and TC5
+// is the millisecond tick.
+#define PLAYBACK_TC TC4
+#define PLAYBACK_TC_DMAC_ID TC4_DMAC_ID_OVF
+
+// The DAC needs about 2.85us to settle after each new value.
+#define PLAYBACK_MAX_RATE 350000
+
+// The second half of the double buffer. The first half uses the channel's own
+// descriptor.
+COMPILER_ALIGNED(16) static DmacDescriptor playback_second_half;
+
+// The AnalogOut that is playing lives in MP_STATE_PORT so that it and its
+// buffer stay reachable by the GC.
+#define playback_owner MP_STATE_PORT(dac_playback_owner)
 
 void common_hal_nativeio_analogout_construct(nativeio_analogout_obj_t* self,
         const mcu_pin_obj_t *pin) {
@@ -43,6 +65,9 @@ void common_hal_nativeio_analogout_construct(nativeio_analogout_obj_t* self,
     struct dac_config config_dac;
     dac_get_config_defaults(&config_dac);
     config_dac.reference = DAC_REFERENCE_AVCC;
+    // Values are 16 bit with the DAC's 10 bits at the top so samples can be
+    // moved straight into DATA.
+    config_dac.left_adjust = true;
     enum status_code status = dac_init(&self->dac_instance, DAC, &config_dac);
     if (status != STATUS_OK) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
@@ -56,14 +81,110 @@ void common_hal_nativeio_analogout_construct(nativeio_analogout_obj_t* self,
     dac_chan_enable(&self->dac_instance, DAC_CHANNEL_0);
 
     dac_enable(&self->dac_instance);
+    self->playback_buffer = MP_OBJ_NULL;
 }
 
 void common_hal_nativeio_analogout_deinit(nativeio_analogout_obj_t *self) {
+    common_hal_nativeio_analogout_stop_playback(self);
     dac_disable(&self->dac_instance);
     dac_chan_disable(&self->dac_instance, DAC_CHANNEL_0);
 }
 
 void common_hal_nativeio_analogout_set_value(nativeio_analogout_obj_t *self,
         uint16_t value) {
+    if (playback_owner != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "DAC is busy playing"));
+    }
     dac_chan_write(&self->dac_instance, DAC_CHANNEL_0, value);
 }
+
+void common_hal_nativeio_analogout_start_playback(nativeio_analogout_obj_t *self,
+        mp_obj_t buffer, const uint16_t *data, size_t len, uint32_t sample_rate, bool loop) {
+    if (playback_owner != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "DAC is busy playing"));
+    }
+    if (len < 2 || len % 2 != 0 || len / 2 > 0xffff) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid playback buffer length."));
+    }
+    if (sample_rate == 0 || sample_rate > PLAYBACK_MAX_RATE) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid sample rate."));
+    }
+
+    // Pick the smallest prescaler that lets the period fit in 16 bits.
+    static const uint16_t prescalers[] = {1, 2, 4, 8, 16, 64, 256, 1024};
+    uint32_t ticks = system_cpu_clock_get_hz() / sample_rate;
+    uint8_t prescaler_index = 0;
+    while (ticks / prescalers[prescaler_index] > 0x10000) {
+        prescaler_index++;
+        if (prescaler_index == MP_ARRAY_SIZE(prescalers)) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid sample rate."));
+        }
+    }
+
+    struct tc_config config_tc;
+    tc_get_config_defaults(&config_tc);
+    config_tc.counter_size = TC_COUNTER_SIZE_16BIT;
+    config_tc.wave_generation = TC_WAVE_GENERATION_MATCH_FREQ;
+    config_tc.clock_prescaler = TC_CTRLA_PRESCALER(prescaler_index);
+    config_tc.counter_16_bit.compare_capture_channel[0] = ticks / prescalers[prescaler_index] - 1;
+    if (tc_init(&self->tc_instance, PLAYBACK_TC, &config_tc) != STATUS_OK) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "Playback timer in use."));
+    }
+
+    // Each overflow moves the next sample into the DAC. The two halves are
+    // linked in a ring when looping, otherwise the channel stops after the
+    // second. Each raises the block done flag when it has been played.
+    shared_dma_init();
+    shared_dma_configure(SHARED_DMA_DAC_CHANNEL, PLAYBACK_TC_DMAC_ID);
+    size_t half_len = len / 2;
+    DmacDescriptor *first_half = shared_dma_descriptor(SHARED_DMA_DAC_CHANNEL);
+    DmacDescriptor *halves[2] = {first_half, &playback_second_half};
+    for (int i = 0; i < 2; i++) {
+        halves[i]->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC |
+            DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_BLOCKACT_INT;
+        halves[i]->BTCNT.reg = half_len;
+        // With address increment enabled the DMAC wants the end address.
+        halves[i]->SRCADDR.reg = (uint32_t) (data + (i + 1) * half_len);
+        halves[i]->DSTADDR.reg = (uint32_t) &DAC->DATA.reg;
+        halves[i]->DESCADDR.reg = (uint32_t) halves[1 - i];
+    }
+    if (!loop) {
+        playback_second_half.DESCADDR.reg = 0;
+    }
+
+    self->playback_buffer = buffer;
+    self->next_half = 0;
+    playback_owner = self;
+    shared_dma_block_done(SHARED_DMA_DAC_CHANNEL);
+    shared_dma_enable(SHARED_DMA_DAC_CHANNEL);
+    tc_enable(&self->tc_instance);
+}
+
+int8_t common_hal_nativeio_analogout_playback_ready(nativeio_analogout_obj_t *self) {
+    if (playback_owner != self || !shared_dma_block_done(SHARED_DMA_DAC_CHANNEL)) {
+        return -1;
+    }
+    int8_t half = self->next_half;
+    self->next_half = 1 - half;
+    return half;
+}
+
+bool common_hal_nativeio_analogout_get_playing(nativeio_analogout_obj_t *self) {
+    return playback_owner == self && shared_dma_busy(SHARED_DMA_DAC_CHANNEL);
+}
+
+void common_hal_nativeio_analogout_stop_playback(nativeio_analogout_obj_t *self) {
+    if (playback_owner != self) {
+        return;
+    }
+    tc_disable(&self->tc_instance);
+    tc_reset(&self->tc_instance);
+    shared_dma_abort(SHARED_DMA_DAC_CHANNEL);
+    self->playback_buffer = MP_OBJ_NULL;
+    playback_owner = NULL;
+}
+
+void reset_analogout_playback(void) {
+    PLAYBACK_TC->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    playback_owner = NULL;
+}
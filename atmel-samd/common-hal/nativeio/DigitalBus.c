@@ -0,0 +1,158 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "py/nlr.h"
+#include "py/runtime.h"
+
+#include "shared-bindings/nativeio/DigitalBus.h"
+
+#include "asf/sam0/drivers/port/port.h"
+
+void common_hal_nativeio_digitalbus_construct(nativeio_digitalbus_obj_t* self,
+        const mcu_pin_obj_t **pins, size_t num_pins, const mcu_pin_obj_t *strobe) {
+    self->port = port_get_group_from_gpio_pin(pins[0]->pin);
+    self->mask = 0;
+    self->contiguous = true;
+    for (size_t i = 0; i < num_pins; i++) {
+        if (port_get_group_from_gpio_pin(pins[i]->pin) != self->port) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                "Bus pins must be on the same port."));
+        }
+        uint8_t bit = pins[i]->pin % 32;
+        if ((self->mask & (1UL << bit)) != 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Pin used twice."));
+        }
+        self->bits[i] = bit;
+        self->mask |= 1UL << bit;
+        if (bit != self->bits[0] + i) {
+            self->contiguous = false;
+        }
+    }
+    self->num_pins = num_pins;
+    self->output = false;
+
+    // The whole bus is configured with a single register write.
+    struct port_config pin_conf;
+    port_get_config_defaults(&pin_conf);
+    pin_conf.direction  = PORT_PIN_DIR_INPUT;
+    pin_conf.input_pull = PORT_PIN_PULL_NONE;
+    port_group_set_config(self->port, self->mask, &pin_conf);
+
+    self->strobe_port = NULL;
+    self->strobe_mask = 0;
+    if (strobe != NULL) {
+        self->strobe_port = port_get_group_from_gpio_pin(strobe->pin);
+        self->strobe_mask = 1UL << (strobe->pin % 32);
+        if (self->strobe_port == self->port && (self->mask & self->strobe_mask) != 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Pin used twice."));
+        }
+        // The strobe idles high.
+        self->strobe_port->OUTSET.reg = self->strobe_mask;
+        pin_conf.direction = PORT_PIN_DIR_OUTPUT;
+        port_group_set_config(self->strobe_port, self->strobe_mask, &pin_conf);
+    }
+}
+
+void common_hal_nativeio_digitalbus_deinit(nativeio_digitalbus_obj_t* self) {
+    struct port_config pin_conf;
+    port_get_config_defaults(&pin_conf);
+    pin_conf.powersave  = true;
+    port_group_set_config(self->port, self->mask, &pin_conf);
+    if (self->strobe_port != NULL) {
+        port_group_set_config(self->strobe_port, self->strobe_mask, &pin_conf);
+    }
+}
+
+// Spreads the bus value out into the bus's port bits.
+static inline uint32_t to_port(nativeio_digitalbus_obj_t* self, uint32_t value) {
+    if (self->contiguous) {
+        return (value << self->bits[0]) & self->mask;
+    }
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < self->num_pins; i++) {
+        if ((value & (1UL << i)) != 0) {
+            bits |= 1UL << self->bits[i];
+        }
+    }
+    return bits;
+}
+
+static inline void put_value(nativeio_digitalbus_obj_t* self, uint32_t value) {
+    uint32_t bits = to_port(self, value);
+    // Clearing first then setting leaves the bus valid in two writes without
+    // a read-modify-write of OUT that could race an interrupt.
+    self->port->OUTCLR.reg = self->mask & ~bits;
+    self->port->OUTSET.reg = bits;
+}
+
+void common_hal_nativeio_digitalbus_switch_to_output(nativeio_digitalbus_obj_t* self, uint32_t value) {
+    put_value(self, value);
+    self->port->DIRSET.reg = self->mask;
+    self->output = true;
+}
+
+void common_hal_nativeio_digitalbus_switch_to_input(nativeio_digitalbus_obj_t* self) {
+    self->port->DIRCLR.reg = self->mask;
+    self->output = false;
+}
+
+bool common_hal_nativeio_digitalbus_is_output(nativeio_digitalbus_obj_t* self) {
+    return self->output;
+}
+
+void common_hal_nativeio_digitalbus_set_value(nativeio_digitalbus_obj_t* self, uint32_t value) {
+    put_value(self, value);
+}
+
+uint32_t common_hal_nativeio_digitalbus_get_value(nativeio_digitalbus_obj_t* self) {
+    // One read samples every pin at the same instant.
+    uint32_t in = self->port->IN.reg;
+    if (self->contiguous) {
+        return (in & self->mask) >> self->bits[0];
+    }
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < self->num_pins; i++) {
+        if ((in & (1UL << self->bits[i])) != 0) {
+            value |= 1UL << i;
+        }
+    }
+    return value;
+}
+
+void common_hal_nativeio_digitalbus_write(nativeio_digitalbus_obj_t* self,
+        const void *data, size_t len, size_t item_size) {
+    const uint8_t *bytes = data;
+    const uint16_t *halfwords = data;
+    for (size_t i = 0; i < len; i++) {
+        put_value(self, item_size == 2 ? halfwords[i] : bytes[i]);
+        if (self->strobe_port != NULL) {
+            self->strobe_port->OUTCLR.reg = self->strobe_mask;
+            self->strobe_port->OUTSET.reg = self->strobe_mask;
+        }
+    }
+}
@@ -32,13 +32,62 @@
 #include "py/mphal.h"
 
 #include "shared-bindings/nativeio/DigitalInOut.h"
+#include "common-hal/nativeio/DigitalInOut.h"
 
+#include "asf/sam0/drivers/extint/extint.h"
+#include "asf/sam0/drivers/extint/extint_callback.h"
 #include "asf/sam0/drivers/port/port.h"
 #include "asf/sam0/drivers/system/pinmux/pinmux.h"
 
+// The external interrupt line of a pin is its number modulo 16 except for
+// a few, and PA08 which only has the NMI.
+int8_t nativeio_extint_channel(uint8_t pin) {
+    switch (pin) {
+        case PIN_PA08: return -1;
+        case PIN_PA24: return 12;
+        case PIN_PA25: return 13;
+        case PIN_PA27: return 15;
+        case PIN_PA28: return 8;
+        case PIN_PA30: return 10;
+        case PIN_PA31: return 11;
+        default: return pin % 16;
+    }
+}
+
+// Runs in the EIC interrupt so it only queues up the Python handler.
+static void extint_handler(void) {
+    mp_obj_t obj = MP_STATE_PORT(nativeio_extint)[extint_get_current_channel()];
+    if (obj != MP_OBJ_NULL) {
+        nativeio_digitalinout_obj_t* self = MP_OBJ_TO_PTR(obj);
+        mp_sched_schedule(self->irq_handler, obj);
+    }
+}
+
+static void irq_disable(nativeio_digitalinout_obj_t* self) {
+    if (self->irq_handler == MP_OBJ_NULL) {
+        return;
+    }
+    int8_t channel = nativeio_extint_channel(self->pin->pin);
+    extint_chan_disable_callback(channel, EXTINT_CALLBACK_TYPE_DETECT);
+    extint_unregister_callback(extint_handler, channel, EXTINT_CALLBACK_TYPE_DETECT);
+    MP_STATE_PORT(nativeio_extint)[channel] = MP_OBJ_NULL;
+    self->irq_handler = MP_OBJ_NULL;
+}
+
+void digitalinout_reset(void) {
+    for (int i = 0; i < EIC_NUMBER_OF_INTERRUPTS; i++) {
+        extint_chan_disable_callback(i, EXTINT_CALLBACK_TYPE_DETECT);
+        extint_unregister_callback(extint_handler, i, EXTINT_CALLBACK_TYPE_DETECT);
+        MP_STATE_PORT(nativeio_extint)[i] = MP_OBJ_NULL;
+    }
+}
+
 digitalinout_result_t common_hal_nativeio_digitalinout_construct(
         nativeio_digitalinout_obj_t* self, const mcu_pin_obj_t* pin) {
     self->pin = pin;
+    self->port = port_get_group_from_gpio_pin(pin->pin);
+    self->mask = 1UL << (pin->pin % 32);
+    self->irq_handler = MP_OBJ_NULL;
 
     struct port_config pin_conf;
     port_get_config_defaults(&pin_conf);
@@ -50,6 +99,8 @@ digitalinout_result_t common_hal_nativeio_digitalinout_construct(
 }
 
 void common_hal_nativeio_digitalinout_deinit(nativeio_digitalinout_obj_t* self) {
+    irq_disable(self);
+
     struct port_config pin_conf;
     port_get_config_defaults(&pin_conf);
 
@@ -67,6 +118,8 @@ void common_hal_nativeio_digitalinout_switch_to_input(
 void common_hal_nativeio_digitalinout_switch_to_output(
         nativeio_digitalinout_obj_t* self, bool value,
         enum digitalinout_drive_mode_t drive_mode) {
+    irq_disable(self);
+
     struct port_config pin_conf;
     port_get_config_defaults(&pin_conf);
 
@@ -76,6 +129,11 @@ void common_hal_nativeio_digitalinout_switch_to_output(
 
     self->output = true;
     self->open_drain = drive_mode == DRIVE_MODE_OPEN_DRAIN;
+    if (self->open_drain) {
+        // Open drain only drives low so keep the latch there. The fast path
+        // relies on it.
+        self->port->OUTCLR.reg = self->mask;
+    }
     common_hal_nativeio_digitalinout_set_value(self, value);
 }
 
@@ -86,9 +144,8 @@ enum digitalinout_direction_t common_hal_nativeio_digitalinout_get_direction(
 
 void common_hal_nativeio_digitalinout_set_value(
         nativeio_digitalinout_obj_t* self, bool value) {
-    uint32_t pin = self->pin->pin;
-    PortGroup *const port_base = port_get_group_from_gpio_pin(pin);
-    uint32_t pin_mask  = (1UL << (pin % 32));
+    PortGroup *const port_base = self->port;
+    uint32_t pin_mask = self->mask;
 
     /* Set the pin to high or low atomically based on the requested level */
     if (value) {
@@ -108,9 +165,8 @@ void common_hal_nativeio_digitalinout_set_value(
 
 bool common_hal_nativeio_digitalinout_get_value(
         nativeio_digitalinout_obj_t* self) {
-    uint32_t pin = self->pin->pin;
-    PortGroup *const port_base = port_get_group_from_gpio_pin(pin);
-    uint32_t pin_mask  = (1UL << (pin % 32));
+    PortGroup *const port_base = self->port;
+    uint32_t pin_mask = self->mask;
     if (!self->output) {
         return (port_base->IN.reg & pin_mask);
     } else {
@@ -175,7 +231,7 @@ enum digitalinout_pull_t common_hal_nativeio_digitalinout_get_pull(
             "Cannot get pull while in output mode."));
         return PULL_NONE;
     } else {
-        if (port_base->PINCFG[pin % 32].bit.PULLEN != 0) {
+        if (port_base->PINCFG[pin % 32].bit.PULLEN == 0) {
             return PULL_NONE;
         } if ((port_base->OUT.reg & pin_mask) > 0) {
             return PULL_UP;
@@ -184,3 +240,61 @@ enum digitalinout_pull_t common_hal_nativeio_digitalinout_get_pull(
         }
     }
 }
+
+void common_hal_nativeio_digitalinout_set_irq(
+        nativeio_digitalinout_obj_t* self, mp_obj_t handler,
+        enum digitalinout_edge_t edge) {
+    enum digitalinout_pull_t pull = common_hal_nativeio_digitalinout_get_pull(self);
+    irq_disable(self);
+    if (handler == mp_const_none) {
+        // Back to a plain input.
+        common_hal_nativeio_digitalinout_set_pull(self, pull);
+        return;
+    }
+
+    int8_t channel = nativeio_extint_channel(self->pin->pin);
+    if (channel < 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Pin does not have interrupt capabilities."));
+    }
+    if (MP_STATE_PORT(nativeio_extint)[channel] != MP_OBJ_NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Another pin is using the same interrupt."));
+    }
+
+    struct extint_chan_conf config;
+    extint_chan_get_config_defaults(&config);
+    config.gpio_pin = self->pin->pin;
+    config.gpio_pin_mux = 0; // mux A is the EIC on every pin
+    switch (pull) {
+        case PULL_UP:
+            config.gpio_pin_pull = EXTINT_PULL_UP;
+            break;
+        case PULL_DOWN:
+            config.gpio_pin_pull = EXTINT_PULL_DOWN;
+            break;
+        case PULL_NONE:
+        default:
+            config.gpio_pin_pull = EXTINT_PULL_NONE;
+            break;
+    }
+    switch (edge) {
+        case EDGE_RISE:
+            config.detection_criteria = EXTINT_DETECT_RISING;
+            break;
+        case EDGE_FALL:
+            config.detection_criteria = EXTINT_DETECT_FALLING;
+            break;
+        case EDGE_BOTH:
+        default:
+            config.detection_criteria = EXTINT_DETECT_BOTH;
+            break;
+    }
+    extint_chan_set_config(channel, &config);
+    extint_chan_clear_detected(channel);
+
+    self->irq_handler = handler;
+    MP_STATE_PORT(nativeio_extint)[channel] = MP_OBJ_FROM_PTR(self);
+    extint_register_callback(extint_handler, channel, EXTINT_CALLBACK_TYPE_DETECT);
+    extint_chan_enable_callback(channel, EXTINT_CALLBACK_TYPE_DETECT);
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Fast paths for bit banging. They go straight to the port registers that
+// were looked up when the pin was constructed and skip the direction handling
+// of common_hal_nativeio_digitalinout_set_value. So only use them once the
+// pin has been switched to an output, or to an input for reading.
+
+#ifndef __MICROPY_INCLUDED_ATMEL_SAMD_COMMON_HAL_NATIVEIO_DIGITALINOUT_H__
+#define __MICROPY_INCLUDED_ATMEL_SAMD_COMMON_HAL_NATIVEIO_DIGITALINOUT_H__
+
+#include "common-hal/nativeio/types.h"
+
+// The EIC line of a pin, or -1 if it has none. The object using each line is
+// kept in MP_STATE_PORT(nativeio_extint).
+int8_t nativeio_extint_channel(uint8_t pin);
+
+static inline void common_hal_nativeio_digitalinout_fast_write(
+        nativeio_digitalinout_obj_t* self, bool value) {
+    if (self->open_drain) {
+        // The output latch is already low so only the direction changes.
+        if (value) {
+            self->port->DIRCLR.reg = self->mask;
+        } else {
+            self->port->DIRSET.reg = self->mask;
+        }
+    } else if (value) {
+        self->port->OUTSET.reg = self->mask;
+    } else {
+        self->port->OUTCLR.reg = self->mask;
+    }
+}
+
+// Reads the level on the pad, even when an open drain output is released.
+static inline bool common_hal_nativeio_digitalinout_fast_read(
+        nativeio_digitalinout_obj_t* self) {
+    return (self->port->IN.reg & self->mask) != 0;
+}
+
+#endif // __MICROPY_INCLUDED_ATMEL_SAMD_COMMON_HAL_NATIVEIO_DIGITALINOUT_H__
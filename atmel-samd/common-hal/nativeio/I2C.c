@@ -27,10 +27,14 @@
  // This file contains all of the port specific HAL functions for the machine
  // module.
 
+#include <stddef.h>
+
 #include "shared-bindings/nativeio/I2C.h"
+#include "py/mphal.h"
 #include "py/nlr.h"
 
 #include "asf/sam0/drivers/sercom/i2c/i2c_master.h"
+#include "asf/sam0/drivers/sercom/i2c/i2c_master_interrupt.h"
 #include "samd21_pins.h"
 
 // We use ENABLE registers below we don't want to treat as a macro.
@@ -39,12 +43,108 @@
 // Number of times to try to send packet if failed.
 #define TIMEOUT 1
 
-void common_hal_nativeio_i2c_construct(nativeio_i2c_obj_t *self,
-        const mcu_pin_obj_t* scl, const mcu_pin_obj_t* sda, uint32_t frequency) {
+// Boards with weak pull ups can cap the clock lower.
+#ifndef NATIVEIO_I2C_MAX_FREQUENCY
+#define NATIVEIO_I2C_MAX_FREQUENCY 3400000
+#endif
+
+// The master code sent in fast mode before each high speed transfer. Only the
+// low three bits are free for us to pick.
+#define HS_MASTER_CODE 0x08
+
+// States of a write then read transaction run from the SERCOM interrupt.
+enum {
+    TRANSFER_IDLE,
+    TRANSFER_WRITING,
+    TRANSFER_READING,
+    TRANSFER_ERROR,
+};
+
+static nativeio_i2c_obj_t* obj_from_module(struct i2c_master_module *const module) {
+    return (nativeio_i2c_obj_t*) ((uint8_t*) module - offsetof(nativeio_i2c_obj_t, i2c_master_instance));
+}
+
+// Once the register address (or whatever else) is written start the read with
+// a repeated start.
+static void write_complete(struct i2c_master_module *const module) {
+    nativeio_i2c_obj_t* self = obj_from_module(module);
+    if (self->transfer_state != TRANSFER_WRITING) {
+        return;
+    }
+    if (self->read_packet.data_length == 0) {
+        self->transfer_state = TRANSFER_IDLE;
+        return;
+    }
+    self->transfer_state = TRANSFER_READING;
+    if (i2c_master_read_packet_job(module, &self->read_packet) != STATUS_OK) {
+        self->transfer_state = TRANSFER_ERROR;
+    }
+}
+
+static void read_complete(struct i2c_master_module *const module) {
+    obj_from_module(module)->transfer_state = TRANSFER_IDLE;
+}
+
+static void transfer_error(struct i2c_master_module *const module) {
+    obj_from_module(module)->transfer_state = TRANSFER_ERROR;
+}
+
+// (Re)initializes the SERCOM for the given frequency, picking the transfer
+// speed mode that covers it. The SERCOM must be disabled.
+static enum status_code init_master(nativeio_i2c_obj_t *self, Sercom* sercom,
+        uint32_t frequency) {
     struct i2c_master_config config_i2c_master;
     i2c_master_get_config_defaults(&config_i2c_master);
     // Struct takes the argument in Khz not Hz.
-    config_i2c_master.baud_rate = frequency / 1000;
+    if (frequency <= 400000) {
+        config_i2c_master.transfer_speed = I2C_MASTER_SPEED_STANDARD_AND_FAST;
+        config_i2c_master.baud_rate = frequency / 1000;
+    } else if (frequency <= 1000000) {
+        config_i2c_master.transfer_speed = I2C_MASTER_SPEED_FAST_MODE_PLUS;
+        config_i2c_master.baud_rate = frequency / 1000;
+    } else {
+        // The high speed master code is sent in fast mode before switching
+        // up for the rest of the transfer.
+        config_i2c_master.transfer_speed = I2C_MASTER_SPEED_HIGH_SPEED;
+        config_i2c_master.baud_rate = 400;
+        config_i2c_master.baud_rate_high_speed = frequency / 1000;
+    }
+    self->high_speed = config_i2c_master.transfer_speed == I2C_MASTER_SPEED_HIGH_SPEED;
+
+    config_i2c_master.pinmux_pad0 = self->sda_pinmux; // SDA
+    config_i2c_master.pinmux_pad1 = self->scl_pinmux; // SCL
+    config_i2c_master.buffer_timeout = 10000;
+
+    enum status_code status = i2c_master_init(&self->i2c_master_instance,
+        sercom, &config_i2c_master);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    i2c_master_enable(&self->i2c_master_instance);
+
+    // Initializing forgets any callbacks.
+    i2c_master_register_callback(&self->i2c_master_instance, write_complete,
+        I2C_MASTER_CALLBACK_WRITE_COMPLETE);
+    i2c_master_register_callback(&self->i2c_master_instance, read_complete,
+        I2C_MASTER_CALLBACK_READ_COMPLETE);
+    i2c_master_register_callback(&self->i2c_master_instance, transfer_error,
+        I2C_MASTER_CALLBACK_ERROR);
+    i2c_master_enable_callback(&self->i2c_master_instance,
+        I2C_MASTER_CALLBACK_WRITE_COMPLETE);
+    i2c_master_enable_callback(&self->i2c_master_instance,
+        I2C_MASTER_CALLBACK_READ_COMPLETE);
+    i2c_master_enable_callback(&self->i2c_master_instance,
+        I2C_MASTER_CALLBACK_ERROR);
+    return STATUS_OK;
+}
+
+void common_hal_nativeio_i2c_construct(nativeio_i2c_obj_t *self,
+        const mcu_pin_obj_t* scl, const mcu_pin_obj_t* sda, uint32_t frequency) {
+    if (frequency == 0 || frequency > NATIVEIO_I2C_MAX_FREQUENCY) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Unsupported frequency."));
+    }
     Sercom* sercom = NULL;
     uint32_t sda_pinmux = 0;
     uint32_t scl_pinmux = 0;
@@ -73,32 +173,32 @@ void common_hal_nativeio_i2c_construct(nativeio_i2c_obj_t *self,
             "No hardware support available with those pins."));
     }
 
-    config_i2c_master.pinmux_pad0 = sda_pinmux; // SDA
-    config_i2c_master.pinmux_pad1 = scl_pinmux; // SCL
-    config_i2c_master.buffer_timeout = 10000;
+    self->sda_pinmux = sda_pinmux;
+    self->scl_pinmux = scl_pinmux;
+    self->transfer_state = TRANSFER_IDLE;
+    self->out_buffer = MP_OBJ_NULL;
+    self->in_buffer = MP_OBJ_NULL;
 
-    enum status_code status = i2c_master_init(&self->i2c_master_instance,
-        sercom, &config_i2c_master);
-    if (status != STATUS_OK) {
+    if (init_master(self, sercom, frequency) != STATUS_OK) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus init error"));
     }
-
-    i2c_master_enable(&self->i2c_master_instance);
 }
 
 void common_hal_nativeio_i2c_deinit(nativeio_i2c_obj_t *self) {
+    common_hal_nativeio_i2c_wait_for_transfer(self);
     i2c_master_disable(&self->i2c_master_instance);
 }
 
 bool common_hal_nativeio_i2c_probe(nativeio_i2c_obj_t *self, uint8_t addr) {
+    common_hal_nativeio_i2c_wait_for_transfer(self);
     uint8_t buf;
     struct i2c_master_packet packet = {
         .address     = addr,
         .data_length = 0,
         .data        = &buf,
         .ten_bit_address = false,
-        .high_speed      = false,
-        .hs_master_code  = 0x0,
+        .high_speed      = self->high_speed,
+        .hs_master_code  = HS_MASTER_CODE,
     };
 
     enum status_code status = i2c_master_write_packet_wait(
@@ -106,9 +206,14 @@ bool common_hal_nativeio_i2c_probe(nativeio_i2c_obj_t *self, uint8_t addr) {
     return status == STATUS_OK;
 }
 
-void common_hal_nativeio_i2c_configure(nativeio_i2c_obj_t *self,
-        uint32_t baudrate, uint8_t polarity, uint8_t phase, uint8_t bits) {
-    return;
+bool common_hal_nativeio_i2c_configure(nativeio_i2c_obj_t *self, uint32_t frequency) {
+    if (frequency == 0 || frequency > NATIVEIO_I2C_MAX_FREQUENCY) {
+        return false;
+    }
+    common_hal_nativeio_i2c_wait_for_transfer(self);
+    Sercom* sercom = self->i2c_master_instance.hw;
+    i2c_master_disable(&self->i2c_master_instance);
+    return init_master(self, sercom, frequency) == STATUS_OK;
 }
 
 bool common_hal_nativeio_i2c_try_lock(nativeio_i2c_obj_t *self) {
@@ -127,13 +232,14 @@ void common_hal_nativeio_i2c_unlock(nativeio_i2c_obj_t *self) {
 
 bool common_hal_nativeio_i2c_write(nativeio_i2c_obj_t *self, uint16_t addr,
         const uint8_t *data, size_t len, bool transmit_stop_bit) {
+    common_hal_nativeio_i2c_wait_for_transfer(self);
     struct i2c_master_packet packet = {
         .address     = addr,
         .data_length = len,
         .data        = (uint8_t *) data,
         .ten_bit_address = false,
-        .high_speed      = false,
-        .hs_master_code  = 0x0,
+        .high_speed      = self->high_speed,
+        .hs_master_code  = HS_MASTER_CODE,
     };
 
     uint16_t timeout = 0;
@@ -156,13 +262,14 @@ bool common_hal_nativeio_i2c_write(nativeio_i2c_obj_t *self, uint16_t addr,
 
 bool common_hal_nativeio_i2c_read(nativeio_i2c_obj_t *self, uint16_t addr,
         uint8_t *data, size_t len) {
+    common_hal_nativeio_i2c_wait_for_transfer(self);
     struct i2c_master_packet packet = {
         .address     = addr,
         .data_length = len,
         .data        = data,
         .ten_bit_address = false,
-        .high_speed      = false,
-        .hs_master_code  = 0x0,
+        .high_speed      = self->high_speed,
+        .hs_master_code  = HS_MASTER_CODE,
     };
 
     uint16_t timeout = 0;
@@ -177,3 +284,74 @@ bool common_hal_nativeio_i2c_read(nativeio_i2c_obj_t *self, uint16_t addr,
     }
     return status == STATUS_OK;
 }
+
+bool common_hal_nativeio_i2c_start_write_then_read(nativeio_i2c_obj_t *self,
+        uint16_t addr, mp_obj_t out_buffer, const uint8_t *out_data, size_t out_len,
+        mp_obj_t in_buffer, uint8_t *in_data, size_t in_len) {
+    common_hal_nativeio_i2c_wait_for_transfer(self);
+    struct i2c_master_packet write_packet = {
+        .address     = addr,
+        .data_length = out_len,
+        .data        = (uint8_t *) out_data,
+        .ten_bit_address = false,
+        .high_speed      = self->high_speed,
+        .hs_master_code  = HS_MASTER_CODE,
+    };
+    self->read_packet.address = addr;
+    self->read_packet.data_length = in_len;
+    self->read_packet.data = in_data;
+    self->read_packet.ten_bit_address = false;
+    self->read_packet.high_speed = self->high_speed;
+    self->read_packet.hs_master_code = HS_MASTER_CODE;
+    self->out_buffer = out_buffer;
+    self->in_buffer = in_buffer;
+
+    enum status_code status;
+    if (out_len == 0) {
+        self->transfer_state = TRANSFER_READING;
+        status = i2c_master_read_packet_job(&self->i2c_master_instance,
+                                            &self->read_packet);
+    } else {
+        self->transfer_state = TRANSFER_WRITING;
+        if (in_len == 0) {
+            status = i2c_master_write_packet_job(&self->i2c_master_instance,
+                                                 &write_packet);
+        } else {
+            status = i2c_master_write_packet_job_no_stop(&self->i2c_master_instance,
+                                                         &write_packet);
+        }
+    }
+    if (status != STATUS_OK) {
+        self->transfer_state = TRANSFER_IDLE;
+        self->out_buffer = MP_OBJ_NULL;
+        self->in_buffer = MP_OBJ_NULL;
+    }
+    return status == STATUS_OK;
+}
+
+bool common_hal_nativeio_i2c_transfer_in_progress(nativeio_i2c_obj_t *self) {
+    return self->transfer_state == TRANSFER_WRITING ||
+           self->transfer_state == TRANSFER_READING;
+}
+
+bool common_hal_nativeio_i2c_wait_for_transfer(nativeio_i2c_obj_t *self) {
+    while (common_hal_nativeio_i2c_transfer_in_progress(self)) {
+        #ifdef MICROPY_VM_HOOK_LOOP
+            MICROPY_VM_HOOK_LOOP
+        #endif
+    }
+    bool ok = self->transfer_state != TRANSFER_ERROR;
+    self->transfer_state = TRANSFER_IDLE;
+    self->out_buffer = MP_OBJ_NULL;
+    self->in_buffer = MP_OBJ_NULL;
+    return ok;
+}
+
+bool common_hal_nativeio_i2c_write_then_read(nativeio_i2c_obj_t *self, uint16_t addr,
+        const uint8_t *out_data, size_t out_len, uint8_t *in_data, size_t in_len) {
+    if (!common_hal_nativeio_i2c_start_write_then_read(self, addr, MP_OBJ_NULL,
+            out_data, out_len, MP_OBJ_NULL, in_data, in_len)) {
+        return false;
+    }
+    return common_hal_nativeio_i2c_wait_for_transfer(self);
+}
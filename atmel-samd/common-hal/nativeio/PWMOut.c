@@ -29,87 +29,301 @@
 #include "py/runtime.h"
 #include "shared-bindings/nativeio/PWMOut.h"
 
+#include "asf/sam0/drivers/system/clock/gclk.h"
+#include "asf/sam0/drivers/system/pinmux/pinmux.h"
+
 #include "samd21_pins.h"
 
-void common_hal_nativeio_pwmout_construct(nativeio_pwmout_obj_t* self, const mcu_pin_obj_t* pin, uint16_t duty) {
-    self->pin = pin;
-    self->using_primary_timer = true;
+// The timers count GCLK0 through one of these prescalers. The index is the
+// value of CTRLA.PRESCALER for both TCs and TCCs.
+static const uint16_t prescaler[] = {1, 2, 4, 8, 16, 64, 256, 1024};
 
-    if (pin->primary_timer.tc == 0 && pin->secondary_timer.tc == 0) {
-        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError,
-            "PWM not supported on pin %q", self->pin->name));
+// Each timer is shared by every PWMOut that uses one of its channels at the
+// same frequency. The top value is kept one short of the counter's maximum so
+// that a compare value of top + 1, which holds the output high, still fits.
+typedef struct {
+    uint32_t frequency;
+    uint32_t top;
+    uint8_t refcount;
+    // Bit n is set when compare channel n is driving a pin.
+    uint8_t channels;
+    // The frequency may be changed so nothing else can share the timer.
+    bool variable_frequency;
+} timer_state_t;
+
+static Tc* const tc_insts[TC_INST_NUM] = TC_INSTS;
+static Tcc* const tcc_insts[TCC_INST_NUM] = TCC_INSTS;
+static const uint32_t tcc_max_top[TCC_INST_NUM] = {
+    (1UL << TCC0_SIZE) - 2, (1UL << TCC1_SIZE) - 2, (1UL << TCC2_SIZE) - 2
+};
+static struct tc_module tc_instances[TC_INST_NUM];
+static struct tcc_module tcc_instances[TCC_INST_NUM];
+static timer_state_t tc_state[TC_INST_NUM];
+static timer_state_t tcc_state[TCC_INST_NUM];
+
+void pwmout_reset(void) {
+    for (int i = 0; i < TC_INST_NUM; i++) {
+        if (tc_state[i].refcount > 0) {
+            tc_reset(&tc_instances[i]);
+        }
+        tc_state[i].refcount = 0;
+        tc_state[i].channels = 0;
+    }
+    for (int i = 0; i < TCC_INST_NUM; i++) {
+        if (tcc_state[i].refcount > 0) {
+            tcc_reset(&tcc_instances[i]);
+        }
+        tcc_state[i].refcount = 0;
+        tcc_state[i].channels = 0;
+    }
+}
+
+static uint8_t timer_index(const pin_timer_t* t) {
+    for (uint8_t i = 0; i < TC_INST_NUM && t->is_tc; i++) {
+        if (tc_insts[i] == t->tc) {
+            return i;
+        }
+    }
+    for (uint8_t i = 0; i < TCC_INST_NUM && !t->is_tc; i++) {
+        if (tcc_insts[i] == t->tcc) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static timer_state_t* timer_state(const pin_timer_t* t) {
+    if (t->is_tc) {
+        return &tc_state[timer_index(t)];
+    }
+    return &tcc_state[timer_index(t)];
+}
+
+static const pin_timer_t* self_timer(nativeio_pwmout_obj_t* self) {
+    if (self->using_primary_timer) {
+        return &self->pin->primary_timer;
+    }
+    return &self->pin->secondary_timer;
+}
+
+// Picks the smallest prescaler that lets the frequency be reached so the
+// duty cycle gets the most resolution.
+static bool find_period(uint32_t frequency, uint32_t max_top, uint8_t* divisor, uint32_t* top) {
+    if (frequency == 0) {
+        return false;
+    }
+    uint32_t clock = system_gclk_gen_get_hz(GCLK_GENERATOR_0);
+    for (uint8_t i = 0; i < MP_ARRAY_SIZE(prescaler); i++) {
+        uint32_t ticks = clock / prescaler[i] / frequency;
+        if (ticks < 2) {
+            return false;
+        }
+        if (ticks - 1 <= max_top) {
+            *divisor = i;
+            *top = ticks - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t compare_value(uint32_t top, uint16_t duty) {
+    return ((uint64_t) duty * (top + 1)) / 0xffff;
+}
+
+static void set_compare(const pin_timer_t* t, uint32_t compare) {
+    if (t->is_tc) {
+        tc_set_compare_value(&tc_instances[timer_index(t)], t->channel, compare);
+    } else {
+        tcc_set_compare_value(&tcc_instances[timer_index(t)], t->channel, compare);
     }
+}
 
-    // TODO(tannewt): Support output on multiple timer channels at once.
-    const pin_timer_t* t = &pin->primary_timer;
+// Starts timer t with its channel driving the pin.
+static void start_timer(const pin_timer_t* t, const mcu_pin_obj_t* pin, uint8_t mux,
+        uint8_t divisor, uint32_t top, uint32_t compare) {
+    uint8_t index = timer_index(t);
     if (t->is_tc) {
         struct tc_config config_tc;
         tc_get_config_defaults(&config_tc);
 
         config_tc.counter_size    = TC_COUNTER_SIZE_8BIT;
         config_tc.wave_generation = TC_WAVE_GENERATION_NORMAL_PWM;
-        config_tc.clock_prescaler = TC_CLOCK_PRESCALER_DIV256;
-        config_tc.counter_8_bit.period = 0xff;
-        config_tc.counter_8_bit.compare_capture_channel[t->channel] = duty;
+        config_tc.clock_prescaler = TC_CTRLA_PRESCALER(divisor);
+        config_tc.counter_8_bit.period = top;
+        config_tc.counter_8_bit.compare_capture_channel[t->channel] = compare;
 
         config_tc.pwm_channel[t->wave_output].enabled = true;
         config_tc.pwm_channel[t->wave_output].pin_out = pin->pin;
-        config_tc.pwm_channel[t->wave_output].pin_mux = MUX_E;
+        config_tc.pwm_channel[t->wave_output].pin_mux = mux;
 
-        tc_init(&self->tc_instance, t->tc, &config_tc);
+        tc_init(&tc_instances[index], t->tc, &config_tc);
 
-        tc_enable(&self->tc_instance);
+        tc_enable(&tc_instances[index]);
     } else {
         struct tcc_config config_tcc;
         tcc_get_config_defaults(&config_tcc, t->tcc);
 
-        config_tcc.counter.clock_prescaler = TCC_CLOCK_PRESCALER_DIV256;
-        config_tcc.counter.period = 0xFF;
+        config_tcc.counter.clock_prescaler = TCC_CTRLA_PRESCALER(divisor);
+        config_tcc.counter.period = top;
         config_tcc.compare.wave_generation = TCC_WAVE_GENERATION_SINGLE_SLOPE_PWM;
-        config_tcc.compare.match[t->channel] = duty;
+        config_tcc.compare.match[t->channel] = compare;
 
         config_tcc.pins.enable_wave_out_pin[t->wave_output] = true;
         config_tcc.pins.wave_out_pin[t->wave_output] = pin->pin;
-        config_tcc.pins.wave_out_pin_mux[t->wave_output] = MUX_E;
+        config_tcc.pins.wave_out_pin_mux[t->wave_output] = mux;
 
-        tcc_init(&self->tcc_instance, t->tcc, &config_tcc);
+        tcc_init(&tcc_instances[index], t->tcc, &config_tcc);
 
-        tcc_enable(&self->tcc_instance);
+        tcc_enable(&tcc_instances[index]);
     }
 }
 
-extern void common_hal_nativeio_pwmout_deinit(nativeio_pwmout_obj_t* self) {
-    const pin_timer_t* t = &self->pin->primary_timer;
-    if (!self->using_primary_timer) {
-      t = &self->pin->secondary_timer;
+// Whether the pin can use timer t at the frequency, joining it when it's
+// already running. *top is set to the timer's top value either way.
+static bool timer_usable(const pin_timer_t* t, uint32_t frequency,
+        bool variable_frequency, uint8_t* divisor, uint32_t* top) {
+    // TC5 provides the millisecond tick.
+    if (t->tc == 0 || (t->is_tc && t->tc == TC5)) {
+        return false;
     }
-    if (t->is_tc) {
-      tc_disable(&self->tc_instance);
-    } else {
-      tcc_disable(&self->tcc_instance);
+    timer_state_t* state = timer_state(t);
+    if (state->refcount > 0) {
+        if (variable_frequency || state->variable_frequency ||
+            state->frequency != frequency || (state->channels & (1 << t->channel)) != 0) {
+            return false;
+        }
+        *top = state->top;
+        return true;
     }
+    // AnalogIn captures and AnalogOut playback pace themselves with TCs.
+    if ((t->is_tc && (t->tc->COUNT16.CTRLA.reg & TC_CTRLA_ENABLE) != 0) ||
+        (!t->is_tc && (t->tcc->CTRLA.reg & TCC_CTRLA_ENABLE) != 0)) {
+        return false;
+    }
+    uint32_t max_top = t->is_tc ? 0xfe : tcc_max_top[timer_index(t)];
+    return find_period(frequency, max_top, divisor, top);
 }
 
-extern void common_hal_nativeio_pwmout_set_duty_cycle(nativeio_pwmout_obj_t* self, uint16_t duty) {
-    const pin_timer_t* t = &self->pin->primary_timer;
-    if (!self->using_primary_timer) {
-        t = &self->pin->secondary_timer;
+void common_hal_nativeio_pwmout_construct(nativeio_pwmout_obj_t* self, const mcu_pin_obj_t* pin,
+        uint16_t duty, uint32_t frequency, bool variable_frequency) {
+    self->pin = pin;
+    self->duty = duty;
+
+    if (pin->primary_timer.tc == 0 && pin->secondary_timer.tc == 0) {
+        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError,
+            "PWM not supported on pin %q", self->pin->name));
     }
-    if (t->tcc != 0) {
-        tcc_set_compare_value(&self->tcc_instance, t->channel, duty);
+
+    // Prefer a timer that is already running, then a 16 or 24 bit TCC for
+    // its resolution, then an 8 bit TC.
+    const pin_timer_t* timers[2] = {&pin->primary_timer, &pin->secondary_timer};
+    const pin_timer_t* t = NULL;
+    uint8_t divisor = 0;
+    uint32_t top = 0;
+    for (uint8_t pass = 0; pass < 3 && t == NULL; pass++) {
+        for (uint8_t i = 0; i < 2 && t == NULL; i++) {
+            const pin_timer_t* candidate = timers[i];
+            bool running = candidate->tc != 0 && timer_state(candidate)->refcount > 0;
+            if ((pass == 0 && !running) ||
+                (pass == 1 && (running || candidate->is_tc)) ||
+                (pass == 2 && (running || !candidate->is_tc))) {
+                continue;
+            }
+            if (timer_usable(candidate, frequency, variable_frequency, &divisor, &top)) {
+                t = candidate;
+                self->using_primary_timer = i == 0;
+            }
+        }
+    }
+    if (t == NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "All timers for this pin are in use or can't reach the frequency."));
+    }
+
+    uint8_t mux = self->using_primary_timer ? MUX_E : MUX_F;
+    timer_state_t* state = timer_state(t);
+    if (state->refcount == 0) {
+        start_timer(t, pin, mux, divisor, top, compare_value(top, duty));
+        state->frequency = frequency;
+        state->top = top;
+        state->variable_frequency = variable_frequency;
     } else {
-        tc_set_compare_value(&self->tc_instance, t->channel, duty);
+        // The timer is already running so only the channel and pin need
+        // setting up.
+        set_compare(t, compare_value(top, duty));
+        struct system_pinmux_config pin_conf;
+        system_pinmux_get_config_defaults(&pin_conf);
+        pin_conf.mux_position = mux;
+        pin_conf.direction = SYSTEM_PINMUX_PIN_DIR_OUTPUT;
+        system_pinmux_pin_set_config(pin->pin, &pin_conf);
     }
+    state->refcount++;
+    state->channels |= 1 << t->channel;
+}
+
+extern void common_hal_nativeio_pwmout_deinit(nativeio_pwmout_obj_t* self) {
+    const pin_timer_t* t = self_timer(self);
+    timer_state_t* state = timer_state(t);
+    if (state->refcount == 0) {
+        return;
+    }
+    state->refcount--;
+    state->channels &= ~(1 << t->channel);
+    if (state->refcount == 0) {
+        if (t->is_tc) {
+            tc_reset(&tc_instances[timer_index(t)]);
+        } else {
+            tcc_reset(&tcc_instances[timer_index(t)]);
+        }
+    }
+    struct system_pinmux_config pin_conf;
+    system_pinmux_get_config_defaults(&pin_conf);
+    pin_conf.powersave = true;
+    system_pinmux_pin_set_config(self->pin->pin, &pin_conf);
+}
+
+extern void common_hal_nativeio_pwmout_set_duty_cycle(nativeio_pwmout_obj_t* self, uint16_t duty) {
+    const pin_timer_t* t = self_timer(self);
+    self->duty = duty;
+    set_compare(t, compare_value(timer_state(t)->top, duty));
 }
 
 uint16_t common_hal_nativeio_pwmout_get_duty_cycle(nativeio_pwmout_obj_t* self) {
-    const pin_timer_t* t = &self->pin->primary_timer;
-    if (!self->using_primary_timer) {
-        t = &self->pin->secondary_timer;
+    // The compare registers may be double buffered so the last value set is
+    // kept rather than read back.
+    return self->duty;
+}
+
+bool common_hal_nativeio_pwmout_set_frequency(nativeio_pwmout_obj_t* self, uint32_t frequency) {
+    const pin_timer_t* t = self_timer(self);
+    uint32_t max_top = t->is_tc ? 0xfe : tcc_max_top[timer_index(t)];
+    uint8_t divisor;
+    uint32_t top;
+    if (!find_period(frequency, max_top, &divisor, &top)) {
+        return false;
     }
-    if (t->tcc != 0) {
-        return tcc_get_capture_value(&self->tcc_instance, t->channel);
+    // The prescaler can only be changed with the timer disabled so it's
+    // started again from scratch. Nothing else shares a variable frequency
+    // timer.
+    if (t->is_tc) {
+        tc_reset(&tc_instances[timer_index(t)]);
     } else {
-        return tc_get_capture_value(&self->tc_instance, t->channel);
+        tcc_reset(&tcc_instances[timer_index(t)]);
     }
+    start_timer(t, self->pin, self->using_primary_timer ? MUX_E : MUX_F,
+        divisor, top, compare_value(top, self->duty));
+    timer_state_t* state = timer_state(t);
+    state->frequency = frequency;
+    state->top = top;
+    return true;
+}
+
+uint32_t common_hal_nativeio_pwmout_get_frequency(nativeio_pwmout_obj_t* self) {
+    const pin_timer_t* t = self_timer(self);
+    return timer_state(t)->frequency;
+}
+
+bool common_hal_nativeio_pwmout_get_variable_frequency(nativeio_pwmout_obj_t* self) {
+    return timer_state(self_timer(self))->variable_frequency;
 }
@@ -0,0 +1,182 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "py/nlr.h"
+#include "py/runtime.h"
+#include "shared-bindings/nativeio/PulseIn.h"
+#include "common-hal/nativeio/DigitalInOut.h"
+
+#include "asf/sam0/drivers/extint/extint.h"
+#include "asf/sam0/drivers/extint/extint_callback.h"
+#include "asf/sam0/drivers/port/port.h"
+
+#include "tick.h"
+
+// Runs in the EIC interrupt on every edge. The time is taken first so that
+// it's as close to the edge as possible.
+static void pulsein_handler(void) {
+    uint64_t now = tick_get_us();
+    mp_obj_t obj = MP_STATE_PORT(nativeio_extint)[extint_get_current_channel()];
+    if (obj == MP_OBJ_NULL) {
+        return;
+    }
+    nativeio_pulsein_obj_t* self = MP_OBJ_TO_PTR(obj);
+    if (self->first_edge) {
+        // Only start at the beginning of a pulse.
+        if (port_pin_get_input_level(self->pin->pin) != self->idle_state) {
+            self->first_edge = false;
+            self->last_us = now;
+        }
+        return;
+    }
+    uint64_t duration = now - self->last_us;
+    self->last_us = now;
+    if (duration > 0xffff) {
+        duration = 0xffff;
+    }
+    self->buffer[(self->start + self->len) % self->maxlen] = duration;
+    if (self->len < self->maxlen) {
+        self->len++;
+    } else {
+        // Full so drop the oldest.
+        self->start = (self->start + 1) % self->maxlen;
+    }
+}
+
+void pulsein_reset(void) {
+    for (int i = 0; i < EIC_NUMBER_OF_INTERRUPTS; i++) {
+        extint_chan_disable_callback(i, EXTINT_CALLBACK_TYPE_DETECT);
+        extint_unregister_callback(pulsein_handler, i, EXTINT_CALLBACK_TYPE_DETECT);
+        MP_STATE_PORT(nativeio_extint)[i] = MP_OBJ_NULL;
+    }
+}
+
+void common_hal_nativeio_pulsein_construct(nativeio_pulsein_obj_t* self,
+        const mcu_pin_obj_t* pin, uint16_t maxlen, bool idle_state) {
+    int8_t channel = nativeio_extint_channel(pin->pin);
+    if (channel < 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Pin does not have interrupt capabilities."));
+    }
+    if (MP_STATE_PORT(nativeio_extint)[channel] != MP_OBJ_NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Another pin is using the same interrupt."));
+    }
+    self->buffer = m_new(uint16_t, maxlen);
+    self->pin = pin;
+    self->maxlen = maxlen;
+    self->start = 0;
+    self->len = 0;
+    self->idle_state = idle_state;
+    self->paused = false;
+    self->first_edge = true;
+    self->last_us = 0;
+
+    struct extint_chan_conf config;
+    extint_chan_get_config_defaults(&config);
+    config.gpio_pin = pin->pin;
+    config.gpio_pin_mux = 0; // mux A is the EIC on every pin
+    config.gpio_pin_pull = EXTINT_PULL_NONE;
+    config.detection_criteria = EXTINT_DETECT_BOTH;
+    extint_chan_set_config(channel, &config);
+    extint_chan_clear_detected(channel);
+
+    MP_STATE_PORT(nativeio_extint)[channel] = MP_OBJ_FROM_PTR(self);
+    extint_register_callback(pulsein_handler, channel, EXTINT_CALLBACK_TYPE_DETECT);
+    extint_chan_enable_callback(channel, EXTINT_CALLBACK_TYPE_DETECT);
+}
+
+void common_hal_nativeio_pulsein_deinit(nativeio_pulsein_obj_t* self) {
+    if (self->buffer == NULL) {
+        return;
+    }
+    int8_t channel = nativeio_extint_channel(self->pin->pin);
+    extint_chan_disable_callback(channel, EXTINT_CALLBACK_TYPE_DETECT);
+    extint_unregister_callback(pulsein_handler, channel, EXTINT_CALLBACK_TYPE_DETECT);
+    MP_STATE_PORT(nativeio_extint)[channel] = MP_OBJ_NULL;
+
+    struct port_config pin_conf;
+    port_get_config_defaults(&pin_conf);
+    pin_conf.powersave  = true;
+    port_pin_set_config(self->pin->pin, &pin_conf);
+
+    m_del(uint16_t, self->buffer, self->maxlen);
+    self->buffer = NULL;
+    self->len = 0;
+}
+
+void common_hal_nativeio_pulsein_pause(nativeio_pulsein_obj_t* self) {
+    if (self->buffer == NULL || self->paused) {
+        return;
+    }
+    extint_chan_disable_callback(nativeio_extint_channel(self->pin->pin),
+        EXTINT_CALLBACK_TYPE_DETECT);
+    self->paused = true;
+}
+
+void common_hal_nativeio_pulsein_resume(nativeio_pulsein_obj_t* self) {
+    if (self->buffer == NULL || !self->paused) {
+        return;
+    }
+    int8_t channel = nativeio_extint_channel(self->pin->pin);
+    self->first_edge = true;
+    self->paused = false;
+    extint_chan_clear_detected(channel);
+    extint_chan_enable_callback(channel, EXTINT_CALLBACK_TYPE_DETECT);
+}
+
+void common_hal_nativeio_pulsein_clear(nativeio_pulsein_obj_t* self) {
+    irqflags_t flags = cpu_irq_save();
+    self->start = 0;
+    self->len = 0;
+    cpu_irq_restore(flags);
+}
+
+uint16_t common_hal_nativeio_pulsein_popleft(nativeio_pulsein_obj_t* self) {
+    irqflags_t flags = cpu_irq_save();
+    uint16_t value = self->buffer[self->start];
+    self->start = (self->start + 1) % self->maxlen;
+    self->len--;
+    cpu_irq_restore(flags);
+    return value;
+}
+
+uint16_t common_hal_nativeio_pulsein_get_item(nativeio_pulsein_obj_t* self, uint16_t index) {
+    irqflags_t flags = cpu_irq_save();
+    uint16_t value = self->buffer[(self->start + index) % self->maxlen];
+    cpu_irq_restore(flags);
+    return value;
+}
+
+uint16_t common_hal_nativeio_pulsein_get_len(nativeio_pulsein_obj_t* self) {
+    return self->len;
+}
+
+uint16_t common_hal_nativeio_pulsein_get_maxlen(nativeio_pulsein_obj_t* self) {
+    return self->maxlen;
+}
@@ -29,7 +29,9 @@
 
 #include "shared-bindings/nativeio/SPI.h"
 #include "py/nlr.h"
+#include "py/mpstate.h"
 #include "samd21_pins.h"
+#include "shared_dma.h"
 
 // We use ENABLE registers below we don't want to treat as a macro.
 #undef ENABLE
@@ -37,6 +39,37 @@
 // Number of times to try to send packet if failed.
 #define TIMEOUT 1
 
+// DMA channel used for background writes. Only one write can be in flight at
+// a time across all SPI objects.
+#define SPI_DMA_CHANNEL SHARED_DMA_SPI_CHANNEL
+
+// A single DMA descriptor can move at most 65535 beats so longer writes are
+// split across a chain of descriptors.
+#define SPI_DMA_MAX_BLOCK 0xffff
+#define SPI_DMA_NUM_BLOCKS 4
+
+// The first descriptor of the chain is the channel's own descriptor. The rest
+// can be anywhere in SRAM.
+COMPILER_ALIGNED(16) static DmacDescriptor dma_chain[SPI_DMA_NUM_BLOCKS - 1];
+
+// The SPI object whose write is in flight lives in MP_STATE_PORT so that it
+// and its buffer stay reachable by the GC.
+#define dma_owner MP_STATE_PORT(spi_dma_owner)
+
+// Finishes off a DMA write once the DMAC has handed over the last byte. The
+// SPI peripheral may still be shifting it out and, when MISO is in use, will
+// have received (and overflowed on) bytes nobody read.
+static void dma_finish(nativeio_spi_obj_t *self) {
+    SercomSpi *const spi_module = &(self->spi_master_instance.hw->SPI);
+    while (!spi_module->INTFLAG.bit.TXC) {}
+    while (spi_module->INTFLAG.bit.RXC) {
+        (void) spi_module->DATA.reg;
+    }
+    spi_module->STATUS.reg = SERCOM_SPI_STATUS_BUFOVF;
+    self->dma_buffer = MP_OBJ_NULL;
+    dma_owner = NULL;
+}
+
 void common_hal_nativeio_spi_construct(nativeio_spi_obj_t *self,
         const mcu_pin_obj_t * clock, const mcu_pin_obj_t * mosi,
         const mcu_pin_obj_t * miso) {
@@ -132,16 +165,23 @@ void common_hal_nativeio_spi_construct(nativeio_spi_obj_t *self,
     }
 
     spi_init(&self->spi_master_instance, sercom, &config_spi_master);
+    self->dma_buffer = MP_OBJ_NULL;
 
     spi_enable(&self->spi_master_instance);
 }
 
 void common_hal_nativeio_spi_deinit(nativeio_spi_obj_t *self) {
+    if (dma_owner == self) {
+        shared_dma_abort(SPI_DMA_CHANNEL);
+        self->dma_buffer = MP_OBJ_NULL;
+        dma_owner = NULL;
+    }
     spi_disable(&self->spi_master_instance);
 }
 
 bool common_hal_nativeio_spi_configure(nativeio_spi_obj_t *self,
         uint32_t baudrate, uint8_t polarity, uint8_t phase, uint8_t bits) {
+    common_hal_nativeio_spi_wait_for_write(self);
     // TODO(tannewt): Check baudrate first before changing it.
     enum status_code status = spi_set_baudrate(&self->spi_master_instance, baudrate);
     if (status != STATUS_OK) {
@@ -189,6 +229,7 @@ bool common_hal_nativeio_spi_has_lock(nativeio_spi_obj_t *self) {
 }
 
 void common_hal_nativeio_spi_unlock(nativeio_spi_obj_t *self) {
+    common_hal_nativeio_spi_wait_for_write(self);
     self->has_lock = false;
     spi_unlock(&self->spi_master_instance);
 }
@@ -198,6 +239,7 @@ bool common_hal_nativeio_spi_write(nativeio_spi_obj_t *self,
     if (len == 0) {
         return true;
     }
+    common_hal_nativeio_spi_wait_for_write(self);
     enum status_code status = spi_write_buffer_wait(
         &self->spi_master_instance,
         data,
@@ -210,6 +252,7 @@ bool common_hal_nativeio_spi_read(nativeio_spi_obj_t *self,
     if (len == 0) {
         return true;
     }
+    common_hal_nativeio_spi_wait_for_write(self);
     enum status_code status = spi_read_buffer_wait(
         &self->spi_master_instance,
         data,
@@ -217,3 +260,86 @@ bool common_hal_nativeio_spi_read(nativeio_spi_obj_t *self,
         0);
     return status == STATUS_OK;
 }
+
+bool common_hal_nativeio_spi_start_write(nativeio_spi_obj_t *self,
+        mp_obj_t buffer, const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    SercomSpi *const spi_module = &(self->spi_master_instance.hw->SPI);
+    // 9 bit characters need 16 bit beats from a differently laid out buffer
+    // and writes beyond the descriptor chain are rare enough that both just
+    // fall back to a blocking write.
+    if (spi_module->CTRLB.bit.CHSIZE != 0 ||
+        len > SPI_DMA_MAX_BLOCK * SPI_DMA_NUM_BLOCKS) {
+        return common_hal_nativeio_spi_write(self, data, len);
+    }
+    if (dma_owner != NULL) {
+        common_hal_nativeio_spi_wait_for_write(dma_owner);
+    }
+    shared_dma_init();
+
+    uint8_t sercom_index = _sercom_get_sercom_inst_index(self->spi_master_instance.hw);
+    shared_dma_configure(SPI_DMA_CHANNEL, SERCOM0_DMAC_ID_TX + 2 * sercom_index);
+
+    DmacDescriptor *descriptor = shared_dma_descriptor(SPI_DMA_CHANNEL);
+    for (size_t i = 0; len > 0; i++) {
+        uint16_t block_len = len > SPI_DMA_MAX_BLOCK ? SPI_DMA_MAX_BLOCK : len;
+        descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC |
+            DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_BLOCKACT_NOACT;
+        descriptor->BTCNT.reg = block_len;
+        // With address increment enabled the DMAC wants the end address.
+        descriptor->SRCADDR.reg = (uint32_t) (data + block_len);
+        descriptor->DSTADDR.reg = (uint32_t) &spi_module->DATA.reg;
+        data += block_len;
+        len -= block_len;
+        if (len > 0) {
+            descriptor->DESCADDR.reg = (uint32_t) &dma_chain[i];
+            descriptor = &dma_chain[i];
+        } else {
+            descriptor->DESCADDR.reg = 0;
+        }
+    }
+
+    self->dma_buffer = buffer;
+    dma_owner = self;
+    shared_dma_enable(SPI_DMA_CHANNEL);
+    return true;
+}
+
+bool common_hal_nativeio_spi_write_in_progress(nativeio_spi_obj_t *self) {
+    if (dma_owner != self) {
+        return false;
+    }
+    if (shared_dma_busy(SPI_DMA_CHANNEL)) {
+        return true;
+    }
+    dma_finish(self);
+    return false;
+}
+
+void common_hal_nativeio_spi_wait_for_write(nativeio_spi_obj_t *self) {
+    if (dma_owner != self) {
+        return;
+    }
+    while (shared_dma_busy(SPI_DMA_CHANNEL)) {
+        #ifdef MICROPY_VM_HOOK_LOOP
+            MICROPY_VM_HOOK_LOOP
+        #endif
+    }
+    dma_finish(self);
+}
+
+bool common_hal_nativeio_spi_transfer(nativeio_spi_obj_t *self,
+        const uint8_t *data_out, uint8_t *data_in, size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    common_hal_nativeio_spi_wait_for_write(self);
+    enum status_code status = spi_transceive_buffer_wait(
+        &self->spi_master_instance,
+        (uint8_t*) data_out,
+        data_in,
+        len);
+    return status == STATUS_OK;
+}
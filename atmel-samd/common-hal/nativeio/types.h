@@ -40,6 +40,7 @@
 #include "asf/sam0/drivers/adc/adc_sam_d_r/adc_feature.h"
 
 #include "asf/sam0/drivers/dac/dac.h"
+#include "asf/sam0/drivers/port/port.h"
 #include "asf/sam0/drivers/sercom/i2c/i2c_master.h"
 #include "asf/sam0/drivers/sercom/spi/spi.h"
 #include "asf/sam0/drivers/tc/tc.h"
@@ -51,38 +52,109 @@ typedef struct {
     mp_obj_base_t base;
     const mcu_pin_obj_t * pin;
     struct adc_module adc_instance;
+    // Timer pacing conversions and the buffer DMA is capturing into, if any.
+    struct tc_module tc_instance;
+    mp_obj_t capture_buffer;
+    uint8_t next_half;
 } nativeio_analogin_obj_t;
 
+typedef struct {
+    mp_obj_base_t base;
+    struct adc_module adc_instance;
+    // The ADC scans the consecutive inputs from first_input. offsets holds
+    // where in that run each pin's result comes, in the order given.
+    uint8_t first_input;
+    uint8_t num_inputs;
+    uint8_t num_pins;
+    uint8_t offsets[16];
+} nativeio_analoginscan_obj_t;
+
 typedef struct {
     mp_obj_base_t base;
     struct dac_module dac_instance;
+    // Timer pacing playback and the buffer DMA is playing from, if any.
+    struct tc_module tc_instance;
+    mp_obj_t playback_buffer;
+    uint8_t next_half;
 } nativeio_analogout_obj_t;
 
 typedef struct {
     mp_obj_base_t base;
     const mcu_pin_obj_t * pin;
+    // Looked up once so the fast paths in DigitalInOut.h don't have to.
+    PortGroup *port;
+    uint32_t mask;
     bool output;
     bool open_drain;
+    // Called through the scheduler when the input changes, see irq().
+    mp_obj_t irq_handler;
 } nativeio_digitalinout_obj_t;
 
+typedef struct {
+    mp_obj_base_t base;
+    // All of the bus pins are on port. bits holds each pin's bit in it, in
+    // order, and when contiguous is set pin i is simply bit bits[0] + i.
+    PortGroup *port;
+    uint32_t mask;
+    PortGroup *strobe_port;
+    uint32_t strobe_mask;
+    uint8_t num_pins;
+    uint8_t bits[16];
+    bool contiguous;
+    bool output;
+} nativeio_digitalbus_obj_t;
+
+typedef struct {
+    mp_obj_base_t base;
+    const mcu_pin_obj_t * pin;
+    // Ring buffer of pulse lengths in microseconds, filled from the EIC
+    // interrupt. len counts up to maxlen and then start moves instead.
+    uint16_t *buffer;
+    uint16_t maxlen;
+    volatile uint16_t start;
+    volatile uint16_t len;
+    bool idle_state;
+    bool paused;
+    // Set until the first edge away from idle_state, which starts a pulse.
+    volatile bool first_edge;
+    // Time of the last edge, as returned by tick_get_us.
+    volatile uint64_t last_us;
+} nativeio_pulsein_obj_t;
+
 typedef struct {
     mp_obj_base_t base;
     struct i2c_master_module i2c_master_instance;
     bool has_lock;
+    // Kept so the SERCOM can be reinitialized at another frequency.
+    uint32_t sda_pinmux;
+    uint32_t scl_pinmux;
+    // Whether packets are sent with high speed mode (3.4MHz).
+    bool high_speed;
+    // The read half of a write then read transaction. It's started from the
+    // interrupt once the write is done.
+    struct i2c_master_packet read_packet;
+    // Buffers used by a transaction in the background. Referenced here so
+    // they can't be collected before it's done.
+    mp_obj_t out_buffer;
+    mp_obj_t in_buffer;
+    volatile uint8_t transfer_state;
 } nativeio_i2c_obj_t;
 
 typedef struct _machine_spi_obj_t {
     mp_obj_base_t base;
     struct spi_module spi_master_instance;
     bool has_lock;
+    // Buffer being clocked out by DMA. Referenced here so it can't be
+    // collected until the write completes.
+    mp_obj_t dma_buffer;
 } nativeio_spi_obj_t;
 
 typedef struct {
     mp_obj_base_t base;
     const mcu_pin_obj_t *pin;
+    // The timers themselves are shared and kept in PWMOut.c.
     bool using_primary_timer;
-    struct tc_module tc_instance;
-    struct tcc_module tcc_instance;
+    uint16_t duty;
 } nativeio_pwmout_obj_t;
 
 #endif // __MICROPY_INCLUDED_ATMEL_SAMD_COMMON_HAL_NATIVEIO_TYPES_H__
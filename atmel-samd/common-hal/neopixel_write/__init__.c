@@ -29,8 +29,202 @@
 #include "shared-bindings/neopixel_write/__init__.h"
 
 #include "asf/common2/services/delay/delay.h"
+#include "asf/sam0/drivers/sercom/spi/spi.h"
+
+#include "py/gc.h"
+#include "py/mpstate.h"
+#include "samd21_pins.h"
+#include "shared_dma.h"
+
+// We use ENABLE registers below we don't want to treat as a macro.
+#undef ENABLE
+
+// Strips shorter than this are bit banged. It only blocks interrupts briefly
+// and works before the heap is up, which the status NeoPixel needs.
+#define DMA_MIN_BYTES 24
+
+// Each NeoPixel bit is sent as three SPI bits, 100 for a 0 and 110 for a 1,
+// so the SPI clock is three times the bit rate.
+#define SPI_BITS_PER_BIT 3
+#define DMA_MAX_BLOCK 0xffff
+
+// Two buffers of encoded data are kept so that the next frame can be encoded
+// while the last one is still going out. Each holds the encoded data after
+// its extra DMA descriptors and lives in MP_STATE_PORT so the GC keeps it.
+#define dma_buffers MP_STATE_PORT(neopixel_dma_buffers)
+static size_t dma_buffer_len[2];
+// The buffer being sent, or -1 when idle.
+static int8_t dma_active = -1;
+static struct spi_module dma_spi;
+static uint8_t dma_pin;
+
+// Waits for a DMA write to finish and hands its pin back to the GPIO
+// registers, held low.
+static void finish_dma_write(void) {
+    if (dma_active < 0) {
+        return;
+    }
+    while (shared_dma_busy(SHARED_DMA_NEOPIXEL_CHANNEL)) {
+        #ifdef MICROPY_VM_HOOK_LOOP
+            MICROPY_VM_HOOK_LOOP
+        #endif
+    }
+    while (!dma_spi.hw->SPI.INTFLAG.bit.TXC) {}
+
+    port_pin_set_output_level(dma_pin, false);
+    struct system_pinmux_config pin_conf;
+    system_pinmux_get_config_defaults(&pin_conf);
+    pin_conf.mux_position = SYSTEM_PINMUX_GPIO;
+    pin_conf.direction = SYSTEM_PINMUX_PIN_DIR_OUTPUT;
+    system_pinmux_pin_set_config(dma_pin, &pin_conf);
+    spi_disable(&dma_spi);
+    spi_reset(&dma_spi);
+    dma_active = -1;
+
+    // Let the pixels latch the data.
+    delay_us(50);
+}
+
+void reset_neopixel_dma(void) {
+    // The SERCOMs and DMAC are reset along with us and the heap is about to
+    // go away so there's nothing to wait for.
+    dma_buffers[0] = NULL;
+    dma_buffers[1] = NULL;
+    dma_buffer_len[0] = 0;
+    dma_buffer_len[1] = 0;
+    dma_active = -1;
+}
+
+// Finds a free SERCOM that can drive the pin as MOSI and sets it up as an SPI
+// master at the given clock rate.
+static bool init_dma_spi(uint8_t pin, const mcu_pin_obj_t *mcu_pin, uint32_t baudrate) {
+    for (int i = 0; i < NUM_SERCOMS_PER_PIN; i++) {
+        Sercom* sercom = mcu_pin->sercom[i].sercom;
+        if (sercom == NULL || sercom->SPI.CTRLA.bit.ENABLE != 0) {
+            continue;
+        }
+        // Any pad but 1 can be MOSI. Clock goes to 1 or 3 and is unused.
+        uint8_t pad = mcu_pin->sercom[i].pad;
+        static const uint8_t dopo_for_pad[] = {0, 0xff, 1, 2};
+        if (dopo_for_pad[pad] == 0xff) {
+            continue;
+        }
+        struct spi_config config;
+        spi_get_config_defaults(&config);
+        config.mux_setting = dopo_for_pad[pad] << SERCOM_SPI_CTRLA_DOPO_Pos;
+        config.receiver_enable = false;
+        config.mode_specific.master.baudrate = baudrate;
+        config.pinmux_pad0 = PINMUX_UNUSED;
+        config.pinmux_pad1 = PINMUX_UNUSED;
+        config.pinmux_pad2 = PINMUX_UNUSED;
+        config.pinmux_pad3 = PINMUX_UNUSED;
+        uint32_t *pinmuxes[4] = {&config.pinmux_pad0, &config.pinmux_pad1,
+                                 &config.pinmux_pad2, &config.pinmux_pad3};
+        *pinmuxes[pad] = PINMUX(pin, (i == 0) ? MUX_C : MUX_D);
+        if (spi_init(&dma_spi, sercom, &config) != STATUS_OK) {
+            continue;
+        }
+        spi_enable(&dma_spi);
+        return true;
+    }
+    return false;
+}
+
+// Encodes the pixels into SPI bits in the idle buffer, waits for any previous
+// write and starts DMA clocking the new one out. Returns false if the pin or
+// memory don't allow it.
+static bool start_dma_write(const nativeio_digitalinout_obj_t* digitalinout, uint8_t *pixels, uint32_t numBytes, bool is800KHz) {
+    size_t encoded_len = numBytes * SPI_BITS_PER_BIT;
+    size_t num_blocks = (encoded_len + DMA_MAX_BLOCK - 1) / DMA_MAX_BLOCK;
+    // Room to align the extra descriptors to 16 bytes as the DMAC requires.
+    size_t alloc_len = encoded_len + 16 + (num_blocks - 1) * sizeof(DmacDescriptor);
+
+    int8_t next = dma_active == 0 ? 1 : 0;
+    if (dma_buffer_len[next] < alloc_len) {
+        if (dma_buffers[next] != NULL) {
+            gc_free(dma_buffers[next]);
+            dma_buffers[next] = NULL;
+            dma_buffer_len[next] = 0;
+        }
+        dma_buffers[next] = m_new_maybe(uint8_t, alloc_len);
+        if (dma_buffers[next] == NULL) {
+            return false;
+        }
+        dma_buffer_len[next] = alloc_len;
+    }
+
+    uint8_t *buffer = dma_buffers[next];
+    DmacDescriptor *chain = (DmacDescriptor*) (((uintptr_t) buffer + 15) & ~(uintptr_t) 15);
+    uint8_t *encoded = (uint8_t*) (chain + num_blocks - 1);
+    // Every 8 pixel bits become 24 SPI bits, so each byte becomes three.
+    for (uint32_t i = 0; i < numBytes; i++) {
+        uint32_t bits = 0;
+        for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+            bits = (bits << 3) | ((pixels[i] & mask) ? 0x6 : 0x4);
+        }
+        encoded[3 * i] = bits >> 16;
+        encoded[3 * i + 1] = bits >> 8;
+        encoded[3 * i + 2] = bits;
+    }
+
+    finish_dma_write();
+    uint8_t pin = digitalinout->pin->pin;
+    if (!init_dma_spi(pin, digitalinout->pin, (is800KHz ? 800000 : 400000) * SPI_BITS_PER_BIT)) {
+        return false;
+    }
+    dma_pin = pin;
+
+    shared_dma_init();
+    uint8_t sercom_index = _sercom_get_sercom_inst_index(dma_spi.hw);
+    shared_dma_configure(SHARED_DMA_NEOPIXEL_CHANNEL, SERCOM0_DMAC_ID_TX + 2 * sercom_index);
+    DmacDescriptor *descriptor = shared_dma_descriptor(SHARED_DMA_NEOPIXEL_CHANNEL);
+    for (size_t i = 0; encoded_len > 0; i++) {
+        uint16_t block_len = encoded_len > DMA_MAX_BLOCK ? DMA_MAX_BLOCK : encoded_len;
+        descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC |
+            DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_BLOCKACT_NOACT;
+        descriptor->BTCNT.reg = block_len;
+        // With address increment enabled the DMAC wants the end address.
+        descriptor->SRCADDR.reg = (uint32_t) (encoded + block_len);
+        descriptor->DSTADDR.reg = (uint32_t) &dma_spi.hw->SPI.DATA.reg;
+        encoded += block_len;
+        encoded_len -= block_len;
+        if (encoded_len > 0) {
+            descriptor->DESCADDR.reg = (uint32_t) &chain[i];
+            descriptor = &chain[i];
+        } else {
+            descriptor->DESCADDR.reg = 0;
+        }
+    }
+    dma_active = next;
+    shared_dma_enable(SHARED_DMA_NEOPIXEL_CHANNEL);
+    return true;
+}
+
+bool common_hal_neopixel_write_in_progress(void) {
+    if (dma_active < 0) {
+        return false;
+    }
+    if (shared_dma_busy(SHARED_DMA_NEOPIXEL_CHANNEL)) {
+        return true;
+    }
+    finish_dma_write();
+    return false;
+}
+
+void common_hal_neopixel_write_wait(void) {
+    finish_dma_write();
+}
 
 void common_hal_neopixel_write(const nativeio_digitalinout_obj_t* digitalinout, uint8_t *pixels, uint32_t numBytes, bool is800KHz) {
+    // Longer strips are streamed out by a SERCOM with interrupts left on and
+    // without waiting for the write to finish. The next frame is encoded
+    // while the last one is sent.
+    if (numBytes >= DMA_MIN_BYTES && start_dma_write(digitalinout, pixels, numBytes, is800KHz)) {
+        return;
+    }
+    // Only one strip can be written at a time.
+    finish_dma_write();
+
     // This is adapted directly from the Adafruit NeoPixel library SAMD21G18A code:
     // https://github.com/adafruit/Adafruit_NeoPixel/blob/master/Adafruit_NeoPixel.cpp
     uint8_t  *ptr, *end, p, bitMask;
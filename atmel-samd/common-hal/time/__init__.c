@@ -31,7 +31,11 @@
 #include "tick.h"
 
 inline uint64_t common_hal_time_monotonic() {
-    return ticks_ms;
+    return tick_get_ms();
+}
+
+uint64_t common_hal_time_monotonic_us() {
+    return tick_get_us();
 }
 
 void common_hal_time_delay_ms(uint32_t delay) {
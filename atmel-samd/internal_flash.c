@@ -124,6 +124,15 @@ static int32_t convert_block_to_flash_addr(uint32_t block) {
     return -1;
 }
 
+const uint8_t *internal_flash_block_address(uint32_t block) {
+    // The NVM is mapped from address zero so the blocks can be read directly.
+    int32_t addr = convert_block_to_flash_addr(block);
+    if (addr == -1) {
+        return NULL;
+    }
+    return (const uint8_t *) addr;
+}
+
 bool internal_flash_read_block(uint8_t *dest, uint32_t block) {
     //printf("RD %u\n", block);
     if (block == 0) {
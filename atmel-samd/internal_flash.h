@@ -44,6 +44,9 @@ void internal_flash_irq_handler(void);
 void internal_flash_flush(void);
 bool internal_flash_read_block(uint8_t *dest, uint32_t block);
 bool internal_flash_write_block(const uint8_t *src, uint32_t block);
+// Where the block can be read in place, or NULL if it isn't a file system
+// block.
+const uint8_t *internal_flash_block_address(uint32_t block);
 
 // these return 0 on success, non-zero on error
 mp_uint_t internal_flash_read_blocks(uint8_t *dest, uint32_t block_num, uint32_t num_blocks);
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "mpconfigport.h"
+
+#include "boot_phases.h"
+#include "lazy_boot.h"
+
+#include "asf/common/services/usb/udc/udc.h"
+#include "asf/sam0/drivers/port/port.h"
+
+#ifdef LAZY_BOOT
+
+volatile bool lazy_boot_usb_wanted = false;
+static bool usb_started = false;
+
+// In main.c, creates the filesystem if the flash doesn't have one.
+void flash_fs_check(void);
+
+void lazy_boot_init(void) {
+    #ifdef MICROPY_HW_USB_VBUS
+    struct port_config pin_conf;
+    port_get_config_defaults(&pin_conf);
+    pin_conf.direction = PORT_PIN_DIR_INPUT;
+    pin_conf.input_pull = PORT_PIN_PULL_DOWN;
+    port_pin_set_config(MICROPY_HW_USB_VBUS, &pin_conf);
+    #endif
+}
+
+void lazy_boot_tick(void) {
+    #ifdef MICROPY_HW_USB_VBUS
+    if (!usb_started && port_pin_get_input_level(MICROPY_HW_USB_VBUS)) {
+        lazy_boot_usb_wanted = true;
+    }
+    #endif
+}
+
+void lazy_boot_start_usb(void) {
+    lazy_boot_usb_wanted = false;
+    if (usb_started) {
+        return;
+    }
+    usb_started = true;
+    // The host will want a filesystem on the drive it's shown.
+    flash_fs_check();
+    #ifdef USB_REPL
+    udc_start();
+    #endif
+    boot_phase_end(MP_QSTR_usb);
+}
+
+#endif
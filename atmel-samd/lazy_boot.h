@@ -0,0 +1,50 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_ATMEL_SAMD_LAZY_BOOT_H__
+#define __MICROPY_INCLUDED_ATMEL_SAMD_LAZY_BOOT_H__
+
+#include <stdbool.h>
+
+// Boards that define LAZY_BOOT start running code.py without starting USB
+// or mounting the flash filesystem first, for units that mostly run from a
+// battery and never see a host. The filesystem is mounted by FatFs on its
+// first use. USB is started, and a fresh filesystem created if there is none
+// yet, once a host powers the board's MICROPY_HW_USB_VBUS pin, if it has
+// one, or once something reads the REPL, at the latest when code.py ends.
+
+// Set from the tick when VBUS comes up, USB is started from the VM hook.
+extern volatile bool lazy_boot_usb_wanted;
+
+void lazy_boot_init(void);
+
+// Called every millisecond to look at VBUS.
+void lazy_boot_tick(void);
+
+// Start USB if it isn't yet. Only called outside of interrupts.
+void lazy_boot_start_usb(void);
+
+#endif  // __MICROPY_INCLUDED_ATMEL_SAMD_LAZY_BOOT_H__
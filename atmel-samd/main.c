@@ -3,6 +3,7 @@
 
 #include "py/nlr.h"
 #include "py/compile.h"
+#include "py/frozenmod.h"
 #include "py/mphal.h"
 #include "py/runtime.h"
 #include "py/repl.h"
@@ -22,8 +23,13 @@
 #include <board.h>
 
 #include "autoreset.h"
+#include "boot_phases.h"
+#include "code_cache.h"
+#include "lazy_boot.h"
 #include "mpconfigboard.h"
 #include "neopixel_status.h"
+#include "reload.h"
+#include "shared_dma.h"
 #include "tick.h"
 
 fs_user_mount_t fs_user_mount_flash;
@@ -61,22 +67,14 @@ static const char fresh_readme_txt[] =
 
 extern void flash_init_vfs(fs_user_mount_t *vfs);
 
-// we don't make this function static because it needs a lot of stack and we
-// want it to be executed without using stack within main() function
-void init_flash_fs(void) {
-    // init the vfs object
-    fs_user_mount_t *vfs = &fs_user_mount_flash;
-    vfs->str = "/flash";
-    vfs->len = 6;
-    vfs->flags = 0;
-    flash_init_vfs(vfs);
-
-    // put the flash device in slot 0 (it will be unused at this point)
-    MP_STATE_PORT(fs_user_mount)[0] = vfs;
-
-    // try to mount the flash
-    FRESULT res = f_mount(&vfs->fatfs, vfs->str, 1);
+#if MICROPY_MODULE_FROZEN_BUNDLE
+// The internal flash set aside for the bundle by the linker script.
+extern uint32_t _sbundle, _ebundle;
+#endif
 
+// Creates a fresh filesystem if mounting the flash found none. Returns false
+// if the flash can't be used.
+static bool flash_fs_mounted(fs_user_mount_t *vfs, FRESULT res) {
     if (res == FR_NO_FILESYSTEM) {
         // no filesystem, or asked to reset it, so create a fresh one
 
@@ -91,7 +89,7 @@ void init_flash_fs(void) {
         } else {
             printf("PYB: can't create flash filesystem\n");
             MP_STATE_PORT(fs_user_mount)[0] = NULL;
-            return;
+            return false;
         }
 
         // set label
@@ -119,18 +117,60 @@ void init_flash_fs(void) {
     } else {
         printf("PYB: can't mount flash\n");
         MP_STATE_PORT(fs_user_mount)[0] = NULL;
+        return false;
+    }
+    return true;
+}
+
+// we don't make this function static because it needs a lot of stack and we
+// want it to be executed without using stack within main() function
+void init_flash_fs(void) {
+    // init the vfs object
+    fs_user_mount_t *vfs = &fs_user_mount_flash;
+    vfs->str = "/flash";
+    vfs->len = 6;
+    vfs->flags = 0;
+    flash_init_vfs(vfs);
+
+    // put the flash device in slot 0 (it will be unused at this point)
+    MP_STATE_PORT(fs_user_mount)[0] = vfs;
+
+    #ifdef LAZY_BOOT
+    // only register the flash, FatFs mounts it when it's first used
+    f_mount(&vfs->fatfs, vfs->str, 0);
+    #else
+    // try to mount the flash
+    if (!flash_fs_mounted(vfs, f_mount(&vfs->fatfs, vfs->str, 1))) {
         return;
     }
+    #endif
 
     // The current directory is used as the boot up directory.
     // It is set to the internal flash filesystem by default.
     f_chdrive("/flash");
 }
 
+#ifdef LAZY_BOOT
+void flash_fs_check(void) {
+    fs_user_mount_t *vfs = &fs_user_mount_flash;
+    if (MP_STATE_PORT(fs_user_mount)[0] != vfs) {
+        return;
+    }
+    // opening the root mounts the flash if nothing has yet, without
+    // disturbing files that are open
+    DIR dir;
+    FRESULT res = f_opendir(&dir, vfs->str);
+    if (res == FR_OK) {
+        f_closedir(&dir);
+    }
+    flash_fs_mounted(vfs, res);
+}
+#endif
+
 static char *stack_top;
 static char heap[16384];
 
-void reset_mp(void) {
+static void prepare_for_reset(void) {
     new_status_color(0x8f, 0x00, 0x8f);
     autoreset_stop();
     autoreset_enable();
@@ -140,11 +180,31 @@ void reset_mp(void) {
     disk_ioctl(0, CTRL_SYNC, NULL);
     disk_ioctl(1, CTRL_SYNC, NULL);
     disk_ioctl(2, CTRL_SYNC, NULL);
+    #ifdef SPI_FLASH_SERCOM
+        // The sync only starts flushing the SPI flash cache in the background.
+        spi_flash_flush();
+    #endif
+}
+
+// Keeps the heap and every module that is still current rather than starting
+// from scratch. Used when files saved over USB trigger the reset.
+static bool reload_mp(void) {
+    prepare_for_reset();
+    return reload_prepare();
+}
+
+void reset_mp(void) {
+    prepare_for_reset();
 
     #if MICROPY_ENABLE_GC
     gc_init(heap, heap + sizeof(heap));
     #endif
     mp_init();
+    #if MICROPY_MODULE_FROZEN_BUNDLE
+    // Before anything else interns a qstr so that the ids of the bundle's
+    // are free. Erased or out of date bundles are ignored.
+    mp_frozen_bundle_mount((const byte *) &_sbundle, (const byte *) &_ebundle - (const byte *) &_sbundle);
+    #endif
     mp_obj_list_init(mp_sys_path, 0);
     mp_obj_list_append(mp_sys_path, MP_OBJ_NEW_QSTR(MP_QSTR_)); // current dir (or base dir of the script)
     mp_obj_list_append(mp_sys_path, MP_OBJ_NEW_QSTR(MP_QSTR__slash_flash));
@@ -152,9 +212,29 @@ void reset_mp(void) {
     mp_obj_list_init(mp_sys_argv, 0);
 
     MP_STATE_PORT(mp_kbd_exception) = mp_obj_new_exception(&mp_type_KeyboardInterrupt);
+    reload_init();
+    code_cache_init();
 }
 
+extern void reset_analogin_capture(void);
+extern void reset_analogout_playback(void);
+extern void reset_neopixel_dma(void);
+extern void pwmout_reset(void);
+extern void digitalinout_reset(void);
+extern void pulsein_reset(void);
+
 void reset_samd21(void) {
+    // Stop any background DMA. Its buffers are about to go away with the
+    // heap.
+    shared_dma_reset();
+    MP_STATE_PORT(spi_dma_owner) = NULL;
+    reset_analogin_capture();
+    reset_analogout_playback();
+    reset_neopixel_dma();
+    pwmout_reset();
+    digitalinout_reset();
+    pulsein_reset();
+
     // Reset all SERCOMs except the one being used by the SPI flash.
     Sercom *sercom_instances[SERCOM_INST_NUM] = SERCOM_INSTS;
     for (int i = 0; i < SERCOM_INST_NUM; i++) {
@@ -198,6 +278,7 @@ void start_mp(void) {
                       maybe_run("settings.py", &ret) ||
                       maybe_run("boot.py", &ret) ||
                       maybe_run("boot.txt", &ret);
+    boot_phase_end(MP_QSTR_boot_py);
     if (found_boot && ret & PYEXEC_FORCED_EXIT) {
         return;
     }
@@ -207,6 +288,7 @@ void start_mp(void) {
         maybe_run("code.py", &ret) ||
         maybe_run("main.py", &ret) ||
         maybe_run("main.txt", &ret);
+    boot_phase_end(MP_QSTR_code_py);
 }
 
 #ifdef UART_REPL
@@ -239,6 +321,19 @@ void load_serial_number(void) {
     }
 }
 
+// There's no hardware RNG, so urandom is seeded from the serial number, which
+// differs between boards, and the cycle count and time when it's first
+// imported, which differ between runs.
+uint32_t samd21_random_seed(void) {
+    uint32_t* addresses[4] = {(uint32_t *) 0x0080A00C, (uint32_t *) 0x0080A040,
+                              (uint32_t *) 0x0080A044, (uint32_t *) 0x0080A048};
+    uint32_t seed = tick_get_cycles() ^ (uint32_t) tick_get_ms();
+    for (int i = 0; i < 4; i++) {
+        seed = (seed ^ *(addresses[i])) * 0x9e3779b1;
+    }
+    return seed;
+}
+
 void samd21_init(void) {
 #ifdef ENABLE_MICRO_TRACE_BUFFER
     REG_MTB_POSITION = ((uint32_t) (mtb - REG_MTB_BASE)) & 0xFFFFFFF8;
@@ -272,6 +367,7 @@ void samd21_init(void) {
     // port_pin_set_output_level(MICROPY_HW_LED1, false);
 
     neopixel_status_init();
+    boot_phase_end(MP_QSTR_samd21_init);
 }
 
 int main(int argc, char **argv) {
@@ -284,15 +380,20 @@ int main(int argc, char **argv) {
     // stack between here and where gc_collect is called.
     stack_top = (char*)&stack_dummy;
     reset_mp();
+    boot_phase_end(MP_QSTR_reset_mp);
 
     // Initialise the local flash filesystem after the gc in case we need to
     // grab memory from it. Create it if needed, mount in on /flash, and set it
     // as current dir.
     init_flash_fs();
+    boot_phase_end(MP_QSTR_init_flash_fs);
 
     // Start USB after getting everything going.
-    #ifdef USB_REPL
+    #ifdef LAZY_BOOT
+        lazy_boot_init();
+    #elif defined(USB_REPL)
         udc_start();
+        boot_phase_end(MP_QSTR_usb);
     #endif
 
     // Run boot and main.
@@ -302,6 +403,10 @@ int main(int argc, char **argv) {
     // The REPL mode can change, or it can request a soft reset.
     int exit_code = 0;
     for (;;) {
+        #ifdef LAZY_BOOT
+        // the REPL is no use without a host
+        lazy_boot_start_usb();
+        #endif
         new_status_color(0x3f, 0x3f, 0x3f);
         if (pyexec_mode_kind == PYEXEC_MODE_RAW_REPL) {
             exit_code = pyexec_raw_repl();
@@ -309,9 +414,19 @@ int main(int argc, char **argv) {
             exit_code = pyexec_friendly_repl();
         }
         if (exit_code == PYEXEC_FORCED_EXIT) {
-            mp_hal_stdout_tx_str("soft reboot\r\n");
+            // Autoreset ends the REPL the same way as CTRL-D.
+            bool autoreset = reset_next_character;
+            boot_phases_clear();
+            boot_phase_end(MP_QSTR_repl);
             reset_samd21();
-            reset_mp();
+            if (autoreset && reload_mp()) {
+                mp_hal_stdout_tx_str("soft reload\r\n");
+                boot_phase_end(MP_QSTR_reload);
+            } else {
+                mp_hal_stdout_tx_str("soft reboot\r\n");
+                reset_mp();
+                boot_phase_end(MP_QSTR_reset_mp);
+            }
             start_mp();
         } else if (exit_code != 0) {
             break;
@@ -343,10 +458,9 @@ mp_lexer_t *mp_lexer_new_from_file(const char *filename) {
     #endif
 }
 
-mp_import_stat_t fat_vfs_import_stat(const char *path);
 mp_import_stat_t mp_import_stat(const char *path) {
     #if MICROPY_VFS_FAT
-    return fat_vfs_import_stat(path);
+    return reload_import_stat(path);
     #else
     (void)path;
     return MP_IMPORT_STAT_NO_EXIST;
@@ -30,6 +30,7 @@
 #include "py/mpstate.h"
 #include "py/objtuple.h"
 #include "py/objstr.h"
+#include "py/runtime.h"
 #include "genhdr/mpversion.h"
 #include "lib/fatfs/ff.h"
 #include "lib/fatfs/diskio.h"
@@ -37,6 +38,8 @@
 #include "extmod/vfs_fat_file.h"
 #include "extmod/fsusermount.h"
 
+extern const mp_obj_type_t mp_sdcard_type;
+
 /// \module os - basic "operating system" services
 ///
 /// The `os` module contains functions for filesystem access and `urandom`.
@@ -87,6 +90,10 @@ STATIC mp_obj_t os_chdir(mp_obj_t path_in) {
         res = f_chdir(path);
     }
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    fat_vfs_import_cache_clear();
+    #endif
+
     if (res != FR_OK) {
         // TODO should be mp_type_FileNotFoundError
         nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_OSError, "No such file or directory: '%s'", path));
@@ -140,6 +147,41 @@ STATIC mp_obj_t os_listdir(mp_uint_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_listdir_obj, 0, 1, os_listdir);
 
+/// \function ilistdir([dir])
+/// Like listdir, but return an iterator of (name, type, size) tuples.
+STATIC mp_obj_t os_ilistdir(mp_uint_t n_args, const mp_obj_t *args) {
+    bool is_str_type = true;
+    const char *path;
+    if (n_args == 1) {
+        if (mp_obj_get_type(args[0]) == &mp_type_bytes) {
+            is_str_type = false;
+        }
+        path = mp_obj_str_get_str(args[0]);
+    } else {
+        path = "";
+    }
+
+    // "hack" to list root directory
+    if (path[0] == '/' && path[1] == '\0') {
+        mp_obj_t dir_list = mp_obj_new_list(0, NULL);
+        for (size_t i = 0; i < MP_ARRAY_SIZE(MP_STATE_PORT(fs_user_mount)); ++i) {
+            fs_user_mount_t *vfs = MP_STATE_PORT(fs_user_mount)[i];
+            if (vfs != NULL) {
+                mp_obj_t entry[3] = {
+                    mp_obj_new_str(vfs->str + 1, vfs->len - 1, false),
+                    MP_OBJ_NEW_SMALL_INT(0x4000), // stat.S_IFDIR
+                    MP_OBJ_NEW_SMALL_INT(0),
+                };
+                mp_obj_list_append(dir_list, mp_obj_new_tuple(3, entry));
+            }
+        }
+        return mp_getiter(dir_list);
+    }
+
+    return fat_vfs_ilistdir(path, is_str_type);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_ilistdir_obj, 0, 1, os_ilistdir);
+
 /// \function mkdir(path)
 /// Create a new directory.
 STATIC mp_obj_t os_mkdir(mp_obj_t path_o) {
@@ -320,11 +362,15 @@ error:
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(os_statvfs_obj, os_statvfs);
 
 /// \function sync()
-/// Sync all filesystems.
+/// Sync all filesystems. Unlike closing or flushing a file, this waits until
+/// everything written is really on the flash.
 STATIC mp_obj_t os_sync(void) {
     disk_ioctl(0, CTRL_SYNC, NULL);
     disk_ioctl(1, CTRL_SYNC, NULL);
     disk_ioctl(2, CTRL_SYNC, NULL);
+    #ifdef SPI_FLASH_SERCOM
+        spi_flash_flush();
+    #endif
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_0(mod_os_sync_obj, os_sync);
@@ -337,6 +383,7 @@ STATIC const mp_map_elem_t os_module_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_chdir), (mp_obj_t)&os_chdir_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_getcwd), (mp_obj_t)&os_getcwd_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_listdir), (mp_obj_t)&os_listdir_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_ilistdir), (mp_obj_t)&os_ilistdir_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_mkdir), (mp_obj_t)&os_mkdir_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_remove), (mp_obj_t)&os_remove_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_rename),(mp_obj_t)&os_rename_obj},
@@ -354,6 +401,9 @@ STATIC const mp_map_elem_t os_module_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_mount), (mp_obj_t)&fsuser_mount_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_umount), (mp_obj_t)&fsuser_umount_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_mkfs), (mp_obj_t)&fsuser_mkfs_obj },
+    #if MICROPY_VFS_SDCARD
+    { MP_OBJ_NEW_QSTR(MP_QSTR_SDCard), (mp_obj_t)&mp_sdcard_type },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(os_module_globals, os_module_globals_table);
@@ -20,10 +20,27 @@
 #define MICROPY_COMP_CONST          (1)
 #define MICROPY_COMP_DOUBLE_TUPLE_ASSIGN (1)
 #define MICROPY_COMP_TRIPLE_TUPLE_ASSIGN (1)
+#define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (128)
+#define MICROPY_OPT_MAP_COMPACT (1)
+#define MICROPY_OPT_INSTANCE_SHARED_KEYS (1)
+#define MICROPY_OPT_SUPERINSTRUCTIONS (1)
+#define MICROPY_OPT_QUICKENING (1)
+#define MICROPY_OPT_STR_INDEX_CACHE (1)
+#define MICROPY_OPT_STR_SEARCH_HORSPOOL (1)
+#define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE (128)
 #define MICROPY_MEM_STATS           (0)
 #define MICROPY_DEBUG_PRINTERS      (0)
 #define MICROPY_ENABLE_GC           (1)
 #define MICROPY_GC_ALLOC_THRESHOLD  (0)
+#define MICROPY_GC_FREE_INDEX_CLASSES (8)
+#define MICROPY_GC_INCREMENTAL_SWEEP (1)
+#define MICROPY_GC_COMPACT          (1)
+#define MICROPY_GC_LONG_LIVED       (1)
+#define MICROPY_GC_STATS            (1)
+// uheap, which reads the allocation profiler, is only in debug builds
+#ifdef DEBUG
+#define MICROPY_GC_ALLOC_PROFILE    (1)
+#endif
 #define MICROPY_REPL_EVENT_DRIVEN   (0)
 #define MICROPY_HELPER_REPL         (1)
 #define MICROPY_HELPER_LEXER_UNIX   (0)
@@ -50,16 +67,25 @@
 #define MICROPY_PY_COLLECTIONS      (1)
 #define MICROPY_PY_DESCRIPTORS      (1)
 #define MICROPY_PY_FRAMEBUF         (1)
+// bitbangio.SPI runs as fast as the port registers go when asked for more
+// than 250kHz, ie a half period of 1us or less.
+#define MICROPY_PY_MACHINE_SPI_MIN_DELAY (1)
 #define MICROPY_PY_MATH             (1)
 #define MICROPY_PY_CMATH            (1)
 #define MICROPY_PY_IO               (0)
 #define MICROPY_PY_URANDOM          (1)
 #define MICROPY_PY_URANDOM_EXTRA_FUNCS (1)
+#define MICROPY_PY_URANDOM_XOSHIRO128 (1)
+#define MICROPY_PY_URANDOM_SEED_INIT_FUNC (samd21_random_seed())
+#define MICROPY_MODULE_BUILTIN_INIT (1)
 #define MICROPY_PY_STRUCT           (1)
 #define MICROPY_PY_SYS              (1)
 #define MICROPY_CPYTHON_COMPAT      (0)
 #define MICROPY_LONGINT_IMPL        (MICROPY_LONGINT_IMPL_NONE)
 #define MICROPY_FLOAT_IMPL          (MICROPY_FLOAT_IMPL_FLOAT)
+// floats are stored in the object word with 30 bits of precision, so
+// float arithmetic doesn't allocate on the heap
+#define MICROPY_OBJ_REPR            (MICROPY_OBJ_REPR_C)
 
 // fatfs configuration used in ffconf.h
 #define MICROPY_FATFS_ENABLE_LFN       (1)
@@ -76,6 +102,9 @@
 #define FLASH_BLOCK_SIZE            (512)
 
 #define MICROPY_VFS_FAT             (1)
+#define MICROPY_VFS_SDCARD          (1)
+#define MICROPY_VFS_SDCARD_NATIVEIO (1)
+#define MICROPY_VFS_FAT_IMPORT_CACHE (1)
 #define MICROPY_PY_MACHINE          (1)
 #define MICROPY_MODULE_WEAK_LINKS   (1)
 #define MICROPY_REPL_AUTO_INDENT    (1)
@@ -86,7 +115,15 @@
 #define MICROPY_PY_IO_FILEIO        (1)
 #define MICROPY_PY_MICROPYTHON_MEM_INFO (1)
 #define MICROPY_PERSISTENT_CODE_LOAD (1)
+#define MICROPY_PERSISTENT_CODE_SAVE (1)
+#define MICROPY_PERSISTENT_CODE_CACHE (1)
+#define MICROPY_COMP_INCREMENTAL (1)
+#define MICROPY_EMIT_BC_ONE_PASS (1)
 #define MICROPY_PY_BUILTINS_STR_UNICODE (1)
+#define MICROPY_ENABLE_SCHEDULER    (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE (1)
+#define MICROPY_PY_MICROPYTHON_TRACE (1)
+#define MICROPY_PY_MICROPYTHON_CYCLES (1)
 
 // type definitions for the specific machine
 
@@ -103,6 +140,12 @@
 typedef int mp_int_t; // must be pointer size
 typedef unsigned mp_uint_t; // must be pointer size
 
+// Interrupts are disabled in atomic sections, see mphalport.c
+mp_uint_t mp_hal_begin_atomic_section(void);
+void mp_hal_end_atomic_section(mp_uint_t state);
+#define MICROPY_BEGIN_ATOMIC_SECTION() mp_hal_begin_atomic_section()
+#define MICROPY_END_ATOMIC_SECTION(state) mp_hal_end_atomic_section(state)
+
 typedef long mp_off_t;
 
 #define MP_PLAT_PRINT_STRN(str, len) mp_hal_stdout_tx_strn_cooked(str, len)
@@ -114,6 +157,15 @@ typedef long mp_off_t;
 // board specific definitions
 #include "mpconfigboard.h"
 
+// Bytecode that is in the memory-mapped internal flash is run in place.
+#define MICROPY_PERSISTENT_CODE_LOAD_XIP (1)
+
+// Boards with an SPI flash have room at the top of the internal flash for a
+// bundle of frozen modules; see README.md.
+#ifdef SPI_FLASH_SERCOM
+#define MICROPY_MODULE_FROZEN_BUNDLE (1)
+#endif
+
 // extra built in modules to add to the list of known ones
 extern const struct _mp_obj_module_t microcontroller_module;
 extern const struct _mp_obj_module_t bitbangio_module;
@@ -165,10 +217,32 @@ extern const struct _mp_obj_module_t uheap_module;
     const char *readline_hist[8]; \
     vstr_t *repl_line; \
     mp_obj_t mp_kbd_exception; \
+    void *spi_dma_owner; \
+    void *adc_capture_owner; \
+    void *dac_playback_owner; \
+    mp_obj_t reload_import_stamps; \
+    mp_obj_t code_cache_in_place; \
+    void *neopixel_dma_buffers[2]; \
+    mp_obj_t nativeio_extint[16]; \
     FLASH_ROOT_POINTERS \
 
 bool udi_msc_process_trans(void);
-#define MICROPY_VM_HOOK_LOOP udi_msc_process_trans();
-#define MICROPY_VM_HOOK_RETURN udi_msc_process_trans();
+uint32_t samd21_random_seed(void);
+#ifdef LAZY_BOOT
+// see lazy_boot.h
+extern volatile bool lazy_boot_usb_wanted;
+void lazy_boot_start_usb(void);
+#define USB_BACKGROUND() { if (lazy_boot_usb_wanted) { lazy_boot_start_usb(); } udi_msc_process_trans(); }
+#else
+#define USB_BACKGROUND() udi_msc_process_trans()
+#endif
+#ifdef SPI_FLASH_SERCOM
+void spi_flash_background(void);
+#define MICROPY_VM_HOOK_LOOP { USB_BACKGROUND(); spi_flash_background(); }
+#define MICROPY_VM_HOOK_RETURN { USB_BACKGROUND(); spi_flash_background(); }
+#else
+#define MICROPY_VM_HOOK_LOOP USB_BACKGROUND();
+#define MICROPY_VM_HOOK_RETURN USB_BACKGROUND();
+#endif
 
 #endif  // __INCLUDED_MPCONFIGPORT_H
@@ -10,11 +10,16 @@
 #include "lib/mp-readline/readline.h"
 #include "py/mphal.h"
 #include "py/mpstate.h"
+#include "py/runtime.h"
 #include "py/smallint.h"
 #include "shared-bindings/time/__init__.h"
 
 #include "mpconfigboard.h"
 #include "mphalport.h"
+#include "tick.h"
+#ifdef SPI_FLASH_SERCOM
+#include "spi_flash.h"
+#endif
 
 // Store received characters on our own so that we can filter control characters
 // and act immediately on CTRL-C for example.
@@ -153,6 +158,10 @@ int receive_usb(void) {
 }
 
 int mp_hal_stdin_rx_chr(void) {
+    #ifdef LAZY_BOOT
+    // reading the REPL is a sign that a host is wanted
+    lazy_boot_start_usb();
+    #endif
     for (;;) {
         #ifdef MICROPY_VM_HOOK_LOOP
             MICROPY_VM_HOOK_LOOP
@@ -228,24 +237,31 @@ void mp_hal_set_interrupt_char(int c) {
 }
 
 void mp_hal_delay_ms(mp_uint_t delay) {
-    // If mass storage is enabled measure the time ourselves and run any mass
-    // storage transactions in the meantime.
-    // TODO(tannewt): Break out of this delay on KeyboardInterrupt too.
-    if (mp_msc_enabled) {
-        uint64_t start_tick = common_hal_time_monotonic();
-        uint64_t duration = 0;
-        while (duration < delay) {
+    // Sleep between interrupts rather than spinning. If mass storage is
+    // enabled run any mass storage transactions each time we wake.
+    uint64_t start_tick = common_hal_time_monotonic();
+    uint64_t duration = 0;
+    while (duration < delay) {
+        uint32_t max_sleep = delay - duration;
+        if (mp_msc_enabled) {
             #ifdef MICROPY_VM_HOOK_LOOP
                 MICROPY_VM_HOOK_LOOP
             #endif
-            // Check to see if we've been CTRL-Ced by autoreset or the user.
-            if(MP_STATE_VM(mp_pending_exception) == MP_STATE_PORT(mp_kbd_exception)) {
-                break;
+            #ifdef SPI_FLASH_SERCOM
+            // The background flush is moved along once per tick.
+            if (spi_flash_background_pending()) {
+                max_sleep = 1;
             }
-            duration = (common_hal_time_monotonic() - start_tick);
+            #endif
         }
-    } else {
-        delay_ms(delay);
+        // Check to see if we've been CTRL-Ced by autoreset or the user.
+        if(MP_STATE_VM(mp_pending_exception) == MP_STATE_PORT(mp_kbd_exception)) {
+            break;
+        }
+        // Run any callbacks queued by interrupts while sleeping.
+        mp_sched_run_pending();
+        tick_sleep(max_sleep);
+        duration = (common_hal_time_monotonic() - start_tick);
     }
 }
 
@@ -257,6 +273,14 @@ void mp_hal_delay_us(mp_uint_t delay) {
 // interrupt functions below.
 static irqflags_t irq_flags;
 
+mp_uint_t mp_hal_begin_atomic_section(void) {
+    return cpu_irq_save();
+}
+
+void mp_hal_end_atomic_section(mp_uint_t state) {
+    cpu_irq_restore(state);
+}
+
 void mp_hal_disable_all_interrupts(void) {
   // Disable all interrupt sources for timing critical sections.
   // Disable ASF-based interrupts.
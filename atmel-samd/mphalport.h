@@ -29,6 +29,8 @@
 
 #include "py/obj.h"
 
+#include "tick.h"
+
 #define USB_RX_BUF_SIZE 128
 
 // Global millisecond tick count (driven by SysTick interrupt).
@@ -38,8 +40,19 @@ static inline mp_uint_t mp_hal_ticks_ms(void) {
   return ticks_ms;
 }
 
+static inline mp_uint_t mp_hal_ticks_us(void) {
+  return tick_get_us();
+}
+
+static inline mp_uint_t mp_hal_ticks_cpu(void) {
+  return tick_get_cycles();
+}
+
 void mp_hal_set_interrupt_char(int c);
 
+// micropython.profile() is sampled from the millisecond tick
+#define mp_hal_profile_timer(enable) (void)(enable)
+
 void mp_hal_disable_all_interrupts(void);
 
 void mp_hal_enable_all_interrupts(void);
@@ -0,0 +1,186 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "reload.h"
+
+#include "code_cache.h"
+#include "extmod/fsusermount.h"
+#include "lib/fatfs/ff.h"
+#include "py/gc.h"
+#include "py/mpstate.h"
+#include "py/objlist.h"
+#include "py/runtime.h"
+
+// Maps the path of each file imported to its stamp from file_stamp. Kept in
+// MP_STATE_PORT so it survives the GC. MP_OBJ_NULL before reload_init.
+#define import_stamps MP_STATE_PORT(reload_import_stamps)
+
+// A reload is only worth it when at least this fraction of the heap is free
+// after collecting. Otherwise fragmentation would leave the script short.
+#define RELOAD_MIN_FREE_FRACTION 4
+
+void reload_init(void) {
+    import_stamps = mp_obj_new_dict(0);
+}
+
+static mp_obj_t file_stamp(const FILINFO *fno) {
+    mp_obj_t items[3] = {
+        MP_OBJ_NEW_SMALL_INT(fno->fdate),
+        MP_OBJ_NEW_SMALL_INT(fno->ftime),
+        MP_OBJ_NEW_SMALL_INT(fno->fsize)
+    };
+    return mp_obj_new_tuple(3, items);
+}
+
+static bool stat_file(const char *path, FILINFO *fno) {
+    #if _USE_LFN
+    fno->lfname = NULL;
+    fno->lfsize = 0;
+    #endif
+    return f_stat(path, fno) == FR_OK;
+}
+
+mp_import_stat_t reload_import_stat(const char *path) {
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    // Most probes are for names that aren't there, so rule those out from the
+    // cached listing and only go to the file for the stamp of one that is.
+    mp_import_stat_t stat = fat_vfs_import_stat(path);
+    if (stat != MP_IMPORT_STAT_FILE) {
+        return stat;
+    }
+    #endif
+    FILINFO fno;
+    if (!stat_file(path, &fno)) {
+        return MP_IMPORT_STAT_NO_EXIST;
+    }
+    if ((fno.fattrib & AM_DIR) != 0) {
+        return MP_IMPORT_STAT_DIR;
+    }
+    // The importer names the module's __file__ after the same path.
+    if (import_stamps != MP_OBJ_NULL) {
+        mp_obj_dict_store(import_stamps, MP_OBJ_NEW_QSTR(qstr_from_str(path)), file_stamp(&fno));
+    }
+    return MP_IMPORT_STAT_FILE;
+}
+
+// The globals of a module imported from a file, or NULL for frozen and built
+// in modules, which have no __file__.
+static mp_map_t *file_module_globals(mp_obj_t module, mp_obj_t *file) {
+    if (!MP_OBJ_IS_TYPE(module, &mp_type_module)) {
+        return NULL;
+    }
+    mp_map_t *globals = &mp_obj_module_get_globals(module)->map;
+    mp_map_elem_t *elem = mp_map_lookup(globals, MP_OBJ_NEW_QSTR(MP_QSTR___file__), MP_MAP_LOOKUP);
+    if (elem == NULL) {
+        return NULL;
+    }
+    *file = elem->value;
+    return globals;
+}
+
+static bool file_changed(mp_obj_t file) {
+    mp_map_elem_t *stamp = mp_map_lookup(&((mp_obj_dict_t *) MP_OBJ_TO_PTR(import_stamps))->map,
+        file, MP_MAP_LOOKUP);
+    FILINFO fno;
+    if (stamp == NULL || !stat_file(mp_obj_str_get_str(file), &fno)) {
+        return true;
+    }
+    return !mp_obj_equal(stamp->value, file_stamp(&fno));
+}
+
+static bool refers_to_any(mp_map_t *globals, mp_obj_list_t *modules) {
+    for (mp_uint_t i = 0; i < globals->alloc; i++) {
+        if (!MP_MAP_SLOT_IS_FILLED(globals, i)) {
+            continue;
+        }
+        for (mp_uint_t j = 0; j < modules->len; j++) {
+            if (globals->table[i].value == modules->items[j]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool reload_prepare(void) {
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    // Files may have changed under the listings kept for imports.
+    fat_vfs_import_cache_clear();
+    #endif
+
+    // Code run from the flash could be left pointing at blocks the host has
+    // since rewritten, so only a full reset is safe.
+    if (import_stamps == MP_OBJ_NULL || code_cache_runs_in_place()) {
+        return false;
+    }
+
+    // Unload modules whose files changed. Then keep unloading any that hold a
+    // reference to an unloaded one until there are no more, so no module is
+    // left using stale code. Names imported with "from x import y" aren't
+    // tracked.
+    mp_map_t *modules = &MP_STATE_VM(mp_loaded_modules_dict).map;
+    mp_obj_list_t *unloaded = MP_OBJ_TO_PTR(mp_obj_new_list(0, NULL));
+    bool check_references = false;
+    bool more = true;
+    while (more) {
+        more = false;
+        for (mp_uint_t i = 0; i < modules->alloc; i++) {
+            if (!MP_MAP_SLOT_IS_FILLED(modules, i)) {
+                continue;
+            }
+            mp_obj_t module = modules->table[i].value;
+            mp_obj_t file;
+            mp_map_t *globals = file_module_globals(module, &file);
+            if (globals == NULL) {
+                continue;
+            }
+            bool unload = check_references ? refers_to_any(globals, unloaded) : file_changed(file);
+            if (unload) {
+                mp_obj_list_append(MP_OBJ_FROM_PTR(unloaded), module);
+                mp_map_lookup(modules, modules->table[i].key, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+                more = true;
+            }
+        }
+        if (!check_references) {
+            check_references = true;
+            more = unloaded->len > 0;
+        }
+    }
+
+    // Start __main__ afresh like mp_init does.
+    mp_obj_dict_init(&MP_STATE_VM(dict_main), 1);
+    mp_obj_dict_store(MP_OBJ_FROM_PTR(&MP_STATE_VM(dict_main)), MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR___main__));
+    MP_STATE_CTX(dict_locals) = MP_STATE_CTX(dict_globals) = &MP_STATE_VM(dict_main);
+    MP_STATE_VM(mp_pending_exception) = MP_OBJ_NULL;
+    mp_obj_exception_clear_traceback(MP_STATE_PORT(mp_kbd_exception));
+
+    gc_collect();
+    gc_info_t info;
+    gc_info(&info);
+    return info.free >= info.total / RELOAD_MIN_FREE_FRACTION;
+}
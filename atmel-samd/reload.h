@@ -0,0 +1,47 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_ATMEL_SAMD_RELOAD_H__
+#define __MICROPY_INCLUDED_ATMEL_SAMD_RELOAD_H__
+
+#include <stdbool.h>
+
+#include "py/lexer.h"
+
+// Starts tracking the files that get imported. Called after mp_init.
+void reload_init(void);
+
+// mp_import_stat for the FAT file systems that also notes the timestamp and
+// size of each file found so a reload can tell if it has changed.
+mp_import_stat_t reload_import_stat(const char *path);
+
+// Readies the VM to run boot and main again without starting from scratch.
+// Modules imported from files that have changed, and those referring to them,
+// are unloaded. Frozen and built in modules and everything else that's
+// unchanged stay imported. Returns false if a full reset is needed instead.
+bool reload_prepare(void);
+
+#endif  // __MICROPY_INCLUDED_ATMEL_SAMD_RELOAD_H__
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shared_dma.h"
+
+#include "asf/sam0/utils/compiler.h"
+
+// We use ENABLE registers below we don't want to treat as a macro.
+#undef ENABLE
+
+// The DMAC reads the first descriptor of channel n from BASEADDR[n] and
+// writes its progress to WRBADDR[n]. Both have to be in SRAM.
+COMPILER_ALIGNED(16) static DmacDescriptor dma_descriptors[SHARED_DMA_NUM_CHANNELS];
+COMPILER_ALIGNED(16) static DmacDescriptor dma_write_back[SHARED_DMA_NUM_CHANNELS];
+
+void shared_dma_init(void) {
+    // shared_dma_reset disables the DMAC so check the hardware rather than
+    // caching whether we've set it up.
+    if ((DMAC->CTRL.reg & DMAC_CTRL_DMAENABLE) != 0 &&
+        DMAC->BASEADDR.reg == (uint32_t) dma_descriptors) {
+        return;
+    }
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+    DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+    while ((DMAC->CTRL.reg & DMAC_CTRL_SWRST) != 0) {}
+    DMAC->BASEADDR.reg = (uint32_t) dma_descriptors;
+    DMAC->WRBADDR.reg = (uint32_t) dma_write_back;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+}
+
+void shared_dma_reset(void) {
+    DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+}
+
+void shared_dma_configure(uint8_t channel, uint8_t trigsrc) {
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while ((DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST) != 0) {}
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) |
+        DMAC_CHCTRLB_TRIGSRC(trigsrc) |
+        DMAC_CHCTRLB_TRIGACT_BEAT;
+}
+
+DmacDescriptor *shared_dma_descriptor(uint8_t channel) {
+    return &dma_descriptors[channel];
+}
+
+DmacDescriptor *shared_dma_write_back(uint8_t channel) {
+    return &dma_write_back[channel];
+}
+
+void shared_dma_enable(uint8_t channel) {
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+}
+
+void shared_dma_abort(uint8_t channel) {
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    while ((DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE) != 0) {}
+}
+
+bool shared_dma_busy(uint8_t channel) {
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    return (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE) != 0;
+}
+
+bool shared_dma_block_done(uint8_t channel) {
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) == 0) {
+        return false;
+    }
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_ATMEL_SAMD_SHARED_DMA_H__
+#define __MICROPY_INCLUDED_ATMEL_SAMD_SHARED_DMA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "asf/sam0/drivers/system/system.h"
+
+// DMAC channels are handed out statically, one per user.
+#define SHARED_DMA_SPI_CHANNEL 0
+#define SHARED_DMA_ADC_CHANNEL 1
+#define SHARED_DMA_NEOPIXEL_CHANNEL 2
+#define SHARED_DMA_DAC_CHANNEL 3
+#define SHARED_DMA_NUM_CHANNELS 4
+
+// Turns on the DMAC and points it at our descriptors if it isn't already.
+void shared_dma_init(void);
+
+// Stops all channels. Called on soft reset because transfers may target the
+// heap.
+void shared_dma_reset(void);
+
+// Resets the channel and sets it to move one beat per trigger from the given
+// peripheral trigger source. The transfer itself is described by the
+// channel's first descriptor.
+void shared_dma_configure(uint8_t channel, uint8_t trigsrc);
+
+// The first descriptor of the channel, read by the DMAC when enabled.
+DmacDescriptor *shared_dma_descriptor(uint8_t channel);
+
+// The descriptor the DMAC writes back the channel's progress to.
+DmacDescriptor *shared_dma_write_back(uint8_t channel);
+
+void shared_dma_enable(uint8_t channel);
+void shared_dma_abort(uint8_t channel);
+bool shared_dma_busy(uint8_t channel);
+
+// Returns and clears whether a block with BLOCKACT_INT has completed.
+bool shared_dma_block_done(uint8_t channel);
+
+#endif  // __MICROPY_INCLUDED_ATMEL_SAMD_SHARED_DMA_H__
@@ -37,6 +37,7 @@
 #include "extmod/fsusermount.h"
 
 #include "neopixel_status.h"
+#include "tick.h"
 
 #define SPI_FLASH_PART1_START_BLOCK (0x1)
 
@@ -44,6 +45,7 @@
 
 #define CMD_READ_JEDEC_ID 0x9f
 #define CMD_READ_DATA 0x03
+#define CMD_FAST_READ_DATA 0x0b
 #define CMD_SECTOR_ERASE 0x20
 // #define CMD_SECTOR_ERASE CMD_READ_JEDEC_ID
 #define CMD_ENABLE_WRITE 0x06
@@ -64,12 +66,49 @@ static uint32_t sector_size;
 // The page size. Its the maximum number of bytes that can be written at once.
 static uint32_t page_size;
 
-// The currently cached sector in the cache, ram or flash based.
-static uint32_t current_sector;
-
-// Track which blocks (up to 32) in the current sector currently live in the
-// cache.
-static uint32_t dirty_mask;
+// The number of sectors we'll try to cache in ram at once. FAT workloads
+// bounce between the FAT, the directory and the file data so caching only one
+// sector means an erase and rewrite every time they take turns.
+#define CACHE_SLOTS (4)
+
+// Only cache more than one sector while this much heap would be left free
+// afterwards.
+#define CACHE_SLOT_HEAP_MARGIN (2 * sector_size)
+
+typedef struct {
+    // The sector cached in this slot or NO_SECTOR_LOADED.
+    uint32_t sector;
+    // Track which blocks (up to 32) in the sector currently live in the cache.
+    uint32_t dirty_mask;
+    // When the slot was last written to, for least recently used eviction.
+    uint32_t last_use;
+} cache_slot_t;
+
+// The cached sectors. The ram for slot i is in flash_ram_cache starting at
+// page i * pages_per_sector. When ram is tight there is no flash_ram_cache and
+// only slot 0 is used, cached in the scratch sector of the flash itself.
+static cache_slot_t cache_slots[CACHE_SLOTS];
+
+// Bumped on every write to order the slots by use.
+static uint32_t cache_use_count;
+
+// A flush started by a filesystem sync runs in the background, a step per
+// millisecond tick, so that Python isn't blocked for a whole sector erase. One
+// slot is flushed at a time.
+typedef enum {
+    FLUSH_IDLE,
+    // The slot is fully loaded into ram but the sector isn't erased yet.
+    FLUSH_ERASE,
+    // The sector erase was issued and the pages are being programmed.
+    FLUSH_PROGRAM,
+} flush_state_t;
+
+static flush_state_t flush_state = FLUSH_IDLE;
+static uint8_t flush_slot_index;
+static uint16_t flush_next_page;
+static uint32_t flush_last_tick;
+// Give back the ram cache once the background flush is done.
+static bool flush_free_cache;
 
 // Address of the scratch flash sector.
 #define SCRATCH_SECTOR (flash_size - sector_size)
@@ -98,6 +137,17 @@ static bool wait_for_flash_ready(void) {
     return status == STATUS_OK;
 }
 
+// Whether the flash is still busy with an erase or program. Unlike
+// wait_for_flash_ready this only checks once.
+static bool flash_is_busy(void) {
+    uint8_t status_request[2] = {CMD_READ_STATUS, 0x00};
+    uint8_t response[2] = {0x00, 0x00};
+    flash_enable();
+    enum status_code status = spi_transceive_buffer_wait(&spi_flash_instance, status_request, response, 2);
+    flash_disable();
+    return status != STATUS_OK || (response[1] & 0x3) != 0;
+}
+
 // Turn on the write enable bit so we can program and erase the flash.
 static bool write_enable(void) {
     flash_enable();
@@ -114,22 +164,48 @@ static void address_to_bytes(uint32_t address, uint8_t* bytes) {
     bytes[2] = address & 0xff;
 }
 
-// Read data_length's worth of bytes starting at address into data.
-static bool read_flash(uint32_t address, uint8_t* data, uint32_t data_length) {
+// Start a read at address. Data can then be clocked out with
+// spi_read_buffer_wait for as long as we like, following on from one call to
+// the next, until flash_disable ends it.
+static bool start_read(uint32_t address) {
     wait_for_flash_ready();
-    enum status_code status;
-    // We can read as much as we want sequentially.
-    uint8_t read_request[4] = {CMD_READ_DATA, 0x00, 0x00, 0x00};
+    // Fast read takes a dummy byte after the address but is good for the
+    // chip's full clock rate.
+    uint8_t read_request[5] = {CMD_FAST_READ_DATA, 0x00, 0x00, 0x00, 0x00};
     address_to_bytes(address, read_request + 1);
     flash_enable();
-    status = spi_write_buffer_wait(&spi_flash_instance, read_request, 4);
-    if (status == STATUS_OK) {
-        status = spi_read_buffer_wait(&spi_flash_instance, data, data_length, 0x00);
+    enum status_code status = spi_write_buffer_wait(&spi_flash_instance, read_request, 5);
+    if (status != STATUS_OK) {
+        flash_disable();
     }
-    flash_disable();
     return status == STATUS_OK;
 }
 
+// Continue a read started with start_read. The ASF driver counts in 16 bits
+// so long reads are split.
+static bool continue_read(uint8_t* data, uint32_t data_length) {
+    while (data_length > 0) {
+        uint16_t chunk = data_length > 0x8000 ? 0x8000 : data_length;
+        if (spi_read_buffer_wait(&spi_flash_instance, data, chunk, 0x00) != STATUS_OK) {
+            return false;
+        }
+        data += chunk;
+        data_length -= chunk;
+    }
+    return true;
+}
+
+// Read data_length's worth of bytes starting at address into data.
+static bool read_flash(uint32_t address, uint8_t* data, uint32_t data_length) {
+    // We can read as much as we want sequentially.
+    if (!start_read(address)) {
+        return false;
+    }
+    bool ok = continue_read(data, data_length);
+    flash_disable();
+    return ok;
+}
+
 // Writes data_length's worth of bytes starting at address from data. Assumes
 // that the sector that address resides in has already been erased. So make sure
 // to run erase_sector.
@@ -234,8 +310,10 @@ void spi_flash_init(void) {
             flash_size = 0;
         }
 
-        current_sector = NO_SECTOR_LOADED;
-        dirty_mask = 0;
+        for (uint8_t i = 0; i < CACHE_SLOTS; i++) {
+            cache_slots[i].sector = NO_SECTOR_LOADED;
+            cache_slots[i].dirty_mask = 0;
+        }
         MP_STATE_VM(flash_ram_cache) = NULL;
 
         spi_flash_is_initialised = true;
@@ -257,13 +335,14 @@ uint32_t spi_flash_get_block_count(void) {
 // Flush the cache that was written to the scratch portion of flash. Only used
 // when ram is tight.
 static bool flush_scratch_flash(void) {
+    cache_slot_t* slot = &cache_slots[0];
     // First, copy out any blocks that we haven't touched from the sector we've
     // cached.
     bool copy_to_scratch_ok = true;
     for (uint8_t i = 0; i < sector_size / FLASH_BLOCK_SIZE; i++) {
-        if ((dirty_mask & (1 << i)) == 0) {
+        if ((slot->dirty_mask & (1 << i)) == 0) {
             copy_to_scratch_ok = copy_to_scratch_ok &&
-                copy_block(current_sector + i * FLASH_BLOCK_SIZE,
+                copy_block(slot->sector + i * FLASH_BLOCK_SIZE,
                            SCRATCH_SECTOR + i * FLASH_BLOCK_SIZE);
         }
     }
@@ -273,112 +352,157 @@ static bool flush_scratch_flash(void) {
         return false;
     }
     // Second, erase the current sector.
-    erase_sector(current_sector);
+    erase_sector(slot->sector);
     // Finally, copy the new version into it.
     for (uint8_t i = 0; i < sector_size / FLASH_BLOCK_SIZE; i++) {
         copy_block(SCRATCH_SECTOR + i * FLASH_BLOCK_SIZE,
-                   current_sector + i * FLASH_BLOCK_SIZE);
+                   slot->sector + i * FLASH_BLOCK_SIZE);
     }
     return true;
 }
 
+// The page buffers for the given cache slot. Only valid while there is a ram
+// cache.
+static uint8_t** slot_pages(uint8_t slot) {
+    uint16_t pages_per_sector = sector_size / page_size;
+    return MP_STATE_VM(flash_ram_cache) + slot * pages_per_sector;
+}
+
+// Whether the given slot has its page buffers.
+static bool slot_has_ram(uint8_t slot) {
+    return MP_STATE_VM(flash_ram_cache) != NULL && slot_pages(slot)[0] != NULL;
+}
+
+// Gives back the page buffers of the given slot.
+static void free_slot_ram(uint8_t slot) {
+    uint16_t pages_per_sector = sector_size / page_size;
+    uint8_t** pages = slot_pages(slot);
+    for (uint16_t i = 0; i < pages_per_sector; i++) {
+        if (pages[i] != NULL) {
+            gc_free(pages[i]);
+            pages[i] = NULL;
+        }
+    }
+}
+
 // Attempts to allocate a new set of page buffers for caching a full sector in
-// ram. Each page is allocated separately so that the GC doesn't need to provide
-// one huge block. We can free it as we write if we want to also.
-static bool allocate_ram_cache(void) {
-    uint8_t blocks_per_sector = sector_size / FLASH_BLOCK_SIZE;
-    uint8_t pages_per_block = FLASH_BLOCK_SIZE / page_size;
-    MP_STATE_VM(flash_ram_cache) = gc_alloc(blocks_per_sector * pages_per_block * sizeof(uint32_t), false);
+// ram in the given slot. Each page is allocated separately so that the GC
+// doesn't need to provide one huge block. We can free it as we write if we want
+// to also.
+static bool allocate_slot_ram(uint8_t slot) {
+    uint16_t pages_per_sector = sector_size / page_size;
     if (MP_STATE_VM(flash_ram_cache) == NULL) {
-        return false;
-    }
-    // Declare i and j outside the loops in case we fail to allocate everything
-    // we need. In that case we'll give it back.
-    uint8_t i = 0;
-    uint8_t j = 0;
-    bool success = true;
-    for (i = 0; i < blocks_per_sector; i++) {
-        for (j = 0; j < pages_per_block; j++) {
-            uint8_t *page_cache = gc_alloc(page_size, false);
-            if (page_cache == NULL) {
-                success = false;
-                break;
-            }
-            MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j] = page_cache;
-        }
-        if (!success) {
-            break;
+        size_t table_size = CACHE_SLOTS * pages_per_sector * sizeof(uint8_t*);
+        MP_STATE_VM(flash_ram_cache) = gc_alloc(table_size, false);
+        if (MP_STATE_VM(flash_ram_cache) == NULL) {
+            return false;
         }
+        memset(MP_STATE_VM(flash_ram_cache), 0, table_size);
     }
-    // We couldn't allocate enough so give back what we got.
-    if (!success) {
-        // We add 1 so that we delete 0 when i is 1. Going to zero (i >= 0)
-        // would never stop because i is unsigned.
-        i++;
-        for (; i > 0; i--) {
-            for (; j > 0; j--) {
-                gc_free(MP_STATE_VM(flash_ram_cache)[(i - 1) * pages_per_block + (j - 1)]);
+    uint8_t** pages = slot_pages(slot);
+    for (uint16_t i = 0; i < pages_per_sector; i++) {
+        pages[i] = gc_alloc(page_size, false);
+        if (pages[i] == NULL) {
+            // We couldn't allocate enough so give back what we got. Slots are
+            // filled in order so without slot 0 there is no ram cache at all.
+            free_slot_ram(slot);
+            if (slot == 0) {
+                gc_free(MP_STATE_VM(flash_ram_cache));
+                MP_STATE_VM(flash_ram_cache) = NULL;
             }
-            j = pages_per_block;
+            return false;
         }
-        gc_free(MP_STATE_VM(flash_ram_cache));
-        MP_STATE_VM(flash_ram_cache) = NULL;
     }
-    return success;
+    return true;
 }
 
-// Flush the cached sector from ram onto the flash. We'll free the cache unless
-// keep_cache is true.
-static bool flush_ram_cache(bool keep_cache) {
-    // First, copy out any blocks that we haven't touched from the sector
-    // we've cached. If we don't do this we'll erase the data during the sector
-    // erase below.
+// Gives back the whole ram cache. All slots must have been flushed.
+static void free_ram_cache(void) {
+    if (MP_STATE_VM(flash_ram_cache) == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < CACHE_SLOTS; i++) {
+        free_slot_ram(i);
+    }
+    gc_free(MP_STATE_VM(flash_ram_cache));
+    MP_STATE_VM(flash_ram_cache) = NULL;
+}
+
+// Copy any blocks that we haven't touched from the sector cached in the given
+// slot into its ram. If we don't do this we'll erase the data during the sector
+// erase. Afterwards the whole sector lives in the cache.
+static bool fill_ram_cache(uint8_t slot_index) {
+    cache_slot_t* slot = &cache_slots[slot_index];
+    uint8_t** pages = slot_pages(slot_index);
+    // Runs of untouched blocks are read with one command, straight into each
+    // page buffer in turn.
     bool copy_to_ram_ok = true;
     uint8_t pages_per_block = FLASH_BLOCK_SIZE / page_size;
-    for (uint8_t i = 0; i < sector_size / FLASH_BLOCK_SIZE; i++) {
-        if ((dirty_mask & (1 << i)) == 0) {
-            for (uint8_t j = 0; j < pages_per_block; j++) {
-                copy_to_ram_ok = read_flash(
-                    current_sector + (i * pages_per_block + j) * page_size,
-                    MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j],
-                    page_size);
-                if (!copy_to_ram_ok) {
-                    break;
-                }
-            }
+    uint8_t blocks_per_sector = sector_size / FLASH_BLOCK_SIZE;
+    for (uint8_t i = 0; i < blocks_per_sector && copy_to_ram_ok; i++) {
+        if ((slot->dirty_mask & (1 << i)) != 0) {
+            continue;
         }
-        if (!copy_to_ram_ok) {
-            break;
+        copy_to_ram_ok = start_read(slot->sector + i * FLASH_BLOCK_SIZE);
+        for (; copy_to_ram_ok && i < blocks_per_sector && (slot->dirty_mask & (1 << i)) == 0; i++) {
+            for (uint8_t j = 0; j < pages_per_block && copy_to_ram_ok; j++) {
+                copy_to_ram_ok = continue_read(pages[i * pages_per_block + j],
+                                               page_size);
+            }
         }
+        flash_disable();
+    }
+    if (copy_to_ram_ok) {
+        slot->dirty_mask = (1 << blocks_per_sector) - 1;
     }
+    return copy_to_ram_ok;
+}
+
+// Write the pages of the given slot, starting at first_page, into its already
+// erased sector.
+static void program_ram_cache(uint8_t slot_index, uint16_t first_page) {
+    uint8_t** pages = slot_pages(slot_index);
+    uint16_t pages_per_sector = sector_size / page_size;
+    for (uint16_t i = first_page; i < pages_per_sector; i++) {
+        write_flash(cache_slots[slot_index].sector + i * page_size, pages[i], page_size);
+    }
+}
 
-    if (!copy_to_ram_ok) {
+// Flush the sector cached in the given slot from ram onto the flash.
+static bool flush_ram_cache(uint8_t slot_index) {
+    // First, make sure the whole sector is in ram.
+    if (!fill_ram_cache(slot_index)) {
         return false;
     }
     // Second, erase the current sector.
-    erase_sector(current_sector);
+    erase_sector(cache_slots[slot_index].sector);
     // Lastly, write all the data in ram that we've cached.
-    for (uint8_t i = 0; i < sector_size / FLASH_BLOCK_SIZE; i++) {
-        for (uint8_t j = 0; j < pages_per_block; j++) {
-            write_flash(current_sector + (i * pages_per_block + j) * page_size,
-                        MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j],
-                        page_size);
-            if (!keep_cache) {
-                gc_free(MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j]);
-            }
-        }
+    program_ram_cache(slot_index, 0);
+    return true;
+}
+
+// Finish the background flush, if there is one, right away.
+static void finish_background_flush(void) {
+    if (flush_state == FLUSH_IDLE) {
+        return;
     }
-    // We're done with the cache for now so give it back.
-    if (!keep_cache) {
-        gc_free(MP_STATE_VM(flash_ram_cache));
-        MP_STATE_VM(flash_ram_cache) = NULL;
+    if (flush_state == FLUSH_ERASE) {
+        erase_sector(cache_slots[flush_slot_index].sector);
+        flush_next_page = 0;
     }
-    return true;
+    program_ram_cache(flush_slot_index, flush_next_page);
+    cache_slots[flush_slot_index].sector = NO_SECTOR_LOADED;
+    cache_slots[flush_slot_index].dirty_mask = 0;
+    flush_state = FLUSH_IDLE;
 }
 
-// Delegates to the correct flash flush method depending on the existing cache.
-static void spi_flash_flush_keep_cache(bool keep_cache) {
-    if (current_sector == NO_SECTOR_LOADED) {
+// Flush the given slot using the correct method for where it is cached and
+// mark it empty.
+static void flush_slot(uint8_t slot) {
+    if (flush_state != FLUSH_IDLE && slot == flush_slot_index) {
+        finish_background_flush();
+    }
+    if (cache_slots[slot].sector == NO_SECTOR_LOADED) {
         return;
     }
     #ifdef MICROPY_HW_LED_MSC
@@ -391,9 +515,10 @@ static void spi_flash_flush_keep_cache(bool keep_cache) {
     if (MP_STATE_VM(flash_ram_cache) == NULL) {
         flush_scratch_flash();
     } else {
-        flush_ram_cache(keep_cache);
+        flush_ram_cache(slot);
     }
-    current_sector = NO_SECTOR_LOADED;
+    cache_slots[slot].sector = NO_SECTOR_LOADED;
+    cache_slots[slot].dirty_mask = 0;
     #ifdef MICROPY_HW_NEOPIXEL
         clear_temp_status();
     #endif
@@ -402,12 +527,164 @@ static void spi_flash_flush_keep_cache(bool keep_cache) {
     #endif
 }
 
+// Flush every cached sector. We'll free the cache unless keep_cache is true.
+static void spi_flash_flush_keep_cache(bool keep_cache) {
+    if (!spi_flash_is_initialised) {
+        return;
+    }
+    finish_background_flush();
+    for (uint8_t i = 0; i < CACHE_SLOTS; i++) {
+        flush_slot(i);
+    }
+    if (!keep_cache) {
+        free_ram_cache();
+    }
+}
+
 // External flash function used. If called externally we assume we won't need
-// the cache after.
+// the cache after. Everything written so far is on the flash once this returns
+// so it doubles as a write barrier.
 void spi_flash_flush(void) {
     spi_flash_flush_keep_cache(false);
 }
 
+// Load the next cached sector fully into ram and queue it up for the
+// background flush. Frees the cache when there is nothing left to flush and no
+// writes came in since the sync.
+static void start_next_background_flush(void) {
+    bool left_over = false;
+    for (uint8_t i = 0; i < CACHE_SLOTS; i++) {
+        if (cache_slots[i].sector == NO_SECTOR_LOADED) {
+            continue;
+        }
+        if (!fill_ram_cache(i)) {
+            // Leave it for a synchronous flush to deal with.
+            left_over = true;
+            continue;
+        }
+        flush_slot_index = i;
+        flush_state = FLUSH_ERASE;
+        return;
+    }
+    flush_state = FLUSH_IDLE;
+    if (flush_free_cache && !left_over) {
+        free_ram_cache();
+    }
+}
+
+// Start flushing the cache without waiting for it. Only the ram cache can be
+// flushed in the background. The scratch sector is flushed right away.
+void spi_flash_sync(void) {
+    if (!spi_flash_is_initialised) {
+        return;
+    }
+    if (MP_STATE_VM(flash_ram_cache) == NULL) {
+        spi_flash_flush();
+        return;
+    }
+    flush_free_cache = true;
+    if (flush_state == FLUSH_IDLE) {
+        start_next_background_flush();
+    }
+}
+
+bool spi_flash_background_pending(void) {
+    return flush_state != FLUSH_IDLE;
+}
+
+// Moves the background flush along by at most one erase or page program per
+// millisecond tick, and only once the flash has finished the previous one.
+void spi_flash_background(void) {
+    if (flush_state == FLUSH_IDLE) {
+        return;
+    }
+    uint32_t tick = ticks_ms;
+    if (tick == flush_last_tick) {
+        return;
+    }
+    flush_last_tick = tick;
+    if (flash_is_busy()) {
+        return;
+    }
+    if (flush_state == FLUSH_ERASE) {
+        erase_sector(cache_slots[flush_slot_index].sector);
+        flush_next_page = 0;
+        flush_state = FLUSH_PROGRAM;
+        return;
+    }
+    uint8_t** pages = slot_pages(flush_slot_index);
+    write_flash(cache_slots[flush_slot_index].sector + flush_next_page * page_size,
+                pages[flush_next_page], page_size);
+    flush_next_page++;
+    if (flush_next_page == sector_size / page_size) {
+        cache_slots[flush_slot_index].sector = NO_SECTOR_LOADED;
+        cache_slots[flush_slot_index].dirty_mask = 0;
+        start_next_background_flush();
+    }
+}
+
+// Returns the slot caching the given sector or -1 if it isn't cached.
+static int8_t find_slot(uint32_t sector) {
+    for (uint8_t i = 0; i < CACHE_SLOTS; i++) {
+        if (cache_slots[i].sector == sector) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Whether there is enough heap to spare for caching another sector.
+static bool heap_allows_another_slot(void) {
+    gc_info_t info;
+    gc_info(&info);
+    return info.free >= sector_size + CACHE_SLOT_HEAP_MARGIN;
+}
+
+// Picks a slot to cache the given sector in. Empty slots that already have ram
+// are used first, then new ones are allocated while the heap allows, and
+// otherwise the least recently used slot is flushed and reused. If there isn't
+// even ram for one slot we fall back to caching in the scratch sector.
+static uint8_t claim_slot(uint32_t sector) {
+    if (MP_STATE_VM(flash_ram_cache) == NULL) {
+        // Anything cached is in the scratch sector and must go back before we
+        // can start using ram.
+        flush_slot(0);
+    }
+    int8_t chosen = -1;
+    for (uint8_t i = 0; i < CACHE_SLOTS && chosen < 0; i++) {
+        if (slot_has_ram(i) && cache_slots[i].sector == NO_SECTOR_LOADED) {
+            chosen = i;
+        }
+    }
+    for (uint8_t i = 0; i < CACHE_SLOTS && chosen < 0; i++) {
+        if (slot_has_ram(i)) {
+            continue;
+        }
+        if ((i == 0 || heap_allows_another_slot()) && allocate_slot_ram(i)) {
+            chosen = i;
+        }
+        // Don't leave holes in the slots.
+        break;
+    }
+    if (chosen < 0 && MP_STATE_VM(flash_ram_cache) != NULL) {
+        chosen = 0;
+        for (uint8_t i = 1; i < CACHE_SLOTS && slot_has_ram(i); i++) {
+            if (cache_slots[i].last_use < cache_slots[chosen].last_use) {
+                chosen = i;
+            }
+        }
+        flush_slot(chosen);
+    }
+    if (chosen < 0) {
+        erase_sector(SCRATCH_SECTOR);
+        wait_for_flash_ready();
+        chosen = 0;
+    }
+    cache_slots[chosen].sector = sector;
+    cache_slots[chosen].dirty_mask = 0;
+    return chosen;
+}
+
 // Builds a partition entry for the MBR.
 static void build_partition(uint8_t *buf, int boot, int type,
                             uint32_t start_block, uint32_t num_blocks) {
@@ -489,13 +766,15 @@ bool spi_flash_read_block(uint8_t *dest, uint32_t block) {
         uint32_t this_sector = address & (~(sector_size - 1));
         uint8_t block_index = (address / FLASH_BLOCK_SIZE) % (sector_size / FLASH_BLOCK_SIZE);
         uint8_t mask = 1 << (block_index);
-        // We're reading from the currently cached sector.
-        if (current_sector == this_sector && (mask & dirty_mask) > 0) {
+        // We're reading from a cached sector.
+        int8_t slot = find_slot(this_sector);
+        if (slot >= 0 && (mask & cache_slots[slot].dirty_mask) > 0) {
             if (MP_STATE_VM(flash_ram_cache) != NULL) {
                 uint8_t pages_per_block = FLASH_BLOCK_SIZE / page_size;
+                uint8_t** pages = slot_pages(slot);
                 for (int i = 0; i < pages_per_block; i++) {
                     memcpy(dest + i * page_size,
-                           MP_STATE_VM(flash_ram_cache)[block_index * pages_per_block + i],
+                           pages[block_index * pages_per_block + i],
                            page_size);
                 }
                 return true;
@@ -525,25 +804,34 @@ bool spi_flash_write_block(const uint8_t *data, uint32_t block) {
         uint32_t this_sector = address & (~(sector_size - 1));
         uint8_t block_index = (address / FLASH_BLOCK_SIZE) % (sector_size / FLASH_BLOCK_SIZE);
         uint8_t mask = 1 << (block_index);
-        // Flush the cache if we're moving onto a sector our we're writing the
-        // same block again.
-        if (current_sector != this_sector || (mask & dirty_mask) > 0) {
-            if (current_sector != NO_SECTOR_LOADED) {
-                spi_flash_flush_keep_cache(true);
-            }
-            if (MP_STATE_VM(flash_ram_cache) == NULL && !allocate_ram_cache()) {
-                erase_sector(SCRATCH_SECTOR);
-                wait_for_flash_ready();
-            }
-            current_sector = this_sector;
-            dirty_mask = 0;
+        int8_t slot = find_slot(this_sector);
+        // Whoever is writing will sync again so keep the cache around.
+        flush_free_cache = false;
+        // The sector being flushed in the background is half erased so finish
+        // that before changing it.
+        if (slot >= 0 && flush_state != FLUSH_IDLE && slot == flush_slot_index) {
+            finish_background_flush();
+            slot = -1;
         }
-        dirty_mask |= mask;
+        // The scratch sector can't be rewritten without erasing it so writing
+        // the same block again means flushing first. Blocks in ram are simply
+        // overwritten.
+        if (slot >= 0 && MP_STATE_VM(flash_ram_cache) == NULL &&
+            (mask & cache_slots[slot].dirty_mask) > 0) {
+            flush_slot(slot);
+            slot = -1;
+        }
+        if (slot < 0) {
+            slot = claim_slot(this_sector);
+        }
+        cache_slots[slot].dirty_mask |= mask;
+        cache_slots[slot].last_use = ++cache_use_count;
         // Copy the block to the appropriate cache.
         if (MP_STATE_VM(flash_ram_cache) != NULL) {
             uint8_t pages_per_block = FLASH_BLOCK_SIZE / page_size;
+            uint8_t** pages = slot_pages(slot);
             for (int i = 0; i < pages_per_block; i++) {
-                memcpy(MP_STATE_VM(flash_ram_cache)[block_index * pages_per_block + i],
+                memcpy(pages[block_index * pages_per_block + i],
                        data + i * page_size,
                        page_size);
             }
@@ -555,11 +843,42 @@ bool spi_flash_write_block(const uint8_t *data, uint32_t block) {
     }
 }
 
+// Whether the block has to come from the write cache rather than its place in
+// flash.
+static bool block_is_cached(uint32_t block) {
+    uint32_t address = convert_block_to_flash_addr(block);
+    uint32_t this_sector = address & (~(sector_size - 1));
+    uint8_t block_index = (address / FLASH_BLOCK_SIZE) % (sector_size / FLASH_BLOCK_SIZE);
+    int8_t slot = find_slot(this_sector);
+    return slot >= 0 && (cache_slots[slot].dirty_mask & (1 << block_index)) != 0;
+}
+
 mp_uint_t spi_flash_read_blocks(uint8_t *dest, uint32_t block_num, uint32_t num_blocks) {
-    for (size_t i = 0; i < num_blocks; i++) {
-        if (!spi_flash_read_block(dest + i * FLASH_BLOCK_SIZE, block_num + i)) {
+    uint32_t block_count = spi_flash_get_block_count();
+    size_t i = 0;
+    while (i < num_blocks) {
+        uint32_t block = block_num + i;
+        // Blocks in the partition are consecutive in flash so a run of them
+        // that isn't in the write cache can be read with one command.
+        size_t run = 0;
+        while (i + run < num_blocks &&
+               block + run >= SPI_FLASH_PART1_START_BLOCK &&
+               block + run < block_count &&
+               !block_is_cached(block + run)) {
+            run++;
+        }
+        if (run > 1) {
+            if (!read_flash(convert_block_to_flash_addr(block),
+                            dest + i * FLASH_BLOCK_SIZE, run * FLASH_BLOCK_SIZE)) {
+                return 1; // error
+            }
+            i += run;
+            continue;
+        }
+        if (!spi_flash_read_block(dest + i * FLASH_BLOCK_SIZE, block)) {
             return 1; // error
         }
+        i++;
     }
     return 0; // success
 }
@@ -610,7 +929,7 @@ STATIC mp_obj_t spi_flash_obj_ioctl(mp_obj_t self, mp_obj_t cmd_in, mp_obj_t arg
     switch (cmd) {
         case BP_IOCTL_INIT: spi_flash_init(); return MP_OBJ_NEW_SMALL_INT(0);
         case BP_IOCTL_DEINIT: spi_flash_flush(); return MP_OBJ_NEW_SMALL_INT(0); // TODO properly
-        case BP_IOCTL_SYNC: spi_flash_flush(); return MP_OBJ_NEW_SMALL_INT(0);
+        case BP_IOCTL_SYNC: spi_flash_sync(); return MP_OBJ_NEW_SMALL_INT(0);
         case BP_IOCTL_SEC_COUNT: return MP_OBJ_NEW_SMALL_INT(spi_flash_get_block_count());
         case BP_IOCTL_SEC_SIZE: return MP_OBJ_NEW_SMALL_INT(spi_flash_get_block_size());
         default: return mp_const_none;
@@ -45,6 +45,10 @@ uint32_t spi_flash_get_block_size(void);
 uint32_t spi_flash_get_block_count(void);
 void spi_flash_irq_handler(void);
 void spi_flash_flush(void);
+void spi_flash_sync(void);
+void spi_flash_background(void);
+// Whether spi_flash_background still has work to do.
+bool spi_flash_background_pending(void);
 bool spi_flash_read_block(uint8_t *dest, uint32_t block);
 bool spi_flash_write_block(const uint8_t *src, uint32_t block);
 
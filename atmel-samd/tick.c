@@ -1,14 +1,27 @@
 #include "autoreset.h"
+#include "lazy_boot.h"
 
 #include "tick.h"
 
+#include "shared_dma.h"
+
+#include "py/runtime.h"
+
+#include "asf/common/services/sleepmgr/sleepmgr.h"
 #include "asf/sam0/drivers/tc/tc_interrupt.h"
 
+// While sleeping without ticks TC5 counts through this prescaler so that over
+// a second fits in its 16 bits.
+#define TICKLESS_PRESCALER 1024
+
 // Global millisecond tick count
 volatile uint64_t ticks_ms = 0;
 
 static struct tc_module ms_timer;
 
+// CPU clocks per millisecond, which TC5 counts up to before each tick.
+static uint32_t clocks_per_ms;
+
 static void ms_tick(struct tc_module *const module_inst) {
     // SysTick interrupt handler called when the SysTick timer reaches zero
     // (every millisecond).
@@ -17,17 +30,145 @@ static void ms_tick(struct tc_module *const module_inst) {
     #ifdef AUTORESET_DELAY_MS
         autoreset_tick();
     #endif
+
+    #ifdef LAZY_BOOT
+    lazy_boot_tick();
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    mp_profile_tick();
+    #endif
 }
 
 void tick_init() {
     struct tc_config config_tc;
     tc_get_config_defaults(&config_tc);
+    // Match frequency mode clears the counter on CC0 so there is exactly one
+    // overflow per millisecond and COUNT is the time since the last one.
+    clocks_per_ms = system_cpu_clock_get_hz() / 1000;
     config_tc.counter_size    = TC_COUNTER_SIZE_16BIT;
     config_tc.clock_prescaler = TC_CLOCK_PRESCALER_DIV1;
-    tc_set_top_value(&ms_timer, system_cpu_clock_get_hz() / 1000);
+    config_tc.wave_generation = TC_WAVE_GENERATION_MATCH_FREQ;
+    config_tc.counter_16_bit.compare_capture_channel[0] = clocks_per_ms - 1;
     tc_init(&ms_timer, TC5, &config_tc);
+    // Keep COUNT synchronized so it can be read without waiting.
+    TC5->COUNT16.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
     tc_enable(&ms_timer);
     tc_register_callback(&ms_timer, ms_tick, TC_CALLBACK_OVERFLOW);
     tc_enable_callback(&ms_timer, TC_CALLBACK_OVERFLOW);
     tc_start_counter(&ms_timer);
 }
+
+uint64_t tick_get_ms(void) {
+    // The M0 reads the 64 bit count in two halves so keep the tick out.
+    irqflags_t flags = cpu_irq_save();
+    uint64_t ms = ticks_ms;
+    cpu_irq_restore(flags);
+    return ms;
+}
+
+// Reads the milliseconds and the CPU clocks since the last one.
+static uint32_t tick_read(uint64_t *ms) {
+    irqflags_t flags = cpu_irq_save();
+    *ms = ticks_ms;
+    uint32_t count = TC5->COUNT16.COUNT.reg;
+    // The counter may have wrapped with the tick still waiting for
+    // interrupts to come back on.
+    if ((TC5->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) != 0) {
+        count = TC5->COUNT16.COUNT.reg;
+        *ms += 1;
+    }
+    cpu_irq_restore(flags);
+    return count;
+}
+
+uint64_t tick_get_us(void) {
+    uint64_t ms;
+    uint32_t count = tick_read(&ms);
+    return ms * 1000 + count * 1000 / clocks_per_ms;
+}
+
+uint32_t tick_get_cycles(void) {
+    // TC5 runs from the CPU clock, so together with the milliseconds it
+    // makes a cycle counter.  The M0+ has no DWT CYCCNT.
+    uint64_t ms;
+    uint32_t count = tick_read(&ms);
+    return (uint32_t)ms * clocks_per_ms + count;
+}
+
+static inline void tc5_sync(void) {
+    while ((TC5->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY) != 0) {}
+}
+
+// Restarts TC5 counting from count up to top through the given prescaler.
+static void tc5_set_period(uint32_t prescaler, uint16_t top, uint16_t count) {
+    TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    tc5_sync();
+    TC5->COUNT16.CTRLA.reg = (TC5->COUNT16.CTRLA.reg & ~TC_CTRLA_PRESCALER_Msk) | prescaler;
+    TC5->COUNT16.CC[0].reg = top;
+    tc5_sync();
+    TC5->COUNT16.COUNT.reg = count;
+    tc5_sync();
+    TC5->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+    TC5->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+    tc5_sync();
+}
+
+void tick_sleep(uint32_t max_ms) {
+    enum sleepmgr_mode mode = sleepmgr_get_sleep_mode();
+    if (mode == SLEEPMGR_ACTIVE) {
+        return;
+    }
+    // TC5 runs from GCLK0, which stops in standby.
+    if (mode > SLEEPMGR_IDLE_2) {
+        mode = SLEEPMGR_IDLE_2;
+    }
+    // Keep the bus clocks running for DMA in the background.
+    for (uint8_t i = 0; i < SHARED_DMA_NUM_CHANNELS; i++) {
+        if (shared_dma_busy(i)) {
+            mode = SLEEPMGR_IDLE_0;
+        }
+    }
+    #ifdef AUTORESET_DELAY_MS
+    // The autoreset countdown needs every tick.
+    if (autoreset_delay_ms != 0) {
+        max_ms = 1;
+    }
+    #endif
+    uint32_t max_span = 0xffff * TICKLESS_PRESCALER / clocks_per_ms;
+    if (max_ms > max_span) {
+        max_ms = max_span;
+    }
+
+    // Interrupts stay masked so nothing is missed while switching between
+    // ticking and tickless. A pending interrupt still ends the WFI and is
+    // handled once they are restored.
+    irqflags_t flags = cpu_irq_save();
+    system_set_sleepmode((enum system_sleepmode)(mode - 1));
+    if (max_ms <= 1 || (TC5->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) != 0) {
+        // The next tick wakes us.
+        system_sleep();
+        cpu_irq_restore(flags);
+        return;
+    }
+
+    uint32_t partial = TC5->COUNT16.COUNT.reg;
+    uint32_t top = (max_ms * clocks_per_ms - partial) / TICKLESS_PRESCALER - 1;
+    tc5_set_period(TC_CTRLA_PRESCALER_DIV1024, top, 0);
+
+    system_sleep();
+
+    uint32_t elapsed;
+    if ((TC5->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) != 0) {
+        elapsed = (top + 1) * TICKLESS_PRESCALER;
+    } else {
+        elapsed = TC5->COUNT16.COUNT.reg * TICKLESS_PRESCALER;
+    }
+    elapsed += partial;
+    uint32_t ms = elapsed / clocks_per_ms;
+    // Clearing the overflow in here means the tick handler won't count it
+    // again. The part of a millisecond left over carries into the next tick.
+    tc5_set_period(TC_CTRLA_PRESCALER_DIV1, clocks_per_ms - 1, elapsed - ms * clocks_per_ms);
+    ticks_ms += ms;
+    cpu_irq_restore(flags);
+}
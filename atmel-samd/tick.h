@@ -32,4 +32,16 @@ extern volatile uint64_t ticks_ms;
 
 void tick_init(void);
 
+// Read the time since tick_init. Unlike reading ticks_ms directly these are
+// safe from a tick landing halfway through the read.
+uint64_t tick_get_ms(void);
+uint64_t tick_get_us(void);
+// CPU clock cycles, wrapping around at 32 bits.
+uint32_t tick_get_cycles(void);
+
+// Sleeps until an interrupt or for at most max_ms. When it's more than a
+// millisecond the tick is stopped for the duration and ticks_ms caught up
+// on wake.
+void tick_sleep(uint32_t max_ms);
+
 #endif  // __MICROPY_INCLUDED_ATMEL_SAMD_TICK_H__
@@ -19,6 +19,9 @@ Example usage on ESP8266:
     os.VfsFat(sd, "")
     os.listdir()
 
+Ports with uos.SDCard have the same driver built in, taking the same
+arguments; it is much faster and can transfer several blocks at a time.
+
 """
 
 from micropython import const
@@ -25,6 +25,7 @@
  */
 
 #include "common-hal/microcontroller/types.h"
+#include "shared-bindings/microcontroller/__init__.h"
 #include "shared-bindings/microcontroller/Pin.h"
 
 #include "eagle_soc.h"
@@ -51,6 +52,12 @@ void common_hal_mcu_enable_interrupts() {
     enable_irq(saved_interrupt_state & ~(1 << ETS_LOOP_ITER_BIT));
 }
 
+size_t common_hal_mcu_get_boot_phases(const mcu_boot_phase_t **phases) {
+    // the stages of starting up aren't marked on the ESP8266
+    *phases = NULL;
+    return 0;
+}
+
 // This macro is used to simplify pin definition in boards/<board>/pins.c
 #define PIN(p_name, p_gpio_number, p_gpio_function, p_peripheral) \
 const mcu_pin_obj_t pin_## p_name = { \
@@ -43,3 +43,15 @@ uint16_t common_hal_nativeio_analogin_get_value(nativeio_analogin_obj_t *self) {
     // ADC is 10 bit so shift by 6 to make it 16-bit.
     return system_adc_read() << 6;
 }
+
+void common_hal_nativeio_analogin_start_capture(nativeio_analogin_obj_t *self,
+        mp_obj_t buffer, uint16_t *data, size_t len, uint32_t sample_rate) {
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_NotImplementedError, "Capture not supported."));
+}
+
+int8_t common_hal_nativeio_analogin_capture_ready(nativeio_analogin_obj_t *self) {
+    return -1;
+}
+
+void common_hal_nativeio_analogin_stop_capture(nativeio_analogin_obj_t *self) {
+}
@@ -45,3 +45,18 @@ void common_hal_nativeio_analogout_deinit(nativeio_analogout_obj_t *self) {
 void common_hal_nativeio_analogout_set_value(nativeio_analogout_obj_t *self,
         uint16_t value) {
 }
+
+void common_hal_nativeio_analogout_start_playback(nativeio_analogout_obj_t *self,
+        mp_obj_t buffer, const uint16_t *data, size_t len, uint32_t sample_rate, bool loop) {
+}
+
+int8_t common_hal_nativeio_analogout_playback_ready(nativeio_analogout_obj_t *self) {
+    return -1;
+}
+
+bool common_hal_nativeio_analogout_get_playing(nativeio_analogout_obj_t *self) {
+    return false;
+}
+
+void common_hal_nativeio_analogout_stop_playback(nativeio_analogout_obj_t *self) {
+}
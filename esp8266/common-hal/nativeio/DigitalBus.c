@@ -0,0 +1,58 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/nlr.h"
+#include "py/runtime.h"
+#include "shared-bindings/nativeio/DigitalBus.h"
+
+void common_hal_nativeio_digitalbus_construct(nativeio_digitalbus_obj_t* self,
+        const mcu_pin_obj_t **pins, size_t num_pins, const mcu_pin_obj_t *strobe) {
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_NotImplementedError, "No DigitalBus support."));
+}
+
+void common_hal_nativeio_digitalbus_deinit(nativeio_digitalbus_obj_t* self) {
+}
+
+void common_hal_nativeio_digitalbus_switch_to_output(nativeio_digitalbus_obj_t* self, uint32_t value) {
+}
+
+void common_hal_nativeio_digitalbus_switch_to_input(nativeio_digitalbus_obj_t* self) {
+}
+
+bool common_hal_nativeio_digitalbus_is_output(nativeio_digitalbus_obj_t* self) {
+    return false;
+}
+
+void common_hal_nativeio_digitalbus_set_value(nativeio_digitalbus_obj_t* self, uint32_t value) {
+}
+
+uint32_t common_hal_nativeio_digitalbus_get_value(nativeio_digitalbus_obj_t* self) {
+    return 0;
+}
+
+void common_hal_nativeio_digitalbus_write(nativeio_digitalbus_obj_t* self,
+        const void *data, size_t len, size_t item_size) {
+}
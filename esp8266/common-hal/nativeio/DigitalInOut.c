@@ -32,6 +32,7 @@
 #include "py/runtime.h"
 #include "py/mphal.h"
 
+#include "common-hal/nativeio/DigitalInOut.h"
 #include "shared-bindings/nativeio/DigitalInOut.h"
 
 digitalinout_result_t common_hal_nativeio_digitalinout_construct(
@@ -105,6 +106,13 @@ void common_hal_nativeio_digitalinout_set_value(
 // Register addresses taken from: https://github.com/esp8266/esp8266-wiki/wiki/gpio-registers
 volatile uint32_t* PIN_DIR = (uint32_t *) 0x6000030C;
 volatile uint32_t* PIN_OUT = (uint32_t *) 0x60000300;
+bool common_hal_nativeio_digitalinout_fast_read(nativeio_digitalinout_obj_t* self) {
+    if (self->pin->gpio_number == 16) {
+        return READ_PERI_REG(RTC_GPIO_IN_DATA) & 1;
+    }
+    return GPIO_INPUT_GET(self->pin->gpio_number);
+}
+
 bool common_hal_nativeio_digitalinout_get_value(
         nativeio_digitalinout_obj_t* self) {
     if (!self->output) {
@@ -170,3 +178,10 @@ enum digitalinout_pull_t common_hal_nativeio_digitalinout_get_pull(
     }
     return PULL_NONE;
 }
+
+void common_hal_nativeio_digitalinout_set_irq(nativeio_digitalinout_obj_t* self,
+        mp_obj_t handler, enum digitalinout_edge_t edge) {
+    // machine.Pin.irq provides pin interrupts on this port.
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_NotImplementedError,
+        "Pin interrupts not supported, use machine.Pin.irq"));
+}
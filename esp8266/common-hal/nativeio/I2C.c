@@ -40,6 +40,10 @@ bool common_hal_nativeio_i2c_probe(nativeio_i2c_obj_t *self, uint8_t addr) {
     return false;
 }
 
+bool common_hal_nativeio_i2c_configure(nativeio_i2c_obj_t *self, uint32_t frequency) {
+    return false;
+}
+
 bool common_hal_nativeio_i2c_try_lock(nativeio_i2c_obj_t *self) {
     return false;
 }
@@ -60,3 +64,22 @@ bool common_hal_nativeio_i2c_read(nativeio_i2c_obj_t *self, uint16_t addr,
         uint8_t * data, size_t len) {
     return false;
 }
+
+bool common_hal_nativeio_i2c_write_then_read(nativeio_i2c_obj_t *self, uint16_t addr,
+        const uint8_t *out_data, size_t out_len, uint8_t *in_data, size_t in_len) {
+    return false;
+}
+
+bool common_hal_nativeio_i2c_start_write_then_read(nativeio_i2c_obj_t *self,
+        uint16_t addr, mp_obj_t out_buffer, const uint8_t *out_data, size_t out_len,
+        mp_obj_t in_buffer, uint8_t *in_data, size_t in_len) {
+    return false;
+}
+
+bool common_hal_nativeio_i2c_transfer_in_progress(nativeio_i2c_obj_t *self) {
+    return false;
+}
+
+bool common_hal_nativeio_i2c_wait_for_transfer(nativeio_i2c_obj_t *self) {
+    return true;
+}
@@ -35,7 +35,16 @@
 // Shared with pybpwm
 extern bool pwm_inited;
 
-void common_hal_nativeio_pwmout_construct(nativeio_pwmout_obj_t* self, const mcu_pin_obj_t* pin, uint16_t duty) {
+// The ESP8266 has a single PWM timer so every PWMOut runs at the same
+// frequency.
+#define PWM_FREQ_MAX 1000
+
+void common_hal_nativeio_pwmout_construct(nativeio_pwmout_obj_t* self, const mcu_pin_obj_t* pin,
+        uint16_t duty, uint32_t frequency, bool variable_frequency) {
+    if (frequency > PWM_FREQ_MAX) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Maximum PWM frequency is 1kHz."));
+    }
     // start the PWM subsystem if it's not already running
     if (!pwm_inited) {
         pwm_init();
@@ -49,6 +58,9 @@ void common_hal_nativeio_pwmout_construct(nativeio_pwmout_obj_t* self, const mcu
         nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_OSError,
             "PWM not supported on pin %d", pin->gpio_number));
     }
+    self->variable_frequency = variable_frequency;
+    pwm_set_freq(frequency, self->channel);
+    common_hal_nativeio_pwmout_set_duty_cycle(self, duty);
 }
 
 extern void common_hal_nativeio_pwmout_deinit(nativeio_pwmout_obj_t* self) {
@@ -65,3 +77,20 @@ extern void common_hal_nativeio_pwmout_set_duty_cycle(nativeio_pwmout_obj_t* sel
 uint16_t common_hal_nativeio_pwmout_get_duty_cycle(nativeio_pwmout_obj_t* self) {
     return pwm_get_duty(self->channel) << 6;
 }
+
+bool common_hal_nativeio_pwmout_set_frequency(nativeio_pwmout_obj_t* self, uint32_t frequency) {
+    if (frequency > PWM_FREQ_MAX) {
+        return false;
+    }
+    pwm_set_freq(frequency, self->channel);
+    pwm_start();
+    return true;
+}
+
+uint32_t common_hal_nativeio_pwmout_get_frequency(nativeio_pwmout_obj_t* self) {
+    return pwm_get_freq(self->channel);
+}
+
+bool common_hal_nativeio_pwmout_get_variable_frequency(nativeio_pwmout_obj_t* self) {
+    return self->variable_frequency;
+}
@@ -134,3 +134,37 @@ bool common_hal_nativeio_spi_read(nativeio_spi_obj_t *self,
     }
     return true;
 }
+
+bool common_hal_nativeio_spi_transfer(nativeio_spi_obj_t *self,
+        const uint8_t * data_out, uint8_t * data_in, size_t len) {
+    // Process data in chunks, let the pending tasks run in between
+    size_t chunk_size = 1024; // TODO this should depend on baudrate
+    size_t count = len / chunk_size;
+    size_t i = 0;
+    for (size_t j = 0; j < count; ++j) {
+        for (size_t k = 0; k < chunk_size; ++k) {
+            data_in[i] = spi_transaction(HSPI, 0, 0, 0, 0, 8, data_out[i], 8, 0);
+            ++i;
+        }
+        ets_loop_iter();
+    }
+    while (i < len) {
+        data_in[i] = spi_transaction(HSPI, 0, 0, 0, 0, 8, data_out[i], 8, 0);
+        ++i;
+    }
+    return true;
+}
+
+// There's no DMA path here so background writes are done synchronously.
+bool common_hal_nativeio_spi_start_write(nativeio_spi_obj_t *self,
+        mp_obj_t buffer, const uint8_t * data, size_t len) {
+    (void) buffer;
+    return common_hal_nativeio_spi_write(self, data, len);
+}
+
+bool common_hal_nativeio_spi_write_in_progress(nativeio_spi_obj_t *self) {
+    return false;
+}
+
+void common_hal_nativeio_spi_wait_for_write(nativeio_spi_obj_t *self) {
+}
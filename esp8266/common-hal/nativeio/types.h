@@ -39,11 +39,26 @@ typedef struct {
     const mcu_pin_obj_t * pin;
 } nativeio_analogin_obj_t;
 
+typedef struct {
+    mp_obj_base_t base;
+    uint8_t num_pins;
+} nativeio_analoginscan_obj_t;
+
 // Not supported, throws error on construction.
 typedef struct {
     mp_obj_base_t base;
 } nativeio_analogout_obj_t;
 
+// Not supported, throws error on construction.
+typedef struct {
+    mp_obj_base_t base;
+} nativeio_digitalbus_obj_t;
+
+// Not supported, throws error on construction.
+typedef struct {
+    mp_obj_base_t base;
+} nativeio_pulsein_obj_t;
+
 typedef struct {
     mp_obj_base_t base;
     const mcu_pin_obj_t * pin;
@@ -64,6 +79,7 @@ typedef struct {
 typedef struct {
     mp_obj_base_t base;
     int channel;
+    bool variable_frequency;
 } nativeio_pwmout_obj_t;
 
 #endif // __MICROPY_INCLUDED_ATMEL_SAMD_COMMON_HAL_NATIVEIO_TYPES_H__
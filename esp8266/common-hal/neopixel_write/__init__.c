@@ -31,3 +31,11 @@
 void common_hal_neopixel_write(const nativeio_digitalinout_obj_t* digitalinout, uint8_t *pixels, uint32_t numBytes, bool is800KHz) {
     esp_neopixel_write(digitalinout->pin->gpio_number, pixels, numBytes, is800KHz);
 }
+
+// Writes here are blocking so there's never one in progress.
+bool common_hal_neopixel_write_in_progress(void) {
+    return false;
+}
+
+void common_hal_neopixel_write_wait(void) {
+}
@@ -32,7 +32,11 @@
 #include "user_interface.h"
 
 inline uint64_t common_hal_time_monotonic() {
-    return ((uint64_t)system_time_high_word << 32 | (uint64_t)system_get_time()) / 1000;
+    return common_hal_time_monotonic_us() / 1000;
+}
+
+uint64_t common_hal_time_monotonic_us() {
+    return (uint64_t)system_time_high_word << 32 | (uint64_t)system_get_time();
 }
 
 void common_hal_time_delay_ms(uint32_t delay) {
@@ -30,9 +30,12 @@
 #include "uart.h"
 #include "esp_mphal.h"
 #include "user_interface.h"
+#include "osapi.h"
 #include "ets_alt_task.h"
+#include "xtirq.h"
 #include "py/obj.h"
 #include "py/mpstate.h"
+#include "py/runtime.h"
 #include "extmod/misc.h"
 #include "lib/utils/pyexec.h"
 
@@ -41,16 +44,45 @@ ringbuf_t input_buf = {input_buf_array, sizeof(input_buf_array)};
 void mp_hal_debug_tx_strn_cooked(void *env, const char *str, uint32_t len);
 const mp_print_t mp_debug_print = {NULL, mp_hal_debug_tx_strn_cooked};
 
+// Only used to bound the time ets_event_wait_ms() sleeps for
+STATIC os_timer_t wait_timer;
+
+// Set by interrupt handlers which have news for code waiting in
+// ets_event_wait_ms(), such as input for the REPL.
+STATIC volatile bool event_signalled;
+
+STATIC void wait_timer_cb(void *arg) {
+    (void)arg;
+}
+
 void mp_hal_init(void) {
     //ets_wdt_disable(); // it's a pain while developing
     mp_hal_rtc_init();
+    // go back to the static RX buffer, a larger one set with UART(0, rxbuf=...)
+    // was on the heap which is about to be reset
+    uart_set_rxbuf(input_buf_array, sizeof(input_buf_array));
     uart_init(UART_BIT_RATE_115200, UART_BIT_RATE_115200);
+    os_timer_setfn(&wait_timer, wait_timer_cb, NULL);
 }
 
 void mp_hal_delay_us(uint32_t us) {
     uint32_t start = system_get_time();
-    while (system_get_time() - start < us) {
-        ets_event_poll();
+    for (;;) {
+        uint32_t dt = system_get_time() - start;
+        if (dt >= us) {
+            break;
+        }
+        // sleep through all but the last millisecond, which is polled for
+        // accuracy since the timer only has millisecond resolution
+        uint32_t remain_ms = (us - dt) / 1000;
+        if (remain_ms >= 2) {
+            ets_event_wait_ms(remain_ms - 1);
+            #if MICROPY_ENABLE_SCHEDULER
+            mp_sched_run_pending();
+            #endif
+        } else {
+            ets_event_poll();
+        }
     }
 }
 
@@ -60,13 +92,10 @@ int mp_hal_stdin_rx_chr(void) {
         if (c != -1) {
             return c;
         }
-        #if 0
-        // Idles CPU but need more testing before enabling
-        if (!ets_loop_iter()) {
-            asm("waiti 0");
-        }
-        #else
-        mp_hal_delay_us(1);
+        // the UART interrupt wakes us up when a character comes in
+        ets_event_wait_ms(0);
+        #if MICROPY_ENABLE_SCHEDULER
+        mp_sched_run_pending();
         #endif
     }
 }
@@ -135,6 +164,79 @@ void ets_event_poll(void) {
         MP_STATE_VM(mp_pending_exception) = MP_OBJ_NULL;
         nlr_raise(obj);
     }
+    #if MICROPY_ENABLE_SCHEDULER
+    mp_sched_run_pending();
+    #endif
+}
+
+mp_uint_t mp_hal_begin_atomic_section(void) {
+    return disable_irq();
+}
+
+void mp_hal_end_atomic_section(mp_uint_t state) {
+    enable_irq(state);
+}
+
+STATIC bool event_pending(void) {
+    return event_signalled || ets_loop_has_work()
+        || MP_STATE_VM(mp_pending_exception) != NULL
+        #if MICROPY_ENABLE_SCHEDULER
+        || MP_STATE_VM(sched_state) == MP_SCHED_PENDING
+        #endif
+        ;
+}
+
+// Like ets_event_poll(), but if there were no tasks to run then sleep until
+// the next interrupt, or until timeout_ms has passed if it is not 0.  New
+// tasks (network, UART, timers) are only ever posted from interrupts, and
+// are checked for with interrupts disabled so none is missed.  While the CPU
+// waits here the SDK can go into the sleep set by esp.sleep_type(), which
+// with SLEEP_LIGHT keeps the WiFi association and open sockets but stops
+// the CPU and radio between beacons.
+void ets_event_wait_ms(uint32_t timeout_ms) {
+    if (!ets_loop_iter()) {
+        if (timeout_ms != 0) {
+            os_timer_arm(&wait_timer, timeout_ms, 0);
+        }
+        uint32_t irq_state = disable_irq();
+        if (!event_pending()) {
+            asm("waiti 0");
+        }
+        event_signalled = false;
+        enable_irq(irq_state);
+        if (timeout_ms != 0) {
+            os_timer_disarm(&wait_timer);
+        }
+    }
+    if (MP_STATE_VM(mp_pending_exception) != NULL) {
+        mp_obj_t obj = MP_STATE_VM(mp_pending_exception);
+        MP_STATE_VM(mp_pending_exception) = MP_OBJ_NULL;
+        nlr_raise(obj);
+    }
+}
+
+// Waits for the next event, but at most 1ms so that callers can still check
+// their timeouts.
+void ets_event_wait(void) {
+    ets_event_wait_ms(1);
+}
+
+// Sleeps until there is something for Python code to do: a scheduled
+// callback such as a Pin.irq() handler, which is then run, input on the
+// REPL, or a KeyboardInterrupt.
+void ets_event_sleep(void) {
+    for (;;) {
+        #if MICROPY_ENABLE_SCHEDULER
+        if (MP_STATE_VM(sched_state) == MP_SCHED_PENDING) {
+            mp_sched_run_pending();
+            return;
+        }
+        #endif
+        if (input_buf.iget != input_buf.iput) {
+            return;
+        }
+        ets_event_wait_ms(0);
+    }
 }
 
 void __assert_func(const char *file, int line, const char *func, const char *expr) {
@@ -144,6 +246,7 @@ void __assert_func(const char *file, int line, const char *func, const char *exp
 }
 
 void mp_hal_signal_input(void) {
+    event_signalled = true;
     #if MICROPY_REPL_EVENT_DRIVEN
     system_os_post(UART_TASK_ID, 0, 0);
     #endif
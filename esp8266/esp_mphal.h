@@ -63,6 +63,9 @@ void uart_task_init();
 void dupterm_task_init();
 
 void ets_event_poll(void);
+void ets_event_wait(void);
+void ets_event_wait_ms(uint32_t timeout_ms);
+void ets_event_sleep(void);
 #define ETS_POLL_WHILE(cond) { while (cond) ets_event_poll(); }
 
 // needed for machine.I2C
@@ -89,7 +92,10 @@ void mp_hal_pin_open_drain(mp_hal_pin_obj_t pin);
         if ((p) == 16) { WRITE_PERI_REG(RTC_GPIO_ENABLE, (READ_PERI_REG(RTC_GPIO_ENABLE) & ~1)); } \
         else { gpio_output_set(1 << (p), 0, 1 << (p), 0); } \
     } while (0)
-#define mp_hal_pin_read(p) pin_get(p)
+// reads the input register directly, rather than going through pin_get()
+// and gpio_input_get(), so that bit-banged protocols like I2C run faster
+#define mp_hal_pin_read(p) \
+    ((p) == 16 ? (READ_PERI_REG(RTC_GPIO_IN_DATA) & 1) : ((GPIO_REG_READ(GPIO_IN_ADDRESS) >> (p)) & 1))
 #define mp_hal_pin_write(p, v) pin_set((p), (v))
 
 void *ets_get_esf_buf_ctlblk(void);
@@ -32,6 +32,7 @@
 #include "eagle_soc.h"
 #include "user_interface.h"
 #include "espapa102.h"
+#include "hspi.h"
 
 #define NOP asm volatile(" nop \n\t")
 
@@ -95,9 +96,72 @@ static inline void _esp_apa102_end_frame(uint32_t clockPinMask, uint32_t dataPin
     }
 }
 
+// With the clock on GPIO14 and data on GPIO13, the HSPI CLK and MOSI pins,
+// the frame is shifted out by the SPI peripheral at 5MHz, 32 bytes at a
+// time, and interrupts are never disabled since the strip is clocked.
+typedef struct _apa102_stream_t {
+    uint32_t words[8];
+    uint32_t len;
+    bool high;
+} apa102_stream_t;
+
+static void _esp_apa102_stream_flush(apa102_stream_t *s) {
+    if (s->len > 0) {
+        spi_tx_stream_load(HSPI, s->high, s->words, (s->len + 3) / 4);
+        spi_tx_stream_send(HSPI, s->high, s->len * 8);
+        s->high = !s->high;
+        s->len = 0;
+    }
+}
+
+static inline void _esp_apa102_stream_byte(apa102_stream_t *s, uint8_t byte) {
+    ((uint8_t*)s->words)[s->len++] = byte;
+    if (s->len == sizeof(s->words)) {
+        _esp_apa102_stream_flush(s);
+    }
+}
+
+static void esp_apa102_write_hspi(uint8_t *pixels, uint32_t numBytes) {
+    spi_saved_regs_t saved;
+    spi_tx_stream_begin(HSPI, 8, 2, &saved);
+    PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTCK_U, 2);
+    PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTMS_U, 2);
+
+    apa102_stream_t s = {.len = 0, .high = false};
+
+    // start frame
+    for (uint32_t i = 0; i < 4; i++) {
+        _esp_apa102_stream_byte(&s, 0x00);
+    }
+
+    for (uint32_t i = 0; i < numBytes / 4; i++) {
+        _esp_apa102_stream_byte(&s, pixels[i * 4 + 3] | 0xE0);
+        _esp_apa102_stream_byte(&s, pixels[i * 4 + 2]);
+        _esp_apa102_stream_byte(&s, pixels[i * 4 + 1]);
+        _esp_apa102_stream_byte(&s, pixels[i * 4]);
+    }
+
+    // the additional clock cycles with the data high, rounded up to whole
+    // bytes, then the end frame
+    uint32_t extra = numBytes / 8 + ((numBytes / 4) % 2);
+    for (uint32_t i = 0; i < (extra + 7) / 8 + 4; i++) {
+        _esp_apa102_stream_byte(&s, 0xFF);
+    }
+    _esp_apa102_stream_flush(&s);
+
+    spi_tx_stream_end(HSPI, &saved);
+    PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTCK_U, FUNC_GPIO13);
+    PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTMS_U, FUNC_GPIO14);
+}
+
 void esp_apa102_write(uint8_t clockPin, uint8_t dataPin, uint8_t *pixels, uint32_t numBytes) {
     uint32_t clockPinMask, dataPinMask;
 
+    if (clockPin == 14 && dataPin == 13) {
+        esp_apa102_write_hspi(pixels, numBytes);
+        return;
+    }
+
     clockPinMask = 1 << clockPin;
     dataPinMask = 1 << dataPin;
 
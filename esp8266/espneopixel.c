@@ -13,11 +13,59 @@
 #include "user_interface.h"
 #include "espneopixel.h"
 #include "esp_mphal.h"
+#include "hspi.h"
 
 #define NEO_KHZ400 (1)
 
+// On GPIO13, the HSPI MOSI pin, the bitstream is made by the SPI peripheral:
+// each data bit becomes 4 SPI bits, 1000 for a 0 and 1110 (1100 at 400kHz)
+// for a 1, at 3.33MHz (1.67MHz), so one pixel byte is one 32 bit word.
+// Interrupts are only held off while waiting for the previous half buffer
+// to go out (at most 77us at 800kHz), not for the whole strip.
+static void esp_neopixel_write_hspi(uint8_t *pixels, uint32_t numBytes, bool is800KHz) {
+  // SPI bytes for each pair of data bits, the first one in the high nibble
+  uint8_t code[4];
+  uint8_t one = is800KHz ? 0xe : 0xc;
+  code[0] = 0x88;
+  code[1] = 0x80 | one;
+  code[2] = (one << 4) | 0x8;
+  code[3] = (one << 4) | one;
+
+  spi_saved_regs_t saved;
+  spi_tx_stream_begin(HSPI, is800KHz ? 12 : 24, 2, &saved);
+  PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTCK_U, 2);
+
+  bool high = false;
+  while (numBytes > 0) {
+    uint32_t words[8];
+    uint32_t n = numBytes < 8 ? numBytes : 8;
+    for (uint32_t i = 0; i < n; i++) {
+      uint8_t pix = pixels[i];
+      // the lowest byte of the word goes out first
+      words[i] = code[pix >> 6] | code[(pix >> 4) & 3] << 8
+        | code[(pix >> 2) & 3] << 16 | code[pix & 3] << 24;
+    }
+    spi_tx_stream_load(HSPI, high, words, n);
+    uint32_t irq_state = mp_hal_quiet_timing_enter();
+    spi_tx_stream_send(HSPI, high, n * 32);
+    mp_hal_quiet_timing_exit(irq_state);
+    high = !high;
+    pixels += n;
+    numBytes -= n;
+  }
+
+  // the line idles low as every code ends in a 0
+  spi_tx_stream_end(HSPI, &saved);
+  PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTCK_U, FUNC_GPIO13);
+}
+
 void /*ICACHE_RAM_ATTR*/ esp_neopixel_write(uint8_t pin, uint8_t *pixels, uint32_t numBytes, bool is800KHz) {
 
+  if (pin == 13) {
+    esp_neopixel_write_hspi(pixels, numBytes, is800KHz);
+    return;
+  }
+
   uint8_t *p, *end, pix, mask;
   uint32_t t, time0, time1, period, c, startTime, pinMask;
 
@@ -153,6 +153,17 @@ bool ets_loop_iter(void) {
     return progress;
 }
 
+// Whether any task has an event waiting, without running it.  Call with
+// interrupts disabled to then sleep without missing a newly posted event.
+bool ets_loop_has_work(void) {
+    for (volatile struct task_entry *t = emu_tasks; t < &emu_tasks[MP_ARRAY_SIZE(emu_tasks)]; t++) {
+        if (t->i_get != t->i_put) {
+            return true;
+        }
+    }
+    return false;
+}
+
 #if SDK_BELOW_1_1_1
 void my_timer_isr(void *arg) {
 //    uart0_write_char('+');
@@ -8,5 +8,6 @@ extern int ets_loop_iter_disable;
 extern uint32_t system_time_high_word;
 
 bool ets_loop_iter(void);
+bool ets_loop_has_work(void);
 
 #endif  // _INCLUDED_ETS_ALT_TASK_H_
@@ -32,6 +32,11 @@ void MD5Init(MD5_CTX *context);
 void MD5Update(MD5_CTX *context, const void *data, unsigned int len);
 void MD5Final(unsigned char digest[16], MD5_CTX *context);
 
+// The ROM's SHA1 context is opaque, see uhashlib_rom.c for its size
+void SHA1Init(void *context);
+void SHA1Update(void *context, const void *data, unsigned int len);
+void SHA1Final(unsigned char digest[20], void *context);
+
 // These prototypes are for recent SDKs with "malloc tracking"
 void *pvPortMalloc(unsigned sz, const char *fname, int line);
 void *pvPortZalloc(unsigned sz, const char *fname, int line);
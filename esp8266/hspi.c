@@ -329,3 +329,61 @@ inline void spi_tx8fast(uint8_t spi_no, uint8_t dout_data) {
 // Begin SPI Transaction
     SET_PERI_REG_MASK(SPI_CMD(spi_no), SPI_USR);
 }
+
+
+/*
+Streaming output of long buffers, used for LED strips.
+The 64 byte W0-W15 buffer is used as two halves: while one half is being
+shifted out, the next 32 bytes are loaded into the other one, so the data
+keeps flowing with only a short gap between transactions.
+*/
+void spi_tx_stream_begin(uint8_t spi_no, uint16_t prediv, uint8_t cntdiv, spi_saved_regs_t *saved) {
+    while (spi_busy(spi_no)) {};
+
+    // keep the setup of the bus, which may be in use by machine.HSPI
+    saved->mux = READ_PERI_REG(PERIPHS_IO_MUX);
+    saved->clock = READ_PERI_REG(SPI_CLOCK(spi_no));
+    saved->user = READ_PERI_REG(SPI_USER(spi_no));
+    saved->user1 = READ_PERI_REG(SPI_USER1(spi_no));
+    saved->pin = READ_PERI_REG(SPI_PIN(spi_no));
+
+    if (spi_no == HSPI) {
+        WRITE_PERI_REG(PERIPHS_IO_MUX, 0x105);
+    }
+    spi_clock(spi_no, prediv, cntdiv);
+    spi_mode(spi_no, 0, 0);
+    // data only, sent from the lowest byte of each word, and no CS delays
+    CLEAR_PERI_REG_MASK(SPI_USER(spi_no), SPI_USR_MISO | SPI_USR_COMMAND |
+        SPI_USR_ADDR | SPI_USR_DUMMY | SPI_DOUTDIN | SPI_WR_BYTE_ORDER |
+        SPI_CS_SETUP | SPI_CS_HOLD | SPI_FLASH_MODE);
+    SET_PERI_REG_MASK(SPI_USER(spi_no), SPI_USR_MOSI);
+}
+
+// Load up to 8 words into the low (W0-W7) or high (W8-W15) half of the buffer.
+void spi_tx_stream_load(uint8_t spi_no, bool high, const uint32_t *words, size_t nwords) {
+    uint32_t reg = SPI_W0(spi_no) + (high ? 32 : 0);
+    for (size_t i = 0; i < nwords; ++i) {
+        WRITE_PERI_REG(reg + 4 * i, words[i]);
+    }
+}
+
+// Wait for the transaction in progress, then send nbits from the given half.
+void spi_tx_stream_send(uint8_t spi_no, bool high, uint32_t nbits) {
+    while (spi_busy(spi_no)) {};
+    if (high) {
+        SET_PERI_REG_MASK(SPI_USER(spi_no), SPI_USR_MOSI_HIGHPART);
+    } else {
+        CLEAR_PERI_REG_MASK(SPI_USER(spi_no), SPI_USR_MOSI_HIGHPART);
+    }
+    WRITE_PERI_REG(SPI_USER1(spi_no), ((nbits - 1) & SPI_USR_MOSI_BITLEN) << SPI_USR_MOSI_BITLEN_S);
+    SET_PERI_REG_MASK(SPI_CMD(spi_no), SPI_USR);
+}
+
+void spi_tx_stream_end(uint8_t spi_no, const spi_saved_regs_t *saved) {
+    while (spi_busy(spi_no)) {};
+    WRITE_PERI_REG(PERIPHS_IO_MUX, saved->mux);
+    WRITE_PERI_REG(SPI_CLOCK(spi_no), saved->clock);
+    WRITE_PERI_REG(SPI_USER(spi_no), saved->user);
+    WRITE_PERI_REG(SPI_USER1(spi_no), saved->user1);
+    WRITE_PERI_REG(SPI_PIN(spi_no), saved->pin);
+}
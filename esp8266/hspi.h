@@ -26,6 +26,7 @@
 #ifndef SPI_APP_H
 #define SPI_APP_H
 
+#include <stddef.h>
 #include "hspi_register.h"
 #include "ets_sys.h"
 #include "osapi.h"
@@ -63,6 +64,19 @@ uint32_t spi_transaction(uint8_t spi_no, uint8_t cmd_bits, uint16_t cmd_data,
                          uint32_t din_bits, uint32_t dummy_bits);
 void spi_tx8fast(uint8_t spi_no, uint8_t dout_data);
 
+typedef struct _spi_saved_regs_t {
+    uint32_t mux;
+    uint32_t clock;
+    uint32_t user;
+    uint32_t user1;
+    uint32_t pin;
+} spi_saved_regs_t;
+
+void spi_tx_stream_begin(uint8_t spi_no, uint16_t prediv, uint8_t cntdiv, spi_saved_regs_t *saved);
+void spi_tx_stream_load(uint8_t spi_no, bool high, const uint32_t *words, size_t nwords);
+void spi_tx_stream_send(uint8_t spi_no, bool high, uint32_t nbits);
+void spi_tx_stream_end(uint8_t spi_no, const spi_saved_regs_t *saved);
+
 // Expansion Macros
 #define spi_busy(spi_no) READ_PERI_REG(SPI_CMD(spi_no))&SPI_USR
 
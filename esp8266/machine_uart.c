@@ -34,6 +34,7 @@
 #include "py/runtime.h"
 #include "py/stream.h"
 #include "py/mperrno.h"
+#include "py/mphal.h"
 #include "modmachine.h"
 
 // UartDev is defined and initialized in rom code.
@@ -57,13 +58,13 @@ STATIC const char *_parity_name[] = {"None", "1", "0"};
 
 STATIC void pyb_uart_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     pyb_uart_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_printf(print, "UART(%u, baudrate=%u, bits=%u, parity=%s, stop=%u, timeout=%u, timeout_char=%u)",
+    mp_printf(print, "UART(%u, baudrate=%u, bits=%u, parity=%s, stop=%u, rxbuf=%u, timeout=%u, timeout_char=%u)",
         self->uart_id, self->baudrate, self->bits, _parity_name[self->parity],
-        self->stop, self->timeout, self->timeout_char);
+        self->stop, input_buf.size - 1, self->timeout, self->timeout_char);
 }
 
 STATIC void pyb_uart_init_helper(pyb_uart_obj_t *self, size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_baudrate, ARG_bits, ARG_parity, ARG_stop, ARG_timeout, ARG_timeout_char };
+    enum { ARG_baudrate, ARG_bits, ARG_parity, ARG_stop, ARG_rxbuf, ARG_timeout, ARG_timeout_char };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_baudrate, MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_bits, MP_ARG_INT, {.u_int = 0} },
@@ -71,6 +72,7 @@ STATIC void pyb_uart_init_helper(pyb_uart_obj_t *self, size_t n_args, const mp_o
         { MP_QSTR_stop, MP_ARG_INT, {.u_int = 0} },
         //{ MP_QSTR_tx, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
         //{ MP_QSTR_rx, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_rxbuf, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
         { MP_QSTR_timeout, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_timeout_char, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
     };
@@ -144,6 +146,19 @@ STATIC void pyb_uart_init_helper(pyb_uart_obj_t *self, size_t n_args, const mp_o
             break;
     }
 
+    // set rx ring buffer size; it is shared with the REPL, so only for UART(0)
+    if (args[ARG_rxbuf].u_int >= 0 && self->uart_id == 0) {
+        mp_int_t len = args[ARG_rxbuf].u_int;
+        if (len < 1 || len >= 0xffff) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "invalid rxbuf length"));
+        }
+        // the ring holds one byte less than its size
+        byte *buf = m_new(byte, len + 1);
+        uart_set_rxbuf(buf, len + 1);
+        // keep the buffer alive; the old one, if any, is then freed by the GC
+        MP_STATE_PORT(uart0_rxbuf) = buf;
+    }
+
     // set timeout
     self->timeout = args[ARG_timeout].u_int;
 
@@ -193,8 +208,18 @@ STATIC mp_obj_t pyb_uart_init(size_t n_args, const mp_obj_t *args, mp_map_t *kw_
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(pyb_uart_init_obj, 1, pyb_uart_init);
 
+STATIC mp_obj_t pyb_uart_any(mp_obj_t self_in) {
+    pyb_uart_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->uart_id == 1) {
+        return MP_OBJ_NEW_SMALL_INT(0);
+    }
+    return MP_OBJ_NEW_SMALL_INT(uart_rx_any());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pyb_uart_any_obj, pyb_uart_any);
+
 STATIC const mp_rom_map_elem_t pyb_uart_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_init), MP_ROM_PTR(&pyb_uart_init_obj) },
+    { MP_ROM_QSTR(MP_QSTR_any), MP_ROM_PTR(&pyb_uart_any_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
     { MP_ROM_QSTR(MP_QSTR_readall), MP_ROM_PTR(&mp_stream_readall_obj) },
@@ -223,11 +248,13 @@ STATIC mp_uint_t pyb_uart_read(mp_obj_t self_in, void *buf_in, mp_uint_t size, i
         return MP_STREAM_ERROR;
     }
 
-    // read the data
+    // read the data, taking everything already buffered in one go
     uint8_t *buf = buf_in;
     for (;;) {
-        *buf++ = uart_rx_char();
-        if (--size == 0 || !uart_rx_wait(self->timeout_char * 1000)) {
+        size_t n = uart_rx_chars(buf, size);
+        buf += n;
+        size -= n;
+        if (size == 0 || !uart_rx_wait(self->timeout_char * 1000)) {
             // return number of bytes read
             return buf - (uint8_t*)buf_in;
         }
@@ -256,6 +283,18 @@ STATIC mp_uint_t pyb_uart_write(mp_obj_t self_in, const void *buf_in, mp_uint_t
 }
 
 STATIC mp_uint_t pyb_uart_ioctl(mp_obj_t self_in, mp_uint_t request, mp_uint_t arg, int *errcode) {
+    pyb_uart_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (request == MP_STREAM_POLL) {
+        mp_uint_t ret = 0;
+        if ((arg & MP_STREAM_POLL_RD) && self->uart_id == 0 && uart_rx_any()) {
+            ret |= MP_STREAM_POLL_RD;
+        }
+        if (arg & MP_STREAM_POLL_WR) {
+            // writes block only until there is room in the TX FIFO
+            ret |= MP_STREAM_POLL_WR;
+        }
+        return ret;
+    }
     *errcode = MP_EINVAL;
     return MP_STREAM_ERROR;
 }
@@ -34,6 +34,7 @@
 #include "py/runtime.h"
 #include "py/mperrno.h"
 #include "py/mphal.h"
+#include "extmod/fsusermount.h"
 #include "drivers/dht/dht.h"
 #include "netutils.h"
 #include "queue.h"
@@ -569,6 +570,10 @@ STATIC mp_obj_t esp_flash_read(mp_obj_t offset_in, mp_obj_t len_or_buf_in) {
         mp_get_buffer_raise(len_or_buf_in, &bufinfo, MP_BUFFER_WRITE);
         len = bufinfo.len;
         buf = bufinfo.buf;
+        // a slice of a buffer may not be word aligned, which the SDK needs
+        if ((uintptr_t)buf & 3) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffer must be 4-byte aligned"));
+        }
     }
 
     // We know that allocation will be 4-byte aligned for sure
@@ -586,6 +591,23 @@ STATIC mp_obj_t esp_flash_read(mp_obj_t offset_in, mp_obj_t len_or_buf_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(esp_flash_read_obj, esp_flash_read);
 
+// The first megabyte of flash is mapped through the cache at this address.
+#define FLASH_MAP_ADDR (0x40200000)
+#define FLASH_MAP_SIZE (0x100000)
+
+// Return a read-only memoryview of 32-bit words over memory-mapped flash, so
+// data can be used in place without copying it to the heap.  The mapped
+// region only supports aligned 32-bit loads, hence the 'I' typecode.
+STATIC mp_obj_t esp_flash_map(mp_obj_t offset_in, mp_obj_t len_in) {
+    mp_uint_t offset = mp_obj_get_int(offset_in);
+    mp_uint_t len = mp_obj_get_int(len_in);
+    if ((offset & 3) || (len & 3) || offset > FLASH_MAP_SIZE || len > FLASH_MAP_SIZE - offset) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "invalid flash region"));
+    }
+    return mp_obj_new_memoryview('I', len / 4, (void*)(FLASH_MAP_ADDR + offset));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(esp_flash_map_obj, esp_flash_map);
+
 STATIC mp_obj_t esp_flash_write(mp_obj_t offset_in, const mp_obj_t buf_in) {
     mp_int_t offset = mp_obj_get_int(offset_in);
     mp_buffer_info_t bufinfo;
@@ -633,6 +655,144 @@ STATIC mp_obj_t esp_flash_user_start(void) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(esp_flash_user_start_obj, esp_flash_user_start);
 
+/******************************************************************************/
+// A block device over the user area of the flash, implemented in C so that
+// the FAT driver can use it through mp_block_dev_p_t without calling into
+// the interpreter for every sector.
+
+#define FLASH_SEC_SIZE (4096)
+
+typedef struct _esp_flash_bdev_obj_t {
+    mp_obj_base_t base;
+    uint32_t start_sec;
+    uint32_t num_secs;
+} esp_flash_bdev_obj_t;
+
+STATIC mp_obj_t esp_flash_bdev_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 2, 2, false);
+    esp_flash_bdev_obj_t *self = m_new_obj(esp_flash_bdev_obj_t);
+    self->base.type = type;
+    self->start_sec = mp_obj_get_int(args[0]);
+    self->num_secs = mp_obj_get_int(args[1]);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_uint_t esp_flash_bdev_read(mp_obj_t self_in, uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    esp_flash_bdev_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (block_num + num_blocks > self->num_secs) {
+        return MP_EINVAL;
+    }
+    // Adjacent sectors are contiguous in flash, so read them in one go
+    uint32_t addr = (self->start_sec + block_num) * FLASH_SEC_SIZE;
+    if (spi_flash_read(addr, (uint32_t*)buf, num_blocks * FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK) {
+        return MP_EIO;
+    }
+    return 0;
+}
+
+STATIC mp_uint_t esp_flash_bdev_write(mp_obj_t self_in, const uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    esp_flash_bdev_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (block_num + num_blocks > self->num_secs) {
+        return MP_EINVAL;
+    }
+    uint32_t sec = self->start_sec + block_num;
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        if (spi_flash_erase_sector(sec + i) != SPI_FLASH_RESULT_OK) {
+            return MP_EIO;
+        }
+    }
+    if (spi_flash_write(sec * FLASH_SEC_SIZE, (uint32_t*)buf, num_blocks * FLASH_SEC_SIZE) != SPI_FLASH_RESULT_OK) {
+        return MP_EIO;
+    }
+    return 0;
+}
+
+// With an offset, readblocks/writeblocks access len(buf) bytes from that
+// offset within the sector, and writeblocks only programs without erasing.
+// This is the raw flash interface used by uos.LogBdev.
+STATIC mp_uint_t esp_flash_bdev_raw(esp_flash_bdev_obj_t *self, mp_buffer_info_t *bufinfo, uint32_t block_num, uint32_t offset, bool write) {
+    if (block_num >= self->num_secs || offset + bufinfo->len > FLASH_SEC_SIZE) {
+        return MP_EINVAL;
+    }
+    uint32_t addr = (self->start_sec + block_num) * FLASH_SEC_SIZE + offset;
+    SpiFlashOpResult res;
+    if (write) {
+        res = spi_flash_write(addr, bufinfo->buf, bufinfo->len);
+    } else {
+        res = spi_flash_read(addr, bufinfo->buf, bufinfo->len);
+    }
+    return res == SPI_FLASH_RESULT_OK ? 0 : MP_EIO;
+}
+
+STATIC mp_obj_t esp_flash_bdev_readblocks(mp_uint_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[2], &bufinfo, MP_BUFFER_WRITE);
+    mp_uint_t ret;
+    if (n_args == 4) {
+        ret = esp_flash_bdev_raw(MP_OBJ_TO_PTR(args[0]), &bufinfo, mp_obj_get_int(args[1]), mp_obj_get_int(args[3]), false);
+    } else {
+        ret = esp_flash_bdev_read(args[0], bufinfo.buf, mp_obj_get_int(args[1]), bufinfo.len / FLASH_SEC_SIZE);
+    }
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(esp_flash_bdev_readblocks_obj, 3, 4, esp_flash_bdev_readblocks);
+
+STATIC mp_obj_t esp_flash_bdev_writeblocks(mp_uint_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[2], &bufinfo, MP_BUFFER_READ);
+    mp_uint_t ret;
+    if (n_args == 4) {
+        ret = esp_flash_bdev_raw(MP_OBJ_TO_PTR(args[0]), &bufinfo, mp_obj_get_int(args[1]), mp_obj_get_int(args[3]), true);
+    } else {
+        ret = esp_flash_bdev_write(args[0], bufinfo.buf, mp_obj_get_int(args[1]), bufinfo.len / FLASH_SEC_SIZE);
+    }
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(esp_flash_bdev_writeblocks_obj, 3, 4, esp_flash_bdev_writeblocks);
+
+STATIC mp_obj_t esp_flash_bdev_ioctl(mp_obj_t self_in, mp_obj_t cmd_in, mp_obj_t arg_in) {
+    esp_flash_bdev_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (mp_obj_get_int(cmd_in)) {
+        case BP_IOCTL_SEC_COUNT: return MP_OBJ_NEW_SMALL_INT(self->num_secs);
+        case BP_IOCTL_SEC_SIZE: return MP_OBJ_NEW_SMALL_INT(FLASH_SEC_SIZE);
+        case BP_IOCTL_BLOCK_SIZE: return MP_OBJ_NEW_SMALL_INT(1);
+        case BP_IOCTL_BLOCK_ERASE: {
+            mp_int_t sec = mp_obj_get_int(arg_in);
+            if (sec < 0 || sec >= (mp_int_t)self->num_secs) {
+                return MP_OBJ_NEW_SMALL_INT(MP_EINVAL);
+            }
+            if (spi_flash_erase_sector(self->start_sec + sec) != SPI_FLASH_RESULT_OK) {
+                return MP_OBJ_NEW_SMALL_INT(MP_EIO);
+            }
+            return MP_OBJ_NEW_SMALL_INT(0);
+        }
+        default: return mp_const_none;
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(esp_flash_bdev_ioctl_obj, esp_flash_bdev_ioctl);
+
+STATIC const mp_map_elem_t esp_flash_bdev_locals_dict_table[] = {
+    { MP_OBJ_NEW_QSTR(MP_QSTR_readblocks), (mp_obj_t)&esp_flash_bdev_readblocks_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_writeblocks), (mp_obj_t)&esp_flash_bdev_writeblocks_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_ioctl), (mp_obj_t)&esp_flash_bdev_ioctl_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_SEC_SIZE), MP_OBJ_NEW_SMALL_INT(FLASH_SEC_SIZE) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(esp_flash_bdev_locals_dict, esp_flash_bdev_locals_dict_table);
+
+STATIC const mp_block_dev_p_t esp_flash_bdev_block_dev_p = {
+    .readblocks = esp_flash_bdev_read,
+    .writeblocks = esp_flash_bdev_write,
+};
+
+STATIC const mp_obj_type_t esp_flash_bdev_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_FlashBdev,
+    .make_new = esp_flash_bdev_make_new,
+    .protocol = &esp_flash_bdev_block_dev_p,
+    .locals_dict = (mp_obj_t)&esp_flash_bdev_locals_dict,
+};
+
 STATIC mp_obj_t esp_check_fw(void) {
     MD5_CTX ctx;
     uint32_t *sz_p = (uint32_t*)0x40208ffc;
@@ -646,7 +806,7 @@ STATIC mp_obj_t esp_check_fw(void) {
         printf("%02x", digest[i]);
     }
     printf("\n");
-    return mp_obj_new_bool(memcmp(digest, (void*)(0x40200000 + *sz_p), sizeof(digest)) == 0);
+    return mp_obj_new_bool(memcmp(digest, (void*)(FLASH_MAP_ADDR + *sz_p), sizeof(digest)) == 0);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(esp_check_fw_obj, esp_check_fw);
 
@@ -707,10 +867,12 @@ STATIC const mp_map_elem_t esp_module_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_deepsleep), (mp_obj_t)&esp_deepsleep_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_flash_id), (mp_obj_t)&esp_flash_id_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_flash_read), (mp_obj_t)&esp_flash_read_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_flash_map), (mp_obj_t)&esp_flash_map_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_flash_write), (mp_obj_t)&esp_flash_write_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_flash_erase), (mp_obj_t)&esp_flash_erase_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_flash_size), (mp_obj_t)&esp_flash_size_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_flash_user_start), (mp_obj_t)&esp_flash_user_start_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_FlashBdev), (mp_obj_t)&esp_flash_bdev_type },
     #if MODESP_ESPCONN
     { MP_OBJ_NEW_QSTR(MP_QSTR_socket), (mp_obj_t)&esp_socket_type },
     { MP_OBJ_NEW_QSTR(MP_QSTR_getaddrinfo), (mp_obj_t)&esp_getaddrinfo_obj },
@@ -32,6 +32,21 @@
 #include "modmachine.h"
 #include "esponewire.h"
 
+STATIC uint8_t onewire_readbyte_raw(uint pin) {
+    uint8_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= esp_onewire_readbit(pin) << i;
+    }
+    return value;
+}
+
+STATIC void onewire_writebyte_raw(uint pin, int value) {
+    for (int i = 0; i < 8; ++i) {
+        esp_onewire_writebit(pin, value & 1);
+        value >>= 1;
+    }
+}
+
 STATIC mp_obj_t onewire_timings(mp_obj_t timings_in) {
     mp_obj_t *items;
     mp_obj_get_array_fixed_n(timings_in, 9, &items);
@@ -53,12 +68,7 @@ STATIC mp_obj_t onewire_readbit(mp_obj_t pin_in) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(onewire_readbit_obj, onewire_readbit);
 
 STATIC mp_obj_t onewire_readbyte(mp_obj_t pin_in) {
-    uint pin = mp_obj_get_pin(pin_in);
-    uint8_t value = 0;
-    for (int i = 0; i < 8; ++i) {
-        value |= esp_onewire_readbit(pin) << i;
-    }
-    return MP_OBJ_NEW_SMALL_INT(value);
+    return MP_OBJ_NEW_SMALL_INT(onewire_readbyte_raw(mp_obj_get_pin(pin_in)));
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(onewire_readbyte_obj, onewire_readbyte);
 
@@ -69,22 +79,39 @@ STATIC mp_obj_t onewire_writebit(mp_obj_t pin_in, mp_obj_t value_in) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(onewire_writebit_obj, onewire_writebit);
 
 STATIC mp_obj_t onewire_writebyte(mp_obj_t pin_in, mp_obj_t value_in) {
+    onewire_writebyte_raw(mp_obj_get_pin(pin_in), mp_obj_get_int(value_in));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(onewire_writebyte_obj, onewire_writebyte);
+
+STATIC mp_obj_t onewire_readinto(mp_obj_t pin_in, mp_obj_t buf_in) {
     uint pin = mp_obj_get_pin(pin_in);
-    int value = mp_obj_get_int(value_in);
-    for (int i = 0; i < 8; ++i) {
-        esp_onewire_writebit(pin, value & 1);
-        value >>= 1;
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+    uint8_t *buf = bufinfo.buf;
+    for (size_t i = 0; i < bufinfo.len; ++i) {
+        buf[i] = onewire_readbyte_raw(pin);
     }
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(onewire_writebyte_obj, onewire_writebyte);
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(onewire_readinto_obj, onewire_readinto);
 
-STATIC mp_obj_t onewire_crc8(mp_obj_t data) {
+STATIC mp_obj_t onewire_write(mp_obj_t pin_in, mp_obj_t buf_in) {
+    uint pin = mp_obj_get_pin(pin_in);
     mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(data, &bufinfo, MP_BUFFER_READ);
-    uint8_t crc = 0;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    const uint8_t *buf = bufinfo.buf;
     for (size_t i = 0; i < bufinfo.len; ++i) {
-        uint8_t byte = ((uint8_t*)bufinfo.buf)[i];
+        onewire_writebyte_raw(pin, buf[i]);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(onewire_write_obj, onewire_write);
+
+STATIC uint8_t onewire_crc8_raw(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t byte = data[i];
         for (int b = 0; b < 8; ++b) {
             uint8_t fb_bit = (crc ^ byte) & 0x01;
             if (fb_bit == 0x01) {
@@ -97,10 +124,75 @@ STATIC mp_obj_t onewire_crc8(mp_obj_t data) {
             byte = byte >> 1;
         }
     }
-    return MP_OBJ_NEW_SMALL_INT(crc);
+    return crc;
+}
+
+STATIC mp_obj_t onewire_crc8(mp_obj_t data) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(data, &bufinfo, MP_BUFFER_READ);
+    return MP_OBJ_NEW_SMALL_INT(onewire_crc8_raw(bufinfo.buf, bufinfo.len));
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(onewire_crc8_obj, onewire_crc8);
 
+// Run one pass of the SEARCH ROM algorithm, following the branches chosen
+// by the previous ROM and discrepancy.  Returns the next discrepancy (0 when
+// this was the last device) or -1 if the bus did not respond.
+STATIC int onewire_search_rom(uint pin, uint8_t *rom, int diff) {
+    if (!esp_onewire_reset(pin)) {
+        return -1;
+    }
+    onewire_writebyte_raw(pin, 0xf0); // SEARCH ROM
+    int next_diff = 0;
+    int i = 64;
+    for (int byte = 0; byte < 8; ++byte) {
+        uint8_t r_b = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+            int b = esp_onewire_readbit(pin);
+            if (esp_onewire_readbit(pin)) {
+                if (b) {
+                    // there are no devices or there is an error on the bus
+                    return -1;
+                }
+            } else if (!b) {
+                // collision, two devices with different bit meaning
+                if (diff > i || ((rom[byte] & (1 << bit)) && diff != i)) {
+                    b = 1;
+                    next_diff = i;
+                }
+            }
+            esp_onewire_writebit(pin, b);
+            if (b) {
+                r_b |= 1 << bit;
+            }
+            i -= 1;
+        }
+        rom[byte] = r_b;
+    }
+    return next_diff;
+}
+
+STATIC mp_obj_t onewire_scan(mp_obj_t pin_in) {
+    uint pin = mp_obj_get_pin(pin_in);
+    mp_obj_t devices = mp_obj_new_list(0, NULL);
+    uint8_t rom[8] = {0};
+    int diff = 65;
+    for (int i = 0; i < 0xff; ++i) {
+        diff = onewire_search_rom(pin, rom, diff);
+        if (diff < 0) {
+            break;
+        }
+        // skip ROMs that were corrupted on the wire
+        if (onewire_crc8_raw(rom, sizeof(rom)) == 0) {
+            mp_obj_list_append(devices, mp_obj_new_bytearray(sizeof(rom), rom));
+        }
+        if (diff == 0) {
+            break;
+        }
+    }
+    return devices;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(onewire_scan_obj, onewire_scan);
+
 STATIC const mp_map_elem_t onewire_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_onewire) },
 
@@ -110,7 +202,10 @@ STATIC const mp_map_elem_t onewire_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_readbyte), MP_ROM_PTR((mp_obj_t)&onewire_readbyte_obj) },
     { MP_ROM_QSTR(MP_QSTR_writebit), MP_ROM_PTR((mp_obj_t)&onewire_writebit_obj) },
     { MP_ROM_QSTR(MP_QSTR_writebyte), MP_ROM_PTR((mp_obj_t)&onewire_writebyte_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR((mp_obj_t)&onewire_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR((mp_obj_t)&onewire_write_obj) },
     { MP_ROM_QSTR(MP_QSTR_crc8), MP_ROM_PTR((mp_obj_t)&onewire_crc8_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scan), MP_ROM_PTR((mp_obj_t)&onewire_scan_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(onewire_module_globals, onewire_module_globals_table);
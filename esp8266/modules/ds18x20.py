@@ -1,6 +1,7 @@
 # DS18x20 temperature sensor driver for MicroPython.
 # MIT license; Copyright (c) 2016 Damien P. George
 
+import time
 from micropython import const
 
 _CONVERT = const(0x44)
@@ -36,7 +37,19 @@ class DS18X20:
         self.ow.write(buf)
 
     def read_temp(self, rom):
-        buf = self.read_scratch(rom)
+        return self._temp(rom, self.read_scratch(rom))
+
+    def read_temps(self, roms, timeout_ms=750):
+        # start a conversion on every device at once, wait for the bus to
+        # report completion, then read each scratchpad in turn
+        self.convert_temp()
+        start = time.ticks_ms()
+        while not self.ow.readbit():
+            if time.ticks_diff(time.ticks_ms(), start) > timeout_ms:
+                break
+        return [self.read_temp(rom) for rom in roms]
+
+    def _temp(self, rom, buf):
         if rom[0] == 0x10:
             if buf[1]:
                 t = buf[0] >> 1 | 0x80
@@ -1,30 +1,9 @@
 import esp
 
-class FlashBdev:
-
-    SEC_SIZE = 4096
-    START_SEC = esp.flash_user_start() // SEC_SIZE
-    NUM_BLK = 0x6b
-
-    def __init__(self, blocks=NUM_BLK):
-        self.blocks = blocks
-
-    def readblocks(self, n, buf):
-        #print("readblocks(%s, %x(%d))" % (n, id(buf), len(buf)))
-        esp.flash_read((n + self.START_SEC) * self.SEC_SIZE, buf)
-
-    def writeblocks(self, n, buf):
-        #print("writeblocks(%s, %x(%d))" % (n, id(buf), len(buf)))
-        #assert len(buf) <= self.SEC_SIZE, len(buf)
-        esp.flash_erase(n + self.START_SEC)
-        esp.flash_write((n + self.START_SEC) * self.SEC_SIZE, buf)
-
-    def ioctl(self, op, arg):
-        #print("ioctl(%d, %r)" % (op, arg))
-        if op == 4:  # BP_IOCTL_SEC_COUNT
-            return self.blocks
-        if op == 5:  # BP_IOCTL_SEC_SIZE
-            return self.SEC_SIZE
+# The block device itself is implemented in C (esp.FlashBdev), so the
+# filesystem driver reads and writes flash without going through Python.
+SEC_SIZE = esp.FlashBdev.SEC_SIZE
+START_SEC = esp.flash_user_start() // SEC_SIZE
 
 def set_bl_flash_size(real_size):
     if real_size == 256*1024:
@@ -65,4 +44,4 @@ if size < 1024*1024:
     bdev = None
 else:
     # 20K at the flash end is reserved for SDK params storage
-    bdev = FlashBdev((size - 20480) // FlashBdev.SEC_SIZE - FlashBdev.START_SEC)
+    bdev = esp.FlashBdev(START_SEC, (size - 20480) // SEC_SIZE - START_SEC)
@@ -39,6 +39,8 @@
 #include "user_interface.h"
 
 extern const mp_obj_type_t mp_fat_vfs_type;
+extern const mp_obj_type_t mp_log_bdev_type;
+extern const mp_obj_type_t mp_sdcard_type;
 
 STATIC const qstr os_uname_info_fields[] = {
     MP_QSTR_sysname, MP_QSTR_nodename,
@@ -90,6 +92,11 @@ STATIC mp_obj_t os_listdir(mp_uint_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_listdir_obj, 0, 1, os_listdir);
 
+STATIC mp_obj_t os_ilistdir(mp_uint_t n_args, const mp_obj_t *args) {
+    return vfs_proxy_call(MP_QSTR_ilistdir, n_args, args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_ilistdir_obj, 0, 1, os_ilistdir);
+
 STATIC mp_obj_t os_mkdir(mp_obj_t path_in) {
     return vfs_proxy_call(MP_QSTR_mkdir, 1, &path_in);
 }
@@ -165,9 +172,16 @@ STATIC const mp_rom_map_elem_t os_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_dupterm), MP_ROM_PTR(&mp_uos_dupterm_obj) },
     { MP_ROM_QSTR(MP_QSTR_dupterm_notify), MP_ROM_PTR(&os_dupterm_notify_obj) },
     #endif
+    #if MICROPY_VFS_LOGBDEV
+    { MP_ROM_QSTR(MP_QSTR_LogBdev), MP_ROM_PTR(&mp_log_bdev_type) },
+    #endif
+    #if MICROPY_VFS_SDCARD
+    { MP_ROM_QSTR(MP_QSTR_SDCard), MP_ROM_PTR(&mp_sdcard_type) },
+    #endif
     #if MICROPY_VFS_FAT
     { MP_ROM_QSTR(MP_QSTR_VfsFat), MP_ROM_PTR(&mp_fat_vfs_type) },
     { MP_ROM_QSTR(MP_QSTR_listdir), MP_ROM_PTR(&os_listdir_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ilistdir), MP_ROM_PTR(&os_ilistdir_obj) },
     { MP_ROM_QSTR(MP_QSTR_mkdir), MP_ROM_PTR(&os_mkdir_obj) },
     { MP_ROM_QSTR(MP_QSTR_rmdir), MP_ROM_PTR(&os_rmdir_obj) },
     { MP_ROM_QSTR(MP_QSTR_chdir), MP_ROM_PTR(&os_chdir_obj) },
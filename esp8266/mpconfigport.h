@@ -18,7 +18,18 @@
 #define MICROPY_DEBUG_PRINTER_DEST  mp_debug_print
 #define MICROPY_ENABLE_GC           (1)
 #define MICROPY_STACK_CHECK         (1)
+#define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (128)
+#define MICROPY_OPT_MAP_COMPACT (1)
+#define MICROPY_OPT_INSTANCE_SHARED_KEYS (1)
+#define MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE (16)
+#define MICROPY_OPT_SUPERINSTRUCTIONS (1)
+#define MICROPY_OPT_QUICKENING (1)
+#define MICROPY_OPT_STR_SEARCH_HORSPOOL (1)
+#define MICROPY_OPT_MPZ_KARATSUBA (1)
+#define MICROPY_OPT_STR_INDEX_CACHE (1)
+#define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE (128)
 #define MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF (1)
+#define MICROPY_ENABLE_SCHEDULER    (1)
 #define MICROPY_REPL_EVENT_DRIVEN   (0)
 #define MICROPY_REPL_AUTO_INDENT    (1)
 #define MICROPY_HELPER_REPL         (1)
@@ -32,6 +43,7 @@
 #define MICROPY_PY_BUILTINS_STR_UNICODE (1)
 #define MICROPY_PY_BUILTINS_BYTEARRAY (1)
 #define MICROPY_PY_BUILTINS_MEMORYVIEW (1)
+#define MICROPY_PY_BUILTINS_MEMORYVIEW_CAST (1)
 #define MICROPY_PY_BUILTINS_FROZENSET (1)
 #define MICROPY_PY_BUILTINS_SET     (1)
 #define MICROPY_PY_BUILTINS_SLICE   (1)
@@ -41,29 +53,42 @@
 #define MICROPY_PY_GC               (1)
 #define MICROPY_PY_ARRAY            (1)
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN (1)
+#define MICROPY_PY_ARRAY_VECTOR_OPS (1)
 #define MICROPY_PY_COLLECTIONS      (1)
+#define MICROPY_PY_COLLECTIONS_DEQUE (1)
 #define MICROPY_PY_COLLECTIONS_ORDEREDDICT (1)
 #define MICROPY_PY_MATH             (1)
 #define MICROPY_PY_CMATH            (0)
 #define MICROPY_PY_IO               (1)
 #define MICROPY_PY_IO_FILEIO        (1)
 #define MICROPY_PY_STRUCT           (1)
+#define MICROPY_PY_STRUCT_STRUCT    (1)
 #define MICROPY_PY_SYS              (1)
 #define MICROPY_PY_SYS_MAXSIZE      (1)
 #define MICROPY_PY_SYS_EXIT         (1)
 #define MICROPY_PY_SYS_STDFILES     (1)
 #define MICROPY_PY_SYS_STDIO_BUFFER (1)
 #define MICROPY_PY_UERRNO           (1)
+#define MICROPY_PY_USELECT          (1)
 #define MICROPY_PY_UBINASCII        (1)
 #define MICROPY_PY_UCTYPES          (1)
 #define MICROPY_PY_UHASHLIB         (1)
-#define MICROPY_PY_UHASHLIB_SHA1    (MICROPY_PY_USSL && MICROPY_SSL_AXTLS)
+#define MICROPY_PY_UHASHLIB_SHA1    (1)
+#define MICROPY_PY_UHASHLIB_MD5     (1)
+#define MICROPY_PY_UHASHLIB_SHA1_IMPL esp_rom_sha1_impl
+#define MICROPY_PY_UHASHLIB_MD5_IMPL esp_rom_md5_impl
 #define MICROPY_PY_UHEAPQ           (1)
+#define MICROPY_PY_UASYNCIO         (1)
 #define MICROPY_PY_UJSON            (1)
 #define MICROPY_PY_URANDOM          (1)
 #define MICROPY_PY_URE              (1)
+#define MICROPY_PY_URE_SUB          (1)
+#define MICROPY_PY_URE_PIKEVM       (1)
 #define MICROPY_PY_UTIME_MP_HAL     (1)
 #define MICROPY_PY_UZLIB            (1)
+#define MICROPY_PY_UZLIB_FAST_BITS  (8)
+#define MICROPY_PY_UZLIB_CRC32_TABLES (1)
+#define MICROPY_PY_UZLIB_COMPRESS   (1)
 #define MICROPY_PY_LWIP             (1)
 #define MICROPY_PY_MACHINE          (1)
 #define MICROPY_PY_MACHINE_PULSE    (1)
@@ -72,7 +97,9 @@
 #define MICROPY_PY_WEBSOCKET        (1)
 #define MICROPY_PY_WEBREPL          (1)
 #define MICROPY_PY_WEBREPL_DELAY    (20)
+#define MICROPY_PY_WEBREPL_CHUNK_SIZE (1024)
 #define MICROPY_PY_FRAMEBUF         (1)
+#define MICROPY_PY_FRAMEBUF_DIRTY   (1)
 #define MICROPY_PY_MICROPYTHON_MEM_INFO (1)
 #define MICROPY_PY_OS_DUPTERM       (1)
 #define MICROPY_CPYTHON_COMPAT      (1)
@@ -90,16 +117,22 @@
 
 #define MICROPY_FATFS_ENABLE_LFN       (1)
 #define MICROPY_FATFS_RPATH            (2)
+#define MICROPY_FATFS_USE_FASTSEEK     (1)
 #define MICROPY_FATFS_VOLUMES          (2)
 #define MICROPY_FATFS_MAX_SS           (4096)
 #define MICROPY_FATFS_LFN_CODE_PAGE    (437) /* 1=SFN/ANSI 437=LFN/U.S.(OEM) */
 #define MICROPY_FSUSERMOUNT            (1)
 #define MICROPY_VFS_FAT                (1)
+#define MICROPY_VFS_LOGBDEV            (1)
+#define MICROPY_VFS_SDCARD             (1)
+#define MICROPY_VFS_FAT_IMPORT_CACHE   (1)
 #define MICROPY_ESP8266_APA102         (1)
 #define MICROPY_ESP8266_NEOPIXEL       (1)
 
 extern void ets_event_poll(void);
 #define MICROPY_EVENT_POLL_HOOK {ets_event_poll();}
+extern void ets_event_wait(void);
+#define MICROPY_EVENT_WAIT_HOOK {ets_event_wait();}
 #define MICROPY_VM_HOOK_COUNT (10)
 #define MICROPY_VM_HOOK_INIT static uint vm_hook_divisor = MICROPY_VM_HOOK_COUNT;
 #define MICROPY_VM_HOOK_POLL if (--vm_hook_divisor == 0) { \
@@ -125,6 +158,12 @@ typedef int32_t mp_int_t; // must be pointer size
 typedef uint32_t mp_uint_t; // must be pointer size
 typedef long mp_off_t;
 typedef uint32_t sys_prot_t; // for modlwip
+
+// Interrupts are disabled in atomic sections, see esp_mphal.c
+mp_uint_t mp_hal_begin_atomic_section(void);
+void mp_hal_end_atomic_section(mp_uint_t state);
+#define MICROPY_BEGIN_ATOMIC_SECTION() mp_hal_begin_atomic_section()
+#define MICROPY_END_ATOMIC_SECTION(state) mp_hal_end_atomic_section(state)
 // ssize_t, off_t as required by POSIX-signatured functions in stream.h
 #include <sys/types.h>
 
@@ -145,6 +184,7 @@ extern const struct _mp_obj_module_t network_module;
 extern const struct _mp_obj_module_t utime_module;
 extern const struct _mp_obj_module_t uos_module;
 extern const struct _mp_obj_module_t mp_module_lwip;
+extern const struct _mp_obj_module_t mp_module_uselect;
 extern const struct _mp_obj_module_t mp_module_machine;
 extern const struct _mp_obj_module_t onewire_module;
 extern const struct _mp_obj_module_t microcontroller_module;
@@ -158,6 +198,7 @@ extern const struct _mp_obj_module_t time_module;
     { MP_OBJ_NEW_QSTR(MP_QSTR_lwip), (mp_obj_t)&mp_module_lwip }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_socket), (mp_obj_t)&mp_module_lwip }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_usocket), (mp_obj_t)&mp_module_lwip }, \
+    { MP_OBJ_NEW_QSTR(MP_QSTR_uselect), (mp_obj_t)&mp_module_uselect }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_network), (mp_obj_t)&network_module }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_utime), (mp_obj_t)&utime_module }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_uos), (mp_obj_t)&uos_module }, \
@@ -173,6 +214,7 @@ extern const struct _mp_obj_module_t time_module;
     { MP_OBJ_NEW_QSTR(MP_QSTR_os), (mp_obj_t)&uos_module }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_json), (mp_obj_t)&mp_module_ujson }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_errno), (mp_obj_t)&mp_module_uerrno }, \
+    { MP_OBJ_NEW_QSTR(MP_QSTR_select), (mp_obj_t)&mp_module_uselect }, \
 
 #define MP_STATE_PORT MP_STATE_VM
 
@@ -181,6 +223,7 @@ extern const struct _mp_obj_module_t time_module;
     vstr_t *repl_line; \
     mp_obj_t mp_kbd_exception; \
     mp_obj_t pin_irq_handler[16]; \
+    byte *uart0_rxbuf; \
 
 // We need to provide a declaration/definition of alloca()
 #include <alloca.h>
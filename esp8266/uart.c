@@ -24,6 +24,15 @@
 
 #define UART_REPL UART0
 
+// RX FIFO level (of 128 bytes) at which the RX interrupt fires, and the
+// number of idle character times after which any fewer bytes are flushed
+#ifndef UART0_RX_FIFO_FULL_THRHD
+#define UART0_RX_FIFO_FULL_THRHD (64)
+#endif
+#ifndef UART0_RX_TOUT_THRHD
+#define UART0_RX_TOUT_THRHD (2)
+#endif
+
 // UartDev is defined and initialized in rom code.
 extern UartDevice UartDev;
 
@@ -69,12 +78,14 @@ static void ICACHE_FLASH_ATTR uart_config(uint8 uart_no) {
     CLEAR_PERI_REG_MASK(UART_CONF0(uart_no), UART_RXFIFO_RST | UART_TXFIFO_RST);
 
     if (uart_no == UART0) {
-        // set rx fifo trigger
+        // set rx fifo trigger: an interrupt comes when the FIFO is half full,
+        // or when the line has gone idle with anything left in the FIFO, so
+        // bytes are taken in batches rather than one interrupt each
         WRITE_PERI_REG(UART_CONF1(uart_no),
-                   ((0x10 & UART_RXFIFO_FULL_THRHD) << UART_RXFIFO_FULL_THRHD_S) |
+                   ((UART0_RX_FIFO_FULL_THRHD & UART_RXFIFO_FULL_THRHD) << UART_RXFIFO_FULL_THRHD_S) |
                    ((0x10 & UART_RX_FLOW_THRHD) << UART_RX_FLOW_THRHD_S) |
                    UART_RX_FLOW_EN |
-                   (0x02 & UART_RX_TOUT_THRHD) << UART_RX_TOUT_THRHD_S |
+                   (UART0_RX_TOUT_THRHD & UART_RX_TOUT_THRHD) << UART_RX_TOUT_THRHD_S |
                    UART_RX_TOUT_EN);
         SET_PERI_REG_MASK(UART_INT_ENA(uart_no), UART_RXFIFO_TOUT_INT_ENA |
                       UART_FRM_ERR_INT_ENA);
@@ -161,26 +172,27 @@ static void uart0_rx_intr_handler(void *para) {
         WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_FRM_ERR_INT_CLR);
     }
 
-    if (UART_RXFIFO_FULL_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_RXFIFO_FULL_INT_ST)) {
-        // fifo full
-        goto read_chars;
-    } else if (UART_RXFIFO_TOUT_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_RXFIFO_TOUT_INT_ST)) {
-        read_chars:
+    uint32 int_st = READ_PERI_REG(UART_INT_ST(uart_no));
+    if (int_st & (UART_RXFIFO_FULL_INT_ST | UART_RXFIFO_TOUT_INT_ST)) {
         ETS_UART_INTR_DISABLE();
 
-        while (READ_PERI_REG(UART_STATUS(uart_no)) & (UART_RXFIFO_CNT << UART_RXFIFO_CNT_S)) {
-            uint8 RcvChar = READ_PERI_REG(UART_FIFO(uart_no)) & 0xff;
-            if (RcvChar == mp_interrupt_char) {
-                mp_keyboard_interrupt();
-            } else {
-                ringbuf_put(&input_buf, RcvChar);
+        // empty the whole FIFO, reading its level once per batch
+        uint32 count;
+        while ((count = (READ_PERI_REG(UART_STATUS(uart_no)) >> UART_RXFIFO_CNT_S) & UART_RXFIFO_CNT) != 0) {
+            while (count--) {
+                uint8 RcvChar = READ_PERI_REG(UART_FIFO(uart_no)) & 0xff;
+                if (RcvChar == mp_interrupt_char) {
+                    mp_keyboard_interrupt();
+                } else {
+                    ringbuf_put(&input_buf, RcvChar);
+                }
             }
         }
 
         mp_hal_signal_input();
 
         // Clear pending FIFO interrupts
-        WRITE_PERI_REG(UART_INT_CLR(UART_REPL), UART_RXFIFO_TOUT_INT_CLR | UART_RXFIFO_FULL_INT_ST);
+        WRITE_PERI_REG(UART_INT_CLR(UART_REPL), UART_RXFIFO_TOUT_INT_CLR | UART_RXFIFO_FULL_INT_CLR);
         ETS_UART_INTR_ENABLE();
     }
 }
@@ -205,6 +217,39 @@ int uart_rx_char(void) {
     return ringbuf_get(&input_buf);
 }
 
+// Copies up to len bytes from the input buffer, returning the number copied.
+size_t uart_rx_chars(uint8 *buf, size_t len) {
+    size_t n = 0;
+    int c;
+    while (n < len && (c = ringbuf_get(&input_buf)) >= 0) {
+        buf[n++] = c;
+    }
+    return n;
+}
+
+// Number of bytes waiting in the input buffer.
+size_t uart_rx_any(void) {
+    return ringbuf_avail(&input_buf);
+}
+
+// Replaces the input buffer with buf, keeping what is pending in the old one
+// as far as it fits.  len must be at least 2, and at most 0xffff.
+void uart_set_rxbuf(uint8 *buf, size_t len) {
+    if (buf == input_buf.buf) {
+        return;
+    }
+    ETS_UART_INTR_DISABLE();
+    ringbuf_t new_buf = {buf, len, 0, 0};
+    int c;
+    while ((c = ringbuf_get(&input_buf)) >= 0) {
+        if (ringbuf_put(&new_buf, c) < 0) {
+            break;
+        }
+    }
+    input_buf = new_buf;
+    ETS_UART_INTR_ENABLE();
+}
+
 int uart_rx_one_char(uint8 uart_no) {
     if (READ_PERI_REG(UART_STATUS(uart_no)) & (UART_RXFIFO_CNT << UART_RXFIFO_CNT_S)) {
         return READ_PERI_REG(UART_FIFO(uart_no)) & 0xff;
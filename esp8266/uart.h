@@ -1,6 +1,7 @@
 #ifndef _INCLUDED_UART_H_
 #define _INCLUDED_UART_H_
 
+#include <stddef.h>
 #include <eagle_soc.h>
 
 #define UART0 (0)
@@ -95,6 +96,9 @@ void uart_init(UartBautRate uart0_br, UartBautRate uart1_br);
 int uart0_rx(void);
 bool uart_rx_wait(uint32_t timeout_us);
 int uart_rx_char(void);
+size_t uart_rx_chars(uint8 *buf, size_t len);
+size_t uart_rx_any(void);
+void uart_set_rxbuf(uint8 *buf, size_t len);
 void uart_tx_one_char(uint8 uart, uint8 TxChar);
 void uart_flush(uint8 uart);
 void uart_os_config(int uart);
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/mpconfig.h"
+#include "etshal.h"
+#include "extmod/moduhashlib.h"
+
+#if MICROPY_PY_UHASHLIB
+
+// The ESP8266 ROM contains SHA1 and MD5 implementations, so use them for
+// uhashlib instead of compiling in the portable C versions.
+
+// state[5], count[2], buffer[64] of the ROM's SHA1 context
+#define ROM_SHA1_CTX_SIZE (92)
+
+#if MICROPY_PY_UHASHLIB_SHA1
+STATIC void rom_sha1_final(void *ctx, uint8_t *digest) {
+    SHA1Final(digest, ctx);
+}
+
+const mp_uhashlib_impl_t esp_rom_sha1_impl = {
+    .ctx_size = ROM_SHA1_CTX_SIZE,
+    .digest_size = 20,
+    .init = SHA1Init,
+    .update = (void(*)(void*, const uint8_t*, size_t))SHA1Update,
+    .final = rom_sha1_final,
+};
+#endif
+
+#if MICROPY_PY_UHASHLIB_MD5
+STATIC void rom_md5_final(void *ctx, uint8_t *digest) {
+    MD5Final(digest, ctx);
+}
+
+const mp_uhashlib_impl_t esp_rom_md5_impl = {
+    .ctx_size = sizeof(MD5_CTX),
+    .digest_size = 16,
+    .init = (void(*)(void*))MD5Init,
+    .update = (void(*)(void*, const uint8_t*, size_t))MD5Update,
+    .final = rom_md5_final,
+};
+#endif
+
+#endif // MICROPY_PY_UHASHLIB
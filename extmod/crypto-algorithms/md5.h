@@ -0,0 +1,31 @@
+/*********************************************************************
+* Filename:   md5.h
+* Copyright:
+* Disclaimer: This code is presented "as is" without any guarantees.
+* Details:    Defines the API for the corresponding MD5 implementation.
+*********************************************************************/
+
+#ifndef MD5_H
+#define MD5_H
+
+/*************************** HEADER FILES ***************************/
+#include <stddef.h>
+#include "sha256.h"
+
+/****************************** MACROS ******************************/
+#define MD5_BLOCK_SIZE 16               // MD5 outputs a 16 byte digest
+
+/**************************** DATA TYPES ****************************/
+typedef struct {
+	BYTE data[64];
+	WORD datalen;
+	unsigned long long bitlen;
+	WORD state[4];
+} CRYAL_MD5_CTX;
+
+/*********************** FUNCTION DECLARATIONS **********************/
+void md5_init(CRYAL_MD5_CTX *ctx);
+void md5_update(CRYAL_MD5_CTX *ctx, const BYTE data[], size_t len);
+void md5_final(CRYAL_MD5_CTX *ctx, BYTE hash[]);
+
+#endif   // MD5_H
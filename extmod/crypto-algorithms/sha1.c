@@ -0,0 +1,143 @@
+/*********************************************************************
+* Filename:   sha1.c
+* Copyright:
+* Disclaimer: This code is presented "as is" without any guarantees.
+* Details:    Implementation of the SHA1 hashing algorithm.
+              Algorithm specification can be found here:
+               * http://csrc.nist.gov/publications/fips/fips180-2/fips180-2withchangenotice.pdf
+              This implementation uses little endian byte order.
+*********************************************************************/
+
+/*************************** HEADER FILES ***************************/
+#include <stdlib.h>
+#include <memory.h>
+#include "sha1.h"
+
+/****************************** MACROS ******************************/
+#define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+static void sha1_transform(CRYAL_SHA1_CTX *ctx, const BYTE data[])
+{
+	WORD a, b, c, d, e, i, m[16];
+
+	// The message schedule is kept in a 16 word circular buffer, and the
+	// rounds are unrolled by 5 so the working variables never get shuffled.
+#define W0(i) (m[i] = ((WORD)data[(i) * 4] << 24) | ((WORD)data[(i) * 4 + 1] << 16) | ((WORD)data[(i) * 4 + 2] << 8) | data[(i) * 4 + 3])
+#define W(i) (m[(i) & 15] = ROTLEFT(m[((i) - 3) & 15] ^ m[((i) - 8) & 15] ^ m[((i) - 14) & 15] ^ m[(i) & 15], 1))
+#define R0(a,b,c,d,e,i,w) e += ((b & (c ^ d)) ^ d) + (w) + 0x5a827999 + ROTLEFT(a,5); b = ROTLEFT(b,30)
+#define R1(a,b,c,d,e,i,w) e += (b ^ c ^ d) + (w) + 0x6ed9eba1 + ROTLEFT(a,5); b = ROTLEFT(b,30)
+#define R2(a,b,c,d,e,i,w) e += (((b | c) & d) | (b & c)) + (w) + 0x8f1bbcdc + ROTLEFT(a,5); b = ROTLEFT(b,30)
+#define R3(a,b,c,d,e,i,w) e += (b ^ c ^ d) + (w) + 0xca62c1d6 + ROTLEFT(a,5); b = ROTLEFT(b,30)
+#define R5(r,w) \
+	r(a,b,c,d,e,i,w(i)); \
+	r(e,a,b,c,d,i + 1,w(i + 1)); \
+	r(d,e,a,b,c,i + 2,w(i + 2)); \
+	r(c,d,e,a,b,i + 3,w(i + 3)); \
+	r(b,c,d,e,a,i + 4,w(i + 4))
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+
+	for (i = 0; i < 15; i += 5) {
+		R5(R0, W0);
+	}
+	R0(a,b,c,d,e,15,W0(15));
+	R0(e,a,b,c,d,16,W(16));
+	R0(d,e,a,b,c,17,W(17));
+	R0(c,d,e,a,b,18,W(18));
+	R0(b,c,d,e,a,19,W(19));
+	for (i = 20; i < 40; i += 5) {
+		R5(R1, W);
+	}
+	for (; i < 60; i += 5) {
+		R5(R2, W);
+	}
+	for (; i < 80; i += 5) {
+		R5(R3, W);
+	}
+
+#undef W0
+#undef W
+#undef R0
+#undef R1
+#undef R2
+#undef R3
+#undef R5
+
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+}
+
+void sha1_init(CRYAL_SHA1_CTX *ctx)
+{
+	ctx->datalen = 0;
+	ctx->bitlen = 0;
+	ctx->state[0] = 0x67452301;
+	ctx->state[1] = 0xefcdab89;
+	ctx->state[2] = 0x98badcfe;
+	ctx->state[3] = 0x10325476;
+	ctx->state[4] = 0xc3d2e1f0;
+}
+
+void sha1_update(CRYAL_SHA1_CTX *ctx, const BYTE data[], size_t len)
+{
+	size_t n;
+
+	while (len > 0) {
+		if (ctx->datalen == 0 && len >= 64) {
+			// whole blocks are hashed straight from the input
+			sha1_transform(ctx, data);
+			n = 64;
+		} else {
+			n = 64 - ctx->datalen;
+			if (n > len)
+				n = len;
+			memcpy(ctx->data + ctx->datalen, data, n);
+			ctx->datalen += n;
+			if (ctx->datalen < 64)
+				break;
+			sha1_transform(ctx, ctx->data);
+			ctx->datalen = 0;
+		}
+		ctx->bitlen += 512;
+		data += n;
+		len -= n;
+	}
+}
+
+void sha1_final(CRYAL_SHA1_CTX *ctx, BYTE hash[])
+{
+	WORD i;
+
+	i = ctx->datalen;
+
+	// Pad whatever data is left in the buffer.
+	ctx->data[i++] = 0x80;
+	if (i > 56) {
+		memset(ctx->data + i, 0, 64 - i);
+		sha1_transform(ctx, ctx->data);
+		i = 0;
+	}
+	memset(ctx->data + i, 0, 56 - i);
+
+	// Append to the padding the total message's length in bits and transform.
+	ctx->bitlen += ctx->datalen * 8;
+	for (i = 0; i < 8; ++i)
+		ctx->data[63 - i] = ctx->bitlen >> (i * 8);
+	sha1_transform(ctx, ctx->data);
+
+	// SHA uses big endian, so reverse the bytes of each state word.
+	for (i = 0; i < 5; ++i) {
+		hash[i * 4]     = ctx->state[i] >> 24;
+		hash[i * 4 + 1] = ctx->state[i] >> 16;
+		hash[i * 4 + 2] = ctx->state[i] >> 8;
+		hash[i * 4 + 3] = ctx->state[i];
+	}
+}
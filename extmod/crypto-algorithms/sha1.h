@@ -0,0 +1,31 @@
+/*********************************************************************
+* Filename:   sha1.h
+* Copyright:
+* Disclaimer: This code is presented "as is" without any guarantees.
+* Details:    Defines the API for the corresponding SHA1 implementation.
+*********************************************************************/
+
+#ifndef SHA1_H
+#define SHA1_H
+
+/*************************** HEADER FILES ***************************/
+#include <stddef.h>
+#include "sha256.h"
+
+/****************************** MACROS ******************************/
+#define SHA1_BLOCK_SIZE 20              // SHA1 outputs a 20 byte digest
+
+/**************************** DATA TYPES ****************************/
+typedef struct {
+	BYTE data[64];
+	WORD datalen;
+	unsigned long long bitlen;
+	WORD state[5];
+} CRYAL_SHA1_CTX;
+
+/*********************** FUNCTION DECLARATIONS **********************/
+void sha1_init(CRYAL_SHA1_CTX *ctx);
+void sha1_update(CRYAL_SHA1_CTX *ctx, const BYTE data[], size_t len);
+void sha1_final(CRYAL_SHA1_CTX *ctx, BYTE hash[]);
+
+#endif   // SHA1_H
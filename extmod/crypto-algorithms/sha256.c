@@ -43,12 +43,25 @@ static const WORD k[64] = {
 /*********************** FUNCTION DEFINITIONS ***********************/
 static void sha256_transform(CRYAL_SHA256_CTX *ctx, const BYTE data[])
 {
-	WORD a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
-
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-	for ( ; i < 64; ++i)
-		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+	WORD a, b, c, d, e, f, g, h, i, t1, m[16];
+
+	// The message schedule is kept in a 16 word circular buffer, and the
+	// rounds are unrolled by 8 so the working variables never get shuffled.
+#define W0(i) (m[i] = ((WORD)data[(i) * 4] << 24) | ((WORD)data[(i) * 4 + 1] << 16) | ((WORD)data[(i) * 4 + 2] << 8) | data[(i) * 4 + 3])
+#define W(i) (m[(i) & 15] += SIG1(m[((i) - 2) & 15]) + m[((i) - 7) & 15] + SIG0(m[((i) - 15) & 15]))
+#define R(a,b,c,d,e,f,g,h,i,w) \
+	t1 = h + EP1(e) + CH(e,f,g) + k[i] + (w); \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c)
+#define R8(w) \
+	R(a,b,c,d,e,f,g,h,i,w(i)); \
+	R(h,a,b,c,d,e,f,g,i + 1,w(i + 1)); \
+	R(g,h,a,b,c,d,e,f,i + 2,w(i + 2)); \
+	R(f,g,h,a,b,c,d,e,i + 3,w(i + 3)); \
+	R(e,f,g,h,a,b,c,d,i + 4,w(i + 4)); \
+	R(d,e,f,g,h,a,b,c,i + 5,w(i + 5)); \
+	R(c,d,e,f,g,h,a,b,i + 6,w(i + 6)); \
+	R(b,c,d,e,f,g,h,a,i + 7,w(i + 7))
 
 	a = ctx->state[0];
 	b = ctx->state[1];
@@ -59,19 +72,18 @@ static void sha256_transform(CRYAL_SHA256_CTX *ctx, const BYTE data[])
 	g = ctx->state[6];
 	h = ctx->state[7];
 
-	for (i = 0; i < 64; ++i) {
-		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-		t2 = EP0(a) + MAJ(a,b,c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + t2;
+	for (i = 0; i < 16; i += 8) {
+		R8(W0);
+	}
+	for (; i < 64; i += 8) {
+		R8(W);
 	}
 
+#undef W0
+#undef W
+#undef R
+#undef R8
+
 	ctx->state[0] += a;
 	ctx->state[1] += b;
 	ctx->state[2] += c;
@@ -98,16 +110,27 @@ void sha256_init(CRYAL_SHA256_CTX *ctx)
 
 void sha256_update(CRYAL_SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
-
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64) {
+	size_t n;
+
+	while (len > 0) {
+		if (ctx->datalen == 0 && len >= 64) {
+			// whole blocks are hashed straight from the input
+			sha256_transform(ctx, data);
+			n = 64;
+		} else {
+			n = 64 - ctx->datalen;
+			if (n > len)
+				n = len;
+			memcpy(ctx->data + ctx->datalen, data, n);
+			ctx->datalen += n;
+			if (ctx->datalen < 64)
+				break;
 			sha256_transform(ctx, ctx->data);
-			ctx->bitlen += 512;
 			ctx->datalen = 0;
 		}
+		ctx->bitlen += 512;
+		data += n;
+		len -= n;
 	}
 }
 
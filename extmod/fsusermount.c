@@ -32,6 +32,7 @@
 #include "py/nlr.h"
 #include "py/runtime.h"
 #include "py/mperrno.h"
+#include "py/objtype.h"
 #include "lib/fatfs/ff.h"
 #include "extmod/fsusermount.h"
 
@@ -41,6 +42,10 @@ fs_user_mount_t *fatfs_mount_mkfs(mp_uint_t n_args, const mp_obj_t *pos_args, mp
         { MP_QSTR_mkfs, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
     };
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    fat_vfs_import_cache_clear();
+    #endif
+
     // parse args
     mp_obj_t device = pos_args[0];
     mp_obj_t mount_point = pos_args[1];
@@ -99,6 +104,11 @@ fs_user_mount_t *fatfs_mount_mkfs(mp_uint_t n_args, const mp_obj_t *pos_args, mp
             mp_load_method_maybe(device, MP_QSTR_sync, vfs->u.old.sync);
             mp_load_method(device, MP_QSTR_count, vfs->u.old.count);
         }
+        const mp_obj_type_t *device_type = mp_obj_get_type(device);
+        if (mp_obj_is_native_type(device_type) && device_type->protocol != NULL) {
+            // device implements the block protocol at the C level
+            vfs->flags |= FSUSER_NATIVE_OBJ;
+        }
 
         // Read-only device indicated by writeblocks[0] == MP_OBJ_NULL.
         // User can specify read-only device by:
@@ -187,6 +197,10 @@ mp_obj_t fatfs_umount(mp_obj_t bdev_or_path_in) {
         mp_raise_OSError(MP_EINVAL);
     }
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    fat_vfs_import_cache_clear();
+    #endif
+
     fs_user_mount_t *vfs = MP_STATE_PORT(fs_user_mount)[i];
     FRESULT res = f_mount(NULL, vfs->str, 0);
     if (vfs->flags & FSUSER_FREE_OBJ) {
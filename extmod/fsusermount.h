@@ -26,6 +26,7 @@
 
 #include "lib/fatfs/ff.h"
 #include "py/obj.h"
+#include "py/lexer.h"
 
 // these are the values for fs_user_mount_t.flags
 #define FSUSER_NATIVE        (0x0001) // readblocks[2]/writeblocks[2] contain native func
@@ -33,6 +34,7 @@
 #define FSUSER_HAVE_IOCTL    (0x0004) // new protocol with ioctl
 // Device is write-able over USB and read-only to MicroPython.
 #define FSUSER_USB_WRITEABLE (0x0008)
+#define FSUSER_NATIVE_OBJ    (0x0010) // device's type has mp_block_dev_p_t as its protocol
 
 // constants for block protocol ioctl
 #define BP_IOCTL_INIT           (1)
@@ -40,6 +42,18 @@
 #define BP_IOCTL_SYNC           (3)
 #define BP_IOCTL_SEC_COUNT      (4)
 #define BP_IOCTL_SEC_SIZE       (5)
+#define BP_IOCTL_BLOCK_SIZE     (6) // erase block size, in sectors
+#define BP_IOCTL_BLOCK_ERASE    (7) // erase the block given by arg (raw flash)
+
+// C-level block protocol. A block device type implemented in C can point
+// its protocol slot at one of these, and the FAT driver then calls it
+// directly rather than through the readblocks/writeblocks methods, with no
+// interpreter call or buffer object per request. num_blocks can be more
+// than 1 for contiguous requests. The functions return 0 on success.
+typedef struct _mp_block_dev_p_t {
+    mp_uint_t (*readblocks)(mp_obj_t self, uint8_t *buf, uint32_t block_num, uint32_t num_blocks);
+    mp_uint_t (*writeblocks)(mp_obj_t self, const uint8_t *buf, uint32_t block_num, uint32_t num_blocks);
+} mp_block_dev_p_t;
 
 typedef struct _fs_user_mount_t {
     mp_obj_base_t base;
@@ -62,6 +76,10 @@ typedef struct _fs_user_mount_t {
 fs_user_mount_t *fatfs_mount_mkfs(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, bool mkfs);
 mp_obj_t fatfs_umount(mp_obj_t bdev_or_path_in);
 
+mp_import_stat_t fat_vfs_import_stat(const char *path);
+// Drops the directory listings kept for imports by fat_vfs_import_stat.
+void fat_vfs_import_cache_clear(void);
+
 MP_DECLARE_CONST_FUN_OBJ_KW(fsuser_mount_obj);
 MP_DECLARE_CONST_FUN_OBJ_1(fsuser_umount_obj);
 MP_DECLARE_CONST_FUN_OBJ_KW(fsuser_mkfs_obj);
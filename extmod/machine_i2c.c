@@ -30,37 +30,49 @@
 
 #include "py/mphal.h"
 #include "py/runtime.h"
+#include "py/mperrno.h"
 #include "extmod/machine_i2c.h"
 
 #if MICROPY_PY_MACHINE_I2C
 
-// Clock stretching limit, so that we don't get stuck.
+// Default clock stretching limit in microseconds, so that we don't get stuck.
 #define I2C_STRETCH_LIMIT 255
 
 typedef struct _machine_i2c_obj_t {
     mp_obj_base_t base;
     uint32_t us_delay;
+    uint32_t us_timeout;
     mp_hal_pin_obj_t scl;
     mp_hal_pin_obj_t sda;
 } machine_i2c_obj_t;
 
 STATIC void mp_hal_i2c_delay(machine_i2c_obj_t *self) {
     // We need to use an accurate delay to get acceptable I2C
-    // speeds (eg 1us should be not much more than 1us).
-    mp_hal_delay_us_fast(self->us_delay);
+    // speeds (eg 1us should be not much more than 1us).  A delay of
+    // zero means run as fast as the pins can be toggled.
+    if (self->us_delay != 0) {
+        mp_hal_delay_us_fast(self->us_delay);
+    }
 }
 
 STATIC void mp_hal_i2c_scl_low(machine_i2c_obj_t *self) {
     mp_hal_pin_od_low(self->scl);
 }
 
-STATIC void mp_hal_i2c_scl_release(machine_i2c_obj_t *self) {
+// returns 0 once SCL is high, or -MP_ETIMEDOUT if a slave stretched the
+// clock for longer than the configured timeout
+STATIC int mp_hal_i2c_scl_release(machine_i2c_obj_t *self) {
+    uint32_t count = self->us_timeout;
     mp_hal_pin_od_high(self->scl);
     mp_hal_i2c_delay(self);
     // For clock stretching, wait for the SCL pin to be released, with timeout.
-    for (int count = I2C_STRETCH_LIMIT; mp_hal_pin_read(self->scl) == 0 && count; --count) {
+    for (; mp_hal_pin_read(self->scl) == 0 && count; --count) {
         mp_hal_delay_us_fast(1);
     }
+    if (count == 0 && mp_hal_pin_read(self->scl) == 0) {
+        return -MP_ETIMEDOUT;
+    }
+    return 0; // success
 }
 
 STATIC void mp_hal_i2c_sda_low(machine_i2c_obj_t *self) {
@@ -75,33 +87,40 @@ STATIC int mp_hal_i2c_sda_read(machine_i2c_obj_t *self) {
     return mp_hal_pin_read(self->sda);
 }
 
-STATIC void mp_hal_i2c_start(machine_i2c_obj_t *self) {
+// returns 0 on success, or a negative errno on timeout
+STATIC int mp_hal_i2c_start(machine_i2c_obj_t *self) {
     mp_hal_i2c_sda_release(self);
     mp_hal_i2c_delay(self);
-    mp_hal_i2c_scl_release(self);
+    int ret = mp_hal_i2c_scl_release(self);
+    if (ret != 0) {
+        return ret;
+    }
     mp_hal_i2c_sda_low(self);
     mp_hal_i2c_delay(self);
+    return 0;
 }
 
-STATIC void mp_hal_i2c_stop(machine_i2c_obj_t *self) {
+// returns 0 on success, or a negative errno on timeout; SDA is always released
+STATIC int mp_hal_i2c_stop(machine_i2c_obj_t *self) {
     mp_hal_i2c_delay(self);
     mp_hal_i2c_sda_low(self);
     mp_hal_i2c_delay(self);
-    mp_hal_i2c_scl_release(self);
+    int ret = mp_hal_i2c_scl_release(self);
     mp_hal_i2c_sda_release(self);
     mp_hal_i2c_delay(self);
+    return ret;
 }
 
 STATIC void mp_hal_i2c_init(machine_i2c_obj_t *self, uint32_t freq) {
+    // frequencies above 500kHz give a zero delay: the bus then runs at
+    // whatever speed the port's pin functions allow
     self->us_delay = 500000 / freq;
-    if (self->us_delay == 0) {
-        self->us_delay = 1;
-    }
     mp_hal_pin_open_drain(self->scl);
     mp_hal_pin_open_drain(self->sda);
     mp_hal_i2c_stop(self);
 }
 
+// returns 1 if the byte was ACKed, 0 if NACKed, or a negative errno on timeout
 STATIC int mp_hal_i2c_write_byte(machine_i2c_obj_t *self, uint8_t val) {
     mp_hal_i2c_delay(self);
     mp_hal_i2c_scl_low(self);
@@ -113,21 +132,29 @@ STATIC int mp_hal_i2c_write_byte(machine_i2c_obj_t *self, uint8_t val) {
             mp_hal_i2c_sda_low(self);
         }
         mp_hal_i2c_delay(self);
-        mp_hal_i2c_scl_release(self);
+        int ret = mp_hal_i2c_scl_release(self);
+        if (ret != 0) {
+            mp_hal_i2c_sda_release(self);
+            return ret;
+        }
         mp_hal_i2c_scl_low(self);
     }
 
     mp_hal_i2c_sda_release(self);
     mp_hal_i2c_delay(self);
-    mp_hal_i2c_scl_release(self);
+    int ret = mp_hal_i2c_scl_release(self);
+    if (ret != 0) {
+        return ret;
+    }
 
-    int ret = mp_hal_i2c_sda_read(self);
+    ret = mp_hal_i2c_sda_read(self);
     mp_hal_i2c_delay(self);
     mp_hal_i2c_scl_low(self);
 
     return !ret;
 }
 
+// returns 0 on success, or a negative errno on timeout
 STATIC int mp_hal_i2c_read_byte(machine_i2c_obj_t *self, uint8_t *val, int nack) {
     mp_hal_i2c_delay(self);
     mp_hal_i2c_scl_low(self);
@@ -135,7 +162,10 @@ STATIC int mp_hal_i2c_read_byte(machine_i2c_obj_t *self, uint8_t *val, int nack)
 
     uint8_t data = 0;
     for (int i = 7; i >= 0; i--) {
-        mp_hal_i2c_scl_release(self);
+        int ret = mp_hal_i2c_scl_release(self);
+        if (ret != 0) {
+            return ret;
+        }
         data = (data << 1) | mp_hal_i2c_sda_read(self);
         mp_hal_i2c_scl_low(self);
         mp_hal_i2c_delay(self);
@@ -147,22 +177,33 @@ STATIC int mp_hal_i2c_read_byte(machine_i2c_obj_t *self, uint8_t *val, int nack)
         mp_hal_i2c_sda_low(self);
     }
     mp_hal_i2c_delay(self);
-    mp_hal_i2c_scl_release(self);
+    int ret = mp_hal_i2c_scl_release(self);
     mp_hal_i2c_scl_low(self);
     mp_hal_i2c_sda_release(self);
 
-    return 1; // success
+    return ret;
+}
+
+// ret is the negative errno from a timeout, or 0 for a NACK
+STATIC NORETURN void mp_hal_i2c_raise(int ret) {
+    if (ret < 0) {
+        mp_raise_OSError(-ret);
+    }
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
 }
 
 // addr is the device address, memaddr is a memory address sent big-endian
+// returns 1 on success, 0 on NACK, or a negative errno on timeout
 STATIC int mp_hal_i2c_write_addresses(machine_i2c_obj_t *self, uint8_t addr,
         uint32_t memaddr, uint8_t addrsize) {
-    if (!mp_hal_i2c_write_byte(self, addr << 1)) {
-        return 0; // error
+    int ret = mp_hal_i2c_write_byte(self, addr << 1);
+    if (ret != 1) {
+        return ret; // error
     }
     for (int16_t i = addrsize - 8; i >= 0; i -= 8) {
-        if (!mp_hal_i2c_write_byte(self, memaddr >> i)) {
-            return 0; // error
+        ret = mp_hal_i2c_write_byte(self, memaddr >> i);
+        if (ret != 1) {
+            return ret; // error
         }
     }
     return 1; // success
@@ -171,58 +212,78 @@ STATIC int mp_hal_i2c_write_addresses(machine_i2c_obj_t *self, uint8_t addr,
 STATIC void mp_hal_i2c_write_mem(machine_i2c_obj_t *self, uint8_t addr,
         uint32_t memaddr, uint8_t addrsize, const uint8_t *src, size_t len) {
     // start the I2C transaction
-    mp_hal_i2c_start(self);
+    int ret = mp_hal_i2c_start(self);
+    if (ret != 0) {
+        goto er;
+    }
 
     // write the slave address and the memory address within the slave
-    if (!mp_hal_i2c_write_addresses(self, addr, memaddr, addrsize)) {
+    ret = mp_hal_i2c_write_addresses(self, addr, memaddr, addrsize);
+    if (ret != 1) {
         goto er;
     }
 
     // write the buffer to the I2C memory
     while (len--) {
-        if (!mp_hal_i2c_write_byte(self, *src++)) {
+        ret = mp_hal_i2c_write_byte(self, *src++);
+        if (ret != 1) {
             goto er;
         }
     }
 
     // finish the I2C transaction
-    mp_hal_i2c_stop(self);
+    ret = mp_hal_i2c_stop(self);
+    if (ret != 0) {
+        mp_hal_i2c_raise(ret);
+    }
     return;
 
 er:
     mp_hal_i2c_stop(self);
-    nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+    mp_hal_i2c_raise(ret);
 }
 
 STATIC void mp_hal_i2c_read_mem(machine_i2c_obj_t *self, uint8_t addr,
         uint32_t memaddr, uint8_t addrsize, uint8_t *dest, size_t len) {
     // start the I2C transaction
-    mp_hal_i2c_start(self);
+    int ret = mp_hal_i2c_start(self);
+    if (ret != 0) {
+        goto er;
+    }
 
     if (addrsize) {
         // write the slave address and the memory address within the slave
-        if (!mp_hal_i2c_write_addresses(self, addr, memaddr, addrsize)) {
+        ret = mp_hal_i2c_write_addresses(self, addr, memaddr, addrsize);
+        if (ret != 1) {
             goto er;
         }
 
         // i2c_read will do a repeated start, and then read the I2C memory
-        mp_hal_i2c_start(self);
+        ret = mp_hal_i2c_start(self);
+        if (ret != 0) {
+            goto er;
+        }
     }
 
-    if (!mp_hal_i2c_write_byte(self, (addr << 1) | 1)) {
+    ret = mp_hal_i2c_write_byte(self, (addr << 1) | 1);
+    if (ret != 1) {
         goto er;
     }
     while (len--) {
-        if (!mp_hal_i2c_read_byte(self, dest++, len == 0)) {
+        ret = mp_hal_i2c_read_byte(self, dest++, len == 0);
+        if (ret != 0) {
             goto er;
         }
     }
-    mp_hal_i2c_stop(self);
+    ret = mp_hal_i2c_stop(self);
+    if (ret != 0) {
+        mp_hal_i2c_raise(ret);
+    }
     return;
 
 er:
     mp_hal_i2c_stop(self);
-    nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+    mp_hal_i2c_raise(ret);
 }
 
 STATIC void mp_hal_i2c_write(machine_i2c_obj_t *self, uint8_t addr, const uint8_t *src, size_t len) {
@@ -237,16 +298,18 @@ STATIC void mp_hal_i2c_read(machine_i2c_obj_t *self, uint8_t addr, uint8_t *dest
 // MicroPython bindings for I2C
 
 STATIC void machine_i2c_obj_init_helper(machine_i2c_obj_t *self, mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_scl, ARG_sda, ARG_freq };
+    enum { ARG_scl, ARG_sda, ARG_freq, ARG_timeout };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_scl, MP_ARG_REQUIRED | MP_ARG_OBJ },
         { MP_QSTR_sda, MP_ARG_REQUIRED | MP_ARG_OBJ },
         { MP_QSTR_freq, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 400000} },
+        { MP_QSTR_timeout, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = I2C_STRETCH_LIMIT} },
     };
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
     self->scl = mp_hal_get_pin_obj(args[ARG_scl].u_obj);
     self->sda = mp_hal_get_pin_obj(args[ARG_sda].u_obj);
+    self->us_timeout = args[ARG_timeout].u_int;
     mp_hal_i2c_init(self, args[ARG_freq].u_int);
 }
 
@@ -271,12 +334,18 @@ STATIC mp_obj_t machine_i2c_scan(mp_obj_t self_in) {
     mp_obj_t list = mp_obj_new_list(0, NULL);
     // 7-bit addresses 0b0000xxx and 0b1111xxx are reserved
     for (int addr = 0x08; addr < 0x78; ++addr) {
-        mp_hal_i2c_start(self);
-        int ack = mp_hal_i2c_write_byte(self, (addr << 1));
-        if (ack) {
+        int ret = mp_hal_i2c_start(self);
+        if (ret == 0) {
+            ret = mp_hal_i2c_write_byte(self, (addr << 1));
+        }
+        if (ret == 1) {
             mp_obj_list_append(list, MP_OBJ_NEW_SMALL_INT(addr));
         }
         mp_hal_i2c_stop(self);
+        if (ret < 0) {
+            // the bus is held low, so no point probing any further
+            mp_hal_i2c_raise(ret);
+        }
     }
     return list;
 }
@@ -284,14 +353,20 @@ MP_DEFINE_CONST_FUN_OBJ_1(machine_i2c_scan_obj, machine_i2c_scan);
 
 STATIC mp_obj_t machine_i2c_start(mp_obj_t self_in) {
     machine_i2c_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_hal_i2c_start(self);
+    int ret = mp_hal_i2c_start(self);
+    if (ret != 0) {
+        mp_hal_i2c_raise(ret);
+    }
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_1(machine_i2c_start_obj, machine_i2c_start);
 
 STATIC mp_obj_t machine_i2c_stop(mp_obj_t self_in) {
     machine_i2c_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_hal_i2c_stop(self);
+    int ret = mp_hal_i2c_stop(self);
+    if (ret != 0) {
+        mp_hal_i2c_raise(ret);
+    }
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_1(machine_i2c_stop_obj, machine_i2c_stop);
@@ -306,8 +381,9 @@ STATIC mp_obj_t machine_i2c_readinto(mp_obj_t self_in, mp_obj_t buf_in) {
     // do the read
     uint8_t *dest = bufinfo.buf;
     while (bufinfo.len--) {
-        if (!mp_hal_i2c_read_byte(self, dest++, bufinfo.len == 0)) {
-            nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+        int ret = mp_hal_i2c_read_byte(self, dest++, bufinfo.len == 0);
+        if (ret != 0) {
+            mp_hal_i2c_raise(ret);
         }
     }
 
@@ -325,8 +401,9 @@ STATIC mp_obj_t machine_i2c_write(mp_obj_t self_in, mp_obj_t buf_in) {
     // do the write
     uint8_t *src = bufinfo.buf;
     while (bufinfo.len--) {
-        if (!mp_hal_i2c_write_byte(self, *src++)) {
-            nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+        int ret = mp_hal_i2c_write_byte(self, *src++);
+        if (ret != 1) {
+            mp_hal_i2c_raise(ret);
         }
     }
 
@@ -33,6 +33,8 @@
 #include "py/runtime.h"
 #include "py/runtime0.h"
 #include "py/stream.h"
+#include "py/gc.h"
+#include "py/objarray.h"
 
 #if MICROPY_PY_BTREE
 
@@ -44,8 +46,14 @@ typedef struct _mp_obj_btree_t {
     DB *db;
     mp_obj_t start_key;
     mp_obj_t end_key;
+    // with FLAG_REUSE, iteration returns these same objects every time
+    mp_obj_t key_buf;
+    mp_obj_t val_buf;
+    mp_obj_t pair;
     #define FLAG_END_KEY_INCL 1
     #define FLAG_DESC 2
+    #define FLAG_PREFIX 4
+    #define FLAG_REUSE 8
     #define FLAG_ITER_TYPE_MASK 0xc0
     #define FLAG_ITER_KEYS   0x40
     #define FLAG_ITER_VALUES 0x80
@@ -54,6 +62,11 @@ typedef struct _mp_obj_btree_t {
     byte next_flags;
 } mp_obj_btree_t;
 
+// With cachesize=0, the page cache is sized to this fraction of the free
+// heap, up to the given maximum, so that most puts only touch cached pages.
+#define BTREE_AUTO_CACHE_DIV (8)
+#define BTREE_AUTO_CACHE_MAX (64 * 1024)
+
 STATIC const mp_obj_type_t btree_type;
 
 #define CHECK_ERROR(res) \
@@ -71,6 +84,9 @@ STATIC mp_obj_btree_t *btree_new(DB *db) {
     o->db = db;
     o->start_key = mp_const_none;
     o->end_key = mp_const_none;
+    o->key_buf = MP_OBJ_NULL;
+    o->val_buf = MP_OBJ_NULL;
+    o->pair = MP_OBJ_NULL;
     o->next_flags = 0;
     return o;
 }
@@ -87,6 +103,40 @@ STATIC mp_obj_t btree_close(mp_obj_t self_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(btree_close_obj, btree_close);
 
+// Dirty pages are kept in the cache until they are evicted, so a series of
+// puts followed by flush() writes each changed page once.
+STATIC mp_obj_t btree_flush(mp_obj_t self_in) {
+    mp_obj_btree_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(__bt_sync(self->db, 0));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(btree_flush_obj, btree_flush);
+
+// Store all (key, value) pairs from an iterable and then flush. If the keys
+// come in ascending order, each put takes the fast path appending to the last
+// leaf, and when that leaf is full it is split by starting a new page rather
+// than halving it, so the leaves end up fully packed.
+STATIC mp_obj_t btree_load(mp_obj_t self_in, mp_obj_t iterable) {
+    mp_obj_btree_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t iter = mp_getiter(iterable);
+    mp_obj_t item;
+    while ((item = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+        mp_obj_t *kv;
+        mp_obj_get_array_fixed_n(item, 2, &kv);
+        DBT key, val;
+        // Different ports may have different type sizes
+        mp_uint_t v;
+        key.data = (void*)mp_obj_str_get_data(kv[0], &v);
+        key.size = v;
+        val.data = (void*)mp_obj_str_get_data(kv[1], &v);
+        val.size = v;
+        int res = __bt_put(self->db, &key, &val, 0);
+        CHECK_ERROR(res);
+    }
+    CHECK_ERROR(__bt_sync(self->db, 0));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(btree_load_obj, btree_load);
+
 STATIC mp_obj_t btree_put(size_t n_args, const mp_obj_t *args) {
     (void)n_args;
     mp_obj_btree_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -160,9 +210,31 @@ STATIC mp_obj_t btree_init_iter(size_t n_args, const mp_obj_t *args, byte type)
             }
         }
     }
+    if (self->next_flags & FLAG_PREFIX) {
+        // the start key is the prefix, and the scan ends where it stops matching
+        self->end_key = self->start_key;
+    }
     return args[0];
 }
 
+// Copy an item into the reused bytearray in *slot, growing it if needed.
+STATIC mp_obj_t btree_reuse_bytes(mp_obj_t *slot, const DBT *dbt) {
+    if (*slot == MP_OBJ_NULL) {
+        *slot = mp_obj_new_bytearray(dbt->size, dbt->data);
+        return *slot;
+    }
+    mp_obj_array_t *o = MP_OBJ_TO_PTR(*slot);
+    size_t alloc = o->len + o->free;
+    if (dbt->size > alloc) {
+        o->items = m_renew(byte, o->items, alloc, dbt->size);
+        alloc = dbt->size;
+    }
+    memcpy(o->items, dbt->data, dbt->size);
+    o->len = dbt->size;
+    o->free = alloc - dbt->size;
+    return *slot;
+}
+
 STATIC mp_obj_t btree_keys(size_t n_args, const mp_obj_t *args) {
     return btree_init_iter(n_args, args, FLAG_ITER_KEYS);
 }
@@ -226,13 +298,18 @@ STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
         DBT end_key;
         end_key.data = (void*)mp_obj_str_get_data(self->end_key, &v);
         end_key.size = v;
-        BTREE *t = self->db->internal;
-        int cmp = t->bt_cmp(&key, &end_key);
-        if (desc) {
-            cmp = -cmp;
-        }
-        if (self->flags & FLAG_END_KEY_INCL) {
-            cmp--;
+        int cmp;
+        if (self->flags & FLAG_PREFIX) {
+            cmp = key.size < end_key.size || memcmp(key.data, end_key.data, end_key.size) != 0;
+        } else {
+            BTREE *t = self->db->internal;
+            cmp = t->bt_cmp(&key, &end_key);
+            if (desc) {
+                cmp = -cmp;
+            }
+            if (self->flags & FLAG_END_KEY_INCL) {
+                cmp--;
+            }
         }
         if (cmp >= 0) {
             self->end_key = MP_OBJ_NULL;
@@ -240,6 +317,23 @@ STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
         }
     }
 
+    if (self->flags & FLAG_REUSE) {
+        switch (self->flags & FLAG_ITER_TYPE_MASK) {
+            case FLAG_ITER_KEYS:
+                return btree_reuse_bytes(&self->key_buf, &key);
+            case FLAG_ITER_VALUES:
+                return btree_reuse_bytes(&self->val_buf, &val);
+            default:
+                if (self->pair == MP_OBJ_NULL) {
+                    self->pair = mp_obj_new_tuple(2, NULL);
+                }
+                mp_obj_tuple_t *pair = MP_OBJ_TO_PTR(self->pair);
+                pair->items[0] = btree_reuse_bytes(&self->key_buf, &key);
+                pair->items[1] = btree_reuse_bytes(&self->val_buf, &val);
+                return self->pair;
+        }
+    }
+
     switch (self->flags & FLAG_ITER_TYPE_MASK) {
         case FLAG_ITER_KEYS:
             return mp_obj_new_bytes(key.data, key.size);
@@ -314,6 +408,8 @@ STATIC mp_obj_t btree_binary_op(mp_uint_t op, mp_obj_t lhs_in, mp_obj_t rhs_in)
 
 STATIC const mp_rom_map_elem_t btree_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&btree_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&btree_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&btree_load_obj) },
     { MP_ROM_QSTR(MP_QSTR_get), MP_ROM_PTR(&btree_get_obj) },
     { MP_ROM_QSTR(MP_QSTR_put), MP_ROM_PTR(&btree_put_obj) },
     { MP_ROM_QSTR(MP_QSTR_seq), MP_ROM_PTR(&btree_seq_obj) },
@@ -367,6 +463,17 @@ STATIC mp_obj_t mod_btree_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t
     openinfo.cachesize = args.cachesize.u_int;
     openinfo.psize = args.pagesize.u_int;
     openinfo.minkeypage = args.minkeypage.u_int;
+    #if MICROPY_ENABLE_GC
+    if (openinfo.cachesize == 0) {
+        gc_info_t info;
+        gc_info(&info);
+        size_t cachesize = info.free / BTREE_AUTO_CACHE_DIV;
+        if (cachesize > BTREE_AUTO_CACHE_MAX) {
+            cachesize = BTREE_AUTO_CACHE_MAX;
+        }
+        openinfo.cachesize = cachesize;
+    }
+    #endif
 
     DB *db = __bt_open(pos_args[0], &btree_stream_fvtable, &openinfo, /*dflags*/0);
     if (db == NULL) {
@@ -381,6 +488,8 @@ STATIC const mp_rom_map_elem_t mp_module_btree_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_open), MP_ROM_PTR(&mod_btree_open_obj) },
     { MP_ROM_QSTR(MP_QSTR_INCL), MP_ROM_INT(FLAG_END_KEY_INCL) },
     { MP_ROM_QSTR(MP_QSTR_DESC), MP_ROM_INT(FLAG_DESC) },
+    { MP_ROM_QSTR(MP_QSTR_PREFIX), MP_ROM_INT(FLAG_PREFIX) },
+    { MP_ROM_QSTR(MP_QSTR_REUSE), MP_ROM_INT(FLAG_REUSE) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_btree_globals, mp_module_btree_globals_table);
@@ -35,18 +35,241 @@
 
 #include "stmhal/font_petme128_8x8.h"
 
-// 1-bit frame buffer, each byte is a column of 8 pixels
-typedef struct _mp_obj_framebuf1_t {
+typedef struct _mp_obj_framebuf_t {
     mp_obj_base_t base;
-    uint8_t *buf;
+    mp_obj_t buf_obj; // so the underlying buffer isn't freed by the GC
+    void *buf;
     uint16_t width, height, stride;
-} mp_obj_framebuf1_t;
+    uint8_t format;
+    #if MICROPY_PY_FRAMEBUF_DIRTY
+    // bounding box of pixels changed since the last call to dirty(),
+    // empty when dirty_x0 >= dirty_x1
+    uint16_t dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+    #endif
+} mp_obj_framebuf_t;
 
-STATIC mp_obj_t framebuf1_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
-    mp_arg_check_num(n_args, n_kw, 3, 4, false);
+typedef void (*setpixel_t)(const mp_obj_framebuf_t*, int, int, uint32_t);
+typedef uint32_t (*getpixel_t)(const mp_obj_framebuf_t*, int, int);
+typedef void (*fill_rect_t)(const mp_obj_framebuf_t *, int, int, int, int, uint32_t);
 
-    mp_obj_framebuf1_t *o = m_new_obj(mp_obj_framebuf1_t);
+typedef struct _mp_framebuf_p_t {
+    setpixel_t setpixel;
+    getpixel_t getpixel;
+    fill_rect_t fill_rect;
+} mp_framebuf_p_t;
+
+// constants for formats
+#define FRAMEBUF_MVLSB    (0)
+#define FRAMEBUF_RGB565   (1)
+#define FRAMEBUF_GS4_HMSB (2)
+#define FRAMEBUF_MHLSB    (3)
+#define FRAMEBUF_MHMSB    (4)
+
+// Functions for MVLSB format: each byte is a column of 8 pixels, LSB at top
+
+STATIC void mvlsb_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
+    size_t index = (y >> 3) * fb->stride + x;
+    uint8_t offset = y & 0x07;
+    ((uint8_t*)fb->buf)[index] = (((uint8_t*)fb->buf)[index] & ~(0x01 << offset)) | ((col != 0) << offset);
+}
+
+STATIC uint32_t mvlsb_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
+    return (((uint8_t*)fb->buf)[(y >> 3) * fb->stride + x] >> (y & 0x07)) & 0x01;
+}
+
+STATIC void mvlsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
+    // work down in bands of 8 rows, setting the bits of a whole column at once
+    while (h > 0) {
+        int n = 8 - (y & 7);
+        if (n > h) {
+            n = h;
+        }
+        uint8_t mask = ((1 << n) - 1) << (y & 7);
+        uint8_t *b = &((uint8_t*)fb->buf)[(y >> 3) * fb->stride + x];
+        if (col) {
+            for (int i = 0; i < w; ++i) {
+                b[i] |= mask;
+            }
+        } else {
+            for (int i = 0; i < w; ++i) {
+                b[i] &= ~mask;
+            }
+        }
+        y += n;
+        h -= n;
+    }
+}
+
+// Functions for MHLSB and MHMSB formats: each byte is a row of 8 pixels,
+// with the leftmost pixel in the MSB for MHLSB and in the LSB for MHMSB
+
+STATIC void mono_horiz_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
+    size_t index = (x + y * fb->stride) >> 3;
+    int offset = fb->format == FRAMEBUF_MHMSB ? x & 0x07 : 7 - (x & 0x07);
+    ((uint8_t*)fb->buf)[index] = (((uint8_t*)fb->buf)[index] & ~(0x01 << offset)) | ((col != 0) << offset);
+}
+
+STATIC uint32_t mono_horiz_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
+    size_t index = (x + y * fb->stride) >> 3;
+    int offset = fb->format == FRAMEBUF_MHMSB ? x & 0x07 : 7 - (x & 0x07);
+    return (((uint8_t*)fb->buf)[index] >> offset) & 0x01;
+}
+
+// mask of the bits for pixels x0 <= x < x1 within one byte
+STATIC uint8_t mono_horiz_mask(const mp_obj_framebuf_t *fb, int x0, int x1) {
+    uint8_t mask = (0xff << (x0 & 7)) & (0xff >> (8 - (x1 - (x0 & ~7))));
+    if (fb->format == FRAMEBUF_MHLSB) {
+        // reverse the bits
+        mask = (mask & 0xf0) >> 4 | (mask & 0x0f) << 4;
+        mask = (mask & 0xcc) >> 2 | (mask & 0x33) << 2;
+        mask = (mask & 0xaa) >> 1 | (mask & 0x55) << 1;
+    }
+    return mask;
+}
+
+STATIC void mono_horiz_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
+    // whole bytes in the middle of each row are set with memset
+    int xend = x + w;
+    int head_end = (x + 7) & ~7;
+    if (head_end > xend) {
+        head_end = xend;
+    }
+    int tail_start = xend & ~7;
+    if (tail_start < head_end) {
+        tail_start = head_end;
+    }
+    uint8_t head_mask = head_end > x ? mono_horiz_mask(fb, x, head_end) : 0;
+    uint8_t tail_mask = xend > tail_start ? mono_horiz_mask(fb, tail_start, xend) : 0;
+    uint8_t fill = col ? 0xff : 0x00;
+    for (; h--; ++y) {
+        uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 3];
+        if (head_mask) {
+            row[x >> 3] = (row[x >> 3] & ~head_mask) | (fill & head_mask);
+        }
+        memset(row + (head_end >> 3), fill, (tail_start - head_end) >> 3);
+        if (tail_mask) {
+            row[tail_start >> 3] = (row[tail_start >> 3] & ~tail_mask) | (fill & tail_mask);
+        }
+    }
+}
+
+// Functions for RGB565 format: each pixel is a native-endian 16-bit word
+
+STATIC void rgb565_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
+    ((uint16_t*)fb->buf)[x + y * fb->stride] = col;
+}
+
+STATIC uint32_t rgb565_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
+    return ((uint16_t*)fb->buf)[x + y * fb->stride];
+}
+
+STATIC void rgb565_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
+    uint16_t *b = &((uint16_t*)fb->buf)[x + y * fb->stride];
+    while (h--) {
+        for (int ww = w; ww; --ww) {
+            *b++ = col;
+        }
+        b += fb->stride - w;
+    }
+}
+
+// Functions for GS4_HMSB format: each byte is 2 pixels, the left one in the
+// upper nibble
+
+STATIC void gs4_hmsb_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
+    uint8_t *pixel = &((uint8_t*)fb->buf)[(x + y * fb->stride) >> 1];
+    if (x & 1) {
+        *pixel = ((uint8_t)col & 0x0f) | (*pixel & 0xf0);
+    } else {
+        *pixel = ((uint8_t)col << 4) | (*pixel & 0x0f);
+    }
+}
+
+STATIC uint32_t gs4_hmsb_getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
+    uint8_t pixel = ((uint8_t*)fb->buf)[(x + y * fb->stride) >> 1];
+    if (x & 1) {
+        return pixel & 0x0f;
+    }
+    return pixel >> 4;
+}
+
+STATIC void gs4_hmsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
+    col &= 0x0f;
+    uint8_t col_pair = col | col << 4;
+    for (; h--; ++y) {
+        int xx = x;
+        int ww = w;
+        if (xx & 1) {
+            gs4_hmsb_setpixel(fb, xx++, y, col);
+            --ww;
+        }
+        memset(&((uint8_t*)fb->buf)[(xx + y * fb->stride) >> 1], col_pair, ww >> 1);
+        if (ww & 1) {
+            gs4_hmsb_setpixel(fb, xx + ww - 1, y, col);
+        }
+    }
+}
+
+STATIC mp_framebuf_p_t formats[] = {
+    [FRAMEBUF_MVLSB] = {mvlsb_setpixel, mvlsb_getpixel, mvlsb_fill_rect},
+    [FRAMEBUF_RGB565] = {rgb565_setpixel, rgb565_getpixel, rgb565_fill_rect},
+    [FRAMEBUF_GS4_HMSB] = {gs4_hmsb_setpixel, gs4_hmsb_getpixel, gs4_hmsb_fill_rect},
+    [FRAMEBUF_MHLSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect},
+    [FRAMEBUF_MHMSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect},
+};
+
+static inline void setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
+    formats[fb->format].setpixel(fb, x, y, col);
+}
+
+static inline uint32_t getpixel(const mp_obj_framebuf_t *fb, int x, int y) {
+    return formats[fb->format].getpixel(fb, x, y);
+}
+
+#if MICROPY_PY_FRAMEBUF_DIRTY
+// grow the dirty region to include the given rectangle, which must already
+// be clipped to the framebuffer and non-empty
+STATIC void mark_dirty(mp_obj_framebuf_t *fb, int x, int y, int w, int h) {
+    if (fb->dirty_x0 >= fb->dirty_x1) {
+        fb->dirty_x0 = x;
+        fb->dirty_y0 = y;
+        fb->dirty_x1 = x + w;
+        fb->dirty_y1 = y + h;
+        return;
+    }
+    fb->dirty_x0 = MIN(fb->dirty_x0, x);
+    fb->dirty_y0 = MIN(fb->dirty_y0, y);
+    fb->dirty_x1 = MAX(fb->dirty_x1, x + w);
+    fb->dirty_y1 = MAX(fb->dirty_y1, y + h);
+}
+#else
+#define mark_dirty(fb, x, y, w, h)
+#endif
+
+STATIC void fill_rect(mp_obj_framebuf_t *fb, int x, int y, int w, int h, uint32_t col) {
+    if (h < 1 || w < 1 || x + w <= 0 || y + h <= 0 || y >= fb->height || x >= fb->width) {
+        // no operation needed
+        return;
+    }
+
+    // clip to the framebuffer
+    int xend = MIN(fb->width, x + w);
+    int yend = MIN(fb->height, y + h);
+    x = MAX(x, 0);
+    y = MAX(y, 0);
+
+    formats[fb->format].fill_rect(fb, x, y, xend - x, yend - y, col);
+    mark_dirty(fb, x, y, xend - x, yend - y);
+}
+
+STATIC const mp_obj_type_t mp_type_framebuf;
+
+STATIC mp_obj_t framebuf_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 4, 5, false);
+
+    mp_obj_framebuf_t *o = m_new_obj(mp_obj_framebuf_t);
     o->base.type = type;
+    o->buf_obj = args[0];
 
     mp_buffer_info_t bufinfo;
     mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_WRITE);
@@ -54,54 +277,244 @@ STATIC mp_obj_t framebuf1_make_new(const mp_obj_type_t *type, size_t n_args, siz
 
     o->width = mp_obj_get_int(args[1]);
     o->height = mp_obj_get_int(args[2]);
+    o->format = mp_obj_get_int(args[3]);
     o->stride = o->width;
-    if (n_args >= 4) {
-        o->stride = mp_obj_get_int(args[3]);
+    if (n_args >= 5) {
+        o->stride = mp_obj_get_int(args[4]);
     }
 
+    size_t size;
+    switch (o->format) {
+        case FRAMEBUF_MVLSB:
+            size = ((o->height + 7) >> 3) * o->stride;
+            break;
+        case FRAMEBUF_RGB565:
+            size = o->height * o->stride * 2;
+            break;
+        case FRAMEBUF_GS4_HMSB:
+            o->stride = (o->stride + 1) & ~1;
+            size = o->height * o->stride / 2;
+            break;
+        case FRAMEBUF_MHLSB:
+        case FRAMEBUF_MHMSB:
+            o->stride = (o->stride + 7) & ~7;
+            size = o->height * o->stride / 8;
+            break;
+        default:
+            mp_raise_ValueError("invalid format");
+    }
+    if (o->stride < o->width || bufinfo.len < size) {
+        mp_raise_ValueError("buffer too small");
+    }
+
+    #if MICROPY_PY_FRAMEBUF_DIRTY
+    // the display hasn't seen any of the buffer yet
+    o->dirty_x0 = 0;
+    o->dirty_y0 = 0;
+    o->dirty_x1 = o->width;
+    o->dirty_y1 = o->height;
+    #endif
+
     return MP_OBJ_FROM_PTR(o);
 }
 
-STATIC mp_obj_t framebuf1_fill(mp_obj_t self_in, mp_obj_t col_in) {
-    mp_obj_framebuf1_t *self = MP_OBJ_TO_PTR(self_in);
+STATIC mp_int_t framebuf_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_get_buffer(self->buf_obj, bufinfo, flags) ? 0 : 1;
+}
+
+STATIC mp_obj_t framebuf_fill(mp_obj_t self_in, mp_obj_t col_in) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(self_in);
     mp_int_t col = mp_obj_get_int(col_in);
-    if (col) {
-        col = 0xff;
-    }
-    int end = (self->height + 7) >> 3;
-    for (int y = 0; y < end; ++y) {
-        memset(self->buf + y * self->stride, col, self->width);
-    }
+    formats[self->format].fill_rect(self, 0, 0, self->width, self->height, col);
+    mark_dirty(self, 0, 0, self->width, self->height);
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(framebuf1_fill_obj, framebuf1_fill);
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(framebuf_fill_obj, framebuf_fill);
+
+STATIC mp_obj_t framebuf_fill_rect(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
 
-STATIC mp_obj_t framebuf1_pixel(size_t n_args, const mp_obj_t *args) {
-    mp_obj_framebuf1_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t width = mp_obj_get_int(args[3]);
+    mp_int_t height = mp_obj_get_int(args[4]);
+    mp_int_t col = mp_obj_get_int(args[5]);
+
+    fill_rect(MP_OBJ_TO_PTR(args[0]), x, y, width, height, col);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_fill_rect_obj, 6, 6, framebuf_fill_rect);
+
+STATIC mp_obj_t framebuf_pixel(size_t n_args, const mp_obj_t *args) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
     mp_int_t x = mp_obj_get_int(args[1]);
     mp_int_t y = mp_obj_get_int(args[2]);
     if (0 <= x && x < self->width && 0 <= y && y < self->height) {
-        int index = (y / 8) * self->stride + x;
         if (n_args == 3) {
             // get
-            return MP_OBJ_NEW_SMALL_INT((self->buf[index] >> (y & 7)) & 1);
+            return MP_OBJ_NEW_SMALL_INT(getpixel(self, x, y));
         } else {
             // set
-            if (mp_obj_get_int(args[3])) {
-                self->buf[index] |= (1 << (y & 7));
+            setpixel(self, x, y, mp_obj_get_int(args[3]));
+            mark_dirty(self, x, y, 1, 1);
+        }
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_pixel_obj, 3, 4, framebuf_pixel);
+
+STATIC mp_obj_t framebuf_hline(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t col = mp_obj_get_int(args[4]);
+
+    fill_rect(MP_OBJ_TO_PTR(args[0]), x, y, w, 1, col);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_hline_obj, 5, 5, framebuf_hline);
+
+STATIC mp_obj_t framebuf_vline(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t h = mp_obj_get_int(args[3]);
+    mp_int_t col = mp_obj_get_int(args[4]);
+
+    fill_rect(MP_OBJ_TO_PTR(args[0]), x, y, 1, h, col);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_vline_obj, 5, 5, framebuf_vline);
+
+STATIC mp_obj_t framebuf_rect(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t h = mp_obj_get_int(args[4]);
+    mp_int_t col = mp_obj_get_int(args[5]);
+
+    fill_rect(self, x, y, w, 1, col);
+    fill_rect(self, x, y + h - 1, w, 1, col);
+    fill_rect(self, x, y, 1, h, col);
+    fill_rect(self, x + w - 1, y, 1, h, col);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_rect_obj, 6, 6, framebuf_rect);
+
+STATIC mp_obj_t framebuf_blit(size_t n_args, const mp_obj_t *args) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_t source_in = args[1];
+    if (!MP_OBJ_IS_TYPE(source_in, &mp_type_framebuf)) {
+        // allow instances of a Python subclass of FrameBuffer
+        source_in = mp_instance_cast_to_native_base(source_in, MP_OBJ_FROM_PTR(&mp_type_framebuf));
+        if (source_in == MP_OBJ_NULL) {
+            mp_raise_TypeError(NULL);
+        }
+    }
+    mp_obj_framebuf_t *source = MP_OBJ_TO_PTR(source_in);
+    mp_int_t x = mp_obj_get_int(args[2]);
+    mp_int_t y = mp_obj_get_int(args[3]);
+    mp_int_t key = -1;
+    if (n_args > 4) {
+        key = mp_obj_get_int(args[4]);
+    }
+
+    if ((x >= self->width) ||
+        (y >= self->height) ||
+        (-x >= source->width) ||
+        (-y >= source->height)
+    ) {
+        // Out of bounds, no-op.
+        return mp_const_none;
+    }
+
+    // Clip.
+    int x0 = MAX(0, x);
+    int y0 = MAX(0, y);
+    int x1 = MAX(0, -x);
+    int y1 = MAX(0, -y);
+    int x0end = MIN(self->width, x + source->width);
+    int y0end = MIN(self->height, y + source->height);
+    int w = x0end - x0;
+    mark_dirty(self, x0, y0, w, y0end - y0);
+
+    if (self->format == FRAMEBUF_RGB565 && source->format == FRAMEBUF_RGB565) {
+        // copy whole rows, or compare words against the key, without
+        // going through the per-pixel functions
+        for (; y0 < y0end; ++y0, ++y1) {
+            uint16_t *dest = &((uint16_t*)self->buf)[x0 + y0 * self->stride];
+            const uint16_t *src = &((uint16_t*)source->buf)[x1 + y1 * source->stride];
+            if (key == -1) {
+                memmove(dest, src, w * sizeof(uint16_t));
             } else {
-                self->buf[index] &= ~(1 << (y & 7));
+                for (int i = 0; i < w; ++i) {
+                    if (src[i] != key) {
+                        dest[i] = src[i];
+                    }
+                }
+            }
+        }
+        return mp_const_none;
+    }
+
+    for (; y0 < y0end; ++y0, ++y1) {
+        int cx1 = x1;
+        for (int cx0 = x0; cx0 < x0end; ++cx0, ++cx1) {
+            uint32_t col = getpixel(source, cx1, y1);
+            if (col != (uint32_t)key) {
+                setpixel(self, cx0, y0, col);
             }
         }
     }
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf1_pixel_obj, 3, 4, framebuf1_pixel);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_blit_obj, 4, 5, framebuf_blit);
 
-STATIC mp_obj_t framebuf1_scroll(mp_obj_t self_in, mp_obj_t xstep_in, mp_obj_t ystep_in) {
-    mp_obj_framebuf1_t *self = MP_OBJ_TO_PTR(self_in);
+STATIC mp_obj_t framebuf_scroll(mp_obj_t self_in, mp_obj_t xstep_in, mp_obj_t ystep_in) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(self_in);
     mp_int_t xstep = mp_obj_get_int(xstep_in);
     mp_int_t ystep = mp_obj_get_int(ystep_in);
+    mark_dirty(self, 0, 0, self->width, self->height);
+    if (self->format != FRAMEBUF_MVLSB) {
+        // move each pixel, in an order that doesn't overwrite pixels still to be moved
+        int sx, y, xend, yend, dx, dy;
+        if (xstep < 0) {
+            sx = 0;
+            xend = self->width + xstep;
+            dx = 1;
+        } else {
+            sx = self->width - 1;
+            xend = xstep - 1;
+            dx = -1;
+        }
+        if (ystep < 0) {
+            y = 0;
+            yend = self->height + ystep;
+            dy = 1;
+        } else {
+            y = self->height - 1;
+            yend = ystep - 1;
+            dy = -1;
+        }
+        for (; y != yend; y += dy) {
+            for (int x = sx; x != xend; x += dx) {
+                setpixel(self, x, y, getpixel(self, x - xstep, y - ystep));
+            }
+        }
+        return mp_const_none;
+    }
+    uint8_t *buf = self->buf;
     int end = (self->height + 7) >> 3;
     if (ystep > 0) {
         for (int y = end; y > 0;) {
@@ -109,9 +522,9 @@ STATIC mp_obj_t framebuf1_scroll(mp_obj_t self_in, mp_obj_t xstep_in, mp_obj_t y
             for (int x = 0; x < self->width; ++x) {
                 int prev = 0;
                 if (y > 0) {
-                    prev = (self->buf[(y - 1) * self->stride + x] >> (8 - ystep)) & ((1 << ystep) - 1);
+                    prev = (buf[(y - 1) * self->stride + x] >> (8 - ystep)) & ((1 << ystep) - 1);
                 }
-                self->buf[y * self->stride + x] = (self->buf[y * self->stride + x] << ystep) | prev;
+                buf[y * self->stride + x] = (buf[y * self->stride + x] << ystep) | prev;
             }
         }
     } else if (ystep < 0) {
@@ -119,33 +532,33 @@ STATIC mp_obj_t framebuf1_scroll(mp_obj_t self_in, mp_obj_t xstep_in, mp_obj_t y
             for (int x = 0; x < self->width; ++x) {
                 int prev = 0;
                 if (y + 1 < end) {
-                    prev = self->buf[(y + 1) * self->stride + x] << (8 + ystep);
+                    prev = buf[(y + 1) * self->stride + x] << (8 + ystep);
                 }
-                self->buf[y * self->stride + x] = (self->buf[y * self->stride + x] >> -ystep) | prev;
+                buf[y * self->stride + x] = (buf[y * self->stride + x] >> -ystep) | prev;
             }
         }
     }
     if (xstep < 0) {
         for (int y = 0; y < end; ++y) {
             for (int x = 0; x < self->width + xstep; ++x) {
-                self->buf[y * self->stride + x] = self->buf[y * self->stride + x - xstep];
+                buf[y * self->stride + x] = buf[y * self->stride + x - xstep];
             }
         }
     } else if (xstep > 0) {
         for (int y = 0; y < end; ++y) {
             for (int x = self->width - 1; x >= xstep; --x) {
-                self->buf[y * self->stride + x] = self->buf[y * self->stride + x - xstep];
+                buf[y * self->stride + x] = buf[y * self->stride + x - xstep];
             }
         }
     }
     // TODO: Should we clear the margin created by scrolling?
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_3(framebuf1_scroll_obj, framebuf1_scroll);
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(framebuf_scroll_obj, framebuf_scroll);
 
-STATIC mp_obj_t framebuf1_text(size_t n_args, const mp_obj_t *args) {
+STATIC mp_obj_t framebuf_text(size_t n_args, const mp_obj_t *args) {
     // extract arguments
-    mp_obj_framebuf1_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
     const char *str = mp_obj_str_get_str(args[1]);
     mp_int_t x0 = mp_obj_get_int(args[2]);
     mp_int_t y0 = mp_obj_get_int(args[3]);
@@ -163,6 +576,15 @@ STATIC mp_obj_t framebuf1_text(size_t n_args, const mp_obj_t *args) {
         }
         // get char data
         const uint8_t *chr_data = &font_petme128_8x8[(chr - 32) * 8];
+        #if MICROPY_PY_FRAMEBUF_DIRTY
+        {
+            int cx0 = MAX(x0, 0), cx1 = MIN(x0 + 8, self->width);
+            int cy0 = MAX(y0, 0), cy1 = MIN(y0 + 8, self->height);
+            if (cx0 < cx1 && cy0 < cy1) {
+                mark_dirty(self, cx0, cy0, cx1 - cx0, cy1 - cy0);
+            }
+        }
+        #endif
         // loop over char data
         for (int j = 0; j < 8; j++, x0++) {
             if (0 <= x0 && x0 < self->width) { // clip x
@@ -170,14 +592,7 @@ STATIC mp_obj_t framebuf1_text(size_t n_args, const mp_obj_t *args) {
                 for (int y = y0; vline_data; vline_data >>= 1, y++) { // scan over vertical column
                     if (vline_data & 1) { // only draw if pixel set
                         if (0 <= y && y < self->height) { // clip y
-                            uint byte_pos = x0 + self->stride * ((uint)y >> 3);
-                            if (col == 0) {
-                                // clear pixel
-                                self->buf[byte_pos] &= ~(1 << (y & 7));
-                            } else {
-                                // set pixel
-                                self->buf[byte_pos] |= 1 << (y & 7);
-                            }
+                            setpixel(self, x0, y, col);
                         }
                     }
                 }
@@ -187,26 +602,92 @@ STATIC mp_obj_t framebuf1_text(size_t n_args, const mp_obj_t *args) {
 
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf1_text_obj, 4, 5, framebuf1_text);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_text_obj, 4, 5, framebuf_text);
+
+#if MICROPY_PY_FRAMEBUF_DIRTY
+// dirty() returns the region drawn to since the previous call, as a tuple
+// (x, y, w, h), or None if nothing changed, and then resets it.
+// dirty(x, y, w, h) marks a region as changed, eg after writing to the
+// underlying buffer directly.
+STATIC mp_obj_t framebuf_dirty(size_t n_args, const mp_obj_t *args) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    if (n_args > 1) {
+        if (n_args != 5) {
+            mp_raise_TypeError("dirty() takes 0 or 4 arguments");
+        }
+        mp_int_t x = mp_obj_get_int(args[1]);
+        mp_int_t y = mp_obj_get_int(args[2]);
+        mp_int_t xend = MIN(self->width, x + mp_obj_get_int(args[3]));
+        mp_int_t yend = MIN(self->height, y + mp_obj_get_int(args[4]));
+        x = MAX(x, 0);
+        y = MAX(y, 0);
+        if (x < xend && y < yend) {
+            mark_dirty(self, x, y, xend - x, yend - y);
+        }
+        return mp_const_none;
+    }
+
+    if (self->dirty_x0 >= self->dirty_x1) {
+        return mp_const_none;
+    }
+    mp_obj_t tuple[4] = {
+        MP_OBJ_NEW_SMALL_INT(self->dirty_x0),
+        MP_OBJ_NEW_SMALL_INT(self->dirty_y0),
+        MP_OBJ_NEW_SMALL_INT(self->dirty_x1 - self->dirty_x0),
+        MP_OBJ_NEW_SMALL_INT(self->dirty_y1 - self->dirty_y0),
+    };
+    self->dirty_x0 = self->dirty_x1 = 0;
+    return mp_obj_new_tuple(4, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_dirty_obj, 1, 5, framebuf_dirty);
+#endif
 
-STATIC const mp_rom_map_elem_t framebuf1_locals_dict_table[] = {
-    { MP_ROM_QSTR(MP_QSTR_fill), MP_ROM_PTR(&framebuf1_fill_obj) },
-    { MP_ROM_QSTR(MP_QSTR_pixel), MP_ROM_PTR(&framebuf1_pixel_obj) },
-    { MP_ROM_QSTR(MP_QSTR_scroll), MP_ROM_PTR(&framebuf1_scroll_obj) },
-    { MP_ROM_QSTR(MP_QSTR_text), MP_ROM_PTR(&framebuf1_text_obj) },
+STATIC const mp_rom_map_elem_t framebuf_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_fill), MP_ROM_PTR(&framebuf_fill_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fill_rect), MP_ROM_PTR(&framebuf_fill_rect_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pixel), MP_ROM_PTR(&framebuf_pixel_obj) },
+    { MP_ROM_QSTR(MP_QSTR_hline), MP_ROM_PTR(&framebuf_hline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_vline), MP_ROM_PTR(&framebuf_vline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rect), MP_ROM_PTR(&framebuf_rect_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blit), MP_ROM_PTR(&framebuf_blit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scroll), MP_ROM_PTR(&framebuf_scroll_obj) },
+    { MP_ROM_QSTR(MP_QSTR_text), MP_ROM_PTR(&framebuf_text_obj) },
+    #if MICROPY_PY_FRAMEBUF_DIRTY
+    { MP_ROM_QSTR(MP_QSTR_dirty), MP_ROM_PTR(&framebuf_dirty_obj) },
+    #endif
 };
-STATIC MP_DEFINE_CONST_DICT(framebuf1_locals_dict, framebuf1_locals_dict_table);
+STATIC MP_DEFINE_CONST_DICT(framebuf_locals_dict, framebuf_locals_dict_table);
 
-STATIC const mp_obj_type_t mp_type_framebuf1 = {
+STATIC const mp_obj_type_t mp_type_framebuf = {
     { &mp_type_type },
-    .name = MP_QSTR_FrameBuffer1,
-    .make_new = framebuf1_make_new,
-    .locals_dict = (mp_obj_t)&framebuf1_locals_dict,
+    .name = MP_QSTR_FrameBuffer,
+    .make_new = framebuf_make_new,
+    .buffer_p = { .get_buffer = framebuf_get_buffer },
+    .locals_dict = (mp_obj_t)&framebuf_locals_dict,
 };
 
+// FrameBuffer1(buf, width, height[, stride]) is the original constructor,
+// giving a frame buffer in MVLSB format
+STATIC mp_obj_t legacy_framebuffer1(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t args2[5] = {args[0], args[1], args[2], MP_OBJ_NEW_SMALL_INT(FRAMEBUF_MVLSB)};
+    if (n_args >= 4) {
+        args2[4] = args[3];
+    }
+    return framebuf_make_new(&mp_type_framebuf, n_args + 1, 0, args2);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(legacy_framebuffer1_obj, 3, 4, legacy_framebuffer1);
+
 STATIC const mp_rom_map_elem_t framebuf_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_framebuf) },
-    { MP_ROM_QSTR(MP_QSTR_FrameBuffer1), MP_ROM_PTR(&mp_type_framebuf1) },
+    { MP_ROM_QSTR(MP_QSTR_FrameBuffer), MP_ROM_PTR(&mp_type_framebuf) },
+    { MP_ROM_QSTR(MP_QSTR_FrameBuffer1), MP_ROM_PTR(&legacy_framebuffer1_obj) },
+    { MP_ROM_QSTR(MP_QSTR_MVLSB), MP_ROM_INT(FRAMEBUF_MVLSB) },
+    { MP_ROM_QSTR(MP_QSTR_MONO_VLSB), MP_ROM_INT(FRAMEBUF_MVLSB) },
+    { MP_ROM_QSTR(MP_QSTR_RGB565), MP_ROM_INT(FRAMEBUF_RGB565) },
+    { MP_ROM_QSTR(MP_QSTR_GS4_HMSB), MP_ROM_INT(FRAMEBUF_GS4_HMSB) },
+    { MP_ROM_QSTR(MP_QSTR_MONO_HLSB), MP_ROM_INT(FRAMEBUF_MHLSB) },
+    { MP_ROM_QSTR(MP_QSTR_MONO_HMSB), MP_ROM_INT(FRAMEBUF_MHMSB) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(framebuf_module_globals, framebuf_module_globals_table);
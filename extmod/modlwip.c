@@ -224,6 +224,16 @@ static const int error_lookup_table[] = {
 #define MOD_NETWORK_SOCK_DGRAM (2)
 #define MOD_NETWORK_SOCK_RAW (3)
 
+// Custom socket option to set the length of the UDP receive queue
+#define SO_RCVQUEUE (21)
+
+// A received UDP datagram and where it came from
+typedef struct _lwip_udp_entry_t {
+    struct pbuf *pbuf;
+    byte peer[4];
+    u16_t peer_port;
+} lwip_udp_entry_t;
+
 typedef struct _lwip_socket_obj_t {
     mp_obj_base_t base;
 
@@ -241,6 +251,16 @@ typedef struct _lwip_socket_obj_t {
     mp_uint_t timeout;
     uint16_t recv_offset;
 
+    // Ring of received UDP datagrams, or for a listening TCP socket of
+    // connections waiting for accept(), filled by the lwIP callbacks
+    union {
+        lwip_udp_entry_t *udp;
+        struct tcp_pcb **tcp;
+    } queue;
+    uint8_t queue_size;
+    uint8_t queue_head;
+    volatile uint8_t queue_count;
+
     uint8_t domain;
     uint8_t type;
 
@@ -253,7 +273,9 @@ typedef struct _lwip_socket_obj_t {
 } lwip_socket_obj_t;
 
 static inline void poll_sockets(void) {
-#ifdef MICROPY_EVENT_POLL_HOOK
+#if defined(MICROPY_EVENT_WAIT_HOOK)
+    MICROPY_EVENT_WAIT_HOOK;
+#elif defined(MICROPY_EVENT_POLL_HOOK)
     MICROPY_EVENT_POLL_HOOK;
 #else
     mp_hal_delay_ms(1);
@@ -269,19 +291,22 @@ static inline void exec_user_callback(lwip_socket_obj_t *socket) {
     }
 }
 
-// Callback for incoming UDP packets. We simply stash the packet and the source address,
+// Callback for incoming UDP packets. We simply queue the packet and the source address,
 // in case we need it for recvfrom.
 STATIC void _lwip_udp_incoming(void *arg, struct udp_pcb *upcb, struct pbuf *p, ip_addr_t *addr, u16_t port) {
     lwip_socket_obj_t *socket = (lwip_socket_obj_t*)arg;
 
-    if (socket->incoming.pbuf != NULL) {
+    if (socket->queue_count >= socket->queue_size) {
         // That's why they call it "unreliable". No room in the inn, drop the packet.
         pbuf_free(p);
-    } else {
-        socket->incoming.pbuf = p;
-        socket->peer_port = (mp_uint_t)port;
-        memcpy(&socket->peer, addr, sizeof(socket->peer));
+        return;
     }
+
+    lwip_udp_entry_t *entry = &socket->queue.udp[(socket->queue_head + socket->queue_count) % socket->queue_size];
+    entry->pbuf = p;
+    entry->peer_port = port;
+    memcpy(entry->peer, addr, sizeof(entry->peer));
+    socket->queue_count += 1;
 }
 
 // Callback for general tcp errors.
@@ -327,13 +352,12 @@ STATIC err_t _lwip_tcp_accept(void *arg, struct tcp_pcb *newpcb, err_t err) {
     lwip_socket_obj_t *socket = (lwip_socket_obj_t*)arg;
     tcp_recv(newpcb, _lwip_tcp_recv_unaccepted);
 
-    if (socket->incoming.connection != NULL) {
-        DEBUG_printf("_lwip_tcp_accept: Tried to queue >1 pcb waiting for accept\n");
-        // We need to handle this better. This single-level structure makes the
-        // backlog setting kind of pointless. FIXME
+    if (socket->queue_count >= socket->queue_size) {
+        DEBUG_printf("_lwip_tcp_accept: backlog of %d pcbs waiting for accept is full\n", socket->queue_size);
         return ERR_BUF;
     } else {
-        socket->incoming.connection = newpcb;
+        socket->queue.tcp[(socket->queue_head + socket->queue_count) % socket->queue_size] = newpcb;
+        socket->queue_count += 1;
         if (socket->callback != MP_OBJ_NULL) {
             // Schedule accept callback to be called when lwIP is done
             // with processing this incoming connection on its side and
@@ -413,36 +437,75 @@ STATIC mp_uint_t lwip_udp_send(lwip_socket_obj_t *socket, const byte *buf, mp_ui
     return len;
 }
 
+// Take the oldest datagram off the UDP queue; the caller must free its pbuf
+STATIC void lwip_udp_queue_pop(lwip_socket_obj_t *socket, lwip_udp_entry_t *entry) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    *entry = socket->queue.udp[socket->queue_head];
+    socket->queue_head = (socket->queue_head + 1) % socket->queue_size;
+    socket->queue_count -= 1;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+// Replace the UDP queue with one of the given size, keeping the oldest
+// queued datagrams that fit
+STATIC void lwip_udp_queue_resize(lwip_socket_obj_t *socket, size_t size) {
+    lwip_udp_entry_t *queue = m_new(lwip_udp_entry_t, size);
+    lwip_udp_entry_t *old_queue = socket->queue.udp;
+    size_t old_size = socket->queue_size;
+    size_t n = 0;
+
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    while (socket->queue_count > 0) {
+        lwip_udp_entry_t *entry = &old_queue[socket->queue_head];
+        if (n < size) {
+            queue[n++] = *entry;
+        } else {
+            pbuf_free(entry->pbuf);
+        }
+        socket->queue_head = (socket->queue_head + 1) % old_size;
+        socket->queue_count -= 1;
+    }
+    socket->queue.udp = queue;
+    socket->queue_size = size;
+    socket->queue_head = 0;
+    socket->queue_count = n;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+
+    m_del(lwip_udp_entry_t, old_queue, old_size);
+}
+
 // Helper function for recv/recvfrom to handle UDP packets
 STATIC mp_uint_t lwip_udp_receive(lwip_socket_obj_t *socket, byte *buf, mp_uint_t len, byte *ip, mp_uint_t *port, int *_errno) {
 
-    if (socket->incoming.pbuf == NULL) {
+    if (socket->queue_count == 0) {
         if (socket->timeout != -1) {
             for (mp_uint_t retries = socket->timeout / 100; retries--;) {
                 mp_hal_delay_ms(100);
-                if (socket->incoming.pbuf != NULL) break;
+                if (socket->queue_count != 0) break;
             }
-            if (socket->incoming.pbuf == NULL) {
+            if (socket->queue_count == 0) {
                 *_errno = MP_ETIMEDOUT;
                 return -1;
             }
         } else {
-            while (socket->incoming.pbuf == NULL) {
+            while (socket->queue_count == 0) {
                 poll_sockets();
             }
         }
     }
 
+    lwip_udp_entry_t entry;
+    lwip_udp_queue_pop(socket, &entry);
+
     if (ip != NULL) {
-        memcpy(ip, &socket->peer, sizeof(socket->peer));
-        *port = socket->peer_port;
+        memcpy(ip, entry.peer, sizeof(entry.peer));
+        *port = entry.peer_port;
     }
 
-    struct pbuf *p = socket->incoming.pbuf;
+    struct pbuf *p = entry.pbuf;
 
     u16_t result = pbuf_copy_partial(p, buf, ((p->tot_len > len) ? len : p->tot_len), 0);
     pbuf_free(p);
-    socket->incoming.pbuf = NULL;
 
     return (mp_uint_t) result;
 }
@@ -457,7 +520,8 @@ STATIC mp_uint_t lwip_udp_receive(lwip_socket_obj_t *socket, byte *buf, mp_uint_
 
 
 // Helper function for send/sendto to handle TCP packets
-STATIC mp_uint_t lwip_tcp_send(lwip_socket_obj_t *socket, const byte *buf, mp_uint_t len, int *_errno) {
+// apiflags are passed on to tcp_write, in addition to TCP_WRITE_FLAG_COPY
+STATIC mp_uint_t lwip_tcp_send(lwip_socket_obj_t *socket, const byte *buf, mp_uint_t len, u8_t apiflags, int *_errno) {
     // Check for any pending errors
     STREAM_ERROR_CHECK(socket);
 
@@ -491,7 +555,7 @@ STATIC mp_uint_t lwip_tcp_send(lwip_socket_obj_t *socket, const byte *buf, mp_ui
 
     u16_t write_len = MIN(available, len);
 
-    err_t err = tcp_write(socket->pcb.tcp, buf, write_len, TCP_WRITE_FLAG_COPY);
+    err_t err = tcp_write(socket->pcb.tcp, buf, write_len, TCP_WRITE_FLAG_COPY | apiflags);
 
     if (err != ERR_OK) {
         *_errno = error_lookup_table[-err];
@@ -540,30 +604,34 @@ STATIC mp_uint_t lwip_tcp_receive(lwip_socket_obj_t *socket, byte *buf, mp_uint_
 
     assert(socket->pcb.tcp != NULL);
 
+    // Copy straight from the queued pbuf chain into the caller's buffer,
+    // freeing each pbuf once it has been consumed.
     struct pbuf *p = socket->incoming.pbuf;
-
-    mp_uint_t remaining = p->len - socket->recv_offset;
-    if (len > remaining) {
-        len = remaining;
-    }
-
-    memcpy(buf, (byte*)p->payload + socket->recv_offset, len);
-
-    remaining -= len;
-    if (remaining == 0) {
-        socket->incoming.pbuf = p->next;
-        // If we don't ref here, free() will free the entire chain,
-        // if we ref, it does what we need: frees 1st buf, and decrements
-        // next buf's refcount back to 1.
-        pbuf_ref(p->next);
-        pbuf_free(p);
-        socket->recv_offset = 0;
-    } else {
-        socket->recv_offset += len;
+    mp_uint_t copied = 0;
+    while (p != NULL && copied < len) {
+        mp_uint_t remaining = p->len - socket->recv_offset;
+        mp_uint_t n = MIN(remaining, len - copied);
+
+        memcpy(buf + copied, (byte*)p->payload + socket->recv_offset, n);
+        copied += n;
+
+        if (n == remaining) {
+            struct pbuf *next = p->next;
+            // If we don't ref here, free() will free the entire chain,
+            // if we ref, it does what we need: frees 1st buf, and decrements
+            // next buf's refcount back to 1.
+            pbuf_ref(next);
+            pbuf_free(p);
+            p = next;
+            socket->recv_offset = 0;
+        } else {
+            socket->recv_offset += n;
+        }
     }
-    tcp_recved(socket->pcb.tcp, len);
+    socket->incoming.pbuf = p;
+    tcp_recved(socket->pcb.tcp, copied);
 
-    return len;
+    return copied;
 }
 
 /*******************************************************************************/
@@ -587,6 +655,9 @@ STATIC mp_obj_t lwip_socket_make_new(const mp_obj_type_t *type, mp_uint_t n_args
     socket->domain = MOD_NETWORK_AF_INET;
     socket->type = MOD_NETWORK_SOCK_STREAM;
     socket->callback = MP_OBJ_NULL;
+    socket->queue.udp = NULL;
+    socket->queue_size = 0;
+    socket->queue_count = 0;
     if (n_args >= 1) {
         socket->domain = mp_obj_get_int(args[0]);
         if (n_args >= 2) {
@@ -614,6 +685,11 @@ STATIC mp_obj_t lwip_socket_make_new(const mp_obj_type_t *type, mp_uint_t n_args
             break;
         }
         case MOD_NETWORK_SOCK_DGRAM: {
+            // The queue must exist before any packets can arrive.
+            socket->queue.udp = m_new(lwip_udp_entry_t, MICROPY_PY_LWIP_UDP_QUEUE_LEN);
+            socket->queue_size = MICROPY_PY_LWIP_UDP_QUEUE_LEN;
+            socket->queue_head = 0;
+            socket->queue_count = 0;
             // Register our receive callback now. Since UDP sockets don't require binding or connection
             // before use, there's no other good time to do it.
             udp_recv(socket->pcb.udp, _lwip_udp_incoming, (void*)socket);
@@ -646,17 +722,29 @@ STATIC mp_obj_t lwip_socket_close(mp_obj_t self_in) {
             }
             break;
         }
-        case MOD_NETWORK_SOCK_DGRAM: udp_remove(socket->pcb.udp); break;
+        case MOD_NETWORK_SOCK_DGRAM: {
+            udp_remove(socket->pcb.udp);
+            // No more packets can arrive, so free any still queued.
+            while (socket->queue_count > 0) {
+                lwip_udp_entry_t entry;
+                lwip_udp_queue_pop(socket, &entry);
+                pbuf_free(entry.pbuf);
+            }
+            break;
+        }
         //case MOD_NETWORK_SOCK_RAW: raw_remove(socket->pcb.raw); break;
     }
     socket->pcb.tcp = NULL;
     socket->state = _ERR_BADF;
-    if (socket->incoming.pbuf != NULL) {
-        if (!socket_is_listener) {
-            pbuf_free(socket->incoming.pbuf);
-        } else {
-            tcp_abort(socket->incoming.connection);
+    if (socket_is_listener) {
+        // Abort connections that were never accepted.
+        while (socket->queue_count > 0) {
+            tcp_abort(socket->queue.tcp[socket->queue_head]);
+            socket->queue_head = (socket->queue_head + 1) % socket->queue_size;
+            socket->queue_count -= 1;
         }
+    } else if (socket->incoming.pbuf != NULL) {
+        pbuf_free(socket->incoming.pbuf);
         socket->incoming.pbuf = NULL;
     }
 
@@ -704,6 +792,19 @@ STATIC mp_obj_t lwip_socket_listen(mp_obj_t self_in, mp_obj_t backlog_in) {
         mp_raise_OSError(MP_EOPNOTSUPP);
     }
 
+    if (backlog < 1) {
+        backlog = 1;
+    } else if (backlog > 255) {
+        backlog = 255;
+    }
+
+    // Connections that arrive before accept() is called are queued here,
+    // up to the backlog; allocate it before lwIP can deliver any.
+    socket->queue.tcp = m_new(struct tcp_pcb*, backlog);
+    socket->queue_size = backlog;
+    socket->queue_head = 0;
+    socket->queue_count = 0;
+
     struct tcp_pcb *new_pcb = tcp_listen_with_backlog(socket->pcb.tcp, (u8_t)backlog);
     if (new_pcb == NULL) {
         mp_raise_OSError(MP_ENOMEM);
@@ -731,17 +832,17 @@ STATIC mp_obj_t lwip_socket_accept(mp_obj_t self_in) {
     }
 
     // accept incoming connection
-    if (socket->incoming.connection == NULL) {
+    if (socket->queue_count == 0) {
         if (socket->timeout != -1) {
             for (mp_uint_t retries = socket->timeout / 100; retries--;) {
                 mp_hal_delay_ms(100);
-                if (socket->incoming.connection != NULL) break;
+                if (socket->queue_count != 0) break;
             }
-            if (socket->incoming.connection == NULL) {
+            if (socket->queue_count == 0) {
                 mp_raise_OSError(MP_ETIMEDOUT);
             }
         } else {
-            while (socket->incoming.connection == NULL) {
+            while (socket->queue_count == 0) {
                 poll_sockets();
             }
         }
@@ -751,14 +852,20 @@ STATIC mp_obj_t lwip_socket_accept(mp_obj_t self_in) {
     lwip_socket_obj_t *socket2 = m_new_obj_with_finaliser(lwip_socket_obj_t);
     socket2->base.type = (mp_obj_t)&lwip_socket_type;
 
-    // We get a new pcb handle...
-    socket2->pcb.tcp = socket->incoming.connection;
-    socket->incoming.connection = NULL;
+    // We get a new pcb handle, the oldest waiting one...
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    socket2->pcb.tcp = socket->queue.tcp[socket->queue_head];
+    socket->queue_head = (socket->queue_head + 1) % socket->queue_size;
+    socket->queue_count -= 1;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
 
     // ...and set up the new socket for it.
     socket2->domain = MOD_NETWORK_AF_INET;
     socket2->type = MOD_NETWORK_SOCK_STREAM;
     socket2->incoming.pbuf = NULL;
+    socket2->queue.udp = NULL;
+    socket2->queue_size = 0;
+    socket2->queue_count = 0;
     socket2->timeout = socket->timeout;
     socket2->state = STATE_CONNECTED;
     socket2->recv_offset = 0;
@@ -871,7 +978,7 @@ STATIC mp_obj_t lwip_socket_send(mp_obj_t self_in, mp_obj_t buf_in) {
     mp_uint_t ret = 0;
     switch (socket->type) {
         case MOD_NETWORK_SOCK_STREAM: {
-            ret = lwip_tcp_send(socket, bufinfo.buf, bufinfo.len, &_errno);
+            ret = lwip_tcp_send(socket, bufinfo.buf, bufinfo.len, 0, &_errno);
             break;
         }
         case MOD_NETWORK_SOCK_DGRAM: {
@@ -920,6 +1027,46 @@ STATIC mp_obj_t lwip_socket_recv(mp_obj_t self_in, mp_obj_t len_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(lwip_socket_recv_obj, lwip_socket_recv);
 
+// recv_into(buf[, nbytes]) receives into a caller-supplied buffer, so a
+// receive loop doesn't allocate a new bytes object for every call
+STATIC mp_obj_t lwip_socket_recv_into(size_t n_args, const mp_obj_t *args) {
+    lwip_socket_obj_t *socket = args[0];
+    int _errno;
+
+    lwip_socket_check_connected(socket);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
+    mp_uint_t len = bufinfo.len;
+    if (n_args > 2) {
+        mp_int_t nbytes = mp_obj_get_int(args[2]);
+        if (nbytes < 0 || (mp_uint_t)nbytes > len) {
+            mp_raise_ValueError("buffer too small");
+        }
+        if (nbytes > 0) {
+            len = nbytes;
+        }
+    }
+
+    mp_uint_t ret = 0;
+    switch (socket->type) {
+        case MOD_NETWORK_SOCK_STREAM: {
+            ret = lwip_tcp_receive(socket, bufinfo.buf, len, &_errno);
+            break;
+        }
+        case MOD_NETWORK_SOCK_DGRAM: {
+            ret = lwip_udp_receive(socket, bufinfo.buf, len, NULL, NULL, &_errno);
+            break;
+        }
+    }
+    if (ret == -1) {
+        mp_raise_OSError(_errno);
+    }
+
+    return mp_obj_new_int_from_uint(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(lwip_socket_recv_into_obj, 2, 3, lwip_socket_recv_into);
+
 STATIC mp_obj_t lwip_socket_sendto(mp_obj_t self_in, mp_obj_t data_in, mp_obj_t addr_in) {
     lwip_socket_obj_t *socket = self_in;
     int _errno;
@@ -935,7 +1082,7 @@ STATIC mp_obj_t lwip_socket_sendto(mp_obj_t self_in, mp_obj_t data_in, mp_obj_t
     mp_uint_t ret = 0;
     switch (socket->type) {
         case MOD_NETWORK_SOCK_STREAM: {
-            ret = lwip_tcp_send(socket, bufinfo.buf, bufinfo.len, &_errno);
+            ret = lwip_tcp_send(socket, bufinfo.buf, bufinfo.len, 0, &_errno);
             break;
         }
         case MOD_NETWORK_SOCK_DGRAM: {
@@ -992,6 +1139,49 @@ STATIC mp_obj_t lwip_socket_recvfrom(mp_obj_t self_in, mp_obj_t len_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(lwip_socket_recvfrom_obj, lwip_socket_recvfrom);
 
+// recvfrom_many(maxcount, bufsize) waits for a datagram like recvfrom, then
+// returns a list of (bytes, address) tuples for it and up to maxcount - 1
+// more that are already queued, draining a burst in one call
+STATIC mp_obj_t lwip_socket_recvfrom_many(mp_obj_t self_in, mp_obj_t count_in, mp_obj_t len_in) {
+    lwip_socket_obj_t *socket = self_in;
+    int _errno;
+
+    if (socket->type != MOD_NETWORK_SOCK_DGRAM) {
+        mp_raise_OSError(MP_EOPNOTSUPP);
+    }
+    lwip_socket_check_connected(socket);
+
+    mp_int_t count = mp_obj_get_int(count_in);
+    mp_int_t len = mp_obj_get_int(len_in);
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+
+    while (count-- > 0) {
+        vstr_t vstr;
+        vstr_init_len(&vstr, len);
+        byte ip[4];
+        mp_uint_t port;
+
+        mp_uint_t ret = lwip_udp_receive(socket, (byte*)vstr.buf, len, ip, &port, &_errno);
+        if (ret == -1) {
+            mp_raise_OSError(_errno);
+        }
+
+        mp_obj_t tuple[2];
+        vstr.len = ret;
+        tuple[0] = mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+        tuple[1] = netutils_format_inet_addr(ip, port, NETUTILS_BIG);
+        mp_obj_list_append(list, mp_obj_new_tuple(2, tuple));
+
+        if (socket->queue_count == 0) {
+            // don't wait for more once the queue is drained
+            break;
+        }
+    }
+
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(lwip_socket_recvfrom_many_obj, lwip_socket_recvfrom_many);
+
 STATIC mp_obj_t lwip_socket_sendall(mp_obj_t self_in, mp_obj_t buf_in) {
     lwip_socket_obj_t *socket = self_in;
     lwip_socket_check_connected(socket);
@@ -1016,7 +1206,7 @@ STATIC mp_obj_t lwip_socket_sendall(mp_obj_t self_in, mp_obj_t buf_in) {
             // TODO: In CPython3.5, socket timeout should apply to the
             // entire sendall() operation, not to individual send() chunks.
             while (bufinfo.len != 0) {
-                ret = lwip_tcp_send(socket, bufinfo.buf, bufinfo.len, &_errno);
+                ret = lwip_tcp_send(socket, bufinfo.buf, bufinfo.len, 0, &_errno);
                 if (ret == -1) {
                     mp_raise_OSError(_errno);
                 }
@@ -1088,6 +1278,12 @@ STATIC mp_obj_t lwip_socket_setsockopt(mp_uint_t n_args, const mp_obj_t *args) {
                 ip_reset_option(socket->pcb.tcp, SOF_REUSEADDR);
             }
             break;
+        case SO_RCVQUEUE:
+            if (socket->type != MOD_NETWORK_SOCK_DGRAM || val < 1 || val > 255) {
+                mp_raise_OSError(MP_EINVAL);
+            }
+            lwip_udp_queue_resize(socket, val);
+            break;
         default:
             printf("Warning: lwip.setsockopt() not implemented\n");
     }
@@ -1119,7 +1315,7 @@ STATIC mp_uint_t lwip_socket_write(mp_obj_t self_in, const void *buf, mp_uint_t
 
     switch (socket->type) {
         case MOD_NETWORK_SOCK_STREAM:
-            return lwip_tcp_send(socket, buf, size, errcode);
+            return lwip_tcp_send(socket, buf, size, 0, errcode);
         case MOD_NETWORK_SOCK_DGRAM:
             return lwip_udp_send(socket, buf, size, NULL, 0, errcode);
     }
@@ -1127,6 +1323,72 @@ STATIC mp_uint_t lwip_socket_write(mp_obj_t self_in, const void *buf, mp_uint_t
     return MP_STREAM_ERROR;
 }
 
+// Readiness is derived from the state the lwIP callbacks leave behind, so
+// uselect can sleep until one of them runs and then just poll again.
+STATIC mp_uint_t lwip_socket_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    lwip_socket_obj_t *socket = self_in;
+
+    if (request == MP_STREAM_WRITEV && socket->type == MOD_NETWORK_SOCK_STREAM) {
+        // Queue the buffers back to back, telling lwIP that more data follows
+        // all but the last, so it can pack them into as few segments as it can
+        const struct mp_stream_writev_t *w = (const struct mp_stream_writev_t*)arg;
+        mp_uint_t total = 0;
+        for (size_t i = 0; i < w->iovcnt; i++) {
+            const byte *buf = w->iov[i].base;
+            mp_uint_t len = w->iov[i].len;
+            u8_t apiflags = i + 1 < w->iovcnt ? TCP_WRITE_FLAG_MORE : 0;
+            while (len > 0) {
+                mp_uint_t out_sz = lwip_tcp_send(socket, buf, len, apiflags, errcode);
+                if (out_sz == MP_STREAM_ERROR) {
+                    return total > 0 ? total : MP_STREAM_ERROR;
+                }
+                buf += out_sz;
+                len -= out_sz;
+                total += out_sz;
+            }
+        }
+        return total;
+    }
+
+    if (request != MP_STREAM_POLL) {
+        *errcode = MP_EINVAL;
+        return MP_STREAM_ERROR;
+    }
+
+    uintptr_t flags = arg;
+    mp_uint_t ret = 0;
+
+    if (socket->type == MOD_NETWORK_SOCK_DGRAM) {
+        if (socket->queue_count > 0) {
+            ret |= flags & MP_STREAM_POLL_RD;
+        }
+        // Sending a datagram never waits
+        ret |= flags & MP_STREAM_POLL_WR;
+    } else if (socket->queue.tcp != NULL) {
+        // Listening socket, readable when a connection is waiting for accept()
+        if (socket->queue_count > 0) {
+            ret |= flags & MP_STREAM_POLL_RD;
+        }
+    } else {
+        // A closed peer is readable too, recv() then returns EOF
+        if (socket->incoming.pbuf != NULL || socket->state == STATE_PEER_CLOSED) {
+            ret |= flags & MP_STREAM_POLL_RD;
+        }
+        if (socket->state == STATE_CONNECTED && tcp_sndbuf(socket->pcb.tcp) > 0) {
+            ret |= flags & MP_STREAM_POLL_WR;
+        }
+    }
+
+    // Errors are always reported, whether asked for or not
+    if (socket->state == ERR_RST || socket->state == ERR_CLSD) {
+        ret |= MP_STREAM_POLL_HUP;
+    } else if (socket->state < 0) {
+        ret |= MP_STREAM_POLL_ERR;
+    }
+
+    return ret;
+}
+
 STATIC const mp_map_elem_t lwip_socket_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___del__), (mp_obj_t)&lwip_socket_close_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_close), (mp_obj_t)&lwip_socket_close_obj },
@@ -1136,8 +1398,10 @@ STATIC const mp_map_elem_t lwip_socket_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_connect), (mp_obj_t)&lwip_socket_connect_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_send), (mp_obj_t)&lwip_socket_send_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_recv), (mp_obj_t)&lwip_socket_recv_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_recv_into), (mp_obj_t)&lwip_socket_recv_into_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_sendto), (mp_obj_t)&lwip_socket_sendto_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_recvfrom), (mp_obj_t)&lwip_socket_recvfrom_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_recvfrom_many), (mp_obj_t)&lwip_socket_recvfrom_many_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_sendall), (mp_obj_t)&lwip_socket_sendall_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_settimeout), (mp_obj_t)&lwip_socket_settimeout_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_setblocking), (mp_obj_t)&lwip_socket_setblocking_obj },
@@ -1145,14 +1409,17 @@ STATIC const mp_map_elem_t lwip_socket_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_makefile), (mp_obj_t)&lwip_socket_makefile_obj },
 
     { MP_OBJ_NEW_QSTR(MP_QSTR_read), (mp_obj_t)&mp_stream_read_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_readinto), (mp_obj_t)&mp_stream_readinto_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_readline), (mp_obj_t)&mp_stream_unbuffered_readline_obj},
     { MP_OBJ_NEW_QSTR(MP_QSTR_write), (mp_obj_t)&mp_stream_write_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_writev), (mp_obj_t)&mp_stream_writev_obj },
 };
 STATIC MP_DEFINE_CONST_DICT(lwip_socket_locals_dict, lwip_socket_locals_dict_table);
 
 STATIC const mp_stream_p_t lwip_socket_stream_p = {
     .read = lwip_socket_read,
     .write = lwip_socket_write,
+    .ioctl = lwip_socket_ioctl,
 };
 
 STATIC const mp_obj_type_t lwip_socket_type = {
@@ -1303,6 +1570,7 @@ STATIC const mp_map_elem_t mp_module_lwip_globals_table[] = {
 
     { MP_OBJ_NEW_QSTR(MP_QSTR_SOL_SOCKET), MP_OBJ_NEW_SMALL_INT(1) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_SO_REUSEADDR), MP_OBJ_NEW_SMALL_INT(SOF_REUSEADDR) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_SO_RCVQUEUE), MP_OBJ_NEW_SMALL_INT(SO_RCVQUEUE) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_lwip_globals, mp_module_lwip_globals_table);
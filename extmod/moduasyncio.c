@@ -0,0 +1,384 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Paul Sokolovsky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+
+#include "py/nlr.h"
+#include "py/runtime.h"
+#include "py/objgenerator.h"
+#include "py/smallint.h"
+#include "py/stream.h"
+#include "py/mphal.h"
+
+#if MICROPY_PY_UASYNCIO
+
+// Core of a cooperative scheduler, for uasyncio-like libraries.  Tasks are
+// coroutines (generators), or plain callables which are just called once.
+// What a coroutine yields tells the loop what to do with it:
+//   yield          - run again after the other ready tasks
+//   yield <int>    - run again after that many milliseconds
+//   yield loop.wait_read(obj) / loop.wait_write(obj)
+//                  - run again once obj polls as ready, via its stream ioctl
+// The timers are kept in a binary heap ordered by ticks, the ready tasks in
+// a ring and the I/O waiters in a flat array; all have the fixed size given
+// when the loop is made, so scheduling a task does not allocate.
+
+typedef struct _uasyncio_timer_t {
+    mp_uint_t time;
+    mp_uint_t id; // keeps tasks with the same time in FIFO order
+    mp_obj_t task;
+} uasyncio_timer_t;
+
+typedef struct _uasyncio_io_t {
+    mp_obj_t obj;
+    mp_uint_t (*ioctl)(mp_obj_t obj, mp_uint_t request, uintptr_t arg, int *errcode);
+    mp_uint_t flags;
+    mp_obj_t task;
+} uasyncio_io_t;
+
+typedef struct _mp_obj_loop_t {
+    mp_obj_base_t base;
+    mp_uint_t alloc;
+    mp_uint_t timer_len;
+    mp_uint_t timer_id;
+    mp_uint_t ready_head;
+    mp_uint_t ready_len;
+    mp_uint_t io_len;
+    uasyncio_timer_t *timers;
+    mp_obj_t *ready;
+    uasyncio_io_t *io;
+    mp_obj_t cur_task;
+    mp_obj_t main_task;
+    mp_obj_t main_ret;
+    bool cur_parked;
+    bool stopped;
+} mp_obj_loop_t;
+
+// Compare two times in ticks, allowing for the counter wrapping around
+STATIC inline bool time_less_than(const uasyncio_timer_t *a, const uasyncio_timer_t *b) {
+    mp_int_t diff = (int32_t)(a->time - b->time);
+    if (diff != 0) {
+        return diff < 0;
+    }
+    return (int32_t)(a->id - b->id) < 0;
+}
+
+STATIC NORETURN void raise_full(void) {
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "queue full"));
+}
+
+STATIC void ready_push(mp_obj_loop_t *self, mp_obj_t task) {
+    if (self->ready_len >= self->alloc) {
+        raise_full();
+    }
+    self->ready[(self->ready_head + self->ready_len) % self->alloc] = task;
+    self->ready_len += 1;
+}
+
+STATIC mp_obj_t ready_pop(mp_obj_loop_t *self) {
+    mp_obj_t task = self->ready[self->ready_head];
+    self->ready[self->ready_head] = MP_OBJ_NULL;
+    self->ready_head = (self->ready_head + 1) % self->alloc;
+    self->ready_len -= 1;
+    return task;
+}
+
+STATIC void timer_push(mp_obj_loop_t *self, mp_uint_t time, mp_obj_t task) {
+    if (self->timer_len >= self->alloc) {
+        raise_full();
+    }
+    uasyncio_timer_t item = {time, self->timer_id++, task};
+    // sift the new item down towards the root
+    mp_uint_t pos = self->timer_len++;
+    while (pos > 0) {
+        mp_uint_t parent_pos = (pos - 1) >> 1;
+        if (!time_less_than(&item, &self->timers[parent_pos])) {
+            break;
+        }
+        self->timers[pos] = self->timers[parent_pos];
+        pos = parent_pos;
+    }
+    self->timers[pos] = item;
+}
+
+STATIC mp_obj_t timer_pop(mp_obj_loop_t *self) {
+    uasyncio_timer_t *heap = self->timers;
+    mp_obj_t task = heap[0].task;
+    uasyncio_timer_t item = heap[--self->timer_len];
+    heap[self->timer_len].task = MP_OBJ_NULL;
+    // move the last item up from the root to where it belongs
+    mp_uint_t pos = 0;
+    mp_uint_t end_pos = self->timer_len;
+    for (;;) {
+        mp_uint_t child_pos = 2 * pos + 1;
+        if (child_pos >= end_pos) {
+            break;
+        }
+        if (child_pos + 1 < end_pos && time_less_than(&heap[child_pos + 1], &heap[child_pos])) {
+            child_pos += 1;
+        }
+        if (!time_less_than(&heap[child_pos], &item)) {
+            break;
+        }
+        heap[pos] = heap[child_pos];
+        pos = child_pos;
+    }
+    heap[pos] = item;
+    return task;
+}
+
+// Move the tasks whose time has come, and those whose I/O is ready, to the
+// ready queue
+STATIC void loop_collect(mp_obj_loop_t *self) {
+    mp_uint_t now = mp_hal_ticks_ms();
+    while (self->timer_len > 0 && (int32_t)(self->timers[0].time - now) <= 0) {
+        ready_push(self, timer_pop(self));
+    }
+
+    for (mp_uint_t i = 0; i < self->io_len;) {
+        uasyncio_io_t *io = &self->io[i];
+        int errcode;
+        mp_uint_t ret = io->ioctl(io->obj, MP_STREAM_POLL, io->flags, &errcode);
+        if (ret == 0) {
+            i++;
+            continue;
+        }
+        // ready, or an error which the task will see when it does the I/O
+        ready_push(self, io->task);
+        *io = self->io[--self->io_len];
+        self->io[self->io_len].obj = MP_OBJ_NULL;
+        self->io[self->io_len].task = MP_OBJ_NULL;
+    }
+}
+
+// Run one task, then put it back on the right queue as it asks
+STATIC void loop_run_task(mp_obj_loop_t *self, mp_obj_t task) {
+    if (!MP_OBJ_IS_TYPE(task, &mp_type_gen_instance)) {
+        self->cur_task = MP_OBJ_NULL;
+        mp_call_function_0(task);
+        return;
+    }
+
+    self->cur_task = task;
+    self->cur_parked = false;
+    mp_obj_t ret;
+    mp_vm_return_kind_t kind = mp_obj_gen_resume(task, mp_const_none, MP_OBJ_NULL, &ret);
+    self->cur_task = MP_OBJ_NULL;
+
+    switch (kind) {
+        case MP_VM_RETURN_YIELD:
+            if (self->cur_parked) {
+                // waiting for I/O
+            } else if (ret == mp_const_none) {
+                ready_push(self, task);
+            } else {
+                timer_push(self, mp_hal_ticks_ms() + mp_obj_get_int(ret), task);
+            }
+            break;
+        case MP_VM_RETURN_NORMAL:
+            if (task == self->main_task) {
+                self->main_ret = ret;
+                self->stopped = true;
+            }
+            break;
+        default:
+            nlr_raise(ret);
+    }
+}
+
+// Wait until a timer is due or some I/O may have become ready
+STATIC void loop_wait(mp_obj_loop_t *self) {
+    if (self->timer_len > 0 && (int32_t)(self->timers[0].time - mp_hal_ticks_ms()) <= 0) {
+        return;
+    }
+    #if defined(MICROPY_EVENT_WAIT_HOOK)
+    MICROPY_EVENT_WAIT_HOOK;
+    #elif defined(MICROPY_EVENT_POLL_HOOK)
+    MICROPY_EVENT_POLL_HOOK;
+    #else
+    mp_hal_delay_ms(1);
+    #endif
+}
+
+STATIC void loop_run(mp_obj_loop_t *self) {
+    self->stopped = false;
+    while (!self->stopped) {
+        loop_collect(self);
+        if (self->ready_len == 0) {
+            if (self->timer_len == 0 && self->io_len == 0) {
+                // nothing left to do
+                break;
+            }
+            loop_wait(self);
+            continue;
+        }
+        // Run the tasks which are ready now; those they make ready run on
+        // the next pass, after timers and I/O were looked at again
+        for (mp_uint_t n = self->ready_len; n > 0 && !self->stopped; --n) {
+            loop_run_task(self, ready_pop(self));
+        }
+    }
+}
+
+STATIC mp_obj_t loop_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 1, false);
+    mp_int_t alloc = 16;
+    if (n_args > 0) {
+        alloc = mp_obj_get_int(args[0]);
+        if (alloc < 1) {
+            mp_raise_ValueError("len must be positive");
+        }
+    }
+    mp_obj_loop_t *self = m_new_obj(mp_obj_loop_t);
+    self->base.type = type;
+    self->alloc = alloc;
+    self->timer_len = 0;
+    self->timer_id = 0;
+    self->ready_head = 0;
+    self->ready_len = 0;
+    self->io_len = 0;
+    self->timers = m_new0(uasyncio_timer_t, alloc);
+    self->ready = m_new0(mp_obj_t, alloc);
+    self->io = m_new0(uasyncio_io_t, alloc);
+    self->cur_task = MP_OBJ_NULL;
+    self->main_task = MP_OBJ_NULL;
+    self->main_ret = mp_const_none;
+    self->cur_parked = false;
+    self->stopped = false;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t loop_time(mp_obj_t self_in) {
+    (void)self_in;
+    return MP_OBJ_NEW_SMALL_INT(mp_hal_ticks_ms() & (MICROPY_PY_UTIME_TICKS_PERIOD - 1));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(loop_time_obj, loop_time);
+
+STATIC mp_obj_t loop_call_soon(mp_obj_t self_in, mp_obj_t task) {
+    mp_obj_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    ready_push(self, task);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(loop_call_soon_obj, loop_call_soon);
+
+STATIC mp_obj_t loop_call_later_ms(mp_obj_t self_in, mp_obj_t delay_in, mp_obj_t task) {
+    mp_obj_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    timer_push(self, mp_hal_ticks_ms() + mp_obj_get_int(delay_in), task);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(loop_call_later_ms_obj, loop_call_later_ms);
+
+STATIC mp_obj_t loop_wait_io(mp_obj_t self_in, mp_obj_t obj, mp_uint_t flags) {
+    mp_obj_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->cur_task == MP_OBJ_NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_RuntimeError, "no running task"));
+    }
+    const mp_stream_p_t *stream_p = mp_obj_get_type(obj)->protocol;
+    if (stream_p == NULL || stream_p->ioctl == NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError, "object with stream.ioctl required"));
+    }
+    if (self->io_len >= self->alloc) {
+        raise_full();
+    }
+    uasyncio_io_t *io = &self->io[self->io_len++];
+    io->obj = obj;
+    io->ioctl = stream_p->ioctl;
+    io->flags = flags;
+    io->task = self->cur_task;
+    self->cur_parked = true;
+    return mp_const_none;
+}
+
+STATIC mp_obj_t loop_wait_read(mp_obj_t self_in, mp_obj_t obj) {
+    return loop_wait_io(self_in, obj, MP_STREAM_POLL_RD);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(loop_wait_read_obj, loop_wait_read);
+
+STATIC mp_obj_t loop_wait_write(mp_obj_t self_in, mp_obj_t obj) {
+    return loop_wait_io(self_in, obj, MP_STREAM_POLL_WR);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(loop_wait_write_obj, loop_wait_write);
+
+STATIC mp_obj_t loop_run_forever(mp_obj_t self_in) {
+    mp_obj_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    self->main_task = MP_OBJ_NULL;
+    loop_run(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(loop_run_forever_obj, loop_run_forever);
+
+STATIC mp_obj_t loop_run_until_complete(mp_obj_t self_in, mp_obj_t task) {
+    mp_obj_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    ready_push(self, task);
+    self->main_task = task;
+    self->main_ret = mp_const_none;
+    loop_run(self);
+    self->main_task = MP_OBJ_NULL;
+    mp_obj_t ret = self->main_ret;
+    self->main_ret = mp_const_none;
+    return ret;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(loop_run_until_complete_obj, loop_run_until_complete);
+
+STATIC mp_obj_t loop_stop(mp_obj_t self_in) {
+    mp_obj_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    self->stopped = true;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(loop_stop_obj, loop_stop);
+
+STATIC const mp_rom_map_elem_t loop_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_time), MP_ROM_PTR(&loop_time_obj) },
+    { MP_ROM_QSTR(MP_QSTR_call_soon), MP_ROM_PTR(&loop_call_soon_obj) },
+    { MP_ROM_QSTR(MP_QSTR_call_later_ms), MP_ROM_PTR(&loop_call_later_ms_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait_read), MP_ROM_PTR(&loop_wait_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait_write), MP_ROM_PTR(&loop_wait_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_forever), MP_ROM_PTR(&loop_run_forever_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_until_complete), MP_ROM_PTR(&loop_run_until_complete_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&loop_stop_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(loop_locals_dict, loop_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_loop = {
+    { &mp_type_type },
+    .name = MP_QSTR_EventLoop,
+    .make_new = loop_make_new,
+    .locals_dict = (void*)&loop_locals_dict,
+};
+
+STATIC const mp_rom_map_elem_t mp_module_uasyncio_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR__uasyncio) },
+    { MP_ROM_QSTR(MP_QSTR_EventLoop), MP_ROM_PTR(&mp_type_loop) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_uasyncio_globals, mp_module_uasyncio_globals_table);
+
+const mp_obj_module_t mp_module_uasyncio = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_uasyncio_globals,
+};
+
+#endif // MICROPY_PY_UASYNCIO
@@ -117,10 +117,124 @@ typedef struct _mp_obj_uctypes_struct_t {
     uint32_t flags;
 } mp_obj_uctypes_struct_t;
 
+/// \class layout - Precompiled structure descriptor
+///
+/// uctypes.layout(desc) converts a descriptor dict into a table sorted by
+/// field name, with scalar fields already decoded. It can be used anywhere
+/// a descriptor dict can, and makes field access a binary search instead
+/// of a dict lookup plus decoding.
+STATIC const mp_obj_type_t uctypes_layout_type;
+
+typedef struct _uctypes_field_t {
+    qstr name;
+    bool scalar;
+    uint8_t val_type; // for scalars
+    mp_uint_t offset; // for scalars, including bitfield position and length
+    mp_obj_t desc; // the original descriptor value
+} uctypes_field_t;
+
+typedef struct _mp_obj_uctypes_layout_t {
+    mp_obj_base_t base;
+    mp_obj_t dict;
+    uint16_t *scalars; // indices of the scalar fields, in order of offset
+    mp_uint_t num_scalars;
+    mp_uint_t len;
+    uctypes_field_t fields[];
+} mp_obj_uctypes_layout_t;
+
 STATIC NORETURN void syntax_error(void) {
     nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError, "syntax error in uctypes descriptor"));
 }
 
+STATIC mp_obj_t uctypes_layout_new(mp_obj_t desc_in) {
+    if (!MP_OBJ_IS_TYPE(desc_in, &mp_type_dict)) {
+        syntax_error();
+    }
+    mp_map_t *map = &((mp_obj_dict_t*)MP_OBJ_TO_PTR(desc_in))->map;
+    mp_obj_uctypes_layout_t *o = m_new_obj_var(mp_obj_uctypes_layout_t, uctypes_field_t, map->used);
+    o->base.type = &uctypes_layout_type;
+    o->dict = desc_in;
+    o->len = 0;
+    o->num_scalars = 0;
+
+    // insertion sort by qstr, descriptors are small
+    for (mp_uint_t i = 0; i < map->alloc; i++) {
+        if (!MP_MAP_SLOT_IS_FILLED(map, i)) {
+            continue;
+        }
+        qstr name = mp_obj_str_get_qstr(map->table[i].key);
+        mp_obj_t v = map->table[i].value;
+        uctypes_field_t f = {name, false, 0, 0, v};
+        if (MP_OBJ_IS_SMALL_INT(v)) {
+            mp_int_t offset = MP_OBJ_SMALL_INT_VALUE(v);
+            f.scalar = true;
+            f.val_type = GET_TYPE(offset, VAL_TYPE_BITS);
+            f.offset = offset & VALUE_MASK(VAL_TYPE_BITS);
+            o->num_scalars += 1;
+        } else if (!MP_OBJ_IS_TYPE(v, &mp_type_tuple)) {
+            syntax_error();
+        }
+        mp_uint_t j = o->len++;
+        for (; j > 0 && o->fields[j - 1].name > name; j--) {
+            o->fields[j] = o->fields[j - 1];
+        }
+        o->fields[j] = f;
+    }
+
+    // scalar fields in order of offset (and bit position), for unpack()
+    o->scalars = m_new(uint16_t, o->num_scalars);
+    mp_uint_t n = 0;
+    for (mp_uint_t i = 0; i < o->len; i++) {
+        if (!o->fields[i].scalar) {
+            continue;
+        }
+        mp_uint_t key = o->fields[i].offset & ((1 << OFFSET_BITS) - 1);
+        key = key << BITF_OFF_BITS | ((o->fields[i].offset >> OFFSET_BITS) & ((1 << BITF_OFF_BITS) - 1));
+        mp_uint_t j = n++;
+        for (; j > 0; j--) {
+            const uctypes_field_t *prev = &o->fields[o->scalars[j - 1]];
+            mp_uint_t prev_key = prev->offset & ((1 << OFFSET_BITS) - 1);
+            prev_key = prev_key << BITF_OFF_BITS | ((prev->offset >> OFFSET_BITS) & ((1 << BITF_OFF_BITS) - 1));
+            if (prev_key <= key) {
+                break;
+            }
+            o->scalars[j] = o->scalars[j - 1];
+        }
+        o->scalars[j] = i;
+    }
+
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC const uctypes_field_t *uctypes_layout_find(mp_obj_uctypes_layout_t *layout, qstr name) {
+    mp_uint_t lo = 0;
+    mp_uint_t hi = layout->len;
+    while (lo < hi) {
+        mp_uint_t mid = (lo + hi) / 2;
+        if (layout->fields[mid].name < name) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < layout->len && layout->fields[lo].name == name) {
+        return &layout->fields[lo];
+    }
+    return NULL;
+}
+
+STATIC void uctypes_layout_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mp_obj_uctypes_layout_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<layout %u fields>", (uint)self->len);
+}
+
+STATIC const mp_obj_type_t uctypes_layout_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_layout,
+    .print = uctypes_layout_print,
+};
+
 STATIC mp_obj_t uctypes_struct_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 2, 3, false);
     mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
@@ -138,7 +252,7 @@ STATIC void uctypes_struct_print(const mp_print_t *print, mp_obj_t self_in, mp_p
     (void)kind;
     mp_obj_uctypes_struct_t *self = MP_OBJ_TO_PTR(self_in);
     const char *typen = "unk";
-    if (MP_OBJ_IS_TYPE(self->desc, &mp_type_dict)) {
+    if (MP_OBJ_IS_TYPE(self->desc, &mp_type_dict) || MP_OBJ_IS_TYPE(self->desc, &uctypes_layout_type)) {
         typen = "STRUCT";
     } else if (MP_OBJ_IS_TYPE(self->desc, &mp_type_tuple)) {
         mp_obj_tuple_t *t = MP_OBJ_TO_PTR(self->desc);
@@ -207,6 +321,9 @@ STATIC mp_uint_t uctypes_struct_agg_size(mp_obj_tuple_t *t, int layout_type, mp_
 }
 
 STATIC mp_uint_t uctypes_struct_size(mp_obj_t desc_in, int layout_type, mp_uint_t *max_field_size) {
+    if (MP_OBJ_IS_TYPE(desc_in, &uctypes_layout_type)) {
+        desc_in = ((mp_obj_uctypes_layout_t*)MP_OBJ_TO_PTR(desc_in))->dict;
+    }
     if (!MP_OBJ_IS_TYPE(desc_in, &mp_type_dict)) {
         if (MP_OBJ_IS_TYPE(desc_in, &mp_type_tuple)) {
             return uctypes_struct_agg_size((mp_obj_tuple_t*)MP_OBJ_TO_PTR(desc_in), layout_type, max_field_size);
@@ -388,74 +505,88 @@ STATIC void set_aligned(uint val_type, void *p, mp_int_t index, mp_obj_t val) {
     }
 }
 
-STATIC mp_obj_t uctypes_struct_attr_op(mp_obj_t self_in, qstr attr, mp_obj_t set_val) {
-    mp_obj_uctypes_struct_t *self = MP_OBJ_TO_PTR(self_in);
-
-    // TODO: Support at least OrderedDict in addition
-    if (!MP_OBJ_IS_TYPE(self->desc, &mp_type_dict)) {
-            nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError, "struct: no fields"));
-    }
-
-    mp_obj_t deref = mp_obj_dict_get(self->desc, MP_OBJ_NEW_QSTR(attr));
-    if (MP_OBJ_IS_SMALL_INT(deref)) {
-        mp_int_t offset = MP_OBJ_SMALL_INT_VALUE(deref);
-        mp_uint_t val_type = GET_TYPE(offset, VAL_TYPE_BITS);
-        offset &= VALUE_MASK(VAL_TYPE_BITS);
-//printf("scalar type=%d offset=%x\n", val_type, offset);
-
-        if (val_type <= INT64 || val_type == FLOAT32 || val_type == FLOAT64) {
+// Get or set a scalar field, given its type and offset as decoded from the
+// descriptor (with bitfield position and length still in the offset).
+STATIC mp_obj_t uctypes_struct_scalar_op(mp_obj_uctypes_struct_t *self, mp_uint_t val_type, mp_int_t offset, mp_obj_t set_val) {
+    if (val_type <= INT64 || val_type == FLOAT32 || val_type == FLOAT64) {
 //            printf("size=%d\n", GET_SCALAR_SIZE(val_type));
-            if (self->flags == LAYOUT_NATIVE) {
-                if (set_val == MP_OBJ_NULL) {
-                    return get_aligned(val_type, self->addr + offset, 0);
-                } else {
-                    set_aligned(val_type, self->addr + offset, 0, set_val);
-                    return set_val; // just !MP_OBJ_NULL
-                }
-            } else {
-                if (set_val == MP_OBJ_NULL) {
-                    return get_unaligned(val_type, self->addr + offset, self->flags);
-                } else {
-                    set_unaligned(val_type, self->addr + offset, self->flags, set_val);
-                    return set_val; // just !MP_OBJ_NULL
-                }
-            }
-        } else if (val_type >= BFUINT8 && val_type <= BFINT32) {
-            uint bit_offset = (offset >> 17) & 31;
-            uint bit_len = (offset >> 22) & 31;
-            offset &= (1 << 17) - 1;
-            mp_uint_t val;
-            if (self->flags == LAYOUT_NATIVE) {
-                val = get_aligned_basic(val_type & 6, self->addr + offset);
+        if (self->flags == LAYOUT_NATIVE) {
+            if (set_val == MP_OBJ_NULL) {
+                return get_aligned(val_type, self->addr + offset, 0);
             } else {
-                val = mp_binary_get_int(GET_SCALAR_SIZE(val_type & 7), val_type & 1, self->flags, self->addr + offset);
+                set_aligned(val_type, self->addr + offset, 0, set_val);
+                return set_val; // just !MP_OBJ_NULL
             }
+        } else {
             if (set_val == MP_OBJ_NULL) {
-                val >>= bit_offset;
-                val &= (1 << bit_len) - 1;
-                // TODO: signed
-                assert((val_type & 1) == 0);
-                return mp_obj_new_int(val);
+                return get_unaligned(val_type, self->addr + offset, self->flags);
             } else {
-                mp_uint_t set_val_int = (mp_uint_t)mp_obj_get_int(set_val);
-                mp_uint_t mask = (1 << bit_len) - 1;
-                set_val_int &= mask;
-                set_val_int <<= bit_offset;
-                mask <<= bit_offset;
-                val = (val & ~mask) | set_val_int;
-
-                if (self->flags == LAYOUT_NATIVE) {
-                    set_aligned_basic(val_type & 6, self->addr + offset, val);
-                } else {
-                    mp_binary_set_int(GET_SCALAR_SIZE(val_type & 7), self->flags == LAYOUT_BIG_ENDIAN,
-                        self->addr + offset, val);
-                }
+                set_unaligned(val_type, self->addr + offset, self->flags, set_val);
                 return set_val; // just !MP_OBJ_NULL
             }
         }
+    } else if (val_type >= BFUINT8 && val_type <= BFINT32) {
+        uint bit_offset = (offset >> 17) & 31;
+        uint bit_len = (offset >> 22) & 31;
+        offset &= (1 << 17) - 1;
+        mp_uint_t val;
+        if (self->flags == LAYOUT_NATIVE) {
+            val = get_aligned_basic(val_type & 6, self->addr + offset);
+        } else {
+            val = mp_binary_get_int(GET_SCALAR_SIZE(val_type & 7), val_type & 1, self->flags, self->addr + offset);
+        }
+        if (set_val == MP_OBJ_NULL) {
+            val >>= bit_offset;
+            val &= (1 << bit_len) - 1;
+            // TODO: signed
+            assert((val_type & 1) == 0);
+            return mp_obj_new_int(val);
+        } else {
+            mp_uint_t set_val_int = (mp_uint_t)mp_obj_get_int(set_val);
+            mp_uint_t mask = (1 << bit_len) - 1;
+            set_val_int &= mask;
+            set_val_int <<= bit_offset;
+            mask <<= bit_offset;
+            val = (val & ~mask) | set_val_int;
 
-        assert(0);
-        return MP_OBJ_NULL;
+            if (self->flags == LAYOUT_NATIVE) {
+                set_aligned_basic(val_type & 6, self->addr + offset, val);
+            } else {
+                mp_binary_set_int(GET_SCALAR_SIZE(val_type & 7), self->flags == LAYOUT_BIG_ENDIAN,
+                    self->addr + offset, val);
+            }
+            return set_val; // just !MP_OBJ_NULL
+        }
+    }
+
+    assert(0);
+    return MP_OBJ_NULL;
+}
+
+STATIC mp_obj_t uctypes_struct_attr_op(mp_obj_t self_in, qstr attr, mp_obj_t set_val) {
+    mp_obj_uctypes_struct_t *self = MP_OBJ_TO_PTR(self_in);
+
+    mp_obj_t deref;
+    if (MP_OBJ_IS_TYPE(self->desc, &uctypes_layout_type)) {
+        const uctypes_field_t *f = uctypes_layout_find(MP_OBJ_TO_PTR(self->desc), attr);
+        if (f == NULL) {
+            nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, MP_OBJ_NEW_QSTR(attr)));
+        }
+        if (f->scalar) {
+            return uctypes_struct_scalar_op(self, f->val_type, f->offset, set_val);
+        }
+        deref = f->desc;
+    } else {
+        // TODO: Support at least OrderedDict in addition
+        if (!MP_OBJ_IS_TYPE(self->desc, &mp_type_dict)) {
+                nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError, "struct: no fields"));
+        }
+
+        deref = mp_obj_dict_get(self->desc, MP_OBJ_NEW_QSTR(attr));
+        if (MP_OBJ_IS_SMALL_INT(deref)) {
+            mp_int_t offset = MP_OBJ_SMALL_INT_VALUE(deref);
+            return uctypes_struct_scalar_op(self, GET_TYPE(offset, VAL_TYPE_BITS), offset & VALUE_MASK(VAL_TYPE_BITS), set_val);
+        }
     }
 
     if (!MP_OBJ_IS_TYPE(deref, &mp_type_tuple)) {
@@ -608,6 +739,48 @@ STATIC mp_int_t uctypes_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo,
     return 0;
 }
 
+/// \function layout()
+/// Precompile a structure descriptor dict, see the layout class.
+STATIC mp_obj_t uctypes_struct_layout(mp_obj_t desc_in) {
+    return uctypes_layout_new(desc_in);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(uctypes_struct_layout_obj, uctypes_struct_layout);
+
+/// \function unpack()
+/// Read several fields of a structure in one call and return them as a
+/// tuple: the fields named in the given sequence, or by default all scalar
+/// fields in order of their offset.
+STATIC mp_obj_t uctypes_struct_unpack(size_t n_args, const mp_obj_t *args) {
+    if (!MP_OBJ_IS_TYPE(args[0], &uctypes_struct_type)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError, "struct expected"));
+    }
+    mp_obj_uctypes_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    if (n_args > 1) {
+        mp_uint_t len;
+        mp_obj_t *names;
+        mp_obj_get_array(args[1], &len, &names);
+        mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(len, NULL));
+        for (mp_uint_t i = 0; i < len; i++) {
+            t->items[i] = uctypes_struct_attr_op(args[0], mp_obj_str_get_qstr(names[i]), MP_OBJ_NULL);
+        }
+        return MP_OBJ_FROM_PTR(t);
+    }
+
+    mp_obj_t layout_in = self->desc;
+    if (!MP_OBJ_IS_TYPE(layout_in, &uctypes_layout_type)) {
+        layout_in = uctypes_layout_new(layout_in);
+    }
+    mp_obj_uctypes_layout_t *layout = MP_OBJ_TO_PTR(layout_in);
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(layout->num_scalars, NULL));
+    for (mp_uint_t i = 0; i < layout->num_scalars; i++) {
+        const uctypes_field_t *f = &layout->fields[layout->scalars[i]];
+        t->items[i] = uctypes_struct_scalar_op(self, f->val_type, f->offset, MP_OBJ_NULL);
+    }
+    return MP_OBJ_FROM_PTR(t);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(uctypes_struct_unpack_obj, 1, 2, uctypes_struct_unpack);
+
 /// \function addressof()
 /// Return address of object's data (applies to object providing buffer
 /// interface).
@@ -651,6 +824,8 @@ STATIC const mp_rom_map_elem_t mp_module_uctypes_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uctypes) },
     { MP_ROM_QSTR(MP_QSTR_struct), MP_ROM_PTR(&uctypes_struct_type) },
     { MP_ROM_QSTR(MP_QSTR_sizeof), MP_ROM_PTR(&uctypes_struct_sizeof_obj) },
+    { MP_ROM_QSTR(MP_QSTR_layout), MP_ROM_PTR(&uctypes_struct_layout_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&uctypes_struct_unpack_obj) },
     { MP_ROM_QSTR(MP_QSTR_addressof), MP_ROM_PTR(&uctypes_struct_addressof_obj) },
     { MP_ROM_QSTR(MP_QSTR_bytes_at), MP_ROM_PTR(&uctypes_struct_bytes_at_obj) },
     { MP_ROM_QSTR(MP_QSTR_bytearray_at), MP_ROM_PTR(&uctypes_struct_bytearray_at_obj) },
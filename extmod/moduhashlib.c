@@ -32,84 +32,94 @@
 
 #if MICROPY_PY_UHASHLIB
 
-#include "crypto-algorithms/sha256.h"
+#include "extmod/moduhashlib.h"
+
+// Portable implementations, used unless the port provides its own
+
+#ifndef MICROPY_PY_UHASHLIB_SHA256_IMPL
+#include "crypto-algorithms/sha256.c"
+STATIC const mp_uhashlib_impl_t uhashlib_sha256_impl = {
+    .ctx_size = sizeof(CRYAL_SHA256_CTX),
+    .digest_size = SHA256_BLOCK_SIZE,
+    .init = (void(*)(void*))sha256_init,
+    .update = (void(*)(void*, const uint8_t*, size_t))sha256_update,
+    .final = (void(*)(void*, uint8_t*))sha256_final,
+};
+#define MICROPY_PY_UHASHLIB_SHA256_IMPL uhashlib_sha256_impl
+#else
+extern const mp_uhashlib_impl_t MICROPY_PY_UHASHLIB_SHA256_IMPL;
+#endif
+
 #if MICROPY_PY_UHASHLIB_SHA1
-#include "lib/axtls/crypto/crypto.h"
+#ifndef MICROPY_PY_UHASHLIB_SHA1_IMPL
+#include "crypto-algorithms/sha1.c"
+STATIC const mp_uhashlib_impl_t uhashlib_sha1_impl = {
+    .ctx_size = sizeof(CRYAL_SHA1_CTX),
+    .digest_size = SHA1_BLOCK_SIZE,
+    .init = (void(*)(void*))sha1_init,
+    .update = (void(*)(void*, const uint8_t*, size_t))sha1_update,
+    .final = (void(*)(void*, uint8_t*))sha1_final,
+};
+#define MICROPY_PY_UHASHLIB_SHA1_IMPL uhashlib_sha1_impl
+#else
+extern const mp_uhashlib_impl_t MICROPY_PY_UHASHLIB_SHA1_IMPL;
+#endif
+#endif
+
+#if MICROPY_PY_UHASHLIB_MD5
+#ifndef MICROPY_PY_UHASHLIB_MD5_IMPL
+#include "crypto-algorithms/md5.c"
+STATIC const mp_uhashlib_impl_t uhashlib_md5_impl = {
+    .ctx_size = sizeof(CRYAL_MD5_CTX),
+    .digest_size = MD5_BLOCK_SIZE,
+    .init = (void(*)(void*))md5_init,
+    .update = (void(*)(void*, const uint8_t*, size_t))md5_update,
+    .final = (void(*)(void*, uint8_t*))md5_final,
+};
+#define MICROPY_PY_UHASHLIB_MD5_IMPL uhashlib_md5_impl
+#else
+extern const mp_uhashlib_impl_t MICROPY_PY_UHASHLIB_MD5_IMPL;
+#endif
 #endif
 
 typedef struct _mp_obj_hash_t {
     mp_obj_base_t base;
-    char state[0];
+    const mp_uhashlib_impl_t *impl;
+    uint64_t state[0]; // aligned for any context structure
 } mp_obj_hash_t;
 
 STATIC mp_obj_t hash_update(mp_obj_t self_in, mp_obj_t arg);
 
-STATIC mp_obj_t hash_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+STATIC mp_obj_t hash_new(const mp_obj_type_t *type, const mp_uhashlib_impl_t *impl, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 0, 1, false);
-    mp_obj_hash_t *o = m_new_obj_var(mp_obj_hash_t, char, sizeof(CRYAL_SHA256_CTX));
+    mp_obj_hash_t *o = m_new_obj_var(mp_obj_hash_t, char, impl->ctx_size);
     o->base.type = type;
-    sha256_init((CRYAL_SHA256_CTX*)o->state);
+    o->impl = impl;
+    impl->init(o->state);
     if (n_args == 1) {
         hash_update(MP_OBJ_FROM_PTR(o), args[0]);
     }
     return MP_OBJ_FROM_PTR(o);
 }
 
-#if MICROPY_PY_UHASHLIB_SHA1
-STATIC mp_obj_t sha1_update(mp_obj_t self_in, mp_obj_t arg);
-
-STATIC mp_obj_t sha1_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
-    mp_arg_check_num(n_args, n_kw, 0, 1, false);
-    mp_obj_hash_t *o = m_new_obj_var(mp_obj_hash_t, char, sizeof(SHA1_CTX));
-    o->base.type = type;
-    SHA1_Init((SHA1_CTX*)o->state);
-    if (n_args == 1) {
-        sha1_update(MP_OBJ_FROM_PTR(o), args[0]);
-    }
-    return MP_OBJ_FROM_PTR(o);
-}
-#endif
-
 STATIC mp_obj_t hash_update(mp_obj_t self_in, mp_obj_t arg) {
     mp_obj_hash_t *self = MP_OBJ_TO_PTR(self_in);
     mp_buffer_info_t bufinfo;
     mp_get_buffer_raise(arg, &bufinfo, MP_BUFFER_READ);
-    sha256_update((CRYAL_SHA256_CTX*)self->state, bufinfo.buf, bufinfo.len);
+    self->impl->update(self->state, bufinfo.buf, bufinfo.len);
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_2(hash_update_obj, hash_update);
 
-#if MICROPY_PY_UHASHLIB_SHA1
-STATIC mp_obj_t sha1_update(mp_obj_t self_in, mp_obj_t arg) {
-    mp_obj_hash_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(arg, &bufinfo, MP_BUFFER_READ);
-    SHA1_Update((SHA1_CTX*)self->state, bufinfo.buf, bufinfo.len);
-    return mp_const_none;
-}
-MP_DEFINE_CONST_FUN_OBJ_2(sha1_update_obj, sha1_update);
-#endif
-
 STATIC mp_obj_t hash_digest(mp_obj_t self_in) {
     mp_obj_hash_t *self = MP_OBJ_TO_PTR(self_in);
     vstr_t vstr;
-    vstr_init_len(&vstr, SHA256_BLOCK_SIZE);
-    sha256_final((CRYAL_SHA256_CTX*)self->state, (byte*)vstr.buf);
+    vstr_init_len(&vstr, self->impl->digest_size);
+    self->impl->final(self->state, (byte*)vstr.buf);
     return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(hash_digest_obj, hash_digest);
 
-#if MICROPY_PY_UHASHLIB_SHA1
-STATIC mp_obj_t sha1_digest(mp_obj_t self_in) {
-    mp_obj_hash_t *self = MP_OBJ_TO_PTR(self_in);
-    vstr_t vstr;
-    vstr_init_len(&vstr, SHA1_SIZE);
-    SHA1_Final((byte*)vstr.buf, (SHA1_CTX*)self->state);
-    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
-}
-MP_DEFINE_CONST_FUN_OBJ_1(sha1_digest_obj, sha1_digest);
-#endif
-
 STATIC const mp_rom_map_elem_t hash_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_update), MP_ROM_PTR(&hash_update_obj) },
     { MP_ROM_QSTR(MP_QSTR_digest), MP_ROM_PTR(&hash_digest_obj) },
@@ -117,25 +127,40 @@ STATIC const mp_rom_map_elem_t hash_locals_dict_table[] = {
 
 STATIC MP_DEFINE_CONST_DICT(hash_locals_dict, hash_locals_dict_table);
 
+STATIC mp_obj_t sha256_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    return hash_new(type, &MICROPY_PY_UHASHLIB_SHA256_IMPL, n_args, n_kw, args);
+}
+
 STATIC const mp_obj_type_t sha256_type = {
     { &mp_type_type },
     .name = MP_QSTR_sha256,
-    .make_new = hash_make_new,
+    .make_new = sha256_make_new,
     .locals_dict = (void*)&hash_locals_dict,
 };
 
 #if MICROPY_PY_UHASHLIB_SHA1
-STATIC const mp_rom_map_elem_t sha1_locals_dict_table[] = {
-    { MP_ROM_QSTR(MP_QSTR_update), MP_ROM_PTR(&sha1_update_obj) },
-    { MP_ROM_QSTR(MP_QSTR_digest), MP_ROM_PTR(&sha1_digest_obj) },
-};
-STATIC MP_DEFINE_CONST_DICT(sha1_locals_dict, sha1_locals_dict_table);
+STATIC mp_obj_t sha1_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    return hash_new(type, &MICROPY_PY_UHASHLIB_SHA1_IMPL, n_args, n_kw, args);
+}
 
 STATIC const mp_obj_type_t sha1_type = {
     { &mp_type_type },
     .name = MP_QSTR_sha1,
     .make_new = sha1_make_new,
-    .locals_dict = (void*)&sha1_locals_dict,
+    .locals_dict = (void*)&hash_locals_dict,
+};
+#endif
+
+#if MICROPY_PY_UHASHLIB_MD5
+STATIC mp_obj_t md5_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    return hash_new(type, &MICROPY_PY_UHASHLIB_MD5_IMPL, n_args, n_kw, args);
+}
+
+STATIC const mp_obj_type_t md5_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_md5,
+    .make_new = md5_make_new,
+    .locals_dict = (void*)&hash_locals_dict,
 };
 #endif
 
@@ -145,6 +170,9 @@ STATIC const mp_rom_map_elem_t mp_module_hashlib_globals_table[] = {
     #if MICROPY_PY_UHASHLIB_SHA1
     { MP_ROM_QSTR(MP_QSTR_sha1), MP_ROM_PTR(&sha1_type) },
     #endif
+    #if MICROPY_PY_UHASHLIB_MD5
+    { MP_ROM_QSTR(MP_QSTR_md5), MP_ROM_PTR(&md5_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_hashlib_globals, mp_module_hashlib_globals_table);
@@ -154,6 +182,4 @@ const mp_obj_module_t mp_module_uhashlib = {
     .globals = (mp_obj_dict_t*)&mp_module_hashlib_globals,
 };
 
-#include "crypto-algorithms/sha256.c"
-
 #endif //MICROPY_PY_UHASHLIB
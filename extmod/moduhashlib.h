@@ -0,0 +1,43 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Paul Sokolovsky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef MICROPY_INCLUDED_EXTMOD_MODUHASHLIB_H
+#define MICROPY_INCLUDED_EXTMOD_MODUHASHLIB_H
+
+#include "py/obj.h"
+
+// A hash algorithm implementation.  The portable C code is used by default,
+// but a port can supply its own, eg using ROM code or a hash peripheral, by
+// defining MICROPY_PY_UHASHLIB_<ALGO>_IMPL to the name of one of these.
+typedef struct _mp_uhashlib_impl_t {
+    uint16_t ctx_size;
+    uint16_t digest_size;
+    void (*init)(void *ctx);
+    void (*update)(void *ctx, const uint8_t *data, size_t len);
+    void (*final)(void *ctx, uint8_t *digest);
+} mp_uhashlib_impl_t;
+
+#endif // MICROPY_INCLUDED_EXTMOD_MODUHASHLIB_H
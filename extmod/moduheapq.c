@@ -105,11 +105,218 @@ STATIC mp_obj_t mod_uheapq_heapify(mp_obj_t heap_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_uheapq_heapify_obj, mod_uheapq_heapify);
 
+#if MICROPY_PY_UHEAPQ_PRIORITYQUEUE
+
+// A priority queue of objects with int priorities.  Entries live in a table
+// that doesn't move them, so that the index of an entry is a handle for it,
+// and the heap is an array of those indices.  Comparisons are of ints in C.
+
+typedef struct _pq_entry_t {
+    mp_int_t prio;
+    mp_obj_t obj; // MP_OBJ_NULL for a free entry
+    size_t pos; // position in the heap, or the next free entry
+} pq_entry_t;
+
+typedef struct _mp_obj_pq_t {
+    mp_obj_base_t base;
+    size_t len;
+    size_t alloc;
+    size_t free; // first free entry, alloc if none
+    pq_entry_t *entries;
+    size_t *heap;
+} mp_obj_pq_t;
+
+STATIC void pq_set(mp_obj_pq_t *self, size_t pos, size_t e) {
+    self->heap[pos] = e;
+    self->entries[e].pos = pos;
+}
+
+STATIC void pq_siftdown(mp_obj_pq_t *self, size_t pos) {
+    size_t e = self->heap[pos];
+    mp_int_t prio = self->entries[e].prio;
+    while (pos > 0) {
+        size_t parent_pos = (pos - 1) >> 1;
+        size_t parent = self->heap[parent_pos];
+        if (prio >= self->entries[parent].prio) {
+            break;
+        }
+        pq_set(self, pos, parent);
+        pos = parent_pos;
+    }
+    pq_set(self, pos, e);
+}
+
+STATIC void pq_siftup(mp_obj_pq_t *self, size_t pos) {
+    size_t e = self->heap[pos];
+    mp_int_t prio = self->entries[e].prio;
+    for (size_t child_pos = 2 * pos + 1; child_pos < self->len; child_pos = 2 * pos + 1) {
+        size_t child = self->heap[child_pos];
+        if (child_pos + 1 < self->len && self->entries[self->heap[child_pos + 1]].prio < self->entries[child].prio) {
+            child = self->heap[++child_pos];
+        }
+        if (prio <= self->entries[child].prio) {
+            break;
+        }
+        pq_set(self, pos, child);
+        pos = child_pos;
+    }
+    pq_set(self, pos, e);
+}
+
+// move the entry at pos to where its priority puts it
+STATIC void pq_fix(mp_obj_pq_t *self, size_t pos) {
+    if (pos > 0 && self->entries[self->heap[pos]].prio < self->entries[self->heap[(pos - 1) >> 1]].prio) {
+        pq_siftdown(self, pos);
+    } else {
+        pq_siftup(self, pos);
+    }
+}
+
+STATIC mp_obj_t pq_remove_at(mp_obj_pq_t *self, size_t pos) {
+    size_t e = self->heap[pos];
+    mp_obj_t obj = self->entries[e].obj;
+    self->entries[e].obj = MP_OBJ_NULL; // so we don't retain a pointer
+    self->entries[e].pos = self->free;
+    self->free = e;
+    self->len -= 1;
+    if (pos < self->len) {
+        pq_set(self, pos, self->heap[self->len]);
+        pq_fix(self, pos);
+    }
+    return obj;
+}
+
+STATIC pq_entry_t *pq_get_entry(mp_obj_pq_t *self, mp_obj_t handle_in) {
+    mp_uint_t e = mp_obj_get_int(handle_in);
+    if (e >= self->alloc || self->entries[e].obj == MP_OBJ_NULL) {
+        mp_raise_ValueError("invalid handle");
+    }
+    return &self->entries[e];
+}
+
+STATIC size_t pq_first(mp_obj_pq_t *self) {
+    if (self->len == 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "empty heap"));
+    }
+    return self->heap[0];
+}
+
+STATIC mp_obj_t pq_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 1, false);
+    size_t alloc = n_args > 0 ? mp_obj_get_int(args[0]) : 0;
+    if (alloc < 4) {
+        alloc = 4;
+    }
+    mp_obj_pq_t *self = m_new_obj(mp_obj_pq_t);
+    self->base.type = type;
+    self->len = 0;
+    self->alloc = alloc;
+    self->free = 0;
+    self->entries = m_new(pq_entry_t, alloc);
+    self->heap = m_new(size_t, alloc);
+    for (size_t i = 0; i < alloc; i++) {
+        self->entries[i].obj = MP_OBJ_NULL;
+        self->entries[i].pos = i + 1;
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t pq_push(mp_obj_t self_in, mp_obj_t prio_in, mp_obj_t obj) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t prio = mp_obj_get_int(prio_in);
+    if (self->free == self->alloc) {
+        // all entries are in use, so double the table and the heap
+        size_t alloc = self->alloc * 2;
+        self->entries = m_renew(pq_entry_t, self->entries, self->alloc, alloc);
+        self->heap = m_renew(size_t, self->heap, self->alloc, alloc);
+        for (size_t i = self->alloc; i < alloc; i++) {
+            self->entries[i].obj = MP_OBJ_NULL;
+            self->entries[i].pos = i + 1;
+        }
+        self->alloc = alloc;
+    }
+    size_t e = self->free;
+    self->free = self->entries[e].pos;
+    self->entries[e].prio = prio;
+    self->entries[e].obj = obj;
+    self->heap[self->len] = e;
+    pq_siftdown(self, self->len++);
+    return MP_OBJ_NEW_SMALL_INT(e);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(pq_push_obj, pq_push);
+
+STATIC mp_obj_t pq_pop(mp_obj_t self_in) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    pq_first(self);
+    return pq_remove_at(self, 0);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pq_pop_obj, pq_pop);
+
+STATIC mp_obj_t pq_peek(mp_obj_t self_in) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    return self->entries[pq_first(self)].obj;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pq_peek_obj, pq_peek);
+
+STATIC mp_obj_t pq_peekprio(mp_obj_t self_in) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(self->entries[pq_first(self)].prio);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pq_peekprio_obj, pq_peekprio);
+
+STATIC mp_obj_t pq_remove(mp_obj_t self_in, mp_obj_t handle_in) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    return pq_remove_at(self, pq_get_entry(self, handle_in)->pos);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(pq_remove_obj, pq_remove);
+
+STATIC mp_obj_t pq_update(mp_obj_t self_in, mp_obj_t handle_in, mp_obj_t prio_in) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    pq_entry_t *entry = pq_get_entry(self, handle_in);
+    entry->prio = mp_obj_get_int(prio_in);
+    pq_fix(self, entry->pos);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(pq_update_obj, pq_update);
+
+STATIC mp_obj_t pq_unary_op(mp_uint_t op, mp_obj_t self_in) {
+    mp_obj_pq_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(self->len != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(self->len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+STATIC const mp_rom_map_elem_t pq_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_push), MP_ROM_PTR(&pq_push_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pop), MP_ROM_PTR(&pq_pop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_peek), MP_ROM_PTR(&pq_peek_obj) },
+    { MP_ROM_QSTR(MP_QSTR_peekprio), MP_ROM_PTR(&pq_peekprio_obj) },
+    { MP_ROM_QSTR(MP_QSTR_remove), MP_ROM_PTR(&pq_remove_obj) },
+    { MP_ROM_QSTR(MP_QSTR_update), MP_ROM_PTR(&pq_update_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(pq_locals_dict, pq_locals_dict_table);
+
+STATIC const mp_obj_type_t pq_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_PriorityQueue,
+    .make_new = pq_make_new,
+    .unary_op = pq_unary_op,
+    .locals_dict = (void*)&pq_locals_dict,
+};
+
+#endif // MICROPY_PY_UHEAPQ_PRIORITYQUEUE
+
 STATIC const mp_rom_map_elem_t mp_module_uheapq_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uheapq) },
     { MP_ROM_QSTR(MP_QSTR_heappush), MP_ROM_PTR(&mod_uheapq_heappush_obj) },
     { MP_ROM_QSTR(MP_QSTR_heappop), MP_ROM_PTR(&mod_uheapq_heappop_obj) },
     { MP_ROM_QSTR(MP_QSTR_heapify), MP_ROM_PTR(&mod_uheapq_heapify_obj) },
+    #if MICROPY_PY_UHEAPQ_PRIORITYQUEUE
+    { MP_ROM_QSTR(MP_QSTR_PriorityQueue), MP_ROM_PTR(&pq_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_uheapq_globals, mp_module_uheapq_globals_table);
@@ -25,9 +25,11 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "py/nlr.h"
 #include "py/objlist.h"
+#include "py/objstr.h"
 #include "py/objstringio.h"
 #include "py/parsenum.h"
 #include "py/runtime.h"
@@ -44,6 +46,110 @@ STATIC mp_obj_t mod_ujson_dumps(mp_obj_t obj) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_dumps_obj, mod_ujson_dumps);
 
+// ujson.dump writes through a small buffer, so that the output never needs
+// to be held in full and the stream doesn't get a write call per token.
+
+typedef struct _ujson_dump_t {
+    mp_obj_t stream_obj;
+    size_t len;
+    byte buf[MICROPY_PY_UJSON_WRITE_BUF_SIZE];
+} ujson_dump_t;
+
+STATIC void ujson_dump_write(mp_obj_t stream_obj, const void *buf, size_t len) {
+    int errcode;
+    mp_stream_rw(stream_obj, (void*)buf, len, &errcode, MP_STREAM_RW_WRITE);
+    if (errcode != 0) {
+        mp_raise_OSError(errcode);
+    }
+}
+
+STATIC void ujson_dump_strn(void *data, const char *str, size_t len) {
+    ujson_dump_t *d = data;
+    if (d->len + len > sizeof(d->buf)) {
+        ujson_dump_write(d->stream_obj, d->buf, d->len);
+        d->len = 0;
+        if (len >= sizeof(d->buf)) {
+            ujson_dump_write(d->stream_obj, str, len);
+            return;
+        }
+    }
+    memcpy(d->buf + d->len, str, len);
+    d->len += len;
+}
+
+STATIC mp_obj_t mod_ujson_dump(mp_obj_t obj, mp_obj_t stream_obj) {
+    mp_get_stream_raise(stream_obj, MP_STREAM_OP_WRITE);
+    ujson_dump_t d;
+    d.stream_obj = stream_obj;
+    d.len = 0;
+    mp_print_t print = {&d, ujson_dump_strn};
+    mp_obj_print_helper(&print, obj, PRINT_JSON);
+    ujson_dump_write(stream_obj, d.buf, d.len);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_ujson_dump_obj, mod_ujson_dump);
+
+// ujson.iterencode(obj) yields the JSON encoding of obj as a sequence of
+// strings.  For a list, tuple or dict there is one string for the opening
+// bracket, one for each element or key/value pair and one for the closing
+// bracket, so only one element's encoding is in memory at a time.  Any
+// other object gives a single string.
+
+typedef struct _ujson_iterencode_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_t obj;
+    mp_obj_t iter; // over the elements or keys of obj once started
+    bool first;
+    bool done;
+} ujson_iterencode_t;
+
+STATIC mp_obj_t ujson_iterencode_iternext(mp_obj_t self_in) {
+    ujson_iterencode_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->done) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    bool is_dict = MP_OBJ_IS_TYPE(self->obj, &mp_type_dict);
+    if (!is_dict && !MP_OBJ_IS_TYPE(self->obj, &mp_type_list) && !MP_OBJ_IS_TYPE(self->obj, &mp_type_tuple)) {
+        self->done = true;
+        return mod_ujson_dumps(self->obj);
+    }
+    if (self->iter == MP_OBJ_NULL) {
+        self->iter = mp_getiter(self->obj);
+        return mp_obj_new_str(is_dict ? "{" : "[", 1, true);
+    }
+    mp_obj_t item = mp_iternext(self->iter);
+    if (item == MP_OBJ_STOP_ITERATION) {
+        self->done = true;
+        return mp_obj_new_str(is_dict ? "}" : "]", 1, true);
+    }
+    vstr_t vstr;
+    mp_print_t print;
+    vstr_init_print(&vstr, 16, &print);
+    if (!self->first) {
+        mp_print_str(&print, ", ");
+    }
+    self->first = false;
+    mp_obj_print_helper(&print, item, PRINT_JSON);
+    if (is_dict) {
+        mp_print_str(&print, ": ");
+        mp_obj_print_helper(&print, mp_obj_subscr(self->obj, item, MP_OBJ_SENTINEL), PRINT_JSON);
+    }
+    return mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
+}
+
+STATIC mp_obj_t mod_ujson_iterencode(mp_obj_t obj) {
+    ujson_iterencode_t *o = m_new_obj(ujson_iterencode_t);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = ujson_iterencode_iternext;
+    o->obj = obj;
+    o->iter = MP_OBJ_NULL;
+    o->first = true;
+    o->done = false;
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_iterencode_obj, mod_ujson_iterencode);
+
 // The function below implements a simple non-recursive JSON parser.
 //
 // The JSON specification is at http://www.ietf.org/rfc/rfc4627.txt
@@ -62,27 +168,200 @@ typedef struct _ujson_stream_t {
     mp_uint_t (*read)(mp_obj_t obj, void *buf, mp_uint_t size, int *errcode);
     int errcode;
     byte cur;
+    // The input is consumed from buf[pos] up to buf[len], and cur always came
+    // from buf[pos - 1] unless at the end.  For a stream buf is rbuf, refilled
+    // a block at a time; for a StringIO or BytesIO it is the object's data.
+    const byte *buf;
+    size_t pos;
+    size_t len;
+    byte rbuf[MICROPY_PY_UJSON_READ_BUF_SIZE];
 } ujson_stream_t;
 
 #define S_EOF (0) // null is not allowed in json stream so is ok as EOF marker
 #define S_END(s) ((s).cur == S_EOF)
 #define S_CUR(s) ((s).cur)
-#define S_NEXT(s) (ujson_stream_next(&(s)))
+#define S_NEXT(s) ((s).pos < (s).len ? ((s).cur = (s).buf[(s).pos++]) : ujson_stream_next(&(s)))
 
 STATIC byte ujson_stream_next(ujson_stream_t *s) {
-    mp_uint_t ret = s->read(s->stream_obj, &s->cur, 1, &s->errcode);
-    if (s->errcode != 0) {
-        mp_raise_OSError(s->errcode);
-    }
-    if (ret == 0) {
-        s->cur = S_EOF;
+    s->cur = S_EOF;
+    if (s->read != NULL) {
+        mp_uint_t ret = s->read(s->stream_obj, s->rbuf, sizeof(s->rbuf), &s->errcode);
+        if (s->errcode != 0) {
+            mp_raise_OSError(s->errcode);
+        }
+        s->buf = s->rbuf;
+        s->pos = 0;
+        s->len = ret;
+        if (ret != 0) {
+            s->cur = s->buf[s->pos++];
+        }
     }
     return s->cur;
 }
 
-STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
+// Dicts nested deeper than this don't share keys or size with their siblings.
+#define UJSON_SHAPE_DEPTH (4)
+
+// Make the object for a dict key.  A key equal to one in shape, the map of
+// the previous dict at the same depth, reuses that key object, so an array
+// of records with the same keys holds only one copy of each.
+STATIC mp_obj_t ujson_new_key(vstr_t *vstr, mp_map_t *shape) {
+    if (shape != NULL) {
+        mp_obj_str_t key = {{&mp_type_str}, qstr_compute_hash((const byte*)vstr->buf, vstr->len), vstr->len, (const byte*)vstr->buf};
+        mp_map_elem_t *elem = mp_map_lookup(shape, MP_OBJ_FROM_PTR(&key), MP_MAP_LOOKUP);
+        if (elem != NULL) {
+            return elem->key;
+        }
+    }
+    // uses an existing qstr if there is one
+    return mp_obj_new_str(vstr->buf, vstr->len, false);
+}
+
+// Parse a null, false, true, string or number, given its first character
+// which has already been consumed.  A string that is a dict key is made by
+// ujson_new_key, given is_key and the shape to share keys with.  Returns
+// MP_OBJ_NULL on a syntax error.
+STATIC mp_obj_t ujson_parse_primitive(ujson_stream_t *s, vstr_t *vstr, byte cur, bool is_key, mp_map_t *shape) {
+    switch (cur) {
+        case 'n':
+            if (S_CUR(*s) == 'u' && S_NEXT(*s) == 'l' && S_NEXT(*s) == 'l') {
+                S_NEXT(*s);
+                return mp_const_none;
+            }
+            return MP_OBJ_NULL;
+        case 'f':
+            if (S_CUR(*s) == 'a' && S_NEXT(*s) == 'l' && S_NEXT(*s) == 's' && S_NEXT(*s) == 'e') {
+                S_NEXT(*s);
+                return mp_const_false;
+            }
+            return MP_OBJ_NULL;
+        case 't':
+            if (S_CUR(*s) == 'r' && S_NEXT(*s) == 'u' && S_NEXT(*s) == 'e') {
+                S_NEXT(*s);
+                return mp_const_true;
+            }
+            return MP_OBJ_NULL;
+        case '"':
+            vstr_reset(vstr);
+            for (; !S_END(*s) && S_CUR(*s) != '"';) {
+                byte c = S_CUR(*s);
+                if (c == '\\') {
+                    c = S_NEXT(*s);
+                    switch (c) {
+                        case 'b': c = 0x08; break;
+                        case 'f': c = 0x0c; break;
+                        case 'n': c = 0x0a; break;
+                        case 'r': c = 0x0d; break;
+                        case 't': c = 0x09; break;
+                        case 'u': {
+                            mp_uint_t num = 0;
+                            for (int i = 0; i < 4; i++) {
+                                c = (S_NEXT(*s) | 0x20) - '0';
+                                if (c > 9) {
+                                    c -= ('a' - ('9' + 1));
+                                }
+                                num = (num << 4) | c;
+                            }
+                            vstr_add_char(vstr, num);
+                            goto str_cont;
+                        }
+                    }
+                } else if (s->pos != 0) {
+                    // copy the run of plain characters from the buffer
+                    const byte *run = &s->buf[s->pos - 1];
+                    const byte *run_end = run + 1;
+                    const byte *buf_end = &s->buf[s->len];
+                    while (run_end < buf_end && *run_end != '"' && *run_end != '\\' && *run_end != S_EOF) {
+                        run_end++;
+                    }
+                    vstr_add_strn(vstr, (const char*)run, run_end - run);
+                    s->pos += run_end - run - 1;
+                    goto str_cont;
+                }
+                vstr_add_byte(vstr, c);
+            str_cont:
+                S_NEXT(*s);
+            }
+            if (S_END(*s)) {
+                return MP_OBJ_NULL;
+            }
+            S_NEXT(*s);
+            if (is_key) {
+                return ujson_new_key(vstr, shape);
+            }
+            return mp_obj_new_str(vstr->buf, vstr->len, false);
+        case '-':
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': {
+            bool flt = false;
+            vstr_reset(vstr);
+            for (;;) {
+                vstr_add_byte(vstr, cur);
+                // take the digits that follow directly from the buffer
+                if (s->pos != 0) {
+                    const byte *run = &s->buf[s->pos - 1];
+                    const byte *run_end = run;
+                    const byte *buf_end = &s->buf[s->len];
+                    while (run_end < buf_end && unichar_isdigit(*run_end)) {
+                        run_end++;
+                    }
+                    if (run_end > run + 1) {
+                        vstr_add_strn(vstr, (const char*)run, run_end - run - 1);
+                        s->pos += run_end - run - 1;
+                        s->cur = s->buf[s->pos - 1];
+                    }
+                }
+                cur = S_CUR(*s);
+                if (cur == '.' || cur == 'E' || cur == 'e') {
+                    flt = true;
+                } else if (cur == '-' || unichar_isdigit(cur)) {
+                    // pass
+                } else {
+                    break;
+                }
+                S_NEXT(*s);
+            }
+            if (flt) {
+                return mp_parse_num_decimal(vstr->buf, vstr->len, false, false, NULL);
+            } else {
+                return mp_parse_num_integer(vstr->buf, vstr->len, 10, NULL);
+            }
+        }
+        default:
+            return MP_OBJ_NULL;
+    }
+}
+
+// Set up s to read from the given stream.  The data of a StringIO or BytesIO
+// is parsed in place, consuming all of it.
+STATIC void ujson_stream_init(ujson_stream_t *s, mp_obj_t stream_obj) {
     const mp_stream_p_t *stream_p = mp_get_stream_raise(stream_obj, MP_STREAM_OP_READ);
-    ujson_stream_t s = {stream_obj, stream_p->read, 0, 0};
+    s->stream_obj = stream_obj;
+    s->read = stream_p->read;
+    s->errcode = 0;
+    s->cur = 0;
+    s->buf = NULL;
+    s->pos = 0;
+    s->len = 0;
+    if (MP_OBJ_IS_TYPE(stream_obj, &mp_type_stringio)
+        #if MICROPY_PY_IO_BYTESIO
+        || MP_OBJ_IS_TYPE(stream_obj, &mp_type_bytesio)
+        #endif
+        ) {
+        mp_obj_stringio_t *sio = MP_OBJ_TO_PTR(stream_obj);
+        if (sio->vstr != NULL) {
+            if (sio->pos < sio->vstr->len) {
+                s->buf = (const byte*)sio->vstr->buf + sio->pos;
+                s->len = sio->vstr->len - sio->pos;
+                sio->pos = sio->vstr->len;
+            }
+            s->read = NULL;
+        }
+    }
+}
+
+STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
+    ujson_stream_t s;
+    ujson_stream_init(&s, stream_obj);
     vstr_t vstr;
     vstr_init(&vstr, 8);
     mp_obj_list_t stack; // we use a list as a simple stack for nested JSON
@@ -91,6 +370,9 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
     mp_obj_t stack_top = MP_OBJ_NULL;
     mp_obj_type_t *stack_top_type = NULL;
     mp_obj_t stack_key = MP_OBJ_NULL;
+    // the last dict finished at each depth, whose keys and table size are
+    // reused for the next dict at that depth (eg the next record of an array)
+    mp_obj_dict_t *shapes[UJSON_SHAPE_DEPTH] = {NULL};
     S_NEXT(s);
     for (;;) {
         cont:
@@ -109,97 +391,17 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
             case '\n':
             case '\r':
                 goto cont;
-            case 'n':
-                if (S_CUR(s) == 'u' && S_NEXT(s) == 'l' && S_NEXT(s) == 'l') {
-                    S_NEXT(s);
-                    next = mp_const_none;
-                } else {
-                    goto fail;
-                }
-                break;
-            case 'f':
-                if (S_CUR(s) == 'a' && S_NEXT(s) == 'l' && S_NEXT(s) == 's' && S_NEXT(s) == 'e') {
-                    S_NEXT(s);
-                    next = mp_const_false;
-                } else {
-                    goto fail;
-                }
-                break;
-            case 't':
-                if (S_CUR(s) == 'r' && S_NEXT(s) == 'u' && S_NEXT(s) == 'e') {
-                    S_NEXT(s);
-                    next = mp_const_true;
-                } else {
-                    goto fail;
-                }
-                break;
-            case '"':
-                vstr_reset(&vstr);
-                for (; !S_END(s) && S_CUR(s) != '"';) {
-                    byte c = S_CUR(s);
-                    if (c == '\\') {
-                        c = S_NEXT(s);
-                        switch (c) {
-                            case 'b': c = 0x08; break;
-                            case 'f': c = 0x0c; break;
-                            case 'n': c = 0x0a; break;
-                            case 'r': c = 0x0d; break;
-                            case 't': c = 0x09; break;
-                            case 'u': {
-                                mp_uint_t num = 0;
-                                for (int i = 0; i < 4; i++) {
-                                    c = (S_NEXT(s) | 0x20) - '0';
-                                    if (c > 9) {
-                                        c -= ('a' - ('9' + 1));
-                                    }
-                                    num = (num << 4) | c;
-                                }
-                                vstr_add_char(&vstr, num);
-                                goto str_cont;
-                            }
-                        }
-                    }
-                    vstr_add_byte(&vstr, c);
-                str_cont:
-                    S_NEXT(s);
-                }
-                if (S_END(s)) {
-                    goto fail;
-                }
-                S_NEXT(s);
-                next = mp_obj_new_str(vstr.buf, vstr.len, false);
-                break;
-            case '-':
-            case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': {
-                bool flt = false;
-                vstr_reset(&vstr);
-                for (;;) {
-                    vstr_add_byte(&vstr, cur);
-                    cur = S_CUR(s);
-                    if (cur == '.' || cur == 'E' || cur == 'e') {
-                        flt = true;
-                    } else if (cur == '-' || unichar_isdigit(cur)) {
-                        // pass
-                    } else {
-                        break;
-                    }
-                    S_NEXT(s);
-                }
-                if (flt) {
-                    next = mp_parse_num_decimal(vstr.buf, vstr.len, false, false, NULL);
-                } else {
-                    next = mp_parse_num_integer(vstr.buf, vstr.len, 10, NULL);
-                }
-                break;
-            }
             case '[':
                 next = mp_obj_new_list(0, NULL);
                 enter = true;
                 break;
-            case '{':
-                next = mp_obj_new_dict(0);
+            case '{': {
+                size_t depth = stack_top == MP_OBJ_NULL ? 0 : stack.len + 1;
+                mp_obj_dict_t *shape = depth < UJSON_SHAPE_DEPTH ? shapes[depth] : NULL;
+                next = mp_obj_new_dict(shape != NULL ? shape->map.alloc : 0);
                 enter = true;
                 break;
+            }
             case '}':
             case ']': {
                 if (stack_top == MP_OBJ_NULL) {
@@ -210,13 +412,23 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
                     // finished; compound object
                     goto success;
                 }
+                if (stack_top_type == &mp_type_dict && stack.len < UJSON_SHAPE_DEPTH) {
+                    shapes[stack.len] = MP_OBJ_TO_PTR(stack_top);
+                }
                 stack.len -= 1;
                 stack_top = stack.items[stack.len];
                 stack_top_type = mp_obj_get_type(stack_top);
                 goto cont;
             }
-            default:
-                goto fail;
+            default: {
+                bool is_key = stack_top_type == &mp_type_dict && stack_key == MP_OBJ_NULL;
+                mp_obj_dict_t *shape = is_key && stack.len < UJSON_SHAPE_DEPTH ? shapes[stack.len] : NULL;
+                next = ujson_parse_primitive(&s, &vstr, cur, is_key, shape != NULL ? &shape->map : NULL);
+                if (next == MP_OBJ_NULL) {
+                    goto fail;
+                }
+                break;
+            }
         }
         if (stack_top == MP_OBJ_NULL) {
             stack_top = next;
@@ -273,6 +485,114 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_load_obj, mod_ujson_load);
 
+// ujson.iterparse(stream) is a pull parser: it returns an iterator of
+// (event, value) tuples, so that a large document can be scanned for the
+// parts that are wanted without building it in memory.  The events are
+// 'start_object', 'end_object', 'start_array' and 'end_array' with a value
+// of None, 'key' with the key string, and 'string', 'number', 'boolean' and
+// 'null' with the value.  Consecutive top-level values are allowed, so a
+// stream of JSON documents can be parsed.
+
+typedef struct _ujson_parser_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    vstr_t vstr;
+    vstr_t stack; // the opening bracket of each enclosing container
+    bool started;
+    bool expect_key;
+    ujson_stream_t s;
+} ujson_parser_t;
+
+STATIC mp_obj_t ujson_event(qstr event, mp_obj_t value) {
+    mp_obj_t items[2] = {MP_OBJ_NEW_QSTR(event), value};
+    return mp_obj_new_tuple(2, items);
+}
+
+STATIC mp_obj_t ujson_parser_iternext(mp_obj_t self_in) {
+    ujson_parser_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->started) {
+        S_NEXT(self->s);
+        self->started = true;
+    }
+    for (;;) {
+        if (S_END(self->s)) {
+            if (self->stack.len != 0) {
+                goto fail;
+            }
+            return MP_OBJ_STOP_ITERATION;
+        }
+        byte cur = S_CUR(self->s);
+        S_NEXT(self->s);
+        bool in_object = self->stack.len != 0 && self->stack.buf[self->stack.len - 1] == '{';
+        switch (cur) {
+            case ',':
+            case ':':
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                continue;
+            case '{':
+            case '[':
+                if (in_object && self->expect_key) {
+                    goto fail;
+                }
+                vstr_add_byte(&self->stack, cur);
+                self->expect_key = cur == '{';
+                return ujson_event(cur == '{' ? MP_QSTR_start_object : MP_QSTR_start_array, mp_const_none);
+            case '}':
+            case ']':
+                if (self->stack.len == 0 || self->stack.buf[self->stack.len - 1] != cur - 2) {
+                    // no or mismatched opening bracket ('{' and '[' are 2 less)
+                    goto fail;
+                }
+                vstr_cut_tail_bytes(&self->stack, 1);
+                self->expect_key = self->stack.len != 0 && self->stack.buf[self->stack.len - 1] == '{';
+                return ujson_event(cur == '}' ? MP_QSTR_end_object : MP_QSTR_end_array, mp_const_none);
+            default: {
+                mp_obj_t value = ujson_parse_primitive(&self->s, &self->vstr, cur, false, NULL);
+                if (value == MP_OBJ_NULL) {
+                    goto fail;
+                }
+                qstr event;
+                if (in_object && self->expect_key) {
+                    if (!MP_OBJ_IS_STR(value)) {
+                        goto fail;
+                    }
+                    self->expect_key = false;
+                    return ujson_event(MP_QSTR_key, value);
+                } else if (MP_OBJ_IS_STR(value)) {
+                    event = MP_QSTR_string;
+                } else if (value == mp_const_none) {
+                    event = MP_QSTR_null;
+                } else if (value == mp_const_false || value == mp_const_true) {
+                    event = MP_QSTR_boolean;
+                } else {
+                    event = MP_QSTR_number;
+                }
+                self->expect_key = in_object;
+                return ujson_event(event, value);
+            }
+        }
+    }
+
+    fail:
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "syntax error in JSON"));
+}
+
+STATIC mp_obj_t mod_ujson_iterparse(mp_obj_t stream_obj) {
+    ujson_parser_t *o = m_new_obj(ujson_parser_t);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = ujson_parser_iternext;
+    vstr_init(&o->vstr, 8);
+    vstr_init(&o->stack, 8);
+    o->started = false;
+    o->expect_key = false;
+    ujson_stream_init(&o->s, stream_obj);
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_iterparse_obj, mod_ujson_iterparse);
+
 STATIC mp_obj_t mod_ujson_loads(mp_obj_t obj) {
     mp_uint_t len;
     const char *buf = mp_obj_str_get_data(obj, &len);
@@ -284,9 +604,12 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_loads_obj, mod_ujson_loads);
 
 STATIC const mp_rom_map_elem_t mp_module_ujson_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ujson) },
+    { MP_ROM_QSTR(MP_QSTR_dump), MP_ROM_PTR(&mod_ujson_dump_obj) },
     { MP_ROM_QSTR(MP_QSTR_dumps), MP_ROM_PTR(&mod_ujson_dumps_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iterencode), MP_ROM_PTR(&mod_ujson_iterencode_obj) },
     { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&mod_ujson_load_obj) },
     { MP_ROM_QSTR(MP_QSTR_loads), MP_ROM_PTR(&mod_ujson_loads_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iterparse), MP_ROM_PTR(&mod_ujson_iterparse_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ujson_globals, mp_module_ujson_globals_table);
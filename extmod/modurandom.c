@@ -32,6 +32,50 @@
 
 #if MICROPY_PY_URANDOM
 
+#if MICROPY_PY_URANDOM_XOSHIRO128
+
+// xoshiro128++ random number generator
+// by David Blackman and Sebastiano Vigna
+// http://xoshiro.di.unimi.it/
+// Public Domain
+
+STATIC uint32_t xoshiro128_s[4] = {0x2aa6d9c3, 0x7d9a1f29, 0xc1a4b3f5, 0x5e6b8d07};
+
+static inline uint32_t xoshiro128_rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+STATIC uint32_t urandom_next(void) {
+    uint32_t *s = xoshiro128_s;
+    uint32_t result = xoshiro128_rotl(s[0] + s[3], 7) + s[0];
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = xoshiro128_rotl(s[3], 11);
+    return result;
+}
+
+// the state is made from the seed by a 32-bit mixing function (lowbias32 by
+// Chris Wellons) of consecutive values, so it can't be all zero
+STATIC void urandom_seed(mp_uint_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint32_t x = (uint32_t)seed + i * 0x9e3779b9;
+        x ^= x >> 16;
+        x *= 0x7feb352d;
+        x ^= x >> 15;
+        x *= 0x846ca68b;
+        x ^= x >> 16;
+        xoshiro128_s[i] = x;
+    }
+}
+
+// End of xoshiro128++
+
+#else
+
 // Yasmarang random number generator
 // by Ilya Levin
 // http://www.literatecode.com/yasmarang
@@ -53,18 +97,31 @@ STATIC uint32_t yasmarang(void)
 
 // End of Yasmarang
 
+static inline uint32_t urandom_next(void) {
+    return yasmarang();
+}
+
+STATIC void urandom_seed(mp_uint_t seed) {
+    yasmarang_pad = seed;
+    yasmarang_n = 69;
+    yasmarang_d = 233;
+    yasmarang_dat = 0;
+}
+
+#endif // MICROPY_PY_URANDOM_XOSHIRO128
+
 #if MICROPY_PY_URANDOM_EXTRA_FUNCS
 
 // returns an unsigned integer below the given argument
 // n must not be zero
-STATIC uint32_t yasmarang_randbelow(uint32_t n) {
+STATIC uint32_t urandom_randbelow(uint32_t n) {
     uint32_t mask = 1;
     while ((n & mask) < n) {
         mask = (mask << 1) | 1;
     }
     uint32_t r;
     do {
-        r = yasmarang() & mask;
+        r = urandom_next() & mask;
     } while (r >= n);
     return r;
 }
@@ -79,20 +136,43 @@ STATIC mp_obj_t mod_urandom_getrandbits(mp_obj_t num_in) {
     uint32_t mask = ~0;
     // Beware of C undefined behavior when shifting by >= than bit size
     mask >>= (32 - n);
-    return mp_obj_new_int_from_uint(yasmarang() & mask);
+    return mp_obj_new_int_from_uint(urandom_next() & mask);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_urandom_getrandbits_obj, mod_urandom_getrandbits);
 
 STATIC mp_obj_t mod_urandom_seed(mp_obj_t seed_in) {
-    mp_uint_t seed = mp_obj_get_int_truncated(seed_in);
-    yasmarang_pad = seed;
-    yasmarang_n = 69;
-    yasmarang_d = 233;
-    yasmarang_dat = 0;
+    urandom_seed(mp_obj_get_int_truncated(seed_in));
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_urandom_seed_obj, mod_urandom_seed);
 
+// fills a writable buffer with random bytes, 4 at a time
+STATIC mp_obj_t mod_urandom_fill(mp_obj_t buf_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+    byte *buf = bufinfo.buf;
+    size_t len = bufinfo.len;
+    for (; len >= 4; len -= 4, buf += 4) {
+        uint32_t r = urandom_next();
+        memcpy(buf, &r, 4);
+    }
+    if (len > 0) {
+        uint32_t r = urandom_next();
+        memcpy(buf, &r, len);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_urandom_fill_obj, mod_urandom_fill);
+
+#if MICROPY_MODULE_BUILTIN_INIT && defined(MICROPY_PY_URANDOM_SEED_INIT_FUNC)
+// called on the first import, to start from a different seed each time
+STATIC mp_obj_t mod_urandom___init__(void) {
+    urandom_seed(MICROPY_PY_URANDOM_SEED_INIT_FUNC);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_urandom___init___obj, mod_urandom___init__);
+#endif
+
 #if MICROPY_PY_URANDOM_EXTRA_FUNCS
 
 STATIC mp_obj_t mod_urandom_randrange(size_t n_args, const mp_obj_t *args) {
@@ -100,7 +180,7 @@ STATIC mp_obj_t mod_urandom_randrange(size_t n_args, const mp_obj_t *args) {
     if (n_args == 1) {
         // range(stop)
         if (start > 0) {
-            return mp_obj_new_int(yasmarang_randbelow(start));
+            return mp_obj_new_int(urandom_randbelow(start));
         } else {
             nlr_raise(mp_obj_new_exception(&mp_type_ValueError));
         }
@@ -109,7 +189,7 @@ STATIC mp_obj_t mod_urandom_randrange(size_t n_args, const mp_obj_t *args) {
         if (n_args == 2) {
             // range(start, stop)
             if (start < stop) {
-                return mp_obj_new_int(start + yasmarang_randbelow(stop - start));
+                return mp_obj_new_int(start + urandom_randbelow(stop - start));
             } else {
                 nlr_raise(mp_obj_new_exception(&mp_type_ValueError));
             }
@@ -125,7 +205,7 @@ STATIC mp_obj_t mod_urandom_randrange(size_t n_args, const mp_obj_t *args) {
                 nlr_raise(mp_obj_new_exception(&mp_type_ValueError));
             }
             if (n > 0) {
-                return mp_obj_new_int(start + step * yasmarang_randbelow(n));
+                return mp_obj_new_int(start + step * urandom_randbelow(n));
             } else {
                 nlr_raise(mp_obj_new_exception(&mp_type_ValueError));
             }
@@ -138,7 +218,7 @@ STATIC mp_obj_t mod_urandom_randint(mp_obj_t a_in, mp_obj_t b_in) {
     mp_int_t a = mp_obj_get_int(a_in);
     mp_int_t b = mp_obj_get_int(b_in);
     if (a <= b) {
-        return mp_obj_new_int(a + yasmarang_randbelow(b - a + 1));
+        return mp_obj_new_int(a + urandom_randbelow(b - a + 1));
     } else {
         nlr_raise(mp_obj_new_exception(&mp_type_ValueError));
     }
@@ -148,7 +228,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_urandom_randint_obj, mod_urandom_randint);
 STATIC mp_obj_t mod_urandom_choice(mp_obj_t seq) {
     mp_int_t len = mp_obj_get_int(mp_obj_len(seq));
     if (len > 0) {
-        return mp_obj_subscr(seq, mp_obj_new_int(yasmarang_randbelow(len)), MP_OBJ_SENTINEL);
+        return mp_obj_subscr(seq, mp_obj_new_int(urandom_randbelow(len)), MP_OBJ_SENTINEL);
     } else {
         nlr_raise(mp_obj_new_exception(&mp_type_IndexError));
     }
@@ -157,8 +237,8 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_urandom_choice_obj, mod_urandom_choice);
 
 #if MICROPY_PY_BUILTINS_FLOAT
 
-// returns a number in the range [0..1) using Yasmarang to fill in the fraction bits
-STATIC mp_float_t yasmarang_float(void) {
+// returns a number in the range [0..1) using the generator to fill in the fraction bits
+STATIC mp_float_t urandom_float(void) {
     #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
     typedef uint64_t mp_float_int_t;
     #elif MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
@@ -175,22 +255,22 @@ STATIC mp_float_t yasmarang_float(void) {
     u.p.sgn = 0;
     u.p.exp = (1 << (MP_FLOAT_EXP_BITS - 1)) - 1;
     if (MP_FLOAT_FRAC_BITS <= 32) {
-        u.p.frc = yasmarang();
+        u.p.frc = urandom_next();
     } else {
-        u.p.frc = ((uint64_t)yasmarang() << 32) | (uint64_t)yasmarang();
+        u.p.frc = ((uint64_t)urandom_next() << 32) | (uint64_t)urandom_next();
     }
     return u.f - 1;
 }
 
 STATIC mp_obj_t mod_urandom_random(void) {
-    return mp_obj_new_float(yasmarang_float());
+    return mp_obj_new_float(urandom_float());
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_urandom_random_obj, mod_urandom_random);
 
 STATIC mp_obj_t mod_urandom_uniform(mp_obj_t a_in, mp_obj_t b_in) {
     mp_float_t a = mp_obj_get_float(a_in);
     mp_float_t b = mp_obj_get_float(b_in);
-    return mp_obj_new_float(a + (b - a) * yasmarang_float());
+    return mp_obj_new_float(a + (b - a) * urandom_float());
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_urandom_uniform_obj, mod_urandom_uniform);
 
@@ -200,8 +280,12 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_urandom_uniform_obj, mod_urandom_uniform);
 
 STATIC const mp_rom_map_elem_t mp_module_urandom_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_urandom) },
+    #if MICROPY_MODULE_BUILTIN_INIT && defined(MICROPY_PY_URANDOM_SEED_INIT_FUNC)
+    { MP_ROM_QSTR(MP_QSTR___init__), MP_ROM_PTR(&mod_urandom___init___obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_getrandbits), MP_ROM_PTR(&mod_urandom_getrandbits_obj) },
     { MP_ROM_QSTR(MP_QSTR_seed), MP_ROM_PTR(&mod_urandom_seed_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fill), MP_ROM_PTR(&mod_urandom_fill_obj) },
     #if MICROPY_PY_URANDOM_EXTRA_FUNCS
     { MP_ROM_QSTR(MP_QSTR_randrange), MP_ROM_PTR(&mod_urandom_randrange_obj) },
     { MP_ROM_QSTR(MP_QSTR_randint), MP_ROM_PTR(&mod_urandom_randint_obj) },
@@ -38,8 +38,13 @@
 
 #define FLAG_DEBUG 0x1000
 
+// Properties of the compiled program, used to pick the matching engine
+#define RE_PROP_LOOP (0x01) // contains a repetition
+#define RE_PROP_NESTED (0x02) // a repetition contains another one, or an alternation
+
 typedef struct _mp_obj_re_t {
     mp_obj_base_t base;
+    byte props;
     ByteProg re;
 } mp_obj_re_t;
 
@@ -92,6 +97,111 @@ STATIC void re_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t
     mp_printf(print, "<re %p>", self);
 }
 
+STATIC int re_inst_len(const char *pc) {
+    switch (*pc) {
+        case Any:
+        case Bol:
+        case Eol:
+        case Match:
+            return 1;
+        case Class:
+        case ClassNot:
+            return 2 + *(unsigned char*)(pc + 1) * 2;
+        default:
+            return 2;
+    }
+}
+
+STATIC byte re_get_props(ByteProg *prog) {
+    const char *code = prog->insts;
+    byte props = 0;
+    for (int pc = NON_ANCHORED_PREFIX; pc < prog->bytelen; pc += re_inst_len(code + pc)) {
+        if (code[pc] != Jmp && code[pc] != Split && code[pc] != RSplit) {
+            continue;
+        }
+        int target = pc + 2 + (signed char)code[pc + 1];
+        if (target >= pc) {
+            continue;
+        }
+        // A backward jump closes a loop whose body starts at target; for
+        // "*" the split at target is the loop's own.  Any other branch in
+        // the body can make the backtracker take exponentially many paths.
+        props |= RE_PROP_LOOP;
+        int i = target;
+        if (code[pc] == Jmp) {
+            i += 2;
+        }
+        for (; i < pc; i += re_inst_len(code + i)) {
+            if (code[i] == Split || code[i] == RSplit) {
+                props |= RE_PROP_NESTED;
+            }
+        }
+    }
+    return props;
+}
+
+// Run the program on the subject, choosing the engine: the Pike VM runs in
+// linear time and constant stack, so it's used for patterns which could
+// make the backtracker blow up, and for long subjects where the
+// backtracker's recursion could overflow the C stack.  Before running
+// either, a literal prefix of the pattern is searched for with memchr.
+STATIC int ure_run(mp_obj_re_t *self, Subject *subj_in, const char **caps, int caps_num, bool is_anchored) {
+    Subject subj = *subj_in;
+    bool use_pike = false;
+    #if MICROPY_PY_URE_PIKEVM
+    use_pike = (self->props & RE_PROP_NESTED)
+        || ((self->props & RE_PROP_LOOP) && subj.end - subj.begin >= MICROPY_PY_URE_PIKEVM_MIN_LEN);
+    #endif
+
+    // pattern code starts after the non-anchored prefix and "Save 0"
+    const char *pat = self->re.insts + NON_ANCHORED_PREFIX + 2;
+    size_t prefix_len = 0;
+    while (pat[prefix_len * 2] == Char) {
+        prefix_len++;
+    }
+
+    if (prefix_len == 0) {
+        goto run;
+    }
+
+    for (const char *p = subj.begin;; p++) {
+        if ((size_t)(subj.end - p) < prefix_len) {
+            return 0;
+        }
+        if (!is_anchored) {
+            p = memchr(p, pat[1], subj.end - p - prefix_len + 1);
+            if (p == NULL) {
+                return 0;
+            }
+        }
+        size_t i = 1;
+        while (i < prefix_len && p[i] == pat[i * 2 + 1]) {
+            i++;
+        }
+        if (i == prefix_len) {
+            subj.begin = p;
+            if (is_anchored || use_pike) {
+                // the Pike VM goes on to try all later positions in one pass
+                break;
+            }
+            // try the backtracker only at positions where the prefix matches
+            if (re1_5_recursiveloopprog(&self->re, &subj, caps, caps_num, true)) {
+                return 1;
+            }
+        } else if (is_anchored) {
+            return 0;
+        }
+    }
+
+run:
+    #if MICROPY_PY_URE_PIKEVM
+    if (use_pike) {
+        return re1_5_pikevm(&self->re, &subj, caps, caps_num, is_anchored);
+    }
+    #endif
+    return re1_5_recursiveloopprog(&self->re, &subj, caps, caps_num, is_anchored);
+}
+
 STATIC mp_obj_t ure_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
     (void)n_args;
     mp_obj_re_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -99,11 +209,12 @@ STATIC mp_obj_t ure_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
     mp_uint_t len;
     subj.begin = mp_obj_str_get_data(args[1], &len);
     subj.end = subj.begin + len;
+    subj.bol = subj.begin;
     int caps_num = (self->re.sub + 1) * 2;
     mp_obj_match_t *match = m_new_obj_var(mp_obj_match_t, char*, caps_num);
     // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
     memset((char*)match->caps, 0, caps_num * sizeof(char*));
-    int res = re1_5_recursiveloopprog(&self->re, &subj, match->caps, caps_num, is_anchored);
+    int res = ure_run(self, &subj, match->caps, caps_num, is_anchored);
     if (res == 0) {
         m_del_var(mp_obj_match_t, char*, caps_num, match);
         return mp_const_none;
@@ -131,6 +242,7 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
     mp_uint_t len;
     subj.begin = mp_obj_str_get_data(args[1], &len);
     subj.end = subj.begin + len;
+    subj.bol = subj.begin;
     int caps_num = (self->re.sub + 1) * 2;
 
     int maxsplit = 0;
@@ -143,7 +255,7 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
     while (true) {
         // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
         memset((char**)caps, 0, caps_num * sizeof(char*));
-        int res = re1_5_recursiveloopprog(&self->re, &subj, caps, caps_num, false);
+        int res = ure_run(self, &subj, caps, caps_num, false);
 
         // if we didn't have a match, or had an empty match, it's time to stop
         if (!res || caps[0] == caps[1]) {
@@ -167,10 +279,193 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_split_obj, 2, 3, re_split);
 
+#if MICROPY_PY_URE_SUB
+
+STATIC mp_obj_t match_new(mp_obj_t str, const char **caps, int caps_num) {
+    mp_obj_match_t *match = m_new_obj_var(mp_obj_match_t, char*, caps_num);
+    match->base.type = &match_type;
+    match->num_matches = caps_num / 2; // caps_num counts start and end pointers
+    match->str = str;
+    memcpy((char*)match->caps, caps, caps_num * sizeof(char*));
+    return MP_OBJ_FROM_PTR(match);
+}
+
+// Find the next match for sub and finditer and move subj->begin past it.
+// After an empty match the next search starts one character further on,
+// so there is at most one empty match at each position.  subj->begin is
+// set to NULL once there are no more matches.
+STATIC bool re_next_match(mp_obj_re_t *self, Subject *subj, const char **caps, int caps_num) {
+    if (subj->begin == NULL) {
+        return false;
+    }
+    // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
+    memset((char**)caps, 0, caps_num * sizeof(char*));
+    if (!ure_run(self, subj, caps, caps_num, false)) {
+        subj->begin = NULL;
+        return false;
+    }
+    if (caps[0] != caps[1]) {
+        subj->begin = caps[1];
+    } else if (caps[1] < subj->end) {
+        subj->begin = caps[1] + 1;
+    } else {
+        subj->begin = NULL;
+    }
+    return true;
+}
+
+// Append the replacement template repl to vstr, substituting the groups
+// referred to by \1 to \99 and \g<n>, and the escapes \n, \r, \t, \0
+// and \\.  Other escapes are kept as they are.
+STATIC void re_sub_expand(vstr_t *vstr, const char *repl, size_t repl_len, const char **caps, int caps_num) {
+    const char *top = repl + repl_len;
+    while (repl < top) {
+        const char *seg = repl;
+        while (repl < top && *repl != '\\') {
+            repl++;
+        }
+        vstr_add_strn(vstr, seg, repl - seg);
+        if (repl + 1 >= top) {
+            // no escape, or a trailing backslash
+            vstr_add_strn(vstr, repl, top - repl);
+            break;
+        }
+        repl++;
+        char c = *repl++;
+        mp_int_t group;
+        if (c >= '1' && c <= '9') {
+            group = c - '0';
+            if (repl < top && *repl >= '0' && *repl <= '9') {
+                group = group * 10 + *repl++ - '0';
+            }
+        } else if (c == 'g' && repl < top && *repl == '<') {
+            const char *num = ++repl;
+            group = 0;
+            while (repl < top && *repl >= '0' && *repl <= '9') {
+                group = group * 10 + *repl++ - '0';
+            }
+            if (repl == num || repl >= top || *repl++ != '>') {
+                mp_raise_ValueError("bad group name");
+            }
+        } else {
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case '0': c = '\0'; break;
+                case '\\': break;
+                default: vstr_add_byte(vstr, '\\'); break;
+            }
+            vstr_add_byte(vstr, c);
+            continue;
+        }
+        if (group >= caps_num / 2) {
+            mp_raise_ValueError("invalid group reference");
+        }
+        const char *start = caps[group * 2];
+        if (start != NULL) {
+            // an unmatched group is replaced by an empty string
+            vstr_add_strn(vstr, start, caps[group * 2 + 1] - start);
+        }
+    }
+}
+
+// The result is built in a single vstr, and a template replacement needs
+// no allocation per match; a callable replacement gets a match object.
+STATIC mp_obj_t re_sub(size_t n_args, const mp_obj_t *args) {
+    mp_obj_re_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_t replace = args[1];
+    mp_obj_t where = args[2];
+    mp_int_t count = 0;
+    if (n_args > 3) {
+        count = mp_obj_get_int(args[3]);
+    }
+
+    Subject subj;
+    size_t len;
+    subj.begin = mp_obj_str_get_data(where, &len);
+    subj.end = subj.begin + len;
+    subj.bol = subj.begin;
+    int caps_num = (self->re.sub + 1) * 2;
+    const char **caps = alloca(caps_num * sizeof(char*));
+
+    const char *repl = NULL;
+    size_t repl_len = 0;
+    if (!mp_obj_is_callable(replace)) {
+        repl = mp_obj_str_get_data(replace, &repl_len);
+    }
+
+    vstr_t vstr;
+    vstr_init(&vstr, len);
+    const char *last_end = subj.bol;
+    mp_int_t n = 0;
+    while ((count <= 0 || n < count) && re_next_match(self, &subj, caps, caps_num)) {
+        vstr_add_strn(&vstr, last_end, caps[0] - last_end);
+        if (repl != NULL) {
+            re_sub_expand(&vstr, repl, repl_len, caps, caps_num);
+        } else {
+            mp_obj_t r = mp_call_function_1(replace, match_new(where, caps, caps_num));
+            size_t r_len;
+            const char *r_str = mp_obj_str_get_data(r, &r_len);
+            vstr_add_strn(&vstr, r_str, r_len);
+        }
+        last_end = caps[1];
+        n++;
+    }
+
+    if (n == 0) {
+        vstr_clear(&vstr);
+        return where;
+    }
+    vstr_add_strn(&vstr, last_end, subj.bol + len - last_end);
+    return mp_obj_new_str_from_vstr(mp_obj_get_type(where), &vstr);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_sub_obj, 3, 4, re_sub);
+
+typedef struct _mp_obj_re_finditer_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_re_t *re;
+    mp_obj_t str;
+    Subject subj;
+    const char *caps[0]; // reused for every search
+} mp_obj_re_finditer_t;
+
+STATIC mp_obj_t re_finditer_iternext(mp_obj_t self_in) {
+    mp_obj_re_finditer_t *self = MP_OBJ_TO_PTR(self_in);
+    int caps_num = (self->re->re.sub + 1) * 2;
+    if (!re_next_match(self->re, &self->subj, self->caps, caps_num)) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    return match_new(self->str, self->caps, caps_num);
+}
+
+STATIC mp_obj_t re_finditer(mp_obj_t self_in, mp_obj_t string) {
+    mp_obj_re_t *self = MP_OBJ_TO_PTR(self_in);
+    int caps_num = (self->re.sub + 1) * 2;
+    mp_obj_re_finditer_t *o = m_new_obj_var(mp_obj_re_finditer_t, char*, caps_num);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = re_finditer_iternext;
+    o->re = self;
+    o->str = string;
+    size_t len;
+    o->subj.begin = mp_obj_str_get_data(string, &len);
+    o->subj.end = o->subj.begin + len;
+    o->subj.bol = o->subj.begin;
+    return MP_OBJ_FROM_PTR(o);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(re_finditer_obj, re_finditer);
+
+#endif // MICROPY_PY_URE_SUB
+
 STATIC const mp_rom_map_elem_t re_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_match), MP_ROM_PTR(&re_match_obj) },
     { MP_ROM_QSTR(MP_QSTR_search), MP_ROM_PTR(&re_search_obj) },
     { MP_ROM_QSTR(MP_QSTR_split), MP_ROM_PTR(&re_split_obj) },
+    #if MICROPY_PY_URE_SUB
+    { MP_ROM_QSTR(MP_QSTR_sub), MP_ROM_PTR(&re_sub_obj) },
+    { MP_ROM_QSTR(MP_QSTR_finditer), MP_ROM_PTR(&re_finditer_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(re_locals_dict, re_locals_dict_table);
@@ -199,6 +494,7 @@ STATIC mp_obj_t mod_re_compile(size_t n_args, const mp_obj_t *args) {
 error:
         nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Error in regex"));
     }
+    o->props = re_get_props(&o->re);
     if (flags & FLAG_DEBUG) {
         re1_5_dumpcode(&o->re);
     }
@@ -225,11 +521,32 @@ STATIC mp_obj_t mod_re_search(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_search_obj, 2, 4, mod_re_search);
 
+#if MICROPY_PY_URE_SUB
+STATIC mp_obj_t mod_re_sub(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t self = mod_re_compile(1, args);
+    mp_obj_t args2[4] = {self, args[1], args[2]};
+    if (n_args > 3) {
+        args2[3] = args[3];
+    }
+    return re_sub(n_args, args2);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_sub_obj, 3, 4, mod_re_sub);
+
+STATIC mp_obj_t mod_re_finditer(mp_obj_t pattern, mp_obj_t string) {
+    return re_finditer(mod_re_compile(1, &pattern), string);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(mod_re_finditer_obj, mod_re_finditer);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_re_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ure) },
     { MP_ROM_QSTR(MP_QSTR_compile), MP_ROM_PTR(&mod_re_compile_obj) },
     { MP_ROM_QSTR(MP_QSTR_match), MP_ROM_PTR(&mod_re_match_obj) },
     { MP_ROM_QSTR(MP_QSTR_search), MP_ROM_PTR(&mod_re_search_obj) },
+    #if MICROPY_PY_URE_SUB
+    { MP_ROM_QSTR(MP_QSTR_sub), MP_ROM_PTR(&mod_re_sub_obj) },
+    { MP_ROM_QSTR(MP_QSTR_finditer), MP_ROM_PTR(&mod_re_finditer_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_DEBUG), MP_ROM_INT(FLAG_DEBUG) },
 };
 
@@ -244,9 +561,16 @@ const mp_obj_module_t mp_module_ure = {
 // only if module is enabled by config setting.
 
 #define re1_5_fatal(x) assert(!x)
+// the Pike VM workspace goes on the C stack if it's small enough, since
+// allocating it on the heap for every search is slow
+#define re1_5_alloc(n) ((n) <= MICROPY_PY_URE_PIKEVM_STACK_MAX ? alloca(n) : m_new(char, n))
+#define re1_5_free(p, n) do { if ((n) > MICROPY_PY_URE_PIKEVM_STACK_MAX) { m_del(char, p, n); } } while (0)
 #include "re1.5/compilecode.c"
 #include "re1.5/dumpcode.c"
 #include "re1.5/recursiveloop.c"
+#if MICROPY_PY_URE_PIKEVM
+#include "re1.5/pike.c"
+#endif
 #include "re1.5/charclass.c"
 
 #endif //MICROPY_PY_URE
@@ -29,20 +29,34 @@
 #include "py/runtime.h"
 #include "py/obj.h"
 #include "py/objlist.h"
+#include "py/objtuple.h"
 #include "py/mperrno.h"
+#include "py/stream.h"
 #include "py/mphal.h"
-#include "pybioctl.h"
+
+#if MICROPY_PY_USELECT
 
 // Flags for poll()
 #define FLAG_ONESHOT (1)
 
+// While nothing is ready, wait for the next event.  Ports that can sleep
+// until an interrupt arrives define MICROPY_EVENT_WAIT_HOOK, the others
+// just keep polling.
+#if defined(MICROPY_EVENT_WAIT_HOOK)
+#define SELECT_WAIT() MICROPY_EVENT_WAIT_HOOK
+#elif defined(MICROPY_EVENT_POLL_HOOK)
+#define SELECT_WAIT() MICROPY_EVENT_POLL_HOOK
+#else
+#define SELECT_WAIT()
+#endif
+
 /// \module select - Provides select function to wait for events on a stream
 ///
 /// This module provides the select function.
 
 typedef struct _poll_obj_t {
     mp_obj_t obj;
-    mp_uint_t (*ioctl)(mp_obj_t obj, mp_uint_t request, mp_uint_t arg, int *errcode);
+    mp_uint_t (*ioctl)(mp_obj_t obj, mp_uint_t request, uintptr_t arg, int *errcode);
     mp_uint_t flags;
     mp_uint_t flags_ret;
 } poll_obj_t;
@@ -84,7 +98,7 @@ STATIC mp_uint_t poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num) {
 
         poll_obj_t *poll_obj = (poll_obj_t*)poll_map->table[i].value;
         int errcode;
-        mp_int_t ret = poll_obj->ioctl(poll_obj->obj, MP_IOCTL_POLL, poll_obj->flags, &errcode);
+        mp_int_t ret = poll_obj->ioctl(poll_obj->obj, MP_STREAM_POLL, poll_obj->flags, &errcode);
         poll_obj->flags_ret = ret;
 
         if (ret == -1) {
@@ -96,13 +110,13 @@ STATIC mp_uint_t poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num) {
             // object is ready
             n_ready += 1;
             if (rwx_num != NULL) {
-                if (ret & MP_IOCTL_POLL_RD) {
+                if (ret & MP_STREAM_POLL_RD) {
                     rwx_num[0] += 1;
                 }
-                if (ret & MP_IOCTL_POLL_WR) {
+                if (ret & MP_STREAM_POLL_WR) {
                     rwx_num[1] += 1;
                 }
-                if ((ret & ~(MP_IOCTL_POLL_RD | MP_IOCTL_POLL_WR)) != 0) {
+                if ((ret & ~(MP_STREAM_POLL_RD | MP_STREAM_POLL_WR)) != 0) {
                     rwx_num[2] += 1;
                 }
             }
@@ -112,7 +126,7 @@ STATIC mp_uint_t poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num) {
 }
 
 /// \function select(rlist, wlist, xlist[, timeout])
-STATIC mp_obj_t select_select(uint n_args, const mp_obj_t *args) {
+STATIC mp_obj_t select_select(size_t n_args, const mp_obj_t *args) {
     // get array data from tuple/list arguments
     mp_uint_t rwx_len[3];
     mp_obj_t *r_array, *w_array, *x_array;
@@ -138,9 +152,9 @@ STATIC mp_obj_t select_select(uint n_args, const mp_obj_t *args) {
     // merge separate lists and get the ioctl function for each object
     mp_map_t poll_map;
     mp_map_init(&poll_map, rwx_len[0] + rwx_len[1] + rwx_len[2]);
-    poll_map_add(&poll_map, r_array, rwx_len[0], MP_IOCTL_POLL_RD, true);
-    poll_map_add(&poll_map, w_array, rwx_len[1], MP_IOCTL_POLL_WR, true);
-    poll_map_add(&poll_map, x_array, rwx_len[2], MP_IOCTL_POLL_ERR | MP_IOCTL_POLL_HUP, true);
+    poll_map_add(&poll_map, r_array, rwx_len[0], MP_STREAM_POLL_RD, true);
+    poll_map_add(&poll_map, w_array, rwx_len[1], MP_STREAM_POLL_WR, true);
+    poll_map_add(&poll_map, x_array, rwx_len[2], MP_STREAM_POLL_ERR | MP_STREAM_POLL_HUP, true);
 
     mp_uint_t start_tick = mp_hal_ticks_ms();
     rwx_len[0] = rwx_len[1] = rwx_len[2] = 0;
@@ -160,20 +174,20 @@ STATIC mp_obj_t select_select(uint n_args, const mp_obj_t *args) {
                     continue;
                 }
                 poll_obj_t *poll_obj = (poll_obj_t*)poll_map.table[i].value;
-                if (poll_obj->flags_ret & MP_IOCTL_POLL_RD) {
+                if (poll_obj->flags_ret & MP_STREAM_POLL_RD) {
                     ((mp_obj_list_t*)list_array[0])->items[rwx_len[0]++] = poll_obj->obj;
                 }
-                if (poll_obj->flags_ret & MP_IOCTL_POLL_WR) {
+                if (poll_obj->flags_ret & MP_STREAM_POLL_WR) {
                     ((mp_obj_list_t*)list_array[1])->items[rwx_len[1]++] = poll_obj->obj;
                 }
-                if ((poll_obj->flags_ret & ~(MP_IOCTL_POLL_RD | MP_IOCTL_POLL_WR)) != 0) {
+                if ((poll_obj->flags_ret & ~(MP_STREAM_POLL_RD | MP_STREAM_POLL_WR)) != 0) {
                     ((mp_obj_list_t*)list_array[2])->items[rwx_len[2]++] = poll_obj->obj;
                 }
             }
             mp_map_deinit(&poll_map);
             return mp_obj_new_tuple(3, list_array);
         }
-        __WFI();
+        SELECT_WAIT();
     }
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_select_select_obj, 3, 4, select_select);
@@ -183,16 +197,21 @@ MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_select_select_obj, 3, 4, select_select);
 typedef struct _mp_obj_poll_t {
     mp_obj_base_t base;
     mp_map_t poll_map;
+    // State of ipoll() iteration
+    int iter_flags;
+    mp_uint_t iter_cnt;
+    mp_uint_t iter_idx;
+    mp_obj_tuple_t *ret_tuple;
 } mp_obj_poll_t;
 
 /// \method register(obj[, eventmask])
-STATIC mp_obj_t poll_register(uint n_args, const mp_obj_t *args) {
+STATIC mp_obj_t poll_register(size_t n_args, const mp_obj_t *args) {
     mp_obj_poll_t *self = args[0];
     mp_uint_t flags;
     if (n_args == 3) {
         flags = mp_obj_get_int(args[2]);
     } else {
-        flags = MP_IOCTL_POLL_RD | MP_IOCTL_POLL_WR;
+        flags = MP_STREAM_POLL_RD | MP_STREAM_POLL_WR;
     }
     poll_map_add(&self->poll_map, &args[1], 1, flags, false);
     return mp_const_none;
@@ -220,9 +239,10 @@ STATIC mp_obj_t poll_modify(mp_obj_t self_in, mp_obj_t obj_in, mp_obj_t eventmas
 }
 MP_DEFINE_CONST_FUN_OBJ_3(poll_modify_obj, poll_modify);
 
-/// \method poll([timeout])
-/// Timeout is in milliseconds.
-STATIC mp_obj_t poll_poll(uint n_args, const mp_obj_t *args) {
+// Wait until an object is ready or the timeout expires, common to poll()
+// and ipoll().  Returns the number of ready objects, which are then taken
+// one at a time with poll_next_ready().
+STATIC mp_uint_t poll_poll_internal(size_t n_args, const mp_obj_t *args) {
     mp_obj_poll_t *self = args[0];
 
     // work out timeout (its given already in ms)
@@ -240,6 +260,9 @@ STATIC mp_obj_t poll_poll(uint n_args, const mp_obj_t *args) {
         }
     }
 
+    self->iter_flags = flags;
+    self->iter_idx = 0;
+
     mp_uint_t start_tick = mp_hal_ticks_ms();
     for (;;) {
         // poll the objects
@@ -247,40 +270,92 @@ STATIC mp_obj_t poll_poll(uint n_args, const mp_obj_t *args) {
 
         if (n_ready > 0 || (timeout != -1 && mp_hal_ticks_ms() - start_tick >= timeout)) {
             // one or more objects are ready, or we had a timeout
-            mp_obj_list_t *ret_list = mp_obj_new_list(n_ready, NULL);
-            n_ready = 0;
-            for (mp_uint_t i = 0; i < self->poll_map.alloc; ++i) {
-                if (!MP_MAP_SLOT_IS_FILLED(&self->poll_map, i)) {
-                    continue;
-                }
-                poll_obj_t *poll_obj = (poll_obj_t*)self->poll_map.table[i].value;
-                if (poll_obj->flags_ret != 0) {
-                    mp_obj_t tuple[2] = {poll_obj->obj, MP_OBJ_NEW_SMALL_INT(poll_obj->flags_ret)};
-                    ret_list->items[n_ready++] = mp_obj_new_tuple(2, tuple);
-                    if (flags & FLAG_ONESHOT) {
-                        // Don't poll next time, until new event flags will be set explicitly
-                        poll_obj->flags = 0;
-                    }
-                }
+            self->iter_cnt = n_ready;
+            return n_ready;
+        }
+        SELECT_WAIT();
+    }
+}
+
+// Take the next ready object from the last poll.  Must only be called as
+// many times as poll_poll_internal() said objects were ready.
+STATIC poll_obj_t *poll_next_ready(mp_obj_poll_t *self) {
+    for (;;) {
+        mp_uint_t i = self->iter_idx++;
+        if (!MP_MAP_SLOT_IS_FILLED(&self->poll_map, i)) {
+            continue;
+        }
+        poll_obj_t *poll_obj = (poll_obj_t*)self->poll_map.table[i].value;
+        if (poll_obj->flags_ret != 0) {
+            self->iter_cnt -= 1;
+            if (self->iter_flags & FLAG_ONESHOT) {
+                // Don't poll next time, until new event flags will be set explicitly
+                poll_obj->flags = 0;
             }
-            return ret_list;
+            return poll_obj;
         }
-        __WFI();
     }
 }
+
+/// \method poll([timeout])
+/// Timeout is in milliseconds.
+STATIC mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = args[0];
+
+    mp_uint_t n_ready = poll_poll_internal(n_args, args);
+    mp_obj_list_t *ret_list = mp_obj_new_list(n_ready, NULL);
+    for (mp_uint_t i = 0; i < n_ready; ++i) {
+        poll_obj_t *poll_obj = poll_next_ready(self);
+        mp_obj_t tuple[2] = {poll_obj->obj, MP_OBJ_NEW_SMALL_INT(poll_obj->flags_ret)};
+        ret_list->items[i] = mp_obj_new_tuple(2, tuple);
+    }
+    return ret_list;
+}
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_poll_obj, 1, 3, poll_poll);
 
+/// \method ipoll([timeout[, flags]])
+/// Like poll(), but returns the poll object to iterate over the ready
+/// (obj, event) pairs.  The same tuple is reused for each pair so nothing
+/// is allocated, and it is only valid until the next iteration.
+STATIC mp_obj_t poll_ipoll(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = args[0];
+
+    if (self->ret_tuple == NULL) {
+        self->ret_tuple = mp_obj_new_tuple(2, NULL);
+    }
+
+    poll_poll_internal(n_args, args);
+    return self;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_ipoll_obj, 1, 3, poll_ipoll);
+
+STATIC mp_obj_t poll_iternext(mp_obj_t self_in) {
+    mp_obj_poll_t *self = self_in;
+
+    if (self->iter_cnt == 0) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+
+    poll_obj_t *poll_obj = poll_next_ready(self);
+    self->ret_tuple->items[0] = poll_obj->obj;
+    self->ret_tuple->items[1] = MP_OBJ_NEW_SMALL_INT(poll_obj->flags_ret);
+    return self->ret_tuple;
+}
+
 STATIC const mp_map_elem_t poll_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_register), (mp_obj_t)&poll_register_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_unregister), (mp_obj_t)&poll_unregister_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_modify), (mp_obj_t)&poll_modify_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_poll), (mp_obj_t)&poll_poll_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_ipoll), (mp_obj_t)&poll_ipoll_obj },
 };
 STATIC MP_DEFINE_CONST_DICT(poll_locals_dict, poll_locals_dict_table);
 
 STATIC const mp_obj_type_t mp_type_poll = {
     { &mp_type_type },
     .name = MP_QSTR_poll,
+    .getiter = mp_identity,
+    .iternext = poll_iternext,
     .locals_dict = (mp_obj_t)&poll_locals_dict,
 };
 
@@ -289,6 +364,8 @@ STATIC mp_obj_t select_poll(void) {
     mp_obj_poll_t *poll = m_new_obj(mp_obj_poll_t);
     poll->base.type = &mp_type_poll;
     mp_map_init(&poll->poll_map, 0);
+    poll->iter_cnt = 0;
+    poll->ret_tuple = NULL;
     return poll;
 }
 MP_DEFINE_CONST_FUN_OBJ_0(mp_select_poll_obj, select_poll);
@@ -297,10 +374,10 @@ STATIC const mp_map_elem_t mp_module_select_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_uselect) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_select), (mp_obj_t)&mp_select_select_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_poll), (mp_obj_t)&mp_select_poll_obj },
-    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLIN), MP_OBJ_NEW_SMALL_INT(MP_IOCTL_POLL_RD) },
-    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLOUT), MP_OBJ_NEW_SMALL_INT(MP_IOCTL_POLL_WR) },
-    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLERR), MP_OBJ_NEW_SMALL_INT(MP_IOCTL_POLL_ERR) },
-    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLHUP), MP_OBJ_NEW_SMALL_INT(MP_IOCTL_POLL_HUP) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLIN), MP_OBJ_NEW_SMALL_INT(MP_STREAM_POLL_RD) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLOUT), MP_OBJ_NEW_SMALL_INT(MP_STREAM_POLL_WR) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLERR), MP_OBJ_NEW_SMALL_INT(MP_STREAM_POLL_ERR) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_POLLHUP), MP_OBJ_NEW_SMALL_INT(MP_STREAM_POLL_HUP) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_select_globals, mp_module_select_globals_table);
@@ -309,3 +386,5 @@ const mp_obj_module_t mp_module_uselect = {
     .base = { &mp_type_module },
     .globals = (mp_obj_dict_t*)&mp_module_select_globals,
 };
+
+#endif // MICROPY_PY_USELECT
@@ -36,41 +36,78 @@
 
 #include "ssl.h"
 
+// A context owns the axtls SSL_CTX, which holds the session cache, and
+// remembers the session ID of the last client handshake so that the next
+// connection to the same server can resume it instead of doing a full
+// (public key) handshake again.
+typedef struct _mp_obj_ssl_context_t {
+    mp_obj_base_t base;
+    SSL_CTX *ssl_ctx;
+    mp_obj_t session_host;
+    uint8_t session_id_len;
+    uint8_t session_id[SSL_SESSION_ID_SIZE];
+} mp_obj_ssl_context_t;
+
 typedef struct _mp_obj_ssl_socket_t {
     mp_obj_base_t base;
     mp_obj_t sock;
-    SSL_CTX *ssl_ctx;
+    mp_obj_ssl_context_t *ctx;
     SSL *ssl_sock;
     byte *buf;
     uint32_t bytes_left;
+    // Whether ctx was created just for this socket and is freed with it
+    bool own_ctx;
 } mp_obj_ssl_socket_t;
 
+STATIC const mp_obj_type_t ussl_context_type;
 STATIC const mp_obj_type_t ussl_socket_type;
 
-STATIC mp_obj_ssl_socket_t *socket_new(mp_obj_t sock, bool server_side) {
+STATIC mp_obj_ssl_context_t *context_new(void) {
+    mp_obj_ssl_context_t *ctx = m_new_obj(mp_obj_ssl_context_t);
+    ctx->base.type = &ussl_context_type;
+    ctx->session_host = mp_const_none;
+    ctx->session_id_len = 0;
+
+    uint32_t options = SSL_SERVER_VERIFY_LATER;
+    if ((ctx->ssl_ctx = ssl_ctx_new(options, SSL_DEFAULT_CLNT_SESS)) == NULL) {
+        mp_raise_OSError(MP_EINVAL);
+    }
+    return ctx;
+}
+
+STATIC mp_obj_ssl_socket_t *socket_new(mp_obj_ssl_context_t *ctx, mp_obj_t sock, bool server_side, mp_obj_t server_hostname) {
     mp_obj_ssl_socket_t *o = m_new_obj(mp_obj_ssl_socket_t);
     o->base.type = &ussl_socket_type;
     o->buf = NULL;
     o->bytes_left = 0;
     o->sock = sock;
-
-    uint32_t options = SSL_SERVER_VERIFY_LATER;
-    if ((o->ssl_ctx = ssl_ctx_new(options, SSL_DEFAULT_CLNT_SESS)) == NULL) {
-        mp_raise_OSError(MP_EINVAL);
-    }
+    o->ctx = ctx;
+    o->own_ctx = false;
 
     if (server_side) {
-        o->ssl_sock = ssl_server_new(o->ssl_ctx, (long)sock);
+        o->ssl_sock = ssl_server_new(ctx->ssl_ctx, (long)sock);
     } else {
-        o->ssl_sock = ssl_client_new(o->ssl_ctx, (long)sock, NULL, 0);
+        const uint8_t *session_id = NULL;
+        uint8_t session_id_len = 0;
+        if (ctx->session_id_len != 0 && mp_obj_equal(ctx->session_host, server_hostname)) {
+            session_id = ctx->session_id;
+            session_id_len = ctx->session_id_len;
+        }
+        o->ssl_sock = ssl_client_new(ctx->ssl_ctx, (long)sock, session_id, session_id_len);
 
         int res;
         /* check the return status */
         if ((res = ssl_handshake_status(o->ssl_sock)) != SSL_OK) {
+            ctx->session_id_len = 0;
             printf("ssl_handshake_status: %d\n", res);
             ssl_display_error(res);
             mp_raise_OSError(MP_EIO);
         }
+
+        // Remember the (possibly new) session for the next connection
+        ctx->session_id_len = ssl_get_session_id_size(o->ssl_sock);
+        memcpy(ctx->session_id, ssl_get_session_id(o->ssl_sock), ctx->session_id_len);
+        ctx->session_host = server_hostname;
     }
 
     return o;
@@ -135,7 +172,9 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(socket_setblocking_obj, socket_setblocking);
 STATIC mp_obj_t socket_close(mp_obj_t self_in) {
     mp_obj_ssl_socket_t *self = MP_OBJ_TO_PTR(self_in);
     ssl_free(self->ssl_sock);
-    ssl_ctx_free(self->ssl_ctx);
+    if (self->own_ctx) {
+        ssl_ctx_free(self->ctx->ssl_ctx);
+    }
     return mp_stream_close(self->sock);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(socket_close_obj, socket_close);
@@ -168,28 +207,69 @@ STATIC const mp_obj_type_t ussl_socket_type = {
     .locals_dict = (void*)&ussl_socket_locals_dict,
 };
 
-STATIC mp_obj_t mod_ssl_wrap_socket(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    // TODO: Implement more args
-    static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_server_side, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
-    };
+STATIC const mp_arg_t wrap_socket_allowed_args[] = {
+    { MP_QSTR_server_side, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    { MP_QSTR_server_hostname, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+};
+
+struct wrap_socket_args {
+    mp_arg_val_t server_side;
+    mp_arg_val_t server_hostname;
+};
+
+STATIC mp_obj_t context_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    (void)type;
+    (void)args;
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+    return MP_OBJ_FROM_PTR(context_new());
+}
 
+STATIC mp_obj_t context_wrap_socket(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_obj_ssl_context_t *ctx = MP_OBJ_TO_PTR(pos_args[0]);
+    // TODO: Check that sock implements stream protocol
+    mp_obj_t sock = pos_args[1];
+
+    struct wrap_socket_args args;
+    mp_arg_parse_all(n_args - 2, pos_args + 2, kw_args,
+        MP_ARRAY_SIZE(wrap_socket_allowed_args), wrap_socket_allowed_args, (mp_arg_val_t*)&args);
+
+    return MP_OBJ_FROM_PTR(socket_new(ctx, sock, args.server_side.u_bool, args.server_hostname.u_obj));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(context_wrap_socket_obj, 2, context_wrap_socket);
+
+STATIC const mp_rom_map_elem_t ussl_context_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_wrap_socket), MP_ROM_PTR(&context_wrap_socket_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(ussl_context_locals_dict, ussl_context_locals_dict_table);
+
+STATIC const mp_obj_type_t ussl_context_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_SSLContext,
+    .make_new = context_make_new,
+    .locals_dict = (void*)&ussl_context_locals_dict,
+};
+
+STATIC mp_obj_t mod_ssl_wrap_socket(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     // TODO: Check that sock implements stream protocol
     mp_obj_t sock = pos_args[0];
 
-    struct {
-        mp_arg_val_t server_side;
-    } args;
+    struct wrap_socket_args args;
     mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args,
-        MP_ARRAY_SIZE(allowed_args), allowed_args, (mp_arg_val_t*)&args);
+        MP_ARRAY_SIZE(wrap_socket_allowed_args), wrap_socket_allowed_args, (mp_arg_val_t*)&args);
 
-    return MP_OBJ_FROM_PTR(socket_new(sock, args.server_side.u_bool));
+    // A one-off context, so there's no session to resume
+    mp_obj_ssl_context_t *ctx = context_new();
+    mp_obj_ssl_socket_t *o = socket_new(ctx, sock, args.server_side.u_bool, args.server_hostname.u_obj);
+    o->own_ctx = true;
+    return MP_OBJ_FROM_PTR(o);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_ssl_wrap_socket_obj, 1, mod_ssl_wrap_socket);
 
 STATIC const mp_rom_map_elem_t mp_module_ssl_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ussl) },
     { MP_ROM_QSTR(MP_QSTR_wrap_socket), MP_ROM_PTR(&mod_ssl_wrap_socket_obj) },
+    { MP_ROM_QSTR(MP_QSTR_SSLContext), MP_ROM_PTR(&ussl_context_type) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ssl_globals, mp_module_ssl_globals_table);
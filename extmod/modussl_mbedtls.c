@@ -45,18 +45,46 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/debug.h"
 
-typedef struct _mp_obj_ssl_socket_t {
+// A context holds everything that can be shared between connections: the
+// RNG, the configuration with its certificates, and the session of the last
+// client handshake. Wrapping a new socket for the same server with the same
+// context resumes that session (by session ID or ticket, whichever the
+// server supports), which avoids the public key operations of a full
+// handshake.
+typedef struct _mp_obj_ssl_context_t {
     mp_obj_base_t base;
-    mp_obj_t sock;
     mbedtls_entropy_context entropy;
     mbedtls_ctr_drbg_context ctr_drbg;
-    mbedtls_ssl_context ssl;
     mbedtls_ssl_config conf;
     mbedtls_x509_crt cacert;
     mbedtls_x509_crt cert;
     mbedtls_pk_context pkey;
+    mbedtls_ssl_session session;
+    mp_obj_t session_host;
+    bool has_session;
+} mp_obj_ssl_context_t;
+
+typedef struct _mp_obj_ssl_socket_t {
+    mp_obj_base_t base;
+    mp_obj_t sock;
+    mp_obj_ssl_context_t *ctx;
+    mbedtls_ssl_context ssl;
+    // Whether ctx was created just for this socket and is freed with it
+    bool own_ctx;
 } mp_obj_ssl_socket_t;
 
+#if MICROPY_PY_USSL_MAX_FRAG_LEN == 512
+#define USSL_MFL_CODE MBEDTLS_SSL_MAX_FRAG_LEN_512
+#elif MICROPY_PY_USSL_MAX_FRAG_LEN == 1024
+#define USSL_MFL_CODE MBEDTLS_SSL_MAX_FRAG_LEN_1024
+#elif MICROPY_PY_USSL_MAX_FRAG_LEN == 2048
+#define USSL_MFL_CODE MBEDTLS_SSL_MAX_FRAG_LEN_2048
+#elif MICROPY_PY_USSL_MAX_FRAG_LEN == 4096
+#define USSL_MFL_CODE MBEDTLS_SSL_MAX_FRAG_LEN_4096
+#elif MICROPY_PY_USSL_MAX_FRAG_LEN
+#error MICROPY_PY_USSL_MAX_FRAG_LEN must be 0, 512, 1024, 2048 or 4096
+#endif
+
 struct ssl_args {
     mp_arg_val_t key;
     mp_arg_val_t cert;
@@ -64,6 +92,7 @@ struct ssl_args {
     mp_arg_val_t server_hostname;
 };
 
+STATIC const mp_obj_type_t ussl_context_type;
 STATIC const mp_obj_type_t ussl_socket_type;
 
 static void mbedtls_debug(void *ctx, int level, const char *file, int line, const char *str) {
@@ -105,29 +134,31 @@ int _mbedtls_ssl_recv(void *ctx, byte *buf, size_t len) {
 }
 
 
-STATIC mp_obj_ssl_socket_t *socket_new(mp_obj_t sock, struct ssl_args *args) {
-    mp_obj_ssl_socket_t *o = m_new_obj(mp_obj_ssl_socket_t);
-    o->base.type = &ussl_socket_type;
+STATIC mp_obj_ssl_context_t *context_new(mp_obj_t key_in, mp_obj_t cert_in) {
+    mp_obj_ssl_context_t *ctx = m_new_obj(mp_obj_ssl_context_t);
+    ctx->base.type = &ussl_context_type;
+    ctx->session_host = mp_const_none;
+    ctx->has_session = false;
 
     int ret;
-    mbedtls_ssl_init(&o->ssl);
-    mbedtls_ssl_config_init(&o->conf);
-    mbedtls_x509_crt_init(&o->cacert);
-    mbedtls_x509_crt_init(&o->cert);
-    mbedtls_pk_init(&o->pkey);
-    mbedtls_ctr_drbg_init(&o->ctr_drbg);
+    mbedtls_ssl_config_init(&ctx->conf);
+    mbedtls_x509_crt_init(&ctx->cacert);
+    mbedtls_x509_crt_init(&ctx->cert);
+    mbedtls_pk_init(&ctx->pkey);
+    mbedtls_ssl_session_init(&ctx->session);
+    mbedtls_ctr_drbg_init(&ctx->ctr_drbg);
     // Debug level (0-4)
     mbedtls_debug_set_threshold(0);
 
-    mbedtls_entropy_init(&o->entropy);
+    mbedtls_entropy_init(&ctx->entropy);
     const byte seed[] = "upy";
-    ret = mbedtls_ctr_drbg_seed(&o->ctr_drbg, null_entropy_func/*mbedtls_entropy_func*/, &o->entropy, seed, sizeof(seed));
+    ret = mbedtls_ctr_drbg_seed(&ctx->ctr_drbg, null_entropy_func/*mbedtls_entropy_func*/, &ctx->entropy, seed, sizeof(seed));
     if (ret != 0) {
         printf("ret=%d\n", ret);
         assert(0);
     }
 
-    ret = mbedtls_ssl_config_defaults(&o->conf,
+    ret = mbedtls_ssl_config_defaults(&ctx->conf,
                     MBEDTLS_SSL_IS_CLIENT,
                     MBEDTLS_SSL_TRANSPORT_STREAM,
                     MBEDTLS_SSL_PRESET_DEFAULT);
@@ -135,17 +166,65 @@ STATIC mp_obj_ssl_socket_t *socket_new(mp_obj_t sock, struct ssl_args *args) {
         assert(0);
     }
 
-    mbedtls_ssl_conf_authmode(&o->conf, MBEDTLS_SSL_VERIFY_NONE);
-    mbedtls_ssl_conf_rng(&o->conf, mbedtls_ctr_drbg_random, &o->ctr_drbg);
-    mbedtls_ssl_conf_dbg(&o->conf, mbedtls_debug, NULL);
+    mbedtls_ssl_conf_authmode(&ctx->conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&ctx->conf, mbedtls_ctr_drbg_random, &ctx->ctr_drbg);
+    mbedtls_ssl_conf_dbg(&ctx->conf, mbedtls_debug, NULL);
+    #if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&ctx->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    #endif
+    #if MICROPY_PY_USSL_MAX_FRAG_LEN && defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    // Ask the server for records no longer than our (reduced) buffers
+    mbedtls_ssl_conf_max_frag_len(&ctx->conf, USSL_MFL_CODE);
+    #endif
+
+    if (key_in != MP_OBJ_NULL) {
+        mp_uint_t key_len;
+        const byte *key = (const byte*)mp_obj_str_get_data(key_in, &key_len);
+        // len should include terminating null
+        ret = mbedtls_pk_parse_key(&ctx->pkey, key, key_len + 1, NULL, 0);
+        assert(ret == 0);
+
+        mp_uint_t cert_len;
+        const byte *cert = (const byte*)mp_obj_str_get_data(cert_in, &cert_len);
+        // len should include terminating null
+        ret = mbedtls_x509_crt_parse(&ctx->cert, cert, cert_len + 1);
+        assert(ret == 0);
+
+        ret = mbedtls_ssl_conf_own_cert(&ctx->conf, &ctx->cert, &ctx->pkey);
+        assert(ret == 0);
+    }
+
+    return ctx;
+}
+
+STATIC void context_free(mp_obj_ssl_context_t *ctx) {
+    mbedtls_ssl_session_free(&ctx->session);
+    mbedtls_pk_free(&ctx->pkey);
+    mbedtls_x509_crt_free(&ctx->cert);
+    mbedtls_x509_crt_free(&ctx->cacert);
+    mbedtls_ssl_config_free(&ctx->conf);
+    mbedtls_ctr_drbg_free(&ctx->ctr_drbg);
+    mbedtls_entropy_free(&ctx->entropy);
+    ctx->has_session = false;
+}
 
-    ret = mbedtls_ssl_setup(&o->ssl, &o->conf);
+STATIC mp_obj_ssl_socket_t *socket_new(mp_obj_ssl_context_t *ctx, mp_obj_t sock, struct ssl_args *args) {
+    mp_obj_ssl_socket_t *o = m_new_obj(mp_obj_ssl_socket_t);
+    o->base.type = &ussl_socket_type;
+    o->ctx = ctx;
+    o->own_ctx = false;
+
+    int ret;
+    mbedtls_ssl_init(&o->ssl);
+
+    ret = mbedtls_ssl_setup(&o->ssl, &ctx->conf);
     if (ret != 0) {
         assert(0);
     }
 
-    if (args->server_hostname.u_obj != mp_const_none) {
-        const char *sni = mp_obj_str_get_str(args->server_hostname.u_obj);
+    mp_obj_t server_hostname = args->server_hostname.u_obj;
+    if (server_hostname != mp_const_none) {
+        const char *sni = mp_obj_str_get_str(server_hostname);
         ret = mbedtls_ssl_set_hostname(&o->ssl, sni);
         if (ret != 0) {
             assert(0);
@@ -155,33 +234,30 @@ STATIC mp_obj_ssl_socket_t *socket_new(mp_obj_t sock, struct ssl_args *args) {
     o->sock = sock;
     mbedtls_ssl_set_bio(&o->ssl, &o->sock, _mbedtls_ssl_send, _mbedtls_ssl_recv, NULL);
 
-    if (args->key.u_obj != MP_OBJ_NULL) {
-        mp_uint_t key_len;
-        const byte *key = (const byte*)mp_obj_str_get_data(args->key.u_obj, &key_len);
-        // len should include terminating null
-        ret = mbedtls_pk_parse_key(&o->pkey, key, key_len + 1, NULL, 0);
-        assert(ret == 0);
-
-        mp_uint_t cert_len;
-        const byte *cert = (const byte*)mp_obj_str_get_data(args->cert.u_obj, &cert_len);
-        // len should include terminating null
-        ret = mbedtls_x509_crt_parse(&o->cert, cert, cert_len + 1);
-        assert(ret == 0);
-
-        ret = mbedtls_ssl_conf_own_cert(&o->conf, &o->cert, &o->pkey);
-        assert(ret == 0);
-    }
-
     if (args->server_side.u_bool) {
         assert(0);
     } else {
+        if (ctx->has_session && mp_obj_equal(ctx->session_host, server_hostname)) {
+            // If the server doesn't accept the session, this silently
+            // falls back to a full handshake
+            mbedtls_ssl_set_session(&o->ssl, &ctx->session);
+        }
+
         while ((ret = mbedtls_ssl_handshake(&o->ssl)) != 0) {
             if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
                 //assert(0);
+                ctx->has_session = false;
+                mbedtls_ssl_free(&o->ssl);
                 printf("mbedtls_ssl_handshake error: -%x\n", -ret);
                 mp_raise_OSError(MP_EIO);
             }
         }
+
+        // Remember the (possibly new) session for the next connection
+        mbedtls_ssl_session_free(&ctx->session);
+        mbedtls_ssl_session_init(&ctx->session);
+        ctx->has_session = (mbedtls_ssl_get_session(&o->ssl, &ctx->session) == 0);
+        ctx->session_host = server_hostname;
     }
 
     return o;
@@ -196,10 +272,19 @@ STATIC void socket_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kin
 STATIC mp_uint_t socket_read(mp_obj_t o_in, void *buf, mp_uint_t size, int *errcode) {
     mp_obj_ssl_socket_t *o = MP_OBJ_TO_PTR(o_in);
 
+    // Records are decrypted straight into the caller's buffer, so reading
+    // with readinto() into a preallocated buffer involves no extra copies
     int ret = mbedtls_ssl_read(&o->ssl, buf, size);
     if (ret >= 0) {
         return ret;
     }
+    if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        // EOF
+        return 0;
+    }
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
+        ret = MP_EAGAIN;
+    }
     *errcode = ret;
     return MP_STREAM_ERROR;
 }
@@ -228,11 +313,10 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(socket_setblocking_obj, socket_setblocking);
 STATIC mp_obj_t socket_close(mp_obj_t self_in) {
     mp_obj_ssl_socket_t *self = MP_OBJ_TO_PTR(self_in);
 
-    mbedtls_x509_crt_free(&self->cacert);
     mbedtls_ssl_free(&self->ssl);
-    mbedtls_ssl_config_free(&self->conf);
-    mbedtls_ctr_drbg_free(&self->ctr_drbg);
-    mbedtls_entropy_free(&self->entropy);
+    if (self->own_ctx) {
+        context_free(self->ctx);
+    }
 
     mp_obj_t dest[2];
     mp_load_method(self->sock, MP_QSTR_close, dest);
@@ -268,29 +352,77 @@ STATIC const mp_obj_type_t ussl_socket_type = {
     .locals_dict = (void*)&ussl_socket_locals_dict,
 };
 
-STATIC mp_obj_t mod_ssl_wrap_socket(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    // TODO: Implement more args
+STATIC const mp_arg_t wrap_socket_allowed_args[] = {
+    { MP_QSTR_key, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+    { MP_QSTR_cert, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+    { MP_QSTR_server_side, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    { MP_QSTR_server_hostname, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+};
+
+STATIC mp_obj_t context_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+    (void)type;
+    enum { ARG_key, ARG_cert };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_key, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
         { MP_QSTR_cert, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
-        { MP_QSTR_server_side, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
-        { MP_QSTR_server_hostname, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
     };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    return MP_OBJ_FROM_PTR(context_new(args[ARG_key].u_obj, args[ARG_cert].u_obj));
+}
+
+STATIC mp_obj_t context_wrap_socket(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_obj_ssl_context_t *ctx = MP_OBJ_TO_PTR(pos_args[0]);
+    // TODO: Check that sock implements stream protocol
+    mp_obj_t sock = pos_args[1];
+
+    // key and cert are properties of the context, so aren't accepted here
+    struct ssl_args args;
+    args.key.u_obj = MP_OBJ_NULL;
+    args.cert.u_obj = MP_OBJ_NULL;
+    mp_arg_parse_all(n_args - 2, pos_args + 2, kw_args,
+        MP_ARRAY_SIZE(wrap_socket_allowed_args) - 2, wrap_socket_allowed_args + 2, &args.server_side);
+
+    return MP_OBJ_FROM_PTR(socket_new(ctx, sock, &args));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(context_wrap_socket_obj, 2, context_wrap_socket);
+
+STATIC const mp_rom_map_elem_t ussl_context_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_wrap_socket), MP_ROM_PTR(&context_wrap_socket_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(ussl_context_locals_dict, ussl_context_locals_dict_table);
 
+STATIC const mp_obj_type_t ussl_context_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_SSLContext,
+    .make_new = context_make_new,
+    .locals_dict = (void*)&ussl_context_locals_dict,
+};
+
+STATIC mp_obj_t mod_ssl_wrap_socket(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     // TODO: Check that sock implements stream protocol
     mp_obj_t sock = pos_args[0];
 
     struct ssl_args args;
     mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args,
-        MP_ARRAY_SIZE(allowed_args), allowed_args, (mp_arg_val_t*)&args);
+        MP_ARRAY_SIZE(wrap_socket_allowed_args), wrap_socket_allowed_args, (mp_arg_val_t*)&args);
 
-    return MP_OBJ_FROM_PTR(socket_new(sock, &args));
+    // A one-off context, so there's no session to resume
+    mp_obj_ssl_context_t *ctx = context_new(args.key.u_obj, args.cert.u_obj);
+    mp_obj_ssl_socket_t *o = socket_new(ctx, sock, &args);
+    o->own_ctx = true;
+    return MP_OBJ_FROM_PTR(o);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_ssl_wrap_socket_obj, 1, mod_ssl_wrap_socket);
 
 STATIC const mp_rom_map_elem_t mp_module_ssl_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ussl) },
     { MP_ROM_QSTR(MP_QSTR_wrap_socket), MP_ROM_PTR(&mod_ssl_wrap_socket_obj) },
+    { MP_ROM_QSTR(MP_QSTR_SSLContext), MP_ROM_PTR(&ussl_context_type) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ssl_globals, mp_module_ssl_globals_table);
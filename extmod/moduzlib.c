@@ -34,6 +34,8 @@
 
 #if MICROPY_PY_UZLIB
 
+#define TINF_FAST_BITS MICROPY_PY_UZLIB_FAST_BITS
+#define TINF_CRC32_TABLES MICROPY_PY_UZLIB_CRC32_TABLES
 #include "uzlib/tinf.h"
 
 #if 0 // print debugging info
@@ -183,11 +185,13 @@ STATIC mp_obj_t mod_uzlib_decompress(size_t n_args, const mp_obj_t *args) {
         if (st == TINF_DONE) {
             break;
         }
+        // grow the buffer geometrically so long outputs aren't copied over and over
         size_t offset = decomp->dest - dest_buf;
-        dest_buf = m_renew(byte, dest_buf, dest_buf_size, dest_buf_size + 256);
-        dest_buf_size += 256;
+        size_t extra = ((dest_buf_size / 2) & ~255) + 256;
+        dest_buf = m_renew(byte, dest_buf, dest_buf_size, dest_buf_size + extra);
+        dest_buf_size += extra;
         decomp->dest = dest_buf + offset;
-        decomp->destSize = 256;
+        decomp->destSize = extra;
     }
 
     mp_uint_t final_sz = decomp->dest - dest_buf;
@@ -202,10 +206,207 @@ error:
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_uzlib_decompress_obj, 1, 3, mod_uzlib_decompress);
 
+#if MICROPY_PY_UZLIB_COMPRESS
+
+#define COMP_FORMAT_RAW (0)
+#define COMP_FORMAT_ZLIB (1)
+#define COMP_FORMAT_GZIP (2)
+
+typedef struct _mp_obj_compio_t {
+    mp_obj_base_t base;
+    mp_obj_t dest_stream; // MP_OBJ_NULL when writing to out_vstr
+    vstr_t *out_vstr;
+    struct uzlib_comp comp;
+    uint32_t chksum;
+    uint32_t isize;
+    byte format;
+    bool closed;
+} mp_obj_compio_t;
+
+STATIC void compio_write_dest(mp_obj_compio_t *self, const void *buf, size_t len) {
+    if (self->dest_stream == MP_OBJ_NULL) {
+        vstr_add_strn(self->out_vstr, buf, len);
+        return;
+    }
+    int err;
+    mp_uint_t out_sz = mp_stream_write_exactly(self->dest_stream, buf, len, &err);
+    if (err != 0) {
+        mp_raise_OSError(err);
+    }
+    (void)out_sz;
+}
+
+STATIC void write_dest_stream(struct uzlib_comp *c, const unsigned char *buf, unsigned int len) {
+    byte *p = (void*)c;
+    p -= offsetof(mp_obj_compio_t, comp);
+    compio_write_dest((mp_obj_compio_t*)p, buf, len);
+}
+
+// wbits follows the convention of DecompIO: negative for a raw deflate
+// stream, 9..15 for zlib, and 16 plus 9..15 for gzip.
+STATIC void compio_init(mp_obj_compio_t *self, mp_int_t wbits) {
+    self->format = COMP_FORMAT_ZLIB;
+    if (wbits < 0) {
+        self->format = COMP_FORMAT_RAW;
+        wbits = -wbits;
+    } else if (wbits >= 16) {
+        self->format = COMP_FORMAT_GZIP;
+        wbits -= 16;
+    }
+    if (wbits < 9 || wbits > 15) {
+        mp_raise_ValueError("wbits");
+    }
+    self->closed = false;
+    self->isize = 0;
+
+    uzlib_compress_init(&self->comp, m_new(byte, 1 << wbits), wbits,
+        m_new(unsigned short, 1 << (wbits - 1)), wbits - 1, write_dest_stream);
+
+    if (self->format == COMP_FORMAT_ZLIB) {
+        byte hdr[2] = {0x08 | (wbits - 8) << 4, 0};
+        hdr[1] = 31 - (hdr[0] << 8) % 31;
+        compio_write_dest(self, hdr, 2);
+        self->chksum = 1;
+    } else if (self->format == COMP_FORMAT_GZIP) {
+        // no flags, no mtime, unknown OS
+        static const byte hdr[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+        compio_write_dest(self, hdr, sizeof(hdr));
+        self->chksum = ~0;
+    }
+}
+
+STATIC void compio_data(mp_obj_compio_t *self, const byte *buf, size_t len) {
+    uzlib_compress_data(&self->comp, buf, len);
+    self->isize += len;
+    if (self->format == COMP_FORMAT_ZLIB) {
+        self->chksum = uzlib_adler32(buf, len, self->chksum);
+    } else if (self->format == COMP_FORMAT_GZIP) {
+        self->chksum = uzlib_crc32(buf, len, self->chksum);
+    }
+}
+
+STATIC void compio_finish(mp_obj_compio_t *self) {
+    uzlib_compress_flush(&self->comp, 1);
+    byte trailer[8];
+    size_t n = 0;
+    if (self->format == COMP_FORMAT_ZLIB) {
+        for (int i = 24; i >= 0; i -= 8) {
+            trailer[n++] = self->chksum >> i;
+        }
+    } else if (self->format == COMP_FORMAT_GZIP) {
+        uint32_t crc = ~self->chksum;
+        for (int i = 0; i < 32; i += 8) {
+            trailer[n++] = crc >> i;
+        }
+        for (int i = 0; i < 32; i += 8) {
+            trailer[n++] = self->isize >> i;
+        }
+    }
+    compio_write_dest(self, trailer, n);
+    self->closed = true;
+    m_del(byte, self->comp.window, self->comp.window_mask + 1);
+    m_del(unsigned short, self->comp.hash, 1 << self->comp.hash_bits);
+    self->comp.window = NULL;
+    self->comp.hash = NULL;
+}
+
+STATIC mp_obj_t compio_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 2, false);
+    mp_get_stream_raise(args[0], MP_STREAM_OP_WRITE);
+    mp_obj_compio_t *o = m_new_obj(mp_obj_compio_t);
+    o->base.type = type;
+    o->dest_stream = args[0];
+    o->out_vstr = NULL;
+    compio_init(o, n_args > 1 ? mp_obj_get_int(args[1]) : 10);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_uint_t compio_write(mp_obj_t o_in, const void *buf, mp_uint_t size, int *errcode) {
+    mp_obj_compio_t *o = MP_OBJ_TO_PTR(o_in);
+    if (o->closed) {
+        *errcode = MP_EINVAL;
+        return MP_STREAM_ERROR;
+    }
+    compio_data(o, buf, size);
+    return size;
+}
+
+// Ends the current block and byte-aligns the output with an empty stored
+// block, so everything written so far can be decompressed by the receiver.
+STATIC mp_obj_t compio_flush(mp_obj_t self_in) {
+    mp_obj_compio_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->closed) {
+        uzlib_compress_flush(&self->comp, 0);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(compio_flush_obj, compio_flush);
+
+// Terminates the deflate stream and writes the trailer; the destination
+// stream is left open.
+STATIC mp_obj_t compio_close(mp_obj_t self_in) {
+    mp_obj_compio_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->closed) {
+        compio_finish(self);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(compio_close_obj, compio_close);
+
+STATIC mp_obj_t compio___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return compio_close(args[0]);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(compio___exit___obj, 4, 4, compio___exit__);
+
+STATIC const mp_rom_map_elem_t compio_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&compio_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&compio_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&mp_identity_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&compio___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(compio_locals_dict, compio_locals_dict_table);
+
+STATIC const mp_stream_p_t compio_stream_p = {
+    .write = compio_write,
+};
+
+STATIC const mp_obj_type_t compio_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_CompressIO,
+    .make_new = compio_make_new,
+    .protocol = &compio_stream_p,
+    .locals_dict = (void*)&compio_locals_dict,
+};
+
+STATIC mp_obj_t mod_uzlib_compress(size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_READ);
+
+    vstr_t vstr;
+    vstr_init(&vstr, bufinfo.len / 2 + 16);
+    mp_obj_compio_t comp;
+    comp.dest_stream = MP_OBJ_NULL;
+    comp.out_vstr = &vstr;
+    compio_init(&comp, n_args > 1 ? mp_obj_get_int(args[1]) : 10);
+    compio_data(&comp, bufinfo.buf, bufinfo.len);
+    compio_finish(&comp);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_uzlib_compress_obj, 1, 2, mod_uzlib_compress);
+
+#endif // MICROPY_PY_UZLIB_COMPRESS
+
 STATIC const mp_rom_map_elem_t mp_module_uzlib_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uzlib) },
     { MP_ROM_QSTR(MP_QSTR_decompress), MP_ROM_PTR(&mod_uzlib_decompress_obj) },
     { MP_ROM_QSTR(MP_QSTR_DecompIO), MP_ROM_PTR(&decompio_type) },
+    #if MICROPY_PY_UZLIB_COMPRESS
+    { MP_ROM_QSTR(MP_QSTR_compress), MP_ROM_PTR(&mod_uzlib_compress_obj) },
+    { MP_ROM_QSTR(MP_QSTR_CompressIO), MP_ROM_PTR(&compio_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_uzlib_globals, mp_module_uzlib_globals_table);
@@ -223,5 +424,8 @@ const mp_obj_module_t mp_module_uzlib = {
 #include "uzlib/tinfgzip.c"
 #include "uzlib/adler32.c"
 #include "uzlib/crc32.c"
+#if MICROPY_PY_UZLIB_COMPRESS
+#include "uzlib/defl_static.c"
+#endif
 
 #endif // MICROPY_PY_UZLIB
@@ -34,6 +34,7 @@
 #include "py/runtime.h"
 #include "py/stream.h"
 #include "py/builtin.h"
+#include "py/mperrno.h"
 #ifdef MICROPY_PY_WEBREPL_DELAY
 #include "py/mphal.h"
 #endif
@@ -78,6 +79,10 @@ STATIC char denied_prompt[] = "\r\nAccess denied\r\n";
 
 STATIC char webrepl_passwd[10];
 
+// Shared by PUT and GET transfers (only one is active at a time); for GET,
+// the first 2 bytes hold the chunk length
+STATIC byte filebuf[MICROPY_PY_WEBREPL_CHUNK_SIZE];
+
 STATIC void write_webrepl(mp_obj_t websock, const void *buf, size_t len) {
     const mp_stream_p_t *sock_stream = mp_get_stream_raise(websock, MP_STREAM_OP_WRITE | MP_STREAM_OP_IOCTL);
     int err;
@@ -115,16 +120,15 @@ STATIC mp_obj_t webrepl_make_new(const mp_obj_type_t *type, size_t n_args, size_
 STATIC int write_file_chunk(mp_obj_webrepl_t *self) {
     const mp_stream_p_t *file_stream =
         mp_get_stream_raise(self->cur_file, MP_STREAM_OP_READ | MP_STREAM_OP_WRITE | MP_STREAM_OP_IOCTL);
-    byte readbuf[2 + 256];
     int err;
-    mp_uint_t out_sz = file_stream->read(self->cur_file, readbuf + 2, sizeof(readbuf) - 2, &err);
+    mp_uint_t out_sz = file_stream->read(self->cur_file, filebuf + 2, sizeof(filebuf) - 2, &err);
     if (out_sz == MP_STREAM_ERROR) {
         return out_sz;
     }
-    readbuf[0] = out_sz;
-    readbuf[1] = out_sz >> 8;
+    filebuf[0] = out_sz;
+    filebuf[1] = out_sz >> 8;
     DEBUG_printf("webrepl: Sending %d bytes of file\n", out_sz);
-    write_webrepl(self->sock, readbuf, 2 + out_sz);
+    write_webrepl(self->sock, filebuf, 2 + out_sz);
     return out_sz;
 }
 
@@ -241,15 +245,24 @@ STATIC mp_uint_t _webrepl_read(mp_obj_t self_in, void *buf, mp_uint_t size, int
     }
 
     if (self->data_to_recv != 0) {
-        static byte filebuf[512];
         filebuf[0] = *(byte*)buf;
         mp_uint_t buf_sz = 1;
-        if (--self->data_to_recv != 0) {
-            size_t to_read = MIN(sizeof(filebuf) - 1, self->data_to_recv);
-            mp_uint_t sz = sock_stream->read(self->sock, filebuf + 1, to_read, errcode);
+        --self->data_to_recv;
+        // Fill the buffer with as much as the socket has ready, possibly
+        // spanning several websocket frames, so the file is written (and
+        // any rate-limiting delay taken) once per chunk
+        while (self->data_to_recv != 0 && buf_sz < sizeof(filebuf)) {
+            size_t to_read = MIN(sizeof(filebuf) - buf_sz, self->data_to_recv);
+            mp_uint_t sz = sock_stream->read(self->sock, filebuf + buf_sz, to_read, errcode);
             if (sz == MP_STREAM_ERROR) {
+                if (*errcode == MP_EAGAIN) {
+                    break;
+                }
                 return sz;
             }
+            if (sz == 0) {
+                break;
+            }
             self->data_to_recv -= sz;
             buf_sz += sz;
         }
@@ -76,6 +76,41 @@ STATIC mp_obj_t websocket_make_new(const mp_obj_type_t *type, size_t n_args, siz
     return  MP_OBJ_FROM_PTR(o);
 }
 
+// Unmask a chunk of payload in place. Bytes are processed one at a time
+// only until buf is word-aligned, then the mask (rotated to the current
+// position) is applied a machine word at a time.
+STATIC void websocket_unmask(mp_obj_websocket_t *self, byte *buf, size_t sz) {
+    uint32_t mask32;
+    memcpy(&mask32, self->mask, sizeof(mask32));
+    if (mask32 == 0) {
+        // Unmasked frame
+        return;
+    }
+    while (sz != 0 && ((uintptr_t)buf & (sizeof(mp_uint_t) - 1)) != 0) {
+        *buf++ ^= self->mask[self->mask_pos++ & 3];
+        sz--;
+    }
+    if (sz >= sizeof(mp_uint_t)) {
+        byte rot[sizeof(mp_uint_t)];
+        for (size_t i = 0; i < sizeof(rot); i++) {
+            rot[i] = self->mask[(self->mask_pos + i) & 3];
+        }
+        mp_uint_t m;
+        memcpy(&m, rot, sizeof(m));
+        mp_uint_t *w = (mp_uint_t*)buf;
+        size_t nw = sz / sizeof(mp_uint_t);
+        for (size_t i = 0; i < nw; i++) {
+            w[i] ^= m;
+        }
+        // Word size is a multiple of 4, so mask_pos is unchanged
+        buf += nw * sizeof(mp_uint_t);
+        sz -= nw * sizeof(mp_uint_t);
+    }
+    while (sz--) {
+        *buf++ ^= self->mask[self->mask_pos++ & 3];
+    }
+}
+
 STATIC mp_uint_t websocket_read(mp_obj_t self_in, void *buf, mp_uint_t size, int *errcode) {
     mp_obj_websocket_t *self =  MP_OBJ_TO_PTR(self_in);
     const mp_stream_p_t *stream_p = mp_get_stream_raise(self->sock, MP_STREAM_OP_READ);
@@ -177,10 +212,7 @@ STATIC mp_uint_t websocket_read(mp_obj_t self_in, void *buf, mp_uint_t size, int
                     return out_sz;
                 }
 
-                sz = out_sz;
-                for (byte *p = buf; sz--; p++) {
-                    *p ^= self->mask[self->mask_pos++ & 3];
-                }
+                websocket_unmask(self, buf, out_sz);
 
                 self->msg_sz -= out_sz;
                 if (self->msg_sz == 0) {
@@ -0,0 +1,210 @@
+// Copyright 2007-2009 Russ Cox.  All Rights Reserved.
+// Copyright 2014 Paul Sokolovsky.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include "re1.5.h"
+
+// Pike VM: runs all threads of the program in lock step over the subject,
+// so matching takes time linear in the subject length and no recursion.
+// Threads are kept in priority order and lower priority threads are cut
+// once one matches, which gives the same leftmost-first results as the
+// backtracking matchers.
+
+#ifndef re1_5_alloc
+#define re1_5_alloc(n) malloc(n)
+#define re1_5_free(p, n) free(p)
+#endif
+
+typedef struct Thread Thread;
+typedef struct ThreadList ThreadList;
+typedef struct Job Job;
+typedef struct PikeVM PikeVM;
+
+struct Thread
+{
+    const char *pc;
+    const char **sub;
+};
+
+struct ThreadList
+{
+    int n;
+    Thread *t;
+};
+
+// Pending work of addthread: follow pc, or if pc is nil restore sub[slot]
+struct Job
+{
+    const char *pc;
+    int slot;
+    const char *sp;
+};
+
+struct PikeVM
+{
+    ByteProg *prog;
+    Subject *input;
+    int nsubp;
+    unsigned char *marks; // bitmap of instructions already on the list
+    Job *stack;
+    const char **sub;     // captures of the path being followed
+};
+
+// Add the thread at pc, and all threads reachable from it without
+// consuming input, to the end of list l.
+static void addthread(PikeVM *vm, ThreadList *l, const char *pc, const char *sp, const char **sub)
+{
+    Job *stack = vm->stack;
+    int n = 0;
+    int off;
+
+    memcpy(vm->sub, sub, vm->nsubp * sizeof(*sub));
+    stack[n].pc = pc;
+    n++;
+
+    while (n) {
+        n--;
+        pc = stack[n].pc;
+        if (pc == nil) {
+            vm->sub[stack[n].slot] = stack[n].sp;
+            continue;
+        }
+        for (;;) {
+            off = pc - vm->prog->insts;
+            if (vm->marks[off >> 3] & (1 << (off & 7))) {
+                break;
+            }
+            vm->marks[off >> 3] |= 1 << (off & 7);
+
+            switch (*pc) {
+            case Jmp:
+                pc += 2 + (signed char)pc[1];
+                continue;
+            case Split:
+                stack[n++].pc = pc + 2 + (signed char)pc[1];
+                pc += 2;
+                continue;
+            case RSplit:
+                stack[n++].pc = pc + 2;
+                pc += 2 + (signed char)pc[1];
+                continue;
+            case Save:
+                off = (unsigned char)pc[1];
+                if (off < vm->nsubp) {
+                    stack[n].pc = nil;
+                    stack[n].slot = off;
+                    stack[n].sp = vm->sub[off];
+                    n++;
+                    vm->sub[off] = sp;
+                }
+                pc += 2;
+                continue;
+            case Bol:
+                if (sp != vm->input->bol) {
+                    break;
+                }
+                pc++;
+                continue;
+            case Eol:
+                if (sp != vm->input->end) {
+                    break;
+                }
+                pc++;
+                continue;
+            default:
+                // consumer or Match, wait for the next step
+                l->t[l->n].pc = pc;
+                memcpy(l->t[l->n].sub, vm->sub, vm->nsubp * sizeof(*sub));
+                l->n++;
+                break;
+            }
+            break;
+        }
+    }
+}
+
+int re1_5_pikevm(ByteProg *prog, Subject *input, const char **subp, int nsubp, int is_anchored)
+{
+    // every instruction is on a list at most once, and pushes at most one job
+    int nthreads = prog->len;
+    int marks_len = (prog->bytelen + 7) / 8;
+    size_t size = (2 * nthreads + 1) * nsubp * sizeof(char*)
+        + 2 * nthreads * sizeof(Thread)
+        + (nthreads + 1) * sizeof(Job)
+        + marks_len;
+    char *mem = re1_5_alloc(size);
+
+    PikeVM vm;
+    ThreadList lists[2], *clist = &lists[0], *nlist = &lists[1], *tmp;
+    const char **subs = (const char**)mem;
+    Thread *threads = (Thread*)(subs + (2 * nthreads + 1) * nsubp);
+    int i, matched = 0;
+    const char *sp, *pc;
+
+    vm.prog = prog;
+    vm.input = input;
+    vm.nsubp = nsubp;
+    vm.sub = subs + 2 * nthreads * nsubp;
+    vm.stack = (Job*)(threads + 2 * nthreads);
+    vm.marks = (unsigned char*)(vm.stack + nthreads + 1);
+    for (i = 0; i < 2 * nthreads; i++) {
+        threads[i].sub = subs + i * nsubp;
+    }
+    lists[0].t = threads;
+    lists[1].t = threads + nthreads;
+
+    clist->n = 0;
+    memset(vm.marks, 0, marks_len);
+    addthread(&vm, clist, HANDLE_ANCHORED(prog->insts, is_anchored), input->begin, subp);
+
+    for (sp = input->begin; clist->n; sp++) {
+        memset(vm.marks, 0, marks_len);
+        nlist->n = 0;
+        for (i = 0; i < clist->n; i++) {
+            Thread *t = &clist->t[i];
+            pc = t->pc;
+            if (inst_is_consumer(*pc) && sp >= input->end) {
+                continue;
+            }
+            switch (*pc) {
+            case Char:
+                if (*sp == pc[1]) {
+                    addthread(&vm, nlist, pc + 2, sp + 1, t->sub);
+                }
+                break;
+            case Any:
+                addthread(&vm, nlist, pc + 1, sp + 1, t->sub);
+                break;
+            case Class:
+            case ClassNot:
+                if (_re1_5_classmatch(pc + 1, sp)) {
+                    addthread(&vm, nlist, pc + 2 + *(unsigned char*)(pc + 1) * 2, sp + 1, t->sub);
+                }
+                break;
+            case NamedClass:
+                if (_re1_5_namedclassmatch(pc + 1, sp)) {
+                    addthread(&vm, nlist, pc + 2, sp + 1, t->sub);
+                }
+                break;
+            case Match:
+                memcpy(subp, t->sub, nsubp * sizeof(*subp));
+                matched = 1;
+                // cut off the lower priority threads
+                i = clist->n;
+                break;
+            default:
+                re1_5_fatal("pikevm");
+            }
+        }
+        tmp = clist;
+        clist = nlist;
+        nlist = tmp;
+        if (sp >= input->end) {
+            break;
+        }
+    }
+
+    re1_5_free(mem, size);
+    return matched;
+}
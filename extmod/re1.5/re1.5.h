@@ -129,6 +129,7 @@ void decref(Sub*);
 struct Subject {
 	const char *begin;
 	const char *end;
+	const char *bol; // start of the string, where ^ matches
 };
 
 
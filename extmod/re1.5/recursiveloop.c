@@ -65,7 +65,7 @@ recursiveloop(char *pc, const char *sp, Subject *input, const char **subp, int n
 			subp[off] = old;
 			return 0;
 		case Bol:
-			if(sp != input->begin)
+			if(sp != input->bol)
 				return 0;
 			continue;
 		case Eol:
@@ -0,0 +1,225 @@
+/*
+ * defl_static  -  tiny deflate compressor using fixed Huffman codes
+ *
+ * This software is provided 'as-is', without any express
+ * or implied warranty.  In no event will the authors be
+ * held liable for any damages arising from the use of
+ * this software.
+ *
+ * Permission is granted to anyone to use this software
+ * for any purpose, including commercial applications,
+ * and to alter it and redistribute it freely, subject to
+ * the following restrictions:
+ *
+ * 1. The origin of this software must not be
+ *    misrepresented; you must not claim that you
+ *    wrote the original software. If you use this
+ *    software in a product, an acknowledgment in
+ *    the product documentation would be appreciated
+ *    but is not required.
+ *
+ * 2. Altered source versions must be plainly marked
+ *    as such, and must not be misrepresented as
+ *    being the original software.
+ *
+ * 3. This notice may not be removed or altered from
+ *    any source distribution.
+ */
+
+/*
+ * Matches are found with a hash of the next 3 bytes, which indexes a table
+ * holding the last position seen with that hash.  Only that one candidate
+ * is tried, so compression is fast and uses little memory (the window and
+ * the hash table), at some cost in ratio compared to zlib.  All data is
+ * coded in fixed Huffman blocks, so no code tables need to be built.
+ */
+
+#include "tinf.h"
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+
+static const unsigned short defl_length_base[29] = {
+   3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const unsigned char defl_length_bits[29] = {
+   0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+   3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const unsigned short defl_dist_base[30] = {
+   1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+   257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const unsigned char defl_dist_bits[30] = {
+   0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+   7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void outbyte(struct uzlib_comp *c, unsigned char b)
+{
+   c->outbuf[c->outlen++] = b;
+   if (c->outlen == sizeof(c->outbuf)) {
+      c->write_out(c, c->outbuf, c->outlen);
+      c->outlen = 0;
+   }
+}
+
+/* write bits, least significant first */
+static void outbits(struct uzlib_comp *c, unsigned int bits, int nbits)
+{
+   c->bitbuf |= bits << c->nbits;
+   c->nbits += nbits;
+   while (c->nbits >= 8) {
+      outbyte(c, c->bitbuf & 0xff);
+      c->bitbuf >>= 8;
+      c->nbits -= 8;
+   }
+}
+
+/* write a Huffman code, which goes most significant bit first */
+static void outcode(struct uzlib_comp *c, unsigned int code, int nbits)
+{
+   unsigned int rev = 0;
+   for (int i = 0; i < nbits; i++) {
+      rev = (rev << 1) | (code & 1);
+      code >>= 1;
+   }
+   outbits(c, rev, nbits);
+}
+
+/* write a literal/length symbol with the fixed code */
+static void outsym(struct uzlib_comp *c, unsigned int sym)
+{
+   if (sym < 144) {
+      outcode(c, 0x30 + sym, 8);
+   } else if (sym < 256) {
+      outcode(c, 0x190 + sym - 144, 9);
+   } else if (sym < 280) {
+      outcode(c, sym - 256, 7);
+   } else {
+      outcode(c, 0xc0 + sym - 280, 8);
+   }
+}
+
+static void outmatch(struct uzlib_comp *c, unsigned int len, unsigned int dist)
+{
+   int i = 28;
+   while (defl_length_base[i] > len) i--;
+   outsym(c, 257 + i);
+   outbits(c, len - defl_length_base[i], defl_length_bits[i]);
+   i = 29;
+   while (defl_dist_base[i] > dist) i--;
+   outcode(c, i, 5);
+   outbits(c, dist - defl_dist_base[i], defl_dist_bits[i]);
+}
+
+static void start_block(struct uzlib_comp *c)
+{
+   if (!c->in_block) {
+      /* BFINAL = 0, BTYPE = 01 (fixed Huffman) */
+      outbits(c, 2, 3);
+      c->in_block = 1;
+   }
+}
+
+void uzlib_compress_init(struct uzlib_comp *c, unsigned char *window, unsigned int wbits,
+   unsigned short *hash, unsigned int hash_bits,
+   void (*write_out)(struct uzlib_comp *c, const unsigned char *buf, unsigned int len))
+{
+   c->window = window;
+   c->window_mask = (1 << wbits) - 1;
+   c->hash = hash;
+   c->hash_bits = hash_bits;
+   for (unsigned int i = 0; i < (1u << hash_bits); i++) {
+      hash[i] = 0;
+   }
+   c->pos = 0;
+   c->bitbuf = 0;
+   c->nbits = 0;
+   c->in_block = 0;
+   c->outlen = 0;
+   c->write_out = write_out;
+}
+
+#define HASH(c, p) ((((p)[0] << 16 | (p)[1] << 8 | (p)[2]) * 2654435761u) >> (32 - (c)->hash_bits))
+
+void uzlib_compress_data(struct uzlib_comp *c, const unsigned char *src, unsigned int len)
+{
+   if (len == 0) return;
+   start_block(c);
+
+   /* src[i] is at stream position c->pos + i; bytes before src come from
+      the window, which holds the last window_mask + 1 bytes */
+   unsigned int i = 0;
+   while (i < len) {
+      unsigned int best_len = 0;
+      unsigned int dist = 0;
+      if (len - i >= MIN_MATCH) {
+         unsigned int h = HASH(c, src + i);
+         unsigned short cand = c->hash[h];
+         c->hash[h] = (unsigned short)(c->pos + i);
+         dist = (unsigned short)(c->pos + i - cand);
+         if (dist > 0 && dist <= c->window_mask && dist <= c->pos + i) {
+            unsigned int max = len - i;
+            if (max > MAX_MATCH) max = MAX_MATCH;
+            while (best_len < max) {
+               unsigned char b;
+               if (i + best_len >= dist) {
+                  /* the earlier byte is within src */
+                  b = src[i + best_len - dist];
+               } else {
+                  b = c->window[(c->pos + i + best_len - dist) & c->window_mask];
+               }
+               if (b != src[i + best_len]) break;
+               best_len++;
+            }
+         }
+      }
+
+      unsigned int n;
+      if (best_len >= MIN_MATCH) {
+         outmatch(c, best_len, dist);
+         n = best_len;
+      } else {
+         outsym(c, src[i]);
+         n = 1;
+      }
+      /* move the consumed bytes into the window, hashing those within a match */
+      for (unsigned int k = 0; k < n; k++, i++) {
+         if (k > 0 && len - i >= MIN_MATCH) {
+            c->hash[HASH(c, src + i)] = (unsigned short)(c->pos + i);
+         }
+         c->window[(c->pos + i) & c->window_mask] = src[i];
+      }
+   }
+   c->pos += len;
+}
+
+void uzlib_compress_flush(struct uzlib_comp *c, int final)
+{
+   if (c->in_block) {
+      /* end of block */
+      outsym(c, 256);
+      c->in_block = 0;
+   }
+   if (final) {
+      /* final empty fixed block */
+      outbits(c, 3, 3);
+      outsym(c, 256);
+   } else {
+      /* empty stored block, to align to a byte boundary */
+      outbits(c, 0, 3);
+      if (c->nbits > 0) outbits(c, 0, 8 - c->nbits);
+      outbits(c, 0x0000, 16);
+      outbits(c, 0xffff, 16);
+   }
+   if (c->nbits > 0) outbits(c, 0, 8 - c->nbits);
+   if (c->outlen > 0) {
+      c->write_out(c, c->outbuf, c->outlen);
+      c->outlen = 0;
+   }
+}
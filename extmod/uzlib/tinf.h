@@ -41,9 +41,18 @@ extern "C" {
 
 /* data structures */
 
+/* number of bits decoded at once by table lookup; each tree then takes
+   2 << TINF_FAST_BITS more bytes. 0 decodes bit by bit. */
+#ifndef TINF_FAST_BITS
+#define TINF_FAST_BITS 0
+#endif
+
 typedef struct {
    unsigned short table[16];  /* table of code length counts */
    unsigned short trans[288]; /* code -> symbol translation table */
+#if TINF_FAST_BITS
+   unsigned short fast[1 << TINF_FAST_BITS]; /* lookup of short codes */
+#endif
 } TINF_TREE;
 
 struct TINF_DATA;
@@ -101,7 +110,28 @@ int TINFCC uzlib_gzip_parse_header(TINF_DATA *d);
 
 /* Compression API */
 
-void TINFCC uzlib_compress(void *data, const uint8_t *src, unsigned slen);
+struct uzlib_comp {
+   unsigned char *window;     /* ring of the last window_mask + 1 bytes */
+   unsigned int window_mask;
+   unsigned short *hash;      /* last position for each 3-byte hash */
+   unsigned int hash_bits;
+   unsigned int pos;          /* number of bytes consumed so far */
+
+   unsigned int bitbuf;
+   int nbits;
+   int in_block;
+
+   unsigned int outlen;
+   unsigned char outbuf[32];
+   void (*write_out)(struct uzlib_comp *c, const unsigned char *buf, unsigned int len);
+};
+
+void TINFCC uzlib_compress_init(struct uzlib_comp *c, unsigned char *window, unsigned int wbits,
+   unsigned short *hash, unsigned int hash_bits,
+   void (*write_out)(struct uzlib_comp *c, const unsigned char *buf, unsigned int len));
+void TINFCC uzlib_compress_data(struct uzlib_comp *c, const unsigned char *src, unsigned int len);
+/* end the current block; if final is set the stream is terminated */
+void TINFCC uzlib_compress_flush(struct uzlib_comp *c, int final);
 
 /* Checksum API */
 
@@ -112,13 +112,41 @@ static void tinf_build_bits_base(unsigned char *bits, unsigned short *base, int
 }
 #endif
 
+#if TINF_FAST_BITS
+/* build the lookup table for codes of up to TINF_FAST_BITS bits; an entry
+   holds the code length above the low 9 bits and the symbol in them, or 0
+   if the code is longer (or the tree is incomplete there) */
+static void tinf_build_fast_table(TINF_TREE *t)
+{
+   unsigned int len, i, k, code = 0, idx = 0;
+
+   for (i = 0; i < (1 << TINF_FAST_BITS); ++i) t->fast[i] = 0;
+
+   for (len = 1; len <= TINF_FAST_BITS; ++len)
+   {
+      for (i = 0; i < t->table[len]; ++i, ++code, ++idx)
+      {
+         /* codes are stored msb first, so the table index is reversed */
+         unsigned int rev = 0, c = code;
+         for (k = 0; k < len; ++k, c >>= 1) rev = (rev << 1) | (c & 1);
+
+         for (k = rev; k < (1 << TINF_FAST_BITS); k += 1 << len)
+         {
+            t->fast[k] = len << 9 | t->trans[idx];
+         }
+      }
+      code <<= 1;
+   }
+}
+#endif
+
 /* build the fixed huffman trees */
 static void tinf_build_fixed_trees(TINF_TREE *lt, TINF_TREE *dt)
 {
    int i;
 
    /* build fixed length tree */
-   for (i = 0; i < 7; ++i) lt->table[i] = 0;
+   for (i = 0; i < 16; ++i) lt->table[i] = 0;
 
    lt->table[7] = 24;
    lt->table[8] = 152;
@@ -130,11 +158,16 @@ static void tinf_build_fixed_trees(TINF_TREE *lt, TINF_TREE *dt)
    for (i = 0; i < 112; ++i) lt->trans[24 + 144 + 8 + i] = 144 + i;
 
    /* build fixed distance tree */
-   for (i = 0; i < 5; ++i) dt->table[i] = 0;
+   for (i = 0; i < 16; ++i) dt->table[i] = 0;
 
    dt->table[5] = 32;
 
    for (i = 0; i < 32; ++i) dt->trans[i] = i;
+
+#if TINF_FAST_BITS
+   tinf_build_fast_table(lt);
+   tinf_build_fast_table(dt);
+#endif
 }
 
 /* given an array of code lengths, build a tree */
@@ -163,6 +196,10 @@ static void tinf_build_tree(TINF_TREE *t, const unsigned char *lengths, unsigned
    {
       if (lengths[i]) t->trans[offs[lengths[i]]++] = i;
    }
+
+#if TINF_FAST_BITS
+   tinf_build_fast_table(t);
+#endif
 }
 
 /* ---------------------- *
@@ -197,22 +234,33 @@ uint32_t tinf_get_be_uint32(TINF_DATA *d)
     return val;
 }
 
+/* The tag holds the next bitcount bits of the source stream, lsb first,
+   with the bits above them clear.  Whole bytes are only loaded when the
+   bits already in the tag are not enough, so nothing is read past the end
+   of the deflate stream and bitcount is below 8 between symbols. */
+
+/* load the next byte into the tag */
+static void tinf_refill(TINF_DATA *d)
+{
+   d->tag |= (unsigned int)uzlib_get_byte(d) << d->bitcount;
+   d->bitcount += 8;
+}
+
 /* get one bit from source stream */
 static int tinf_getbit(TINF_DATA *d)
 {
    unsigned int bit;
 
    /* check if tag is empty */
-   if (!d->bitcount--)
+   if (!d->bitcount)
    {
-      /* load next tag */
-      d->tag = uzlib_get_byte(d);
-      d->bitcount = 7;
+      tinf_refill(d);
    }
 
    /* shift bit out of tag */
    bit = d->tag & 0x01;
    d->tag >>= 1;
+   d->bitcount--;
 
    return bit;
 }
@@ -220,18 +268,17 @@ static int tinf_getbit(TINF_DATA *d)
 /* read a num bit value from a stream and add base */
 static unsigned int tinf_read_bits(TINF_DATA *d, int num, int base)
 {
-   unsigned int val = 0;
+   unsigned int val;
 
-   /* read num bits */
-   if (num)
+   while (d->bitcount < (unsigned int)num)
    {
-      unsigned int limit = 1 << (num);
-      unsigned int mask;
-
-      for (mask = 1; mask < limit; mask *= 2)
-         if (tinf_getbit(d)) val += mask;
+      tinf_refill(d);
    }
 
+   val = d->tag & ((1 << num) - 1);
+   d->tag >>= num;
+   d->bitcount -= num;
+
    return val + base;
 }
 
@@ -240,6 +287,27 @@ static int tinf_decode_symbol(TINF_DATA *d, TINF_TREE *t)
 {
    int sum = 0, cur = 0, len = 0;
 
+#if TINF_FAST_BITS
+   /* the bits above bitcount are zero, so a table entry whose code fits
+      in the bits we have is the right one even if bitcount is short */
+   for (;;)
+   {
+      unsigned int e = t->fast[d->tag & ((1 << TINF_FAST_BITS) - 1)];
+      unsigned int n = e >> 9;
+
+      if (n == 0) break;
+
+      if (n <= d->bitcount)
+      {
+         d->tag >>= n;
+         d->bitcount -= n;
+         return e & 0x1ff;
+      }
+
+      tinf_refill(d);
+   }
+#endif
+
    /* get more bits while code value is above sum */
    do {
 
@@ -332,58 +400,74 @@ static void tinf_decode_trees(TINF_DATA *d, TINF_TREE *lt, TINF_TREE *dt)
  * -- block inflate functions -- *
  * ----------------------------- */
 
-/* given a stream and two trees, inflate a block of data */
+/* given a stream and two trees, inflate a block of data until the
+   destination buffer is full or the block ends */
 static int tinf_inflate_block_data(TINF_DATA *d, TINF_TREE *lt, TINF_TREE *dt)
 {
-    if (d->curlen == 0) {
-        unsigned int offs;
-        int dist;
-        int sym = tinf_decode_symbol(d, lt);
-        //printf("huff sym: %02x\n", sym);
-
-        /* literal byte */
-        if (sym < 256) {
-            TINF_PUT(d, sym);
-            return TINF_OK;
-        }
+    while (d->destSize) {
+        if (d->curlen == 0) {
+            unsigned int offs;
+            int dist;
+            int sym = tinf_decode_symbol(d, lt);
+            //printf("huff sym: %02x\n", sym);
+
+            /* literal byte */
+            if (sym < 256) {
+                TINF_PUT(d, sym);
+                d->destSize--;
+                continue;
+            }
 
-        /* end of block */
-        if (sym == 256) {
-            return TINF_DONE;
-        }
+            /* end of block */
+            if (sym == 256) {
+                return TINF_DONE;
+            }
 
-        /* substring from sliding dictionary */
-        sym -= 257;
-        /* possibly get more bits from length code */
-        d->curlen = tinf_read_bits(d, length_bits[sym], length_base[sym]);
+            /* substring from sliding dictionary */
+            sym -= 257;
+            /* possibly get more bits from length code */
+            d->curlen = tinf_read_bits(d, length_bits[sym], length_base[sym]);
+
+            dist = tinf_decode_symbol(d, dt);
+            /* possibly get more bits from distance code */
+            offs = tinf_read_bits(d, dist_bits[dist], dist_base[dist]);
+            if (d->dict_ring) {
+                if (offs > d->dict_size) {
+                    return TINF_DICT_ERROR;
+                }
+                d->lzOff = d->dict_idx - offs;
+                if (d->lzOff < 0) {
+                    d->lzOff += d->dict_size;
+                }
+            } else {
+                d->lzOff = -offs;
+            }
+        }
 
-        dist = tinf_decode_symbol(d, dt);
-        /* possibly get more bits from distance code */
-        offs = tinf_read_bits(d, dist_bits[dist], dist_base[dist]);
+        /* copy as much of the dict substring as fits in the buffer */
+        unsigned int n = d->curlen;
+        if (n > d->destSize) {
+            n = d->destSize;
+        }
+        d->curlen -= n;
+        d->destSize -= n;
         if (d->dict_ring) {
-            if (offs > d->dict_size) {
-                return TINF_DICT_ERROR;
-            }
-            d->lzOff = d->dict_idx - offs;
-            if (d->lzOff < 0) {
-                d->lzOff += d->dict_size;
+            while (n--) {
+                TINF_PUT(d, d->dict_ring[d->lzOff]);
+                if ((unsigned)++d->lzOff == d->dict_size) {
+                    d->lzOff = 0;
+                }
             }
         } else {
-            d->lzOff = -offs;
-        }
-    }
-
-    /* copy next byte from dict substring */
-    if (d->dict_ring) {
-        TINF_PUT(d, d->dict_ring[d->lzOff]);
-        if ((unsigned)++d->lzOff == d->dict_size) {
-            d->lzOff = 0;
+            /* source and destination may overlap, so copy forwards bytewise */
+            unsigned char *dest = d->dest;
+            while (n--) {
+                *dest = dest[d->lzOff];
+                dest++;
+            }
+            d->dest = dest;
         }
-    } else {
-        d->dest[0] = d->dest[d->lzOff];
-        d->dest++;
     }
-    d->curlen--;
     return TINF_OK;
 }
 
@@ -405,15 +489,19 @@ static int tinf_inflate_uncompressed_block(TINF_DATA *d)
         d->curlen = length + 1;
 
         /* make sure we start next block on a byte boundary */
+        d->tag = 0;
         d->bitcount = 0;
     }
 
-    if (--d->curlen == 0) {
-        return TINF_DONE;
-    }
+    while (d->destSize) {
+        if (--d->curlen == 0) {
+            return TINF_DONE;
+        }
 
-    unsigned char c = uzlib_get_byte(d);
-    TINF_PUT(d, c);
+        unsigned char c = uzlib_get_byte(d);
+        TINF_PUT(d, c);
+        d->destSize--;
+    }
     return TINF_OK;
 }
 
@@ -438,6 +526,7 @@ void uzlib_init(void)
 /* initialize decompression structure */
 void uzlib_uncompress_init(TINF_DATA *d, void *dict, unsigned int dictLen)
 {
+   d->tag = 0;
    d->bitcount = 0;
    d->bfinal = 0;
    d->btype = -1;
@@ -447,10 +536,11 @@ void uzlib_uncompress_init(TINF_DATA *d, void *dict, unsigned int dictLen)
    d->curlen = 0;
 }
 
-/* inflate next byte of compressed stream */
+/* inflate compressed stream until destSize bytes have been produced or
+   the stream ends */
 int uzlib_uncompress(TINF_DATA *d)
 {
-    do {
+    while (d->destSize) {
         int res;
 
         /* start a new block */
@@ -490,16 +580,15 @@ next_blk:
         }
 
         if (res == TINF_DONE && !d->bfinal) {
-            /* the block has ended (without producing more data), but we
-               can't return without data, so start procesing next block */
+            /* the block has ended, but the buffer isn't full yet, so
+               start processing the next block */
             goto next_blk;
         }
 
         if (res != TINF_OK) {
             return res;
         }
-
-    } while (--d->destSize);
+    }
 
     return TINF_OK;
 }
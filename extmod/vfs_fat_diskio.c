@@ -129,11 +129,19 @@ DRESULT disk_read (
         if (f(buff, sector, count) != 0) {
             return RES_ERROR;
         }
+    } else if (vfs->flags & FSUSER_NATIVE_OBJ) {
+        mp_obj_t self = vfs->readblocks[1];
+        const mp_block_dev_p_t *bdev_p = mp_obj_get_type(self)->protocol;
+        if (bdev_p->readblocks(self, buff, sector, count) != 0) {
+            return RES_ERROR;
+        }
     } else {
         vfs->readblocks[2] = MP_OBJ_NEW_SMALL_INT(sector);
         vfs->readblocks[3] = mp_obj_new_bytearray_by_ref(count * SECSIZE(&vfs->fatfs), buff);
-        mp_call_method_n_kw(2, 0, vfs->readblocks);
-        // TODO handle error return
+        mp_obj_t ret = mp_call_method_n_kw(2, 0, vfs->readblocks);
+        if (ret != mp_const_none && MP_OBJ_SMALL_INT_VALUE(ret) != 0) {
+            return RES_ERROR;
+        }
     }
 
     return RES_OK;
@@ -161,16 +169,28 @@ DRESULT disk_write (
         return RES_WRPRT;
     }
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    fat_vfs_import_cache_clear();
+    #endif
+
     if (vfs->flags & FSUSER_NATIVE) {
         mp_uint_t (*f)(const uint8_t*, uint32_t, uint32_t) = (void*)(uintptr_t)vfs->writeblocks[2];
         if (f(buff, sector, count) != 0) {
             return RES_ERROR;
         }
+    } else if (vfs->flags & FSUSER_NATIVE_OBJ) {
+        mp_obj_t self = vfs->writeblocks[1];
+        const mp_block_dev_p_t *bdev_p = mp_obj_get_type(self)->protocol;
+        if (bdev_p->writeblocks(self, buff, sector, count) != 0) {
+            return RES_ERROR;
+        }
     } else {
         vfs->writeblocks[2] = MP_OBJ_NEW_SMALL_INT(sector);
         vfs->writeblocks[3] = mp_obj_new_bytearray_by_ref(count * SECSIZE(&vfs->fatfs), (void*)buff);
-        mp_call_method_n_kw(2, 0, vfs->writeblocks);
-        // TODO handle error return
+        mp_obj_t ret = mp_call_method_n_kw(2, 0, vfs->writeblocks);
+        if (ret != mp_const_none && MP_OBJ_SMALL_INT_VALUE(ret) != 0) {
+            return RES_ERROR;
+        }
     }
 
     return RES_OK;
@@ -224,9 +244,19 @@ DRESULT disk_ioctl (
                 return RES_OK;
             }
 
-            case GET_BLOCK_SIZE:
-                *((DWORD*)buff) = 1; // erase block size in units of sector size
+            case GET_BLOCK_SIZE: {
+                // erase block size in units of sector size; mkfs aligns
+                // the data area (and so the clusters) to it
+                vfs->u.ioctl[2] = MP_OBJ_NEW_SMALL_INT(BP_IOCTL_BLOCK_SIZE);
+                vfs->u.ioctl[3] = MP_OBJ_NEW_SMALL_INT(0); // unused
+                mp_obj_t ret = mp_call_method_n_kw(2, 0, vfs->u.ioctl);
+                mp_int_t n = 1;
+                if (ret != mp_const_none) {
+                    n = mp_obj_get_int(ret);
+                }
+                *((DWORD*)buff) = n > 0 ? n : 1;
                 return RES_OK;
+            }
 
             default:
                 return RES_PARERR;
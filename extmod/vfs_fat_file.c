@@ -73,6 +73,8 @@ const byte fresult_to_errno_table[20] = {
 
 typedef struct _pyb_file_obj_t {
     mp_obj_base_t base;
+    // Unless _FS_TINY is set, this includes the file's own sector buffer,
+    // allocated on the GC heap along with the object
     FIL fp;
 } pyb_file_obj_t;
 
@@ -176,6 +178,9 @@ STATIC const mp_arg_t file_open_args[] = {
     { MP_QSTR_file, MP_ARG_OBJ | MP_ARG_REQUIRED, {.u_rom_obj = MP_ROM_PTR(&mp_const_none_obj)} },
     { MP_QSTR_mode, MP_ARG_OBJ, {.u_obj = MP_OBJ_NEW_QSTR(MP_QSTR_r)} },
     { MP_QSTR_encoding, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_PTR(&mp_const_none_obj)} },
+    #if _USE_FASTSEEK
+    { MP_QSTR_fastseek, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+    #endif
 };
 #define FILE_OPEN_NUM_ARGS MP_ARRAY_SIZE(file_open_args)
 
@@ -226,6 +231,38 @@ STATIC mp_obj_t file_open(const mp_obj_type_t *type, mp_arg_val_t *args) {
         f_lseek(&o->fp, f_size(&o->fp));
     }
 
+    #if _USE_FASTSEEK
+    if (args[3].u_bool) {
+        // Build the cluster link map, so seeking no longer follows the FAT
+        // chain from the start of the file. The file can't grow while the
+        // map is in use, so it's only allowed for read-only files.
+        if (mode & FA_WRITE) {
+            f_close(&o->fp);
+            mp_raise_ValueError("fastseek needs read-only mode");
+        }
+        // Start with room for a few fragments; if that's not enough,
+        // FatFs reports the size needed in the first entry.
+        DWORD tbl_len = 2 + 2 * 4;
+        for (;;) {
+            DWORD *tbl = m_new(DWORD, tbl_len);
+            tbl[0] = tbl_len;
+            o->fp.cltbl = tbl;
+            res = f_lseek(&o->fp, CREATE_LINKMAP);
+            if (res != FR_NOT_ENOUGH_CORE) {
+                break;
+            }
+            DWORD needed = tbl[0];
+            m_del(DWORD, tbl, tbl_len);
+            tbl_len = needed;
+        }
+        if (res != FR_OK) {
+            o->fp.cltbl = NULL;
+            f_close(&o->fp);
+            mp_raise_OSError(fresult_to_errno_table[res]);
+        }
+    }
+    #endif
+
     return MP_OBJ_FROM_PTR(o);
 }
 
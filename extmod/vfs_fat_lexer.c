@@ -34,26 +34,22 @@
 
 typedef struct _mp_lexer_file_buf_t {
     FIL fp;
+    bool eof;
     byte buf[20];
-    uint16_t len;
-    uint16_t pos;
 } mp_lexer_file_buf_t;
 
-STATIC mp_uint_t file_buf_next_byte(mp_lexer_file_buf_t *fb) {
-    if (fb->pos >= fb->len) {
-        if (fb->len < sizeof(fb->buf)) {
-            return MP_LEXER_EOF;
-        } else {
-            UINT n;
-            f_read(&fb->fp, fb->buf, sizeof(fb->buf), &n);
-            if (n == 0) {
-                return MP_LEXER_EOF;
-            }
-            fb->len = n;
-            fb->pos = 0;
-        }
+STATIC mp_uint_t file_buf_read_block(mp_lexer_file_buf_t *fb, const byte **buf) {
+    if (fb->eof) {
+        return 0;
     }
-    return fb->buf[fb->pos++];
+    UINT n;
+    f_read(&fb->fp, fb->buf, sizeof(fb->buf), &n);
+    if (n < sizeof(fb->buf)) {
+        // a short read means the end of the file
+        fb->eof = true;
+    }
+    *buf = fb->buf;
+    return n;
 }
 
 STATIC void file_buf_close(mp_lexer_file_buf_t *fb) {
@@ -73,11 +69,8 @@ mp_lexer_t *fat_vfs_lexer_new_from_file(const char *filename) {
         m_del_obj(mp_lexer_file_buf_t, fb);
         return NULL;
     }
-    UINT n;
-    f_read(&fb->fp, fb->buf, sizeof(fb->buf), &n);
-    fb->len = n;
-    fb->pos = 0;
-    return mp_lexer_new(qstr_from_str(filename), fb, (mp_lexer_stream_next_byte_t)file_buf_next_byte, (mp_lexer_stream_close_t)file_buf_close);
+    fb->eof = false;
+    return mp_lexer_new_buffered(qstr_from_str(filename), fb, (mp_lexer_stream_read_block_t)file_buf_read_block, (mp_lexer_stream_close_t)file_buf_close);
 }
 
 #endif // MICROPY_VFS_FAT
@@ -37,68 +37,109 @@
 #include "extmod/vfs_fat_file.h"
 #include "extmod/fsusermount.h"
 #include "py/lexer.h"
+#include "py/objstr.h"
 
 #if _USE_LFN
 STATIC char lfn[_MAX_LFN + 1];   /* Buffer to store the LFN */
 #endif
 
-// TODO: actually, the core function should be ilistdir()
-mp_obj_t fat_vfs_listdir(const char *path, bool is_str_type) {
-    FRESULT res;
-    FILINFO fno;
-    DIR dir;
-#if _USE_LFN
-    fno.lfname = lfn;
-    fno.lfsize = sizeof lfn;
-#endif
-
-    res = f_opendir(&dir, path);                       /* Open the directory */
+STATIC void fat_vfs_opendir(DIR *dir, const char *path) {
+    FRESULT res = f_opendir(dir, path);
     if (res != FR_OK) {
         mp_raise_OSError(fresult_to_errno_table[res]);
     }
+}
 
-    mp_obj_t dir_list = mp_obj_new_list(0, NULL);
-
+// Reads the next entry, skipping . and .., and returns its name.  At the end
+// of the directory (or on an error) it closes it and returns NULL.
+STATIC const char *fat_vfs_readdir(DIR *dir, FILINFO *fno) {
+#if _USE_LFN
+    fno->lfname = lfn;
+    fno->lfsize = sizeof lfn;
+#endif
     for (;;) {
-        res = f_readdir(&dir, &fno);                   /* Read a directory item */
-        if (res != FR_OK || fno.fname[0] == 0) break;  /* Break on error or end of dir */
-        if (fno.fname[0] == '.' && fno.fname[1] == 0) continue;             /* Ignore . entry */
-        if (fno.fname[0] == '.' && fno.fname[1] == '.' && fno.fname[2] == 0) continue;             /* Ignore .. entry */
-
+        FRESULT res = f_readdir(dir, fno);
+        if (res != FR_OK || fno->fname[0] == 0) {
+            f_closedir(dir);
+            return NULL;
+        }
+        if (fno->fname[0] == '.' && fno->fname[1] == 0) continue;             /* Ignore . entry */
+        if (fno->fname[0] == '.' && fno->fname[1] == '.' && fno->fname[2] == 0) continue;             /* Ignore .. entry */
 #if _USE_LFN
-        char *fn = *fno.lfname ? fno.lfname : fno.fname;
+        return *fno->lfname ? fno->lfname : fno->fname;
 #else
-        char *fn = fno.fname;
+        return fno->fname;
 #endif
+    }
+}
 
-        /*
-        if (fno.fattrib & AM_DIR) {
-            // dir
-        } else {
-            // file
-        }
-        */
+STATIC mp_obj_t fat_vfs_new_name(const char *fn, bool is_str_type) {
+    if (is_str_type) {
+        return mp_obj_new_str(fn, strlen(fn), false);
+    } else {
+        return mp_obj_new_bytes((const byte*)fn, strlen(fn));
+    }
+}
 
-        // make a string object for this entry
-        mp_obj_t entry_o;
-        if (is_str_type) {
-            entry_o = mp_obj_new_str(fn, strlen(fn), false);
-        } else {
-            entry_o = mp_obj_new_bytes((const byte*)fn, strlen(fn));
-        }
+mp_obj_t fat_vfs_listdir(const char *path, bool is_str_type) {
+    DIR dir;
+    FILINFO fno;
+    fat_vfs_opendir(&dir, path);
 
-        // add the entry to the list
-        mp_obj_list_append(dir_list, entry_o);
+    mp_obj_t dir_list = mp_obj_new_list(0, NULL);
+    const char *fn;
+    while ((fn = fat_vfs_readdir(&dir, &fno)) != NULL) {
+        mp_obj_list_append(dir_list, fat_vfs_new_name(fn, is_str_type));
     }
 
-    f_closedir(&dir);
-
     return dir_list;
 }
 
+typedef struct _fat_vfs_ilistdir_it_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    bool is_str_type;
+    bool is_open;
+    DIR dir;
+} fat_vfs_ilistdir_it_t;
+
+STATIC mp_obj_t fat_vfs_ilistdir_it_iternext(mp_obj_t self_in) {
+    fat_vfs_ilistdir_it_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->is_open) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+
+    FILINFO fno;
+    const char *fn = fat_vfs_readdir(&self->dir, &fno);
+    if (fn == NULL) {
+        self->is_open = false;
+        return MP_OBJ_STOP_ITERATION;
+    }
+
+    // the type is the S_IFMT part of st_mode, as given by stat()
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(3, NULL));
+    t->items[0] = fat_vfs_new_name(fn, self->is_str_type);
+    t->items[1] = MP_OBJ_NEW_SMALL_INT((fno.fattrib & AM_DIR) ? 0x4000 : 0x8000);
+    t->items[2] = mp_obj_new_int_from_uint(fno.fsize);
+    return MP_OBJ_FROM_PTR(t);
+}
+
+// Returns an iterator of (name, type, size) tuples, which reads the entries
+// from the device as it goes rather than building a list of them first.
+mp_obj_t fat_vfs_ilistdir(const char *path, bool is_str_type) {
+    fat_vfs_ilistdir_it_t *it = m_new_obj(fat_vfs_ilistdir_it_t);
+    it->base.type = &mp_type_polymorph_iter;
+    it->iternext = fat_vfs_ilistdir_it_iternext;
+    it->is_str_type = is_str_type;
+    it->is_open = false;
+    fat_vfs_opendir(&it->dir, path);
+    it->is_open = true;
+    return MP_OBJ_FROM_PTR(it);
+}
+
 mp_import_stat_t fat_vfs_import_stat(const char *path);
 
-mp_import_stat_t fat_vfs_import_stat(const char *path) {
+STATIC mp_import_stat_t fat_vfs_stat(const char *path) {
     FILINFO fno;
 #if _USE_LFN
     fno.lfname = NULL;
@@ -115,4 +156,159 @@ mp_import_stat_t fat_vfs_import_stat(const char *path) {
     return MP_IMPORT_STAT_NO_EXIST;
 }
 
+#if MICROPY_VFS_FAT_IMPORT_CACHE
+
+// An import probes each entry of sys.path for a package, a .py and a .mpy,
+// and on FAT each probe scans the directory on the device. Instead the first
+// probe of a directory reads the whole of it into a dict, which maps the
+// lowercased names of its entries (both the long and the 8.3 name) to True
+// for a directory and False for a file. The cache maps each directory's path
+// to such a dict, or to None if the directory has too many entries to be
+// worth keeping. It is dropped on any write to a FAT device, which takes in
+// mount and mkfs, and on umount and chdir, since relative paths then mean
+// something else.
+#define import_cache MP_STATE_VM(fat_import_cache)
+
+// At most this many directories are kept; when full the cache starts over.
+#define IMPORT_CACHE_MAX_DIRS (8)
+// Directories with more names than this are looked up on the device.
+#define IMPORT_CACHE_MAX_NAMES (64)
+// Longer names, as for names not all ASCII, are looked up on the device.
+#define IMPORT_CACHE_NAME_MAX (32)
+
+STATIC void import_cache_add(mp_obj_t names, char *name, bool is_dir) {
+    for (char *c = name; *c != '\0'; c++) {
+        if ('A' <= *c && *c <= 'Z') {
+            *c += 'a' - 'A';
+        }
+    }
+    mp_obj_dict_store(names, mp_obj_new_str(name, strlen(name), false), mp_obj_new_bool(is_dir));
+}
+
+// The names in the directory at path, or MP_OBJ_NULL if it couldn't be read.
+// A path that isn't a directory has no names.
+STATIC mp_obj_t import_cache_list(const char *path) {
+    FILINFO fno;
+    DIR dir;
+#if _USE_LFN
+    fno.lfname = lfn;
+    fno.lfsize = sizeof lfn;
+#endif
+
+    FRESULT res = f_opendir(&dir, path);
+    if (res == FR_NO_PATH || res == FR_NO_FILE) {
+        return mp_obj_new_dict(0);
+    } else if (res != FR_OK) {
+        return MP_OBJ_NULL;
+    }
+
+    mp_obj_t names = mp_obj_new_dict(0);
+    for (;;) {
+        res = f_readdir(&dir, &fno);
+        if (res != FR_OK) {
+            names = MP_OBJ_NULL;
+            break;
+        }
+        if (fno.fname[0] == 0) {
+            break;
+        }
+        if (fno.fname[0] == '.') {
+            continue;
+        }
+        bool is_dir = (fno.fattrib & AM_DIR) != 0;
+        import_cache_add(names, fno.fname, is_dir);
+#if _USE_LFN
+        if (*fno.lfname) {
+            import_cache_add(names, fno.lfname, is_dir);
+        }
+#endif
+        if (mp_obj_dict_get_map(names)->used > IMPORT_CACHE_MAX_NAMES) {
+            names = mp_const_none;
+            break;
+        }
+    }
+    f_closedir(&dir);
+
+    return names;
+}
+
+// The cached names of the directory given by the first len chars of path.
+STATIC mp_obj_t import_cache_dir(const char *path, size_t len) {
+    if (import_cache != MP_OBJ_NULL) {
+        mp_obj_str_t key = {{&mp_type_str}, qstr_compute_hash((const byte*)path, len), len, (const byte*)path};
+        mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(import_cache), MP_OBJ_FROM_PTR(&key), MP_MAP_LOOKUP);
+        if (elem != NULL) {
+            return elem->value;
+        }
+    }
+
+    mp_obj_t dir = mp_obj_new_str(path, len, false);
+    mp_obj_t names = import_cache_list(mp_obj_str_get_str(dir));
+    if (names == MP_OBJ_NULL) {
+        return mp_const_none;
+    }
+
+    // Reading the directory can flush a dirty sector, which drops the cache.
+    if (import_cache == MP_OBJ_NULL || mp_obj_dict_get_map(import_cache)->used >= IMPORT_CACHE_MAX_DIRS) {
+        import_cache = mp_obj_new_dict(0);
+    }
+    mp_obj_dict_store(import_cache, dir, names);
+    return names;
+}
+
+mp_import_stat_t fat_vfs_import_stat(const char *path) {
+    const char *leaf = strrchr(path, '/');
+    size_t dir_len;
+    if (leaf == NULL) {
+        leaf = path;
+        dir_len = 0;
+    } else {
+        dir_len = leaf == path ? 1 : leaf - path;
+        leaf += 1;
+    }
+
+    // FAT matches names without regard to case, so look up a lowercase copy.
+    char name[IMPORT_CACHE_NAME_MAX];
+    size_t len = strlen(leaf);
+    if (len == 0 || len >= sizeof(name) || leaf[0] == '.') {
+        return fat_vfs_stat(path);
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = leaf[i];
+        if (c & 0x80) {
+            return fat_vfs_stat(path);
+        }
+        if ('A' <= c && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        name[i] = c;
+    }
+
+    mp_obj_t names = import_cache_dir(path, dir_len);
+    if (names == mp_const_none) {
+        return fat_vfs_stat(path);
+    }
+    mp_obj_str_t key = {{&mp_type_str}, qstr_compute_hash((const byte*)name, len), len, (const byte*)name};
+    mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(names), MP_OBJ_FROM_PTR(&key), MP_MAP_LOOKUP);
+    if (elem == NULL) {
+        return MP_IMPORT_STAT_NO_EXIST;
+    } else if (elem->value == mp_const_true) {
+        return MP_IMPORT_STAT_DIR;
+    } else {
+        return MP_IMPORT_STAT_FILE;
+    }
+}
+
+void fat_vfs_import_cache_clear(void) {
+    import_cache = MP_OBJ_NULL;
+}
+
+#else
+
+mp_import_stat_t fat_vfs_import_stat(const char *path) {
+    return fat_vfs_stat(path);
+}
+
+#endif // MICROPY_VFS_FAT_IMPORT_CACHE
+
 #endif // MICROPY_VFS_FAT
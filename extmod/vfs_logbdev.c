@@ -0,0 +1,471 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/mpconfig.h"
+#if MICROPY_VFS_LOGBDEV
+
+#include <string.h>
+#include "py/runtime.h"
+#include "py/mperrno.h"
+#include "py/objarray.h"
+#include "py/binary.h"
+#include "extmod/fsusermount.h"
+
+// A log-structured block device on top of raw flash, for use under the FAT
+// driver. Rather than erasing and rewriting a whole erase block for each
+// sector written, sectors are appended to the currently open erase block and
+// a table in RAM maps each logical sector to its latest copy. Erase blocks
+// are only erased when they are reclaimed by the garbage collector, and the
+// least worn free block is always the next one to be used.
+//
+// Each erase block is laid out as:
+//   header   - magic, sequence number, erase count, check word
+//   tags     - one per page: logical sector number and its complement
+//   pages    - LOG_SECTOR_SIZE bytes of data each
+// The header and tags are padded to a multiple of LOG_SECTOR_SIZE. A page's
+// data is programmed before its tag, so a sector write interrupted by power
+// loss leaves either the old or the new copy, never a mix of the two.
+//
+// The raw flash device must provide:
+//   readblocks(block, buf, offset)  - read len(buf) bytes at offset in block
+//   writeblocks(block, buf, offset) - program without erasing
+//   ioctl(BP_IOCTL_SEC_COUNT, 0)    - number of erase blocks
+//   ioctl(BP_IOCTL_SEC_SIZE, 0)     - size of an erase block in bytes
+//   ioctl(BP_IOCTL_BLOCK_ERASE, n)  - erase block n
+
+#define LOG_SECTOR_SIZE (512)
+#define LOG_MAGIC (0x42474f4c) // "LOGB"
+#define LOG_NONE (0xffff)
+#define LOG_TAG_SIZE (8)
+#define LOG_HDR_SIZE (16)
+// erase count difference above which static data is moved to a worn block
+#define LOG_WEAR_DELTA (8)
+
+typedef struct _log_block_t {
+    uint32_t seq; // 0 if the block is free
+    uint32_t erase_count;
+    uint16_t valid; // number of pages holding the latest copy of a sector
+} log_block_t;
+
+typedef struct _mp_obj_log_bdev_t {
+    mp_obj_base_t base;
+    mp_obj_t readblocks[5];
+    mp_obj_t writeblocks[5];
+    mp_obj_t ioctl[4];
+    // buffer object passed to the raw device, pointed at the data each time
+    mp_obj_array_t raw_buf;
+    uint32_t num_sectors;
+    uint32_t max_seq;
+    uint16_t num_blocks;
+    uint16_t pages_per_block;
+    uint16_t data_offset;
+    uint16_t free_blocks;
+    uint16_t cur_block;
+    uint16_t cur_page;
+    bool in_gc;
+    bool wear_moved;
+    uint32_t *page_buf; // one sector, for the collector and mounting
+    log_block_t *blocks;
+    uint16_t *map; // logical sector -> physical page
+} mp_obj_log_bdev_t;
+
+STATIC void log_raw_check(mp_obj_t ret) {
+    if (ret != mp_const_none && mp_obj_get_int(ret) != 0) {
+        mp_raise_OSError(MP_EIO);
+    }
+}
+
+STATIC void log_raw_read(mp_obj_log_bdev_t *self, uint32_t block, uint32_t offset, void *buf, size_t len) {
+    self->raw_buf.len = len;
+    self->raw_buf.items = buf;
+    self->readblocks[2] = MP_OBJ_NEW_SMALL_INT(block);
+    self->readblocks[3] = MP_OBJ_FROM_PTR(&self->raw_buf);
+    self->readblocks[4] = MP_OBJ_NEW_SMALL_INT(offset);
+    log_raw_check(mp_call_method_n_kw(3, 0, self->readblocks));
+}
+
+STATIC void log_raw_prog(mp_obj_log_bdev_t *self, uint32_t block, uint32_t offset, const void *buf, size_t len) {
+    self->raw_buf.len = len;
+    self->raw_buf.items = (void*)buf;
+    self->writeblocks[2] = MP_OBJ_NEW_SMALL_INT(block);
+    self->writeblocks[3] = MP_OBJ_FROM_PTR(&self->raw_buf);
+    self->writeblocks[4] = MP_OBJ_NEW_SMALL_INT(offset);
+    log_raw_check(mp_call_method_n_kw(3, 0, self->writeblocks));
+}
+
+STATIC mp_int_t log_raw_ioctl(mp_obj_log_bdev_t *self, mp_int_t op, mp_int_t arg) {
+    self->ioctl[2] = MP_OBJ_NEW_SMALL_INT(op);
+    self->ioctl[3] = MP_OBJ_NEW_SMALL_INT(arg);
+    mp_obj_t ret = mp_call_method_n_kw(2, 0, self->ioctl);
+    if (ret == mp_const_none) {
+        return 0;
+    }
+    return mp_obj_get_int(ret);
+}
+
+STATIC uint32_t log_hdr_check(const uint32_t *hdr) {
+    return ~(hdr[0] ^ hdr[1] ^ hdr[2]);
+}
+
+// Returns true if the page at phys_a holds a newer copy than phys_b.
+STATIC bool log_page_newer(mp_obj_log_bdev_t *self, uint16_t phys_a, uint16_t phys_b) {
+    uint32_t seq_a = self->blocks[phys_a / self->pages_per_block].seq;
+    uint32_t seq_b = self->blocks[phys_b / self->pages_per_block].seq;
+    if (seq_a != seq_b) {
+        return seq_a > seq_b;
+    }
+    return phys_a > phys_b;
+}
+
+STATIC void log_mount(mp_obj_log_bdev_t *self) {
+    size_t P = self->pages_per_block;
+    uint32_t *tags = m_new(uint32_t, 2 * P);
+    uint32_t hdr[4];
+
+    for (uint32_t i = 0; i < self->num_sectors; i++) {
+        self->map[i] = LOG_NONE;
+    }
+
+    // read all block headers and tags, keeping the newest copy of each sector
+    uint16_t newest = LOG_NONE;
+    for (uint16_t b = 0; b < self->num_blocks; b++) {
+        log_block_t *blk = &self->blocks[b];
+        log_raw_read(self, b, 0, hdr, sizeof(hdr));
+        if (hdr[0] != LOG_MAGIC || hdr[3] != log_hdr_check(hdr) || hdr[1] == 0) {
+            blk->seq = 0;
+            blk->erase_count = 0;
+            continue;
+        }
+        blk->seq = hdr[1];
+        blk->erase_count = hdr[2];
+        if (blk->seq > self->max_seq) {
+            self->max_seq = blk->seq;
+            newest = b;
+        }
+        log_raw_read(self, b, LOG_HDR_SIZE, tags, P * LOG_TAG_SIZE);
+        for (size_t i = 0; i < P; i++) {
+            uint32_t lsn = tags[2 * i];
+            if (lsn >= self->num_sectors || tags[2 * i + 1] != ~lsn) {
+                // blank, torn or corrupt tag
+                continue;
+            }
+            uint16_t phys = b * P + i;
+            uint16_t old = self->map[lsn];
+            if (old == LOG_NONE || log_page_newer(self, phys, old)) {
+                self->map[lsn] = phys;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < self->num_sectors; i++) {
+        if (self->map[i] != LOG_NONE) {
+            self->blocks[self->map[i] / P].valid += 1;
+        }
+    }
+
+    // blocks without any live data are free, they are erased when reused
+    self->free_blocks = 0;
+    for (uint16_t b = 0; b < self->num_blocks; b++) {
+        if (self->blocks[b].valid == 0 && b != newest) {
+            self->blocks[b].seq = 0;
+        }
+        if (self->blocks[b].seq == 0) {
+            self->free_blocks += 1;
+        }
+    }
+
+    // carry on appending to the newest block, after its last tagged page
+    self->cur_block = LOG_NONE;
+    if (newest != LOG_NONE) {
+        log_raw_read(self, newest, LOG_HDR_SIZE, tags, P * LOG_TAG_SIZE);
+        size_t next = P;
+        while (next > 0 && tags[2 * (next - 1)] == 0xffffffff && tags[2 * (next - 1) + 1] == 0xffffffff) {
+            next -= 1;
+        }
+        if (next < P) {
+            // the data of an untagged page may have been partly programmed
+            // before power was lost, in which case that page is skipped
+            uint32_t *page = self->page_buf;
+            log_raw_read(self, newest, self->data_offset + next * LOG_SECTOR_SIZE, page, LOG_SECTOR_SIZE);
+            for (size_t i = 0; i < LOG_SECTOR_SIZE / 4; i++) {
+                if (page[i] != 0xffffffff) {
+                    next += 1;
+                    break;
+                }
+            }
+        }
+        if (next < P) {
+            self->cur_block = newest;
+            self->cur_page = next;
+        }
+    }
+
+    m_del(uint32_t, tags, 2 * P);
+}
+
+STATIC void log_open_block(mp_obj_log_bdev_t *self) {
+    // use the least worn free block
+    uint16_t best = LOG_NONE;
+    for (uint16_t b = 0; b < self->num_blocks; b++) {
+        if (self->blocks[b].seq == 0
+            && (best == LOG_NONE || self->blocks[b].erase_count < self->blocks[best].erase_count)) {
+            best = b;
+        }
+    }
+    if (best == LOG_NONE) {
+        mp_raise_OSError(MP_ENOSPC);
+    }
+
+    log_block_t *blk = &self->blocks[best];
+    log_raw_ioctl(self, BP_IOCTL_BLOCK_ERASE, best);
+    uint32_t hdr[4] = {LOG_MAGIC, self->max_seq + 1, blk->erase_count + 1, 0};
+    hdr[3] = log_hdr_check(hdr);
+    log_raw_prog(self, best, 0, hdr, sizeof(hdr));
+
+    self->max_seq += 1;
+    blk->seq = self->max_seq;
+    blk->erase_count += 1;
+    blk->valid = 0;
+    self->free_blocks -= 1;
+    self->cur_block = best;
+    self->cur_page = 0;
+}
+
+STATIC void log_write_page(mp_obj_log_bdev_t *self, uint32_t lsn, const uint8_t *data);
+
+// Reclaim the used block with the fewest live pages by moving those pages to
+// the head of the log. Blocks holding static data would never be reclaimed
+// that way, so when one falls too far behind the most worn block it is
+// reclaimed instead, putting it back into use for the frequently written
+// data. That is done at most every other time so that space is still freed.
+STATIC void log_gc(mp_obj_log_bdev_t *self) {
+    size_t P = self->pages_per_block;
+    uint16_t victim = LOG_NONE;
+    uint16_t coldest = LOG_NONE;
+    uint32_t max_erase_count = 0;
+    for (uint16_t b = 0; b < self->num_blocks; b++) {
+        log_block_t *blk = &self->blocks[b];
+        if (blk->erase_count > max_erase_count) {
+            max_erase_count = blk->erase_count;
+        }
+        if (blk->seq == 0 || (b == self->cur_block && self->cur_page < P)) {
+            continue;
+        }
+        if (victim == LOG_NONE || blk->valid < self->blocks[victim].valid
+            || (blk->valid == self->blocks[victim].valid
+                && blk->erase_count < self->blocks[victim].erase_count)) {
+            victim = b;
+        }
+        if (coldest == LOG_NONE || blk->erase_count < self->blocks[coldest].erase_count) {
+            coldest = b;
+        }
+    }
+    if (victim == LOG_NONE) {
+        mp_raise_OSError(MP_ENOSPC);
+    }
+    self->wear_moved = !self->wear_moved
+        && max_erase_count - self->blocks[coldest].erase_count > LOG_WEAR_DELTA;
+    if (self->wear_moved) {
+        victim = coldest;
+    }
+    if (victim == self->cur_block) {
+        self->cur_block = LOG_NONE;
+    }
+
+    self->in_gc = true;
+    if (self->blocks[victim].valid > 0) {
+        uint8_t *buf = (uint8_t*)self->page_buf;
+        uint16_t first = victim * P;
+        for (uint32_t lsn = 0; lsn < self->num_sectors; lsn++) {
+            uint16_t phys = self->map[lsn];
+            if (phys >= first && phys < first + P) {
+                log_raw_read(self, victim, self->data_offset + (phys - first) * LOG_SECTOR_SIZE, buf, LOG_SECTOR_SIZE);
+                log_write_page(self, lsn, buf);
+            }
+        }
+    }
+    self->in_gc = false;
+
+    // the old copies stay in flash until the block is reused, which is fine
+    // because every sector in it now has a newer copy elsewhere
+    self->blocks[victim].seq = 0;
+    self->free_blocks += 1;
+}
+
+STATIC uint16_t log_alloc_page(mp_obj_log_bdev_t *self) {
+    // one free block is kept in reserve for the garbage collector
+    while (self->cur_block == LOG_NONE || self->cur_page == self->pages_per_block) {
+        if (self->free_blocks > 1 || (self->in_gc && self->free_blocks > 0)) {
+            log_open_block(self);
+        } else if (!self->in_gc) {
+            log_gc(self);
+        } else {
+            mp_raise_OSError(MP_ENOSPC);
+        }
+    }
+    return self->cur_block * self->pages_per_block + self->cur_page++;
+}
+
+STATIC void log_write_page(mp_obj_log_bdev_t *self, uint32_t lsn, const uint8_t *data) {
+    size_t P = self->pages_per_block;
+    uint16_t phys = log_alloc_page(self);
+    uint16_t b = phys / P;
+    uint16_t i = phys % P;
+    // program the data first, then the tag which makes it live
+    log_raw_prog(self, b, self->data_offset + i * LOG_SECTOR_SIZE, data, LOG_SECTOR_SIZE);
+    uint32_t tag[2] = {lsn, ~lsn};
+    log_raw_prog(self, b, LOG_HDR_SIZE + i * LOG_TAG_SIZE, tag, sizeof(tag));
+    uint16_t old = self->map[lsn];
+    if (old != LOG_NONE) {
+        self->blocks[old / P].valid -= 1;
+    }
+    self->map[lsn] = phys;
+    self->blocks[b].valid += 1;
+}
+
+STATIC mp_uint_t log_bdev_read(mp_obj_t self_in, uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    mp_obj_log_bdev_t *self = MP_OBJ_TO_PTR(self_in);
+    if (block_num + num_blocks > self->num_sectors) {
+        return MP_EINVAL;
+    }
+    size_t P = self->pages_per_block;
+    for (; num_blocks > 0; num_blocks--, block_num++, buf += LOG_SECTOR_SIZE) {
+        uint16_t phys = self->map[block_num];
+        if (phys == LOG_NONE) {
+            // never written
+            memset(buf, 0, LOG_SECTOR_SIZE);
+        } else {
+            log_raw_read(self, phys / P, self->data_offset + (phys % P) * LOG_SECTOR_SIZE, buf, LOG_SECTOR_SIZE);
+        }
+    }
+    return 0;
+}
+
+STATIC mp_uint_t log_bdev_write(mp_obj_t self_in, const uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    mp_obj_log_bdev_t *self = MP_OBJ_TO_PTR(self_in);
+    if (block_num + num_blocks > self->num_sectors) {
+        return MP_EINVAL;
+    }
+    // a previous write may have been aborted part way through a collection
+    self->in_gc = false;
+    for (; num_blocks > 0; num_blocks--, block_num++, buf += LOG_SECTOR_SIZE) {
+        log_write_page(self, block_num, buf);
+    }
+    return 0;
+}
+
+STATIC mp_obj_t log_bdev_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+    mp_obj_log_bdev_t *self = m_new0(mp_obj_log_bdev_t, 1);
+    self->base.type = type;
+    mp_load_method(args[0], MP_QSTR_readblocks, self->readblocks);
+    mp_load_method(args[0], MP_QSTR_writeblocks, self->writeblocks);
+    mp_load_method(args[0], MP_QSTR_ioctl, self->ioctl);
+    self->raw_buf.base.type = &mp_type_bytearray;
+    self->raw_buf.typecode = BYTEARRAY_TYPECODE;
+
+    mp_int_t num_blocks = log_raw_ioctl(self, BP_IOCTL_SEC_COUNT, 0);
+    mp_int_t block_size = log_raw_ioctl(self, BP_IOCTL_SEC_SIZE, 0);
+
+    // find the number of pages that fit in a block along with their tags
+    mp_int_t P = block_size / LOG_SECTOR_SIZE - 1;
+    mp_int_t meta;
+    for (;;) {
+        meta = (LOG_HDR_SIZE + P * LOG_TAG_SIZE + LOG_SECTOR_SIZE - 1) / LOG_SECTOR_SIZE * LOG_SECTOR_SIZE;
+        if (P <= 0 || meta + P * LOG_SECTOR_SIZE <= block_size) {
+            break;
+        }
+        P -= 1;
+    }
+    // need at least one block for data and one spare for the collector
+    if (P <= 0 || num_blocks < 3 || num_blocks * P >= LOG_NONE) {
+        mp_raise_ValueError("unsupported flash geometry");
+    }
+
+    self->num_blocks = num_blocks;
+    self->pages_per_block = P;
+    self->data_offset = meta;
+    self->num_sectors = (num_blocks - 2) * P;
+    self->blocks = m_new0(log_block_t, num_blocks);
+    self->map = m_new(uint16_t, self->num_sectors);
+    self->page_buf = m_new(uint32_t, LOG_SECTOR_SIZE / 4);
+
+    log_mount(self);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t log_bdev_readblocks(mp_obj_t self, mp_obj_t block_num, mp_obj_t buf) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf, &bufinfo, MP_BUFFER_WRITE);
+    mp_uint_t ret = log_bdev_read(self, bufinfo.buf, mp_obj_get_int(block_num), bufinfo.len / LOG_SECTOR_SIZE);
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(log_bdev_readblocks_obj, log_bdev_readblocks);
+
+STATIC mp_obj_t log_bdev_writeblocks(mp_obj_t self, mp_obj_t block_num, mp_obj_t buf) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf, &bufinfo, MP_BUFFER_READ);
+    mp_uint_t ret = log_bdev_write(self, bufinfo.buf, mp_obj_get_int(block_num), bufinfo.len / LOG_SECTOR_SIZE);
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(log_bdev_writeblocks_obj, log_bdev_writeblocks);
+
+STATIC mp_obj_t log_bdev_ioctl(mp_obj_t self_in, mp_obj_t cmd_in, mp_obj_t arg_in) {
+    (void)arg_in;
+    mp_obj_log_bdev_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (mp_obj_get_int(cmd_in)) {
+        case BP_IOCTL_SYNC: return MP_OBJ_NEW_SMALL_INT(0); // writes go straight to flash
+        case BP_IOCTL_SEC_COUNT: return MP_OBJ_NEW_SMALL_INT(self->num_sectors);
+        case BP_IOCTL_SEC_SIZE: return MP_OBJ_NEW_SMALL_INT(LOG_SECTOR_SIZE);
+        case BP_IOCTL_BLOCK_SIZE: return MP_OBJ_NEW_SMALL_INT(1);
+        default: return mp_const_none;
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(log_bdev_ioctl_obj, log_bdev_ioctl);
+
+STATIC const mp_rom_map_elem_t log_bdev_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_readblocks), MP_ROM_PTR(&log_bdev_readblocks_obj) },
+    { MP_ROM_QSTR(MP_QSTR_writeblocks), MP_ROM_PTR(&log_bdev_writeblocks_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ioctl), MP_ROM_PTR(&log_bdev_ioctl_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(log_bdev_locals_dict, log_bdev_locals_dict_table);
+
+STATIC const mp_block_dev_p_t log_bdev_block_dev_p = {
+    .readblocks = log_bdev_read,
+    .writeblocks = log_bdev_write,
+};
+
+const mp_obj_type_t mp_log_bdev_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_LogBdev,
+    .make_new = log_bdev_make_new,
+    .protocol = &log_bdev_block_dev_p,
+    .locals_dict = (mp_obj_dict_t*)&log_bdev_locals_dict,
+};
+
+#endif // MICROPY_VFS_LOGBDEV
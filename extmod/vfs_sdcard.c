@@ -0,0 +1,581 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/mpconfig.h"
+#if MICROPY_VFS_SDCARD
+
+#include <string.h>
+#include "py/runtime.h"
+#include "py/mperrno.h"
+#include "py/mphal.h"
+#include "py/objarray.h"
+#include "py/binary.h"
+#include "extmod/fsusermount.h"
+#include "extmod/machine_spi.h"
+#if MICROPY_VFS_SDCARD_NATIVEIO
+#include "shared-bindings/nativeio/DigitalInOut.h"
+#include "shared-bindings/nativeio/SPI.h"
+#endif
+
+// An SD card on an SPI bus, as a block device for the FAT driver. This does
+// the same as drivers/sdcard/sdcard.py but the command and token handling is
+// all in C, so a sector costs a few calls into the SPI driver rather than
+// dozens of interpreted ones, and reads and writes of several sectors use the
+// card's multi-block commands (CMD18 and CMD25).
+//
+// The bus can be:
+//   machine.SPI     - bytes go straight to the port's transfer function
+//   nativeio.SPI    - likewise, and sector writes are sent by DMA
+//   anything else   - with write(buf) and write_readinto(out, in) methods,
+//                     which are called for each transfer
+// and the chip select pin either a nativeio.DigitalInOut or anything with
+// a value(v) method.
+
+#define SD_SECTOR_SIZE (512)
+#define SD_INIT_BAUDRATE (100000)
+#define SD_CMD_TIMEOUT (100) // bytes to wait for a command response
+#define SD_INIT_TIMEOUT_MS (1000)
+#define SD_READ_TIMEOUT_MS (300)
+#define SD_WRITE_TIMEOUT_MS (600)
+// nativeio.SPI writes at least this long are sent by DMA
+#define SD_DMA_MIN_LEN (32)
+
+#define R1_IDLE_STATE (1 << 0)
+#define R1_ILLEGAL_COMMAND (1 << 2)
+#define TOKEN_CMD25 (0xfc)
+#define TOKEN_STOP_TRAN (0xfd)
+#define TOKEN_DATA (0xfe)
+
+enum {
+    SD_SPI_GENERIC,
+    SD_SPI_MACHINE,
+    SD_SPI_NATIVEIO,
+};
+
+typedef struct _mp_obj_sdcard_t {
+    mp_obj_base_t base;
+    mp_obj_t spi;
+    mp_obj_t cs;
+    // methods of a generic bus and chip select, loaded once
+    mp_obj_t write[3];
+    mp_obj_t write_readinto[4];
+    mp_obj_t cs_value[3];
+    // buffer objects passed to a generic bus, pointed at the data each time
+    mp_obj_array_t out_buf;
+    mp_obj_array_t in_buf;
+    uint32_t baudrate;
+    uint32_t sectors;
+    uint8_t spi_kind;
+    uint8_t addr_shift; // 9 for cards addressed in bytes, 0 for SDHC
+    bool took_lock;
+} mp_obj_sdcard_t;
+
+/******************************************************************************/
+// bus access
+
+// Sends len bytes from src, or 0xff bytes if src is NULL, and stores the bytes
+// received in dest if it isn't NULL. src and dest may be the same buffer.
+STATIC void sd_xfer(mp_obj_sdcard_t *self, const uint8_t *src, uint8_t *dest, size_t len) {
+    if (src == NULL) {
+        memset(dest, 0xff, len);
+        src = dest;
+    }
+    switch (self->spi_kind) {
+        #if MICROPY_PY_MACHINE_SPI
+        case SD_SPI_MACHINE: {
+            mp_obj_base_t *s = (mp_obj_base_t*)MP_OBJ_TO_PTR(self->spi);
+            ((const mp_machine_spi_p_t*)s->type->protocol)->transfer(s, len, src, dest);
+            break;
+        }
+        #endif
+        #if MICROPY_VFS_SDCARD_NATIVEIO
+        case SD_SPI_NATIVEIO: {
+            nativeio_spi_obj_t *s = MP_OBJ_TO_PTR(self->spi);
+            if (dest != NULL) {
+                common_hal_nativeio_spi_transfer(s, src, dest, len);
+            } else if (len >= SD_DMA_MIN_LEN) {
+                // keeps USB serviced while the sector goes out
+                common_hal_nativeio_spi_start_write(s, MP_OBJ_NULL, src, len);
+                common_hal_nativeio_spi_wait_for_write(s);
+            } else {
+                common_hal_nativeio_spi_write(s, src, len);
+            }
+            break;
+        }
+        #endif
+        default:
+            self->out_buf.len = len;
+            self->out_buf.items = (void*)src;
+            if (dest == NULL) {
+                self->write[2] = MP_OBJ_FROM_PTR(&self->out_buf);
+                mp_call_method_n_kw(1, 0, self->write);
+            } else {
+                self->in_buf.len = len;
+                self->in_buf.items = dest;
+                self->write_readinto[2] = MP_OBJ_FROM_PTR(&self->out_buf);
+                self->write_readinto[3] = MP_OBJ_FROM_PTR(&self->in_buf);
+                mp_call_method_n_kw(2, 0, self->write_readinto);
+            }
+            break;
+    }
+}
+
+STATIC uint8_t sd_byte(mp_obj_sdcard_t *self, uint8_t out) {
+    sd_xfer(self, &out, &out, 1);
+    return out;
+}
+
+STATIC void sd_cs(mp_obj_sdcard_t *self, bool value) {
+    #if MICROPY_VFS_SDCARD_NATIVEIO
+    if (self->cs_value[0] == MP_OBJ_NULL) {
+        common_hal_nativeio_digitalinout_set_value(MP_OBJ_TO_PTR(self->cs), value);
+        return;
+    }
+    #endif
+    self->cs_value[2] = MP_OBJ_NEW_SMALL_INT(value);
+    mp_call_method_n_kw(1, 0, self->cs_value);
+}
+
+STATIC void sd_spi_init(mp_obj_sdcard_t *self, uint32_t baudrate) {
+    #if MICROPY_VFS_SDCARD_NATIVEIO
+    if (self->spi_kind == SD_SPI_NATIVEIO) {
+        common_hal_nativeio_spi_configure(MP_OBJ_TO_PTR(self->spi), baudrate, 0, 0, 8);
+        return;
+    }
+    #endif
+    mp_obj_t args[2 + 1 + 2 * 3];
+    mp_load_method(self->spi, MP_QSTR_init, args);
+    // pyb.SPI wants its mode first
+    size_t n_args = 0;
+    mp_obj_t master[2];
+    mp_load_method_maybe(self->spi, MP_QSTR_MASTER, master);
+    if (master[0] != MP_OBJ_NULL) {
+        args[2] = master[0];
+        n_args = 1;
+    }
+    mp_obj_t *kw = args + 2 + n_args;
+    kw[0] = MP_OBJ_NEW_QSTR(MP_QSTR_baudrate);
+    kw[1] = mp_obj_new_int_from_uint(baudrate);
+    kw[2] = MP_OBJ_NEW_QSTR(MP_QSTR_polarity);
+    kw[3] = MP_OBJ_NEW_SMALL_INT(0);
+    kw[4] = MP_OBJ_NEW_QSTR(MP_QSTR_phase);
+    kw[5] = MP_OBJ_NEW_SMALL_INT(0);
+    mp_call_method_n_kw(n_args, 3, args);
+}
+
+// nativeio.SPI must be locked to be used. The lock is taken for the length
+// of each request unless the caller already holds it.
+STATIC bool sd_begin(mp_obj_sdcard_t *self) {
+    #if MICROPY_VFS_SDCARD_NATIVEIO
+    if (self->spi_kind == SD_SPI_NATIVEIO) {
+        nativeio_spi_obj_t *s = MP_OBJ_TO_PTR(self->spi);
+        self->took_lock = false;
+        if (!common_hal_nativeio_spi_has_lock(s)) {
+            if (!common_hal_nativeio_spi_try_lock(s)) {
+                return false;
+            }
+            self->took_lock = true;
+        }
+    }
+    #else
+    (void)self;
+    #endif
+    return true;
+}
+
+STATIC void sd_end(mp_obj_sdcard_t *self) {
+    #if MICROPY_VFS_SDCARD_NATIVEIO
+    if (self->took_lock) {
+        common_hal_nativeio_spi_unlock(MP_OBJ_TO_PTR(self->spi));
+        self->took_lock = false;
+    }
+    #else
+    (void)self;
+    #endif
+}
+
+/******************************************************************************/
+// SD protocol
+
+// Clocks the card until it sends something other than skip, and returns
+// that, or -1 if it didn't within timeout_ms.
+STATIC int sd_wait_not(mp_obj_sdcard_t *self, uint8_t skip, mp_uint_t timeout_ms) {
+    mp_uint_t start = mp_hal_ticks_ms();
+    for (;;) {
+        uint8_t b = sd_byte(self, 0xff);
+        if (b != skip) {
+            return b;
+        }
+        if (mp_hal_ticks_ms() - start >= timeout_ms) {
+            return -1;
+        }
+    }
+}
+
+// Waits for the card to stop holding MISO low while it's busy.
+STATIC bool sd_wait_ready(mp_obj_sdcard_t *self, mp_uint_t timeout_ms) {
+    mp_uint_t start = mp_hal_ticks_ms();
+    while (sd_byte(self, 0xff) != 0xff) {
+        if (mp_hal_ticks_ms() - start >= timeout_ms) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Selects the card and sends it a command. Returns the R1 response, or -1 if
+// there was none, and the resp_len bytes following it are stored in resp.
+// The card is left selected; sd_release() deselects it.
+STATIC int sd_cmd(mp_obj_sdcard_t *self, uint8_t cmd, uint32_t arg, uint8_t crc, uint8_t *resp, size_t resp_len) {
+    uint8_t buf[6] = {0x40 | cmd, arg >> 24, arg >> 16, arg >> 8, arg, crc};
+    sd_cs(self, 0);
+    sd_xfer(self, buf, NULL, sizeof(buf));
+    for (int i = 0; i < SD_CMD_TIMEOUT; ++i) {
+        uint8_t r = sd_byte(self, 0xff);
+        if (!(r & 0x80)) {
+            if (resp_len > 0) {
+                sd_xfer(self, NULL, resp, resp_len);
+            }
+            return r;
+        }
+    }
+    return -1;
+}
+
+STATIC void sd_release(mp_obj_sdcard_t *self) {
+    sd_cs(self, 1);
+    // the card only lets go of MISO on the next clock
+    sd_byte(self, 0xff);
+}
+
+STATIC bool sd_read_data(mp_obj_sdcard_t *self, uint8_t *buf, size_t len) {
+    if (sd_wait_not(self, 0xff, SD_READ_TIMEOUT_MS) != TOKEN_DATA) {
+        return false;
+    }
+    sd_xfer(self, NULL, buf, len);
+    uint8_t crc[2];
+    sd_xfer(self, NULL, crc, sizeof(crc));
+    return true;
+}
+
+STATIC bool sd_write_data(mp_obj_sdcard_t *self, uint8_t token, const uint8_t *buf) {
+    static const uint8_t crc[2] = {0xff, 0xff};
+    sd_byte(self, token);
+    sd_xfer(self, buf, NULL, SD_SECTOR_SIZE);
+    sd_xfer(self, crc, NULL, sizeof(crc));
+    if ((sd_byte(self, 0xff) & 0x1f) != 0x05) {
+        return false;
+    }
+    return sd_wait_ready(self, SD_WRITE_TIMEOUT_MS);
+}
+
+// Returns NULL, or a message saying why the card couldn't be set up.
+STATIC const char *sd_init_card(mp_obj_sdcard_t *self) {
+    sd_cs(self, 1);
+    sd_spi_init(self, SD_INIT_BAUDRATE);
+
+    // clock the card at least 74 cycles with CS high
+    uint8_t buf[16];
+    memset(buf, 0xff, sizeof(buf));
+    sd_xfer(self, buf, NULL, sizeof(buf));
+
+    // CMD0: go idle, allowing a few attempts
+    int r = -1;
+    for (int i = 0; i < 5 && r != R1_IDLE_STATE; ++i) {
+        r = sd_cmd(self, 0, 0, 0x95, NULL, 0);
+        sd_release(self);
+    }
+    if (r != R1_IDLE_STATE) {
+        return "no SD card";
+    }
+
+    // CMD8: only v2 cards know it, and they may be high capacity
+    r = sd_cmd(self, 8, 0x1aa, 0x87, buf, 4);
+    sd_release(self);
+    uint32_t hcs;
+    if (r == R1_IDLE_STATE) {
+        hcs = 0x40000000;
+    } else if (r == (R1_IDLE_STATE | R1_ILLEGAL_COMMAND)) {
+        hcs = 0;
+    } else {
+        return "couldn't determine SD card version";
+    }
+
+    // ACMD41: start initialisation, and wait for it to finish
+    mp_uint_t start = mp_hal_ticks_ms();
+    for (;;) {
+        sd_cmd(self, 55, 0, 0, NULL, 0);
+        sd_release(self);
+        r = sd_cmd(self, 41, hcs, 0, NULL, 0);
+        sd_release(self);
+        if (r == 0) {
+            break;
+        }
+        if (mp_hal_ticks_ms() - start >= SD_INIT_TIMEOUT_MS) {
+            return "timeout waiting for SD card";
+        }
+        mp_hal_delay_ms(10);
+    }
+
+    // CMD58: the OCR's CCS bit says whether blocks are addressed by number
+    self->addr_shift = 9;
+    if (hcs != 0) {
+        r = sd_cmd(self, 58, 0, 0, buf, 4);
+        sd_release(self);
+        if (r == 0 && (buf[0] & 0x40)) {
+            self->addr_shift = 0;
+        }
+    }
+
+    // CMD9: the CSD register comes back as a data block
+    r = sd_cmd(self, 9, 0, 0, NULL, 0);
+    bool ok = r == 0 && sd_read_data(self, buf, 16);
+    sd_release(self);
+    if (!ok) {
+        return "no response from SD card";
+    }
+    if ((buf[0] >> 6) == 1) {
+        uint32_t c_size = (buf[7] & 0x3f) << 16 | buf[8] << 8 | buf[9];
+        self->sectors = (c_size + 1) * 1024;
+    } else if ((buf[0] >> 6) == 0) {
+        uint32_t c_size = (buf[6] & 0x03) << 10 | buf[7] << 2 | buf[8] >> 6;
+        uint32_t c_size_mult = (buf[9] & 0x03) << 1 | buf[10] >> 7;
+        uint32_t read_bl_len = buf[5] & 0x0f;
+        self->sectors = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+    } else {
+        return "SD card CSD format not supported";
+    }
+
+    // CMD16: set block length to 512 bytes
+    r = sd_cmd(self, 16, SD_SECTOR_SIZE, 0, NULL, 0);
+    sd_release(self);
+    if (r != 0) {
+        return "can't set 512 block size";
+    }
+
+    sd_spi_init(self, self->baudrate);
+    return NULL;
+}
+
+STATIC mp_uint_t sdcard_read(mp_obj_t self_in, uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    mp_obj_sdcard_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!sd_begin(self)) {
+        return MP_EBUSY;
+    }
+    mp_uint_t ret = 0;
+    uint32_t addr = block_num << self->addr_shift;
+    if (num_blocks == 1) {
+        // CMD17: read a single block
+        if (sd_cmd(self, 17, addr, 0, NULL, 0) != 0 || !sd_read_data(self, buf, SD_SECTOR_SIZE)) {
+            ret = MP_EIO;
+        }
+    } else {
+        // CMD18: read blocks until stopped
+        if (sd_cmd(self, 18, addr, 0, NULL, 0) != 0) {
+            ret = MP_EIO;
+        } else {
+            for (; num_blocks > 0; --num_blocks, buf += SD_SECTOR_SIZE) {
+                if (!sd_read_data(self, buf, SD_SECTOR_SIZE)) {
+                    ret = MP_EIO;
+                    break;
+                }
+            }
+            // CMD12: stop; the byte after it is junk, then R1 and busy
+            static const uint8_t cmd12[6] = {0x40 | 12, 0, 0, 0, 0, 0};
+            sd_xfer(self, cmd12, NULL, sizeof(cmd12));
+            sd_byte(self, 0xff);
+            if (sd_wait_not(self, 0xff, SD_READ_TIMEOUT_MS) < 0 || !sd_wait_ready(self, SD_READ_TIMEOUT_MS)) {
+                ret = MP_EIO;
+            }
+        }
+    }
+    sd_release(self);
+    sd_end(self);
+    return ret;
+}
+
+STATIC mp_uint_t sdcard_write(mp_obj_t self_in, const uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    mp_obj_sdcard_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!sd_begin(self)) {
+        return MP_EBUSY;
+    }
+    mp_uint_t ret = 0;
+    uint32_t addr = block_num << self->addr_shift;
+    if (num_blocks == 1) {
+        // CMD24: write a single block
+        if (sd_cmd(self, 24, addr, 0, NULL, 0) != 0 || !sd_write_data(self, TOKEN_DATA, buf)) {
+            ret = MP_EIO;
+        }
+    } else {
+        // CMD25: write blocks until the stop token
+        if (sd_cmd(self, 25, addr, 0, NULL, 0) != 0) {
+            ret = MP_EIO;
+        } else {
+            for (; num_blocks > 0; --num_blocks, buf += SD_SECTOR_SIZE) {
+                if (!sd_write_data(self, TOKEN_CMD25, buf)) {
+                    ret = MP_EIO;
+                    break;
+                }
+            }
+            sd_byte(self, TOKEN_STOP_TRAN);
+            sd_byte(self, 0xff);
+            if (!sd_wait_ready(self, SD_WRITE_TIMEOUT_MS)) {
+                ret = MP_EIO;
+            }
+        }
+    }
+    sd_release(self);
+    sd_end(self);
+    return ret;
+}
+
+/******************************************************************************/
+// MicroPython bindings
+
+STATIC mp_obj_t sdcard_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_spi, ARG_cs, ARG_baudrate };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_spi, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_cs, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_baudrate, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1320000} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_sdcard_t *self = m_new0(mp_obj_sdcard_t, 1);
+    self->base.type = type;
+    self->spi = args[ARG_spi].u_obj;
+    self->cs = args[ARG_cs].u_obj;
+    self->baudrate = args[ARG_baudrate].u_int;
+    self->out_buf.base.type = &mp_type_bytearray;
+    self->out_buf.typecode = BYTEARRAY_TYPECODE;
+    self->in_buf.base.type = &mp_type_bytearray;
+    self->in_buf.typecode = BYTEARRAY_TYPECODE;
+
+    // find out how to talk to the bus
+    self->spi_kind = SD_SPI_GENERIC;
+    #if MICROPY_VFS_SDCARD_NATIVEIO
+    if (MP_OBJ_IS_TYPE(self->spi, &nativeio_spi_type)) {
+        self->spi_kind = SD_SPI_NATIVEIO;
+    }
+    #endif
+    #if MICROPY_PY_MACHINE_SPI
+    if (self->spi_kind == SD_SPI_GENERIC) {
+        mp_obj_t dest[2];
+        mp_load_method_maybe(self->spi, MP_QSTR_write_readinto, dest);
+        if (dest[0] == MP_OBJ_FROM_PTR(&mp_machine_spi_write_readinto_obj)) {
+            self->spi_kind = SD_SPI_MACHINE;
+        }
+    }
+    #endif
+    if (self->spi_kind == SD_SPI_GENERIC) {
+        mp_load_method(self->spi, MP_QSTR_write, self->write);
+        mp_load_method(self->spi, MP_QSTR_write_readinto, self->write_readinto);
+    }
+
+    // make the chip select an output, high
+    #if MICROPY_VFS_SDCARD_NATIVEIO
+    if (MP_OBJ_IS_TYPE(self->cs, &nativeio_digitalinout_type)) {
+        common_hal_nativeio_digitalinout_switch_to_output(MP_OBJ_TO_PTR(self->cs), true, DRIVE_MODE_PUSH_PULL);
+    } else
+    #endif
+    {
+        mp_load_method(self->cs, MP_QSTR_value, self->cs_value);
+        mp_obj_t init[2 + 1 + 2];
+        mp_obj_t out[2];
+        mp_load_method_maybe(self->cs, MP_QSTR_init, init);
+        mp_load_method_maybe(self->cs, MP_QSTR_OUT, out);
+        if (init[0] != MP_OBJ_NULL && out[0] != MP_OBJ_NULL) {
+            init[2] = out[0];
+            init[3] = MP_OBJ_NEW_QSTR(MP_QSTR_value);
+            init[4] = MP_OBJ_NEW_SMALL_INT(1);
+            mp_call_method_n_kw(1, 1, init);
+        }
+    }
+
+    if (!sd_begin(self)) {
+        mp_raise_OSError(MP_EBUSY);
+    }
+    const char *err = sd_init_card(self);
+    sd_end(self);
+    if (err != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, err));
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t sdcard_readblocks(mp_obj_t self, mp_obj_t block_num, mp_obj_t buf) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf, &bufinfo, MP_BUFFER_WRITE);
+    mp_uint_t ret = sdcard_read(self, bufinfo.buf, mp_obj_get_int(block_num), bufinfo.len / SD_SECTOR_SIZE);
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(sdcard_readblocks_obj, sdcard_readblocks);
+
+STATIC mp_obj_t sdcard_writeblocks(mp_obj_t self, mp_obj_t block_num, mp_obj_t buf) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf, &bufinfo, MP_BUFFER_READ);
+    mp_uint_t ret = sdcard_write(self, bufinfo.buf, mp_obj_get_int(block_num), bufinfo.len / SD_SECTOR_SIZE);
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(sdcard_writeblocks_obj, sdcard_writeblocks);
+
+STATIC mp_obj_t sdcard_ioctl(mp_obj_t self_in, mp_obj_t cmd_in, mp_obj_t arg_in) {
+    (void)arg_in;
+    mp_obj_sdcard_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (mp_obj_get_int(cmd_in)) {
+        case BP_IOCTL_INIT: return MP_OBJ_NEW_SMALL_INT(0); // done by the constructor
+        case BP_IOCTL_DEINIT: return MP_OBJ_NEW_SMALL_INT(0);
+        case BP_IOCTL_SYNC: return MP_OBJ_NEW_SMALL_INT(0); // writes finish before returning
+        case BP_IOCTL_SEC_COUNT: return mp_obj_new_int_from_uint(self->sectors);
+        case BP_IOCTL_SEC_SIZE: return MP_OBJ_NEW_SMALL_INT(SD_SECTOR_SIZE);
+        default: return mp_const_none;
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(sdcard_ioctl_obj, sdcard_ioctl);
+
+STATIC const mp_rom_map_elem_t sdcard_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_readblocks), MP_ROM_PTR(&sdcard_readblocks_obj) },
+    { MP_ROM_QSTR(MP_QSTR_writeblocks), MP_ROM_PTR(&sdcard_writeblocks_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ioctl), MP_ROM_PTR(&sdcard_ioctl_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(sdcard_locals_dict, sdcard_locals_dict_table);
+
+STATIC const mp_block_dev_p_t sdcard_block_dev_p = {
+    .readblocks = sdcard_read,
+    .writeblocks = sdcard_write,
+};
+
+const mp_obj_type_t mp_sdcard_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_SDCard,
+    .make_new = sdcard_make_new,
+    .protocol = &sdcard_block_dev_p,
+    .locals_dict = (mp_obj_dict_t*)&sdcard_locals_dict,
+};
+
+#endif // MICROPY_VFS_SDCARD
@@ -39,7 +39,11 @@
 / Functions and Buffer Configurations
 /---------------------------------------------------------------------------*/
 
+#ifdef MICROPY_FATFS_TINY
+#define	_FS_TINY		(MICROPY_FATFS_TINY)
+#else
 #define	_FS_TINY		1
+#endif
 /* This option switches tiny buffer configuration. (0:Normal or 1:Tiny)
 /  At the tiny configuration, size of the file object (FIL) is reduced _MAX_SS
 /  bytes. Instead of private sector buffer eliminated from the file object,
@@ -82,7 +86,11 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
+#ifdef MICROPY_FATFS_USE_FASTSEEK
+#define	_USE_FASTSEEK	(MICROPY_FATFS_USE_FASTSEEK)
+#else
 #define	_USE_FASTSEEK	0
+#endif
 /* This option switches fast seek feature. (0:Disable or 1:Enable) */
 
 #ifdef MICROPY_FATFS_USE_LABEL
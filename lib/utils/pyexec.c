@@ -52,12 +52,69 @@ STATIC bool repl_display_debugging_info = 0;
 #define EXEC_FLAG_ALLOW_DEBUGGING (2)
 #define EXEC_FLAG_IS_REPL (4)
 #define EXEC_FLAG_SOURCE_IS_RAW_CODE (8)
+#define EXEC_FLAG_SOURCE_IS_STMTS (16)
+#define EXEC_FLAG_SOURCE_IS_RAW_PASTE (32)
+
+#if MICROPY_REPL_RAW_PASTE_WINDOW
+
+// Raw-paste mode streams the script from stdin straight into the lexer, so
+// the source is never buffered in full.  The host may send at most one
+// window of data ahead of what has been consumed, and is sent \x01 each time
+// a further window can follow.  Ctrl-D ends the data and Ctrl-C aborts it;
+// both are acknowledged with \x04.
+typedef struct _raw_paste_reader_t {
+    bool eof;
+    uint16_t window_remain;
+} raw_paste_reader_t;
+
+STATIC mp_uint_t raw_paste_next_byte(void *data) {
+    raw_paste_reader_t *reader = data;
+    if (reader->eof) {
+        return MP_LEXER_EOF;
+    }
+
+    int c = mp_hal_stdin_rx_chr();
+    if (c == CHAR_CTRL_C || c == CHAR_CTRL_D) {
+        reader->eof = true;
+        mp_hal_stdout_tx_strn("\x04", 1);
+        if (c == CHAR_CTRL_C) {
+            nlr_raise(mp_obj_new_exception(&mp_type_KeyboardInterrupt));
+        }
+        return MP_LEXER_EOF;
+    }
+
+    if (--reader->window_remain == 0) {
+        reader->window_remain = MICROPY_REPL_RAW_PASTE_WINDOW;
+        mp_hal_stdout_tx_strn("\x01", 1);
+    }
+    return c;
+}
+
+STATIC void raw_paste_close(void *data) {
+    raw_paste_reader_t *reader = data;
+    if (!reader->eof) {
+        // parsing stopped early (eg syntax error) so tell the host to stop
+        // sending, then discard what it has in flight up to its Ctrl-D
+        reader->eof = true;
+        mp_hal_stdout_tx_strn("\x04", 1);
+        for (;;) {
+            int c = mp_hal_stdin_rx_chr();
+            if (c == CHAR_CTRL_C || c == CHAR_CTRL_D) {
+                break;
+            }
+        }
+    }
+}
+
+#endif // MICROPY_REPL_RAW_PASTE_WINDOW
 
 // parses, compiles and executes the code in the lexer
 // frees the lexer before returning
 // EXEC_FLAG_PRINT_EOF prints 2 EOF chars: 1 after normal output, 1 after exception output
 // EXEC_FLAG_ALLOW_DEBUGGING allows debugging info to be printed after executing the code
 // EXEC_FLAG_IS_REPL is used for REPL inputs (flag passed on to mp_compile)
+// EXEC_FLAG_SOURCE_IS_STMTS compiles and executes a file lexer a statement at a time
+// EXEC_FLAG_SOURCE_IS_RAW_PASTE compiles from a raw_paste_reader_t as the data arrives
 STATIC int parse_compile_execute(void *source, mp_parse_input_kind_t input_kind, int exec_flags) {
     int ret = 0;
     uint32_t start = 0;
@@ -67,7 +124,23 @@ STATIC int parse_compile_execute(void *source, mp_parse_input_kind_t input_kind,
 
     nlr_buf_t nlr;
     if (nlr_push(&nlr) == 0) {
-        mp_obj_t module_fun;
+        mp_obj_t module_fun = MP_OBJ_NULL;
+        #if MICROPY_COMP_INCREMENTAL
+        if (exec_flags & EXEC_FLAG_SOURCE_IS_STMTS) {
+            // compiled as it is executed below
+        } else
+        #endif
+        #if MICROPY_REPL_RAW_PASTE_WINDOW
+        if (exec_flags & EXEC_FLAG_SOURCE_IS_RAW_PASTE) {
+            // the lexer is created here so a Ctrl-C while it reads ahead is caught
+            mp_lexer_t *lex = mp_lexer_new(MP_QSTR__lt_stdin_gt_, source, raw_paste_next_byte, raw_paste_close);
+            if (lex == NULL) {
+                nlr_raise(mp_obj_new_exception(&mp_type_MemoryError));
+            }
+            mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
+            module_fun = mp_compile(&parse_tree, MP_QSTR__lt_stdin_gt_, MP_EMIT_OPT_NONE, false);
+        } else
+        #endif
         #if MICROPY_MODULE_FROZEN_MPY
         if (exec_flags & EXEC_FLAG_SOURCE_IS_RAW_CODE) {
             // source is a raw_code object, create the function
@@ -85,7 +158,14 @@ STATIC int parse_compile_execute(void *source, mp_parse_input_kind_t input_kind,
         // execute code
         mp_hal_set_interrupt_char(CHAR_CTRL_C); // allow ctrl-C to interrupt us
         start = mp_hal_ticks_ms();
-        mp_call_function_0(module_fun);
+        #if MICROPY_COMP_INCREMENTAL
+        if (exec_flags & EXEC_FLAG_SOURCE_IS_STMTS) {
+            mp_parse_compile_execute_stmts(source, mp_globals_get(), mp_locals_get());
+        } else
+        #endif
+        {
+            mp_call_function_0(module_fun);
+        }
         mp_hal_set_interrupt_char(-1); // disable interrupt
         nlr_pop();
         ret = 1;
@@ -168,6 +248,13 @@ void pyexec_event_repl_init(void) {
 
 STATIC int pyexec_raw_repl_process_char(int c) {
     if (c == CHAR_CTRL_A) {
+        if (MP_STATE_VM(repl_line)->len == 2 && MP_STATE_VM(repl_line)->buf[0] == CHAR_CTRL_E) {
+            // raw-paste request: it needs to pull from stdin, which the
+            // event-driven REPL can't do, so tell the host to use plain raw mode
+            mp_hal_stdout_tx_strn("R\x00", 2);
+            vstr_reset(MP_STATE_VM(repl_line));
+            return 0;
+        }
         // reset raw REPL
         mp_hal_stdout_tx_str("raw REPL; CTRL-B to exit\r\n");
         goto reset;
@@ -314,6 +401,28 @@ int pyexec_event_repl_process_char(int c) {
 
 #else // MICROPY_REPL_EVENT_DRIVEN
 
+// Handles Ctrl-E, a command byte, Ctrl-A received by the raw REPL.  Older
+// firmware treats this as a reset of the raw REPL, so the host can tell from
+// the reply whether raw-paste mode is supported.  Returns -1 if the command
+// was refused, otherwise the result of executing the pasted script.
+STATIC int pyexec_raw_paste(int cmd) {
+    #if MICROPY_REPL_RAW_PASTE_WINDOW
+    if (cmd == 'A') {
+        // accept, followed by the window size as 16-bit little endian
+        static const char accept[4] = {
+            'R', 1, MICROPY_REPL_RAW_PASTE_WINDOW & 0xff, MICROPY_REPL_RAW_PASTE_WINDOW >> 8
+        };
+        mp_hal_stdout_tx_strn(accept, sizeof(accept));
+        raw_paste_reader_t reader = {false, MICROPY_REPL_RAW_PASTE_WINDOW};
+        return parse_compile_execute(&reader, MP_PARSE_FILE_INPUT, EXEC_FLAG_PRINT_EOF | EXEC_FLAG_SOURCE_IS_RAW_PASTE);
+    }
+    #else
+    (void)cmd;
+    #endif
+    mp_hal_stdout_tx_strn("R\x00", 2);
+    return -1;
+}
+
 int pyexec_raw_repl(void) {
     vstr_t line;
     vstr_init(&line, 32);
@@ -327,6 +436,20 @@ raw_repl_reset:
         for (;;) {
             int c = mp_hal_stdin_rx_chr();
             if (c == CHAR_CTRL_A) {
+                if (line.len == 2 && line.buf[0] == CHAR_CTRL_E) {
+                    int ret = pyexec_raw_paste(line.buf[1]);
+                    vstr_reset(&line);
+                    if (ret < 0) {
+                        // refused, the host falls back to plain raw mode
+                        continue;
+                    }
+                    if (ret & PYEXEC_FORCED_EXIT) {
+                        vstr_clear(&line);
+                        return ret;
+                    }
+                    mp_hal_stdout_tx_str(">");
+                    continue;
+                }
                 // reset raw REPL
                 goto raw_repl_reset;
             } else if (c == CHAR_CTRL_B) {
@@ -505,7 +628,11 @@ int pyexec_file(const char *filename) {
         return false;
     }
 
+    #if MICROPY_COMP_INCREMENTAL
+    return parse_compile_execute(lex, MP_PARSE_FILE_INPUT, EXEC_FLAG_SOURCE_IS_STMTS);
+    #else
     return parse_compile_execute(lex, MP_PARSE_FILE_INPUT, 0);
+    #endif
 }
 
 #if MICROPY_MODULE_FROZEN
@@ -37,6 +37,8 @@
 #include "py/stackctrl.h"
 #ifdef _WIN32
 #include "windows/fmode.h"
+#else
+#include <sys/wait.h>
 #endif
 
 // Command line options, with their defaults
@@ -101,12 +103,86 @@ STATIC int compile_and_save(const char *file, const char *output_file, const cha
     }
 }
 
+// Compile one of several input files given on the command line.  The file is
+// read from root_dir/name (or just name), its source name is name, and the
+// output goes to out_dir/name with a .mpy extension (or next to the input).
+STATIC int compile_batch_file(const char *name, const char *root_dir, const char *out_dir) {
+    vstr_t path;
+    vstr_init(&path, 16);
+    if (root_dir != NULL) {
+        vstr_add_str(&path, root_dir);
+        vstr_add_char(&path, '/');
+    }
+    vstr_add_str(&path, name);
+
+    vstr_t out;
+    vstr_init(&out, 16);
+    if (out_dir != NULL) {
+        vstr_add_str(&out, out_dir);
+        vstr_add_char(&out, '/');
+        vstr_add_str(&out, name);
+    } else {
+        vstr_add_str(&out, vstr_null_terminated_str(&path));
+    }
+    vstr_cut_tail_bytes(&out, 2);
+    vstr_add_str(&out, "mpy");
+
+    int ret = compile_and_save(vstr_null_terminated_str(&path), vstr_null_terminated_str(&out),
+        root_dir != NULL ? name : NULL);
+
+    vstr_clear(&out);
+    vstr_clear(&path);
+    return ret;
+}
+
+// Compile every n_jobs'th file starting with the first_job'th; returns the
+// number of files that failed to compile.
+STATIC int compile_batch(const char **files, int n_files, int first_job, int n_jobs, const char *root_dir, const char *out_dir) {
+    int n_failed = 0;
+    for (int i = first_job; i < n_files; i += n_jobs) {
+        if (compile_batch_file(files[i], root_dir, out_dir) != 0) {
+            n_failed += 1;
+        }
+    }
+    return n_failed;
+}
+
+#ifndef _WIN32
+// Split the files between n_jobs child processes, each with its own copy
+// of the compiler state, and wait for them all.
+STATIC int compile_batch_parallel(const char **files, int n_files, int n_jobs, const char *root_dir, const char *out_dir) {
+    fflush(stdout);
+    int n_failed = 0;
+    for (int job = 0; job < n_jobs; ++job) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            int ret = compile_batch(files, n_files, job, n_jobs, root_dir, out_dir);
+            fflush(stdout);
+            _exit(ret != 0);
+        } else if (pid < 0) {
+            // couldn't start a worker, so compile its share here
+            n_failed += compile_batch(files, n_files, job, n_jobs, root_dir, out_dir);
+        }
+    }
+    int status;
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            n_failed += 1;
+        }
+    }
+    return n_failed;
+}
+#endif
+
 STATIC int usage(char **argv) {
     printf(
-"usage: %s [<opts>] [-X <implopt>] <input filename>\n"
+"usage: %s [<opts>] [-X <implopt>] <input filename>...\n"
 "Options:\n"
 "-o : output file for compiled bytecode (defaults to input with .mpy extension)\n"
 "-s : source filename to embed in the compiled bytecode (defaults to input file)\n"
+"-r <dir> : read inputs from <dir>, embedding their names relative to it\n"
+"-d <dir> : write the .mpy files for the inputs to <dir>\n"
+"-j <n> : compile multiple inputs with <n> worker processes\n"
 "-v : verbose (trace various operations); can be multiple\n"
 "-O[N] : apply bytecode optimizations of level N\n"
 "\n"
@@ -114,6 +190,8 @@ STATIC int usage(char **argv) {
 "-msmall-int-bits=number : set the maximum bits used to encode a small-int\n"
 "-mno-unicode : don't support unicode in compiled strings\n"
 "-mcache-lookup-bc : cache map lookups in the bytecode\n"
+"-msuperinstr-bc : fuse common opcode pairs into superinstructions\n"
+"-march=<arch> : set architecture for native emitter; x86, x64, armv6, armv7m\n"
 "\n"
 "Implementation specific options:\n", argv[0]
 );
@@ -197,11 +275,17 @@ MP_NOINLINE int main_(int argc, char **argv) {
     // set default compiler configuration
     mp_dynamic_compiler.small_int_bits = 31;
     mp_dynamic_compiler.opt_cache_map_lookup_in_bytecode = 0;
+    mp_dynamic_compiler.opt_superinstructions = 0;
     mp_dynamic_compiler.py_builtins_str_unicode = 1;
+    mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_NONE;
 
-    const char *input_file = NULL;
+    const char **input_files = malloc(argc * sizeof(*input_files));
+    int n_input_files = 0;
     const char *output_file = NULL;
     const char *source_file = NULL;
+    const char *root_dir = NULL;
+    const char *out_dir = NULL;
+    int n_jobs = 1;
 
     // parse main options
     for (int a = 1; a < argc; a++) {
@@ -229,6 +313,32 @@ MP_NOINLINE int main_(int argc, char **argv) {
                 }
                 a += 1;
                 source_file = argv[a];
+            } else if (strcmp(argv[a], "-r") == 0) {
+                if (a + 1 >= argc) {
+                    exit(usage(argv));
+                }
+                a += 1;
+                root_dir = argv[a];
+            } else if (strcmp(argv[a], "-d") == 0) {
+                if (a + 1 >= argc) {
+                    exit(usage(argv));
+                }
+                a += 1;
+                out_dir = argv[a];
+            } else if (strncmp(argv[a], "-j", 2) == 0) {
+                const char *arg = argv[a] + 2;
+                if (*arg == '\0') {
+                    if (a + 1 >= argc) {
+                        exit(usage(argv));
+                    }
+                    a += 1;
+                    arg = argv[a];
+                }
+                char *end;
+                n_jobs = strtol(arg, &end, 0);
+                if (*end || n_jobs < 1) {
+                    return usage(argv);
+                }
             } else if (strncmp(argv[a], "-msmall-int-bits=", sizeof("-msmall-int-bits=") - 1) == 0) {
                 char *end;
                 mp_dynamic_compiler.small_int_bits =
@@ -241,28 +351,66 @@ MP_NOINLINE int main_(int argc, char **argv) {
                 mp_dynamic_compiler.opt_cache_map_lookup_in_bytecode = 0;
             } else if (strcmp(argv[a], "-mcache-lookup-bc") == 0) {
                 mp_dynamic_compiler.opt_cache_map_lookup_in_bytecode = 1;
+            } else if (strcmp(argv[a], "-mno-superinstr-bc") == 0) {
+                mp_dynamic_compiler.opt_superinstructions = 0;
+            } else if (strcmp(argv[a], "-msuperinstr-bc") == 0) {
+                mp_dynamic_compiler.opt_superinstructions = 1;
             } else if (strcmp(argv[a], "-mno-unicode") == 0) {
                 mp_dynamic_compiler.py_builtins_str_unicode = 0;
             } else if (strcmp(argv[a], "-municode") == 0) {
                 mp_dynamic_compiler.py_builtins_str_unicode = 1;
+            } else if (strncmp(argv[a], "-march=", sizeof("-march=") - 1) == 0) {
+                const char *arch = argv[a] + sizeof("-march=") - 1;
+                if (strcmp(arch, "x86") == 0) {
+                    mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_X86;
+                } else if (strcmp(arch, "x64") == 0) {
+                    mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_X64;
+                } else if (strcmp(arch, "armv6") == 0) {
+                    mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_ARMV6;
+                } else if (strcmp(arch, "armv7m") == 0) {
+                    mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_ARMV7M;
+                } else {
+                    mp_printf(&mp_stderr_print, "unrecognised arch\n");
+                    exit(1);
+                }
             } else {
                 return usage(argv);
             }
         } else {
-            if (input_file != NULL) {
-                mp_printf(&mp_stderr_print, "multiple input files\n");
-                exit(1);
-            }
-            input_file = argv[a];
+            input_files[n_input_files++] = argv[a];
         }
     }
 
-    if (input_file == NULL) {
+    if (n_input_files == 0) {
         mp_printf(&mp_stderr_print, "no input file\n");
         exit(1);
     }
 
-    int ret = compile_and_save(input_file, output_file, source_file);
+    if (n_input_files > 1 && (output_file != NULL || source_file != NULL)) {
+        mp_printf(&mp_stderr_print, "-o and -s need a single input file\n");
+        exit(1);
+    }
+
+    if ((emit_opt == MP_EMIT_OPT_NATIVE_PYTHON || emit_opt == MP_EMIT_OPT_VIPER)
+        && mp_dynamic_compiler.native_arch == MP_NATIVE_ARCH_NONE) {
+        mp_printf(&mp_stderr_print, "arch not specified\n");
+        exit(1);
+    }
+
+    int ret;
+    if (output_file != NULL || source_file != NULL) {
+        ret = compile_and_save(input_files[0], output_file, source_file);
+    #ifndef _WIN32
+    } else if (n_jobs > 1 && n_input_files > 1) {
+        if (n_jobs > n_input_files) {
+            n_jobs = n_input_files;
+        }
+        ret = compile_batch_parallel(input_files, n_input_files, n_jobs, root_dir, out_dir) != 0;
+    #endif
+    } else {
+        ret = compile_batch(input_files, n_input_files, 0, 1, root_dir, out_dir) != 0;
+    }
+    free(input_files);
 
     #if MICROPY_PY_MICROPYTHON_MEM_INFO
     if (mp_verbose_flag) {
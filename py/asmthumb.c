@@ -35,6 +35,7 @@
 
 #include "py/asmthumb.h"
 
+#define UNSIGNED_FIT5(x) ((uint32_t)(x) < 32)
 #define UNSIGNED_FIT8(x) (((x) & 0xffffff00) == 0)
 #define UNSIGNED_FIT16(x) (((x) & 0xffff0000) == 0)
 #define SIGNED_FIT8(x) (((x) & 0xffffff80) == 0) || (((x) & 0xffffff80) == 0xffffff80)
@@ -363,9 +364,23 @@ void asm_thumb_mov_reg_i32_optimised(asm_thumb_t *as, uint reg_dest, int i32) {
     }
 }
 
+#define OP_LDR_PC_OFFSET(rlo_dest, word_offset) (0x4800 | ((rlo_dest) << 8) | ((word_offset) & 0x00ff))
+
 // i32 is stored as a full word in the code, and aligned to machine-word boundary
-// TODO this is very inefficient, improve it!
+// For a low register it is the last word of the code and is what gets loaded,
+// so it can be patched when the code is relocated.
 void asm_thumb_mov_reg_i32_aligned(asm_thumb_t *as, uint reg_dest, int i32) {
+    if (reg_dest < ASM_THUMB_REG_R8) {
+        // the ldr must be on a machine-word boundary for the i32 to follow it
+        if ((as->code_offset & 3) != 0) {
+            asm_thumb_op16(as, ASM_THUMB_OP_NOP);
+        }
+        asm_thumb_op16(as, OP_LDR_PC_OFFSET(reg_dest, 0));
+        // jump over the i32 value (instruction prefetch adds 2 to PC)
+        asm_thumb_op16(as, OP_B_N(2));
+        asm_thumb_data(as, 4, i32);
+        return;
+    }
     // align on machine-word + 2
     if ((as->code_offset & 3) == 0) {
         asm_thumb_op16(as, ASM_THUMB_OP_NOP);
@@ -404,6 +419,30 @@ void asm_thumb_mov_reg_local_addr(asm_thumb_t *as, uint rlo_dest, int local_num)
     asm_thumb_op16(as, OP_ADD_REG_SP_OFFSET(rlo_dest, word_offset));
 }
 
+#define OP_LDR_W_HI(reg_base) (0xf8d0 | (reg_base))
+#define OP_LDR_W_LO(reg_dest, imm12) ((reg_dest) << 12 | (imm12))
+#define OP_STR_W_HI(reg_base) (0xf8c0 | (reg_base))
+#define OP_STR_W_LO(reg_src, imm12) ((reg_src) << 12 | (imm12))
+
+// uses the 16-bit instruction when the registers and offset allow it
+void asm_thumb_ldr_reg_reg_i12_optimised(asm_thumb_t *as, uint reg_dest, uint reg_base, uint word_offset) {
+    if (reg_dest < ASM_THUMB_REG_R8 && reg_base < ASM_THUMB_REG_R8 && UNSIGNED_FIT5(word_offset)) {
+        asm_thumb_ldr_rlo_rlo_i5(as, reg_dest, reg_base, word_offset);
+    } else {
+        assert(word_offset < 1024);
+        asm_thumb_op32(as, OP_LDR_W_HI(reg_base), OP_LDR_W_LO(reg_dest, word_offset * 4));
+    }
+}
+
+void asm_thumb_str_reg_reg_i12_optimised(asm_thumb_t *as, uint reg_src, uint reg_base, uint word_offset) {
+    if (reg_src < ASM_THUMB_REG_R8 && reg_base < ASM_THUMB_REG_R8 && UNSIGNED_FIT5(word_offset)) {
+        asm_thumb_str_rlo_rlo_i5(as, reg_src, reg_base, word_offset);
+    } else {
+        assert(word_offset < 1024);
+        asm_thumb_op32(as, OP_STR_W_HI(reg_base), OP_STR_W_LO(reg_src, word_offset * 4));
+    }
+}
+
 // this could be wrong, because it should have a range of +/- 16MiB...
 #define OP_BW_HI(byte_offset) (0xf000 | (((byte_offset) >> 12) & 0x07ff))
 #define OP_BW_LO(byte_offset) (0xb800 | (((byte_offset) >> 1) & 0x07ff))
@@ -450,24 +489,12 @@ void asm_thumb_bcc_label(asm_thumb_t *as, int cond, uint label) {
 #define OP_SVC(arg) (0xdf00 | (arg))
 
 void asm_thumb_bl_ind(asm_thumb_t *as, void *fun_ptr, uint fun_id, uint reg_temp) {
-    /* TODO make this use less bytes
-    uint rlo_base = ASM_THUMB_REG_R3;
-    uint rlo_dest = ASM_THUMB_REG_R7;
-    uint word_offset = 4;
-    asm_thumb_op16(as, 0x0000);
-    asm_thumb_op16(as, 0x6800 | (word_offset << 6) | (rlo_base << 3) | rlo_dest); // ldr rlo_dest, [rlo_base, #offset]
-    asm_thumb_op16(as, 0x4780 | (ASM_THUMB_REG_R9 << 3)); // blx reg
-    */
-
-    if (fun_id < 32) {
-        // load ptr to function from table, indexed by fun_id (must be in range 0-31); 4 bytes
-        asm_thumb_op16(as, ASM_THUMB_FORMAT_9_10_ENCODE(ASM_THUMB_FORMAT_9_LDR | ASM_THUMB_FORMAT_9_WORD_TRANSFER, reg_temp, ASM_THUMB_REG_R7, fun_id));
-        asm_thumb_op16(as, OP_BLX(reg_temp));
-    } else {
-        // load ptr to function into register using immediate; 6 bytes
-        asm_thumb_mov_reg_i32(as, reg_temp, (mp_uint_t)fun_ptr);
-        asm_thumb_op16(as, OP_BLX(reg_temp));
-    }
+    // load ptr to function from table, indexed by fun_id; 4 bytes, or 6 if
+    // fun_id doesn't fit the 16-bit instruction.  No absolute address is used,
+    // so the code doesn't need relocating.
+    (void)fun_ptr;
+    asm_thumb_ldr_reg_reg_i12_optimised(as, reg_temp, ASM_THUMB_REG_R7, fun_id);
+    asm_thumb_op16(as, OP_BLX(reg_temp));
 }
 
 #endif // MICROPY_EMIT_THUMB || MICROPY_EMIT_INLINE_THUMB
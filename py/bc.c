@@ -54,6 +54,63 @@ mp_uint_t mp_decode_uint(const byte **ptr) {
     return unum;
 }
 
+size_t mp_bytecode_get_source_line(const mp_code_state_t *code_state, qstr *source_file, qstr *block_name) {
+    const byte *ip = code_state->code_info;
+    mp_uint_t code_info_size = mp_decode_uint(&ip);
+    #if MICROPY_PERSISTENT_CODE
+    *block_name = ip[0] | (ip[1] << 8);
+    *source_file = ip[2] | (ip[3] << 8);
+    ip += 4;
+    #else
+    *block_name = mp_decode_uint(&ip);
+    *source_file = mp_decode_uint(&ip);
+    #endif
+    size_t bc = code_state->ip - code_state->code_info - code_info_size;
+    size_t source_line = 1;
+    size_t c;
+    while ((c = *ip)) {
+        mp_uint_t b, l;
+        if ((c & 0x80) == 0) {
+            // 0b0LLBBBBB encoding
+            b = c & 0x1f;
+            l = c >> 5;
+            ip += 1;
+        } else {
+            // 0b1LLLBBBB 0bLLLLLLLL encoding (l's LSB in second byte)
+            b = c & 0xf;
+            l = ((c << 4) & 0x700) | ip[1];
+            ip += 2;
+        }
+        if (bc >= b) {
+            bc -= b;
+            source_line += l;
+        } else {
+            // found source line corresponding to bytecode offset
+            break;
+        }
+    }
+    return source_line;
+}
+
+#if MICROPY_GC_ALLOC_PROFILE
+qstr mp_bytecode_current_site(size_t *bc_offset) {
+    const mp_code_state_t *code_state = MP_STATE_THREAD(cur_code_state);
+    if (code_state == NULL) {
+        *bc_offset = 0;
+        return MP_QSTR_NULL;
+    }
+    const byte *ip = code_state->code_info;
+    mp_uint_t code_info_size = mp_decode_uint(&ip);
+    #if MICROPY_PERSISTENT_CODE
+    qstr block_name = ip[0] | (ip[1] << 8);
+    #else
+    qstr block_name = mp_decode_uint(&ip);
+    #endif
+    *bc_offset = code_state->ip - code_state->code_info - code_info_size;
+    return block_name;
+}
+#endif
+
 STATIC NORETURN void fun_pos_args_mismatch(mp_obj_fun_bc_t *f, size_t expected, size_t given) {
 #if MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_TERSE
     // generic message, used also for other argument issues
@@ -170,16 +227,28 @@ void mp_setup_code_state(mp_code_state_t *code_state, mp_obj_fun_bc_t *self, siz
         // get pointer to arg_names array
         const mp_obj_t *arg_names = (const mp_obj_t*)code_state->const_table;
 
+        // Keyword arguments are usually passed in the same order as the
+        // parameters are declared, so the search for each name starts just
+        // after the slot matched by the previous one and wraps around.  In
+        // the common case every name is then found with one comparison.
+        size_t n_named = n_pos_args + n_kwonly_args;
+        size_t hint = n_args;
+        mp_obj_t *named_state = &code_state->state[n_state - 1];
         for (size_t i = 0; i < n_kw; i++) {
             // the keys in kwargs are expected to be qstr objects
             mp_obj_t wanted_arg_name = kwargs[2 * i];
-            for (size_t j = 0; j < n_pos_args + n_kwonly_args; j++) {
+            size_t j = hint;
+            for (size_t n = n_named; n > 0; n--, j++) {
+                if (j >= n_named) {
+                    j = 0;
+                }
                 if (wanted_arg_name == arg_names[j]) {
-                    if (code_state->state[n_state - 1 - j] != MP_OBJ_NULL) {
+                    if (named_state[-(mp_int_t)j] != MP_OBJ_NULL) {
                         nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_TypeError,
                             "function got multiple values for argument '%q'", MP_OBJ_QSTR_VALUE(wanted_arg_name)));
                     }
-                    code_state->state[n_state - 1 - j] = kwargs[2 * i + 1];
+                    named_state[-(mp_int_t)j] = kwargs[2 * i + 1];
+                    hint = j + 1;
                     goto continue2;
                 }
             }
@@ -270,10 +339,12 @@ continue2:;
 #if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_PERSISTENT_CODE_SAVE
 
 // The following table encodes the number of bytes that a specific opcode
-// takes up.  There are 3 special opcodes that always have an extra byte:
+// takes up.  There are 5 special opcodes that always have an extra byte:
 //     MP_BC_MAKE_CLOSURE
 //     MP_BC_MAKE_CLOSURE_DEFARGS
 //     MP_BC_RAISE_VARARGS
+//     MP_BC_BINARY_OP_SMALL_INT
+//     MP_BC_LOAD_FAST_2
 // There are 4 special opcodes that have an extra byte only when
 // MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE is enabled:
 //     MP_BC_LOAD_NAME
@@ -304,8 +375,8 @@ STATIC const byte opcode_format_table[64] = {
     OC4(O, O, U, U), // 0x38-0x3b
     OC4(U, O, B, O), // 0x3c-0x3f
     OC4(O, B, B, O), // 0x40-0x43
-    OC4(B, B, O, U), // 0x44-0x47
-    OC4(U, U, U, U), // 0x48-0x4b
+    OC4(B, B, O, V), // 0x44-0x47
+    OC4(B, V, V, O), // 0x48-0x4b
     OC4(U, U, U, U), // 0x4c-0x4f
     OC4(V, V, U, V), // 0x50-0x53
     OC4(B, U, V, V), // 0x54-0x57
@@ -372,9 +443,12 @@ uint mp_opcode_format(const byte *ip, size_t *opcode_size) {
         ip += 3;
     } else {
         int extra_byte = (
-            *ip == MP_BC_RAISE_VARARGS
+            *ip == MP_BC_UNWIND_JUMP
+            || *ip == MP_BC_RAISE_VARARGS
             || *ip == MP_BC_MAKE_CLOSURE
             || *ip == MP_BC_MAKE_CLOSURE_DEFARGS
+            || *ip == MP_BC_BINARY_OP_SMALL_INT
+            || *ip == MP_BC_LOAD_FAST_2
             #if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
             || *ip == MP_BC_LOAD_NAME
             || *ip == MP_BC_LOAD_GLOBAL
@@ -89,6 +89,16 @@ typedef struct _mp_code_state_t {
 
 mp_uint_t mp_decode_uint(const byte **ptr);
 
+// Return the source line of the opcode code_state is at, and set the names of
+// its file and function.
+size_t mp_bytecode_get_source_line(const mp_code_state_t *code_state, qstr *source_file, qstr *block_name);
+
+#if MICROPY_GC_ALLOC_PROFILE
+// Return the name of the function the current thread runs bytecode of, and
+// the offset of its current opcode in *bc_offset.
+qstr mp_bytecode_current_site(size_t *bc_offset);
+#endif
+
 mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp_obj_t inject_exc);
 mp_code_state_t *mp_obj_fun_bc_prepare_codestate(mp_obj_t func, size_t n_args, size_t n_kw, const mp_obj_t *args);
 struct _mp_obj_fun_bc_t;
@@ -80,6 +80,13 @@
 #define MP_BC_POP_EXCEPT         (0x45)
 #define MP_BC_UNWIND_JUMP        (0x46) // rel byte code offset, 16-bit signed, in excess; then a byte
 
+// superinstructions, emitted if MICROPY_OPT_SUPERINSTRUCTIONS is enabled
+#define MP_BC_BINARY_OP_SMALL_INT (0x47) // signed var int, then a byte for the op
+#define MP_BC_LOAD_FAST_2        (0x48) // byte: first local in low nibble, second in high
+#define MP_BC_INPLACE_ADD_FAST   (0x49) // uint: local that TOS is added to in place
+#define MP_BC_LOAD_FAST_SHARE    (0x4a) // uint: local that may be a str/bytes built in place
+#define MP_BC_FOR_RANGE          (0x4b) // rel byte code offset, 16-bit unsigned
+
 #define MP_BC_BUILD_TUPLE        (0x50) // uint
 #define MP_BC_BUILD_LIST         (0x51) // uint
 #define MP_BC_BUILD_MAP          (0x53) // uint
@@ -114,4 +121,8 @@
 #define MP_BC_UNARY_OP_MULTI             (0xd0) // + op(7)
 #define MP_BC_BINARY_OP_MULTI            (0xd7) // + op(36)
 
+// quickened opcodes, only ever written by the VM into bytecode in RAM
+#define MP_BC_BINARY_OP_QUICK_MULTI      (0x01) // + N(10)
+#define MP_BC_LOAD_ATTR_INSTANCE         (0x0b) // qstr, as for LOAD_ATTR
+
 #endif // __MICROPY_INCLUDED_PY_BC0_H__
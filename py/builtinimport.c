@@ -152,11 +152,15 @@ STATIC void do_load_from_lexer(mp_obj_t module_obj, mp_lexer_t *lex, const char
 
     // parse, compile and execute the module in its context
     mp_obj_dict_t *mod_globals = mp_obj_module_get_globals(module_obj);
+    #if MICROPY_COMP_INCREMENTAL
+    mp_parse_compile_execute_stmts(lex, mod_globals, mod_globals);
+    #else
     mp_parse_compile_execute(lex, MP_PARSE_FILE_INPUT, mod_globals, mod_globals);
+    #endif
 }
 #endif
 
-#if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_MODULE_FROZEN_MPY
+#if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_MODULE_FROZEN_MPY || MICROPY_MODULE_FROZEN_BUNDLE || MICROPY_PERSISTENT_CODE_CACHE
 STATIC void do_execute_raw_code(mp_obj_t module_obj, mp_raw_code_t *raw_code) {
     #if MICROPY_PY___FILE__
     // TODO
@@ -193,6 +197,54 @@ STATIC void do_execute_raw_code(mp_obj_t module_obj, mp_raw_code_t *raw_code) {
 }
 #endif
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+// Execute the cached bytecode for fname if the port has an up-to-date copy,
+// otherwise compile it, hand the result to the cache and execute that.
+STATIC void do_load_cached(mp_obj_t module_obj, const char *fname) {
+    mp_raw_code_t *raw_code = mp_code_cache_load(fname);
+    if (raw_code != NULL) {
+        #if MICROPY_PY___FILE__
+        mp_store_attr(module_obj, MP_QSTR___file__, MP_OBJ_NEW_QSTR(qstr_from_str(fname)));
+        #endif
+        do_execute_raw_code(module_obj, raw_code);
+        return;
+    }
+
+    mp_lexer_t *lex = mp_lexer_new_from_file(fname);
+    if (lex == NULL) {
+        // let do_load_from_lexer raise the appropriate ImportError
+        do_load_from_lexer(module_obj, lex, fname);
+    }
+
+    qstr source_name = lex->source_name;
+    #if MICROPY_PY___FILE__
+    mp_store_attr(module_obj, MP_QSTR___file__, MP_OBJ_NEW_QSTR(source_name));
+    #endif
+
+    #if MICROPY_COMP_INCREMENTAL
+    // the whole file must be compiled at once to be cached, if that needs more
+    // memory than there is then fall back to going a statement at a time
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        raw_code = mp_compile_to_raw_code(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+        nlr_pop();
+    } else {
+        if (!mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(((mp_obj_base_t*)nlr.ret_val)->type), MP_OBJ_FROM_PTR(&mp_type_MemoryError))) {
+            nlr_jump(nlr.ret_val);
+        }
+        do_load_from_lexer(module_obj, mp_lexer_new_from_file(fname), fname);
+        return;
+    }
+    #else
+    mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+    raw_code = mp_compile_to_raw_code(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+    #endif
+    mp_code_cache_store(fname, raw_code);
+    do_execute_raw_code(module_obj, raw_code);
+}
+#endif
+
 STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     #if MICROPY_MODULE_FROZEN || MICROPY_PERSISTENT_CODE_LOAD || MICROPY_ENABLE_COMPILER
     char *file_str = vstr_null_terminated_str(file);
@@ -216,7 +268,7 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
 
     // If we support frozen mpy modules and we found a corresponding file (and
     // its data) in the list of frozen files, execute it.
-    #if MICROPY_MODULE_FROZEN_MPY
+    #if MICROPY_MODULE_FROZEN_MPY || MICROPY_MODULE_FROZEN_BUNDLE
     if (frozen_type == MP_FROZEN_MPY) {
         do_execute_raw_code(module_obj, modref);
         return;
@@ -233,6 +285,12 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     }
     #endif
 
+    // If we cache compiled scripts then reuse or refresh the cached bytecode.
+    #if MICROPY_PERSISTENT_CODE_CACHE
+    do_load_cached(module_obj, file_str);
+    return;
+    #endif
+
     // If we can compile scripts then load the file and compile and execute it.
     #if MICROPY_ENABLE_COMPILER
     {
@@ -80,6 +80,8 @@ typedef struct _compiler_t {
     uint8_t pass; // holds enum type pass_kind_t
     uint8_t func_arg_is_super; // used to compile special case of super() function call
     uint8_t have_star;
+    uint8_t have_child_scope; // in MP_PASS_SCOPE, a scope was made inside scope_cur
+    uint16_t cond_depth; // in MP_PASS_SCOPE, nesting of statements whose body may not run to the end
 
     // try to keep compiler clean from nlr
     mp_obj_t compile_error; // set to an exception object if there's an error
@@ -148,6 +150,7 @@ STATIC scope_t *scope_new_and_link(compiler_t *comp, scope_kind_t kind, mp_parse
     scope_t *scope = scope_new(kind, pn, comp->source_file, emit_options);
     scope->parent = comp->scope_cur;
     scope->next = NULL;
+    comp->have_child_scope = true;
     if (comp->scope_head == NULL) {
         comp->scope_head = scope;
     } else {
@@ -186,10 +189,43 @@ STATIC void compile_generic_all_nodes(compiler_t *comp, mp_parse_node_struct_t *
     }
 }
 
+#if NEED_METHOD_TABLE
+#define EMIT_IS_BYTECODE (comp->emit_method_table == &emit_bc_method_table)
+#else
+#define EMIT_IS_BYTECODE (true)
+#endif
+
+// A local that is assigned a str/bytes literal and extended with += is built
+// up in place by MP_BC_INPLACE_ADD_FAST.  All other loads of it must then use
+// MP_BC_LOAD_FAST_SHARE, so that it stops being modified once it is shared.
+STATIC id_info_t *str_builder_id(compiler_t *comp, qstr qst) {
+    if (!MICROPY_OPT_SUPERINSTRUCTIONS_DYNAMIC || !EMIT_IS_BYTECODE || !SCOPE_IS_FUNC_LIKE(comp->scope_cur->kind)) {
+        return NULL;
+    }
+    id_info_t *id = scope_find(comp->scope_cur, qst);
+    if (id == NULL || id->kind != ID_INFO_KIND_LOCAL
+        || (id->flags & (ID_FLAG_IS_STR_BUILDER | ID_FLAG_IS_PARAM)) != ID_FLAG_IS_STR_BUILDER) {
+        return NULL;
+    }
+    return id;
+}
+
+STATIC void str_builder_set_flag(compiler_t *comp, qstr qst, uint8_t flag) {
+    id_info_t *id = scope_find(comp->scope_cur, qst);
+    if (id != NULL) {
+        id->flags |= flag;
+    }
+}
+
 STATIC void compile_load_id(compiler_t *comp, qstr qst) {
     if (comp->pass == MP_PASS_SCOPE) {
         mp_emit_common_get_id_for_load(comp->scope_cur, qst);
     } else {
+        id_info_t *id = str_builder_id(comp, qst);
+        if (id != NULL) {
+            mp_emit_bc_load_fast_share(comp->emit, id->local_num);
+            return;
+        }
         #if NEED_METHOD_TABLE
         mp_emit_common_id_op(comp->emit, &comp->emit_method_table->load_id, comp->scope_cur, qst);
         #else
@@ -198,9 +234,40 @@ STATIC void compile_load_id(compiler_t *comp, qstr qst) {
     }
 }
 
+// Declare qst as bound or unbound by the current scope, in MP_PASS_SCOPE.  A
+// variable bound exactly once, not in a loop and before any closure over it
+// may have been made, can be closed over by value, see scope_compute_things.
+STATIC void compile_declare_modification(compiler_t *comp, qstr qst) {
+    mp_emit_common_get_id_for_modification(comp->scope_cur, qst);
+    #if MICROPY_COMP_CLOSURE_BY_VALUE
+    id_info_t *id = scope_find(comp->scope_cur, qst);
+    if (id->kind == ID_INFO_KIND_FREE) {
+        // rebinding a nonlocal, so mark the variable where it lives
+        for (scope_t *s = comp->scope_cur->parent; s != NULL; s = s->parent) {
+            id_info_t *id2 = scope_find(s, qst);
+            if (id2 != NULL && id2->kind == ID_INFO_KIND_CELL) {
+                id2->flags |= ID_FLAG_IS_REBOUND;
+                break;
+            }
+        }
+    }
+    // labels start at 1 so break_label is non-zero only in a loop, and
+    // everything a comprehension binds is in its loop
+    bool in_loop = comp->break_label != 0
+        || (comp->scope_cur->kind >= SCOPE_LIST_COMP && comp->scope_cur->kind <= SCOPE_GEN_EXPR);
+    // a binding in an if, try or with body may not happen, and then the
+    // variable must stay unbound until the closure is called
+    if ((id->flags & (ID_FLAG_IS_PARAM | ID_FLAG_IS_ASSIGNED)) || in_loop || comp->cond_depth != 0
+        || comp->have_child_scope) {
+        id->flags |= ID_FLAG_IS_REBOUND;
+    }
+    id->flags |= ID_FLAG_IS_ASSIGNED;
+    #endif
+}
+
 STATIC void compile_store_id(compiler_t *comp, qstr qst) {
     if (comp->pass == MP_PASS_SCOPE) {
-        mp_emit_common_get_id_for_modification(comp->scope_cur, qst);
+        compile_declare_modification(comp, qst);
     } else {
         #if NEED_METHOD_TABLE
         mp_emit_common_id_op(comp->emit, &comp->emit_method_table->store_id, comp->scope_cur, qst);
@@ -212,7 +279,7 @@ STATIC void compile_store_id(compiler_t *comp, qstr qst) {
 
 STATIC void compile_delete_id(compiler_t *comp, qstr qst) {
     if (comp->pass == MP_PASS_SCOPE) {
-        mp_emit_common_get_id_for_modification(comp->scope_cur, qst);
+        compile_declare_modification(comp, qst);
     } else {
         #if NEED_METHOD_TABLE
         mp_emit_common_id_op(comp->emit, &comp->emit_method_table->delete_id, comp->scope_cur, qst);
@@ -768,6 +835,14 @@ STATIC bool compile_built_in_decorator(compiler_t *comp, int name_len, mp_parse_
         compile_syntax_error(comp, name_nodes[1], "invalid micropython decorator");
     }
 
+    #if MICROPY_EMIT_NATIVE && MICROPY_DYNAMIC_COMPILER
+    if (*emit_options == MP_EMIT_OPT_NATIVE_PYTHON || *emit_options == MP_EMIT_OPT_VIPER) {
+        if (mp_dynamic_compiler.native_arch == MP_NATIVE_ARCH_NONE) {
+            compile_syntax_error(comp, name_nodes[1], "invalid arch");
+        }
+    }
+    #endif
+
     return true;
 }
 
@@ -1394,10 +1469,64 @@ STATIC void compile_for_stmt_optimised_range(compiler_t *comp, mp_parse_node_t p
     }
 }
 
+// This function compiles a for-loop over range(<start>, <end>, <step>) using
+// the for_range emit method, which keeps the next value, <end> and <step> on
+// the stack and counts in place while they are small ints.  Any <step> is
+// allowed; the VM or runtime checks its sign and that it's non-zero.
+//
+// The stack during the for-loop contains the 3 values, and they are left there
+// when the loop finishes (so no for_iter_end).
+STATIC void compile_for_stmt_range(compiler_t *comp, mp_parse_node_t pn_var, mp_parse_node_t pn_start, mp_parse_node_t pn_end, mp_parse_node_t pn_step, mp_parse_node_t pn_body, mp_parse_node_t pn_else) {
+    START_BREAK_CONTINUE_BLOCK
+
+    uint end_label = comp_next_label(comp);
+
+    compile_node(comp, pn_start);
+    compile_node(comp, pn_end);
+    compile_node(comp, pn_step);
+
+    EMIT_ARG(label_assign, continue_label);
+    EMIT_ARG(for_range, end_label);
+    c_assign(comp, pn_var, ASSIGN_STORE);
+    compile_node(comp, pn_body);
+    if (!EMIT(last_emit_was_return_value)) {
+        EMIT_ARG(jump, continue_label);
+    }
+    EMIT_ARG(label_assign, end_label);
+
+    // break/continue apply to outer loop (if any) in the else block
+    END_BREAK_CONTINUE_BLOCK
+
+    compile_node(comp, pn_else);
+
+    EMIT_ARG(label_assign, break_label);
+
+    EMIT(pop_top);
+    EMIT(pop_top);
+    EMIT(pop_top);
+}
+
+// Whether for-loops over range can use the for_range emit method: it needs
+// MP_BC_FOR_RANGE in bytecode, and viper does better with the explicitly
+// incremented variable of compile_for_stmt_optimised_range.  This depends only
+// on the scope, not the emitter, so that all passes agree on the labels used.
+STATIC bool compile_for_range_supported(compiler_t *comp) {
+    #if MICROPY_EMIT_NATIVE
+    if (comp->scope_cur->emit_options == MP_EMIT_OPT_VIPER) {
+        return false;
+    }
+    if (comp->scope_cur->emit_options == MP_EMIT_OPT_NATIVE_PYTHON) {
+        return true;
+    }
+    #endif
+    return MICROPY_OPT_SUPERINSTRUCTIONS_DYNAMIC;
+}
+
 STATIC void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
-    // this bit optimises: for <x> in range(...), turning it into an explicitly incremented variable
-    // this is actually slower, but uses no heap memory
-    // for viper it will be much, much faster
+    // this bit optimises: for <x> in range(...), turning it into a loop that
+    // uses no heap memory: either a for_range loop or, failing that, an
+    // explicitly incremented variable (slower in bytecode, but for viper it
+    // will be much, much faster)
     if (/*comp->scope_cur->emit_options == MP_EMIT_OPT_VIPER &&*/ MP_PARSE_NODE_IS_ID(pns->nodes[0]) && MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], PN_atom_expr_normal)) {
         mp_parse_node_struct_t *pns_it = (mp_parse_node_struct_t*)pns->nodes[1];
         if (MP_PARSE_NODE_IS_ID(pns_it->nodes[0])
@@ -1410,6 +1539,7 @@ STATIC void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
             mp_parse_node_t pn_range_end;
             mp_parse_node_t pn_range_step;
             bool optimize = false;
+            bool for_range = compile_for_range_supported(comp);
             if (1 <= n_args && n_args <= 3) {
                 optimize = true;
                 if (n_args == 1) {
@@ -1424,8 +1554,9 @@ STATIC void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
                     pn_range_start = args[0];
                     pn_range_end = args[1];
                     pn_range_step = args[2];
-                    // We need to know sign of step. This is possible only if it's constant
-                    if (!MP_PARSE_NODE_IS_SMALL_INT(pn_range_step)) {
+                    // We need to know sign of step. This is possible only if it's constant,
+                    // unless for_range checks it at run time
+                    if (!for_range && !MP_PARSE_NODE_IS_SMALL_INT(pn_range_step)) {
                         optimize = false;
                     }
                 }
@@ -1442,6 +1573,16 @@ STATIC void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
                         optimize = false;
                     }
                 }
+                if (optimize && MP_PARSE_NODE_IS_STRUCT(pn_range_step)) {
+                    int k = MP_PARSE_NODE_STRUCT_KIND((mp_parse_node_struct_t*)pn_range_step);
+                    if (k == PN_arglist_star || k == PN_arglist_dbl_star || k == PN_argument) {
+                        optimize = false;
+                    }
+                }
+            }
+            if (optimize && for_range) {
+                compile_for_stmt_range(comp, pns->nodes[0], pn_range_start, pn_range_end, pn_range_step, pns->nodes[2], pns->nodes[3]);
+                return;
             }
             if (optimize) {
                 compile_for_stmt_optimised_range(comp, pns->nodes[0], pn_range_start, pn_range_end, pn_range_step, pns->nodes[2], pns->nodes[3]);
@@ -1866,6 +2007,22 @@ STATIC void compile_expr_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
         mp_parse_node_struct_t *pns1 = (mp_parse_node_struct_t*)pns->nodes[1];
         int kind = MP_PARSE_NODE_STRUCT_KIND(pns1);
         if (kind == PN_expr_stmt_augassign) {
+            if (MP_PARSE_NODE_IS_ID(pns->nodes[0])
+                && MP_PARSE_NODE_IS_TOKEN_KIND(pns1->nodes[0], MP_TOKEN_DEL_PLUS_EQUAL)) {
+                qstr qst = MP_PARSE_NODE_LEAF_ARG(pns->nodes[0]);
+                if (comp->pass == MP_PASS_SCOPE) {
+                    compile_declare_modification(comp, qst);
+                    str_builder_set_flag(comp, qst, ID_FLAG_IS_AUG_ADDED);
+                } else {
+                    id_info_t *id = str_builder_id(comp, qst);
+                    if (id != NULL) {
+                        // the local is loaded by the opcode itself, after the rhs
+                        compile_node(comp, pns1->nodes[1]); // rhs
+                        mp_emit_bc_inplace_add_fast(comp->emit, id->local_num);
+                        return;
+                    }
+                }
+            }
             c_assign(comp, pns->nodes[0], ASSIGN_AUG_LOAD); // lhs load for aug assign
             compile_node(comp, pns1->nodes[1]); // rhs
             assert(MP_PARSE_NODE_IS_TOKEN(pns1->nodes[0]));
@@ -1946,6 +2103,13 @@ STATIC void compile_expr_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
                 no_optimisation:
                 compile_node(comp, pns->nodes[1]); // rhs
                 c_assign(comp, pns->nodes[0], ASSIGN_STORE); // lhs store
+                if (comp->pass == MP_PASS_SCOPE && MP_PARSE_NODE_IS_ID(pns->nodes[0])
+                    && (MP_PARSE_NODE_LEAF_KIND(pns->nodes[1]) == MP_PARSE_NODE_STRING
+                        || MP_PARSE_NODE_LEAF_KIND(pns->nodes[1]) == MP_PARSE_NODE_BYTES
+                        || MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], PN_string)
+                        || MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], PN_bytes))) {
+                    str_builder_set_flag(comp, MP_PARSE_NODE_LEAF_ARG(pns->nodes[0]), ID_FLAG_IS_STR_ASSIGNED);
+                }
             }
         }
     } else {
@@ -1966,6 +2130,15 @@ STATIC void compile_test_if_expr(compiler_t *comp, mp_parse_node_struct_t *pns)
     assert(MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], PN_test_if_else));
     mp_parse_node_struct_t *pns_test_if_else = (mp_parse_node_struct_t*)pns->nodes[1];
 
+    // optimisation: only compile the value that is chosen by a constant condition
+    if (node_is_const_true(pns_test_if_else->nodes[0])) {
+        compile_node(comp, pns->nodes[0]);
+        return;
+    } else if (node_is_const_false(pns_test_if_else->nodes[0])) {
+        compile_node(comp, pns_test_if_else->nodes[1]);
+        return;
+    }
+
     uint l_fail = comp_next_label(comp);
     uint l_end = comp_next_label(comp);
     c_if_cond(comp, pns_test_if_else->nodes[0], false, l_fail); // condition
@@ -2724,6 +2897,19 @@ STATIC void compile_node(compiler_t *comp, mp_parse_node_t pn) {
         EMIT_ARG(set_source_line, pns->source_line);
         compile_function_t f = compile_function[MP_PARSE_NODE_STRUCT_KIND(pns)];
         assert(f != NULL);
+        #if MICROPY_COMP_CLOSURE_BY_VALUE
+        switch (MP_PARSE_NODE_STRUCT_KIND(pns)) {
+            case PN_if_stmt: case PN_while_stmt: case PN_for_stmt:
+            case PN_try_stmt: case PN_with_stmt:
+            #if MICROPY_PY_ASYNC_AWAIT
+            case PN_async_stmt:
+            #endif
+                comp->cond_depth += 1;
+                f(comp, pns);
+                comp->cond_depth -= 1;
+                return;
+        }
+        #endif
         f(comp, pns);
     }
 }
@@ -2852,6 +3038,54 @@ STATIC void compile_scope_func_annotations(compiler_t *comp, mp_parse_node_t pn)
 }
 #endif // MICROPY_EMIT_NATIVE
 
+// Largest number of entries a dict comprehension is presized for.
+#define COMP_DICT_HINT_MAX (1024)
+
+// Return the number of entries a dict comprehension will have if it's of the
+// form {k: v for x in range(...)} with constant range arguments, or else 0.
+// The result is only used to presize the dict so it needn't be exact, eg if
+// range has been redefined.
+STATIC mp_uint_t compile_dict_comp_hint(mp_parse_node_struct_t *pns_comp_for) {
+    if (!MP_PARSE_NODE_IS_NULL(pns_comp_for->nodes[2])
+        || !MP_PARSE_NODE_IS_STRUCT_KIND(pns_comp_for->nodes[1], PN_atom_expr_normal)) {
+        return 0;
+    }
+    mp_parse_node_struct_t *pns_it = (mp_parse_node_struct_t*)pns_comp_for->nodes[1];
+    if (!MP_PARSE_NODE_IS_ID(pns_it->nodes[0])
+        || MP_PARSE_NODE_LEAF_ARG(pns_it->nodes[0]) != MP_QSTR_range
+        || !MP_PARSE_NODE_IS_STRUCT_KIND(pns_it->nodes[1], PN_trailer_paren)) {
+        return 0;
+    }
+    mp_parse_node_t pn_range_args = ((mp_parse_node_struct_t*)pns_it->nodes[1])->nodes[0];
+    mp_parse_node_t *args;
+    int n_args = mp_parse_node_extract_list(&pn_range_args, PN_arglist, &args);
+    if (n_args < 1 || n_args > 3) {
+        return 0;
+    }
+    for (int i = 0; i < n_args; i++) {
+        if (!MP_PARSE_NODE_IS_SMALL_INT(args[i])) {
+            return 0;
+        }
+    }
+    mp_int_t start = 0, stop, step = 1;
+    if (n_args == 1) {
+        stop = MP_PARSE_NODE_LEAF_SMALL_INT(args[0]);
+    } else {
+        start = MP_PARSE_NODE_LEAF_SMALL_INT(args[0]);
+        stop = MP_PARSE_NODE_LEAF_SMALL_INT(args[1]);
+        if (n_args == 3) {
+            step = MP_PARSE_NODE_LEAF_SMALL_INT(args[2]);
+        }
+    }
+    mp_int_t len = 0;
+    if (step > 0 && stop > start) {
+        len = (stop - start - 1) / step + 1;
+    } else if (step < 0 && start > stop) {
+        len = (start - stop - 1) / -step + 1;
+    }
+    return MIN(len, COMP_DICT_HINT_MAX);
+}
+
 STATIC void compile_scope_comp_iter(compiler_t *comp, mp_parse_node_struct_t *pns_comp_for, mp_parse_node_t pn_inner_expr, int for_depth) {
     uint l_top = comp_next_label(comp);
     uint l_end = comp_next_label(comp);
@@ -2938,6 +3172,8 @@ STATIC void compile_scope(compiler_t *comp, scope_t *scope, pass_kind_t pass) {
     comp->pass = pass;
     comp->scope_cur = scope;
     comp->next_label = 1;
+    comp->have_child_scope = false;
+    comp->cond_depth = 0;
     EMIT_ARG(start_pass, pass, scope);
 
     if (comp->pass == MP_PASS_SCOPE) {
@@ -3044,7 +3280,7 @@ STATIC void compile_scope(compiler_t *comp, scope_t *scope, pass_kind_t pass) {
         if (scope->kind == SCOPE_LIST_COMP) {
             EMIT_ARG(build_list, 0);
         } else if (scope->kind == SCOPE_DICT_COMP) {
-            EMIT_ARG(build_map, 0);
+            EMIT_ARG(build_map, compile_dict_comp_hint(pns_comp_for));
         #if MICROPY_PY_BUILTINS_SET
         } else if (scope->kind == SCOPE_SET_COMP) {
             EMIT_ARG(build_set, 0);
@@ -3259,12 +3495,36 @@ STATIC void scope_compute_things(scope_t *scope) {
                     id_info_t temp = *id_param; *id_param = *id; *id = temp;
                 }
                 break;
-            } else if (id_param == NULL && id->flags == ID_FLAG_IS_PARAM) {
+            } else if (id_param == NULL && (id->flags & (ID_FLAG_IS_PARAM | ID_FLAG_IS_STAR_PARAM | ID_FLAG_IS_DBL_STAR_PARAM)) == ID_FLAG_IS_PARAM) {
                 id_param = id;
             }
         }
     }
 
+    #if MICROPY_COMP_CLOSURE_BY_VALUE
+    // a variable that can't change once a closure over it is made is passed
+    // to the closure by value, and then needs no cell; parent scopes come
+    // first so their variables are done before those of their children
+    for (int i = 0; i < scope->id_info_len; i++) {
+        id_info_t *id = &scope->id_info[i];
+        if (id->kind == ID_INFO_KIND_CELL) {
+            if (SCOPE_IS_FUNC_LIKE(scope->kind)
+                && (id->flags & (ID_FLAG_IS_PARAM | ID_FLAG_IS_ASSIGNED))
+                && !(id->flags & ID_FLAG_IS_REBOUND)) {
+                id->flags |= ID_FLAG_IS_BY_VALUE;
+            }
+        } else if (id->kind == ID_INFO_KIND_FREE) {
+            for (scope_t *s = scope->parent; s != NULL; s = s->parent) {
+                id_info_t *id2 = scope_find(s, id->qst);
+                if (id2 != NULL && id2->kind == ID_INFO_KIND_CELL) {
+                    id->flags |= id2->flags & ID_FLAG_IS_BY_VALUE;
+                    break;
+                }
+            }
+        }
+    }
+    #endif
+
     // in functions, turn implicit globals into explicit globals
     // compute the index of each local
     scope->num_locals = 0;
@@ -3327,10 +3587,81 @@ STATIC void scope_compute_things(scope_t *scope) {
     }
 }
 
+#if MICROPY_EMIT_NATIVE
+#if MICROPY_DYNAMIC_COMPILER
+// The emitter is chosen at runtime by the architecture to generate code for.
+typedef struct _native_emitter_t {
+    emit_t *(*new)(mp_obj_t *error_slot, mp_uint_t max_num_labels);
+    void (*free)(emit_t *emit);
+    const emit_method_table_t *method_table;
+} native_emitter_t;
+
+STATIC const native_emitter_t native_emitter_table[] = {
+    #if MICROPY_EMIT_X86
+    [MP_NATIVE_ARCH_X86] = {emit_native_x86_new, emit_native_x86_free, &emit_native_x86_method_table},
+    #endif
+    #if MICROPY_EMIT_X64
+    [MP_NATIVE_ARCH_X64] = {emit_native_x64_new, emit_native_x64_free, &emit_native_x64_method_table},
+    #endif
+    #if MICROPY_EMIT_ARM
+    [MP_NATIVE_ARCH_ARMV6] = {emit_native_arm_new, emit_native_arm_free, &emit_native_arm_method_table},
+    #endif
+    #if MICROPY_EMIT_THUMB
+    [MP_NATIVE_ARCH_ARMV7M] = {emit_native_thumb_new, emit_native_thumb_free, &emit_native_thumb_method_table},
+    #endif
+};
+
+#define NATIVE_EMITTER(f) (native_emitter_table[mp_dynamic_compiler.native_arch].f)
+#define NATIVE_EMITTER_TABLE (native_emitter_table[mp_dynamic_compiler.native_arch].method_table)
+#else
+#if MICROPY_EMIT_X64
+#define NATIVE_EMITTER(f) emit_native_x64_##f
+#elif MICROPY_EMIT_X86
+#define NATIVE_EMITTER(f) emit_native_x86_##f
+#elif MICROPY_EMIT_THUMB
+#define NATIVE_EMITTER(f) emit_native_thumb_##f
+#elif MICROPY_EMIT_ARM
+#define NATIVE_EMITTER(f) emit_native_arm_##f
+#endif
+#define NATIVE_EMITTER_TABLE (&NATIVE_EMITTER(method_table))
+#endif
+#endif
+
+#if MICROPY_EMIT_NATIVE_TIERED
+
+// What is needed to run the last compiler passes again on one of the scopes
+// of an already compiled parse tree.  The scopes are referenced from the parse
+// nodes so the parse tree has to be kept along with them.
+typedef struct _mp_native_tier_unit_t {
+    struct _mp_native_tier_unit_t *next;
+    struct _mp_parse_chunk_t *chunk;
+    scope_t *scope_head;
+    qstr source_file;
+    uint16_t max_num_labels;
+    uint8_t is_repl;
+    uint8_t optimise_value;
+} mp_native_tier_unit_t;
+
+STATIC void native_tier_retain(compiler_t *comp, mp_parse_tree_t *parse_tree, uint max_num_labels) {
+    mp_native_tier_unit_t *unit = m_new_obj(mp_native_tier_unit_t);
+    unit->chunk = parse_tree->chunk;
+    unit->scope_head = comp->scope_head;
+    unit->source_file = comp->source_file;
+    unit->max_num_labels = max_num_labels;
+    unit->is_repl = comp->is_repl;
+    unit->optimise_value = MP_STATE_VM(mp_optimise_value);
+    unit->next = MP_STATE_VM(native_tier_units);
+    MP_STATE_VM(native_tier_units) = unit;
+}
+
+#endif // MICROPY_EMIT_NATIVE_TIERED
+
 #if !MICROPY_PERSISTENT_CODE_SAVE
 STATIC
 #endif
 mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl) {
+    MP_CYCLES_BEGIN(COMPILE);
+
     // put compiler state on the stack, it's relatively small
     compiler_t comp_state = {0};
     compiler_t *comp = &comp_state;
@@ -3409,27 +3740,10 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
 #if MICROPY_EMIT_NATIVE
                 case MP_EMIT_OPT_NATIVE_PYTHON:
                 case MP_EMIT_OPT_VIPER:
-#if MICROPY_EMIT_X64
-                    if (emit_native == NULL) {
-                        emit_native = emit_native_x64_new(&comp->compile_error, max_num_labels);
-                    }
-                    comp->emit_method_table = &emit_native_x64_method_table;
-#elif MICROPY_EMIT_X86
                     if (emit_native == NULL) {
-                        emit_native = emit_native_x86_new(&comp->compile_error, max_num_labels);
+                        emit_native = NATIVE_EMITTER(new)(&comp->compile_error, max_num_labels);
                     }
-                    comp->emit_method_table = &emit_native_x86_method_table;
-#elif MICROPY_EMIT_THUMB
-                    if (emit_native == NULL) {
-                        emit_native = emit_native_thumb_new(&comp->compile_error, max_num_labels);
-                    }
-                    comp->emit_method_table = &emit_native_thumb_method_table;
-#elif MICROPY_EMIT_ARM
-                    if (emit_native == NULL) {
-                        emit_native = emit_native_arm_new(&comp->compile_error, max_num_labels);
-                    }
-                    comp->emit_method_table = &emit_native_arm_method_table;
-#endif
+                    comp->emit_method_table = NATIVE_EMITTER_TABLE;
                     comp->emit = emit_native;
                     EMIT_ARG(set_native_type, MP_EMIT_NATIVE_TYPE_ENABLE, s->emit_options == MP_EMIT_OPT_VIPER, 0);
                     break;
@@ -3443,6 +3757,14 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
                     break;
             }
 
+            #if MICROPY_EMIT_BC_ONE_PASS
+            if (comp->emit == emit_bc) {
+                // the bytecode emitter works out the stack and code size as it goes
+                compile_scope(comp, s, MP_PASS_EMIT);
+                continue;
+            }
+            #endif
+
             // need a pass to compute stack size
             compile_scope(comp, s, MP_PASS_STACK_SIZE);
 
@@ -3472,15 +3794,7 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
     emit_bc_free(emit_bc);
 #if MICROPY_EMIT_NATIVE
     if (emit_native != NULL) {
-#if MICROPY_EMIT_X64
-        emit_native_x64_free(emit_native);
-#elif MICROPY_EMIT_X86
-        emit_native_x86_free(emit_native);
-#elif MICROPY_EMIT_THUMB
-        emit_native_thumb_free(emit_native);
-#elif MICROPY_EMIT_ARM
-        emit_native_arm_free(emit_native);
-#endif
+        NATIVE_EMITTER(free)(emit_native);
     }
 #endif
 #if MICROPY_EMIT_INLINE_THUMB
@@ -3489,6 +3803,15 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
     }
 #endif
 
+    #if MICROPY_EMIT_NATIVE_TIERED
+    if (comp->compile_error == MP_OBJ_NULL && MP_STATE_VM(native_tier_threshold) != 0) {
+        // keep the parse tree and scopes so hot functions can be recompiled
+        native_tier_retain(comp, parse_tree, max_num_labels);
+        MP_CYCLES_END(COMPILE);
+        return module_scope->raw_code;
+    }
+    #endif
+
     // free the parse tree
     mp_parse_tree_clear(parse_tree);
 
@@ -3499,6 +3822,7 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
         scope_free(s);
         s = next;
     }
+    MP_CYCLES_END(COMPILE);
 
     if (comp->compile_error != MP_OBJ_NULL) {
         nlr_raise(comp->compile_error);
@@ -3513,4 +3837,75 @@ mp_obj_t mp_compile(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt
     return mp_make_function_from_raw_code(rc, MP_OBJ_NULL, MP_OBJ_NULL);
 }
 
+#if MICROPY_EMIT_NATIVE_TIERED
+// find the retained scope, and its unit, that the bytecode was compiled from
+STATIC scope_t *native_tier_find_scope(const byte *bytecode, mp_native_tier_unit_t **unit_out) {
+    for (mp_native_tier_unit_t *unit = MP_STATE_VM(native_tier_units); unit != NULL; unit = unit->next) {
+        for (scope_t *s = unit->scope_head; s != NULL; s = s->next) {
+            if (s->raw_code->kind == MP_CODE_BYTECODE && s->raw_code->data.u_byte.bytecode == bytecode) {
+                *unit_out = unit;
+                return s;
+            }
+        }
+    }
+    return NULL;
+}
+
+mp_raw_code_t *mp_compile_native_tier(const byte *bytecode) {
+    mp_native_tier_unit_t *unit;
+    scope_t *s = native_tier_find_scope(bytecode, &unit);
+    if (s == NULL
+        || s->kind == SCOPE_MODULE || s->kind == SCOPE_CLASS
+        || (s->scope_flags & MP_SCOPE_FLAG_GENERATOR) != 0
+        || (s->emit_options != MP_EMIT_OPT_NONE && s->emit_options != MP_EMIT_OPT_BYTECODE)
+        || (s->emit_options == MP_EMIT_OPT_BYTECODE && s->exc_stack_size != 0)
+        || unit->optimise_value != MP_STATE_VM(mp_optimise_value)) {
+        // a generator is called through its wrapper, so is never promoted; the
+        // scope pass depended on the optimisation level, and only reserved the
+        // extra label of a with block that the native emitter needs if the
+        // scope wasn't forced to bytecode
+        return NULL;
+    }
+
+    compiler_t comp_state = {0};
+    compiler_t *comp = &comp_state;
+    comp->source_file = unit->source_file;
+    comp->is_repl = unit->is_repl;
+    comp->scope_head = unit->scope_head;
+
+    // the native code is attached to a new raw code; the bytecode one is still
+    // needed by the enclosing scope if it's compiled again
+    mp_raw_code_t *bc_raw_code = s->raw_code;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        s->raw_code = mp_emit_glue_new_raw_code();
+        comp->emit = NATIVE_EMITTER(new)(&comp->compile_error, unit->max_num_labels);
+        comp->emit_method_table = NATIVE_EMITTER_TABLE;
+        EMIT_ARG(set_native_type, MP_EMIT_NATIVE_TYPE_ENABLE, false, 0);
+        compile_scope(comp, s, MP_PASS_STACK_SIZE);
+        if (comp->compile_error == MP_OBJ_NULL) {
+            compile_scope(comp, s, MP_PASS_CODE_SIZE);
+        }
+        if (comp->compile_error == MP_OBJ_NULL) {
+            compile_scope(comp, s, MP_PASS_EMIT);
+        }
+        nlr_pop();
+    } else {
+        // eg out of memory
+        comp->compile_error = MP_OBJ_FROM_PTR(nlr.ret_val);
+    }
+    if (comp->emit != NULL) {
+        NATIVE_EMITTER(free)(comp->emit);
+    }
+    mp_raw_code_t *rc = s->raw_code;
+    s->raw_code = bc_raw_code;
+
+    // on any error the function just keeps running as bytecode
+    if (comp->compile_error != MP_OBJ_NULL || rc->kind != MP_CODE_NATIVE_PY) {
+        return NULL;
+    }
+    return rc;
+}
+#endif
+
 #endif // MICROPY_ENABLE_COMPILER
@@ -48,7 +48,19 @@ mp_obj_t mp_compile(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt
 mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl);
 #endif
 
+#if MICROPY_EMIT_NATIVE_TIERED
+// compile the function with the given bytecode again using the native emitter,
+// returning NULL if that's not possible
+mp_raw_code_t *mp_compile_native_tier(const byte *bytecode);
+#endif
+
 // this is implemented in runtime.c
 mp_obj_t mp_parse_compile_execute(mp_lexer_t *lex, mp_parse_input_kind_t parse_input_kind, mp_obj_dict_t *globals, mp_obj_dict_t *locals);
 
+#if MICROPY_COMP_INCREMENTAL
+// this is implemented in runtime.c
+// executes each top-level statement of the file as soon as it is compiled
+void mp_parse_compile_execute_stmts(mp_lexer_t *lex, mp_obj_dict_t *globals, mp_obj_dict_t *locals);
+#endif
+
 #endif // __MICROPY_INCLUDED_PY_COMPILE_H__
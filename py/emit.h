@@ -113,6 +113,7 @@ typedef struct _emit_method_table_t {
     void (*get_iter)(emit_t *emit);
     void (*for_iter)(emit_t *emit, mp_uint_t label);
     void (*for_iter_end)(emit_t *emit);
+    void (*for_range)(emit_t *emit, mp_uint_t label);
     void (*pop_block)(emit_t *emit);
     void (*pop_except)(emit_t *emit);
     void (*unary_op)(emit_t *emit, mp_unary_op_t op);
@@ -196,6 +197,9 @@ void mp_emit_bc_delete_deref(emit_t *emit, qstr qst, mp_uint_t local_num);
 void mp_emit_bc_delete_name(emit_t *emit, qstr qst);
 void mp_emit_bc_delete_global(emit_t *emit, qstr qst);
 
+void mp_emit_bc_load_fast_share(emit_t *emit, mp_uint_t local_num);
+void mp_emit_bc_inplace_add_fast(emit_t *emit, mp_uint_t local_num);
+
 void mp_emit_bc_label_assign(emit_t *emit, mp_uint_t l);
 void mp_emit_bc_import_name(emit_t *emit, qstr qst);
 void mp_emit_bc_import_from(emit_t *emit, qstr qst);
@@ -232,6 +236,7 @@ void mp_emit_bc_end_finally(emit_t *emit);
 void mp_emit_bc_get_iter(emit_t *emit);
 void mp_emit_bc_for_iter(emit_t *emit, mp_uint_t label);
 void mp_emit_bc_for_iter_end(emit_t *emit);
+void mp_emit_bc_for_range(emit_t *emit, mp_uint_t label);
 void mp_emit_bc_pop_block(emit_t *emit);
 void mp_emit_bc_pop_except(emit_t *emit);
 void mp_emit_bc_unary_op(emit_t *emit, mp_unary_op_t op);
@@ -39,6 +39,21 @@
 #define BYTES_FOR_INT ((BYTES_PER_WORD * 8 + 6) / 7)
 #define DUMMY_DATA_SIZE (BYTES_FOR_INT)
 
+#if MICROPY_EMIT_BC_ONE_PASS
+// A reference in the bytecode that can only be written at the end of the pass
+typedef enum {
+    EMIT_BC_FIXUP_SIGNED_LABEL,
+    EMIT_BC_FIXUP_UNSIGNED_LABEL,
+    EMIT_BC_FIXUP_RAW_CODE,
+} emit_bc_fixup_kind_t;
+
+typedef struct _emit_bc_fixup_t {
+    size_t offset; // of the opcode
+    mp_uint_t arg; // the label, or the raw code
+    emit_bc_fixup_kind_t kind;
+} emit_bc_fixup_t;
+#endif
+
 struct _emit_t {
     // Accessed as mp_obj_t, so must be aligned as such, and we rely on the
     // memory allocator returning a suitably aligned pointer.
@@ -64,6 +79,26 @@ struct _emit_t {
     size_t bytecode_size;
     byte *code_base; // stores both byte code and code info
 
+    #if MICROPY_EMIT_BC_ONE_PASS
+    // Scratch buffers reused for each scope.  While emitting, the code info,
+    // bytecode and const table go in these and are copied to code_base and
+    // const_table at the end of the pass.
+    byte *code_info_buf;
+    size_t code_info_alloc;
+    byte *bytecode_buf;
+    size_t bytecode_alloc;
+    mp_uint_t *const_table_buf;
+    size_t const_table_alloc;
+    emit_bc_fixup_t *fixups;
+    size_t fixups_alloc;
+    size_t num_fixups;
+    #endif
+
+    // the last opcode written if it can start a superinstruction, else 0
+    byte last_op;
+    size_t last_op_offset;
+    mp_int_t last_op_arg;
+
     #if MICROPY_PERSISTENT_CODE
     uint16_t ct_cur_obj;
     uint16_t ct_num_obj;
@@ -83,6 +118,12 @@ void emit_bc_set_max_num_labels(emit_t *emit, mp_uint_t max_num_labels) {
 }
 
 void emit_bc_free(emit_t *emit) {
+    #if MICROPY_EMIT_BC_ONE_PASS
+    m_del(byte, emit->code_info_buf, emit->code_info_alloc);
+    m_del(byte, emit->bytecode_buf, emit->bytecode_alloc);
+    m_del(mp_uint_t, emit->const_table_buf, emit->const_table_alloc);
+    m_del(emit_bc_fixup_t, emit->fixups, emit->fixups_alloc);
+    #endif
     m_del(mp_uint_t, emit->label_offsets, emit->max_num_labels);
     m_del_obj(emit_t, emit);
 }
@@ -112,8 +153,17 @@ STATIC byte *emit_get_cur_to_write_code_info(emit_t *emit, int num_bytes_to_writ
         emit->code_info_offset += num_bytes_to_write;
         return emit->dummy_data;
     } else {
+        #if MICROPY_EMIT_BC_ONE_PASS
+        if (emit->code_info_offset + num_bytes_to_write > emit->code_info_alloc) {
+            size_t new_alloc = emit->code_info_alloc * 2 + num_bytes_to_write + 16;
+            emit->code_info_buf = m_renew(byte, emit->code_info_buf, emit->code_info_alloc, new_alloc);
+            emit->code_info_alloc = new_alloc;
+        }
+        byte *c = emit->code_info_buf + emit->code_info_offset;
+        #else
         assert(emit->code_info_offset + num_bytes_to_write <= emit->code_info_size);
         byte *c = emit->code_base + emit->code_info_offset;
+        #endif
         emit->code_info_offset += num_bytes_to_write;
         return c;
     }
@@ -167,11 +217,22 @@ STATIC void emit_write_code_info_bytes_lines(emit_t *emit, mp_uint_t bytes_to_sk
 STATIC byte *emit_get_cur_to_write_bytecode(emit_t *emit, int num_bytes_to_write) {
     //printf("emit %d\n", num_bytes_to_write);
     if (emit->pass < MP_PASS_EMIT) {
+        emit->last_op = 0;
         emit->bytecode_offset += num_bytes_to_write;
         return emit->dummy_data;
     } else {
+        #if MICROPY_EMIT_BC_ONE_PASS
+        if (emit->bytecode_offset + num_bytes_to_write > emit->bytecode_alloc) {
+            size_t new_alloc = emit->bytecode_alloc * 2 + num_bytes_to_write + 32;
+            emit->bytecode_buf = m_renew(byte, emit->bytecode_buf, emit->bytecode_alloc, new_alloc);
+            emit->bytecode_alloc = new_alloc;
+        }
+        byte *c = emit->bytecode_buf + emit->bytecode_offset;
+        #else
         assert(emit->bytecode_offset + num_bytes_to_write <= emit->bytecode_size);
         byte *c = emit->code_base + emit->code_info_size + emit->bytecode_offset;
+        #endif
+        emit->last_op = 0;
         emit->bytecode_offset += num_bytes_to_write;
         return c;
     }
@@ -215,15 +276,58 @@ STATIC void emit_write_bytecode_byte_int(emit_t *emit, byte b1, mp_int_t num) {
     *c = *p;
 }
 
+// Record that the opcode just written, which started at the given offset,
+// may be fused with the next one.  Anything written in between (including
+// line-number info and labels) clears this, so all passes fuse the same pairs.
+STATIC void emit_bc_set_last_op(emit_t *emit, size_t offset, byte op, mp_int_t arg) {
+    if (MICROPY_OPT_SUPERINSTRUCTIONS_DYNAMIC) {
+        emit->last_op = op;
+        emit->last_op_offset = offset;
+        emit->last_op_arg = arg;
+    }
+}
+
+// Remove the last opcode so it can be rewritten as part of a superinstruction.
+STATIC void emit_bc_rewind_last_op(emit_t *emit) {
+    emit->bytecode_offset = emit->last_op_offset;
+    emit->last_op = 0;
+}
+
 STATIC void emit_write_bytecode_byte_uint(emit_t *emit, byte b, mp_uint_t val) {
     emit_write_bytecode_byte(emit, b);
     emit_write_uint(emit, emit_get_cur_to_write_bytecode, val);
 }
 
+#if MICROPY_EMIT_BC_ONE_PASS
+STATIC void emit_bc_add_fixup(emit_t *emit, emit_bc_fixup_kind_t kind, mp_uint_t arg) {
+    if (emit->pass < MP_PASS_EMIT) {
+        return;
+    }
+    if (emit->num_fixups >= emit->fixups_alloc) {
+        size_t new_alloc = emit->fixups_alloc * 2 + 8;
+        emit->fixups = m_renew(emit_bc_fixup_t, emit->fixups, emit->fixups_alloc, new_alloc);
+        emit->fixups_alloc = new_alloc;
+    }
+    emit_bc_fixup_t *f = &emit->fixups[emit->num_fixups++];
+    f->offset = emit->bytecode_offset;
+    f->arg = arg;
+    f->kind = kind;
+}
+#endif
+
 #if MICROPY_PERSISTENT_CODE
 STATIC void emit_write_bytecode_byte_const(emit_t *emit, byte b, mp_uint_t n, mp_uint_t c) {
     if (emit->pass == MP_PASS_EMIT) {
+        #if MICROPY_EMIT_BC_ONE_PASS
+        if (n >= emit->const_table_alloc) {
+            size_t new_alloc = emit->const_table_alloc * 2 + 4;
+            emit->const_table_buf = m_renew(mp_uint_t, emit->const_table_buf, emit->const_table_alloc, new_alloc);
+            emit->const_table_alloc = new_alloc;
+        }
+        emit->const_table_buf[n] = c;
+        #else
         emit->const_table[n] = c;
+        #endif
     }
     emit_write_bytecode_byte_uint(emit, b, n);
 }
@@ -258,7 +362,14 @@ STATIC void emit_write_bytecode_byte_obj(emit_t *emit, byte b, mp_obj_t obj) {
 }
 
 STATIC void emit_write_bytecode_byte_raw_code(emit_t *emit, byte b, mp_raw_code_t *rc) {
-    #if MICROPY_PERSISTENT_CODE
+    #if MICROPY_PERSISTENT_CODE && MICROPY_EMIT_BC_ONE_PASS
+    // raw codes follow the objects in the const table and the number of those
+    // isn't known yet, so the index is a 2-byte uint filled in at the end
+    emit_bc_add_fixup(emit, EMIT_BC_FIXUP_RAW_CODE, (mp_uint_t)(uintptr_t)rc);
+    emit->ct_cur_raw_code++;
+    byte *c = emit_get_cur_to_write_bytecode(emit, 3);
+    c[0] = b;
+    #elif MICROPY_PERSISTENT_CODE
     emit_write_bytecode_byte_const(emit, b,
         emit->scope->num_pos_args + emit->scope->num_kwonly_args
         + emit->ct_num_obj + emit->ct_cur_raw_code++, (mp_uint_t)(uintptr_t)rc);
@@ -278,6 +389,12 @@ STATIC void emit_write_bytecode_byte_unsigned_label(emit_t *emit, byte b1, mp_ui
     mp_uint_t bytecode_offset;
     if (emit->pass < MP_PASS_EMIT) {
         bytecode_offset = 0;
+    #if MICROPY_EMIT_BC_ONE_PASS
+    } else if (emit->label_offsets[label] == (mp_uint_t)-1) {
+        // a forward jump
+        emit_bc_add_fixup(emit, EMIT_BC_FIXUP_UNSIGNED_LABEL, label);
+        bytecode_offset = 0;
+    #endif
     } else {
         bytecode_offset = emit->label_offsets[label] - emit->bytecode_offset - 3;
     }
@@ -292,6 +409,12 @@ STATIC void emit_write_bytecode_byte_signed_label(emit_t *emit, byte b1, mp_uint
     int bytecode_offset;
     if (emit->pass < MP_PASS_EMIT) {
         bytecode_offset = 0;
+    #if MICROPY_EMIT_BC_ONE_PASS
+    } else if (emit->label_offsets[label] == (mp_uint_t)-1) {
+        // a forward jump
+        emit_bc_add_fixup(emit, EMIT_BC_FIXUP_SIGNED_LABEL, label);
+        bytecode_offset = 0;
+    #endif
     } else {
         bytecode_offset = emit->label_offsets[label] - emit->bytecode_offset - 3 + 0x8000;
     }
@@ -301,18 +424,9 @@ STATIC void emit_write_bytecode_byte_signed_label(emit_t *emit, byte b1, mp_uint
     c[2] = bytecode_offset >> 8;
 }
 
-void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
-    emit->pass = pass;
-    emit->stack_size = 0;
-    emit->last_emit_was_return_value = false;
-    emit->scope = scope;
-    emit->last_source_line_offset = 0;
-    emit->last_source_line = 1;
-    if (pass < MP_PASS_EMIT) {
-        memset(emit->label_offsets, -1, emit->max_num_labels * sizeof(mp_uint_t));
-    }
-    emit->bytecode_offset = 0;
-    emit->code_info_offset = 0;
+// Writes the code info up to the line-number info.  This needs the stack size.
+STATIC void emit_write_code_info_prelude(emit_t *emit) {
+    scope_t *scope = emit->scope;
 
     // Write local state size and exception stack size.
     {
@@ -329,15 +443,15 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
 
     // Write scope flags and number of arguments.
     // TODO check that num args all fit in a byte
-    emit_write_code_info_byte(emit, emit->scope->scope_flags);
-    emit_write_code_info_byte(emit, emit->scope->num_pos_args);
-    emit_write_code_info_byte(emit, emit->scope->num_kwonly_args);
-    emit_write_code_info_byte(emit, emit->scope->num_def_pos_args);
+    emit_write_code_info_byte(emit, scope->scope_flags);
+    emit_write_code_info_byte(emit, scope->num_pos_args);
+    emit_write_code_info_byte(emit, scope->num_kwonly_args);
+    emit_write_code_info_byte(emit, scope->num_def_pos_args);
 
     // Write size of the rest of the code info.  We don't know how big this
     // variable uint will be on the MP_PASS_CODE_SIZE pass so we reserve 2 bytes
     // for it and hope that is enough!  TODO assert this or something.
-    if (pass == MP_PASS_EMIT) {
+    if (emit->pass == MP_PASS_EMIT) {
         emit_write_code_info_uint(emit, emit->code_info_size - emit->code_info_offset);
     } else  {
         emit_get_cur_to_write_code_info(emit, 2);
@@ -346,11 +460,43 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     // Write the name and source file of this function.
     emit_write_code_info_qstr(emit, scope->simple_name);
     emit_write_code_info_qstr(emit, scope->source_file);
+}
+
+void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
+    emit->pass = pass;
+    emit->stack_size = 0;
+    emit->last_emit_was_return_value = false;
+    emit->scope = scope;
+    emit->last_source_line_offset = 0;
+    emit->last_source_line = 1;
+    emit->last_op = 0;
+    emit->bytecode_offset = 0;
+    emit->code_info_offset = 0;
+
+    #if MICROPY_EMIT_BC_ONE_PASS
+    if (pass == MP_PASS_EMIT) {
+        // The code info prelude is written at the end of the pass, once the
+        // stack size is known.
+        memset(emit->label_offsets, -1, emit->max_num_labels * sizeof(mp_uint_t));
+        emit->num_fixups = 0;
+        size_t num_args = scope->num_pos_args + scope->num_kwonly_args;
+        if (num_args > emit->const_table_alloc) {
+            emit->const_table_buf = m_renew(mp_uint_t, emit->const_table_buf, emit->const_table_alloc, num_args);
+            emit->const_table_alloc = num_args;
+        }
+        emit->const_table = emit->const_table_buf;
+    }
+    #else
+    if (pass < MP_PASS_EMIT) {
+        memset(emit->label_offsets, -1, emit->max_num_labels * sizeof(mp_uint_t));
+    }
+    emit_write_code_info_prelude(emit);
+    #endif
 
     // bytecode prelude: initialise closed over variables
     for (int i = 0; i < scope->id_info_len; i++) {
         id_info_t *id = &scope->id_info[i];
-        if (id->kind == ID_INFO_KIND_CELL) {
+        if (id->kind == ID_INFO_KIND_CELL && !(id->flags & ID_FLAG_IS_BY_VALUE)) {
             assert(id->local_num < 255);
             emit_write_bytecode_byte(emit, id->local_num); // write the local which should be converted to a cell
         }
@@ -392,6 +538,71 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     }
 }
 
+#if MICROPY_EMIT_BC_ONE_PASS
+// Copies the code info prelude, line-number info and bytecode into code_base,
+// then fills in the references that weren't known while emitting.
+STATIC void emit_bc_finish_one_pass(emit_t *emit) {
+    scope_t *scope = emit->scope;
+    size_t lines_len = emit->code_info_offset;
+    byte *lines = emit->code_info_buf;
+    size_t lines_alloc = emit->code_info_alloc;
+
+    // work out the size of the code info, now that the stack size is known
+    emit->pass = MP_PASS_CODE_SIZE;
+    emit->code_info_offset = 0;
+    emit_write_code_info_prelude(emit);
+    emit->code_info_offset += lines_len;
+    #if !MICROPY_PERSISTENT_CODE
+    // so bytecode is aligned
+    emit->code_info_offset = (size_t)MP_ALIGN(emit->code_info_offset, sizeof(mp_uint_t));
+    #endif
+    emit->code_info_size = emit->code_info_offset;
+    emit->bytecode_size = emit->bytecode_offset;
+    emit->code_base = m_new0_ll(byte, emit->code_info_size + emit->bytecode_size);
+
+    // write the code info, then the bytecode after it; jumps are all relative
+    emit->pass = MP_PASS_EMIT;
+    emit->code_info_offset = 0;
+    emit->code_info_buf = emit->code_base;
+    emit->code_info_alloc = emit->code_info_size;
+    emit_write_code_info_prelude(emit);
+    memcpy(emit_get_cur_to_write_code_info(emit, lines_len), lines, lines_len);
+    emit->code_info_buf = lines;
+    emit->code_info_alloc = lines_alloc;
+    byte *bytecode = emit->code_base + emit->code_info_size;
+    memcpy(bytecode, emit->bytecode_buf, emit->bytecode_size);
+
+    // the const table is the argument names, objects then raw codes
+    size_t ct_index = scope->num_pos_args + scope->num_kwonly_args;
+    #if MICROPY_PERSISTENT_CODE
+    ct_index += emit->ct_num_obj;
+    emit->const_table = m_new0_ll(mp_uint_t, ct_index + emit->ct_cur_raw_code);
+    #else
+    emit->const_table = m_new0_ll(mp_uint_t, ct_index);
+    #endif
+    memcpy(emit->const_table, emit->const_table_buf, ct_index * sizeof(mp_uint_t));
+
+    for (size_t i = 0; i < emit->num_fixups; i++) {
+        emit_bc_fixup_t *f = &emit->fixups[i];
+        byte *c = bytecode + f->offset + 1;
+        if (f->kind == EMIT_BC_FIXUP_RAW_CODE) {
+            assert(ct_index < 0x4000);
+            emit->const_table[ct_index] = f->arg;
+            c[0] = 0x80 | (ct_index >> 7);
+            c[1] = ct_index & 0x7f;
+            ct_index += 1;
+        } else {
+            mp_uint_t bytecode_offset = emit->label_offsets[f->arg] - f->offset - 3;
+            if (f->kind == EMIT_BC_FIXUP_SIGNED_LABEL) {
+                bytecode_offset += 0x8000;
+            }
+            c[0] = bytecode_offset;
+            c[1] = bytecode_offset >> 8;
+        }
+    }
+}
+#endif
+
 void mp_emit_bc_end_pass(emit_t *emit) {
     if (emit->pass == MP_PASS_SCOPE) {
         return;
@@ -403,7 +614,7 @@ void mp_emit_bc_end_pass(emit_t *emit) {
     emit_write_code_info_byte(emit, 0); // end of line number info
 
     #if MICROPY_PERSISTENT_CODE
-    assert(emit->pass <= MP_PASS_STACK_SIZE || (emit->ct_num_obj == emit->ct_cur_obj));
+    assert(emit->pass <= MP_PASS_STACK_SIZE || MICROPY_EMIT_BC_ONE_PASS || (emit->ct_num_obj == emit->ct_cur_obj));
     emit->ct_num_obj = emit->ct_cur_obj;
     #endif
 
@@ -416,18 +627,21 @@ void mp_emit_bc_end_pass(emit_t *emit) {
         // calculate size of total code-info + bytecode, in bytes
         emit->code_info_size = emit->code_info_offset;
         emit->bytecode_size = emit->bytecode_offset;
-        emit->code_base = m_new0(byte, emit->code_info_size + emit->bytecode_size);
+        emit->code_base = m_new0_ll(byte, emit->code_info_size + emit->bytecode_size);
 
         #if MICROPY_PERSISTENT_CODE
-        emit->const_table = m_new0(mp_uint_t,
+        emit->const_table = m_new0_ll(mp_uint_t,
             emit->scope->num_pos_args + emit->scope->num_kwonly_args
             + emit->ct_cur_obj + emit->ct_cur_raw_code);
         #else
-        emit->const_table = m_new0(mp_uint_t,
+        emit->const_table = m_new0_ll(mp_uint_t,
             emit->scope->num_pos_args + emit->scope->num_kwonly_args);
         #endif
 
     } else if (emit->pass == MP_PASS_EMIT) {
+        #if MICROPY_EMIT_BC_ONE_PASS
+        emit_bc_finish_one_pass(emit);
+        #endif
         mp_emit_glue_assign_bytecode(emit->scope->raw_code, emit->code_base,
             emit->code_info_size + emit->bytecode_size,
             emit->const_table,
@@ -459,6 +673,7 @@ void mp_emit_bc_set_source_line(emit_t *emit, mp_uint_t source_line) {
         emit_write_code_info_bytes_lines(emit, bytes_to_skip, lines_to_skip);
         emit->last_source_line_offset = emit->bytecode_offset;
         emit->last_source_line = source_line;
+        emit->last_op = 0;
     }
 #else
     (void)emit;
@@ -480,11 +695,12 @@ STATIC void emit_bc_pre(emit_t *emit, mp_int_t stack_size_delta) {
 
 void mp_emit_bc_label_assign(emit_t *emit, mp_uint_t l) {
     emit_bc_pre(emit, 0);
+    emit->last_op = 0;
     if (emit->pass == MP_PASS_SCOPE) {
         return;
     }
     assert(l < emit->max_num_labels);
-    if (emit->pass < MP_PASS_EMIT) {
+    if (emit->pass < MP_PASS_EMIT || MICROPY_EMIT_BC_ONE_PASS) {
         // assign label offset
         assert(emit->label_offsets[l] == (mp_uint_t)-1);
         emit->label_offsets[l] = emit->bytecode_offset;
@@ -525,11 +741,13 @@ void mp_emit_bc_load_const_tok(emit_t *emit, mp_token_kind_t tok) {
 
 void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     emit_bc_pre(emit, 1);
+    size_t offset = emit->bytecode_offset;
     if (-16 <= arg && arg <= 47) {
         emit_write_bytecode_byte(emit, MP_BC_LOAD_CONST_SMALL_INT_MULTI + 16 + arg);
     } else {
         emit_write_bytecode_byte_int(emit, MP_BC_LOAD_CONST_SMALL_INT, arg);
     }
+    emit_bc_set_last_op(emit, offset, MP_BC_LOAD_CONST_SMALL_INT, arg);
 }
 
 void mp_emit_bc_load_const_str(emit_t *emit, qstr qst) {
@@ -551,12 +769,30 @@ void mp_emit_bc_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     (void)qst;
     emit_bc_pre(emit, 1);
     if (local_num <= 15) {
+        if (emit->last_op == MP_BC_LOAD_FAST_MULTI) {
+            mp_uint_t first = emit->last_op_arg;
+            emit_bc_rewind_last_op(emit);
+            emit_write_bytecode_byte_byte(emit, MP_BC_LOAD_FAST_2, first | (local_num << 4));
+            return;
+        }
+        size_t offset = emit->bytecode_offset;
         emit_write_bytecode_byte(emit, MP_BC_LOAD_FAST_MULTI + local_num);
+        emit_bc_set_last_op(emit, offset, MP_BC_LOAD_FAST_MULTI, local_num);
     } else {
         emit_write_bytecode_byte_uint(emit, MP_BC_LOAD_FAST_N, local_num);
     }
 }
 
+void mp_emit_bc_load_fast_share(emit_t *emit, mp_uint_t local_num) {
+    emit_bc_pre(emit, 1);
+    emit_write_bytecode_byte_uint(emit, MP_BC_LOAD_FAST_SHARE, local_num);
+}
+
+void mp_emit_bc_inplace_add_fast(emit_t *emit, mp_uint_t local_num) {
+    emit_bc_pre(emit, -1);
+    emit_write_bytecode_byte_uint(emit, MP_BC_INPLACE_ADD_FAST, local_num);
+}
+
 void mp_emit_bc_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num) {
     (void)qst;
     emit_bc_pre(emit, 1);
@@ -782,6 +1018,11 @@ void mp_emit_bc_for_iter_end(emit_t *emit) {
     emit_bc_pre(emit, -1);
 }
 
+void mp_emit_bc_for_range(emit_t *emit, mp_uint_t label) {
+    emit_bc_pre(emit, 1);
+    emit_write_bytecode_byte_unsigned_label(emit, MP_BC_FOR_RANGE, label);
+}
+
 void mp_emit_bc_pop_block(emit_t *emit) {
     emit_bc_pre(emit, 0);
     emit_write_bytecode_byte(emit, MP_BC_POP_BLOCK);
@@ -807,7 +1048,14 @@ void mp_emit_bc_binary_op(emit_t *emit, mp_binary_op_t op) {
         op = MP_BINARY_OP_IS;
     }
     emit_bc_pre(emit, -1);
-    emit_write_bytecode_byte(emit, MP_BC_BINARY_OP_MULTI + op);
+    if (emit->last_op == MP_BC_LOAD_CONST_SMALL_INT) {
+        mp_int_t arg = emit->last_op_arg;
+        emit_bc_rewind_last_op(emit);
+        emit_write_bytecode_byte_int(emit, MP_BC_BINARY_OP_SMALL_INT, arg);
+        emit_write_bytecode_byte(emit, op);
+    } else {
+        emit_write_bytecode_byte(emit, MP_BC_BINARY_OP_MULTI + op);
+    }
     if (invert) {
         emit_bc_pre(emit, 0);
         emit_write_bytecode_byte(emit, MP_BC_UNARY_OP_MULTI + MP_UNARY_OP_NOT);
@@ -1012,6 +1260,7 @@ const emit_method_table_t emit_bc_method_table = {
     mp_emit_bc_get_iter,
     mp_emit_bc_for_iter,
     mp_emit_bc_for_iter_end,
+    mp_emit_bc_for_range,
     mp_emit_bc_pop_block,
     mp_emit_bc_pop_except,
     mp_emit_bc_unary_op,
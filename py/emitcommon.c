@@ -66,7 +66,8 @@ void mp_emit_common_id_op(emit_t *emit, const mp_emit_method_table_id_ops_t *emi
         emit_method_table->name(emit, qst);
     } else if (id->kind == ID_INFO_KIND_GLOBAL_EXPLICIT) {
         emit_method_table->global(emit, qst);
-    } else if (id->kind == ID_INFO_KIND_LOCAL) {
+    } else if (id->kind == ID_INFO_KIND_LOCAL || (id->flags & ID_FLAG_IS_BY_VALUE)) {
+        // a variable closed over by value holds its value, not a cell
         emit_method_table->fast(emit, qst, id->local_num);
     } else {
         assert(id->kind == ID_INFO_KIND_CELL || id->kind == ID_INFO_KIND_FREE);
@@ -50,7 +50,7 @@ mp_uint_t mp_verbose_flag = 0;
 #endif
 
 mp_raw_code_t *mp_emit_glue_new_raw_code(void) {
-    mp_raw_code_t *rc = m_new0(mp_raw_code_t, 1);
+    mp_raw_code_t *rc = m_new0_ll(mp_raw_code_t, 1);
     rc->kind = MP_CODE_RESERVED;
     return rc;
 }
@@ -83,7 +83,11 @@ void mp_emit_glue_assign_bytecode(mp_raw_code_t *rc, const byte *code, mp_uint_t
 }
 
 #if MICROPY_EMIT_NATIVE || MICROPY_EMIT_INLINE_THUMB
-void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void *fun_data, mp_uint_t fun_len, const mp_uint_t *const_table, mp_uint_t n_pos_args, mp_uint_t scope_flags, mp_uint_t type_sig) {
+void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void *fun_data, mp_uint_t fun_len, const mp_uint_t *const_table,
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    const mp_native_reloc_t *relocs, mp_uint_t n_reloc,
+    #endif
+    mp_uint_t n_pos_args, mp_uint_t scope_flags, mp_uint_t type_sig) {
     assert(kind == MP_CODE_NATIVE_PY || kind == MP_CODE_NATIVE_VIPER || kind == MP_CODE_NATIVE_ASM);
     rc->kind = kind;
     rc->scope_flags = scope_flags;
@@ -91,6 +95,11 @@ void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void
     rc->data.u_native.fun_data = fun_data;
     rc->data.u_native.const_table = const_table;
     rc->data.u_native.type_sig = type_sig;
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    rc->data.u_native.fun_len = fun_len;
+    rc->data.u_native.relocs = relocs;
+    rc->data.u_native.n_reloc = n_reloc;
+    #endif
 
 #ifdef DEBUG_PRINT
     DEBUG_printf("assign native: kind=%d fun=%p len=" UINT_FMT " n_pos_args=" UINT_FMT " flags=%x\n", kind, fun_data, fun_len, n_pos_args, (uint)scope_flags);
@@ -181,13 +190,42 @@ mp_obj_t mp_make_closure_from_raw_code(const mp_raw_code_t *rc, mp_uint_t n_clos
 #define MPY_FEATURE_FLAGS ( \
     ((MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE) << 0) \
     | ((MICROPY_PY_BUILTINS_STR_UNICODE) << 1) \
+    | ((MICROPY_OPT_SUPERINSTRUCTIONS) << 2) \
     )
 // This is a version of the flags that can be configured at runtime.
 #define MPY_FEATURE_FLAGS_DYNAMIC ( \
     ((MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC) << 0) \
     | ((MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC) << 1) \
+    | ((MICROPY_OPT_SUPERINSTRUCTIONS_DYNAMIC) << 2) \
+    )
+// Flags for features that the VM can run but the bytecode need not use.
+#define MPY_FEATURE_FLAGS_OPTIONAL ((MICROPY_OPT_SUPERINSTRUCTIONS) << 2)
+
+// Set in the feature flags byte of a file with native code, whose header then
+// has two more bytes: the architecture and MPY_NATIVE_FEATURES.
+#define MPY_FEATURE_NATIVE (1 << 3)
+
+// The config options that change the layout of mp_fun_table, which native
+// code calls into.
+#define MPY_NATIVE_FEATURES ( \
+    ((MICROPY_PY_BUILTINS_SET) << 0) \
+    | ((MICROPY_PY_BUILTINS_SLICE) << 1) \
+    | ((MICROPY_PY_BUILTINS_FLOAT) << 2) \
     )
 
+// The architecture of the native code this VM can run.
+#if MICROPY_EMIT_X64
+#define MPY_NATIVE_ARCH (MP_NATIVE_ARCH_X64)
+#elif MICROPY_EMIT_X86
+#define MPY_NATIVE_ARCH (MP_NATIVE_ARCH_X86)
+#elif MICROPY_EMIT_THUMB || MICROPY_EMIT_INLINE_THUMB
+#define MPY_NATIVE_ARCH (MP_NATIVE_ARCH_ARMV7M)
+#elif MICROPY_EMIT_ARM
+#define MPY_NATIVE_ARCH (MP_NATIVE_ARCH_ARMV6)
+#else
+#define MPY_NATIVE_ARCH (MP_NATIVE_ARCH_NONE)
+#endif
+
 #if MICROPY_PERSISTENT_CODE_LOAD || (MICROPY_PERSISTENT_CODE_SAVE && !MICROPY_DYNAMIC_COMPILER)
 // The bytecode will depend on the number of bits in a small-int, and
 // this function computes that (could make it a fixed constant, but it
@@ -300,11 +338,217 @@ STATIC void load_bytecode_qstrs(mp_reader_t *reader, byte *ip, byte *ip_top) {
     }
 }
 
-STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
-    // load bytecode
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+
+#if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+#error MICROPY_PERSISTENT_CODE_LOAD_XIP needs bytecode that is never written to
+#endif
+
+typedef struct _mp_mem_reader_t {
+    const byte *cur;
+    const byte *end;
+} mp_mem_reader_t;
+
+STATIC mp_uint_t mp_mem_reader_next_byte(void *br_in);
+
+STATIC bool load_qstr_matches(mp_reader_t *reader, const byte *ip) {
+    return load_qstr(reader) == (qstr)(ip[0] | (ip[1] << 8));
+}
+
+STATIC void skip_obj(mp_reader_t *reader) {
+    if (read_byte(reader) != 'e') {
+        mp_mem_reader_t *mr = reader->data;
+        mr->cur += read_uint(reader);
+    }
+}
+
+// Checks that every qstr the bytecode of rc and its children was saved with
+// has the same id in this VM, so the bytecode can be run without patching.
+// The qstrs are interned as they would be for a normal load.
+STATIC bool check_raw_code_qstrs(mp_reader_t *reader) {
+    mp_mem_reader_t *mr = reader->data;
     mp_uint_t bc_len = read_uint(reader);
-    byte *bytecode = m_new(byte, bc_len);
-    read_bytes(reader, bytecode, bc_len);
+    const byte *bytecode = mr->cur;
+    if (bc_len > (size_t)(mr->end - bytecode)) {
+        mp_raise_ValueError("invalid .mpy file");
+    }
+    mr->cur += bc_len;
+
+    const byte *ip = bytecode;
+    const byte *ip2;
+    bytecode_prelude_t prelude;
+    extract_prelude(&ip, &ip2, &prelude);
+
+    bool match = load_qstr_matches(reader, ip2);
+    match &= load_qstr_matches(reader, ip2 + 2);
+    while (ip < bytecode + bc_len) {
+        size_t sz;
+        uint f = mp_opcode_format(ip, &sz);
+        if (f == MP_OPCODE_QSTR) {
+            match &= load_qstr_matches(reader, ip + 1);
+        }
+        ip += sz;
+    }
+
+    mp_uint_t n_obj = read_uint(reader);
+    mp_uint_t n_raw_code = read_uint(reader);
+    for (mp_uint_t i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
+        load_qstr(reader);
+    }
+    for (mp_uint_t i = 0; i < n_obj; ++i) {
+        skip_obj(reader);
+    }
+    for (mp_uint_t i = 0; i < n_raw_code; ++i) {
+        match &= check_raw_code_qstrs(reader);
+    }
+    return match;
+}
+#endif
+
+#if MICROPY_EMIT_NATIVE || MICROPY_EMIT_INLINE_THUMB
+
+STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, bool in_place, bool native_file);
+
+#if MICROPY_EMIT_NATIVE
+// Native code from a .mpy file is generated with the nlr_buf_t of the assembly
+// nlr for its architecture, and assumes the code state and object layout of
+// a default build.
+STATIC bool native_code_is_compatible(void) {
+    #if MICROPY_EMIT_X64
+    size_t nlr_buf_words = 2 + 8;
+    #elif MICROPY_EMIT_X86
+    size_t nlr_buf_words = 2 + 6;
+    #else
+    size_t nlr_buf_words = 2 + 10;
+    #endif
+    return sizeof(nlr_buf_t) == nlr_buf_words * sizeof(mp_uint_t)
+        && !MICROPY_STACKLESS && MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_A;
+}
+#endif
+
+STATIC mp_raw_code_t *load_native_code(mp_reader_t *reader, mp_raw_code_kind_t kind, size_t fun_len) {
+    bool supported = false;
+    #if MICROPY_EMIT_NATIVE
+    supported |= kind != MP_CODE_NATIVE_ASM && native_code_is_compatible();
+    #endif
+    #if MICROPY_EMIT_INLINE_THUMB
+    supported |= kind == MP_CODE_NATIVE_ASM;
+    #endif
+    if (!supported) {
+        mp_raise_ValueError("incompatible .mpy file");
+    }
+
+    // copy the code to memory that it can be run from
+    byte *fun_data;
+    mp_uint_t fun_alloc;
+    MP_PLAT_ALLOC_EXEC(fun_len, (void**)&fun_data, &fun_alloc);
+    if (fun_data == NULL) {
+        m_malloc_fail(fun_len);
+    }
+    read_bytes(reader, fun_data, fun_len);
+
+    mp_uint_t scope_flags = read_uint(reader);
+    mp_uint_t n_pos_args = read_uint(reader);
+    mp_uint_t type_sig = read_uint(reader);
+    const mp_uint_t *const_table = NULL;
+    if (kind == MP_CODE_NATIVE_PY) {
+        const_table = (const mp_uint_t*)(fun_data + read_uint(reader));
+    }
+
+    // fill in the values that depend on this VM
+    mp_uint_t n_reloc = read_uint(reader);
+    for (mp_uint_t i = 0; i < n_reloc; ++i) {
+        mp_uint_t offset = read_uint(reader);
+        byte reloc_kind = read_byte(reader);
+        if (offset + (reloc_kind == MP_NATIVE_RELOC_QSTR16 ? 2 : sizeof(mp_uint_t)) > fun_len) {
+            mp_raise_ValueError("invalid .mpy file");
+        }
+        mp_uint_t val;
+        switch (reloc_kind) {
+            case MP_NATIVE_RELOC_QSTR16: {
+                qstr qst = load_qstr(reader);
+                fun_data[offset] = qst;
+                fun_data[offset + 1] = qst >> 8;
+                continue;
+            }
+            case MP_NATIVE_RELOC_QSTR:
+                val = load_qstr(reader);
+                break;
+            case MP_NATIVE_RELOC_QSTR_OBJ:
+                val = (mp_uint_t)MP_OBJ_NEW_QSTR(load_qstr(reader));
+                break;
+            case MP_NATIVE_RELOC_CONST: {
+                byte idx = read_byte(reader);
+                mp_obj_t consts[4] = {
+                    mp_const_none, mp_const_false, mp_const_true, MP_OBJ_FROM_PTR(&mp_const_ellipsis_obj),
+                };
+                if (idx >= MP_ARRAY_SIZE(consts)) {
+                    mp_raise_ValueError("invalid .mpy file");
+                }
+                val = (mp_uint_t)consts[idx];
+                break;
+            }
+            case MP_NATIVE_RELOC_OBJ:
+                val = (mp_uint_t)load_obj(reader);
+                break;
+            case MP_NATIVE_RELOC_RAW_CODE:
+                val = (mp_uint_t)(uintptr_t)load_raw_code(reader, false, true);
+                break;
+            case MP_NATIVE_RELOC_FUN_TABLE: {
+                mp_uint_t idx = read_uint(reader);
+                if (idx == 0) {
+                    val = (mp_uint_t)(uintptr_t)mp_fun_table;
+                } else if (idx <= MP_F_NUMBER_OF) {
+                    val = (mp_uint_t)(uintptr_t)mp_fun_table[idx - 1];
+                } else {
+                    mp_raise_ValueError("invalid .mpy file");
+                }
+                break;
+            }
+            default:
+                mp_raise_ValueError("invalid .mpy file");
+        }
+        memcpy(fun_data + offset, &val, sizeof(val));
+    }
+
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+    mp_emit_glue_assign_native(rc, kind, fun_data, fun_len, const_table,
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        NULL, 0,
+        #endif
+        n_pos_args, scope_flags, type_sig);
+    return rc;
+}
+
+#endif
+
+STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, bool in_place, bool native_file) {
+    // load bytecode, or in a file with native code the kind and length of the code
+    mp_uint_t bc_len = read_uint(reader);
+    if (native_file) {
+        mp_raw_code_kind_t kind = MP_CODE_BYTECODE + (bc_len & 3);
+        bc_len >>= 2;
+        if (kind != MP_CODE_BYTECODE) {
+            #if MICROPY_EMIT_NATIVE || MICROPY_EMIT_INLINE_THUMB
+            return load_native_code(reader, kind, bc_len);
+            #else
+            mp_raise_ValueError("incompatible .mpy file");
+            #endif
+        }
+    }
+    byte *bytecode;
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    if (in_place) {
+        // the qstrs were checked by check_raw_code_qstrs
+        mp_mem_reader_t *mr = reader->data;
+        bytecode = (byte*)mr->cur;
+        mr->cur += bc_len;
+    } else
+    #endif
+    {
+        bytecode = m_new_ll(byte, bc_len);
+        read_bytes(reader, bytecode, bc_len);
+    }
 
     // extract prelude
     const byte *ip = bytecode;
@@ -315,14 +559,25 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
     // load qstrs and link global qstr ids into bytecode
     qstr simple_name = load_qstr(reader);
     qstr source_file = load_qstr(reader);
-    ((byte*)ip2)[0] = simple_name; ((byte*)ip2)[1] = simple_name >> 8;
-    ((byte*)ip2)[2] = source_file; ((byte*)ip2)[3] = source_file >> 8;
-    load_bytecode_qstrs(reader, (byte*)ip, bytecode + bc_len);
+    if (in_place) {
+        // skip over the qstrs, which are already linked
+        while (ip < bytecode + bc_len) {
+            size_t sz;
+            if (mp_opcode_format(ip, &sz) == MP_OPCODE_QSTR) {
+                load_qstr(reader);
+            }
+            ip += sz;
+        }
+    } else {
+        ((byte*)ip2)[0] = simple_name; ((byte*)ip2)[1] = simple_name >> 8;
+        ((byte*)ip2)[2] = source_file; ((byte*)ip2)[3] = source_file >> 8;
+        load_bytecode_qstrs(reader, (byte*)ip, bytecode + bc_len);
+    }
 
     // load constant table
     mp_uint_t n_obj = read_uint(reader);
     mp_uint_t n_raw_code = read_uint(reader);
-    mp_uint_t *const_table = m_new(mp_uint_t, prelude.n_pos_args + prelude.n_kwonly_args + n_obj + n_raw_code);
+    mp_uint_t *const_table = m_new_ll(mp_uint_t, prelude.n_pos_args + prelude.n_kwonly_args + n_obj + n_raw_code);
     mp_uint_t *ct = const_table;
     for (mp_uint_t i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
         *ct++ = (mp_uint_t)MP_OBJ_NEW_QSTR(load_qstr(reader));
@@ -331,7 +586,7 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
         *ct++ = (mp_uint_t)load_obj(reader);
     }
     for (mp_uint_t i = 0; i < n_raw_code; ++i) {
-        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader);
+        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader, in_place, native_file);
     }
 
     // create raw_code and return it
@@ -344,22 +599,38 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
     return rc;
 }
 
-mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
+// Returns whether the file has native code.
+STATIC bool load_header(mp_reader_t *reader) {
     byte header[4];
     read_bytes(reader, header, sizeof(header));
     if (strncmp((char*)header, "M\x00", 2) != 0) {
         mp_raise_ValueError("invalid .mpy file");
     }
-    if (header[2] != MPY_FEATURE_FLAGS || header[3] > mp_small_int_bits()) {
+    bool native_file = header[2] & MPY_FEATURE_NATIVE;
+    if (((header[2] & ~MPY_FEATURE_NATIVE) | MPY_FEATURE_FLAGS_OPTIONAL) != MPY_FEATURE_FLAGS || header[3] > mp_small_int_bits()) {
         mp_raise_ValueError("incompatible .mpy file");
     }
-    return load_raw_code(reader);
+    if (native_file) {
+        byte arch = read_byte(reader);
+        byte features = read_byte(reader);
+        if (arch == MP_NATIVE_ARCH_NONE || arch != MPY_NATIVE_ARCH || features != MPY_NATIVE_FEATURES) {
+            mp_raise_ValueError("incompatible .mpy file");
+        }
+    }
+    return native_file;
+}
+
+mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
+    bool native_file = load_header(reader);
+    return load_raw_code(reader, false, native_file);
 }
 
+#if !MICROPY_PERSISTENT_CODE_LOAD_XIP
 typedef struct _mp_mem_reader_t {
     const byte *cur;
     const byte *end;
 } mp_mem_reader_t;
+#endif
 
 STATIC mp_uint_t mp_mem_reader_next_byte(void *br_in) {
     mp_mem_reader_t *br = br_in;
@@ -376,6 +647,23 @@ mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len) {
     return mp_raw_code_load(&reader);
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+mp_raw_code_t *mp_raw_code_load_xip(const byte *buf, size_t len) {
+    mp_mem_reader_t mr = {buf, buf + len};
+    mp_reader_t reader = {&mr, mp_mem_reader_next_byte};
+    if (load_header(&reader)) {
+        // native code is always copied to executable memory
+        return NULL;
+    }
+    const byte *code = mr.cur;
+    if (!check_raw_code_qstrs(&reader)) {
+        return NULL;
+    }
+    mr.cur = code;
+    return load_raw_code(&reader, true, false);
+}
+#endif
+
 // here we define mp_raw_code_load_file depending on the port
 // TODO abstract this away properly
 
@@ -555,13 +843,60 @@ STATIC void save_bytecode_qstrs(mp_print_t *print, const byte *ip, const byte *i
     }
 }
 
-STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
+STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc, bool native_file);
+
+STATIC void save_native_code(mp_print_t *print, mp_raw_code_t *rc) {
+    // save the code, with the kind in the low bits of its length
+    mp_print_uint(print, (rc->data.u_native.fun_len << 2) | (rc->kind - MP_CODE_BYTECODE));
+    mp_print_bytes(print, rc->data.u_native.fun_data, rc->data.u_native.fun_len);
+    mp_print_uint(print, rc->scope_flags);
+    mp_print_uint(print, rc->n_pos_args);
+    mp_print_uint(print, rc->data.u_native.type_sig);
+    if (rc->kind == MP_CODE_NATIVE_PY) {
+        mp_print_uint(print, (const byte*)rc->data.u_native.const_table - (const byte*)rc->data.u_native.fun_data);
+    }
+
+    // save the relocations, each with what to fill in when loading
+    mp_print_uint(print, rc->data.u_native.n_reloc);
+    for (mp_uint_t i = 0; i < rc->data.u_native.n_reloc; ++i) {
+        const mp_native_reloc_t *r = &rc->data.u_native.relocs[i];
+        byte kind = r->kind;
+        mp_print_uint(print, r->offset);
+        mp_print_bytes(print, &kind, 1);
+        switch (kind) {
+            case MP_NATIVE_RELOC_QSTR:
+            case MP_NATIVE_RELOC_QSTR16:
+            case MP_NATIVE_RELOC_QSTR_OBJ:
+                save_qstr(print, r->arg);
+                break;
+            case MP_NATIVE_RELOC_CONST: {
+                byte idx = r->arg;
+                mp_print_bytes(print, &idx, 1);
+                break;
+            }
+            case MP_NATIVE_RELOC_OBJ:
+                save_obj(print, (mp_obj_t)r->arg);
+                break;
+            case MP_NATIVE_RELOC_RAW_CODE:
+                save_raw_code(print, (mp_raw_code_t*)(uintptr_t)r->arg, true);
+                break;
+            default:
+                assert(kind == MP_NATIVE_RELOC_FUN_TABLE);
+                mp_print_uint(print, r->arg);
+                break;
+        }
+    }
+}
+
+STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc, bool native_file) {
     if (rc->kind != MP_CODE_BYTECODE) {
-        mp_raise_ValueError("can only save bytecode");
+        // only reached for a file with native code, see raw_code_has_native
+        save_native_code(print, rc);
+        return;
     }
 
-    // save bytecode
-    mp_print_uint(print, rc->data.u_byte.bc_len);
+    // save bytecode, in a file with native code with the kind in the low bits
+    mp_print_uint(print, native_file ? rc->data.u_byte.bc_len << 2 : rc->data.u_byte.bc_len);
     mp_print_bytes(print, rc->data.u_byte.bytecode, rc->data.u_byte.bc_len);
 
     // extract prelude
@@ -587,16 +922,38 @@ STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
         save_obj(print, (mp_obj_t)*const_table++);
     }
     for (uint i = 0; i < rc->data.u_byte.n_raw_code; ++i) {
-        save_raw_code(print, (mp_raw_code_t*)(uintptr_t)*const_table++);
+        save_raw_code(print, (mp_raw_code_t*)(uintptr_t)*const_table++, native_file);
     }
 }
 
+// Whether rc or any function nested in it is native code.
+STATIC bool raw_code_has_native(const mp_raw_code_t *rc) {
+    if (rc->kind != MP_CODE_BYTECODE) {
+        return true;
+    }
+    const mp_uint_t *const_table = rc->data.u_byte.const_table;
+    const byte *ip = rc->data.u_byte.bytecode;
+    const byte *ip2;
+    bytecode_prelude_t prelude;
+    extract_prelude(&ip, &ip2, &prelude);
+    const_table += prelude.n_pos_args + prelude.n_kwonly_args + rc->data.u_byte.n_obj;
+    for (uint i = 0; i < rc->data.u_byte.n_raw_code; ++i) {
+        if (raw_code_has_native((const mp_raw_code_t*)(uintptr_t)const_table[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
     // header contains:
     //  byte  'M'
     //  byte  version
     //  byte  feature flags
     //  byte  number of bits in a small int
+    // and if the file has native code (MPY_FEATURE_NATIVE is set):
+    //  byte  native architecture
+    //  byte  MPY_NATIVE_FEATURES
     byte header[4] = {'M', 0, MPY_FEATURE_FLAGS_DYNAMIC,
         #if MICROPY_DYNAMIC_COMPILER
         mp_dynamic_compiler.small_int_bits,
@@ -604,9 +961,24 @@ void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
         mp_small_int_bits(),
         #endif
     };
+    bool native_file = raw_code_has_native(rc);
+    if (native_file) {
+        header[2] |= MPY_FEATURE_NATIVE;
+    }
     mp_print_bytes(print, header, sizeof(header));
+    if (native_file) {
+        byte native_header[2] = {
+            #if MICROPY_DYNAMIC_COMPILER
+            mp_dynamic_compiler.native_arch,
+            #else
+            MPY_NATIVE_ARCH,
+            #endif
+            MPY_NATIVE_FEATURES,
+        };
+        mp_print_bytes(print, native_header, sizeof(native_header));
+    }
 
-    save_raw_code(print, rc);
+    save_raw_code(print, rc, native_file);
 }
 
 // here we define mp_raw_code_save_file depending on the port
@@ -631,6 +1003,27 @@ void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
     close(fd);
 }
 
+#elif defined(__thumb2__) || defined(__thumb__) || defined(__xtensa__)
+// fatfs file writer
+
+#include "py/mperrno.h"
+#include "lib/fatfs/ff.h"
+
+STATIC void fat_print_strn(void *env, const char *str, size_t len) {
+    UINT n;
+    f_write(env, str, len, &n);
+}
+
+void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
+    FIL fp;
+    if (f_open(&fp, filename, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        mp_raise_OSError(MP_EIO);
+    }
+    mp_print_t fat_print = {&fp, fat_print_strn};
+    mp_raw_code_save(rc, &fat_print);
+    f_close(&fp);
+}
+
 #else
 #error mp_raw_code_save_file not implemented for this platform
 #endif
@@ -39,6 +39,38 @@ typedef enum {
     MP_CODE_NATIVE_ASM,
 } mp_raw_code_kind_t;
 
+// The architecture native code in a .mpy file was generated for.
+typedef enum {
+    MP_NATIVE_ARCH_NONE = 0,
+    MP_NATIVE_ARCH_X86,
+    MP_NATIVE_ARCH_X64,
+    MP_NATIVE_ARCH_ARMV6,
+    MP_NATIVE_ARCH_ARMV7M = 5,
+} mp_native_arch_t;
+
+#if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_PERSISTENT_CODE_SAVE
+// The values in native code that depend on the VM it runs in, which have to be
+// fixed up when it is loaded from a .mpy file.  Except for QSTR16 each is a
+// whole machine word in the code.
+typedef enum {
+    MP_NATIVE_RELOC_QSTR,       // arg is the qstr
+    MP_NATIVE_RELOC_QSTR16,     // 2 bytes in the prelude, arg is the qstr
+    MP_NATIVE_RELOC_QSTR_OBJ,   // arg is the qstr
+    MP_NATIVE_RELOC_CONST,      // arg is 0-3 for None, False, True, Ellipsis
+    MP_NATIVE_RELOC_OBJ,        // arg is the constant object
+    MP_NATIVE_RELOC_RAW_CODE,   // arg is the mp_raw_code_t of a child function
+    MP_NATIVE_RELOC_FUN_TABLE,  // arg is 0 for mp_fun_table itself, else 1 + index of the entry
+} mp_native_reloc_kind_t;
+#endif
+
+#if MICROPY_PERSISTENT_CODE_SAVE
+typedef struct _mp_native_reloc_t {
+    mp_uint_t offset : 8 * sizeof(mp_uint_t) - 3;
+    mp_uint_t kind : 3;
+    mp_uint_t arg;
+} mp_native_reloc_t;
+#endif
+
 typedef struct _mp_raw_code_t {
     mp_raw_code_kind_t kind : 3;
     mp_uint_t scope_flags : 7;
@@ -57,6 +89,11 @@ typedef struct _mp_raw_code_t {
             void *fun_data;
             const mp_uint_t *const_table;
             mp_uint_t type_sig; // for viper, compressed as 2-bit types; ret is MSB, then arg0, arg1, etc
+            #if MICROPY_PERSISTENT_CODE_SAVE
+            mp_uint_t fun_len;
+            const mp_native_reloc_t *relocs;
+            mp_uint_t n_reloc;
+            #endif
         } u_native;
     } data;
 } mp_raw_code_t;
@@ -69,7 +106,11 @@ void mp_emit_glue_assign_bytecode(mp_raw_code_t *rc, const byte *code, mp_uint_t
     uint16_t n_obj, uint16_t n_raw_code,
     #endif
     mp_uint_t scope_flags);
-void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void *fun_data, mp_uint_t fun_len, const mp_uint_t *const_table, mp_uint_t n_pos_args, mp_uint_t scope_flags, mp_uint_t type_sig);
+void mp_emit_glue_assign_native(mp_raw_code_t *rc, mp_raw_code_kind_t kind, void *fun_data, mp_uint_t fun_len, const mp_uint_t *const_table,
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    const mp_native_reloc_t *relocs, mp_uint_t n_reloc,
+    #endif
+    mp_uint_t n_pos_args, mp_uint_t scope_flags, mp_uint_t type_sig);
 
 mp_obj_t mp_make_function_from_raw_code(const mp_raw_code_t *rc, mp_obj_t def_args, mp_obj_t def_kw_args);
 mp_obj_t mp_make_closure_from_raw_code(const mp_raw_code_t *rc, mp_uint_t n_closed_over, const mp_obj_t *args);
@@ -84,6 +125,13 @@ typedef struct _mp_reader_t {
 mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader);
 mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len);
 mp_raw_code_t *mp_raw_code_load_file(const char *filename);
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+// buf must stay mapped and unchanged for as long as the code may run. Returns
+// NULL, having interned the qstrs, if buf wasn't saved with the qstr ids of
+// this VM, or if it has native code; it can then only be loaded with
+// mp_raw_code_load_mem.
+mp_raw_code_t *mp_raw_code_load_xip(const byte *buf, size_t len);
+#endif
 #endif
 
 #if MICROPY_PERSISTENT_CODE_SAVE
@@ -91,4 +139,12 @@ void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print);
 void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename);
 #endif
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+// Provided by the port. Load returns NULL if there is no up-to-date copy of
+// the compiled source_file. Store must not raise; a cache that can't be
+// written is simply ignored.
+mp_raw_code_t *mp_code_cache_load(const char *source_file);
+void mp_code_cache_store(const char *source_file, mp_raw_code_t *rc);
+#endif
+
 #endif // __MICROPY_INCLUDED_PY_EMITGLUE_H__
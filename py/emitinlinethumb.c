@@ -91,7 +91,11 @@ STATIC void emit_inline_thumb_end_pass(emit_inline_asm_t *emit, mp_uint_t type_s
     if (emit->pass == MP_PASS_EMIT) {
         void *f = asm_thumb_get_code(emit->as);
         mp_emit_glue_assign_native(emit->scope->raw_code, MP_CODE_NATIVE_ASM, f,
-            asm_thumb_get_code_size(emit->as), NULL, emit->scope->num_pos_args, 0, type_sig);
+            asm_thumb_get_code_size(emit->as), NULL,
+            #if MICROPY_PERSISTENT_CODE_SAVE
+            NULL, 0,
+            #endif
+            emit->scope->num_pos_args, 0, type_sig);
     }
 }
 
@@ -247,8 +251,19 @@ malformed:
 }
 #endif
 
-STATIC mp_uint_t get_arg_reglist(emit_inline_asm_t *emit, const char *op, mp_parse_node_t pn) {
-    // a register list looks like {r0, r1, r2} and is parsed as a Python set
+STATIC mp_uint_t get_arg_reglist_reg(emit_inline_asm_t *emit, const char *op, mp_parse_node_t pn, bool vfp) {
+    #if MICROPY_EMIT_INLINE_THUMB_FLOAT
+    if (vfp) {
+        return get_arg_vfpreg(emit, op, pn);
+    }
+    #else
+    (void)vfp;
+    #endif
+    return get_arg_reg(emit, op, pn, 15);
+}
+
+STATIC mp_uint_t get_arg_reglist_helper(emit_inline_asm_t *emit, const char *op, mp_parse_node_t pn, bool vfp) {
+    // a register list looks like {r0, r1, r2} (or {s0, s1} for the FPU) and is parsed as a Python set
 
     if (!MP_PARSE_NODE_IS_STRUCT_KIND(pn, PN_atom_brace)) {
         goto bad_arg;
@@ -262,7 +277,7 @@ STATIC mp_uint_t get_arg_reglist(emit_inline_asm_t *emit, const char *op, mp_par
 
     if (MP_PARSE_NODE_IS_ID(pn)) {
         // set with one element
-        reglist |= 1 << get_arg_reg(emit, op, pn, 15);
+        reglist |= (mp_uint_t)1 << get_arg_reglist_reg(emit, op, pn, vfp);
     } else if (MP_PARSE_NODE_IS_STRUCT(pn)) {
         pns = (mp_parse_node_struct_t*)pn;
         if (MP_PARSE_NODE_STRUCT_KIND(pns) == PN_dictorsetmaker) {
@@ -271,8 +286,8 @@ STATIC mp_uint_t get_arg_reglist(emit_inline_asm_t *emit, const char *op, mp_par
             if (MP_PARSE_NODE_STRUCT_KIND(pns1) == PN_dictorsetmaker_list) {
                 // set with multiple elements
 
-                // get first element of set (we rely on get_arg_reg to catch syntax errors)
-                reglist |= 1 << get_arg_reg(emit, op, pns->nodes[0], 15);
+                // get first element of set (we rely on get_arg_reglist_reg to catch syntax errors)
+                reglist |= (mp_uint_t)1 << get_arg_reglist_reg(emit, op, pns->nodes[0], vfp);
 
                 // get tail elements (2nd, 3rd, ...)
                 mp_parse_node_t *nodes;
@@ -280,7 +295,7 @@ STATIC mp_uint_t get_arg_reglist(emit_inline_asm_t *emit, const char *op, mp_par
 
                 // process rest of elements
                 for (int i = 0; i < n; i++) {
-                    reglist |= 1 << get_arg_reg(emit, op, nodes[i], 15);
+                    reglist |= (mp_uint_t)1 << get_arg_reglist_reg(emit, op, nodes[i], vfp);
                 }
             } else {
                 goto bad_arg;
@@ -295,10 +310,37 @@ STATIC mp_uint_t get_arg_reglist(emit_inline_asm_t *emit, const char *op, mp_par
     return reglist;
 
 bad_arg:
-    emit_inline_thumb_error_exc(emit, mp_obj_new_exception_msg_varg(&mp_type_SyntaxError, "'%s' expects {r0, r1, ...}", op));
+    emit_inline_thumb_error_exc(emit, mp_obj_new_exception_msg_varg(&mp_type_SyntaxError,
+        vfp ? "'%s' expects {s0, s1, ...}" : "'%s' expects {r0, r1, ...}", op));
     return 0;
 }
 
+STATIC mp_uint_t get_arg_reglist(emit_inline_asm_t *emit, const char *op, mp_parse_node_t pn) {
+    return get_arg_reglist_helper(emit, op, pn, false);
+}
+
+#if MICROPY_EMIT_INLINE_THUMB_FLOAT
+// an FPU register list must be a consecutive run, and is returned as its first
+// register with the number of registers in *count
+STATIC mp_uint_t get_arg_vfpreglist(emit_inline_asm_t *emit, const char *op, mp_parse_node_t pn, mp_uint_t *count) {
+    mp_uint_t reglist = get_arg_reglist_helper(emit, op, pn, true);
+    mp_uint_t first = 0;
+    while (first < 32 && !(reglist & ((mp_uint_t)1 << first))) {
+        first += 1;
+    }
+    mp_uint_t n = 0;
+    while (first + n < 32 && (reglist & ((mp_uint_t)1 << (first + n)))) {
+        n += 1;
+    }
+    if (first + n < 32 && (reglist >> (first + n)) != 0) {
+        emit_inline_thumb_error_exc(emit, mp_obj_new_exception_msg_varg(&mp_type_SyntaxError,
+            "'%s' expects consecutive FPU registers", op));
+    }
+    *count = n;
+    return first;
+}
+#endif
+
 STATIC uint32_t get_arg_i(emit_inline_asm_t *emit, const char *op, mp_parse_node_t pn, uint32_t fit_mask) {
     mp_obj_t o;
     if (!mp_parse_node_get_int_maybe(pn, &o)) {
@@ -416,6 +458,136 @@ STATIC const format_vfp_op_t format_vfp_op_table[] = {
 };
 #endif
 
+#if MICROPY_EMIT_INLINE_THUMB_DSP
+// The DSP instructions are all 32-bit and put their registers in fixed fields:
+// op_hi | rn, op_lo | (ra << 12) | (rd << 8) | rm.  Those without an accumulator
+// have 0xf in the ra field of op_lo.
+#define DSP_RD_RN_RM (0) // op(rd, rn, rm)
+#define DSP_RD_RM_RN (1) // op(rd, rm, rn), the saturating qadd family
+#define DSP_RD_RN_RM_RA (2) // op(rd, rn, rm, ra)
+#define DSP_RDLO_RDHI_RN_RM (3) // op(rdlo, rdhi, rn, rm), rdlo goes in the ra field
+typedef struct _format_dsp_op_t { uint16_t op_hi; uint16_t op_lo; byte form; char name[8]; } format_dsp_op_t;
+STATIC const format_dsp_op_t format_dsp_op_table[] = {
+    { 0xfa80, 0xf080, DSP_RD_RM_RN, "qadd" },
+    { 0xfa80, 0xf090, DSP_RD_RM_RN, "qdadd" },
+    { 0xfa80, 0xf0a0, DSP_RD_RM_RN, "qsub" },
+    { 0xfa80, 0xf0b0, DSP_RD_RM_RN, "qdsub" },
+    { 0xfaa0, 0xf080, DSP_RD_RN_RM, "sel" },
+    { 0xfb70, 0xf000, DSP_RD_RN_RM, "usad8" },
+    { 0xfb70, 0x0000, DSP_RD_RN_RM_RA, "usada8" },
+    { 0xfb10, 0xf000, DSP_RD_RN_RM, "smulbb" },
+    { 0xfb10, 0xf010, DSP_RD_RN_RM, "smulbt" },
+    { 0xfb10, 0xf020, DSP_RD_RN_RM, "smultb" },
+    { 0xfb10, 0xf030, DSP_RD_RN_RM, "smultt" },
+    { 0xfb10, 0x0000, DSP_RD_RN_RM_RA, "smlabb" },
+    { 0xfb10, 0x0010, DSP_RD_RN_RM_RA, "smlabt" },
+    { 0xfb10, 0x0020, DSP_RD_RN_RM_RA, "smlatb" },
+    { 0xfb10, 0x0030, DSP_RD_RN_RM_RA, "smlatt" },
+    { 0xfb20, 0xf000, DSP_RD_RN_RM, "smuad" },
+    { 0xfb20, 0xf010, DSP_RD_RN_RM, "smuadx" },
+    { 0xfb20, 0x0000, DSP_RD_RN_RM_RA, "smlad" },
+    { 0xfb20, 0x0010, DSP_RD_RN_RM_RA, "smladx" },
+    { 0xfb30, 0xf000, DSP_RD_RN_RM, "smulwb" },
+    { 0xfb30, 0xf010, DSP_RD_RN_RM, "smulwt" },
+    { 0xfb30, 0x0000, DSP_RD_RN_RM_RA, "smlawb" },
+    { 0xfb30, 0x0010, DSP_RD_RN_RM_RA, "smlawt" },
+    { 0xfb40, 0xf000, DSP_RD_RN_RM, "smusd" },
+    { 0xfb40, 0xf010, DSP_RD_RN_RM, "smusdx" },
+    { 0xfb40, 0x0000, DSP_RD_RN_RM_RA, "smlsd" },
+    { 0xfb40, 0x0010, DSP_RD_RN_RM_RA, "smlsdx" },
+    { 0xfb50, 0xf000, DSP_RD_RN_RM, "smmul" },
+    { 0xfb50, 0xf010, DSP_RD_RN_RM, "smmulr" },
+    { 0xfb50, 0x0000, DSP_RD_RN_RM_RA, "smmla" },
+    { 0xfb50, 0x0010, DSP_RD_RN_RM_RA, "smmlar" },
+    { 0xfb80, 0x0000, DSP_RDLO_RDHI_RN_RM, "smull" },
+    { 0xfba0, 0x0000, DSP_RDLO_RDHI_RN_RM, "umull" },
+    { 0xfbc0, 0x0000, DSP_RDLO_RDHI_RN_RM, "smlal" },
+    { 0xfbc0, 0x00c0, DSP_RDLO_RDHI_RN_RM, "smlald" },
+    { 0xfbc0, 0x00d0, DSP_RDLO_RDHI_RN_RM, "smlaldx" },
+    { 0xfbd0, 0x00c0, DSP_RDLO_RDHI_RN_RM, "smlsld" },
+    { 0xfbd0, 0x00d0, DSP_RDLO_RDHI_RN_RM, "smlsldx" },
+    { 0xfbe0, 0x0000, DSP_RDLO_RDHI_RN_RM, "umlal" },
+};
+
+// The parallel add/subtract instructions are named by a prefix for the kind of
+// arithmetic and a suffix for the operation, eg sadd16, qsub8, uhasx.  The index
+// into each table is the value of the corresponding field in the opcode.
+STATIC const char dsp_parallel_prefix[7][3] = { "s", "q", "sh", "", "u", "uq", "uh" };
+STATIC const char dsp_parallel_suffix[7][6] = { "add8", "add16", "asx", "", "sub8", "sub16", "sax" };
+
+STATIC bool emit_inline_thumb_dsp_op(emit_inline_asm_t *emit, const char *op_str, mp_uint_t n_args, mp_parse_node_t *pn_args) {
+    if (n_args == 3 && (op_str[0] == 's' || op_str[0] == 'u') && strncmp(op_str + 1, "sat", 3) == 0
+        && (op_str[4] == '\0' || strcmp(op_str + 4, "16") == 0)) {
+        // ssat saturates to 1..32 bits and encodes one less, usat to 0..31 bits
+        bool is_unsigned = op_str[0] == 'u';
+        bool is_16 = op_str[4] != '\0';
+        mp_uint_t max = is_16 ? 16 : 32;
+        mp_uint_t rd = get_arg_reg(emit, op_str, pn_args[0], 15);
+        mp_uint_t sat = get_arg_i(emit, op_str, pn_args[1], 0x3f);
+        mp_uint_t rn = get_arg_reg(emit, op_str, pn_args[2], 15);
+        if (is_unsigned ? sat >= max : (sat == 0 || sat > max)) {
+            emit_inline_thumb_error_exc(emit, mp_obj_new_exception_msg_varg(&mp_type_SyntaxError,
+                "'%s' expects a bit position from %d to %d", op_str, !is_unsigned, max - is_unsigned));
+            return true;
+        }
+        asm_thumb_op32(emit->as, 0xf300 | (is_unsigned << 7) | (is_16 << 5) | rn,
+            (rd << 8) | (sat - !is_unsigned));
+        return true;
+    }
+
+    mp_uint_t op_hi = 0, op_lo = 0, form = DSP_RD_RN_RM;
+    bool found = false;
+    for (mp_uint_t p = 0; p < MP_ARRAY_SIZE(dsp_parallel_prefix) && !found; p++) {
+        size_t len = strlen(dsp_parallel_prefix[p]);
+        if (len == 0 || strncmp(op_str, dsp_parallel_prefix[p], len) != 0) {
+            continue;
+        }
+        for (mp_uint_t i = 0; i < MP_ARRAY_SIZE(dsp_parallel_suffix); i++) {
+            if (dsp_parallel_suffix[i][0] != '\0' && strcmp(op_str + len, dsp_parallel_suffix[i]) == 0) {
+                op_hi = 0xfa80 | (i << 4);
+                op_lo = 0xf000 | (p << 4);
+                found = true;
+                break;
+            }
+        }
+    }
+    for (mp_uint_t i = 0; i < MP_ARRAY_SIZE(format_dsp_op_table) && !found; i++) {
+        if (strcmp(op_str, format_dsp_op_table[i].name) == 0) {
+            op_hi = format_dsp_op_table[i].op_hi;
+            op_lo = format_dsp_op_table[i].op_lo;
+            form = format_dsp_op_table[i].form;
+            found = true;
+        }
+    }
+    if (!found || n_args != (form <= DSP_RD_RM_RN ? 3 : 4)) {
+        return false;
+    }
+
+    mp_uint_t r0 = get_arg_reg(emit, op_str, pn_args[0], 15);
+    mp_uint_t r1 = get_arg_reg(emit, op_str, pn_args[1], 15);
+    mp_uint_t r2 = get_arg_reg(emit, op_str, pn_args[2], 15);
+    switch (form) {
+        case DSP_RD_RN_RM:
+            asm_thumb_op32(emit->as, op_hi | r1, op_lo | (r0 << 8) | r2);
+            break;
+        case DSP_RD_RM_RN:
+            asm_thumb_op32(emit->as, op_hi | r2, op_lo | (r0 << 8) | r1);
+            break;
+        case DSP_RD_RN_RM_RA: {
+            mp_uint_t ra = get_arg_reg(emit, op_str, pn_args[3], 15);
+            asm_thumb_op32(emit->as, op_hi | r1, op_lo | (ra << 12) | (r0 << 8) | r2);
+            break;
+        }
+        default: {
+            mp_uint_t rm = get_arg_reg(emit, op_str, pn_args[3], 15);
+            asm_thumb_op32(emit->as, op_hi | r2, op_lo | (r0 << 12) | (r1 << 8) | rm);
+            break;
+        }
+    }
+    return true;
+}
+#endif
+
 // shorthand alias for whether we allow ARMv7-M instructions
 #define ARMV7M MICROPY_EMIT_INLINE_THUMB_ARMV7M
 
@@ -436,7 +608,19 @@ STATIC void emit_inline_thumb_op(emit_inline_asm_t *emit, qstr op, mp_uint_t n_a
     #if MICROPY_EMIT_INLINE_THUMB_FLOAT
     if (op_str[0] == 'v') {
         // floating point operations
-        if (n_args == 2) {
+        if (n_args == 1) {
+            mp_uint_t op_code_hi;
+            if (op == MP_QSTR_vpush) {
+                op_code_hi = 0xed2d;
+            } else if (op == MP_QSTR_vpop) {
+                op_code_hi = 0xecbd;
+            } else {
+                goto unknown_op;
+            }
+            mp_uint_t count;
+            mp_uint_t vd = get_arg_vfpreglist(emit, op_str, pn_args[0], &count);
+            asm_thumb_op32(emit->as, op_code_hi | ((vd & 1) << 6), 0x0a00 | ((vd & 0x1e) << 11) | count);
+        } else if (n_args == 2) {
             mp_uint_t op_code = 0x0ac0, op_code_hi;
             if (op == MP_QSTR_vcmp) {
                 op_code_hi = 0xeeb4;
@@ -505,6 +689,19 @@ STATIC void emit_inline_thumb_op(emit_inline_asm_t *emit, qstr op, mp_uint_t n_a
             } else if (op == MP_QSTR_vstr) {
                 op_code_hi = 0xed80;
                 goto op_vldr_vstr;
+            } else if (op == MP_QSTR_vldm) {
+                op_code_hi = 0xec90;
+                op_vldm_vstm:;
+                // increment after, without writing back to the base register
+                mp_uint_t r_base = get_arg_reg(emit, op_str, pn_args[0], 15);
+                mp_uint_t count;
+                mp_uint_t vd = get_arg_vfpreglist(emit, op_str, pn_args[1], &count);
+                asm_thumb_op32(emit->as,
+                    op_code_hi | r_base | ((vd & 1) << 6),
+                    0x0a00 | ((vd & 0x1e) << 11) | count);
+            } else if (op == MP_QSTR_vstm) {
+                op_code_hi = 0xec80;
+                goto op_vldm_vstm;
             } else {
                 goto unknown_op;
             }
@@ -798,10 +995,21 @@ STATIC void emit_inline_thumb_op(emit_inline_asm_t *emit, qstr op, mp_uint_t n_a
                 mp_uint_t i8 = get_arg_i(emit, op_str, pn_offset, 0xff) >> 2;
                 asm_thumb_op32(emit->as, 0xe840 | r_base, (r_src << 12) | (r_dest << 8) | i8);
             }
+        #if MICROPY_EMIT_INLINE_THUMB_DSP
+        } else if (emit_inline_thumb_dsp_op(emit, op_str, n_args, pn_args)) {
+            // emitted by the helper
+        #endif
         } else {
             goto unknown_op;
         }
 
+    #if MICROPY_EMIT_INLINE_THUMB_DSP
+    } else if (n_args == 4) {
+        if (!emit_inline_thumb_dsp_op(emit, op_str, n_args, pn_args)) {
+            goto unknown_op;
+        }
+    #endif
+
     } else {
         goto unknown_op;
     }
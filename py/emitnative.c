@@ -89,7 +89,9 @@
 #define REG_LOCAL_1 ASM_X64_REG_RBX
 #define REG_LOCAL_2 ASM_X64_REG_R12
 #define REG_LOCAL_3 ASM_X64_REG_R13
-#define REG_LOCAL_NUM (3)
+#define REG_LOCAL_4 ASM_X64_REG_R14
+#define REG_LOCAL_5 ASM_X64_REG_R15
+#define REG_LOCAL_NUM (5)
 
 #define ASM_PASS_COMPUTE    ASM_X64_PASS_COMPUTE
 #define ASM_PASS_EMIT       ASM_X64_PASS_EMIT
@@ -126,6 +128,7 @@
         asm_x64_jcc_label(as, ASM_X64_CC_JE, label); \
     } while (0)
 #define ASM_CALL_IND(as, ptr, idx) asm_x64_call_ind(as, ptr, ASM_X64_REG_RAX)
+#define ASM_CALL_IND_PTR_OFFSET(idx) (2) // the pointer follows the 2-byte movabs opcode
 
 #define ASM_MOV_REG_TO_LOCAL        asm_x64_mov_r64_to_local
 #define ASM_MOV_IMM_TO_REG          asm_x64_mov_i64_to_r64_optimised
@@ -196,6 +199,7 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
     [MP_F_CALL_METHOD_N_KW_VAR] = 3,
     [MP_F_GETITER] = 1,
     [MP_F_ITERNEXT] = 1,
+    [MP_F_FOR_RANGE_NEXT] = 1,
     [MP_F_NLR_PUSH] = 1,
     [MP_F_NLR_POP] = 0,
     [MP_F_NATIVE_RAISE] = 1,
@@ -212,6 +216,10 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
     [MP_F_NEW_CELL] = 1,
     [MP_F_MAKE_CLOSURE_FROM_RAW_CODE] = 3,
     [MP_F_SETUP_CODE_STATE] = 5,
+    [MP_F_NATIVE_YIELD_FROM] = 2,
+#if MICROPY_PY_BUILTINS_FLOAT
+    [MP_F_NATIVE_FLOAT_OP] = 3,
+#endif
 };
 
 #define EXPORT_FUN(name) emit_native_x86_##name
@@ -271,6 +279,7 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
         asm_x86_jcc_label(as, ASM_X86_CC_JE, label); \
     } while (0)
 #define ASM_CALL_IND(as, ptr, idx) asm_x86_call_ind(as, ptr, mp_f_n_args[idx], ASM_X86_REG_EAX)
+#define ASM_CALL_IND_PTR_OFFSET(idx) (mp_f_n_args[idx] + 1) // after a push for each arg and the mov opcode
 
 #define ASM_MOV_REG_TO_LOCAL        asm_x86_mov_r32_to_local
 #define ASM_MOV_IMM_TO_REG          asm_x86_mov_i32_to_r32
@@ -329,7 +338,13 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
 #define REG_LOCAL_1 ASM_THUMB_REG_R4
 #define REG_LOCAL_2 ASM_THUMB_REG_R5
 #define REG_LOCAL_3 ASM_THUMB_REG_R6
-#define REG_LOCAL_NUM (3)
+// r8-r11 can only be moved to and from, and are saved by the emitter
+#define REG_LOCAL_4 ASM_THUMB_REG_R8
+#define REG_LOCAL_5 ASM_THUMB_REG_R9
+#define REG_LOCAL_6 ASM_THUMB_REG_R10
+#define REG_LOCAL_7 ASM_THUMB_REG_R11
+#define REG_LOCAL_NUM (7)
+#define REG_LOCAL_NUM_DIRECT (3)
 
 #define ASM_PASS_COMPUTE    ASM_THUMB_PASS_COMPUTE
 #define ASM_PASS_EMIT       ASM_THUMB_PASS_EMIT
@@ -389,13 +404,13 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
 #define ASM_MUL_REG_REG(as, reg_dest, reg_src) asm_thumb_format_4((as), ASM_THUMB_FORMAT_4_MUL, (reg_dest), (reg_src))
 
 #define ASM_LOAD_REG_REG(as, reg_dest, reg_base) asm_thumb_ldr_rlo_rlo_i5((as), (reg_dest), (reg_base), 0)
-#define ASM_LOAD_REG_REG_OFFSET(as, reg_dest, reg_base, word_offset) asm_thumb_ldr_rlo_rlo_i5((as), (reg_dest), (reg_base), (word_offset))
+#define ASM_LOAD_REG_REG_OFFSET(as, reg_dest, reg_base, word_offset) asm_thumb_ldr_reg_reg_i12_optimised((as), (reg_dest), (reg_base), (word_offset))
 #define ASM_LOAD8_REG_REG(as, reg_dest, reg_base) asm_thumb_ldrb_rlo_rlo_i5((as), (reg_dest), (reg_base), 0)
 #define ASM_LOAD16_REG_REG(as, reg_dest, reg_base) asm_thumb_ldrh_rlo_rlo_i5((as), (reg_dest), (reg_base), 0)
 #define ASM_LOAD32_REG_REG(as, reg_dest, reg_base) asm_thumb_ldr_rlo_rlo_i5((as), (reg_dest), (reg_base), 0)
 
 #define ASM_STORE_REG_REG(as, reg_src, reg_base) asm_thumb_str_rlo_rlo_i5((as), (reg_src), (reg_base), 0)
-#define ASM_STORE_REG_REG_OFFSET(as, reg_src, reg_base, word_offset) asm_thumb_str_rlo_rlo_i5((as), (reg_src), (reg_base), (word_offset))
+#define ASM_STORE_REG_REG_OFFSET(as, reg_src, reg_base, word_offset) asm_thumb_str_reg_reg_i12_optimised((as), (reg_src), (reg_base), (word_offset))
 #define ASM_STORE8_REG_REG(as, reg_src, reg_base) asm_thumb_strb_rlo_rlo_i5((as), (reg_src), (reg_base), 0)
 #define ASM_STORE16_REG_REG(as, reg_src, reg_base) asm_thumb_strh_rlo_rlo_i5((as), (reg_src), (reg_base), 0)
 #define ASM_STORE32_REG_REG(as, reg_src, reg_base) asm_thumb_str_rlo_rlo_i5((as), (reg_src), (reg_base), 0)
@@ -463,7 +478,7 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
 
 #define ASM_MOV_REG_TO_LOCAL(as, reg, local_num) asm_arm_mov_local_reg(as, (local_num), (reg))
 #define ASM_MOV_IMM_TO_REG(as, imm, reg) asm_arm_mov_reg_i32(as, (reg), (imm))
-#define ASM_MOV_ALIGNED_IMM_TO_REG(as, imm, reg) asm_arm_mov_reg_i32(as, (reg), (imm))
+#define ASM_MOV_ALIGNED_IMM_TO_REG(as, imm, reg) asm_arm_mov_reg_i32_aligned(as, (reg), (imm))
 #define ASM_MOV_IMM_TO_LOCAL_USING(as, imm, local_num, reg_temp) \
     do { \
         asm_arm_mov_reg_i32(as, (reg_temp), (imm)); \
@@ -500,6 +515,23 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
 
 #endif
 
+// Callee-saved registers that locals can be kept in, chosen per function by
+// emit_native_alloc_local_regs.  The first REG_LOCAL_NUM_DIRECT can be used by
+// any instruction, the rest only with ASM_MOV_REG_REG.
+#ifndef REG_LOCAL_NUM_DIRECT
+#define REG_LOCAL_NUM_DIRECT (REG_LOCAL_NUM)
+#endif
+
+STATIC const byte reg_local_table[REG_LOCAL_NUM] = {
+    REG_LOCAL_1, REG_LOCAL_2, REG_LOCAL_3,
+    #if REG_LOCAL_NUM > 3
+    REG_LOCAL_4, REG_LOCAL_5,
+    #endif
+    #if REG_LOCAL_NUM > 5
+    REG_LOCAL_6, REG_LOCAL_7,
+    #endif
+};
+
 #define EMIT_NATIVE_VIPER_TYPE_ERROR(emit, ...) do { \
         *emit->error_slot = mp_obj_new_exception_msg_varg(&mp_type_ViperTypeError, __VA_ARGS__); \
     } while (0)
@@ -521,6 +553,9 @@ typedef enum {
     VTYPE_PTR8 = 0x00 | MP_NATIVE_TYPE_PTR8,
     VTYPE_PTR16 = 0x00 | MP_NATIVE_TYPE_PTR16,
     VTYPE_PTR32 = 0x00 | MP_NATIVE_TYPE_PTR32,
+    VTYPE_PTR16S = 0x00 | MP_NATIVE_TYPE_PTR16S,
+    VTYPE_PTRF = 0x00 | MP_NATIVE_TYPE_PTRF,
+    VTYPE_FLOAT = 0x00 | MP_NATIVE_TYPE_FLOAT, // bits of a single-precision float
 
     VTYPE_PTR_NONE = 0x50 | MP_NATIVE_TYPE_PTR,
 
@@ -538,10 +573,21 @@ STATIC qstr vtype_to_qstr(vtype_kind_t vtype) {
         case VTYPE_PTR8: return MP_QSTR_ptr8;
         case VTYPE_PTR16: return MP_QSTR_ptr16;
         case VTYPE_PTR32: return MP_QSTR_ptr32;
+        case VTYPE_PTR16S: return MP_QSTR_ptr16s;
+        case VTYPE_PTRF: return MP_QSTR_ptrf;
+        case VTYPE_FLOAT: return MP_QSTR_float;
         case VTYPE_PTR_NONE: default: return MP_QSTR_None;
     }
 }
 
+// whether a value of type vtype_value can be stored through a vtype_base pointer
+STATIC bool viper_can_store(vtype_kind_t vtype_base, vtype_kind_t vtype_value) {
+    if (vtype_base == VTYPE_PTRF) {
+        return vtype_value == VTYPE_FLOAT;
+    }
+    return vtype_value == VTYPE_BOOL || vtype_value == VTYPE_INT || vtype_value == VTYPE_UINT;
+}
+
 typedef struct _stack_info_t {
     vtype_kind_t vtype;
     stack_info_kind_t kind;
@@ -551,6 +597,30 @@ typedef struct _stack_info_t {
     } data;
 } stack_info_t;
 
+// a try/except, try/finally or with block that is being compiled
+typedef enum {
+    EXC_STACK_EXCEPT,
+    EXC_STACK_FINALLY,
+    EXC_STACK_WITH,
+} exc_stack_kind_t;
+
+typedef struct _exc_stack_entry_t {
+    exc_stack_kind_t kind;
+    bool is_active; // whether the handler catches exceptions raised at this point
+    uint16_t label; // compiler label of the handler
+    uint16_t handler_id; // private label of the handler, stored in the state to jump to it
+    uint16_t with_base; // stack slot of __exit__
+} exc_stack_entry_t;
+
+// a load or store of a local, as seen by the first pass
+typedef struct _local_use_t {
+    uint16_t local_num;
+    int16_t loop_delta; // change in the depth of loops since the previous use
+} local_use_t;
+
+// labels not yet assigned have a position of 0xffff, past the end of the log
+#define LOCAL_USE_LOG_MAX (0xffff)
+
 struct _emit_t {
     mp_obj_t *error_slot;
     int pass;
@@ -562,6 +632,21 @@ struct _emit_t {
     mp_uint_t local_vtype_alloc;
     vtype_kind_t *local_vtype;
 
+    // where each local is kept: if less than REG_LOCAL_NUM then the register
+    // reg_local_table[local_loc[i]], otherwise (for viper) the C-stack local
+    // local_loc[i] - REG_LOCAL_NUM, or else (not viper) its slot in the state
+    uint16_t *local_loc;
+    mp_uint_t num_local_regs;
+    int reg_save_start; // C-stack locals keeping the registers not in REG_LOCAL_NUM_DIRECT
+
+    // the uses of locals in the first pass, and the position in them of each
+    // label, from which emit_native_alloc_local_regs weighs the locals
+    mp_uint_t use_log_alloc;
+    mp_uint_t use_log_len;
+    local_use_t *use_log;
+    int use_log_pending_delta;
+    uint16_t *label_use_pos;
+
     mp_uint_t stack_info_alloc;
     stack_info_t *stack_info;
     vtype_kind_t saved_stack_vtype;
@@ -574,6 +659,27 @@ struct _emit_t {
 
     bool last_emit_was_return_value;
 
+    mp_uint_t exc_stack_alloc;
+    mp_uint_t exc_stack_size;
+    exc_stack_entry_t *exc_stack;
+    int nlr_start; // C-stack local holding the nlr_buf_t of the global exception handler
+
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    // the words of the code to fix up when it is loaded from a .mpy file
+    mp_uint_t reloc_alloc;
+    mp_uint_t n_reloc;
+    mp_native_reloc_t *relocs;
+    #endif
+
+    // labels after those of the compiler belong to this emitter; index max_num_labels
+    // is a dummy one used before the private labels are counted
+    mp_uint_t max_num_labels;
+    mp_uint_t num_labels_alloc;
+    mp_uint_t num_dispatch_ids;
+    mp_uint_t num_local_labels;
+    mp_uint_t dispatch_label_base;
+    mp_uint_t local_label_base;
+
     scope_t *scope;
 
     ASM_T *as;
@@ -582,14 +688,25 @@ struct _emit_t {
 emit_t *EXPORT_FUN(new)(mp_obj_t *error_slot, mp_uint_t max_num_labels) {
     emit_t *emit = m_new0(emit_t, 1);
     emit->error_slot = error_slot;
-    emit->as = ASM_NEW(max_num_labels);
+    emit->max_num_labels = max_num_labels;
+    emit->num_labels_alloc = max_num_labels + 1;
+    emit->as = ASM_NEW(emit->num_labels_alloc);
     return emit;
 }
 
 void EXPORT_FUN(free)(emit_t *emit) {
     ASM_FREE(emit->as, false);
     m_del(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc);
+    m_del(uint16_t, emit->local_loc, emit->local_vtype_alloc);
+    m_del(local_use_t, emit->use_log, emit->use_log_alloc);
+    if (emit->label_use_pos != NULL) {
+        m_del(uint16_t, emit->label_use_pos, emit->max_num_labels);
+    }
     m_del(stack_info_t, emit->stack_info, emit->stack_info_alloc);
+    m_del(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc);
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    m_del(mp_native_reloc_t, emit->relocs, emit->reloc_alloc);
+    #endif
     m_del_obj(emit_t, emit);
 }
 
@@ -610,6 +727,11 @@ STATIC void emit_native_set_native_type(emit_t *emit, mp_uint_t op, mp_uint_t ar
                 case MP_QSTR_ptr8: type = VTYPE_PTR8; break;
                 case MP_QSTR_ptr16: type = VTYPE_PTR16; break;
                 case MP_QSTR_ptr32: type = VTYPE_PTR32; break;
+                case MP_QSTR_ptr16s: type = VTYPE_PTR16S; break;
+                #if MICROPY_PY_BUILTINS_FLOAT
+                case MP_QSTR_ptrf: type = VTYPE_PTRF; break;
+                case MP_QSTR_float: type = VTYPE_FLOAT; break;
+                #endif
                 default: EMIT_NATIVE_VIPER_TYPE_ERROR(emit, "unknown type '%q'", arg2); return;
             }
             if (op == MP_EMIT_NATIVE_TYPE_RETURN) {
@@ -630,6 +752,338 @@ STATIC void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num);
 
 #define STATE_START (sizeof(mp_code_state_t) / sizeof(mp_uint_t))
 
+// Functions with a try or with block, and generators, push a single nlr_buf_t
+// on entry and jump to the active handler from there.  Locals are then kept in
+// the state, not in registers, because longjmp restores registers.  The start
+// of such a state holds these slots, followed by one slot per nesting level of
+// try/with blocks: the caught exception for an except block (so that a bare
+// raise can re-raise it), or where to carry on unwinding after a finally block.
+#define NEED_GLOBAL_EXC_HANDLER(emit) (!(emit)->do_viper_types \
+    && ((emit)->scope->exc_stack_size > 0 || ((emit)->scope->scope_flags & MP_SCOPE_FLAG_GENERATOR)))
+#define CAN_USE_REGS_FOR_LOCALS(emit) (!NEED_GLOBAL_EXC_HANDLER(emit))
+#define IS_NATIVE_GENERATOR(emit) (!(emit)->do_viper_types && ((emit)->scope->scope_flags & MP_SCOPE_FLAG_GENERATOR))
+
+#define STATE_EXC_VAL (STATE_START + 0) // exception being handled, or MP_OBJ_SENTINEL when unwinding
+#define STATE_HANDLER (STATE_START + 1) // id of the active handler, 0 if there is none
+#define STATE_RET_VAL (STATE_START + 2) // return value while finally blocks run
+#define STATE_RESUME (STATE_START + 3) // id where a generator resumes
+#define STATE_EXC_LEVEL(level) (STATE_START + 4 + (level))
+#define STATE_NUM_EXC_SLOTS(scope) (4 + (scope)->exc_stack_size)
+
+#if MICROPY_DYNAMIC_COMPILER
+// the nlr_buf_t of the target, which needn't be that of this machine: prev,
+// ret_val and the registers saved by nlr_push
+#if N_X64
+#define NLR_BUF_WORDS (2 + 8)
+#elif N_X86
+#define NLR_BUF_WORDS (2 + 6)
+#else
+#define NLR_BUF_WORDS (2 + 10)
+#endif
+#else
+#define NLR_BUF_WORDS (sizeof(nlr_buf_t) / sizeof(mp_uint_t))
+#endif
+#define NLR_BUF_IDX_RET_VAL (1)
+
+// a generator is given its code_state, which holds all its state, in this register
+#define REG_GENERATOR_STATE (REG_LOCAL_3)
+// C-stack local of a generator holding the exception thrown into it
+#define LOCAL_IDX_GEN_THROW (NLR_BUF_WORDS)
+
+// The labels of the emitter follow those of the compiler.  First come those
+// that the global exception handler can jump to, given their id in REG_ARG_1:
+// the start of the body, the handlers, where a generator resumes, and where
+// unwinding carries on after a finally block.  Then come local labels.
+#define DISPATCH_ID_START (0)
+#define LOCAL_LABEL_CATCH (0)
+#define LOCAL_LABEL_DISPATCH (1)
+
+STATIC mp_uint_t emit_native_new_dispatch_id(emit_t *emit) {
+    return emit->num_dispatch_ids++;
+}
+
+STATIC mp_uint_t emit_native_new_local_label(emit_t *emit) {
+    return emit->num_local_labels++;
+}
+
+// before the labels are counted they all share the same dummy one
+STATIC mp_uint_t emit_native_dispatch_label(emit_t *emit, mp_uint_t id) {
+    if (emit->pass < MP_PASS_CODE_SIZE) {
+        return emit->max_num_labels;
+    }
+    return emit->dispatch_label_base + id;
+}
+
+STATIC mp_uint_t emit_native_local_label(emit_t *emit, mp_uint_t id) {
+    if (emit->pass < MP_PASS_CODE_SIZE) {
+        return emit->max_num_labels;
+    }
+    return emit->local_label_base + id;
+}
+
+STATIC void emit_native_private_label_assign(emit_t *emit, mp_uint_t label) {
+    if (emit->pass >= MP_PASS_CODE_SIZE) {
+        ASM_LABEL_ASSIGN(emit->as, label);
+    }
+}
+
+#if MICROPY_PERSISTENT_CODE_SAVE
+// Records that the code at offset holds a value to fix up on loading.
+STATIC void emit_native_reloc_at(emit_t *emit, mp_uint_t offset, mp_native_reloc_kind_t kind, mp_uint_t arg) {
+    if (emit->pass != MP_PASS_EMIT) {
+        return;
+    }
+    if (emit->n_reloc >= emit->reloc_alloc) {
+        emit->relocs = m_renew(mp_native_reloc_t, emit->relocs, emit->reloc_alloc, emit->reloc_alloc + 16);
+        emit->reloc_alloc += 16;
+    }
+    mp_native_reloc_t *r = &emit->relocs[emit->n_reloc++];
+    r->offset = offset;
+    r->kind = kind;
+    r->arg = arg;
+}
+
+// the value is the word just emitted, by ASM_MOV_ALIGNED_IMM_TO_REG
+#define EMIT_NATIVE_RELOC(emit, kind, arg) \
+    emit_native_reloc_at((emit), ASM_GET_CODE_POS((emit)->as) - ASM_WORD_SIZE, (kind), (arg))
+#else
+#define EMIT_NATIVE_RELOC(emit, kind, arg) (void)0
+#endif
+
+STATIC void emit_native_call_ind(emit_t *emit, mp_fun_kind_t fun_kind) {
+    #if MICROPY_PERSISTENT_CODE_SAVE && defined(ASM_CALL_IND_PTR_OFFSET)
+    // the call is made through a pointer in the code, not through mp_fun_table
+    emit_native_reloc_at(emit, ASM_GET_CODE_POS(emit->as) + ASM_CALL_IND_PTR_OFFSET(fun_kind),
+        MP_NATIVE_RELOC_FUN_TABLE, 1 + fun_kind);
+    #endif
+    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+}
+
+#if N_THUMB || N_ARM
+STATIC void emit_native_mov_reg_fun_table(emit_t *emit, int reg_dest) {
+    ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, (mp_uint_t)mp_fun_table, reg_dest);
+    EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_FUN_TABLE, 0);
+}
+#endif
+
+STATIC void emit_native_mov_reg_qstr(emit_t *emit, int reg_dest, qstr qst) {
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, qst, reg_dest);
+    EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_QSTR, qst);
+    #else
+    ASM_MOV_IMM_TO_REG(emit->as, qst, reg_dest);
+    #endif
+}
+
+// For an immediate object.  Small ints and the null and sentinel values are
+// the same in every VM, anything else has to be relocated.
+STATIC void emit_native_mov_reg_obj(emit_t *emit, int reg_dest, mp_uint_t obj) {
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    if (!MP_OBJ_IS_SMALL_INT((mp_obj_t)obj) && (mp_obj_t)obj != MP_OBJ_NULL && (mp_obj_t)obj != MP_OBJ_SENTINEL) {
+        ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, obj, reg_dest);
+        if (MP_OBJ_IS_QSTR((mp_obj_t)obj)) {
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_QSTR_OBJ, MP_OBJ_QSTR_VALUE((mp_obj_t)obj));
+        } else if ((mp_obj_t)obj == mp_const_none) {
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_CONST, 0);
+        } else if ((mp_obj_t)obj == mp_const_false) {
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_CONST, 1);
+        } else if ((mp_obj_t)obj == mp_const_true) {
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_CONST, 2);
+        } else if ((mp_obj_t)obj == MP_OBJ_FROM_PTR(&mp_const_ellipsis_obj)) {
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_CONST, 3);
+        } else {
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_OBJ, obj);
+        }
+        return;
+    }
+    #endif
+    ASM_MOV_IMM_TO_REG(emit->as, obj, reg_dest);
+}
+
+// Access a word of the code_state, given as a local number of the C stack: for
+// generators the code_state is on the heap, otherwise it starts the C stack frame.
+STATIC void emit_native_mov_state_reg(emit_t *emit, int local_num, int reg_src) {
+    if (IS_NATIVE_GENERATOR(emit)) {
+        ASM_STORE_REG_REG_OFFSET(emit->as, reg_src, REG_GENERATOR_STATE, local_num);
+    } else {
+        ASM_MOV_REG_TO_LOCAL(emit->as, reg_src, local_num);
+    }
+}
+
+STATIC void emit_native_mov_reg_state(emit_t *emit, int reg_dest, int local_num) {
+    if (IS_NATIVE_GENERATOR(emit)) {
+        ASM_LOAD_REG_REG_OFFSET(emit->as, reg_dest, REG_GENERATOR_STATE, local_num);
+    } else {
+        ASM_MOV_LOCAL_TO_REG(emit->as, local_num, reg_dest);
+    }
+}
+
+STATIC void emit_native_mov_state_imm_via(emit_t *emit, int local_num, mp_uint_t imm, int reg_temp) {
+    if (IS_NATIVE_GENERATOR(emit)) {
+        ASM_MOV_IMM_TO_REG(emit->as, imm, reg_temp);
+        ASM_STORE_REG_REG_OFFSET(emit->as, reg_temp, REG_GENERATOR_STATE, local_num);
+    } else {
+        ASM_MOV_IMM_TO_LOCAL_USING(emit->as, imm, local_num, reg_temp);
+    }
+}
+
+STATIC void emit_native_mov_state_obj_via(emit_t *emit, int local_num, mp_uint_t obj, int reg_temp) {
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    if (!MP_OBJ_IS_SMALL_INT((mp_obj_t)obj)) {
+        emit_native_mov_reg_obj(emit, reg_temp, obj);
+        emit_native_mov_state_reg(emit, local_num, reg_temp);
+        return;
+    }
+    #endif
+    emit_native_mov_state_imm_via(emit, local_num, obj, reg_temp);
+}
+
+STATIC void emit_native_mov_reg_state_addr(emit_t *emit, int reg_dest, int local_num) {
+    if (IS_NATIVE_GENERATOR(emit)) {
+        ASM_MOV_IMM_TO_REG(emit->as, local_num * ASM_WORD_SIZE, reg_dest);
+        ASM_ADD_REG_REG(emit->as, reg_dest, REG_GENERATOR_STATE);
+    } else {
+        ASM_MOV_LOCAL_ADDR_TO_REG(emit->as, local_num, reg_dest);
+    }
+}
+
+STATIC void emit_native_push_global_nlr(emit_t *emit) {
+    ASM_MOV_LOCAL_ADDR_TO_REG(emit->as, emit->nlr_start, REG_ARG_1);
+    emit_native_call_ind(emit, MP_F_NLR_PUSH);
+    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, emit_native_local_label(emit, LOCAL_LABEL_CATCH));
+}
+
+// on entering or resuming a generator, raise the exception thrown into it, if any
+STATIC void emit_native_check_gen_throw(emit_t *emit) {
+    mp_uint_t label_no_throw = emit_native_local_label(emit, emit_native_new_local_label(emit));
+    // ASM_JUMP_IF_REG_ZERO may only test the low byte, so compare the whole word
+    ASM_MOV_LOCAL_TO_REG(emit->as, LOCAL_IDX_GEN_THROW, REG_ARG_1);
+    ASM_MOV_IMM_TO_REG(emit->as, (mp_uint_t)MP_OBJ_NULL, REG_ARG_2);
+    ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, label_no_throw);
+    ASM_MOV_REG_TO_LOCAL(emit->as, REG_ARG_2, LOCAL_IDX_GEN_THROW);
+    emit_native_call_ind(emit, MP_F_NATIVE_RAISE);
+    emit_native_private_label_assign(emit, label_no_throw);
+}
+
+// In the first pass record each load and store of a local, along with how many
+// loops (backward jumps) it starts or ends, for emit_native_alloc_local_regs.
+STATIC void emit_native_log_use(emit_t *emit, mp_uint_t local_num) {
+    if (emit->pass != MP_PASS_STACK_SIZE || emit->use_log_len >= LOCAL_USE_LOG_MAX) {
+        return;
+    }
+    if (emit->use_log_len >= emit->use_log_alloc) {
+        mp_uint_t alloc = emit->use_log_alloc * 2 + 16;
+        emit->use_log = m_renew(local_use_t, emit->use_log, emit->use_log_alloc, alloc);
+        emit->use_log_alloc = alloc;
+    }
+    local_use_t *use = &emit->use_log[emit->use_log_len++];
+    use->local_num = local_num;
+    use->loop_delta = emit->use_log_pending_delta;
+    emit->use_log_pending_delta = 0;
+}
+
+STATIC void emit_native_log_label(emit_t *emit, mp_uint_t label) {
+    if (emit->pass == MP_PASS_STACK_SIZE && label < emit->max_num_labels) {
+        emit->label_use_pos[label] = emit->use_log_len;
+    }
+}
+
+STATIC void emit_native_log_jump(emit_t *emit, mp_uint_t label) {
+    if (emit->pass == MP_PASS_STACK_SIZE && label < emit->max_num_labels) {
+        mp_uint_t pos = emit->label_use_pos[label];
+        if (pos < emit->use_log_len) {
+            // a loop from the label to here
+            emit->use_log[pos].loop_delta += 1;
+            emit->use_log_pending_delta -= 1;
+        }
+    }
+}
+
+// Choose where each local is kept, returning the number kept in memory.  All
+// are in memory for the first pass, which logs their uses.  Then the locals
+// weighing most, each use counting 8 times more for each loop it is in, get
+// the registers, and keep them for the last pass.
+STATIC mp_uint_t emit_native_alloc_local_regs(emit_t *emit) {
+    scope_t *scope = emit->scope;
+    if (emit->pass == MP_PASS_STACK_SIZE) {
+        if (emit->label_use_pos == NULL) {
+            emit->label_use_pos = m_new(uint16_t, emit->max_num_labels);
+        }
+        memset(emit->label_use_pos, 0xff, emit->max_num_labels * sizeof(uint16_t));
+        emit->use_log_len = 0;
+        emit->use_log_pending_delta = 0;
+        emit->num_local_regs = 0;
+        for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+            emit->local_loc[i] = REG_LOCAL_NUM;
+        }
+    } else if (emit->pass == MP_PASS_CODE_SIZE) {
+        for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+            emit->local_loc[i] = REG_LOCAL_NUM;
+        }
+        emit->num_local_regs = 0;
+        if (CAN_USE_REGS_FOR_LOCALS(emit) && scope->num_locals > 0) {
+            mp_uint_t *weight = m_new0(mp_uint_t, scope->num_locals);
+            mp_int_t depth = 0;
+            for (mp_uint_t i = 0; i < emit->use_log_len; i++) {
+                depth += emit->use_log[i].loop_delta;
+                weight[emit->use_log[i].local_num] += 1 << (3 * MIN(MAX(depth, 0), 4));
+            }
+            while (emit->num_local_regs < REG_LOCAL_NUM) {
+                mp_uint_t best = scope->num_locals;
+                for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+                    if (weight[i] > 0 && (best == scope->num_locals || weight[i] > weight[best])) {
+                        best = i;
+                    }
+                }
+                if (best == scope->num_locals) {
+                    break;
+                }
+                emit->local_loc[best] = emit->num_local_regs++;
+                weight[best] = 0;
+            }
+            m_del(mp_uint_t, weight, scope->num_locals);
+        }
+    }
+
+    // the rest are numbered in order
+    mp_uint_t num_mem_locals = 0;
+    for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+        if (emit->local_loc[i] >= REG_LOCAL_NUM) {
+            emit->local_loc[i] = REG_LOCAL_NUM + num_mem_locals++;
+        }
+    }
+    return num_mem_locals;
+}
+
+#if REG_LOCAL_NUM_DIRECT < REG_LOCAL_NUM
+// The registers past REG_LOCAL_NUM_DIRECT aren't saved by ASM_ENTRY, so those
+// in use are kept in C-stack locals from reg_save_start.
+STATIC mp_uint_t emit_native_num_saved_regs(emit_t *emit) {
+    return emit->num_local_regs > REG_LOCAL_NUM_DIRECT ? emit->num_local_regs - REG_LOCAL_NUM_DIRECT : 0;
+}
+
+STATIC void emit_native_save_local_regs(emit_t *emit, int reg_temp) {
+    for (mp_uint_t i = REG_LOCAL_NUM_DIRECT; i < emit->num_local_regs; i++) {
+        ASM_MOV_REG_REG(emit->as, reg_temp, reg_local_table[i]);
+        ASM_MOV_REG_TO_LOCAL(emit->as, reg_temp, emit->reg_save_start + i - REG_LOCAL_NUM_DIRECT);
+    }
+}
+#else
+#define emit_native_num_saved_regs(emit) (0)
+#define emit_native_save_local_regs(emit, reg_temp)
+#endif
+
+// return from the function, with the value in REG_RET
+STATIC void emit_native_exit(emit_t *emit) {
+    #if REG_LOCAL_NUM_DIRECT < REG_LOCAL_NUM
+    for (mp_uint_t i = REG_LOCAL_NUM_DIRECT; i < emit->num_local_regs; i++) {
+        ASM_MOV_LOCAL_TO_REG(emit->as, emit->reg_save_start + i - REG_LOCAL_NUM_DIRECT, REG_TEMP1);
+        ASM_MOV_REG_REG(emit->as, reg_local_table[i], REG_TEMP1);
+    }
+    #endif
+    ASM_EXIT(emit->as);
+}
+
 STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     DEBUG_printf("start_pass(pass=%u, scope=%p)\n", pass, scope);
 
@@ -638,12 +1092,37 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
     emit->stack_size = 0;
     emit->last_emit_was_return_value = false;
     emit->scope = scope;
+    emit->exc_stack_size = 0;
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    emit->n_reloc = 0;
+    #endif
 
-    // allocate memory for keeping track of the types of locals
+    // the previous pass counted the private labels, so make room for them
+    if (pass >= MP_PASS_CODE_SIZE) {
+        emit->dispatch_label_base = emit->max_num_labels + 1;
+        emit->local_label_base = emit->dispatch_label_base + emit->num_dispatch_ids;
+        if (emit->local_label_base + emit->num_local_labels > emit->num_labels_alloc) {
+            ASM_FREE(emit->as, false);
+            emit->num_labels_alloc = emit->local_label_base + emit->num_local_labels;
+            emit->as = ASM_NEW(emit->num_labels_alloc);
+        }
+    }
+    emit->num_dispatch_ids = DISPATCH_ID_START + 1;
+    emit->num_local_labels = LOCAL_LABEL_DISPATCH + 1;
+
+    // allocate memory for keeping track of try and with blocks
+    if (emit->exc_stack_alloc < scope->exc_stack_size) {
+        emit->exc_stack = m_renew(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc, scope->exc_stack_size);
+        emit->exc_stack_alloc = scope->exc_stack_size;
+    }
+
+    // allocate memory for keeping track of the types and places of locals
     if (emit->local_vtype_alloc < scope->num_locals) {
         emit->local_vtype = m_renew(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc, scope->num_locals);
+        emit->local_loc = m_renew(uint16_t, emit->local_loc, emit->local_vtype_alloc, scope->num_locals);
         emit->local_vtype_alloc = scope->num_locals;
     }
+    mp_uint_t num_mem_locals = emit_native_alloc_local_regs(emit);
 
     // allocate memory for keeping track of the objects on the stack
     // XXX don't know stack size on entry, and it should be maximum over all scopes
@@ -691,67 +1170,103 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
             return;
         }
 
-        // entry to function
-        int num_locals = 0;
-        if (pass > MP_PASS_SCOPE) {
-            num_locals = scope->num_locals - REG_LOCAL_NUM;
-            if (num_locals < 0) {
-                num_locals = 0;
-            }
-            emit->stack_start = num_locals;
-            num_locals += scope->stack_size;
-        }
-        ASM_ENTRY(emit->as, num_locals);
+        // entry to function: the C stack holds the locals not in registers,
+        // then the value stack, then any saved registers
+        emit->stack_start = num_mem_locals;
+        emit->reg_save_start = num_mem_locals + scope->stack_size;
+        ASM_ENTRY(emit->as, emit->reg_save_start + emit_native_num_saved_regs(emit));
+        emit_native_save_local_regs(emit, REG_LOCAL_1);
 
         // TODO don't load r7 if we don't need it
         #if N_THUMB
-        asm_thumb_mov_reg_i32(emit->as, ASM_THUMB_REG_R7, (mp_uint_t)mp_fun_table);
+        emit_native_mov_reg_fun_table(emit, ASM_THUMB_REG_R7);
         #elif N_ARM
-        asm_arm_mov_reg_i32(emit->as, ASM_ARM_REG_R7, (mp_uint_t)mp_fun_table);
+        emit_native_mov_reg_fun_table(emit, ASM_ARM_REG_R7);
         #endif
 
-        #if N_X86
         for (int i = 0; i < scope->num_pos_args; i++) {
-            if (i == 0) {
-                asm_x86_mov_arg_to_r32(emit->as, i, REG_LOCAL_1);
-            } else if (i == 1) {
-                asm_x86_mov_arg_to_r32(emit->as, i, REG_LOCAL_2);
-            } else if (i == 2) {
-                asm_x86_mov_arg_to_r32(emit->as, i, REG_LOCAL_3);
+            mp_uint_t loc = emit->local_loc[i];
+            #if N_X86
+            if (loc < REG_LOCAL_NUM) {
+                asm_x86_mov_arg_to_r32(emit->as, i, reg_local_table[loc]);
             } else {
                 asm_x86_mov_arg_to_r32(emit->as, i, REG_TEMP0);
-                asm_x86_mov_r32_to_local(emit->as, REG_TEMP0, i - REG_LOCAL_NUM);
+                asm_x86_mov_r32_to_local(emit->as, REG_TEMP0, loc - REG_LOCAL_NUM);
             }
-        }
-        #else
-        for (int i = 0; i < scope->num_pos_args; i++) {
-            if (i == 0) {
-                ASM_MOV_REG_REG(emit->as, REG_LOCAL_1, REG_ARG_1);
-            } else if (i == 1) {
-                ASM_MOV_REG_REG(emit->as, REG_LOCAL_2, REG_ARG_2);
-            } else if (i == 2) {
-                ASM_MOV_REG_REG(emit->as, REG_LOCAL_3, REG_ARG_3);
-            } else if (i == 3) {
-                ASM_MOV_REG_TO_LOCAL(emit->as, REG_ARG_4, i - REG_LOCAL_NUM);
+            #else
+            static const byte reg_arg_table[4] = { REG_ARG_1, REG_ARG_2, REG_ARG_3, REG_ARG_4 };
+            if (loc < REG_LOCAL_NUM) {
+                ASM_MOV_REG_REG(emit->as, reg_local_table[loc], reg_arg_table[i]);
             } else {
-                // TODO not implemented
-                assert(0);
+                ASM_MOV_REG_TO_LOCAL(emit->as, reg_arg_table[i], loc - REG_LOCAL_NUM);
             }
+            #endif
         }
-        #endif
 
     } else {
         // work out size of state (locals plus stack)
         emit->n_state = scope->num_locals + scope->stack_size;
+        if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+            // the value stack follows the exception slots in the state
+            emit->n_state += STATE_NUM_EXC_SLOTS(scope);
+            emit->stack_start = STATE_EXC_LEVEL(scope->exc_stack_size);
+        }
+
+        if (IS_NATIVE_GENERATOR(emit)) {
+            // The code of a generator begins with the size of its state and the
+            // offset to its prelude, which the generator object is set up from.
+            // The function following them resumes the generator, taking the
+            // code_state and the value to throw in, like mp_execute_bytecode.
+            ASM_DATA(emit->as, ASM_WORD_SIZE, emit->n_state);
+            ASM_DATA(emit->as, ASM_WORD_SIZE, emit->prelude_offset);
+
+            // the C stack holds the nlr_buf_t and the value thrown in
+            emit->nlr_start = 0;
+            ASM_ENTRY(emit->as, NLR_BUF_WORDS + 1);
+
+            #if N_THUMB
+            emit_native_mov_reg_fun_table(emit, ASM_THUMB_REG_R7);
+            #elif N_ARM
+            emit_native_mov_reg_fun_table(emit, ASM_ARM_REG_R7);
+            #endif
+
+            #if N_X86
+            asm_x86_mov_arg_to_r32(emit->as, 0, REG_GENERATOR_STATE);
+            asm_x86_mov_arg_to_r32(emit->as, 1, REG_TEMP0);
+            ASM_MOV_REG_TO_LOCAL(emit->as, REG_TEMP0, LOCAL_IDX_GEN_THROW);
+            #else
+            ASM_MOV_REG_REG(emit->as, REG_GENERATOR_STATE, REG_ARG_1);
+            ASM_MOV_REG_TO_LOCAL(emit->as, REG_ARG_2, LOCAL_IDX_GEN_THROW);
+            #endif
+
+            // jump to where the generator left off, starting at PRIVATE_LABEL_START
+            emit_native_push_global_nlr(emit);
+            emit_native_mov_reg_state(emit, REG_ARG_1, STATE_RESUME);
+            ASM_JUMP(emit->as, emit_native_local_label(emit, LOCAL_LABEL_DISPATCH));
+            emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, DISPATCH_ID_START));
+            emit_native_check_gen_throw(emit);
+
+            // set the type of closed over variables
+            for (mp_uint_t i = 0; i < scope->id_info_len; i++) {
+                id_info_t *id = &scope->id_info[i];
+                if (id->kind == ID_INFO_KIND_CELL) {
+                    emit->local_vtype[id->local_num] = VTYPE_PYOBJ;
+                }
+            }
+            return;
+        }
 
-        // allocate space on C-stack for code_state structure, which includes state
-        ASM_ENTRY(emit->as, STATE_START + emit->n_state);
+        // allocate space on C-stack for code_state structure, which includes state,
+        // followed by the nlr_buf_t if needed
+        emit->nlr_start = STATE_START + emit->n_state;
+        emit->reg_save_start = emit->nlr_start + (NEED_GLOBAL_EXC_HANDLER(emit) ? NLR_BUF_WORDS : 0);
+        ASM_ENTRY(emit->as, emit->reg_save_start + emit_native_num_saved_regs(emit));
 
         // TODO don't load r7 if we don't need it
         #if N_THUMB
-        asm_thumb_mov_reg_i32(emit->as, ASM_THUMB_REG_R7, (mp_uint_t)mp_fun_table);
+        emit_native_mov_reg_fun_table(emit, ASM_THUMB_REG_R7);
         #elif N_ARM
-        asm_arm_mov_reg_i32(emit->as, ASM_ARM_REG_R7, (mp_uint_t)mp_fun_table);
+        emit_native_mov_reg_fun_table(emit, ASM_ARM_REG_R7);
         #endif
 
         // prepare incoming arguments for call to mp_setup_code_state
@@ -774,8 +1289,10 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         #endif
 
         // set code_state.ip (offset from start of this function to prelude info)
-        // XXX this encoding may change size
-        ASM_MOV_IMM_TO_LOCAL_USING(emit->as, emit->prelude_offset, offsetof(mp_code_state_t, ip) / sizeof(mp_uint_t), REG_ARG_1);
+        // the offset is only known after the code-size pass, so it is loaded
+        // with an encoding whose size doesn't depend on its value
+        ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, emit->prelude_offset, REG_ARG_1);
+        ASM_MOV_REG_TO_LOCAL(emit->as, REG_ARG_1, offsetof(mp_code_state_t, ip) / sizeof(mp_uint_t));
 
         // set code_state.n_state
         ASM_MOV_IMM_TO_LOCAL_USING(emit->as, emit->n_state, offsetof(mp_code_state_t, n_state) / sizeof(mp_uint_t), REG_ARG_1);
@@ -793,17 +1310,23 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         asm_arm_bl_ind(emit->as, mp_fun_table[MP_F_SETUP_CODE_STATE], MP_F_SETUP_CODE_STATE, ASM_ARM_REG_R4);
         asm_arm_pop(emit->as, 1 << REG_RET); // pop dummy (was 5th arg)
         #else
-        ASM_CALL_IND(emit->as, mp_fun_table[MP_F_SETUP_CODE_STATE], MP_F_SETUP_CODE_STATE);
+        emit_native_call_ind(emit, MP_F_SETUP_CODE_STATE);
         #endif
 
-        // cache some locals in registers
-        if (scope->num_locals > 0) {
-            ASM_MOV_LOCAL_TO_REG(emit->as, STATE_START + emit->n_state - 1 - 0, REG_LOCAL_1);
-            if (scope->num_locals > 1) {
-                ASM_MOV_LOCAL_TO_REG(emit->as, STATE_START + emit->n_state - 1 - 1, REG_LOCAL_2);
-                if (scope->num_locals > 2) {
-                    ASM_MOV_LOCAL_TO_REG(emit->as, STATE_START + emit->n_state - 1 - 2, REG_LOCAL_3);
-                }
+        if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+            emit_native_push_global_nlr(emit);
+            emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, DISPATCH_ID_START));
+        }
+
+        // cache locals in their registers
+        emit_native_save_local_regs(emit, REG_TEMP0);
+        for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+            mp_uint_t loc = emit->local_loc[i];
+            if (loc < REG_LOCAL_NUM_DIRECT) {
+                ASM_MOV_LOCAL_TO_REG(emit->as, STATE_START + emit->n_state - 1 - i, reg_local_table[loc]);
+            } else if (loc < REG_LOCAL_NUM) {
+                ASM_MOV_LOCAL_TO_REG(emit->as, STATE_START + emit->n_state - 1 - i, REG_TEMP0);
+                ASM_MOV_REG_REG(emit->as, reg_local_table[loc], REG_TEMP0);
             }
         }
 
@@ -820,7 +1343,38 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
 
 STATIC void emit_native_end_pass(emit_t *emit) {
     if (!emit->last_emit_was_return_value) {
-        ASM_EXIT(emit->as);
+        emit_native_exit(emit);
+    }
+
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        // the global exception handler: nlr_push returned with an exception,
+        // so jump to the active handler, given by its id, or else propagate it
+        mp_uint_t label_unhandled = emit_native_local_label(emit, emit_native_new_local_label(emit));
+        emit_native_private_label_assign(emit, emit_native_local_label(emit, LOCAL_LABEL_CATCH));
+        ASM_MOV_LOCAL_TO_REG(emit->as, emit->nlr_start + NLR_BUF_IDX_RET_VAL, REG_ARG_1);
+        emit_native_mov_state_reg(emit, STATE_EXC_VAL, REG_ARG_1);
+        emit_native_mov_reg_state(emit, REG_ARG_2, STATE_HANDLER);
+        ASM_MOV_IMM_TO_REG(emit->as, 0, REG_ARG_3);
+        ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_2, REG_ARG_3, label_unhandled);
+        emit_native_push_global_nlr(emit);
+        emit_native_mov_reg_state(emit, REG_ARG_1, STATE_HANDLER);
+
+        // jump to the label of the id in REG_ARG_1
+        emit_native_private_label_assign(emit, emit_native_local_label(emit, LOCAL_LABEL_DISPATCH));
+        for (mp_uint_t id = 0; id < emit->num_dispatch_ids; id++) {
+            ASM_MOV_IMM_TO_REG(emit->as, id, REG_ARG_2);
+            ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, emit_native_dispatch_label(emit, id));
+        }
+
+        // REG_ARG_1 holds the exception
+        emit_native_private_label_assign(emit, label_unhandled);
+        if (IS_NATIVE_GENERATOR(emit)) {
+            emit_native_mov_state_reg(emit, STATE_START + emit->n_state - 1, REG_ARG_1);
+            ASM_MOV_IMM_TO_REG(emit->as, MP_VM_RETURN_EXCEPTION, REG_RET);
+            ASM_EXIT(emit->as);
+        } else {
+            emit_native_call_ind(emit, MP_F_NATIVE_RAISE);
+        }
     }
 
     if (!emit->do_viper_types) {
@@ -833,18 +1387,34 @@ STATIC void emit_native_end_pass(emit_t *emit) {
         // write code info
         #if MICROPY_PERSISTENT_CODE
         ASM_DATA(emit->as, 1, 5);
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        emit_native_reloc_at(emit, ASM_GET_CODE_POS(emit->as), MP_NATIVE_RELOC_QSTR16, emit->scope->simple_name);
+        emit_native_reloc_at(emit, ASM_GET_CODE_POS(emit->as) + 2, MP_NATIVE_RELOC_QSTR16, emit->scope->source_file);
+        #endif
         ASM_DATA(emit->as, 1, emit->scope->simple_name);
         ASM_DATA(emit->as, 1, emit->scope->simple_name >> 8);
         ASM_DATA(emit->as, 1, emit->scope->source_file);
         ASM_DATA(emit->as, 1, emit->scope->source_file >> 8);
         #else
-        ASM_DATA(emit->as, 1, 1);
+        // the size, then the name encoded as in emitbc.c
+        byte buf[(8 * sizeof(mp_uint_t) + 6) / 7];
+        byte *p = buf + sizeof(buf);
+        mp_uint_t val = emit->scope->simple_name;
+        do {
+            *--p = val & 0x7f;
+            val >>= 7;
+        } while (val != 0);
+        ASM_DATA(emit->as, 1, 1 + (buf + sizeof(buf) - p));
+        for (; p != buf + sizeof(buf) - 1; p++) {
+            ASM_DATA(emit->as, 1, *p | 0x80);
+        }
+        ASM_DATA(emit->as, 1, *p);
         #endif
 
         // bytecode prelude: initialise closed over variables
         for (int i = 0; i < emit->scope->id_info_len; i++) {
             id_info_t *id = &emit->scope->id_info[i];
-            if (id->kind == ID_INFO_KIND_CELL) {
+            if (id->kind == ID_INFO_KIND_CELL && !(id->flags & ID_FLAG_IS_BY_VALUE)) {
                 assert(id->local_num < 255);
                 ASM_DATA(emit->as, 1, id->local_num); // write the local which should be converted to a cell
             }
@@ -866,6 +1436,7 @@ STATIC void emit_native_end_pass(emit_t *emit) {
                 }
             }
             ASM_DATA(emit->as, ASM_WORD_SIZE, (mp_uint_t)MP_OBJ_NEW_QSTR(qst));
+            EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_QSTR_OBJ, qst);
         }
 
     }
@@ -888,9 +1459,17 @@ STATIC void emit_native_end_pass(emit_t *emit) {
             type_sig |= (emit->local_vtype[i] & 0xf) << (i * 4 + 4);
         }
 
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        mp_native_reloc_t *relocs = m_new(mp_native_reloc_t, emit->n_reloc);
+        memcpy(relocs, emit->relocs, emit->n_reloc * sizeof(mp_native_reloc_t));
+        #endif
+
         mp_emit_glue_assign_native(emit->scope->raw_code,
             emit->do_viper_types ? MP_CODE_NATIVE_VIPER : MP_CODE_NATIVE_PY,
             f, f_len, (mp_uint_t*)((byte*)f + emit->const_table_offset),
+            #if MICROPY_PERSISTENT_CODE_SAVE
+            relocs, emit->n_reloc,
+            #endif
             emit->scope->num_pos_args, emit->scope->scope_flags, type_sig);
     }
 }
@@ -994,7 +1573,7 @@ STATIC void need_reg_single(emit_t *emit, int reg_needed, int skip_stack_pos) {
             stack_info_t *si = &emit->stack_info[i];
             if (si->kind == STACK_REG && si->data.u_reg == reg_needed) {
                 si->kind = STACK_VALUE;
-                ASM_MOV_REG_TO_LOCAL(emit->as, si->data.u_reg, emit->stack_start + i);
+                emit_native_mov_state_reg(emit, emit->stack_start + i, si->data.u_reg);
             }
         }
     }
@@ -1005,7 +1584,7 @@ STATIC void need_reg_all(emit_t *emit) {
         stack_info_t *si = &emit->stack_info[i];
         if (si->kind == STACK_REG) {
             si->kind = STACK_VALUE;
-            ASM_MOV_REG_TO_LOCAL(emit->as, si->data.u_reg, emit->stack_start + i);
+            emit_native_mov_state_reg(emit, emit->stack_start + i, si->data.u_reg);
         }
     }
 }
@@ -1017,7 +1596,7 @@ STATIC void need_stack_settled(emit_t *emit) {
         if (si->kind == STACK_REG) {
             DEBUG_printf("    reg(%u) to local(%u)\n", si->data.u_reg, emit->stack_start + i);
             si->kind = STACK_VALUE;
-            ASM_MOV_REG_TO_LOCAL(emit->as, si->data.u_reg, emit->stack_start + i);
+            emit_native_mov_state_reg(emit, emit->stack_start + i, si->data.u_reg);
         }
     }
     for (int i = 0; i < emit->stack_size; i++) {
@@ -1025,7 +1604,11 @@ STATIC void need_stack_settled(emit_t *emit) {
         if (si->kind == STACK_IMM) {
             DEBUG_printf("    imm(" INT_FMT ") to local(%u)\n", si->data.u_imm, emit->stack_start + i);
             si->kind = STACK_VALUE;
-            ASM_MOV_IMM_TO_LOCAL_USING(emit->as, si->data.u_imm, emit->stack_start + i, REG_TEMP0);
+            if (si->vtype == VTYPE_PYOBJ) {
+                emit_native_mov_state_obj_via(emit, emit->stack_start + i, si->data.u_imm, REG_TEMP0);
+            } else {
+                emit_native_mov_state_imm_via(emit, emit->stack_start + i, si->data.u_imm, REG_TEMP0);
+            }
         }
     }
 }
@@ -1037,7 +1620,7 @@ STATIC void emit_access_stack(emit_t *emit, int pos, vtype_kind_t *vtype, int re
     *vtype = si->vtype;
     switch (si->kind) {
         case STACK_VALUE:
-            ASM_MOV_LOCAL_TO_REG(emit->as, emit->stack_start + emit->stack_size - pos, reg_dest);
+            emit_native_mov_reg_state(emit, reg_dest, emit->stack_start + emit->stack_size - pos);
             break;
 
         case STACK_REG:
@@ -1047,7 +1630,11 @@ STATIC void emit_access_stack(emit_t *emit, int pos, vtype_kind_t *vtype, int re
             break;
 
         case STACK_IMM:
-            ASM_MOV_IMM_TO_REG(emit->as, si->data.u_imm, reg_dest);
+            if (si->vtype == VTYPE_PYOBJ) {
+                emit_native_mov_reg_obj(emit, reg_dest, si->data.u_imm);
+            } else {
+                ASM_MOV_IMM_TO_REG(emit->as, si->data.u_imm, reg_dest);
+            }
             break;
     }
 }
@@ -1059,7 +1646,7 @@ STATIC void emit_fold_stack_top(emit_t *emit, int reg_dest) {
     si[0] = si[1];
     if (si->kind == STACK_VALUE) {
         // if folded element was on the stack we need to put it in a register
-        ASM_MOV_LOCAL_TO_REG(emit->as, emit->stack_start + emit->stack_size - 1, reg_dest);
+        emit_native_mov_reg_state(emit, reg_dest, emit->stack_start + emit->stack_size - 1);
         si->kind = STACK_REG;
         si->data.u_reg = reg_dest;
     }
@@ -1148,38 +1735,92 @@ STATIC void emit_post_push_reg_reg_reg_reg(emit_t *emit, vtype_kind_t vtypea, in
 
 STATIC void emit_call(emit_t *emit, mp_fun_kind_t fun_kind) {
     need_reg_all(emit);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
 STATIC void emit_call_with_imm_arg(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val, int arg_reg) {
     need_reg_all(emit);
     ASM_MOV_IMM_TO_REG(emit->as, arg_val, arg_reg);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
-// the first arg is stored in the code aligned on a mp_uint_t boundary
-STATIC void emit_call_with_imm_arg_aligned(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val, int arg_reg) {
+STATIC void emit_call_with_qstr_arg(emit_t *emit, mp_fun_kind_t fun_kind, qstr qst, int arg_reg) {
     need_reg_all(emit);
-    ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, arg_val, arg_reg);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_mov_reg_qstr(emit, arg_reg, qst);
+    emit_native_call_ind(emit, fun_kind);
+}
+
+// the first arg is a raw code, stored in the code aligned on a mp_uint_t boundary
+STATIC void emit_call_with_raw_code_arg(emit_t *emit, mp_fun_kind_t fun_kind, mp_raw_code_t *rc, int arg_reg) {
+    need_reg_all(emit);
+    ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, (mp_uint_t)rc, arg_reg);
+    EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_RAW_CODE, (mp_uint_t)rc);
+    emit_native_call_ind(emit, fun_kind);
 }
 
 STATIC void emit_call_with_2_imm_args(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val1, int arg_reg1, mp_int_t arg_val2, int arg_reg2) {
     need_reg_all(emit);
     ASM_MOV_IMM_TO_REG(emit->as, arg_val1, arg_reg1);
     ASM_MOV_IMM_TO_REG(emit->as, arg_val2, arg_reg2);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
-// the first arg is stored in the code aligned on a mp_uint_t boundary
-STATIC void emit_call_with_3_imm_args_and_first_aligned(emit_t *emit, mp_fun_kind_t fun_kind, mp_int_t arg_val1, int arg_reg1, mp_int_t arg_val2, int arg_reg2, mp_int_t arg_val3, int arg_reg3) {
+// the first arg is a raw code, stored in the code aligned on a mp_uint_t boundary
+STATIC void emit_call_with_raw_code_and_2_imm_args(emit_t *emit, mp_fun_kind_t fun_kind, mp_raw_code_t *rc, int arg_reg1, mp_int_t arg_val2, int arg_reg2, mp_int_t arg_val3, int arg_reg3) {
     need_reg_all(emit);
-    ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, arg_val1, arg_reg1);
+    ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, (mp_uint_t)rc, arg_reg1);
+    EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_RAW_CODE, (mp_uint_t)rc);
     ASM_MOV_IMM_TO_REG(emit->as, arg_val2, arg_reg2);
     ASM_MOV_IMM_TO_REG(emit->as, arg_val3, arg_reg3);
-    ASM_CALL_IND(emit->as, mp_fun_table[fun_kind], fun_kind);
+    emit_native_call_ind(emit, fun_kind);
 }
 
+#if MICROPY_PY_BUILTINS_FLOAT
+
+// how mp_native_float_op should unbox a value of the given vtype, or -1 if it can't
+STATIC int vtype_to_float_arg_kind(vtype_kind_t vtype) {
+    switch (vtype) {
+        case VTYPE_FLOAT: return MP_NATIVE_FLOAT_ARG_FLOAT;
+        case VTYPE_BOOL:
+        case VTYPE_INT:
+        case VTYPE_UINT: return MP_NATIVE_FLOAT_ARG_INT;
+        case VTYPE_PYOBJ: return MP_NATIVE_FLOAT_ARG_OBJ;
+        default: return -1;
+    }
+}
+
+// converts the value at the given depth on the stack to VTYPE_FLOAT, in place
+// integer immediates are converted at compile time, otherwise uses REG_ARG_1, REG_ARG_2, REG_ARG_3 and REG_RET
+STATIC void emit_native_convert_to_float(emit_t *emit, mp_uint_t depth) {
+    stack_info_t *si = peek_stack(emit, depth);
+    int kind = vtype_to_float_arg_kind(si->vtype);
+    if (kind == MP_NATIVE_FLOAT_ARG_FLOAT) {
+        return;
+    }
+    if (kind < 0) {
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+            "can't convert '%q' to 'float'", vtype_to_qstr(si->vtype));
+        return;
+    }
+    if (si->kind == STACK_IMM && kind == MP_NATIVE_FLOAT_ARG_INT) {
+        union { uint32_t u; float f; } v;
+        v.f = si->data.u_imm;
+        si->data.u_imm = v.u;
+        si->vtype = VTYPE_FLOAT;
+        return;
+    }
+    need_reg_all(emit);
+    vtype_kind_t vtype;
+    emit_access_stack(emit, depth + 1, &vtype, REG_ARG_2);
+    emit_call_with_2_imm_args(emit, MP_F_NATIVE_FLOAT_OP,
+        MP_NATIVE_FLOAT_OP(MP_BINARY_OP_ADD, kind, MP_NATIVE_FLOAT_ARG_FLOAT), REG_ARG_1, 0, REG_ARG_3);
+    emit_native_mov_state_reg(emit, emit->stack_start + emit->stack_size - 1 - depth, REG_RET);
+    si->kind = STACK_VALUE;
+    si->vtype = VTYPE_FLOAT;
+}
+
+#endif
+
 // vtype of all n_pop objects is VTYPE_PYOBJ
 // Will convert any items that are not VTYPE_PYOBJ to this type and put them back on the stack.
 // If any conversions of non-immediate values are needed, then it uses REG_ARG_1, REG_ARG_2 and REG_RET.
@@ -1196,21 +1837,25 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
             si->kind = STACK_VALUE;
             switch (si->vtype) {
                 case VTYPE_PYOBJ:
-                    ASM_MOV_IMM_TO_LOCAL_USING(emit->as, si->data.u_imm, emit->stack_start + emit->stack_size - 1 - i, reg_dest);
+                    emit_native_mov_state_obj_via(emit, emit->stack_start + emit->stack_size - 1 - i, si->data.u_imm, reg_dest);
                     break;
                 case VTYPE_BOOL:
                     if (si->data.u_imm == 0) {
-                        ASM_MOV_IMM_TO_LOCAL_USING(emit->as, (mp_uint_t)mp_const_false, emit->stack_start + emit->stack_size - 1 - i, reg_dest);
+                        emit_native_mov_state_obj_via(emit, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_false, reg_dest);
                     } else {
-                        ASM_MOV_IMM_TO_LOCAL_USING(emit->as, (mp_uint_t)mp_const_true, emit->stack_start + emit->stack_size - 1 - i, reg_dest);
+                        emit_native_mov_state_obj_via(emit, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_true, reg_dest);
                     }
                     si->vtype = VTYPE_PYOBJ;
                     break;
                 case VTYPE_INT:
                 case VTYPE_UINT:
-                    ASM_MOV_IMM_TO_LOCAL_USING(emit->as, (uintptr_t)MP_OBJ_NEW_SMALL_INT(si->data.u_imm), emit->stack_start + emit->stack_size - 1 - i, reg_dest);
+                    emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, (uintptr_t)MP_OBJ_NEW_SMALL_INT(si->data.u_imm), reg_dest);
                     si->vtype = VTYPE_PYOBJ;
                     break;
+                case VTYPE_FLOAT:
+                    // boxed by the conversion below
+                    emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, si->data.u_imm, reg_dest);
+                    break;
                 default:
                     // not handled
                     assert(0);
@@ -1226,9 +1871,9 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
         stack_info_t *si = &emit->stack_info[emit->stack_size - 1 - i];
         if (si->vtype != VTYPE_PYOBJ) {
             mp_uint_t local_num = emit->stack_start + emit->stack_size - 1 - i;
-            ASM_MOV_LOCAL_TO_REG(emit->as, local_num, REG_ARG_1);
+            emit_native_mov_reg_state(emit, REG_ARG_1, local_num);
             emit_call_with_imm_arg(emit, MP_F_CONVERT_NATIVE_TO_OBJ, si->vtype, REG_ARG_2); // arg2 = type
-            ASM_MOV_REG_TO_LOCAL(emit->as, REG_RET, local_num);
+            emit_native_mov_state_reg(emit, local_num, REG_RET);
             si->vtype = VTYPE_PYOBJ;
             DEBUG_printf("  convert_native_to_obj(local_num=" UINT_FMT ")\n", local_num);
         }
@@ -1236,7 +1881,7 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
 
     // Adujust the stack for a pop of n_pop items, and load the stack pointer into reg_dest.
     adjust_stack(emit, -n_pop);
-    ASM_MOV_LOCAL_ADDR_TO_REG(emit->as, emit->stack_start + emit->stack_size, reg_dest);
+    emit_native_mov_reg_state_addr(emit, reg_dest, emit->stack_start + emit->stack_size);
 }
 
 // vtype of all n_push objects is VTYPE_PYOBJ
@@ -1246,16 +1891,114 @@ STATIC void emit_get_stack_pointer_to_reg_for_push(emit_t *emit, mp_uint_t reg_d
         emit->stack_info[emit->stack_size + i].kind = STACK_VALUE;
         emit->stack_info[emit->stack_size + i].vtype = VTYPE_PYOBJ;
     }
-    ASM_MOV_LOCAL_ADDR_TO_REG(emit->as, emit->stack_start + emit->stack_size, reg_dest);
+    emit_native_mov_reg_state_addr(emit, reg_dest, emit->stack_start + emit->stack_size);
     adjust_stack(emit, n_push);
 }
 
+// id of the handler active outside the first exc_depth try/with blocks, 0 if none
+STATIC mp_uint_t emit_native_enclosing_handler(emit_t *emit, mp_uint_t exc_depth) {
+    while (exc_depth > 0) {
+        exc_stack_entry_t *e = &emit->exc_stack[--exc_depth];
+        if (e->is_active) {
+            return e->handler_id;
+        }
+    }
+    return 0;
+}
+
+STATIC void emit_native_set_handler(emit_t *emit, mp_uint_t handler_id) {
+    need_reg_single(emit, REG_TEMP0, 0);
+    emit_native_mov_state_imm_via(emit, STATE_HANDLER, handler_id, REG_TEMP0);
+}
+
+STATIC exc_stack_entry_t *emit_native_push_exc_stack(emit_t *emit, exc_stack_kind_t kind, mp_uint_t label) {
+    assert(emit->exc_stack_size < emit->exc_stack_alloc);
+    exc_stack_entry_t *e = &emit->exc_stack[emit->exc_stack_size++];
+    e->kind = kind;
+    e->is_active = true;
+    e->label = label;
+    e->handler_id = emit_native_new_dispatch_id(emit);
+    e->with_base = 0;
+    return e;
+}
+
+// a try or with block no longer catches exceptions; its handler is about to run
+STATIC void emit_native_deactivate_exc_stack_top(emit_t *emit) {
+    exc_stack_entry_t *e = &emit->exc_stack[emit->exc_stack_size - 1];
+    assert(e->is_active);
+    e->is_active = false;
+    emit_native_set_handler(emit, emit_native_enclosing_handler(emit, emit->exc_stack_size - 1));
+}
+
+// Leave the innermost n try/with blocks, running their finally blocks and
+// __exit__ methods, as for a return, break or continue.
+STATIC void emit_native_unwind(emit_t *emit, mp_uint_t n) {
+    need_stack_settled(emit);
+    for (mp_uint_t i = emit->exc_stack_size; i > emit->exc_stack_size - n; i--) {
+        exc_stack_entry_t *e = &emit->exc_stack[i - 1];
+        if (!e->is_active) {
+            continue;
+        }
+        if (e->kind == EXC_STACK_WITH) {
+            // call __exit__(None, None, None), which sits with its self at with_base
+            emit_native_set_handler(emit, emit_native_enclosing_handler(emit, i - 1));
+            for (int j = 2; j < 5; j++) {
+                emit_native_mov_state_obj_via(emit, emit->stack_start + e->with_base + j, (mp_uint_t)mp_const_none, REG_TEMP0);
+            }
+            emit_native_mov_reg_state_addr(emit, REG_ARG_3, emit->stack_start + e->with_base);
+            ASM_MOV_IMM_TO_REG(emit->as, 3, REG_ARG_1);
+            ASM_MOV_IMM_TO_REG(emit->as, 0, REG_ARG_2);
+            emit_native_call_ind(emit, MP_F_CALL_METHOD_N_KW);
+        } else if (e->kind == EXC_STACK_FINALLY) {
+            // run the finally block, which carries on from here when it ends
+            mp_uint_t cont_id = emit_native_new_dispatch_id(emit);
+            emit_native_mov_state_imm_via(emit, STATE_EXC_LEVEL(i - 1), cont_id, REG_TEMP0);
+            emit_native_mov_state_imm_via(emit, STATE_EXC_VAL, (mp_uint_t)MP_OBJ_SENTINEL, REG_TEMP0);
+            ASM_JUMP(emit->as, e->label);
+            emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, cont_id));
+        }
+    }
+    emit_native_set_handler(emit, emit_native_enclosing_handler(emit, emit->exc_stack_size - n));
+}
+
 STATIC void emit_native_label_assign(emit_t *emit, mp_uint_t l) {
     DEBUG_printf("label_assign(" UINT_FMT ")\n", l);
     emit_native_pre(emit);
+    emit_native_log_label(emit, l);
+
+    exc_stack_entry_t *e = NULL;
+    if (emit->exc_stack_size > 0 && NEED_GLOBAL_EXC_HANDLER(emit)) {
+        e = &emit->exc_stack[emit->exc_stack_size - 1];
+        if (e->is_active || e->label != l || e->kind == EXC_STACK_WITH) {
+            e = NULL;
+        }
+    }
+
+    if (e != NULL && e->kind == EXC_STACK_FINALLY) {
+        // falling into a finally block: the value on the stack (None) goes
+        // through the same slot as the exception, or a pending unwind
+        vtype_kind_t vtype;
+        emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
+        emit_native_mov_state_reg(emit, STATE_EXC_VAL, REG_TEMP0);
+    }
+
     // need to commit stack because we can jump here from elsewhere
     need_stack_settled(emit);
     ASM_LABEL_ASSIGN(emit->as, l);
+
+    if (e != NULL) {
+        // start of an except or finally handler, which the global exception
+        // handler jumps to with the exception in STATE_EXC_VAL
+        emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, e->handler_id));
+        emit_native_mov_state_imm_via(emit, STATE_HANDLER, emit_native_enclosing_handler(emit, emit->exc_stack_size - 1), REG_TEMP0);
+        emit_native_mov_reg_state(emit, REG_TEMP0, STATE_EXC_VAL);
+        if (e->kind == EXC_STACK_EXCEPT) {
+            // keep the exception for a bare raise
+            emit_native_mov_state_reg(emit, STATE_EXC_LEVEL(emit->exc_stack_size - 1), REG_TEMP0);
+        }
+        emit_post_push_reg(emit, VTYPE_PYOBJ, REG_TEMP0);
+    }
+
     emit_post(emit);
 }
 
@@ -1266,7 +2009,7 @@ STATIC void emit_native_import_name(emit_t *emit, qstr qst) {
     emit_pre_pop_reg_reg(emit, &vtype_fromlist, REG_ARG_2, &vtype_level, REG_ARG_3); // arg2 = fromlist, arg3 = level
     assert(vtype_fromlist == VTYPE_PYOBJ);
     assert(vtype_level == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_IMPORT_NAME, qst, REG_ARG_1); // arg1 = import name
+    emit_call_with_qstr_arg(emit, MP_F_IMPORT_NAME, qst, REG_ARG_1); // arg1 = import name
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -1276,7 +2019,7 @@ STATIC void emit_native_import_from(emit_t *emit, qstr qst) {
     vtype_kind_t vtype_module;
     emit_access_stack(emit, 1, &vtype_module, REG_ARG_1); // arg1 = module
     assert(vtype_module == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_IMPORT_FROM, qst, REG_ARG_2); // arg2 = import name
+    emit_call_with_qstr_arg(emit, MP_F_IMPORT_FROM, qst, REG_ARG_2); // arg2 = import name
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -1348,6 +2091,7 @@ STATIC void emit_native_load_const_obj(emit_t *emit, mp_obj_t obj) {
     emit_native_pre(emit);
     need_reg_single(emit, REG_RET, 0);
     ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, (mp_uint_t)obj, REG_RET);
+    EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_OBJ, (mp_uint_t)obj);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -1363,18 +2107,18 @@ STATIC void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
         EMIT_NATIVE_VIPER_TYPE_ERROR(emit, "local '%q' used before type known", qst);
     }
     emit_native_pre(emit);
-    if (local_num == 0) {
-        emit_post_push_reg(emit, vtype, REG_LOCAL_1);
-    } else if (local_num == 1) {
-        emit_post_push_reg(emit, vtype, REG_LOCAL_2);
-    } else if (local_num == 2) {
-        emit_post_push_reg(emit, vtype, REG_LOCAL_3);
+    emit_native_log_use(emit, local_num);
+    mp_uint_t loc = emit->local_loc[local_num];
+    if (loc < REG_LOCAL_NUM_DIRECT) {
+        emit_post_push_reg(emit, vtype, reg_local_table[loc]);
     } else {
         need_reg_single(emit, REG_TEMP0, 0);
-        if (emit->do_viper_types) {
-            ASM_MOV_LOCAL_TO_REG(emit->as, local_num - REG_LOCAL_NUM, REG_TEMP0);
+        if (loc < REG_LOCAL_NUM) {
+            ASM_MOV_REG_REG(emit->as, REG_TEMP0, reg_local_table[loc]);
+        } else if (emit->do_viper_types) {
+            ASM_MOV_LOCAL_TO_REG(emit->as, loc - REG_LOCAL_NUM, REG_TEMP0);
         } else {
-            ASM_MOV_LOCAL_TO_REG(emit->as, STATE_START + emit->n_state - 1 - local_num, REG_TEMP0);
+            emit_native_mov_reg_state(emit, REG_TEMP0, STATE_START + emit->n_state - 1 - local_num);
         }
         emit_post_push_reg(emit, vtype, REG_TEMP0);
     }
@@ -1395,7 +2139,7 @@ STATIC void emit_native_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num)
 STATIC void emit_native_load_name(emit_t *emit, qstr qst) {
     DEBUG_printf("load_name(%s)\n", qstr_str(qst));
     emit_native_pre(emit);
-    emit_call_with_imm_arg(emit, MP_F_LOAD_NAME, qst, REG_ARG_1);
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_NAME, qst, REG_ARG_1);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -1415,8 +2159,16 @@ STATIC void emit_native_load_global(emit_t *emit, qstr qst) {
         emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTR16);
     } else if (emit->do_viper_types && qst == MP_QSTR_ptr32) {
         emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTR32);
+    } else if (emit->do_viper_types && qst == MP_QSTR_ptr16s) {
+        emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTR16S);
+    #if MICROPY_PY_BUILTINS_FLOAT
+    } else if (emit->do_viper_types && qst == MP_QSTR_ptrf) {
+        emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTRF);
+    } else if (emit->do_viper_types && qst == MP_QSTR_float) {
+        emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_FLOAT);
+    #endif
     } else {
-        emit_call_with_imm_arg(emit, MP_F_LOAD_GLOBAL, qst, REG_ARG_1);
+        emit_call_with_qstr_arg(emit, MP_F_LOAD_GLOBAL, qst, REG_ARG_1);
         emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
     }
 }
@@ -1429,7 +2181,7 @@ STATIC void emit_native_load_attr(emit_t *emit, qstr qst) {
     vtype_kind_t vtype_base;
     emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1); // arg1 = base
     assert(vtype_base == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_LOAD_ATTR, qst, REG_ARG_2); // arg2 = attribute name
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_ATTR, qst, REG_ARG_2); // arg2 = attribute name
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -1438,7 +2190,7 @@ STATIC void emit_native_load_method(emit_t *emit, qstr qst) {
     emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1); // arg1 = base
     assert(vtype_base == VTYPE_PYOBJ);
     emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_3, 2); // arg3 = dest ptr
-    emit_call_with_imm_arg(emit, MP_F_LOAD_METHOD, qst, REG_ARG_2); // arg2 = method name
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_METHOD, qst, REG_ARG_2); // arg2 = method name
 }
 
 STATIC void emit_native_load_build_class(emit_t *emit) {
@@ -1482,6 +2234,9 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
             int reg_base = REG_ARG_1;
             int reg_index = REG_ARG_2;
             emit_pre_pop_reg_flexible(emit, &vtype_base, &reg_base, reg_index, reg_index);
+            // values further down the stack may be held in these registers
+            need_reg_single(emit, REG_RET, 0);
+            need_reg_single(emit, reg_index, 0);
             switch (vtype_base) {
                 case VTYPE_PTR8: {
                     // pointer to 8-bit memory
@@ -1501,7 +2256,8 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                     ASM_LOAD8_REG_REG(emit->as, REG_RET, reg_base); // load from (base+index)
                     break;
                 }
-                case VTYPE_PTR16: {
+                case VTYPE_PTR16:
+                case VTYPE_PTR16S: {
                     // pointer to 16-bit memory
                     if (index_value != 0) {
                         // index is a non-zero immediate
@@ -1518,7 +2274,8 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                     ASM_LOAD16_REG_REG(emit->as, REG_RET, reg_base); // load from (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTRF: {
                     // pointer to 32-bit memory
                     if (index_value != 0) {
                         // index is a non-zero immediate
@@ -1545,6 +2302,8 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
             int reg_index = REG_ARG_2;
             emit_pre_pop_reg_flexible(emit, &vtype_index, &reg_index, REG_ARG_1, REG_ARG_1);
             emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1);
+            need_reg_single(emit, REG_RET, 0);
+            need_reg_single(emit, REG_ARG_2, 0);
             if (vtype_index != VTYPE_INT && vtype_index != VTYPE_UINT) {
                 EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
                     "can't load with '%q' index", vtype_to_qstr(vtype_index));
@@ -1557,14 +2316,16 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                     ASM_LOAD8_REG_REG(emit->as, REG_RET, REG_ARG_1); // store value to (base+index)
                     break;
                 }
-                case VTYPE_PTR16: {
+                case VTYPE_PTR16:
+                case VTYPE_PTR16S: {
                     // pointer to 16-bit memory
                     ASM_ADD_REG_REG(emit->as, REG_ARG_1, reg_index); // add index to base
                     ASM_ADD_REG_REG(emit->as, REG_ARG_1, reg_index); // add index to base
                     ASM_LOAD16_REG_REG(emit->as, REG_RET, REG_ARG_1); // load from (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTRF: {
                     // pointer to word-size memory
                     ASM_ADD_REG_REG(emit->as, REG_ARG_1, reg_index); // add index to base
                     ASM_ADD_REG_REG(emit->as, REG_ARG_1, reg_index); // add index to base
@@ -1578,24 +2339,30 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                         "can't load from '%q'", vtype_to_qstr(vtype_base));
             }
         }
-        emit_post_push_reg(emit, VTYPE_INT, REG_RET);
+        if (vtype_base == VTYPE_PTR16S) {
+            // sign extend the loaded 16-bit value, as (x ^ 0x8000) - 0x8000
+            ASM_MOV_IMM_TO_REG(emit->as, 0x8000, REG_ARG_2);
+            ASM_XOR_REG_REG(emit->as, REG_RET, REG_ARG_2);
+            ASM_SUB_REG_REG(emit->as, REG_RET, REG_ARG_2);
+        }
+        emit_post_push_reg(emit, vtype_base == VTYPE_PTRF ? VTYPE_FLOAT : VTYPE_INT, REG_RET);
     }
 }
 
 STATIC void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     vtype_kind_t vtype;
-    if (local_num == 0) {
-        emit_pre_pop_reg(emit, &vtype, REG_LOCAL_1);
-    } else if (local_num == 1) {
-        emit_pre_pop_reg(emit, &vtype, REG_LOCAL_2);
-    } else if (local_num == 2) {
-        emit_pre_pop_reg(emit, &vtype, REG_LOCAL_3);
+    emit_native_log_use(emit, local_num);
+    mp_uint_t loc = emit->local_loc[local_num];
+    if (loc < REG_LOCAL_NUM_DIRECT) {
+        emit_pre_pop_reg(emit, &vtype, reg_local_table[loc]);
     } else {
         emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
-        if (emit->do_viper_types) {
-            ASM_MOV_REG_TO_LOCAL(emit->as, REG_TEMP0, local_num - REG_LOCAL_NUM);
+        if (loc < REG_LOCAL_NUM) {
+            ASM_MOV_REG_REG(emit->as, reg_local_table[loc], REG_TEMP0);
+        } else if (emit->do_viper_types) {
+            ASM_MOV_REG_TO_LOCAL(emit->as, REG_TEMP0, loc - REG_LOCAL_NUM);
         } else {
-            ASM_MOV_REG_TO_LOCAL(emit->as, REG_TEMP0, STATE_START + emit->n_state - 1 - local_num);
+            emit_native_mov_state_reg(emit, STATE_START + emit->n_state - 1 - local_num, REG_TEMP0);
         }
     }
     emit_post(emit);
@@ -1631,7 +2398,7 @@ STATIC void emit_native_store_name(emit_t *emit, qstr qst) {
     vtype_kind_t vtype;
     emit_pre_pop_reg(emit, &vtype, REG_ARG_2);
     assert(vtype == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_STORE_NAME, qst, REG_ARG_1); // arg1 = name
+    emit_call_with_qstr_arg(emit, MP_F_STORE_NAME, qst, REG_ARG_1); // arg1 = name
     emit_post(emit);
 }
 
@@ -1644,7 +2411,7 @@ STATIC void emit_native_store_global(emit_t *emit, qstr qst) {
         emit_call_with_imm_arg(emit, MP_F_CONVERT_NATIVE_TO_OBJ, vtype, REG_ARG_2); // arg2 = type
         ASM_MOV_REG_REG(emit->as, REG_ARG_2, REG_RET);
     }
-    emit_call_with_imm_arg(emit, MP_F_STORE_GLOBAL, qst, REG_ARG_1); // arg1 = name
+    emit_call_with_qstr_arg(emit, MP_F_STORE_GLOBAL, qst, REG_ARG_1); // arg1 = name
     emit_post(emit);
 }
 
@@ -1653,7 +2420,7 @@ STATIC void emit_native_store_attr(emit_t *emit, qstr qst) {
     emit_pre_pop_reg_reg(emit, &vtype_base, REG_ARG_1, &vtype_val, REG_ARG_3); // arg1 = base, arg3 = value
     assert(vtype_base == VTYPE_PYOBJ);
     assert(vtype_val == VTYPE_PYOBJ);
-    emit_call_with_imm_arg(emit, MP_F_STORE_ATTR, qst, REG_ARG_2); // arg2 = attribute name
+    emit_call_with_qstr_arg(emit, MP_F_STORE_ATTR, qst, REG_ARG_2); // arg2 = attribute name
     emit_post(emit);
 }
 
@@ -1682,6 +2449,12 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
         // TODO The different machine architectures have very different
         // capabilities and requirements for stores, so probably best to
         // write a completely separate store-optimiser for each one.
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (vtype_base == VTYPE_PTRF) {
+            // ints and objects stored to a float buffer are converted first
+            emit_native_convert_to_float(emit, 2);
+        }
+        #endif
         stack_info_t *top = peek_stack(emit, 0);
         if (top->vtype == VTYPE_INT && top->kind == STACK_IMM) {
             // index is an immediate
@@ -1698,7 +2471,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
             #else
             emit_pre_pop_reg_flexible(emit, &vtype_value, &reg_value, reg_base, reg_index);
             #endif
-            if (vtype_value != VTYPE_BOOL && vtype_value != VTYPE_INT && vtype_value != VTYPE_UINT) {
+            need_reg_single(emit, reg_index, 0);
+            if (!viper_can_store(vtype_base, vtype_value)) {
                 EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
                     "can't store '%q'", vtype_to_qstr(vtype_value));
             }
@@ -1725,7 +2499,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
                     ASM_STORE8_REG_REG(emit->as, reg_value, reg_base); // store value to (base+index)
                     break;
                 }
-                case VTYPE_PTR16: {
+                case VTYPE_PTR16:
+                case VTYPE_PTR16S: {
                     // pointer to 16-bit memory
                     if (index_value != 0) {
                         // index is a non-zero immediate
@@ -1746,7 +2521,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
                     ASM_STORE16_REG_REG(emit->as, reg_value, reg_base); // store value to (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTRF: {
                     // pointer to 32-bit memory
                     if (index_value != 0) {
                         // index is a non-zero immediate
@@ -1788,7 +2564,7 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
             #else
             emit_pre_pop_reg_flexible(emit, &vtype_value, &reg_value, REG_ARG_1, reg_index);
             #endif
-            if (vtype_value != VTYPE_BOOL && vtype_value != VTYPE_INT && vtype_value != VTYPE_UINT) {
+            if (!viper_can_store(vtype_base, vtype_value)) {
                 EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
                     "can't store '%q'", vtype_to_qstr(vtype_value));
             }
@@ -1804,7 +2580,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
                     ASM_STORE8_REG_REG(emit->as, reg_value, REG_ARG_1); // store value to (base+index)
                     break;
                 }
-                case VTYPE_PTR16: {
+                case VTYPE_PTR16:
+                case VTYPE_PTR16S: {
                     // pointer to 16-bit memory
                     #if N_ARM
                     asm_arm_strh_reg_reg_reg(emit->as, reg_value, REG_ARG_1, reg_index);
@@ -1815,7 +2592,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
                     ASM_STORE16_REG_REG(emit->as, reg_value, REG_ARG_1); // store value to (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTRF: {
                     // pointer to 32-bit memory
                     #if N_ARM
                     asm_arm_str_reg_reg_reg(emit->as, reg_value, REG_ARG_1, reg_index);
@@ -1854,13 +2632,13 @@ STATIC void emit_native_delete_deref(emit_t *emit, qstr qst, mp_uint_t local_num
 
 STATIC void emit_native_delete_name(emit_t *emit, qstr qst) {
     emit_native_pre(emit);
-    emit_call_with_imm_arg(emit, MP_F_DELETE_NAME, qst, REG_ARG_1);
+    emit_call_with_qstr_arg(emit, MP_F_DELETE_NAME, qst, REG_ARG_1);
     emit_post(emit);
 }
 
 STATIC void emit_native_delete_global(emit_t *emit, qstr qst) {
     emit_native_pre(emit);
-    emit_call_with_imm_arg(emit, MP_F_DELETE_GLOBAL, qst, REG_ARG_1);
+    emit_call_with_qstr_arg(emit, MP_F_DELETE_GLOBAL, qst, REG_ARG_1);
     emit_post(emit);
 }
 
@@ -1868,7 +2646,9 @@ STATIC void emit_native_delete_attr(emit_t *emit, qstr qst) {
     vtype_kind_t vtype_base;
     emit_pre_pop_reg(emit, &vtype_base, REG_ARG_1); // arg1 = base
     assert(vtype_base == VTYPE_PYOBJ);
-    emit_call_with_2_imm_args(emit, MP_F_STORE_ATTR, qst, REG_ARG_2, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3); // arg2 = attribute name, arg3 = value (null for delete)
+    need_reg_all(emit);
+    ASM_MOV_IMM_TO_REG(emit->as, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3); // arg3 = value (null for delete)
+    emit_call_with_qstr_arg(emit, MP_F_STORE_ATTR, qst, REG_ARG_2); // arg2 = attribute name
     emit_post(emit);
 }
 
@@ -1917,6 +2697,7 @@ STATIC void emit_native_rot_three(emit_t *emit) {
 STATIC void emit_native_jump(emit_t *emit, mp_uint_t label) {
     DEBUG_printf("jump(label=" UINT_FMT ")\n", label);
     emit_native_pre(emit);
+    emit_native_log_jump(emit, label);
     // need to commit stack because we are jumping elsewhere
     need_stack_settled(emit);
     ASM_JUMP(emit->as, label);
@@ -1953,6 +2734,7 @@ STATIC void emit_native_jump_helper(emit_t *emit, bool pop) {
 STATIC void emit_native_pop_jump_if(emit_t *emit, bool cond, mp_uint_t label) {
     DEBUG_printf("pop_jump_if(cond=%u, label=" UINT_FMT ")\n", cond, label);
     emit_native_jump_helper(emit, true);
+    emit_native_log_jump(emit, label);
     if (cond) {
         ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
     } else {
@@ -1964,6 +2746,7 @@ STATIC void emit_native_pop_jump_if(emit_t *emit, bool cond, mp_uint_t label) {
 STATIC void emit_native_jump_if_or_pop(emit_t *emit, bool cond, mp_uint_t label) {
     DEBUG_printf("jump_if_or_pop(cond=%u, label=" UINT_FMT ")\n", cond, label);
     emit_native_jump_helper(emit, false);
+    emit_native_log_jump(emit, label);
     if (cond) {
         ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
     } else {
@@ -1974,13 +2757,18 @@ STATIC void emit_native_jump_if_or_pop(emit_t *emit, bool cond, mp_uint_t label)
 }
 
 STATIC void emit_native_break_loop(emit_t *emit, mp_uint_t label, mp_uint_t except_depth) {
-    (void)except_depth;
-    emit_native_jump(emit, label & ~MP_EMIT_BREAK_FROM_FOR); // TODO properly
+    if (NEED_GLOBAL_EXC_HANDLER(emit) && except_depth > 0) {
+        emit_native_pre(emit);
+        emit_native_unwind(emit, except_depth);
+        ASM_JUMP(emit->as, label & ~MP_EMIT_BREAK_FROM_FOR);
+        emit_post(emit);
+    } else {
+        emit_native_jump(emit, label & ~MP_EMIT_BREAK_FROM_FOR); // TODO properly
+    }
 }
 
 STATIC void emit_native_continue_loop(emit_t *emit, mp_uint_t label, mp_uint_t except_depth) {
-    (void)except_depth;
-    emit_native_jump(emit, label); // TODO properly
+    emit_native_break_loop(emit, label, except_depth);
 }
 
 STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
@@ -1992,7 +2780,7 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
     emit_access_stack(emit, 1, &vtype, REG_ARG_1); // arg1 = ctx_mgr
     assert(vtype == VTYPE_PYOBJ);
     emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_3, 2); // arg3 = dest ptr
-    emit_call_with_imm_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___exit__, REG_ARG_2);
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___exit__, REG_ARG_2);
     // stack: (..., ctx_mgr, __exit__, self)
 
     emit_pre_pop_reg(emit, &vtype, REG_ARG_3); // self
@@ -2005,7 +2793,7 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
 
     // get __enter__ method
     emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_3, 2); // arg3 = dest ptr
-    emit_call_with_imm_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___enter__, REG_ARG_2); // arg2 = method name
+    emit_call_with_qstr_arg(emit, MP_F_LOAD_METHOD, MP_QSTR___enter__, REG_ARG_2); // arg2 = method name
     // stack: (..., __exit__, self, __enter__, self)
 
     // call __enter__ method
@@ -2016,22 +2804,98 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
 
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
-    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, sizeof(nlr_buf_t) / sizeof(mp_uint_t)); // arg1 = pointer to nlr buf
+
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        exc_stack_entry_t *e = emit_native_push_exc_stack(emit, EXC_STACK_WITH, label);
+        e->with_base = emit->stack_size - 3;
+        emit_native_set_handler(emit, e->handler_id);
+        return;
+    }
+
+    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, NLR_BUF_WORDS); // arg1 = pointer to nlr buf
     emit_call(emit, MP_F_NLR_PUSH);
     ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
 
-    emit_access_stack(emit, sizeof(nlr_buf_t) / sizeof(mp_uint_t) + 1, &vtype, REG_RET); // access return value of __enter__
+    emit_access_stack(emit, NLR_BUF_WORDS + 1, &vtype, REG_RET); // access return value of __enter__
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET); // push return value of __enter__
     // stack: (..., __exit__, self, as_value, nlr_buf, as_value)
 }
 
+STATIC void emit_native_with_cleanup_global(emit_t *emit, mp_uint_t label) {
+    // note: label+1 is available as an auxiliary label
+
+    // stack: (..., __exit__, self)
+    emit_native_pre(emit);
+    exc_stack_entry_t *e = &emit->exc_stack[emit->exc_stack_size - 1];
+    mp_uint_t enclosing_handler = emit_native_enclosing_handler(emit, emit->exc_stack_size - 1);
+    emit_native_deactivate_exc_stack_top(emit);
+
+    // call __exit__
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+    emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, 5);
+    emit_call_with_2_imm_args(emit, MP_F_CALL_METHOD_N_KW, 3, REG_ARG_1, 0, REG_ARG_2);
+
+    // jump to after with cleanup handler, with no exception on the stack
+    emit_native_load_const_tok(emit, MP_TOKEN_KW_NONE);
+    emit_native_jump(emit, label + 1);
+
+    // the handler, reached with the stack: (..., __exit__, self)
+    adjust_stack(emit, -1);
+    emit_native_adjust_stack_size(emit, 2);
+    emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, e->handler_id));
+    emit_native_set_handler(emit, enclosing_handler);
+
+    vtype_kind_t vtype;
+    emit_pre_pop_reg(emit, &vtype, REG_ARG_2); // self
+    emit_pre_pop_reg(emit, &vtype, REG_ARG_3); // __exit__
+    emit_native_mov_reg_state(emit, REG_ARG_1, STATE_EXC_VAL); // exc
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_1); // push exc to save it for later
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_3); // __exit__
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_2); // self
+    need_reg_all(emit);
+    // stack: (..., exc, __exit__, self)
+    // REG_ARG_1=exc
+
+    ASM_LOAD_REG_REG_OFFSET(emit->as, REG_ARG_2, REG_ARG_1, 0); // get type(exc)
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_2); // push type(exc)
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_1); // push exc value
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none); // traceback info
+    // stack: (..., exc, __exit__, self, type(exc), exc, traceback)
+
+    // call __exit__ method
+    emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, 5);
+    emit_call_with_2_imm_args(emit, MP_F_CALL_METHOD_N_KW, 3, REG_ARG_1, 0, REG_ARG_2);
+    // stack: (..., exc)
+
+    // if REG_RET is true then we need to replace top-of-stack with None (swallow exception)
+    if (REG_ARG_1 != REG_RET) {
+        ASM_MOV_REG_REG(emit->as, REG_ARG_1, REG_RET);
+    }
+    emit_call(emit, MP_F_OBJ_IS_TRUE);
+    ASM_JUMP_IF_REG_ZERO(emit->as, REG_RET, label + 1);
+
+    // replace exc with None
+    emit_pre_pop_discard(emit);
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+
+    // end of with cleanup handler
+    emit_native_label_assign(emit, label + 1);
+}
+
 STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        emit_native_with_cleanup_global(emit, label);
+        return;
+    }
+
     // note: label+1 is available as an auxiliary label
 
     // stack: (..., __exit__, self, as_value, nlr_buf)
     emit_native_pre(emit);
     emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)) - 1);
+    adjust_stack(emit, -(mp_int_t)NLR_BUF_WORDS - 1);
     // stack: (..., __exit__, self)
 
     // call __exit__
@@ -2065,6 +2929,7 @@ STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
     emit_post_push_reg(emit, vtype, REG_ARG_1); // push exc to save it for later
     emit_post_push_reg(emit, vtype, REG_ARG_3); // __exit__
     emit_post_push_reg(emit, vtype, REG_ARG_2); // self
+    need_reg_all(emit); // self is in REG_ARG_2, which is about to be reused
     // stack: (..., exc, __exit__, self)
     // REG_ARG_1=exc
 
@@ -2094,18 +2959,27 @@ STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
     emit_native_label_assign(emit, label + 1);
 }
 
-STATIC void emit_native_setup_except(emit_t *emit, mp_uint_t label) {
+STATIC void emit_native_setup_block(emit_t *emit, exc_stack_kind_t kind, mp_uint_t label) {
     emit_native_pre(emit);
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
-    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, sizeof(nlr_buf_t) / sizeof(mp_uint_t)); // arg1 = pointer to nlr buf
-    emit_call(emit, MP_F_NLR_PUSH);
-    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        exc_stack_entry_t *e = emit_native_push_exc_stack(emit, kind, label);
+        emit_native_set_handler(emit, e->handler_id);
+    } else {
+        emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, NLR_BUF_WORDS); // arg1 = pointer to nlr buf
+        emit_call(emit, MP_F_NLR_PUSH);
+        ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
+    }
     emit_post(emit);
 }
 
+STATIC void emit_native_setup_except(emit_t *emit, mp_uint_t label) {
+    emit_native_setup_block(emit, EXC_STACK_EXCEPT, label);
+}
+
 STATIC void emit_native_setup_finally(emit_t *emit, mp_uint_t label) {
-    emit_native_setup_except(emit, label);
+    emit_native_setup_block(emit, EXC_STACK_FINALLY, label);
 }
 
 STATIC void emit_native_end_finally(emit_t *emit) {
@@ -2115,6 +2989,32 @@ STATIC void emit_native_end_finally(emit_t *emit) {
     //   else: raise exc
     // the check if exc is None is done in the MP_F_NATIVE_RAISE stub
     vtype_kind_t vtype;
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        emit_pre_pop_reg(emit, &vtype, REG_ARG_1);
+        exc_stack_entry_t *e = &emit->exc_stack[emit->exc_stack_size - 1];
+        if (e->kind == EXC_STACK_FINALLY) {
+            // the finally block may have been run to unwind, in which case carry on with that
+            mp_uint_t label_unwind = emit_native_local_label(emit, emit_native_new_local_label(emit));
+            mp_uint_t label_done = emit_native_local_label(emit, emit_native_new_local_label(emit));
+            need_stack_settled(emit);
+            ASM_MOV_IMM_TO_REG(emit->as, (mp_uint_t)MP_OBJ_SENTINEL, REG_ARG_2);
+            ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, label_unwind);
+            emit_native_call_ind(emit, MP_F_NATIVE_RAISE);
+            ASM_JUMP(emit->as, label_done);
+            emit_native_private_label_assign(emit, label_unwind);
+            emit_native_mov_reg_state(emit, REG_ARG_1, STATE_EXC_LEVEL(emit->exc_stack_size - 1));
+            ASM_JUMP(emit->as, emit_native_local_label(emit, LOCAL_LABEL_DISPATCH));
+            emit_native_private_label_assign(emit, label_done);
+        } else {
+            emit_call(emit, MP_F_NATIVE_RAISE);
+        }
+        if (e->kind != EXC_STACK_EXCEPT) {
+            // an except block is left by end_except_handler
+            emit->exc_stack_size -= 1;
+        }
+        emit_post(emit);
+        return;
+    }
     emit_pre_pop_reg(emit, &vtype, REG_ARG_1); // get nlr_buf.ret_val
     emit_pre_pop_discard(emit); // discard nlr_buf.prev
     emit_call(emit, MP_F_NATIVE_RAISE);
@@ -2143,6 +3043,17 @@ STATIC void emit_native_for_iter(emit_t *emit, mp_uint_t label) {
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
+STATIC void emit_native_for_range(emit_t *emit, mp_uint_t label) {
+    // the next value, stop and step stay on the stack, updated in place
+    emit_native_pre(emit);
+    emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_1, 3);
+    adjust_stack(emit, 3);
+    emit_call(emit, MP_F_FOR_RANGE_NEXT);
+    ASM_MOV_IMM_TO_REG(emit->as, (mp_uint_t)MP_OBJ_STOP_ITERATION, REG_TEMP1);
+    ASM_JUMP_IF_REG_EQ(emit->as, REG_RET, REG_TEMP1, label);
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
+}
+
 STATIC void emit_native_for_iter_end(emit_t *emit) {
     // adjust stack counter (we get here from for_iter ending, which popped the value for us)
     emit_native_pre(emit);
@@ -2152,8 +3063,12 @@ STATIC void emit_native_for_iter_end(emit_t *emit) {
 
 STATIC void emit_native_pop_block(emit_t *emit) {
     emit_native_pre(emit);
-    emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)) + 1);
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        emit_native_deactivate_exc_stack_top(emit);
+    } else {
+        emit_call(emit, MP_F_NLR_POP);
+        adjust_stack(emit, -(mp_int_t)NLR_BUF_WORDS + 1);
+    }
     emit_post(emit);
 }
 
@@ -2162,7 +3077,7 @@ STATIC void emit_native_pop_except(emit_t *emit) {
     /*
     emit_native_pre(emit);
     emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)));
+    adjust_stack(emit, -(mp_int_t)NLR_BUF_WORDS);
     emit_post(emit);
     */
 }
@@ -2304,6 +3219,27 @@ STATIC void emit_native_binary_op(emit_t *emit, mp_binary_op_t op) {
             EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
                 "binary op %q not implemented", mp_binary_op_method_name[op]);
         }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    } else if ((vtype_lhs == VTYPE_FLOAT || vtype_rhs == VTYPE_FLOAT)
+        && vtype_to_float_arg_kind(vtype_lhs) >= 0 && vtype_to_float_arg_kind(vtype_rhs) >= 0) {
+        // unboxed float op; the helper converts any int or object operand
+        mp_uint_t float_op = MP_NATIVE_FLOAT_OP(op, vtype_to_float_arg_kind(vtype_lhs), vtype_to_float_arg_kind(vtype_rhs));
+        emit_pre_pop_reg_reg(emit, &vtype_rhs, REG_ARG_3, &vtype_lhs, REG_ARG_2);
+        if (MP_BINARY_OP_LESS <= op && op <= MP_BINARY_OP_NOT_EQUAL) {
+            emit_call_with_imm_arg(emit, MP_F_NATIVE_FLOAT_OP, float_op, REG_ARG_1);
+            emit_post_push_reg(emit, VTYPE_BOOL, REG_RET);
+        } else if (op == MP_BINARY_OP_ADD || op == MP_BINARY_OP_INPLACE_ADD
+            || op == MP_BINARY_OP_SUBTRACT || op == MP_BINARY_OP_INPLACE_SUBTRACT
+            || op == MP_BINARY_OP_MULTIPLY || op == MP_BINARY_OP_INPLACE_MULTIPLY
+            || op == MP_BINARY_OP_TRUE_DIVIDE || op == MP_BINARY_OP_INPLACE_TRUE_DIVIDE) {
+            emit_call_with_imm_arg(emit, MP_F_NATIVE_FLOAT_OP, float_op, REG_ARG_1);
+            emit_post_push_reg(emit, VTYPE_FLOAT, REG_RET);
+        } else {
+            adjust_stack(emit, 1);
+            EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+                "binary op %q not implemented", mp_binary_op_method_name[op]);
+        }
+    #endif
     } else if (vtype_lhs == VTYPE_PYOBJ && vtype_rhs == VTYPE_PYOBJ) {
         emit_pre_pop_reg_reg(emit, &vtype_rhs, REG_ARG_3, &vtype_lhs, REG_ARG_2);
         bool invert = false;
@@ -2377,7 +3313,9 @@ STATIC void emit_native_build_slice(emit_t *emit, mp_uint_t n_args) {
         emit_pre_pop_reg_reg(emit, &vtype_stop, REG_ARG_2, &vtype_start, REG_ARG_1); // arg1 = start, arg2 = stop
         assert(vtype_start == VTYPE_PYOBJ);
         assert(vtype_stop == VTYPE_PYOBJ);
-        emit_call_with_imm_arg(emit, MP_F_NEW_SLICE, (mp_uint_t)mp_const_none, REG_ARG_3); // arg3 = step
+        need_reg_all(emit);
+        emit_native_mov_reg_obj(emit, REG_ARG_3, (mp_uint_t)mp_const_none); // arg3 = step
+        emit_native_call_ind(emit, MP_F_NEW_SLICE);
         emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
     } else {
         assert(n_args == 3);
@@ -2443,13 +3381,13 @@ STATIC void emit_native_make_function(emit_t *emit, scope_t *scope, mp_uint_t n_
     // call runtime, with type info for args, or don't support dict/default params, or only support Python objects for them
     emit_native_pre(emit);
     if (n_pos_defaults == 0 && n_kw_defaults == 0) {
-        emit_call_with_3_imm_args_and_first_aligned(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE, (mp_uint_t)scope->raw_code, REG_ARG_1, (mp_uint_t)MP_OBJ_NULL, REG_ARG_2, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3);
+        emit_call_with_raw_code_and_2_imm_args(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE, scope->raw_code, REG_ARG_1, (mp_uint_t)MP_OBJ_NULL, REG_ARG_2, (mp_uint_t)MP_OBJ_NULL, REG_ARG_3);
     } else {
         vtype_kind_t vtype_def_tuple, vtype_def_dict;
         emit_pre_pop_reg_reg(emit, &vtype_def_dict, REG_ARG_3, &vtype_def_tuple, REG_ARG_2);
         assert(vtype_def_tuple == VTYPE_PYOBJ);
         assert(vtype_def_dict == VTYPE_PYOBJ);
-        emit_call_with_imm_arg_aligned(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE, (mp_uint_t)scope->raw_code, REG_ARG_1);
+        emit_call_with_raw_code_arg(emit, MP_F_MAKE_FUNCTION_FROM_RAW_CODE, scope->raw_code, REG_ARG_1);
     }
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
@@ -2464,7 +3402,8 @@ STATIC void emit_native_make_closure(emit_t *emit, scope_t *scope, mp_uint_t n_c
         ASM_MOV_IMM_TO_REG(emit->as, 0x100 | n_closed_over, REG_ARG_2);
     }
     ASM_MOV_ALIGNED_IMM_TO_REG(emit->as, (mp_uint_t)scope->raw_code, REG_ARG_1);
-    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_MAKE_CLOSURE_FROM_RAW_CODE], MP_F_MAKE_CLOSURE_FROM_RAW_CODE);
+    EMIT_NATIVE_RELOC(emit, MP_NATIVE_RELOC_RAW_CODE, (mp_uint_t)scope->raw_code);
+    emit_native_call_ind(emit, MP_F_MAKE_CLOSURE_FROM_RAW_CODE);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
@@ -2482,6 +3421,23 @@ STATIC void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_u
         assert(!star_flags);
         DEBUG_printf("  cast to %d\n", vtype_fun);
         vtype_kind_t vtype_cast = peek_stack(emit, 1)->data.u_imm;
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (vtype_cast == VTYPE_FLOAT) {
+            // a float cast converts the value, rather than reinterpreting it
+            emit_native_convert_to_float(emit, 0);
+        } else if (peek_vtype(emit, 0) == VTYPE_FLOAT) {
+            if (vtype_cast != VTYPE_INT && vtype_cast != VTYPE_UINT) {
+                EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+                    "can't convert 'float' to '%q'", vtype_to_qstr(vtype_cast));
+            }
+            vtype_kind_t vtype;
+            emit_pre_pop_reg(emit, &vtype, REG_ARG_2);
+            emit_pre_pop_discard(emit);
+            emit_call_with_imm_arg(emit, MP_F_NATIVE_FLOAT_OP, MP_NATIVE_FLOAT_OP_TRUNC, REG_ARG_1);
+            emit_post_push_reg(emit, vtype_cast, REG_RET);
+            return;
+        }
+        #endif
         switch (peek_vtype(emit, 0)) {
             case VTYPE_PYOBJ: {
                 vtype_kind_t vtype;
@@ -2498,6 +3454,9 @@ STATIC void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_u
             case VTYPE_PTR8:
             case VTYPE_PTR16:
             case VTYPE_PTR32:
+            case VTYPE_PTR16S:
+            case VTYPE_PTRF:
+            case VTYPE_FLOAT:
             case VTYPE_PTR_NONE:
                 emit_fold_stack_top(emit, REG_ARG_1);
                 emit_post_top_set_vtype(emit, vtype_cast);
@@ -2541,7 +3500,7 @@ STATIC void emit_native_return_value(emit_t *emit) {
         if (peek_vtype(emit, 0) == VTYPE_PTR_NONE) {
             emit_pre_pop_discard(emit);
             if (emit->return_vtype == VTYPE_PYOBJ) {
-                ASM_MOV_IMM_TO_REG(emit->as, (mp_uint_t)mp_const_none, REG_RET);
+                emit_native_mov_reg_obj(emit, REG_RET, (mp_uint_t)mp_const_none);
             } else {
                 ASM_MOV_IMM_TO_REG(emit->as, 0, REG_RET);
             }
@@ -2554,6 +3513,22 @@ STATIC void emit_native_return_value(emit_t *emit) {
                     vtype_to_qstr(emit->return_vtype), vtype_to_qstr(vtype));
             }
         }
+    } else if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        // keep the return value in the state while any finally blocks run
+        vtype_kind_t vtype;
+        emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
+        assert(vtype == VTYPE_PYOBJ);
+        emit_native_mov_state_reg(emit, STATE_RET_VAL, REG_TEMP0);
+        emit_native_unwind(emit, emit->exc_stack_size);
+        emit_call(emit, MP_F_NLR_POP);
+        if (IS_NATIVE_GENERATOR(emit)) {
+            // the generator object takes the return value from code_state.sp
+            emit_native_mov_reg_state_addr(emit, REG_TEMP0, STATE_RET_VAL);
+            emit_native_mov_state_reg(emit, offsetof(mp_code_state_t, sp) / sizeof(mp_uint_t), REG_TEMP0);
+            ASM_MOV_IMM_TO_REG(emit->as, MP_VM_RETURN_NORMAL, REG_RET);
+        } else {
+            emit_native_mov_reg_state(emit, REG_RET, STATE_RET_VAL);
+        }
     } else {
         vtype_kind_t vtype;
         emit_pre_pop_reg(emit, &vtype, REG_RET);
@@ -2561,11 +3536,31 @@ STATIC void emit_native_return_value(emit_t *emit) {
     }
     emit->last_emit_was_return_value = true;
     //ASM_BREAK_POINT(emit->as); // to insert a break-point for debugging
-    ASM_EXIT(emit->as);
+    emit_native_exit(emit);
 }
 
 STATIC void emit_native_raise_varargs(emit_t *emit, mp_uint_t n_args) {
-    assert(n_args == 1);
+    if (n_args == 0) {
+        // re-raise the exception being handled, kept by the innermost except block
+        emit_native_pre(emit);
+        need_reg_all(emit);
+        mp_uint_t level = emit->exc_stack_size;
+        while (level > 0 && !(emit->exc_stack[level - 1].kind == EXC_STACK_EXCEPT
+            && !emit->exc_stack[level - 1].is_active)) {
+            level -= 1;
+        }
+        if (level > 0 && NEED_GLOBAL_EXC_HANDLER(emit)) {
+            emit_native_mov_reg_state(emit, REG_ARG_1, STATE_EXC_LEVEL(level - 1));
+        } else {
+            ASM_MOV_IMM_TO_REG(emit->as, (mp_uint_t)MP_OBJ_NULL, REG_ARG_1);
+        }
+        emit_native_call_ind(emit, MP_F_NATIVE_RAISE);
+        return;
+    }
+    if (n_args == 2) {
+        // the cause of the exception is not kept, as by the VM
+        emit_pre_pop_discard(emit);
+    }
     vtype_kind_t vtype_exc;
     emit_pre_pop_reg(emit, &vtype_exc, REG_ARG_1); // arg1 = object to raise
     if (vtype_exc != VTYPE_PYOBJ) {
@@ -2576,17 +3571,79 @@ STATIC void emit_native_raise_varargs(emit_t *emit, mp_uint_t n_args) {
 }
 
 STATIC void emit_native_yield_value(emit_t *emit) {
-    // not supported (for now)
-    (void)emit;
-    assert(0);
+    if (emit->do_viper_types) {
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit, "native yield");
+        return;
+    }
+    emit_native_pre(emit);
+    need_stack_settled(emit);
+
+    // the generator object takes the value to yield from code_state.sp, and
+    // puts the value sent in there
+    emit_get_stack_pointer_to_reg_for_pop(emit, REG_TEMP0, 1);
+    emit_native_mov_state_reg(emit, offsetof(mp_code_state_t, sp) / sizeof(mp_uint_t), REG_TEMP0);
+    mp_uint_t resume_id = emit_native_new_dispatch_id(emit);
+    emit_native_mov_state_imm_via(emit, STATE_RESUME, resume_id, REG_TEMP0);
+    emit_native_call_ind(emit, MP_F_NLR_POP);
+    ASM_MOV_IMM_TO_REG(emit->as, MP_VM_RETURN_YIELD, REG_RET);
+    ASM_EXIT(emit->as);
+
+    // resume here, raising the exception thrown in, if any
+    emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, resume_id));
+    emit_native_check_gen_throw(emit);
+    stack_info_t *si = &emit->stack_info[emit->stack_size];
+    si->kind = STACK_VALUE;
+    si->vtype = VTYPE_PYOBJ;
+    adjust_stack(emit, 1);
+    emit_post(emit);
 }
+
 STATIC void emit_native_yield_from(emit_t *emit) {
-    // not supported (for now)
-    (void)emit;
-    assert(0);
+    if (emit->do_viper_types) {
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit, "native yield from");
+        adjust_stack(emit, -1);
+        return;
+    }
+    // stack: (..., iter, send_value), with room above for the value thrown in
+    emit_native_pre(emit);
+    need_stack_settled(emit);
+    adjust_stack(emit, 1);
+    adjust_stack(emit, -1);
+    mp_uint_t iter_slot = emit->stack_start + emit->stack_size - 2;
+
+    // resume here, passing the value sent or thrown in to the delegate
+    mp_uint_t resume_id = emit_native_new_dispatch_id(emit);
+    mp_uint_t label_done = emit_native_local_label(emit, emit_native_new_local_label(emit));
+    emit_native_private_label_assign(emit, emit_native_dispatch_label(emit, resume_id));
+    ASM_MOV_LOCAL_TO_REG(emit->as, LOCAL_IDX_GEN_THROW, REG_TEMP0);
+    emit_native_mov_state_reg(emit, iter_slot + 2, REG_TEMP0);
+    ASM_MOV_IMM_TO_LOCAL_USING(emit->as, (mp_uint_t)MP_OBJ_NULL, LOCAL_IDX_GEN_THROW, REG_TEMP0);
+    emit_native_mov_reg_state(emit, REG_ARG_1, iter_slot);
+    emit_native_mov_reg_state_addr(emit, REG_ARG_2, iter_slot + 1);
+    emit_native_call_ind(emit, MP_F_NATIVE_YIELD_FROM);
+    ASM_JUMP_IF_REG_ZERO(emit->as, REG_RET, label_done);
+
+    // the delegate yielded a value, so yield it from here
+    emit_native_mov_reg_state_addr(emit, REG_TEMP0, iter_slot + 1);
+    emit_native_mov_state_reg(emit, offsetof(mp_code_state_t, sp) / sizeof(mp_uint_t), REG_TEMP0);
+    emit_native_mov_state_imm_via(emit, STATE_RESUME, resume_id, REG_TEMP0);
+    emit_native_call_ind(emit, MP_F_NLR_POP);
+    ASM_MOV_IMM_TO_REG(emit->as, MP_VM_RETURN_YIELD, REG_RET);
+    ASM_EXIT(emit->as);
+
+    // the delegate finished, with its return value in place of the value sent
+    emit_native_private_label_assign(emit, label_done);
+    vtype_kind_t vtype;
+    emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
+    emit_pre_pop_discard(emit);
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_TEMP0);
 }
 
 STATIC void emit_native_start_except_handler(emit_t *emit) {
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        // the exception was pushed by emit_native_label_assign
+        return;
+    }
     // This instruction follows an nlr_pop, so the stack counter is back to zero, when really
     // it should be up by a whole nlr_buf_t.  We then want to pop the nlr_buf_t here, but save
     // the first 2 elements, so we can get the thrown value.
@@ -2598,6 +3655,11 @@ STATIC void emit_native_start_except_handler(emit_t *emit) {
 }
 
 STATIC void emit_native_end_except_handler(emit_t *emit) {
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        assert(emit->exc_stack[emit->exc_stack_size - 1].kind == EXC_STACK_EXCEPT);
+        emit->exc_stack_size -= 1;
+        return;
+    }
     adjust_stack(emit, -1);
 }
 
@@ -2663,6 +3725,7 @@ const emit_method_table_t EXPORT_FUN(method_table) = {
     emit_native_get_iter,
     emit_native_for_iter,
     emit_native_for_iter_end,
+    emit_native_for_range,
     emit_native_pop_block,
     emit_native_pop_except,
     emit_native_unary_op,
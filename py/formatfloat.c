@@ -30,7 +30,9 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include "py/formatfloat.h"
+#include "py/parsenum.h"
 
 /***********************************************************************
 
@@ -424,4 +426,357 @@ int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, ch
     return s - buf;
 }
 
+#if MICROPY_FLOAT_REPR_SHORTEST
+
+/***********************************************************************
+
+  Shortest round-trip formatting, for repr() and str().
+
+  The digits are found by Grisu2 (Florian Loitsch, "Printing Floating-Point
+  Numbers Quickly and Accurately with Integers", PLDI 2010), as done by
+  Milo Yip's dtoa.  They always read back as the same value, and for all
+  but a tiny fraction of values there is no shorter such string.  Those
+  are found by also checking where the digits would end with the rounding
+  interval widened instead of narrowed, and then shorter candidates are
+  checked by reading them back.  Only integer arithmetic is used, so it is also much
+  faster than the loop in mp_format_float where floats are done in software.
+
+***********************************************************************/
+
+#if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+#define GRISU_MANT_BITS (23)
+#define GRISU_EXP_BIAS (127 + GRISU_MANT_BITS)
+#define GRISU_EXP_MASK (0xff)
+#define GRISU_FIXED_MAX (7) // as many digits as 'g' with precision 7
+#define GRISU_EXP_DIGITS (2)
+#define GRISU_POW_K0 (-44)
+typedef uint32_t grisu_bits_t;
+#else
+#define GRISU_MANT_BITS (52)
+#define GRISU_EXP_BIAS (1023 + GRISU_MANT_BITS)
+#define GRISU_EXP_MASK (0x7ff)
+#define GRISU_FIXED_MAX (16) // like CPython
+#define GRISU_EXP_DIGITS (3)
+#define GRISU_POW_K0 (-348)
+typedef uint64_t grisu_bits_t;
+#endif
+
+// A value f * 2^e, with a 64-bit f
+typedef struct _diy_fp_t {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+// Normalised 10^k for k = GRISU_POW_K0 + 8 * i, rounded to 64 bits
+STATIC const uint64_t grisu_pow_f[] = {
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+    0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+    0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+    0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+    0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+    0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+    0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+    0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac,
+    #endif
+    0xe45c10c42a2b3b06, 0xaa242499697392d3, 0xfd87b5f28300ca0e,
+    0xbce5086492111aeb, 0x8cbccc096f5088cc, 0xd1b71758e219652c,
+    0x9c40000000000000, 0xe8d4a51000000000, 0xad78ebc5ac620000,
+    0x813f3978f8940984, 0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70,
+    0xd5d238a4abe98068, 0x9f4f2726179a2245,
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    0xed63a231d4c4fb27, 0xb0de65388cc8ada8, 0x83c7088e1aab65db,
+    0xc45d1df942711d9a, 0x924d692ca61be758, 0xda01ee641a708dea,
+    0xa26da3999aef774a, 0xf209787bb47d6b85, 0xb454e4a179dd1877,
+    0x865b86925b9bc5c2, 0xc83553c5c8965d3d, 0x952ab45cfa97a0b3,
+    0xde469fbd99a05fe3, 0xa59bc234db398c25, 0xf6c69a72a3989f5c,
+    0xb7dcbf5354e9bece, 0x88fcf317f22241e2, 0xcc20ce9bd35c78a5,
+    0x98165af37b2153df, 0xe2a0b5dc971f303a, 0xa8d9d1535ce3b396,
+    0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410, 0x8bab8eefb6409c1a,
+    0xd01fef10a657842c, 0x9b10a4e5e9913129, 0xe7109bfba19c0c9d,
+    0xac2820d9623bf429, 0x80444b5e7aa7cf85, 0xbf21e44003acdd2d,
+    0x8e679c2f5e44ff8f, 0xd433179d9c8cb841, 0x9e19db92b4e31ba9,
+    0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b,
+    #endif
+};
+
+STATIC const int16_t grisu_pow_e[] = {
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236,
+    #endif
+    -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136,
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    162, 189, 216, 242, 269, 295, 322, 348, 375, 402,
+    428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933,
+    960, 986, 1013, 1039, 1066,
+    #endif
+};
+
+// x * y, rounded to the upper 64 bits of the product
+STATIC diy_fp_t grisu_mul(diy_fp_t x, diy_fp_t y) {
+    uint64_t a = x.f >> 32, b = x.f & 0xffffffff;
+    uint64_t c = y.f >> 32, d = y.f & 0xffffffff;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & 0xffffffff) + (bc & 0xffffffff) + (1U << 31);
+    diy_fp_t r = {ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64};
+    return r;
+}
+
+STATIC diy_fp_t grisu_normalize(diy_fp_t x) {
+    while (!(x.f & ((uint64_t)1 << 63))) {
+        x.f <<= 1;
+        x.e -= 1;
+    }
+    return x;
+}
+
+// Move the last digit down while the digits stay within the rounding
+// interval and get closer to the exact value
+STATIC void grisu_round(char *buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa
+        && (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+// Whether the digits would end at this point if the rounding interval was
+// widened by the possible error of the products, given the rest of w_p and
+// the size of that error
+STATIC bool grisu_wide_ends(uint64_t rest, uint64_t delta, uint64_t ten_kappa, uint64_t unit) {
+    rest += 2 * unit;
+    if (rest >= ten_kappa) {
+        rest -= ten_kappa;
+    }
+    return rest <= delta + 4 * unit;
+}
+
+// Generate the digits of f, which must be positive, and return how many
+// there are, at most 18; f is then the digits times 10^*k.  No string with
+// fewer than *min_len digits reads back as f.
+STATIC int grisu_digits(FPTYPE f, char *buf, int *k, int *min_len) {
+    union {
+        FPTYPE f;
+        grisu_bits_t u;
+    } fb = {f};
+    int biased_e = (fb.u >> GRISU_MANT_BITS) & GRISU_EXP_MASK;
+    diy_fp_t v = {fb.u & (((grisu_bits_t)1 << GRISU_MANT_BITS) - 1), 1 - GRISU_EXP_BIAS};
+    if (biased_e != 0) {
+        v.f += (uint64_t)1 << GRISU_MANT_BITS;
+        v.e = biased_e - GRISU_EXP_BIAS;
+    }
+
+    // the boundaries m- and m+ halfway to the neighbouring values, with the
+    // same exponent, that of v normalised
+    diy_fp_t w = grisu_normalize(v);
+    diy_fp_t w_p = {((v.f << 1) + 1) << (v.e - w.e - 1), w.e};
+    diy_fp_t w_m;
+    if (v.f == (uint64_t)1 << GRISU_MANT_BITS && biased_e > 1) {
+        // the gap below a power of 2 is half the gap above it
+        w_m.f = ((v.f << 2) - 1) << (v.e - w.e - 2);
+    } else {
+        w_m.f = ((v.f << 1) - 1) << (v.e - w.e - 1);
+    }
+    w_m.e = w.e;
+
+    // scale by a cached power of 10 so the exponent is in [-60, -32]
+    int i = ((-60 - 64 - w.e - grisu_pow_e[0]) * 1233 + 32767) >> 15;
+    while (grisu_pow_e[i] + w.e + 64 < -60) {
+        i++;
+    }
+    while (grisu_pow_e[i] + w.e + 64 > -32) {
+        i--;
+    }
+    diy_fp_t c = {grisu_pow_f[i], grisu_pow_e[i]};
+    *k = -(GRISU_POW_K0 + 8 * i);
+    w = grisu_mul(w, c);
+    w_p = grisu_mul(w_p, c);
+    w_m = grisu_mul(w_m, c);
+    w_m.f += 1;
+    w_p.f -= 1;
+
+    // generate digits of w_p until they are within delta of it
+    uint64_t delta = w_p.f - w_m.f;
+    uint64_t wp_w = w_p.f - w.f;
+    int shift = -w_p.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint32_t p1 = w_p.f >> shift;
+    uint64_t p2 = w_p.f & (one - 1);
+    int len = 0;
+    *min_len = 0;
+
+    // the integral part, a digit at a time from the most significant
+    static const uint32_t pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    int kappa = 10;
+    while (kappa > 0 && pow10[kappa - 1] > p1) {
+        kappa--;
+    }
+    while (kappa > 0) {
+        kappa--;
+        uint32_t d = p1 / pow10[kappa];
+        p1 %= pow10[kappa];
+        if (d != 0 || len != 0) {
+            buf[len++] = '0' + d;
+        }
+        uint64_t rest = ((uint64_t)p1 << shift) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            grisu_round(buf, len, delta, rest, (uint64_t)pow10[kappa] << shift, wp_w);
+            return len;
+        }
+        if (*min_len == 0 && grisu_wide_ends(rest, delta, (uint64_t)pow10[kappa] << shift, 1)) {
+            *min_len = MAX(len, 1);
+        }
+    }
+
+    // the fractional part
+    uint64_t unit = 1;
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        wp_w *= 10;
+        unit *= 10;
+        int d = p2 >> shift;
+        if (d != 0 || len != 0) {
+            buf[len++] = '0' + d;
+        }
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            grisu_round(buf, len, delta, p2, one, wp_w);
+            return len;
+        }
+        if (*min_len == 0 && grisu_wide_ends(p2, delta, one, unit)) {
+            *min_len = MAX(len, 1);
+        }
+    }
+}
+
+// Try to find fewer digits, from min_len, that read back as f: the two
+// nearest candidates for each length, as rounded from the digits found
+STATIC void grisu_shorten(FPTYPE f, char *digits, int *len, int *k, int min_len) {
+    for (int p = min_len; p < *len; p++) {
+        uint64_t mant = 0;
+        for (int i = 0; i < p; i++) {
+            mant = mant * 10 + (digits[i] - '0');
+        }
+        int e = *k + *len - p;
+        bool up_first = digits[p] >= '5';
+        for (int j = 0; j < 2; j++) {
+            uint64_t m = mant + (up_first != (j == 1));
+            if (mp_parse_num_decimal_exact(m, e) == f) {
+                for (; m % 10 == 0; m /= 10) {
+                    e++;
+                }
+                int n = 0;
+                for (uint64_t t = m; t != 0; t /= 10) {
+                    n++;
+                }
+                for (int i = n; i-- > 0; m /= 10) {
+                    digits[i] = '0' + m % 10;
+                }
+                *len = n;
+                *k = e;
+                return;
+            }
+        }
+    }
+}
+
+int mp_format_float_repr(FPTYPE f, char *buf, size_t buf_size) {
+    FPTYPE f_abs = fp_signbit(f) ? -f : f;
+    if (fp_iszero(f_abs) || (fp_isspecial(f_abs) && (fp_isinf(f_abs) || fp_isnan(f_abs)))) {
+        return mp_format_float(f, buf, buf_size, 'g', 1, '\0');
+    }
+
+    char digits[20];
+    int k;
+    int min_len;
+    int len = grisu_digits(f_abs, digits, &k, &min_len);
+    if (min_len != 0 && min_len < len) {
+        grisu_shorten(f_abs, digits, &len, &k, min_len);
+    }
+
+    // like 'g', use fixed notation unless the exponent is less than -4 or
+    // at least GRISU_FIXED_MAX
+    char *s = buf;
+    if (fp_signbit(f)) {
+        *s++ = '-';
+    }
+    int decpt = len + k;
+    if (decpt > -4 && decpt <= GRISU_FIXED_MAX) {
+        // this takes at most len + 5 chars, or GRISU_FIXED_MAX + 1
+        assert(buf_size > (size_t)(s - buf) + len + 5 && buf_size > (size_t)(s - buf) + GRISU_FIXED_MAX + 1);
+        if (decpt <= 0) {
+            *s++ = '0';
+            *s++ = '.';
+            for (; decpt < 0; decpt++) {
+                *s++ = '0';
+            }
+            memcpy(s, digits, len);
+            s += len;
+        } else if (decpt < len) {
+            memcpy(s, digits, decpt);
+            s += decpt;
+            *s++ = '.';
+            memcpy(s, digits + decpt, len - decpt);
+            s += len - decpt;
+        } else {
+            memcpy(s, digits, len);
+            s += len;
+            for (; decpt > len; decpt--) {
+                *s++ = '0';
+            }
+        }
+    } else {
+        assert(buf_size > (size_t)(s - buf) + len + 3 + GRISU_EXP_DIGITS);
+        *s++ = digits[0];
+        if (len > 1) {
+            *s++ = '.';
+            memcpy(s, digits + 1, len - 1);
+            s += len - 1;
+        }
+        *s++ = 'e';
+        int e = decpt - 1;
+        if (e < 0) {
+            *s++ = '-';
+            e = -e;
+        } else {
+            *s++ = '+';
+        }
+        if (e >= 100) {
+            *s++ = '0' + e / 100;
+        }
+        *s++ = '0' + e / 10 % 10;
+        *s++ = '0' + e % 10;
+    }
+    *s = '\0';
+    return s - buf;
+}
+
+#else // MICROPY_FLOAT_REPR_SHORTEST
+
+int mp_format_float_repr(FPTYPE f, char *buf, size_t buf_size) {
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+    return mp_format_float(f, buf, buf_size, 'g', 7, '\0');
+    #else
+    return mp_format_float(f, buf, buf_size, 'g', 16, '\0');
+    #endif
+}
+
+#endif // MICROPY_FLOAT_REPR_SHORTEST
+
 #endif // MICROPY_FLOAT_IMPL != MICROPY_FLOAT_IMPL_NONE
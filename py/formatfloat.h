@@ -30,6 +30,8 @@
 
 #if MICROPY_PY_BUILTINS_FLOAT
 int mp_format_float(mp_float_t f, char *buf, size_t bufSize, char fmt, int prec, char sign);
+// format f for repr() and str(), without adding a ".0"
+int mp_format_float_repr(mp_float_t f, char *buf, size_t buf_size);
 #endif
 
 #endif // __MICROPY_INCLUDED_PY_FORMATFLOAT_H__
@@ -31,6 +31,51 @@
 #include "py/lexer.h"
 #include "py/frozenmod.h"
 
+#if MICROPY_MODULE_FROZEN
+
+// The tools that make frozen modules list them sorted by name, as bytes, so
+// that a module is found by binary search rather than by going through all
+// of their names. Each kind of frozen module provides the i'th name through
+// a frozen_name_fun_t.
+typedef const char *(*frozen_name_fun_t)(const void *table, size_t i);
+
+// Compares the name with str[0:len], or if dir is true with str[0:len] + '/'
+// as a prefix, so that all the modules of a package compare equal to it.
+STATIC int frozen_name_cmp(const char *name, const char *str, size_t len, bool dir) {
+    for (size_t i = 0; i < len; i++) {
+        int d = (byte)name[i] - (byte)str[i];
+        if (d != 0) {
+            return d;
+        }
+    }
+    name += len;
+    if (dir) {
+        return (byte)*name - '/';
+    }
+    return (byte)*name;
+}
+
+// Returns the index of the module that matches str (see frozen_name_cmp) and
+// comes first, or -1 if there's none.
+STATIC mp_int_t frozen_lookup(frozen_name_fun_t get_name, const void *table, size_t n, const char *str, size_t len, bool dir) {
+    size_t lo = 0;
+    size_t hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (frozen_name_cmp(get_name(table, mid), str, len, dir) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < n && frozen_name_cmp(get_name(table, lo), str, len, dir) == 0) {
+        return lo;
+    }
+    return -1;
+}
+
+#endif
+
 #if MICROPY_MODULE_FROZEN_STR
 
 #ifndef MICROPY_MODULE_FROZEN_LEXER
@@ -42,22 +87,24 @@ mp_lexer_t *MICROPY_MODULE_FROZEN_LEXER(qstr src_name, const char *str, mp_uint_
 extern const char mp_frozen_str_names[];
 extern const uint32_t mp_frozen_str_sizes[];
 extern const char mp_frozen_str_content[];
+// index[0] is the number of modules, then come the offsets of their names in
+// mp_frozen_str_names, then the offsets of their source in the content
+extern const uint32_t mp_frozen_str_index[];
+
+STATIC const char *frozen_str_name(const void *table, size_t i) {
+    (void)table;
+    return mp_frozen_str_names + mp_frozen_str_index[1 + i];
+}
 
 STATIC mp_lexer_t *mp_find_frozen_str(const char *str, size_t len) {
-    const char *name = mp_frozen_str_names;
-
-    size_t offset = 0;
-    for (int i = 0; *name != 0; i++) {
-        size_t l = strlen(name);
-        if (l == len && !memcmp(str, name, l)) {
-            qstr source = qstr_from_strn(name, l);
-            mp_lexer_t *lex = MICROPY_MODULE_FROZEN_LEXER(source, mp_frozen_str_content + offset, mp_frozen_str_sizes[i], 0);
-            return lex;
-        }
-        name += l + 1;
-        offset += mp_frozen_str_sizes[i] + 1;
+    size_t n = mp_frozen_str_index[0];
+    mp_int_t i = frozen_lookup(frozen_str_name, NULL, n, str, len, false);
+    if (i < 0) {
+        return NULL;
     }
-    return NULL;
+    qstr source = qstr_from_strn(str, len);
+    const char *content = mp_frozen_str_content + mp_frozen_str_index[1 + n + i];
+    return MICROPY_MODULE_FROZEN_LEXER(source, content, mp_frozen_str_sizes[i], 0);
 }
 
 #endif
@@ -68,36 +115,149 @@ STATIC mp_lexer_t *mp_find_frozen_str(const char *str, size_t len) {
 
 extern const char mp_frozen_mpy_names[];
 extern const mp_raw_code_t *const mp_frozen_mpy_content[];
+// index[0] is the number of modules, then come the offsets of their names
+extern const uint32_t mp_frozen_mpy_index[];
+
+STATIC const char *frozen_mpy_name(const void *table, size_t i) {
+    (void)table;
+    return mp_frozen_mpy_names + mp_frozen_mpy_index[1 + i];
+}
 
 STATIC const mp_raw_code_t *mp_find_frozen_mpy(const char *str, size_t len) {
-    const char *name = mp_frozen_mpy_names;
-    for (size_t i = 0; *name != 0; i++) {
-        size_t l = strlen(name);
-        if (l == len && !memcmp(str, name, l)) {
-            return mp_frozen_mpy_content[i];
+    mp_int_t i = frozen_lookup(frozen_mpy_name, NULL, mp_frozen_mpy_index[0], str, len, false);
+    if (i < 0) {
+        return NULL;
+    }
+    return mp_frozen_mpy_content[i];
+}
+
+#endif
+
+#if MICROPY_MODULE_FROZEN_BUNDLE
+
+#include "py/emitglue.h"
+#include "py/mpstate.h"
+
+// A bundle, as made by tools/mpy-tool.py, is laid out as follows, with all
+// numbers little endian and all offsets from the start of the bundle:
+//  - 'M', 'B', version 1
+//  - MICROPY_QSTR_BYTES_IN_HASH | MICROPY_QSTR_BYTES_IN_LEN << 4
+//  - u16 id of the first qstr of the bundle, u16 number of them
+//  - u32 checksum of the qstrs of the firmware, see qstr_link_pool
+//  - u16 number of modules, u16 zero
+//  - u32 offset of the data of each qstr, in the format of qstr.c
+//  - u32 offset and u32 length of the .mpy image of each module, with its
+//    qstrs already linked, and u32 offset of its name
+//  - the name of each module followed by a '\0', then another '\0'
+// The modules are sorted by name.
+#define BUNDLE_HEADER_SIZE (16)
+#define BUNDLE_ENTRY_SIZE (12)
+
+STATIC size_t bundle_u16(const byte *p) {
+    return p[0] | p[1] << 8;
+}
+
+STATIC size_t bundle_u32(const byte *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+STATIC const byte *bundle_module_table(const byte *bundle) {
+    return bundle + BUNDLE_HEADER_SIZE + 4 * bundle_u16(bundle + 6);
+}
+
+STATIC const char *bundle_names(const byte *bundle) {
+    return (const char*)bundle_module_table(bundle) + BUNDLE_ENTRY_SIZE * bundle_u16(bundle + 12);
+}
+
+STATIC const char *bundle_name(const void *table, size_t i) {
+    const byte *bundle = table;
+    return (const char*)bundle + bundle_u32(bundle_module_table(bundle) + BUNDLE_ENTRY_SIZE * i + 8);
+}
+
+bool mp_frozen_bundle_mount(const byte *buf, size_t len) {
+    if (len < BUNDLE_HEADER_SIZE || buf[0] != 'M' || buf[1] != 'B' || buf[2] != 1
+        || buf[3] != (MICROPY_QSTR_BYTES_IN_HASH | MICROPY_QSTR_BYTES_IN_LEN << 4)) {
+        return false;
+    }
+    size_t n_qstr = bundle_u16(buf + 6);
+    size_t n_module = bundle_u16(buf + 12);
+    const byte *table = bundle_module_table(buf);
+    const char *names = bundle_names(buf);
+    if ((const byte*)names >= buf + len) {
+        return false;
+    }
+    for (size_t i = 0; i <= n_module; i++) {
+        const char *end = memchr(names, '\0', buf + len - (const byte*)names);
+        if (end == NULL) {
+            return false;
         }
-        name += l + 1;
+        names = end + 1;
+    }
+    for (size_t i = 0; i < n_module; i++) {
+        const byte *entry = table + BUNDLE_ENTRY_SIZE * i;
+        size_t offset = bundle_u32(entry);
+        if (offset > len || bundle_u32(entry + 4) > len - offset
+            || bundle_u32(entry + 8) >= (size_t)((const byte*)names - buf)) {
+            return false;
+        }
+    }
+
+    // the qstrs are used from where they are, only the pool is in RAM
+    qstr_pool_t *pool = m_new_obj_var(qstr_pool_t, const byte*, n_qstr);
+    pool->total_prev_len = bundle_u16(buf + 4);
+    pool->alloc = n_qstr;
+    pool->len = n_qstr;
+    for (size_t i = 0; i < n_qstr; i++) {
+        size_t offset = bundle_u32(buf + BUNDLE_HEADER_SIZE + 4 * i);
+        if (offset >= len) {
+            m_del_var(qstr_pool_t, const byte*, n_qstr, pool);
+            return false;
+        }
+        pool->qstrs[i] = buf + offset;
+    }
+    if (!qstr_link_pool(pool, bundle_u32(buf + 8))) {
+        m_del_var(qstr_pool_t, const byte*, n_qstr, pool);
+        return false;
+    }
+    if (n_qstr == 0) {
+        m_del_var(qstr_pool_t, const byte*, n_qstr, pool);
+    }
+    MP_STATE_VM(frozen_bundle) = buf;
+    return true;
+}
+
+STATIC const mp_raw_code_t *mp_find_frozen_bundle(const char *str, size_t len) {
+    const byte *bundle = MP_STATE_VM(frozen_bundle);
+    if (bundle == NULL) {
+        return NULL;
+    }
+    mp_int_t i = frozen_lookup(bundle_name, bundle, bundle_u16(bundle + 12), str, len, false);
+    if (i < 0) {
+        return NULL;
+    }
+    const byte *entry = bundle_module_table(bundle) + BUNDLE_ENTRY_SIZE * i;
+    const byte *mpy = bundle + bundle_u32(entry);
+    size_t mpy_len = bundle_u32(entry + 4);
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    mp_raw_code_t *rc = mp_raw_code_load_xip(mpy, mpy_len);
+    if (rc != NULL) {
+        return rc;
     }
-    return NULL;
+    #endif
+    return mp_raw_code_load_mem(mpy, mpy_len);
 }
 
 #endif
 
 #if MICROPY_MODULE_FROZEN
 
-STATIC mp_import_stat_t mp_frozen_stat_helper(const char *name, const char *str) {
+STATIC mp_import_stat_t mp_frozen_stat_helper(frozen_name_fun_t get_name, const void *table, size_t n, const char *str) {
     size_t len = strlen(str);
-
-    for (int i = 0; *name != 0; i++) {
-        size_t l = strlen(name);
-        if (l >= len && !memcmp(str, name, len)) {
-            if (name[len] == 0) {
-                return MP_IMPORT_STAT_FILE;
-            } else if (name[len] == '/') {
-                return MP_IMPORT_STAT_DIR;
-            }
-        }
-        name += l + 1;
+    if (frozen_lookup(get_name, table, n, str, len, false) >= 0) {
+        return MP_IMPORT_STAT_FILE;
+    }
+    if (frozen_lookup(get_name, table, n, str, len, true) >= 0) {
+        return MP_IMPORT_STAT_DIR;
     }
     return MP_IMPORT_STAT_NO_EXIST;
 }
@@ -106,19 +266,29 @@ mp_import_stat_t mp_frozen_stat(const char *str) {
     mp_import_stat_t stat;
 
     #if MICROPY_MODULE_FROZEN_STR
-    stat = mp_frozen_stat_helper(mp_frozen_str_names, str);
+    stat = mp_frozen_stat_helper(frozen_str_name, NULL, mp_frozen_str_index[0], str);
     if (stat != MP_IMPORT_STAT_NO_EXIST) {
         return stat;
     }
     #endif
 
     #if MICROPY_MODULE_FROZEN_MPY
-    stat = mp_frozen_stat_helper(mp_frozen_mpy_names, str);
+    stat = mp_frozen_stat_helper(frozen_mpy_name, NULL, mp_frozen_mpy_index[0], str);
     if (stat != MP_IMPORT_STAT_NO_EXIST) {
         return stat;
     }
     #endif
 
+    #if MICROPY_MODULE_FROZEN_BUNDLE
+    const byte *bundle = MP_STATE_VM(frozen_bundle);
+    if (bundle != NULL) {
+        stat = mp_frozen_stat_helper(bundle_name, bundle, bundle_u16(bundle + 12), str);
+        if (stat != MP_IMPORT_STAT_NO_EXIST) {
+            return stat;
+        }
+    }
+    #endif
+
     return MP_IMPORT_STAT_NO_EXIST;
 }
 
@@ -137,6 +307,13 @@ int mp_find_frozen_module(const char *str, size_t len, void **data) {
         return MP_FROZEN_MPY;
     }
     #endif
+    #if MICROPY_MODULE_FROZEN_BUNDLE
+    const mp_raw_code_t *bundle_rc = mp_find_frozen_bundle(str, len);
+    if (bundle_rc != NULL) {
+        *data = (void*)bundle_rc;
+        return MP_FROZEN_MPY;
+    }
+    #endif
     return MP_FROZEN_NONE;
 }
 
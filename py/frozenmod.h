@@ -31,4 +31,9 @@ enum {
 };
 
 int mp_find_frozen_module(const char *str, size_t len, void **data);
+#if MICROPY_MODULE_FROZEN_BUNDLE
+// buf must stay mapped for as long as the VM runs. Returns false if it holds
+// no bundle, or one made for other firmware.
+bool mp_frozen_bundle_mount(const byte *buf, size_t len);
+#endif
 mp_import_stat_t mp_frozen_stat(const char *str);
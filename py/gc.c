@@ -29,9 +29,13 @@
 #include <string.h>
 
 #include "py/mpstate.h"
+#include "py/mphal.h"
 #include "py/gc.h"
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/binary.h"
+#include "py/bc.h"
+#include "py/objarray.h"
 
 #if MICROPY_ENABLE_GC
 
@@ -73,11 +77,29 @@
 
 #define BLOCK_SHIFT(block) (2 * ((block) & (BLOCKS_PER_ATB - 1)))
 #define ATB_GET_KIND(block) ((MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] >> BLOCK_SHIFT(block)) & 3)
-#define ATB_ANY_TO_FREE(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] &= (~(AT_MARK << BLOCK_SHIFT(block))); } while (0)
-#define ATB_FREE_TO_HEAD(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_HEAD << BLOCK_SHIFT(block)); } while (0)
-#define ATB_FREE_TO_TAIL(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_TAIL << BLOCK_SHIFT(block)); } while (0)
-#define ATB_HEAD_TO_MARK(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_MARK << BLOCK_SHIFT(block)); } while (0)
-#define ATB_MARK_TO_HEAD(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] &= (~(AT_TAIL << BLOCK_SHIFT(block))); } while (0)
+
+#if MICROPY_GC_THREAD_ALLOC_BLOCKS
+// Threads change the ATBs of their own allocation region without holding the
+// GC mutex, so all other updates must not clobber neighbouring blocks.
+#define ATB_AND(block, mask) __atomic_fetch_and(&MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB], (byte)(mask), __ATOMIC_RELAXED)
+#define ATB_OR(block, bits) __atomic_fetch_or(&MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB], (byte)(bits), __ATOMIC_RELAXED)
+#define ATB_TAIL_TO_HEAD(block) do { __atomic_fetch_xor(&MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB], (byte)(AT_MARK << BLOCK_SHIFT(block)), __ATOMIC_RELAXED); } while (0)
+#else
+#define ATB_AND(block, mask) (MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] &= (mask))
+#define ATB_OR(block, bits) (MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (bits))
+#endif
+
+#define ATB_ANY_TO_FREE(block) do { ATB_AND(block, ~(AT_MARK << BLOCK_SHIFT(block))); } while (0)
+#define ATB_FREE_TO_HEAD(block) do { ATB_OR(block, AT_HEAD << BLOCK_SHIFT(block)); } while (0)
+#define ATB_FREE_TO_TAIL(block) do { ATB_OR(block, AT_TAIL << BLOCK_SHIFT(block)); } while (0)
+#define ATB_HEAD_TO_MARK(block) do { ATB_OR(block, AT_MARK << BLOCK_SHIFT(block)); } while (0)
+#define ATB_MARK_TO_HEAD(block) do { ATB_AND(block, ~(AT_TAIL << BLOCK_SHIFT(block))); } while (0)
+
+// a marked head outside of a collection is a live head that is not swept yet
+#define ATB_IS_HEAD(block) (ATB_GET_KIND(block) & AT_HEAD)
+
+// value of the sweep cursor when no sweep is pending
+#define GC_SWEEP_DONE ((size_t)-1)
 
 #define BLOCK_FROM_PTR(ptr) (((byte*)(ptr) - MP_STATE_MEM(gc_pool_start)) / BYTES_PER_BLOCK)
 #define PTR_FROM_BLOCK(block) (((block) * BYTES_PER_BLOCK + (uintptr_t)MP_STATE_MEM(gc_pool_start)))
@@ -94,6 +116,26 @@
 #define FTB_CLEAR(block) do { MP_STATE_MEM(gc_finaliser_table_start)[(block) / BLOCKS_PER_FTB] &= (~(1 << ((block) & 7))); } while (0)
 #endif
 
+#if MICROPY_GC_COMPACT
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+#error MICROPY_GC_COMPACT requires the GIL when threads are enabled
+#endif
+
+// CTB = compaction table bits, same layout as the ATBs
+// PINNED -- the chain this block is in must not move
+// OWNED -- an array object refers to this block as its buffer
+
+#define CTB_PINNED (1)
+#define CTB_OWNED (2)
+
+#define CTB_GET(block) ((MP_STATE_MEM(gc_compact_table)[(block) / BLOCKS_PER_ATB] >> BLOCK_SHIFT(block)) & 3)
+#if MICROPY_GC_PARALLEL_MARK
+#define CTB_SET(block, bits) do { __atomic_fetch_or(&MP_STATE_MEM(gc_compact_table)[(block) / BLOCKS_PER_ATB], (byte)((bits) << BLOCK_SHIFT(block)), __ATOMIC_RELAXED); } while (0)
+#else
+#define CTB_SET(block, bits) do { MP_STATE_MEM(gc_compact_table)[(block) / BLOCKS_PER_ATB] |= ((bits) << BLOCK_SHIFT(block)); } while (0)
+#endif
+#endif
+
 #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
 #define GC_ENTER() mp_thread_mutex_lock(&MP_STATE_MEM(gc_mutex), 1)
 #define GC_EXIT() mp_thread_mutex_unlock(&MP_STATE_MEM(gc_mutex))
@@ -111,6 +153,17 @@ void __attribute__ ((noinline)) gc_log_change(uint32_t start_block, uint32_t len
 }
 #endif
 
+#if MICROPY_GC_LONG_LIVED
+// Long-lived objects go below the nursery, which is kept for short-lived ones.
+STATIC size_t gc_long_lived_limit(void) {
+    #if MICROPY_GC_NURSERY_BLOCKS
+    return MP_STATE_MEM(gc_nursery_start);
+    #else
+    return MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    #endif
+}
+#endif
+
 // TODO waste less memory; currently requires that all entries in alloc_table have a corresponding block in pool
 void gc_init(void *start, void *end) {
     // align end pointer on block boundary
@@ -152,8 +205,60 @@ void gc_init(void *start, void *end) {
     memset(MP_STATE_MEM(gc_finaliser_table_start), 0, gc_finaliser_table_byte_len);
 #endif
 
-    // set last free ATB index to start of heap
-    MP_STATE_MEM(gc_last_free_atb_index) = 0;
+    // set first free ATB index of all size classes to start of heap
+    for (size_t c = 0; c < MICROPY_GC_FREE_INDEX_CLASSES; c++) {
+        MP_STATE_MEM(gc_first_free_atb_index)[c] = 0;
+    }
+
+    // nothing to sweep
+    MP_STATE_MEM(gc_sweep_block) = GC_SWEEP_DONE;
+
+    #if MICROPY_GC_PARALLEL_MARK
+    MP_STATE_MEM(gc_mark_parallel) = false;
+    #endif
+
+    #if MICROPY_GC_COMPACT
+    MP_STATE_MEM(gc_compact_table) = NULL;
+    #endif
+
+    #if MICROPY_GC_ALLOC_PROFILE
+    MP_STATE_MEM(gc_profile_rate) = 0;
+    MP_STATE_MEM(gc_profile_len) = 0;
+    MP_STATE_MEM(gc_profile_live) = 0;
+    #endif
+
+    #if MICROPY_GC_NURSERY_BLOCKS
+    // the nursery takes up at most a quarter of the heap
+    size_t nursery_len = MIN(MICROPY_GC_NURSERY_BLOCKS, gc_pool_block_len / 4) & ~(BLOCKS_PER_ATB - 1);
+    MP_STATE_MEM(gc_nursery_start) = gc_pool_block_len - nursery_len;
+    MP_STATE_MEM(gc_nursery_next) = MP_STATE_MEM(gc_nursery_start);
+    MP_STATE_MEM(gc_nursery_full) = nursery_len == 0;
+    #endif
+
+    #if MICROPY_GC_LONG_LIVED
+    MP_STATE_MEM(gc_long_lived_top) = gc_long_lived_limit();
+    #endif
+
+    #if MICROPY_GC_PARTIAL_COLLECT
+    MP_STATE_MEM(gc_partial) = false;
+    MP_STATE_THREAD(gc_partial_start) = 0;
+    MP_STATE_THREAD(gc_partial_end) = 0;
+    #endif
+
+    #if MICROPY_GC_ARENA
+    MP_STATE_VM(gc_arena_list) = NULL;
+    MP_STATE_THREAD(gc_arena) = NULL;
+    #endif
+
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // register the allocation region of the main thread
+    MP_STATE_MEM(gc_collecting) = 0;
+    MP_STATE_MEM(gc_thread_alloc_list) = NULL;
+    gc_thread_alloc_start();
+    #endif
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    MP_STATE_MEM(gc_sweep_quantum) = MICROPY_GC_SWEEP_QUANTUM;
+    #endif
 
     // unlock the GC
     MP_STATE_MEM(gc_lock_depth) = 0;
@@ -165,6 +270,16 @@ void gc_init(void *start, void *end) {
     // by default, maxuint for gc threshold, effectively turning gc-by-threshold off
     MP_STATE_MEM(gc_alloc_threshold) = (size_t)-1;
     MP_STATE_MEM(gc_alloc_amount) = 0;
+    MP_STATE_MEM(gc_threshold_reached) = false;
+    #endif
+
+    #if MICROPY_GC_STATS
+    MP_STATE_MEM(gc_stats_collections) = 0;
+    MP_STATE_MEM(gc_stats_alloc_collections) = 0;
+    MP_STATE_MEM(gc_stats_pause_total) = 0;
+    MP_STATE_MEM(gc_stats_pause_max) = 0;
+    MP_STATE_MEM(gc_stats_alloc_bytes) = 0;
+    MP_STATE_MEM(gc_stats_alloc_count) = 0;
     #endif
 
     #if MICROPY_PY_THREAD
@@ -195,6 +310,93 @@ bool gc_is_locked(void) {
     return MP_STATE_MEM(gc_lock_depth) != 0;
 }
 
+// Adjust the free index after the blocks starting at the given block were
+// freed.  The freed blocks may join a free run that starts up to c blocks
+// earlier, so a run of c + 1 blocks can now start that far back.
+STATIC void gc_free_index_update(size_t block) {
+    for (size_t c = 0; c < MICROPY_GC_FREE_INDEX_CLASSES; c++) {
+        size_t atb = (block > c ? block - c : 0) / BLOCKS_PER_ATB;
+        if (atb < MP_STATE_MEM(gc_first_free_atb_index)[c]) {
+            MP_STATE_MEM(gc_first_free_atb_index)[c] = atb;
+        }
+    }
+    #if MICROPY_GC_LONG_LIVED
+    // the freed blocks may be the highest free ones now
+    if (block >= MP_STATE_MEM(gc_long_lived_top) && block < gc_long_lived_limit()) {
+        MP_STATE_MEM(gc_long_lived_top) = gc_long_lived_limit();
+    }
+    #endif
+}
+
+#if MICROPY_GC_ALLOC_PROFILE
+
+void gc_profile_set_rate(size_t rate) {
+    GC_ENTER();
+    MP_STATE_MEM(gc_profile_rate) = rate;
+    MP_STATE_MEM(gc_profile_countdown) = rate;
+    if (rate != 0) {
+        MP_STATE_MEM(gc_profile_clock) = 0;
+        MP_STATE_MEM(gc_profile_len) = 0;
+        MP_STATE_MEM(gc_profile_live) = 0;
+    }
+    GC_EXIT();
+}
+
+size_t gc_profile_get(mp_gc_profile_entry_t *dest) {
+    GC_ENTER();
+    size_t len = MP_STATE_MEM(gc_profile_len);
+    size_t n = MIN(len, MICROPY_GC_ALLOC_PROFILE_ENTRIES);
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = MP_STATE_MEM(gc_profile_entries)[(len - n + i) % MICROPY_GC_ALLOC_PROFILE_ENTRIES];
+    }
+    GC_EXIT();
+    return n;
+}
+
+// Count an allocation, and record it if it is the one to sample.
+STATIC void gc_profile_alloc(size_t block, size_t n_blocks) {
+    GC_ENTER();
+    MP_STATE_MEM(gc_profile_clock) += n_blocks;
+    if (MP_STATE_MEM(gc_profile_countdown) > n_blocks) {
+        MP_STATE_MEM(gc_profile_countdown) -= n_blocks;
+        GC_EXIT();
+        return;
+    }
+    MP_STATE_MEM(gc_profile_countdown) = MP_STATE_MEM(gc_profile_rate);
+    size_t len = MP_STATE_MEM(gc_profile_len)++;
+    mp_gc_profile_entry_t *e = &MP_STATE_MEM(gc_profile_entries)[len % MICROPY_GC_ALLOC_PROFILE_ENTRIES];
+    if (len >= MICROPY_GC_ALLOC_PROFILE_ENTRIES && e->death == 0) {
+        // the oldest entry is overwritten
+        MP_STATE_MEM(gc_profile_live)--;
+    }
+    e->block = block;
+    e->n_blocks = n_blocks;
+    e->birth = MP_STATE_MEM(gc_profile_clock);
+    e->death = 0;
+    e->block_name = mp_bytecode_current_site(&e->bc_offset);
+    MP_STATE_MEM(gc_profile_live)++;
+    GC_EXIT();
+}
+
+// Record the end of a sampled allocation with the given head being freed.
+// The GC must be entered by the caller.
+STATIC void gc_profile_free(size_t block) {
+    if (MP_STATE_MEM(gc_profile_live) == 0) {
+        return;
+    }
+    size_t n = MIN(MP_STATE_MEM(gc_profile_len), MICROPY_GC_ALLOC_PROFILE_ENTRIES);
+    for (size_t i = 0; i < n; i++) {
+        mp_gc_profile_entry_t *e = &MP_STATE_MEM(gc_profile_entries)[i];
+        if (e->block == block && e->death == 0) {
+            e->death = MP_STATE_MEM(gc_profile_clock);
+            MP_STATE_MEM(gc_profile_live)--;
+            return;
+        }
+    }
+}
+
+#endif // MICROPY_GC_ALLOC_PROFILE
+
 // ptr should be of type void*
 #define VERIFY_PTR(ptr) ( \
         ((uintptr_t)(ptr) & (BYTES_PER_BLOCK - 1)) == 0      /* must be aligned on a block */ \
@@ -202,12 +404,19 @@ bool gc_is_locked(void) {
         && ptr < (void*)MP_STATE_MEM(gc_pool_end)        /* must be below end of pool */ \
     )
 
+#if MICROPY_GC_PARTIAL_COLLECT
+// a partial collection takes everything outside its range to be live
+#define GC_TRACE_BLOCK(block) (!MP_STATE_MEM(gc_partial) || ((block) >= MP_STATE_MEM(gc_partial_start) && (block) < MP_STATE_MEM(gc_partial_end)))
+#else
+#define GC_TRACE_BLOCK(block) (1)
+#endif
+
 // ptr should be of type void*
 #define VERIFY_MARK_AND_PUSH(ptr) \
     do { \
         if (VERIFY_PTR(ptr)) { \
             size_t _block = BLOCK_FROM_PTR(ptr); \
-            if (ATB_GET_KIND(_block) == AT_HEAD) { \
+            if (ATB_GET_KIND(_block) == AT_HEAD && GC_TRACE_BLOCK(_block)) { \
                 /* an unmarked head, mark it, and push it on gc stack */ \
                 DEBUG_printf("gc_mark(%p)\n", ptr); \
                 ATB_HEAD_TO_MARK(_block); \
@@ -256,15 +465,54 @@ STATIC void gc_deal_with_stack_overflow(void) {
     }
 }
 
-STATIC void gc_sweep(void) {
-    #if MICROPY_PY_GC_COLLECT_RETVAL
-    MP_STATE_MEM(gc_collected) = 0;
-    #endif
-    // free unmarked heads and their tails
+#if MICROPY_GC_ARENA
+// Return whether the given block is in the chunk of an arena in use.
+STATIC bool gc_arena_holds(size_t block) {
+    byte *ptr = (byte*)PTR_FROM_BLOCK(block);
+    for (gc_arena_t *arena = MP_STATE_VM(gc_arena_list); arena != NULL; arena = arena->next) {
+        if (ptr >= arena->start && ptr < arena->end) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+// Sweep at most n_blocks blocks starting at the sweep cursor, freeing unmarked
+// heads and their tails.  The GC must be entered and locked by the caller.
+// A sweep always runs to the end of the chain it is in, so no state is carried
+// over to the next step: a tail block found at the cursor later on can only
+// belong to a live chain that was extended in the meantime.
+STATIC void gc_sweep(size_t n_blocks) {
+    size_t block = MP_STATE_MEM(gc_sweep_block);
+    if (block == GC_SWEEP_DONE) {
+        return;
+    }
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t end_block = n_blocks < total_blocks - block ? block + n_blocks : total_blocks;
+
+    // The free index can only be rebuilt exactly if the whole heap is swept in
+    // one go, otherwise it is moved back as blocks are freed.
+    bool rebuild_index = block == 0 && end_block == total_blocks;
+    size_t run_start = 0;
+    size_t run_len = 0;
+    size_t next_class = 0;
+
     int free_tail = 0;
-    for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
-        switch (ATB_GET_KIND(block)) {
+    for (; block < total_blocks; block++) {
+        size_t kind = ATB_GET_KIND(block);
+        if (block >= end_block && kind != AT_TAIL) {
+            break;
+        }
+        switch (kind) {
             case AT_HEAD:
+                #if MICROPY_GC_ARENA
+                if (MP_STATE_VM(gc_arena_list) != NULL && gc_arena_holds(block)) {
+                    // arena objects are released when the arena is exited
+                    free_tail = 0;
+                    break;
+                }
+                #endif
 #if MICROPY_ENABLE_FINALISER
                 if (FTB_GET(block)) {
                     #if MICROPY_PY_THREAD
@@ -294,6 +542,12 @@ STATIC void gc_sweep(void) {
                 #if MICROPY_PY_GC_COLLECT_RETVAL
                 MP_STATE_MEM(gc_collected)++;
                 #endif
+                if (!rebuild_index) {
+                    gc_free_index_update(block);
+                }
+                #if MICROPY_GC_ALLOC_PROFILE
+                gc_profile_free(block);
+                #endif
                 // fall through to free the head
 
             case AT_TAIL:
@@ -307,15 +561,267 @@ STATIC void gc_sweep(void) {
                 free_tail = 0;
                 break;
         }
+
+        if (!rebuild_index) {
+            continue;
+        }
+        if (ATB_GET_KIND(block) == AT_FREE) {
+            if (run_len++ == 0) {
+                run_start = block;
+            }
+            // the first run to reach a given length is where that class starts
+            while (next_class < MICROPY_GC_FREE_INDEX_CLASSES && run_len > next_class) {
+                MP_STATE_MEM(gc_first_free_atb_index)[next_class++] = run_start / BLOCKS_PER_ATB;
+            }
+        } else {
+            run_len = 0;
+        }
+    }
+
+    if (block < total_blocks) {
+        MP_STATE_MEM(gc_sweep_block) = block;
+        return;
+    }
+    MP_STATE_MEM(gc_sweep_block) = GC_SWEEP_DONE;
+
+    if (rebuild_index) {
+        // no free run is long enough for the remaining classes
+        while (next_class < MICROPY_GC_FREE_INDEX_CLASSES) {
+            MP_STATE_MEM(gc_first_free_atb_index)[next_class++] = MP_STATE_MEM(gc_alloc_table_byte_len);
+        }
+        #if MICROPY_GC_LONG_LIVED
+        MP_STATE_MEM(gc_long_lived_top) = gc_long_lived_limit();
+        #endif
+    }
+}
+
+#if MICROPY_GC_INCREMENTAL_SWEEP
+void gc_sweep_step(void) {
+    GC_ENTER();
+    if (MP_STATE_MEM(gc_sweep_block) != GC_SWEEP_DONE && MP_STATE_MEM(gc_lock_depth) == 0) {
+        size_t quantum = MP_STATE_MEM(gc_sweep_quantum);
+        MP_STATE_MEM(gc_lock_depth)++;
+        gc_sweep(quantum == 0 ? SIZE_MAX : quantum);
+        MP_STATE_MEM(gc_lock_depth)--;
+    }
+    GC_EXIT();
+}
+#endif
+
+#if MICROPY_GC_ALLOC_THRESHOLD
+void gc_threshold_collect(void) {
+    MP_STATE_MEM(gc_threshold_reached) = false;
+    if (MP_STATE_MEM(gc_auto_collect_enabled) && MP_STATE_MEM(gc_lock_depth) == 0) {
+        gc_collect();
+    }
+}
+#endif
+
+#if MICROPY_GC_PARTIAL_COLLECT
+// Scan the allocated blocks from start_block up to end_block for pointers
+// into the range being collected.
+STATIC void gc_partial_scan(size_t start_block, size_t end_block) {
+    byte *range_start = (byte*)PTR_FROM_BLOCK(MP_STATE_MEM(gc_partial_start));
+    byte *range_end = (byte*)PTR_FROM_BLOCK(MP_STATE_MEM(gc_partial_end));
+    for (size_t block = start_block; block < end_block; block++) {
+        if (ATB_GET_KIND(block) == AT_FREE) {
+            continue;
+        }
+        void **ptrs = (void**)PTR_FROM_BLOCK(block);
+        for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+            void *ptr = ptrs[i];
+            if ((byte*)ptr >= range_start && (byte*)ptr < range_end) {
+                VERIFY_MARK_AND_PUSH(ptr);
+                gc_drain_stack();
+            }
+        }
+    }
+}
+
+// There is no write barrier to record which objects outside the range were
+// given a pointer into it, so all of them make up the remembered set.  They
+// are only scanned for pointers into the range, not traced, which is a lot
+// cheaper than marking the whole heap.  A chain that starts before the range
+// may extend into it, and its tail is scanned as well.
+STATIC void gc_partial_scan_remembered(void) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t end_block = MP_STATE_MEM(gc_partial_start);
+    while (end_block < total_blocks && ATB_GET_KIND(end_block) == AT_TAIL) {
+        end_block++;
+    }
+    gc_partial_scan(0, end_block);
+    gc_partial_scan(MAX(end_block, MP_STATE_MEM(gc_partial_end)), total_blocks);
+}
+
+// Run a collection, by way of gc_collect, that only reclaims unreachable
+// objects whose head is from start_block up to end_block.
+STATIC void gc_collect_partial(size_t start_block, size_t end_block) {
+    MP_STATE_THREAD(gc_partial_start) = start_block;
+    MP_STATE_THREAD(gc_partial_end) = end_block;
+    gc_collect();
+    MP_STATE_THREAD(gc_partial_end) = MP_STATE_THREAD(gc_partial_start);
+}
+#endif
+
+#if MICROPY_GC_NURSERY_BLOCKS
+void gc_collect_minor(void) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    gc_collect_partial(MP_STATE_MEM(gc_nursery_start), total_blocks);
+    GC_ENTER();
+    size_t n_free = 0;
+    for (size_t block = MP_STATE_MEM(gc_nursery_start); block < total_blocks; block++) {
+        n_free += ATB_GET_KIND(block) == AT_FREE;
+    }
+    MP_STATE_MEM(gc_nursery_full) = n_free < (total_blocks - MP_STATE_MEM(gc_nursery_start)) / 2;
+    MP_STATE_MEM(gc_nursery_next) = MP_STATE_MEM(gc_nursery_start);
+    GC_EXIT();
+}
+#endif
+
+#if MICROPY_GC_ARENA
+bool gc_arena_enter(gc_arena_t *arena, size_t n_bytes) {
+    // the chunk itself comes from the heap, not from an enclosing arena
+    arena->prev = MP_STATE_THREAD(gc_arena);
+    MP_STATE_THREAD(gc_arena) = NULL;
+    n_bytes = (n_bytes + BYTES_PER_BLOCK - 1) & ~(BYTES_PER_BLOCK - 1);
+    byte *chunk = gc_alloc(n_bytes, false);
+    MP_STATE_THREAD(gc_arena) = arena->prev;
+    if (chunk == NULL) {
+        return false;
+    }
+    // objects are carved off the chunk without being cleared
+    memset(chunk, 0, n_bytes);
+    arena->start = chunk;
+    arena->free = chunk;
+    arena->end = chunk + n_bytes;
+    GC_ENTER();
+    #if MICROPY_GC_STATS
+    // the objects carved off the chunk are counted, not the chunk itself
+    MP_STATE_MEM(gc_stats_alloc_bytes) -= n_bytes;
+    MP_STATE_MEM(gc_stats_alloc_count) -= 1;
+    #endif
+    arena->next = MP_STATE_VM(gc_arena_list);
+    MP_STATE_VM(gc_arena_list) = arena;
+    GC_EXIT();
+    MP_STATE_THREAD(gc_arena) = arena;
+    return true;
+}
+
+void gc_arena_exit(gc_arena_t *arena, bool collect) {
+    MP_STATE_THREAD(gc_arena) = arena->prev;
+    GC_ENTER();
+    for (gc_arena_t **p = &MP_STATE_VM(gc_arena_list); *p != NULL; p = &(*p)->next) {
+        if (*p == arena) {
+            *p = arena->next;
+            break;
+        }
+    }
+    if (MP_STATE_MEM(gc_lock_depth) > 0) {
+        // the objects are like any others now, and the unused part of the
+        // chunk is garbage, so the next collection will deal with them
+        GC_EXIT();
+        return;
+    }
+    size_t start_block = BLOCK_FROM_PTR(arena->start);
+    size_t end_block = BLOCK_FROM_PTR(arena->end);
+    if (collect) {
+        GC_EXIT();
+        // the unused part of the chunk is only referred to by the arena
+        if (arena->free < arena->end) {
+            gc_free(arena->free);
+        }
+        arena->free = arena->end;
+        gc_collect_partial(start_block, end_block);
+        return;
+    }
+    // none of the objects have a finaliser, so the whole chunk, objects and
+    // unused part alike, can be freed in one go
+    for (size_t block = start_block; block < end_block; block++) {
+        #if MICROPY_GC_ALLOC_PROFILE
+        if (ATB_IS_HEAD(block)) {
+            gc_profile_free(block);
+        }
+        #endif
+        ATB_ANY_TO_FREE(block);
+    }
+    gc_free_index_update(start_block);
+    #ifdef LOG_HEAP_ACTIVITY
+    gc_log_change(start_block, 0);
+    #endif
+    GC_EXIT();
+}
+
+// Carve n_blocks off the front of the chunk of the current arena, or return
+// NULL if they don't fit.  The unused part of the chunk is a single chain
+// whose head is the next block to hand out.
+STATIC void *gc_arena_alloc(gc_arena_t *arena, size_t n_bytes, size_t n_blocks) {
+    if (n_blocks * BYTES_PER_BLOCK > (size_t)(arena->end - arena->free)) {
+        return NULL;
+    }
+    GC_ENTER();
+    if (MP_STATE_MEM(gc_lock_depth) > 0) {
+        GC_EXIT();
+        return NULL;
     }
+    void *ret_ptr = arena->free;
+    arena->free += n_blocks * BYTES_PER_BLOCK;
+    if (arena->free < arena->end) {
+        // if not swept yet the new head is marked, like any new allocation
+        size_t block = BLOCK_FROM_PTR(arena->free);
+        ATB_ANY_TO_FREE(block);
+        ATB_FREE_TO_HEAD(block);
+        if (block >= MP_STATE_MEM(gc_sweep_block)) {
+            ATB_HEAD_TO_MARK(block);
+        }
+    }
+    #if MICROPY_GC_STATS
+    MP_STATE_MEM(gc_stats_alloc_bytes) += n_bytes;
+    MP_STATE_MEM(gc_stats_alloc_count) += 1;
+    #endif
+    GC_EXIT();
+    DEBUG_printf("gc_arena_alloc(%p)\n", ret_ptr);
+    return ret_ptr;
 }
+#endif
+
+#if MICROPY_GC_STATS
+STATIC void gc_stats_collect_end(void) {
+    mp_uint_t pause = mp_hal_ticks_us() - MP_STATE_MEM(gc_stats_pause_start);
+    MP_STATE_MEM(gc_stats_collections)++;
+    MP_STATE_MEM(gc_stats_pause_total) += pause;
+    if (pause > MP_STATE_MEM(gc_stats_pause_max)) {
+        MP_STATE_MEM(gc_stats_pause_max) = pause;
+    }
+}
+#endif
 
 void gc_collect_start(void) {
     GC_ENTER();
+    MP_CYCLES_BEGIN(GC_COLLECT);
+    #if MICROPY_GC_STATS
+    MP_STATE_MEM(gc_stats_pause_start) = mp_hal_ticks_us();
+    #endif
     MP_STATE_MEM(gc_lock_depth)++;
+    #if MICROPY_GC_PARTIAL_COLLECT
+    MP_STATE_MEM(gc_partial_start) = MP_STATE_THREAD(gc_partial_start);
+    MP_STATE_MEM(gc_partial_end) = MP_STATE_THREAD(gc_partial_end);
+    MP_STATE_MEM(gc_partial) = MP_STATE_MEM(gc_partial_start) != MP_STATE_MEM(gc_partial_end);
+    #endif
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // Stop all threads allocating from their own region, and wait for any
+    // allocation in progress to finish, before the heap is looked at.
+    __atomic_store_n(&MP_STATE_MEM(gc_collecting), 1, __ATOMIC_SEQ_CST);
+    for (mp_gc_thread_alloc_t *ta = MP_STATE_MEM(gc_thread_alloc_list); ta != NULL; ta = ta->next) {
+        while (__atomic_load_n(&ta->busy, __ATOMIC_SEQ_CST)) {
+        }
+    }
+    #endif
     #if MICROPY_GC_ALLOC_THRESHOLD
     MP_STATE_MEM(gc_alloc_amount) = 0;
+    MP_STATE_MEM(gc_threshold_reached) = false;
     #endif
+    // finish sweeping the previous collection so that only live heads are left
+    gc_sweep(SIZE_MAX);
     MP_STATE_MEM(gc_stack_overflow) = 0;
     MP_STATE_MEM(gc_sp) = MP_STATE_MEM(gc_stack);
     // Trace root pointers.  This relies on the root pointers being organised
@@ -323,9 +829,106 @@ void gc_collect_start(void) {
     // dict_globals, then the root pointer section of mp_state_vm.
     void **ptrs = (void**)(void*)&mp_state_ctx;
     gc_collect_root(ptrs, offsetof(mp_state_ctx_t, vm.qstr_last_chunk) / sizeof(void*));
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // the unused part of each thread's allocation region must be kept
+    for (mp_gc_thread_alloc_t *ta = MP_STATE_MEM(gc_thread_alloc_list); ta != NULL; ta = ta->next) {
+        gc_collect_root((void**)&ta->region, 1);
+    }
+    #endif
+    #if MICROPY_GC_PARTIAL_COLLECT
+    if (MP_STATE_MEM(gc_partial)) {
+        gc_partial_scan_remembered();
+    }
+    #endif
 }
 
+#if MICROPY_GC_PARALLEL_MARK
+
+void gc_collect_parallel_start(void) {
+    MP_STATE_MEM(gc_mark_parallel) = true;
+}
+
+void gc_collect_parallel_end(void) {
+    MP_STATE_MEM(gc_mark_parallel) = false;
+}
+
+// Mark the block with the given pointer and push it on the given mark stack,
+// if this thread is the one that marks it.  Heads only change to marked heads
+// during a collection, so an atomic update of the ATB decides which thread
+// traces the block.
+STATIC void gc_mark_push_parallel(void *ptr, size_t *stack, size_t *sp) {
+    if (!VERIFY_PTR(ptr)) {
+        return;
+    }
+    size_t block = BLOCK_FROM_PTR(ptr);
+    size_t shift = BLOCK_SHIFT(block);
+    byte *atb = &MP_STATE_MEM(gc_alloc_table_start)[block / BLOCKS_PER_ATB];
+    if (((*atb >> shift) & 3) != AT_HEAD || !GC_TRACE_BLOCK(block)) {
+        return;
+    }
+    byte old = __atomic_fetch_or(atb, (byte)(AT_TAIL << shift), __ATOMIC_RELAXED);
+    if (((old >> shift) & 3) != AT_HEAD) {
+        // another thread got there first
+        return;
+    }
+    DEBUG_printf("gc_mark(%p)\n", ptr);
+    if (*sp < MICROPY_ALLOC_GC_STACK_SIZE) {
+        stack[(*sp)++] = block;
+    } else {
+        // picked up by gc_deal_with_stack_overflow once marking is done
+        __atomic_store_n(&MP_STATE_MEM(gc_stack_overflow), 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Version of gc_collect_root used while several threads mark at once, each
+// with its own mark stack.
+STATIC void gc_collect_root_parallel(void **ptrs, size_t len) {
+    size_t stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    size_t sp = 0;
+    for (size_t i = 0; i < len; i++) {
+        gc_mark_push_parallel(ptrs[i], stack, &sp);
+        while (sp > 0) {
+            size_t block = stack[--sp];
+            size_t n_blocks = 0;
+            do {
+                n_blocks += 1;
+            } while (ATB_GET_KIND(block + n_blocks) == AT_TAIL);
+            void **child = (void**)PTR_FROM_BLOCK(block);
+            for (size_t j = n_blocks * BYTES_PER_BLOCK / sizeof(void*); j > 0; j--, child++) {
+                gc_mark_push_parallel(*child, stack, &sp);
+            }
+        }
+    }
+}
+
+#endif // MICROPY_GC_PARALLEL_MARK
+
+#if MICROPY_GC_COMPACT
+// Pin every block that one of the given root pointers points into.  Roots
+// include the C stacks and registers, and the root pointers C code must keep
+// its references to the heap in, so this is what pins buffers held by C.
+STATIC void gc_compact_pin(void **ptrs, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        byte *ptr = ptrs[i];
+        if (ptr >= MP_STATE_MEM(gc_pool_start) && ptr < MP_STATE_MEM(gc_pool_end)) {
+            CTB_SET(BLOCK_FROM_PTR(ptr), CTB_PINNED);
+        }
+    }
+}
+#endif
+
 void gc_collect_root(void **ptrs, size_t len) {
+    #if MICROPY_GC_COMPACT
+    if (MP_STATE_MEM(gc_compact_table) != NULL) {
+        gc_compact_pin(ptrs, len);
+    }
+    #endif
+    #if MICROPY_GC_PARALLEL_MARK
+    if (MP_STATE_MEM(gc_mark_parallel)) {
+        gc_collect_root_parallel(ptrs, len);
+        return;
+    }
+    #endif
     for (size_t i = 0; i < len; i++) {
         void *ptr = ptrs[i];
         VERIFY_MARK_AND_PUSH(ptr);
@@ -335,76 +938,475 @@ void gc_collect_root(void **ptrs, size_t len) {
 
 void gc_collect_end(void) {
     gc_deal_with_stack_overflow();
-    gc_sweep();
-    MP_STATE_MEM(gc_last_free_atb_index) = 0;
+    #if MICROPY_PY_GC_COLLECT_RETVAL
+    MP_STATE_MEM(gc_collected) = 0;
+    #endif
+    #if MICROPY_GC_PARTIAL_COLLECT
+    if (MP_STATE_MEM(gc_partial)) {
+        // only the range was marked, and it is small enough to sweep now
+        MP_STATE_MEM(gc_sweep_block) = MP_STATE_MEM(gc_partial_start);
+        gc_sweep(MP_STATE_MEM(gc_partial_end) - MP_STATE_MEM(gc_partial_start));
+        MP_STATE_MEM(gc_sweep_block) = GC_SWEEP_DONE;
+        MP_STATE_MEM(gc_partial) = false;
+        #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+        __atomic_store_n(&MP_STATE_MEM(gc_collecting), 0, __ATOMIC_SEQ_CST);
+        #endif
+        #if MICROPY_GC_STATS
+        gc_stats_collect_end();
+        #endif
+        MP_CYCLES_END(GC_COLLECT);
+        MP_STATE_MEM(gc_lock_depth)--;
+        GC_EXIT();
+        return;
+    }
+    #endif
+    #if MICROPY_GC_NURSERY_BLOCKS
+    // a major collection may free up the nursery again
+    MP_STATE_MEM(gc_nursery_full) = MP_STATE_MEM(gc_nursery_start) == MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    MP_STATE_MEM(gc_nursery_next) = MP_STATE_MEM(gc_nursery_start);
+    #endif
+    MP_STATE_MEM(gc_sweep_block) = 0;
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    // with a non-zero quantum, sweeping is done in steps after the collection
+    if (MP_STATE_MEM(gc_sweep_quantum) == 0) {
+        gc_sweep(SIZE_MAX);
+    }
+    #else
+    gc_sweep(SIZE_MAX);
+    #endif
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // threads can use their region again once the sweep is done
+    __atomic_store_n(&MP_STATE_MEM(gc_collecting), 0, __ATOMIC_SEQ_CST);
+    #endif
+    #if MICROPY_GC_STATS
+    gc_stats_collect_end();
+    #endif
+    MP_CYCLES_END(GC_COLLECT);
+    MP_STATE_MEM(gc_lock_depth)--;
+    GC_EXIT();
+}
+
+void gc_info(gc_info_t *info) {
+    GC_ENTER();
+    // blocks not yet swept would count as used
+    if (MP_STATE_MEM(gc_lock_depth) == 0) {
+        MP_STATE_MEM(gc_lock_depth)++;
+        gc_sweep(SIZE_MAX);
+        MP_STATE_MEM(gc_lock_depth)--;
+    }
+    info->total = MP_STATE_MEM(gc_pool_end) - MP_STATE_MEM(gc_pool_start);
+    info->used = 0;
+    info->free = 0;
+    info->max_free = 0;
+    info->num_1block = 0;
+    info->num_2block = 0;
+    info->max_block = 0;
+    bool finish = false;
+    for (size_t block = 0, len = 0, len_free = 0; !finish;) {
+        size_t kind = ATB_GET_KIND(block);
+        switch (kind) {
+            case AT_FREE:
+                info->free += 1;
+                len_free += 1;
+                len = 0;
+                break;
+
+            case AT_HEAD:
+                info->used += 1;
+                len = 1;
+                break;
+
+            case AT_TAIL:
+                info->used += 1;
+                len += 1;
+                break;
+
+            case AT_MARK:
+                // shouldn't happen
+                break;
+        }
+
+        block++;
+        finish = (block == MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB);
+        // Get next block type if possible
+        if (!finish) {
+            kind = ATB_GET_KIND(block);
+        }
+
+        if (finish || kind == AT_FREE || kind == AT_HEAD) {
+            if (len == 1) {
+                info->num_1block += 1;
+            } else if (len == 2) {
+                info->num_2block += 1;
+            }
+            if (len > info->max_block) {
+                info->max_block = len;
+            }
+            if (finish || kind == AT_HEAD) {
+                if (len_free > info->max_free) {
+                    info->max_free = len_free;
+                }
+                len_free = 0;
+            }
+        }
+    }
+
+    info->used *= BYTES_PER_BLOCK;
+    info->free *= BYTES_PER_BLOCK;
+    GC_EXIT();
+}
+
+#if MICROPY_GC_STATS
+void gc_stats(gc_stats_t *stats) {
+    GC_ENTER();
+    stats->collections = MP_STATE_MEM(gc_stats_collections);
+    stats->alloc_collections = MP_STATE_MEM(gc_stats_alloc_collections);
+    stats->pause_total = MP_STATE_MEM(gc_stats_pause_total);
+    stats->pause_max = MP_STATE_MEM(gc_stats_pause_max);
+    stats->alloc_bytes = MP_STATE_MEM(gc_stats_alloc_bytes);
+    stats->alloc_count = MP_STATE_MEM(gc_stats_alloc_count);
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // allocations from the regions of running threads are added in when
+    // the thread finishes, so pick them up here too; another thread's
+    // counts may be a moment out of date
+    for (mp_gc_thread_alloc_t *ta = MP_STATE_MEM(gc_thread_alloc_list); ta != NULL; ta = ta->next) {
+        stats->alloc_bytes += ta->alloc_bytes;
+        stats->alloc_count += ta->alloc_count;
+    }
+    #endif
+    GC_EXIT();
+}
+#endif
+
+#if MICROPY_GC_COMPACT
+
+STATIC size_t gc_compact_chain_len(size_t block) {
+    size_t n_blocks = 0;
+    do {
+        n_blocks += 1;
+    } while (ATB_GET_KIND(block + n_blocks) == AT_TAIL);
+    return n_blocks;
+}
+
+// Return the bytearray or array object at the head of the given chain if its
+// buffer is a chain of its own that compaction may move, or NULL.  The chain
+// may just be data that looks like such an object, so the buffer must also
+// be of exactly the size the object needs.
+STATIC mp_obj_array_t *gc_compact_owner(size_t block) {
+    mp_obj_array_t *o = (mp_obj_array_t*)PTR_FROM_BLOCK(block);
+    if (!(false
+        #if MICROPY_PY_BUILTINS_BYTEARRAY
+        || o->base.type == &mp_type_bytearray
+        #endif
+        #if MICROPY_PY_ARRAY
+        || o->base.type == &mp_type_array
+        #endif
+        )) {
+        return NULL;
+    }
+    if (!VERIFY_PTR(o->items)) {
+        return NULL;
+    }
+    size_t items_block = BLOCK_FROM_PTR(o->items);
+    if (!ATB_IS_HEAD(items_block)) {
+        return NULL;
+    }
+    #if MICROPY_ENABLE_FINALISER
+    if (FTB_GET(items_block)) {
+        return NULL;
+    }
+    #endif
+    size_t n_bytes = mp_binary_get_size('@', o->typecode, NULL) * (o->len + o->free);
+    if (n_bytes == 0 || (n_bytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK != gc_compact_chain_len(items_block)) {
+        return NULL;
+    }
+    return o;
+}
+
+// Find the first run of n_blocks free blocks that starts before the given
+// block, returning that block if there is none.
+STATIC size_t gc_compact_find_free(size_t n_blocks, size_t limit) {
+    size_t size_class = MIN(n_blocks, MICROPY_GC_FREE_INDEX_CLASSES) - 1;
+    size_t n_free = 0;
+    for (size_t block = MP_STATE_MEM(gc_first_free_atb_index)[size_class] * BLOCKS_PER_ATB; block < limit; block++) {
+        if (ATB_GET_KIND(block) != AT_FREE) {
+            n_free = 0;
+        } else if (++n_free == n_blocks) {
+            return block + 1 - n_blocks;
+        }
+    }
+    return limit;
+}
+
+// The collector can't tell a pointer from an integer that looks like one, so
+// in general nothing can be moved.  The exception are the buffers of bytearray
+// and array objects: the only word that may refer to such a buffer is the
+// items field of its owner, which can be updated when the buffer moves.  So
+// after a collection that pins everything reachable straight from the roots,
+// all other words in the heap are scanned to pin what they point into, and
+// then each buffer that is still unpinned is moved to the first free run of
+// blocks below it.  C code that keeps a pointer to a buffer must keep it in a
+// root pointer (as it must anyway so the buffer isn't freed), which pins it.
+size_t gc_compact(void) {
+    if (MP_STATE_MEM(gc_lock_depth) > 0) {
+        return 0;
+    }
+
+    // the table is allocated before collecting so the collection can fill it
+    size_t table_len = MP_STATE_MEM(gc_alloc_table_byte_len);
+    byte *table = gc_alloc(table_len, false);
+    if (table == NULL) {
+        return 0;
+    }
+    memset(table, 0, table_len);
+    MP_STATE_MEM(gc_compact_table) = table;
+
+    // the heap must be swept completely before anything is moved
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    size_t quantum = MP_STATE_MEM(gc_sweep_quantum);
+    MP_STATE_MEM(gc_sweep_quantum) = 0;
+    gc_collect();
+    MP_STATE_MEM(gc_sweep_quantum) = quantum;
+    #else
+    gc_collect();
+    #endif
+
+    GC_ENTER();
+    MP_STATE_MEM(gc_lock_depth)++;
+
+    // Pin all blocks pointed into from the heap, except for a buffer that is
+    // referred to from the items field of exactly one array.
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t table_block = BLOCK_FROM_PTR(table);
+    for (size_t block = 0; block < total_blocks; block++) {
+        if (!ATB_IS_HEAD(block) || block == table_block) {
+            continue;
+        }
+        mp_obj_array_t *owner = gc_compact_owner(block);
+        size_t n_blocks = gc_compact_chain_len(block);
+        void **ptrs = (void**)PTR_FROM_BLOCK(block);
+        for (size_t i = 0; i < n_blocks * WORDS_PER_BLOCK; i++) {
+            byte *ptr = ptrs[i];
+            if (ptr < MP_STATE_MEM(gc_pool_start) || ptr >= MP_STATE_MEM(gc_pool_end)) {
+                continue;
+            }
+            size_t ptr_block = BLOCK_FROM_PTR(ptr);
+            if (owner != NULL && &ptrs[i] == &owner->items && !(CTB_GET(ptr_block) & CTB_OWNED)) {
+                CTB_SET(ptr_block, CTB_OWNED);
+            } else {
+                CTB_SET(ptr_block, CTB_PINNED);
+            }
+        }
+        block += n_blocks - 1;
+    }
+
+    // move each unpinned buffer as far down as it goes
+    size_t n_moved = 0;
+    for (size_t block = 0; block < total_blocks; block++) {
+        if (!ATB_IS_HEAD(block) || block == table_block) {
+            continue;
+        }
+        mp_obj_array_t *owner = gc_compact_owner(block);
+        if (owner == NULL) {
+            continue;
+        }
+        size_t src = BLOCK_FROM_PTR(owner->items);
+        size_t n_blocks = gc_compact_chain_len(src);
+        bool pinned = false;
+        for (size_t i = 0; i < n_blocks; i++) {
+            if (CTB_GET(src + i) & CTB_PINNED) {
+                pinned = true;
+                break;
+            }
+        }
+        #if MICROPY_GC_ARENA
+        // freeing the buffer would not make its blocks available
+        pinned |= gc_arena_holds(src);
+        #endif
+        if (pinned) {
+            continue;
+        }
+        size_t dest = gc_compact_find_free(n_blocks, src);
+        if (dest == src) {
+            continue;
+        }
+        DEBUG_printf("gc_compact(%p -> %p)\n", owner->items, (void*)PTR_FROM_BLOCK(dest));
+
+        ATB_FREE_TO_HEAD(dest);
+        for (size_t i = 1; i < n_blocks; i++) {
+            ATB_FREE_TO_TAIL(dest + i);
+        }
+        memcpy((void*)PTR_FROM_BLOCK(dest), owner->items, n_blocks * BYTES_PER_BLOCK);
+        owner->items = (void*)PTR_FROM_BLOCK(dest);
+        for (size_t i = 0; i < n_blocks; i++) {
+            ATB_ANY_TO_FREE(src + i);
+        }
+        gc_free_index_update(src);
+        #if MICROPY_GC_ALLOC_PROFILE
+        for (size_t i = 0; i < MIN(MP_STATE_MEM(gc_profile_len), MICROPY_GC_ALLOC_PROFILE_ENTRIES); i++) {
+            if (MP_STATE_MEM(gc_profile_entries)[i].block == src) {
+                MP_STATE_MEM(gc_profile_entries)[i].block = dest;
+            }
+        }
+        #endif
+        #ifdef LOG_HEAP_ACTIVITY
+        gc_log_change(dest, n_blocks);
+        gc_log_change(src, 0);
+        #endif
+        n_moved++;
+    }
+
+    MP_STATE_MEM(gc_compact_table) = NULL;
     MP_STATE_MEM(gc_lock_depth)--;
     GC_EXIT();
+    gc_free(table);
+
+    #if EXTENSIVE_HEAP_PROFILING
+    gc_dump_alloc_table();
+    #endif
+
+    return n_moved;
+}
+
+#endif // MICROPY_GC_COMPACT
+
+#if MICROPY_GC_THREAD_ALLOC_BLOCKS
+
+void gc_thread_alloc_start(void) {
+    mp_gc_thread_alloc_t *ta = &MP_STATE_THREAD(gc_thread_alloc);
+    ta->region = NULL;
+    ta->n_blocks = 0;
+    ta->busy = 0;
+    #if MICROPY_GC_ALLOC_PROFILE || MICROPY_GC_STATS
+    ta->refilling = false;
+    #endif
+    #if MICROPY_GC_STATS
+    ta->alloc_bytes = 0;
+    ta->alloc_count = 0;
+    #endif
+    GC_ENTER();
+    ta->next = MP_STATE_MEM(gc_thread_alloc_list);
+    MP_STATE_MEM(gc_thread_alloc_list) = ta;
+    GC_EXIT();
 }
 
-void gc_info(gc_info_t *info) {
+void gc_thread_alloc_finish(void) {
+    mp_gc_thread_alloc_t *ta = &MP_STATE_THREAD(gc_thread_alloc);
+    // give back the unused part of the region while it is still a root
+    gc_free(ta->region);
     GC_ENTER();
-    info->total = MP_STATE_MEM(gc_pool_end) - MP_STATE_MEM(gc_pool_start);
-    info->used = 0;
-    info->free = 0;
-    info->max_free = 0;
-    info->num_1block = 0;
-    info->num_2block = 0;
-    info->max_block = 0;
-    bool finish = false;
-    for (size_t block = 0, len = 0, len_free = 0; !finish;) {
-        size_t kind = ATB_GET_KIND(block);
-        switch (kind) {
-            case AT_FREE:
-                info->free += 1;
-                len_free += 1;
-                len = 0;
-                break;
+    #if MICROPY_GC_STATS
+    MP_STATE_MEM(gc_stats_alloc_bytes) += ta->alloc_bytes;
+    MP_STATE_MEM(gc_stats_alloc_count) += ta->alloc_count;
+    #endif
+    for (mp_gc_thread_alloc_t **p = &MP_STATE_MEM(gc_thread_alloc_list); *p != NULL; p = &(*p)->next) {
+        if (*p == ta) {
+            *p = ta->next;
+            break;
+        }
+    }
+    GC_EXIT();
+}
 
-            case AT_HEAD:
-                info->used += 1;
-                len = 1;
-                break;
+// Allocate n_blocks from the allocation region of the calling thread, without
+// taking the GC mutex.  The unused part of the region is a single chain of
+// blocks whose head is the next block to hand out, so carving an object off
+// the front only needs the block after it turned into the new head.  Returns
+// NULL if the object must be allocated from the shared heap instead.
+STATIC void *gc_thread_alloc(size_t n_bytes, size_t n_blocks) {
+    mp_gc_thread_alloc_t *ta = &MP_STATE_THREAD(gc_thread_alloc);
+
+    if (ta->n_blocks < n_blocks) {
+        // Reserve a new region under the GC mutex; this is the only point
+        // where the thread contends with others.  The rest of the old region
+        // is given back first, while it is still a root.
+        gc_free(ta->region);
+        ta->region = NULL;
+        ta->n_blocks = 0;
+        #if MICROPY_GC_ARENA
+        // the region must outlive any arena in use
+        gc_arena_t *arena = MP_STATE_THREAD(gc_arena);
+        MP_STATE_THREAD(gc_arena) = NULL;
+        #endif
+        #if MICROPY_GC_ALLOC_PROFILE || MICROPY_GC_STATS
+        // the objects in the region are profiled and counted, not the region
+        // itself
+        ta->refilling = true;
+        byte *region = gc_alloc(MICROPY_GC_THREAD_ALLOC_BLOCKS * BYTES_PER_BLOCK, false);
+        ta->refilling = false;
+        #else
+        byte *region = gc_alloc(MICROPY_GC_THREAD_ALLOC_BLOCKS * BYTES_PER_BLOCK, false);
+        #endif
+        #if MICROPY_GC_ARENA
+        MP_STATE_THREAD(gc_arena) = arena;
+        #endif
+        if (region == NULL) {
+            return NULL;
+        }
+        #if !MICROPY_GC_CONSERVATIVE_CLEAR
+        // objects are handed out without being cleared
+        memset(region, 0, MICROPY_GC_THREAD_ALLOC_BLOCKS * BYTES_PER_BLOCK);
+        #endif
+        ta->region = region;
+        ta->n_blocks = MICROPY_GC_THREAD_ALLOC_BLOCKS;
+    }
 
-            case AT_TAIL:
-                info->used += 1;
-                len += 1;
-                break;
+    __atomic_store_n(&ta->busy, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&MP_STATE_MEM(gc_collecting), __ATOMIC_SEQ_CST)
+        || __atomic_load_n(&MP_STATE_MEM(gc_sweep_block), __ATOMIC_SEQ_CST) != GC_SWEEP_DONE
+        || MP_STATE_MEM(gc_lock_depth) > 0) {
+        // the collector owns the heap for now
+        __atomic_store_n(&ta->busy, 0, __ATOMIC_SEQ_CST);
+        return NULL;
+    }
+    void *ret_ptr = ta->region;
+    ta->n_blocks -= n_blocks;
+    if (ta->n_blocks == 0) {
+        ta->region = NULL;
+    } else {
+        ta->region += n_blocks * BYTES_PER_BLOCK;
+        ATB_TAIL_TO_HEAD(BLOCK_FROM_PTR(ta->region));
+    }
+    __atomic_store_n(&ta->busy, 0, __ATOMIC_SEQ_CST);
+    #if MICROPY_GC_STATS
+    ta->alloc_bytes += n_bytes;
+    ta->alloc_count += 1;
+    #endif
 
-            case AT_MARK:
-                // shouldn't happen
-                break;
-        }
+    DEBUG_printf("gc_thread_alloc(%p)\n", ret_ptr);
+    return ret_ptr;
+}
 
-        block++;
-        finish = (block == MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB);
-        // Get next block type if possible
-        if (!finish) {
-            kind = ATB_GET_KIND(block);
-        }
+#endif // MICROPY_GC_THREAD_ALLOC_BLOCKS
 
-        if (finish || kind == AT_FREE || kind == AT_HEAD) {
-            if (len == 1) {
-                info->num_1block += 1;
-            } else if (len == 2) {
-                info->num_2block += 1;
-            }
-            if (len > info->max_block) {
-                info->max_block = len;
-            }
-            if (finish || kind == AT_HEAD) {
-                if (len_free > info->max_free) {
-                    info->max_free = len_free;
-                }
-                len_free = 0;
-            }
+#if MICROPY_GC_NURSERY_BLOCKS
+
+// objects of up to this many blocks are allocated from the nursery
+#define GC_NURSERY_MAX_BLOCKS (4)
+
+// Find a run of n_blocks free blocks in the nursery, going on from where the
+// last one was found, and return its first block or 0 if there is none.
+STATIC size_t gc_nursery_find(size_t n_blocks) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t block = MP_STATE_MEM(gc_nursery_next);
+    size_t n_free = 0;
+    for (size_t n = total_blocks - MP_STATE_MEM(gc_nursery_start); n > 0; n--, block++) {
+        if (block == total_blocks) {
+            block = MP_STATE_MEM(gc_nursery_start);
+            n_free = 0;
+        }
+        if (ATB_GET_KIND(block) != AT_FREE) {
+            n_free = 0;
+        } else if (++n_free == n_blocks) {
+            MP_STATE_MEM(gc_nursery_next) = block + 1;
+            return block + 1 - n_blocks;
         }
     }
-
-    info->used *= BYTES_PER_BLOCK;
-    info->free *= BYTES_PER_BLOCK;
-    GC_EXIT();
+    return 0;
 }
 
+#endif // MICROPY_GC_NURSERY_BLOCKS
+
 void *gc_alloc(size_t n_bytes, bool has_finaliser) {
     size_t n_blocks = ((n_bytes + BYTES_PER_BLOCK - 1) & (~(BYTES_PER_BLOCK - 1))) / BYTES_PER_BLOCK;
     DEBUG_printf("gc_alloc(" UINT_FMT " bytes -> " UINT_FMT " blocks)\n", n_bytes, n_blocks);
@@ -414,6 +1416,36 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser) {
         return NULL;
     }
 
+    #if MICROPY_GC_ARENA
+    if (!has_finaliser && MP_STATE_THREAD(gc_arena) != NULL) {
+        void *ret_ptr = gc_arena_alloc(MP_STATE_THREAD(gc_arena), n_bytes, n_blocks);
+        if (ret_ptr != NULL) {
+            #if MICROPY_GC_ALLOC_PROFILE
+            if (MP_STATE_MEM(gc_profile_rate) != 0) {
+                gc_profile_alloc(BLOCK_FROM_PTR(ret_ptr), n_blocks);
+            }
+            #endif
+            return ret_ptr;
+        }
+    }
+    #endif
+
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // small objects come from the thread's own region, which is never larger
+    // than this so that refilling the region goes to the shared heap
+    if (!has_finaliser && n_blocks <= MICROPY_GC_THREAD_ALLOC_BLOCKS / 8) {
+        void *ret_ptr = gc_thread_alloc(n_bytes, n_blocks);
+        if (ret_ptr != NULL) {
+            #if MICROPY_GC_ALLOC_PROFILE
+            if (MP_STATE_MEM(gc_profile_rate) != 0) {
+                gc_profile_alloc(BLOCK_FROM_PTR(ret_ptr), n_blocks);
+            }
+            #endif
+            return ret_ptr;
+        }
+    }
+    #endif
+
     GC_ENTER();
 
     // check if GC is locked
@@ -425,21 +1457,49 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser) {
     size_t i;
     size_t end_block;
     size_t start_block;
-    size_t n_free = 0;
+    size_t n_free;
+    size_t size_class = MIN(n_blocks, MICROPY_GC_FREE_INDEX_CLASSES) - 1;
+    size_t scan_start;
+    size_t scan_end;
     int collected = !MP_STATE_MEM(gc_auto_collect_enabled);
 
     #if MICROPY_GC_ALLOC_THRESHOLD
-    if (!collected && MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
+    // The collection for reaching the threshold is normally run from the VM
+    // loop; only if that doesn't happen in time, for example because C code
+    // allocates a lot in one go, is it run here.
+    if (!collected && MP_STATE_MEM(gc_alloc_amount) / 2 >= MP_STATE_MEM(gc_alloc_threshold)) {
         GC_EXIT();
         gc_collect();
         GC_ENTER();
     }
     #endif
 
+    #if MICROPY_GC_NURSERY_BLOCKS
+    if (!has_finaliser && n_blocks <= GC_NURSERY_MAX_BLOCKS && !MP_STATE_MEM(gc_nursery_full)) {
+        start_block = gc_nursery_find(n_blocks);
+        if (start_block == 0 && !collected) {
+            GC_EXIT();
+            gc_collect_minor();
+            GC_ENTER();
+            #if MICROPY_GC_STATS
+            MP_STATE_MEM(gc_stats_alloc_collections)++;
+            #endif
+            start_block = gc_nursery_find(n_blocks);
+        }
+        if (start_block != 0) {
+            end_block = start_block + n_blocks - 1;
+            goto found_nursery;
+        }
+    }
+    #endif
+
+    scan_start = MP_STATE_MEM(gc_first_free_atb_index)[size_class];
+    scan_end = MP_STATE_MEM(gc_alloc_table_byte_len);
     for (;;) {
 
         // look for a run of n_blocks available blocks
-        for (i = MP_STATE_MEM(gc_last_free_atb_index); i < MP_STATE_MEM(gc_alloc_table_byte_len); i++) {
+        n_free = 0;
+        for (i = scan_start; i < scan_end; i++) {
             byte a = MP_STATE_MEM(gc_alloc_table_start)[i];
             if (ATB_0_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 0; goto found; } } else { n_free = 0; }
             if (ATB_1_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 1; goto found; } } else { n_free = 0; }
@@ -447,8 +1507,29 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser) {
             if (ATB_3_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 3; goto found; } } else { n_free = 0; }
         }
 
-        GC_EXIT();
         // nothing found!
+        if (MP_STATE_MEM(gc_sweep_block) != GC_SWEEP_DONE) {
+            // Garbage from the last collection is not swept yet, so sweep the
+            // next part of the heap and try again.  Any new run of n_blocks
+            // must contain a block freed by this step, so only the blocks
+            // around the part just swept need scanning again.
+            MP_STATE_MEM(gc_lock_depth)++;
+            size_t sweep_start = MP_STATE_MEM(gc_sweep_block);
+            #if MICROPY_GC_INCREMENTAL_SWEEP
+            gc_sweep(MAX(MP_STATE_MEM(gc_sweep_quantum), n_blocks));
+            #else
+            gc_sweep(SIZE_MAX);
+            #endif
+            size_t sweep_end = MP_STATE_MEM(gc_sweep_block);
+            if (sweep_end == GC_SWEEP_DONE) {
+                sweep_end = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+            }
+            MP_STATE_MEM(gc_lock_depth)--;
+            scan_start = (sweep_start > n_blocks ? sweep_start - n_blocks : 0) / BLOCKS_PER_ATB;
+            scan_end = MIN((sweep_end + n_blocks) / BLOCKS_PER_ATB + 1, MP_STATE_MEM(gc_alloc_table_byte_len));
+            continue;
+        }
+        GC_EXIT();
         if (collected) {
             return NULL;
         }
@@ -456,6 +1537,11 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser) {
         gc_collect();
         collected = 1;
         GC_ENTER();
+        #if MICROPY_GC_STATS
+        MP_STATE_MEM(gc_stats_alloc_collections)++;
+        #endif
+        scan_start = MP_STATE_MEM(gc_first_free_atb_index)[size_class];
+        scan_end = MP_STATE_MEM(gc_alloc_table_byte_len);
     }
 
     // found, ending at block i inclusive
@@ -464,21 +1550,35 @@ found:
     end_block = i;
     start_block = i - n_free + 1;
 
-    // Set last free ATB index to block after last block we found, for start of
-    // next scan.  To reduce fragmentation, we only do this if we were looking
-    // for a single free block, which guarantees that there are no free blocks
-    // before this one.  Also, whenever we free or shink a block we must check
-    // if this index needs adjusting (see gc_realloc and gc_free).
-    if (n_free == 1) {
-        MP_STATE_MEM(gc_last_free_atb_index) = (i + 1) / BLOCKS_PER_ATB;
+    // Advance the free index to the block after the last block we found, for
+    // start of next scan.  The scan found the first fit for n_blocks, so no run
+    // of n_blocks or more free blocks exists before this one.  This only holds
+    // if we were using the index of this exact size class, which is not the
+    // case for allocations larger than the number of classes.  Whenever we free
+    // or shrink a block we must check if the index needs adjusting (see
+    // gc_free_index_update).
+    if (n_blocks <= MICROPY_GC_FREE_INDEX_CLASSES) {
+        size_t next_atb = (i + 1) / BLOCKS_PER_ATB;
+        for (size_t c = n_blocks - 1; c < MICROPY_GC_FREE_INDEX_CLASSES; c++) {
+            if (MP_STATE_MEM(gc_first_free_atb_index)[c] < next_atb) {
+                MP_STATE_MEM(gc_first_free_atb_index)[c] = next_atb;
+            }
+        }
     }
 
+    #if MICROPY_GC_NURSERY_BLOCKS
+found_nursery:
+    #endif
     #ifdef LOG_HEAP_ACTIVITY
     gc_log_change(start_block, end_block - start_block + 1);
     #endif
 
-    // mark first block as used head
+    // mark first block as used head; if it is not swept yet it is marked so
+    // that the pending sweep keeps it
     ATB_FREE_TO_HEAD(start_block);
+    if (start_block >= MP_STATE_MEM(gc_sweep_block)) {
+        ATB_HEAD_TO_MARK(start_block);
+    }
 
     // mark rest of blocks as used tail
     // TODO for a run of many blocks can make this more efficient
@@ -493,6 +1593,19 @@ found:
 
     #if MICROPY_GC_ALLOC_THRESHOLD
     MP_STATE_MEM(gc_alloc_amount) += n_blocks;
+    if (MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
+        MP_STATE_MEM(gc_threshold_reached) = true;
+    }
+    #endif
+
+    #if MICROPY_GC_STATS
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    if (!MP_STATE_THREAD(gc_thread_alloc).refilling)
+    #endif
+    {
+        MP_STATE_MEM(gc_stats_alloc_bytes) += n_bytes;
+        MP_STATE_MEM(gc_stats_alloc_count) += 1;
+    }
     #endif
 
     GC_EXIT();
@@ -522,6 +1635,16 @@ found:
     (void)has_finaliser;
     #endif
 
+    #if MICROPY_GC_ALLOC_PROFILE
+    if (MP_STATE_MEM(gc_profile_rate) != 0
+        #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+        && !MP_STATE_THREAD(gc_thread_alloc).refilling
+        #endif
+        ) {
+        gc_profile_alloc(start_block, n_blocks);
+    }
+    #endif
+
     #if EXTENSIVE_HEAP_PROFILING
     gc_dump_alloc_table();
     #endif
@@ -529,6 +1652,99 @@ found:
     return ret_ptr;
 }
 
+#if MICROPY_GC_LONG_LIVED
+// Long-lived objects are taken from the highest free run of blocks that fits,
+// searching down from gc_long_lived_top.  There is no index for the top-down
+// search, but the part of the heap it passes over only holds long-lived
+// objects, which are few.  If no run is found, which also means garbage is not
+// swept yet or must be collected first, the object is allocated as usual.
+void *gc_alloc_long_lived(size_t n_bytes) {
+    size_t n_blocks = ((n_bytes + BYTES_PER_BLOCK - 1) & (~(BYTES_PER_BLOCK - 1))) / BYTES_PER_BLOCK;
+    DEBUG_printf("gc_alloc_long_lived(" UINT_FMT " bytes -> " UINT_FMT " blocks)\n", n_bytes, n_blocks);
+
+    if (n_blocks == 0) {
+        return NULL;
+    }
+
+    GC_ENTER();
+
+    if (MP_STATE_MEM(gc_lock_depth) > 0) {
+        GC_EXIT();
+        return NULL;
+    }
+
+    size_t start_block = MP_STATE_MEM(gc_long_lived_top);
+    size_t n_free = 0;
+    while (start_block > 0 && n_free < n_blocks) {
+        start_block--;
+        if (ATB_GET_KIND(start_block) == AT_FREE) {
+            n_free++;
+        } else {
+            n_free = 0;
+        }
+    }
+
+    if (n_free < n_blocks) {
+        GC_EXIT();
+        #if MICROPY_GC_ARENA
+        // the object must outlive any arena in use
+        gc_arena_t *arena = MP_STATE_THREAD(gc_arena);
+        MP_STATE_THREAD(gc_arena) = NULL;
+        #endif
+        void *ret_ptr = gc_alloc(n_bytes, false);
+        #if MICROPY_GC_ARENA
+        MP_STATE_THREAD(gc_arena) = arena;
+        #endif
+        if (ret_ptr != NULL) {
+            memset(ret_ptr, 0, n_bytes);
+        }
+        return ret_ptr;
+    }
+
+    MP_STATE_MEM(gc_long_lived_top) = start_block;
+
+    #ifdef LOG_HEAP_ACTIVITY
+    gc_log_change(start_block, n_blocks);
+    #endif
+
+    // claim the blocks as gc_alloc does, including the mark for a pending sweep
+    ATB_FREE_TO_HEAD(start_block);
+    if (start_block >= MP_STATE_MEM(gc_sweep_block)) {
+        ATB_HEAD_TO_MARK(start_block);
+    }
+    for (size_t bl = start_block + 1; bl < start_block + n_blocks; bl++) {
+        ATB_FREE_TO_TAIL(bl);
+    }
+
+    void *ret_ptr = (void*)(MP_STATE_MEM(gc_pool_start) + start_block * BYTES_PER_BLOCK);
+    DEBUG_printf("gc_alloc_long_lived(%p)\n", ret_ptr);
+
+    #if MICROPY_GC_ALLOC_THRESHOLD
+    MP_STATE_MEM(gc_alloc_amount) += n_blocks;
+    if (MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
+        MP_STATE_MEM(gc_threshold_reached) = true;
+    }
+    #endif
+
+    #if MICROPY_GC_STATS
+    MP_STATE_MEM(gc_stats_alloc_bytes) += n_bytes;
+    MP_STATE_MEM(gc_stats_alloc_count) += 1;
+    #endif
+
+    GC_EXIT();
+
+    memset(ret_ptr, 0, n_blocks * BYTES_PER_BLOCK);
+
+    #if MICROPY_GC_ALLOC_PROFILE
+    if (MP_STATE_MEM(gc_profile_rate) != 0) {
+        gc_profile_alloc(start_block, n_blocks);
+    }
+    #endif
+
+    return ret_ptr;
+}
+#endif // MICROPY_GC_LONG_LIVED
+
 /*
 void *gc_alloc(mp_uint_t n_bytes) {
     return _gc_alloc(n_bytes, false);
@@ -553,14 +1769,22 @@ void gc_free(void *ptr) {
 
     if (VERIFY_PTR(ptr)) {
         size_t block = BLOCK_FROM_PTR(ptr);
-        if (ATB_GET_KIND(block) == AT_HEAD) {
+        #if MICROPY_GC_ARENA
+        if (gc_arena_holds(block)) {
+            // the arena frees it on exit
+            GC_EXIT();
+            return;
+        }
+        #endif
+        if (ATB_IS_HEAD(block)) {
             #if MICROPY_ENABLE_FINALISER
             FTB_CLEAR(block);
             #endif
-            // set the last_free pointer to this block if it's earlier in the heap
-            if (block / BLOCKS_PER_ATB < MP_STATE_MEM(gc_last_free_atb_index)) {
-                MP_STATE_MEM(gc_last_free_atb_index) = block / BLOCKS_PER_ATB;
-            }
+            // move the free index back to this block if it's earlier in the heap
+            gc_free_index_update(block);
+            #if MICROPY_GC_ALLOC_PROFILE
+            gc_profile_free(block);
+            #endif
 
             // free head and all of its tail blocks
             #ifdef LOG_HEAP_ACTIVITY
@@ -592,7 +1816,7 @@ size_t gc_nbytes(const void *ptr) {
     GC_ENTER();
     if (VERIFY_PTR(ptr)) {
         size_t block = BLOCK_FROM_PTR(ptr);
-        if (ATB_GET_KIND(block) == AT_HEAD) {
+        if (ATB_IS_HEAD(block)) {
             // work out number of consecutive blocks in the chain starting with this on
             size_t n_blocks = 0;
             do {
@@ -608,6 +1832,24 @@ size_t gc_nbytes(const void *ptr) {
     return 0;
 }
 
+// Returns the start of the chain of blocks in use that ptr points into, which
+// may be anywhere in the chain, or NULL if there isn't one.
+void *gc_find_head(const void *ptr) {
+    GC_ENTER();
+    if (ptr >= (void*)MP_STATE_MEM(gc_pool_start) && ptr < (void*)MP_STATE_MEM(gc_pool_end)) {
+        size_t block = BLOCK_FROM_PTR(ptr);
+        if (ATB_GET_KIND(block) != AT_FREE) {
+            while (ATB_GET_KIND(block) == AT_TAIL) {
+                block -= 1;
+            }
+            GC_EXIT();
+            return (void*)PTR_FROM_BLOCK(block);
+        }
+    }
+    GC_EXIT();
+    return NULL;
+}
+
 #if 0
 // old, simple realloc that didn't expand memory in place
 void *gc_realloc(void *ptr, mp_uint_t n_bytes) {
@@ -662,7 +1904,7 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     GC_ENTER();
 
     // sanity check the ptr is pointing to the head of a block
-    if (ATB_GET_KIND(block) != AT_HEAD) {
+    if (!ATB_IS_HEAD(block)) {
         GC_EXIT();
         return NULL;
     }
@@ -707,6 +1949,14 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
         return ptr_in;
     }
 
+    #if MICROPY_GC_ARENA
+    // blocks of an arena object are only freed with the arena
+    if (new_blocks < n_blocks && gc_arena_holds(block)) {
+        GC_EXIT();
+        return ptr_in;
+    }
+    #endif
+
     // check if we can shrink the allocated area
     if (new_blocks < n_blocks) {
         // free unneeded tail blocks
@@ -714,10 +1964,8 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
             ATB_ANY_TO_FREE(bl);
         }
 
-        // set the last_free pointer to end of this block if it's earlier in the heap
-        if ((block + new_blocks) / BLOCKS_PER_ATB < MP_STATE_MEM(gc_last_free_atb_index)) {
-            MP_STATE_MEM(gc_last_free_atb_index) = (block + new_blocks) / BLOCKS_PER_ATB;
-        }
+        // move the free index back to end of this block if it's earlier in the heap
+        gc_free_index_update(block + new_blocks);
 
         GC_EXIT();
 
@@ -798,6 +2046,88 @@ void gc_dump_info(void) {
            (uint)info.num_1block, (uint)info.num_2block, (uint)info.max_block, (uint)info.max_free);
 }
 
+// Return the character that stands for block bl in the allocation table
+// dumps: '.' for free, '=' for tail, 'm' for marked and, for a head, a letter
+// for the type of the object in it.
+STATIC int gc_block_char(size_t bl) {
+    int c = ' ';
+    switch (ATB_GET_KIND(bl)) {
+        case AT_FREE: c = '.'; break;
+        /* this prints out if the object is reachable from BSS or STACK (for unix only)
+        case AT_HEAD: {
+            c = 'h';
+            void **ptrs = (void**)(void*)&mp_state_ctx;
+            mp_uint_t len = offsetof(mp_state_ctx_t, vm.stack_top) / sizeof(mp_uint_t);
+            for (mp_uint_t i = 0; i < len; i++) {
+                mp_uint_t ptr = (mp_uint_t)ptrs[i];
+                if (VERIFY_PTR(ptr) && BLOCK_FROM_PTR(ptr) == bl) {
+                    c = 'B';
+                    break;
+                }
+            }
+            if (c == 'h') {
+                ptrs = (void**)&c;
+                len = ((mp_uint_t)MP_STATE_THREAD(stack_top) - (mp_uint_t)&c) / sizeof(mp_uint_t);
+                for (mp_uint_t i = 0; i < len; i++) {
+                    mp_uint_t ptr = (mp_uint_t)ptrs[i];
+                    if (VERIFY_PTR(ptr) && BLOCK_FROM_PTR(ptr) == bl) {
+                        c = 'S';
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        */
+        /* this prints the uPy object type of the head block */
+        case AT_HEAD: {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-align"
+            void **ptr = (void**)(MP_STATE_MEM(gc_pool_start) + bl * BYTES_PER_BLOCK);
+#pragma GCC diagnostic pop
+            if (*ptr == &mp_type_tuple) { c = 'T'; }
+            else if (*ptr == &mp_type_list) { c = 'L'; }
+            else if (*ptr == &mp_type_dict) { c = 'D'; }
+            else if (*ptr == &mp_type_str || *ptr == &mp_type_bytes) { c = 'S'; }
+            #if MICROPY_PY_BUILTINS_BYTEARRAY
+            else if (*ptr == &mp_type_bytearray) { c = 'A'; }
+            #endif
+            #if MICROPY_PY_ARRAY
+            else if (*ptr == &mp_type_array) { c = 'A'; }
+            #endif
+            #if MICROPY_PY_BUILTINS_FLOAT
+            else if (*ptr == &mp_type_float) { c = 'F'; }
+            #endif
+            else if (*ptr == &mp_type_fun_bc) { c = 'B'; }
+            else if (*ptr == &mp_type_module) { c = 'M'; }
+            else {
+                c = 'h';
+                #if 0
+                // This code prints "Q" for qstr-pool data, and "q" for qstr-str
+                // data.  It can be useful to see how qstrs are being allocated,
+                // but is disabled by default because it is very slow.
+                for (qstr_pool_t *pool = MP_STATE_VM(last_pool); c == 'h' && pool != NULL; pool = pool->prev) {
+                    if ((qstr_pool_t*)ptr == pool) {
+                        c = 'Q';
+                        break;
+                    }
+                    for (const byte **q = pool->qstrs, **q_top = pool->qstrs + pool->len; q < q_top; q++) {
+                        if ((const byte*)ptr == *q) {
+                            c = 'q';
+                            break;
+                        }
+                    }
+                }
+                #endif
+            }
+            break;
+        }
+        case AT_TAIL: c = '='; break;
+        case AT_MARK: c = 'm'; break;
+    }
+    return c;
+}
+
 void gc_dump_alloc_table(void) {
     GC_ENTER();
     static const size_t DUMP_BYTES_PER_LINE = 64;
@@ -830,87 +2160,22 @@ void gc_dump_alloc_table(void) {
             //mp_printf(&mp_plat_print, "\n%05x: ", (uint)(PTR_FROM_BLOCK(bl) & (uint32_t)0xfffff));
             mp_printf(&mp_plat_print, "\n%05x: ", (uint)((bl * BYTES_PER_BLOCK) & (uint32_t)0xfffff));
         }
-        int c = ' ';
-        switch (ATB_GET_KIND(bl)) {
-            case AT_FREE: c = '.'; break;
-            /* this prints out if the object is reachable from BSS or STACK (for unix only)
-            case AT_HEAD: {
-                c = 'h';
-                void **ptrs = (void**)(void*)&mp_state_ctx;
-                mp_uint_t len = offsetof(mp_state_ctx_t, vm.stack_top) / sizeof(mp_uint_t);
-                for (mp_uint_t i = 0; i < len; i++) {
-                    mp_uint_t ptr = (mp_uint_t)ptrs[i];
-                    if (VERIFY_PTR(ptr) && BLOCK_FROM_PTR(ptr) == bl) {
-                        c = 'B';
-                        break;
-                    }
-                }
-                if (c == 'h') {
-                    ptrs = (void**)&c;
-                    len = ((mp_uint_t)MP_STATE_THREAD(stack_top) - (mp_uint_t)&c) / sizeof(mp_uint_t);
-                    for (mp_uint_t i = 0; i < len; i++) {
-                        mp_uint_t ptr = (mp_uint_t)ptrs[i];
-                        if (VERIFY_PTR(ptr) && BLOCK_FROM_PTR(ptr) == bl) {
-                            c = 'S';
-                            break;
-                        }
-                    }
-                }
-                break;
-            }
-            */
-            /* this prints the uPy object type of the head block */
-            case AT_HEAD: {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-align"
-                void **ptr = (void**)(MP_STATE_MEM(gc_pool_start) + bl * BYTES_PER_BLOCK);
-#pragma GCC diagnostic pop
-                if (*ptr == &mp_type_tuple) { c = 'T'; }
-                else if (*ptr == &mp_type_list) { c = 'L'; }
-                else if (*ptr == &mp_type_dict) { c = 'D'; }
-                else if (*ptr == &mp_type_str || *ptr == &mp_type_bytes) { c = 'S'; }
-                #if MICROPY_PY_BUILTINS_BYTEARRAY
-                else if (*ptr == &mp_type_bytearray) { c = 'A'; }
-                #endif
-                #if MICROPY_PY_ARRAY
-                else if (*ptr == &mp_type_array) { c = 'A'; }
-                #endif
-                #if MICROPY_PY_BUILTINS_FLOAT
-                else if (*ptr == &mp_type_float) { c = 'F'; }
-                #endif
-                else if (*ptr == &mp_type_fun_bc) { c = 'B'; }
-                else if (*ptr == &mp_type_module) { c = 'M'; }
-                else {
-                    c = 'h';
-                    #if 0
-                    // This code prints "Q" for qstr-pool data, and "q" for qstr-str
-                    // data.  It can be useful to see how qstrs are being allocated,
-                    // but is disabled by default because it is very slow.
-                    for (qstr_pool_t *pool = MP_STATE_VM(last_pool); c == 'h' && pool != NULL; pool = pool->prev) {
-                        if ((qstr_pool_t*)ptr == pool) {
-                            c = 'Q';
-                            break;
-                        }
-                        for (const byte **q = pool->qstrs, **q_top = pool->qstrs + pool->len; q < q_top; q++) {
-                            if ((const byte*)ptr == *q) {
-                                c = 'q';
-                                break;
-                            }
-                        }
-                    }
-                    #endif
-                }
-                break;
-            }
-            case AT_TAIL: c = '='; break;
-            case AT_MARK: c = 'm'; break;
-        }
-        mp_printf(&mp_plat_print, "%c", c);
+        mp_printf(&mp_plat_print, "%c", gc_block_char(bl));
     }
     mp_print_str(&mp_plat_print, "\n");
     GC_EXIT();
 }
 
+size_t gc_snapshot(byte *buf, size_t len) {
+    GC_ENTER();
+    size_t n_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    for (size_t bl = 0; bl < n_blocks && bl < len; bl++) {
+        buf[bl] = gc_block_char(bl);
+    }
+    GC_EXIT();
+    return n_blocks;
+}
+
 #if DEBUG_PRINT
 void gc_test(void) {
     mp_uint_t len = 500;
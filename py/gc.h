@@ -45,9 +45,84 @@ void gc_collect_start(void);
 void gc_collect_root(void **ptrs, size_t len);
 void gc_collect_end(void);
 
+#if MICROPY_GC_NURSERY_BLOCKS
+// Reclaim unreachable objects in the nursery only, by way of gc_collect.
+void gc_collect_minor(void);
+#endif
+
+#if MICROPY_GC_PARALLEL_MARK
+// Between these two calls gc_collect_root may be called by several threads at
+// once, for example by all threads scanning their own stack.
+void gc_collect_parallel_start(void);
+void gc_collect_parallel_end(void);
+#endif
+
+#if MICROPY_GC_ALLOC_THRESHOLD
+// Run the collection due because the allocation threshold was reached;
+// called from the VM loop.
+void gc_threshold_collect(void);
+#endif
+
+#if MICROPY_GC_INCREMENTAL_SWEEP
+// Do one bounded step of a pending sweep; called from the VM loop.
+void gc_sweep_step(void);
+#endif
+
+#if MICROPY_GC_THREAD_ALLOC_BLOCKS
+// Each thread reserves regions of the heap to allocate small objects from
+// without taking the GC mutex.  A thread must register itself when it starts
+// and unregister before it finishes; gc_init does this for the main thread.
+void gc_thread_alloc_start(void);
+void gc_thread_alloc_finish(void);
+#endif
+
+#if MICROPY_GC_COMPACT
+// Collect, then move buffers of bytearray and array objects into free memory
+// lower down the heap.  Returns the number of buffers moved.
+size_t gc_compact(void);
+#endif
+
+#if MICROPY_GC_ALLOC_PROFILE
+// Sample one allocation in every rate blocks allocated, discarding earlier
+// samples; a rate of 0 stops sampling but keeps the samples.
+void gc_profile_set_rate(size_t rate);
+// Copy the samples, oldest first, to dest which must have room for
+// MICROPY_GC_ALLOC_PROFILE_ENTRIES of them.  Returns the number copied.
+struct _mp_gc_profile_entry_t;
+size_t gc_profile_get(struct _mp_gc_profile_entry_t *dest);
+#endif
+
+#if MICROPY_GC_ARENA
+// While an arena is entered, objects without a finaliser that the thread
+// allocates are taken from the front of its chunk if they fit.  Freeing or
+// shrinking them does nothing, and they are not swept, until the arena is
+// exited.  Arenas of a thread nest and must be exited in reverse order.
+typedef struct _gc_arena_t {
+    struct _gc_arena_t *prev;
+    struct _gc_arena_t *next;
+    byte *start;
+    byte *free;
+    byte *end;
+} gc_arena_t;
+
+// Allocate a chunk of n_bytes for the arena and make it the current one of
+// the calling thread.  Returns false if the chunk can't be allocated.
+bool gc_arena_enter(gc_arena_t *arena, size_t n_bytes);
+// Stop allocating from the arena.  With collect false all of its objects are
+// freed at once, so the caller must be sure nothing refers to them any more.
+// Otherwise the chunk is collected, which keeps any objects still in use.
+void gc_arena_exit(gc_arena_t *arena, bool collect);
+#endif
+
 void *gc_alloc(size_t n_bytes, bool has_finaliser);
+#if MICROPY_GC_LONG_LIVED
+// Allocate zeroed memory for an object that will likely never be freed, taking
+// it from the top of the heap if possible.
+void *gc_alloc_long_lived(size_t n_bytes);
+#endif
 void gc_free(void *ptr); // does not call finaliser
 size_t gc_nbytes(const void *ptr);
+void *gc_find_head(const void *ptr);
 void *gc_realloc(void *ptr, size_t n_bytes, bool allow_move);
 
 typedef struct _gc_info_t {
@@ -61,7 +136,24 @@ typedef struct _gc_info_t {
 } gc_info_t;
 
 void gc_info(gc_info_t *info);
+
+#if MICROPY_GC_STATS
+typedef struct _gc_stats_t {
+    size_t collections; // all collections, including minor ones
+    size_t alloc_collections; // those run because an allocation failed
+    uint64_t pause_total; // time spent collecting, in microseconds
+    mp_uint_t pause_max; // longest collection, in microseconds
+    uint64_t alloc_bytes; // bytes asked for by successful allocations
+    uint64_t alloc_count; // number of successful allocations
+} gc_stats_t;
+
+void gc_stats(gc_stats_t *stats);
+#endif
 void gc_dump_info(void);
 void gc_dump_alloc_table(void);
 
+// Write the characters gc_dump_alloc_table prints for the first len blocks of
+// the heap into buf, and return the total number of blocks.
+size_t gc_snapshot(byte *buf, size_t len);
+
 #endif // __MICROPY_INCLUDED_PY_GC_H__
@@ -125,6 +125,24 @@ STATIC bool is_tail_of_identifier(mp_lexer_t *lex) {
     return is_head_of_identifier(lex) || is_digit(lex);
 }
 
+// get the next byte of the stream, from the current block if there is one
+STATIC unichar next_byte(mp_lexer_t *lex) {
+    if (lex->buf_cur < lex->buf_end) {
+        return *lex->buf_cur++;
+    }
+    if (lex->stream_read_block == NULL) {
+        return lex->stream_next_byte(lex->stream_data);
+    }
+    mp_uint_t len = lex->stream_read_block(lex->stream_data, &lex->buf_cur);
+    if (len == 0) {
+        lex->buf_cur = NULL;
+        lex->buf_end = NULL;
+        return MP_LEXER_EOF;
+    }
+    lex->buf_end = lex->buf_cur + len;
+    return *lex->buf_cur++;
+}
+
 STATIC void next_char(mp_lexer_t *lex) {
     if (lex->chr0 == MP_LEXER_EOF) {
         return;
@@ -144,7 +162,7 @@ STATIC void next_char(mp_lexer_t *lex) {
 
     lex->chr0 = lex->chr1;
     lex->chr1 = lex->chr2;
-    lex->chr2 = lex->stream_next_byte(lex->stream_data);
+    lex->chr2 = next_byte(lex);
 
     if (lex->chr0 == '\r') {
         // CR is a new line, converted to LF
@@ -152,7 +170,7 @@ STATIC void next_char(mp_lexer_t *lex) {
         if (lex->chr1 == '\n') {
             // CR LF is a single new line
             lex->chr1 = lex->chr2;
-            lex->chr2 = lex->stream_next_byte(lex->stream_data);
+            lex->chr2 = next_byte(lex);
         }
     }
 
@@ -166,6 +184,50 @@ STATIC void next_char(mp_lexer_t *lex) {
     }
 }
 
+// kinds of character runs for skip_run()
+enum {
+    RUN_NAME,
+    RUN_DIGITS,
+    RUN_COMMENT,
+};
+
+STATIC bool is_run_char(unichar c, int kind) {
+    if (kind == RUN_NAME) {
+        return unichar_isalpha(c) || unichar_isdigit(c) || c == '_' || (c >= 0x80 && c != MP_LEXER_EOF);
+    } else if (kind == RUN_DIGITS) {
+        return unichar_isdigit(c);
+    } else {
+        return c != '\n' && c != '\r' && c != MP_LEXER_EOF;
+    }
+}
+
+// Fast path for the body of a name, number or comment: when the current
+// character, the two after it and some of the buffered bytes after those are
+// all of the given kind, then move past them in one go, adding them to the
+// token text unless they are a comment.  The last three of them are left in
+// chr0-2 so that next_char() deals with whatever follows.
+STATIC void skip_run(mp_lexer_t *lex, int kind) {
+    const byte *p = lex->buf_cur;
+    while (p < lex->buf_end && is_run_char(*p, kind)) {
+        ++p;
+    }
+    mp_uint_t n = p - lex->buf_cur;
+    if (n < 3 || !is_run_char(lex->chr0, kind) || !is_run_char(lex->chr1, kind) || !is_run_char(lex->chr2, kind)) {
+        return;
+    }
+    if (kind != RUN_COMMENT) {
+        vstr_add_byte(&lex->vstr, lex->chr0);
+        vstr_add_byte(&lex->vstr, lex->chr1);
+        vstr_add_byte(&lex->vstr, lex->chr2);
+        vstr_add_strn(&lex->vstr, (const char*)lex->buf_cur, n - 3);
+    }
+    lex->column += n;
+    lex->chr0 = p[-3];
+    lex->chr1 = p[-2];
+    lex->chr2 = p[-1];
+    lex->buf_cur = p;
+}
+
 STATIC void indent_push(mp_lexer_t *lex, mp_uint_t indent) {
     if (lex->num_indent_level >= lex->alloc_indent_level) {
         // TODO use m_renew_maybe and somehow indicate an error if it fails... probably by using MP_TOKEN_MEMORY_ERROR
@@ -300,6 +362,7 @@ STATIC void mp_lexer_next_token_into(mp_lexer_t *lex, bool first_token) {
         } else if (is_char(lex, '#')) {
             next_char(lex);
             while (!is_end(lex) && !is_physical_newline(lex)) {
+                skip_run(lex, RUN_COMMENT);
                 next_char(lex);
             }
             // had_physical_newline will be set on next loop
@@ -531,6 +594,7 @@ STATIC void mp_lexer_next_token_into(mp_lexer_t *lex, bool first_token) {
 
         // get tail chars
         while (!is_end(lex) && is_tail_of_identifier(lex)) {
+            skip_run(lex, RUN_NAME);
             vstr_add_byte(&lex->vstr, CUR_CHAR(lex));
             next_char(lex);
         }
@@ -561,6 +625,9 @@ STATIC void mp_lexer_next_token_into(mp_lexer_t *lex, bool first_token) {
                     next_char(lex);
                 }
             } else if (is_letter(lex) || is_digit(lex) || is_char(lex, '.')) {
+                if (is_digit(lex)) {
+                    skip_run(lex, RUN_DIGITS);
+                }
                 if (is_char_or3(lex, '.', 'j', 'J')) {
                     lex->tok_kind = MP_TOKEN_FLOAT_OR_IMAG;
                 }
@@ -688,7 +755,7 @@ STATIC void mp_lexer_next_token_into(mp_lexer_t *lex, bool first_token) {
     }
 }
 
-mp_lexer_t *mp_lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_byte_t stream_next_byte, mp_lexer_stream_close_t stream_close) {
+STATIC mp_lexer_t *lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_byte_t stream_next_byte, mp_lexer_stream_read_block_t stream_read_block, mp_lexer_stream_close_t stream_close) {
     mp_lexer_t *lex = m_new_obj_maybe(mp_lexer_t);
 
     // check for memory allocation error
@@ -702,7 +769,10 @@ mp_lexer_t *mp_lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_
     lex->source_name = src_name;
     lex->stream_data = stream_data;
     lex->stream_next_byte = stream_next_byte;
+    lex->stream_read_block = stream_read_block;
     lex->stream_close = stream_close;
+    lex->buf_cur = NULL;
+    lex->buf_end = NULL;
     lex->line = 1;
     lex->column = 1;
     lex->emit_dent = 0;
@@ -723,9 +793,9 @@ mp_lexer_t *mp_lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_
     lex->indent_level[0] = 0;
 
     // preload characters
-    lex->chr0 = stream_next_byte(stream_data);
-    lex->chr1 = stream_next_byte(stream_data);
-    lex->chr2 = stream_next_byte(stream_data);
+    lex->chr0 = next_byte(lex);
+    lex->chr1 = next_byte(lex);
+    lex->chr2 = next_byte(lex);
 
     // if input stream is 0, 1 or 2 characters long and doesn't end in a newline, then insert a newline at the end
     if (lex->chr0 == MP_LEXER_EOF) {
@@ -750,6 +820,14 @@ mp_lexer_t *mp_lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_
     return lex;
 }
 
+mp_lexer_t *mp_lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_byte_t stream_next_byte, mp_lexer_stream_close_t stream_close) {
+    return lexer_new(src_name, stream_data, stream_next_byte, NULL, stream_close);
+}
+
+mp_lexer_t *mp_lexer_new_buffered(qstr src_name, void *stream_data, mp_lexer_stream_read_block_t stream_read_block, mp_lexer_stream_close_t stream_close) {
+    return lexer_new(src_name, stream_data, NULL, stream_read_block, stream_close);
+}
+
 void mp_lexer_free(mp_lexer_t *lex) {
     if (lex) {
         if (lex->stream_close) {
@@ -150,14 +150,23 @@ typedef enum _mp_token_kind_t {
 typedef mp_uint_t (*mp_lexer_stream_next_byte_t)(void*);
 typedef void (*mp_lexer_stream_close_t)(void*);
 
+// the read-block function must point buf at the next block of bytes in the stream
+// and return its length, which stays valid until the function is called again
+// it must return 0 at end of stream, and keep doing so if called again
+typedef mp_uint_t (*mp_lexer_stream_read_block_t)(void*, const byte **buf);
+
 // this data structure is exposed for efficiency
 // public members are: source_name, tok_line, tok_column, tok_kind, vstr
 typedef struct _mp_lexer_t {
     qstr source_name;           // name of source
     void *stream_data;          // data for stream
     mp_lexer_stream_next_byte_t stream_next_byte;   // stream callback to get next byte
+    mp_lexer_stream_read_block_t stream_read_block; // stream callback to get next block, or NULL
     mp_lexer_stream_close_t stream_close;           // stream callback to free
 
+    const byte *buf_cur;        // next unread byte of the current block
+    const byte *buf_end;        // end of the current block
+
     unichar chr0, chr1, chr2;   // current cached characters from source
 
     mp_uint_t line;             // current source line
@@ -177,6 +186,7 @@ typedef struct _mp_lexer_t {
 } mp_lexer_t;
 
 mp_lexer_t *mp_lexer_new(qstr src_name, void *stream_data, mp_lexer_stream_next_byte_t stream_next_byte, mp_lexer_stream_close_t stream_close);
+mp_lexer_t *mp_lexer_new_buffered(qstr src_name, void *stream_data, mp_lexer_stream_read_block_t stream_read_block, mp_lexer_stream_close_t stream_close);
 mp_lexer_t *mp_lexer_new_from_str_len(qstr src_name, const char *str, mp_uint_t len, mp_uint_t free_len);
 
 void mp_lexer_free(mp_lexer_t *lex);
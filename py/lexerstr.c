@@ -35,12 +35,12 @@ typedef struct _mp_lexer_str_buf_t {
     const char *src_end;        // end (exclusive) of source
 } mp_lexer_str_buf_t;
 
-STATIC mp_uint_t str_buf_next_byte(mp_lexer_str_buf_t *sb) {
-    if (sb->src_cur < sb->src_end) {
-        return *sb->src_cur++;
-    } else {
-        return MP_LEXER_EOF;
-    }
+STATIC mp_uint_t str_buf_read_block(mp_lexer_str_buf_t *sb, const byte **buf) {
+    // the whole of the rest of the string is one block
+    *buf = (const byte*)sb->src_cur;
+    mp_uint_t len = sb->src_end - sb->src_cur;
+    sb->src_cur = sb->src_end;
+    return len;
 }
 
 STATIC void str_buf_free(mp_lexer_str_buf_t *sb) {
@@ -59,7 +59,7 @@ mp_lexer_t *mp_lexer_new_from_str_len(qstr src_name, const char *str, mp_uint_t
     sb->src_beg = str;
     sb->src_cur = str;
     sb->src_end = str + len;
-    return mp_lexer_new(src_name, sb, (mp_lexer_stream_next_byte_t)str_buf_next_byte, (mp_lexer_stream_close_t)str_buf_free);
+    return mp_lexer_new_buffered(src_name, sb, (mp_lexer_stream_read_block_t)str_buf_read_block, (mp_lexer_stream_close_t)str_buf_free);
 }
 
 #endif // MICROPY_ENABLE_COMPILER
@@ -40,26 +40,21 @@
 typedef struct _mp_lexer_file_buf_t {
     int fd;
     bool close_fd;
+    bool eof;
     byte buf[20];
-    mp_uint_t len;
-    mp_uint_t pos;
 } mp_lexer_file_buf_t;
 
-STATIC mp_uint_t file_buf_next_byte(mp_lexer_file_buf_t *fb) {
-    if (fb->pos >= fb->len) {
-        if (fb->len == 0) {
-            return MP_LEXER_EOF;
-        } else {
-            int n = read(fb->fd, fb->buf, sizeof(fb->buf));
-            if (n <= 0) {
-                fb->len = 0;
-                return MP_LEXER_EOF;
-            }
-            fb->len = n;
-            fb->pos = 0;
-        }
+STATIC mp_uint_t file_buf_read_block(mp_lexer_file_buf_t *fb, const byte **buf) {
+    if (fb->eof) {
+        return 0;
+    }
+    int n = read(fb->fd, fb->buf, sizeof(fb->buf));
+    if (n <= 0) {
+        fb->eof = true;
+        return 0;
     }
-    return fb->buf[fb->pos++];
+    *buf = fb->buf;
+    return n;
 }
 
 STATIC void file_buf_close(mp_lexer_file_buf_t *fb) {
@@ -79,10 +74,8 @@ mp_lexer_t *mp_lexer_new_from_fd(qstr filename, int fd, bool close_fd) {
     }
     fb->fd = fd;
     fb->close_fd = close_fd;
-    int n = read(fb->fd, fb->buf, sizeof(fb->buf));
-    fb->len = n;
-    fb->pos = 0;
-    return mp_lexer_new(filename, fb, (mp_lexer_stream_next_byte_t)file_buf_next_byte, (mp_lexer_stream_close_t)file_buf_close);
+    fb->eof = false;
+    return mp_lexer_new_buffered(filename, fb, (mp_lexer_stream_read_block_t)file_buf_read_block, (mp_lexer_stream_close_t)file_buf_close);
 }
 
 mp_lexer_t *mp_lexer_new_from_file(const char *filename) {
@@ -150,6 +150,30 @@ def print_qstr_data(qcfgs, qstrs):
         qbytes = make_bytes(cfg_bytes_len, cfg_bytes_hash, qstr)
         print('QDEF(MP_QSTR_%s, %s)' % (ident, qbytes))
 
+    print_qstr_hash_table(cfg_bytes_hash, qstrs)
+
+def print_qstr_hash_table(cfg_bytes_hash, qstrs):
+    # open-addressed hash table of the qstr numbers, with 0 for an empty slot,
+    # filled up to two thirds at most; see qstr_find_strn
+    size = 1
+    while 2 * size < 3 * len(qstrs):
+        size *= 2
+    table = [0] * size
+    for order, ident, qstr in sorted(qstrs.values(), key=lambda x: x[0]):
+        qbytes = bytes_cons(qstr, 'utf8')
+        # this must match QSTR_HASH_SLOT in qstr.c
+        slot = (compute_hash(qbytes, cfg_bytes_hash) ^ (len(qbytes) << 8)) & (size - 1)
+        while table[slot]:
+            slot = (slot + 1) & (size - 1)
+        # the NULL qstr comes first
+        table[slot] = order + 1
+
+    print('')
+    print('#ifdef QHASH')
+    for i in range(0, size, 16):
+        print(' '.join('QHASH(%d)' % q for q in table[i:i + 16]))
+    print('#endif')
+
 def do_work(infiles):
     qcfgs, qstrs = parse_input_headers(infiles)
     print_qstr_data(qcfgs, qstrs)
@@ -34,6 +34,54 @@
 #include "py/runtime0.h"
 #include "py/runtime.h"
 
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+// Without the GIL, each map or set that isn't fixed is protected by the lock
+// picked by its address, which is held for every change and for lookups
+// that can't be done optimistically, see mp_map_lookup.  Some code, such as
+// iteration and the lookup caches of the VM, reads the slots of a map
+// directly without the lock, so a table that is replaced is never freed but
+// left to the GC, and a new table is only made visible with its alloc once it
+// is at least as big as the old one.
+#define MAP_LOCKING (1)
+#define MAP_LOCK_FOR(map) (&MP_STATE_VM(map_locks)[((uintptr_t)(map) >> 4) % MICROPY_PY_THREAD_MAP_LOCKS])
+#define MAP_PUBLISH() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define MAP_DEL_TABLE(type, ptr, n) ((void)(ptr))
+
+void mp_map_lock_init(void) {
+    for (size_t i = 0; i < MICROPY_PY_THREAD_MAP_LOCKS; i++) {
+        mp_thread_mutex_init(&MP_STATE_VM(map_locks)[i].mutex);
+        MP_STATE_VM(map_locks)[i].owner = NULL;
+        MP_STATE_VM(map_locks)[i].depth = 0;
+        MP_STATE_VM(map_locks)[i].seq = 0;
+    }
+}
+
+STATIC mp_map_lock_t *map_lock(const void *map) {
+    mp_map_lock_t *lock = MAP_LOCK_FOR(map);
+    mp_state_thread_t *ts = mp_thread_get_state();
+    if (lock->owner != ts) {
+        mp_thread_mutex_lock(&lock->mutex, 1);
+        lock->owner = ts;
+        __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    lock->depth++;
+    return lock;
+}
+
+STATIC void map_unlock(mp_map_lock_t *lock) {
+    if (--lock->depth == 0) {
+        __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+        lock->owner = NULL;
+        mp_thread_mutex_unlock(&lock->mutex);
+    }
+}
+#else
+#define MAP_LOCKING (0)
+#define MAP_PUBLISH()
+#define MAP_DEL_TABLE(type, ptr, n) m_del(type, ptr, n)
+#endif
+
 // Fixed empty map. Useful when need to call kw-receiving functions
 // without any keywords from C, etc.
 const mp_map_t mp_const_empty_map = {
@@ -67,21 +115,86 @@ STATIC mp_uint_t get_hash_alloc_greater_or_equal_to(mp_uint_t x) {
     return (x + x / 2) | 1;
 }
 
+// Return the table size to preallocate for a map or set that will be filled
+// with about n entries.  A compact map has its own hash index, so it needs
+// exactly n; an open-addressed table gets some slack so that it does not end
+// up full, which would make every failed lookup scan the whole table.
+mp_uint_t mp_map_alloc_hint(mp_uint_t n, bool is_compact) {
+    if (n == 0 || is_compact) {
+        return n;
+    }
+    return get_hash_alloc_greater_or_equal_to(n + n / 4);
+}
+
+#if MICROPY_OPT_MAP_COMPACT
+// A compact map keeps its entries densely, in insertion order, in
+// table[0..alloc), so that code which iterates over the slots of a map works
+// unchanged.  Deleted entries keep their place, with key MP_OBJ_SENTINEL,
+// until the entries are compacted when the table is next full.
+//
+// Small maps are searched linearly, stopping at the first unused entry.
+// Larger maps follow their entries in the same allocation by an array of
+// indices, each 1, 2 or 4 bytes wide depending on alloc.  The first index
+// counts the entries used so far, including deleted ones, and the rest are an
+// open-addressed hash table where 0 is an empty slot and i + 1 refers to
+// table[i].  The index of a deleted entry stays and acts as a tombstone.
+
+#define MAP_COMPACT_LINEAR_MAX (8)
+
+static inline size_t map_compact_index_len(size_t alloc) {
+    return alloc + alloc / 4 + 1;
+}
+
+static inline size_t map_compact_index_width(size_t alloc) {
+    return alloc <= 0xff ? 1 : alloc <= 0xffff ? 2 : 4;
+}
+
+STATIC size_t map_compact_bytes(size_t alloc) {
+    size_t n_bytes = alloc * sizeof(mp_map_elem_t);
+    if (alloc > MAP_COMPACT_LINEAR_MAX) {
+        n_bytes += (1 + map_compact_index_len(alloc)) * map_compact_index_width(alloc);
+    }
+    return n_bytes;
+}
+
+STATIC size_t map_compact_get(const mp_map_t *map, size_t i) {
+    void *index = &map->table[map->alloc];
+    switch (map_compact_index_width(map->alloc)) {
+        case 1: return ((uint8_t*)index)[i];
+        case 2: return ((uint16_t*)index)[i];
+        default: return ((uint32_t*)index)[i];
+    }
+}
+
+STATIC void map_compact_set(mp_map_t *map, size_t i, size_t val) {
+    void *index = &map->table[map->alloc];
+    switch (map_compact_index_width(map->alloc)) {
+        case 1: ((uint8_t*)index)[i] = val; break;
+        case 2: ((uint16_t*)index)[i] = val; break;
+        default: ((uint32_t*)index)[i] = val; break;
+    }
+}
+#endif
+
 /******************************************************************************/
 /* map                                                                        */
 
 void mp_map_init(mp_map_t *map, mp_uint_t n) {
     if (n == 0) {
-        map->alloc = 0;
         map->table = NULL;
     } else {
-        map->alloc = n;
-        map->table = m_new0(mp_map_elem_t, map->alloc);
+        #if MICROPY_OPT_MAP_COMPACT
+        map->table = (mp_map_elem_t*)m_new0(byte, map_compact_bytes(n));
+        #else
+        map->table = m_new0(mp_map_elem_t, n);
+        #endif
     }
+    map->alloc = n;
     map->used = 0;
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 0;
     map->is_ordered = 0;
+    map->is_compact = MICROPY_OPT_MAP_COMPACT;
 }
 
 void mp_map_init_fixed_table(mp_map_t *map, mp_uint_t n, const mp_obj_t *table) {
@@ -90,20 +203,67 @@ void mp_map_init_fixed_table(mp_map_t *map, mp_uint_t n, const mp_obj_t *table)
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 1;
     map->is_ordered = 1;
+    map->is_compact = 0;
     map->table = (mp_map_elem_t*)table;
 }
 
+// Initialise map with a copy of the entries of src, keeping its layout.
+// The copy is never fixed, even if src is.
+void mp_map_init_copy(mp_map_t *map, const mp_map_t *src) {
+    #if MAP_LOCKING
+    mp_map_lock_t *lock = map_lock(src);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        map_unlock(lock);
+        nlr_jump(nlr.ret_val);
+    }
+    #endif
+    size_t n_bytes = src->alloc * sizeof(mp_map_elem_t);
+    #if MICROPY_OPT_MAP_COMPACT
+    if (src->is_compact) {
+        n_bytes = map_compact_bytes(src->alloc);
+    }
+    #endif
+    map->table = NULL;
+    if (n_bytes != 0) {
+        map->table = (mp_map_elem_t*)m_new(byte, n_bytes);
+        memcpy(map->table, src->table, n_bytes);
+    }
+    map->alloc = src->alloc;
+    map->used = src->used;
+    map->all_keys_are_qstrs = src->all_keys_are_qstrs;
+    map->is_fixed = 0;
+    map->is_ordered = src->is_ordered;
+    map->is_compact = src->is_compact;
+    #if MAP_LOCKING
+    nlr_pop();
+    map_unlock(lock);
+    #endif
+}
+
 mp_map_t *mp_map_new(mp_uint_t n) {
     mp_map_t *map = m_new(mp_map_t, 1);
     mp_map_init(map, n);
     return map;
 }
 
+STATIC void mp_map_free_table(mp_map_t *map) {
+    if (map->is_fixed || MAP_LOCKING) {
+        // without the GIL other threads may still be reading the table
+        return;
+    }
+    #if MICROPY_OPT_MAP_COMPACT
+    if (map->is_compact) {
+        m_del(byte, map->table, map_compact_bytes(map->alloc));
+        return;
+    }
+    #endif
+    m_del(mp_map_elem_t, map->table, map->alloc);
+}
+
 // Differentiate from mp_map_clear() - semantics is different
 void mp_map_deinit(mp_map_t *map) {
-    if (!map->is_fixed) {
-        m_del(mp_map_elem_t, map->table, map->alloc);
-    }
+    mp_map_free_table(map);
     map->used = map->alloc = 0;
 }
 
@@ -113,33 +273,201 @@ void mp_map_free(mp_map_t *map) {
 }
 
 void mp_map_clear(mp_map_t *map) {
-    if (!map->is_fixed) {
-        m_del(mp_map_elem_t, map->table, map->alloc);
-    }
+    #if MAP_LOCKING
+    mp_map_lock_t *lock = map_lock(map);
+    #endif
+    mp_map_free_table(map);
     map->alloc = 0;
     map->used = 0;
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 0;
+    MAP_PUBLISH();
     map->table = NULL;
+    #if MAP_LOCKING
+    map_unlock(lock);
+    #endif
+}
+
+STATIC mp_map_elem_t *map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind);
+
+// Allocate a zeroed table for map, as a long-lived object if map is the
+// namespace being filled in by a module or class body during an import.
+STATIC void *map_new_table(mp_map_t *map, size_t n_bytes) {
+    if (mp_import_is_toplevel() && map == &mp_locals_get()->map) {
+        return m_new0_ll(byte, n_bytes);
+    }
+    return m_new0(byte, n_bytes);
 }
 
 STATIC void mp_map_rehash(mp_map_t *map) {
     mp_uint_t old_alloc = map->alloc;
     mp_uint_t new_alloc = get_hash_alloc_greater_or_equal_to(map->alloc + 1);
     mp_map_elem_t *old_table = map->table;
-    mp_map_elem_t *new_table = m_new0(mp_map_elem_t, new_alloc);
+    mp_map_elem_t *new_table = map_new_table(map, new_alloc * sizeof(mp_map_elem_t));
     // If we reach this point, table resizing succeeded, now we can edit the old map.
-    map->alloc = new_alloc;
     map->used = 0;
     map->all_keys_are_qstrs = 1;
     map->table = new_table;
+    MAP_PUBLISH();
+    map->alloc = new_alloc;
     for (mp_uint_t i = 0; i < old_alloc; i++) {
         if (old_table[i].key != MP_OBJ_NULL && old_table[i].key != MP_OBJ_SENTINEL) {
-            mp_map_lookup(map, old_table[i].key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = old_table[i].value;
+            map_lookup(map, old_table[i].key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = old_table[i].value;
+        }
+    }
+    MAP_DEL_TABLE(mp_map_elem_t, old_table, old_alloc);
+}
+
+static inline mp_uint_t mp_map_hash(mp_obj_t index) {
+    // fast path for common case of qstr
+    if (MP_OBJ_IS_QSTR(index)) {
+        return qstr_hash(MP_OBJ_QSTR_VALUE(index));
+    } else {
+        return MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
+    }
+}
+
+#if MICROPY_OPT_MAP_COMPACT
+// Add index, which must not be in the map, as entry n, which must be the
+// first unused entry.  For a map with an index pos is the empty slot of the
+// hash table to use.
+STATIC mp_map_elem_t *map_compact_append(mp_map_t *map, mp_obj_t index, size_t n, size_t pos) {
+    if (map->alloc > MAP_COMPACT_LINEAR_MAX) {
+        map_compact_set(map, 0, n + 1);
+        map_compact_set(map, 1 + pos, n + 1);
+    }
+    map->used++;
+    mp_map_elem_t *elem = &map->table[n];
+    elem->key = index;
+    elem->value = MP_OBJ_NULL;
+    if (!MP_OBJ_IS_QSTR(index)) {
+        map->all_keys_are_qstrs = 0;
+    }
+    return elem;
+}
+
+// Move the live entries to a new table with room for new_alloc of them,
+// dropping deleted ones and rebuilding the index.
+STATIC void map_compact_resize(mp_map_t *map, size_t new_alloc) {
+    mp_uint_t old_alloc = map->alloc;
+    mp_map_elem_t *old_table = map->table;
+    mp_map_elem_t *new_table = map_new_table(map, map_compact_bytes(new_alloc));
+    // If we reach this point, table resizing succeeded, now we can edit the old map.
+    map->used = 0;
+    map->all_keys_are_qstrs = 1;
+    map->table = new_table;
+    MAP_PUBLISH();
+    map->alloc = new_alloc;
+    size_t index_len = map_compact_index_len(new_alloc);
+    for (size_t i = 0; i < old_alloc; i++) {
+        mp_obj_t key = old_table[i].key;
+        if (key == MP_OBJ_NULL) {
+            break;
+        } else if (key == MP_OBJ_SENTINEL) {
+            continue;
+        }
+        size_t pos = 0;
+        if (new_alloc > MAP_COMPACT_LINEAR_MAX) {
+            pos = mp_map_hash(key) % index_len;
+            while (map_compact_get(map, 1 + pos) != 0) {
+                pos = (pos + 1) % index_len;
+            }
+        }
+        map_compact_append(map, key, map->used, pos)->value = old_table[i].value;
+    }
+    MAP_DEL_TABLE(byte, old_table, map_compact_bytes(old_alloc));
+}
+
+// Compact the table when it has no unused entries, growing it if needed, and
+// leave some room so that deleting and adding keys doesn't compact it every
+// time.
+STATIC void map_compact_make_room(mp_map_t *map) {
+    size_t new_alloc = get_hash_alloc_greater_or_equal_to(map->used + map->used / 4 + 1);
+    if (MAP_LOCKING && new_alloc < map->alloc) {
+        // the table mustn't shrink under unlocked readers
+        new_alloc = map->alloc;
+    }
+    map_compact_resize(map, new_alloc);
+}
+
+STATIC mp_map_elem_t *map_compact_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind, bool compare_only_ptrs) {
+    if (map->alloc <= MAP_COMPACT_LINEAR_MAX) {
+        if (!MP_OBJ_IS_QSTR(index) && !MP_OBJ_IS_SMALL_INT(index)) {
+            // the hash isn't needed but unhashable keys must still be rejected
+            mp_map_hash(index);
+        }
+        mp_map_elem_t *elem = &map->table[0], *top = &map->table[map->alloc];
+        for (; elem < top && elem->key != MP_OBJ_NULL; elem++) {
+            if (elem->key == index || (!compare_only_ptrs && elem->key != MP_OBJ_SENTINEL && mp_obj_equal(elem->key, index))) {
+                if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
+                    map->used--;
+                    elem->key = MP_OBJ_SENTINEL;
+                    // keep elem->value so that caller can access it if needed
+                }
+                return elem;
+            }
+        }
+        if (lookup_kind != MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+            return NULL;
+        }
+        if (elem < top) {
+            return map_compact_append(map, index, elem - map->table, 0);
+        }
+        map_compact_make_room(map);
+        if (map->alloc <= MAP_COMPACT_LINEAR_MAX) {
+            return map_compact_append(map, index, map->used, 0);
+        }
+    }
+
+    mp_uint_t hash = mp_map_hash(index);
+    size_t index_len = map_compact_index_len(map->alloc);
+    size_t pos = hash % index_len;
+    for (;;) {
+        size_t i = map_compact_get(map, 1 + pos);
+        if (i == 0) {
+            // found empty slot, so index is not in table
+            if (lookup_kind != MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+                return NULL;
+            }
+            size_t n = map_compact_get(map, 0);
+            if (n == map->alloc) {
+                map_compact_make_room(map);
+                if (map->alloc <= MAP_COMPACT_LINEAR_MAX) {
+                    // there were enough deleted entries to drop the index
+                    return map_compact_append(map, index, map->used, 0);
+                }
+                // restart the search for the new element
+                index_len = map_compact_index_len(map->alloc);
+                pos = hash % index_len;
+                continue;
+            }
+            return map_compact_append(map, index, n, pos);
+        }
+        mp_map_elem_t *elem = &map->table[i - 1];
+        if (elem->key == index || (!compare_only_ptrs && elem->key != MP_OBJ_SENTINEL && mp_obj_equal(elem->key, index))) {
+            // found index
+            if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
+                map->used--;
+                elem->key = MP_OBJ_SENTINEL;
+                // keep elem->value so that caller can access it if needed
+            }
+            return elem;
         }
+        pos = (pos + 1) % index_len;
     }
-    m_del(mp_map_elem_t, old_table, old_alloc);
 }
+#endif
+
+#if MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE
+// Each entry of the cache holds the position at which a key was last found in
+// an ordered map, picked by both the key and the map so that the same name in
+// different locals dicts doesn't collide.  The position is checked before it
+// is used, so an entry that belongs to another map or key is harmless and
+// the cache needs no invalidation.  The shifts drop the tag bits of the key
+// and the alignment bits of the map.
+#define MAP_CACHE_ENTRY(map, index) (MP_STATE_VM(map_lookup_cache)[ \
+    ((((uintptr_t)(index)) >> 2) ^ (((uintptr_t)(map)) >> 3)) % MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE])
+#endif
 
 // MP_MAP_LOOKUP behaviour:
 //  - returns NULL if not found, else the slot it was found in with key,value non-null
@@ -147,7 +475,7 @@ STATIC void mp_map_rehash(mp_map_t *map) {
 //  - returns slot, with key non-null and value=MP_OBJ_NULL if it was added
 // MP_MAP_LOOKUP_REMOVE_IF_FOUND behaviour:
 //  - returns NULL if not found, else the slot if was found in with key null and value non-null
-mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
+STATIC mp_map_elem_t *map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
 
     if (map->is_fixed && lookup_kind != MP_MAP_LOOKUP) {
         // can't add/remove from a fixed array
@@ -175,8 +503,26 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
 
     // if the map is an ordered array then we must do a brute force linear search
     if (map->is_ordered) {
+        #if MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE
+        uint8_t *cached = NULL;
+        if (compare_only_ptrs) {
+            cached = &MAP_CACHE_ENTRY(map, index);
+            if (*cached < map->used && map->table[*cached].key == index) {
+                mp_map_elem_t *elem = &map->table[*cached];
+                if (MP_UNLIKELY(lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND)) {
+                    elem->key = MP_OBJ_SENTINEL;
+                }
+                return elem;
+            }
+        }
+        #endif
         for (mp_map_elem_t *elem = &map->table[0], *top = &map->table[map->used]; elem < top; elem++) {
             if (elem->key == index || (!compare_only_ptrs && mp_obj_equal(elem->key, index))) {
+                #if MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE
+                if (cached != NULL && elem - map->table <= 0xff) {
+                    *cached = elem - map->table;
+                }
+                #endif
                 if (MP_UNLIKELY(lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND)) {
                     elem->key = MP_OBJ_SENTINEL;
                     // keep elem->value so that caller can access it if needed
@@ -190,9 +536,17 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
         // TODO shrink array down over any previously-freed slots
         if (map->used == map->alloc) {
             // TODO: Alloc policy
+            #if MAP_LOCKING
+            mp_map_elem_t *new_table = m_new0(mp_map_elem_t, map->alloc + 4);
+            memcpy(new_table, map->table, map->used * sizeof(*map->table));
+            map->table = new_table;
+            MAP_PUBLISH();
+            map->alloc += 4;
+            #else
             map->alloc += 4;
             map->table = m_renew(mp_map_elem_t, map->table, map->used, map->alloc);
             mp_seq_clear(map->table, map->used, map->alloc, sizeof(*map->table));
+            #endif
         }
         mp_map_elem_t *elem = map->table + map->used++;
         elem->key = index;
@@ -204,6 +558,12 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
 
     // map is a hash table (not an ordered array), so do a hash lookup
 
+    #if MICROPY_OPT_MAP_COMPACT
+    if (map->is_compact) {
+        return map_compact_lookup(map, index, lookup_kind, compare_only_ptrs);
+    }
+    #endif
+
     if (map->alloc == 0) {
         if (lookup_kind == MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
             mp_map_rehash(map);
@@ -212,13 +572,7 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
         }
     }
 
-    // get hash of index, with fast path for common case of qstr
-    mp_uint_t hash;
-    if (MP_OBJ_IS_QSTR(index)) {
-        hash = qstr_hash(MP_OBJ_QSTR_VALUE(index));
-    } else {
-        hash = MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
-    }
+    mp_uint_t hash = mp_map_hash(index);
 
     mp_uint_t pos = hash % map->alloc;
     mp_uint_t start_pos = pos;
@@ -291,6 +645,124 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
     }
 }
 
+#if MAP_LOCKING
+// Look up index without taking the map's lock.  The map is copied between two
+// reads of the lock's sequence number, so that its table and size match, and
+// the result is only used if the number is still the same after the lookup,
+// meaning the map wasn't changed meanwhile.  Tables aren't freed, so the copy
+// stays valid while keys are hashed and compared, which may run Python code.
+STATIC bool map_lookup_optimistic(mp_map_t *map, mp_obj_t index, mp_map_elem_t **elem, mp_uint_t *seq_out) {
+    mp_map_lock_t *lock = MAP_LOCK_FOR(map);
+    mp_uint_t seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) {
+        return false;
+    }
+    mp_map_t copy = *map;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != seq) {
+        return false;
+    }
+    *elem = map_lookup(&copy, index, MP_MAP_LOOKUP);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    *seq_out = seq;
+    return __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) == seq;
+}
+
+// Whether looking up index can neither run Python code nor raise.  Strings
+// are hashed and compared without either, so this is the case for them
+// unless the table has to grow.
+STATIC bool map_lookup_is_simple(const mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
+    if (!MP_OBJ_IS_STR(index)) {
+        return false;
+    }
+    if (lookup_kind != MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+        return true;
+    }
+    // adding must not need a new table
+    #if MICROPY_OPT_MAP_COMPACT
+    if (map->is_compact) {
+        if (map->alloc <= MAP_COMPACT_LINEAR_MAX) {
+            return map->alloc != 0 && map->table[map->alloc - 1].key == MP_OBJ_NULL;
+        }
+        return map_compact_get(map, 0) < map->alloc;
+    }
+    #endif
+    return map->used < map->alloc;
+}
+
+// Look up index in a map that isn't fixed, and store value in the slot found
+// unless it's MP_OBJ_NULL.  Plain lookups are tried without the lock first,
+// and so are keys which are there already, whose value can then be stored if
+// nothing changed before the lock was taken.  Otherwise the lookup is done
+// with the lock held and, unless it's simple, an exception handler to release
+// it.
+STATIC mp_map_elem_t *map_lookup_locked(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind, mp_obj_t value) {
+    mp_map_elem_t *elem;
+    mp_map_lock_t *lock;
+    mp_uint_t seq;
+    if (lookup_kind != MP_MAP_LOOKUP_REMOVE_IF_FOUND && map_lookup_optimistic(map, index, &elem, &seq)) {
+        if (lookup_kind == MP_MAP_LOOKUP) {
+            return elem;
+        }
+        if (elem != NULL) {
+            lock = map_lock(map);
+            if (lock->seq == seq + 1) {
+                if (value != MP_OBJ_NULL) {
+                    elem->value = value;
+                }
+                map_unlock(lock);
+                return elem;
+            }
+            map_unlock(lock);
+        }
+    }
+
+    lock = map_lock(map);
+    if (map_lookup_is_simple(map, index, lookup_kind)) {
+        elem = map_lookup(map, index, lookup_kind);
+    } else {
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) != 0) {
+            map_unlock(lock);
+            nlr_jump(nlr.ret_val);
+        }
+        elem = map_lookup(map, index, lookup_kind);
+        nlr_pop();
+    }
+    if (elem != NULL && value != MP_OBJ_NULL) {
+        elem->value = value;
+    }
+    map_unlock(lock);
+    return elem;
+}
+#endif
+
+mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
+    #if MAP_LOCKING
+    if (!map->is_fixed) {
+        return map_lookup_locked(map, index, lookup_kind, MP_OBJ_NULL);
+    }
+    #endif
+    return map_lookup(map, index, lookup_kind);
+}
+
+// Add index to the map if it's not there and set its value.  Returns the slot,
+// or NULL if the map is fixed.  Without the GIL the value is stored with the
+// map's lock held, so that it can't be lost by another thread growing the
+// table.
+mp_map_elem_t *mp_map_store(mp_map_t *map, mp_obj_t index, mp_obj_t value) {
+    #if MAP_LOCKING
+    if (!map->is_fixed) {
+        return map_lookup_locked(map, index, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND, value);
+    }
+    #endif
+    mp_map_elem_t *elem = map_lookup(map, index, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+    if (elem != NULL) {
+        elem->value = value;
+    }
+    return elem;
+}
+
 /******************************************************************************/
 /* set                                                                        */
 
@@ -302,21 +774,26 @@ void mp_set_init(mp_set_t *set, mp_uint_t n) {
     set->table = m_new0(mp_obj_t, set->alloc);
 }
 
+STATIC mp_obj_t set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t lookup_kind);
+
 STATIC void mp_set_rehash(mp_set_t *set) {
     mp_uint_t old_alloc = set->alloc;
     mp_obj_t *old_table = set->table;
-    set->alloc = get_hash_alloc_greater_or_equal_to(set->alloc + 1);
+    mp_uint_t new_alloc = get_hash_alloc_greater_or_equal_to(set->alloc + 1);
+    mp_obj_t *new_table = m_new0(mp_obj_t, new_alloc);
     set->used = 0;
-    set->table = m_new0(mp_obj_t, set->alloc);
+    set->table = new_table;
+    MAP_PUBLISH();
+    set->alloc = new_alloc;
     for (mp_uint_t i = 0; i < old_alloc; i++) {
         if (old_table[i] != MP_OBJ_NULL && old_table[i] != MP_OBJ_SENTINEL) {
-            mp_set_lookup(set, old_table[i], MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+            set_lookup(set, old_table[i], MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
         }
     }
-    m_del(mp_obj_t, old_table, old_alloc);
+    MAP_DEL_TABLE(mp_obj_t, old_table, old_alloc);
 }
 
-mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
+STATIC mp_obj_t set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
     // Note: lookup_kind can be MP_MAP_LOOKUP_ADD_IF_NOT_FOUND_OR_REMOVE_IF_FOUND which
     // is handled by using bitwise operations.
 
@@ -389,10 +866,32 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
     }
 }
 
+mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t lookup_kind) {
+    #if MAP_LOCKING
+    // hashing and comparing can run Python code, and growing can raise
+    mp_map_lock_t *lock = map_lock(set);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        map_unlock(lock);
+        nlr_jump(nlr.ret_val);
+    }
+    mp_obj_t elem = set_lookup(set, index, lookup_kind);
+    nlr_pop();
+    map_unlock(lock);
+    return elem;
+    #else
+    return set_lookup(set, index, lookup_kind);
+    #endif
+}
+
 mp_obj_t mp_set_remove_first(mp_set_t *set) {
+    #if MAP_LOCKING
+    mp_map_lock_t *lock = map_lock(set);
+    #endif
+    mp_obj_t elem = MP_OBJ_NULL;
     for (mp_uint_t pos = 0; pos < set->alloc; pos++) {
         if (MP_SET_SLOT_IS_FILLED(set, pos)) {
-            mp_obj_t elem = set->table[pos];
+            elem = set->table[pos];
             // delete element
             set->used--;
             if (set->table[(pos + 1) % set->alloc] == MP_OBJ_NULL) {
@@ -401,17 +900,27 @@ mp_obj_t mp_set_remove_first(mp_set_t *set) {
             } else {
                 set->table[pos] = MP_OBJ_SENTINEL;
             }
-            return elem;
+            break;
         }
     }
-    return MP_OBJ_NULL;
+    #if MAP_LOCKING
+    map_unlock(lock);
+    #endif
+    return elem;
 }
 
 void mp_set_clear(mp_set_t *set) {
-    m_del(mp_obj_t, set->table, set->alloc);
+    #if MAP_LOCKING
+    mp_map_lock_t *lock = map_lock(set);
+    #endif
+    MAP_DEL_TABLE(mp_obj_t, set->table, set->alloc);
     set->alloc = 0;
     set->used = 0;
+    MAP_PUBLISH();
     set->table = NULL;
+    #if MAP_LOCKING
+    map_unlock(lock);
+    #endif
 }
 
 #endif // MICROPY_PY_BUILTINS_SET
@@ -64,6 +64,22 @@ typedef unsigned int uint;
 #else
 #define m_new_obj_with_finaliser(type) m_new_obj(type)
 #endif
+// Allocations with an _ll suffix are for long-lived objects, see
+// MICROPY_GC_LONG_LIVED.  The GC zeroes those anyway, so m_new0_ll is free.
+#if MICROPY_GC_LONG_LIVED
+#define m_new_ll(type, num) ((type*)(m_malloc_ll(sizeof(type) * (num))))
+#define m_new_maybe_ll(type, num) ((type*)(m_malloc_maybe_ll(sizeof(type) * (num))))
+#define m_new0_ll(type, num) m_new_ll(type, num)
+#define m_new_obj_var_ll(obj_type, var_type, var_num) ((obj_type*)m_malloc_ll(sizeof(obj_type) + sizeof(var_type) * (var_num)))
+#define m_new_obj_var_maybe_ll(obj_type, var_type, var_num) ((obj_type*)m_malloc_maybe_ll(sizeof(obj_type) + sizeof(var_type) * (var_num)))
+#else
+#define m_new_ll(type, num) m_new(type, num)
+#define m_new_maybe_ll(type, num) m_new_maybe(type, num)
+#define m_new0_ll(type, num) m_new0(type, num)
+#define m_new_obj_var_ll(obj_type, var_type, var_num) m_new_obj_var(obj_type, var_type, var_num)
+#define m_new_obj_var_maybe_ll(obj_type, var_type, var_num) m_new_obj_var_maybe(obj_type, var_type, var_num)
+#endif
+#define m_new_obj_ll(type) (m_new_ll(type, 1))
 #if MICROPY_MALLOC_USES_ALLOCATED_SIZE
 #define m_renew(type, ptr, old_num, new_num) ((type*)(m_realloc((ptr), sizeof(type) * (old_num), sizeof(type) * (new_num))))
 #define m_renew_maybe(type, ptr, old_num, new_num, allow_move) ((type*)(m_realloc_maybe((ptr), sizeof(type) * (old_num), sizeof(type) * (new_num), (allow_move))))
@@ -81,6 +97,10 @@ void *m_malloc(size_t num_bytes);
 void *m_malloc_maybe(size_t num_bytes);
 void *m_malloc_with_finaliser(size_t num_bytes);
 void *m_malloc0(size_t num_bytes);
+#if MICROPY_GC_LONG_LIVED
+void *m_malloc_ll(size_t num_bytes);
+void *m_malloc_maybe_ll(size_t num_bytes);
+#endif
 #if MICROPY_MALLOC_USES_ALLOCATED_SIZE
 void *m_realloc(void *ptr, size_t old_num_bytes, size_t new_num_bytes);
 void *m_realloc_maybe(void *ptr, size_t old_num_bytes, size_t new_num_bytes, bool allow_move);
@@ -60,7 +60,10 @@ endif
 
 MAKE_FROZEN = ../tools/make-frozen.py
 MPY_CROSS = ../mpy-cross/mpy-cross
+MPY_CROSS_FLAGS ?=
+MPY_CROSS_JOBS ?= 4
 MPY_TOOL = ../tools/mpy-tool.py
+MPY_TOOL_FLAGS ?=
 
 all:
 .PHONY: all
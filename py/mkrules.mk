@@ -101,7 +101,7 @@ $(HEADER_BUILD):
 	$(MKDIR) -p $@
 
 ifneq ($(FROZEN_DIR),)
-$(BUILD)/frozen.c: $(wildcard $(FROZEN_DIR)/*) $(HEADER_BUILD) $(FROZEN_EXTRA_DEPS)
+$(BUILD)/frozen.c: $(wildcard $(FROZEN_DIR)/*) $(HEADER_BUILD) $(FROZEN_EXTRA_DEPS) $(MAKE_FROZEN)
 	$(ECHO) "Generating $@"
 	$(Q)$(MAKE_FROZEN) $(FROZEN_DIR) > $@
 endif
@@ -111,16 +111,27 @@ ifneq ($(FROZEN_MPY_DIR),)
 FROZEN_MPY_PY_FILES := $(notdir $(shell find -L $(FROZEN_MPY_DIR) -type f -name '*.py'))
 FROZEN_MPY_MPY_FILES := $(addprefix $(BUILD)/frozen_mpy/,$(FROZEN_MPY_PY_FILES:.py=.mpy))
 
-# to build .mpy files from .py files
-$(BUILD)/frozen_mpy/%.mpy: $(FROZEN_MPY_DIR)/%.py
-	@$(ECHO) "MPY $<"
-	$(Q)$(MKDIR) -p $(dir $@)
-	$(Q)$(MPY_CROSS) -o $@ -s $(^:$(FROZEN_MPY_DIR)/%=%) $^
+# .mpy files that don't exist yet, eg because they were deleted or their .py
+# was copied in with an old mtime; these are compiled even if the stamp is newer
+FROZEN_MPY_MISSING := $(filter-out $(wildcard $(FROZEN_MPY_MPY_FILES)),$(FROZEN_MPY_MPY_FILES))
+
+# the .py files to compile: those changed since the last run plus the missing ones
+FROZEN_MPY_STALE = $(sort $(patsubst $(FROZEN_MPY_DIR)/%,%,$(filter %.py,$?)) $(FROZEN_MPY_MISSING:$(BUILD)/frozen_mpy/%.mpy=%.py))
+
+# to build .mpy files from .py files; all out-of-date files are compiled by
+# a single mpy-cross process that shares them between MPY_CROSS_JOBS workers
+$(BUILD)/frozen_mpy.stamp: $(addprefix $(FROZEN_MPY_DIR)/,$(FROZEN_MPY_PY_FILES)) $(if $(FROZEN_MPY_MISSING),FORCE)
+	@$(ECHO) "MPY $(FROZEN_MPY_STALE)"
+	$(Q)$(MKDIR) -p $(BUILD)/frozen_mpy
+	$(Q)$(MPY_CROSS) $(MPY_CROSS_FLAGS) -j$(MPY_CROSS_JOBS) -r $(FROZEN_MPY_DIR) -d $(BUILD)/frozen_mpy $(FROZEN_MPY_STALE)
+	$(Q)touch $@
+
+$(FROZEN_MPY_MPY_FILES): $(BUILD)/frozen_mpy.stamp
 
 # to build frozen_mpy.c from all .mpy files
-$(BUILD)/frozen_mpy.c: $(FROZEN_MPY_MPY_FILES) $(BUILD)/genhdr/qstrdefs.generated.h
+$(BUILD)/frozen_mpy.c: $(FROZEN_MPY_MPY_FILES) $(BUILD)/genhdr/qstrdefs.generated.h $(MPY_TOOL)
 	@$(ECHO) "Creating $@"
-	$(Q)$(PYTHON) $(MPY_TOOL) -f -q $(BUILD)/genhdr/qstrdefs.preprocessed.h $(FROZEN_MPY_MPY_FILES) > $@
+	$(Q)$(PYTHON) $(MPY_TOOL) -f $(MPY_TOOL_FLAGS) -q $(BUILD)/genhdr/qstrdefs.preprocessed.h $(FROZEN_MPY_MPY_FILES) > $@
 endif
 
 ifneq ($(PROG),)
@@ -29,6 +29,7 @@
 
 #include "py/nlr.h"
 #include "py/smallint.h"
+#include "py/objgenerator.h"
 #include "py/objint.h"
 #include "py/objstr.h"
 #include "py/objtype.h"
@@ -53,8 +54,10 @@ STATIC mp_obj_t mp_builtin___build_class__(size_t n_args, const mp_obj_t *args)
 
     // set the new classes __locals__ object
     mp_obj_dict_t *old_locals = mp_locals_get();
-    mp_obj_t class_locals = mp_obj_new_dict(0);
-    mp_locals_set(MP_OBJ_TO_PTR(class_locals));
+    mp_obj_dict_t *class_locals_dict = mp_import_is_toplevel() ? m_new_obj_ll(mp_obj_dict_t) : m_new_obj(mp_obj_dict_t);
+    mp_obj_dict_init(class_locals_dict, 0);
+    mp_obj_t class_locals = MP_OBJ_FROM_PTR(class_locals_dict);
+    mp_locals_set(class_locals_dict);
 
     // call the class code
     mp_obj_t cell = mp_call_function_0(args[0]);
@@ -198,6 +201,9 @@ STATIC mp_obj_t mp_builtin_dir(size_t n_args, const mp_obj_t *args) {
 
     mp_obj_dict_t *dict = NULL;
     mp_map_t *members = NULL;
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    mp_obj_instance_t *values_inst = NULL;
+    #endif
     if (n_args == 0) {
         // make a list of names in the local name space
         dict = mp_locals_get();
@@ -218,7 +224,14 @@ STATIC mp_obj_t mp_builtin_dir(size_t n_args, const mp_obj_t *args) {
         }
         if (mp_obj_is_instance_type(mp_obj_get_type(args[0]))) {
             mp_obj_instance_t *inst = MP_OBJ_TO_PTR(args[0]);
+            #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+            members = inst->members;
+            if (members == NULL) {
+                values_inst = inst;
+            }
+            #else
             members = &inst->members;
+            #endif
         }
     }
 
@@ -237,6 +250,17 @@ STATIC mp_obj_t mp_builtin_dir(size_t n_args, const mp_obj_t *args) {
             }
         }
     }
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    if (values_inst != NULL) {
+        const mp_obj_t *keys = ((mp_obj_instance_type_t*)values_inst->base.type)->shared_keys;
+        mp_obj_t *values = mp_obj_instance_values(values_inst);
+        for (size_t i = 0; i < values_inst->n_values; i++) {
+            if (values[i] != MP_OBJ_NULL) {
+                mp_obj_list_append(dir, keys[i]);
+            }
+        }
+    }
+    #endif
     return dir;
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_builtin_dir_obj, 0, 1, mp_builtin_dir);
@@ -318,9 +342,13 @@ MP_DEFINE_CONST_FUN_OBJ_KW(mp_builtin_min_obj, 1, mp_builtin_min);
 #endif
 
 STATIC mp_obj_t mp_builtin_next(mp_obj_t o) {
+    if (MP_OBJ_IS_TYPE(o, &mp_type_gen_instance)) {
+        // a generator's iternext drops its return value, but next() must not
+        return mp_obj_gen_send(o, mp_const_none);
+    }
     mp_obj_t ret = mp_iternext_allow_raise(o);
     if (ret == MP_OBJ_STOP_ITERATION) {
-        nlr_raise(mp_obj_new_exception(&mp_type_StopIteration));
+        nlr_raise(MP_OBJ_FROM_PTR(&mp_const_StopIteration_obj));
     } else {
         return ret;
     }
@@ -378,7 +406,14 @@ MP_DEFINE_CONST_FUN_OBJ_1(mp_builtin_ord_obj, mp_builtin_ord);
 STATIC mp_obj_t mp_builtin_pow(size_t n_args, const mp_obj_t *args) {
     switch (n_args) {
         case 2: return mp_binary_op(MP_BINARY_OP_POWER, args[0], args[1]);
-        default: return mp_binary_op(MP_BINARY_OP_MODULO, mp_binary_op(MP_BINARY_OP_POWER, args[0], args[1]), args[2]); // TODO optimise...
+        default:
+            #if MICROPY_LONGINT_IMPL == MICROPY_LONGINT_IMPL_MPZ
+            if (MP_OBJ_IS_INT(args[0]) && MP_OBJ_IS_INT(args[1]) && MP_OBJ_IS_INT(args[2])) {
+                // modular exponentiation, without computing the full power
+                return mp_obj_int_pow3(args[0], args[1], args[2]);
+            }
+            #endif
+            return mp_binary_op(MP_BINARY_OP_MODULO, mp_binary_op(MP_BINARY_OP_POWER, args[0], args[1]), args[2]);
     }
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_builtin_pow_obj, 2, 3, mp_builtin_pow);
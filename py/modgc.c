@@ -32,17 +32,39 @@
 
 /// \module gc - control the garbage collector
 
-/// \function collect()
-/// Run a garbage collection.
-STATIC mp_obj_t py_gc_collect(void) {
+/// \function collect([generation])
+/// Run a garbage collection.  If the nursery is enabled, a generation of 0
+/// runs a minor collection that only reclaims objects in the nursery.
+STATIC mp_obj_t py_gc_collect(size_t n_args, const mp_obj_t *args) {
+    #if MICROPY_GC_NURSERY_BLOCKS
+    if (n_args > 0 && mp_obj_get_int(args[0]) == 0) {
+        gc_collect_minor();
+        #if MICROPY_PY_GC_COLLECT_RETVAL
+        return MP_OBJ_NEW_SMALL_INT(MP_STATE_MEM(gc_collected));
+        #else
+        return mp_const_none;
+        #endif
+    }
+    #else
+    (void)args;
+    #endif
+    (void)n_args;
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    // an explicit collection sweeps the whole heap straight away
+    size_t quantum = MP_STATE_MEM(gc_sweep_quantum);
+    MP_STATE_MEM(gc_sweep_quantum) = 0;
+    gc_collect();
+    MP_STATE_MEM(gc_sweep_quantum) = quantum;
+    #else
     gc_collect();
+    #endif
 #if MICROPY_PY_GC_COLLECT_RETVAL
     return MP_OBJ_NEW_SMALL_INT(MP_STATE_MEM(gc_collected));
 #else
     return mp_const_none;
 #endif
 }
-MP_DEFINE_CONST_FUN_OBJ_0(gc_collect_obj, py_gc_collect);
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_collect_obj, 0, 1, py_gc_collect);
 
 /// \function disable()
 /// Disable the garbage collector.
@@ -102,6 +124,121 @@ STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *args) {
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_threshold_obj, 0, 1, gc_threshold);
 #endif
 
+#if MICROPY_GC_STATS
+/// \function stats()
+/// Return a tuple of counters kept since boot: the number of collections,
+/// the number of those that were run because an allocation failed, the
+/// total and the longest time spent in a collection in microseconds, and
+/// the number of bytes and of objects allocated.
+STATIC mp_obj_t gc_stats_(void) {
+    gc_stats_t stats;
+    gc_stats(&stats);
+    mp_obj_t items[6] = {
+        mp_obj_new_int_from_uint(stats.collections),
+        mp_obj_new_int_from_uint(stats.alloc_collections),
+        mp_obj_new_int_from_ull(stats.pause_total),
+        mp_obj_new_int_from_uint(stats.pause_max),
+        mp_obj_new_int_from_ull(stats.alloc_bytes),
+        mp_obj_new_int_from_ull(stats.alloc_count),
+    };
+    return mp_obj_new_tuple(6, items);
+}
+MP_DEFINE_CONST_FUN_OBJ_0(gc_stats_obj, gc_stats_);
+#endif
+
+#if MICROPY_GC_INCREMENTAL_SWEEP
+/// \function incremental([blocks])
+/// Get or set the number of heap blocks swept per step after a collection.
+/// The sweep is then done in bounded steps from the VM loop, which bounds the
+/// pause the collection causes.  A value of 0 sweeps the whole heap during
+/// the collection, as does a negative value.
+STATIC mp_obj_t gc_incremental(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_int_from_uint(MP_STATE_MEM(gc_sweep_quantum));
+    }
+    mp_int_t val = mp_obj_get_int(args[0]);
+    MP_STATE_MEM(gc_sweep_quantum) = val < 0 ? 0 : val;
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_incremental_obj, 0, 1, gc_incremental);
+#endif
+
+#if MICROPY_GC_COMPACT
+/// \function compact()
+/// Run a garbage collection, then move the buffers of bytearray and array
+/// objects to lower addresses so that free memory is joined into larger
+/// blocks.  Buffers that may be referenced from C code, or that are used by
+/// a memoryview, stay where they are.  Return the number of buffers moved.
+STATIC mp_obj_t py_gc_compact(void) {
+    return MP_OBJ_NEW_SMALL_INT(gc_compact());
+}
+MP_DEFINE_CONST_FUN_OBJ_0(gc_compact_obj, py_gc_compact);
+#endif
+
+#if MICROPY_GC_ARENA
+typedef struct _mp_obj_gc_arena_t {
+    mp_obj_base_t base;
+    size_t n_bytes;
+    // allocated on entry so that the list of arenas in use can keep it alive
+    gc_arena_t *arena;
+} mp_obj_gc_arena_t;
+
+STATIC mp_obj_t gc_arena___enter__(mp_obj_t self_in) {
+    mp_obj_gc_arena_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->arena == NULL) {
+        gc_arena_t *arena = m_new_obj(gc_arena_t);
+        if (!gc_arena_enter(arena, self->n_bytes)) {
+            m_del_obj(gc_arena_t, arena);
+            m_malloc_fail(self->n_bytes);
+        }
+        self->arena = arena;
+    }
+    return self_in;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(gc_arena___enter___obj, gc_arena___enter__);
+
+STATIC mp_obj_t gc_arena___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    mp_obj_gc_arena_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (self->arena != NULL) {
+        // objects may still be referred to, so they are collected rather
+        // than all freed
+        gc_arena_exit(self->arena, true);
+        self->arena = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_arena___exit___obj, 4, 4, gc_arena___exit__);
+
+STATIC const mp_rom_map_elem_t gc_arena_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&gc_arena___enter___obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&gc_arena___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(gc_arena_locals_dict, gc_arena_locals_dict_table);
+
+STATIC const mp_obj_type_t gc_arena_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_arena,
+    .locals_dict = (mp_obj_dict_t*)&gc_arena_locals_dict,
+};
+
+/// \function arena(nbytes)
+/// Return a context manager.  Inside its with block, objects without a
+/// finaliser are allocated from one chunk of nbytes of the heap while they
+/// fit, and freeing them does nothing.  When the block is left, the chunk is
+/// collected on its own, which releases the objects that are no longer used
+/// without looking for garbage in the rest of the heap.
+STATIC mp_obj_t py_gc_arena(mp_obj_t n_bytes_in) {
+    mp_obj_gc_arena_t *o = m_new_obj(mp_obj_gc_arena_t);
+    o->base.type = &gc_arena_type;
+    o->n_bytes = mp_obj_get_int(n_bytes_in);
+    o->arena = NULL;
+    return MP_OBJ_FROM_PTR(o);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(gc_arena_obj, py_gc_arena);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_gc) },
     { MP_ROM_QSTR(MP_QSTR_collect), MP_ROM_PTR(&gc_collect_obj) },
@@ -113,6 +250,18 @@ STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     #if MICROPY_GC_ALLOC_THRESHOLD
     { MP_ROM_QSTR(MP_QSTR_threshold), MP_ROM_PTR(&gc_threshold_obj) },
     #endif
+    #if MICROPY_GC_COMPACT
+    { MP_ROM_QSTR(MP_QSTR_compact), MP_ROM_PTR(&gc_compact_obj) },
+    #endif
+    #if MICROPY_GC_ARENA
+    { MP_ROM_QSTR(MP_QSTR_arena), MP_ROM_PTR(&gc_arena_obj) },
+    #endif
+    #if MICROPY_GC_STATS
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&gc_stats_obj) },
+    #endif
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    { MP_ROM_QSTR(MP_QSTR_incremental), MP_ROM_PTR(&gc_incremental_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_gc_globals, mp_module_gc_globals_table);
@@ -25,11 +25,15 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "py/mpstate.h"
 #include "py/builtin.h"
+#include "py/runtime.h"
 #include "py/stackctrl.h"
 #include "py/gc.h"
+#include "py/mphal.h"
+#include "py/smallint.h"
 
 // Various builtins specific to MicroPython runtime,
 // living in micropython module
@@ -44,6 +48,22 @@ STATIC mp_obj_t mp_micropython_opt_level(size_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_opt_level_obj, 0, 1, mp_micropython_opt_level);
 
+#if MICROPY_EMIT_NATIVE_TIERED
+STATIC mp_obj_t mp_micropython_native_threshold(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return MP_OBJ_NEW_SMALL_INT(MP_STATE_VM(native_tier_threshold));
+    } else {
+        mp_int_t n = mp_obj_get_int(args[0]);
+        if (n < 0) {
+            mp_raise_ValueError("threshold must be >= 0");
+        }
+        MP_STATE_VM(native_tier_threshold) = n;
+        return mp_const_none;
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_native_threshold_obj, 0, 1, mp_micropython_native_threshold);
+#endif
+
 #if MICROPY_PY_MICROPYTHON_MEM_INFO
 
 #if MICROPY_MEM_STATS
@@ -87,6 +107,30 @@ mp_obj_t mp_micropython_mem_info(size_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_mem_info_obj, 0, 1, mp_micropython_mem_info);
 
+#if MICROPY_ENABLE_GC
+// Return the allocation table as bytes: "GC", the number of bytes per block
+// as 16 bits and the number of blocks as 32 bits, both little endian, then
+// one character per block as printed by mem_info(1).  Snapshots can be
+// appended to one file and read back by tools/gc_activity.py.
+STATIC mp_obj_t mp_micropython_heap_snapshot(void) {
+    size_t n_blocks = gc_snapshot(NULL, 0);
+    vstr_t vstr;
+    vstr_init_len(&vstr, 8 + n_blocks);
+    byte *buf = (byte*)vstr.buf;
+    buf[0] = 'G';
+    buf[1] = 'C';
+    buf[2] = MICROPY_BYTES_PER_GC_BLOCK & 0xff;
+    buf[3] = MICROPY_BYTES_PER_GC_BLOCK >> 8;
+    for (int i = 0; i < 4; i++) {
+        buf[4 + i] = n_blocks >> (8 * i);
+    }
+    // the bytes object itself was allocated first, so it is included
+    gc_snapshot(buf + 8, n_blocks);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_heap_snapshot_obj, mp_micropython_heap_snapshot);
+#endif
+
 STATIC mp_obj_t mp_micropython_qstr_info(size_t n_args, const mp_obj_t *args) {
     (void)args;
     size_t n_pool, n_qstr, n_str_data_bytes, n_total_bytes;
@@ -124,6 +168,167 @@ STATIC mp_obj_t mp_micropython_heap_unlock(void) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_heap_unlock_obj, mp_micropython_heap_unlock);
 #endif
 
+#if MICROPY_PY_MICROPYTHON_LIST_RESERVE
+STATIC mp_obj_t mp_micropython_list_reserve(mp_obj_t list_in, mp_obj_t n_in) {
+    if (!MP_OBJ_IS_TYPE(list_in, &mp_type_list)) {
+        mp_raise_TypeError("expecting a list");
+    }
+    mp_int_t n = mp_obj_get_int(n_in);
+    if (n < 0) {
+        mp_raise_ValueError("size must be >= 0");
+    }
+    mp_obj_list_reserve(list_in, n);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mp_micropython_list_reserve_obj, mp_micropython_list_reserve);
+#endif
+
+#if MICROPY_ENABLE_SCHEDULER
+STATIC mp_obj_t mp_micropython_schedule(mp_obj_t function, mp_obj_t arg) {
+    if (!mp_sched_schedule(function, arg)) {
+        mp_raise_msg(&mp_type_RuntimeError, "schedule queue full");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mp_micropython_schedule_obj, mp_micropython_schedule);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+STATIC mp_obj_t mp_micropython_profile(mp_obj_t period_in) {
+    mp_int_t period = mp_obj_get_int(period_in);
+    if (period < 0 || period > 0xffff) {
+        mp_raise_ValueError("period out of range");
+    }
+    mp_profile_start(period);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_micropython_profile_obj, mp_micropython_profile);
+
+STATIC mp_obj_t mp_micropython_profile_stats(void) {
+    mp_profile_entry_t *entries = m_new(mp_profile_entry_t, MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES);
+    size_t dropped;
+    size_t n = mp_profile_get(entries, &dropped);
+    mp_obj_t lines = mp_obj_new_list(n, NULL);
+    for (size_t i = 0; i < n; i++) {
+        const mp_profile_entry_t *e = &entries[i];
+        mp_obj_t line[4] = {
+            mp_obj_new_int_from_uint(e->count),
+            e->source_file == MP_QSTR_NULL ? mp_const_none : MP_OBJ_NEW_QSTR(e->source_file),
+            e->block_name == MP_QSTR_NULL ? mp_const_none : MP_OBJ_NEW_QSTR(e->block_name),
+            MP_OBJ_NEW_SMALL_INT(e->line),
+        };
+        mp_obj_list_store(lines, MP_OBJ_NEW_SMALL_INT(i), mp_obj_new_tuple(4, line));
+    }
+    m_del(mp_profile_entry_t, entries, MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES);
+    mp_obj_t ret[2] = {lines, mp_obj_new_int_from_uint(dropped)};
+    return mp_obj_new_tuple(2, ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_profile_stats_obj, mp_micropython_profile_stats);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_TRACE
+STATIC mp_obj_t mp_micropython_trace(mp_obj_t enable) {
+    mp_trace_enable(mp_obj_is_true(enable));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_micropython_trace_obj, mp_micropython_trace);
+
+STATIC mp_obj_t mp_micropython_trace_calls(void) {
+    mp_trace_entry_t *entries = m_new(mp_trace_entry_t, MICROPY_PY_MICROPYTHON_TRACE_ENTRIES);
+    size_t n = mp_trace_get(entries);
+    mp_obj_t calls = mp_obj_new_list(n, NULL);
+    for (size_t i = 0; i < n; i++) {
+        const mp_trace_entry_t *e = &entries[i];
+        mp_obj_t call[4] = {
+            MP_OBJ_NEW_QSTR(e->name),
+            mp_obj_new_int_from_uint(e->start),
+            mp_obj_new_int_from_uint(e->duration),
+            mp_obj_new_bool(e->raised),
+        };
+        mp_obj_list_store(calls, MP_OBJ_NEW_SMALL_INT(i), mp_obj_new_tuple(4, call));
+    }
+    m_del(mp_trace_entry_t, entries, MICROPY_PY_MICROPYTHON_TRACE_ENTRIES);
+    return calls;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_trace_calls_obj, mp_micropython_trace_calls);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_CYCLES
+STATIC mp_obj_t mp_micropython_cycles(void) {
+    return MP_OBJ_NEW_SMALL_INT(mp_hal_ticks_cpu() & (MICROPY_PY_UTIME_TICKS_PERIOD - 1));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_cycles_obj, mp_micropython_cycles);
+
+STATIC mp_obj_t mp_micropython_cycle_stats(size_t n_args, const mp_obj_t *args) {
+    static const qstr names[MP_CYCLES_NUM_SECTIONS] = {
+        [MP_CYCLES_GC_COLLECT] = MP_QSTR_gc_collect,
+        [MP_CYCLES_PARSE] = MP_QSTR_parse,
+        [MP_CYCLES_COMPILE] = MP_QSTR_compile,
+    };
+    // take the counts first, so that building the result isn't counted
+    mp_cycles_section_t sections[MP_CYCLES_NUM_SECTIONS];
+    memcpy(sections, MP_STATE_VM(cycles_sections), sizeof(sections));
+    if (n_args == 1 && mp_obj_is_true(args[0])) {
+        mp_cycles_reset();
+    }
+    mp_obj_t dict = mp_obj_new_dict(MP_CYCLES_NUM_SECTIONS);
+    for (size_t i = 0; i < MP_CYCLES_NUM_SECTIONS; i++) {
+        mp_obj_t stats[3] = {
+            mp_obj_new_int_from_uint(sections[i].count),
+            mp_obj_new_int_from_ull(sections[i].total),
+            mp_obj_new_int_from_uint(sections[i].max),
+        };
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(names[i]), mp_obj_new_tuple(3, stats));
+    }
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_cycle_stats_obj, 0, 1, mp_micropython_cycle_stats);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+STATIC mp_obj_t mp_micropython_opcode_stats(size_t n_args, const mp_obj_t *args) {
+    // take the counts first, so that building the result isn't counted
+    size_t *counts = m_new(size_t, 256);
+    mp_opcode_pair_t *pairs = m_new(mp_opcode_pair_t, MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS);
+    memcpy(counts, MP_STATE_VM(opcode_counts), 256 * sizeof(size_t));
+    size_t n = 0;
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS; i++) {
+        const mp_opcode_pair_t *e = &MP_STATE_VM(opcode_pairs)[i];
+        if (e->count != 0) {
+            // insertion sort, most counted first
+            size_t j = n++;
+            for (; j > 0 && pairs[j - 1].count < e->count; j--) {
+                pairs[j] = pairs[j - 1];
+            }
+            pairs[j] = *e;
+        }
+    }
+    mp_obj_t dropped = mp_obj_new_int_from_uint(MP_STATE_VM(opcode_pairs_dropped));
+    if (n_args == 1 && mp_obj_is_true(args[0])) {
+        mp_opcode_stats_reset();
+    }
+
+    mp_obj_t count_list = mp_obj_new_list(256, NULL);
+    for (size_t i = 0; i < 256; i++) {
+        mp_obj_list_store(count_list, MP_OBJ_NEW_SMALL_INT(i), mp_obj_new_int_from_uint(counts[i]));
+    }
+    mp_obj_t pair_list = mp_obj_new_list(n, NULL);
+    for (size_t i = 0; i < n; i++) {
+        mp_obj_t pair[3] = {
+            MP_OBJ_NEW_SMALL_INT(pairs[i].pair >> 8),
+            MP_OBJ_NEW_SMALL_INT(pairs[i].pair & 0xff),
+            mp_obj_new_int_from_uint(pairs[i].count),
+        };
+        mp_obj_list_store(pair_list, MP_OBJ_NEW_SMALL_INT(i), mp_obj_new_tuple(3, pair));
+    }
+    m_del(size_t, counts, 256);
+    m_del(mp_opcode_pair_t, pairs, MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS);
+    mp_obj_t ret[3] = {count_list, pair_list, dropped};
+    return mp_obj_new_tuple(3, ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_opcode_stats_obj, 0, 1, mp_micropython_opcode_stats);
+#endif
+
 #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF && (MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE == 0)
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_alloc_emergency_exception_buf_obj, mp_alloc_emergency_exception_buf);
 #endif
@@ -132,6 +337,9 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_micropython) },
     { MP_ROM_QSTR(MP_QSTR_const), MP_ROM_PTR(&mp_identity_obj) },
     { MP_ROM_QSTR(MP_QSTR_opt_level), MP_ROM_PTR(&mp_micropython_opt_level_obj) },
+#if MICROPY_EMIT_NATIVE_TIERED
+    { MP_ROM_QSTR(MP_QSTR_native_threshold), MP_ROM_PTR(&mp_micropython_native_threshold_obj) },
+#endif
 #if MICROPY_PY_MICROPYTHON_MEM_INFO
 #if MICROPY_MEM_STATS
     { MP_ROM_QSTR(MP_QSTR_mem_total), MP_ROM_PTR(&mp_micropython_mem_total_obj) },
@@ -139,6 +347,9 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_mem_peak), MP_ROM_PTR(&mp_micropython_mem_peak_obj) },
 #endif
     { MP_ROM_QSTR(MP_QSTR_mem_info), MP_ROM_PTR(&mp_micropython_mem_info_obj) },
+#if MICROPY_ENABLE_GC
+    { MP_ROM_QSTR(MP_QSTR_heap_snapshot), MP_ROM_PTR(&mp_micropython_heap_snapshot_obj) },
+#endif
     { MP_ROM_QSTR(MP_QSTR_qstr_info), MP_ROM_PTR(&mp_micropython_qstr_info_obj) },
     #if MICROPY_STACK_CHECK
     { MP_ROM_QSTR(MP_QSTR_stack_use), MP_ROM_PTR(&mp_micropython_stack_use_obj) },
@@ -147,10 +358,34 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
 #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF && (MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE == 0)
     { MP_ROM_QSTR(MP_QSTR_alloc_emergency_exception_buf), MP_ROM_PTR(&mp_alloc_emergency_exception_buf_obj) },
 #endif
+    #if MICROPY_PY_MICROPYTHON_LIST_RESERVE
+    { MP_ROM_QSTR(MP_QSTR_list_reserve), MP_ROM_PTR(&mp_micropython_list_reserve_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_RINGIO
+    { MP_ROM_QSTR(MP_QSTR_RingIO), MP_ROM_PTR(&mp_type_ringio) },
+    #endif
     #if MICROPY_ENABLE_GC
     { MP_ROM_QSTR(MP_QSTR_heap_lock), MP_ROM_PTR(&mp_micropython_heap_lock_obj) },
     { MP_ROM_QSTR(MP_QSTR_heap_unlock), MP_ROM_PTR(&mp_micropython_heap_unlock_obj) },
     #endif
+    #if MICROPY_ENABLE_SCHEDULER
+    { MP_ROM_QSTR(MP_QSTR_schedule), MP_ROM_PTR(&mp_micropython_schedule_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    { MP_ROM_QSTR(MP_QSTR_profile), MP_ROM_PTR(&mp_micropython_profile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_profile_stats), MP_ROM_PTR(&mp_micropython_profile_stats_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_TRACE
+    { MP_ROM_QSTR(MP_QSTR_trace), MP_ROM_PTR(&mp_micropython_trace_obj) },
+    { MP_ROM_QSTR(MP_QSTR_trace_calls), MP_ROM_PTR(&mp_micropython_trace_calls_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_CYCLES
+    { MP_ROM_QSTR(MP_QSTR_cycles), MP_ROM_PTR(&mp_micropython_cycles_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cycle_stats), MP_ROM_PTR(&mp_micropython_cycle_stats_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+    { MP_ROM_QSTR(MP_QSTR_opcode_stats), MP_ROM_PTR(&mp_micropython_opcode_stats_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_micropython_globals, mp_module_micropython_globals_table);
@@ -250,6 +250,234 @@ STATIC mp_obj_t struct_pack_into(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_pack_into);
 
+#if MICROPY_PY_STRUCT_STRUCT
+
+// A Struct object holds a format string parsed once into a list of ops, so
+// that packing and unpacking records with it doesn't parse the format again.
+
+typedef struct _struct_op_t {
+    char code;
+    mp_uint_t count; // repeat count, or the length for 's'
+} struct_op_t;
+
+typedef struct _mp_obj_struct_t {
+    mp_obj_base_t base;
+    mp_obj_t format;
+    char fmt_type;
+    size_t size;
+    size_t num_items;
+    size_t num_ops;
+    struct_op_t ops[];
+} mp_obj_struct_t;
+
+STATIC const mp_obj_type_t struct_type;
+
+STATIC mp_obj_t struct_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    const char *fmt = mp_obj_str_get_str(args[0]);
+    char fmt_type = get_fmt_type(&fmt);
+    mp_obj_struct_t *self = m_new_obj_var(mp_obj_struct_t, struct_op_t, strlen(fmt));
+    self->base.type = type;
+    self->format = args[0];
+    self->fmt_type = fmt_type;
+    self->size = MP_OBJ_SMALL_INT_VALUE(struct_calcsize(args[0]));
+    self->num_items = 0;
+    self->num_ops = 0;
+    for (; *fmt; fmt++) {
+        mp_uint_t cnt = 1;
+        if (unichar_isdigit(*fmt)) {
+            cnt = get_fmt_num(&fmt);
+        }
+        struct_op_t *op = &self->ops[self->num_ops++];
+        op->code = *fmt;
+        op->count = cnt;
+        self->num_items += *fmt == 's' ? 1 : cnt;
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// get a pointer to a whole record at the given offset into the buffer
+STATIC byte *struct_get_record(mp_obj_struct_t *self, mp_obj_t buf_in, mp_int_t offset, mp_uint_t flags) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, flags);
+    if (offset < 0) {
+        // negative offsets are relative to the end of the buffer
+        offset += bufinfo.len;
+    }
+    if (offset < 0 || (size_t)offset + self->size > bufinfo.len) {
+        mp_raise_ValueError("buffer too small");
+    }
+    return (byte*)bufinfo.buf + offset;
+}
+
+STATIC void struct_unpack_items(mp_obj_struct_t *self, byte *p, mp_obj_t *items) {
+    for (size_t i = 0; i < self->num_ops; i++) {
+        const struct_op_t *op = &self->ops[i];
+        if (op->code == 's') {
+            *items++ = mp_obj_new_bytes(p, op->count);
+            p += op->count;
+        } else {
+            for (mp_uint_t n = op->count; n > 0; n--) {
+                *items++ = mp_binary_get_val(self->fmt_type, op->code, &p);
+            }
+        }
+    }
+}
+
+STATIC void struct_pack_items(mp_obj_struct_t *self, byte *p, size_t n_args, const mp_obj_t *args) {
+    if (n_args != self->num_items) {
+        mp_raise_ValueError("wrong number of items");
+    }
+    for (size_t i = 0; i < self->num_ops; i++) {
+        const struct_op_t *op = &self->ops[i];
+        if (op->code == 's') {
+            mp_buffer_info_t bufinfo;
+            mp_get_buffer_raise(*args++, &bufinfo, MP_BUFFER_READ);
+            mp_uint_t to_copy = MIN(bufinfo.len, op->count);
+            memcpy(p, bufinfo.buf, to_copy);
+            memset(p + to_copy, 0, op->count - to_copy);
+            p += op->count;
+        } else {
+            for (mp_uint_t n = op->count; n > 0; n--) {
+                mp_binary_set_val(self->fmt_type, op->code, *args++, &p);
+            }
+        }
+    }
+}
+
+STATIC mp_obj_t struct_obj_pack(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    vstr_t vstr;
+    vstr_init_len(&vstr, self->size);
+    memset(vstr.buf, 0, self->size);
+    struct_pack_items(self, (byte*)vstr.buf, n_args - 1, &args[1]);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_obj_pack);
+
+STATIC mp_obj_t struct_obj_pack_into(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    byte *p = struct_get_record(self, args[1], mp_obj_get_int(args[2]), MP_BUFFER_WRITE);
+    struct_pack_items(self, p, n_args - 3, &args[3]);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_obj_pack_into);
+
+STATIC mp_obj_t struct_obj_unpack_from(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t offset = n_args > 2 ? mp_obj_get_int(args[2]) : 0;
+    byte *p = struct_get_record(self, args[1], offset, MP_BUFFER_READ);
+    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(self->num_items, NULL));
+    struct_unpack_items(self, p, res->items);
+    return MP_OBJ_FROM_PTR(res);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_unpack_from_obj, 2, 3, struct_obj_unpack_from);
+
+// unpack_into(list, buffer, offset=0) stores the items into a list of the
+// right length, so unpacking integers that fit a small int doesn't allocate
+STATIC mp_obj_t struct_obj_unpack_into(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (!MP_OBJ_IS_TYPE(args[1], &mp_type_list)) {
+        mp_raise_msg(&mp_type_TypeError, "list required");
+    }
+    mp_uint_t len;
+    mp_obj_t *items;
+    mp_obj_list_get(args[1], &len, &items);
+    if (len != self->num_items) {
+        mp_raise_ValueError("wrong number of items");
+    }
+    mp_int_t offset = n_args > 3 ? mp_obj_get_int(args[3]) : 0;
+    byte *p = struct_get_record(self, args[2], offset, MP_BUFFER_READ);
+    struct_unpack_items(self, p, items);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_unpack_into_obj, 3, 4, struct_obj_unpack_into);
+
+typedef struct _mp_obj_struct_it_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_struct_t *st;
+    mp_obj_t buf;
+    size_t offset;
+} mp_obj_struct_it_t;
+
+STATIC mp_obj_t struct_it_iternext(mp_obj_t self_in) {
+    mp_obj_struct_it_t *self = MP_OBJ_TO_PTR(self_in);
+    // the buffer is looked up each time in case its object was resized
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(self->buf, &bufinfo, MP_BUFFER_READ);
+    if (self->offset + self->st->size > bufinfo.len) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(self->st->num_items, NULL));
+    struct_unpack_items(self->st, (byte*)bufinfo.buf + self->offset, res->items);
+    self->offset += self->st->size;
+    return MP_OBJ_FROM_PTR(res);
+}
+
+STATIC mp_obj_t struct_obj_iter_unpack(mp_obj_t self_in, mp_obj_t buf_in) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    if (self->size == 0 || bufinfo.len % self->size != 0) {
+        mp_raise_ValueError("buffer size not a multiple of struct size");
+    }
+    mp_obj_struct_it_t *o = m_new_obj(mp_obj_struct_it_t);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = struct_it_iternext;
+    o->st = self;
+    o->buf = buf_in;
+    o->offset = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(struct_obj_iter_unpack_obj, struct_obj_iter_unpack);
+
+STATIC const mp_rom_map_elem_t struct_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_pack), MP_ROM_PTR(&struct_obj_pack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_obj_pack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_obj_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_obj_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack_into), MP_ROM_PTR(&struct_obj_unpack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_obj_iter_unpack_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(struct_locals_dict, struct_locals_dict_table);
+
+STATIC void struct_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(self_in);
+    if (dest[0] != MP_OBJ_NULL) {
+        // not load attribute
+        return;
+    }
+    if (attr == MP_QSTR_size) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->size);
+    } else if (attr == MP_QSTR_format) {
+        dest[0] = self->format;
+    } else {
+        mp_map_elem_t *elem = mp_map_lookup((mp_map_t*)&struct_locals_dict.map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+        if (elem != NULL) {
+            dest[0] = elem->value;
+            dest[1] = self_in;
+        }
+    }
+}
+
+STATIC const mp_obj_type_t struct_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Struct,
+    .make_new = struct_make_new,
+    .attr = struct_attr,
+    .locals_dict = (mp_obj_dict_t*)&struct_locals_dict,
+};
+
+STATIC mp_obj_t struct_iter_unpack(mp_obj_t fmt_in, mp_obj_t buf_in) {
+    mp_obj_t st = struct_make_new(&struct_type, 1, 0, &fmt_in);
+    return struct_obj_iter_unpack(st, buf_in);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(struct_iter_unpack_obj, struct_iter_unpack);
+
+#endif // MICROPY_PY_STRUCT_STRUCT
+
 STATIC const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ustruct) },
     { MP_ROM_QSTR(MP_QSTR_calcsize), MP_ROM_PTR(&struct_calcsize_obj) },
@@ -257,6 +485,10 @@ STATIC const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_pack_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_unpack_from_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_unpack_from_obj) },
+    #if MICROPY_PY_STRUCT_STRUCT
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_iter_unpack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Struct), MP_ROM_PTR(&struct_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_struct_globals, mp_module_struct_globals_table);
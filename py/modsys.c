@@ -32,6 +32,7 @@
 #include "py/objstr.h"
 #include "py/objint.h"
 #include "py/stream.h"
+#include "py/runtime.h"
 
 #if MICROPY_PY_SYS
 
@@ -145,8 +146,14 @@ MP_DEFINE_CONST_FUN_OBJ_0(mp_sys_exc_info_obj, mp_sys_exc_info);
 STATIC const mp_rom_map_elem_t mp_module_sys_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_sys) },
 
+    #if MICROPY_MULTI_INTERP
+    // filled in by mp_sys_init
+    { MP_ROM_QSTR(MP_QSTR_path), MP_ROM_PTR(&mp_const_none_obj) },
+    { MP_ROM_QSTR(MP_QSTR_argv), MP_ROM_PTR(&mp_const_none_obj) },
+    #else
     { MP_ROM_QSTR(MP_QSTR_path), MP_ROM_PTR(&MP_STATE_VM(mp_sys_path_obj)) },
     { MP_ROM_QSTR(MP_QSTR_argv), MP_ROM_PTR(&MP_STATE_VM(mp_sys_argv_obj)) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_version), MP_ROM_PTR(&version_obj) },
     { MP_ROM_QSTR(MP_QSTR_version_info), MP_ROM_PTR(&mp_sys_version_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_implementation), MP_ROM_PTR(&mp_sys_implementation_obj) },
@@ -186,8 +193,12 @@ STATIC const mp_rom_map_elem_t mp_module_sys_globals_table[] = {
     #endif
 
     #if MICROPY_PY_SYS_MODULES
+    #if MICROPY_MULTI_INTERP
+    { MP_ROM_QSTR(MP_QSTR_modules), MP_ROM_PTR(&mp_const_none_obj) },
+    #else
     { MP_ROM_QSTR(MP_QSTR_modules), MP_ROM_PTR(&MP_STATE_VM(mp_loaded_modules_dict)) },
     #endif
+    #endif
     #if MICROPY_PY_SYS_EXC_INFO
     { MP_ROM_QSTR(MP_QSTR_exc_info), MP_ROM_PTR(&mp_sys_exc_info_obj) },
     #endif
@@ -206,4 +217,24 @@ const mp_obj_module_t mp_module_sys = {
     .globals = (mp_obj_dict_t*)&mp_module_sys_globals,
 };
 
+#if MICROPY_MULTI_INTERP
+// Each interpreter has its own sys.path, sys.argv and sys.modules, so it
+// gets a sys module of its own, a copy of the one above with those set.
+void mp_sys_init(void) {
+    mp_obj_t mod = mp_obj_new_module(MP_QSTR_sys);
+    mp_obj_dict_t *dict = mp_obj_module_get_globals(mod);
+    mp_obj_t globals = MP_OBJ_FROM_PTR(dict);
+    for (size_t i = 0; i < MP_ARRAY_SIZE(mp_module_sys_globals_table); ++i) {
+        mp_obj_dict_store(globals, (mp_obj_t)mp_module_sys_globals_table[i].key, (mp_obj_t)mp_module_sys_globals_table[i].value);
+    }
+    mp_obj_dict_store(globals, MP_OBJ_NEW_QSTR(MP_QSTR_path), mp_sys_path);
+    mp_obj_dict_store(globals, MP_OBJ_NEW_QSTR(MP_QSTR_argv), mp_sys_argv);
+    #if MICROPY_PY_SYS_MODULES
+    mp_obj_dict_store(globals, MP_OBJ_NEW_QSTR(MP_QSTR_modules), MP_OBJ_FROM_PTR(&MP_STATE_VM(mp_loaded_modules_dict)));
+    #endif
+    // like the builtin module, it's read-only
+    dict->map.is_fixed = 1;
+}
+#endif
+
 #endif
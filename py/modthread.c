@@ -29,6 +29,9 @@
 
 #include "py/runtime.h"
 #include "py/stackctrl.h"
+#include "py/gc.h"
+#include "py/mphal.h"
+#include "py/mperrno.h"
 
 #if MICROPY_PY_THREAD
 
@@ -42,6 +45,47 @@
 #define DEBUG_printf(...) (void)0
 #endif
 
+#if MICROPY_PY_THREAD_GIL
+
+/****************************************************************/
+// GIL
+// A thread that fails to take the GIL straight away counts itself in
+// gil_waiting, which tells the holder to hand the GIL over at its next
+// switch point (see mp_thread_gil_switch).  gil_switches counts every
+// acquisition so the holder can tell when another thread got the GIL.
+
+void mp_thread_gil_enter(void) {
+    if (!mp_thread_mutex_lock(&MP_STATE_VM(gil_mutex), 0)) {
+        __atomic_add_fetch(&MP_STATE_VM(gil_waiting), 1, __ATOMIC_SEQ_CST);
+        mp_thread_mutex_lock(&MP_STATE_VM(gil_mutex), 1);
+        __atomic_sub_fetch(&MP_STATE_VM(gil_waiting), 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_store_n(&MP_STATE_VM(gil_switches), MP_STATE_VM(gil_switches) + 1, __ATOMIC_RELEASE);
+    MP_THREAD_UNPARK();
+}
+
+void mp_thread_gil_exit(void) {
+    // the GC can scan a thread without the GIL where it is
+    MP_THREAD_PARK();
+    mp_thread_mutex_unlock(&MP_STATE_VM(gil_mutex));
+}
+
+// Release the GIL and, if other threads are waiting for it, don't take it
+// back before one of them had it.  Otherwise the mutex is usually just
+// re-acquired by the thread that released it and waiters starve.
+void mp_thread_gil_switch(void) {
+    MP_STATE_VM(gil_ticks) = MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL;
+    mp_uint_t switches = MP_STATE_VM(gil_switches);
+    mp_thread_gil_exit();
+    while (__atomic_load_n(&MP_STATE_VM(gil_waiting), __ATOMIC_SEQ_CST) != 0
+        && __atomic_load_n(&MP_STATE_VM(gil_switches), __ATOMIC_ACQUIRE) == switches) {
+        MP_THREAD_YIELD();
+    }
+    mp_thread_gil_enter();
+}
+
+#endif // MICROPY_PY_THREAD_GIL
+
 /****************************************************************/
 // Lock object
 // Note: with the GIL enabled we can easily synthesise a lock object
@@ -79,14 +123,18 @@ STATIC mp_obj_t thread_lock_acquire(size_t n_args, const mp_obj_t *args) {
             return mp_const_false;
         }
         do {
-            MP_THREAD_GIL_EXIT();
-            MP_THREAD_GIL_ENTER();
+            mp_thread_gil_switch();
         } while (self->locked);
     }
     self->locked = true;
     return mp_const_true;
     #else
-    int ret = mp_thread_mutex_lock(&self->mutex, wait);
+    int ret = mp_thread_mutex_lock(&self->mutex, 0);
+    if (ret == 0 && wait) {
+        MP_THREAD_GIL_EXIT();
+        ret = mp_thread_mutex_lock(&self->mutex, 1);
+        MP_THREAD_GIL_ENTER();
+    }
     if (ret == 0) {
         return mp_const_false;
     } else if (ret == 1) {
@@ -138,6 +186,371 @@ STATIC const mp_obj_type_t mp_type_thread_lock = {
     .locals_dict = (mp_obj_dict_t*)&thread_lock_locals_dict,
 };
 
+#if MICROPY_PY_THREAD_SYNC
+
+/****************************************************************/
+// Condition, Event and Queue objects
+// Waiting threads block in the port's condition variables with the GIL
+// released, so they are woken straight away without polling.  A thread
+// never blocks on one of the mutexes below while holding the GIL, so a
+// thread that holds one of them can always go on to take the GIL.
+
+STATIC void thread_sync_lock(mp_thread_mutex_t *mutex) {
+    if (!mp_thread_mutex_lock(mutex, 0)) {
+        MP_THREAD_GIL_EXIT();
+        mp_thread_mutex_lock(mutex, 1);
+        MP_THREAD_GIL_ENTER();
+    }
+}
+
+// Convert a timeout in seconds, or None for no timeout, to milliseconds
+STATIC mp_int_t thread_sync_timeout(mp_obj_t timeout_in) {
+    if (timeout_in == mp_const_none) {
+        return -1;
+    }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    mp_int_t timeout_ms = mp_obj_get_float(timeout_in) * 1000;
+    #else
+    mp_int_t timeout_ms = mp_obj_get_int(timeout_in) * 1000;
+    #endif
+    return timeout_ms < 0 ? 0 : timeout_ms;
+}
+
+// Wait on cond, with its mutex held, for at most *timeout_ms or forever if
+// it's negative.  *timeout_ms is reduced by the time spent waiting and false
+// is returned once it has run out.
+STATIC bool thread_sync_wait(mp_thread_cond_t *cond, mp_thread_mutex_t *mutex, mp_int_t *timeout_ms) {
+    if (*timeout_ms == 0) {
+        return false;
+    }
+    mp_uint_t start = mp_hal_ticks_ms();
+    MP_THREAD_GIL_EXIT();
+    int ret = mp_thread_cond_wait(cond, mutex, *timeout_ms);
+    MP_THREAD_GIL_ENTER();
+    if (*timeout_ms > 0) {
+        mp_int_t elapsed = mp_hal_ticks_ms() - start;
+        *timeout_ms = elapsed >= *timeout_ms ? 0 : *timeout_ms - elapsed;
+    }
+    return ret;
+}
+
+// Condition
+
+typedef struct _mp_obj_thread_cond_t {
+    mp_obj_base_t base;
+    mp_thread_mutex_t mutex;
+    mp_thread_cond_t cond;
+    struct _mp_state_thread_t *owner;
+} mp_obj_thread_cond_t;
+
+STATIC mp_obj_t thread_cond_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    (void)args;
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+    mp_obj_thread_cond_t *self = m_new_obj(mp_obj_thread_cond_t);
+    self->base.type = type;
+    mp_thread_mutex_init(&self->mutex);
+    mp_thread_cond_init(&self->cond);
+    self->owner = NULL;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC void thread_cond_check_owner(mp_obj_thread_cond_t *self) {
+    if (self->owner != mp_thread_get_state()) {
+        mp_raise_msg(&mp_type_RuntimeError, "lock not held");
+    }
+}
+
+STATIC mp_obj_t thread_cond_acquire(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_cond_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (n_args > 1 && !mp_obj_is_true(args[1])) {
+        if (!mp_thread_mutex_lock(&self->mutex, 0)) {
+            return mp_const_false;
+        }
+    } else {
+        thread_sync_lock(&self->mutex);
+    }
+    self->owner = mp_thread_get_state();
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_cond_acquire_obj, 1, 2, thread_cond_acquire);
+
+STATIC mp_obj_t thread_cond_release(mp_obj_t self_in) {
+    mp_obj_thread_cond_t *self = MP_OBJ_TO_PTR(self_in);
+    thread_cond_check_owner(self);
+    self->owner = NULL;
+    mp_thread_mutex_unlock(&self->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_cond_release_obj, thread_cond_release);
+
+STATIC mp_obj_t thread_cond___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return thread_cond_release(args[0]);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_cond___exit___obj, 4, 4, thread_cond___exit__);
+
+STATIC mp_obj_t thread_cond_wait(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_cond_t *self = MP_OBJ_TO_PTR(args[0]);
+    thread_cond_check_owner(self);
+    mp_int_t timeout_ms = thread_sync_timeout(n_args > 1 ? args[1] : mp_const_none);
+    self->owner = NULL;
+    bool ret = thread_sync_wait(&self->cond, &self->mutex, &timeout_ms);
+    self->owner = mp_thread_get_state();
+    return mp_obj_new_bool(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_cond_wait_obj, 1, 2, thread_cond_wait);
+
+STATIC mp_obj_t thread_cond_notify(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_cond_t *self = MP_OBJ_TO_PTR(args[0]);
+    thread_cond_check_owner(self);
+    for (mp_int_t n = n_args > 1 ? mp_obj_get_int(args[1]) : 1; n > 0; --n) {
+        mp_thread_cond_signal(&self->cond);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_cond_notify_obj, 1, 2, thread_cond_notify);
+
+STATIC mp_obj_t thread_cond_notify_all(mp_obj_t self_in) {
+    mp_obj_thread_cond_t *self = MP_OBJ_TO_PTR(self_in);
+    thread_cond_check_owner(self);
+    mp_thread_cond_broadcast(&self->cond);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_cond_notify_all_obj, thread_cond_notify_all);
+
+STATIC const mp_rom_map_elem_t thread_cond_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_acquire), MP_ROM_PTR(&thread_cond_acquire_obj) },
+    { MP_ROM_QSTR(MP_QSTR_release), MP_ROM_PTR(&thread_cond_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&thread_cond_wait_obj) },
+    { MP_ROM_QSTR(MP_QSTR_notify), MP_ROM_PTR(&thread_cond_notify_obj) },
+    { MP_ROM_QSTR(MP_QSTR_notify_all), MP_ROM_PTR(&thread_cond_notify_all_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&thread_cond_acquire_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&thread_cond___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(thread_cond_locals_dict, thread_cond_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_thread_cond = {
+    { &mp_type_type },
+    .name = MP_QSTR_Condition,
+    .make_new = thread_cond_make_new,
+    .locals_dict = (mp_obj_dict_t*)&thread_cond_locals_dict,
+};
+
+// Event
+
+typedef struct _mp_obj_thread_event_t {
+    mp_obj_base_t base;
+    mp_thread_mutex_t mutex;
+    mp_thread_cond_t cond;
+    volatile bool flag;
+} mp_obj_thread_event_t;
+
+STATIC mp_obj_t thread_event_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    (void)args;
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+    mp_obj_thread_event_t *self = m_new_obj(mp_obj_thread_event_t);
+    self->base.type = type;
+    mp_thread_mutex_init(&self->mutex);
+    mp_thread_cond_init(&self->cond);
+    self->flag = false;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t thread_event_set(mp_obj_t self_in) {
+    mp_obj_thread_event_t *self = MP_OBJ_TO_PTR(self_in);
+    thread_sync_lock(&self->mutex);
+    self->flag = true;
+    mp_thread_cond_broadcast(&self->cond);
+    mp_thread_mutex_unlock(&self->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_event_set_obj, thread_event_set);
+
+STATIC mp_obj_t thread_event_clear(mp_obj_t self_in) {
+    mp_obj_thread_event_t *self = MP_OBJ_TO_PTR(self_in);
+    thread_sync_lock(&self->mutex);
+    self->flag = false;
+    mp_thread_mutex_unlock(&self->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_event_clear_obj, thread_event_clear);
+
+STATIC mp_obj_t thread_event_is_set(mp_obj_t self_in) {
+    mp_obj_thread_event_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->flag);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_event_is_set_obj, thread_event_is_set);
+
+STATIC mp_obj_t thread_event_wait(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_event_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t timeout_ms = thread_sync_timeout(n_args > 1 ? args[1] : mp_const_none);
+    thread_sync_lock(&self->mutex);
+    while (!self->flag && thread_sync_wait(&self->cond, &self->mutex, &timeout_ms)) {
+    }
+    bool flag = self->flag;
+    mp_thread_mutex_unlock(&self->mutex);
+    return mp_obj_new_bool(flag);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_event_wait_obj, 1, 2, thread_event_wait);
+
+STATIC const mp_rom_map_elem_t thread_event_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_set), MP_ROM_PTR(&thread_event_set_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&thread_event_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_is_set), MP_ROM_PTR(&thread_event_is_set_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&thread_event_wait_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(thread_event_locals_dict, thread_event_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_thread_event = {
+    { &mp_type_type },
+    .name = MP_QSTR_Event,
+    .make_new = thread_event_make_new,
+    .locals_dict = (mp_obj_dict_t*)&thread_event_locals_dict,
+};
+
+// Queue
+// The items are kept in a ring buffer which grows as needed, up to maxsize.
+
+typedef struct _mp_obj_thread_queue_t {
+    mp_obj_base_t base;
+    mp_thread_mutex_t mutex;
+    mp_thread_cond_t not_empty;
+    mp_thread_cond_t not_full;
+    size_t maxsize; // 0 if there is no limit
+    size_t alloc;
+    size_t head;
+    volatile size_t len;
+    mp_obj_t *items;
+} mp_obj_thread_queue_t;
+
+STATIC mp_obj_t thread_queue_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 1, false);
+    mp_int_t maxsize = n_args > 0 ? mp_obj_get_int(args[0]) : 0;
+    mp_obj_thread_queue_t *self = m_new_obj(mp_obj_thread_queue_t);
+    self->base.type = type;
+    mp_thread_mutex_init(&self->mutex);
+    mp_thread_cond_init(&self->not_empty);
+    mp_thread_cond_init(&self->not_full);
+    self->maxsize = maxsize < 0 ? 0 : maxsize;
+    self->alloc = self->maxsize > 0 && self->maxsize < 4 ? self->maxsize : 4;
+    self->head = 0;
+    self->len = 0;
+    self->items = m_new(mp_obj_t, self->alloc);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Grow the ring buffer when it's full, with the mutex held
+STATIC bool thread_queue_grow(mp_obj_thread_queue_t *self) {
+    size_t new_alloc = self->alloc * 2;
+    if (self->maxsize > 0 && new_alloc > self->maxsize) {
+        new_alloc = self->maxsize;
+    }
+    mp_obj_t *items = m_renew_maybe(mp_obj_t, self->items, self->alloc, new_alloc, true);
+    if (items == NULL) {
+        return false;
+    }
+    // move the items from head onwards to the end of the new space
+    size_t n_tail = self->alloc - self->head;
+    memmove(items + new_alloc - n_tail, items + self->head, n_tail * sizeof(mp_obj_t));
+    self->head += new_alloc - self->alloc;
+    self->items = items;
+    self->alloc = new_alloc;
+    return true;
+}
+
+enum { ARG_block, ARG_timeout };
+STATIC const mp_arg_t thread_queue_wait_args[] = {
+    { MP_QSTR_block, MP_ARG_BOOL, {.u_bool = true} },
+    { MP_QSTR_timeout, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_PTR(&mp_const_none_obj)} },
+};
+
+STATIC mp_obj_t thread_queue_put(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_obj_thread_queue_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(thread_queue_wait_args)];
+    mp_arg_parse_all(n_args - 2, pos_args + 2, kw_args, MP_ARRAY_SIZE(args), thread_queue_wait_args, args);
+    mp_int_t timeout_ms = args[ARG_block].u_bool ? thread_sync_timeout(args[ARG_timeout].u_obj) : 0;
+
+    thread_sync_lock(&self->mutex);
+    while (self->maxsize > 0 && self->len >= self->maxsize) {
+        if (!thread_sync_wait(&self->not_full, &self->mutex, &timeout_ms) && timeout_ms == 0) {
+            mp_thread_mutex_unlock(&self->mutex);
+            mp_raise_OSError(args[ARG_block].u_bool ? MP_ETIMEDOUT : MP_EAGAIN);
+        }
+    }
+    if (self->len == self->alloc && !thread_queue_grow(self)) {
+        mp_thread_mutex_unlock(&self->mutex);
+        m_malloc_fail(self->alloc * 2 * sizeof(mp_obj_t));
+    }
+    self->items[(self->head + self->len) % self->alloc] = pos_args[1];
+    self->len += 1;
+    mp_thread_cond_signal(&self->not_empty);
+    mp_thread_mutex_unlock(&self->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(thread_queue_put_obj, 2, thread_queue_put);
+
+STATIC mp_obj_t thread_queue_get(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_obj_thread_queue_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(thread_queue_wait_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(args), thread_queue_wait_args, args);
+    mp_int_t timeout_ms = args[ARG_block].u_bool ? thread_sync_timeout(args[ARG_timeout].u_obj) : 0;
+
+    thread_sync_lock(&self->mutex);
+    while (self->len == 0) {
+        if (!thread_sync_wait(&self->not_empty, &self->mutex, &timeout_ms) && timeout_ms == 0) {
+            mp_thread_mutex_unlock(&self->mutex);
+            mp_raise_OSError(args[ARG_block].u_bool ? MP_ETIMEDOUT : MP_EAGAIN);
+        }
+    }
+    mp_obj_t item = self->items[self->head];
+    self->items[self->head] = MP_OBJ_NULL;
+    self->head = (self->head + 1) % self->alloc;
+    self->len -= 1;
+    mp_thread_cond_signal(&self->not_full);
+    mp_thread_mutex_unlock(&self->mutex);
+    return item;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(thread_queue_get_obj, 1, thread_queue_get);
+
+STATIC mp_obj_t thread_queue_qsize(mp_obj_t self_in) {
+    mp_obj_thread_queue_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(self->len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_queue_qsize_obj, thread_queue_qsize);
+
+STATIC mp_obj_t thread_queue_empty(mp_obj_t self_in) {
+    mp_obj_thread_queue_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->len == 0);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_queue_empty_obj, thread_queue_empty);
+
+STATIC mp_obj_t thread_queue_full(mp_obj_t self_in) {
+    mp_obj_thread_queue_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->maxsize > 0 && self->len >= self->maxsize);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_queue_full_obj, thread_queue_full);
+
+STATIC const mp_rom_map_elem_t thread_queue_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_put), MP_ROM_PTR(&thread_queue_put_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get), MP_ROM_PTR(&thread_queue_get_obj) },
+    { MP_ROM_QSTR(MP_QSTR_qsize), MP_ROM_PTR(&thread_queue_qsize_obj) },
+    { MP_ROM_QSTR(MP_QSTR_empty), MP_ROM_PTR(&thread_queue_empty_obj) },
+    { MP_ROM_QSTR(MP_QSTR_full), MP_ROM_PTR(&thread_queue_full_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(thread_queue_locals_dict, thread_queue_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_thread_queue = {
+    { &mp_type_type },
+    .name = MP_QSTR_Queue,
+    .make_new = thread_queue_make_new,
+    .locals_dict = (mp_obj_dict_t*)&thread_queue_locals_dict,
+};
+
+#endif // MICROPY_PY_THREAD_SYNC
+
 /****************************************************************/
 // _thread module
 
@@ -167,16 +580,46 @@ typedef struct _thread_entry_args_t {
     mp_obj_t args[];
 } thread_entry_args_t;
 
+// Set up the state of a new thread, which is kept on its stack at ts
+STATIC void thread_init_state(mp_state_thread_t *ts, size_t stack_size) {
+    mp_thread_set_state(ts);
+
+    mp_stack_set_top(ts + 1); // need to include ts in root-pointer scan
+    mp_stack_set_limit(stack_size);
+
+    #if MICROPY_GC_PARTIAL_COLLECT
+    MP_STATE_THREAD(gc_partial_start) = 0;
+    MP_STATE_THREAD(gc_partial_end) = 0;
+    #endif
+
+    #if MICROPY_GC_ARENA
+    MP_STATE_THREAD(gc_arena) = NULL;
+    #endif
+
+    #if MICROPY_TRACK_CODE_STATE
+    MP_STATE_THREAD(cur_code_state) = NULL;
+    #endif
+
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    memset(MP_STATE_THREAD(gen_frame_pool_nbytes), 0, sizeof(MP_STATE_THREAD(gen_frame_pool_nbytes)));
+    #endif
+
+    #if MICROPY_OPT_TUPLE_POOL
+    memset(MP_STATE_THREAD(tuple_pool), 0, sizeof(MP_STATE_THREAD(tuple_pool)));
+    #endif
+
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    gc_thread_alloc_start();
+    #endif
+}
+
 STATIC void *thread_entry(void *args_in) {
     // Execution begins here for a new thread.  We do not have the GIL.
 
     thread_entry_args_t *args = (thread_entry_args_t*)args_in;
 
     mp_state_thread_t ts;
-    mp_thread_set_state(&ts);
-
-    mp_stack_set_top(&ts + 1); // need to include ts in root-pointer scan
-    mp_stack_set_limit(args->stack_size);
+    thread_init_state(&ts, args->stack_size);
 
     MP_THREAD_GIL_ENTER();
 
@@ -211,6 +654,10 @@ STATIC void *thread_entry(void *args_in) {
 
     DEBUG_printf("[thread] finish ts=%p\n", &ts);
 
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    gc_thread_alloc_finish();
+    #endif
+
     // signal that we are finished
     mp_thread_finish();
 
@@ -270,6 +717,295 @@ STATIC mp_obj_t mod_thread_start_new_thread(size_t n_args, const mp_obj_t *args)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_start_new_thread_obj, 2, 3, mod_thread_start_new_thread);
 
+#if MICROPY_PY_THREAD_POOL
+
+/****************************************************************/
+// Pool and Future objects
+// A pool keeps a number of worker threads, and their thread state, running
+// for as long as it's open.  Submitted calls are queued as futures in a
+// linked list and each worker takes the next one as soon as it's free.  All
+// of the futures of a pool share its mutex and its done condition, which is
+// signalled whenever a call finishes.
+
+#define THREAD_FUTURE_PENDING (0)
+#define THREAD_FUTURE_RUNNING (1)
+#define THREAD_FUTURE_DONE (2)
+#define THREAD_FUTURE_ERROR (3)
+
+typedef struct _mp_obj_thread_pool_t {
+    mp_obj_base_t base;
+    mp_thread_mutex_t mutex;
+    mp_thread_cond_t not_empty;
+    mp_thread_cond_t done;
+    struct _mp_obj_thread_future_t *head;
+    struct _mp_obj_thread_future_t *tail;
+    size_t stack_size;
+    volatile size_t n_workers;
+    volatile bool shutdown;
+} mp_obj_thread_pool_t;
+
+typedef struct _mp_obj_thread_future_t {
+    mp_obj_base_t base;
+    mp_obj_thread_pool_t *pool;
+    struct _mp_obj_thread_future_t *next;
+    volatile uint8_t state;
+    // the result or exception once done
+    mp_obj_t value;
+    // the call to make, cleared once made
+    mp_obj_t fun;
+    size_t n_args;
+    size_t n_kw;
+    mp_obj_t *args;
+} mp_obj_thread_future_t;
+
+STATIC const mp_obj_type_t mp_type_thread_future;
+
+STATIC void *thread_pool_worker(void *pool_in) {
+    // Execution begins here for a worker.  We do not have the GIL.
+
+    mp_obj_thread_pool_t *pool = pool_in;
+
+    // the stack size is only known once the pool has started all workers
+    mp_thread_mutex_lock(&pool->mutex, 1);
+    size_t stack_size = pool->stack_size;
+    mp_thread_mutex_unlock(&pool->mutex);
+
+    mp_state_thread_t ts;
+    thread_init_state(&ts, stack_size);
+
+    MP_THREAD_GIL_ENTER();
+
+    // signal that we are set up and running
+    mp_thread_start();
+
+    DEBUG_printf("[thread] worker start ts=%p pool=%p\n", &ts, pool);
+
+    thread_sync_lock(&pool->mutex);
+    for (;;) {
+        mp_int_t timeout_ms = -1;
+        while (pool->head == NULL && !pool->shutdown) {
+            thread_sync_wait(&pool->not_empty, &pool->mutex, &timeout_ms);
+        }
+        mp_obj_thread_future_t *future = pool->head;
+        if (future == NULL) {
+            // shut down and nothing left to do
+            break;
+        }
+        pool->head = future->next;
+        future->next = NULL;
+        future->state = THREAD_FUTURE_RUNNING;
+        mp_thread_mutex_unlock(&pool->mutex);
+
+        uint8_t state;
+        mp_obj_t value;
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            value = mp_call_function_n_kw(future->fun, future->n_args, future->n_kw, future->args);
+            nlr_pop();
+            state = THREAD_FUTURE_DONE;
+        } else {
+            value = MP_OBJ_FROM_PTR(nlr.ret_val);
+            state = THREAD_FUTURE_ERROR;
+        }
+
+        thread_sync_lock(&pool->mutex);
+        future->value = value;
+        future->state = state;
+        future->fun = MP_OBJ_NULL;
+        future->args = NULL;
+        mp_thread_cond_broadcast(&pool->done);
+    }
+    pool->n_workers -= 1;
+    mp_thread_cond_broadcast(&pool->done);
+    mp_thread_mutex_unlock(&pool->mutex);
+
+    DEBUG_printf("[thread] worker finish ts=%p\n", &ts);
+
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    gc_thread_alloc_finish();
+    #endif
+
+    // signal that we are finished
+    mp_thread_finish();
+
+    MP_THREAD_GIL_EXIT();
+
+    return NULL;
+}
+
+STATIC mp_obj_t thread_pool_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 1, false);
+    mp_int_t n_workers = n_args > 0 ? mp_obj_get_int(args[0]) : 4;
+    if (n_workers < 1) {
+        mp_raise_ValueError("need at least one worker");
+    }
+    mp_obj_thread_pool_t *self = m_new_obj(mp_obj_thread_pool_t);
+    self->base.type = type;
+    mp_thread_mutex_init(&self->mutex);
+    mp_thread_cond_init(&self->not_empty);
+    mp_thread_cond_init(&self->done);
+    self->head = NULL;
+    self->tail = NULL;
+    self->stack_size = thread_stack_size;
+    self->n_workers = 0;
+    self->shutdown = false;
+
+    // the workers wait for the mutex before reading stack_size, which the
+    // port may adjust when creating a thread
+    mp_thread_mutex_lock(&self->mutex, 1);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        for (mp_int_t i = 0; i < n_workers; i++) {
+            size_t stack_size = thread_stack_size;
+            mp_thread_create(thread_pool_worker, self, &stack_size);
+            self->stack_size = stack_size;
+            self->n_workers += 1;
+        }
+        nlr_pop();
+    } else {
+        // let the workers that did start exit straight away
+        self->shutdown = true;
+        mp_thread_mutex_unlock(&self->mutex);
+        nlr_jump(nlr.ret_val);
+    }
+    mp_thread_mutex_unlock(&self->mutex);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t thread_pool_submit(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
+    mp_obj_thread_pool_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    // keep a copy of the positional and keyword arguments for the call
+    size_t n_pos = n_args - 2;
+    size_t n_kw = kw_args->used;
+    mp_obj_thread_future_t *future = m_new_obj(mp_obj_thread_future_t);
+    future->base.type = &mp_type_thread_future;
+    future->pool = self;
+    future->next = NULL;
+    future->state = THREAD_FUTURE_PENDING;
+    future->value = mp_const_none;
+    future->fun = args[1];
+    future->n_args = n_pos;
+    future->n_kw = n_kw;
+    future->args = m_new(mp_obj_t, n_pos + 2 * n_kw);
+    memcpy(future->args, args + 2, n_pos * sizeof(mp_obj_t));
+    for (size_t i = 0, n = n_pos; i < kw_args->alloc; ++i) {
+        if (MP_MAP_SLOT_IS_FILLED(kw_args, i)) {
+            future->args[n++] = kw_args->table[i].key;
+            future->args[n++] = kw_args->table[i].value;
+        }
+    }
+
+    thread_sync_lock(&self->mutex);
+    if (self->shutdown) {
+        mp_thread_mutex_unlock(&self->mutex);
+        mp_raise_msg(&mp_type_RuntimeError, "pool is shut down");
+    }
+    if (self->head == NULL) {
+        self->head = future;
+    } else {
+        self->tail->next = future;
+    }
+    self->tail = future;
+    mp_thread_cond_signal(&self->not_empty);
+    mp_thread_mutex_unlock(&self->mutex);
+    return MP_OBJ_FROM_PTR(future);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(thread_pool_submit_obj, 2, thread_pool_submit);
+
+STATIC mp_obj_t thread_pool_shutdown(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_pool_t *self = MP_OBJ_TO_PTR(args[0]);
+    bool wait = n_args < 2 || mp_obj_is_true(args[1]);
+    thread_sync_lock(&self->mutex);
+    self->shutdown = true;
+    mp_thread_cond_broadcast(&self->not_empty);
+    mp_int_t timeout_ms = -1;
+    while (wait && self->n_workers > 0) {
+        thread_sync_wait(&self->done, &self->mutex, &timeout_ms);
+    }
+    mp_thread_mutex_unlock(&self->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_pool_shutdown_obj, 1, 2, thread_pool_shutdown);
+
+STATIC mp_obj_t thread_pool___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return thread_pool_shutdown(1, args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_pool___exit___obj, 4, 4, thread_pool___exit__);
+
+STATIC const mp_rom_map_elem_t thread_pool_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_submit), MP_ROM_PTR(&thread_pool_submit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_shutdown), MP_ROM_PTR(&thread_pool_shutdown_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&mp_identity_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&thread_pool___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(thread_pool_locals_dict, thread_pool_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_thread_pool = {
+    { &mp_type_type },
+    .name = MP_QSTR_Pool,
+    .make_new = thread_pool_make_new,
+    .locals_dict = (mp_obj_dict_t*)&thread_pool_locals_dict,
+};
+
+// Wait for the future to finish, raising ETIMEDOUT if it doesn't in time
+STATIC void thread_future_wait(mp_obj_thread_future_t *self, mp_obj_t timeout_in) {
+    mp_int_t timeout_ms = thread_sync_timeout(timeout_in);
+    mp_obj_thread_pool_t *pool = self->pool;
+    thread_sync_lock(&pool->mutex);
+    while (self->state < THREAD_FUTURE_DONE) {
+        if (!thread_sync_wait(&pool->done, &pool->mutex, &timeout_ms) && timeout_ms == 0) {
+            mp_thread_mutex_unlock(&pool->mutex);
+            mp_raise_OSError(MP_ETIMEDOUT);
+        }
+    }
+    mp_thread_mutex_unlock(&pool->mutex);
+}
+
+STATIC mp_obj_t thread_future_result(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_future_t *self = MP_OBJ_TO_PTR(args[0]);
+    thread_future_wait(self, n_args > 1 ? args[1] : mp_const_none);
+    if (self->state == THREAD_FUTURE_ERROR) {
+        nlr_raise(self->value);
+    }
+    return self->value;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_future_result_obj, 1, 2, thread_future_result);
+
+STATIC mp_obj_t thread_future_exception(size_t n_args, const mp_obj_t *args) {
+    mp_obj_thread_future_t *self = MP_OBJ_TO_PTR(args[0]);
+    thread_future_wait(self, n_args > 1 ? args[1] : mp_const_none);
+    if (self->state == THREAD_FUTURE_ERROR) {
+        return self->value;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_future_exception_obj, 1, 2, thread_future_exception);
+
+STATIC mp_obj_t thread_future_done(mp_obj_t self_in) {
+    mp_obj_thread_future_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->state >= THREAD_FUTURE_DONE);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_future_done_obj, thread_future_done);
+
+STATIC const mp_rom_map_elem_t thread_future_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_result), MP_ROM_PTR(&thread_future_result_obj) },
+    { MP_ROM_QSTR(MP_QSTR_exception), MP_ROM_PTR(&thread_future_exception_obj) },
+    { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&thread_future_done_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(thread_future_locals_dict, thread_future_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_thread_future = {
+    { &mp_type_type },
+    .name = MP_QSTR_Future,
+    .locals_dict = (mp_obj_dict_t*)&thread_future_locals_dict,
+};
+
+#endif // MICROPY_PY_THREAD_POOL
+
 STATIC mp_obj_t mod_thread_exit(void) {
     nlr_raise(mp_obj_new_exception(&mp_type_SystemExit));
 }
@@ -288,6 +1024,14 @@ STATIC const mp_rom_map_elem_t mp_module_thread_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_start_new_thread), MP_ROM_PTR(&mod_thread_start_new_thread_obj) },
     { MP_ROM_QSTR(MP_QSTR_exit), MP_ROM_PTR(&mod_thread_exit_obj) },
     { MP_ROM_QSTR(MP_QSTR_allocate_lock), MP_ROM_PTR(&mod_thread_allocate_lock_obj) },
+    #if MICROPY_PY_THREAD_SYNC
+    { MP_ROM_QSTR(MP_QSTR_Condition), MP_ROM_PTR(&mp_type_thread_cond) },
+    { MP_ROM_QSTR(MP_QSTR_Event), MP_ROM_PTR(&mp_type_thread_event) },
+    { MP_ROM_QSTR(MP_QSTR_Queue), MP_ROM_PTR(&mp_type_thread_queue) },
+    #endif
+    #if MICROPY_PY_THREAD_POOL
+    { MP_ROM_QSTR(MP_QSTR_Pool), MP_ROM_PTR(&mp_type_thread_pool) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_thread_globals, mp_module_thread_globals_table);
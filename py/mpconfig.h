@@ -117,6 +117,94 @@
 #define MICROPY_GC_CONSERVATIVE_CLEAR (MICROPY_ENABLE_GC)
 #endif
 
+// Number of size classes for which the GC keeps an index of the first ATB
+// that may contain a free run of that many blocks.  Allocations of up to this
+// many blocks then start their search at the first possible fit instead of
+// rescanning the used part of the heap.  The index costs one word per class.
+// A value of 1 gives the classic behaviour of a single free-block cursor.
+#ifndef MICROPY_GC_FREE_INDEX_CLASSES
+#define MICROPY_GC_FREE_INDEX_CLASSES (1)
+#endif
+
+// Whether the sweep phase of a collection can be deferred and done in bounded
+// steps from the VM loop, instead of sweeping the whole heap before returning
+// from the collection.  An allocation that finds no free blocks while a sweep
+// is pending sweeps on demand, one step at a time, until it finds a fit.  The
+// number of blocks swept per step bounds the pause and is configurable by
+// gc.incremental().
+#ifndef MICROPY_GC_INCREMENTAL_SWEEP
+#define MICROPY_GC_INCREMENTAL_SWEEP (0)
+#endif
+
+// Default number of blocks swept per step of an incremental sweep; 0 means
+// sweep the whole heap during the collection.
+#ifndef MICROPY_GC_SWEEP_QUANTUM
+#define MICROPY_GC_SWEEP_QUANTUM (256)
+#endif
+
+// Number of blocks in the region of the heap that each thread reserves to
+// allocate small objects from without taking the GC mutex; 0 disables it.
+// Only useful with threads and no GIL, and requires the GCC atomic builtins.
+#ifndef MICROPY_GC_THREAD_ALLOC_BLOCKS
+#define MICROPY_GC_THREAD_ALLOC_BLOCKS (0)
+#endif
+
+// Whether gc_collect_root can be called by several threads at once during
+// a collection, so that threads can mark from their own stack in parallel.
+// Requires the GCC atomic builtins.
+#ifndef MICROPY_GC_PARALLEL_MARK
+#define MICROPY_GC_PARALLEL_MARK (0)
+#endif
+
+// Number of blocks at the end of the heap that form the nursery, where small
+// objects are allocated, and which minor collections reclaim without tracing
+// the rest of the heap; 0 disables it.
+#ifndef MICROPY_GC_NURSERY_BLOCKS
+#define MICROPY_GC_NURSERY_BLOCKS (0)
+#endif
+
+// Whether to support arenas: while an arena is in use by a thread, the small
+// objects it allocates come from one chunk of the heap, which is released in
+// one go when the arena is done with.
+#ifndef MICROPY_GC_ARENA
+#define MICROPY_GC_ARENA (0)
+#endif
+
+// Whether objects expected to live as long as the program, such as modules,
+// compiled code and qstr data, are allocated from the top of the heap downward
+// (below the nursery, if any).  This keeps them out of the way of short-lived
+// objects, which fill the heap from the bottom, so that the free memory left
+// after importing is in fewer, larger pieces.
+#ifndef MICROPY_GC_LONG_LIVED
+#define MICROPY_GC_LONG_LIVED (0)
+#endif
+
+// Collections of only a part of the heap are used by the nursery and arenas
+#define MICROPY_GC_PARTIAL_COLLECT (MICROPY_GC_NURSERY_BLOCKS || MICROPY_GC_ARENA)
+
+// Whether to sample heap allocations into a ring buffer of this many entries,
+// recording the function and bytecode offset they came from, their size and
+// how long they lived.
+#ifndef MICROPY_GC_ALLOC_PROFILE
+#define MICROPY_GC_ALLOC_PROFILE (0)
+#endif
+#ifndef MICROPY_GC_ALLOC_PROFILE_ENTRIES
+#define MICROPY_GC_ALLOC_PROFILE_ENTRIES (32)
+#endif
+
+// Whether to count collections, their pause times and the allocations made,
+// for gc.stats().  Needs mp_hal_ticks_us.
+#ifndef MICROPY_GC_STATS
+#define MICROPY_GC_STATS (0)
+#endif
+
+// Whether to provide gc_compact, which moves the buffers of bytearray and
+// array objects down the heap to join up free memory.  Not available with
+// threads unless the GIL is used.
+#ifndef MICROPY_GC_COMPACT
+#define MICROPY_GC_COMPACT (0)
+#endif
+
 // Support automatic GC when reaching allocation threshold,
 // configurable by gc.threshold().
 #ifndef MICROPY_GC_ALLOC_THRESHOLD
@@ -211,6 +299,13 @@
 #define MICROPY_QSTR_BYTES_IN_HASH (2)
 #endif
 
+// Whether to find qstrs through hash tables instead of searching the pools:
+// one generated in ROM for the qstrs built into the firmware, and one on the
+// heap for all other qstrs, which costs 2 words of RAM per qstr
+#ifndef MICROPY_QSTR_HASH_TABLE
+#define MICROPY_QSTR_HASH_TABLE (0)
+#endif
+
 // Avoid using C stack when making Python function calls. C stack still
 // may be used if there's no free heap.
 #ifndef MICROPY_STACKLESS
@@ -247,12 +342,33 @@
 #define MICROPY_PERSISTENT_CODE_SAVE (0)
 #endif
 
+// Whether persistent code in memory-mapped storage can be loaded so that its
+// bytecode is run from where it is rather than copied to the heap; see
+// mp_raw_code_load_xip(). Can't be used with bytecode that caches map lookups.
+#ifndef MICROPY_PERSISTENT_CODE_LOAD_XIP
+#define MICROPY_PERSISTENT_CODE_LOAD_XIP (0)
+#endif
+
+// Whether imported source files are compiled once and their bytecode kept
+// by the port for later imports. The port must provide mp_code_cache_load()
+// and mp_code_cache_store(); see py/emitglue.h.
+#ifndef MICROPY_PERSISTENT_CODE_CACHE
+#define MICROPY_PERSISTENT_CODE_CACHE (0)
+#endif
+
 // Whether generated code can persist independently of the VM/runtime instance
 // This is enabled automatically when needed by other features
 #ifndef MICROPY_PERSISTENT_CODE
 #define MICROPY_PERSISTENT_CODE (MICROPY_PERSISTENT_CODE_LOAD || MICROPY_PERSISTENT_CODE_SAVE || MICROPY_MODULE_FROZEN_MPY)
 #endif
 
+// Whether the bytecode emitter works out the stack and code size of a function
+// while emitting it, into buffers that grow as needed, so the compiler walks
+// each function twice (scope and emit) rather than four times
+#ifndef MICROPY_EMIT_BC_ONE_PASS
+#define MICROPY_EMIT_BC_ONE_PASS (0)
+#endif
+
 // Whether to emit x64 native code
 #ifndef MICROPY_EMIT_X64
 #define MICROPY_EMIT_X64 (0)
@@ -283,6 +399,12 @@
 #define MICROPY_EMIT_INLINE_THUMB_FLOAT (1)
 #endif
 
+// Whether to enable the ARMv7E-M DSP instructions (Cortex-M4 and up) in the
+// Thumb2 inline assembler
+#ifndef MICROPY_EMIT_INLINE_THUMB_DSP
+#define MICROPY_EMIT_INLINE_THUMB_DSP (MICROPY_EMIT_INLINE_THUMB_ARMV7M)
+#endif
+
 // Whether to emit ARM native code
 #ifndef MICROPY_EMIT_ARM
 #define MICROPY_EMIT_ARM (0)
@@ -291,6 +413,16 @@
 // Convenience definition for whether any native emitter is enabled
 #define MICROPY_EMIT_NATIVE (MICROPY_EMIT_X64 || MICROPY_EMIT_X86 || MICROPY_EMIT_THUMB || MICROPY_EMIT_ARM)
 
+// Whether bytecode functions count their calls and, once the count reaches
+// micropython.native_threshold(), are recompiled with the native emitter.
+// While a threshold is set the compiler keeps the parse tree and scopes of
+// everything it compiles, which costs a lot of RAM.  Promoted functions act
+// like @micropython.native ones: they don't show in tracebacks and reading an
+// unbound local isn't caught.  Needs a native emitter.
+#ifndef MICROPY_EMIT_NATIVE_TIERED
+#define MICROPY_EMIT_NATIVE_TIERED (0)
+#endif
+
 /*****************************************************************************/
 /* Compiler configuration                                                    */
 
@@ -307,9 +439,11 @@
 // Configure dynamic compiler macros
 #if MICROPY_DYNAMIC_COMPILER
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC (mp_dynamic_compiler.opt_cache_map_lookup_in_bytecode)
+#define MICROPY_OPT_SUPERINSTRUCTIONS_DYNAMIC (mp_dynamic_compiler.opt_superinstructions)
 #define MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC (mp_dynamic_compiler.py_builtins_str_unicode)
 #else
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+#define MICROPY_OPT_SUPERINSTRUCTIONS_DYNAMIC MICROPY_OPT_SUPERINSTRUCTIONS
 #define MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC MICROPY_PY_BUILTINS_STR_UNICODE
 #endif
 
@@ -323,11 +457,32 @@
 #define MICROPY_COMP_MODULE_CONST (0)
 #endif
 
+// Whether to parse, compile and execute files one top-level statement at a
+// time, so the memory needed is bounded by the largest statement rather than
+// the whole file. A syntax error is then only raised once the statements
+// before it have run.
+#ifndef MICROPY_COMP_INCREMENTAL
+#define MICROPY_COMP_INCREMENTAL (0)
+#endif
+
 // Whether to enable constant optimisation; id = const(value)
 #ifndef MICROPY_COMP_CONST
 #define MICROPY_COMP_CONST (1)
 #endif
 
+// Whether to fold parenthesised tuples of constants into a constant object;
+// eg (1, 'a', None).  Such objects can't be saved to a .mpy file.
+#ifndef MICROPY_COMP_CONST_TUPLE
+#define MICROPY_COMP_CONST_TUPLE (MICROPY_COMP_CONST_FOLDING && !MICROPY_PERSISTENT_CODE_SAVE)
+#endif
+
+// Whether a variable closed over by an inner function, lambda or
+// comprehension is passed to it by value rather than in a cell, when the
+// variable is bound only once, before any closure over it is made
+#ifndef MICROPY_COMP_CLOSURE_BY_VALUE
+#define MICROPY_COMP_CLOSURE_BY_VALUE (1)
+#endif
+
 // Whether to enable optimisation of: a, b = c, d
 // Costs 124 bytes (Thumb2)
 #ifndef MICROPY_COMP_DOUBLE_TUPLE_ASSIGN
@@ -372,15 +527,129 @@
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #endif
 
+// Otherwise, whether to cache the same lookups, and those of LOAD_METHOD on
+// modules, in a table in RAM indexed by the address of the opcode.  This works
+// with bytecode that can't be written to, such as frozen or persistent code.
+// Uses this many bytes of RAM.
+#ifndef MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE
+#define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE (0)
+#endif
+
+// Whether the bytecode emitter fuses common pairs of opcodes into single
+// opcodes (eg two LOAD_FASTs, or a small-int constant and a BINARY_OP), and
+// the VM runs them along with fast paths for small-int add, subtract and
+// compare.  Uses a bit of extra code ROM but saves dispatches in hot loops.
+#ifndef MICROPY_OPT_SUPERINSTRUCTIONS
+#define MICROPY_OPT_SUPERINSTRUCTIONS (0)
+#endif
+
+// Whether the VM rewrites BINARY_OP and LOAD_ATTR opcodes in bytecode that
+// lives in the GC heap into variants specialised for the types they last saw
+// (small ints, instance members), reverting them when that guess fails.
+// LOAD_ATTR is only specialised if one of the map lookup caches is enabled.
+#ifndef MICROPY_OPT_QUICKENING
+#define MICROPY_OPT_QUICKENING (0)
+#endif
+
+// Whether to remember where recently looked up keys were found in ordered
+// maps, such as the locals dicts of built-in types and modules, so that the
+// linear search can be skipped.  Uses this many bytes of RAM.
+#ifndef MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE
+#define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (0)
+#endif
+
+// Whether to remember where recent searches of the hierarchy of a Python
+// class for an attribute (a method, or a special method such as __add__)
+// ended, so that repeated calls don't walk the bases and their locals dicts.
+// Uses this many entries of 5 words of RAM each.
+#ifndef MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+#define MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE (0)
+#endif
+
+// Whether hash maps (dicts, instance members, module globals) store their
+// entries densely in insertion order with a separate small array of 1-4 byte
+// indices for the hash lookup, instead of as an open-addressed table of
+// key/value pairs.  Uses less RAM per map and iterates in insertion order.
+#ifndef MICROPY_OPT_MAP_COMPACT
+#define MICROPY_OPT_MAP_COMPACT (0)
+#endif
+
+// Whether instances of user classes store their attributes in an array of
+// values inside the instance, indexed like a table of attribute names kept by
+// the class and shared by all its instances, instead of in a map of their
+// own.  Instances fall back to a map if they set attributes in a different
+// order.  Roughly halves the RAM used by instances with a few attributes.
+#ifndef MICROPY_OPT_INSTANCE_SHARED_KEYS
+#define MICROPY_OPT_INSTANCE_SHARED_KEYS (0)
+#endif
+
+// Whether str/bytes searches (find, replace, count, split, in, ...) use the
+// Boyer-Moore-Horspool algorithm for longer needles in longer haystacks,
+// instead of checking each position in turn.  Uses 256 bytes of C stack
+// during such a search.
+#ifndef MICROPY_OPT_STR_SEARCH_HORSPOOL
+#define MICROPY_OPT_STR_SEARCH_HORSPOOL (0)
+#endif
+
+// Slices of str/bytes objects at least this many bytes long refer to the data
+// of the object they were taken from instead of copying it, keeping that data
+// alive for as long as they do.  Such a slice is copied to a null-terminated
+// buffer if it's ever needed as a C string.  Requires the GC; 0 disables it.
+#ifndef MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN
+#define MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN (0)
+#endif
+
+// Whether indexing a str with unicode support remembers where it got to in
+// the str last indexed, so that a loop over a str by index takes O(n) time
+// rather than O(n^2), and an all-ASCII str whose len() was taken indexes in
+// O(1). Costs a few words of state.
+#ifndef MICROPY_OPT_STR_INDEX_CACHE
+#define MICROPY_OPT_STR_INDEX_CACHE (0)
+#endif
+
+// How many frames of finished generators each thread keeps, to be reused by
+// new generators that need a frame of the same size, so that running a
+// generator expression in a loop doesn't allocate its frame every time.  The
+// frame is then allocated apart from the generator object.  0 disables it.
+#ifndef MICROPY_OPT_GEN_FRAME_POOL
+#define MICROPY_OPT_GEN_FRAME_POOL (0)
+#endif
+
+// Up to what length each thread keeps a tuple of each length for reuse, once
+// it is known to be dead.  The VM knows this when a for loop unpacks the
+// tuples made by enumerate(), zip() or dict.items(), so such a loop doesn't
+// allocate a tuple on each pass.  0 disables it.
+#ifndef MICROPY_OPT_TUPLE_POOL
+#define MICROPY_OPT_TUPLE_POOL (0)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
 #define MICROPY_OPT_MPZ_BITWISE (0)
 #endif
 
+// Whether to multiply big mpz integers by Karatsuba's method, which is much
+// faster than the schoolbook method for numbers of more than about a thousand
+// bits.  Increases code size a little and allocates temporary digits.
+#ifndef MICROPY_OPT_MPZ_KARATSUBA
+#define MICROPY_OPT_MPZ_KARATSUBA (0)
+#endif
+
 /*****************************************************************************/
 /* Python internal features                                                  */
 
+// Whether to provide the scheduler, which lets interrupt handlers queue up
+// Python functions for the VM to call soon after, see scheduler.c
+#ifndef MICROPY_ENABLE_SCHEDULER
+#define MICROPY_ENABLE_SCHEDULER (0)
+#endif
+
+// Number of functions that can be waiting to be run by the scheduler
+#ifndef MICROPY_SCHEDULER_DEPTH
+#define MICROPY_SCHEDULER_DEPTH (4)
+#endif
+
 // Hook for the VM at the start of the opcode loop (can contain variable
 // definitions usable by the other hook functions)
 #ifndef MICROPY_VM_HOOK_INIT
@@ -449,6 +718,13 @@
 #define MICROPY_REPL_EVENT_DRIVEN (0)
 #endif
 
+// Flow-control window in bytes for the raw REPL's raw-paste mode, or 0 to
+// disable raw-paste mode.  The host never has more than this many bytes in
+// flight, so it must fit in the port's stdin receive buffer.
+#ifndef MICROPY_REPL_RAW_PASTE_WINDOW
+#define MICROPY_REPL_RAW_PASTE_WINDOW (256)
+#endif
+
 // Whether to include lexer helper function for unix
 #ifndef MICROPY_HELPER_LEXER_UNIX
 #define MICROPY_HELPER_LEXER_UNIX (0)
@@ -503,6 +779,15 @@ typedef long long mp_longint_impl_t;
 #define MICROPY_FLOAT_IMPL (MICROPY_FLOAT_IMPL_NONE)
 #endif
 
+// Whether repr() and str() of a float give the fewest digits that read back
+// as the same float, like CPython, rather than rounding to 7 (single
+// precision) or 16 (double precision) significant digits.  This is found
+// with integer arithmetic only, which is also faster where floats are done
+// in software.  Costs about 1k of code, and 1k of tables with doubles.
+#ifndef MICROPY_FLOAT_REPR_SHORTEST
+#define MICROPY_FLOAT_REPR_SHORTEST (0)
+#endif
+
 #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
 #define MICROPY_PY_BUILTINS_FLOAT (1)
 #define MICROPY_FLOAT_CONST(x) x##F
@@ -560,9 +845,16 @@ typedef double mp_float_t;
 #define MICROPY_MODULE_FROZEN_MPY (0)
 #endif
 
+// Whether frozen modules are supported in the form of a bundle made by
+// tools/mpy-tool.py --bundle, which the port maps at runtime with
+// mp_frozen_bundle_mount(). Needs MICROPY_PERSISTENT_CODE_LOAD.
+#ifndef MICROPY_MODULE_FROZEN_BUNDLE
+#define MICROPY_MODULE_FROZEN_BUNDLE (0)
+#endif
+
 // Convenience macro for whether frozen modules are supported
 #ifndef MICROPY_MODULE_FROZEN
-#define MICROPY_MODULE_FROZEN (MICROPY_MODULE_FROZEN_STR || MICROPY_MODULE_FROZEN_MPY)
+#define MICROPY_MODULE_FROZEN (MICROPY_MODULE_FROZEN_STR || MICROPY_MODULE_FROZEN_MPY || MICROPY_MODULE_FROZEN_BUNDLE)
 #endif
 
 // Whether you can override builtins in the builtins module
@@ -594,6 +886,29 @@ typedef double mp_float_t;
 #define MICROPY_FSUSERMOUNT (0)
 #endif
 
+// Whether to provide uos.LogBdev, a wear-levelling log-structured block
+// device which lets a FAT filesystem live on raw flash
+#ifndef MICROPY_VFS_LOGBDEV
+#define MICROPY_VFS_LOGBDEV (0)
+#endif
+
+// Whether imports from FAT file systems keep a listing of each directory they
+// search, so that probing sys.path is answered from RAM. It is cleared on any
+// write to a FAT device, on mount, umount and chdir.
+#ifndef MICROPY_VFS_FAT_IMPORT_CACHE
+#define MICROPY_VFS_FAT_IMPORT_CACHE (0)
+#endif
+
+// Whether to provide uos.SDCard, a block device for an SD card on an SPI bus
+#ifndef MICROPY_VFS_SDCARD
+#define MICROPY_VFS_SDCARD (0)
+#endif
+
+// Whether uos.SDCard can drive nativeio.SPI and nativeio.DigitalInOut directly
+#ifndef MICROPY_VFS_SDCARD_NATIVEIO
+#define MICROPY_VFS_SDCARD_NATIVEIO (0)
+#endif
+
 /*****************************************************************************/
 /* Fine control over Python builtins, classes, modules, etc                  */
 
@@ -608,6 +923,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_DESCRIPTORS (0)
 #endif
 
+// Whether a class can declare the attributes of its instances in __slots__,
+// giving each a fixed slot in the instance and raising AttributeError when
+// others are set.  Requires MICROPY_OPT_INSTANCE_SHARED_KEYS.
+#ifndef MICROPY_PY_SLOTS
+#define MICROPY_PY_SLOTS (0)
+#endif
+
 // Support for async/await/async for/async with
 #ifndef MICROPY_PY_ASYNC_AWAIT
 #define MICROPY_PY_ASYNC_AWAIT (1)
@@ -648,6 +970,11 @@ typedef double mp_float_t;
 #define MICROPY_PY_BUILTINS_MEMORYVIEW (0)
 #endif
 
+// Whether to support memoryview.cast, including casts to 2D shapes
+#ifndef MICROPY_PY_BUILTINS_MEMORYVIEW_CAST
+#define MICROPY_PY_BUILTINS_MEMORYVIEW_CAST (0)
+#endif
+
 // Whether to support set object
 #ifndef MICROPY_PY_BUILTINS_SET
 #define MICROPY_PY_BUILTINS_SET (1)
@@ -742,6 +1069,58 @@ typedef double mp_float_t;
 #define MICROPY_PY_MICROPYTHON_MEM_INFO (0)
 #endif
 
+// Whether to provide micropython.list_reserve(list, n), which makes room for
+// a list to grow to n items without reallocating
+#ifndef MICROPY_PY_MICROPYTHON_LIST_RESERVE
+#define MICROPY_PY_MICROPYTHON_LIST_RESERVE (0)
+#endif
+
+// Whether to provide micropython.RingIO, a fixed-size byte queue with the
+// stream protocol that can pass data from an interrupt to the main loop
+#ifndef MICROPY_PY_MICROPYTHON_RINGIO
+#define MICROPY_PY_MICROPYTHON_RINGIO (0)
+#endif
+
+// Whether to provide micropython.profile(), a sampling profiler which counts
+// the source lines that the port's tick finds running, in a table of this
+// many lines.  The port must call mp_profile_tick every millisecond.
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE
+#define MICROPY_PY_MICROPYTHON_PROFILE (0)
+#endif
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES
+#define MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES (64)
+#endif
+
+// Whether to provide micropython.trace(), which records the start time and
+// duration of calls to Python functions in a ring of this many calls
+#ifndef MICROPY_PY_MICROPYTHON_TRACE
+#define MICROPY_PY_MICROPYTHON_TRACE (0)
+#endif
+#ifndef MICROPY_PY_MICROPYTHON_TRACE_ENTRIES
+#define MICROPY_PY_MICROPYTHON_TRACE_ENTRIES (64)
+#endif
+
+// Whether to provide micropython.opcode_stats(), which counts the opcodes
+// the bytecode VM dispatches, and pairs of consecutive opcodes in a table of
+// this many pairs.  This adds work to every opcode, so is only meant for
+// builds made to collect the counts.
+#ifndef MICROPY_PY_MICROPYTHON_OPCODE_STATS
+#define MICROPY_PY_MICROPYTHON_OPCODE_STATS (0)
+#endif
+#ifndef MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS
+#define MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS (1024)
+#endif
+
+// Whether to provide micropython.cycles(), which reads mp_hal_ticks_cpu, and
+// micropython.cycle_stats(), the cycles taken by gc collections, parsing and
+// compiling as timed by MP_CYCLES_BEGIN and MP_CYCLES_END
+#ifndef MICROPY_PY_MICROPYTHON_CYCLES
+#define MICROPY_PY_MICROPYTHON_CYCLES (0)
+#endif
+
+// The profilers need the VM to keep the innermost code state in thread state
+#define MICROPY_TRACK_CODE_STATE (MICROPY_GC_ALLOC_PROFILE || MICROPY_PY_MICROPYTHON_PROFILE)
+
 // Whether to provide "array" module. Note that large chunk of the
 // underlying code is shared with "bytearray" builtin type, so to
 // get real savings, it should be disabled too.
@@ -755,6 +1134,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN (0)
 #endif
 
+// Whether to support native bulk operations on arrays: the add, mul, sum,
+// dot, min and max methods, and fast conversion between typecodes when an
+// array is constructed from another array
+#ifndef MICROPY_PY_ARRAY_VECTOR_OPS
+#define MICROPY_PY_ARRAY_VECTOR_OPS (0)
+#endif
+
 // Whether to support attrtuple type (MicroPython extension)
 // It provides space-efficient tuples with attribute access
 #ifndef MICROPY_PY_ATTRTUPLE
@@ -771,6 +1157,12 @@ typedef double mp_float_t;
 #define MICROPY_PY_COLLECTIONS_ORDEREDDICT (0)
 #endif
 
+// Whether to provide "collections.deque" type, a ring buffer with O(1)
+// appends and pops at both ends and an optional maxlen
+#ifndef MICROPY_PY_COLLECTIONS_DEQUE
+#define MICROPY_PY_COLLECTIONS_DEQUE (0)
+#endif
+
 // Whether to provide "math" module
 #ifndef MICROPY_PY_MATH
 #define MICROPY_PY_MATH (1)
@@ -821,6 +1213,12 @@ typedef double mp_float_t;
 #define MICROPY_PY_STRUCT (1)
 #endif
 
+// Whether to provide "struct.Struct", which parses its format once, along
+// with iter_unpack and the unpack_into extension
+#ifndef MICROPY_PY_STRUCT_STRUCT
+#define MICROPY_PY_STRUCT_STRUCT (0)
+#endif
+
 // Whether to provide "sys" module
 #ifndef MICROPY_PY_SYS
 #define MICROPY_PY_SYS (1)
@@ -863,6 +1261,17 @@ typedef double mp_float_t;
 #define MICROPY_PY_UERRNO (0)
 #endif
 
+// Whether to provide "uselect" module (baremetal implementation, which
+// polls objects through their stream ioctl)
+#ifndef MICROPY_PY_USELECT
+#define MICROPY_PY_USELECT (0)
+#endif
+
+// Whether to provide "_uasyncio" module, the C core of an event loop
+#ifndef MICROPY_PY_UASYNCIO
+#define MICROPY_PY_UASYNCIO (0)
+#endif
+
 // Whether to provide "utime" module functions implementation
 // in terms of mp_hal_* functions.
 #ifndef MICROPY_PY_UTIME_MP_HAL
@@ -890,6 +1299,46 @@ typedef double mp_float_t;
 #define MICROPY_PY_THREAD_GIL (MICROPY_PY_THREAD)
 #endif
 
+// Whether _thread provides the Queue, Condition and Event types; the port
+// must then implement mp_thread_cond_t, see mpthread.h
+#ifndef MICROPY_PY_THREAD_SYNC
+#define MICROPY_PY_THREAD_SYNC (0)
+#endif
+
+// Whether _thread provides the Pool type, which runs calls on a set of
+// worker threads that are kept for reuse; requires MICROPY_PY_THREAD_SYNC
+#ifndef MICROPY_PY_THREAD_POOL
+#define MICROPY_PY_THREAD_POOL (0)
+#endif
+
+// Whether the interpreter state is reached through a thread-local pointer,
+// so that several independent interpreters, each with its own heap and
+// qstr pool, can run in one process; the port must support thread-local
+// storage and have each new thread take over the state of its creator
+#ifndef MICROPY_MULTI_INTERP
+#define MICROPY_MULTI_INTERP (0)
+#endif
+
+// Whether a thread publishes its registers and stack extent while it waits
+// for the GIL or blocks (between MP_THREAD_GIL_EXIT and MP_THREAD_GIL_ENTER)
+// so that the GC scans it there, rather than having to interrupt it; the
+// port must provide mp_thread_park and mp_thread_unpark
+#ifndef MICROPY_PY_THREAD_GC_SAFEPOINTS
+#define MICROPY_PY_THREAD_GC_SAFEPOINTS (0)
+#endif
+
+// Number of VM loop checks (backwards jumps and the like) a thread runs
+// for, while other threads wait for the GIL, before it hands the GIL over
+#ifndef MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+#define MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL (100)
+#endif
+
+// Number of locks that maps and sets are spread over when there is no GIL;
+// each map or set uses the lock picked by its address
+#ifndef MICROPY_PY_THREAD_MAP_LOCKS
+#define MICROPY_PY_THREAD_MAP_LOCKS (16)
+#endif
+
 // Extended modules
 
 #ifndef MICROPY_PY_UCTYPES
@@ -900,22 +1349,90 @@ typedef double mp_float_t;
 #define MICROPY_PY_UZLIB (0)
 #endif
 
+// Number of bits the inflater decodes at once by table lookup, 0 to decode
+// bit by bit. Each DecompIO (and decompress call) needs 4 << bits more bytes.
+#ifndef MICROPY_PY_UZLIB_FAST_BITS
+#define MICROPY_PY_UZLIB_FAST_BITS (0)
+#endif
+
+// Number of 1k tables used for CRC32 (gzip streams and ubinascii.crc32): 0
+// for a 64 byte table and 4 bits per lookup, 1 for a byte at a time, or 4 or
+// 8 for slicing-by-4/8, which are several times faster again.
+#ifndef MICROPY_PY_UZLIB_CRC32_TABLES
+#define MICROPY_PY_UZLIB_CRC32_TABLES (0)
+#endif
+
+// Whether to provide uzlib.compress and uzlib.CompressIO
+// Depends on MICROPY_PY_UZLIB
+#ifndef MICROPY_PY_UZLIB_COMPRESS
+#define MICROPY_PY_UZLIB_COMPRESS (0)
+#endif
+
 #ifndef MICROPY_PY_UJSON
 #define MICROPY_PY_UJSON (0)
 #endif
 
+// Size of the block that ujson.load reads from a stream at a time.  Note
+// that this is allocated on the C stack, and that load may read past the
+// end of the JSON value (it reads the stream to its end anyway).
+#ifndef MICROPY_PY_UJSON_READ_BUF_SIZE
+#define MICROPY_PY_UJSON_READ_BUF_SIZE (64)
+#endif
+
+// Size of the buffer, on the C stack, through which ujson.dump writes
+#ifndef MICROPY_PY_UJSON_WRITE_BUF_SIZE
+#define MICROPY_PY_UJSON_WRITE_BUF_SIZE (64)
+#endif
+
 #ifndef MICROPY_PY_URE
 #define MICROPY_PY_URE (0)
 #endif
 
+// Whether to provide ure.sub and ure.finditer
+#ifndef MICROPY_PY_URE_SUB
+#define MICROPY_PY_URE_SUB (0)
+#endif
+
+// Whether ure can use a Pike VM, which matches in linear time without
+// recursion, for patterns with nested repetition and for long subjects
+#ifndef MICROPY_PY_URE_PIKEVM
+#define MICROPY_PY_URE_PIKEVM (0)
+#endif
+
+// Subjects of at least this length are matched with the Pike VM if the
+// pattern has any repetition
+#ifndef MICROPY_PY_URE_PIKEVM_MIN_LEN
+#define MICROPY_PY_URE_PIKEVM_MIN_LEN (256)
+#endif
+
+// Largest Pike VM workspace, in bytes, which is put on the C stack instead
+// of the heap
+#ifndef MICROPY_PY_URE_PIKEVM_STACK_MAX
+#define MICROPY_PY_URE_PIKEVM_STACK_MAX (512)
+#endif
+
 #ifndef MICROPY_PY_UHEAPQ
 #define MICROPY_PY_UHEAPQ (0)
 #endif
 
+// Whether to provide uheapq.PriorityQueue, a heap of objects with int
+// priorities that can remove an entry or change its priority
+#ifndef MICROPY_PY_UHEAPQ_PRIORITYQUEUE
+#define MICROPY_PY_UHEAPQ_PRIORITYQUEUE (0)
+#endif
+
 #ifndef MICROPY_PY_UHASHLIB
 #define MICROPY_PY_UHASHLIB (0)
 #endif
 
+#ifndef MICROPY_PY_UHASHLIB_SHA1
+#define MICROPY_PY_UHASHLIB_SHA1 (0)
+#endif
+
+#ifndef MICROPY_PY_UHASHLIB_MD5
+#define MICROPY_PY_UHASHLIB_MD5 (0)
+#endif
+
 #ifndef MICROPY_PY_UBINASCII
 #define MICROPY_PY_UBINASCII (0)
 #endif
@@ -934,6 +1451,16 @@ typedef double mp_float_t;
 #define MICROPY_PY_URANDOM_EXTRA_FUNCS (0)
 #endif
 
+// Whether urandom uses the xoshiro128++ generator, which has better
+// statistical quality than the default Yasmarang and is as fast
+#ifndef MICROPY_PY_URANDOM_XOSHIRO128
+#define MICROPY_PY_URANDOM_XOSHIRO128 (0)
+#endif
+
+// A port may define MICROPY_PY_URANDOM_SEED_INIT_FUNC to an expression giving
+// a 32-bit seed, such as from a hardware RNG, that urandom is seeded with when
+// first imported.  This needs MICROPY_MODULE_BUILTIN_INIT.
+
 #ifndef MICROPY_PY_MACHINE
 #define MICROPY_PY_MACHINE (0)
 #endif
@@ -951,18 +1478,43 @@ typedef double mp_float_t;
 #define MICROPY_PY_MACHINE_SPI (0)
 #endif
 
+// Default number of received datagrams a lwIP UDP socket can hold before
+// dropping new ones; can be changed per socket with setsockopt(SO_RCVQUEUE)
+#ifndef MICROPY_PY_LWIP_UDP_QUEUE_LEN
+#define MICROPY_PY_LWIP_UDP_QUEUE_LEN (4)
+#endif
+
 #ifndef MICROPY_PY_USSL
 #define MICROPY_PY_USSL (0)
 #endif
 
+// Maximum TLS record length (512, 1024, 2048 or 4096) to negotiate with the
+// server, so the TLS library can be built with record buffers that small
+// instead of 16K; 0 means no negotiation. Only supported with mbedTLS.
+#ifndef MICROPY_PY_USSL_MAX_FRAG_LEN
+#define MICROPY_PY_USSL_MAX_FRAG_LEN (0)
+#endif
+
 #ifndef MICROPY_PY_WEBSOCKET
 #define MICROPY_PY_WEBSOCKET (0)
 #endif
 
+// Size of the buffer WebREPL moves file data through; larger chunks mean
+// fewer file writes, websocket frames and rate-limiting delays per transfer
+#ifndef MICROPY_PY_WEBREPL_CHUNK_SIZE
+#define MICROPY_PY_WEBREPL_CHUNK_SIZE (512)
+#endif
+
 #ifndef MICROPY_PY_FRAMEBUF
 #define MICROPY_PY_FRAMEBUF (0)
 #endif
 
+// Whether framebuf tracks the bounding box of drawn pixels, so display
+// drivers can send only the changed window with FrameBuffer.dirty()
+#ifndef MICROPY_PY_FRAMEBUF_DIRTY
+#define MICROPY_PY_FRAMEBUF_DIRTY (0)
+#endif
+
 #ifndef MICROPY_PY_BTREE
 #define MICROPY_PY_BTREE (0)
 #endif
@@ -26,6 +26,7 @@
 #ifndef __MICROPY_INCLUDED_PY_MPHAL_H__
 #define __MICROPY_INCLUDED_PY_MPHAL_H__
 
+#include <stdbool.h>
 #include "py/mpconfig.h"
 
 #ifdef MICROPY_MPHALPORT_H
@@ -70,6 +71,12 @@ mp_uint_t mp_hal_ticks_us(void);
 mp_uint_t mp_hal_ticks_cpu(void);
 #endif
 
+#if MICROPY_PY_MICROPYTHON_PROFILE && !defined(mp_hal_profile_timer)
+// Start or stop calling mp_profile_tick every millisecond, for ports which
+// don't call it from a tick they always run.
+void mp_hal_profile_timer(bool enable);
+#endif
+
 // If port HAL didn't define its own pin API, use generic
 // "virtual pin" API from the core.
 #ifndef mp_hal_pin_obj_t
@@ -30,4 +30,10 @@
 mp_dynamic_compiler_t mp_dynamic_compiler = {0};
 #endif
 
+#if MICROPY_MULTI_INTERP
+// the state of the first interpreter, which threads run in unless told otherwise
+STATIC mp_state_ctx_t mp_state_ctx_main;
+__thread mp_state_ctx_t *mp_state_ctx_ptr = &mp_state_ctx_main;
+#else
 mp_state_ctx_t mp_state_ctx;
+#endif
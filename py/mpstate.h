@@ -45,11 +45,134 @@
 typedef struct mp_dynamic_compiler_t {
     uint8_t small_int_bits; // must be <= host small_int_bits
     bool opt_cache_map_lookup_in_bytecode;
+    bool opt_superinstructions;
     bool py_builtins_str_unicode;
+    uint8_t native_arch; // an mp_native_arch_t, MP_NATIVE_ARCH_NONE for no native code
 } mp_dynamic_compiler_t;
 extern mp_dynamic_compiler_t mp_dynamic_compiler;
 #endif
 
+#if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+// The result of a search of a class hierarchy for an attribute, see objtype.c
+typedef struct _mp_class_lookup_cache_entry_t {
+    const mp_obj_type_t *type;
+    qstr attr;
+    mp_uint_t version;
+    const mp_obj_type_t *found_type;
+    mp_obj_t value;
+} mp_class_lookup_cache_entry_t;
+#endif
+
+#if MICROPY_OPT_STR_INDEX_CACHE
+// Where the chars are in the str last indexed, see objstrunicode.c
+typedef struct _mp_str_index_cache_t {
+    size_t len; // bytes in the str when it was remembered
+    size_t chars; // chars in the str, or (size_t)-1 if not known yet
+    size_t char_index;
+    size_t byte_offset; // of the char at char_index
+    size_t ascii_len; // the str starts with this many ASCII bytes
+} mp_str_index_cache_t;
+#endif
+
+#if MICROPY_ENABLE_SCHEDULER
+// A function queued up by mp_sched_schedule, with the argument to call it with
+typedef struct _mp_sched_item_t {
+    mp_obj_t func;
+    mp_obj_t arg;
+} mp_sched_item_t;
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+// A source line found running by the sampling profiler, and the number of
+// times it was; samples taken outside of bytecode have no names
+typedef struct _mp_profile_entry_t {
+    qstr source_file;
+    qstr block_name;
+    size_t line;
+    size_t count;
+} mp_profile_entry_t;
+#endif
+
+#if MICROPY_PY_MICROPYTHON_TRACE
+// A call recorded by micropython.trace(), times are in microseconds
+typedef struct _mp_trace_entry_t {
+    qstr name;
+    bool raised;
+    mp_uint_t start;
+    mp_uint_t duration;
+} mp_trace_entry_t;
+#endif
+
+#if MICROPY_PY_MICROPYTHON_CYCLES
+// The code timed in cycles by MP_CYCLES_BEGIN and MP_CYCLES_END
+enum {
+    MP_CYCLES_GC_COLLECT,
+    MP_CYCLES_PARSE,
+    MP_CYCLES_COMPILE,
+    MP_CYCLES_NUM_SECTIONS,
+};
+
+typedef struct _mp_cycles_section_t {
+    mp_uint_t start; // mp_hal_ticks_cpu() when the section was entered
+    mp_uint_t count;
+    mp_uint_t max;
+    uint64_t total;
+} mp_cycles_section_t;
+#endif
+
+#if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+// A pair of opcodes dispatched one after the other, first in the high byte,
+// and the number of times they were
+typedef struct _mp_opcode_pair_t {
+    uint16_t pair;
+    size_t count;
+} mp_opcode_pair_t;
+#endif
+
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+// A lock shared by the maps and sets whose address picks it.  It can be taken
+// again by the thread holding it, because looking up a key can run Python code
+// that uses the same map.  The sequence number is odd while the lock is held.
+typedef struct _mp_map_lock_t {
+    mp_thread_mutex_t mutex;
+    struct _mp_state_thread_t *owner;
+    mp_uint_t depth;
+    mp_uint_t seq;
+} mp_map_lock_t;
+#endif
+
+#if MICROPY_GC_THREAD_ALLOC_BLOCKS
+// A region of the heap that a thread allocates small objects from without
+// taking the GC mutex.
+typedef struct _mp_gc_thread_alloc_t {
+    struct _mp_gc_thread_alloc_t *next; // list of all threads' regions
+    byte *region; // head of the unused part of the region, or NULL
+    size_t n_blocks; // number of unused blocks in the region
+    int busy; // set while the owner is allocating from the region
+    #if MICROPY_GC_ALLOC_PROFILE || MICROPY_GC_STATS
+    bool refilling; // set while the owner allocates a new region
+    #endif
+    #if MICROPY_GC_STATS
+    // allocations made from the region, only written by the owner
+    uint64_t alloc_bytes;
+    size_t alloc_count;
+    #endif
+} mp_gc_thread_alloc_t;
+#endif
+
+#if MICROPY_GC_ALLOC_PROFILE
+// An allocation recorded by the allocation profiler.  Times are given by the
+// number of blocks allocated since the profiler was started.
+typedef struct _mp_gc_profile_entry_t {
+    size_t block; // head block of the allocation
+    size_t n_blocks;
+    size_t birth;
+    size_t death; // 0 while the allocation is live
+    qstr block_name; // function allocating, or MP_QSTR_NULL outside bytecode
+    size_t bc_offset;
+} mp_gc_profile_entry_t;
+#endif
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
@@ -67,6 +190,9 @@ typedef struct _mp_state_mem_t {
     byte *gc_pool_end;
 
     int gc_stack_overflow;
+    #if MICROPY_GC_PARALLEL_MARK
+    bool gc_mark_parallel;
+    #endif
     size_t gc_stack[MICROPY_ALLOC_GC_STACK_SIZE];
     size_t *gc_sp;
     uint16_t gc_lock_depth;
@@ -79,9 +205,75 @@ typedef struct _mp_state_mem_t {
     #if MICROPY_GC_ALLOC_THRESHOLD
     size_t gc_alloc_amount;
     size_t gc_alloc_threshold;
+    // set once gc_alloc_amount reaches the threshold, until the collection
+    volatile bool gc_threshold_reached;
     #endif
 
-    size_t gc_last_free_atb_index;
+    // For each size class c (allocations of c + 1 blocks, the last class also
+    // covering all larger sizes) this holds an ATB index such that no run of
+    // c + 1 free blocks starts in an earlier ATB.
+    size_t gc_first_free_atb_index[MICROPY_GC_FREE_INDEX_CLASSES];
+
+    // Next block to be swept, or (size_t)-1 if no sweep is pending.  Heads at
+    // or after this block that are allocated before the sweep gets to them
+    // are created marked.
+    size_t gc_sweep_block;
+
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    size_t gc_sweep_quantum;
+    #endif
+
+    #if MICROPY_GC_NURSERY_BLOCKS
+    // The nursery runs from gc_nursery_start to the end of the heap, and
+    // small objects are allocated from it starting at gc_nursery_next.  It
+    // is full when a minor collection could not free half of it, and stays
+    // so until the next major collection.
+    size_t gc_nursery_start;
+    size_t gc_nursery_next;
+    bool gc_nursery_full;
+    #endif
+
+    #if MICROPY_GC_LONG_LIVED
+    // Long-lived objects are allocated from the highest free run of blocks
+    // below this block.  It is lowered to each such object and raised again
+    // when blocks above it are freed.
+    size_t gc_long_lived_top;
+    #endif
+
+    #if MICROPY_GC_PARTIAL_COLLECT
+    // Set during a collection that only reclaims objects with their head
+    // from gc_partial_start up to gc_partial_end.
+    bool gc_partial;
+    size_t gc_partial_start;
+    size_t gc_partial_end;
+    #endif
+
+    #if MICROPY_GC_ALLOC_PROFILE
+    // one allocation is sampled each time gc_profile_rate blocks have been
+    // allocated; 0 stops sampling
+    size_t gc_profile_rate;
+    size_t gc_profile_countdown;
+    size_t gc_profile_clock;
+    size_t gc_profile_len; // number of entries recorded since starting
+    size_t gc_profile_live; // number of entries still live
+    mp_gc_profile_entry_t gc_profile_entries[MICROPY_GC_ALLOC_PROFILE_ENTRIES];
+    #endif
+
+    #if MICROPY_GC_STATS
+    // counted since boot; see gc_stats
+    size_t gc_stats_collections;
+    size_t gc_stats_alloc_collections;
+    uint64_t gc_stats_pause_total;
+    mp_uint_t gc_stats_pause_max;
+    mp_uint_t gc_stats_pause_start;
+    uint64_t gc_stats_alloc_bytes;
+    uint64_t gc_stats_alloc_count;
+    #endif
+
+    #if MICROPY_GC_COMPACT
+    // two bits per block used while compacting, NULL otherwise
+    byte *gc_compact_table;
+    #endif
 
     #if MICROPY_PY_GC_COLLECT_RETVAL
     size_t gc_collected;
@@ -91,6 +283,13 @@ typedef struct _mp_state_mem_t {
     // This is a global mutex used to make the GC thread-safe.
     mp_thread_mutex_t gc_mutex;
     #endif
+
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    // set while a collection is in progress, which stops threads from using
+    // their allocation region
+    int gc_collecting;
+    mp_gc_thread_alloc_t *gc_thread_alloc_list;
+    #endif
 } mp_state_mem_t;
 
 // This structure hold runtime and VM information.  It includes a section
@@ -124,6 +323,11 @@ typedef struct _mp_state_vm_t {
     // pending exception object (MP_OBJ_NULL if not pending)
     volatile mp_obj_t mp_pending_exception;
 
+    #if MICROPY_ENABLE_SCHEDULER
+    // functions waiting to be run by the scheduler, see scheduler.c
+    mp_sched_item_t sched_queue[MICROPY_SCHEDULER_DEPTH];
+    #endif
+
     // current exception being handled, for sys.exc_info()
     #if MICROPY_PY_SYS_EXC_INFO
     mp_obj_base_t *cur_exception;
@@ -132,6 +336,11 @@ typedef struct _mp_state_vm_t {
     // dictionary for the __main__ module
     mp_obj_dict_t dict_main;
 
+    #if MICROPY_MULTI_INTERP
+    // the __main__ module, which can't be shared between interpreters
+    mp_obj_module_t module_main;
+    #endif
+
     // these two lists must be initialised per port, after the call to mp_init
     mp_obj_list_t mp_sys_path_obj;
     mp_obj_list_t mp_sys_argv_obj;
@@ -141,6 +350,21 @@ typedef struct _mp_state_vm_t {
     mp_obj_dict_t *mp_module_builtins_override_dict;
     #endif
 
+    // index of the qstrs that are not in mp_qstr_const_pool
+    #if MICROPY_QSTR_HASH_TABLE
+    struct _qstr_hash_table_t *qstr_hash_table;
+    #endif
+
+    // all arenas in use by any thread, linked through their next field
+    #if MICROPY_GC_ARENA
+    struct _gc_arena_t *gc_arena_list;
+    #endif
+
+    // parse trees and scopes kept for recompiling hot functions to native code
+    #if MICROPY_EMIT_NATIVE_TIERED
+    struct _mp_native_tier_unit_t *native_tier_units;
+    #endif
+
     // include any root pointers defined by a port
     MICROPY_PORT_ROOT_POINTERS
 
@@ -160,6 +384,16 @@ typedef struct _mp_state_vm_t {
     struct _fs_user_mount_t *fs_user_mount[MICROPY_FATFS_VOLUMES];
     #endif
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    // directory listings for imports, see extmod/vfs_fat_misc.c
+    mp_obj_t fat_import_cache;
+    #endif
+
+    #if MICROPY_OPT_STR_INDEX_CACHE
+    // the str last indexed, see objstrunicode.c
+    mp_obj_t str_index_obj;
+    #endif
+
     //
     // END ROOT POINTER SECTION
     ////////////////////////////////////////////////////////////
@@ -177,14 +411,96 @@ typedef struct _mp_state_vm_t {
 
     mp_uint_t mp_optimise_value;
 
+    #if MICROPY_MODULE_FROZEN_BUNDLE
+    // the bundle of frozen modules, or NULL if none is mounted
+    const byte *frozen_bundle;
+    #endif
+
+    #if MICROPY_EMIT_NATIVE_TIERED
+    // number of calls after which a bytecode function is compiled to native
+    // code; 0 disables counting
+    mp_uint_t native_tier_threshold;
+    #endif
+
+    #if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE && !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+    // position in its map of the key last looked up by an opcode, see vm.c
+    uint8_t bc_map_lookup_cache[MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE];
+    #endif
+
+    #if MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE
+    // position in its map of a recently found key, see mp_map_lookup
+    uint8_t map_lookup_cache[MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE];
+    #endif
+
+    #if MICROPY_OPT_STR_INDEX_CACHE
+    mp_str_index_cache_t str_index;
+    #endif
+
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+    // recent searches of class hierarchies; not root pointers, see objtype.c
+    mp_uint_t class_lookup_version;
+    mp_class_lookup_cache_entry_t class_lookup_cache[MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE];
+    #endif
+
     // size of the emergency exception buf, if it's dynamically allocated
     #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF && MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE == 0
     mp_int_t mp_emergency_exception_buf_size;
     #endif
 
+    #if MICROPY_ENABLE_SCHEDULER
+    // one of MP_SCHED_IDLE or MP_SCHED_PENDING, or negative while locked
+    volatile int16_t sched_state;
+    uint8_t sched_idx;
+    uint8_t sched_len;
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    // ticks between samples, 0 when not profiling; see profile.c
+    volatile uint16_t profile_period;
+    uint16_t profile_countdown;
+    // set while the table is read, samples taken meanwhile are dropped
+    volatile bool profile_reading;
+    size_t profile_dropped; // samples that didn't fit in the table
+    mp_profile_entry_t profile_table[MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES];
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_TRACE
+    // calls are traced while this is set; see profile.c
+    bool trace_enabled;
+    size_t trace_len; // number of calls recorded since starting
+    mp_trace_entry_t trace_ring[MICROPY_PY_MICROPYTHON_TRACE_ENTRIES];
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_CYCLES
+    // see profile.c
+    mp_cycles_section_t cycles_sections[MP_CYCLES_NUM_SECTIONS];
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+    // opcodes dispatched by the VM; see profile.c
+    byte opcode_last;
+    size_t opcode_pairs_dropped; // pairs that didn't fit in the table
+    size_t opcode_counts[256];
+    mp_opcode_pair_t opcode_pairs[MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS];
+    #endif
+
     #if MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make the VM/runtime thread-safe.
     mp_thread_mutex_t gil_mutex;
+    // number of threads blocked on gil_mutex, non-zero asks the holder to switch
+    mp_uint_t gil_waiting;
+    // number of times the GIL was acquired
+    mp_uint_t gil_switches;
+    // VM loop checks left until the holder next considers a switch
+    mp_uint_t gil_ticks;
+    #elif MICROPY_PY_THREAD
+    // Without the GIL, maps and sets are protected by these locks, see map.c.
+    mp_map_lock_t map_locks[MICROPY_PY_THREAD_MAP_LOCKS];
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    // This mutex protects the attributes of instances which aren't in a map
+    // yet, and the shared keys of their types, see objtype.c.
+    mp_thread_mutex_t instance_mutex;
+    #endif
     #endif
 } mp_state_vm_t;
 
@@ -201,6 +517,38 @@ typedef struct _mp_state_thread_t {
     #if MICROPY_STACK_CHECK
     size_t stack_limit;
     #endif
+
+    #if MICROPY_GC_THREAD_ALLOC_BLOCKS
+    mp_gc_thread_alloc_t gc_thread_alloc;
+    #endif
+
+    #if MICROPY_GC_PARTIAL_COLLECT
+    // range of a partial collection this thread runs through gc_collect,
+    // empty for a full collection
+    size_t gc_partial_start;
+    size_t gc_partial_end;
+    #endif
+
+    #if MICROPY_GC_ARENA
+    struct _gc_arena_t *gc_arena; // arena allocations come from, or NULL
+    #endif
+
+    #if MICROPY_TRACK_CODE_STATE
+    // bytecode being run, which allocations and profiler samples are
+    // attributed to
+    struct _mp_code_state_t *cur_code_state;
+    #endif
+
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    // frames of finished generators and their sizes, 0 for an empty slot
+    struct _mp_code_state_t *gen_frame_pool[MICROPY_OPT_GEN_FRAME_POOL];
+    size_t gen_frame_pool_nbytes[MICROPY_OPT_GEN_FRAME_POOL];
+    #endif
+
+    #if MICROPY_OPT_TUPLE_POOL
+    // dead tuples of length 1 and up, NULL for an empty slot
+    struct _mp_obj_tuple_t *tuple_pool[MICROPY_OPT_TUPLE_POOL];
+    #endif
 } mp_state_thread_t;
 
 // This structure combines the above 3 structures, and adds the local
@@ -217,7 +565,13 @@ typedef struct _mp_state_ctx_t {
     mp_state_mem_t mem;
 } mp_state_ctx_t;
 
+#if MICROPY_MULTI_INTERP
+// each thread runs in the interpreter that this points to
+extern __thread mp_state_ctx_t *mp_state_ctx_ptr;
+#define mp_state_ctx (*mp_state_ctx_ptr)
+#else
 extern mp_state_ctx_t mp_state_ctx;
+#endif
 
 #define MP_STATE_CTX(x) (mp_state_ctx.x)
 #define MP_STATE_VM(x) (mp_state_ctx.vm.x)
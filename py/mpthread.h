@@ -47,15 +47,44 @@ void mp_thread_mutex_init(mp_thread_mutex_t *mutex);
 int mp_thread_mutex_lock(mp_thread_mutex_t *mutex, int wait);
 void mp_thread_mutex_unlock(mp_thread_mutex_t *mutex);
 
+#if MICROPY_PY_THREAD_SYNC
+void mp_thread_cond_init(mp_thread_cond_t *cond);
+// Waits with mutex unlocked for at most timeout_ms, or forever if it's
+// negative; returns 0 on timeout, 1 if woken (which may be spurious).
+int mp_thread_cond_wait(mp_thread_cond_t *cond, mp_thread_mutex_t *mutex, mp_int_t timeout_ms);
+void mp_thread_cond_signal(mp_thread_cond_t *cond);
+void mp_thread_cond_broadcast(mp_thread_cond_t *cond);
+#endif
+
+// Let other threads run, used while waiting for one of them to take the GIL
+#ifndef MP_THREAD_YIELD
+#define MP_THREAD_YIELD()
+#endif
+
 #endif // MICROPY_PY_THREAD
 
+#if MICROPY_PY_THREAD && MICROPY_PY_THREAD_GC_SAFEPOINTS
+// A thread is parked between these, and must not touch the heap then
+void mp_thread_park(void);
+void mp_thread_unpark(void);
+#define MP_THREAD_PARK() mp_thread_park()
+#define MP_THREAD_UNPARK() mp_thread_unpark()
+#else
+#define MP_THREAD_PARK()
+#define MP_THREAD_UNPARK()
+#endif
+
 #if MICROPY_PY_THREAD && MICROPY_PY_THREAD_GIL
 #include "py/mpstate.h"
-#define MP_THREAD_GIL_ENTER() mp_thread_mutex_lock(&MP_STATE_VM(gil_mutex), 1)
-#define MP_THREAD_GIL_EXIT() mp_thread_mutex_unlock(&MP_STATE_VM(gil_mutex))
+void mp_thread_gil_enter(void);
+void mp_thread_gil_exit(void);
+void mp_thread_gil_switch(void);
+#define MP_THREAD_GIL_ENTER() mp_thread_gil_enter()
+#define MP_THREAD_GIL_EXIT() mp_thread_gil_exit()
 #else
-#define MP_THREAD_GIL_ENTER()
-#define MP_THREAD_GIL_EXIT()
+// without a GIL these still mark where a thread blocks
+#define MP_THREAD_GIL_ENTER() MP_THREAD_UNPARK()
+#define MP_THREAD_GIL_EXIT() MP_THREAD_PARK()
 #endif
 
 #endif // __MICROPY_INCLUDED_PY_MPTHREAD_H__
@@ -419,12 +419,13 @@ STATIC mp_uint_t mpn_mul_dig_add_dig(mpz_dig_t *idig, mp_uint_t ilen, mpz_dig_t
     return idig - oidig;
 }
 
-/* computes i = j * k
+/* computes i = j * k by the schoolbook method
    returns number of digits in i
-   assumes enough memory in i; assumes i is zeroed; assumes normalised j, k
+   assumes enough memory in i; assumes i is zeroed
+   j, k needn't be normalised, but then neither is i
    can have j, k point to same memory
 */
-STATIC mp_uint_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, mp_uint_t jlen, mpz_dig_t *kdig, mp_uint_t klen) {
+STATIC mp_uint_t mpn_mul_school(mpz_dig_t *idig, const mpz_dig_t *jdig, mp_uint_t jlen, const mpz_dig_t *kdig, mp_uint_t klen) {
     mpz_dig_t *oidig = idig;
     mp_uint_t ilen = 0;
 
@@ -433,7 +434,7 @@ STATIC mp_uint_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, mp_uint_t jlen, mpz_d
         mpz_dbl_dig_t carry = 0;
 
         mp_uint_t jl = jlen;
-        for (mpz_dig_t *jd = jdig; jl > 0; --jl, ++jd, ++id) {
+        for (const mpz_dig_t *jd = jdig; jl > 0; --jl, ++jd, ++id) {
             carry += (mpz_dbl_dig_t)*id + (mpz_dbl_dig_t)*jd * (mpz_dbl_dig_t)*kdig; // will never overflow so long as DIG_SIZE <= 8*sizeof(mpz_dbl_dig_t)/2
             *id = carry & DIG_MASK;
             carry >>= DIG_SIZE;
@@ -449,6 +450,165 @@ STATIC mp_uint_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, mp_uint_t jlen, mpz_d
     return ilen;
 }
 
+/* computes i = i - j for the n digits of j, borrowing from the digits of i
+   above those as needed
+   assumes i >= j
+*/
+STATIC void mpn_sub_n_inpl(mpz_dig_t *idig, const mpz_dig_t *jdig, mp_uint_t n) {
+    mpz_dbl_dig_signed_t borrow = 0;
+
+    for (; n > 0; --n, ++idig, ++jdig) {
+        borrow += (mpz_dbl_dig_t)*idig - (mpz_dbl_dig_t)*jdig;
+        *idig = borrow & DIG_MASK;
+        borrow >>= DIG_SIZE;
+    }
+
+    for (; borrow != 0; ++idig) {
+        borrow += *idig;
+        *idig = borrow & DIG_MASK;
+        borrow >>= DIG_SIZE;
+    }
+}
+
+#if MICROPY_OPT_MPZ_KARATSUBA
+
+// below this many digits the schoolbook method is faster
+#define MPN_KARATSUBA_THRESHOLD (32)
+
+/* computes i = i + j for the n digits of j, carrying into the digits of i
+   above those as needed
+   assumes the result fits in i
+*/
+STATIC void mpn_add_n_inpl(mpz_dig_t *idig, const mpz_dig_t *jdig, mp_uint_t n) {
+    mpz_dbl_dig_t carry = 0;
+
+    for (; n > 0; --n, ++idig, ++jdig) {
+        carry += (mpz_dbl_dig_t)*idig + (mpz_dbl_dig_t)*jdig;
+        *idig = carry & DIG_MASK;
+        carry >>= DIG_SIZE;
+    }
+
+    for (; carry != 0; ++idig) {
+        carry += *idig;
+        *idig = carry & DIG_MASK;
+        carry >>= DIG_SIZE;
+    }
+}
+
+/* computes i = j * k by Karatsuba's method, for n digits of each of j, k
+   assumes i has 2n digits and is zeroed; j, k needn't be normalised
+*/
+STATIC void mpn_mul_karatsuba(mpz_dig_t *idig, const mpz_dig_t *jdig, const mpz_dig_t *kdig, mp_uint_t n) {
+    if (n < MPN_KARATSUBA_THRESHOLD) {
+        mpn_mul_school(idig, jdig, n, kdig, n);
+        return;
+    }
+
+    // split j, k into low halves j0, k0 of m digits and high halves j1, k1
+    mp_uint_t m = n / 2;
+    mp_uint_t h = n - m;
+
+    // j0 * k0 and j1 * k1 go straight into the low and high parts of i
+    mpn_mul_karatsuba(idig, jdig, kdig, m);
+    mpn_mul_karatsuba(idig + 2 * m, jdig + m, kdig + m, h);
+
+    // then j0 * k1 + j1 * k0 = (j0 + j1) * (k0 + k1) - j0 * k0 - j1 * k1
+    // is added to the middle of i
+    mpz_dig_t *tmp = m_new0(mpz_dig_t, 4 * (h + 1));
+    mpz_dig_t *jsum = tmp;
+    mpz_dig_t *ksum = tmp + h + 1;
+    mpz_dig_t *mid = tmp + 2 * (h + 1);
+    memcpy(jsum, jdig + m, h * sizeof(mpz_dig_t));
+    mpn_add_n_inpl(jsum, jdig, m);
+    memcpy(ksum, kdig + m, h * sizeof(mpz_dig_t));
+    mpn_add_n_inpl(ksum, kdig, m);
+    mpn_mul_karatsuba(mid, jsum, ksum, h + 1);
+    mpn_sub_n_inpl(mid, idig, 2 * m);
+    mpn_sub_n_inpl(mid, idig + 2 * m, 2 * h);
+    mpn_add_n_inpl(idig + m, mid, 2 * (h + 1));
+    m_del(mpz_dig_t, tmp, 4 * (h + 1));
+}
+
+#endif
+
+/* computes i = j * k
+   returns number of digits in i
+   assumes enough memory in i; assumes i is zeroed; assumes normalised j, k
+   can have j, k point to same memory
+*/
+STATIC mp_uint_t mpn_mul(mpz_dig_t *idig, const mpz_dig_t *jdig, mp_uint_t jlen, const mpz_dig_t *kdig, mp_uint_t klen) {
+    #if MICROPY_OPT_MPZ_KARATSUBA
+    if (jlen < klen) {
+        const mpz_dig_t *t = jdig; jdig = kdig; kdig = t;
+        mp_uint_t tl = jlen; jlen = klen; klen = tl;
+    }
+    if (klen >= MPN_KARATSUBA_THRESHOLD) {
+        // multiply k by each klen-digit piece of j, padding the last with zeros
+        mpz_dig_t *tmp = m_new(mpz_dig_t, 3 * klen);
+        mpz_dig_t *piece = tmp + 2 * klen;
+        for (mp_uint_t off = 0; off < jlen; off += klen) {
+            mp_uint_t len = MIN(klen, jlen - off);
+            memcpy(piece, jdig + off, len * sizeof(mpz_dig_t));
+            memset(piece + len, 0, (klen - len) * sizeof(mpz_dig_t));
+            memset(tmp, 0, 2 * klen * sizeof(mpz_dig_t));
+            mpn_mul_karatsuba(tmp, piece, kdig, klen);
+            mpn_add_n_inpl(idig + off, tmp, len + klen);
+        }
+        m_del(mpz_dig_t, tmp, 3 * klen);
+        return mpn_remove_trailing_zeros(idig, idig + jlen + klen);
+    }
+    #endif
+
+    return mpn_mul_school(idig, jdig, jlen, kdig, klen);
+}
+
+/* computes i = j * k / R % m, where R = DIG_BASE ** n (Montgomery multiplication)
+   assumes m is odd and has n digits, j, k < m have n digits (needn't be
+   normalised), i has n + 2 digits, minv * m = -1 (mod DIG_BASE)
+   i ends up with n digits, which may not be normalised
+*/
+STATIC void mpn_montmul(mpz_dig_t *idig, const mpz_dig_t *jdig, const mpz_dig_t *kdig, const mpz_dig_t *mdig, mp_uint_t n, mpz_dig_t minv) {
+    memset(idig, 0, (n + 2) * sizeof(mpz_dig_t));
+
+    for (mp_uint_t x = 0; x < n; ++x) {
+        // i += j * k[x]
+        mpz_dbl_dig_t carry = 0;
+        for (mp_uint_t y = 0; y < n; ++y) {
+            carry += (mpz_dbl_dig_t)idig[y] + (mpz_dbl_dig_t)jdig[y] * (mpz_dbl_dig_t)kdig[x];
+            idig[y] = carry & DIG_MASK;
+            carry >>= DIG_SIZE;
+        }
+        carry += idig[n];
+        idig[n] = carry & DIG_MASK;
+        idig[n + 1] = carry >> DIG_SIZE;
+
+        // i = (i + q * m) / DIG_BASE, with q chosen so that the division is exact
+        mpz_dig_t q = ((mpz_dbl_dig_t)idig[0] * (mpz_dbl_dig_t)minv) & DIG_MASK;
+        carry = ((mpz_dbl_dig_t)idig[0] + (mpz_dbl_dig_t)q * (mpz_dbl_dig_t)mdig[0]) >> DIG_SIZE;
+        for (mp_uint_t y = 1; y < n; ++y) {
+            carry += (mpz_dbl_dig_t)idig[y] + (mpz_dbl_dig_t)q * (mpz_dbl_dig_t)mdig[y];
+            idig[y - 1] = carry & DIG_MASK;
+            carry >>= DIG_SIZE;
+        }
+        carry += idig[n];
+        idig[n - 1] = carry & DIG_MASK;
+        idig[n] = idig[n + 1] + (carry >> DIG_SIZE);
+    }
+
+    // i < 2m, so at most one subtraction of m is needed
+    bool ge = idig[n] != 0;
+    if (!ge) {
+        mp_uint_t y = n;
+        while (y > 0 && idig[y - 1] == mdig[y - 1]) {
+            --y;
+        }
+        ge = y == 0 || idig[y - 1] > mdig[y - 1];
+    }
+    if (ge) {
+        mpn_sub_n_inpl(idig, mdig, n);
+    }
+}
+
 /* natural_div - quo * den + new_num = old_num (ie num is replaced with rem)
    assumes den != 0
    assumes num_dig has enough memory to be extended by 1 digit
@@ -1361,47 +1521,109 @@ void mpz_pow_inpl(mpz_t *dest, const mpz_t *lhs, const mpz_t *rhs) {
     mpz_free(n);
 }
 
-#if 0
-these functions are unused
-
-/* computes dest = (lhs ** rhs) % mod
-   can have dest, lhs, rhs the same; mod can't be the same as dest
+/* computes dest = (lhs ** rhs) % mod, with Python's sign for the result
+   assumes rhs >= 0, mod != 0
+   can have dest, lhs, rhs, mod the same
 */
 void mpz_pow3_inpl(mpz_t *dest, const mpz_t *lhs, const mpz_t *rhs, const mpz_t *mod) {
-    if (lhs->len == 0 || rhs->neg != 0) {
-        mpz_set_from_int(dest, 0);
-        return;
-    }
-
-    if (rhs->len == 0) {
-        mpz_set_from_int(dest, 1);
-        return;
+    // m = abs(mod), which shares mod's digits so must be copied if dest is mod
+    mpz_t *temp = NULL;
+    if (mod == dest) {
+        mod = temp = mpz_clone(mod);
     }
+    mpz_t m = *mod;
+    m.neg = 0;
 
-    mpz_t *x = mpz_clone(lhs);
-    mpz_t *n = mpz_clone(rhs);
+    mpz_t x; mpz_init_zero(&x);
     mpz_t quo; mpz_init_zero(&quo);
-
-    mpz_set_from_int(dest, 1);
-
-    while (n->len > 0) {
-        if ((n->dig[0] & 1) != 0) {
-            mpz_mul_inpl(dest, dest, x);
-            mpz_divmod_inpl(&quo, dest, dest, mod);
+    mpz_t *n = mpz_clone(rhs);
+    mpz_divmod_inpl(&quo, &x, lhs, &m); // 0 <= x < m
+
+    if ((m.dig[0] & 1) != 0) {
+        // odd modulus: work with Montgomery forms a * R % m, R = DIG_BASE ** len
+        mp_uint_t len = m.len;
+        mpz_dig_t minv = m.dig[0];
+        for (int bits = 3; bits < DIG_SIZE; bits *= 2) {
+            minv = ((mpz_dbl_dig_t)minv * ((2 - (mpz_dbl_dig_t)m.dig[0] * minv) & DIG_MASK)) & DIG_MASK;
         }
-        n->len = mpn_shr(n->dig, n->dig, n->len, 1);
-        if (n->len == 0) {
-            break;
+        minv = (DIG_BASE - minv) & DIG_MASK;
+
+        mpz_dig_t *buf = m_new0(mpz_dig_t, 4 * (len + 2));
+        mpz_dig_t *xr = buf;
+        mpz_dig_t *acc = buf + (len + 2);
+        mpz_dig_t *tmp = buf + 2 * (len + 2);
+        mpz_dig_t *one = buf + 3 * (len + 2);
+
+        // xr = x * R % m and acc = R % m, the Montgomery form of 1
+        mpz_shl_inpl(&x, &x, len * DIG_SIZE);
+        mpz_divmod_inpl(&quo, &x, &x, &m);
+        memcpy(xr, x.dig, x.len * sizeof(mpz_dig_t));
+        mpz_set_from_int(&x, 1);
+        mpz_shl_inpl(&x, &x, len * DIG_SIZE);
+        mpz_divmod_inpl(&quo, &x, &x, &m);
+        memcpy(acc, x.dig, x.len * sizeof(mpz_dig_t));
+
+        // left-to-right binary exponentiation, starting at the top set bit
+        bool started = false;
+        for (mp_uint_t d = n->len; d > 0; --d) {
+            for (int b = DIG_SIZE - 1; b >= 0; --b) {
+                bool bit = (n->dig[d - 1] >> b) & 1;
+                if (started) {
+                    mpn_montmul(tmp, acc, acc, m.dig, len, minv);
+                    if (bit) {
+                        mpn_montmul(acc, tmp, xr, m.dig, len, minv);
+                    } else {
+                        memcpy(acc, tmp, len * sizeof(mpz_dig_t));
+                    }
+                } else if (bit) {
+                    memcpy(acc, xr, len * sizeof(mpz_dig_t));
+                    started = true;
+                }
+            }
         }
-        mpz_mul_inpl(x, x, x);
-        mpz_divmod_inpl(&quo, x, x, mod);
+
+        // convert back from Montgomery form
+        one[0] = 1;
+        mpn_montmul(tmp, acc, one, m.dig, len, minv);
+        mpz_need_dig(dest, len);
+        memcpy(dest->dig, tmp, len * sizeof(mpz_dig_t));
+        dest->len = mpn_remove_trailing_zeros(dest->dig, dest->dig + len);
+        dest->neg = 0;
+        m_del(mpz_dig_t, buf, 4 * (len + 2));
+    } else {
+        // even modulus: reduce after each multiplication
+        mpz_t acc; mpz_init_from_int(&acc, 1);
+        while (n->len > 0) {
+            if ((n->dig[0] & 1) != 0) {
+                mpz_mul_inpl(&acc, &acc, &x);
+                mpz_divmod_inpl(&quo, &acc, &acc, &m);
+            }
+            n->len = mpn_shr(n->dig, n->dig, n->len, 1);
+            if (n->len == 0) {
+                break;
+            }
+            mpz_mul_inpl(&x, &x, &x);
+            mpz_divmod_inpl(&quo, &x, &x, &m);
+        }
+        // reduce again in case the exponent was 0 and m is 1
+        mpz_divmod_inpl(&quo, dest, &acc, &m);
+        mpz_deinit(&acc);
+    }
+
+    // the result takes the sign of mod
+    if (mod->neg && !mpz_is_zero(dest)) {
+        mpz_sub_inpl(dest, dest, &m);
     }
 
+    mpz_deinit(&x);
     mpz_deinit(&quo);
-    mpz_free(x);
     mpz_free(n);
+    mpz_free(temp);
 }
 
+#if 0
+these functions are unused
+
 /* computes gcd(z1, z2)
    based on Knuth's modified gcd algorithm (I think?)
    gcd(z1, z2) >= 0
@@ -1677,41 +1899,52 @@ mp_uint_t mpz_as_str_inpl(const mpz_t *i, mp_uint_t base, const char *prefix, ch
     mpz_dig_t *dig = m_new(mpz_dig_t, ilen);
     memcpy(dig, i->dig, ilen * sizeof(mpz_dig_t));
 
+    // each pass over the digits divides by the largest power of the base that
+    // fits in a digit, giving that many characters at once
+    mpz_dbl_dig_t big_base = base;
+    mp_uint_t chars_per_pass = 1;
+    while (big_base * base <= DIG_MASK) {
+        big_base *= base;
+        ++chars_per_pass;
+    }
+
     // convert
     char *last_comma = str;
-    bool done;
+    mp_uint_t dig_len = ilen;
     do {
-        mpz_dig_t *d = dig + ilen;
+        mpz_dig_t *d = dig + dig_len;
         mpz_dbl_dig_t a = 0;
 
         // compute next remainder
         while (--d >= dig) {
             a = (a << DIG_SIZE) | *d;
-            *d = a / base;
-            a %= base;
+            *d = a / big_base;
+            a %= big_base;
         }
-
-        // convert to character
-        a += '0';
-        if (a > '9') {
-            a += base_char - '9' - 1;
+        while (dig_len > 0 && dig[dig_len - 1] == 0) {
+            --dig_len;
         }
-        *s++ = a;
 
-        // check if number is zero
-        done = true;
-        for (d = dig; d < dig + ilen; ++d) {
-            if (*d != 0) {
-                done = false;
+        for (mp_uint_t n = chars_per_pass; n > 0; --n) {
+            if (comma && (s - last_comma) == 3) {
+                *s++ = comma;
+                last_comma = s;
+            }
+
+            // convert to character
+            mpz_dig_t c = a % base + '0';
+            a /= base;
+            if (c > '9') {
+                c += base_char - '9' - 1;
+            }
+            *s++ = c;
+
+            // the last pass has no leading zeros
+            if (dig_len == 0 && a == 0) {
                 break;
             }
         }
-        if (comma && (s - last_comma) == 3) {
-            *s++ = comma;
-            last_comma = s;
-        }
-    }
-    while (!done);
+    } while (dig_len > 0);
 
     // free the copy of the digits array
     m_del(mpz_dig_t, dig, ilen);
@@ -50,6 +50,10 @@ mp_uint_t mp_convert_obj_to_native(mp_obj_t obj, mp_uint_t type) {
         case MP_NATIVE_TYPE_BOOL:
         case MP_NATIVE_TYPE_INT:
         case MP_NATIVE_TYPE_UINT: return mp_obj_get_int_truncated(obj);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case MP_NATIVE_TYPE_FLOAT: return mp_native_float_op(MP_NATIVE_FLOAT_OP(MP_BINARY_OP_ADD,
+            MP_NATIVE_FLOAT_ARG_OBJ, MP_NATIVE_FLOAT_ARG_FLOAT), (mp_uint_t)obj, 0);
+        #endif
         default: { // cast obj to a pointer
             mp_buffer_info_t bufinfo;
             if (mp_get_buffer(obj, &bufinfo, MP_BUFFER_RW)) {
@@ -74,6 +78,12 @@ mp_obj_t mp_convert_native_to_obj(mp_uint_t val, mp_uint_t type) {
         case MP_NATIVE_TYPE_BOOL: return mp_obj_new_bool(val);
         case MP_NATIVE_TYPE_INT: return mp_obj_new_int(val);
         case MP_NATIVE_TYPE_UINT: return mp_obj_new_int_from_uint(val);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case MP_NATIVE_TYPE_FLOAT: {
+            union { uint32_t u; float f; } v = {val};
+            return mp_obj_new_float(v.f);
+        }
+        #endif
         default: // a pointer
             // we return just the value of the pointer as an integer
             return mp_obj_new_int_from_uint(val);
@@ -93,11 +103,115 @@ mp_obj_t mp_native_call_function_n_kw(mp_obj_t fun_in, mp_uint_t n_args_kw, cons
 // wrapper that makes raise obj and raises it
 // END_FINALLY opcode requires that we don't raise if o==None
 void mp_native_raise(mp_obj_t o) {
+    if (o == MP_OBJ_NULL) {
+        // a bare raise outside an except block
+        mp_raise_msg(&mp_type_RuntimeError, "No active exception to reraise");
+    }
     if (o != mp_const_none) {
         nlr_raise(mp_make_raise_obj(o));
     }
 }
 
+// Resume the delegate of a native yield from, as the VM does, with the value
+// sent in at slots[0] and the value thrown in (if any) at slots[1].  Returns
+// true if the delegate yielded, with the value it yielded put in slots[0],
+// otherwise its return value is put in slots[0].
+bool mp_native_yield_from(mp_obj_t gen, mp_obj_t *slots) {
+    mp_obj_t throw_value = slots[1];
+    mp_obj_t ret_value;
+    mp_vm_return_kind_t ret_kind;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        if (throw_value != MP_OBJ_NULL) {
+            ret_kind = mp_resume(gen, MP_OBJ_NULL, throw_value, &ret_value);
+        } else {
+            ret_kind = mp_resume(gen, slots[0], MP_OBJ_NULL, &ret_value);
+        }
+        nlr_pop();
+    } else {
+        // StopIteration raised by a delegate that isn't a generator is caught
+        // by the VM as its return value, so do the same
+        ret_kind = MP_VM_RETURN_EXCEPTION;
+        ret_value = MP_OBJ_FROM_PTR(nlr.ret_val);
+    }
+    if (ret_kind == MP_VM_RETURN_YIELD) {
+        slots[0] = ret_value;
+        return true;
+    }
+    if (ret_kind == MP_VM_RETURN_NORMAL) {
+        if (ret_value == MP_OBJ_NULL || ret_value == MP_OBJ_STOP_ITERATION) {
+            ret_value = mp_const_none;
+        }
+    } else {
+        assert(ret_kind == MP_VM_RETURN_EXCEPTION);
+        if (!mp_obj_exception_match(ret_value, MP_OBJ_FROM_PTR(&mp_type_StopIteration))) {
+            nlr_raise(ret_value);
+        }
+        ret_value = mp_obj_exception_get_value(ret_value);
+    }
+    // if GeneratorExit was thrown in then it is raised again, even if swallowed
+    if (throw_value != MP_OBJ_NULL && mp_obj_exception_match(throw_value, MP_OBJ_FROM_PTR(&mp_type_GeneratorExit))) {
+        nlr_raise(mp_make_raise_obj(throw_value));
+    }
+    slots[0] = ret_value;
+    return false;
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+
+STATIC float mp_native_float_arg(mp_uint_t kind, mp_uint_t arg) {
+    switch (kind) {
+        case MP_NATIVE_FLOAT_ARG_INT: return (mp_int_t)arg;
+        case MP_NATIVE_FLOAT_ARG_OBJ: return mp_obj_get_float((mp_obj_t)arg);
+        default: {
+            union { uint32_t u; float f; } v = {arg};
+            return v.f;
+        }
+    }
+}
+
+// Viper keeps floats unboxed as the bits of a single-precision float, the
+// same layout as an array('f') element.  This does arithmetic and comparisons
+// on them, unboxing any int or object operand as given by the kinds packed
+// into op (see MP_NATIVE_FLOAT_OP), so that no float objects are created.
+// Comparisons return a bool, truncation an int, and other ops a float.
+mp_uint_t mp_native_float_op(mp_uint_t op, mp_uint_t lhs_in, mp_uint_t rhs_in) {
+    float lhs = mp_native_float_arg((op >> 8) & 3, lhs_in);
+    if ((op & 0xff) == MP_NATIVE_FLOAT_OP_TRUNC) {
+        return (mp_int_t)lhs;
+    }
+    float rhs = mp_native_float_arg((op >> 10) & 3, rhs_in);
+    union { uint32_t u; float f; } ret;
+    switch (op & 0xff) {
+        case MP_BINARY_OP_ADD:
+        case MP_BINARY_OP_INPLACE_ADD: ret.f = lhs + rhs; break;
+        case MP_BINARY_OP_SUBTRACT:
+        case MP_BINARY_OP_INPLACE_SUBTRACT: ret.f = lhs - rhs; break;
+        case MP_BINARY_OP_MULTIPLY:
+        case MP_BINARY_OP_INPLACE_MULTIPLY: ret.f = lhs * rhs; break;
+        case MP_BINARY_OP_TRUE_DIVIDE:
+        case MP_BINARY_OP_INPLACE_TRUE_DIVIDE:
+            if (rhs == 0) {
+                mp_raise_msg(&mp_type_ZeroDivisionError, "division by zero");
+            }
+            ret.f = lhs / rhs;
+            break;
+        case MP_BINARY_OP_LESS: return lhs < rhs;
+        case MP_BINARY_OP_MORE: return lhs > rhs;
+        case MP_BINARY_OP_EQUAL: return lhs == rhs;
+        case MP_BINARY_OP_LESS_EQUAL: return lhs <= rhs;
+        case MP_BINARY_OP_MORE_EQUAL: return lhs >= rhs;
+        case MP_BINARY_OP_NOT_EQUAL: return lhs != rhs;
+        default:
+            // the emitter only passes the ops above
+            assert(0);
+            return 0;
+    }
+    return ret.u;
+}
+
+#endif
+
 // these must correspond to the respective enum in runtime0.h
 void *const mp_fun_table[MP_F_NUMBER_OF] = {
     mp_convert_obj_to_native,
@@ -129,6 +243,7 @@ void *const mp_fun_table[MP_F_NUMBER_OF] = {
     mp_call_method_n_kw_var,
     mp_getiter,
     mp_iternext,
+    mp_for_range_next,
     nlr_push,
     nlr_pop,
     mp_native_raise,
@@ -145,6 +260,10 @@ void *const mp_fun_table[MP_F_NUMBER_OF] = {
     mp_obj_new_cell,
     mp_make_closure_from_raw_code,
     mp_setup_code_state,
+    mp_native_yield_from,
+#if MICROPY_PY_BUILTINS_FLOAT
+    mp_native_float_op,
+#endif
 };
 
 /*
@@ -40,12 +40,13 @@
 __attribute__((naked)) unsigned int nlr_push(nlr_buf_t *nlr) {
 
     __asm volatile (
+#if defined(__ARM_ARCH_6M__)
+    // Thumb-1 can only store the low registers with stm, and would need
+    // them as scratch for the high registers, so store one at a time
     "str    r4, [r0, #12]       \n" // store r4 into nlr_buf
     "str    r5, [r0, #16]       \n" // store r5 into nlr_buf
     "str    r6, [r0, #20]       \n" // store r6 into nlr_buf
     "str    r7, [r0, #24]       \n" // store r7 into nlr_buf
-
-#if defined(__ARM_ARCH_6M__)
     "mov    r1, r8              \n"
     "str    r1, [r0, #28]       \n" // store r8 into nlr_buf
     "mov    r1, r9              \n"
@@ -59,10 +60,8 @@ __attribute__((naked)) unsigned int nlr_push(nlr_buf_t *nlr) {
     "mov    r1, lr              \n"
     "str    r1, [r0, #8]        \n" // store lr into nlr_buf
 #else
-    "str    r8, [r0, #28]       \n" // store r8 into nlr_buf
-    "str    r9, [r0, #32]       \n" // store r9 into nlr_buf
-    "str    r10, [r0, #36]      \n" // store r10 into nlr_buf
-    "str    r11, [r0, #40]      \n" // store r11 into nlr_buf
+    "add    r1, r0, #12         \n" // r1 points to r4 in nlr_buf
+    "stm    r1, {r4-r11}        \n" // store r4-r11 into nlr_buf in one go
     "str    r13, [r0, #44]      \n" // store r13=sp into nlr_buf
     "str    lr, [r0, #8]        \n" // store lr into nlr_buf
 #endif
@@ -97,12 +96,12 @@ NORETURN __attribute__((naked)) void nlr_jump(void *val) {
 
     __asm volatile (
     "mov    r0, %0              \n" // r0 points to nlr_buf
+
+#if defined(__ARM_ARCH_6M__)
     "ldr    r4, [r0, #12]       \n" // load r4 from nlr_buf
     "ldr    r5, [r0, #16]       \n" // load r5 from nlr_buf
     "ldr    r6, [r0, #20]       \n" // load r6 from nlr_buf
     "ldr    r7, [r0, #24]       \n" // load r7 from nlr_buf
-
-#if defined(__ARM_ARCH_6M__)
     "ldr    r1, [r0, #28]       \n" // load r8 from nlr_buf
     "mov    r8, r1              \n"
     "ldr    r1, [r0, #32]       \n" // load r9 from nlr_buf
@@ -116,10 +115,8 @@ NORETURN __attribute__((naked)) void nlr_jump(void *val) {
     "ldr    r1, [r0, #8]        \n" // load lr from nlr_buf
     "mov    lr, r1              \n"
 #else
-    "ldr    r8, [r0, #28]       \n" // load r8 from nlr_buf
-    "ldr    r9, [r0, #32]       \n" // load r9 from nlr_buf
-    "ldr    r10, [r0, #36]      \n" // load r10 from nlr_buf
-    "ldr    r11, [r0, #40]      \n" // load r11 from nlr_buf
+    "add    r1, r0, #12         \n" // r1 points to r4 in nlr_buf
+    "ldm    r1, {r4-r11}        \n" // load r4-r11 from nlr_buf in one go
     "ldr    r13, [r0, #44]      \n" // load r13=sp from nlr_buf
     "ldr    lr, [r0, #8]        \n" // load lr from nlr_buf
 #endif
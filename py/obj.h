@@ -356,7 +356,8 @@ typedef struct _mp_map_t {
     mp_uint_t all_keys_are_qstrs : 1;
     mp_uint_t is_fixed : 1;     // a fixed array that can't be modified; must also be ordered
     mp_uint_t is_ordered : 1;   // an ordered array
-    mp_uint_t used : (8 * sizeof(mp_uint_t) - 3);
+    mp_uint_t is_compact : 1;   // a hash table of dense entries plus indices; never ordered
+    mp_uint_t used : (8 * sizeof(mp_uint_t) - 4);
     mp_uint_t alloc;
     mp_map_elem_t *table;
 } mp_map_t;
@@ -373,14 +374,20 @@ extern const mp_map_t mp_const_empty_map;
 
 static inline bool MP_MAP_SLOT_IS_FILLED(const mp_map_t *map, mp_uint_t pos) { return ((map)->table[pos].key != MP_OBJ_NULL && (map)->table[pos].key != MP_OBJ_SENTINEL); }
 
+mp_uint_t mp_map_alloc_hint(mp_uint_t n, bool is_compact);
 void mp_map_init(mp_map_t *map, mp_uint_t n);
 void mp_map_init_fixed_table(mp_map_t *map, mp_uint_t n, const mp_obj_t *table);
+void mp_map_init_copy(mp_map_t *map, const mp_map_t *src);
 mp_map_t *mp_map_new(mp_uint_t n);
 void mp_map_deinit(mp_map_t *map);
 void mp_map_free(mp_map_t *map);
 mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind);
+mp_map_elem_t *mp_map_store(mp_map_t *map, mp_obj_t index, mp_obj_t value);
 void mp_map_clear(mp_map_t *map);
 void mp_map_dump(mp_map_t *map);
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+void mp_map_lock_init(void);
+#endif
 
 // Underlying set implementation (not set object)
 
@@ -526,6 +533,8 @@ extern const mp_obj_type_t mp_type_enumerate;
 extern const mp_obj_type_t mp_type_filter;
 extern const mp_obj_type_t mp_type_dict;
 extern const mp_obj_type_t mp_type_ordereddict;
+extern const mp_obj_type_t mp_type_deque;
+extern const mp_obj_type_t mp_type_ringio;
 extern const mp_obj_type_t mp_type_range;
 extern const mp_obj_type_t mp_type_set;
 extern const mp_obj_type_t mp_type_frozenset;
@@ -596,6 +605,7 @@ extern const struct _mp_obj_singleton_t mp_const_ellipsis_obj;
 extern const struct _mp_obj_singleton_t mp_const_notimplemented_obj;
 extern const struct _mp_obj_exception_t mp_const_MemoryError_obj;
 extern const struct _mp_obj_exception_t mp_const_GeneratorExit_obj;
+extern const struct _mp_obj_exception_t mp_const_StopIteration_obj;
 
 // General API for objects
 
@@ -726,6 +736,7 @@ mp_obj_t mp_obj_list_append(mp_obj_t self_in, mp_obj_t arg);
 mp_obj_t mp_obj_list_remove(mp_obj_t self_in, mp_obj_t value);
 void mp_obj_list_get(mp_obj_t self_in, mp_uint_t *len, mp_obj_t **items);
 void mp_obj_list_set_len(mp_obj_t self_in, mp_uint_t len);
+void mp_obj_list_reserve(mp_obj_t self_in, mp_uint_t n);
 void mp_obj_list_store(mp_obj_t self_in, mp_obj_t index, mp_obj_t value);
 mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs);
 
@@ -740,6 +751,7 @@ mp_obj_t mp_obj_dict_get(mp_obj_t self_in, mp_obj_t index);
 mp_obj_t mp_obj_dict_store(mp_obj_t self_in, mp_obj_t key, mp_obj_t value);
 mp_obj_t mp_obj_dict_delete(mp_obj_t self_in, mp_obj_t key);
 mp_map_t *mp_obj_dict_get_map(mp_obj_t self_in);
+bool mp_obj_is_dict_items_iter(mp_obj_t o_in);
 
 // set
 void mp_obj_set_store(mp_obj_t self_in, mp_obj_t item);
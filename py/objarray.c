@@ -32,6 +32,7 @@
 #include "py/nlr.h"
 #include "py/runtime0.h"
 #include "py/runtime.h"
+#include "py/smallint.h"
 #include "py/binary.h"
 #include "py/objstr.h"
 #include "py/objarray.h"
@@ -113,6 +114,82 @@ STATIC mp_obj_array_t *array_new(char typecode, mp_uint_t n) {
 }
 #endif
 
+#if MICROPY_PY_ARRAY_VECTOR_OPS
+// Bulk arithmetic on arrays.  Each operation is written once as a macro over
+// the element type and expanded for every supported typecode, so the inner
+// loops are plain C over typed pointers which the compiler is free to unroll
+// and vectorise for the target.  Integer arithmetic is done unsigned so that
+// results wrap to the element size, as storing with a[i] = x would.
+
+#define ARRAY_VEC_CASES_INT(OP) \
+    case 'b': OP(signed char) break; \
+    case BYTEARRAY_TYPECODE: case 'B': OP(unsigned char) break; \
+    case 'h': OP(short) break; \
+    case 'H': OP(unsigned short) break; \
+    case 'i': OP(int) break; \
+    case 'I': OP(unsigned int) break; \
+    case 'l': OP(long) break; \
+    case 'L': OP(unsigned long) break;
+#if MICROPY_PY_BUILTINS_FLOAT
+#define ARRAY_VEC_CASES_FLOAT(OP) \
+    case 'f': OP(float) break; \
+    case 'd': OP(double) break;
+#else
+#define ARRAY_VEC_CASES_FLOAT(OP)
+#endif
+
+#define ARRAY_VEC_IS_FLOAT(typecode) ((typecode) == 'f' || (typecode) == 'd')
+// signed integer typecodes are lower case, and bytearray's is 0
+#define ARRAY_VEC_IS_SIGNED(typecode) ((typecode) >= 'a')
+
+STATIC bool array_vec_typecode_ok(char typecode) {
+    switch (typecode) {
+        case BYTEARRAY_TYPECODE: case 'b': case 'B': case 'h': case 'H':
+        case 'i': case 'I': case 'l': case 'L':
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case 'f': case 'd':
+        #endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+STATIC void array_vec_check_typecode(char typecode) {
+    if (!array_vec_typecode_ok(typecode)) {
+        mp_raise_msg(&mp_type_TypeError, "unsupported typecode");
+    }
+}
+
+STATIC long long array_vec_get_int(char typecode, const void *p, size_t i) {
+    #define OP(T) return ((const T*)p)[i];
+    switch (typecode) { ARRAY_VEC_CASES_INT(OP) }
+    #undef OP
+    return 0;
+}
+
+STATIC void array_vec_set_int(char typecode, void *p, size_t i, long long val) {
+    #define OP(T) ((T*)p)[i] = (T)val;
+    switch (typecode) { ARRAY_VEC_CASES_INT(OP) }
+    #undef OP
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+STATIC mp_float_t array_vec_get_float(char typecode, const void *p, size_t i) {
+    #define OP(T) return ((const T*)p)[i];
+    switch (typecode) { ARRAY_VEC_CASES_INT(OP) ARRAY_VEC_CASES_FLOAT(OP) }
+    #undef OP
+    return 0;
+}
+
+STATIC void array_vec_set_float(char typecode, void *p, size_t i, mp_float_t val) {
+    #define OP(T) ((T*)p)[i] = (T)val;
+    switch (typecode) { ARRAY_VEC_CASES_INT(OP) ARRAY_VEC_CASES_FLOAT(OP) }
+    #undef OP
+}
+#endif
+#endif // MICROPY_PY_ARRAY_VECTOR_OPS
+
 #if MICROPY_PY_BUILTINS_BYTEARRAY || MICROPY_PY_ARRAY
 STATIC mp_obj_t array_construct(char typecode, mp_obj_t initializer) {
     // bytearrays can be raw-initialised from anything with the buffer protocol
@@ -133,6 +210,31 @@ STATIC mp_obj_t array_construct(char typecode, mp_obj_t initializer) {
         return MP_OBJ_FROM_PTR(o);
     }
 
+    #if MICROPY_PY_ARRAY_VECTOR_OPS
+    // convert from an array of another typecode without boxing each element
+    if (MICROPY_PY_ARRAY && typecode != BYTEARRAY_TYPECODE
+        && (MP_OBJ_IS_TYPE(initializer, &mp_type_array)
+            || (MICROPY_PY_BUILTINS_MEMORYVIEW && MP_OBJ_IS_TYPE(initializer, &mp_type_memoryview)))
+        && array_vec_typecode_ok(typecode)
+        && mp_get_buffer(initializer, &bufinfo, MP_BUFFER_READ)
+        && array_vec_typecode_ok(bufinfo.typecode)) {
+        mp_uint_t len = bufinfo.len / mp_binary_get_size('@', bufinfo.typecode, NULL);
+        mp_obj_array_t *o = array_new(typecode, len);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (ARRAY_VEC_IS_FLOAT(typecode) || ARRAY_VEC_IS_FLOAT(bufinfo.typecode)) {
+            for (mp_uint_t i = 0; i < len; i++) {
+                array_vec_set_float(typecode, o->items, i, array_vec_get_float(bufinfo.typecode, bufinfo.buf, i));
+            }
+            return MP_OBJ_FROM_PTR(o);
+        }
+        #endif
+        for (mp_uint_t i = 0; i < len; i++) {
+            array_vec_set_int(typecode, o->items, i, array_vec_get_int(bufinfo.typecode, bufinfo.buf, i));
+        }
+        return MP_OBJ_FROM_PTR(o);
+    }
+    #endif
+
     mp_uint_t len;
     // Try to create array of exact len if initializer len is known
     mp_obj_t len_in = mp_obj_len_maybe(initializer);
@@ -233,6 +335,213 @@ STATIC mp_obj_t memoryview_make_new(const mp_obj_type_t *type_in, size_t n_args,
 
     return MP_OBJ_FROM_PTR(self);
 }
+
+#if MICROPY_PY_BUILTINS_MEMORYVIEW_CAST
+// memoryview.cast(typecode[, shape]) reinterprets the items of a memoryview
+// in place.  Given a shape of (rows, cols) the result is a 2D view, which is a
+// separate object type so that the 1D memoryview stays 4 words in size.  A 2D
+// view indexed by a row gives a 1D memoryview of that row, indexed by
+// (row, col) gives an item, and sliced in both dimensions gives a view of a
+// sub-rectangle whose rows are stride items apart in the underlying buffer.
+typedef struct _mp_obj_memoryview_2d_t {
+    mp_obj_base_t base;
+    mp_uint_t typecode; // top bit set if writable, as for memoryview
+    mp_uint_t offset; // in items, to the first item of the first row
+    mp_uint_t rows;
+    mp_uint_t cols;
+    mp_uint_t stride; // in items, between the starts of consecutive rows
+    void *items; // start of the original buffer, to keep it alive
+} mp_obj_memoryview_2d_t;
+
+STATIC const mp_obj_type_t mp_type_memoryview_2d;
+
+STATIC mp_obj_t memoryview_cast(size_t n_args, const mp_obj_t *args) {
+    mp_obj_array_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_uint_t len;
+    const char *typecode_str = mp_obj_str_get_data(args[1], &len);
+    size_t new_sz = 0;
+    if (len == 1 && typecode_str[0] != 'O') {
+        new_sz = mp_binary_get_size('@', typecode_str[0], NULL);
+    }
+    if (new_sz == 0) {
+        mp_raise_msg(&mp_type_ValueError, "bad typecode");
+    }
+    mp_uint_t typecode = typecode_str[0] | (self->typecode & 0x80);
+
+    // the view must hold a whole number of items of the new type, and unlike
+    // CPython must start on one so that the items are aligned
+    size_t old_sz = mp_binary_get_size('@', self->typecode & TYPECODE_MASK, NULL);
+    size_t start = (mp_uint_t)self->free * old_sz;
+    size_t nbytes = self->len * old_sz;
+    if (nbytes % new_sz != 0) {
+        mp_raise_msg(&mp_type_TypeError, "length is not a multiple of itemsize");
+    }
+    if (start % new_sz != 0) {
+        mp_raise_ValueError("memoryview not aligned to itemsize");
+    }
+    mp_uint_t nitems = nbytes / new_sz;
+
+    if (n_args == 2) {
+        mp_obj_array_t *res = MP_OBJ_TO_PTR(mp_obj_new_memoryview(typecode, nitems, self->items));
+        res->free = start / new_sz;
+        return MP_OBJ_FROM_PTR(res);
+    }
+
+    mp_obj_t *shape;
+    mp_obj_get_array_fixed_n(args[2], 2, &shape);
+    mp_int_t rows = mp_obj_get_int(shape[0]);
+    mp_int_t cols = mp_obj_get_int(shape[1]);
+    if (rows < 0 || cols < 0 || (mp_uint_t)(rows * cols) != nitems) {
+        mp_raise_msg(&mp_type_TypeError, "shape doesn't match buffer size");
+    }
+    mp_obj_memoryview_2d_t *res = m_new_obj(mp_obj_memoryview_2d_t);
+    res->base.type = &mp_type_memoryview_2d;
+    res->typecode = typecode;
+    res->offset = start / new_sz;
+    res->rows = rows;
+    res->cols = cols;
+    res->stride = cols;
+    res->items = self->items;
+    return MP_OBJ_FROM_PTR(res);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(memoryview_cast_obj, 2, 3, memoryview_cast);
+
+STATIC const mp_rom_map_elem_t memoryview_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_cast), MP_ROM_PTR(&memoryview_cast_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(memoryview_locals_dict, memoryview_locals_dict_table);
+
+STATIC mp_obj_t memoryview_2d_unary_op(mp_uint_t op, mp_obj_t self_in) {
+    mp_obj_memoryview_2d_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(self->rows != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(self->rows);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+STATIC mp_obj_t memoryview_2d_row(mp_obj_memoryview_2d_t *self, mp_uint_t row, mp_uint_t col, mp_uint_t ncols) {
+    mp_obj_array_t *res = MP_OBJ_TO_PTR(mp_obj_new_memoryview(self->typecode, ncols, self->items));
+    res->free = self->offset + row * self->stride + col;
+    return MP_OBJ_FROM_PTR(res);
+}
+
+STATIC mp_obj_t memoryview_2d_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
+    mp_obj_memoryview_2d_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value == MP_OBJ_NULL) {
+        return MP_OBJ_NULL; // delete not supported
+    }
+
+    mp_obj_t row_in = index_in;
+    mp_obj_t col_in = MP_OBJ_NULL;
+    if (MP_OBJ_IS_TYPE(index_in, &mp_type_tuple)) {
+        mp_obj_t *index;
+        mp_obj_get_array_fixed_n(index_in, 2, &index);
+        row_in = index[0];
+        col_in = index[1];
+    }
+
+    bool row_is_slice = MP_OBJ_IS_TYPE(row_in, &mp_type_slice);
+    bool col_is_slice = col_in != MP_OBJ_NULL && MP_OBJ_IS_TYPE(col_in, &mp_type_slice);
+    if (row_is_slice || col_is_slice) {
+        if (value != MP_OBJ_SENTINEL) {
+            return MP_OBJ_NULL; // store to a slice not supported
+        }
+        mp_bound_slice_t rs = { 0, self->rows, 1 };
+        mp_bound_slice_t cs = { 0, self->cols, 1 };
+        if ((row_is_slice && !mp_seq_get_fast_slice_indexes(self->rows, row_in, &rs))
+            || (col_is_slice && !mp_seq_get_fast_slice_indexes(self->cols, col_in, &cs))) {
+            mp_not_implemented("only slices with step=1 (aka None) are supported");
+        }
+        if (!row_is_slice) {
+            // part of a single row, which is contiguous
+            mp_uint_t row = mp_get_index(self->base.type, self->rows, row_in, false);
+            return memoryview_2d_row(self, row, cs.start, cs.stop - cs.start);
+        }
+        if (col_in != MP_OBJ_NULL && !col_is_slice) {
+            mp_not_implemented("column of a 2D memoryview");
+        }
+        mp_obj_memoryview_2d_t *res = m_new_obj(mp_obj_memoryview_2d_t);
+        *res = *self;
+        res->offset += rs.start * self->stride + cs.start;
+        res->rows = rs.stop - rs.start;
+        res->cols = cs.stop - cs.start;
+        return MP_OBJ_FROM_PTR(res);
+    }
+
+    mp_uint_t row = mp_get_index(self->base.type, self->rows, row_in, false);
+    if (col_in == MP_OBJ_NULL) {
+        if (value != MP_OBJ_SENTINEL) {
+            return MP_OBJ_NULL; // store to a whole row not supported
+        }
+        return memoryview_2d_row(self, row, 0, self->cols);
+    }
+    mp_uint_t col = mp_get_index(self->base.type, self->cols, col_in, false);
+    mp_uint_t index = self->offset + row * self->stride + col;
+    if (value == MP_OBJ_SENTINEL) {
+        return mp_binary_get_val_array(self->typecode & TYPECODE_MASK, self->items, index);
+    }
+    if ((self->typecode & 0x80) == 0) {
+        return MP_OBJ_NULL; // store to read-only memoryview
+    }
+    mp_binary_set_val_array(self->typecode & TYPECODE_MASK, self->items, index, value);
+    return mp_const_none;
+}
+
+typedef struct _mp_obj_memoryview_2d_it_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_memoryview_2d_t *view;
+    mp_uint_t cur;
+} mp_obj_memoryview_2d_it_t;
+
+STATIC mp_obj_t memoryview_2d_it_iternext(mp_obj_t self_in) {
+    mp_obj_memoryview_2d_it_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->cur >= self->view->rows) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    return memoryview_2d_row(self->view, self->cur++, 0, self->view->cols);
+}
+
+STATIC mp_obj_t memoryview_2d_getiter(mp_obj_t self_in) {
+    mp_obj_memoryview_2d_it_t *o = m_new_obj(mp_obj_memoryview_2d_it_t);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = memoryview_2d_it_iternext;
+    o->view = MP_OBJ_TO_PTR(self_in);
+    o->cur = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_int_t memoryview_2d_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags) {
+    mp_obj_memoryview_2d_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->rows > 1 && self->stride != self->cols) {
+        // not contiguous
+        return 1;
+    }
+    if ((self->typecode & 0x80) == 0 && (flags & MP_BUFFER_WRITE)) {
+        // read-only memoryview
+        return 1;
+    }
+    size_t sz = mp_binary_get_size('@', self->typecode & TYPECODE_MASK, NULL);
+    bufinfo->buf = (uint8_t*)self->items + self->offset * sz;
+    bufinfo->len = self->rows * self->cols * sz;
+    bufinfo->typecode = self->typecode & TYPECODE_MASK;
+    return 0;
+}
+
+STATIC const mp_rom_obj_tuple_t memoryview_2d_bases_tuple = {{&mp_type_tuple}, 1, {MP_ROM_PTR(&mp_type_memoryview)}};
+
+STATIC const mp_obj_type_t mp_type_memoryview_2d = {
+    { &mp_type_type },
+    .name = MP_QSTR_memoryview,
+    .unary_op = memoryview_2d_unary_op,
+    .subscr = memoryview_2d_subscr,
+    .getiter = memoryview_2d_getiter,
+    .buffer_p = { .get_buffer = memoryview_2d_get_buffer },
+    .bases_tuple = (mp_obj_tuple_t*)&memoryview_2d_bases_tuple,
+};
+#endif // MICROPY_PY_BUILTINS_MEMORYVIEW_CAST
 #endif
 
 STATIC mp_obj_t array_unary_op(mp_uint_t op, mp_obj_t o_in) {
@@ -366,6 +675,180 @@ STATIC mp_obj_t array_extend(mp_obj_t self_in, mp_obj_t arg_in) {
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(array_extend_obj, array_extend);
+
+#if MICROPY_PY_ARRAY_VECTOR_OPS
+// get the items of an array-like operand, which must have the same typecode
+// and length as self
+STATIC const void *array_vec_get_operand(mp_obj_array_t *self, mp_obj_t arg) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(arg, &bufinfo, MP_BUFFER_READ);
+    char typecode = bufinfo.typecode == BYTEARRAY_TYPECODE ? 'B' : bufinfo.typecode;
+    char self_typecode = self->typecode == BYTEARRAY_TYPECODE ? 'B' : self->typecode;
+    if (typecode != self_typecode
+        || bufinfo.len != self->len * mp_binary_get_size('@', self->typecode, NULL)) {
+        mp_raise_ValueError("array mismatch");
+    }
+    return bufinfo.buf;
+}
+
+STATIC mp_obj_t array_vec_new_int(unsigned long long val, char typecode) {
+    if (ARRAY_VEC_IS_SIGNED(typecode)) {
+        long long sval = val;
+        if (MP_SMALL_INT_MIN <= sval && sval <= MP_SMALL_INT_MAX) {
+            return MP_OBJ_NEW_SMALL_INT(sval);
+        }
+        return mp_obj_new_int_from_ll(sval);
+    } else {
+        if (val <= MP_SMALL_INT_MAX) {
+            return MP_OBJ_NEW_SMALL_INT(val);
+        }
+        return mp_obj_new_int_from_ull(val);
+    }
+}
+
+STATIC mp_obj_t array_vec_arith(mp_obj_t self_in, mp_obj_t arg, bool is_mul) {
+    mp_obj_array_t *self = MP_OBJ_TO_PTR(self_in);
+    char typecode = self->typecode;
+    void *items = self->items;
+    size_t n = self->len;
+    array_vec_check_typecode(typecode);
+
+    #define ARRAY_VEC_APPLY(T, W, X) { \
+        T *a = items; \
+        if (is_mul) { \
+            for (size_t i = 0; i < n; i++) { a[i] = (T)((W)a[i] * (X)); } \
+        } else { \
+            for (size_t i = 0; i < n; i++) { a[i] = (T)((W)a[i] + (X)); } \
+        } \
+    }
+
+    if (MP_OBJ_IS_INT(arg) && !ARRAY_VEC_IS_FLOAT(typecode)) {
+        mp_uint_t x = mp_obj_get_int_truncated(arg);
+        #define OP(T) ARRAY_VEC_APPLY(T, mp_uint_t, x)
+        switch (typecode) { ARRAY_VEC_CASES_INT(OP) }
+        #undef OP
+    #if MICROPY_PY_BUILTINS_FLOAT
+    } else if (MP_OBJ_IS_INT(arg) || mp_obj_is_float(arg)) {
+        // integer elements scaled by a float are truncated towards zero
+        mp_float_t x = mp_obj_get_float(arg);
+        #define OP(T) ARRAY_VEC_APPLY(T, mp_float_t, x)
+        switch (typecode) { ARRAY_VEC_CASES_INT(OP) ARRAY_VEC_CASES_FLOAT(OP) }
+        #undef OP
+    #endif
+    } else {
+        const void *b = array_vec_get_operand(self, arg);
+        #define OP(T) ARRAY_VEC_APPLY(T, mp_uint_t, (mp_uint_t)((const T*)b)[i])
+        #define OP_FLOAT(T) ARRAY_VEC_APPLY(T, T, ((const T*)b)[i])
+        switch (typecode) { ARRAY_VEC_CASES_INT(OP) ARRAY_VEC_CASES_FLOAT(OP_FLOAT) }
+        #undef OP
+        #undef OP_FLOAT
+    }
+
+    #undef ARRAY_VEC_APPLY
+    return mp_const_none;
+}
+
+STATIC mp_obj_t array_vec_add(mp_obj_t self_in, mp_obj_t arg) {
+    return array_vec_arith(self_in, arg, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(array_vec_add_obj, array_vec_add);
+
+STATIC mp_obj_t array_vec_mul(mp_obj_t self_in, mp_obj_t arg) {
+    return array_vec_arith(self_in, arg, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(array_vec_mul_obj, array_vec_mul);
+
+// sum of the elements, or with other given the sum of their products
+STATIC mp_obj_t array_vec_sum_prod(mp_obj_t self_in, mp_obj_t other_in) {
+    mp_obj_array_t *self = MP_OBJ_TO_PTR(self_in);
+    char typecode = self->typecode;
+    const void *items = self->items;
+    size_t n = self->len;
+    array_vec_check_typecode(typecode);
+    const void *b = NULL;
+    if (other_in != MP_OBJ_NULL) {
+        b = array_vec_get_operand(self, other_in);
+    }
+
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (ARRAY_VEC_IS_FLOAT(typecode)) {
+        mp_float_t acc = 0;
+        #define OP(T) { \
+            const T *a = items; \
+            if (b == NULL) { \
+                for (size_t i = 0; i < n; i++) { acc += (mp_float_t)a[i]; } \
+            } else { \
+                for (size_t i = 0; i < n; i++) { acc += (mp_float_t)a[i] * (mp_float_t)((const T*)b)[i]; } \
+            } \
+        }
+        switch (typecode) { ARRAY_VEC_CASES_FLOAT(OP) }
+        #undef OP
+        return mp_obj_new_float(acc);
+    }
+    #endif
+
+    unsigned long long acc = 0;
+    #define OP(T) { \
+        const T *a = items; \
+        if (b == NULL) { \
+            for (size_t i = 0; i < n; i++) { acc += (unsigned long long)a[i]; } \
+        } else { \
+            for (size_t i = 0; i < n; i++) { \
+                acc += (unsigned long long)a[i] * (unsigned long long)((const T*)b)[i]; \
+            } \
+        } \
+    }
+    switch (typecode) { ARRAY_VEC_CASES_INT(OP) }
+    #undef OP
+    return array_vec_new_int(acc, typecode);
+}
+
+STATIC mp_obj_t array_vec_sum(mp_obj_t self_in) {
+    return array_vec_sum_prod(self_in, MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(array_vec_sum_obj, array_vec_sum);
+
+STATIC mp_obj_t array_vec_dot(mp_obj_t self_in, mp_obj_t other_in) {
+    return array_vec_sum_prod(self_in, other_in);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(array_vec_dot_obj, array_vec_dot);
+
+STATIC mp_obj_t array_vec_minmax(mp_obj_t self_in, bool is_max) {
+    mp_obj_array_t *self = MP_OBJ_TO_PTR(self_in);
+    char typecode = self->typecode;
+    const void *items = self->items;
+    size_t n = self->len;
+    array_vec_check_typecode(typecode);
+    if (n == 0) {
+        mp_raise_ValueError("empty array");
+    }
+
+    size_t best = 0;
+    #define OP(T) { \
+        const T *a = items; \
+        T val = a[0]; \
+        if (is_max) { \
+            for (size_t i = 1; i < n; i++) { if (a[i] > val) { val = a[i]; best = i; } } \
+        } else { \
+            for (size_t i = 1; i < n; i++) { if (a[i] < val) { val = a[i]; best = i; } } \
+        } \
+    }
+    switch (typecode) { ARRAY_VEC_CASES_INT(OP) ARRAY_VEC_CASES_FLOAT(OP) }
+    #undef OP
+
+    return mp_binary_get_val_array(typecode, self->items, best);
+}
+
+STATIC mp_obj_t array_vec_min(mp_obj_t self_in) {
+    return array_vec_minmax(self_in, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(array_vec_min_obj, array_vec_min);
+
+STATIC mp_obj_t array_vec_max(mp_obj_t self_in) {
+    return array_vec_minmax(self_in, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(array_vec_max_obj, array_vec_max);
+#endif // MICROPY_PY_ARRAY_VECTOR_OPS
 #endif
 
 STATIC mp_obj_t array_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
@@ -516,6 +999,14 @@ STATIC mp_int_t array_get_buffer(mp_obj_t o_in, mp_buffer_info_t *bufinfo, mp_ui
 STATIC const mp_rom_map_elem_t array_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_append), MP_ROM_PTR(&array_append_obj) },
     { MP_ROM_QSTR(MP_QSTR_extend), MP_ROM_PTR(&array_extend_obj) },
+    #if MICROPY_PY_ARRAY_VECTOR_OPS
+    { MP_ROM_QSTR(MP_QSTR_add), MP_ROM_PTR(&array_vec_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mul), MP_ROM_PTR(&array_vec_mul_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sum), MP_ROM_PTR(&array_vec_sum_obj) },
+    { MP_ROM_QSTR(MP_QSTR_dot), MP_ROM_PTR(&array_vec_dot_obj) },
+    { MP_ROM_QSTR(MP_QSTR_min), MP_ROM_PTR(&array_vec_min_obj) },
+    { MP_ROM_QSTR(MP_QSTR_max), MP_ROM_PTR(&array_vec_max_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(array_locals_dict, array_locals_dict_table);
@@ -561,6 +1052,9 @@ const mp_obj_type_t mp_type_memoryview = {
     .binary_op = array_binary_op,
     .subscr = array_subscr,
     .buffer_p = { .get_buffer = array_get_buffer },
+    #if MICROPY_PY_BUILTINS_MEMORYVIEW_CAST
+    .locals_dict = (mp_obj_dict_t*)&memoryview_locals_dict,
+    #endif
 };
 #endif
 
@@ -0,0 +1,300 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "py/runtime0.h"
+#include "py/runtime.h"
+
+#if MICROPY_PY_COLLECTIONS_DEQUE
+
+// A deque is a ring buffer: the items are items[head], items[head + 1], ...
+// wrapping around at alloc.  The buffer doubles when full and halves when a
+// quarter full, so it never holds much more than its peak length for long.
+typedef struct _mp_obj_deque_t {
+    mp_obj_base_t base;
+    size_t alloc;
+    size_t head;
+    size_t len;
+    size_t maxlen; // (size_t)-1 if unbounded
+    mp_obj_t *items;
+} mp_obj_deque_t;
+
+#define DEQUE_MIN_ALLOC (4)
+#define DEQUE_UNBOUNDED ((size_t)-1)
+
+static inline size_t deque_index(mp_obj_deque_t *self, size_t i) {
+    i += self->head;
+    return i < self->alloc ? i : i - self->alloc;
+}
+
+STATIC void deque_resize(mp_obj_deque_t *self, size_t new_alloc) {
+    mp_obj_t *items = m_new(mp_obj_t, new_alloc);
+    size_t n_top = self->alloc - self->head;
+    if (n_top >= self->len) {
+        memcpy(items, self->items + self->head, self->len * sizeof(mp_obj_t));
+    } else {
+        memcpy(items, self->items + self->head, n_top * sizeof(mp_obj_t));
+        memcpy(items + n_top, self->items, (self->len - n_top) * sizeof(mp_obj_t));
+    }
+    mp_seq_clear(items, self->len, new_alloc, sizeof(*items));
+    m_del(mp_obj_t, self->items, self->alloc);
+    self->items = items;
+    self->alloc = new_alloc;
+    self->head = 0;
+}
+
+// Make room for one more item, evicting one from the other end if the deque
+// is at its maxlen.  Returns false if the item should be dropped.
+STATIC bool deque_make_room(mp_obj_deque_t *self, bool at_right) {
+    if (self->len == self->maxlen) {
+        if (self->len == 0) {
+            return false;
+        }
+        if (at_right) {
+            self->items[self->head] = MP_OBJ_NULL;
+            self->head = deque_index(self, 1);
+        } else {
+            self->items[deque_index(self, self->len - 1)] = MP_OBJ_NULL;
+        }
+        self->len -= 1;
+    } else if (self->len == self->alloc) {
+        size_t new_alloc = 2 * self->alloc;
+        if (new_alloc > self->maxlen) {
+            new_alloc = self->maxlen;
+        }
+        deque_resize(self, new_alloc);
+    }
+    return true;
+}
+
+STATIC void deque_shrink(mp_obj_deque_t *self) {
+    if (self->alloc > DEQUE_MIN_ALLOC && self->len < self->alloc / 4) {
+        deque_resize(self, self->alloc / 2);
+    }
+}
+
+STATIC mp_obj_t deque_append(mp_obj_t self_in, mp_obj_t arg) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    if (deque_make_room(self, true)) {
+        self->items[deque_index(self, self->len)] = arg;
+        self->len += 1;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_append_obj, deque_append);
+
+STATIC mp_obj_t deque_appendleft(mp_obj_t self_in, mp_obj_t arg) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    if (deque_make_room(self, false)) {
+        self->head = self->head == 0 ? self->alloc - 1 : self->head - 1;
+        self->items[self->head] = arg;
+        self->len += 1;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_appendleft_obj, deque_appendleft);
+
+STATIC mp_obj_t deque_pop(mp_obj_t self_in) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->len == 0) {
+        mp_raise_msg(&mp_type_IndexError, "pop from an empty deque");
+    }
+    self->len -= 1;
+    size_t i = deque_index(self, self->len);
+    mp_obj_t ret = self->items[i];
+    self->items[i] = MP_OBJ_NULL;
+    deque_shrink(self);
+    return ret;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(deque_pop_obj, deque_pop);
+
+STATIC mp_obj_t deque_popleft(mp_obj_t self_in) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->len == 0) {
+        mp_raise_msg(&mp_type_IndexError, "pop from an empty deque");
+    }
+    mp_obj_t ret = self->items[self->head];
+    self->items[self->head] = MP_OBJ_NULL;
+    self->head = deque_index(self, 1);
+    self->len -= 1;
+    deque_shrink(self);
+    return ret;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(deque_popleft_obj, deque_popleft);
+
+STATIC mp_obj_t deque_extend(mp_obj_t self_in, mp_obj_t iterable) {
+    mp_obj_t iter = mp_getiter(iterable);
+    mp_obj_t item;
+    while ((item = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+        deque_append(self_in, item);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_extend_obj, deque_extend);
+
+STATIC mp_obj_t deque_extendleft(mp_obj_t self_in, mp_obj_t iterable) {
+    mp_obj_t iter = mp_getiter(iterable);
+    mp_obj_t item;
+    while ((item = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+        deque_appendleft(self_in, item);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(deque_extendleft_obj, deque_extendleft);
+
+STATIC mp_obj_t deque_clear(mp_obj_t self_in) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    m_del(mp_obj_t, self->items, self->alloc);
+    self->alloc = self->maxlen < DEQUE_MIN_ALLOC ? self->maxlen : DEQUE_MIN_ALLOC;
+    self->items = m_new0(mp_obj_t, self->alloc);
+    self->head = 0;
+    self->len = 0;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(deque_clear_obj, deque_clear);
+
+STATIC mp_obj_t deque_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_iterable, ARG_maxlen };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_PTR(&mp_const_empty_tuple_obj)} },
+        { MP_QSTR_maxlen, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_PTR(&mp_const_none_obj)} },
+    };
+    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
+
+    size_t maxlen = DEQUE_UNBOUNDED;
+    if (vals[ARG_maxlen].u_obj != mp_const_none) {
+        mp_int_t n = mp_obj_get_int(vals[ARG_maxlen].u_obj);
+        if (n < 0) {
+            mp_raise_ValueError("maxlen must be >= 0");
+        }
+        maxlen = n;
+    }
+
+    mp_obj_deque_t *o = m_new_obj(mp_obj_deque_t);
+    o->base.type = type;
+    o->maxlen = maxlen;
+    o->items = NULL;
+    o->alloc = 0;
+    deque_clear(MP_OBJ_FROM_PTR(o));
+    deque_extend(MP_OBJ_FROM_PTR(o), vals[ARG_iterable].u_obj);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC void deque_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_print_str(print, "deque([");
+    for (size_t i = 0; i < self->len; i++) {
+        if (i > 0) {
+            mp_print_str(print, ", ");
+        }
+        mp_obj_print_helper(print, self->items[deque_index(self, i)], PRINT_REPR);
+    }
+    mp_print_str(print, "]");
+    if (self->maxlen != DEQUE_UNBOUNDED) {
+        mp_printf(print, ", maxlen=%u", (uint)self->maxlen);
+    }
+    mp_print_str(print, ")");
+}
+
+STATIC mp_obj_t deque_unary_op(mp_uint_t op, mp_obj_t self_in) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(self->len != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(self->len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+STATIC mp_obj_t deque_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
+    mp_obj_deque_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value == MP_OBJ_NULL) {
+        // delete not supported
+        return MP_OBJ_NULL;
+    }
+    size_t i = deque_index(self, mp_get_index(self->base.type, self->len, index, false));
+    if (value == MP_OBJ_SENTINEL) {
+        // load
+        return self->items[i];
+    } else {
+        // store
+        self->items[i] = value;
+        return mp_const_none;
+    }
+}
+
+typedef struct _mp_obj_deque_it_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_t deque;
+    size_t cur;
+} mp_obj_deque_it_t;
+
+STATIC mp_obj_t deque_it_iternext(mp_obj_t self_in) {
+    mp_obj_deque_it_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_deque_t *deque = MP_OBJ_TO_PTR(self->deque);
+    if (self->cur >= deque->len) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    return deque->items[deque_index(deque, self->cur++)];
+}
+
+STATIC mp_obj_t deque_getiter(mp_obj_t self_in) {
+    mp_obj_deque_it_t *o = m_new_obj(mp_obj_deque_it_t);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = deque_it_iternext;
+    o->deque = self_in;
+    o->cur = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC const mp_rom_map_elem_t deque_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_append), MP_ROM_PTR(&deque_append_obj) },
+    { MP_ROM_QSTR(MP_QSTR_appendleft), MP_ROM_PTR(&deque_appendleft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&deque_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_extend), MP_ROM_PTR(&deque_extend_obj) },
+    { MP_ROM_QSTR(MP_QSTR_extendleft), MP_ROM_PTR(&deque_extendleft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pop), MP_ROM_PTR(&deque_pop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_popleft), MP_ROM_PTR(&deque_popleft_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(deque_locals_dict, deque_locals_dict_table);
+
+const mp_obj_type_t mp_type_deque = {
+    { &mp_type_type },
+    .name = MP_QSTR_deque,
+    .print = deque_print,
+    .make_new = deque_make_new,
+    .unary_op = deque_unary_op,
+    .subscr = deque_subscr,
+    .getiter = deque_getiter,
+    .locals_dict = (mp_obj_dict_t*)&deque_locals_dict,
+};
+
+#endif // MICROPY_PY_COLLECTIONS_DEQUE
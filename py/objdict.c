@@ -83,12 +83,21 @@ STATIC void dict_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_
 }
 
 STATIC mp_obj_t dict_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
-    mp_obj_t dict_out = mp_obj_new_dict(0);
+    // allocate the table once if the number of entries is known up front
+    mp_uint_t n = n_kw;
+    if (n_args == 1) {
+        mp_obj_t len = mp_obj_len_maybe(args[0]);
+        if (len != MP_OBJ_NULL) {
+            n += MP_OBJ_SMALL_INT_VALUE(len);
+        }
+    }
+    mp_obj_t dict_out = mp_obj_new_dict(mp_map_alloc_hint(n, MICROPY_OPT_MAP_COMPACT));
     mp_obj_dict_t *dict = MP_OBJ_TO_PTR(dict_out);
     dict->base.type = type;
     #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
     if (type == &mp_type_ordereddict) {
-        dict->map.is_ordered = 1;
+        // a compact map already keeps its entries in insertion order
+        dict->map.is_ordered = !dict->map.is_compact;
     }
     #endif
     if (n_args > 0 || n_kw > 0) {
@@ -235,14 +244,10 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(dict_clear_obj, dict_clear);
 STATIC mp_obj_t dict_copy(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_DICT_TYPE(self_in));
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_obj_t other_out = mp_obj_new_dict(self->map.alloc);
+    mp_obj_t other_out = mp_obj_new_dict(0);
     mp_obj_dict_t *other = MP_OBJ_TO_PTR(other_out);
     other->base.type = self->base.type;
-    other->map.used = self->map.used;
-    other->map.all_keys_are_qstrs = self->map.all_keys_are_qstrs;
-    other->map.is_fixed = 0;
-    other->map.is_ordered = self->map.is_ordered;
-    memcpy(other->map.table, self->map.table, self->map.alloc * sizeof(mp_map_elem_t));
+    mp_map_init_copy(&other->map, &self->map);
     return other_out;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(dict_copy_obj, dict_copy);
@@ -370,7 +375,7 @@ STATIC mp_obj_t dict_update(size_t n_args, const mp_obj_t *args, mp_map_t *kwarg
                 mp_uint_t cur = 0;
                 mp_map_elem_t *elem = NULL;
                 while ((elem = dict_iter_next((mp_obj_dict_t*)MP_OBJ_TO_PTR(args[1]), &cur)) != NULL) {
-                    mp_map_lookup(&self->map, elem->key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = elem->value;
+                    mp_map_store(&self->map, elem->key, elem->value);
                 }
             }
         } else {
@@ -387,7 +392,7 @@ STATIC mp_obj_t dict_update(size_t n_args, const mp_obj_t *args, mp_map_t *kwarg
                     || stop != MP_OBJ_STOP_ITERATION) {
                     mp_raise_msg(&mp_type_ValueError, "dictionary update sequence has the wrong length");
                 } else {
-                    mp_map_lookup(&self->map, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+                    mp_map_store(&self->map, key, value);
                 }
             }
         }
@@ -396,7 +401,7 @@ STATIC mp_obj_t dict_update(size_t n_args, const mp_obj_t *args, mp_map_t *kwarg
     // update the dict with any keyword args
     for (mp_uint_t i = 0; i < kwargs->alloc; i++) {
         if (MP_MAP_SLOT_IS_FILLED(kwargs, i)) {
-            mp_map_lookup(&self->map, kwargs->table[i].key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = kwargs->table[i].value;
+            mp_map_store(&self->map, kwargs->table[i].key, kwargs->table[i].value);
         }
     }
 
@@ -461,6 +466,13 @@ STATIC const mp_obj_type_t dict_view_it_type = {
     .iternext = dict_view_it_iternext,
 };
 
+// Whether o_in iterates over dict.items(), which makes a new tuple for each
+// item; keys() and values() hand out objects that the dict itself refers to
+bool mp_obj_is_dict_items_iter(mp_obj_t o_in) {
+    return MP_OBJ_IS_TYPE(o_in, &dict_view_it_type)
+        && ((mp_obj_dict_view_it_t*)MP_OBJ_TO_PTR(o_in))->kind == MP_DICT_VIEW_ITEMS;
+}
+
 STATIC mp_obj_t dict_view_getiter(mp_obj_t view_in) {
     mp_check_self(MP_OBJ_IS_TYPE(view_in, &dict_view_type));
     mp_obj_dict_view_t *view = MP_OBJ_TO_PTR(view_in);
@@ -609,7 +621,7 @@ mp_uint_t mp_obj_dict_len(mp_obj_t self_in) {
 mp_obj_t mp_obj_dict_store(mp_obj_t self_in, mp_obj_t key, mp_obj_t value) {
     mp_check_self(MP_OBJ_IS_DICT_TYPE(self_in));
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_map_lookup(&self->map, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+    mp_map_store(&self->map, key, value);
     return self_in;
 }
 
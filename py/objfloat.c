@@ -67,12 +67,10 @@ STATIC void float_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_t
     mp_float_t o_val = mp_obj_float_get(o_in);
 #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
     char buf[16];
-    const int precision = 7;
 #else
     char buf[32];
-    const int precision = 16;
 #endif
-    mp_format_float(o_val, buf, sizeof(buf), 'g', precision, '\0');
+    mp_format_float_repr(o_val, buf, sizeof(buf));
     mp_print_str(print, buf);
     if (strchr(buf, '.') == NULL && strchr(buf, 'e') == NULL && strchr(buf, 'n') == NULL) {
         // Python floats always have decimal point (unless inf or nan)
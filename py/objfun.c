@@ -31,6 +31,7 @@
 #include "py/nlr.h"
 #include "py/objtuple.h"
 #include "py/objfun.h"
+#include "py/compile.h"
 #include "py/runtime0.h"
 #include "py/runtime.h"
 #include "py/bc.h"
@@ -151,6 +152,7 @@ qstr mp_obj_code_get_name(const byte *code_info) {
 
 #if MICROPY_EMIT_NATIVE
 STATIC const mp_obj_type_t mp_type_fun_native;
+STATIC mp_obj_t fun_native_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args);
 #endif
 
 qstr mp_obj_fun_get_name(mp_const_obj_t fun_in) {
@@ -232,9 +234,67 @@ mp_code_state_t *mp_obj_fun_bc_prepare_codestate(mp_obj_t self_in, size_t n_args
 }
 #endif
 
+#if MICROPY_EMIT_NATIVE_TIERED
+// Count a call of the function, returning the native version of it once there
+// is one.  The native function is a copy of this one so that frames already
+// running the bytecode are left alone.
+STATIC mp_obj_t fun_bc_tier_up(mp_obj_fun_bc_t *self) {
+    if (!MP_OBJ_IS_SMALL_INT(self->tier)) {
+        return self->tier == mp_const_none ? MP_OBJ_NULL : self->tier;
+    }
+    mp_uint_t n_calls = MP_OBJ_SMALL_INT_VALUE(self->tier) + 1;
+    if (n_calls < MP_STATE_VM(native_tier_threshold)) {
+        self->tier = MP_OBJ_NEW_SMALL_INT(n_calls);
+        return MP_OBJ_NULL;
+    }
+
+    // only try once, whatever happens
+    self->tier = mp_const_none;
+    mp_raw_code_t *rc = mp_compile_native_tier(self->bytecode);
+    if (rc == NULL) {
+        return MP_OBJ_NULL;
+    }
+
+    const byte *ip = self->bytecode;
+    mp_decode_uint(&ip); // skip n_state
+    mp_decode_uint(&ip); // skip n_exc_stack
+    size_t n_extra_args = ip[3] + ((ip[0] & MP_SCOPE_FLAG_DEFKWARGS) != 0);
+    mp_obj_fun_bc_t *o = m_new_obj_var(mp_obj_fun_bc_t, mp_obj_t, n_extra_args);
+    memcpy(o, self, sizeof(mp_obj_fun_bc_t) + n_extra_args * sizeof(mp_obj_t));
+    o->base.type = &mp_type_fun_native;
+    o->bytecode = rc->data.u_native.fun_data;
+    o->const_table = rc->data.u_native.const_table;
+    self->tier = MP_OBJ_FROM_PTR(o);
+    return self->tier;
+}
+#endif
+
+#if MICROPY_PY_MICROPYTHON_TRACE
+STATIC mp_obj_t fun_bc_call_untraced(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args);
+
+// Go through the call tracer only while it's enabled.
+STATIC mp_obj_t fun_bc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    if (MP_STATE_VM(trace_enabled)) {
+        return mp_trace_call(fun_bc_call_untraced, self_in, n_args, n_kw, args);
+    }
+    return fun_bc_call_untraced(self_in, n_args, n_kw, args);
+}
+
+STATIC mp_obj_t fun_bc_call_untraced(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+#else
 STATIC mp_obj_t fun_bc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+#endif
     MP_STACK_CHECK();
 
+    #if MICROPY_EMIT_NATIVE_TIERED
+    if (MP_STATE_VM(native_tier_threshold) != 0) {
+        mp_obj_t native = fun_bc_tier_up(MP_OBJ_TO_PTR(self_in));
+        if (native != MP_OBJ_NULL) {
+            return fun_native_call(native, n_args, n_kw, args);
+        }
+    }
+    #endif
+
     DEBUG_printf("Input n_args: " UINT_FMT ", n_kw: " UINT_FMT "\n", n_args, n_kw);
     DEBUG_printf("Input pos args: ");
     dump_args(args, n_args);
@@ -361,11 +421,19 @@ mp_obj_t mp_obj_new_fun_bc(mp_obj_t def_args_in, mp_obj_t def_kw_args, const byt
     if (def_kw_args != MP_OBJ_NULL) {
         n_extra_args += 1;
     }
-    mp_obj_fun_bc_t *o = m_new_obj_var(mp_obj_fun_bc_t, mp_obj_t, n_extra_args);
+    mp_obj_fun_bc_t *o;
+    if (mp_import_is_toplevel()) {
+        o = m_new_obj_var_ll(mp_obj_fun_bc_t, mp_obj_t, n_extra_args);
+    } else {
+        o = m_new_obj_var(mp_obj_fun_bc_t, mp_obj_t, n_extra_args);
+    }
     o->base.type = &mp_type_fun_bc;
     o->globals = mp_globals_get();
     o->bytecode = code;
     o->const_table = const_table;
+    #if MICROPY_EMIT_NATIVE_TIERED
+    o->tier = MP_OBJ_NEW_SMALL_INT(0);
+    #endif
     if (def_args != NULL) {
         memcpy(o->extra_args, def_args->items, n_def_args * sizeof(mp_obj_t));
     }
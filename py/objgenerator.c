@@ -26,6 +26,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "py/nlr.h"
@@ -46,12 +47,106 @@ typedef struct _mp_obj_gen_wrap_t {
 typedef struct _mp_obj_gen_instance_t {
     mp_obj_base_t base;
     mp_obj_dict_t *globals;
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    // The frame is allocated separately so that, once the generator finishes,
+    // it can be reused by a new generator that needs one of the same size.
+    // code_state is NULL while the generator runs and after it finishes, and
+    // frame_nbytes is 0 once it has finished.
+    mp_code_state_t *code_state;
+    size_t frame_nbytes;
+    const byte *code_info; // for printing
+    #else
     mp_code_state_t code_state;
+    #endif
 } mp_obj_gen_instance_t;
 
+#if MICROPY_OPT_GEN_FRAME_POOL
+
+#define GEN_CODE_STATE(self) ((self)->code_state)
+
+// Get a zeroed frame for a new generator, from the pool if it has one of the
+// right size.
+STATIC mp_code_state_t *gen_frame_new(size_t nbytes) {
+    for (size_t i = 0; i < MICROPY_OPT_GEN_FRAME_POOL; i++) {
+        if (MP_STATE_THREAD(gen_frame_pool_nbytes)[i] == nbytes) {
+            mp_code_state_t *code_state = MP_STATE_THREAD(gen_frame_pool)[i];
+            MP_STATE_THREAD(gen_frame_pool)[i] = NULL;
+            MP_STATE_THREAD(gen_frame_pool_nbytes)[i] = 0;
+            return code_state;
+        }
+    }
+    return m_new_obj_var(mp_code_state_t, byte, nbytes - sizeof(mp_code_state_t));
+}
+
+// Mark a generator as finished and give its frame to the pool.  The frame is
+// cleared so that it doesn't keep the generator's locals alive.  If the pool
+// is full then the frame is left to the GC.
+STATIC void gen_frame_release(mp_obj_gen_instance_t *self, mp_code_state_t *code_state) {
+    size_t nbytes = self->frame_nbytes;
+    self->code_state = NULL;
+    self->frame_nbytes = 0;
+    for (size_t i = 0; i < MICROPY_OPT_GEN_FRAME_POOL; i++) {
+        if (MP_STATE_THREAD(gen_frame_pool_nbytes)[i] == 0) {
+            memset(code_state, 0, nbytes);
+            MP_STATE_THREAD(gen_frame_pool)[i] = code_state;
+            MP_STATE_THREAD(gen_frame_pool_nbytes)[i] = nbytes;
+            return;
+        }
+    }
+}
+
+STATIC mp_obj_gen_instance_t *gen_instance_new(mp_obj_fun_bc_t *self_fun, size_t nbytes) {
+    mp_obj_gen_instance_t *o = m_new_obj(mp_obj_gen_instance_t);
+    o->base.type = &mp_type_gen_instance;
+    o->globals = self_fun->globals;
+    o->code_state = gen_frame_new(nbytes);
+    o->frame_nbytes = nbytes;
+    return o;
+}
+
+#else
+
+#define GEN_CODE_STATE(self) (&(self)->code_state)
+
+STATIC mp_obj_gen_instance_t *gen_instance_new(mp_obj_fun_bc_t *self_fun, size_t nbytes) {
+    mp_obj_gen_instance_t *o = m_new_obj_var(mp_obj_gen_instance_t, byte, nbytes - sizeof(mp_code_state_t));
+    o->base.type = &mp_type_gen_instance;
+    o->globals = self_fun->globals;
+    return o;
+}
+
+#endif
+
+#if MICROPY_EMIT_NATIVE
+// The code of a native generator begins with its state size and the offset to
+// its prelude, followed by the function that resumes it.  The exc_sp of its
+// code_state is NULL, to tell it from a bytecode generator.
+STATIC mp_obj_t native_gen_wrap_call(mp_obj_fun_bc_t *self_fun, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    const mp_uint_t *data = (const mp_uint_t*)self_fun->bytecode;
+    mp_uint_t n_state = data[0];
+
+    mp_obj_gen_instance_t *o = gen_instance_new(self_fun, sizeof(mp_code_state_t) + n_state * sizeof(mp_obj_t));
+    mp_code_state_t *code_state = GEN_CODE_STATE(o);
+    code_state->n_state = n_state;
+    code_state->ip = (const byte*)(uintptr_t)data[1]; // offset to prelude
+    mp_setup_code_state(code_state, self_fun, n_args, n_kw, args);
+    code_state->exc_sp = NULL;
+    code_state->ip = (const byte*)&data[2];
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    o->code_info = code_state->code_info;
+    #endif
+    return MP_OBJ_FROM_PTR(o);
+}
+#endif
+
 STATIC mp_obj_t gen_wrap_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_obj_gen_wrap_t *self = MP_OBJ_TO_PTR(self_in);
     mp_obj_fun_bc_t *self_fun = (mp_obj_fun_bc_t*)self->fun;
+    #if MICROPY_EMIT_NATIVE
+    if (self_fun->base.type != &mp_type_fun_bc) {
+        return native_gen_wrap_call(self_fun, n_args, n_kw, args);
+    }
+    #endif
     assert(self_fun->base.type == &mp_type_fun_bc);
 
     // get start of bytecode
@@ -62,14 +157,15 @@ STATIC mp_obj_t gen_wrap_call(mp_obj_t self_in, size_t n_args, size_t n_kw, cons
     mp_uint_t n_exc_stack = mp_decode_uint(&ip);
 
     // allocate the generator object, with room for local stack and exception stack
-    mp_obj_gen_instance_t *o = m_new_obj_var(mp_obj_gen_instance_t, byte,
-        n_state * sizeof(mp_obj_t) + n_exc_stack * sizeof(mp_exc_stack_t));
-    o->base.type = &mp_type_gen_instance;
-
-    o->globals = self_fun->globals;
-    o->code_state.n_state = n_state;
-    o->code_state.ip = (byte*)(ip - self_fun->bytecode); // offset to prelude
-    mp_setup_code_state(&o->code_state, self_fun, n_args, n_kw, args);
+    mp_obj_gen_instance_t *o = gen_instance_new(self_fun, sizeof(mp_code_state_t)
+        + n_state * sizeof(mp_obj_t) + n_exc_stack * sizeof(mp_exc_stack_t));
+    mp_code_state_t *code_state = GEN_CODE_STATE(o);
+    code_state->n_state = n_state;
+    code_state->ip = (byte*)(ip - self_fun->bytecode); // offset to prelude
+    mp_setup_code_state(code_state, self_fun, n_args, n_kw, args);
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    o->code_info = code_state->code_info;
+    #endif
     return MP_OBJ_FROM_PTR(o);
 }
 
@@ -92,29 +188,62 @@ mp_obj_t mp_obj_new_gen_wrap(mp_obj_t fun) {
 STATIC void gen_instance_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     (void)kind;
     mp_obj_gen_instance_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_printf(print, "<generator object '%q' at %p>", mp_obj_code_get_name(self->code_state.code_info), self);
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    const byte *code_info = self->code_info;
+    #else
+    const byte *code_info = self->code_state.code_info;
+    #endif
+    mp_printf(print, "<generator object '%q' at %p>", mp_obj_code_get_name(code_info), self);
 }
 
 mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, mp_obj_t *ret_val) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_gen_instance));
     mp_obj_gen_instance_t *self = MP_OBJ_TO_PTR(self_in);
-    if (self->code_state.ip == 0) {
+    mp_code_state_t *code_state = GEN_CODE_STATE(self);
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    if (code_state == NULL) {
+        if (self->frame_nbytes != 0) {
+            // the frame is in use further up the stack, and would be given
+            // to another generator if this call finished the generator
+            mp_raise_ValueError("generator already executing");
+        }
         // Trying to resume already stopped generator
         *ret_val = MP_OBJ_STOP_ITERATION;
         return MP_VM_RETURN_NORMAL;
     }
-    if (self->code_state.sp == self->code_state.state - 1) {
+    #else
+    if (code_state->ip == 0) {
+        // Trying to resume already stopped generator
+        *ret_val = MP_OBJ_STOP_ITERATION;
+        return MP_VM_RETURN_NORMAL;
+    }
+    #endif
+    if (code_state->sp == code_state->state - 1) {
         if (send_value != mp_const_none) {
             mp_raise_msg(&mp_type_TypeError, "can't send non-None value to a just-started generator");
         }
     } else {
-        *self->code_state.sp = send_value;
+        *code_state->sp = send_value;
     }
     mp_obj_dict_t *old_globals = mp_globals_get();
     mp_globals_set(self->globals);
-    mp_vm_return_kind_t ret_kind = mp_execute_bytecode(&self->code_state, throw_value);
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    self->code_state = NULL;
+    #endif
+    mp_vm_return_kind_t ret_kind;
+    #if MICROPY_EMIT_NATIVE
+    if (code_state->exc_sp == NULL) {
+        // native generator, see native_gen_wrap_call
+        ret_kind = ((mp_vm_return_kind_t(*)(mp_code_state_t*, mp_obj_t))
+            MICROPY_MAKE_POINTER_CALLABLE(code_state->ip))(code_state, throw_value);
+    } else
+    #endif
+    {
+        ret_kind = mp_execute_bytecode(code_state, throw_value);
+    }
     mp_globals_set(old_globals);
 
+    bool finished = true;
     switch (ret_kind) {
         case MP_VM_RETURN_NORMAL:
         default:
@@ -123,33 +252,43 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
             // again and again, leading to side effects.
             // TODO: check how return with value behaves under such conditions
             // in CPython.
-            self->code_state.ip = 0;
-            *ret_val = *self->code_state.sp;
+            *ret_val = *code_state->sp;
             break;
 
         case MP_VM_RETURN_YIELD:
-            *ret_val = *self->code_state.sp;
-            if (*ret_val == MP_OBJ_STOP_ITERATION) {
-                self->code_state.ip = 0;
-            }
+            *ret_val = *code_state->sp;
+            finished = *ret_val == MP_OBJ_STOP_ITERATION;
             break;
 
         case MP_VM_RETURN_EXCEPTION:
-            self->code_state.ip = 0;
-            *ret_val = self->code_state.state[self->code_state.n_state - 1];
+            *ret_val = code_state->state[code_state->n_state - 1];
             break;
     }
 
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    if (finished) {
+        gen_frame_release(self, code_state);
+    } else {
+        self->code_state = code_state;
+    }
+    #else
+    if (finished) {
+        code_state->ip = 0;
+    }
+    #endif
+
     return ret_kind;
 }
 
-STATIC mp_obj_t gen_resume_and_raise(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value) {
+// If keep_value is false then the generator's return value is dropped, which
+// is what iteration wants, and no StopIteration needs to be created for it.
+STATIC mp_obj_t gen_resume_and_raise(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, bool keep_value) {
     mp_obj_t ret;
     switch (mp_obj_gen_resume(self_in, send_value, throw_value, &ret)) {
         case MP_VM_RETURN_NORMAL:
         default:
             // Optimize return w/o value in case generator is used in for loop
-            if (ret == mp_const_none || ret == MP_OBJ_STOP_ITERATION) {
+            if (ret == mp_const_none || ret == MP_OBJ_STOP_ITERATION || !keep_value) {
                 return MP_OBJ_STOP_ITERATION;
             } else {
                 nlr_raise(mp_obj_new_exception_args(&mp_type_StopIteration, 1, &ret));
@@ -176,28 +315,30 @@ STATIC mp_obj_t gen_resume_and_raise(mp_obj_t self_in, mp_obj_t send_value, mp_o
 }
 
 STATIC mp_obj_t gen_instance_iternext(mp_obj_t self_in) {
-    return gen_resume_and_raise(self_in, mp_const_none, MP_OBJ_NULL);
+    return gen_resume_and_raise(self_in, mp_const_none, MP_OBJ_NULL, false);
 }
 
-STATIC mp_obj_t gen_instance_send(mp_obj_t self_in, mp_obj_t send_value) {
-    mp_obj_t ret = gen_resume_and_raise(self_in, send_value, MP_OBJ_NULL);
+// This is also next() for a generator, which unlike iteration must raise
+// StopIteration with the generator's return value.
+mp_obj_t mp_obj_gen_send(mp_obj_t self_in, mp_obj_t send_value) {
+    mp_obj_t ret = gen_resume_and_raise(self_in, send_value, MP_OBJ_NULL, true);
     if (ret == MP_OBJ_STOP_ITERATION) {
-        nlr_raise(mp_obj_new_exception(&mp_type_StopIteration));
+        nlr_raise(MP_OBJ_FROM_PTR(&mp_const_StopIteration_obj));
     } else {
         return ret;
     }
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(gen_instance_send_obj, gen_instance_send);
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(gen_instance_send_obj, mp_obj_gen_send);
 
 STATIC mp_obj_t gen_instance_close(mp_obj_t self_in);
 STATIC mp_obj_t gen_instance_throw(size_t n_args, const mp_obj_t *args) {
     mp_obj_t exc = (n_args == 2) ? args[1] : args[2];
     exc = mp_make_raise_obj(exc);
 
-    mp_obj_t ret = gen_resume_and_raise(args[0], mp_const_none, exc);
+    mp_obj_t ret = gen_resume_and_raise(args[0], mp_const_none, exc, true);
     if (ret == MP_OBJ_STOP_ITERATION) {
-        nlr_raise(mp_obj_new_exception(&mp_type_StopIteration));
+        nlr_raise(MP_OBJ_FROM_PTR(&mp_const_StopIteration_obj));
     } else {
         return ret;
     }
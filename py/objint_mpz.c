@@ -322,6 +322,37 @@ mp_obj_t mp_obj_int_binary_op(mp_uint_t op, mp_obj_t lhs_in, mp_obj_t rhs_in) {
     }
 }
 
+// computes pow(base, exponent, modulus) for int arguments
+mp_obj_t mp_obj_int_pow3(mp_obj_t base, mp_obj_t exponent, mp_obj_t modulus) {
+    mpz_t z_int[3];
+    const mpz_t *z[3];
+    mp_obj_t args[3] = {base, exponent, modulus};
+    for (int i = 0; i < 3; ++i) {
+        if (MP_OBJ_IS_SMALL_INT(args[i])) {
+            mpz_init_from_int(&z_int[i], MP_OBJ_SMALL_INT_VALUE(args[i]));
+            z[i] = &z_int[i];
+        } else {
+            mpz_init_zero(&z_int[i]);
+            z[i] = &((mp_obj_int_t*)MP_OBJ_TO_PTR(args[i]))->mpz;
+        }
+    }
+
+    if (z[1]->neg) {
+        mp_raise_ValueError("pow() 2nd argument cannot be negative");
+    }
+    if (mpz_is_zero(z[2])) {
+        mp_raise_ValueError("pow() 3rd argument cannot be 0");
+    }
+
+    mp_obj_int_t *res = mp_obj_int_new_mpz();
+    mpz_pow3_inpl(&res->mpz, z[0], z[1], z[2]);
+
+    for (int i = 0; i < 3; ++i) {
+        mpz_deinit(&z_int[i]);
+    }
+    return MP_OBJ_FROM_PTR(res);
+}
+
 mp_obj_t mp_obj_new_int(mp_int_t value) {
     if (MP_SMALL_INT_FITS(value)) {
         return MP_OBJ_NEW_SMALL_INT(value);
@@ -31,7 +31,6 @@
 #include "py/objlist.h"
 #include "py/runtime0.h"
 #include "py/runtime.h"
-#include "py/stackctrl.h"
 
 STATIC mp_obj_t mp_obj_new_list_iterator(mp_obj_t list, mp_uint_t cur);
 STATIC mp_obj_list_t *list_new(mp_uint_t n);
@@ -44,6 +43,36 @@ STATIC mp_obj_t list_pop(size_t n_args, const mp_obj_t *args);
 /******************************************************************************/
 /* list                                                                       */
 
+// Make room for at least n items.  The array grows by half each time so that
+// a run of appends costs amortised O(1) without overshooting as far as
+// doubling would.
+STATIC void list_grow(mp_obj_list_t *self, mp_uint_t n) {
+    if (n <= self->alloc) {
+        return;
+    }
+    mp_uint_t new_alloc = self->alloc + self->alloc / 2;
+    if (new_alloc < n) {
+        new_alloc = n;
+    }
+    self->items = m_renew(mp_obj_t, self->items, self->alloc, new_alloc);
+    mp_seq_clear(self->items, self->alloc, new_alloc, sizeof(*self->items));
+    self->alloc = new_alloc;
+}
+
+// Give back memory once the list has dropped to a quarter of its array,
+// keeping room for it to double again, so that a list used as a queue
+// doesn't keep holding its peak size nor reallocate on every push and pop.
+STATIC void list_shrink(mp_obj_list_t *self) {
+    if (self->alloc > LIST_MIN_ALLOC && self->len < self->alloc / 4) {
+        mp_uint_t new_alloc = 2 * self->len;
+        if (new_alloc < LIST_MIN_ALLOC) {
+            new_alloc = LIST_MIN_ALLOC;
+        }
+        self->items = m_renew(mp_obj_t, self->items, self->alloc, new_alloc);
+        self->alloc = new_alloc;
+    }
+}
+
 STATIC void list_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_t kind) {
     mp_obj_list_t *o = MP_OBJ_TO_PTR(o_in);
     if (!(MICROPY_PY_UJSON && kind == PRINT_JSON)) {
@@ -79,9 +108,13 @@ STATIC mp_obj_t list_make_new(const mp_obj_type_t *type_in, size_t n_args, size_
 
         case 1:
         default: {
-            // make list from iterable
-            // TODO: optimize list/tuple
+            // make list from iterable, allocating all of it at once if its
+            // length is known
             mp_obj_t list = mp_obj_new_list(0, NULL);
+            mp_obj_t len = mp_obj_len_maybe(args[0]);
+            if (len != MP_OBJ_NULL) {
+                mp_obj_list_reserve(list, MP_OBJ_SMALL_INT_VALUE(len));
+            }
             return list_extend_from_iter(list, args[0]);
         }
     }
@@ -166,6 +199,7 @@ STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
             // Clear "freed" elements at the end of list
             mp_seq_clear(self->items, self->len + len_adj, self->len, sizeof(*self->items));
             self->len += len_adj;
+            list_shrink(self);
             return mp_const_none;
         }
 #endif
@@ -201,12 +235,7 @@ STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
             mp_int_t len_adj = slice->len - (slice_out.stop - slice_out.start);
             //printf("Len adj: %d\n", len_adj);
             if (len_adj > 0) {
-                if (self->len + len_adj > self->alloc) {
-                    // TODO: Might optimize memory copies here by checking if block can
-                    // be grown inplace or not
-                    self->items = m_renew(mp_obj_t, self->items, self->alloc, self->len + len_adj);
-                    self->alloc = self->len + len_adj;
-                }
+                list_grow(self, self->len + len_adj);
                 mp_seq_replace_slice_grow_inplace(self->items, self->len,
                     slice_out.start, slice_out.stop, slice->items, slice->len, len_adj, sizeof(*self->items));
             } else {
@@ -214,9 +243,9 @@ STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
                     slice_out.start, slice_out.stop, slice->items, slice->len, sizeof(*self->items));
                 // Clear "freed" elements at the end of list
                 mp_seq_clear(self->items, self->len + len_adj, self->len, sizeof(*self->items));
-                // TODO: apply allocation policy re: alloc_size
             }
             self->len += len_adj;
+            list_shrink(self);
             return mp_const_none;
         }
 #endif
@@ -232,11 +261,7 @@ STATIC mp_obj_t list_getiter(mp_obj_t o_in) {
 mp_obj_t mp_obj_list_append(mp_obj_t self_in, mp_obj_t arg) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
-    if (self->len >= self->alloc) {
-        self->items = m_renew(mp_obj_t, self->items, self->alloc, self->alloc * 2);
-        self->alloc *= 2;
-        mp_seq_clear(self->items, self->len + 1, self->alloc, sizeof(*self->items));
-    }
+    list_grow(self, self->len + 1);
     self->items[self->len++] = arg;
     return mp_const_none; // return None, as per CPython
 }
@@ -247,13 +272,7 @@ STATIC mp_obj_t list_extend(mp_obj_t self_in, mp_obj_t arg_in) {
         mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
         mp_obj_list_t *arg = MP_OBJ_TO_PTR(arg_in);
 
-        if (self->len + arg->len > self->alloc) {
-            // TODO: use alloc policy for "4"
-            self->items = m_renew(mp_obj_t, self->items, self->alloc, self->len + arg->len + 4);
-            self->alloc = self->len + arg->len + 4;
-            mp_seq_clear(self->items, self->len + arg->len, self->alloc, sizeof(*self->items));
-        }
-
+        list_grow(self, self->len + arg->len);
         memcpy(self->items + self->len, arg->items, sizeof(mp_obj_t) * arg->len);
         self->len += arg->len;
     } else {
@@ -274,42 +293,213 @@ STATIC mp_obj_t list_pop(size_t n_args, const mp_obj_t *args) {
     memmove(self->items + index, self->items + index + 1, (self->len - index) * sizeof(mp_obj_t));
     // Clear stale pointer from slot which just got freed to prevent GC issues
     self->items[self->len] = MP_OBJ_NULL;
-    if (self->alloc > LIST_MIN_ALLOC && self->alloc > 2 * self->len) {
-        self->items = m_renew(mp_obj_t, self->items, self->alloc, self->alloc/2);
-        self->alloc /= 2;
-    }
+    list_shrink(self);
     return ret;
 }
 
-STATIC void mp_quicksort(mp_obj_t *head, mp_obj_t *tail, mp_obj_t key_fn, mp_obj_t binop_less_result) {
-    MP_STACK_CHECK();
-    while (head < tail) {
-        mp_obj_t *h = head - 1;
-        mp_obj_t *t = tail;
-        mp_obj_t v = key_fn == MP_OBJ_NULL ? tail[0] : mp_call_function_1(key_fn, tail[0]); // get pivot using key_fn
-        for (;;) {
-            do ++h; while (h < t && mp_binary_op(MP_BINARY_OP_LESS, key_fn == MP_OBJ_NULL ? h[0] : mp_call_function_1(key_fn, h[0]), v) == binop_less_result);
-            do --t; while (h < t && mp_binary_op(MP_BINARY_OP_LESS, v, key_fn == MP_OBJ_NULL ? t[0] : mp_call_function_1(key_fn, t[0])) == binop_less_result);
-            if (h >= t) break;
-            mp_obj_t x = h[0];
-            h[0] = t[0];
-            t[0] = x;
+// Sorting is a stable merge sort of the runs already in the list, a cut-down
+// timsort without galloping. Presorted and reversed input takes n - 1
+// comparisons, and it needs no recursion. An element is w words: 1 for just
+// the item, or 2 for its key then the item when there's a key function, so
+// that each key is computed once.
+
+// Runs shorter than this are extended with a binary insertion sort.
+#define LIST_SORT_MIN_MERGE (32)
+// With each pending run more than the next two together, there can be no more
+// pending runs than this.
+#define LIST_SORT_MAX_RUNS (sizeof(size_t) * 8 * 3 / 2)
+
+typedef struct _list_sort_t {
+    mp_obj_t *base;
+    mp_obj_t *tmp; // room for half of the elements, made at the first merge
+    size_t len;
+    size_t w;
+    bool reverse;
+} list_sort_t;
+
+// Whether element a has to go before element b.
+STATIC bool list_sort_lt(const list_sort_t *s, const mp_obj_t *a, const mp_obj_t *b) {
+    if (s->reverse) {
+        const mp_obj_t *t = a;
+        a = b;
+        b = t;
+    }
+    return mp_obj_is_true(mp_binary_op(MP_BINARY_OP_LESS, *a, *b));
+}
+
+// The length of the run at the start of base, which has n > 1 elements. A
+// strictly descending run is reversed; keeping equal elements out of it
+// keeps the sort stable.
+STATIC size_t list_sort_run(const list_sort_t *s, mp_obj_t *base, size_t n) {
+    size_t w = s->w;
+    size_t len = 2;
+    if (list_sort_lt(s, base + w, base)) {
+        while (len < n && list_sort_lt(s, base + len * w, base + (len - 1) * w)) {
+            len += 1;
         }
-        mp_obj_t x = h[0];
-        h[0] = tail[0];
-        tail[0] = x;
-        // do the smaller recursive call first, to keep stack within O(log(N))
-        if (t - head < tail - h - 1) {
-            mp_quicksort(head, t, key_fn, binop_less_result);
-            head = h + 1;
-        } else {
-            mp_quicksort(h + 1, tail, key_fn, binop_less_result);
-            tail = t;
+        for (mp_obj_t *lo = base, *hi = base + (len - 1) * w; lo < hi; lo += w, hi -= w) {
+            for (size_t k = 0; k < w; k++) {
+                mp_obj_t x = lo[k];
+                lo[k] = hi[k];
+                hi[k] = x;
+            }
+        }
+    } else {
+        while (len < n && !list_sort_lt(s, base + len * w, base + (len - 1) * w)) {
+            len += 1;
+        }
+    }
+    return len;
+}
+
+// Sorts the n elements at base, of which the first start are sorted already.
+STATIC void list_sort_insertion(const list_sort_t *s, mp_obj_t *base, size_t start, size_t n) {
+    size_t w = s->w;
+    for (size_t i = start; i < n; i++) {
+        mp_obj_t x[2];
+        memcpy(x, base + i * w, w * sizeof(mp_obj_t));
+        size_t lo = 0;
+        size_t hi = i;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (list_sort_lt(s, x, base + mid * w)) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
         }
+        memmove(base + (lo + 1) * w, base + lo * w, (i - lo) * w * sizeof(mp_obj_t));
+        memcpy(base + lo * w, x, w * sizeof(mp_obj_t));
+    }
+}
+
+// Merges the sorted runs of na and nb elements at base. The shorter run is
+// moved out to tmp. If a comparison raises, what's left in tmp is put back
+// in the gap before the exception goes on, so no element goes missing.
+STATIC void list_sort_merge(list_sort_t *s, mp_obj_t *base, size_t na, size_t nb) {
+    size_t w = s->w;
+    mp_obj_t *b = base + na * w;
+    if (!list_sort_lt(s, b, b - w)) {
+        // already in order
+        return;
+    }
+    if (s->tmp == NULL) {
+        s->tmp = m_new(mp_obj_t, s->len / 2 * w);
+    }
+    mp_obj_t *tmp = s->tmp;
+
+    nlr_buf_t nlr;
+    if (na <= nb) {
+        // merge forwards, from the start of each run
+        memcpy(tmp, base, na * w * sizeof(mp_obj_t));
+        volatile size_t i = 0;
+        volatile size_t d = 0;
+        if (nlr_push(&nlr) == 0) {
+            size_t j;
+            while (i < na && (j = d + na - i) < na + nb) {
+                if (list_sort_lt(s, base + j * w, tmp + i * w)) {
+                    memcpy(base + d * w, base + j * w, w * sizeof(mp_obj_t));
+                } else {
+                    memcpy(base + d * w, tmp + i * w, w * sizeof(mp_obj_t));
+                    i += 1;
+                }
+                d += 1;
+            }
+            nlr_pop();
+            nlr.ret_val = NULL;
+        }
+        memcpy(base + d * w, tmp + i * w, (na - i) * w * sizeof(mp_obj_t));
+    } else {
+        // merge backwards, from the end of each run
+        memcpy(tmp, b, nb * w * sizeof(mp_obj_t));
+        volatile size_t i = na;
+        volatile size_t j = nb;
+        if (nlr_push(&nlr) == 0) {
+            while (i > 0 && j > 0) {
+                if (list_sort_lt(s, tmp + (j - 1) * w, base + (i - 1) * w)) {
+                    memcpy(base + (i + j - 1) * w, base + (i - 1) * w, w * sizeof(mp_obj_t));
+                    i -= 1;
+                } else {
+                    memcpy(base + (i + j - 1) * w, tmp + (j - 1) * w, w * sizeof(mp_obj_t));
+                    j -= 1;
+                }
+            }
+            nlr_pop();
+            nlr.ret_val = NULL;
+        }
+        memcpy(base + i * w, tmp, j * w * sizeof(mp_obj_t));
+    }
+    if (nlr.ret_val != NULL) {
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+// Merges pending run k with run k + 1.
+STATIC void list_sort_merge_at(list_sort_t *s, size_t *runs, size_t n_runs, size_t k) {
+    size_t start = 0;
+    for (size_t i = 0; i < k; i++) {
+        start += runs[i];
+    }
+    list_sort_merge(s, s->base + start * s->w, runs[k], runs[k + 1]);
+    runs[k] += runs[k + 1];
+    if (k + 3 == n_runs) {
+        runs[k + 1] = runs[k + 2];
+    }
+}
+
+STATIC void list_sort(list_sort_t *s) {
+    // the minimum run length, so that n / min_run is a little under a power
+    // of two and the merges stay balanced
+    size_t min_run = s->len;
+    size_t r = 0;
+    while (min_run >= LIST_SORT_MIN_MERGE) {
+        r |= min_run & 1;
+        min_run >>= 1;
+    }
+    min_run += r;
+
+    size_t runs[LIST_SORT_MAX_RUNS];
+    size_t n_runs = 0;
+    for (size_t lo = 0; lo < s->len;) {
+        mp_obj_t *base = s->base + lo * s->w;
+        size_t n = s->len - lo;
+        size_t len = n < 2 ? n : list_sort_run(s, base, n);
+        if (len < min_run) {
+            size_t force = MIN(min_run, n);
+            list_sort_insertion(s, base, len, force);
+            len = force;
+        }
+        runs[n_runs++] = len;
+        lo += len;
+
+        // keep each run longer than the next, and than the next two together,
+        // so that merges are of runs of similar length
+        while (n_runs > 1) {
+            size_t k = n_runs - 2;
+            if ((k > 0 && runs[k - 1] <= runs[k] + runs[k + 1])
+                || (k > 1 && runs[k - 2] <= runs[k - 1] + runs[k])) {
+                if (runs[k - 1] < runs[k + 1]) {
+                    k -= 1;
+                }
+            } else if (runs[k] > runs[k + 1]) {
+                break;
+            }
+            list_sort_merge_at(s, runs, n_runs--, k);
+        }
+    }
+    while (n_runs > 1) {
+        size_t k = n_runs - 2;
+        if (k > 0 && runs[k - 1] < runs[k + 1]) {
+            k -= 1;
+        }
+        list_sort_merge_at(s, runs, n_runs--, k);
+    }
+
+    if (s->tmp != NULL) {
+        m_del(mp_obj_t, s->tmp, s->len / 2 * s->w);
     }
 }
 
-// TODO Python defines sort to be stable but ours is not
 mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_key, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_PTR(&mp_const_none_obj)} },
@@ -327,9 +517,24 @@ mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_
     mp_obj_list_t *self = MP_OBJ_TO_PTR(pos_args[0]);
 
     if (self->len > 1) {
-        mp_quicksort(self->items, self->items + self->len - 1,
-                     args.key.u_obj == mp_const_none ? MP_OBJ_NULL : args.key.u_obj,
-                     args.reverse.u_bool ? mp_const_false : mp_const_true);
+        list_sort_t s = {self->items, NULL, self->len, 1, args.reverse.u_bool};
+        if (args.key.u_obj == mp_const_none) {
+            list_sort(&s);
+        } else {
+            // sort (key, item) pairs, then put the items back
+            mp_obj_t *pairs = m_new(mp_obj_t, 2 * self->len);
+            for (size_t i = 0; i < self->len; i++) {
+                pairs[2 * i] = mp_call_function_1(args.key.u_obj, self->items[i]);
+                pairs[2 * i + 1] = self->items[i];
+            }
+            s.base = pairs;
+            s.w = 2;
+            list_sort(&s);
+            for (size_t i = 0; i < s.len; i++) {
+                self->items[i] = pairs[2 * i + 1];
+            }
+            m_del(mp_obj_t, pairs, 2 * s.len);
+        }
     }
 
     return mp_const_none;
@@ -483,9 +688,22 @@ void mp_obj_list_get(mp_obj_t self_in, mp_uint_t *len, mp_obj_t **items) {
 
 void mp_obj_list_set_len(mp_obj_t self_in, mp_uint_t len) {
     // trust that the caller knows what it's doing
-    // TODO realloc if len got much smaller than alloc
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
+    if (len < self->len) {
+        mp_seq_clear(self->items, len, self->len, sizeof(*self->items));
+    }
     self->len = len;
+    list_shrink(self);
+}
+
+// Make room for the list to hold n items without reallocating.
+void mp_obj_list_reserve(mp_obj_t self_in, mp_uint_t n) {
+    mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
+    if (n > self->alloc) {
+        self->items = m_renew(mp_obj_t, self->items, self->alloc, n);
+        mp_seq_clear(self->items, self->alloc, n, sizeof(*self->items));
+        self->alloc = n;
+    }
 }
 
 void mp_obj_list_store(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
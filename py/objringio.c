@@ -0,0 +1,163 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/runtime0.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+#include "py/ringbuf.h"
+
+#if MICROPY_PY_MICROPYTHON_RINGIO
+
+// A byte queue with the stream protocol.  Once created it doesn't allocate
+// when written to or read into a buffer, and a writer and a reader on either
+// side of an interrupt can use it without locking, because each only
+// updates its own index of the ringbuf_t.
+typedef struct _mp_obj_ringio_t {
+    mp_obj_base_t base;
+    ringbuf_t ringbuf;
+} mp_obj_ringio_t;
+
+STATIC mp_obj_t ringio_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    mp_obj_ringio_t *self = m_new_obj(mp_obj_ringio_t);
+    self->base.type = type;
+
+    size_t size;
+    mp_buffer_info_t bufinfo;
+    if (mp_get_buffer(args[0], &bufinfo, MP_BUFFER_RW)) {
+        // use the given buffer as storage; one byte of it is always unused
+        self->ringbuf.buf = bufinfo.buf;
+        size = bufinfo.len;
+    } else {
+        // allocate storage for the given number of bytes
+        self->ringbuf.buf = NULL;
+        size = mp_obj_get_int(args[0]) + 1;
+    }
+    if (size < 2 || size > 0xffff) {
+        mp_raise_ValueError("invalid size");
+    }
+    if (self->ringbuf.buf == NULL) {
+        self->ringbuf.buf = m_new(uint8_t, size);
+    }
+    self->ringbuf.size = size;
+    self->ringbuf.iget = self->ringbuf.iput = 0;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_uint_t ringio_read(mp_obj_t self_in, void *buf_in, mp_uint_t size, int *errcode) {
+    (void)errcode;
+    mp_obj_ringio_t *self = MP_OBJ_TO_PTR(self_in);
+    uint8_t *buf = buf_in;
+    mp_uint_t n = 0;
+    int c;
+    while (n < size && (c = ringbuf_get(&self->ringbuf)) >= 0) {
+        buf[n++] = c;
+    }
+    return n;
+}
+
+STATIC mp_uint_t ringio_write(mp_obj_t self_in, const void *buf_in, mp_uint_t size, int *errcode) {
+    (void)errcode;
+    mp_obj_ringio_t *self = MP_OBJ_TO_PTR(self_in);
+    const uint8_t *buf = buf_in;
+    mp_uint_t n = 0;
+    while (n < size && ringbuf_put(&self->ringbuf, buf[n]) == 0) {
+        n++;
+    }
+    return n;
+}
+
+STATIC mp_uint_t ringio_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    (void)self_in;
+    (void)arg;
+    switch (request) {
+        case MP_STREAM_FLUSH:
+            return 0;
+        default:
+            *errcode = MP_EINVAL;
+            return MP_STREAM_ERROR;
+    }
+}
+
+STATIC mp_obj_t ringio_any(mp_obj_t self_in) {
+    mp_obj_ringio_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(ringbuf_avail(&self->ringbuf));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ringio_any_obj, ringio_any);
+
+STATIC mp_obj_t ringio_free(mp_obj_t self_in) {
+    mp_obj_ringio_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(ringbuf_free(&self->ringbuf));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ringio_free_obj, ringio_free);
+
+STATIC mp_obj_t ringio_clear(mp_obj_t self_in) {
+    mp_obj_ringio_t *self = MP_OBJ_TO_PTR(self_in);
+    self->ringbuf.iget = self->ringbuf.iput;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ringio_clear_obj, ringio_clear);
+
+STATIC mp_obj_t ringio_unary_op(mp_uint_t op, mp_obj_t self_in) {
+    mp_obj_ringio_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(ringbuf_avail(&self->ringbuf) != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(ringbuf_avail(&self->ringbuf));
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+STATIC const mp_rom_map_elem_t ringio_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&mp_stream_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readline), MP_ROM_PTR(&mp_stream_unbuffered_readline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_any), MP_ROM_PTR(&ringio_any_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free), MP_ROM_PTR(&ringio_free_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&ringio_clear_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(ringio_locals_dict, ringio_locals_dict_table);
+
+STATIC const mp_stream_p_t ringio_stream_p = {
+    .read = ringio_read,
+    .write = ringio_write,
+    .ioctl = ringio_ioctl,
+    .is_text = false,
+};
+
+const mp_obj_type_t mp_type_ringio = {
+    { &mp_type_type },
+    .name = MP_QSTR_RingIO,
+    .make_new = ringio_make_new,
+    .unary_op = ringio_unary_op,
+    .getiter = mp_identity,
+    .iternext = mp_stream_unbuffered_iter,
+    .protocol = &ringio_stream_p,
+    .locals_dict = (mp_obj_dict_t*)&ringio_locals_dict,
+};
+
+#endif // MICROPY_PY_MICROPYTHON_RINGIO
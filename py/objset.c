@@ -127,16 +127,22 @@ STATIC mp_obj_t set_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_
 
         case 1:
         default: { // can only be 0 or 1 arg
-            // 1 argument, an iterable from which we make a new set
-            mp_obj_t set = mp_obj_new_set(0, NULL);
+            // 1 argument, an iterable from which we make a new set, allocating
+            // the table once if its length is known
+            mp_uint_t n = 0;
+            mp_obj_t len = mp_obj_len_maybe(args[0]);
+            if (len != MP_OBJ_NULL) {
+                n = mp_map_alloc_hint(MP_OBJ_SMALL_INT_VALUE(len), false);
+            }
+            mp_obj_set_t *set = m_new_obj(mp_obj_set_t);
+            set->base.type = type;
+            mp_set_init(&set->set, n);
             mp_obj_t iterable = mp_getiter(args[0]);
             mp_obj_t item;
             while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
-                mp_obj_set_store(set, item);
+                mp_set_lookup(&set->set, item, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
             }
-            // Set actual set/frozenset type
-            ((mp_obj_set_t*)MP_OBJ_TO_PTR(set))->base.type = type;
-            return set;
+            return MP_OBJ_FROM_PTR(set);
         }
     }
 }
@@ -217,6 +223,30 @@ STATIC mp_obj_t set_discard(mp_obj_t self_in, mp_obj_t item) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(set_discard_obj, set_discard);
 
+// Remove, in place, the elements of self that are in other (if remove_found)
+// or that aren't in other (otherwise).  This costs one lookup in other per
+// element of self, so it's used when self is the smaller of the two.
+STATIC void set_filter_int(mp_set_t *self, mp_set_t *other, bool remove_found) {
+    bool removed = false;
+    for (mp_uint_t i = 0; i < self->alloc; i++) {
+        if (MP_SET_SLOT_IS_FILLED(self, i)
+            && (mp_set_lookup(other, self->table[i], MP_MAP_LOOKUP) != MP_OBJ_NULL) == remove_found) {
+            self->table[i] = MP_OBJ_SENTINEL;
+            self->used--;
+            removed = true;
+        }
+    }
+    if (removed) {
+        // deleted slots that end a probe sequence can be emptied, so that
+        // failed lookups stop early
+        for (mp_uint_t i = self->alloc; i-- > 0;) {
+            if (self->table[i] == MP_OBJ_SENTINEL && self->table[(i + 1) % self->alloc] == MP_OBJ_NULL) {
+                self->table[i] = MP_OBJ_NULL;
+            }
+        }
+    }
+}
+
 STATIC mp_obj_t set_diff_int(size_t n_args, const mp_obj_t *args, bool update) {
     mp_obj_t self;
     if (update) {
@@ -230,8 +260,13 @@ STATIC mp_obj_t set_diff_int(size_t n_args, const mp_obj_t *args, bool update) {
 
     for (mp_uint_t i = 1; i < n_args; i++) {
         mp_obj_t other = args[i];
+        mp_obj_set_t *self_set = MP_OBJ_TO_PTR(self);
         if (self == other) {
             set_clear(self);
+        } else if (is_set_or_frozenset(other)
+            && ((mp_obj_set_t*)MP_OBJ_TO_PTR(other))->set.used > self_set->set.used) {
+            // other is the larger set, so probe it for each element of self
+            set_filter_int(&self_set->set, &((mp_obj_set_t*)MP_OBJ_TO_PTR(other))->set, true);
         } else {
             mp_obj_t iter = mp_getiter(other);
             mp_obj_t next;
@@ -268,6 +303,23 @@ STATIC mp_obj_t set_intersect_int(mp_obj_t self_in, mp_obj_t other, bool update)
     }
 
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (is_set_or_frozenset(other)) {
+        mp_obj_set_t *other_set = MP_OBJ_TO_PTR(other);
+        if (other_set->set.used >= self->set.used) {
+            // other is the larger set, so probe it for each element of self,
+            // filtering self in place if we are updating it
+            if (update) {
+                set_filter_int(&self->set, &other_set->set, false);
+                return mp_const_none;
+            }
+            mp_obj_set_t *out = MP_OBJ_TO_PTR(set_copy_as_mutable(self_in));
+            set_filter_int(&out->set, &other_set->set, false);
+            return MP_OBJ_FROM_PTR(out);
+        }
+    }
+
+    // iterate other and probe self, building the result in a new set
     mp_obj_set_t *out = MP_OBJ_TO_PTR(mp_obj_new_set(0, NULL));
 
     mp_obj_t iter = mp_getiter(other);
@@ -302,6 +354,14 @@ STATIC mp_obj_t set_isdisjoint(mp_obj_t self_in, mp_obj_t other) {
     check_set_or_frozenset(self_in);
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
 
+    if (is_set_or_frozenset(other)
+        && ((mp_obj_set_t*)MP_OBJ_TO_PTR(other))->set.used > self->set.used) {
+        // iterate the smaller set and probe the larger one
+        mp_obj_t tmp = self_in;
+        self = MP_OBJ_TO_PTR(other);
+        other = tmp;
+    }
+
     mp_obj_t iter = mp_getiter(other);
     mp_obj_t next;
     while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
@@ -332,7 +392,8 @@ STATIC mp_obj_t set_issubset_internal(mp_obj_t self_in, mp_obj_t other_in, bool
         cleanup_other = true;
     }
     bool out = true;
-    if (proper && self->set.used == other->set.used) {
+    if (self->set.used > other->set.used || (proper && self->set.used == other->set.used)) {
+        // self is too big to be a (proper) subset
         out = false;
     } else {
         mp_obj_t iter = set_getiter(MP_OBJ_FROM_PTR(self));
@@ -479,6 +540,23 @@ STATIC mp_obj_t set_unary_op(mp_uint_t op, mp_obj_t self_in) {
 
 STATIC mp_obj_t set_binary_op(mp_uint_t op, mp_obj_t lhs, mp_obj_t rhs) {
     mp_obj_t args[] = {lhs, rhs};
+    if (MP_OBJ_IS_TYPE(lhs, &mp_type_set)) {
+        // a mutable set is updated in place by the in-place operators
+        switch (op) {
+            case MP_BINARY_OP_INPLACE_OR:
+                set_update(2, args);
+                return lhs;
+            case MP_BINARY_OP_INPLACE_XOR:
+                set_symmetric_difference_update(lhs, rhs);
+                return lhs;
+            case MP_BINARY_OP_INPLACE_AND:
+                set_intersect_update(lhs, rhs);
+                return lhs;
+            case MP_BINARY_OP_INPLACE_SUBTRACT:
+                set_diff_update(2, args);
+                return lhs;
+        }
+    }
     switch (op) {
         case MP_BINARY_OP_OR:
             return set_union(lhs, rhs);
@@ -35,6 +35,7 @@
 #include "py/runtime0.h"
 #include "py/runtime.h"
 #include "py/stackctrl.h"
+#include "py/gc.h"
 
 STATIC mp_obj_t str_modulo_format(mp_obj_t pattern, mp_uint_t n_args, const mp_obj_t *args, mp_obj_t dict);
 
@@ -249,28 +250,76 @@ wrong_args:
     mp_raise_TypeError("wrong number of arguments");
 }
 
+#if MICROPY_OPT_STR_SEARCH_HORSPOOL
+// Boyer-Moore-Horspool search, for when nlen >= 2 and hlen >= nlen.  Each
+// skip is capped at 255 so the table fits in bytes; a shorter skip than the
+// real one is always safe.
+STATIC const byte *find_subbytes_horspool(const byte *haystack, mp_uint_t hlen, const byte *needle, mp_uint_t nlen, mp_int_t direction) {
+    byte skip[256];
+    mp_uint_t max_skip = nlen < 255 ? nlen : 255;
+    memset(skip, max_skip, sizeof(skip));
+    mp_uint_t last = nlen - 1;
+    if (direction > 0) {
+        // skip is indexed by the haystack byte under the end of the needle
+        for (mp_uint_t i = nlen - max_skip; i < last; i++) {
+            skip[needle[i]] = last - i;
+        }
+        for (mp_uint_t pos = 0; pos <= hlen - nlen; pos += skip[haystack[pos + last]]) {
+            if (haystack[pos + last] == needle[last] && memcmp(haystack + pos, needle, last) == 0) {
+                return haystack + pos;
+            }
+        }
+    } else {
+        // mirror image: skip is indexed by the haystack byte under the start
+        for (mp_uint_t i = max_skip; i > 1; i--) {
+            skip[needle[i - 1]] = i - 1;
+        }
+        for (mp_uint_t pos = hlen - nlen;; pos -= skip[haystack[pos]]) {
+            if (haystack[pos] == needle[0] && memcmp(haystack + pos + 1, needle + 1, last) == 0) {
+                return haystack + pos;
+            }
+            if (pos < skip[haystack[pos]]) {
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+#endif
+
 // like strstr but with specified length and allows \0 bytes
-// TODO replace with something more efficient/standard
 const byte *find_subbytes(const byte *haystack, mp_uint_t hlen, const byte *needle, mp_uint_t nlen, mp_int_t direction) {
-    if (hlen >= nlen) {
-        mp_uint_t str_index, str_index_end;
-        if (direction > 0) {
-            str_index = 0;
-            str_index_end = hlen - nlen;
-        } else {
-            str_index = hlen - nlen;
-            str_index_end = 0;
+    if (hlen < nlen) {
+        return NULL;
+    }
+    if (nlen == 0) {
+        return direction > 0 ? haystack : haystack + hlen;
+    }
+    #if MICROPY_OPT_STR_SEARCH_HORSPOOL
+    if (nlen >= 4 && hlen >= 64) {
+        return find_subbytes_horspool(haystack, hlen, needle, nlen, direction);
+    }
+    #endif
+    if (direction > 0) {
+        // let memchr find candidates for the first byte
+        const byte *p = haystack;
+        const byte *top = haystack + hlen - nlen + 1;
+        while ((p = memchr(p, needle[0], top - p)) != NULL) {
+            if (memcmp(p + 1, needle + 1, nlen - 1) == 0) {
+                return p;
+            }
+            if (++p == top) {
+                break;
+            }
         }
-        for (;;) {
-            if (memcmp(&haystack[str_index], needle, nlen) == 0) {
-                //found
-                return haystack + str_index;
+    } else {
+        for (const byte *p = haystack + hlen - nlen;; p--) {
+            if (*p == needle[0] && memcmp(p + 1, needle + 1, nlen - 1) == 0) {
+                return p;
             }
-            if (str_index == str_index_end) {
-                //not found
+            if (p == haystack) {
                 break;
             }
-            str_index += direction;
         }
     }
     return NULL;
@@ -381,10 +430,85 @@ mp_obj_t mp_obj_str_binary_op(mp_uint_t op, mp_obj_t lhs_in, mp_obj_t rhs_in) {
     return MP_OBJ_NULL; // op not supported
 }
 
+#if MICROPY_OPT_SUPERINSTRUCTIONS
+
+// A str or bytes that a local variable is building up with += (see
+// MP_BC_INPLACE_ADD_FAST) is referred to only by that variable and has its
+// data to itself, so it can be extended in place.  Such an object has this bit
+// set in its hash, and the rest of the hash is the size of its data buffer.
+// Real hashes are never this big.  The hash is computed when the object is
+// loaded in any other way, which is when it might start being shared.
+#define STR_BUILDER_BIT ((mp_uint_t)1 << (8 * sizeof(mp_uint_t) - 1))
+
+STATIC bool is_str_builder(mp_obj_t o) {
+    return (MP_OBJ_IS_TYPE(o, &mp_type_str) || MP_OBJ_IS_TYPE(o, &mp_type_bytes))
+        && (((mp_obj_str_t*)MP_OBJ_TO_PTR(o))->hash & STR_BUILDER_BIT);
+}
+
+// Implements lhs += rhs for a local variable that holds lhs.  If lhs is a
+// str/bytes built in place then rhs is appended to it, with its buffer growing
+// geometrically; otherwise a str/bytes result is returned as a new one of
+// those so that the next += can extend it.
+mp_obj_t mp_obj_str_inplace_add(mp_obj_t lhs_in, mp_obj_t rhs_in) {
+    const mp_obj_type_t *lhs_type = mp_obj_get_type(lhs_in);
+    if ((lhs_type != &mp_type_str && lhs_type != &mp_type_bytes) || mp_obj_get_type(rhs_in) != lhs_type) {
+        // the generic operation may pass lhs to arbitrary code
+        return mp_binary_op(MP_BINARY_OP_INPLACE_ADD, mp_obj_str_share(lhs_in), rhs_in);
+    }
+
+    GET_STR_DATA_LEN(rhs_in, rhs_data, rhs_len);
+    if (is_str_builder(lhs_in)) {
+        mp_obj_str_t *o = MP_OBJ_TO_PTR(lhs_in);
+        size_t alloc = o->hash & ~STR_BUILDER_BIT;
+        size_t needed = o->len + rhs_len + 1;
+        if (needed > alloc) {
+            size_t new_alloc = needed + needed / 2;
+            o->data = m_renew(byte, (byte*)o->data, alloc, new_alloc);
+            o->hash = STR_BUILDER_BIT | new_alloc;
+        }
+        byte *data = (byte*)o->data;
+        memcpy(data + o->len, rhs_data, rhs_len);
+        o->len += rhs_len;
+        data[o->len] = '\0';
+        return lhs_in;
+    }
+
+    GET_STR_DATA_LEN(lhs_in, lhs_data, lhs_len);
+    size_t len = lhs_len + rhs_len;
+    size_t alloc = len + 1 + (len + 1) / 2;
+    byte *data = m_new(byte, alloc);
+    memcpy(data, lhs_data, lhs_len);
+    memcpy(data + lhs_len, rhs_data, rhs_len);
+    data[len] = '\0';
+    mp_obj_str_t *o = m_new_obj(mp_obj_str_t);
+    o->base.type = lhs_type;
+    o->hash = STR_BUILDER_BIT | alloc;
+    o->len = len;
+    o->data = data;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+// Turns a str/bytes built in place back into an ordinary one: its buffer is
+// trimmed and its hash computed.  Anything else is returned unchanged.
+mp_obj_t mp_obj_str_share(mp_obj_t self_in) {
+    if (is_str_builder(self_in)) {
+        mp_obj_str_t *o = MP_OBJ_TO_PTR(self_in);
+        byte *data = m_renew_maybe(byte, (byte*)o->data, o->hash & ~STR_BUILDER_BIT, o->len + 1, false);
+        if (data != NULL) {
+            o->data = data;
+        }
+        o->hash = qstr_compute_hash(o->data, o->len);
+    }
+    return self_in;
+}
+
+#endif // MICROPY_OPT_SUPERINSTRUCTIONS
+
 #if !MICROPY_PY_BUILTINS_STR_UNICODE
 // objstrunicode defines own version
-const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, size_t self_len,
+const byte *str_index_to_ptr(mp_obj_t self_in, const mp_obj_type_t *type, const byte *self_data, size_t self_len,
                              mp_obj_t index, bool is_slice) {
+    (void)self_in;
     mp_uint_t index_val = mp_get_index(type, self_len, index, is_slice);
     return self_data + index_val;
 }
@@ -402,7 +526,7 @@ STATIC mp_obj_t bytes_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
             if (!mp_seq_get_fast_slice_indexes(self_len, index, &slice)) {
                 mp_not_implemented("only slices with step=1 (aka None) are supported");
             }
-            return mp_obj_new_str_of_type(type, self_data + slice.start, slice.stop - slice.start);
+            return mp_obj_new_str_slice(self_in, self_data + slice.start, slice.stop - slice.start);
         }
 #endif
         mp_uint_t index_val = mp_get_index(type, self_len, index, false);
@@ -522,14 +646,8 @@ mp_obj_t mp_obj_str_split(size_t n_args, const mp_obj_t *args) {
 
         for (;;) {
             const byte *start = s;
-            for (;;) {
-                if (splits == 0 || s + sep_len > top) {
-                    s = top;
-                    break;
-                } else if (memcmp(s, sep_str, sep_len) == 0) {
-                    break;
-                }
-                s++;
+            if (splits == 0 || (s = find_subbytes(s, top - s, (const byte*)sep_str, sep_len, 1)) == NULL) {
+                s = top;
             }
             mp_obj_list_append(res, mp_obj_new_str_of_type(self_type, start, s - start));
             if (s >= top) {
@@ -621,16 +739,11 @@ STATIC mp_obj_t str_rsplit(size_t n_args, const mp_obj_t *args) {
         const byte *beg = s;
         const byte *last = s + len;
         for (;;) {
-            s = last - sep_len;
-            for (;;) {
-                if (splits == 0 || s < beg) {
-                    break;
-                } else if (memcmp(s, sep_str, sep_len) == 0) {
-                    break;
-                }
-                s--;
+            s = NULL;
+            if (splits != 0) {
+                s = find_subbytes(beg, last - beg, (const byte*)sep_str, sep_len, -1);
             }
-            if (s < beg || splits == 0) {
+            if (s == NULL) {
                 res->items[idx] = mp_obj_new_str_of_type(self_type, beg, last - beg);
                 break;
             }
@@ -667,10 +780,10 @@ STATIC mp_obj_t str_finder(mp_uint_t n_args, const mp_obj_t *args, mp_int_t dire
     const byte *start = haystack;
     const byte *end = haystack + haystack_len;
     if (n_args >= 3 && args[2] != mp_const_none) {
-        start = str_index_to_ptr(self_type, haystack, haystack_len, args[2], true);
+        start = str_index_to_ptr(args[0], self_type, haystack, haystack_len, args[2], true);
     }
     if (n_args >= 4 && args[3] != mp_const_none) {
-        end = str_index_to_ptr(self_type, haystack, haystack_len, args[3], true);
+        end = str_index_to_ptr(args[0], self_type, haystack, haystack_len, args[3], true);
     }
 
     const byte *p = find_subbytes(start, end - start, needle, needle_len, direction);
@@ -715,7 +828,7 @@ STATIC mp_obj_t str_startswith(size_t n_args, const mp_obj_t *args) {
     GET_STR_DATA_LEN(args[1], prefix, prefix_len);
     const byte *start = str;
     if (n_args > 2) {
-        start = str_index_to_ptr(self_type, str, str_len, args[2], true);
+        start = str_index_to_ptr(args[0], self_type, str, str_len, args[2], true);
     }
     if (prefix_len + (start - str) > str_len) {
         return mp_const_false;
@@ -909,7 +1022,12 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
             }
         }
         if (*str != '{') {
-            vstr_add_byte(&vstr, *str);
+            // copy a run of literal text in one go
+            const char *lit = str;
+            while (str + 1 < top && str[1] != '{' && str[1] != '}') {
+                str++;
+            }
+            vstr_add_strn(&vstr, lit, str + 1 - lit);
             continue;
         }
 
@@ -925,6 +1043,7 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
         const char *field_name_top = NULL;
         char conversion = '\0';
         const char *format_spec = NULL;
+        bool format_spec_nested = false;
 
         if (str < top && *str != '}' && *str != '!' && *str != ':') {
             field_name = (const char *)str;
@@ -969,6 +1088,7 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
                 for (int nest = 1; str < top;) {
                     if (*str == '{') {
                         ++nest;
+                        format_spec_nested = true;
                     } else if (*str == '}') {
                         if (--nest == 0) {
                             break;
@@ -1041,8 +1161,11 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
             arg = args[(*arg_i) + 1];
             (*arg_i)++;
         }
-        if (!format_spec && !conversion) {
-            conversion = 's';
+        if (!format_spec) {
+            // nothing to pad or align, so print the argument straight out
+            // rather than converting it to a str first
+            mp_obj_print_helper(&print, arg, conversion == 'r' ? PRINT_REPR : PRINT_STR);
+            continue;
         }
         if (conversion) {
             mp_print_kind_t print_kind;
@@ -1078,11 +1201,24 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
             // precision   ::=  integer
             // type        ::=  "b" | "c" | "d" | "e" | "E" | "f" | "F" | "g" | "G" | "n" | "o" | "s" | "x" | "X" | "%"
 
-            // recursively call the formatter to format any nested specifiers
-            MP_STACK_CHECK();
-            vstr_t format_spec_vstr = mp_obj_str_format_helper(format_spec, str, arg_i, n_args, args, kwargs);
-            const char *s = vstr_null_terminated_str(&format_spec_vstr);
-            const char *stop = s + format_spec_vstr.len;
+            // a plain specifier is parsed from a copy on the stack, one with
+            // nested specifiers is formatted first by a recursive call
+            char format_spec_buf[32];
+            vstr_t format_spec_vstr;
+            const char *s;
+            const char *stop;
+            if (!format_spec_nested && (size_t)(str - format_spec) < sizeof(format_spec_buf)) {
+                memcpy(format_spec_buf, format_spec, str - format_spec);
+                format_spec_buf[str - format_spec] = '\0';
+                s = format_spec_buf;
+                stop = s + (str - format_spec);
+            } else {
+                MP_STACK_CHECK();
+                format_spec_vstr = mp_obj_str_format_helper(format_spec, str, arg_i, n_args, args, kwargs);
+                s = vstr_null_terminated_str(&format_spec_vstr);
+                stop = s + format_spec_vstr.len;
+            }
+            const char *spec_start = s;
             if (isalignment(*s)) {
                 align = *s++;
             } else if (*s && isalignment(s[1])) {
@@ -1128,7 +1264,9 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
                     mp_raise_ValueError("invalid format specifier");
                 }
             }
-            vstr_clear(&format_spec_vstr);
+            if (spec_start != format_spec_buf) {
+                vstr_clear(&format_spec_vstr);
+            }
         }
         if (!align) {
             if (arg_looks_numeric(arg)) {
@@ -1356,7 +1494,12 @@ STATIC mp_obj_t str_modulo_format(mp_obj_t pattern, mp_uint_t n_args, const mp_o
     for (const byte *top = str + len; str < top; str++) {
         mp_obj_t arg = MP_OBJ_NULL;
         if (*str != '%') {
-            vstr_add_byte(&vstr, *str);
+            // copy a run of literal text in one go
+            const byte *lit = str;
+            while (str + 1 < top && str[1] != '%') {
+                str++;
+            }
+            vstr_add_strn(&vstr, (const char*)lit, str + 1 - lit);
             continue;
         }
         if (++str >= top) {
@@ -1489,15 +1632,20 @@ not_enough_args:
             case 'r':
             case 's':
             {
-                vstr_t arg_vstr;
-                mp_print_t arg_print;
-                vstr_init_print(&arg_vstr, 16, &arg_print);
                 mp_print_kind_t print_kind = (*str == 'r' ? PRINT_REPR : PRINT_STR);
                 if (print_kind == PRINT_STR && is_bytes && MP_OBJ_IS_TYPE(arg, &mp_type_bytes)) {
                     // If we have something like b"%s" % b"1", bytes arg should be
                     // printed undecorated.
                     print_kind = PRINT_RAW;
                 }
+                if (width == 0 && prec < 0) {
+                    // nothing to pad or truncate, so print straight out
+                    mp_obj_print_helper(&print, arg, print_kind);
+                    break;
+                }
+                vstr_t arg_vstr;
+                mp_print_t arg_print;
+                vstr_init_print(&arg_vstr, 16, &arg_print);
                 mp_obj_print_helper(&arg_print, arg, print_kind);
                 uint vlen = arg_vstr.len;
                 if (prec < 0) {
@@ -1656,10 +1804,14 @@ STATIC mp_obj_t str_count(size_t n_args, const mp_obj_t *args) {
     const byte *start = haystack;
     const byte *end = haystack + haystack_len;
     if (n_args >= 3 && args[2] != mp_const_none) {
-        start = str_index_to_ptr(self_type, haystack, haystack_len, args[2], true);
+        start = str_index_to_ptr(args[0], self_type, haystack, haystack_len, args[2], true);
     }
     if (n_args >= 4 && args[3] != mp_const_none) {
-        end = str_index_to_ptr(self_type, haystack, haystack_len, args[3], true);
+        end = str_index_to_ptr(args[0], self_type, haystack, haystack_len, args[3], true);
+    }
+
+    if (end < start) {
+        return MP_OBJ_NEW_SMALL_INT(0);
     }
 
     // if needle_len is zero then we count each gap between characters as an occurrence
@@ -1667,15 +1819,12 @@ STATIC mp_obj_t str_count(size_t n_args, const mp_obj_t *args) {
         return MP_OBJ_NEW_SMALL_INT(unichar_charlen((const char*)start, end - start) + 1);
     }
 
-    // count the occurrences
+    // count the non-overlapping occurrences
     mp_int_t num_occurrences = 0;
-    for (const byte *haystack_ptr = start; haystack_ptr + needle_len <= end;) {
-        if (memcmp(haystack_ptr, needle, needle_len) == 0) {
-            num_occurrences++;
-            haystack_ptr += needle_len;
-        } else {
-            haystack_ptr = utf8_next_char(haystack_ptr);
-        }
+    for (const byte *haystack_ptr = start;
+        (haystack_ptr = find_subbytes(haystack_ptr, end - haystack_ptr, needle, needle_len, 1)) != NULL;
+        haystack_ptr += needle_len) {
+        num_occurrences++;
     }
 
     return MP_OBJ_NEW_SMALL_INT(num_occurrences);
@@ -1983,6 +2132,73 @@ mp_obj_t mp_obj_new_str_of_type(const mp_obj_type_t *type, const byte* data, siz
     return MP_OBJ_FROM_PTR(o);
 }
 
+#if MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN
+// Returns the object as a view if it is one: it must be in the heap, be big
+// enough and have its data inside the heap block it says owns that data
+STATIC mp_obj_str_view_t *str_get_view(mp_obj_t self_in) {
+    if (MP_OBJ_IS_QSTR(self_in) || gc_nbytes(MP_OBJ_TO_PTR(self_in)) < sizeof(mp_obj_str_view_t)) {
+        return NULL;
+    }
+    mp_obj_str_view_t *view = MP_OBJ_TO_PTR(self_in);
+    const byte *owner = view->owner;
+    size_t n = gc_nbytes(owner);
+    if (n == 0 || view->str.data < owner || view->str.data >= owner + n) {
+        return NULL;
+    }
+    return view;
+}
+
+// C code given the data of a str/bytes may rely on it being null terminated,
+// so a view that doesn't reach the end of its data gets its own copy of it
+STATIC void str_view_terminate(mp_obj_t self_in) {
+    mp_obj_str_view_t *view = str_get_view(self_in);
+    if (view != NULL && view->str.data[view->str.len] != '\0') {
+        byte *p = m_new(byte, view->str.len + 1);
+        memcpy(p, view->str.data, view->str.len);
+        p[view->str.len] = '\0';
+        view->str.data = p;
+        view->owner = p;
+    }
+}
+
+// Returns the start of the heap block holding the given data of a str/bytes,
+// or NULL if it's not in the heap
+STATIC void *str_data_owner(mp_obj_t self_in, const byte *data) {
+    if (!MP_OBJ_IS_QSTR(self_in)) {
+        const mp_obj_str_t *self = MP_OBJ_TO_PTR(self_in);
+        if (gc_nbytes(self->data) != 0) {
+            // an ordinary str/bytes, which owns its data
+            return (void*)self->data;
+        }
+        mp_obj_str_view_t *view = str_get_view(self_in);
+        if (view != NULL) {
+            return view->owner;
+        }
+    }
+    return gc_find_head(data);
+}
+#endif
+
+// Create a slice of the given str/bytes object from part of its data.  It may
+// share that data with the object rather than copying it.
+mp_obj_t mp_obj_new_str_slice(mp_obj_t self_in, const byte *data, size_t len) {
+    const mp_obj_type_t *type = mp_obj_get_type(self_in);
+    #if MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN
+    // data that's not in the heap could be anywhere, so is always copied
+    void *owner;
+    if (len >= MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN && (owner = str_data_owner(self_in, data)) != NULL) {
+        mp_obj_str_view_t *o = m_new_obj(mp_obj_str_view_t);
+        o->str.base.type = type;
+        o->str.hash = 0; // computed when needed
+        o->str.len = len;
+        o->str.data = data;
+        o->owner = owner;
+        return MP_OBJ_FROM_PTR(o);
+    }
+    #endif
+    return mp_obj_new_str_of_type(type, data, len);
+}
+
 // Create a str/bytes object from the given vstr.  The vstr buffer is resized to
 // the exact length required and then reused for the str/bytes object.  The vstr
 // is cleared and can safely be passed to vstr_free if it was heap allocated.
@@ -2084,6 +2300,9 @@ qstr mp_obj_str_get_qstr(mp_obj_t self_in) {
 // at the moment all strings are zero terminated to help with C ASCIIZ compatibility
 const char *mp_obj_str_get_str(mp_obj_t self_in) {
     if (MP_OBJ_IS_STR_OR_BYTES(self_in)) {
+        #if MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN
+        str_view_terminate(self_in);
+        #endif
         GET_STR_DATA_LEN(self_in, s, l);
         (void)l; // len unused
         return (const char*)s;
@@ -2094,6 +2313,9 @@ const char *mp_obj_str_get_str(mp_obj_t self_in) {
 
 const char *mp_obj_str_get_data(mp_obj_t self_in, mp_uint_t *len) {
     if (MP_OBJ_IS_STR_OR_BYTES(self_in)) {
+        #if MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN
+        str_view_terminate(self_in);
+        #endif
         GET_STR_DATA_LEN(self_in, s, l);
         *len = l;
         return (const char*)s;
@@ -36,6 +36,15 @@ typedef struct _mp_obj_str_t {
     const byte *data;
 } mp_obj_str_t;
 
+#if MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN
+// A slice whose data is part of the data of another str/bytes; owner is the
+// start of the heap block holding that data, or NULL if it's not in the heap
+typedef struct _mp_obj_str_view_t {
+    mp_obj_str_t str;
+    void *owner;
+} mp_obj_str_view_t;
+#endif
+
 #define MP_DEFINE_STR_OBJ(obj_name, str) mp_obj_str_t obj_name = {{&mp_type_str}, 0, sizeof(str) - 1, (const byte*)str}
 
 // use this macro to extract the string hash
@@ -66,11 +75,17 @@ void mp_str_print_json(const mp_print_t *print, const byte *str_data, size_t str
 mp_obj_t mp_obj_str_format(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs);
 mp_obj_t mp_obj_str_split(size_t n_args, const mp_obj_t *args);
 mp_obj_t mp_obj_new_str_of_type(const mp_obj_type_t *type, const byte* data, size_t len);
+mp_obj_t mp_obj_new_str_slice(mp_obj_t self_in, const byte *data, size_t len);
 
 mp_obj_t mp_obj_str_binary_op(mp_uint_t op, mp_obj_t lhs_in, mp_obj_t rhs_in);
 mp_int_t mp_obj_str_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags);
 
-const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, size_t self_len,
+#if MICROPY_OPT_SUPERINSTRUCTIONS
+mp_obj_t mp_obj_str_inplace_add(mp_obj_t lhs_in, mp_obj_t rhs_in);
+mp_obj_t mp_obj_str_share(mp_obj_t self_in);
+#endif
+
+const byte *str_index_to_ptr(mp_obj_t self_in, const mp_obj_type_t *type, const byte *self_data, size_t self_len,
                              mp_obj_t index, bool is_slice);
 const byte *find_subbytes(const byte *haystack, mp_uint_t hlen, const byte *needle, mp_uint_t nlen, mp_int_t direction);
 
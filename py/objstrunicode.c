@@ -100,13 +100,102 @@ STATIC void uni_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t
     }
 }
 
+#if MICROPY_OPT_STR_INDEX_CACHE
+
+// Finding the nth char of a str means counting chars from one end, so a loop
+// over a str by index would take O(n^2) time. Instead the str last indexed is
+// remembered along with a char index and its byte offset, which indexing
+// near it starts from, and how many of its leading bytes are known to be
+// ASCII, which index as bytes. len() of a str also makes it the one
+// remembered, as then the number of its chars is known, so that if it's all
+// ASCII each index is O(1). Holding the str object keeps it and its data
+// alive, so a new str can't take its place.
+#define index_cache_obj MP_STATE_VM(str_index_obj)
+#define index_cache MP_STATE_VM(str_index)
+
+#define STR_INDEX_CHARS_UNKNOWN ((size_t)-1)
+
+// Starts remembering the given str.
+STATIC void str_index_cache_set(mp_obj_t self_in, size_t self_len, size_t n_chars) {
+    index_cache_obj = self_in;
+    index_cache.len = self_len;
+    index_cache.chars = n_chars;
+    index_cache.char_index = 0;
+    index_cache.byte_offset = 0;
+    index_cache.ascii_len = n_chars == self_len ? self_len : 0;
+}
+
+// The lead byte of char i >= 0, counting on from the remembered place.
+STATIC const byte *str_index_cached(const byte *self_data, size_t self_len, size_t i, bool is_slice) {
+    size_t c, b;
+    if (index_cache.chars != STR_INDEX_CHARS_UNKNOWN && i >= index_cache.chars) {
+        c = index_cache.chars;
+        b = self_len;
+    } else if (i <= index_cache.ascii_len) {
+        c = b = i;
+    } else if (i >= index_cache.char_index) {
+        c = index_cache.char_index;
+        b = index_cache.byte_offset;
+        if (c < index_cache.ascii_len) {
+            c = b = index_cache.ascii_len;
+        }
+    } else if (index_cache.char_index - i < i - index_cache.ascii_len) {
+        // back from the remembered place
+        c = index_cache.char_index;
+        b = index_cache.byte_offset;
+        while (c > i) {
+            do {
+                --b;
+            } while (UTF8_IS_CONT(self_data[b]));
+            --c;
+        }
+    } else {
+        c = b = index_cache.ascii_len;
+    }
+    while (c < i && b < self_len) {
+        if (b == index_cache.ascii_len && !UTF8_IS_NONASCII(self_data[b])) {
+            index_cache.ascii_len = b + 1;
+        }
+        ++b;
+        while (UTF8_IS_CONT(self_data[b])) {
+            ++b;
+        }
+        ++c;
+    }
+    if (b >= self_len) {
+        if (b == self_len) {
+            index_cache.chars = c;
+        }
+        if (is_slice) {
+            return self_data + self_len;
+        }
+        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_IndexError, "string index out of range"));
+    }
+    index_cache.char_index = c;
+    index_cache.byte_offset = b;
+    return self_data + b;
+}
+
+#endif // MICROPY_OPT_STR_INDEX_CACHE
+
 STATIC mp_obj_t uni_unary_op(mp_uint_t op, mp_obj_t self_in) {
     GET_STR_DATA_LEN(self_in, str_data, str_len);
     switch (op) {
         case MP_UNARY_OP_BOOL:
             return mp_obj_new_bool(str_len != 0);
-        case MP_UNARY_OP_LEN:
+        case MP_UNARY_OP_LEN: {
+            #if MICROPY_OPT_STR_INDEX_CACHE
+            if (self_in == index_cache_obj && str_len == index_cache.len
+                && index_cache.chars != STR_INDEX_CHARS_UNKNOWN) {
+                return MP_OBJ_NEW_SMALL_INT(index_cache.chars);
+            }
+            size_t n_chars = unichar_charlen((const char *)str_data, str_len);
+            str_index_cache_set(self_in, str_len, n_chars);
+            return MP_OBJ_NEW_SMALL_INT(n_chars);
+            #else
             return MP_OBJ_NEW_SMALL_INT(unichar_charlen((const char *)str_data, str_len));
+            #endif
+        }
         default:
             return MP_OBJ_NULL; // op not supported
     }
@@ -114,7 +203,7 @@ STATIC mp_obj_t uni_unary_op(mp_uint_t op, mp_obj_t self_in) {
 
 // Convert an index into a pointer to its lead byte. Out of bounds indexing will raise IndexError or
 // be capped to the first/last character of the string, depending on is_slice.
-const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, size_t self_len,
+const byte *str_index_to_ptr(mp_obj_t self_in, const mp_obj_type_t *type, const byte *self_data, size_t self_len,
                              mp_obj_t index, bool is_slice) {
     // All str functions also handle bytes objects, and they call str_index_to_ptr(),
     // so it must handle bytes.
@@ -133,6 +222,31 @@ const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, s
     } else if (!mp_obj_get_int_maybe(index, &i)) {
         nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_TypeError, "string indices must be integers, not %s", mp_obj_get_type_str(index)));
     }
+    #if MICROPY_OPT_STR_INDEX_CACHE
+    // a qstr is remembered by value, and its data is never freed
+    if (self_in != index_cache_obj || self_len != index_cache.len) {
+        if (i < 0) {
+            goto scan;
+        }
+        str_index_cache_set(self_in, self_len, STR_INDEX_CHARS_UNKNOWN);
+    }
+    if (i < 0) {
+        if (index_cache.chars == STR_INDEX_CHARS_UNKNOWN) {
+            goto scan;
+        }
+        i += index_cache.chars;
+        if (i < 0) {
+            if (is_slice) {
+                return self_data;
+            }
+            nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_IndexError, "string index out of range"));
+        }
+    }
+    return str_index_cached(self_data, self_len, i, is_slice);
+scan:;
+    #else
+    (void)self_in;
+    #endif
     const byte *s, *top = self_data + self_len;
     if (i < 0)
     {
@@ -193,24 +307,24 @@ STATIC mp_obj_t str_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
 
             const byte *pstart, *pstop;
             if (ostart != mp_const_none) {
-                pstart = str_index_to_ptr(type, self_data, self_len, ostart, true);
+                pstart = str_index_to_ptr(self_in, type, self_data, self_len, ostart, true);
             } else {
                 pstart = self_data;
             }
             if (ostop != mp_const_none) {
                 // pstop will point just after the stop character. This depends on
                 // the \0 at the end of the string.
-                pstop = str_index_to_ptr(type, self_data, self_len, ostop, true);
+                pstop = str_index_to_ptr(self_in, type, self_data, self_len, ostop, true);
             } else {
                 pstop = self_data + self_len;
             }
             if (pstop < pstart) {
                 return MP_OBJ_NEW_QSTR(MP_QSTR_);
             }
-            return mp_obj_new_str_of_type(type, (const byte *)pstart, pstop - pstart);
+            return mp_obj_new_str_slice(self_in, (const byte *)pstart, pstop - pstart);
         }
 #endif
-        const byte *s = str_index_to_ptr(type, self_data, self_len, index, false);
+        const byte *s = str_index_to_ptr(self_in, type, self_data, self_len, index, false);
         int len = 1;
         if (UTF8_IS_NONASCII(*s)) {
             // Count the number of 1 bits (after the first)
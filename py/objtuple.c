@@ -239,9 +239,19 @@ mp_obj_t mp_obj_new_tuple(mp_uint_t n, const mp_obj_t *items) {
     if (n == 0) {
         return mp_const_empty_tuple;
     }
-    mp_obj_tuple_t *o = m_new_obj_var(mp_obj_tuple_t, mp_obj_t, n);
-    o->base.type = &mp_type_tuple;
-    o->len = n;
+    mp_obj_tuple_t *o;
+    #if MICROPY_OPT_TUPLE_POOL
+    if (n <= MICROPY_OPT_TUPLE_POOL && MP_STATE_THREAD(tuple_pool)[n - 1] != NULL) {
+        // a pooled tuple has its type and length set, and its items cleared
+        o = MP_STATE_THREAD(tuple_pool)[n - 1];
+        MP_STATE_THREAD(tuple_pool)[n - 1] = NULL;
+    } else
+    #endif
+    {
+        o = m_new_obj_var(mp_obj_tuple_t, mp_obj_t, n);
+        o->base.type = &mp_type_tuple;
+        o->len = n;
+    }
     if (items) {
         for (mp_uint_t i = 0; i < n; i++) {
             o->items[i] = items[i];
@@ -257,9 +267,18 @@ void mp_obj_tuple_get(mp_obj_t self_in, mp_uint_t *len, mp_obj_t **items) {
     *items = &self->items[0];
 }
 
+// The tuple must not be referenced from anywhere else
 void mp_obj_tuple_del(mp_obj_t self_in) {
     assert(MP_OBJ_IS_TYPE(self_in, &mp_type_tuple));
     mp_obj_tuple_t *self = MP_OBJ_TO_PTR(self_in);
+    #if MICROPY_OPT_TUPLE_POOL
+    if (self->len <= MICROPY_OPT_TUPLE_POOL && MP_STATE_THREAD(tuple_pool)[self->len - 1] == NULL) {
+        // clear the items so the pool doesn't keep them alive
+        memset(self->items, 0, self->len * sizeof(mp_obj_t));
+        MP_STATE_THREAD(tuple_pool)[self->len - 1] = self;
+        return;
+    }
+    #endif
     m_del_var(mp_obj_tuple_t, mp_obj_t, self->len, self);
 }
 
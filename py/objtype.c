@@ -48,14 +48,194 @@ STATIC mp_obj_t static_class_method_make_new(const mp_obj_type_t *self_in, size_
 /******************************************************************************/
 // instance object
 
+#if MICROPY_PY_SLOTS && !MICROPY_OPT_INSTANCE_SHARED_KEYS
+#error MICROPY_PY_SLOTS requires MICROPY_OPT_INSTANCE_SHARED_KEYS
+#endif
+
+#if MICROPY_OPT_INSTANCE_SHARED_KEYS
+// At most this many attribute names are shared by the instances of a class.
+// An instance that needs more, or different ones, gets a members map instead.
+#define INSTANCE_SHARED_KEYS_MAX (16)
+#endif
+
 STATIC mp_obj_t mp_obj_new_instance(const mp_obj_type_t *class, uint subobjs) {
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    // make room for the attributes that earlier instances of the class have set
+    uint n_values = ((const mp_obj_instance_type_t*)class)->n_shared_keys;
+    mp_obj_instance_t *o = m_new_obj_var(mp_obj_instance_t, mp_obj_t, subobjs + n_values);
+    o->base.type = class;
+    o->members = NULL;
+    o->n_subobj = subobjs;
+    o->n_values = n_values;
+    mp_seq_clear(o->subobj, 0, subobjs + n_values, sizeof(*o->subobj));
+    #else
     mp_obj_instance_t *o = m_new_obj_var(mp_obj_instance_t, mp_obj_t, subobjs);
     o->base.type = class;
     mp_map_init(&o->members, 0);
     mp_seq_clear(o->subobj, 0, subobjs, sizeof(*o->subobj));
+    #endif
     return MP_OBJ_FROM_PTR(o);
 }
 
+#if MICROPY_OPT_INSTANCE_SHARED_KEYS
+mp_obj_t *mp_obj_instance_lookup_slot(mp_obj_instance_t *self, qstr attr) {
+    const mp_obj_t *keys = ((const mp_obj_instance_type_t*)self->base.type)->shared_keys;
+    mp_obj_t key = MP_OBJ_NEW_QSTR(attr);
+    for (size_t i = 0; i < self->n_values; i++) {
+        if (keys[i] == key) {
+            return &mp_obj_instance_values(self)[i];
+        }
+    }
+    return NULL;
+}
+
+// Called when key is set on an instance of type which had n attributes.  If
+// those were the shared keys then key is appended to them, so that later
+// instances which set the same attributes in the same order can store them
+// without a members map.
+STATIC void instance_type_share_key(mp_obj_instance_type_t *type, mp_obj_t key, size_t n) {
+    if (n != type->n_shared_keys || n >= INSTANCE_SHARED_KEYS_MAX) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (type->shared_keys[i] == key) {
+            return;
+        }
+    }
+    if (n == type->alloc_shared_keys) {
+        #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+        // other threads may be reading the old keys, so leave them to the GC
+        mp_obj_t *keys = m_new(mp_obj_t, n + 4);
+        memcpy(keys, type->shared_keys, n * sizeof(mp_obj_t));
+        type->shared_keys = keys;
+        #else
+        type->shared_keys = m_renew(mp_obj_t, type->shared_keys, n, n + 4);
+        #endif
+        type->alloc_shared_keys = n + 4;
+    }
+    type->shared_keys[type->n_shared_keys++] = key;
+}
+
+#if MICROPY_PY_SLOTS
+STATIC void instance_type_add_slot(mp_obj_instance_type_t *type, mp_obj_t key) {
+    for (size_t i = 0; i < type->n_shared_keys; i++) {
+        if (type->shared_keys[i] == key) {
+            return;
+        }
+    }
+    size_t n = type->n_shared_keys;
+    if (n == type->alloc_shared_keys) {
+        type->shared_keys = m_renew(mp_obj_t, type->shared_keys, n, n + 4);
+        type->alloc_shared_keys = n + 4;
+    }
+    type->shared_keys[type->n_shared_keys++] = key;
+    type->n_slots++;
+}
+
+// Make the slots of the bases of type, followed by the names in its own
+// __slots__, its first shared keys.  Its instances are restricted to these
+// attributes if it and all its Python bases have __slots__, unless one of
+// them names __dict__.
+STATIC void instance_type_init_slots(mp_obj_instance_type_t *type) {
+    bool slots_only = true;
+    mp_obj_tuple_t *bases = type->type.bases_tuple;
+    for (size_t i = 0; i < bases->len; i++) {
+        const mp_obj_type_t *bt = MP_OBJ_TO_PTR(bases->items[i]);
+        if (mp_obj_is_instance_type(bt)) {
+            const mp_obj_instance_type_t *base = (const mp_obj_instance_type_t*)bt;
+            slots_only &= base->slots_only;
+            for (size_t j = 0; j < base->n_slots; j++) {
+                instance_type_add_slot(type, base->shared_keys[j]);
+            }
+        }
+    }
+
+    mp_map_elem_t *elem = mp_map_lookup(&type->type.locals_dict->map, MP_OBJ_NEW_QSTR(MP_QSTR___slots__), MP_MAP_LOOKUP);
+    if (elem == NULL) {
+        return;
+    }
+    mp_obj_t names = elem->value;
+    if (MP_OBJ_IS_STR(names)) {
+        // a single name
+        names = mp_obj_new_tuple(1, &names);
+    }
+    mp_obj_t iter = mp_getiter(names);
+    mp_obj_t name;
+    while ((name = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+        qstr q = mp_obj_str_get_qstr(name);
+        if (q == MP_QSTR___dict__) {
+            slots_only = false;
+        } else {
+            instance_type_add_slot(type, MP_OBJ_NEW_QSTR(q));
+        }
+    }
+    type->slots_only = slots_only;
+}
+#endif
+
+STATIC mp_obj_t instance_load_member(mp_obj_instance_t *self, qstr attr) {
+    if (self->members == NULL) {
+        mp_obj_t *slot = mp_obj_instance_lookup_slot(self, attr);
+        return slot == NULL ? MP_OBJ_NULL : *slot;
+    }
+    mp_map_elem_t *elem = mp_map_lookup(self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+    return elem == NULL ? MP_OBJ_NULL : elem->value;
+}
+
+// Stores value as attr of self, or deletes attr if value is MP_OBJ_NULL.
+// Returns false if there was no attr to delete.
+STATIC bool instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value) {
+    mp_obj_instance_type_t *type = (mp_obj_instance_type_t*)self->base.type;
+    mp_obj_t key = MP_OBJ_NEW_QSTR(attr);
+    if (self->members == NULL) {
+        mp_obj_t *slot = mp_obj_instance_lookup_slot(self, attr);
+        if (slot != NULL && (*slot != MP_OBJ_NULL || value != MP_OBJ_NULL)) {
+            *slot = value;
+            return true;
+        }
+        if (value == MP_OBJ_NULL) {
+            return false;
+        }
+        #if MICROPY_PY_SLOTS
+        if (type->slots_only) {
+            return false;
+        }
+        #endif
+
+        // there's no slot for attr, so move the attributes to a members map
+        const mp_obj_t *keys = type->shared_keys;
+        mp_obj_t *values = mp_obj_instance_values(self);
+        size_t n = 0;
+        for (size_t i = 0; i < self->n_values; i++) {
+            n += values[i] != MP_OBJ_NULL;
+        }
+        instance_type_share_key(type, key, n);
+        mp_map_t *map = mp_map_new(n + 1);
+        for (size_t i = 0; i < self->n_values; i++) {
+            if (values[i] != MP_OBJ_NULL) {
+                mp_map_lookup(map, keys[i], MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = values[i];
+            }
+        }
+        mp_map_lookup(map, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+        self->members = map;
+        // clear the values only now, so that they're never missing for a
+        // thread reading them without the GIL
+        mp_seq_clear(values, 0, self->n_values, sizeof(*values));
+        return true;
+    }
+
+    if (value == MP_OBJ_NULL) {
+        return mp_map_lookup(self->members, key, MP_MAP_LOOKUP_REMOVE_IF_FOUND) != NULL;
+    }
+    mp_map_elem_t *elem = mp_map_lookup(self->members, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+    if (elem->value == MP_OBJ_NULL) {
+        instance_type_share_key(type, key, self->members->used - 1);
+    }
+    elem->value = value;
+    return true;
+}
+#endif
+
 STATIC int instance_count_native_bases(const mp_obj_type_t *type, const mp_obj_type_t **last_native_base) {
     mp_uint_t len = type->bases_tuple->len;
     mp_obj_t *items = type->bases_tuple->items;
@@ -99,12 +279,44 @@ struct class_lookup_data {
     mp_uint_t meth_offset;
     mp_obj_t *dest;
     bool is_type;
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+    // set by the search if it visited a native type, whose attributes may
+    // depend on the object or meth_offset, so the result can't be cached
+    bool native_seen;
+    const mp_obj_type_t *found_type;
+    mp_obj_t found_value;
+    #endif
 };
 
-STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_type_t *type) {
+STATIC void class_lookup_convert(struct class_lookup_data *lookup, const mp_obj_type_t *type, mp_obj_t member) {
+    if (lookup->is_type) {
+        // If we look up a class method, we need to return original type for which we
+        // do a lookup, not a (base) type in which we found the class method.
+        const mp_obj_type_t *org_type = (const mp_obj_type_t*)lookup->obj;
+        mp_convert_member_lookup(MP_OBJ_NULL, org_type, member, lookup->dest);
+    } else {
+        mp_obj_instance_t *obj = lookup->obj;
+        mp_obj_t obj_obj;
+        if (obj != NULL && mp_obj_is_native_type(type) && type != &mp_type_object /* object is not a real type */) {
+            // If we're dealing with native base class, then it applies to native sub-object
+            obj_obj = obj->subobj[0];
+        } else {
+            obj_obj = MP_OBJ_FROM_PTR(obj);
+        }
+        mp_convert_member_lookup(obj_obj, type, member, lookup->dest);
+    }
+}
+
+STATIC void class_lookup_search(struct class_lookup_data  *lookup, const mp_obj_type_t *type) {
     assert(lookup->dest[0] == MP_OBJ_NULL);
     assert(lookup->dest[1] == MP_OBJ_NULL);
     for (;;) {
+        #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+        if (mp_obj_is_native_type(type)) {
+            lookup->native_seen = true;
+        }
+        #endif
+
         // Optimize special method lookup for native types
         // This avoids extra method_name => slot lookup. On the other hand,
         // this should not be applied to class types, as will result in extra
@@ -126,22 +338,11 @@ STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_
             mp_map_t *locals_map = &type->locals_dict->map;
             mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(lookup->attr), MP_MAP_LOOKUP);
             if (elem != NULL) {
-                if (lookup->is_type) {
-                    // If we look up a class method, we need to return original type for which we
-                    // do a lookup, not a (base) type in which we found the class method.
-                    const mp_obj_type_t *org_type = (const mp_obj_type_t*)lookup->obj;
-                    mp_convert_member_lookup(MP_OBJ_NULL, org_type, elem->value, lookup->dest);
-                } else {
-                    mp_obj_instance_t *obj = lookup->obj;
-                    mp_obj_t obj_obj;
-                    if (obj != NULL && mp_obj_is_native_type(type) && type != &mp_type_object /* object is not a real type */) {
-                        // If we're dealing with native base class, then it applies to native sub-object
-                        obj_obj = obj->subobj[0];
-                    } else {
-                        obj_obj = MP_OBJ_FROM_PTR(obj);
-                    }
-                    mp_convert_member_lookup(obj_obj, type, elem->value, lookup->dest);
-                }
+                #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+                lookup->found_type = type;
+                lookup->found_value = elem->value;
+                #endif
+                class_lookup_convert(lookup, type, elem->value);
 #if DEBUG_PRINT
                 printf("mp_obj_class_lookup: Returning: ");
                 mp_obj_print(lookup->dest[0], PRINT_REPR); printf(" ");
@@ -180,7 +381,7 @@ STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_
                 // Not a "real" type
                 continue;
             }
-            mp_obj_class_lookup(lookup, bt);
+            class_lookup_search(lookup, bt);
             if (lookup->dest[0] != MP_OBJ_NULL) {
                 return;
             }
@@ -196,6 +397,47 @@ STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_
     }
 }
 
+#if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+// Each entry of the cache holds where a search of the hierarchy of a type for
+// an attribute ended: the type and value it was found in the locals of, or
+// MP_OBJ_NULL if it wasn't found.  Only searches that visit Python classes
+// alone are cached.  The entries are made stale by incrementing the version
+// whenever a class is created, or an attribute of one is stored or deleted.
+#define CLASS_CACHE_ENTRY(type, attr) (&MP_STATE_VM(class_lookup_cache)[ \
+    ((((uintptr_t)(type)) >> 3) ^ (attr)) % MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE])
+
+STATIC void class_lookup_cache_invalidate(void) {
+    if (++MP_STATE_VM(class_lookup_version) == 0) {
+        // the version wrapped around, so old entries could match it again
+        memset(MP_STATE_VM(class_lookup_cache), 0, sizeof(MP_STATE_VM(class_lookup_cache)));
+    }
+}
+#endif
+
+STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_type_t *type) {
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+    mp_class_lookup_cache_entry_t *entry = CLASS_CACHE_ENTRY(type, lookup->attr);
+    if (entry->type == type && entry->attr == lookup->attr && entry->version == MP_STATE_VM(class_lookup_version)) {
+        if (entry->value != MP_OBJ_NULL) {
+            class_lookup_convert(lookup, entry->found_type, entry->value);
+        }
+        return;
+    }
+    lookup->native_seen = false;
+    lookup->found_type = NULL;
+    class_lookup_search(lookup, type);
+    if (!lookup->native_seen) {
+        entry->type = type;
+        entry->attr = lookup->attr;
+        entry->version = MP_STATE_VM(class_lookup_version);
+        entry->found_type = lookup->found_type;
+        entry->value = lookup->found_type == NULL ? MP_OBJ_NULL : lookup->found_value;
+    }
+    #else
+    class_lookup_search(lookup, type);
+    #endif
+}
+
 STATIC void instance_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     mp_obj_instance_t *self = MP_OBJ_TO_PTR(self_in);
     qstr meth = (kind == PRINT_STR) ? MP_QSTR___str__ : MP_QSTR___repr__;
@@ -466,6 +708,15 @@ STATIC void mp_obj_instance_load_attr(mp_obj_t self_in, qstr attr, mp_obj_t *des
     assert(mp_obj_is_instance_type(mp_obj_get_type(self_in)));
     mp_obj_instance_t *self = MP_OBJ_TO_PTR(self_in);
 
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    mp_obj_t value = instance_load_member(self, attr);
+    if (value != MP_OBJ_NULL) {
+        // object member, always treated as a value
+        // TODO should we check for properties?
+        dest[0] = value;
+        return;
+    }
+    #else
     mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
     if (elem != NULL) {
         // object member, always treated as a value
@@ -473,12 +724,33 @@ STATIC void mp_obj_instance_load_attr(mp_obj_t self_in, qstr attr, mp_obj_t *des
         dest[0] = elem->value;
         return;
     }
+    #endif
 #if MICROPY_CPYTHON_COMPAT
+    #if MICROPY_PY_SLOTS
+    if (attr == MP_QSTR___dict__ && !((mp_obj_instance_type_t*)self->base.type)->slots_only) {
+    #else
     if (attr == MP_QSTR___dict__) {
+    #endif
         // Create a new dict with a copy of the instance's map items.
         // This creates, unlike CPython, a 'read-only' __dict__: modifying
         // it will not result in modifications to the actual instance members.
+        #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+        if (self->members == NULL) {
+            const mp_obj_t *keys = ((mp_obj_instance_type_t*)self->base.type)->shared_keys;
+            mp_obj_t *values = mp_obj_instance_values(self);
+            mp_obj_t attr_dict = mp_obj_new_dict(self->n_values);
+            for (size_t i = 0; i < self->n_values; ++i) {
+                if (values[i] != MP_OBJ_NULL) {
+                    mp_obj_dict_store(attr_dict, keys[i], values[i]);
+                }
+            }
+            dest[0] = attr_dict;
+            return;
+        }
+        mp_map_t *map = self->members;
+        #else
         mp_map_t *map = &self->members;
+        #endif
         mp_obj_t attr_dict = mp_obj_new_dict(map->used);
         for (mp_uint_t i = 0; i < map->alloc; ++i) {
             if (MP_MAP_SLOT_IS_FILLED(map, i)) {
@@ -627,15 +899,32 @@ STATIC bool mp_obj_instance_store_attr(mp_obj_t self_in, qstr attr, mp_obj_t val
     }
     #endif
 
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS && MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+    // without the GIL only one thread at a time may move the attributes of an
+    // instance to a members map, or add to the shared keys of a type
+    mp_thread_mutex_lock(&MP_STATE_VM(instance_mutex), 1);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        mp_thread_mutex_unlock(&MP_STATE_VM(instance_mutex));
+        nlr_jump(nlr.ret_val);
+    }
+    bool stored = instance_store_member(self, attr, value);
+    nlr_pop();
+    mp_thread_mutex_unlock(&MP_STATE_VM(instance_mutex));
+    return stored;
+    #elif MICROPY_OPT_INSTANCE_SHARED_KEYS
+    return instance_store_member(self, attr, value);
+    #else
     if (value == MP_OBJ_NULL) {
         // delete attribute
         mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND);
         return elem != NULL;
     } else {
         // store attribute
-        mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+        mp_map_store(&self->members, MP_OBJ_NEW_QSTR(attr), value);
         return true;
     }
+    #endif
 }
 
 void mp_obj_instance_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
@@ -847,6 +1136,9 @@ STATIC void type_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
         if (self->locals_dict != NULL) {
             assert(self->locals_dict->base.type == &mp_type_dict); // MicroPython restriction, for now
             mp_map_t *locals_map = &self->locals_dict->map;
+            #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+            class_lookup_cache_invalidate();
+            #endif
             if (dest[1] == MP_OBJ_NULL) {
                 // delete attribute
                 mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND);
@@ -856,10 +1148,9 @@ STATIC void type_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
                 }
             } else {
                 // store attribute
-                mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+                mp_map_elem_t *elem = mp_map_store(locals_map, MP_OBJ_NEW_QSTR(attr), dest[1]);
                 // note that locals_map may be in ROM, so add will fail in that case
                 if (elem != NULL) {
-                    elem->value = dest[1];
                     dest[0] = MP_OBJ_NULL; // indicate success
                 }
             }
@@ -901,7 +1192,11 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
         }
     }
 
-    mp_obj_type_t *o = m_new0(mp_obj_type_t, 1);
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    mp_obj_type_t *o = mp_import_is_toplevel() ? &m_new0_ll(mp_obj_instance_type_t, 1)->type : &m_new0(mp_obj_instance_type_t, 1)->type;
+    #else
+    mp_obj_type_t *o = mp_import_is_toplevel() ? m_new0_ll(mp_obj_type_t, 1) : m_new0(mp_obj_type_t, 1);
+    #endif
     o->base.type = &mp_type_type;
     o->name = name;
     o->print = instance_print;
@@ -924,6 +1219,11 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
     o->bases_tuple = MP_OBJ_TO_PTR(bases_tuple);
     o->locals_dict = MP_OBJ_TO_PTR(locals_dict);
 
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+    // the new class may be at the address of one that was freed
+    class_lookup_cache_invalidate();
+    #endif
+
     const mp_obj_type_t *native_base;
     uint num_native_bases = instance_count_native_bases(o, &native_base);
     if (num_native_bases > 1) {
@@ -940,6 +1240,10 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
         }
     }
 
+    #if MICROPY_PY_SLOTS
+    instance_type_init_slots((mp_obj_instance_type_t*)o);
+    #endif
+
     return MP_OBJ_FROM_PTR(o);
 }
 
@@ -32,11 +32,46 @@
 // creating an instance of a class makes one of these objects
 typedef struct _mp_obj_instance_t {
     mp_obj_base_t base;
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    // While members is NULL the attributes are stored after the subobjs, in
+    // n_values slots which line up with the shared keys of the type, and an
+    // unset attribute has value MP_OBJ_NULL.  Otherwise members holds them all.
+    mp_map_t *members;
+    uint16_t n_subobj;
+    uint16_t n_values;
+    #else
     mp_map_t members;
+    #endif
     mp_obj_t subobj[];
     // TODO maybe cache __getattr__ and __setattr__ for efficient lookup of them
 } mp_obj_instance_t;
 
+#if MICROPY_OPT_INSTANCE_SHARED_KEYS
+// a class created by type() or a class statement
+// the names of the attributes stored on its instances are appended to
+// shared_keys in the order they are first set, and never removed
+typedef struct _mp_obj_instance_type_t {
+    mp_obj_type_t type;
+    uint16_t n_shared_keys;
+    uint16_t alloc_shared_keys;
+    #if MICROPY_PY_SLOTS
+    // the first n_slots shared keys are the names in __slots__ of the class
+    // and its bases; if slots_only then instances can have no other attributes
+    uint16_t n_slots;
+    bool slots_only;
+    #endif
+    mp_obj_t *shared_keys;
+} mp_obj_instance_type_t;
+
+static inline mp_obj_t *mp_obj_instance_values(mp_obj_instance_t *self) {
+    return &self->subobj[self->n_subobj];
+}
+
+// returns the slot for attr among the values of self, which must not have a
+// members map, or NULL if there is none; the slot may hold MP_OBJ_NULL
+mp_obj_t *mp_obj_instance_lookup_slot(mp_obj_instance_t *self, qstr attr);
+#endif
+
 // this needs to be exposed for MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE to work
 void mp_obj_instance_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest);
 
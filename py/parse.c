@@ -148,10 +148,15 @@ typedef struct _parser_t {
     mp_parse_chunk_t *cur_chunk;
 
     #if MICROPY_COMP_CONST
-    mp_map_t consts;
+    mp_map_t *consts;
     #endif
 } parser_t;
 
+#if MICROPY_COMP_INCREMENTAL
+// internal input kind for mp_parse_stmts_next: a single statement of a file
+#define MP_PARSE_STMT_INPUT ((mp_parse_input_kind_t)(MP_PARSE_EVAL_INPUT + 1))
+#endif
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-align"
 STATIC void *parser_alloc(parser_t *parser, size_t num_bytes) {
@@ -410,8 +415,13 @@ STATIC void push_result_token(parser_t *parser, const rule_t *rule) {
         // if name is a standalone identifier, look it up in the table of dynamic constants
         mp_map_elem_t *elem;
         if (rule->rule_id == RULE_atom
-            && (elem = mp_map_lookup(&parser->consts, MP_OBJ_NEW_QSTR(id), MP_MAP_LOOKUP)) != NULL) {
-            pn = mp_parse_node_new_leaf(MP_PARSE_NODE_SMALL_INT, MP_OBJ_SMALL_INT_VALUE(elem->value));
+            && (elem = mp_map_lookup(parser->consts, MP_OBJ_NEW_QSTR(id), MP_MAP_LOOKUP)) != NULL) {
+            if (MP_OBJ_IS_SMALL_INT(elem->value)) {
+                pn = mp_parse_node_new_leaf(MP_PARSE_NODE_SMALL_INT, MP_OBJ_SMALL_INT_VALUE(elem->value));
+            } else {
+                pn = mp_parse_node_new_leaf(MP_PARSE_NODE_TOKEN,
+                    elem->value == mp_const_true ? MP_TOKEN_KW_TRUE : MP_TOKEN_KW_FALSE);
+            }
         } else {
             pn = mp_parse_node_new_leaf(MP_PARSE_NODE_ID, id);
         }
@@ -470,9 +480,54 @@ STATIC MP_DEFINE_CONST_MAP(mp_constants_map, mp_constants_table);
 STATIC void push_result_rule(parser_t *parser, size_t src_line, const rule_t *rule, size_t num_args);
 
 #if MICROPY_COMP_CONST_FOLDING
+// returns 1 if pn is a constant that is true, 0 if it's a constant that is
+// false, and -1 if it's not a constant
+STATIC int parse_node_get_truth_maybe(mp_parse_node_t pn) {
+    mp_obj_t o;
+    if (MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_KW_TRUE)) {
+        return 1;
+    } else if (MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_KW_FALSE)
+        || MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_KW_NONE)) {
+        return 0;
+    } else if (mp_parse_node_get_int_maybe(pn, &o)) {
+        return mp_obj_is_true(o);
+    } else {
+        return -1;
+    }
+}
+
+#if MICROPY_COMP_CONST_TUPLE
+// gets the value of a constant that can go in a constant tuple, without allocating
+STATIC bool parse_node_get_const_maybe(mp_parse_node_t pn, mp_obj_t *o) {
+    if (MP_PARSE_NODE_IS_SMALL_INT(pn)) {
+        *o = MP_OBJ_NEW_SMALL_INT(MP_PARSE_NODE_LEAF_SMALL_INT(pn));
+    } else if (MP_PARSE_NODE_LEAF_KIND(pn) == MP_PARSE_NODE_STRING) {
+        *o = MP_OBJ_NEW_QSTR(MP_PARSE_NODE_LEAF_ARG(pn));
+    } else if (MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_KW_NONE)) {
+        *o = mp_const_none;
+    } else if (MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_KW_TRUE)) {
+        *o = mp_const_true;
+    } else if (MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_KW_FALSE)) {
+        *o = mp_const_false;
+    } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pn, RULE_const_object)) {
+        mp_parse_node_struct_t *pns = (mp_parse_node_struct_t*)pn;
+        #if MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_D
+        *o = (uint64_t)pns->nodes[0] | ((uint64_t)pns->nodes[1] << 32);
+        #else
+        *o = (mp_obj_t)pns->nodes[0];
+        #endif
+    } else {
+        return false;
+    }
+    return true;
+}
+#endif
+
 STATIC bool fold_constants(parser_t *parser, const rule_t *rule, size_t num_args) {
     // this code does folding of arbitrary integer expressions, eg 1 + 2 * 3 + 4
     // it does not do partial folding, eg 1 + 2 + x -> 3 + x
+    // comparisons, not, and, or of constants are folded to constants, as are
+    // parenthesised tuples of constants
 
     mp_obj_t arg0;
     if (rule->rule_id == RULE_expr
@@ -563,6 +618,119 @@ STATIC bool fold_constants(parser_t *parser, const rule_t *rule, size_t num_args
         }
         arg0 = mp_unary_op(op, arg0);
 
+    } else if (rule->rule_id == RULE_comparison) {
+        // folding for integer comparisons: < > == <= >= != and chains of them
+        mp_parse_node_t pn = peek_result(parser, num_args - 1);
+        if (!mp_parse_node_get_int_maybe(pn, &arg0)) {
+            return false;
+        }
+        bool result = true;
+        for (ssize_t i = num_args - 2; i >= 1; i -= 2) {
+            pn = peek_result(parser, i);
+            if (!MP_PARSE_NODE_IS_TOKEN(pn)) {
+                // is, is not, not in
+                return false;
+            }
+            mp_binary_op_t op;
+            switch (MP_PARSE_NODE_LEAF_ARG(pn)) {
+                case MP_TOKEN_OP_LESS: op = MP_BINARY_OP_LESS; break;
+                case MP_TOKEN_OP_MORE: op = MP_BINARY_OP_MORE; break;
+                case MP_TOKEN_OP_DBL_EQUAL: op = MP_BINARY_OP_EQUAL; break;
+                case MP_TOKEN_OP_LESS_EQUAL: op = MP_BINARY_OP_LESS_EQUAL; break;
+                case MP_TOKEN_OP_MORE_EQUAL: op = MP_BINARY_OP_MORE_EQUAL; break;
+                case MP_TOKEN_OP_NOT_EQUAL: op = MP_BINARY_OP_NOT_EQUAL; break;
+                default: return false; // in
+            }
+            mp_obj_t arg1;
+            if (!mp_parse_node_get_int_maybe(peek_result(parser, i - 1), &arg1)) {
+                return false;
+            }
+            if (result && mp_binary_op(op, arg0, arg1) == mp_const_false) {
+                result = false;
+            }
+            arg0 = arg1;
+        }
+        arg0 = mp_obj_new_bool(result);
+
+    } else if (rule->rule_id == RULE_not_test_2) {
+        // folding for: not <constant>
+        int truth = parse_node_get_truth_maybe(peek_result(parser, 0));
+        if (truth < 0) {
+            return false;
+        }
+        arg0 = mp_obj_new_bool(!truth);
+
+    } else if (rule->rule_id == RULE_and_test || rule->rule_id == RULE_or_test) {
+        // partial folding for and/or: leading constants that don't decide the
+        // result are dropped, eg 1 and x -> x, and one that does decide it
+        // replaces the whole expression, eg 0 and x -> 0
+        int decider = rule->rule_id == RULE_or_test;
+        size_t n_drop = 0;
+        for (; n_drop < num_args; n_drop++) {
+            mp_parse_node_t pn = peek_result(parser, num_args - 1 - n_drop);
+            int truth = parse_node_get_truth_maybe(pn);
+            if (truth < 0) {
+                break;
+            }
+            if (truth == decider || n_drop == num_args - 1) {
+                for (size_t i = num_args; i > 0; i--) {
+                    pop_result(parser);
+                }
+                push_result_node(parser, pn);
+                return true;
+            }
+        }
+        if (n_drop == 0) {
+            return false;
+        }
+        // remove the dropped operands from underneath the remaining ones
+        mp_parse_node_t *args = &parser->result_stack[parser->result_stack_top - num_args];
+        memmove(args, args + n_drop, (num_args - n_drop) * sizeof(mp_parse_node_t));
+        parser->result_stack_top -= n_drop;
+        if (num_args - n_drop > 1) {
+            push_result_rule(parser, 0, rule, num_args - n_drop);
+        }
+        return true;
+
+    #if MICROPY_COMP_CONST_TUPLE
+    } else if (rule->rule_id == RULE_atom_paren) {
+        // folding for tuples of constants, eg (1, 'a', None)
+        mp_parse_node_t pn = peek_result(parser, 0);
+        if (!MP_PARSE_NODE_IS_STRUCT_KIND(pn, RULE_testlist_comp)) {
+            return false;
+        }
+        mp_parse_node_struct_t *pns = (mp_parse_node_struct_t*)pn;
+        mp_parse_node_t *items = &pns->nodes[1];
+        size_t n = 1;
+        if (MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], RULE_testlist_comp_3b)) {
+            // sequence of one item, with trailing comma
+            n = 0;
+        } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], RULE_testlist_comp_3c)) {
+            // sequence of many items
+            mp_parse_node_struct_t *pns1 = (mp_parse_node_struct_t*)pns->nodes[1];
+            items = &pns1->nodes[0];
+            n = MP_PARSE_NODE_STRUCT_NUM_NODES(pns1);
+        } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[1], RULE_comp_for)) {
+            // generator expression
+            return false;
+        }
+        mp_obj_t o;
+        if (!parse_node_get_const_maybe(pns->nodes[0], &o)) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!parse_node_get_const_maybe(items[i], &o)) {
+                return false;
+            }
+        }
+        mp_obj_tuple_t *tuple = MP_OBJ_TO_PTR(mp_obj_new_tuple(1 + n, NULL));
+        parse_node_get_const_maybe(pns->nodes[0], &tuple->items[0]);
+        for (size_t i = 0; i < n; i++) {
+            parse_node_get_const_maybe(items[i], &tuple->items[1 + i]);
+        }
+        arg0 = MP_OBJ_FROM_PTR(tuple);
+    #endif
+
     #if MICROPY_COMP_CONST
     } else if (rule->rule_id == RULE_expr_stmt) {
         mp_parse_node_t pn1 = peek_result(parser, 0);
@@ -582,18 +750,24 @@ STATIC bool fold_constants(parser_t *parser, const rule_t *rule, size_t num_args
                 // get the id
                 qstr id = MP_PARSE_NODE_LEAF_ARG(pn0);
 
-                // get the value
+                // get the value, which can be an integer or a bool
                 mp_parse_node_t pn_value = ((mp_parse_node_struct_t*)((mp_parse_node_struct_t*)pn1)->nodes[1])->nodes[0];
-                if (!MP_PARSE_NODE_IS_SMALL_INT(pn_value)) {
+                mp_obj_t value;
+                if (MP_PARSE_NODE_IS_SMALL_INT(pn_value)) {
+                    value = MP_OBJ_NEW_SMALL_INT(MP_PARSE_NODE_LEAF_SMALL_INT(pn_value));
+                } else if (MP_PARSE_NODE_IS_TOKEN_KIND(pn_value, MP_TOKEN_KW_TRUE)) {
+                    value = mp_const_true;
+                } else if (MP_PARSE_NODE_IS_TOKEN_KIND(pn_value, MP_TOKEN_KW_FALSE)) {
+                    value = mp_const_false;
+                } else {
                     parser->parse_error = PARSE_ERROR_CONST;
                     return false;
                 }
-                mp_int_t value = MP_PARSE_NODE_LEAF_SMALL_INT(pn_value);
 
                 // store the value in the table of dynamic constants
-                mp_map_elem_t *elem = mp_map_lookup(&parser->consts, MP_OBJ_NEW_QSTR(id), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+                mp_map_elem_t *elem = mp_map_lookup(parser->consts, MP_OBJ_NEW_QSTR(id), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
                 assert(elem->value == MP_OBJ_NULL);
-                elem->value = MP_OBJ_NEW_SMALL_INT(value);
+                elem->value = value;
 
                 // If the constant starts with an underscore then treat it as a private
                 // variable and don't emit any code to store the value to the id.
@@ -652,6 +826,9 @@ STATIC bool fold_constants(parser_t *parser, const rule_t *rule, size_t num_args
     }
     if (MP_OBJ_IS_SMALL_INT(arg0)) {
         push_result_node(parser, mp_parse_node_new_leaf(MP_PARSE_NODE_SMALL_INT, MP_OBJ_SMALL_INT_VALUE(arg0)));
+    } else if (arg0 == mp_const_true || arg0 == mp_const_false) {
+        push_result_node(parser, mp_parse_node_new_leaf(MP_PARSE_NODE_TOKEN,
+            arg0 == mp_const_true ? MP_TOKEN_KW_TRUE : MP_TOKEN_KW_FALSE));
     } else {
         // TODO reuse memory for parse node struct?
         push_result_node(parser, make_node_const_object(parser, 0, arg0));
@@ -696,7 +873,10 @@ STATIC void push_result_rule(parser_t *parser, size_t src_line, const rule_t *ru
     push_result_node(parser, (mp_parse_node_t)pn);
 }
 
-mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
+// consts is the table of dynamic constants to use, it's freed unless this is
+// a MP_PARSE_STMT_INPUT in which case the lexer is also kept
+STATIC mp_parse_tree_t parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind, mp_map_t *consts) {
+    MP_CYCLES_BEGIN(PARSE);
 
     // initialise parser and allocate memory for its stacks
 
@@ -718,7 +898,9 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     parser.cur_chunk = NULL;
 
     #if MICROPY_COMP_CONST
-    mp_map_init(&parser.consts, 0);
+    parser.consts = consts;
+    #else
+    (void)consts;
     #endif
 
     // check if we could allocate the stacks
@@ -727,13 +909,26 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     }
 
     // work out the top-level rule to use, and push it on the stack
-    size_t top_level_rule;
-    switch (input_kind) {
-        case MP_PARSE_SINGLE_INPUT: top_level_rule = RULE_single_input; break;
-        case MP_PARSE_EVAL_INPUT: top_level_rule = RULE_eval_input; break;
-        default: top_level_rule = RULE_file_input;
+    #if MICROPY_COMP_INCREMENTAL
+    if (input_kind == MP_PARSE_STMT_INPUT) {
+        // skip blank lines; at the end of the input there is no rule to parse
+        while (lex->tok_kind == MP_TOKEN_NEWLINE) {
+            mp_lexer_to_next(lex);
+        }
+        if (lex->tok_kind != MP_TOKEN_END) {
+            push_rule(&parser, lex->tok_line, rules[RULE_stmt], 0);
+        }
+    } else
+    #endif
+    {
+        size_t top_level_rule;
+        switch (input_kind) {
+            case MP_PARSE_SINGLE_INPUT: top_level_rule = RULE_single_input; break;
+            case MP_PARSE_EVAL_INPUT: top_level_rule = RULE_eval_input; break;
+            default: top_level_rule = RULE_file_input;
+        }
+        push_rule(&parser, lex->tok_line, rules[top_level_rule], 0);
     }
-    push_rule(&parser, lex->tok_line, rules[top_level_rule], 0);
 
     // parse!
 
@@ -1008,7 +1203,12 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     }
 
     #if MICROPY_COMP_CONST
-    mp_map_deinit(&parser.consts);
+    #if MICROPY_COMP_INCREMENTAL
+    if (input_kind != MP_PARSE_STMT_INPUT)
+    #endif
+    {
+        mp_map_deinit(parser.consts);
+    }
     #endif
 
     // truncate final chunk and link into chain of chunks
@@ -1038,6 +1238,20 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                 "parser could not allocate enough memory");
         }
         parser.tree.root = MP_PARSE_NODE_NULL;
+    #if MICROPY_COMP_INCREMENTAL
+    } else if (input_kind == MP_PARSE_STMT_INPUT && parser.result_stack_top == 0) {
+        // no statement is only valid at the end of the input
+        if (lex->tok_kind != MP_TOKEN_END) {
+            goto syntax_error;
+        }
+        exc = MP_OBJ_NULL;
+        parser.tree.root = MP_PARSE_NODE_NULL;
+    } else if (input_kind == MP_PARSE_STMT_INPUT) {
+        // the rest of the input is left for the next statement
+        assert(parser.result_stack_top == 1);
+        exc = MP_OBJ_NULL;
+        parser.tree.root = parser.result_stack[0];
+    #endif
     } else if (
         lex->tok_kind != MP_TOKEN_END // check we are at the end of the token stream
         || parser.result_stack_top == 0 // check that we got a node (can fail on empty input)
@@ -1072,20 +1286,55 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     m_del(rule_stack_t, parser.rule_stack, parser.rule_stack_alloc);
     m_del(mp_parse_node_t, parser.result_stack, parser.result_stack_alloc);
     // we also free the lexer on behalf of the caller (see below)
+    MP_CYCLES_END(PARSE);
 
     if (exc != MP_OBJ_NULL) {
         // had an error so raise the exception
         // add traceback to give info about file name and location
         // we don't have a 'block' name, so just pass the NULL qstr to indicate this
         mp_obj_exception_add_traceback(exc, lex->source_name, lex->tok_line, MP_QSTR_NULL);
-        mp_lexer_free(lex);
+        #if MICROPY_COMP_INCREMENTAL
+        if (input_kind != MP_PARSE_STMT_INPUT)
+        #endif
+        {
+            mp_lexer_free(lex);
+        }
         nlr_raise(exc);
     } else {
-        mp_lexer_free(lex);
+        #if MICROPY_COMP_INCREMENTAL
+        if (input_kind != MP_PARSE_STMT_INPUT)
+        #endif
+        {
+            mp_lexer_free(lex);
+        }
         return parser.tree;
     }
 }
 
+mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
+    mp_map_t consts;
+    #if MICROPY_COMP_CONST
+    mp_map_init(&consts, 0);
+    #endif
+    return parse(lex, input_kind, &consts);
+}
+
+#if MICROPY_COMP_INCREMENTAL
+void mp_parse_stmts_init(mp_parse_stmts_t *stmts, mp_lexer_t *lex) {
+    stmts->lex = lex;
+    mp_map_init(&stmts->consts, 0);
+}
+
+mp_parse_tree_t mp_parse_stmts_next(mp_parse_stmts_t *stmts) {
+    return parse(stmts->lex, MP_PARSE_STMT_INPUT, &stmts->consts);
+}
+
+void mp_parse_stmts_deinit(mp_parse_stmts_t *stmts) {
+    mp_map_deinit(&stmts->consts);
+    mp_lexer_free(stmts->lex);
+}
+#endif
+
 void mp_parse_tree_clear(mp_parse_tree_t *tree) {
     mp_parse_chunk_t *chunk = tree->chunk;
     while (chunk != NULL) {
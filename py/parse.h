@@ -97,4 +97,21 @@ typedef struct _mp_parse_t {
 mp_parse_tree_t mp_parse(struct _mp_lexer_t *lex, mp_parse_input_kind_t input_kind);
 void mp_parse_tree_clear(mp_parse_tree_t *tree);
 
+#if MICROPY_COMP_INCREMENTAL
+// state for parsing a file one top-level statement at a time, so that each
+// statement can be compiled and its parse tree freed before the next is read
+typedef struct _mp_parse_stmts_t {
+    struct _mp_lexer_t *lex;
+    mp_map_t consts;
+} mp_parse_stmts_t;
+
+// the lexer belongs to stmts until mp_parse_stmts_deinit, which must be
+// called even if parsing raised an exception
+void mp_parse_stmts_init(mp_parse_stmts_t *stmts, struct _mp_lexer_t *lex);
+// the parser will raise an exception if an error occurred
+// the root of the tree is MP_PARSE_NODE_NULL at the end of the input
+mp_parse_tree_t mp_parse_stmts_next(mp_parse_stmts_t *stmts);
+void mp_parse_stmts_deinit(mp_parse_stmts_t *stmts);
+#endif
+
 #endif // __MICROPY_INCLUDED_PY_PARSE_H__
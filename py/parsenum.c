@@ -164,6 +164,232 @@ value_error:
     }
 }
 
+#if MICROPY_PY_BUILTINS_FLOAT
+
+// A decimal number is parsed into an integer times a power of 10, and turned
+// into the nearest float.  If both the integer and the power of 10 are exact
+// in a float then a single multiply or divide does that (W. D. Clinger, "How
+// to Read Floating Point Numbers Accurately", PLDI 1990), which covers most
+// numbers with a few digits, as written in source code and data.  Otherwise
+// the float is approximated and then corrected by comparing the number with
+// the points halfway to the neighbouring floats, using big integers.  This is
+// correctly rounded when there are at most DEC_MANT_DIGITS significant digits,
+// enough for any float printed by repr() to read back the same.
+
+#if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+typedef uint32_t dec_mant_t;
+typedef uint32_t dec_float_bits_t;
+#define DEC_MANT_DIGITS (9)
+#define DEC_MANT_EXACT_MAX (0xffffff) // 2^24 - 1
+#define DEC_POW10_EXACT_MAX (10)
+#define DEC_POW10_MAX (38)
+#define DEC_EXP10_MIN (-45) // numbers below 10^this round to 0
+#define DEC_EXP10_MAX (39) // numbers from 10^this round to inf
+#define DEC_FLOAT_MANT_BITS (23)
+#define DEC_FLOAT_EXP_BIAS (127 + DEC_FLOAT_MANT_BITS)
+#define DEC_FLOAT_EXP_MASK (0xff)
+#define DEC_FLOAT_MAX_BITS (0x7f7fffff)
+#define DEC_BIG_WORDS (8)
+STATIC const float dec_pow10[] = {
+    1e0F, 1e1F, 1e2F, 1e3F, 1e4F, 1e5F, 1e6F, 1e7F, 1e8F, 1e9F, 1e10F,
+};
+#else
+typedef uint64_t dec_mant_t;
+typedef uint64_t dec_float_bits_t;
+#define DEC_MANT_DIGITS (19)
+#define DEC_MANT_EXACT_MAX (0x1fffffffffffff) // 2^53 - 1
+#define DEC_POW10_EXACT_MAX (22)
+#define DEC_POW10_MAX (308)
+#define DEC_EXP10_MIN (-324)
+#define DEC_EXP10_MAX (310)
+#define DEC_FLOAT_MANT_BITS (52)
+#define DEC_FLOAT_EXP_BIAS (1023 + DEC_FLOAT_MANT_BITS)
+#define DEC_FLOAT_EXP_MASK (0x7ff)
+#define DEC_FLOAT_MAX_BITS (0x7fefffffffffffff)
+#define DEC_BIG_WORDS (42)
+STATIC const double dec_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+#endif
+
+typedef union _dec_float_t {
+    mp_float_t f;
+    dec_float_bits_t u;
+} dec_float_t;
+
+// Just enough of an unsigned big integer to compare a decimal number with
+// the halfway point between two floats
+typedef struct _dec_big_t {
+    size_t len;
+    uint32_t d[DEC_BIG_WORDS];
+} dec_big_t;
+
+STATIC void dec_big_init(dec_big_t *b, uint64_t x) {
+    b->d[0] = x;
+    b->d[1] = x >> 32;
+    b->len = b->d[1] != 0 ? 2 : 1;
+}
+
+STATIC void dec_big_mul(dec_big_t *b, uint32_t x) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < b->len; i++) {
+        carry += (uint64_t)b->d[i] * x;
+        b->d[i] = carry;
+        carry >>= 32;
+    }
+    if (carry != 0) {
+        assert(b->len < DEC_BIG_WORDS);
+        b->d[b->len++] = carry;
+    }
+}
+
+STATIC void dec_big_mul_pow10(dec_big_t *b, mp_uint_t n) {
+    for (; n >= 9; n -= 9) {
+        dec_big_mul(b, 1000000000);
+    }
+    uint32_t x = 1;
+    while (n-- > 0) {
+        x *= 10;
+    }
+    dec_big_mul(b, x);
+}
+
+STATIC void dec_big_shl(dec_big_t *b, mp_uint_t n) {
+    size_t words = n / 32;
+    uint bits = n % 32;
+    assert(b->len + words < DEC_BIG_WORDS);
+    b->d[b->len] = 0;
+    for (size_t i = b->len + 1; i-- > 0;) {
+        uint32_t hi = b->d[i] << bits;
+        uint32_t lo = (bits != 0 && i > 0) ? b->d[i - 1] >> (32 - bits) : 0;
+        b->d[i + words] = hi | lo;
+    }
+    for (size_t i = 0; i < words; i++) {
+        b->d[i] = 0;
+    }
+    b->len += words + 1;
+    while (b->len > 1 && b->d[b->len - 1] == 0) {
+        b->len -= 1;
+    }
+}
+
+// Compare mant * 10^e10 with half * 2^e2
+STATIC int dec_cmp_halfway(dec_mant_t mant, mp_int_t e10, uint64_t half, mp_int_t e2) {
+    dec_big_t a, b;
+    dec_big_init(&a, mant);
+    dec_big_init(&b, half);
+    if (e10 >= 0) {
+        dec_big_mul_pow10(&a, e10);
+    } else {
+        dec_big_mul_pow10(&b, -e10);
+    }
+    if (e2 >= 0) {
+        dec_big_shl(&b, e2);
+    } else {
+        dec_big_shl(&a, -e2);
+    }
+    if (a.len != b.len) {
+        return a.len < b.len ? -1 : 1;
+    }
+    for (size_t i = a.len; i-- > 0;) {
+        if (a.d[i] != b.d[i]) {
+            return a.d[i] < b.d[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// The float nearest to mant * 10^e, with ties to even
+STATIC mp_float_t dec_to_float(dec_mant_t mant, mp_int_t e) {
+    if (mant == 0) {
+        return 0;
+    }
+
+    // move some of a large exponent into the integer while it stays exact
+    while (e > DEC_POW10_EXACT_MAX && mant <= DEC_MANT_EXACT_MAX / 10) {
+        mant *= 10;
+        e -= 1;
+    }
+    if (mant <= DEC_MANT_EXACT_MAX && -DEC_POW10_EXACT_MAX <= e && e <= DEC_POW10_EXACT_MAX) {
+        if (e < 0) {
+            return (mp_float_t)mant / dec_pow10[-e];
+        } else {
+            return (mp_float_t)mant * dec_pow10[e];
+        }
+    }
+
+    mp_int_t e_top = e;
+    for (dec_mant_t m = mant; m != 0; m /= 10) {
+        e_top += 1;
+    }
+    if (e_top > DEC_EXP10_MAX) {
+        return INFINITY;
+    } else if (e_top < DEC_EXP10_MIN) {
+        return 0;
+    }
+
+    // approximate, scaling in steps so that no power of 10 over- or underflows
+    dec_float_t z = {(mp_float_t)mant};
+    mp_int_t e_left = e;
+    for (; e_left < -DEC_POW10_MAX; e_left += DEC_POW10_MAX) {
+        z.f /= MICROPY_FLOAT_C_FUN(pow)(10, DEC_POW10_MAX);
+    }
+    if (e_left < 0) {
+        z.f /= MICROPY_FLOAT_C_FUN(pow)(10, -e_left);
+    } else {
+        z.f *= MICROPY_FLOAT_C_FUN(pow)(10, e_left);
+    }
+    if (z.u > DEC_FLOAT_MAX_BITS) {
+        z.u = DEC_FLOAT_MAX_BITS;
+    }
+
+    // then move to a neighbouring float while the number is past the point
+    // halfway to it; z is m * 2^e2 and isn't more than a few floats out
+    for (;;) {
+        if (z.u > DEC_FLOAT_MAX_BITS) {
+            // above the largest float by at least half a step, so inf
+            break;
+        }
+        mp_int_t e2 = (z.u >> DEC_FLOAT_MANT_BITS) & DEC_FLOAT_EXP_MASK;
+        uint64_t m = z.u & (((dec_float_bits_t)1 << DEC_FLOAT_MANT_BITS) - 1);
+        if (e2 == 0) {
+            e2 = 1;
+        } else {
+            m |= (uint64_t)1 << DEC_FLOAT_MANT_BITS;
+        }
+        e2 -= DEC_FLOAT_EXP_BIAS;
+        int c = dec_cmp_halfway(mant, e, 2 * m + 1, e2 - 1);
+        if (c > 0 || (c == 0 && (m & 1))) {
+            z.u += 1;
+            continue;
+        }
+        if (z.u == 0) {
+            break;
+        }
+        if (m == (uint64_t)1 << DEC_FLOAT_MANT_BITS && e2 > 1 - DEC_FLOAT_EXP_BIAS) {
+            // the step below a power of 2 is half the step above it
+            c = dec_cmp_halfway(mant, e, 4 * m - 1, e2 - 2);
+        } else {
+            c = dec_cmp_halfway(mant, e, 2 * m - 1, e2 - 1);
+        }
+        if (c < 0 || (c == 0 && (m & 1))) {
+            z.u -= 1;
+            continue;
+        }
+        break;
+    }
+    return z.f;
+}
+
+#if MICROPY_FLOAT_REPR_SHORTEST
+mp_float_t mp_parse_num_decimal_exact(uint64_t mant, mp_int_t e) {
+    return dec_to_float(mant, e);
+}
+#endif
+
+#endif
+
 typedef enum {
     PARSE_DEC_IN_INTG,
     PARSE_DEC_IN_FRAC,
@@ -213,24 +439,36 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
             dec_val = MICROPY_FLOAT_C_FUN(nan)("");
         }
     } else {
-        // string should be a decimal number
+        // string should be a decimal number; the digits are collected in an
+        // integer, as many as it can hold exactly, and the value is then
+        // that integer times 10^exp_val
         parse_dec_in_t in = PARSE_DEC_IN_INTG;
         bool exp_neg = false;
-        mp_float_t frac_mult = 0.1;
         mp_int_t exp_val = 0;
+        mp_int_t exp_extra = 0;
+        dec_mant_t dec_mant = 0;
+        int num_digits = 0;
         while (str < top) {
             mp_uint_t dig = *str++;
             if ('0' <= dig && dig <= '9') {
                 dig -= '0';
                 if (in == PARSE_DEC_IN_EXP) {
-                    exp_val = 10 * exp_val + dig;
-                } else {
+                    // enough for any float to overflow or underflow
+                    if (exp_val < 0x10000) {
+                        exp_val = 10 * exp_val + dig;
+                    }
+                } else if (num_digits < DEC_MANT_DIGITS) {
+                    dec_mant = 10 * dec_mant + dig;
+                    if (dec_mant != 0) {
+                        // leading zeros don't count
+                        num_digits += 1;
+                    }
                     if (in == PARSE_DEC_IN_FRAC) {
-                        dec_val += dig * frac_mult;
-                        frac_mult *= MICROPY_FLOAT_CONST(0.1);
-                    } else {
-                        dec_val = 10 * dec_val + dig;
+                        exp_extra -= 1;
                     }
+                } else if (in == PARSE_DEC_IN_INTG) {
+                    // digit beyond the precision of a float, dropped
+                    exp_extra += 1;
                 }
             } else if (in == PARSE_DEC_IN_INTG && dig == '.') {
                 in = PARSE_DEC_IN_FRAC;
@@ -261,9 +499,10 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
         if (exp_neg) {
             exp_val = -exp_val;
         }
+        exp_val += exp_extra;
 
         // apply the exponent
-        dec_val *= MICROPY_FLOAT_C_FUN(pow)(10, exp_val);
+        dec_val = dec_to_float(dec_mant, exp_val);
     }
 
     // negate value if needed
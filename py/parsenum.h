@@ -34,4 +34,10 @@
 mp_obj_t mp_parse_num_integer(const char *restrict str, size_t len, int base, mp_lexer_t *lex);
 mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool force_complex, mp_lexer_t *lex);
 
+#if MICROPY_PY_BUILTINS_FLOAT && MICROPY_FLOAT_REPR_SHORTEST
+// the float nearest to mant * 10^e, correctly rounded if mant has at most 19
+// digits (9 with single precision floats)
+mp_float_t mp_parse_num_decimal_exact(uint64_t mant, mp_int_t e);
+#endif
+
 #endif // __MICROPY_INCLUDED_PY_PARSENUM_H__
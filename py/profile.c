@@ -0,0 +1,248 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/bc.h"
+#include "py/mphal.h"
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+
+// The sampling profiler.  The port calls mp_profile_tick every millisecond,
+// from its tick interrupt or a timer signal, and every profile_period ticks
+// it looks up the source line of the bytecode the current thread is running
+// and counts it in a hash table.  The table is fixed so that samples can be
+// taken without allocating; lines that don't fit are only counted as
+// dropped.  Samples never wait for the table to be read, they are dropped
+// instead, so the tick can't block on code it interrupted.
+
+void mp_profile_start(mp_uint_t period) {
+    MP_STATE_VM(profile_period) = 0;
+    if (period != 0) {
+        MP_STATE_VM(profile_reading) = true;
+        memset(MP_STATE_VM(profile_table), 0, sizeof(MP_STATE_VM(profile_table)));
+        MP_STATE_VM(profile_dropped) = 0;
+        MP_STATE_VM(profile_countdown) = period;
+        MP_STATE_VM(profile_reading) = false;
+        MP_STATE_VM(profile_period) = period;
+    }
+    mp_hal_profile_timer(period != 0);
+}
+
+void mp_profile_tick(void) {
+    if (MP_STATE_VM(profile_period) == 0 || --MP_STATE_VM(profile_countdown) != 0) {
+        return;
+    }
+    MP_STATE_VM(profile_countdown) = MP_STATE_VM(profile_period);
+    if (MP_STATE_VM(profile_reading)) {
+        return;
+    }
+    #if MICROPY_PY_THREAD
+    if (mp_thread_get_state() == NULL) {
+        // the tick interrupted a thread that hasn't started running Python
+        return;
+    }
+    #endif
+
+    qstr source_file = MP_QSTR_NULL;
+    qstr block_name = MP_QSTR_NULL;
+    size_t line = 0;
+    const mp_code_state_t *code_state = MP_STATE_THREAD(cur_code_state);
+    if (code_state != NULL) {
+        line = mp_bytecode_get_source_line(code_state, &source_file, &block_name);
+    }
+
+    size_t hash = (block_name * 31 + line) % MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES;
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES; i++) {
+        mp_profile_entry_t *e = &MP_STATE_VM(profile_table)[(hash + i) % MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES];
+        if (e->count == 0) {
+            e->source_file = source_file;
+            e->block_name = block_name;
+            e->line = line;
+            e->count = 1;
+            return;
+        }
+        if (e->line == line && e->block_name == block_name && e->source_file == source_file) {
+            e->count += 1;
+            return;
+        }
+    }
+    MP_STATE_VM(profile_dropped) += 1;
+}
+
+size_t mp_profile_get(mp_profile_entry_t *dest, size_t *dropped) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    MP_STATE_VM(profile_reading) = true;
+    size_t n = 0;
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES; i++) {
+        const mp_profile_entry_t *e = &MP_STATE_VM(profile_table)[i];
+        if (e->count != 0) {
+            // insertion sort, most samples first
+            size_t j = n++;
+            for (; j > 0 && dest[j - 1].count < e->count; j--) {
+                dest[j] = dest[j - 1];
+            }
+            dest[j] = *e;
+        }
+    }
+    *dropped = MP_STATE_VM(profile_dropped);
+    MP_STATE_VM(profile_reading) = false;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+    return n;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_PROFILE
+
+#if MICROPY_PY_MICROPYTHON_TRACE
+
+// The call tracer.  Calls of bytecode functions go through mp_trace_call
+// while tracing is enabled, which times the call and records it in a ring
+// of the latest calls once it returns or raises.  When tracing is disabled
+// the only cost is the check of trace_enabled in fun_bc_call.
+
+void mp_trace_enable(bool enable) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    if (enable) {
+        MP_STATE_VM(trace_len) = 0;
+    }
+    MP_STATE_VM(trace_enabled) = enable;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+STATIC void trace_record(mp_obj_t fun, mp_uint_t start, bool raised) {
+    mp_uint_t duration = mp_hal_ticks_us() - start;
+    qstr name = mp_obj_fun_get_name(fun);
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    mp_trace_entry_t *e = &MP_STATE_VM(trace_ring)[MP_STATE_VM(trace_len)++ % MICROPY_PY_MICROPYTHON_TRACE_ENTRIES];
+    e->name = name;
+    e->raised = raised;
+    e->start = start;
+    e->duration = duration;
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+mp_obj_t mp_trace_call(mp_call_fun_t call, mp_obj_t fun, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_uint_t start = mp_hal_ticks_us();
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t ret = call(fun, n_args, n_kw, args);
+        nlr_pop();
+        if (MP_STATE_VM(trace_enabled)) {
+            trace_record(fun, start, false);
+        }
+        return ret;
+    } else {
+        if (MP_STATE_VM(trace_enabled)) {
+            trace_record(fun, start, true);
+        }
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+size_t mp_trace_get(mp_trace_entry_t *dest) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    size_t len = MP_STATE_VM(trace_len);
+    size_t n = MIN(len, MICROPY_PY_MICROPYTHON_TRACE_ENTRIES);
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = MP_STATE_VM(trace_ring)[(len - n + i) % MICROPY_PY_MICROPYTHON_TRACE_ENTRIES];
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+    return n;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_TRACE
+
+#if MICROPY_PY_MICROPYTHON_CYCLES
+
+// Cycle timing of sections of the runtime.  The port's mp_hal_ticks_cpu
+// counts CPU cycles, or the closest it has, and wraps around at the width of
+// mp_uint_t at most, so a section is timed by the difference of two reads.
+// A time that went around the counter more than once is wrong, ports with a
+// narrow counter should keep that in mind for gc collections.
+
+void mp_cycles_begin(size_t section) {
+    MP_STATE_VM(cycles_sections)[section].start = mp_hal_ticks_cpu();
+}
+
+void mp_cycles_end(size_t section) {
+    mp_cycles_section_t *s = &MP_STATE_VM(cycles_sections)[section];
+    mp_uint_t cycles = mp_hal_ticks_cpu() - s->start;
+    s->count += 1;
+    s->total += cycles;
+    if (cycles > s->max) {
+        s->max = cycles;
+    }
+}
+
+void mp_cycles_reset(void) {
+    memset(MP_STATE_VM(cycles_sections), 0, sizeof(MP_STATE_VM(cycles_sections)));
+}
+
+#endif // MICROPY_PY_MICROPYTHON_CYCLES
+
+#if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+
+// The opcode counter.  The VM calls mp_opcode_stats_count with each opcode
+// it is about to run, including the quickened forms it has written into
+// bytecode, which is counted by opcode and also as a pair with the opcode
+// dispatched before it.  The pairs are kept in a fixed hash table; pairs
+// that don't fit are only counted as dropped.  Opcodes run by different
+// threads are counted without locking, so then the counts are approximate.
+
+void mp_opcode_stats_count(byte op) {
+    MP_STATE_VM(opcode_counts)[op] += 1;
+    uint16_t pair = MP_STATE_VM(opcode_last) << 8 | op;
+    MP_STATE_VM(opcode_last) = op;
+    if (pair < 0x100) {
+        // first opcode since the counts were cleared, 0 isn't an opcode
+        return;
+    }
+    size_t hash = (pair * 31) % MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS;
+    for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS; i++) {
+        mp_opcode_pair_t *e = &MP_STATE_VM(opcode_pairs)[(hash + i) % MICROPY_PY_MICROPYTHON_OPCODE_STATS_PAIRS];
+        if (e->count == 0) {
+            e->pair = pair;
+            e->count = 1;
+            return;
+        }
+        if (e->pair == pair) {
+            e->count += 1;
+            return;
+        }
+    }
+    MP_STATE_VM(opcode_pairs_dropped) += 1;
+}
+
+void mp_opcode_stats_reset(void) {
+    MP_STATE_VM(opcode_last) = 0;
+    MP_STATE_VM(opcode_pairs_dropped) = 0;
+    memset(MP_STATE_VM(opcode_counts), 0, sizeof(MP_STATE_VM(opcode_counts)));
+    memset(MP_STATE_VM(opcode_pairs), 0, sizeof(MP_STATE_VM(opcode_pairs)));
+}
+
+#endif // MICROPY_PY_MICROPYTHON_OPCODE_STATS
@@ -136,6 +136,8 @@ PY_O_BASENAME = \
 	emitglue.o \
 	runtime.o \
 	runtime_utils.o \
+	scheduler.o \
+	profile.o \
 	nativeglue.o \
 	stackctrl.o \
 	argcheck.o \
@@ -149,6 +151,8 @@ PY_O_BASENAME = \
 	objcell.o \
 	objclosure.o \
 	objcomplex.o \
+	objdeque.o \
+	objringio.o \
 	objdict.o \
 	objenumerate.o \
 	objexcept.o \
@@ -208,6 +212,8 @@ PY_O_BASENAME = \
 	../extmod/modure.o \
 	../extmod/moduzlib.o \
 	../extmod/moduheapq.o \
+	../extmod/moduselect.o \
+	../extmod/moduasyncio.o \
 	../extmod/moduhashlib.o \
 	../extmod/modubinascii.o \
 	../extmod/virtpin.o \
@@ -229,6 +235,8 @@ PY_O_BASENAME = \
 	../extmod/vfs_fat_file.o \
 	../extmod/vfs_fat_lexer.o \
 	../extmod/vfs_fat_misc.o \
+	../extmod/vfs_logbdev.o \
+	../extmod/vfs_sdcard.o \
 	../extmod/utime_mphal.o \
 	../extmod/uos_dupterm.o \
 	../lib/embed/abort_.o \
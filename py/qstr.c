@@ -116,10 +116,88 @@ extern const qstr_pool_t MICROPY_QSTR_EXTRA_POOL;
 #define CONST_POOL mp_qstr_const_pool
 #endif
 
+#if MICROPY_QSTR_HASH_TABLE
+
+// Both tables are open-addressed with linear probing, and an empty slot holds
+// MP_QSTR_NULL.  The first slot to try only depends on the hash and length of
+// the string; this must match the equivalent code in makeqstrdata.py.
+#define QSTR_HASH_SLOT(hash, len) ((hash) ^ ((len) << 8))
+
+// the table for mp_qstr_const_pool, generated along with the pool
+STATIC const uint16_t qstr_const_hash_table[] = {
+#ifndef NO_QSTR
+#define QDEF(id, str)
+#define QHASH(q) q,
+#include "genhdr/qstrdefs.generated.h"
+#undef QHASH
+#undef QDEF
+#endif
+};
+
+// The table for all other qstrs.  It carries its own size so that a lookup
+// needs to load only one pointer while the table may be replaced.
+typedef struct _qstr_hash_table_t {
+    size_t alloc; // a power of 2
+    size_t used;
+    qstr slots[];
+} qstr_hash_table_t;
+
+STATIC void qstr_hash_insert(qstr_hash_table_t *table, qstr q, const byte *q_ptr) {
+    size_t mask = table->alloc - 1;
+    size_t slot = QSTR_HASH_SLOT(Q_GET_HASH(q_ptr), Q_GET_LENGTH(q_ptr)) & mask;
+    while (table->slots[slot] != MP_QSTR_NULL) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot] = q;
+    table->used++;
+}
+
+// qstr_mutex must be taken while in this function
+// Replace the table with one that has room for twice the number of qstrs not
+// in mp_qstr_const_pool.  If no memory is available the old table is kept.
+STATIC void qstr_hash_rebuild(void) {
+    size_t n = MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len - MP_QSTRnumber_of;
+    size_t alloc = 32;
+    while (alloc < 4 * n) {
+        alloc *= 2;
+    }
+    qstr_hash_table_t *table = m_new_obj_var_maybe_ll(qstr_hash_table_t, qstr, alloc);
+    if (table == NULL) {
+        return;
+    }
+    table->alloc = alloc;
+    table->used = 0;
+    memset(table->slots, 0, alloc * sizeof(qstr));
+    for (qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != &mp_qstr_const_pool; pool = pool->prev) {
+        for (size_t i = 0; i < pool->len; i++) {
+            qstr_hash_insert(table, pool->total_prev_len + i, pool->qstrs[i]);
+        }
+    }
+    qstr_hash_table_t *old = MP_STATE_VM(qstr_hash_table);
+    MP_STATE_VM(qstr_hash_table) = table;
+    #if !MICROPY_PY_THREAD || MICROPY_PY_THREAD_GIL
+    // without the GIL another thread may still be searching the old table,
+    // which is left for the GC to reclaim
+    if (old != NULL) {
+        m_del_var(qstr_hash_table_t, qstr, old->alloc, old);
+    }
+    #else
+    (void)old;
+    #endif
+}
+
+#endif // MICROPY_QSTR_HASH_TABLE
+
 void qstr_init(void) {
     MP_STATE_VM(last_pool) = (qstr_pool_t*)&CONST_POOL; // we won't modify the const_pool since it has no allocated room left
     MP_STATE_VM(qstr_last_chunk) = NULL;
 
+    #if MICROPY_QSTR_HASH_TABLE
+    // index the qstrs of any frozen pool
+    MP_STATE_VM(qstr_hash_table) = NULL;
+    qstr_hash_rebuild();
+    #endif
+
     #if MICROPY_PY_THREAD
     mp_thread_mutex_init(&MP_STATE_VM(qstr_mutex));
     #endif
@@ -143,7 +221,7 @@ STATIC qstr qstr_add(const byte *q_ptr) {
 
     // make sure we have room in the pool for a new qstr
     if (MP_STATE_VM(last_pool)->len >= MP_STATE_VM(last_pool)->alloc) {
-        qstr_pool_t *pool = m_new_obj_var_maybe(qstr_pool_t, const char*, MP_STATE_VM(last_pool)->alloc * 2);
+        qstr_pool_t *pool = m_new_obj_var_maybe_ll(qstr_pool_t, const char*, MP_STATE_VM(last_pool)->alloc * 2);
         if (pool == NULL) {
             QSTR_EXIT();
             m_malloc_fail(MP_STATE_VM(last_pool)->alloc * 2);
@@ -158,15 +236,67 @@ STATIC qstr qstr_add(const byte *q_ptr) {
 
     // add the new qstr
     MP_STATE_VM(last_pool)->qstrs[MP_STATE_VM(last_pool)->len++] = q_ptr;
+    qstr q = MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len - 1;
+
+    #if MICROPY_QSTR_HASH_TABLE
+    qstr_hash_table_t *table = MP_STATE_VM(qstr_hash_table);
+    if (table != NULL) {
+        if (2 * (table->used + 1) > table->alloc) {
+            // the new qstr is indexed along with all the others
+            qstr_hash_rebuild();
+            if (MP_STATE_VM(qstr_hash_table) != table) {
+                return q;
+            }
+        }
+        if (table->used + 1 < table->alloc) {
+            qstr_hash_insert(table, q, q_ptr);
+        } else {
+            // the table is full and can't grow, so search the pools instead
+            MP_STATE_VM(qstr_hash_table) = NULL;
+        }
+    }
+    #endif
 
     // return id for the newly-added qstr
-    return MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len - 1;
+    return q;
+}
+
+#if MICROPY_QSTR_HASH_TABLE
+STATIC qstr qstr_hash_find(const qstr_hash_table_t *table, const char *str, size_t str_len, mp_uint_t str_hash) {
+    size_t start = QSTR_HASH_SLOT(str_hash, str_len);
+
+    // qstrs in the const pool are by far the most common, so look there first
+    size_t mask = MP_ARRAY_SIZE(qstr_const_hash_table) - 1;
+    for (size_t slot = start & mask; qstr_const_hash_table[slot] != MP_QSTR_NULL; slot = (slot + 1) & mask) {
+        const byte *q = mp_qstr_const_pool.qstrs[qstr_const_hash_table[slot]];
+        if (Q_GET_HASH(q) == str_hash && Q_GET_LENGTH(q) == str_len && memcmp(Q_GET_DATA(q), str, str_len) == 0) {
+            return qstr_const_hash_table[slot];
+        }
+    }
+
+    mask = table->alloc - 1;
+    for (size_t slot = start & mask; table->slots[slot] != MP_QSTR_NULL; slot = (slot + 1) & mask) {
+        const byte *q = find_qstr(table->slots[slot]);
+        if (Q_GET_HASH(q) == str_hash && Q_GET_LENGTH(q) == str_len && memcmp(Q_GET_DATA(q), str, str_len) == 0) {
+            return table->slots[slot];
+        }
+    }
+
+    return 0;
 }
+#endif
 
 qstr qstr_find_strn(const char *str, size_t str_len) {
     // work out hash of str
     mp_uint_t str_hash = qstr_compute_hash((const byte*)str, str_len);
 
+    #if MICROPY_QSTR_HASH_TABLE
+    const qstr_hash_table_t *table = MP_STATE_VM(qstr_hash_table);
+    if (table != NULL) {
+        return qstr_hash_find(table, str, str_len, str_hash);
+    }
+    #endif
+
     // search pools for the data
     for (qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != NULL; pool = pool->prev) {
         for (const byte **q = pool->qstrs, **q_top = pool->qstrs + pool->len; q < q_top; q++) {
@@ -213,10 +343,10 @@ qstr qstr_from_strn(const char *str, size_t len) {
             if (al < MICROPY_ALLOC_QSTR_CHUNK_INIT) {
                 al = MICROPY_ALLOC_QSTR_CHUNK_INIT;
             }
-            MP_STATE_VM(qstr_last_chunk) = m_new_maybe(byte, al);
+            MP_STATE_VM(qstr_last_chunk) = m_new_maybe_ll(byte, al);
             if (MP_STATE_VM(qstr_last_chunk) == NULL) {
                 // failed to allocate a large chunk so try with exact size
-                MP_STATE_VM(qstr_last_chunk) = m_new_maybe(byte, n_bytes);
+                MP_STATE_VM(qstr_last_chunk) = m_new_maybe_ll(byte, n_bytes);
                 if (MP_STATE_VM(qstr_last_chunk) == NULL) {
                     QSTR_EXIT();
                     m_malloc_fail(n_bytes);
@@ -243,6 +373,41 @@ qstr qstr_from_strn(const char *str, size_t len) {
     return q;
 }
 
+#if MICROPY_MODULE_FROZEN_BUNDLE
+// Appends a pool whose strings were given ids by tools/mpy-tool.py, starting
+// at pool->total_prev_len. That's only possible while no qstr has been
+// interned at runtime, and if the qstrs before it have the checksum the tool
+// worked out for them. Returns false, leaving the pools as they were, if not.
+bool qstr_link_pool(qstr_pool_t *pool, uint32_t checksum) {
+    QSTR_ENTER();
+    qstr_pool_t *last = MP_STATE_VM(last_pool);
+    bool ok = last == (qstr_pool_t*)&CONST_POOL && pool->total_prev_len == last->total_prev_len + last->len;
+    if (ok) {
+        // must match bundle_qstr_checksum in tools/mpy-tool.py
+        uint32_t sum = 0;
+        for (qstr q = 1; q < pool->total_prev_len; q++) {
+            const byte *qd = find_qstr(q);
+            sum = sum * 33 + Q_GET_HASH(qd) + (Q_GET_LENGTH(qd) << 16);
+        }
+        ok = sum == checksum;
+    }
+    if (ok && pool->len > 0) {
+        pool->prev = last;
+        MP_STATE_VM(last_pool) = pool;
+        #if MICROPY_QSTR_HASH_TABLE
+        qstr_hash_table_t *table = MP_STATE_VM(qstr_hash_table);
+        qstr_hash_rebuild();
+        if (MP_STATE_VM(qstr_hash_table) == table) {
+            // out of memory, so search the pools instead
+            MP_STATE_VM(qstr_hash_table) = NULL;
+        }
+        #endif
+    }
+    QSTR_EXIT();
+    return ok;
+}
+#endif
+
 byte *qstr_build_start(size_t len, byte **q_ptr) {
     assert(len < (1 << (8 * MICROPY_QSTR_BYTES_IN_LEN)));
     *q_ptr = m_new(byte, MICROPY_QSTR_BYTES_IN_HASH + MICROPY_QSTR_BYTES_IN_LEN + len + 1);
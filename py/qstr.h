@@ -65,6 +65,10 @@ qstr qstr_find_strn(const char *str, size_t str_len); // returns MP_QSTR_NULL if
 qstr qstr_from_str(const char *str);
 qstr qstr_from_strn(const char *str, size_t len);
 
+#if MICROPY_MODULE_FROZEN_BUNDLE
+bool qstr_link_pool(qstr_pool_t *pool, uint32_t checksum);
+#endif
+
 byte *qstr_build_start(size_t len, byte **q_ptr);
 qstr qstr_build_end(byte *q_ptr);
 
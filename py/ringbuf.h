@@ -69,4 +69,14 @@ static inline int ringbuf_put(ringbuf_t *r, uint8_t v) {
     return 0;
 }
 
+// Number of bytes that can be got.
+static inline size_t ringbuf_avail(ringbuf_t *r) {
+    return (r->size + r->iput - r->iget) % r->size;
+}
+
+// Number of bytes that can be put.
+static inline size_t ringbuf_free(ringbuf_t *r) {
+    return r->size - ringbuf_avail(r) - 1;
+}
+
 #endif // __MICROPY_INCLUDED_PY_RINGBUF_H__
@@ -54,16 +54,45 @@
 #define DEBUG_OP_printf(...) (void)0
 #endif
 
+#if !MICROPY_MULTI_INTERP
 const mp_obj_module_t mp_module___main__ = {
     .base = { &mp_type_module },
     .globals = (mp_obj_dict_t*)&MP_STATE_VM(dict_main),
 };
+#endif
 
 void mp_init(void) {
     qstr_init();
 
+    #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+    mp_map_lock_init();
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    mp_thread_mutex_init(&MP_STATE_VM(instance_mutex));
+    #endif
+    #endif
+
+    #if MICROPY_MODULE_FROZEN_BUNDLE
+    // its qstrs went with the old pools
+    MP_STATE_VM(frozen_bundle) = NULL;
+    #endif
+
     // no pending exceptions to start with
     MP_STATE_VM(mp_pending_exception) = MP_OBJ_NULL;
+    #if MICROPY_ENABLE_SCHEDULER
+    mp_sched_init();
+    #endif
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    MP_STATE_VM(profile_period) = 0;
+    #endif
+    #if MICROPY_PY_MICROPYTHON_TRACE
+    MP_STATE_VM(trace_enabled) = false;
+    #endif
+    #if MICROPY_PY_MICROPYTHON_CYCLES
+    mp_cycles_reset();
+    #endif
+    #if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+    mp_opcode_stats_reset();
+    #endif
 
 #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF
     mp_init_emergency_exception_buf();
@@ -77,12 +106,25 @@ void mp_init(void) {
     // optimization disabled by default
     MP_STATE_VM(mp_optimise_value) = 0;
 
+    #if MICROPY_EMIT_NATIVE_TIERED
+    MP_STATE_VM(native_tier_units) = NULL;
+    MP_STATE_VM(native_tier_threshold) = 0;
+    #endif
+
     // init global module stuff
     mp_module_init();
 
     // initialise the __main__ module
     mp_obj_dict_init(&MP_STATE_VM(dict_main), 1);
     mp_obj_dict_store(MP_OBJ_FROM_PTR(&MP_STATE_VM(dict_main)), MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR___main__));
+    #if MICROPY_MULTI_INTERP
+    MP_STATE_VM(module_main).base.type = &mp_type_module;
+    MP_STATE_VM(module_main).globals = &MP_STATE_VM(dict_main);
+    mp_module_register(MP_QSTR___main__, MP_OBJ_FROM_PTR(&MP_STATE_VM(module_main)));
+    #if MICROPY_PY_SYS
+    mp_sys_init();
+    #endif
+    #endif
 
     // locals = globals for outer module (see Objects/frameobject.c/PyFrame_New())
     MP_STATE_CTX(dict_locals) = MP_STATE_CTX(dict_globals) = &MP_STATE_VM(dict_main);
@@ -92,8 +134,27 @@ void mp_init(void) {
     MP_STATE_VM(mp_module_builtins_override_dict) = NULL;
     #endif
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    MP_STATE_VM(fat_import_cache) = MP_OBJ_NULL;
+    #endif
+
+    #if MICROPY_OPT_STR_INDEX_CACHE
+    MP_STATE_VM(str_index_obj) = MP_OBJ_NULL;
+    #endif
+
+    #if MICROPY_OPT_GEN_FRAME_POOL
+    // the heap may have been reset, taking the pooled frames with it
+    memset(MP_STATE_THREAD(gen_frame_pool_nbytes), 0, sizeof(MP_STATE_THREAD(gen_frame_pool_nbytes)));
+    #endif
+
+    #if MICROPY_OPT_TUPLE_POOL
+    memset(MP_STATE_THREAD(tuple_pool), 0, sizeof(MP_STATE_THREAD(tuple_pool)));
+    #endif
+
     #if MICROPY_PY_THREAD_GIL
     mp_thread_mutex_init(&MP_STATE_VM(gil_mutex));
+    MP_STATE_VM(gil_waiting) = 0;
+    MP_STATE_VM(gil_ticks) = MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL;
     #endif
 
     MP_THREAD_GIL_ENTER();
@@ -1213,6 +1274,51 @@ mp_obj_t mp_iternext(mp_obj_t o_in) {
     }
 }
 
+#if MICROPY_OPT_SUPERINSTRUCTIONS || MICROPY_EMIT_NATIVE
+// Next value of a for-loop over range(start, stop, step), for MP_BC_FOR_RANGE
+// and native code.  slots holds the next value, stop and step, and the loop
+// counts in place, with machine arithmetic while they are all small ints and
+// with generic int arithmetic otherwise (so long-int bounds don't wrap).  The
+// usual range errors are raised for non-int values or a zero step.  Returns
+// MP_OBJ_STOP_ITERATION at the end.
+mp_obj_t mp_for_range_next(mp_obj_t *slots) {
+    if (MP_OBJ_IS_SMALL_INT(slots[0]) && MP_OBJ_IS_SMALL_INT(slots[1])
+        && MP_OBJ_IS_SMALL_INT(slots[2]) && slots[2] != MP_OBJ_NEW_SMALL_INT(0)) {
+        mp_int_t cur = MP_OBJ_SMALL_INT_VALUE(slots[0]);
+        mp_int_t stop = MP_OBJ_SMALL_INT_VALUE(slots[1]);
+        mp_int_t step = MP_OBJ_SMALL_INT_VALUE(slots[2]);
+        if (step > 0 ? cur >= stop : cur <= stop) {
+            return MP_OBJ_STOP_ITERATION;
+        }
+        mp_obj_t value = slots[0];
+        // can't overflow a machine word; if it leaves the small-int range
+        // then it is past stop, so stop itself ends the loop
+        cur += step;
+        slots[0] = MP_SMALL_INT_FITS(cur) ? MP_OBJ_NEW_SMALL_INT(cur) : slots[1];
+        return value;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (!MP_OBJ_IS_INT(slots[i])) {
+            // converts a bool, raises TypeError for anything else
+            slots[i] = MP_OBJ_NEW_SMALL_INT(mp_obj_get_int(slots[i]));
+        }
+    }
+    if (slots[2] == MP_OBJ_NEW_SMALL_INT(0)) {
+        mp_raise_ValueError("zero step");
+    }
+    mp_uint_t op = MP_BINARY_OP_MORE_EQUAL;
+    if (mp_obj_is_true(mp_binary_op(MP_BINARY_OP_LESS, slots[2], MP_OBJ_NEW_SMALL_INT(0)))) {
+        op = MP_BINARY_OP_LESS_EQUAL;
+    }
+    if (mp_obj_is_true(mp_binary_op(op, slots[0], slots[1]))) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_t value = slots[0];
+    slots[0] = mp_binary_op(MP_BINARY_OP_ADD, value, slots[2]);
+    return value;
+}
+#endif
+
 // TODO: Unclear what to do with StopIterarion exception here.
 mp_vm_return_kind_t mp_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, mp_obj_t *ret_val) {
     assert((send_value != MP_OBJ_NULL) ^ (throw_value != MP_OBJ_NULL));
@@ -1414,6 +1520,47 @@ mp_obj_t mp_parse_compile_execute(mp_lexer_t *lex, mp_parse_input_kind_t parse_i
     }
 }
 
+#if MICROPY_COMP_INCREMENTAL
+void mp_parse_compile_execute_stmts(mp_lexer_t *lex, mp_obj_dict_t *globals, mp_obj_dict_t *locals) {
+    // save context
+    mp_obj_dict_t *volatile old_globals = mp_globals_get();
+    mp_obj_dict_t *volatile old_locals = mp_locals_get();
+
+    // set new context
+    mp_globals_set(globals);
+    mp_locals_set(locals);
+
+    qstr source_name = lex->source_name;
+    mp_parse_stmts_t stmts;
+    mp_parse_stmts_init(&stmts, lex);
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        for (;;) {
+            // the parse tree of each statement is freed by the compiler
+            mp_parse_tree_t parse_tree = mp_parse_stmts_next(&stmts);
+            if (parse_tree.root == MP_PARSE_NODE_NULL) {
+                break;
+            }
+            mp_obj_t stmt_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+            mp_call_function_0(stmt_fun);
+        }
+
+        // finish nlr block, restore context
+        nlr_pop();
+        mp_parse_stmts_deinit(&stmts);
+        mp_globals_set(old_globals);
+        mp_locals_set(old_locals);
+    } else {
+        // exception; restore context and re-raise same exception
+        mp_parse_stmts_deinit(&stmts);
+        mp_globals_set(old_globals);
+        mp_locals_set(old_locals);
+        nlr_jump(nlr.ret_val);
+    }
+}
+#endif
+
 #endif // MICROPY_ENABLE_COMPILER
 
 void *m_malloc_fail(size_t num_bytes) {
@@ -78,6 +78,18 @@ static inline void mp_locals_set(mp_obj_dict_t *d) { MP_STATE_CTX(dict_locals) =
 static inline mp_obj_dict_t *mp_globals_get(void) { return MP_STATE_CTX(dict_globals); }
 static inline void mp_globals_set(mp_obj_dict_t *d) { MP_STATE_CTX(dict_globals) = d; }
 
+// Whether the code running is the top level of a module being imported, or a
+// class body in it, so that the functions, classes and namespaces it creates
+// will likely live as long as the module.  Code run from __main__ has its dict
+// as globals or, when calling into other modules, as locals.
+static inline bool mp_import_is_toplevel(void) {
+    #if MICROPY_GC_LONG_LIVED
+    return mp_globals_get() != &MP_STATE_VM(dict_main) && mp_locals_get() != &MP_STATE_VM(dict_main);
+    #else
+    return false;
+    #endif
+}
+
 mp_obj_t mp_load_name(qstr qst);
 mp_obj_t mp_load_global(qstr qst);
 mp_obj_t mp_load_build_class(void);
@@ -95,6 +107,61 @@ mp_obj_t mp_call_function_2(mp_obj_t fun, mp_obj_t arg1, mp_obj_t arg2);
 mp_obj_t mp_call_function_n_kw(mp_obj_t fun, mp_uint_t n_args, mp_uint_t n_kw, const mp_obj_t *args);
 mp_obj_t mp_call_method_n_kw(mp_uint_t n_args, mp_uint_t n_kw, const mp_obj_t *args);
 mp_obj_t mp_call_method_n_kw_var(bool have_self, mp_uint_t n_args_n_kw, const mp_obj_t *args);
+#if MICROPY_ENABLE_SCHEDULER
+#define MP_SCHED_IDLE (1)
+#define MP_SCHED_LOCKED (-1)
+#define MP_SCHED_PENDING (0) // zero so it's a quick check in the VM
+void mp_sched_init(void);
+void mp_sched_lock(void);
+void mp_sched_unlock(void);
+bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg);
+void mp_sched_run_pending(void);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+// Start sampling once every period ticks, discarding earlier samples; a
+// period of 0 stops sampling but keeps the samples.
+void mp_profile_start(mp_uint_t period);
+// Called by the port every millisecond, possibly from an interrupt.
+void mp_profile_tick(void);
+// Copy the lines sampled, most samples first, to dest which must have room
+// for MICROPY_PY_MICROPYTHON_PROFILE_ENTRIES of them.  Returns the number
+// copied, and the number of samples that didn't fit in *dropped.
+size_t mp_profile_get(mp_profile_entry_t *dest, size_t *dropped);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_TRACE
+// Start tracing calls, discarding earlier ones, or stop tracing.
+void mp_trace_enable(bool enable);
+// Make the call with the given call function, recording it in the trace.
+// Only called while tracing is enabled.
+mp_obj_t mp_trace_call(mp_call_fun_t call, mp_obj_t fun, size_t n_args, size_t n_kw, const mp_obj_t *args);
+// Copy the calls recorded, oldest first, to dest which must have room for
+// MICROPY_PY_MICROPYTHON_TRACE_ENTRIES of them.  Returns the number copied.
+size_t mp_trace_get(mp_trace_entry_t *dest);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_CYCLES
+// Time the code between them in cycles, as one of the MP_CYCLES_ sections.
+// A section can't be entered again before it ends.
+#define MP_CYCLES_BEGIN(section) mp_cycles_begin(MP_CYCLES_##section)
+#define MP_CYCLES_END(section) mp_cycles_end(MP_CYCLES_##section)
+void mp_cycles_begin(size_t section);
+void mp_cycles_end(size_t section);
+// Clear the counts of all sections.
+void mp_cycles_reset(void);
+#else
+#define MP_CYCLES_BEGIN(section)
+#define MP_CYCLES_END(section)
+#endif
+
+#if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+// Count an opcode about to be dispatched by the VM.
+void mp_opcode_stats_count(byte op);
+// Clear the counts.
+void mp_opcode_stats_reset(void);
+#endif
+
 // Call function and catch/dump exception - for Python callbacks from C code
 void mp_call_function_1_protected(mp_obj_t fun, mp_obj_t arg);
 void mp_call_function_2_protected(mp_obj_t fun, mp_obj_t arg1, mp_obj_t arg2);
@@ -125,6 +192,7 @@ void mp_store_attr(mp_obj_t base, qstr attr, mp_obj_t val);
 mp_obj_t mp_getiter(mp_obj_t o);
 mp_obj_t mp_iternext_allow_raise(mp_obj_t o); // may return MP_OBJ_STOP_ITERATION instead of raising StopIteration()
 mp_obj_t mp_iternext(mp_obj_t o); // will always return MP_OBJ_STOP_ITERATION instead of raising StopIteration(...)
+mp_obj_t mp_for_range_next(mp_obj_t *slots);
 mp_vm_return_kind_t mp_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, mp_obj_t *ret_val);
 
 mp_obj_t mp_make_raise_obj(mp_obj_t o);
@@ -156,6 +224,8 @@ mp_uint_t mp_convert_obj_to_native(mp_obj_t obj, mp_uint_t type);
 mp_obj_t mp_convert_native_to_obj(mp_uint_t val, mp_uint_t type);
 mp_obj_t mp_native_call_function_n_kw(mp_obj_t fun_in, mp_uint_t n_args_kw, const mp_obj_t *args);
 void mp_native_raise(mp_obj_t o);
+bool mp_native_yield_from(mp_obj_t gen, mp_obj_t *slots);
+mp_uint_t mp_native_float_op(mp_uint_t op, mp_uint_t lhs, mp_uint_t rhs);
 
 #define mp_sys_path (MP_OBJ_FROM_PTR(&MP_STATE_VM(mp_sys_path_obj)))
 #define mp_sys_argv (MP_OBJ_FROM_PTR(&MP_STATE_VM(mp_sys_argv_obj)))
@@ -43,6 +43,16 @@
 #define MP_NATIVE_TYPE_PTR8 (0x05)
 #define MP_NATIVE_TYPE_PTR16 (0x06)
 #define MP_NATIVE_TYPE_PTR32 (0x07)
+#define MP_NATIVE_TYPE_PTR16S (0x08)
+#define MP_NATIVE_TYPE_PTRF (0x09)
+#define MP_NATIVE_TYPE_FLOAT (0x0a)
+
+// kinds of operands passed to mp_native_float_op, packed into its op argument
+#define MP_NATIVE_FLOAT_ARG_FLOAT (0)
+#define MP_NATIVE_FLOAT_ARG_INT (1)
+#define MP_NATIVE_FLOAT_ARG_OBJ (2)
+#define MP_NATIVE_FLOAT_OP(op, lhs_kind, rhs_kind) ((op) | ((lhs_kind) << 8) | ((rhs_kind) << 10))
+#define MP_NATIVE_FLOAT_OP_TRUNC (0xff) // truncate lhs to an int
 
 typedef enum {
     MP_UNARY_OP_BOOL, // __bool__
@@ -131,6 +141,7 @@ typedef enum {
     MP_F_CALL_METHOD_N_KW_VAR,
     MP_F_GETITER,
     MP_F_ITERNEXT,
+    MP_F_FOR_RANGE_NEXT,
     MP_F_NLR_PUSH,
     MP_F_NLR_POP,
     MP_F_NATIVE_RAISE,
@@ -147,6 +158,10 @@ typedef enum {
     MP_F_NEW_CELL,
     MP_F_MAKE_CLOSURE_FROM_RAW_CODE,
     MP_F_SETUP_CODE_STATE,
+    MP_F_NATIVE_YIELD_FROM,
+#if MICROPY_PY_BUILTINS_FLOAT
+    MP_F_NATIVE_FLOAT_OP,
+#endif
     MP_F_NUMBER_OF,
 } mp_fun_kind_t;
 
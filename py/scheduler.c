@@ -0,0 +1,101 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/runtime.h"
+
+#if MICROPY_ENABLE_SCHEDULER
+
+// The scheduler lets interrupt handlers queue up a Python function to be
+// called soon after by the VM, at a point where it's safe to allocate
+// memory.  Queued functions are run one at a time, from the same check in
+// the VM loop that raises pending exceptions, so the latency is that of a
+// jump in the running code.  mp_sched_schedule may be called from an
+// interrupt; everything touching the queue is in an atomic section.
+
+void mp_sched_init(void) {
+    MP_STATE_VM(sched_state) = MP_SCHED_IDLE;
+    MP_STATE_VM(sched_idx) = 0;
+    MP_STATE_VM(sched_len) = 0;
+}
+
+void mp_sched_lock(void) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    if (MP_STATE_VM(sched_state) < 0) {
+        --MP_STATE_VM(sched_state);
+    } else {
+        MP_STATE_VM(sched_state) = MP_SCHED_LOCKED;
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+void mp_sched_unlock(void) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    if (++MP_STATE_VM(sched_state) == 0) {
+        // no longer locked
+        MP_STATE_VM(sched_state) = MP_STATE_VM(sched_len) > 0 ? MP_SCHED_PENDING : MP_SCHED_IDLE;
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+}
+
+bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    bool ret = false;
+    if (MP_STATE_VM(sched_len) < MICROPY_SCHEDULER_DEPTH) {
+        if (MP_STATE_VM(sched_state) == MP_SCHED_IDLE) {
+            MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
+        }
+        mp_sched_item_t *item = &MP_STATE_VM(sched_queue)[(MP_STATE_VM(sched_idx) + MP_STATE_VM(sched_len)) % MICROPY_SCHEDULER_DEPTH];
+        item->func = function;
+        item->arg = arg;
+        ++MP_STATE_VM(sched_len);
+        ret = true;
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+    return ret;
+}
+
+// Run the function at the head of the queue, if there is one and the
+// scheduler isn't locked.  The scheduler is locked while it runs so that
+// scheduled functions don't interrupt each other.  Ports can call this
+// while they wait, as well as it being called from the VM.
+void mp_sched_run_pending(void) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    if (MP_STATE_VM(sched_state) != MP_SCHED_PENDING || MP_STATE_VM(sched_len) == 0) {
+        MICROPY_END_ATOMIC_SECTION(atomic_state);
+        return;
+    }
+    MP_STATE_VM(sched_state) = MP_SCHED_LOCKED;
+    mp_sched_item_t item = MP_STATE_VM(sched_queue)[MP_STATE_VM(sched_idx)];
+    MP_STATE_VM(sched_queue)[MP_STATE_VM(sched_idx)].func = MP_OBJ_NULL;
+    MP_STATE_VM(sched_queue)[MP_STATE_VM(sched_idx)].arg = MP_OBJ_NULL;
+    MP_STATE_VM(sched_idx) = (MP_STATE_VM(sched_idx) + 1) % MICROPY_SCHEDULER_DEPTH;
+    --MP_STATE_VM(sched_len);
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+    mp_call_function_1_protected(item.func, item.arg);
+    mp_sched_unlock();
+}
+
+#endif // MICROPY_ENABLE_SCHEDULER
@@ -41,8 +41,15 @@ enum {
     ID_FLAG_IS_PARAM = 0x01,
     ID_FLAG_IS_STAR_PARAM = 0x02,
     ID_FLAG_IS_DBL_STAR_PARAM = 0x04,
+    ID_FLAG_IS_STR_ASSIGNED = 0x08, // assigned a str/bytes literal somewhere
+    ID_FLAG_IS_AUG_ADDED = 0x10, // target of a += somewhere
+    ID_FLAG_IS_ASSIGNED = 0x20, // bound or unbound somewhere in the scope
+    ID_FLAG_IS_REBOUND = 0x40, // may be bound after a closure over it is made
+    ID_FLAG_IS_BY_VALUE = 0x80, // a cell/free variable closed over by value
 };
 
+#define ID_FLAG_IS_STR_BUILDER (ID_FLAG_IS_STR_ASSIGNED | ID_FLAG_IS_AUG_ADDED)
+
 typedef struct _id_info_t {
     uint8_t kind;
     uint8_t flags;
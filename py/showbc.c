@@ -241,6 +241,16 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             }
             break;
 
+        #if MICROPY_OPT_QUICKENING
+        case MP_BC_LOAD_ATTR_INSTANCE:
+            DECODE_QSTR;
+            printf("LOAD_ATTR_INSTANCE %s", qstr_str(qst));
+            if (MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE) {
+                printf(" (cache=%u)", *ip++);
+            }
+            break;
+        #endif
+
         case MP_BC_LOAD_METHOD:
             DECODE_QSTR;
             printf("LOAD_METHOD %s", qstr_str(qst));
@@ -366,6 +376,40 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             ip += 1;
             break;
 
+        case MP_BC_BINARY_OP_SMALL_INT: {
+            mp_int_t num = 0;
+            if ((ip[0] & 0x40) != 0) {
+                // Number is negative
+                num--;
+            }
+            do {
+                num = (num << 7) | (*ip & 0x7f);
+            } while ((*ip++ & 0x80) != 0);
+            mp_uint_t op = *ip++;
+            printf("BINARY_OP_SMALL_INT " UINT_FMT " %s " INT_FMT, op, qstr_str(mp_binary_op_method_name[op]), num);
+            break;
+        }
+
+        case MP_BC_LOAD_FAST_2:
+            printf("LOAD_FAST_2 %u %u", *ip & 0xf, *ip >> 4);
+            ip += 1;
+            break;
+
+        case MP_BC_INPLACE_ADD_FAST:
+            DECODE_UINT;
+            printf("INPLACE_ADD_FAST " UINT_FMT, unum);
+            break;
+
+        case MP_BC_LOAD_FAST_SHARE:
+            DECODE_UINT;
+            printf("LOAD_FAST_SHARE " UINT_FMT, unum);
+            break;
+
+        case MP_BC_FOR_RANGE:
+            DECODE_ULABEL; // the jump offset if iteration finishes; for labels are always forward
+            printf("FOR_RANGE " UINT_FMT, (mp_uint_t)(ip + unum - mp_showbc_code_start));
+            break;
+
         case MP_BC_SETUP_EXCEPT:
             DECODE_ULABEL; // except labels are always forward
             printf("SETUP_EXCEPT " UINT_FMT, (mp_uint_t)(ip + unum - mp_showbc_code_start));
@@ -525,6 +569,11 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             break;
 
         default:
+            #if MICROPY_OPT_QUICKENING
+            if (ip[-1] >= MP_BC_BINARY_OP_QUICK_MULTI && ip[-1] < MP_BC_BINARY_OP_QUICK_MULTI + 10) {
+                printf("BINARY_OP_QUICK " UINT_FMT, (mp_uint_t)ip[-1] - MP_BC_BINARY_OP_QUICK_MULTI);
+            } else
+            #endif
             if (ip[-1] < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64) {
                 printf("LOAD_CONST_SMALL_INT " INT_FMT, (mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16);
             } else if (ip[-1] < MP_BC_LOAD_FAST_MULTI + 16) {
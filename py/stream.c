@@ -32,6 +32,7 @@
 #include "py/objstr.h"
 #include "py/stream.h"
 #include "py/runtime.h"
+#include "py/mperrno.h"
 
 #if MICROPY_STREAMS_NON_BLOCK
 #include <errno.h>
@@ -293,6 +294,102 @@ STATIC mp_obj_t stream_write1_method(mp_obj_t self_in, mp_obj_t arg) {
 }
 MP_DEFINE_CONST_FUN_OBJ_2(mp_stream_write1_obj, stream_write1_method);
 
+// Write all the given buffers, using the MP_STREAM_WRITEV ioctl if the
+// stream has it, else a write per buffer.  The iov array is updated as data
+// is written.  Return value and *errcode are as for mp_stream_rw().
+mp_uint_t mp_stream_writev(mp_obj_t stream, mp_stream_iovec_t *iov, size_t iovcnt, int *errcode) {
+    const mp_stream_p_t *stream_p = mp_get_stream_raise(stream, MP_STREAM_OP_WRITE);
+    bool use_ioctl = stream_p->ioctl != NULL;
+
+    *errcode = 0;
+    mp_uint_t done = 0;
+    for (;;) {
+        // skip over the buffers already written, and empty ones
+        while (iovcnt > 0 && iov->len == 0) {
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt == 0) {
+            return done;
+        }
+
+        mp_uint_t out_sz;
+        if (use_ioctl) {
+            struct mp_stream_writev_t arg = {iov, MIN(iovcnt, MP_STREAM_WRITEV_MAX)};
+            out_sz = stream_p->ioctl(stream, MP_STREAM_WRITEV, (uintptr_t)&arg, errcode);
+            if (out_sz == MP_STREAM_ERROR && *errcode == MP_EINVAL) {
+                // not supported by this stream
+                use_ioctl = false;
+                *errcode = 0;
+                continue;
+            }
+        } else {
+            out_sz = stream_p->write(stream, iov->base, iov->len, errcode);
+        }
+        if (out_sz == 0) {
+            return done;
+        }
+        if (out_sz == MP_STREAM_ERROR) {
+            if (mp_is_nonblocking_error(*errcode) && done != 0) {
+                *errcode = 0;
+            }
+            return done;
+        }
+
+        done += out_sz;
+        while (out_sz >= iov->len) {
+            out_sz -= iov->len;
+            iov->len = 0;
+            if (out_sz == 0) {
+                break;
+            }
+            iov++;
+            iovcnt--;
+        }
+        iov->base = (const byte*)iov->base + out_sz;
+        iov->len -= out_sz;
+    }
+}
+
+// Write a sequence of buffers, as if they were joined, without joining them
+STATIC mp_obj_t stream_writev(mp_obj_t self_in, mp_obj_t bufs_in) {
+    mp_uint_t nbufs;
+    mp_obj_t *bufs;
+    mp_obj_get_array(bufs_in, &nbufs, &bufs);
+
+    mp_stream_iovec_t iov[MP_STREAM_WRITEV_MAX];
+    mp_uint_t total = 0;
+    int error = 0;
+    while (nbufs > 0) {
+        size_t iovcnt = MIN(nbufs, MP_STREAM_WRITEV_MAX);
+        mp_uint_t len = 0;
+        for (size_t i = 0; i < iovcnt; i++) {
+            mp_buffer_info_t bufinfo;
+            mp_get_buffer_raise(bufs[i], &bufinfo, MP_BUFFER_READ);
+            iov[i].base = bufinfo.buf;
+            iov[i].len = bufinfo.len;
+            len += bufinfo.len;
+        }
+        bufs += iovcnt;
+        nbufs -= iovcnt;
+
+        mp_uint_t out_sz = mp_stream_writev(self_in, iov, iovcnt, &error);
+        total += out_sz;
+        if (error != 0 || out_sz != len) {
+            break;
+        }
+    }
+
+    if (error != 0) {
+        if (mp_is_nonblocking_error(error) && total == 0) {
+            return mp_const_none;
+        }
+        mp_raise_OSError(error);
+    }
+    return MP_OBJ_NEW_SMALL_INT(total);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(mp_stream_writev_obj, stream_writev);
+
 STATIC mp_obj_t stream_readinto(size_t n_args, const mp_obj_t *args) {
     mp_get_stream_raise(args[0], MP_STREAM_OP_READ);
     mp_buffer_info_t bufinfo;
@@ -322,6 +419,61 @@ STATIC mp_obj_t stream_readinto(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_readinto_obj, 2, 3, stream_readinto);
 
+// Copy src to dst until src reaches EOF, through the given buffer, without
+// creating any objects.  Returns the number of bytes copied; if an error
+// occurs it's returned in *errcode and the count is of bytes copied before.
+mp_uint_t mp_stream_copy(mp_obj_t src, mp_obj_t dst, byte *buf, mp_uint_t bufsize, int *errcode) {
+    const mp_stream_p_t *src_p = mp_get_stream_raise(src, MP_STREAM_OP_READ);
+    mp_get_stream_raise(dst, MP_STREAM_OP_WRITE);
+
+    mp_uint_t total = 0;
+    for (;;) {
+        mp_uint_t in_sz = src_p->read(src, buf, bufsize, errcode);
+        if (in_sz == MP_STREAM_ERROR) {
+            return total;
+        }
+        if (in_sz == 0) {
+            *errcode = 0;
+            return total;
+        }
+        mp_uint_t out_sz = mp_stream_write_exactly(dst, buf, in_sz, errcode);
+        total += out_sz;
+        if (*errcode != 0) {
+            return total;
+        }
+        if (out_sz != in_sz) {
+            // destination stopped taking data
+            *errcode = MP_EIO;
+            return total;
+        }
+    }
+}
+
+// CPython's shutil.copyfileobj(), length is the size of the chunks to copy
+STATIC mp_obj_t stream_copyfileobj(size_t n_args, const mp_obj_t *args) {
+    byte stack_buf[DEFAULT_BUFFER_SIZE];
+    byte *buf = stack_buf;
+    mp_uint_t bufsize = sizeof(stack_buf);
+    if (n_args > 2) {
+        mp_int_t len = mp_obj_get_int(args[2]);
+        if (len > (mp_int_t)bufsize) {
+            bufsize = len;
+            buf = m_new(byte, bufsize);
+        }
+    }
+
+    int error;
+    mp_stream_copy(args[0], args[1], buf, bufsize, &error);
+    if (buf != stack_buf) {
+        m_del(byte, buf, bufsize);
+    }
+    if (error != 0) {
+        mp_raise_OSError(error);
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_copyfileobj_obj, 2, 3, stream_copyfileobj);
+
 STATIC mp_obj_t stream_readall(mp_obj_t self_in) {
     const mp_stream_p_t *stream_p = mp_get_stream_raise(self_in, MP_STREAM_OP_READ);
 
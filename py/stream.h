@@ -41,6 +41,28 @@
 #define MP_STREAM_SET_OPTS      (7)  // Set stream options
 #define MP_STREAM_GET_DATA_OPTS (8)  // Get data/message options
 #define MP_STREAM_SET_DATA_OPTS (9)  // Set data/message options
+#define MP_STREAM_WRITEV        (10) // Write several buffers (single op)
+
+// These poll ioctl values are compatible with Linux
+#define MP_STREAM_POLL_RD  (0x0001)
+#define MP_STREAM_POLL_WR  (0x0004)
+#define MP_STREAM_POLL_ERR (0x0008)
+#define MP_STREAM_POLL_HUP (0x0010)
+
+// Argument structures for MP_STREAM_WRITEV, which returns the number of
+// bytes written like the write method does
+typedef struct _mp_stream_iovec_t {
+    const void *base;
+    size_t len;
+} mp_stream_iovec_t;
+
+struct mp_stream_writev_t {
+    const mp_stream_iovec_t *iov;
+    size_t iovcnt;
+};
+
+// Most buffers passed to MP_STREAM_WRITEV at once
+#define MP_STREAM_WRITEV_MAX (16)
 
 // Argument structure for MP_STREAM_SEEK
 struct mp_stream_seek_t {
@@ -56,10 +78,12 @@ MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_unbuffered_readline_obj);
 MP_DECLARE_CONST_FUN_OBJ_1(mp_stream_unbuffered_readlines_obj);
 MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_write_obj);
 MP_DECLARE_CONST_FUN_OBJ_2(mp_stream_write1_obj);
+MP_DECLARE_CONST_FUN_OBJ_2(mp_stream_writev_obj);
 MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_seek_obj);
 MP_DECLARE_CONST_FUN_OBJ_1(mp_stream_tell_obj);
 MP_DECLARE_CONST_FUN_OBJ_1(mp_stream_flush_obj);
 MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_ioctl_obj);
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mp_stream_copyfileobj_obj);
 
 // these are for mp_get_stream_raise and can be or'd together
 #define MP_STREAM_OP_READ (1)
@@ -81,6 +105,8 @@ mp_obj_t mp_stream_write(mp_obj_t self_in, const void *buf, size_t len, byte fla
 mp_uint_t mp_stream_rw(mp_obj_t stream, void *buf, mp_uint_t size, int *errcode, byte flags);
 #define mp_stream_write_exactly(stream, buf, size, err) mp_stream_rw(stream, (byte*)buf, size, err, MP_STREAM_RW_WRITE)
 #define mp_stream_read_exactly(stream, buf, size, err) mp_stream_rw(stream, buf, size, err, MP_STREAM_RW_READ)
+mp_uint_t mp_stream_writev(mp_obj_t stream, mp_stream_iovec_t *iov, size_t iovcnt, int *errcode);
+mp_uint_t mp_stream_copy(mp_obj_t src, mp_obj_t dst, byte *buf, mp_uint_t bufsize, int *errcode);
 
 void mp_stream_write_adaptor(void *self, const char *buf, size_t len);
 
@@ -33,9 +33,13 @@
 #include "py/nlr.h"
 #include "py/emitglue.h"
 #include "py/objtype.h"
+#include "py/objstr.h"
+#include "py/smallint.h"
+#include "py/runtime0.h"
 #include "py/runtime.h"
 #include "py/bc0.h"
 #include "py/bc.h"
+#include "py/gc.h"
 
 #if 0
 //#define TRACE(ip) printf("sp=" INT_FMT " ", sp - code_state->sp); mp_bytecode_print2(ip, 1);
@@ -44,6 +48,12 @@
 #define TRACE(ip)
 #endif
 
+#if MICROPY_PY_MICROPYTHON_OPCODE_STATS
+#define OPCODE_STATS(ip) mp_opcode_stats_count(*(ip))
+#else
+#define OPCODE_STATS(ip)
+#endif
+
 // Value stack grows up (this makes it incompatible with native C stack, but
 // makes sure that arguments to functions are in natural order arg1..argN
 // (Python semantics mandates left-to-right evaluation order, including for
@@ -51,6 +61,42 @@
 // top element.
 // Exception stack also grows up, top element is also pointed at.
 
+// Map lookups by LOAD_NAME, LOAD_GLOBAL, LOAD_ATTR and STORE_ATTR first try
+// the position at which the same opcode found its key last time.  The position
+// is kept in a byte following the opcode in the bytecode itself, or else in a
+// table in RAM indexed by the address of the opcode, which also works for
+// bytecode in ROM and is used by LOAD_METHOD as well.  Any position may be
+// stale, so it is checked before use.
+#if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+#define VM_CACHE_MAP_LOOKUP (1)
+#define MAP_CACHE_GET() (*ip)
+#define MAP_CACHE_SET(pos) (*(byte*)ip = (pos) & 0xff)
+#define MAP_CACHE_SKIP() (ip++)
+#define VM_CACHE_MAP_LOOKUP_IN_RAM (0)
+#elif MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE
+#define VM_CACHE_MAP_LOOKUP (1)
+#define VM_CACHE_MAP_LOOKUP_IN_RAM (1)
+#define MAP_CACHE_GET() (MP_STATE_VM(bc_map_lookup_cache)[(uintptr_t)ip % MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE])
+#define MAP_CACHE_SET(pos) (MAP_CACHE_GET() = (pos) & 0xff)
+#define MAP_CACHE_SKIP() (void)0
+#else
+#define VM_CACHE_MAP_LOOKUP (0)
+#define VM_CACHE_MAP_LOOKUP_IN_RAM (0)
+#endif
+
+#if MICROPY_OPT_TUPLE_POOL
+// Whether the iterator makes a new tuple for each item, that only the caller
+// then refers to
+STATIC bool iter_gives_new_tuples(mp_obj_t iter) {
+    #if MICROPY_PY_BUILTINS_ENUMERATE
+    if (MP_OBJ_IS_TYPE(iter, &mp_type_enumerate)) {
+        return true;
+    }
+    #endif
+    return MP_OBJ_IS_TYPE(iter, &mp_type_zip) || mp_obj_is_dict_items_iter(iter);
+}
+#endif
+
 // Exception stack unwind reasons (WHY_* in CPython-speak)
 // TODO perhaps compress this to RETURN=0, JUMP>0, with number of unwinds
 // left to do encoded in the JUMP number
@@ -123,11 +169,109 @@ typedef enum {
 
 // fastn has items in reverse order (fastn[0] is local[0], fastn[-1] is local[1], etc)
 // sp points to bottom of stack which grows up
+#if MICROPY_OPT_SUPERINSTRUCTIONS
+// Fast path for the binary ops that dominate loop counters and conditions,
+// when both arguments are small ints.  Anything else, including overflow,
+// goes through mp_binary_op.
+STATIC inline mp_obj_t vm_binary_op(mp_uint_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    if (!MP_OBJ_IS_SMALL_INT(lhs) || !MP_OBJ_IS_SMALL_INT(rhs)) {
+        return mp_binary_op(op, lhs, rhs);
+    }
+    mp_int_t lhs_val = MP_OBJ_SMALL_INT_VALUE(lhs);
+    mp_int_t rhs_val = MP_OBJ_SMALL_INT_VALUE(rhs);
+    switch (op) {
+        case MP_BINARY_OP_ADD:
+        case MP_BINARY_OP_INPLACE_ADD:
+            // can't overflow a machine word, small ints are at least 1 bit narrower
+            lhs_val += rhs_val;
+            break;
+        case MP_BINARY_OP_SUBTRACT:
+        case MP_BINARY_OP_INPLACE_SUBTRACT:
+            lhs_val -= rhs_val;
+            break;
+        case MP_BINARY_OP_LESS: return mp_obj_new_bool(lhs_val < rhs_val);
+        case MP_BINARY_OP_MORE: return mp_obj_new_bool(lhs_val > rhs_val);
+        case MP_BINARY_OP_EQUAL: return mp_obj_new_bool(lhs_val == rhs_val);
+        case MP_BINARY_OP_LESS_EQUAL: return mp_obj_new_bool(lhs_val <= rhs_val);
+        case MP_BINARY_OP_MORE_EQUAL: return mp_obj_new_bool(lhs_val >= rhs_val);
+        case MP_BINARY_OP_NOT_EQUAL: return mp_obj_new_bool(lhs_val != rhs_val);
+        default:
+            return mp_binary_op(op, lhs, rhs);
+    }
+    if (!MP_SMALL_INT_FITS(lhs_val)) {
+        return mp_binary_op(op, lhs, rhs);
+    }
+    return MP_OBJ_NEW_SMALL_INT(lhs_val);
+}
+#else
+#define vm_binary_op mp_binary_op
+#endif
+
+#if MICROPY_OPT_QUICKENING
+// Only bytecode compiled at runtime, which lives in the GC heap, is rewritten;
+// frozen bytecode and bytecode in ROM is run as is.
+#define VM_BYTECODE_IS_WRITABLE(ip) ((byte*)(ip) >= MP_STATE_MEM(gc_pool_start) && (byte*)(ip) < MP_STATE_MEM(gc_pool_end))
+
+// The binary ops that have a quickened small-int variant, in the order of the
+// MP_BC_BINARY_OP_QUICK_MULTI opcodes.
+STATIC const byte vm_quick_binary_op[] = {
+    MP_BINARY_OP_ADD,
+    MP_BINARY_OP_INPLACE_ADD,
+    MP_BINARY_OP_SUBTRACT,
+    MP_BINARY_OP_INPLACE_SUBTRACT,
+    MP_BINARY_OP_LESS,
+    MP_BINARY_OP_MORE,
+    MP_BINARY_OP_EQUAL,
+    MP_BINARY_OP_LESS_EQUAL,
+    MP_BINARY_OP_MORE_EQUAL,
+    MP_BINARY_OP_NOT_EQUAL,
+};
+
+// The reverse of the table above, 0 for ops that stay generic.
+STATIC const byte vm_binary_op_quickened[MP_BINARY_OP_NOT_EQUAL + 1] = {
+    [MP_BINARY_OP_ADD] = MP_BC_BINARY_OP_QUICK_MULTI + 0,
+    [MP_BINARY_OP_INPLACE_ADD] = MP_BC_BINARY_OP_QUICK_MULTI + 1,
+    [MP_BINARY_OP_SUBTRACT] = MP_BC_BINARY_OP_QUICK_MULTI + 2,
+    [MP_BINARY_OP_INPLACE_SUBTRACT] = MP_BC_BINARY_OP_QUICK_MULTI + 3,
+    [MP_BINARY_OP_LESS] = MP_BC_BINARY_OP_QUICK_MULTI + 4,
+    [MP_BINARY_OP_MORE] = MP_BC_BINARY_OP_QUICK_MULTI + 5,
+    [MP_BINARY_OP_EQUAL] = MP_BC_BINARY_OP_QUICK_MULTI + 6,
+    [MP_BINARY_OP_LESS_EQUAL] = MP_BC_BINARY_OP_QUICK_MULTI + 7,
+    [MP_BINARY_OP_MORE_EQUAL] = MP_BC_BINARY_OP_QUICK_MULTI + 8,
+    [MP_BINARY_OP_NOT_EQUAL] = MP_BC_BINARY_OP_QUICK_MULTI + 9,
+};
+
+// Called by a generic BINARY_OP that saw two small ints.
+STATIC inline void vm_quicken_binary_op(const byte *ip) {
+    mp_uint_t op = *ip - MP_BC_BINARY_OP_MULTI;
+    if (op < MP_ARRAY_SIZE(vm_binary_op_quickened) && vm_binary_op_quickened[op] != 0
+        && VM_BYTECODE_IS_WRITABLE(ip)) {
+        *(byte*)ip = vm_binary_op_quickened[op];
+    }
+}
+#endif
+
 // returns:
 //  MP_VM_RETURN_NORMAL, sp valid, return value in *sp
 //  MP_VM_RETURN_YIELD, ip, sp valid, yielded value in *sp
 //  MP_VM_RETURN_EXCEPTION, exception in fastn[0]
+#if MICROPY_TRACK_CODE_STATE
+STATIC mp_vm_return_kind_t execute_bytecode(mp_code_state_t *code_state, volatile mp_obj_t inject_exc);
+
+// Keep track of the innermost bytecode being run, for the profilers.
+// Exceptions never propagate out of execute_bytecode, so this always gets to
+// restore the outer code state.
+mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp_obj_t inject_exc) {
+    mp_code_state_t *outer_code_state = MP_STATE_THREAD(cur_code_state);
+    mp_vm_return_kind_t ret = execute_bytecode(code_state, inject_exc);
+    MP_STATE_THREAD(cur_code_state) = outer_code_state;
+    return ret;
+}
+
+STATIC mp_vm_return_kind_t execute_bytecode(mp_code_state_t *code_state, volatile mp_obj_t inject_exc) {
+#else
 mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp_obj_t inject_exc) {
+#endif
 #define SELECTIVE_EXC_IP (0)
 #if SELECTIVE_EXC_IP
 #define MARK_EXC_IP_SELECTIVE() { code_state->ip = ip; } /* stores ip 1 byte past last opcode */
@@ -140,6 +284,7 @@ mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp
     #include "py/vmentrytable.h"
     #define DISPATCH() do { \
         TRACE(ip); \
+        OPCODE_STATS(ip); \
         MARK_EXC_IP_GLOBAL(); \
         goto *entry_table[*ip++]; \
     } while (0)
@@ -162,6 +307,9 @@ mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp
 #if MICROPY_STACKLESS
 run_code_state: ;
 #endif
+    #if MICROPY_TRACK_CODE_STATE
+    MP_STATE_THREAD(cur_code_state) = code_state;
+    #endif
     // Pointers which are constant for particular invocation of mp_execute_bytecode()
     mp_obj_t * /*const*/ fastn = &code_state->state[code_state->n_state - 1];
     mp_exc_stack_t * /*const*/ exc_stack = (mp_exc_stack_t*)(code_state->state + code_state->n_state);
@@ -200,6 +348,7 @@ dispatch_loop:
                 DISPATCH();
 #else
                 TRACE(ip);
+                OPCODE_STATS(ip);
                 MARK_EXC_IP_GLOBAL();
                 switch (*ip++) {
 #endif
@@ -260,13 +409,74 @@ dispatch_loop:
                     DISPATCH();
                 }
 
+                #if MICROPY_OPT_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_LOAD_FAST_2): {
+                    mp_obj_t obj = fastn[-(mp_int_t)(*ip & 0xf)];
+                    obj_shared = fastn[-(mp_int_t)(*ip++ >> 4)];
+                    if (obj == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(obj);
+                    goto load_check;
+                }
+
+                ENTRY(MP_BC_FOR_RANGE): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_ULABEL; // the jump offset if iteration finishes; for labels are always forward
+                    // stack holds the next value, stop and step; see mp_for_range_next
+                    mp_obj_t value = sp[-2];
+                    if (MP_OBJ_IS_SMALL_INT(value) && MP_OBJ_IS_SMALL_INT(sp[-1])
+                        && MP_OBJ_IS_SMALL_INT(TOP()) && TOP() != MP_OBJ_NEW_SMALL_INT(0)) {
+                        mp_int_t cur = MP_OBJ_SMALL_INT_VALUE(value);
+                        mp_int_t step = MP_OBJ_SMALL_INT_VALUE(TOP());
+                        if (step > 0 ? cur < MP_OBJ_SMALL_INT_VALUE(sp[-1]) : cur > MP_OBJ_SMALL_INT_VALUE(sp[-1])) {
+                            cur += step;
+                            sp[-2] = MP_SMALL_INT_FITS(cur) ? MP_OBJ_NEW_SMALL_INT(cur) : sp[-1];
+                            PUSH(value);
+                        } else {
+                            ip += ulab; // jump to after for-block, leaving the 3 values
+                        }
+                        DISPATCH();
+                    }
+                    code_state->sp = sp;
+                    value = mp_for_range_next(sp - 2);
+                    if (value == MP_OBJ_STOP_ITERATION) {
+                        ip += ulab;
+                    } else {
+                        PUSH(value);
+                    }
+                    DISPATCH();
+                }
+
+                ENTRY(MP_BC_LOAD_FAST_SHARE): {
+                    DECODE_UINT;
+                    obj_shared = fastn[-unum];
+                    if (obj_shared != MP_OBJ_NULL) {
+                        obj_shared = mp_obj_str_share(obj_shared);
+                    }
+                    goto load_check;
+                }
+
+                ENTRY(MP_BC_INPLACE_ADD_FAST): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_UINT;
+                    mp_obj_t lhs = fastn[-unum];
+                    if (lhs == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    fastn[-unum] = mp_obj_str_inplace_add(lhs, TOP());
+                    sp--;
+                    DISPATCH();
+                }
+                #endif
+
                 ENTRY(MP_BC_LOAD_DEREF): {
                     DECODE_UINT;
                     obj_shared = mp_obj_cell_get(fastn[-unum]);
                     goto load_check;
                 }
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if !VM_CACHE_MAP_LOOKUP
                 ENTRY(MP_BC_LOAD_NAME): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -278,24 +488,24 @@ dispatch_loop:
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
                     mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
-                    mp_uint_t x = *ip;
+                    mp_uint_t x = MAP_CACHE_GET();
                     if (x < MP_STATE_CTX(dict_locals)->map.alloc && MP_STATE_CTX(dict_locals)->map.table[x].key == key) {
                         PUSH(MP_STATE_CTX(dict_locals)->map.table[x].value);
                     } else {
                         mp_map_elem_t *elem = mp_map_lookup(&MP_STATE_CTX(dict_locals)->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
                         if (elem != NULL) {
-                            *(byte*)ip = (elem - &MP_STATE_CTX(dict_locals)->map.table[0]) & 0xff;
+                            MAP_CACHE_SET(elem - &MP_STATE_CTX(dict_locals)->map.table[0]);
                             PUSH(elem->value);
                         } else {
                             PUSH(mp_load_name(MP_OBJ_QSTR_VALUE(key)));
                         }
                     }
-                    ip++;
+                    MAP_CACHE_SKIP();
                     DISPATCH();
                 }
                 #endif
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if !VM_CACHE_MAP_LOOKUP
                 ENTRY(MP_BC_LOAD_GLOBAL): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -307,24 +517,24 @@ dispatch_loop:
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
                     mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
-                    mp_uint_t x = *ip;
+                    mp_uint_t x = MAP_CACHE_GET();
                     if (x < MP_STATE_CTX(dict_globals)->map.alloc && MP_STATE_CTX(dict_globals)->map.table[x].key == key) {
                         PUSH(MP_STATE_CTX(dict_globals)->map.table[x].value);
                     } else {
                         mp_map_elem_t *elem = mp_map_lookup(&MP_STATE_CTX(dict_globals)->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
                         if (elem != NULL) {
-                            *(byte*)ip = (elem - &MP_STATE_CTX(dict_globals)->map.table[0]) & 0xff;
+                            MAP_CACHE_SET(elem - &MP_STATE_CTX(dict_globals)->map.table[0]);
                             PUSH(elem->value);
                         } else {
                             PUSH(mp_load_global(MP_OBJ_QSTR_VALUE(key)));
                         }
                     }
-                    ip++;
+                    MAP_CACHE_SKIP();
                     DISPATCH();
                 }
                 #endif
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if !VM_CACHE_MAP_LOOKUP
                 ENTRY(MP_BC_LOAD_ATTR): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -334,34 +544,116 @@ dispatch_loop:
                 #else
                 ENTRY(MP_BC_LOAD_ATTR): {
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_QUICKENING
+                    const byte *op_ip = ip - 1;
+                    #endif
                     DECODE_QSTR;
                     mp_obj_t top = TOP();
+                    mp_map_t *map = NULL;
                     if (mp_obj_get_type(top)->attr == mp_obj_instance_attr) {
+                        #if MICROPY_OPT_INSTANCE_SHARED_KEYS
                         mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
-                        mp_uint_t x = *ip;
+                        map = self->members;
+                        if (map == NULL) {
+                            // the cache holds the slot of the attribute in the shared keys
+                            mp_obj_t *values = mp_obj_instance_values(self);
+                            mp_uint_t x = MAP_CACHE_GET();
+                            mp_obj_t *slot;
+                            if (x < self->n_values && ((mp_obj_instance_type_t*)self->base.type)->shared_keys[x] == MP_OBJ_NEW_QSTR(qst)) {
+                                slot = &values[x];
+                            } else {
+                                slot = mp_obj_instance_lookup_slot(self, qst);
+                                if (slot == NULL) {
+                                    goto load_attr_cache_fail;
+                                }
+                                MAP_CACHE_SET(slot - values);
+                            }
+                            if (*slot == MP_OBJ_NULL) {
+                                goto load_attr_cache_fail;
+                            }
+                            #if MICROPY_OPT_QUICKENING
+                            if (VM_BYTECODE_IS_WRITABLE(op_ip)) {
+                                *(byte*)op_ip = MP_BC_LOAD_ATTR_INSTANCE;
+                            }
+                            #endif
+                            SET_TOP(*slot);
+                            MAP_CACHE_SKIP();
+                            DISPATCH();
+                        }
+                        #else
+                        map = &((mp_obj_instance_t*)MP_OBJ_TO_PTR(top))->members;
+                        #endif
+                    } else if (MP_OBJ_IS_TYPE(top, &mp_type_module) && qst != MP_QSTR___class__) {
+                        map = &((mp_obj_module_t*)MP_OBJ_TO_PTR(top))->globals->map;
+                    }
+                    if (map != NULL) {
+                        mp_uint_t x = MAP_CACHE_GET();
                         mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
                         mp_map_elem_t *elem;
-                        if (x < self->members.alloc && self->members.table[x].key == key) {
-                            elem = &self->members.table[x];
+                        if (x < map->alloc && map->table[x].key == key) {
+                            elem = &map->table[x];
                         } else {
-                            elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP);
+                            elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
                             if (elem != NULL) {
-                                *(byte*)ip = elem - &self->members.table[0];
+                                MAP_CACHE_SET(elem - &map->table[0]);
                             } else {
                                 goto load_attr_cache_fail;
                             }
                         }
+                        #if MICROPY_OPT_QUICKENING
+                        if (!MP_OBJ_IS_TYPE(top, &mp_type_module) && VM_BYTECODE_IS_WRITABLE(op_ip)) {
+                            // found in the members of an instance
+                            *(byte*)op_ip = MP_BC_LOAD_ATTR_INSTANCE;
+                        }
+                        #endif
                         SET_TOP(elem->value);
-                        ip++;
+                        MAP_CACHE_SKIP();
                         DISPATCH();
                     }
                 load_attr_cache_fail:
                     SET_TOP(mp_load_attr(top, qst));
-                    ip++;
+                    MAP_CACHE_SKIP();
+                    DISPATCH();
+                }
+
+                #if MICROPY_OPT_QUICKENING
+                ENTRY(MP_BC_LOAD_ATTR_INSTANCE): {
+                    MARK_EXC_IP_SELECTIVE();
+                    const byte *op_ip = ip - 1;
+                    DECODE_QSTR;
+                    mp_obj_t top = TOP();
+                    if (mp_obj_get_type(top)->attr == mp_obj_instance_attr) {
+                        mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
+                        mp_uint_t x = MAP_CACHE_GET();
+                        #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+                        mp_map_t *map = self->members;
+                        if (map == NULL) {
+                            mp_obj_t *values = mp_obj_instance_values(self);
+                            if (x < self->n_values && values[x] != MP_OBJ_NULL
+                                && ((mp_obj_instance_type_t*)self->base.type)->shared_keys[x] == MP_OBJ_NEW_QSTR(qst)) {
+                                SET_TOP(values[x]);
+                                MAP_CACHE_SKIP();
+                                DISPATCH();
+                            }
+                        } else
+                        #else
+                        mp_map_t *map = &self->members;
+                        #endif
+                        if (x < map->alloc && map->table[x].key == MP_OBJ_NEW_QSTR(qst)) {
+                            SET_TOP(map->table[x].value);
+                            MAP_CACHE_SKIP();
+                            DISPATCH();
+                        }
+                    }
+                    // the guess failed, so go back to LOAD_ATTR and run that
+                    ip = op_ip;
+                    *(byte*)ip = MP_BC_LOAD_ATTR;
                     DISPATCH();
                 }
                 #endif
+                #endif
 
+                #if !VM_CACHE_MAP_LOOKUP_IN_RAM
                 ENTRY(MP_BC_LOAD_METHOD): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -369,6 +661,37 @@ dispatch_loop:
                     sp += 1;
                     DISPATCH();
                 }
+                #else
+                // Methods of instances come from their class, so only calls of
+                // functions in modules, like time.sleep(), are cached.
+                ENTRY(MP_BC_LOAD_METHOD): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    if (MP_OBJ_IS_TYPE(*sp, &mp_type_module) && qst != MP_QSTR___class__) {
+                        mp_map_t *map = &((mp_obj_module_t*)MP_OBJ_TO_PTR(*sp))->globals->map;
+                        mp_uint_t x = MAP_CACHE_GET();
+                        mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
+                        mp_map_elem_t *elem;
+                        if (x < map->alloc && map->table[x].key == key) {
+                            elem = &map->table[x];
+                        } else {
+                            elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
+                            if (elem == NULL) {
+                                goto load_method_cache_fail;
+                            }
+                            MAP_CACHE_SET(elem - &map->table[0]);
+                        }
+                        sp[0] = elem->value;
+                        sp[1] = MP_OBJ_NULL;
+                        sp += 1;
+                        DISPATCH();
+                    }
+                load_method_cache_fail:
+                    mp_load_method(*sp, qst, sp);
+                    sp += 1;
+                    DISPATCH();
+                }
+                #endif
 
                 ENTRY(MP_BC_LOAD_BUILD_CLASS):
                     MARK_EXC_IP_SELECTIVE();
@@ -408,7 +731,7 @@ dispatch_loop:
                     DISPATCH();
                 }
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if !VM_CACHE_MAP_LOOKUP
                 ENTRY(MP_BC_STORE_ATTR): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -428,28 +751,54 @@ dispatch_loop:
                     mp_obj_t top = TOP();
                     if (mp_obj_get_type(top)->attr == mp_obj_instance_attr && sp[-1] != MP_OBJ_NULL) {
                         mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
-                        mp_uint_t x = *ip;
+                        mp_uint_t x = MAP_CACHE_GET();
                         mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
+                        #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+                        mp_map_t *map = self->members;
+                        if (map == NULL) {
+                            // as above, the attribute must already be set
+                            mp_obj_t *values = mp_obj_instance_values(self);
+                            mp_obj_t *slot;
+                            if (x < self->n_values && ((mp_obj_instance_type_t*)self->base.type)->shared_keys[x] == key) {
+                                slot = &values[x];
+                            } else {
+                                slot = mp_obj_instance_lookup_slot(self, qst);
+                                if (slot == NULL) {
+                                    goto store_attr_cache_fail;
+                                }
+                                MAP_CACHE_SET(slot - values);
+                            }
+                            if (*slot == MP_OBJ_NULL) {
+                                goto store_attr_cache_fail;
+                            }
+                            *slot = sp[-1];
+                            sp -= 2;
+                            MAP_CACHE_SKIP();
+                            DISPATCH();
+                        }
+                        #else
+                        mp_map_t *map = &self->members;
+                        #endif
                         mp_map_elem_t *elem;
-                        if (x < self->members.alloc && self->members.table[x].key == key) {
-                            elem = &self->members.table[x];
+                        if (x < map->alloc && map->table[x].key == key) {
+                            elem = &map->table[x];
                         } else {
-                            elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP);
+                            elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
                             if (elem != NULL) {
-                                *(byte*)ip = elem - &self->members.table[0];
+                                MAP_CACHE_SET(elem - &map->table[0]);
                             } else {
                                 goto store_attr_cache_fail;
                             }
                         }
                         elem->value = sp[-1];
                         sp -= 2;
-                        ip++;
+                        MAP_CACHE_SKIP();
                         DISPATCH();
                     }
                 store_attr_cache_fail:
                     mp_store_attr(sp[0], qst, sp[-1]);
                     sp -= 2;
-                    ip++;
+                    MAP_CACHE_SKIP();
                     DISPATCH();
                 }
                 #endif
@@ -730,6 +1079,19 @@ unwind_jump:;
                     if (value == MP_OBJ_STOP_ITERATION) {
                         --sp; // pop the exhausted iterator
                         ip += ulab; // jump to after for-block
+                    #if MICROPY_OPT_TUPLE_POOL
+                    } else if (*ip == MP_BC_UNPACK_SEQUENCE && MP_OBJ_IS_TYPE(value, &mp_type_tuple)
+                        && ip[1] < 0x80 && ((mp_obj_tuple_t*)MP_OBJ_TO_PTR(value))->len == ip[1]
+                        && iter_gives_new_tuples(TOP())) {
+                        // nothing else refers to the tuple, so unpack it here
+                        // and give it back to be reused
+                        mp_obj_tuple_t *tuple = MP_OBJ_TO_PTR(value);
+                        for (size_t i = tuple->len; i-- > 0;) {
+                            PUSH(tuple->items[i]);
+                        }
+                        mp_obj_tuple_del(value);
+                        ip += 2; // skip the UNPACK_SEQUENCE
+                    #endif
                     } else {
                         PUSH(value); // push the next iteration value
                     }
@@ -1175,6 +1537,69 @@ yield:
                     mp_import_all(POP());
                     DISPATCH();
 
+                #if MICROPY_OPT_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT): {
+                    MARK_EXC_IP_SELECTIVE();
+                    mp_int_t num = 0;
+                    if ((ip[0] & 0x40) != 0) {
+                        // Number is negative
+                        num--;
+                    }
+                    do {
+                        num = (num << 7) | (*ip & 0x7f);
+                    } while ((*ip++ & 0x80) != 0);
+                    mp_uint_t op = *ip++;
+                    SET_TOP(vm_binary_op(op, TOP(), MP_OBJ_NEW_SMALL_INT(num)));
+                    DISPATCH();
+                }
+                #endif
+
+                #if MICROPY_OPT_QUICKENING
+                #if MICROPY_OPT_COMPUTED_GOTO
+                ENTRY(MP_BC_BINARY_OP_QUICK_MULTI):
+                #else
+                binary_op_quick:
+                #endif
+                {
+                    mp_obj_t rhs = TOP();
+                    mp_obj_t lhs = sp[-1];
+                    if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+                        mp_int_t lhs_val = MP_OBJ_SMALL_INT_VALUE(lhs);
+                        mp_int_t rhs_val = MP_OBJ_SMALL_INT_VALUE(rhs);
+                        bool res;
+                        switch (vm_quick_binary_op[ip[-1] - MP_BC_BINARY_OP_QUICK_MULTI]) {
+                            case MP_BINARY_OP_ADD:
+                            case MP_BINARY_OP_INPLACE_ADD:
+                                lhs_val += rhs_val;
+                                goto binary_op_quick_int;
+                            case MP_BINARY_OP_SUBTRACT:
+                            case MP_BINARY_OP_INPLACE_SUBTRACT:
+                                lhs_val -= rhs_val;
+                                goto binary_op_quick_int;
+                            case MP_BINARY_OP_LESS: res = lhs_val < rhs_val; break;
+                            case MP_BINARY_OP_MORE: res = lhs_val > rhs_val; break;
+                            case MP_BINARY_OP_EQUAL: res = lhs_val == rhs_val; break;
+                            case MP_BINARY_OP_LESS_EQUAL: res = lhs_val <= rhs_val; break;
+                            case MP_BINARY_OP_MORE_EQUAL: res = lhs_val >= rhs_val; break;
+                            default: res = lhs_val != rhs_val; break;
+                        }
+                        sp--;
+                        SET_TOP(mp_obj_new_bool(res));
+                        DISPATCH();
+                    binary_op_quick_int:
+                        if (MP_SMALL_INT_FITS(lhs_val)) {
+                            sp--;
+                            SET_TOP(MP_OBJ_NEW_SMALL_INT(lhs_val));
+                            DISPATCH();
+                        }
+                    }
+                    // the guess failed, so go back to the generic opcode and run that
+                    ip -= 1;
+                    *(byte*)ip = MP_BC_BINARY_OP_MULTI + vm_quick_binary_op[*ip - MP_BC_BINARY_OP_QUICK_MULTI];
+                    DISPATCH();
+                }
+                #endif
+
 #if MICROPY_OPT_COMPUTED_GOTO
                 ENTRY(MP_BC_LOAD_CONST_SMALL_INT_MULTI):
                     PUSH(MP_OBJ_NEW_SMALL_INT((mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16));
@@ -1197,7 +1622,14 @@ yield:
                     MARK_EXC_IP_SELECTIVE();
                     mp_obj_t rhs = POP();
                     mp_obj_t lhs = TOP();
-                    SET_TOP(mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                    #if MICROPY_OPT_QUICKENING
+                    if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+                        SET_TOP(vm_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                        vm_quicken_binary_op(ip - 1);
+                        DISPATCH();
+                    }
+                    #endif
+                    SET_TOP(vm_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
                     DISPATCH();
                 }
 
@@ -1205,6 +1637,12 @@ yield:
                     MARK_EXC_IP_SELECTIVE();
 #else
                 ENTRY_DEFAULT:
+                    #if MICROPY_OPT_QUICKENING
+                    if (ip[-1] >= MP_BC_BINARY_OP_QUICK_MULTI
+                        && ip[-1] < MP_BC_BINARY_OP_QUICK_MULTI + MP_ARRAY_SIZE(vm_quick_binary_op)) {
+                        goto binary_op_quick;
+                    } else
+                    #endif
                     if (ip[-1] < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64) {
                         PUSH(MP_OBJ_NEW_SMALL_INT((mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16));
                         DISPATCH();
@@ -1220,7 +1658,14 @@ yield:
                     } else if (ip[-1] < MP_BC_BINARY_OP_MULTI + 36) {
                         mp_obj_t rhs = POP();
                         mp_obj_t lhs = TOP();
-                        SET_TOP(mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                        #if MICROPY_OPT_QUICKENING
+                        if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+                            SET_TOP(vm_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                            vm_quicken_binary_op(ip - 1);
+                            DISPATCH();
+                        }
+                        #endif
+                        SET_TOP(vm_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
                         DISPATCH();
                     } else
 #endif
@@ -1237,6 +1682,16 @@ yield:
 
 pending_exception_check:
                 MICROPY_VM_HOOK_LOOP
+                #if MICROPY_GC_ALLOC_THRESHOLD
+                if (MP_STATE_MEM(gc_threshold_reached)) {
+                    gc_threshold_collect();
+                }
+                #endif
+                #if MICROPY_GC_INCREMENTAL_SWEEP
+                if (MP_STATE_MEM(gc_sweep_block) != (size_t)-1) {
+                    gc_sweep_step();
+                }
+                #endif
                 if (MP_STATE_VM(mp_pending_exception) != MP_OBJ_NULL) {
                     MARK_EXC_IP_SELECTIVE();
                     mp_obj_t obj = MP_STATE_VM(mp_pending_exception);
@@ -1244,9 +1699,24 @@ pending_exception_check:
                     RAISE(obj);
                 }
 
-                // TODO make GIL release more efficient
-                MP_THREAD_GIL_EXIT();
-                MP_THREAD_GIL_ENTER();
+                #if MICROPY_ENABLE_SCHEDULER
+                if (MP_STATE_VM(sched_state) == MP_SCHED_PENDING) {
+                    MARK_EXC_IP_SELECTIVE();
+                    mp_sched_run_pending();
+                }
+                #endif
+
+                #if MICROPY_PY_THREAD_GIL
+                // hand the GIL over if another thread asked for it and
+                // this one has had it for a whole switch interval
+                if (--MP_STATE_VM(gil_ticks) == 0) {
+                    if (__atomic_load_n(&MP_STATE_VM(gil_waiting), __ATOMIC_RELAXED) != 0) {
+                        mp_thread_gil_switch();
+                    } else {
+                        MP_STATE_VM(gil_ticks) = MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL;
+                    }
+                }
+                #endif
 
             } // for loop
 
@@ -1288,42 +1758,11 @@ unwind_loop:
             // set file and line number that the exception occurred at
             // TODO: don't set traceback for exceptions re-raised by END_FINALLY.
             // But consider how to handle nested exceptions.
-            // TODO need a better way of not adding traceback to constant objects (right now, just GeneratorExit_obj and MemoryError_obj)
-            if (nlr.ret_val != &mp_const_GeneratorExit_obj && nlr.ret_val != &mp_const_MemoryError_obj) {
-                const byte *ip = code_state->code_info;
-                mp_uint_t code_info_size = mp_decode_uint(&ip);
-                #if MICROPY_PERSISTENT_CODE
-                qstr block_name = ip[0] | (ip[1] << 8);
-                qstr source_file = ip[2] | (ip[3] << 8);
-                ip += 4;
-                #else
-                qstr block_name = mp_decode_uint(&ip);
-                qstr source_file = mp_decode_uint(&ip);
-                #endif
-                size_t bc = code_state->ip - code_state->code_info - code_info_size;
-                size_t source_line = 1;
-                size_t c;
-                while ((c = *ip)) {
-                    mp_uint_t b, l;
-                    if ((c & 0x80) == 0) {
-                        // 0b0LLBBBBB encoding
-                        b = c & 0x1f;
-                        l = c >> 5;
-                        ip += 1;
-                    } else {
-                        // 0b1LLLBBBB 0bLLLLLLLL encoding (l's LSB in second byte)
-                        b = c & 0xf;
-                        l = ((c << 4) & 0x700) | ip[1];
-                        ip += 2;
-                    }
-                    if (bc >= b) {
-                        bc -= b;
-                        source_line += l;
-                    } else {
-                        // found source line corresponding to bytecode offset
-                        break;
-                    }
-                }
+            // TODO need a better way of not adding traceback to constant objects (right now, just GeneratorExit_obj, MemoryError_obj and StopIteration_obj)
+            if (nlr.ret_val != &mp_const_GeneratorExit_obj && nlr.ret_val != &mp_const_MemoryError_obj
+                && nlr.ret_val != &mp_const_StopIteration_obj) {
+                qstr source_file, block_name;
+                size_t source_line = mp_bytecode_get_source_line(code_state, &source_file, &block_name);
                 mp_obj_exception_add_traceback(MP_OBJ_FROM_PTR(nlr.ret_val), source_file, source_line, block_name);
             }
 
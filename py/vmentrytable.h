@@ -69,6 +69,13 @@ static const void *const entry_table[256] = {
     [MP_BC_SETUP_WITH] = &&entry_MP_BC_SETUP_WITH,
     [MP_BC_WITH_CLEANUP] = &&entry_MP_BC_WITH_CLEANUP,
     [MP_BC_UNWIND_JUMP] = &&entry_MP_BC_UNWIND_JUMP,
+    #if MICROPY_OPT_SUPERINSTRUCTIONS
+    [MP_BC_BINARY_OP_SMALL_INT] = &&entry_MP_BC_BINARY_OP_SMALL_INT,
+    [MP_BC_LOAD_FAST_2] = &&entry_MP_BC_LOAD_FAST_2,
+    [MP_BC_INPLACE_ADD_FAST] = &&entry_MP_BC_INPLACE_ADD_FAST,
+    [MP_BC_LOAD_FAST_SHARE] = &&entry_MP_BC_LOAD_FAST_SHARE,
+    [MP_BC_FOR_RANGE] = &&entry_MP_BC_FOR_RANGE,
+    #endif
     [MP_BC_SETUP_EXCEPT] = &&entry_MP_BC_SETUP_EXCEPT,
     [MP_BC_SETUP_FINALLY] = &&entry_MP_BC_SETUP_FINALLY,
     [MP_BC_END_FINALLY] = &&entry_MP_BC_END_FINALLY,
@@ -109,6 +116,12 @@ static const void *const entry_table[256] = {
     [MP_BC_STORE_FAST_MULTI ... MP_BC_STORE_FAST_MULTI + 15] = &&entry_MP_BC_STORE_FAST_MULTI,
     [MP_BC_UNARY_OP_MULTI ... MP_BC_UNARY_OP_MULTI + 6] = &&entry_MP_BC_UNARY_OP_MULTI,
     [MP_BC_BINARY_OP_MULTI ... MP_BC_BINARY_OP_MULTI + 35] = &&entry_MP_BC_BINARY_OP_MULTI,
+    #if MICROPY_OPT_QUICKENING
+    [MP_BC_BINARY_OP_QUICK_MULTI ... MP_BC_BINARY_OP_QUICK_MULTI + 9] = &&entry_MP_BC_BINARY_OP_QUICK_MULTI,
+    #if VM_CACHE_MAP_LOOKUP
+    [MP_BC_LOAD_ATTR_INSTANCE] = &&entry_MP_BC_LOAD_ATTR_INSTANCE,
+    #endif
+    #endif
 };
 
 #if __clang__
@@ -0,0 +1,108 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "py/nlr.h"
+#include "py/obj.h"
+#include "py/compile.h"
+#include "py/runtime0.h"
+#include "py/runtime.h"
+#include "py/stackctrl.h"
+#include "py/gc.h"
+
+// Firmware for counting retired instructions with tests/run-bench-tests.
+// It runs the script whose host path is given as the first semihosting
+// argument and exits; QEMU's instruction-count plugin does the measuring,
+// so nothing here depends on a clock and every run is reproducible.
+
+#define HEAP_SIZE (256 * 1024)
+
+STATIC char *read_script(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *src = malloc(len + 1);
+    if (src != NULL) {
+        len = fread(src, 1, len, f);
+        src[len] = '\0';
+    }
+    fclose(f);
+    return src;
+}
+
+STATIC int do_str(const char *src) {
+    mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_stdin_gt_, src, strlen(src), 0);
+    if (lex == NULL) {
+        return 1;
+    }
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        mp_obj_t module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, true);
+        mp_call_function_0(module_fun);
+        nlr_pop();
+        return 0;
+    } else {
+        // uncaught exception
+        mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
+        return 1;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s <script>\n", argc > 0 ? argv[0] : "firmware-bench.elf");
+        return 1;
+    }
+    char *src = read_script(argv[1]);
+    if (src == NULL) {
+        printf("can't read %s\n", argv[1]);
+        return 1;
+    }
+    mp_stack_ctrl_init();
+    mp_stack_set_limit(10240);
+    void *heap = malloc(HEAP_SIZE);
+    gc_init(heap, (char*)heap + HEAP_SIZE);
+    mp_init();
+    int ret = do_str(src);
+    mp_deinit();
+    return ret;
+}
+
+void gc_collect(void) {
+    gc_collect_start();
+
+    // get the registers and the sp
+    jmp_buf env;
+    setjmp(env);
+    volatile mp_uint_t dummy;
+    void *sp = (void*)&dummy;
+
+    // trace the stack, including the registers (since they live on the stack in this function)
+    gc_collect_root((void**)sp, ((uint32_t)MP_STATE_THREAD(stack_top) - (uint32_t)sp) / sizeof(uint32_t));
+
+    gc_collect_end();
+}
+
+mp_lexer_t *mp_lexer_new_from_file(const char *filename) {
+    return NULL;
+}
+
+mp_import_stat_t mp_import_stat(const char *path) {
+    return MP_IMPORT_STAT_NO_EXIST;
+}
+
+mp_obj_t mp_builtin_open(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) {
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(mp_builtin_open_obj, 1, mp_builtin_open);
+
+void nlr_jump_fail(void *val) {
+}
@@ -209,6 +209,30 @@ STATIC mp_obj_t bitbangio_spi_readinto(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(bitbangio_spi_readinto_obj, 2, 2, bitbangio_spi_readinto);
 
+//|   .. method:: SPI.write_readinto(buffer_out, buffer_in)
+//|
+//|     Write out the data in ``buffer_out`` while simultaneously reading data
+//|     into ``buffer_in``. The buffers must be the same length. Requires the
+//|     SPI being locked.
+//|
+STATIC mp_obj_t bitbangio_spi_write_readinto(mp_obj_t self_in, mp_obj_t wr_buf, mp_obj_t rd_buf) {
+    mp_buffer_info_t src;
+    mp_get_buffer_raise(wr_buf, &src, MP_BUFFER_READ);
+    mp_buffer_info_t dest;
+    mp_get_buffer_raise(rd_buf, &dest, MP_BUFFER_WRITE);
+    if (src.len != dest.len) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffers must be the same length"));
+    }
+    bitbangio_spi_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_lock(self);
+    bool ok = shared_module_bitbangio_spi_transfer(self, src.buf, dest.buf, src.len);
+    if (!ok) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "SPI bus error"));
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_3(bitbangio_spi_write_readinto_obj, bitbangio_spi_write_readinto);
+
 STATIC const mp_rom_map_elem_t bitbangio_spi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&bitbangio_spi_deinit_obj) },
     { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&bitbangio_spi___enter___obj) },
@@ -219,6 +243,7 @@ STATIC const mp_rom_map_elem_t bitbangio_spi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_unlock), MP_ROM_PTR(&bitbangio_spi_unlock_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&bitbangio_spi_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write_readinto), MP_ROM_PTR(&bitbangio_spi_write_readinto_obj) },
     { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&bitbangio_spi_write_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(bitbangio_spi_locals_dict, bitbangio_spi_locals_dict_table);
@@ -55,4 +55,7 @@ extern bool shared_module_bitbangio_spi_write(bitbangio_spi_obj_t *self, const u
 // Reads in len bytes while outputting zeroes.
 extern bool shared_module_bitbangio_spi_read(bitbangio_spi_obj_t *self, uint8_t *data, size_t len);
 
+// Writes out data_out while simultaneously reading len bytes into data_in.
+extern bool shared_module_bitbangio_spi_transfer(bitbangio_spi_obj_t *self, const uint8_t *data_out, uint8_t *data_in, size_t len);
+
 #endif // __MICROPY_INCLUDED_SHARED_BINDINGS_BITBANGIO_SPI_H__
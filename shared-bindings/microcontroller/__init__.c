@@ -90,6 +90,37 @@ STATIC mp_obj_t mcu_enable_interrupts(void) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(mcu_enable_interrupts_obj, mcu_enable_interrupts);
 
+//|   .. method:: boot_times()
+//|
+//|     Return the stages of the last start, cold or soft, as a list of
+//|     ``(name, us)`` tuples in the order they ran. ``us`` is the time the
+//|     stage ended, in microseconds from when the port started counting
+//|     time, early in the cold start. Ports which don't mark their stages
+//|     return an empty list.
+//|
+//|     On SAMD21 the stages of a cold start are ``samd21_init``, ``reset_mp``,
+//|     ``init_flash_fs``, ``usb``, ``boot_py`` and ``code_py``, the last two
+//|     ending whether or not the files were found. A soft reboot has
+//|     ``repl``, ending when the reboot was asked for, then ``reset_mp``, or
+//|     ``reload`` when the heap was kept, then the last two.
+//|     How much of running a file went into compiling it is in
+//|     `micropython.cycle_stats()`.
+//|
+STATIC mp_obj_t mcu_boot_times(void) {
+    const mcu_boot_phase_t *phases;
+    size_t n = common_hal_mcu_get_boot_phases(&phases);
+    mp_obj_t list = mp_obj_new_list(n, NULL);
+    for (size_t i = 0; i < n; i++) {
+        mp_obj_t phase[2] = {
+            MP_OBJ_NEW_QSTR(phases[i].name),
+            mp_obj_new_int_from_uint(phases[i].us),
+        };
+        mp_obj_list_store(list, MP_OBJ_NEW_SMALL_INT(i), mp_obj_new_tuple(2, phase));
+    }
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mcu_boot_times_obj, mcu_boot_times);
+
 //| :mod:`microcontroller.pin` --- Microcontroller pin names
 //| --------------------------------------------------------
 //|
@@ -106,6 +137,7 @@ const mp_obj_module_t mcu_pin_module = {
 
 STATIC const mp_rom_map_elem_t mcu_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_microcontroller) },
+    { MP_ROM_QSTR(MP_QSTR_boot_times), MP_ROM_PTR(&mcu_boot_times_obj) },
     { MP_ROM_QSTR(MP_QSTR_delay_us), MP_ROM_PTR(&mcu_delay_us_obj) },
     { MP_ROM_QSTR(MP_QSTR_disable_interrupts), MP_ROM_PTR(&mcu_disable_interrupts_obj) },
     { MP_ROM_QSTR(MP_QSTR_enable_interrupts), MP_ROM_PTR(&mcu_enable_interrupts_obj) },
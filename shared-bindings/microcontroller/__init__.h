@@ -34,6 +34,16 @@ extern void common_hal_mcu_delay_us(uint32_t);
 extern void common_hal_mcu_disable_interrupts(void);
 extern void common_hal_mcu_enable_interrupts(void);
 
+// A stage of starting up, and the time it ended in microseconds from when
+// the port started counting time.
+typedef struct {
+    qstr name;
+    uint32_t us;
+} mcu_boot_phase_t;
+
+// Returns the number of phases of the last start, and sets phases to them.
+extern size_t common_hal_mcu_get_boot_phases(const mcu_boot_phase_t **phases);
+
 extern const mp_obj_dict_t mcu_pin_globals;
 
 #endif  // __MICROPY_INCLUDED_SHARED_BINDINGS_MICROCONTROLLER___INIT___H__
@@ -94,8 +94,62 @@ mp_obj_property_t nativeio_analogin_value_obj = {
               (mp_obj_t)&mp_const_none_obj},
 };
 
+//|   .. method:: start_capture(buffer, rate)
+//|
+//|     Start sampling the pin ``rate`` times a second into ``buffer``, an
+//|     ``array('H')`` of even length. Samples are taken by hardware in the
+//|     background and are scaled to 16-bit like `value`.
+//|
+//|     The buffer is filled as two halves. When one is full sampling moves on
+//|     to the other and then wraps around, so one half can be processed while
+//|     the other fills. Use `capture_ready` to find out when a half is full.
+//|
+//|     :param array buffer: the buffer to fill
+//|     :param int rate: samples per second
+//|
+STATIC mp_obj_t nativeio_analogin_start_capture(mp_obj_t self_in, mp_obj_t buffer, mp_obj_t rate) {
+    nativeio_analogin_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_WRITE);
+    if (bufinfo.typecode != 'H') {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffer must be an array('H')"));
+    }
+    common_hal_nativeio_analogin_start_capture(self, buffer, bufinfo.buf,
+        bufinfo.len / sizeof(uint16_t), mp_obj_get_int(rate));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_3(nativeio_analogin_start_capture_obj, nativeio_analogin_start_capture);
+
+//|   .. method:: capture_ready()
+//|
+//|     Return the index, 0 or 1, of the half of the capture buffer that has
+//|     been filled since the last call, or None if neither has. Call this at
+//|     least once per half buffer of samples or a half will be missed.
+//|
+STATIC mp_obj_t nativeio_analogin_capture_ready(mp_obj_t self_in) {
+    int8_t half = common_hal_nativeio_analogin_capture_ready(MP_OBJ_TO_PTR(self_in));
+    if (half < 0) {
+        return mp_const_none;
+    }
+    return MP_OBJ_NEW_SMALL_INT(half);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analogin_capture_ready_obj, nativeio_analogin_capture_ready);
+
+//|   .. method:: stop_capture()
+//|
+//|     Stop a capture started by `start_capture`.
+//|
+STATIC mp_obj_t nativeio_analogin_stop_capture(mp_obj_t self_in) {
+    common_hal_nativeio_analogin_stop_capture(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analogin_stop_capture_obj, nativeio_analogin_stop_capture);
+
 STATIC const mp_rom_map_elem_t nativeio_analogin_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_value), MP_ROM_PTR(&nativeio_analogin_value_obj)},
+    { MP_ROM_QSTR(MP_QSTR_start_capture), MP_ROM_PTR(&nativeio_analogin_start_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_capture_ready), MP_ROM_PTR(&nativeio_analogin_capture_ready_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop_capture), MP_ROM_PTR(&nativeio_analogin_stop_capture_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(nativeio_analogin_locals_dict, nativeio_analogin_locals_dict_table);
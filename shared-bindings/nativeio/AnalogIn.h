@@ -35,4 +35,13 @@ extern const mp_obj_type_t nativeio_analogin_type;
 void common_hal_nativeio_analogin_construct(nativeio_analogin_obj_t* self, const mcu_pin_obj_t *pin);
 uint16_t common_hal_nativeio_analogin_get_value(nativeio_analogin_obj_t *self);
 
+// Starts filling data, len 16 bit values, with samples taken sample_rate times
+// a second until stopped. The buffer is used as two halves: once one is full
+// sampling moves on to the other. buffer is the object owning data and is
+// kept alive until the capture stops.
+void common_hal_nativeio_analogin_start_capture(nativeio_analogin_obj_t *self, mp_obj_t buffer, uint16_t *data, size_t len, uint32_t sample_rate);
+// Returns the index of a half filled since the last call, or -1 if none was.
+int8_t common_hal_nativeio_analogin_capture_ready(nativeio_analogin_obj_t *self);
+void common_hal_nativeio_analogin_stop_capture(nativeio_analogin_obj_t *self);
+
 #endif  // __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_ANALOGIN_H__
@@ -0,0 +1,147 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/nlr.h"
+#include "py/runtime.h"
+#include "shared-bindings/microcontroller/Pin.h"
+#include "shared-bindings/nativeio/AnalogInScan.h"
+
+//| .. currentmodule:: nativeio
+//|
+//| :class:`AnalogInScan` -- read several analog voltages at once
+//| ===============================================================
+//|
+//| Keeps the analog to digital converter (ADC) set up to sample a group of
+//| pins back to back. This is much quicker than reading an
+//| :py:class:`~nativeio.AnalogIn` for each pin because the ADC isn't set up
+//| and torn down for every sample.
+//|
+//| Usage::
+//|
+//|    import array
+//|    import nativeio
+//|    from board import *
+//|
+//|    values = array.array('H', [0, 0, 0])
+//|    with nativeio.AnalogInScan((A1, A2, A3)) as scan:
+//|      scan.readinto(values)
+//|
+
+//| .. class:: AnalogInScan(pins)
+//|
+//|   Set up the ADC to sample each of the given pins.
+//|
+//|   :param sequence pins: the `~microcontroller.Pin` objects to sample
+//|
+STATIC mp_obj_t nativeio_analoginscan_make_new(const mp_obj_type_t *type,
+        mp_uint_t n_args, mp_uint_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+    mp_uint_t num_pins;
+    mp_obj_t *pin_objs;
+    mp_obj_get_array(args[0], &num_pins, &pin_objs);
+    if (num_pins == 0 || num_pins > NATIVEIO_ANALOGINSCAN_MAX_PINS) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid number of pins."));
+    }
+    const mcu_pin_obj_t *pins[NATIVEIO_ANALOGINSCAN_MAX_PINS];
+    for (size_t i = 0; i < num_pins; i++) {
+        assert_pin(pin_objs[i], false);
+        pins[i] = MP_OBJ_TO_PTR(pin_objs[i]);
+    }
+
+    nativeio_analoginscan_obj_t *self = m_new_obj(nativeio_analoginscan_obj_t);
+    self->base.type = &nativeio_analoginscan_type;
+    common_hal_nativeio_analoginscan_construct(self, pins, num_pins);
+
+    return (mp_obj_t) self;
+}
+
+//|   .. method:: deinit()
+//|
+//|      Turn off the ADC.
+//|
+STATIC mp_obj_t nativeio_analoginscan_deinit(mp_obj_t self_in) {
+    common_hal_nativeio_analoginscan_deinit(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analoginscan_deinit_obj, nativeio_analoginscan_deinit);
+
+//|   .. method:: __enter__()
+//|
+//|      No-op used by Context Managers.
+//|
+STATIC mp_obj_t nativeio_analoginscan___enter__(mp_obj_t self_in) {
+    return self_in;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analoginscan___enter___obj, nativeio_analoginscan___enter__);
+
+//|   .. method:: __exit__()
+//|
+//|      Automatically deinitializes the hardware when exiting a context.
+//|
+STATIC mp_obj_t nativeio_analoginscan___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    common_hal_nativeio_analoginscan_deinit(MP_OBJ_TO_PTR(args[0]));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(nativeio_analoginscan___exit___obj, 4, 4, nativeio_analoginscan___exit__);
+
+//|   .. method:: readinto(buffer)
+//|
+//|     Sample every pin once and store the results, in the order the pins were
+//|     given, into ``buffer``, an ``array('H')`` with room for one value per
+//|     pin. Values are between 0 and 65535 inclusive (16-bit) like
+//|     `AnalogIn.value` but are single samples rather than averages.
+//|
+STATIC mp_obj_t nativeio_analoginscan_readinto(mp_obj_t self_in, mp_obj_t buffer) {
+    nativeio_analoginscan_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_WRITE);
+    if (bufinfo.typecode != 'H' || bufinfo.len / sizeof(uint16_t) < self->num_pins) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffer must be an array('H') with a value per pin"));
+    }
+    common_hal_nativeio_analoginscan_read(self, bufinfo.buf);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_2(nativeio_analoginscan_readinto_obj, nativeio_analoginscan_readinto);
+
+STATIC const mp_rom_map_elem_t nativeio_analoginscan_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&nativeio_analoginscan_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&nativeio_analoginscan___enter___obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&nativeio_analoginscan___exit___obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&nativeio_analoginscan_readinto_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(nativeio_analoginscan_locals_dict, nativeio_analoginscan_locals_dict_table);
+
+const mp_obj_type_t nativeio_analoginscan_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_AnalogInScan,
+    .make_new = nativeio_analoginscan_make_new,
+    .locals_dict = (mp_obj_t)&nativeio_analoginscan_locals_dict,
+};
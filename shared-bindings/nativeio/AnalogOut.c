@@ -105,12 +105,95 @@ mp_obj_property_t nativeio_analogout_value_obj = {
               (mp_obj_t)&mp_const_none_obj},
 };
 
+//|   .. method:: start_playback(buffer, rate, \*, loop=False)
+//|
+//|     Start playing the samples in ``buffer``, an ``array('H')`` of even
+//|     length, ``rate`` times a second. Samples are 16-bit like `value` and
+//|     are moved to the DAC by hardware in the background.
+//|
+//|     The buffer is played as two halves. With ``loop`` playback wraps around
+//|     after the second half so one half can be refilled while the other
+//|     plays. Use `playback_ready` to find out when a half has been played.
+//|
+//|     :param array buffer: the samples to play
+//|     :param int rate: samples per second
+//|     :param bool loop: keep playing the buffer until `stop_playback`
+//|
+STATIC mp_obj_t nativeio_analogout_start_playback(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_buffer, ARG_rate, ARG_loop };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_rate, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_loop, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    nativeio_analogout_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[ARG_buffer].u_obj, &bufinfo, MP_BUFFER_READ);
+    if (bufinfo.typecode != 'H') {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffer must be an array('H')"));
+    }
+    common_hal_nativeio_analogout_start_playback(self, args[ARG_buffer].u_obj, bufinfo.buf,
+        bufinfo.len / sizeof(uint16_t), args[ARG_rate].u_int, args[ARG_loop].u_bool);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_analogout_start_playback_obj, 3, nativeio_analogout_start_playback);
+
+//|   .. method:: playback_ready()
+//|
+//|     Return the index, 0 or 1, of the half of the playback buffer that has
+//|     been played since the last call, or None if neither has. Refill that
+//|     half before playback comes back around to it.
+//|
+STATIC mp_obj_t nativeio_analogout_playback_ready(mp_obj_t self_in) {
+    int8_t half = common_hal_nativeio_analogout_playback_ready(MP_OBJ_TO_PTR(self_in));
+    if (half < 0) {
+        return mp_const_none;
+    }
+    return MP_OBJ_NEW_SMALL_INT(half);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analogout_playback_ready_obj, nativeio_analogout_playback_ready);
+
+//|   .. method:: stop_playback()
+//|
+//|     Stop playback started by `start_playback`. The DAC holds the last
+//|     sample played.
+//|
+STATIC mp_obj_t nativeio_analogout_stop_playback(mp_obj_t self_in) {
+    common_hal_nativeio_analogout_stop_playback(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analogout_stop_playback_obj, nativeio_analogout_stop_playback);
+
+//|   .. attribute:: playing
+//|
+//|     True while samples are being played. Stays False once a playback
+//|     without ``loop`` has finished.
+//|
+STATIC mp_obj_t nativeio_analogout_obj_get_playing(mp_obj_t self_in) {
+    return mp_obj_new_bool(common_hal_nativeio_analogout_get_playing(MP_OBJ_TO_PTR(self_in)));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_analogout_get_playing_obj, nativeio_analogout_obj_get_playing);
+
+mp_obj_property_t nativeio_analogout_playing_obj = {
+    .base.type = &mp_type_property,
+    .proxy = {(mp_obj_t)&nativeio_analogout_get_playing_obj,
+              (mp_obj_t)&mp_const_none_obj,
+              (mp_obj_t)&mp_const_none_obj},
+};
+
 STATIC const mp_rom_map_elem_t nativeio_analogout_locals_dict_table[] = {
     // instance methods
     { MP_OBJ_NEW_QSTR(MP_QSTR_deinit), (mp_obj_t)&nativeio_analogout_deinit_obj },
+    { MP_ROM_QSTR(MP_QSTR_start_playback), MP_ROM_PTR(&nativeio_analogout_start_playback_obj) },
+    { MP_ROM_QSTR(MP_QSTR_playback_ready), MP_ROM_PTR(&nativeio_analogout_playback_ready_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop_playback), MP_ROM_PTR(&nativeio_analogout_stop_playback_obj) },
 
     // Properties
     { MP_OBJ_NEW_QSTR(MP_QSTR_value), (mp_obj_t)&nativeio_analogout_value_obj },
+    { MP_ROM_QSTR(MP_QSTR_playing), MP_ROM_PTR(&nativeio_analogout_playing_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(nativeio_analogout_locals_dict, nativeio_analogout_locals_dict_table);
@@ -36,4 +36,13 @@ void common_hal_nativeio_analogout_construct(nativeio_analogout_obj_t* self, con
 void common_hal_nativeio_analogout_deinit(nativeio_analogout_obj_t *self);
 void common_hal_nativeio_analogout_set_value(nativeio_analogout_obj_t *self, uint16_t value);
 
+// Plays data, len 16 bit samples, out at sample_rate using the buffer in two
+// halves. buffer is kept alive until playback stops. Without loop playback
+// stops after the second half.
+void common_hal_nativeio_analogout_start_playback(nativeio_analogout_obj_t *self, mp_obj_t buffer, const uint16_t *data, size_t len, uint32_t sample_rate, bool loop);
+// Returns the index of a half that finished playing, or -1 if neither has.
+int8_t common_hal_nativeio_analogout_playback_ready(nativeio_analogout_obj_t *self);
+bool common_hal_nativeio_analogout_get_playing(nativeio_analogout_obj_t *self);
+void common_hal_nativeio_analogout_stop_playback(nativeio_analogout_obj_t *self);
+
 #endif  // __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_ANALOGOUT_H__
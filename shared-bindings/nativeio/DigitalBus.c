@@ -0,0 +1,229 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/binary.h"
+#include "py/nlr.h"
+#include "py/objproperty.h"
+#include "py/runtime.h"
+#include "shared-bindings/microcontroller/Pin.h"
+#include "shared-bindings/nativeio/DigitalBus.h"
+
+//| .. currentmodule:: nativeio
+//|
+//| :class:`DigitalBus` -- drive or read several digital pins at once
+//| ==================================================================
+//|
+//| Groups digital pins into a bus whose value is read or written as one
+//| integer, bit 0 being the first pin. All of the pins are changed or sampled
+//| together so this is much quicker than a `DigitalInOut` per pin, for
+//| example to feed a parallel display.
+//|
+//| Usage::
+//|
+//|    import nativeio
+//|    from board import *
+//|
+//|    with nativeio.DigitalBus((D0, D1, D2, D3, D4, D5, D6, D7), strobe=D8) as bus:
+//|      bus.switch_to_output()
+//|      bus.write(b"\x01\x02\x03")
+//|
+
+//| .. class:: DigitalBus(pins, \*, strobe=None)
+//|
+//|   Set up the given pins as a bus. They start out as inputs.
+//|
+//|   :param sequence pins: the `~microcontroller.Pin` objects of the bus,
+//|     least significant bit first. Ports may require them to share a
+//|     hardware port.
+//|   :param ~microcontroller.Pin strobe: optional pin pulsed low after each
+//|     value put out by `write`, such as a display's write strobe
+//|
+STATIC mp_obj_t nativeio_digitalbus_make_new(const mp_obj_type_t *type,
+        mp_uint_t n_args, mp_uint_t n_kw, const mp_obj_t *pos_args) {
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, pos_args + n_args);
+    enum { ARG_pins, ARG_strobe };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_pins, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_strobe, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_uint_t num_pins;
+    mp_obj_t *pin_objs;
+    mp_obj_get_array(args[ARG_pins].u_obj, &num_pins, &pin_objs);
+    if (num_pins == 0 || num_pins > NATIVEIO_DIGITALBUS_MAX_PINS) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid number of pins."));
+    }
+    const mcu_pin_obj_t *pins[NATIVEIO_DIGITALBUS_MAX_PINS];
+    for (size_t i = 0; i < num_pins; i++) {
+        assert_pin(pin_objs[i], false);
+        pins[i] = MP_OBJ_TO_PTR(pin_objs[i]);
+    }
+    const mcu_pin_obj_t *strobe = NULL;
+    if (args[ARG_strobe].u_obj != mp_const_none) {
+        assert_pin(args[ARG_strobe].u_obj, false);
+        strobe = MP_OBJ_TO_PTR(args[ARG_strobe].u_obj);
+    }
+
+    nativeio_digitalbus_obj_t *self = m_new_obj(nativeio_digitalbus_obj_t);
+    self->base.type = &nativeio_digitalbus_type;
+    common_hal_nativeio_digitalbus_construct(self, pins, num_pins, strobe);
+
+    return (mp_obj_t) self;
+}
+
+//|   .. method:: deinit()
+//|
+//|      Turn off the bus pins and release them for other use.
+//|
+STATIC mp_obj_t nativeio_digitalbus_deinit(mp_obj_t self_in) {
+    common_hal_nativeio_digitalbus_deinit(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_digitalbus_deinit_obj, nativeio_digitalbus_deinit);
+
+//|   .. method:: __enter__()
+//|
+//|      No-op used by Context Managers.
+//|
+STATIC mp_obj_t nativeio_digitalbus___enter__(mp_obj_t self_in) {
+    return self_in;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_digitalbus___enter___obj, nativeio_digitalbus___enter__);
+
+//|   .. method:: __exit__()
+//|
+//|      Automatically deinitializes the hardware when exiting a context.
+//|
+STATIC mp_obj_t nativeio_digitalbus___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    common_hal_nativeio_digitalbus_deinit(MP_OBJ_TO_PTR(args[0]));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(nativeio_digitalbus___exit___obj, 4, 4, nativeio_digitalbus___exit__);
+
+//|   .. method:: switch_to_output(value=0)
+//|
+//|     Switch every bus pin to an output and put ``value`` on the bus.
+//|
+STATIC mp_obj_t nativeio_digitalbus_switch_to_output(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_value };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_value, MP_ARG_INT, {.u_int = 0} },
+    };
+    nativeio_digitalbus_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    common_hal_nativeio_digitalbus_switch_to_output(self, args[ARG_value].u_int);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_digitalbus_switch_to_output_obj, 1, nativeio_digitalbus_switch_to_output);
+
+//|   .. method:: switch_to_input()
+//|
+//|     Switch every bus pin to an input.
+//|
+STATIC mp_obj_t nativeio_digitalbus_switch_to_input(mp_obj_t self_in) {
+    common_hal_nativeio_digitalbus_switch_to_input(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_digitalbus_switch_to_input_obj, nativeio_digitalbus_switch_to_input);
+
+//|   .. method:: write(buffer)
+//|
+//|     Put each value in ``buffer`` onto the bus in turn, pulsing the strobe
+//|     low after each one. Use bytes for buses of up to 8 pins and an
+//|     ``array('H')`` for wider ones. The bus must be an output.
+//|
+STATIC mp_obj_t nativeio_digitalbus_write(mp_obj_t self_in, mp_obj_t buffer) {
+    nativeio_digitalbus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!common_hal_nativeio_digitalbus_is_output(self)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_AttributeError,
+            "Cannot write when direction is input."));
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_READ);
+    size_t item_size = 1;
+    if (bufinfo.typecode == 'H' || bufinfo.typecode == 'h') {
+        item_size = 2;
+    } else if (bufinfo.typecode != 'B' && bufinfo.typecode != 'b' &&
+               bufinfo.typecode != BYTEARRAY_TYPECODE) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffer must hold bytes or an array('H')"));
+    }
+    common_hal_nativeio_digitalbus_write(self, bufinfo.buf, bufinfo.len / item_size, item_size);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_2(nativeio_digitalbus_write_obj, nativeio_digitalbus_write);
+
+//|   .. attribute:: value
+//|
+//|     The bus value as an integer, bit 0 being the first pin. Reading samples
+//|     the pins. Setting it is only allowed when the bus is an output.
+//|
+STATIC mp_obj_t nativeio_digitalbus_obj_get_value(mp_obj_t self_in) {
+    nativeio_digitalbus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int_from_uint(common_hal_nativeio_digitalbus_get_value(self));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_digitalbus_get_value_obj, nativeio_digitalbus_obj_get_value);
+
+STATIC mp_obj_t nativeio_digitalbus_obj_set_value(mp_obj_t self_in, mp_obj_t value) {
+    nativeio_digitalbus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!common_hal_nativeio_digitalbus_is_output(self)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_AttributeError,
+            "Cannot set value when direction is input."));
+    }
+    common_hal_nativeio_digitalbus_set_value(self, mp_obj_get_int(value));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_2(nativeio_digitalbus_set_value_obj, nativeio_digitalbus_obj_set_value);
+
+mp_obj_property_t nativeio_digitalbus_value_obj = {
+    .base.type = &mp_type_property,
+    .proxy = {(mp_obj_t)&nativeio_digitalbus_get_value_obj,
+              (mp_obj_t)&nativeio_digitalbus_set_value_obj,
+              (mp_obj_t)&mp_const_none_obj},
+};
+
+STATIC const mp_rom_map_elem_t nativeio_digitalbus_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&nativeio_digitalbus_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&nativeio_digitalbus___enter___obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&nativeio_digitalbus___exit___obj) },
+    { MP_ROM_QSTR(MP_QSTR_switch_to_output), MP_ROM_PTR(&nativeio_digitalbus_switch_to_output_obj) },
+    { MP_ROM_QSTR(MP_QSTR_switch_to_input), MP_ROM_PTR(&nativeio_digitalbus_switch_to_input_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&nativeio_digitalbus_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_value), MP_ROM_PTR(&nativeio_digitalbus_value_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(nativeio_digitalbus_locals_dict, nativeio_digitalbus_locals_dict_table);
+
+const mp_obj_type_t nativeio_digitalbus_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_DigitalBus,
+    .make_new = nativeio_digitalbus_make_new,
+    .locals_dict = (mp_obj_t)&nativeio_digitalbus_locals_dict,
+};
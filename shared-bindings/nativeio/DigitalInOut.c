@@ -166,6 +166,49 @@ STATIC mp_obj_t nativeio_digitalinout_switch_to_input(size_t n_args, const mp_ob
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_digitalinout_switch_to_input_obj, 1, nativeio_digitalinout_switch_to_input);
 
+//|   .. method:: irq(handler, edge=Edge.both)
+//|
+//|       Call ``handler`` with this DigitalInOut whenever the input changes.
+//|       The handler isn't run in the interrupt itself but is queued up with
+//|       :py:func:`micropython.schedule`, so it may allocate memory. Waiting
+//|       for the handler rather than reading :py:attr:`value` in a loop saves
+//|       power and doesn't miss short pulses.
+//|
+//|       :param handler: function to call, or None to stop calling it
+//|       :param Edge edge: the changes to call it on
+//|
+typedef struct {
+    mp_obj_base_t base;
+} nativeio_digitalinout_edge_obj_t;
+extern const nativeio_digitalinout_edge_obj_t nativeio_digitalinout_edge_rise_obj;
+extern const nativeio_digitalinout_edge_obj_t nativeio_digitalinout_edge_fall_obj;
+extern const nativeio_digitalinout_edge_obj_t nativeio_digitalinout_edge_both_obj;
+
+STATIC mp_obj_t nativeio_digitalinout_irq(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+   enum { ARG_handler, ARG_edge };
+   static const mp_arg_t allowed_args[] = {
+       { MP_QSTR_handler,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+       { MP_QSTR_edge,       MP_ARG_OBJ, {.u_rom_obj = &nativeio_digitalinout_edge_both_obj} },
+   };
+   nativeio_digitalinout_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+   mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+   mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+   if (common_hal_nativeio_digitalinout_get_direction(self) == DIRECTION_OUT) {
+       nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+           "Interrupts not used when direction is output."));
+   }
+   enum digitalinout_edge_t edge = EDGE_BOTH;
+   if (args[ARG_edge].u_rom_obj == &nativeio_digitalinout_edge_rise_obj) {
+       edge = EDGE_RISE;
+   } else if (args[ARG_edge].u_rom_obj == &nativeio_digitalinout_edge_fall_obj) {
+       edge = EDGE_FALL;
+   }
+   common_hal_nativeio_digitalinout_set_irq(self, args[ARG_handler].u_obj, edge);
+   return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_digitalinout_irq_obj, 1, nativeio_digitalinout_irq);
+
 //|   .. attribute:: direction
 //|
 //|       Get the direction of the pin.
@@ -417,6 +460,50 @@ const mp_obj_type_t nativeio_digitalinout_pull_type = {
     .locals_dict = (mp_obj_t)&nativeio_digitalinout_pull_locals_dict,
 };
 
+//| .. class:: nativeio.DigitalInOut.Edge
+//|
+//|     Enum-like class to define which changes of an input call the
+//|     :py:meth:`irq` handler.
+//|
+//|     .. data:: rise
+//|
+//|       When the input goes from low to high
+//|
+//|     .. data:: fall
+//|
+//|       When the input goes from high to low
+//|
+//|     .. data:: both
+//|
+//|       On every change of the input
+//|
+const mp_obj_type_t nativeio_digitalinout_edge_type;
+
+const nativeio_digitalinout_edge_obj_t nativeio_digitalinout_edge_rise_obj = {
+    { &nativeio_digitalinout_edge_type },
+};
+
+const nativeio_digitalinout_edge_obj_t nativeio_digitalinout_edge_fall_obj = {
+    { &nativeio_digitalinout_edge_type },
+};
+
+const nativeio_digitalinout_edge_obj_t nativeio_digitalinout_edge_both_obj = {
+    { &nativeio_digitalinout_edge_type },
+};
+
+STATIC const mp_rom_map_elem_t nativeio_digitalinout_edge_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_rise),  MP_ROM_PTR(&nativeio_digitalinout_edge_rise_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fall),  MP_ROM_PTR(&nativeio_digitalinout_edge_fall_obj) },
+    { MP_ROM_QSTR(MP_QSTR_both),  MP_ROM_PTR(&nativeio_digitalinout_edge_both_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(nativeio_digitalinout_edge_locals_dict, nativeio_digitalinout_edge_locals_dict_table);
+
+const mp_obj_type_t nativeio_digitalinout_edge_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Edge,
+    .locals_dict = (mp_obj_t)&nativeio_digitalinout_edge_locals_dict,
+};
+
 STATIC const mp_rom_map_elem_t nativeio_digitalinout_locals_dict_table[] = {
     // instance methods
     { MP_ROM_QSTR(MP_QSTR_deinit),                 MP_ROM_PTR(&nativeio_digitalinout_deinit_obj) },
@@ -424,6 +511,7 @@ STATIC const mp_rom_map_elem_t nativeio_digitalinout_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR___exit__),               MP_ROM_PTR(&nativeio_digitalinout_obj___exit___obj) },
     { MP_ROM_QSTR(MP_QSTR_switch_to_output),   MP_ROM_PTR(&nativeio_digitalinout_switch_to_output_obj) },
     { MP_ROM_QSTR(MP_QSTR_switch_to_input),    MP_ROM_PTR(&nativeio_digitalinout_switch_to_input_obj) },
+    { MP_ROM_QSTR(MP_QSTR_irq),                MP_ROM_PTR(&nativeio_digitalinout_irq_obj) },
 
     // Properties
     { MP_ROM_QSTR(MP_QSTR_direction),          MP_ROM_PTR(&nativeio_digitalinout_direction_obj) },
@@ -435,6 +523,7 @@ STATIC const mp_rom_map_elem_t nativeio_digitalinout_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_Direction),          MP_ROM_PTR(&nativeio_digitalinout_direction_type) },
     { MP_ROM_QSTR(MP_QSTR_DriveMode),          MP_ROM_PTR(&nativeio_digitalinout_drive_mode_type) },
     { MP_ROM_QSTR(MP_QSTR_Pull),               MP_ROM_PTR(&nativeio_digitalinout_pull_type) },
+    { MP_ROM_QSTR(MP_QSTR_Edge),               MP_ROM_PTR(&nativeio_digitalinout_edge_type) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(nativeio_digitalinout_locals_dict, nativeio_digitalinout_locals_dict_table);
@@ -48,6 +48,12 @@ enum digitalinout_drive_mode_t {
     DRIVE_MODE_OPEN_DRAIN
 };
 
+enum digitalinout_edge_t {
+    EDGE_RISE,
+    EDGE_FALL,
+    EDGE_BOTH
+};
+
 typedef enum {
     DIGITALINOUT_OK,
     DIGITALINOUT_PIN_BUSY
@@ -64,5 +70,6 @@ void common_hal_nativeio_digitalinout_set_drive_mode(nativeio_digitalinout_obj_t
 enum digitalinout_drive_mode_t common_hal_nativeio_digitalinout_get_drive_mode(nativeio_digitalinout_obj_t* self);
 void common_hal_nativeio_digitalinout_set_pull(nativeio_digitalinout_obj_t* self, enum digitalinout_pull_t pull);
 enum digitalinout_pull_t common_hal_nativeio_digitalinout_get_pull(nativeio_digitalinout_obj_t* self);
+void common_hal_nativeio_digitalinout_set_irq(nativeio_digitalinout_obj_t* self, mp_obj_t handler, enum digitalinout_edge_t edge);
 
 #endif // __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_DIGITALINOUT_H__
@@ -44,7 +44,8 @@
 //|
 //|   :param ~microcontroller.Pin scl: The clock pin
 //|   :param ~microcontroller.Pin sda: The data pin
-//|   :param int frequency: The clock frequency
+//|   :param int frequency: The clock frequency. Over 400kHz selects fast mode
+//|     plus and over 1MHz high speed mode, as with `configure`.
 //|
 STATIC mp_obj_t nativeio_i2c_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *pos_args) {
     mp_arg_check_num(n_args, n_kw, 0, MP_OBJ_FUN_ARGS_MAX, true);
@@ -105,6 +106,30 @@ static void check_lock(nativeio_i2c_obj_t *self) {
     }
 }
 
+//|   .. method:: I2C.configure(\*, frequency=400000)
+//|
+//|     Changes the clock frequency. Only valid when locked. Frequencies over
+//|     400kHz use fast mode plus (up to 1MHz) and high speed mode (up to
+//|     3.4MHz) where the hardware and board allow it. Every device on the bus
+//|     must support the chosen mode.
+//|
+STATIC mp_obj_t nativeio_i2c_configure(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_frequency };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_frequency, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 400000} },
+    };
+    nativeio_i2c_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    check_lock(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (!common_hal_nativeio_i2c_configure(self, args[ARG_frequency].u_int)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C configure failed."));
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_i2c_configure_obj, 1, nativeio_i2c_configure);
+
 //|   .. method:: I2C.scan()
 //|
 //|      Scan all I2C addresses between 0x08 and 0x77 inclusive and return a
@@ -249,10 +274,136 @@ STATIC mp_obj_t nativeio_i2c_writeto(size_t n_args, const mp_obj_t *pos_args, mp
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_i2c_writeto_obj, 1, nativeio_i2c_writeto);
 
+// Finds the bytes of buffer[start:end] without allocating a slice.
+STATIC void get_buffer_slice(mp_obj_t buffer, mp_uint_t flags, int32_t start_in,
+        int32_t end, uint8_t **data, size_t *len) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, flags);
+    if (end < 0) {
+        end += bufinfo.len;
+    }
+    uint32_t start = start_in;
+    *len = end - start;
+    if ((uint32_t) end < start) {
+        *len = 0;
+    } else if (*len > bufinfo.len) {
+        *len = bufinfo.len;
+    }
+    *data = ((uint8_t*) bufinfo.buf) + start;
+}
+
+enum { ARG_address, ARG_buffer_out, ARG_buffer_in, ARG_out_start, ARG_out_end, ARG_in_start, ARG_in_end };
+STATIC const mp_arg_t write_then_read_args[] = {
+    { MP_QSTR_address,    MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+    { MP_QSTR_buffer_out, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+    { MP_QSTR_buffer_in,  MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+    { MP_QSTR_out_start,  MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+    { MP_QSTR_out_end,    MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = INT_MAX} },
+    { MP_QSTR_in_start,   MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+    { MP_QSTR_in_end,     MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = INT_MAX} },
+};
+
+//|   .. method:: I2C.writeto_then_readfrom(address, buffer_out, buffer_in, \*, out_start=0, out_end=len(buffer_out), in_start=0, in_end=len(buffer_in))
+//|
+//|      Write the bytes from ``buffer_out`` to the slave specified by
+//|      ``address`` and then, after a repeated start, read into ``buffer_in``
+//|      as one transaction. This is the usual way to read a register: write
+//|      its address and read its value back.
+//|
+//|      ``out_start``, ``out_end``, ``in_start`` and ``in_end`` slice the
+//|      buffers without allocating, just like ``start`` and ``end`` do for
+//|      `writeto` and `readfrom_into`.
+//|
+//|      :param int address: 7-bit device address
+//|      :param bytearray buffer_out: buffer containing the bytes to write
+//|      :param bytearray buffer_in: buffer to read into
+//|
+STATIC mp_obj_t nativeio_i2c_writeto_then_readfrom(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    nativeio_i2c_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    check_lock(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(write_then_read_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(write_then_read_args), write_then_read_args, args);
+
+    uint8_t *out_data;
+    size_t out_len;
+    get_buffer_slice(args[ARG_buffer_out].u_obj, MP_BUFFER_READ,
+        args[ARG_out_start].u_int, args[ARG_out_end].u_int, &out_data, &out_len);
+    uint8_t *in_data;
+    size_t in_len;
+    get_buffer_slice(args[ARG_buffer_in].u_obj, MP_BUFFER_WRITE,
+        args[ARG_in_start].u_int, args[ARG_in_end].u_int, &in_data, &in_len);
+
+    bool ok = common_hal_nativeio_i2c_write_then_read(self, args[ARG_address].u_int,
+        out_data, out_len, in_data, in_len);
+    if (!ok) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_i2c_writeto_then_readfrom_obj, 4, nativeio_i2c_writeto_then_readfrom);
+
+//|   .. method:: I2C.start_writeto_then_readfrom(address, buffer_out, buffer_in, \*, out_start=0, out_end=len(buffer_out), in_start=0, in_end=len(buffer_in))
+//|
+//|      Start the same transaction as `writeto_then_readfrom` and return
+//|      straight away while it runs in the background. Don't change either
+//|      buffer until `is_transferring` returns False. Use `wait` to find out
+//|      whether it succeeded.
+//|
+STATIC mp_obj_t nativeio_i2c_start_writeto_then_readfrom(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    nativeio_i2c_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    check_lock(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(write_then_read_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(write_then_read_args), write_then_read_args, args);
+
+    uint8_t *out_data;
+    size_t out_len;
+    get_buffer_slice(args[ARG_buffer_out].u_obj, MP_BUFFER_READ,
+        args[ARG_out_start].u_int, args[ARG_out_end].u_int, &out_data, &out_len);
+    uint8_t *in_data;
+    size_t in_len;
+    get_buffer_slice(args[ARG_buffer_in].u_obj, MP_BUFFER_WRITE,
+        args[ARG_in_start].u_int, args[ARG_in_end].u_int, &in_data, &in_len);
+
+    bool ok = common_hal_nativeio_i2c_start_write_then_read(self, args[ARG_address].u_int,
+        args[ARG_buffer_out].u_obj, out_data, out_len,
+        args[ARG_buffer_in].u_obj, in_data, in_len);
+    if (!ok) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(nativeio_i2c_start_writeto_then_readfrom_obj, 4, nativeio_i2c_start_writeto_then_readfrom);
+
+//|   .. method:: I2C.is_transferring()
+//|
+//|      Returns True while a transaction started with
+//|      `start_writeto_then_readfrom` is still running.
+//|
+STATIC mp_obj_t nativeio_i2c_obj_is_transferring(mp_obj_t self_in) {
+    nativeio_i2c_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(common_hal_nativeio_i2c_transfer_in_progress(self));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_i2c_is_transferring_obj, nativeio_i2c_obj_is_transferring);
+
+//|   .. method:: I2C.wait()
+//|
+//|      Waits for a transaction started with `start_writeto_then_readfrom` to
+//|      finish. Raises OSError if it failed.
+//|
+STATIC mp_obj_t nativeio_i2c_obj_wait(mp_obj_t self_in) {
+    nativeio_i2c_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!common_hal_nativeio_i2c_wait_for_transfer(self)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "I2C bus error"));
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_i2c_wait_obj, nativeio_i2c_obj_wait);
+
 STATIC const mp_rom_map_elem_t nativeio_i2c_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&nativeio_i2c_deinit_obj) },
     { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&nativeio_i2c___enter___obj) },
     { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&nativeio_i2c___exit___obj) },
+    { MP_ROM_QSTR(MP_QSTR_configure), MP_ROM_PTR(&nativeio_i2c_configure_obj) },
     { MP_ROM_QSTR(MP_QSTR_scan), MP_ROM_PTR(&nativeio_i2c_scan_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_try_lock), MP_ROM_PTR(&nativeio_i2c_try_lock_obj) },
@@ -260,6 +411,10 @@ STATIC const mp_rom_map_elem_t nativeio_i2c_locals_dict_table[] = {
 
     { MP_ROM_QSTR(MP_QSTR_readfrom_into), MP_ROM_PTR(&nativeio_i2c_readfrom_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_writeto), MP_ROM_PTR(&nativeio_i2c_writeto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_writeto_then_readfrom), MP_ROM_PTR(&nativeio_i2c_writeto_then_readfrom_obj) },
+    { MP_ROM_QSTR(MP_QSTR_start_writeto_then_readfrom), MP_ROM_PTR(&nativeio_i2c_start_writeto_then_readfrom_obj) },
+    { MP_ROM_QSTR(MP_QSTR_is_transferring), MP_ROM_PTR(&nativeio_i2c_is_transferring_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&nativeio_i2c_wait_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(nativeio_i2c_locals_dict, nativeio_i2c_locals_dict_table);
@@ -54,6 +54,10 @@ extern bool common_hal_nativeio_i2c_try_lock(nativeio_i2c_obj_t *self);
 extern bool common_hal_nativeio_i2c_has_lock(nativeio_i2c_obj_t *self);
 extern void common_hal_nativeio_i2c_unlock(nativeio_i2c_obj_t *self);
 
+// Changes the clock frequency. Anything over 400kHz uses fast mode plus and
+// over 1MHz high speed mode, if the port supports them.
+extern bool common_hal_nativeio_i2c_configure(nativeio_i2c_obj_t *self, uint32_t frequency);
+
 // Probe the bus to see if a device acknowledges the given address.
 extern bool common_hal_nativeio_i2c_probe(nativeio_i2c_obj_t *self, uint8_t addr);
 
@@ -65,4 +69,27 @@ extern bool common_hal_nativeio_i2c_write(nativeio_i2c_obj_t *self, uint16_t add
 extern bool common_hal_nativeio_i2c_read(nativeio_i2c_obj_t *self, uint16_t address,
                                          uint8_t * data, size_t len);
 
+// Writes out_data and then reads in_len bytes into in_data after a repeated
+// start, as one transaction.
+extern bool common_hal_nativeio_i2c_write_then_read(nativeio_i2c_obj_t *self,
+                                                    uint16_t address,
+                                                    const uint8_t * out_data,
+                                                    size_t out_len,
+                                                    uint8_t * in_data,
+                                                    size_t in_len);
+
+// Starts the same transaction in the background. The buffer objects are kept
+// referenced until it's done. Returns false if it couldn't be started.
+extern bool common_hal_nativeio_i2c_start_write_then_read(nativeio_i2c_obj_t *self,
+                                                          uint16_t address,
+                                                          mp_obj_t out_buffer,
+                                                          const uint8_t * out_data,
+                                                          size_t out_len,
+                                                          mp_obj_t in_buffer,
+                                                          uint8_t * in_data,
+                                                          size_t in_len);
+extern bool common_hal_nativeio_i2c_transfer_in_progress(nativeio_i2c_obj_t *self);
+// Waits for a background transaction to finish. Returns false if it failed.
+extern bool common_hal_nativeio_i2c_wait_for_transfer(nativeio_i2c_obj_t *self);
+
 #endif // __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_I2C_H__
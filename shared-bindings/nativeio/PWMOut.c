@@ -38,13 +38,21 @@
 //|
 //| PWMOut can be used to output a PWM signal on a given pin.
 //|
-//| .. class:: PWMOut(pin, duty=0)
+//| .. class:: PWMOut(pin, \*, duty_cycle=0, frequency=500, variable_frequency=False)
 //|
 //|   Create a PWM object associated with the given pin. This allows you to
-//|   write PWM signals out on the given pin. Frequency is currently fixed at
-//|   ~735Hz like Arduino.
+//|   write PWM signals out on the given pin. The duty cycle resolution is the
+//|   highest the hardware allows at the frequency, so lower frequencies give
+//|   finer steps.
+//|
+//|   Pins with the same fixed frequency may share a timer. A timer whose
+//|   frequency can be changed can't be shared so ask for
+//|   ``variable_frequency`` only when it's needed.
 //|
 //|   :param ~microcontroller.Pin pin: The pin to output to
+//|   :param int duty_cycle: The fraction of each pulse which is high. 16-bit
+//|   :param int frequency: The target frequency in Hertz (32-bit)
+//|   :param bool variable_frequency: True if the frequency will change over time
 //|
 STATIC mp_obj_t nativeio_pwmout_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 1, MP_OBJ_FUN_ARGS_MAX, true);
@@ -58,15 +66,24 @@ STATIC mp_obj_t nativeio_pwmout_make_new(const mp_obj_type_t *type, size_t n_arg
 
     mp_map_t kw_args;
     mp_map_init_fixed_table(&kw_args, n_kw, args + n_args);
-    enum { ARG_duty };
+    enum { ARG_duty_cycle, ARG_frequency, ARG_variable_frequency };
     static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_duty, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_duty_cycle, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_frequency, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 500} },
+        { MP_QSTR_variable_frequency, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
     };
     mp_arg_val_t parsed_args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args - 1, args + 1, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, parsed_args);
-    uint8_t duty = parsed_args[ARG_duty].u_int;
+    mp_int_t duty = parsed_args[ARG_duty_cycle].u_int;
+    if (duty < 0 || duty > 0xffff) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "PWM duty_cycle must be between 0 and 65535 inclusive (16 bit resolution)"));
+    }
+    mp_int_t frequency = parsed_args[ARG_frequency].u_int;
+    if (frequency <= 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "PWM frequency must be positive"));
+    }
 
-    common_hal_nativeio_pwmout_construct(self, pin, duty);
+    common_hal_nativeio_pwmout_construct(self, pin, duty, frequency, parsed_args[ARG_variable_frequency].u_bool);
 
     return MP_OBJ_FROM_PTR(self);
 }
@@ -104,9 +121,9 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(nativeio_pwmout___exit___obj, 4, 4, n
 
 //|   .. attribute:: duty_cycle
 //|
-//|      8 bit value that dictates how much of one cycle is high (1) versus low
-//|      (0). 255 will always be high, 0 will always be low and 127 will be half
-//|      high and then half low.
+//|      16 bit value that dictates how much of one cycle is high (1) versus low
+//|      (0). 0xffff will always be high, 0 will always be low and 0x7fff will
+//|      be half high and then half low.
 STATIC mp_obj_t nativeio_pwmout_obj_get_duty_cycle(mp_obj_t self_in) {
    nativeio_pwmout_obj_t *self = MP_OBJ_TO_PTR(self_in);
    return MP_OBJ_NEW_SMALL_INT(common_hal_nativeio_pwmout_get_duty_cycle(self));
@@ -116,9 +133,9 @@ MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pwmout_get_duty_cycle_obj, nativeio_pwmout_ob
 STATIC mp_obj_t nativeio_pwmout_obj_set_duty_cycle(mp_obj_t self_in, mp_obj_t duty_cycle) {
     nativeio_pwmout_obj_t *self = MP_OBJ_TO_PTR(self_in);
     mp_int_t duty = mp_obj_get_int(duty_cycle);
-    if (duty < 0 || duty > 255) {
+    if (duty < 0 || duty > 0xffff) {
         nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError,
-            "PWM duty must be between 0 and 255 (8 bit resolution), not %d",
+            "PWM duty must be between 0 and 65535 (16 bit resolution), not %d",
             duty));
     }
    common_hal_nativeio_pwmout_set_duty_cycle(self, duty);
@@ -133,6 +150,38 @@ mp_obj_property_t nativeio_pwmout_duty_cycle_obj = {
               (mp_obj_t)&mp_const_none_obj},
 };
 
+//|   .. attribute:: frequency
+//|
+//|      32 bit value that dictates the PWM frequency in Hertz (cycles per
+//|      second). Only writeable when constructed with ``variable_frequency=True``.
+//|      The duty cycle is kept as a fraction of the new period.
+STATIC mp_obj_t nativeio_pwmout_obj_get_frequency(mp_obj_t self_in) {
+   nativeio_pwmout_obj_t *self = MP_OBJ_TO_PTR(self_in);
+   return mp_obj_new_int_from_uint(common_hal_nativeio_pwmout_get_frequency(self));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pwmout_get_frequency_obj, nativeio_pwmout_obj_get_frequency);
+
+STATIC mp_obj_t nativeio_pwmout_obj_set_frequency(mp_obj_t self_in, mp_obj_t frequency) {
+    nativeio_pwmout_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!common_hal_nativeio_pwmout_get_variable_frequency(self)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_AttributeError,
+            "PWM frequency not writeable when variable_frequency is False on construction."));
+    }
+    mp_int_t freq = mp_obj_get_int(frequency);
+    if (freq <= 0 || !common_hal_nativeio_pwmout_set_frequency(self, freq)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid PWM frequency"));
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_2(nativeio_pwmout_set_frequency_obj, nativeio_pwmout_obj_set_frequency);
+
+mp_obj_property_t nativeio_pwmout_frequency_obj = {
+    .base.type = &mp_type_property,
+    .proxy = {(mp_obj_t)&nativeio_pwmout_get_frequency_obj,
+              (mp_obj_t)&nativeio_pwmout_set_frequency_obj,
+              (mp_obj_t)&mp_const_none_obj},
+};
+
 STATIC const mp_rom_map_elem_t nativeio_pwmout_locals_dict_table[] = {
     // Methods
     { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&nativeio_pwmout___enter___obj) },
@@ -141,7 +190,7 @@ STATIC const mp_rom_map_elem_t nativeio_pwmout_locals_dict_table[] = {
 
     // Properties
     { MP_ROM_QSTR(MP_QSTR_duty_cycle), MP_ROM_PTR(&nativeio_pwmout_duty_cycle_obj) },
-    // TODO(tannewt): Add frequency.
+    { MP_ROM_QSTR(MP_QSTR_frequency), MP_ROM_PTR(&nativeio_pwmout_frequency_obj) },
     // TODO(tannewt): Add enabled to determine whether the signal is output
     // without giving up the resources. Useful for IR output.
 };
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "py/nlr.h"
+#include "py/objproperty.h"
+#include "py/runtime.h"
+#include "py/runtime0.h"
+#include "shared-bindings/microcontroller/Pin.h"
+#include "shared-bindings/nativeio/PulseIn.h"
+
+//| .. currentmodule:: nativeio
+//|
+//| :class:`PulseIn` -- measure a series of pulses
+//| ================================================
+//|
+//| Records the length of each pulse on a pin, and of the gaps between them,
+//| in microseconds. Edges are timestamped from an interrupt as they happen so
+//| nothing is missed while Python is busy, unlike polling
+//| :py:class:`~nativeio.DigitalInOut` or ``machine.time_pulse_us()``. Use it to
+//| decode remote controls or read sensors that output a pulse train.
+//|
+//| Lengths are kept in a ring buffer of ``maxlen`` values, the oldest ones
+//| being dropped when it overflows. Lengths over 65535 microseconds are
+//| recorded as 65535.
+//|
+//| Usage::
+//|
+//|    import nativeio
+//|    import time
+//|    from board import *
+//|
+//|    with nativeio.PulseIn(D5, maxlen=200, idle_state=True) as pulses:
+//|      time.sleep(1)
+//|      while len(pulses) > 0:
+//|        print(pulses.popleft())
+//|
+
+//| .. class:: PulseIn(pin, maxlen=100, \*, idle_state=False)
+//|
+//|   Start recording the pulses on the given pin.
+//|
+//|   :param ~microcontroller.Pin pin: the pin to read from
+//|   :param int maxlen: how many pulse lengths to keep
+//|   :param bool idle_state: the level of the pin between pulses. The first
+//|     length recorded is always that of a pulse away from this level.
+//|
+STATIC mp_obj_t nativeio_pulsein_make_new(const mp_obj_type_t *type,
+        mp_uint_t n_args, mp_uint_t n_kw, const mp_obj_t *pos_args) {
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, pos_args + n_args);
+    enum { ARG_pin, ARG_maxlen, ARG_idle_state };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_pin, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_maxlen, MP_ARG_INT, {.u_int = 100} },
+        { MP_QSTR_idle_state, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    assert_pin(args[ARG_pin].u_obj, false);
+    const mcu_pin_obj_t* pin = MP_OBJ_TO_PTR(args[ARG_pin].u_obj);
+    mp_int_t maxlen = args[ARG_maxlen].u_int;
+    if (maxlen < 1 || maxlen > 0xffff) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "maxlen must be 1 to 65535"));
+    }
+
+    nativeio_pulsein_obj_t *self = m_new_obj(nativeio_pulsein_obj_t);
+    self->base.type = &nativeio_pulsein_type;
+    common_hal_nativeio_pulsein_construct(self, pin, maxlen, args[ARG_idle_state].u_bool);
+
+    return (mp_obj_t) self;
+}
+
+//|   .. method:: deinit()
+//|
+//|      Stop recording and release the pin for other use.
+//|
+STATIC mp_obj_t nativeio_pulsein_deinit(mp_obj_t self_in) {
+    common_hal_nativeio_pulsein_deinit(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein_deinit_obj, nativeio_pulsein_deinit);
+
+//|   .. method:: __enter__()
+//|
+//|      No-op used by Context Managers.
+//|
+STATIC mp_obj_t nativeio_pulsein___enter__(mp_obj_t self_in) {
+    return self_in;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein___enter___obj, nativeio_pulsein___enter__);
+
+//|   .. method:: __exit__()
+//|
+//|      Automatically deinitializes the hardware when exiting a context.
+//|
+STATIC mp_obj_t nativeio_pulsein___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    common_hal_nativeio_pulsein_deinit(MP_OBJ_TO_PTR(args[0]));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(nativeio_pulsein___exit___obj, 4, 4, nativeio_pulsein___exit__);
+
+//|   .. method:: pause()
+//|
+//|      Stop recording. The lengths recorded so far are kept.
+//|
+STATIC mp_obj_t nativeio_pulsein_pause(mp_obj_t self_in) {
+    common_hal_nativeio_pulsein_pause(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein_pause_obj, nativeio_pulsein_pause);
+
+//|   .. method:: resume()
+//|
+//|      Start recording again, from the next time the pin leaves the idle
+//|      state.
+//|
+STATIC mp_obj_t nativeio_pulsein_resume(mp_obj_t self_in) {
+    common_hal_nativeio_pulsein_resume(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein_resume_obj, nativeio_pulsein_resume);
+
+//|   .. method:: clear()
+//|
+//|      Drop all of the recorded lengths.
+//|
+STATIC mp_obj_t nativeio_pulsein_clear(mp_obj_t self_in) {
+    common_hal_nativeio_pulsein_clear(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein_clear_obj, nativeio_pulsein_clear);
+
+//|   .. method:: popleft()
+//|
+//|      Remove and return the oldest length recorded.
+//|
+//|      :raises IndexError: when there are none
+//|
+STATIC mp_obj_t nativeio_pulsein_popleft(mp_obj_t self_in) {
+    nativeio_pulsein_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (common_hal_nativeio_pulsein_get_len(self) == 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "pop from an empty PulseIn"));
+    }
+    return MP_OBJ_NEW_SMALL_INT(common_hal_nativeio_pulsein_popleft(self));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein_popleft_obj, nativeio_pulsein_popleft);
+
+//|   .. attribute:: maxlen
+//|
+//|      The number of lengths kept before the oldest are dropped. (read-only)
+//|
+STATIC mp_obj_t nativeio_pulsein_obj_get_maxlen(mp_obj_t self_in) {
+    nativeio_pulsein_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(common_hal_nativeio_pulsein_get_maxlen(self));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_pulsein_get_maxlen_obj, nativeio_pulsein_obj_get_maxlen);
+
+mp_obj_property_t nativeio_pulsein_maxlen_obj = {
+    .base.type = &mp_type_property,
+    .proxy = {(mp_obj_t)&nativeio_pulsein_get_maxlen_obj,
+              (mp_obj_t)&mp_const_none_obj,
+              (mp_obj_t)&mp_const_none_obj},
+};
+
+//|   .. method:: __len__()
+//|
+//|      The number of lengths recorded and not yet popped. This is used by
+//|      ``len()``.
+//|
+STATIC mp_obj_t nativeio_pulsein_unary_op(mp_uint_t op, mp_obj_t self_in) {
+    nativeio_pulsein_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    uint16_t len = common_hal_nativeio_pulsein_get_len(self);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(len != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+//|   .. method:: __getitem__(index)
+//|
+//|      Return the length at ``index`` without removing it, 0 being the
+//|      oldest. Negative indices count from the newest.
+//|
+STATIC mp_obj_t nativeio_pulsein_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
+    if (value != MP_OBJ_SENTINEL) {
+        // store and delete aren't supported
+        return MP_OBJ_NULL;
+    }
+    nativeio_pulsein_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    uint16_t len = common_hal_nativeio_pulsein_get_len(self);
+    mp_uint_t index = mp_get_index(self->base.type, len, index_in, false);
+    return MP_OBJ_NEW_SMALL_INT(common_hal_nativeio_pulsein_get_item(self, index));
+}
+
+STATIC const mp_rom_map_elem_t nativeio_pulsein_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&nativeio_pulsein_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&nativeio_pulsein___enter___obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&nativeio_pulsein___exit___obj) },
+    { MP_ROM_QSTR(MP_QSTR_pause), MP_ROM_PTR(&nativeio_pulsein_pause_obj) },
+    { MP_ROM_QSTR(MP_QSTR_resume), MP_ROM_PTR(&nativeio_pulsein_resume_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&nativeio_pulsein_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_popleft), MP_ROM_PTR(&nativeio_pulsein_popleft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_maxlen), MP_ROM_PTR(&nativeio_pulsein_maxlen_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(nativeio_pulsein_locals_dict, nativeio_pulsein_locals_dict_table);
+
+const mp_obj_type_t nativeio_pulsein_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_PulseIn,
+    .make_new = nativeio_pulsein_make_new,
+    .unary_op = nativeio_pulsein_unary_op,
+    .subscr = nativeio_pulsein_subscr,
+    .locals_dict = (mp_obj_t)&nativeio_pulsein_locals_dict,
+};
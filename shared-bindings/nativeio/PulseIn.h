@@ -0,0 +1,51 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Scott Shawcroft
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_PULSEIN_H__
+#define __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_PULSEIN_H__
+
+#include "common-hal/microcontroller/types.h"
+#include "common-hal/nativeio/types.h"
+
+extern const mp_obj_type_t nativeio_pulsein_type;
+
+void common_hal_nativeio_pulsein_construct(nativeio_pulsein_obj_t* self, const mcu_pin_obj_t* pin, uint16_t maxlen, bool idle_state);
+void common_hal_nativeio_pulsein_deinit(nativeio_pulsein_obj_t* self);
+
+// Stop and restart recording. Resuming waits for the pin to leave the idle
+// state again before recording anything.
+void common_hal_nativeio_pulsein_pause(nativeio_pulsein_obj_t* self);
+void common_hal_nativeio_pulsein_resume(nativeio_pulsein_obj_t* self);
+
+// Access to the recorded pulse lengths, in microseconds and oldest first.
+// popleft and get_item must only be called with index < get_len.
+void common_hal_nativeio_pulsein_clear(nativeio_pulsein_obj_t* self);
+uint16_t common_hal_nativeio_pulsein_popleft(nativeio_pulsein_obj_t* self);
+uint16_t common_hal_nativeio_pulsein_get_item(nativeio_pulsein_obj_t* self, uint16_t index);
+uint16_t common_hal_nativeio_pulsein_get_len(nativeio_pulsein_obj_t* self);
+uint16_t common_hal_nativeio_pulsein_get_maxlen(nativeio_pulsein_obj_t* self);
+
+#endif  // __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_PULSEIN_H__
@@ -195,6 +195,44 @@ STATIC mp_obj_t nativeio_spi_write(mp_obj_t self_in, mp_obj_t wr_buf) {
 }
 MP_DEFINE_CONST_FUN_OBJ_2(nativeio_spi_write_obj, nativeio_spi_write);
 
+//|   .. method:: SPI.start_write(buf)
+//|
+//|     Start writing the data contained in ``buf`` in the background and
+//|     return immediately. ``buf`` must not be changed until the write is
+//|     finished. Use `is_writing` to poll for completion or `wait` to block
+//|     on it. Requires the SPI being locked.
+//|
+STATIC mp_obj_t nativeio_spi_start_write(mp_obj_t self_in, mp_obj_t wr_buf) {
+    mp_buffer_info_t src;
+    mp_get_buffer_raise(wr_buf, &src, MP_BUFFER_READ);
+    nativeio_spi_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_lock(self);
+    bool ok = common_hal_nativeio_spi_start_write(self, wr_buf, src.buf, src.len);
+    if (!ok) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "SPI bus error"));
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_2(nativeio_spi_start_write_obj, nativeio_spi_start_write);
+
+//|   .. method:: SPI.is_writing()
+//|
+//|     Returns True while a write started by `start_write` is still going.
+//|
+STATIC mp_obj_t nativeio_spi_is_writing(mp_obj_t self_in) {
+    return mp_obj_new_bool(common_hal_nativeio_spi_write_in_progress(MP_OBJ_TO_PTR(self_in)));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_spi_is_writing_obj, nativeio_spi_is_writing);
+
+//|   .. method:: SPI.wait()
+//|
+//|     Blocks until a write started by `start_write` has finished.
+//|
+STATIC mp_obj_t nativeio_spi_wait(mp_obj_t self_in) {
+    common_hal_nativeio_spi_wait_for_write(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(nativeio_spi_wait_obj, nativeio_spi_wait);
 
 //|   .. method:: SPI.readinto(buf)
 //|
@@ -212,6 +250,30 @@ STATIC mp_obj_t nativeio_spi_readinto(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(nativeio_spi_readinto_obj, 2, 2, nativeio_spi_readinto);
 
+//|   .. method:: SPI.write_readinto(buffer_out, buffer_in)
+//|
+//|     Write out the data in ``buffer_out`` while simultaneously reading data
+//|     into ``buffer_in``. The buffers must be the same length. Requires the
+//|     SPI being locked.
+//|
+STATIC mp_obj_t nativeio_spi_write_readinto(mp_obj_t self_in, mp_obj_t wr_buf, mp_obj_t rd_buf) {
+    mp_buffer_info_t src;
+    mp_get_buffer_raise(wr_buf, &src, MP_BUFFER_READ);
+    mp_buffer_info_t dest;
+    mp_get_buffer_raise(rd_buf, &dest, MP_BUFFER_WRITE);
+    if (src.len != dest.len) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "buffers must be the same length"));
+    }
+    nativeio_spi_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_lock(self);
+    bool ok = common_hal_nativeio_spi_transfer(self, src.buf, dest.buf, src.len);
+    if (!ok) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError, "SPI bus error"));
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_3(nativeio_spi_write_readinto_obj, nativeio_spi_write_readinto);
+
 STATIC const mp_rom_map_elem_t nativeio_spi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_deinit), MP_ROM_PTR(&nativeio_spi_deinit_obj) },
     { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&nativeio_spi___enter___obj) },
@@ -222,7 +284,11 @@ STATIC const mp_rom_map_elem_t nativeio_spi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_unlock), MP_ROM_PTR(&nativeio_spi_unlock_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&nativeio_spi_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write_readinto), MP_ROM_PTR(&nativeio_spi_write_readinto_obj) },
     { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&nativeio_spi_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_start_write), MP_ROM_PTR(&nativeio_spi_start_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_is_writing), MP_ROM_PTR(&nativeio_spi_is_writing_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&nativeio_spi_wait_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(nativeio_spi_locals_dict, nativeio_spi_locals_dict_table);
 
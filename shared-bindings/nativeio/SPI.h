@@ -51,7 +51,21 @@ extern void common_hal_nativeio_spi_unlock(nativeio_spi_obj_t *self);
 // Writes out the given data.
 extern bool common_hal_nativeio_spi_write(nativeio_spi_obj_t *self, const uint8_t *data, size_t len);
 
+// Starts writing out the given data in the background and returns
+// immediately. buffer is the object owning data and is kept alive until the
+// write finishes. Falls back to a blocking write when the port can't.
+extern bool common_hal_nativeio_spi_start_write(nativeio_spi_obj_t *self, mp_obj_t buffer, const uint8_t *data, size_t len);
+
+// Returns true while a write started by start_write is still going.
+extern bool common_hal_nativeio_spi_write_in_progress(nativeio_spi_obj_t *self);
+
+// Blocks until a write started by start_write has finished.
+extern void common_hal_nativeio_spi_wait_for_write(nativeio_spi_obj_t *self);
+
 // Reads in len bytes while outputting zeroes.
 extern bool common_hal_nativeio_spi_read(nativeio_spi_obj_t *self, uint8_t *data, size_t len);
 
+// Writes out data_out while simultaneously reading len bytes into data_in.
+extern bool common_hal_nativeio_spi_transfer(nativeio_spi_obj_t *self, const uint8_t *data_out, uint8_t *data_in, size_t len);
+
 #endif // __MICROPY_INCLUDED_SHARED_BINDINGS_NATIVEIO_SPI_H__
@@ -36,9 +36,12 @@
 #include "shared-bindings/microcontroller/Pin.h"
 #include "shared-bindings/nativeio/__init__.h"
 #include "shared-bindings/nativeio/AnalogIn.h"
+#include "shared-bindings/nativeio/AnalogInScan.h"
+#include "shared-bindings/nativeio/DigitalBus.h"
 #include "shared-bindings/nativeio/AnalogOut.h"
 #include "shared-bindings/nativeio/DigitalInOut.h"
 #include "shared-bindings/nativeio/I2C.h"
+#include "shared-bindings/nativeio/PulseIn.h"
 #include "shared-bindings/nativeio/PWMOut.h"
 #include "shared-bindings/nativeio/SPI.h"
 #include "common-hal/nativeio/types.h"
@@ -69,9 +72,12 @@
 //|     :maxdepth: 3
 //|
 //|     AnalogIn
+//|     AnalogInScan
 //|     AnalogOut
+//|     DigitalBus
 //|     DigitalInOut
 //|     I2C
+//|     PulseIn
 //|     PWMOut
 //|     SPI
 //|
@@ -109,9 +115,12 @@
 STATIC const mp_rom_map_elem_t nativeio_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_nativeio) },
     { MP_ROM_QSTR(MP_QSTR_AnalogIn),   MP_ROM_PTR(&nativeio_analogin_type) },
+    { MP_ROM_QSTR(MP_QSTR_AnalogInScan),   MP_ROM_PTR(&nativeio_analoginscan_type) },
     { MP_ROM_QSTR(MP_QSTR_AnalogOut),   MP_ROM_PTR(&nativeio_analogout_type) },
+    { MP_ROM_QSTR(MP_QSTR_DigitalBus),     MP_ROM_PTR(&nativeio_digitalbus_type) },
     { MP_ROM_QSTR(MP_QSTR_DigitalInOut),  MP_ROM_PTR(&nativeio_digitalinout_type) },
     { MP_ROM_QSTR(MP_QSTR_I2C),   MP_ROM_PTR(&nativeio_i2c_type) },
+    { MP_ROM_QSTR(MP_QSTR_PulseIn), MP_ROM_PTR(&nativeio_pulsein_type) },
     { MP_ROM_QSTR(MP_QSTR_PWMOut), MP_ROM_PTR(&nativeio_pwmout_type) },
     { MP_ROM_QSTR(MP_QSTR_SPI),   MP_ROM_PTR(&nativeio_spi_type) },
 };
@@ -46,6 +46,13 @@
 //|
 //|   Write buf out on the given DigitalInOut.
 //|
+//|   Where the port supports it, longer buffers are streamed out by hardware
+//|   in the background so this returns before the write is complete and
+//|   interrupts stay enabled. ``buf`` is copied first so it can be refilled
+//|   with the next frame straight away. The next call encodes its frame while
+//|   the previous one is still being sent and only then waits for it to
+//|   finish, so animations run at the speed of the strip.
+//|
 //|   :param ~nativeio.DigitalInOut gpio: the DigitalInOut to output with
 //|   :param bytearray buf: The bytes to clock out. No assumption is made about color order
 //|   :param bool is800KHz: True if the pixels are 800KHz, otherwise 400KHz is assumed.
@@ -62,9 +69,30 @@ STATIC mp_obj_t neopixel_write_neopixel_write_(mp_obj_t digitalinout_obj, mp_obj
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_3(neopixel_write_neopixel_write_obj, neopixel_write_neopixel_write_);
 
+//| .. method:: neopixel_write.is_writing()
+//|
+//|   Returns True while a previous write is still being sent.
+//|
+STATIC mp_obj_t neopixel_write_is_writing(void) {
+    return mp_obj_new_bool(common_hal_neopixel_write_in_progress());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(neopixel_write_is_writing_obj, neopixel_write_is_writing);
+
+//| .. method:: neopixel_write.wait()
+//|
+//|   Blocks until a previous write has been sent and latched by the pixels.
+//|
+STATIC mp_obj_t neopixel_write_wait(void) {
+    common_hal_neopixel_write_wait();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(neopixel_write_wait_obj, neopixel_write_wait);
+
 STATIC const mp_rom_map_elem_t neopixel_write_module_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_neopixel_write) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_neopixel_write), (mp_obj_t)&neopixel_write_neopixel_write_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_is_writing), (mp_obj_t)&neopixel_write_is_writing_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_wait), (mp_obj_t)&neopixel_write_wait_obj },
 };
 
 STATIC MP_DEFINE_CONST_DICT(neopixel_write_module_globals, neopixel_write_module_globals_table);
@@ -34,4 +34,10 @@
 
 extern void common_hal_neopixel_write(const nativeio_digitalinout_obj_t* gpio, uint8_t *pixels, uint32_t numBytes, bool is800KHz);
 
+// Returns true while a write is still being sent in the background.
+extern bool common_hal_neopixel_write_in_progress(void);
+
+// Blocks until any background write has finished.
+extern void common_hal_neopixel_write_wait(void);
+
 #endif
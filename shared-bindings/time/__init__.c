@@ -33,7 +33,7 @@
 //#include "py/gc.h"
 //#include "py/runtime.h"
 //#include "py/mphal.h"
-//#include "py/smallint.h"
+#include "py/smallint.h"
 #include "shared-bindings/time/__init__.h"
 
 //| :mod:`time` --- time and timing related functions
@@ -56,10 +56,55 @@
 //|   :rtype: float
 //|
 STATIC mp_obj_t time_monotonic(void) {
-    return mp_obj_new_float(common_hal_time_monotonic() / 100.0);
+    return mp_obj_new_float(common_hal_time_monotonic() / 1000.0);
 }
 MP_DEFINE_CONST_FUN_OBJ_0(time_monotonic_obj, time_monotonic);
 
+#if MICROPY_LONGINT_IMPL != MICROPY_LONGINT_IMPL_NONE
+//| .. method:: monotonic_ns()
+//|
+//|   Like `monotonic` but as an integer number of nanoseconds so no
+//|   precision is lost to the float. Resolution is one microsecond.
+//|
+//|   :return: the current monotonic time
+//|   :rtype: int
+//|
+STATIC mp_obj_t time_monotonic_ns(void) {
+    return mp_obj_new_int_from_ull(common_hal_time_monotonic_us() * 1000);
+}
+MP_DEFINE_CONST_FUN_OBJ_0(time_monotonic_ns_obj, time_monotonic_ns);
+#endif
+
+//| .. method:: ticks_us()
+//|
+//|   Returns a microsecond counter that wraps around to 0 once it outgrows a
+//|   small int. Use `ticks_diff` to find the time between two values.
+//|
+//|   :return: the current microsecond count
+//|   :rtype: int
+//|
+STATIC mp_obj_t time_ticks_us(void) {
+    return MP_OBJ_NEW_SMALL_INT(common_hal_time_monotonic_us() & (MICROPY_PY_UTIME_TICKS_PERIOD - 1));
+}
+MP_DEFINE_CONST_FUN_OBJ_0(time_ticks_us_obj, time_ticks_us);
+
+//| .. method:: ticks_diff(end, start)
+//|
+//|   Returns the signed number of ticks from ``start`` to ``end``, two values
+//|   from `ticks_us`, allowing for the counter wrapping in between.
+//|
+//|   :rtype: int
+//|
+STATIC mp_obj_t time_ticks_diff(mp_obj_t end_in, mp_obj_t start_in) {
+    // the arguments come from ticks_us so are small ints
+    mp_uint_t start = MP_OBJ_SMALL_INT_VALUE(start_in);
+    mp_uint_t end = MP_OBJ_SMALL_INT_VALUE(end_in);
+    mp_int_t diff = ((end - start + MICROPY_PY_UTIME_TICKS_PERIOD / 2) & (MICROPY_PY_UTIME_TICKS_PERIOD - 1))
+                   - MICROPY_PY_UTIME_TICKS_PERIOD / 2;
+    return MP_OBJ_NEW_SMALL_INT(diff);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(time_ticks_diff_obj, time_ticks_diff);
+
 //| .. method:: sleep(seconds)
 //|
 //|   Sleep for a given number of seconds.
@@ -80,6 +125,11 @@ STATIC const mp_map_elem_t time_module_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_time) },
 
     { MP_OBJ_NEW_QSTR(MP_QSTR_monotonic), (mp_obj_t)&time_monotonic_obj },
+    #if MICROPY_LONGINT_IMPL != MICROPY_LONGINT_IMPL_NONE
+    { MP_OBJ_NEW_QSTR(MP_QSTR_monotonic_ns), (mp_obj_t)&time_monotonic_ns_obj },
+    #endif
+    { MP_OBJ_NEW_QSTR(MP_QSTR_ticks_us), (mp_obj_t)&time_ticks_us_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_ticks_diff), (mp_obj_t)&time_ticks_diff_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_sleep), (mp_obj_t)&time_sleep_obj },
 };
 
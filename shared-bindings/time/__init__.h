@@ -30,7 +30,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Milliseconds and microseconds since an arbitrary point, usually boot.
 extern uint64_t common_hal_time_monotonic(void);
+extern uint64_t common_hal_time_monotonic_us(void);
 extern void common_hal_time_delay_ms(uint32_t);
 
 #endif  // __MICROPY_INCLUDED_SHARED_BINDINGS_TIME___INIT___H__
@@ -50,9 +50,68 @@ STATIC mp_obj_t uheap_info(mp_obj_t obj) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(uheap_info_obj, uheap_info);
 
+//|   .. method:: summary(object, max_depth=8)
+//|
+//|     Returns the size of the given object like `info`, but without printing
+//|     anything, broken down so that it can be checked by code.  The result is
+//|     a tuple of the total size in bytes, a dict mapping the name of each
+//|     type found to a tuple of the number of objects of that type and their
+//|     size, and a list of the size of the objects found at each depth, the
+//|     given object being at depth 0.  Objects deeper than ``max_depth - 1``
+//|     are not looked at.
+//|
+STATIC mp_obj_t uheap_summary(size_t n_args, const mp_obj_t *args) {
+    mp_int_t max_depth = 8;
+    if (n_args > 1) {
+        max_depth = mp_obj_get_int(args[1]);
+    }
+    if (max_depth < 1 || max_depth > 255) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid depth."));
+    }
+    return shared_module_uheap_summary(args[0], max_depth);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(uheap_summary_obj, 1, 2, uheap_summary);
+
+#if MICROPY_GC_ALLOC_PROFILE
+//|   .. method:: profile(rate)
+//|
+//|     Start sampling one in every ``rate`` blocks of heap allocated, which
+//|     clears any earlier samples.  A ``rate`` of 0 stops sampling and keeps
+//|     the samples.
+//|
+STATIC mp_obj_t uheap_profile(mp_obj_t rate_in) {
+    mp_int_t rate = mp_obj_get_int(rate_in);
+    if (rate < 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError, "Invalid rate."));
+    }
+    shared_module_uheap_profile(rate);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uheap_profile_obj, uheap_profile);
+
+//|   .. method:: allocations()
+//|
+//|     Returns a list of the sampled allocations, oldest first.  Each one is a
+//|     tuple of the name of the function that allocated it (or None if not
+//|     allocated from bytecode), the bytecode offset in that function, the
+//|     size in bytes, and its lifetime (or None if still live).  Lifetime is
+//|     measured in bytes allocated from the heap while it was live.
+//|
+STATIC mp_obj_t uheap_allocations(void) {
+    return shared_module_uheap_allocations();
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(uheap_allocations_obj, uheap_allocations);
+#endif
+
+
 STATIC const mp_rom_map_elem_t uheap_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uheap) },
     { MP_ROM_QSTR(MP_QSTR_info), MP_ROM_PTR(&uheap_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_summary), MP_ROM_PTR(&uheap_summary_obj) },
+    #if MICROPY_GC_ALLOC_PROFILE
+    { MP_ROM_QSTR(MP_QSTR_profile), MP_ROM_PTR(&uheap_profile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_allocations), MP_ROM_PTR(&uheap_allocations_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(uheap_module_globals, uheap_module_globals_table);
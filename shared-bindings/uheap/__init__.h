@@ -30,5 +30,11 @@
 #include "py/obj.h"
 
 extern uint32_t shared_module_uheap_info(mp_obj_t obj);
+extern mp_obj_t shared_module_uheap_summary(mp_obj_t obj, uint8_t max_depth);
+
+#if MICROPY_GC_ALLOC_PROFILE
+extern void shared_module_uheap_profile(size_t rate);
+extern mp_obj_t shared_module_uheap_allocations(void);
+#endif
 
 #endif  // __MICROPY_INCLUDED_SHARED_BINDINGS_UHEAP___INIT___H__
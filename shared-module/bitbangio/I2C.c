@@ -29,6 +29,7 @@
 #include "py/obj.h"
 
 #include "common-hal/microcontroller/types.h"
+#include "common-hal/nativeio/DigitalInOut.h"
 #include "shared-bindings/microcontroller/__init__.h"
 #include "shared-bindings/nativeio/DigitalInOut.h"
 #include "shared-module/bitbangio/types.h"
@@ -37,36 +38,38 @@
 
 STATIC void delay(bitbangio_i2c_obj_t *self) {
     // We need to use an accurate delay to get acceptable I2C
-    // speeds (eg 1us should be not much more than 1us).
-    common_hal_mcu_delay_us(self->us_delay);
+    // speeds (eg 1us should be not much more than 1us).  A delay of
+    // zero means run as fast as the pins can be toggled.
+    if (self->us_delay != 0) {
+        common_hal_mcu_delay_us(self->us_delay);
+    }
 }
 
 STATIC void scl_low(bitbangio_i2c_obj_t *self) {
-    common_hal_nativeio_digitalinout_set_value(&self->scl, false);
+    common_hal_nativeio_digitalinout_fast_write(&self->scl, false);
 }
 
 STATIC void scl_release(bitbangio_i2c_obj_t *self) {
-    common_hal_nativeio_digitalinout_set_value(&self->scl, true);
+    common_hal_nativeio_digitalinout_fast_write(&self->scl, true);
     delay(self);
     // For clock stretching, wait for the SCL pin to be released, with timeout.
-    for (int count = I2C_STRETCH_LIMIT; !common_hal_nativeio_digitalinout_get_value(&self->scl) && count; --count) {
+    for (int count = I2C_STRETCH_LIMIT; !common_hal_nativeio_digitalinout_fast_read(&self->scl) && count; --count) {
         common_hal_mcu_delay_us(1);
     }
 }
 
 STATIC void sda_low(bitbangio_i2c_obj_t *self) {
-    common_hal_nativeio_digitalinout_set_value(&self->sda, false);
+    common_hal_nativeio_digitalinout_fast_write(&self->sda, false);
 }
 
 STATIC void sda_release(bitbangio_i2c_obj_t *self) {
-    common_hal_nativeio_digitalinout_set_value(&self->sda, true);
+    common_hal_nativeio_digitalinout_fast_write(&self->sda, true);
 }
 
+// SDA is always released by the time it's read so the pad shows what the
+// device is driving.
 STATIC bool sda_read(bitbangio_i2c_obj_t *self) {
-    common_hal_nativeio_digitalinout_switch_to_input(&self->sda, PULL_UP);
-    bool value = common_hal_nativeio_digitalinout_get_value(&self->sda);
-    common_hal_nativeio_digitalinout_switch_to_output(&self->sda, true, DRIVE_MODE_OPEN_DRAIN);
-    return value;
+    return common_hal_nativeio_digitalinout_fast_read(&self->sda);
 }
 
 STATIC void start(bitbangio_i2c_obj_t *self) {
@@ -142,10 +145,8 @@ void shared_module_bitbangio_i2c_construct(bitbangio_i2c_obj_t *self,
                                            const mcu_pin_obj_t * scl,
                                            const mcu_pin_obj_t * sda,
                                            uint32_t frequency) {
+    // frequencies above 500kHz run the bus as fast as the pins allow
     self->us_delay = 500000 / frequency;
-    if (self->us_delay == 0) {
-        self->us_delay = 1;
-    }
     digitalinout_result_t result = common_hal_nativeio_digitalinout_construct(&self->scl, scl);
     if (result != DIGITALINOUT_OK) {
         return;
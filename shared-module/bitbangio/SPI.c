@@ -30,6 +30,7 @@
 #include "py/obj.h"
 
 #include "common-hal/microcontroller/types.h"
+#include "common-hal/nativeio/DigitalInOut.h"
 #include "shared-bindings/microcontroller/__init__.h"
 #include "shared-bindings/nativeio/DigitalInOut.h"
 #include "shared-module/bitbangio/types.h"
@@ -68,6 +69,12 @@ void shared_module_bitbangio_spi_construct(bitbangio_spi_obj_t *self,
     self->delay_half = 5;
     self->polarity = 0;
     self->phase = 0;
+    // The bit loops write the port directly so the pins need to be outputs
+    // already.
+    common_hal_nativeio_digitalinout_switch_to_output(&self->clock, self->polarity, DRIVE_MODE_PUSH_PULL);
+    if (self->has_mosi) {
+        common_hal_nativeio_digitalinout_switch_to_output(&self->mosi, false, DRIVE_MODE_PUSH_PULL);
+    }
 }
 
 void shared_module_bitbangio_spi_deinit(bitbangio_spi_obj_t *self) {
@@ -90,6 +97,7 @@ void shared_module_bitbangio_spi_configure(bitbangio_spi_obj_t *self,
 
     self->polarity = polarity;
     self->phase = phase;
+    common_hal_nativeio_digitalinout_fast_write(&self->clock, polarity);
 }
 
 bool shared_module_bitbangio_spi_try_lock(bitbangio_spi_obj_t *self) {
@@ -125,16 +133,13 @@ bool shared_module_bitbangio_spi_write(bitbangio_spi_obj_t *self, const uint8_t
     // delay_half is equal to this value, then the software SPI implementation
     // will run as fast as possible, limited only by CPU speed and GPIO time.
     #ifdef MICROPY_PY_MACHINE_SPI_MIN_DELAY
-    if (delay_half <= MICROPY_PY_MACHINE_SPI_MIN_DELAY) {
+    if (delay_half <= MICROPY_PY_MACHINE_SPI_MIN_DELAY && self->phase == 0) {
         for (size_t i = 0; i < len; ++i) {
             uint8_t data_out = data[i];
             for (int j = 0; j < 8; ++j, data_out <<= 1) {
-                common_hal_nativeio_digitalinout_set_value(&self->mosi, (data_out >> 7) & 1);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, 1 - self->polarity);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, self->polarity);
-            }
-            if (dest != NULL) {
-                dest[i] = data_in;
+                common_hal_nativeio_digitalinout_fast_write(&self->mosi, (data_out >> 7) & 1);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
             }
         }
         return true;
@@ -144,19 +149,19 @@ bool shared_module_bitbangio_spi_write(bitbangio_spi_obj_t *self, const uint8_t
     for (size_t i = 0; i < len; ++i) {
         uint8_t data_out = data[i];
         for (int j = 0; j < 8; ++j, data_out <<= 1) {
-            common_hal_nativeio_digitalinout_set_value(&self->mosi, (data_out >> 7) & 1);
+            common_hal_nativeio_digitalinout_fast_write(&self->mosi, (data_out >> 7) & 1);
             if (self->phase == 0) {
                 common_hal_mcu_delay_us(delay_half);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, 1 - self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
             } else {
-                common_hal_nativeio_digitalinout_set_value(&self->clock, 1 - self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
                 common_hal_mcu_delay_us(delay_half);
             }
             if (self->phase == 0) {
                 common_hal_mcu_delay_us(delay_half);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
             } else {
-                common_hal_nativeio_digitalinout_set_value(&self->clock, self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
                 common_hal_mcu_delay_us(delay_half);
             }
         }
@@ -185,17 +190,17 @@ bool shared_module_bitbangio_spi_read(bitbangio_spi_obj_t *self, uint8_t *data,
     // delay_half is equal to this value, then the software SPI implementation
     // will run as fast as possible, limited only by CPU speed and GPIO time.
     #ifdef MICROPY_PY_MACHINE_SPI_MIN_DELAY
-    if (delay_half <= MICROPY_PY_MACHINE_SPI_MIN_DELAY) {
+    if (delay_half <= MICROPY_PY_MACHINE_SPI_MIN_DELAY && self->phase == 0) {
         // Clock out zeroes while we read.
         if (self->has_mosi) {
-            common_hal_nativeio_digitalinout_set_value(&self->mosi, false);
+            common_hal_nativeio_digitalinout_fast_write(&self->mosi, false);
         }
         for (size_t i = 0; i < len; ++i) {
             uint8_t data_in = 0;
-            for (int j = 0; j < 8; ++j, data_out <<= 1) {
-                common_hal_nativeio_digitalinout_set_value(&self->clock, 1 - self->polarity);
-                data_in = (data_in << 1) | common_hal_nativeio_digitalinout_get_value(&self->miso);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, self->polarity);
+            for (int j = 0; j < 8; ++j) {
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
+                data_in = (data_in << 1) | common_hal_nativeio_digitalinout_fast_read(&self->miso);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
             }
             data[i] = data_in;
         }
@@ -203,24 +208,24 @@ bool shared_module_bitbangio_spi_read(bitbangio_spi_obj_t *self, uint8_t *data,
     }
     #endif
     if (self->has_mosi) {
-        common_hal_nativeio_digitalinout_set_value(&self->mosi, false);
+        common_hal_nativeio_digitalinout_fast_write(&self->mosi, false);
     }
     for (size_t i = 0; i < len; ++i) {
         uint8_t data_in = 0;
         for (int j = 0; j < 8; ++j) {
             if (self->phase == 0) {
                 common_hal_mcu_delay_us(delay_half);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, 1 - self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
             } else {
-                common_hal_nativeio_digitalinout_set_value(&self->clock, 1 - self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
                 common_hal_mcu_delay_us(delay_half);
             }
-            data_in = (data_in << 1) | common_hal_nativeio_digitalinout_get_value(&self->miso);
+            data_in = (data_in << 1) | common_hal_nativeio_digitalinout_fast_read(&self->miso);
             if (self->phase == 0) {
                 common_hal_mcu_delay_us(delay_half);
-                common_hal_nativeio_digitalinout_set_value(&self->clock, self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
             } else {
-                common_hal_nativeio_digitalinout_set_value(&self->clock, self->polarity);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
                 common_hal_mcu_delay_us(delay_half);
             }
         }
@@ -234,3 +239,62 @@ bool shared_module_bitbangio_spi_read(bitbangio_spi_obj_t *self, uint8_t *data,
     }
     return true;
 }
+
+// Writes out data_out while simultaneously reading len bytes into data_in.
+bool shared_module_bitbangio_spi_transfer(bitbangio_spi_obj_t *self, const uint8_t *data_out, uint8_t *data_in, size_t len) {
+    if (len > 0 && (!self->has_mosi || !self->has_miso)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+            "Cannot transfer without MOSI and MISO pins."));
+    }
+    uint32_t delay_half = self->delay_half;
+
+    // only MSB transfer is implemented
+
+    #ifdef MICROPY_PY_MACHINE_SPI_MIN_DELAY
+    if (delay_half <= MICROPY_PY_MACHINE_SPI_MIN_DELAY && self->phase == 0) {
+        for (size_t i = 0; i < len; ++i) {
+            uint8_t byte_out = data_out[i];
+            uint8_t byte_in = 0;
+            for (int j = 0; j < 8; ++j, byte_out <<= 1) {
+                common_hal_nativeio_digitalinout_fast_write(&self->mosi, (byte_out >> 7) & 1);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
+                byte_in = (byte_in << 1) | common_hal_nativeio_digitalinout_fast_read(&self->miso);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
+            }
+            data_in[i] = byte_in;
+        }
+        return true;
+    }
+    #endif
+
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t byte_out = data_out[i];
+        uint8_t byte_in = 0;
+        for (int j = 0; j < 8; ++j, byte_out <<= 1) {
+            common_hal_nativeio_digitalinout_fast_write(&self->mosi, (byte_out >> 7) & 1);
+            if (self->phase == 0) {
+                common_hal_mcu_delay_us(delay_half);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
+            } else {
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, 1 - self->polarity);
+                common_hal_mcu_delay_us(delay_half);
+            }
+            byte_in = (byte_in << 1) | common_hal_nativeio_digitalinout_fast_read(&self->miso);
+            if (self->phase == 0) {
+                common_hal_mcu_delay_us(delay_half);
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
+            } else {
+                common_hal_nativeio_digitalinout_fast_write(&self->clock, self->polarity);
+                common_hal_mcu_delay_us(delay_half);
+            }
+        }
+        data_in[i] = byte_in;
+
+        // Some ports need a regular callback, but probably we don't need
+        // to do this every byte, or even at all.
+        #ifdef MICROPY_EVENT_POLL_HOOK
+        MICROPY_EVENT_POLL_HOOK;
+        #endif
+    }
+    return true;
+}
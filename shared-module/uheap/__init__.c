@@ -24,6 +24,7 @@
  * THE SOFTWARE.
  */
 
+#include <stdarg.h>
 #include <stdint.h>
 
 #include "py/bc.h"
@@ -44,15 +45,74 @@
         && (void *) ptr < (void*)MP_STATE_MEM(gc_pool_end)        /* must be below end of pool */ \
     )
 
+typedef struct _uheap_type_count_t {
+    const mp_obj_type_t *type;
+    uint32_t count;
+    uint32_t bytes;
+} uheap_type_count_t;
+
+// State of a walk over an object graph.  Each node is printed as it is
+// visited if print is set, and counted by type and by depth if the arrays
+// for those are given.
+typedef struct _uheap_walk_t {
+    bool print;
+    uint8_t depth;
+    uint8_t max_depth;
+    // bytes counted so far, which gives the size of an object without the
+    // objects it refers to
+    uint32_t counted;
+    uheap_type_count_t *types;
+    size_t types_len;
+    size_t types_alloc;
+    uint32_t *depth_bytes;
+} uheap_walk_t;
+
 static void indent(uint8_t levels) {
     for (int i = 0; i < levels; i++) {
         mp_printf(&mp_plat_print, "  ");
     }
 }
 
-static uint32_t object_size(uint8_t indent_level, mp_obj_t obj);
+static void walk_printf(uheap_walk_t *walk, uint8_t indent_level, const char *fmt, ...) {
+    if (!walk->print) {
+        return;
+    }
+    indent(indent_level);
+    va_list ap;
+    va_start(ap, fmt);
+    mp_vprintf(&mp_plat_print, fmt, ap);
+    va_end(ap);
+}
 
-static uint32_t int_size(uint8_t indent_level, mp_obj_t obj) {
+static void walk_count(uheap_walk_t *walk, mp_obj_t obj, uint32_t bytes) {
+    if (walk->depth_bytes != NULL) {
+        walk->depth_bytes[walk->depth] += bytes;
+    }
+    if (walk->types == NULL) {
+        return;
+    }
+    const mp_obj_type_t *type = mp_obj_get_type(obj);
+    size_t i = 0;
+    while (i < walk->types_len && walk->types[i].type != type) {
+        i++;
+    }
+    if (i == walk->types_len) {
+        if (walk->types_len == walk->types_alloc) {
+            walk->types = m_renew(uheap_type_count_t, walk->types, walk->types_alloc, walk->types_alloc * 2);
+            walk->types_alloc *= 2;
+        }
+        walk->types[i].type = type;
+        walk->types[i].count = 0;
+        walk->types[i].bytes = 0;
+        walk->types_len++;
+    }
+    walk->types[i].count++;
+    walk->types[i].bytes += bytes;
+}
+
+static uint32_t object_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_t obj);
+
+static uint32_t int_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_t obj) {
     if (MP_OBJ_IS_SMALL_INT(obj)) {
         return 0;
     }
@@ -67,15 +127,14 @@ static uint32_t int_size(uint8_t indent_level, mp_obj_t obj) {
     #endif
 }
 
-static uint32_t string_size(uint8_t indent_level, mp_obj_t obj) {
+static uint32_t string_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_t obj) {
     if (MP_OBJ_IS_QSTR(obj)) {
         qstr qs = MP_OBJ_QSTR_VALUE(obj);
         const char* s = qstr_str(qs);
         if (!VERIFY_PTR(s)) {
             return 0;
         }
-        indent(indent_level);
-        mp_printf(&mp_plat_print, "%s\n", s);
+        walk_printf(walk, indent_level, "%s\n", s);
         return 0;
     } else { // MP_OBJ_IS_TYPE(o, &mp_type_str)
         mp_obj_str_t* s = MP_OBJ_TO_PTR(obj);
@@ -83,41 +142,41 @@ static uint32_t string_size(uint8_t indent_level, mp_obj_t obj) {
     }
 }
 
-static uint32_t map_size(uint8_t indent_level, const mp_map_t *map) {
+static uint32_t map_size(uheap_walk_t *walk, uint8_t indent_level, const mp_map_t *map) {
     uint32_t total_size = gc_nbytes(map->table);
     for (int i = 0; i < map->used; i++) {
         uint32_t this_size = 0;
-        indent(indent_level);
-        if (map->table[i].key != NULL) {
-            mp_print_str(&mp_plat_print, "key: ");
-            mp_obj_print_helper(&mp_plat_print, map->table[i].key, PRINT_STR);
-            mp_print_str(&mp_plat_print, "\n");
-        } else {
-            mp_print_str(&mp_plat_print, "null key\n");
+        if (walk->print) {
+            indent(indent_level);
+            if (map->table[i].key != NULL) {
+                mp_print_str(&mp_plat_print, "key: ");
+                mp_obj_print_helper(&mp_plat_print, map->table[i].key, PRINT_STR);
+                mp_print_str(&mp_plat_print, "\n");
+            } else {
+                mp_print_str(&mp_plat_print, "null key\n");
+            }
         }
-        this_size += object_size(indent_level + 1, map->table[i].key);
-        this_size += object_size(indent_level + 1, map->table[i].value);
+        this_size += object_size(walk, indent_level + 1, map->table[i].key);
+        this_size += object_size(walk, indent_level + 1, map->table[i].value);
 
-        indent(indent_level);
-        mp_printf(&mp_plat_print, "Entry size: %u\n\n", this_size);
+        walk_printf(walk, indent_level, "Entry size: %u\n\n", this_size);
         total_size += this_size;
     }
 
     return total_size;
 }
 
-static uint32_t dict_size(uint8_t indent_level, mp_obj_dict_t *dict) {
+static uint32_t dict_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_dict_t *dict) {
     uint32_t total_size = gc_nbytes(dict);
 
-    indent(indent_level);
-    mp_printf(&mp_plat_print, "Dictionary @%x\n", dict);
+    walk_printf(walk, indent_level, "Dictionary @%x\n", dict);
 
-    total_size += map_size(indent_level, &dict->map);
+    total_size += map_size(walk, indent_level, &dict->map);
 
     return total_size;
 }
 
-static uint32_t function_size(uint8_t indent_level, mp_obj_t obj) {
+static uint32_t function_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_t obj) {
     //indent(indent_level);
     //mp_print_str(&mp_plat_print, "function\n");
     if (MP_OBJ_IS_TYPE(obj, &mp_type_fun_builtin_0)) {
@@ -134,9 +193,11 @@ static uint32_t function_size(uint8_t indent_level, mp_obj_t obj) {
         mp_obj_fun_bc_t* fn = MP_OBJ_TO_PTR(obj);
         uint32_t total_size = gc_nbytes(fn) + gc_nbytes(fn->bytecode) + gc_nbytes(fn->const_table);
         #if MICROPY_DEBUG_PRINTERS
-        mp_printf(&mp_plat_print, "BYTECODE START\n");
-        mp_bytecode_print(fn, fn->bytecode, gc_nbytes(fn->bytecode), fn->const_table);
-        mp_printf(&mp_plat_print, "BYTECODE END\n");
+        if (walk->print) {
+            mp_printf(&mp_plat_print, "BYTECODE START\n");
+            mp_bytecode_print(fn, fn->bytecode, gc_nbytes(fn->bytecode), fn->const_table);
+            mp_printf(&mp_plat_print, "BYTECODE END\n");
+        }
         #endif
         return total_size;
     #if MICROPY_EMIT_NATIVE
@@ -155,29 +216,26 @@ static uint32_t function_size(uint8_t indent_level, mp_obj_t obj) {
     return 0;
 }
 
-static uint32_t array_size(uint8_t indent_level, mp_obj_array_t *array) {
+static uint32_t array_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_array_t *array) {
     uint32_t total_size = gc_nbytes(array);
 
     uint32_t item_size = gc_nbytes(array->items);
     total_size += item_size;
-    indent(indent_level);
-    mp_printf(&mp_plat_print, "Array of size: %u\n\n", item_size);
+    walk_printf(walk, indent_level, "Array of size: %u\n\n", item_size);
 
     return total_size;
 }
 
-static uint32_t memoryview_size(uint8_t indent_level, mp_obj_array_t *array) {
+static uint32_t memoryview_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_array_t *array) {
     uint32_t total_size = gc_nbytes(array);
 
-    indent(indent_level);
-    mp_printf(&mp_plat_print, "memoryview\n");
+    walk_printf(walk, indent_level, "memoryview\n");
 
     return total_size;
 }
 
-static uint32_t type_size(uint8_t indent_level, mp_obj_type_t *type) {
+static uint32_t type_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_type_t *type) {
     uint32_t total_size = gc_nbytes(type);
-
     // mp_obj_base_t base;
     // qstr name;
     //total_size += string_size(indent_level, MP_OBJ_TO_PTR(type->name));
@@ -216,46 +274,64 @@ static uint32_t type_size(uint8_t indent_level, mp_obj_type_t *type) {
     // struct _mp_obj_tuple_t *bases_tuple;
     // struct _mp_obj_dict_t *locals_dict;
     if (type->locals_dict != NULL) {
-        total_size += dict_size(indent_level, type->locals_dict);
+        total_size += object_size(walk, indent_level, MP_OBJ_FROM_PTR(type->locals_dict));
     }
 
-    indent(indent_level);
-    mp_printf(&mp_plat_print, "TYPE\n");
+    walk_printf(walk, indent_level, "TYPE\n");
     return total_size;
 }
 
 
-static uint32_t instance_size(uint8_t indent_level, mp_obj_instance_t *instance) {
+static uint32_t instance_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_instance_t *instance) {
     uint32_t total_size = gc_nbytes(instance);
 
-    total_size += map_size(indent_level, &instance->members);
+    #if MICROPY_OPT_INSTANCE_SHARED_KEYS
+    if (instance->members != NULL) {
+        total_size += gc_nbytes(instance->members) + map_size(walk, indent_level, instance->members);
+        return total_size;
+    }
+    // the attributes are stored in the instance, under the keys of the type
+    const mp_obj_instance_type_t *type = (const mp_obj_instance_type_t*)instance->base.type;
+    mp_obj_t *values = mp_obj_instance_values(instance);
+    for (size_t i = 0; i < instance->n_values; i++) {
+        if (values[i] == MP_OBJ_NULL) {
+            continue;
+        }
+        if (walk->print) {
+            indent(indent_level);
+            mp_print_str(&mp_plat_print, "key: ");
+            mp_obj_print_helper(&mp_plat_print, type->shared_keys[i], PRINT_STR);
+            mp_print_str(&mp_plat_print, "\n");
+        }
+        uint32_t this_size = object_size(walk, indent_level + 1, values[i]);
+        walk_printf(walk, indent_level, "Entry size: %u\n\n", this_size);
+        total_size += this_size;
+    }
+    #else
+    total_size += map_size(walk, indent_level, &instance->members);
+    #endif
 
     return total_size;
 }
 
-static uint32_t module_size(uint8_t indent_level, mp_obj_module_t *module) {
+static uint32_t module_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_module_t *module) {
     uint32_t total_size = gc_nbytes(module);
 
-    indent(indent_level);
-    mp_printf(&mp_plat_print, ".globals\n");
+    walk_printf(walk, indent_level, ".globals\n");
 
-    total_size += dict_size(indent_level + 1, module->globals);
+    total_size += object_size(walk, indent_level + 1, MP_OBJ_FROM_PTR(module->globals));
 
-    indent(indent_level);
-    mp_printf(&mp_plat_print, "Module size: %u\n", total_size);
+    walk_printf(walk, indent_level, "Module size: %u\n", total_size);
     return total_size;
 }
 
-static uint32_t object_size(uint8_t indent_level, mp_obj_t obj) {
-    if (obj == NULL) {
-        return 0;
-    }
+static uint32_t any_object_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_t obj) {
     if (MP_OBJ_IS_INT(obj)) {
-        return int_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return int_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     } else if (MP_OBJ_IS_STR(obj)) {
-        return string_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return string_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     } else if (MP_OBJ_IS_FUN(obj)) {
-        return function_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return function_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     }
     if (!VERIFY_PTR(obj)) {
         //indent(indent_level);
@@ -265,28 +341,101 @@ static uint32_t object_size(uint8_t indent_level, mp_obj_t obj) {
     mp_obj_t type = MP_OBJ_FROM_PTR(mp_obj_get_type(obj));
 
     if (type == &mp_type_module) {
-        return module_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return module_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     } else if (type == &mp_type_dict) {
-        return dict_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return dict_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     } else if (type == &mp_type_type) {
-        return type_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return type_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     } else if (type == &mp_type_bytearray || type == &mp_type_array) {
-        return array_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return array_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     } else if (type == &mp_type_memoryview) {
-        return memoryview_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return memoryview_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     }  else if (MP_OBJ_IS_OBJ(obj) && VERIFY_PTR(type)) {
-        return instance_size(indent_level, MP_OBJ_TO_PTR(obj));
+        return instance_size(walk, indent_level, MP_OBJ_TO_PTR(obj));
     }
 
-    indent(indent_level);
-    mp_printf(&mp_plat_print, "unknown type %x\n", type);
+    walk_printf(walk, indent_level, "unknown type %x\n", type);
     return 0;
 }
 
+// Return the size of obj and everything it refers to, up to the maximum
+// depth of the walk, and count the part of it taken by obj itself.
+static uint32_t object_size(uheap_walk_t *walk, uint8_t indent_level, mp_obj_t obj) {
+    if (obj == NULL || walk->depth >= walk->max_depth) {
+        return 0;
+    }
+    uint32_t counted = walk->counted;
+    walk->depth++;
+    uint32_t size = any_object_size(walk, indent_level, obj);
+    walk->depth--;
+    uint32_t own_size = size - (walk->counted - counted);
+    if (own_size > 0) {
+        walk->counted += own_size;
+        walk_count(walk, obj, own_size);
+    }
+    return size;
+}
+
 uint32_t shared_module_uheap_info(mp_obj_t obj) {
     if (!VERIFY_PTR(obj)) {
         mp_printf(&mp_plat_print, "Object not on heap.\n");
         return 0;
     }
-    return object_size(0, obj);
+    uheap_walk_t walk = { .print = true, .max_depth = UINT8_MAX };
+    return object_size(&walk, 0, obj);
+}
+
+mp_obj_t shared_module_uheap_summary(mp_obj_t obj, uint8_t max_depth) {
+    uheap_walk_t walk = { .print = false, .max_depth = max_depth };
+    walk.types_alloc = 8;
+    walk.types = m_new(uheap_type_count_t, walk.types_alloc);
+    walk.depth_bytes = m_new0(uint32_t, max_depth);
+    uint32_t total = 0;
+    if (VERIFY_PTR(obj)) {
+        total = object_size(&walk, 0, obj);
+    }
+
+    mp_obj_t types = mp_obj_new_dict(walk.types_len);
+    for (size_t i = 0; i < walk.types_len; i++) {
+        mp_obj_t counts[2] = {
+            mp_obj_new_int_from_uint(walk.types[i].count),
+            mp_obj_new_int_from_uint(walk.types[i].bytes),
+        };
+        mp_obj_dict_store(types, MP_OBJ_NEW_QSTR(walk.types[i].type->name), mp_obj_new_tuple(2, counts));
+    }
+    mp_obj_t depths = mp_obj_new_list(max_depth, NULL);
+    for (size_t i = 0; i < max_depth; i++) {
+        mp_obj_list_store(depths, MP_OBJ_NEW_SMALL_INT(i), mp_obj_new_int_from_uint(walk.depth_bytes[i]));
+    }
+    m_del(uheap_type_count_t, walk.types, walk.types_alloc);
+    m_del(uint32_t, walk.depth_bytes, max_depth);
+
+    mp_obj_t items[3] = { mp_obj_new_int_from_uint(total), types, depths };
+    return mp_obj_new_tuple(3, items);
+}
+
+#if MICROPY_GC_ALLOC_PROFILE
+void shared_module_uheap_profile(size_t rate) {
+    gc_profile_set_rate(rate);
+}
+
+mp_obj_t shared_module_uheap_allocations(void) {
+    // the samples are copied first so the allocations made while building
+    // the result don't change them
+    mp_gc_profile_entry_t *entries = m_new(mp_gc_profile_entry_t, MICROPY_GC_ALLOC_PROFILE_ENTRIES);
+    size_t n = gc_profile_get(entries);
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (size_t i = 0; i < n; i++) {
+        mp_gc_profile_entry_t *e = &entries[i];
+        mp_obj_t items[4] = {
+            e->block_name == MP_QSTR_NULL ? mp_const_none : MP_OBJ_NEW_QSTR(e->block_name),
+            MP_OBJ_NEW_SMALL_INT(e->bc_offset),
+            MP_OBJ_NEW_SMALL_INT(e->n_blocks * MICROPY_BYTES_PER_GC_BLOCK),
+            e->death == 0 ? mp_const_none : MP_OBJ_NEW_SMALL_INT((e->death - e->birth) * MICROPY_BYTES_PER_GC_BLOCK),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(4, items));
+    }
+    m_del(mp_gc_profile_entry_t, entries, MICROPY_GC_ALLOC_PROFILE_ENTRIES);
+    return list;
 }
+#endif
@@ -35,6 +35,7 @@
 #include "pin.h"
 #include "genhdr/pins.h"
 #include "timer.h"
+#include "dma.h"
 
 /// \moduleref pyb
 /// \class ADC - analog to digital conversion: read analog values on a pin
@@ -403,9 +404,266 @@ STATIC mp_obj_t adc_read_timed(mp_obj_t self_in, mp_obj_t buf_in, mp_obj_t freq_
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_3(adc_read_timed_obj, adc_read_timed);
 
+// Get the ADC objects out of a tuple or list, returning how many there are.
+STATIC size_t adc_get_array(mp_obj_t adc_array_in, pyb_obj_adc_t **adcs) {
+    size_t nadcs;
+    mp_obj_t *adc_array;
+    mp_obj_get_array(adc_array_in, &nadcs, &adc_array);
+    if (nadcs < 1 || nadcs > ADC_NUM_CHANNELS) {
+        mp_raise_ValueError("need 1 to 19 ADC objects");
+    }
+    for (size_t i = 0; i < nadcs; i++) {
+        if (!MP_OBJ_IS_TYPE(adc_array[i], &pyb_adc_type)) {
+            mp_raise_ValueError("need ADC objects");
+        }
+        adcs[i] = adc_array[i];
+    }
+    return nadcs;
+}
+
+/// \staticmethod read_timed_multi((adcx, adcy, ...), (bufx, bufy, ...), timer)
+///
+/// Read analog values from several ADC channels into their buffers at a rate
+/// set by the `timer` object.  At each trigger of the timer all the channels
+/// are sampled, one straight after the other, so the samples at the same
+/// index of each buffer are taken at (almost) the same time.
+///
+/// The buffers must all have the same number of elements, and are filled
+/// as with `read_timed`.
+///
+/// Return value: `True` if every sample was taken on time, `False` if the
+/// timer triggered again before all the channels of a sample were read,
+/// which means the timer runs too fast for this many channels.
+///
+/// This function does not allocate any memory.
+STATIC mp_obj_t adc_read_timed_multi(mp_obj_t adc_array_in, mp_obj_t buf_array_in, mp_obj_t tim_in) {
+    pyb_obj_adc_t *adcs[ADC_NUM_CHANNELS];
+    size_t nadcs = adc_get_array(adc_array_in, adcs);
+
+    size_t nbufs;
+    mp_obj_t *buf_array;
+    mp_obj_get_array(buf_array_in, &nbufs, &buf_array);
+    if (nbufs != nadcs) {
+        mp_raise_ValueError("need one buffer for each ADC");
+    }
+
+    mp_buffer_info_t bufinfo[ADC_NUM_CHANNELS];
+    size_t typesize[ADC_NUM_CHANNELS];
+    size_t nelems = 0;
+    for (size_t i = 0; i < nbufs; i++) {
+        mp_get_buffer_raise(buf_array[i], &bufinfo[i], MP_BUFFER_WRITE);
+        typesize[i] = mp_binary_get_size('@', bufinfo[i].typecode, NULL);
+        if (i == 0) {
+            nelems = bufinfo[i].len / typesize[i];
+        } else if (bufinfo[i].len / typesize[i] != nelems) {
+            mp_raise_ValueError("buffers must have the same number of elements");
+        }
+    }
+
+    TIM_HandleTypeDef *tim = pyb_timer_get_handle(tim_in);
+
+    bool on_time = true;
+    for (size_t index = 0; index < nelems; index++) {
+        // Wait for the timer to trigger so we sample at the correct frequency
+        while (__HAL_TIM_GET_FLAG(tim, TIM_FLAG_UPDATE) == RESET) {
+        }
+        __HAL_TIM_CLEAR_FLAG(tim, TIM_FLAG_UPDATE);
+
+        for (size_t i = 0; i < nadcs; i++) {
+            adc_config_channel(&adcs[i]->handle, adcs[i]->channel);
+
+            if (index == 0 && i == 0) {
+                // for the first sample we need to turn the ADC on
+                HAL_ADC_Start(&adcs[0]->handle);
+            } else {
+                // for subsequent samples we can just set the "start sample" bit
+#if defined(MCU_SERIES_F4) || defined(MCU_SERIES_F7)
+                ADCx->CR2 |= (uint32_t)ADC_CR2_SWSTART;
+#elif defined(MCU_SERIES_L4)
+                SET_BIT(ADCx->CR, ADC_CR_ADSTART);
+#else
+                #error Unsupported processor
+#endif
+            }
+
+            // wait for sample to complete, and read it
+            adc_wait_for_eoc_or_timeout(READ_TIMED_TIMEOUT);
+            uint value = ADCx->DR;
+            if (typesize[i] == 1) {
+                value >>= 4;
+            }
+            mp_binary_set_val_array_from_int(bufinfo[i].typecode, bufinfo[i].buf, index, value);
+        }
+
+        if (__HAL_TIM_GET_FLAG(tim, TIM_FLAG_UPDATE) != RESET) {
+            // the next trigger came before this sample was done
+            on_time = false;
+        }
+    }
+
+    // turn the ADC off
+    HAL_ADC_Stop(&adcs[0]->handle);
+
+    return mp_obj_new_bool(on_time);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(adc_read_timed_multi_fun_obj, adc_read_timed_multi);
+STATIC MP_DEFINE_CONST_STATICMETHOD_OBJ(adc_read_timed_multi_obj, (mp_obj_t)&adc_read_timed_multi_fun_obj);
+
+#if defined(MCU_SERIES_F4) || defined(MCU_SERIES_F7)
+
+// State of the sampling started by read_timed_start, kept in
+// MP_STATE_PORT(pyb_adc_stream) so it and the buffer stay put on the heap
+// while the DMA fills it.
+typedef struct _pyb_adc_stream_t {
+    ADC_HandleTypeDef handle;
+    DMA_HandleTypeDef dma;
+    mp_obj_t callback;
+    mp_obj_t buf;
+} pyb_adc_stream_t;
+
+// The half transfer and transfer complete interrupts of the circular DMA
+// mean the first and second half of the buffer are full.
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+    pyb_adc_stream_t *stream = MP_STATE_PORT(pyb_adc_stream);
+    if (stream != NULL && hadc == &stream->handle && stream->callback != mp_const_none) {
+        mp_sched_schedule(stream->callback, MP_OBJ_NEW_SMALL_INT(0));
+    }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+    pyb_adc_stream_t *stream = MP_STATE_PORT(pyb_adc_stream);
+    if (stream != NULL && hadc == &stream->handle && stream->callback != mp_const_none) {
+        mp_sched_schedule(stream->callback, MP_OBJ_NEW_SMALL_INT(1));
+    }
+}
+
+void adc_stream_deinit(void) {
+    pyb_adc_stream_t *stream = MP_STATE_PORT(pyb_adc_stream);
+    if (stream != NULL) {
+        HAL_ADC_Stop_DMA(&stream->handle);
+        dma_deinit(&dma_ADC_1_RX);
+        MP_STATE_PORT(pyb_adc_stream) = NULL;
+    }
+}
+
+/// \staticmethod read_timed_start((adcx, adcy, ...), buf, timer, callback)
+///
+/// Start sampling several ADC channels at each trigger of `timer`, and
+/// return straight away.  The ADC scans the channels and DMA stores the
+/// samples in `buf`, interleaved as x, y, ..., x, y, ..., going round the
+/// buffer until `read_timed_stop` is called.  When the first half of the
+/// buffer is full `callback(0)` is scheduled, and `callback(1)` when the
+/// second half is, so one half can be processed while the other is filled.
+///
+/// `buf` must have 16-bit elements, eg `array('H', ...)`, and hold a whole
+/// number of samples in each half.  `timer` must be Timer 2, 3 or 8, and is
+/// set to trigger the ADC on each update.  The ADC can't be used for
+/// anything else while sampling.
+STATIC mp_obj_t adc_read_timed_start(size_t n_args, const mp_obj_t *args) {
+    pyb_obj_adc_t *adcs[ADC_NUM_CHANNELS];
+    size_t nadcs = adc_get_array(args[0], adcs);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
+    if (mp_binary_get_size('@', bufinfo.typecode, NULL) != 2) {
+        mp_raise_ValueError("buffer must have 16-bit elements");
+    }
+    size_t nelems = bufinfo.len / 2;
+    if (nelems == 0 || nelems % (2 * nadcs) != 0) {
+        mp_raise_ValueError("each half of the buffer must hold whole samples");
+    }
+
+    // the timer's update event drives the ADC through TRGO
+    TIM_HandleTypeDef *tim = pyb_timer_get_handle(args[2]);
+    uint32_t trigger;
+    if (tim->Instance == TIM2) {
+        trigger = ADC_EXTERNALTRIGCONV_T2_TRGO;
+    } else if (tim->Instance == TIM3) {
+        trigger = ADC_EXTERNALTRIGCONV_T3_TRGO;
+    #if defined(TIM8)
+    } else if (tim->Instance == TIM8) {
+        trigger = ADC_EXTERNALTRIGCONV_T8_TRGO;
+    #endif
+    } else {
+        mp_raise_ValueError("timer must be 2, 3 or 8");
+    }
+    TIM_MasterConfigTypeDef master_config;
+    master_config.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(tim, &master_config);
+
+    adc_stream_deinit();
+    pyb_adc_stream_t *stream = m_new0(pyb_adc_stream_t, 1);
+    stream->callback = args[3];
+    stream->buf = args[1];
+
+    // configure the ADC to scan the channels at each trigger, as adc_init_single
+    // does for a single channel (whose GPIO it has already set up)
+    adcx_clock_enable();
+    ADC_HandleTypeDef *adcHandle = &stream->handle;
+    adcHandle->Instance                   = ADCx;
+    adcHandle->Init.ContinuousConvMode    = DISABLE;
+    adcHandle->Init.DiscontinuousConvMode = DISABLE;
+    adcHandle->Init.NbrOfDiscConversion   = 0;
+    adcHandle->Init.ExternalTrigConvEdge  = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    adcHandle->Init.DataAlign             = ADC_DATAALIGN_RIGHT;
+    adcHandle->Init.NbrOfConversion       = nadcs;
+    adcHandle->Init.DMAContinuousRequests = ENABLE;
+    adcHandle->Init.Resolution            = ADC_RESOLUTION12b;
+    adcHandle->Init.ClockPrescaler        = ADC_CLOCKPRESCALER_PCLK_DIV2;
+    adcHandle->Init.ScanConvMode          = ENABLE;
+    adcHandle->Init.ExternalTrigConv      = trigger;
+    adcHandle->Init.EOCSelection          = DISABLE;
+    HAL_ADC_Init(adcHandle);
+
+    for (size_t i = 0; i < nadcs; i++) {
+        ADC_ChannelConfTypeDef sConfig;
+        sConfig.Channel = adcs[i]->channel;
+        sConfig.Rank = i + 1;
+        sConfig.SamplingTime = ADC_SAMPLETIME_15CYCLES;
+        sConfig.Offset = 0;
+        HAL_ADC_ConfigChannel(adcHandle, &sConfig);
+    }
+
+    dma_init(&stream->dma, &dma_ADC_1_RX, adcHandle);
+    adcHandle->DMA_Handle = &stream->dma;
+
+    MP_STATE_PORT(pyb_adc_stream) = stream;
+    if (HAL_ADC_Start_DMA(adcHandle, (uint32_t*)bufinfo.buf, nelems) != HAL_OK) {
+        adc_stream_deinit();
+        mp_raise_msg(&mp_type_OSError, "ADC DMA start failed");
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(adc_read_timed_start_fun_obj, 4, 4, adc_read_timed_start);
+STATIC MP_DEFINE_CONST_STATICMETHOD_OBJ(adc_read_timed_start_obj, (mp_obj_t)&adc_read_timed_start_fun_obj);
+
+/// \staticmethod read_timed_stop()
+///
+/// Stop the sampling started by `read_timed_start`.
+STATIC mp_obj_t adc_read_timed_stop(void) {
+    adc_stream_deinit();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(adc_read_timed_stop_fun_obj, adc_read_timed_stop);
+STATIC MP_DEFINE_CONST_STATICMETHOD_OBJ(adc_read_timed_stop_obj, (mp_obj_t)&adc_read_timed_stop_fun_obj);
+
+#else
+
+void adc_stream_deinit(void) {
+}
+
+#endif
+
 STATIC const mp_map_elem_t adc_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_read), (mp_obj_t)&adc_read_obj},
     { MP_OBJ_NEW_QSTR(MP_QSTR_read_timed), (mp_obj_t)&adc_read_timed_obj},
+    { MP_OBJ_NEW_QSTR(MP_QSTR_read_timed_multi), (mp_obj_t)&adc_read_timed_multi_obj},
+    #if defined(MCU_SERIES_F4) || defined(MCU_SERIES_F7)
+    { MP_OBJ_NEW_QSTR(MP_QSTR_read_timed_start), (mp_obj_t)&adc_read_timed_start_obj},
+    { MP_OBJ_NEW_QSTR(MP_QSTR_read_timed_stop), (mp_obj_t)&adc_read_timed_stop_obj},
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(adc_locals_dict, adc_locals_dict_table);
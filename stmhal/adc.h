@@ -26,3 +26,5 @@
 
 extern const mp_obj_type_t pyb_adc_type;
 extern const mp_obj_type_t pyb_adc_all_type;
+
+void adc_stream_deinit(void);
@@ -31,6 +31,7 @@ typedef struct _dma_descr_t dma_descr_t;
 
 #if defined(MCU_SERIES_F4) || defined(MCU_SERIES_F7)
 
+extern const dma_descr_t dma_ADC_1_RX;
 extern const dma_descr_t dma_I2C_1_RX;
 extern const dma_descr_t dma_SPI_3_RX;
 extern const dma_descr_t dma_I2C_3_RX;
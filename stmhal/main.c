@@ -60,6 +60,7 @@
 #include "rng.h"
 #include "accel.h"
 #include "servo.h"
+#include "adc.h"
 #include "dac.h"
 #include "can.h"
 #include "modnetwork.h"
@@ -636,6 +637,8 @@ soft_reset_exit:
     printf("PYB: soft reboot\n");
     timer_deinit();
     uart_deinit();
+    spi_async_deinit();
+    adc_stream_deinit();
 #if MICROPY_HW_ENABLE_CAN
     can_deinit();
 #endif
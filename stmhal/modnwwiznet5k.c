@@ -37,6 +37,7 @@
 #include "modnetwork.h"
 #include "pin.h"
 #include "genhdr/pins.h"
+#include "irq.h"
 #include "spi.h"
 
 #include "ethernet/wizchip_conf.h"
@@ -56,12 +57,19 @@ typedef struct _wiznet5k_obj_t {
 
 STATIC wiznet5k_obj_t wiznet5k_obj;
 
+// Socket buffer bursts at least this long go through DMA; the 3-byte
+// address phase and single register accesses are cheaper to poll.
+#define WIZ_SPI_DMA_MIN_LEN (16)
+
+// The critical section only needs to keep out Python-level callbacks that
+// could touch the chip mid-transaction.  Raising the priority mask instead
+// of disabling IRQs leaves the DMA interrupt free to complete a burst.
 STATIC void wiz_cris_enter(void) {
-    wiznet5k_obj.cris_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    wiznet5k_obj.cris_state = raise_irq_pri(IRQ_PRI_OTG_FS);
 }
 
 STATIC void wiz_cris_exit(void) {
-    MICROPY_END_ATOMIC_SECTION(wiznet5k_obj.cris_state);
+    restore_irq_pri(wiznet5k_obj.cris_state);
 }
 
 STATIC void wiz_cs_select(void) {
@@ -73,12 +81,22 @@ STATIC void wiz_cs_deselect(void) {
 }
 
 STATIC void wiz_spi_read(uint8_t *buf, uint32_t len) {
-    HAL_StatusTypeDef status = HAL_SPI_Receive(wiznet5k_obj.spi, buf, len, 5000);
+    HAL_StatusTypeDef status;
+    if (len < WIZ_SPI_DMA_MIN_LEN) {
+        status = HAL_SPI_Receive(wiznet5k_obj.spi, buf, len, 5000);
+    } else {
+        status = spi_transfer_handle(wiznet5k_obj.spi, len, NULL, buf, 5000);
+    }
     (void)status;
 }
 
 STATIC void wiz_spi_write(const uint8_t *buf, uint32_t len) {
-    HAL_StatusTypeDef status = HAL_SPI_Transmit(wiznet5k_obj.spi, (uint8_t*)buf, len, 5000);
+    HAL_StatusTypeDef status;
+    if (len < WIZ_SPI_DMA_MIN_LEN) {
+        status = HAL_SPI_Transmit(wiznet5k_obj.spi, (uint8_t*)buf, len, 5000);
+    } else {
+        status = spi_transfer_handle(wiznet5k_obj.spi, len, buf, NULL, 5000);
+    }
     (void)status;
 }
 
@@ -92,6 +92,10 @@ STATIC mp_obj_t os_chdir(mp_obj_t path_in) {
         res = f_chdir(path);
     }
 
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    fat_vfs_import_cache_clear();
+    #endif
+
     if (res != FR_OK) {
         // TODO should be mp_type_FileNotFoundError
         nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_OSError, "No such file or directory: '%s'", path));
@@ -145,6 +149,41 @@ STATIC mp_obj_t os_listdir(mp_uint_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_listdir_obj, 0, 1, os_listdir);
 
+/// \function ilistdir([dir])
+/// Like listdir, but return an iterator of (name, type, size) tuples.
+STATIC mp_obj_t os_ilistdir(mp_uint_t n_args, const mp_obj_t *args) {
+    bool is_str_type = true;
+    const char *path;
+    if (n_args == 1) {
+        if (mp_obj_get_type(args[0]) == &mp_type_bytes) {
+            is_str_type = false;
+        }
+        path = mp_obj_str_get_str(args[0]);
+    } else {
+        path = "";
+    }
+
+    // "hack" to list root directory
+    if (path[0] == '/' && path[1] == '\0') {
+        mp_obj_t dir_list = mp_obj_new_list(0, NULL);
+        for (size_t i = 0; i < MP_ARRAY_SIZE(MP_STATE_PORT(fs_user_mount)); ++i) {
+            fs_user_mount_t *vfs = MP_STATE_PORT(fs_user_mount)[i];
+            if (vfs != NULL) {
+                mp_obj_t entry[3] = {
+                    mp_obj_new_str(vfs->str + 1, vfs->len - 1, false),
+                    MP_OBJ_NEW_SMALL_INT(0x4000), // stat.S_IFDIR
+                    MP_OBJ_NEW_SMALL_INT(0),
+                };
+                mp_obj_list_append(dir_list, mp_obj_new_tuple(3, entry));
+            }
+        }
+        return mp_getiter(dir_list);
+    }
+
+    return fat_vfs_ilistdir(path, is_str_type);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_ilistdir_obj, 0, 1, os_ilistdir);
+
 /// \function mkdir(path)
 /// Create a new directory.
 STATIC mp_obj_t os_mkdir(mp_obj_t path_o) {
@@ -379,6 +418,7 @@ STATIC const mp_map_elem_t os_module_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_chdir), (mp_obj_t)&os_chdir_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_getcwd), (mp_obj_t)&os_getcwd_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_listdir), (mp_obj_t)&os_listdir_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_ilistdir), (mp_obj_t)&os_ilistdir_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_mkdir), (mp_obj_t)&os_mkdir_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_remove), (mp_obj_t)&os_remove_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_rename),(mp_obj_t)&os_rename_obj},
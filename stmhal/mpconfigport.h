@@ -40,6 +40,7 @@
 #define MICROPY_COMP_MODULE_CONST   (1)
 #define MICROPY_COMP_TRIPLE_TUPLE_ASSIGN (1)
 #define MICROPY_ENABLE_GC           (1)
+#define MICROPY_GC_STATS            (1)
 #define MICROPY_ENABLE_FINALISER    (1)
 #define MICROPY_STACK_CHECK         (1)
 #define MICROPY_HELPER_REPL         (1)
@@ -48,18 +49,25 @@
 #define MICROPY_ENABLE_SOURCE_LINE  (1)
 #define MICROPY_LONGINT_IMPL        (MICROPY_LONGINT_IMPL_MPZ)
 #define MICROPY_FLOAT_IMPL          (MICROPY_FLOAT_IMPL_FLOAT)
+// floats are stored in the object word with 30 bits of precision, so
+// float arithmetic doesn't allocate on the heap
+#define MICROPY_OBJ_REPR            (MICROPY_OBJ_REPR_C)
 #define MICROPY_OPT_COMPUTED_GOTO   (1)
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #define MICROPY_OPT_MPZ_BITWISE     (1)
+#define MICROPY_OPT_STR_INDEX_CACHE (1)
 
 // fatfs configuration used in ffconf.h
 #define MICROPY_FATFS_ENABLE_LFN       (1)
 #define MICROPY_FATFS_LFN_CODE_PAGE    (437) /* 1=SFN/ANSI 437=LFN/U.S.(OEM) */
 #define MICROPY_FATFS_USE_LABEL        (1)
 #define MICROPY_FATFS_RPATH            (2)
+#define MICROPY_FATFS_USE_FASTSEEK     (1)
+#define MICROPY_FATFS_TINY             (0)
 #define MICROPY_FATFS_VOLUMES          (4)
 #define MICROPY_FATFS_MULTI_PARTITION  (1)
 #define MICROPY_FSUSERMOUNT            (1)
+#define MICROPY_VFS_FAT_IMPORT_CACHE   (1)
 
 #define MICROPY_STREAMS_NON_BLOCK   (1)
 #define MICROPY_MODULE_WEAK_LINKS   (1)
@@ -71,12 +79,17 @@
 #define MICROPY_PY_BUILTINS_STR_PARTITION (1)
 #define MICROPY_PY_BUILTINS_STR_SPLITLINES (1)
 #define MICROPY_PY_BUILTINS_MEMORYVIEW (1)
+#define MICROPY_PY_BUILTINS_MEMORYVIEW_CAST (1)
 #define MICROPY_PY_BUILTINS_FROZENSET (1)
 #define MICROPY_PY_BUILTINS_EXECFILE (1)
 #define MICROPY_PY_BUILTINS_COMPILE (1)
 #define MICROPY_PY_ALL_SPECIAL_METHODS (1)
 #define MICROPY_PY_MICROPYTHON_MEM_INFO (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE (1)
+#define MICROPY_PY_MICROPYTHON_TRACE (1)
+#define MICROPY_PY_MICROPYTHON_CYCLES (1)
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN (1)
+#define MICROPY_PY_ARRAY_VECTOR_OPS (1)
 #define MICROPY_PY_BUILTINS_SLICE_ATTRS (1)
 #define MICROPY_PY_SYS_EXIT         (1)
 #define MICROPY_PY_SYS_MAXSIZE      (1)
@@ -88,15 +101,27 @@
 #define MICROPY_PY_IO               (1)
 #define MICROPY_PY_IO_FILEIO        (1)
 #define MICROPY_PY_UERRNO           (1)
+#define MICROPY_PY_USELECT          (1)
 #define MICROPY_PY_UBINASCII        (1)
 #define MICROPY_PY_URANDOM          (1)
 #define MICROPY_PY_URANDOM_EXTRA_FUNCS (1)
+#if MICROPY_HW_ENABLE_RNG
+#define MICROPY_PY_URANDOM_SEED_INIT_FUNC (rng_get())
+#endif
+#define MICROPY_MODULE_BUILTIN_INIT (1)
 #define MICROPY_PY_UCTYPES          (1)
 #define MICROPY_PY_UZLIB            (1)
+#define MICROPY_PY_UZLIB_FAST_BITS  (8)
+#define MICROPY_PY_UZLIB_CRC32_TABLES (8)
 #define MICROPY_PY_UJSON            (1)
 #define MICROPY_PY_URE              (1)
+#define MICROPY_PY_URE_SUB          (1)
+#define MICROPY_PY_URE_PIKEVM       (1)
 #define MICROPY_PY_UHEAPQ           (1)
+#define MICROPY_PY_UASYNCIO         (1)
 #define MICROPY_PY_UHASHLIB         (1)
+#define MICROPY_PY_UHASHLIB_SHA1    (1)
+#define MICROPY_PY_UHASHLIB_MD5     (1)
 #define MICROPY_PY_UTIME_MP_HAL     (1)
 #define MICROPY_PY_MACHINE          (1)
 #define MICROPY_PY_MACHINE_PULSE    (1)
@@ -104,6 +129,7 @@
 #define MICROPY_PY_MACHINE_SPI      (1)
 #define MICROPY_PY_MACHINE_SPI_MIN_DELAY (0)
 #define MICROPY_PY_FRAMEBUF         (1)
+#define MICROPY_PY_FRAMEBUF_DIRTY   (1)
 
 #ifndef MICROPY_PY_USOCKET
 #define MICROPY_PY_USOCKET          (1)
@@ -115,6 +141,7 @@
 
 #define MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF   (1)
 #define MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE  (0)
+#define MICROPY_ENABLE_SCHEDULER    (1)
 
 // extra built in names to add to the global namespace
 #define MICROPY_PORT_BUILTINS \
@@ -219,6 +246,12 @@ extern const struct _mp_obj_module_t mp_module_network;
     /* pointers to all CAN objects (if they have been created) */ \
     struct _pyb_can_obj_t *pyb_can_obj_all[2]; \
     \
+    /* state of SPI transfers started with a callback, see spi.c */ \
+    struct _pyb_spi_async_t *pyb_spi_async[6]; \
+    \
+    /* state of ADC sampling started with read_timed_start, see adc.c */ \
+    struct _pyb_adc_stream_t *pyb_adc_stream; \
+    \
     /* list of registered NICs */ \
     mp_obj_list_t mod_network_nic_list; \
 
@@ -262,6 +295,12 @@ static inline mp_uint_t disable_irq(void) {
 #define MICROPY_BEGIN_ATOMIC_SECTION()     disable_irq()
 #define MICROPY_END_ATOMIC_SECTION(state)  enable_irq(state)
 
+// from rng.c, for MICROPY_PY_URANDOM_SEED_INIT_FUNC
+uint32_t rng_get(void);
+
+// Sleep until the next interrupt, used by uselect while nothing is ready
+#define MICROPY_EVENT_WAIT_HOOK {__WFI();}
+
 // There is no classical C heap in bare-metal ports, only Python
 // garbage-collected heap. For completeness, emulate C heap via
 // GC heap. Note that MicroPython core never uses malloc() and friends,
@@ -29,6 +29,9 @@ void mp_hal_set_interrupt_char(int c); // -1 to disable
 #define mp_hal_ticks_ms HAL_GetTick
 #define mp_hal_ticks_us() sys_tick_get_microseconds()
 
+// micropython.profile() is sampled from SysTick
+#define mp_hal_profile_timer(enable) (void)(enable)
+
 extern bool mp_hal_ticks_cpu_enabled;
 void mp_hal_ticks_cpu_enable(void);
 static inline mp_uint_t mp_hal_ticks_cpu(void) {
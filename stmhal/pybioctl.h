@@ -1,8 +1,10 @@
-#define MP_IOCTL_POLL (0x100 | 1)
+#include "py/stream.h"
 
-// These values are compatible with Linux, which are in turn
-// compatible with iBCS2 spec.
-#define MP_IOCTL_POLL_RD  (0x0001)
-#define MP_IOCTL_POLL_WR  (0x0004)
-#define MP_IOCTL_POLL_ERR (0x0008)
-#define MP_IOCTL_POLL_HUP (0x0010)
+// The poll ioctl and its flags are shared with the generic stream code,
+// so that stmhal objects can be used with extmod/moduselect.c
+#define MP_IOCTL_POLL MP_STREAM_POLL
+
+#define MP_IOCTL_POLL_RD  MP_STREAM_POLL_RD
+#define MP_IOCTL_POLL_WR  MP_STREAM_POLL_WR
+#define MP_IOCTL_POLL_ERR MP_STREAM_POLL_ERR
+#define MP_IOCTL_POLL_HUP MP_STREAM_POLL_HUP
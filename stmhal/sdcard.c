@@ -433,10 +433,26 @@ STATIC const mp_map_elem_t pyb_sdcard_locals_dict_table[] = {
 
 STATIC MP_DEFINE_CONST_DICT(pyb_sdcard_locals_dict, pyb_sdcard_locals_dict_table);
 
+STATIC mp_uint_t pyb_sdcard_bdev_readblocks(mp_obj_t self, uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    (void)self;
+    return sdcard_read_blocks(buf, block_num, num_blocks);
+}
+
+STATIC mp_uint_t pyb_sdcard_bdev_writeblocks(mp_obj_t self, const uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    (void)self;
+    return sdcard_write_blocks(buf, block_num, num_blocks);
+}
+
+STATIC const mp_block_dev_p_t pyb_sdcard_block_dev_p = {
+    .readblocks = pyb_sdcard_bdev_readblocks,
+    .writeblocks = pyb_sdcard_bdev_writeblocks,
+};
+
 const mp_obj_type_t pyb_sdcard_type = {
     { &mp_type_type },
     .name = MP_QSTR_SDCard,
     .make_new = pyb_sdcard_make_new,
+    .protocol = &pyb_sdcard_block_dev_p,
     .locals_dict = (mp_obj_t)&pyb_sdcard_locals_dict,
 };
 
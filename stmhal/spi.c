@@ -29,6 +29,7 @@
 
 #include "py/nlr.h"
 #include "py/runtime.h"
+#include "py/mperrno.h"
 #include "py/mphal.h"
 #include "extmod/machine_spi.h"
 #include "irq.h"
@@ -61,6 +62,13 @@
 ///     buf = bytearray(4)
 ///     spi.send_recv(b'1234', buf)          # send 4 bytes and receive 4 into buf
 ///     spi.send_recv(buf, buf)              # send/recv 4 bytes from/to buf
+///
+/// Given a callback, send, recv and send_recv start the transfer with DMA and
+/// return straight away; the callback is scheduled once the transfer is done:
+///
+///     spi.send(buf, callback=lambda spi: print('sent'))
+///     while spi.busy():
+///         compute()
 
 // Possible DMA configurations for SPI busses:
 // SPI1_TX: DMA2_Stream3.CHANNEL_3 or DMA2_Stream5.CHANNEL_3
@@ -83,6 +91,18 @@ typedef struct _pyb_spi_obj_t {
     const dma_descr_t *rx_dma_descr;
 } pyb_spi_obj_t;
 
+// State of a transfer started with a callback.  It's allocated on the heap
+// the first time a bus is used this way and kept in MP_STATE_PORT(pyb_spi_async),
+// which also keeps the buffers being transferred alive until the DMA is done.
+typedef struct _pyb_spi_async_t {
+    DMA_HandleTypeDef tx_dma;
+    DMA_HandleTypeDef rx_dma;
+    mp_obj_t callback;
+    mp_obj_t send_buf;
+    mp_obj_t recv_buf;
+    volatile bool busy;
+} pyb_spi_async_t;
+
 #if defined(MICROPY_HW_SPI1_SCK)
 SPI_HandleTypeDef SPIHandle1 = {.Instance = NULL};
 #endif
@@ -161,6 +181,11 @@ void spi_init0(void) {
     memset(&SPIHandle6, 0, sizeof(SPI_HandleTypeDef));
     SPIHandle6.Instance = SPI6;
     #endif
+
+    // the heap is new so forget the state of any async transfers
+    for (int i = 0; i < MP_ARRAY_SIZE(MP_STATE_PORT(pyb_spi_async)); i++) {
+        MP_STATE_PORT(pyb_spi_async)[i] = NULL;
+    }
 }
 
 STATIC int spi_find(mp_obj_t id) {
@@ -406,7 +431,18 @@ STATIC HAL_StatusTypeDef spi_wait_dma_finished(SPI_HandleTypeDef *spi, uint32_t
     return HAL_OK;
 }
 
-STATIC void spi_transfer(const pyb_spi_obj_t *self, size_t len, const uint8_t *src, uint8_t *dest, uint32_t timeout) {
+STATIC pyb_spi_async_t *spi_get_async(const pyb_spi_obj_t *self) {
+    return MP_STATE_PORT(pyb_spi_async)[self - &pyb_spi_obj[0]];
+}
+
+STATIC bool spi_async_busy(const pyb_spi_obj_t *self) {
+    pyb_spi_async_t *async = spi_get_async(self);
+    return async != NULL && async->busy;
+}
+
+// Blocking transfer that reports errors instead of raising them, so it can
+// be used by drivers that hold a critical section around the transfer.
+STATIC HAL_StatusTypeDef spi_transfer_status(const pyb_spi_obj_t *self, size_t len, const uint8_t *src, uint8_t *dest, uint32_t timeout) {
     // Note: there seems to be a problem sending 1 byte using DMA the first
     // time directly after the SPI/DMA is initialised.  The cause of this is
     // unknown but we sidestep the issue by using polling for 1 byte transfer.
@@ -472,11 +508,160 @@ STATIC void spi_transfer(const pyb_spi_obj_t *self, size_t len, const uint8_t *s
         }
     }
 
+    return status;
+}
+
+STATIC void spi_transfer(const pyb_spi_obj_t *self, size_t len, const uint8_t *src, uint8_t *dest, uint32_t timeout) {
+    if (spi_async_busy(self)) {
+        mp_raise_OSError(MP_EBUSY);
+    }
+    HAL_StatusTypeDef status = spi_transfer_status(self, len, src, dest, timeout);
     if (status != HAL_OK) {
         mp_hal_raise(status);
     }
 }
 
+// Blocking transfer on the bus with the given handle, for C drivers that
+// only keep the HAL handle.  Uses DMA unless IRQs are disabled, and returns
+// HAL_BUSY if a callback-driven transfer is still running on the bus.
+HAL_StatusTypeDef spi_transfer_handle(SPI_HandleTypeDef *spi, size_t len, const uint8_t *src, uint8_t *dest, uint32_t timeout) {
+    for (size_t i = 0; i < MP_ARRAY_SIZE(pyb_spi_obj); ++i) {
+        const pyb_spi_obj_t *self = &pyb_spi_obj[i];
+        if (self->spi == spi) {
+            if (spi_async_busy(self)) {
+                return HAL_BUSY;
+            }
+            return spi_transfer_status(self, len, src, dest, timeout);
+        }
+    }
+    return HAL_ERROR;
+}
+
+// Start a transfer with DMA and return without waiting for it to finish.
+// When it's done the DMA interrupt schedules callback(self), which may be
+// None.  src_obj and dest_obj are the objects owning src and dest, and are
+// kept alive until then.
+STATIC void spi_transfer_async(const pyb_spi_obj_t *self, size_t len, const uint8_t *src, uint8_t *dest,
+    mp_obj_t src_obj, mp_obj_t dest_obj, mp_obj_t callback) {
+    if (len <= 1 || query_irq() == IRQ_STATE_DISABLED) {
+        // too short for DMA (see spi_transfer) or no interrupt to say it's done
+        spi_transfer(self, len, src, dest, 5000);
+        if (callback != mp_const_none) {
+            mp_sched_schedule(callback, (mp_obj_t)self);
+        }
+        return;
+    }
+
+    pyb_spi_async_t *async = spi_get_async(self);
+    if (async == NULL) {
+        async = m_new0(pyb_spi_async_t, 1);
+        MP_STATE_PORT(pyb_spi_async)[self - &pyb_spi_obj[0]] = async;
+    } else if (async->busy) {
+        mp_raise_OSError(MP_EBUSY);
+    }
+    async->callback = callback;
+    async->send_buf = src_obj;
+    async->recv_buf = dest_obj;
+
+    // set up the DMA streams as spi_transfer does
+    self->spi->hdmatx = NULL;
+    self->spi->hdmarx = NULL;
+    if (dest == NULL || self->spi->Init.Mode == SPI_MODE_MASTER) {
+        // in master mode a receive is actually a TransmitReceive call
+        dma_init(&async->tx_dma, self->tx_dma_descr, self->spi);
+        self->spi->hdmatx = &async->tx_dma;
+    }
+    if (dest != NULL) {
+        dma_init(&async->rx_dma, self->rx_dma_descr, self->spi);
+        self->spi->hdmarx = &async->rx_dma;
+    }
+
+    async->busy = true;
+    HAL_StatusTypeDef status;
+    if (dest == NULL) {
+        status = HAL_SPI_Transmit_DMA(self->spi, (uint8_t*)src, len);
+    } else if (src == NULL) {
+        status = HAL_SPI_Receive_DMA(self->spi, dest, len);
+    } else {
+        status = HAL_SPI_TransmitReceive_DMA(self->spi, (uint8_t*)src, dest, len);
+    }
+
+    if (status != HAL_OK) {
+        async->busy = false;
+        if (self->spi->hdmatx != NULL) {
+            dma_deinit(self->tx_dma_descr);
+        }
+        if (self->spi->hdmarx != NULL) {
+            dma_deinit(self->rx_dma_descr);
+        }
+        mp_hal_raise(status);
+    }
+}
+
+// Called from the DMA interrupt, through the HAL callbacks below, when a
+// transfer on the bus ends.  Transfers made by spi_transfer also end up
+// here and are ignored since they aren't marked busy.
+STATIC void spi_async_done(SPI_HandleTypeDef *spi) {
+    for (int i = 0; i < MP_ARRAY_SIZE(pyb_spi_obj); i++) {
+        if (pyb_spi_obj[i].spi != spi) {
+            continue;
+        }
+        pyb_spi_async_t *async = MP_STATE_PORT(pyb_spi_async)[i];
+        if (async == NULL || !async->busy) {
+            return;
+        }
+        if (spi->hdmatx != NULL) {
+            dma_deinit(pyb_spi_obj[i].tx_dma_descr);
+        }
+        if (spi->hdmarx != NULL) {
+            dma_deinit(pyb_spi_obj[i].rx_dma_descr);
+        }
+        async->send_buf = MP_OBJ_NULL;
+        async->recv_buf = MP_OBJ_NULL;
+        async->busy = false;
+        if (async->callback != mp_const_none) {
+            mp_sched_schedule(async->callback, (mp_obj_t)&pyb_spi_obj[i]);
+        }
+        return;
+    }
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *spi) {
+    spi_async_done(spi);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *spi) {
+    spi_async_done(spi);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi) {
+    spi_async_done(spi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *spi) {
+    spi_async_done(spi);
+}
+
+// Abandon a transfer started by spi_transfer_async, without calling back.
+STATIC void spi_async_stop(const pyb_spi_obj_t *self) {
+    pyb_spi_async_t *async = spi_get_async(self);
+    if (async != NULL && async->busy) {
+        async->callback = mp_const_none;
+        HAL_SPI_DMAStop(self->spi);
+        spi_async_done(self->spi);
+    }
+}
+
+// Stop any transfers still running at a soft reset, before the heap holding
+// their buffers goes away.
+void spi_async_deinit(void) {
+    for (int i = 0; i < MP_ARRAY_SIZE(pyb_spi_obj); i++) {
+        if (pyb_spi_obj[i].spi != NULL) {
+            spi_async_stop(&pyb_spi_obj[i]);
+        }
+    }
+}
+
 STATIC void spi_print(const mp_print_t *print, SPI_HandleTypeDef *spi, bool legacy) {
     uint spi_num = 1; // default to SPI1
     if (spi->Instance == SPI2) { spi_num = 2; }
@@ -632,16 +817,26 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pyb_spi_init_obj, 1, pyb_spi_init);
 /// Turn off the SPI bus.
 STATIC mp_obj_t pyb_spi_deinit(mp_obj_t self_in) {
     pyb_spi_obj_t *self = self_in;
+    spi_async_stop(self);
     spi_deinit(self->spi);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(pyb_spi_deinit_obj, pyb_spi_deinit);
 
-/// \method send(send, *, timeout=5000)
+/// \method busy()
+/// Return `True` while a transfer started with a callback is still running.
+STATIC mp_obj_t pyb_spi_busy(mp_obj_t self_in) {
+    return mp_obj_new_bool(spi_async_busy(self_in));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(pyb_spi_busy_obj, pyb_spi_busy);
+
+/// \method send(send, *, timeout=5000, callback=None)
 /// Send data on the bus:
 ///
 ///   - `send` is the data to send (an integer to send, or a buffer object).
 ///   - `timeout` is the timeout in milliseconds to wait for the send.
+///   - `callback`, if given, makes the send return straight away, with
+///     `callback(spi)` scheduled once the data has gone.
 ///
 /// Return value: `None`.
 STATIC mp_obj_t pyb_spi_send(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
@@ -650,6 +845,7 @@ STATIC mp_obj_t pyb_spi_send(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_send,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
         { MP_QSTR_timeout, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 5000} },
+        { MP_QSTR_callback, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
     };
 
     // parse args
@@ -663,19 +859,26 @@ STATIC mp_obj_t pyb_spi_send(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_
     pyb_buf_get_for_send(args[0].u_obj, &bufinfo, data);
 
     // send the data
-    spi_transfer(self, bufinfo.len, bufinfo.buf, NULL, args[1].u_int);
+    if (args[2].u_obj != MP_OBJ_NULL) {
+        spi_transfer_async(self, bufinfo.len, bufinfo.buf, NULL, args[0].u_obj, MP_OBJ_NULL, args[2].u_obj);
+    } else {
+        spi_transfer(self, bufinfo.len, bufinfo.buf, NULL, args[1].u_int);
+    }
 
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pyb_spi_send_obj, 1, pyb_spi_send);
 
-/// \method recv(recv, *, timeout=5000)
+/// \method recv(recv, *, timeout=5000, callback=None)
 ///
 /// Receive data on the bus:
 ///
 ///   - `recv` can be an integer, which is the number of bytes to receive,
 ///     or a mutable buffer, which will be filled with received bytes.
 ///   - `timeout` is the timeout in milliseconds to wait for the receive.
+///   - `callback`, if given, makes the receive return straight away, with
+///     `callback(spi)` scheduled once `recv` is filled.  `recv` must then
+///     be a buffer.
 ///
 /// Return value: if `recv` is an integer then a new buffer of the bytes received,
 /// otherwise the same buffer that was passed in to `recv`.
@@ -685,6 +888,7 @@ STATIC mp_obj_t pyb_spi_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_recv,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
         { MP_QSTR_timeout, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 5000} },
+        { MP_QSTR_callback, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
     };
 
     // parse args
@@ -692,6 +896,14 @@ STATIC mp_obj_t pyb_spi_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
+    if (args[2].u_obj != MP_OBJ_NULL) {
+        // receive into the given buffer in the background
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(args[0].u_obj, &bufinfo, MP_BUFFER_WRITE);
+        spi_transfer_async(self, bufinfo.len, NULL, bufinfo.buf, MP_OBJ_NULL, args[0].u_obj, args[2].u_obj);
+        return args[0].u_obj;
+    }
+
     // get the buffer to receive into
     vstr_t vstr;
     mp_obj_t o_ret = pyb_buf_get_for_recv(args[0].u_obj, &vstr);
@@ -708,7 +920,7 @@ STATIC mp_obj_t pyb_spi_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pyb_spi_recv_obj, 1, pyb_spi_recv);
 
-/// \method send_recv(send, recv=None, *, timeout=5000)
+/// \method send_recv(send, recv=None, *, timeout=5000, callback=None)
 ///
 /// Send and receive data on the bus at the same time:
 ///
@@ -717,6 +929,8 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pyb_spi_recv_obj, 1, pyb_spi_recv);
 ///   It can be the same as `send`, or omitted.  If omitted, a new buffer will
 ///   be created.
 ///   - `timeout` is the timeout in milliseconds to wait for the receive.
+///   - `callback`, if given, makes the transfer return straight away, with
+///     `callback(spi)` scheduled once it's done.  `recv` must then be given.
 ///
 /// Return value: the buffer with the received bytes.
 STATIC mp_obj_t pyb_spi_send_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
@@ -726,6 +940,7 @@ STATIC mp_obj_t pyb_spi_send_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp
         { MP_QSTR_send,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
         { MP_QSTR_recv,    MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
         { MP_QSTR_timeout, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 5000} },
+        { MP_QSTR_callback, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
     };
 
     // parse args
@@ -751,6 +966,9 @@ STATIC mp_obj_t pyb_spi_send_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp
 
         // get the buffer to receive into
         if (args[1].u_obj == MP_OBJ_NULL) {
+            if (args[3].u_obj != MP_OBJ_NULL) {
+                mp_raise_ValueError("recv buffer needed with a callback");
+            }
             // only send argument given, so create a fresh buffer of the send length
             vstr_init_len(&vstr_recv, bufinfo_send.len);
             bufinfo_recv.len = vstr_recv.len;
@@ -767,6 +985,10 @@ STATIC mp_obj_t pyb_spi_send_recv(mp_uint_t n_args, const mp_obj_t *pos_args, mp
     }
 
     // do the transfer
+    if (args[3].u_obj != MP_OBJ_NULL) {
+        spi_transfer_async(self, bufinfo_send.len, bufinfo_send.buf, bufinfo_recv.buf, args[0].u_obj, o_ret, args[3].u_obj);
+        return o_ret;
+    }
     spi_transfer(self, bufinfo_send.len, bufinfo_send.buf, bufinfo_recv.buf, args[2].u_int);
 
     // return the received data
@@ -792,6 +1014,7 @@ STATIC const mp_map_elem_t pyb_spi_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_send), (mp_obj_t)&pyb_spi_send_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_recv), (mp_obj_t)&pyb_spi_recv_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_send_recv), (mp_obj_t)&pyb_spi_send_recv_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_busy), (mp_obj_t)&pyb_spi_busy_obj },
 
     // class constants
     /// \constant MASTER - for initialising the bus to master mode
@@ -35,5 +35,7 @@ extern const mp_obj_type_t machine_soft_spi_type;
 extern const mp_obj_type_t machine_hard_spi_type;
 
 void spi_init0(void);
+void spi_async_deinit(void);
 void spi_init(SPI_HandleTypeDef *spi, bool enable_nss_pin);
 SPI_HandleTypeDef *spi_get_handle(mp_obj_t o);
+HAL_StatusTypeDef spi_transfer_handle(SPI_HandleTypeDef *spi, size_t len, const uint8_t *src, uint8_t *dest, uint32_t timeout);
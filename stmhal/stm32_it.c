@@ -71,6 +71,7 @@
 #include STM32_HAL_H
 
 #include "py/obj.h"
+#include "py/runtime.h"
 #include "pendsv.h"
 #include "irq.h"
 #include "extint.h"
@@ -285,6 +286,10 @@ void SysTick_Handler(void) {
     if (DMA_IDLE_ENABLED() && DMA_IDLE_TICK(uwTick)) {
         dma_idle_handler(uwTick);
     }
+
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    mp_profile_tick();
+    #endif
 }
 
 /******************************************************************************/
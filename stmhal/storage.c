@@ -41,6 +41,7 @@
 #if defined(STM32F405xx) || defined(STM32F407xx)
 
 #define CACHE_MEM_START_ADDR (0x10000000) // CCM data RAM, 64k
+#define CACHE_MEM_SIZE (0x10000)
 #define FLASH_SECTOR_SIZE_MAX (0x10000) // 64k max, size of CCM
 #define FLASH_MEM_SEG1_START_ADDR (0x08004000) // sector 1
 #define FLASH_MEM_SEG1_NUM_BLOCKS (224) // sectors 1,2,3,4: 16k+16k+16k+64k=112k
@@ -55,6 +56,7 @@
 
 STATIC byte flash_cache_mem[0x4000] __attribute__((aligned(4))); // 16k
 #define CACHE_MEM_START_ADDR (&flash_cache_mem[0])
+#define CACHE_MEM_SIZE (sizeof(flash_cache_mem))
 #define FLASH_SECTOR_SIZE_MAX (0x4000) // 16k max due to size of cache buffer
 #define FLASH_MEM_SEG1_START_ADDR (0x08004000) // sector 1
 #define FLASH_MEM_SEG1_NUM_BLOCKS (128) // sectors 1,2,3,4: 16k+16k+16k+16k(of 64k)=64k
@@ -62,6 +64,7 @@ STATIC byte flash_cache_mem[0x4000] __attribute__((aligned(4))); // 16k
 #elif defined(STM32F429xx)
 
 #define CACHE_MEM_START_ADDR (0x10000000) // CCM data RAM, 64k
+#define CACHE_MEM_SIZE (0x10000)
 #define FLASH_SECTOR_SIZE_MAX (0x10000) // 64k max, size of CCM
 #define FLASH_MEM_SEG1_START_ADDR (0x08004000) // sector 1
 #define FLASH_MEM_SEG1_NUM_BLOCKS (224) // sectors 1,2,3,4: 16k+16k+16k+64k=112k
@@ -69,6 +72,7 @@ STATIC byte flash_cache_mem[0x4000] __attribute__((aligned(4))); // 16k
 #elif defined(STM32F439xx)
 
 #define CACHE_MEM_START_ADDR (0x10000000) // CCM data RAM, 64k
+#define CACHE_MEM_SIZE (0x10000)
 #define FLASH_SECTOR_SIZE_MAX (0x10000) // 64k max, size of CCM
 #define FLASH_MEM_SEG1_START_ADDR (0x08100000) // sector 12
 #define FLASH_MEM_SEG1_NUM_BLOCKS (384) // sectors 12,13,14,15,16,17: 16k+16k+16k+16k+64k+64k(of 128k)=192k
@@ -80,6 +84,7 @@ STATIC byte flash_cache_mem[0x4000] __attribute__((aligned(4))); // 16k
 // The STM32F746 doesn't really have CCRAM, so we use the 64K DTCM for this.
 
 #define CACHE_MEM_START_ADDR (0x20000000) // DTCM data RAM, 64k
+#define CACHE_MEM_SIZE (0x10000)
 #define FLASH_SECTOR_SIZE_MAX (0x08000) // 32k max
 #define FLASH_MEM_SEG1_START_ADDR (0x08008000) // sector 1
 #define FLASH_MEM_SEG1_NUM_BLOCKS (192) // sectors 1,2,3: 32k+32k+32=96k
@@ -91,6 +96,8 @@ extern uint8_t _flash_fs_end;
 
 // The STM32L476 doesn't have CCRAM, so we use the 32K SRAM2 for this.
 #define CACHE_MEM_START_ADDR (0x10000000)       // SRAM2 data RAM, 32k
+#define CACHE_MEM_SIZE (0x8000)
+#define CACHE_MAX_SECTORS (16)
 #define FLASH_SECTOR_SIZE_MAX (0x00800)         // 2k max
 #define FLASH_MEM_SEG1_START_ADDR ((long)&_flash_fs_start)
 #define FLASH_MEM_SEG1_NUM_BLOCKS ((&_flash_fs_end - &_flash_fs_start) / 512)
@@ -99,6 +106,11 @@ extern uint8_t _flash_fs_end;
 #error "no storage support for this MCU"
 #endif
 
+// The cache holds as many sectors as fit in its memory, up to this many
+#if !defined(CACHE_MAX_SECTORS)
+#define CACHE_MAX_SECTORS (4)
+#endif
+
 #if !defined(FLASH_MEM_SEG2_START_ADDR)
 #define FLASH_MEM_SEG2_START_ADDR (0) // no second segment
 #define FLASH_MEM_SEG2_NUM_BLOCKS (0) // no second segment
@@ -110,11 +122,23 @@ extern uint8_t _flash_fs_end;
 #define FLASH_FLAG_DIRTY        (1)
 #define FLASH_FLAG_FORCE_WRITE  (2)
 #define FLASH_FLAG_ERASED       (4)
+
+// A flash sector held in the cache memory.  Only the FLASH_FLAG_DIRTY and
+// FLASH_FLAG_ERASED flags are used here; flash_flags has FLASH_FLAG_DIRTY
+// set while any sector in the cache is dirty.
+typedef struct _flash_cache_sector_t {
+    uint32_t id;
+    uint32_t start;
+    uint32_t size;
+    uint8_t *mem;
+    __IO uint8_t flags;
+} flash_cache_sector_t;
+
 static bool flash_is_initialised = false;
 static __IO uint8_t flash_flags = 0;
-static uint32_t flash_cache_sector_id;
-static uint32_t flash_cache_sector_start;
-static uint32_t flash_cache_sector_size;
+static flash_cache_sector_t flash_cache[CACHE_MAX_SECTORS];
+static __IO uint32_t flash_cache_num_sectors;
+static uint32_t flash_cache_mem_used;
 static uint32_t flash_tick_counter_last_write;
 
 static void flash_cache_flush(void) {
@@ -126,33 +150,65 @@ static void flash_cache_flush(void) {
     }
 }
 
-static uint8_t *flash_cache_get_addr_for_write(uint32_t flash_addr) {
+static flash_cache_sector_t *flash_cache_find(uint32_t flash_sector_id) {
+    for (uint32_t i = 0; i < flash_cache_num_sectors; i++) {
+        if (flash_cache[i].id == flash_sector_id) {
+            return &flash_cache[i];
+        }
+    }
+    return NULL;
+}
+
+// Returns where to write the data for flash_addr in the cache.  If len is
+// not NULL it's set to the number of bytes from there to the end of the
+// cached sector, which can all be written in one go.
+static uint8_t *flash_cache_get_addr_for_write(uint32_t flash_addr, uint32_t *len) {
     uint32_t flash_sector_start;
     uint32_t flash_sector_size;
     uint32_t flash_sector_id = flash_get_sector_info(flash_addr, &flash_sector_start, &flash_sector_size);
     if (flash_sector_size > FLASH_SECTOR_SIZE_MAX) {
         flash_sector_size = FLASH_SECTOR_SIZE_MAX;
     }
-    if (flash_cache_sector_id != flash_sector_id) {
-        flash_cache_flush();
-        memcpy((void*)CACHE_MEM_START_ADDR, (const void*)flash_sector_start, flash_sector_size);
-        flash_cache_sector_id = flash_sector_id;
-        flash_cache_sector_start = flash_sector_start;
-        flash_cache_sector_size = flash_sector_size;
+    flash_cache_sector_t *sector = flash_cache_find(flash_sector_id);
+    if (sector == NULL) {
+        // Keep the sectors already in the cache if this one fits alongside
+        // them, so that writes going back and forth between the FAT and the
+        // data don't erase and write a sector each time.  Otherwise write
+        // them all out and start again.
+        if (flash_cache_num_sectors == CACHE_MAX_SECTORS
+            || flash_cache_mem_used + flash_sector_size > CACHE_MEM_SIZE) {
+            flash_cache_flush();
+            flash_cache_num_sectors = 0;
+            flash_cache_mem_used = 0;
+        }
+        sector = &flash_cache[flash_cache_num_sectors];
+        sector->id = flash_sector_id;
+        sector->start = flash_sector_start;
+        sector->size = flash_sector_size;
+        sector->mem = (uint8_t*)CACHE_MEM_START_ADDR + flash_cache_mem_used;
+        sector->flags = 0;
+        memcpy(sector->mem, (const void*)flash_sector_start, flash_sector_size);
+        flash_cache_mem_used += flash_sector_size;
+        flash_cache_num_sectors += 1;
     }
+    sector->flags |= FLASH_FLAG_DIRTY;
     flash_flags |= FLASH_FLAG_DIRTY;
     led_state(PYB_LED_R1, 1); // indicate a dirty cache with LED on
     flash_tick_counter_last_write = HAL_GetTick();
-    return (uint8_t*)CACHE_MEM_START_ADDR + flash_addr - flash_sector_start;
+    if (len != NULL) {
+        *len = sector->start + sector->size - flash_addr;
+    }
+    return sector->mem + flash_addr - flash_sector_start;
 }
 
 static uint8_t *flash_cache_get_addr_for_read(uint32_t flash_addr) {
     uint32_t flash_sector_start;
     uint32_t flash_sector_size;
     uint32_t flash_sector_id = flash_get_sector_info(flash_addr, &flash_sector_start, &flash_sector_size);
-    if (flash_cache_sector_id == flash_sector_id) {
+    flash_cache_sector_t *sector = flash_cache_find(flash_sector_id);
+    if (sector != NULL) {
         // in cache, copy from there
-        return (uint8_t*)CACHE_MEM_START_ADDR + flash_addr - flash_sector_start;
+        return sector->mem + flash_addr - flash_sector_start;
     }
     // not in cache, copy straight from flash
     return (uint8_t*)flash_addr;
@@ -161,7 +217,8 @@ static uint8_t *flash_cache_get_addr_for_read(uint32_t flash_addr) {
 void storage_init(void) {
     if (!flash_is_initialised) {
         flash_flags = 0;
-        flash_cache_sector_id = 0;
+        flash_cache_num_sectors = 0;
+        flash_cache_mem_used = 0;
         flash_tick_counter_last_write = 0;
         flash_is_initialised = true;
     }
@@ -205,18 +262,35 @@ void storage_irq_handler(void) {
     }
     */
 
-    // This code erases the flash directly, waiting for it to finish
-    if (!(flash_flags & FLASH_FLAG_ERASED)) {
-        flash_erase(flash_cache_sector_start, (const uint32_t*)CACHE_MEM_START_ADDR, flash_cache_sector_size / 4);
-        flash_flags |= FLASH_FLAG_ERASED;
-        return;
+    // This code erases the flash directly, waiting for it to finish.  Each
+    // call erases at most one dirty sector.
+    for (uint32_t i = 0; i < flash_cache_num_sectors; i++) {
+        flash_cache_sector_t *sector = &flash_cache[i];
+        if ((sector->flags & FLASH_FLAG_DIRTY) && !(sector->flags & FLASH_FLAG_ERASED)) {
+            flash_erase(sector->start, (const uint32_t*)sector->mem, sector->size / 4);
+            sector->flags |= FLASH_FLAG_ERASED;
+            return;
+        }
     }
 
     // If not a forced write, wait at least 5 seconds after last write to flush
     // On file close and flash unmount we get a forced write, so we can afford to wait a while
     if ((flash_flags & FLASH_FLAG_FORCE_WRITE) || sys_tick_has_passed(flash_tick_counter_last_write, 5000)) {
-        // sync the cache RAM buffer by writing it to the flash page
-        flash_write(flash_cache_sector_start, (const uint32_t*)CACHE_MEM_START_ADDR, flash_cache_sector_size / 4);
+        // sync the cache RAM buffers by writing them to the flash pages, one
+        // sector per call
+        bool written = false;
+        for (uint32_t i = 0; i < flash_cache_num_sectors; i++) {
+            flash_cache_sector_t *sector = &flash_cache[i];
+            if (sector->flags & FLASH_FLAG_DIRTY) {
+                if (written) {
+                    // leave this one for the next call
+                    return;
+                }
+                flash_write(sector->start, (const uint32_t*)sector->mem, sector->size / 4);
+                sector->flags = 0;
+                written = true;
+            }
+        }
         // clear the flash flags now that we have a clean cache
         flash_flags = 0;
         // indicate a clean cache with LED off
@@ -324,7 +398,7 @@ bool storage_write_block(const uint8_t *src, uint32_t block) {
             // bad block number
             return false;
         }
-        uint8_t *dest = flash_cache_get_addr_for_write(flash_addr);
+        uint8_t *dest = flash_cache_get_addr_for_write(flash_addr, NULL);
         memcpy(dest, src, FLASH_BLOCK_SIZE);
         return true;
     }
@@ -340,10 +414,30 @@ mp_uint_t storage_read_blocks(uint8_t *dest, uint32_t block_num, uint32_t num_bl
 }
 
 mp_uint_t storage_write_blocks(const uint8_t *src, uint32_t block_num, uint32_t num_blocks) {
-    for (size_t i = 0; i < num_blocks; i++) {
-        if (!storage_write_block(src + i * FLASH_BLOCK_SIZE, block_num + i)) {
-            return 1; // error
+    while (num_blocks > 0) {
+        uint32_t flash_addr = convert_block_to_flash_addr(block_num);
+        if (block_num == 0 || flash_addr == -1) {
+            if (!storage_write_block(src, block_num)) {
+                return 1; // error
+            }
+            src += FLASH_BLOCK_SIZE;
+            block_num += 1;
+            num_blocks -= 1;
+            continue;
+        }
+
+        // copy the run of blocks that goes in the same cached sector at once
+        uint32_t len;
+        uint8_t *dest = flash_cache_get_addr_for_write(flash_addr, &len);
+        uint32_t n = 1;
+        while (n < num_blocks && (n + 1) * FLASH_BLOCK_SIZE <= len
+            && convert_block_to_flash_addr(block_num + n) == flash_addr + n * FLASH_BLOCK_SIZE) {
+            n += 1;
         }
+        memcpy(dest, src, n * FLASH_BLOCK_SIZE);
+        src += n * FLASH_BLOCK_SIZE;
+        block_num += n;
+        num_blocks -= n;
     }
     return 0; // success
 }
@@ -401,10 +495,26 @@ STATIC const mp_map_elem_t pyb_flash_locals_dict_table[] = {
 
 STATIC MP_DEFINE_CONST_DICT(pyb_flash_locals_dict, pyb_flash_locals_dict_table);
 
+STATIC mp_uint_t pyb_flash_bdev_readblocks(mp_obj_t self, uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    (void)self;
+    return storage_read_blocks(buf, block_num, num_blocks);
+}
+
+STATIC mp_uint_t pyb_flash_bdev_writeblocks(mp_obj_t self, const uint8_t *buf, uint32_t block_num, uint32_t num_blocks) {
+    (void)self;
+    return storage_write_blocks(buf, block_num, num_blocks);
+}
+
+STATIC const mp_block_dev_p_t pyb_flash_block_dev_p = {
+    .readblocks = pyb_flash_bdev_readblocks,
+    .writeblocks = pyb_flash_bdev_writeblocks,
+};
+
 const mp_obj_type_t pyb_flash_type = {
     { &mp_type_type },
     .name = MP_QSTR_Flash,
     .make_new = pyb_flash_make_new,
+    .protocol = &pyb_flash_block_dev_p,
     .locals_dict = (mp_obj_t)&pyb_flash_locals_dict,
 };
 
@@ -36,6 +36,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "usbd_cdc_msc_hid.h"
 #include "usbd_cdc_interface.h"
@@ -59,8 +60,23 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
-#define APP_RX_DATA_SIZE  1024 // I think this must be at least CDC_DATA_FS_OUT_PACKET_SIZE=64 (APP_RX_DATA_SIZE was 2048)
-#define APP_TX_DATA_SIZE  1024 // I think this can be any value (was 2048)
+// The sizes of the rx and tx buffers can be set by a board.  The rx buffer
+// must hold at least two CDC_DATA_FS_MAX_PACKET_SIZE=64 packets, and the tx
+// buffer size must be a power of 2.  Bigger buffers let bulk transfers keep
+// going for longer without the Python code having to keep up.
+#ifndef MICROPY_HW_USB_CDC_RX_DATA_SIZE
+#define MICROPY_HW_USB_CDC_RX_DATA_SIZE (1024)
+#endif
+#ifndef MICROPY_HW_USB_CDC_TX_DATA_SIZE
+#define MICROPY_HW_USB_CDC_TX_DATA_SIZE (1024)
+#endif
+
+#define APP_RX_DATA_SIZE  MICROPY_HW_USB_CDC_RX_DATA_SIZE
+#define APP_TX_DATA_SIZE  MICROPY_HW_USB_CDC_TX_DATA_SIZE
+
+#if APP_TX_DATA_SIZE & (APP_TX_DATA_SIZE - 1)
+#error "MICROPY_HW_USB_CDC_TX_DATA_SIZE must be a power of 2"
+#endif
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
@@ -69,7 +85,8 @@ static __IO uint8_t dev_is_connected = 0; // indicates if we are connected
 
 static uint8_t UserRxBuffer[APP_RX_DATA_SIZE]; // received data from USB OUT endpoint is stored in this buffer
 static uint16_t UserRxBufCur = 0; // points to next available character in UserRxBuffer
-static uint16_t UserRxBufLen = 0; // counts number of valid characters in UserRxBuffer
+static __IO uint16_t UserRxBufLen = 0; // counts number of valid characters in UserRxBuffer
+static __IO uint8_t UserRxPaused = 0; // set when UserRxBuffer has no room for another packet
 
 static uint8_t UserTxBuffer[APP_TX_DATA_SIZE]; // data for USB IN endpoind is stored in this buffer
 static uint16_t UserTxBufPtrIn = 0; // increment this pointer modulo APP_TX_DATA_SIZE when new data is available
@@ -146,6 +163,7 @@ static int8_t CDC_Itf_Init(void)
 
     UserRxBufCur = 0;
     UserRxBufLen = 0;
+    UserRxPaused = 0;
   
     /* NOTE: we cannot reset these here, because USBD_CDC_SetInterrupt
      * may be called before this init function to set these values.
@@ -367,12 +385,15 @@ static int8_t CDC_Itf_Receive(uint8_t* Buf, uint32_t *Len) {
         delta_len = dest - Buf;
     }
 
-    if (UserRxBufLen + delta_len + CDC_DATA_FS_MAX_PACKET_SIZE > APP_RX_DATA_SIZE) {
-        // if we keep this data then the buffer can overflow on the next USB rx
-        // so we don't increment the length, and throw this data away
-    } else {
-        // data fits, leaving room for another CDC_DATA_FS_OUT_PACKET_SIZE
-        UserRxBufLen += delta_len;
+    // the data always fits, the endpoint is only armed with room for a packet
+    UserRxBufLen += delta_len;
+
+    if (UserRxBufLen + CDC_DATA_FS_MAX_PACKET_SIZE > APP_RX_DATA_SIZE) {
+        // No room for another packet.  Leave the endpoint unarmed so the
+        // host holds on to its data (the endpoint NAKs) instead of it being
+        // thrown away, until USBD_CDC_Rx makes room and rearms it.
+        UserRxPaused = 1;
+        return USBD_OK;
     }
 
     // initiate next USB packet transfer, to append to existing data in buffer
@@ -382,6 +403,28 @@ static int8_t CDC_Itf_Receive(uint8_t* Buf, uint32_t *Len) {
     return USBD_OK;
 }
 
+// Called after data is taken out of UserRxBuffer.  If reception was paused
+// and there is now room for a packet, move the remaining data to the start
+// of the buffer and rearm the endpoint.  No rx interrupt can come while
+// paused, but IRQs are disabled anyway since the USB driver is used.
+static void cdc_rx_resume(void) {
+    if (!UserRxPaused) {
+        return;
+    }
+    uint32_t remaining = UserRxBufLen - UserRxBufCur;
+    if (remaining + CDC_DATA_FS_MAX_PACKET_SIZE > APP_RX_DATA_SIZE) {
+        return;
+    }
+    mp_uint_t irq_state = disable_irq();
+    memmove(UserRxBuffer, UserRxBuffer + UserRxBufCur, remaining);
+    UserRxBufCur = 0;
+    UserRxBufLen = remaining;
+    UserRxPaused = 0;
+    USBD_CDC_SetRxBuffer(&hUSBDDevice, UserRxBuffer + UserRxBufLen);
+    USBD_CDC_ReceivePacket(&hUSBDDevice);
+    enable_irq(irq_state);
+}
+
 int USBD_CDC_IsConnected(void) {
     return dev_is_connected;
 }
@@ -402,7 +445,7 @@ int USBD_CDC_TxHalfEmpty(void) {
 // timout in milliseconds.
 // Returns number of bytes written to the device.
 int USBD_CDC_Tx(const uint8_t *buf, uint32_t len, uint32_t timeout) {
-    for (uint32_t i = 0; i < len; i++) {
+    for (uint32_t i = 0; i < len;) {
         // Wait until the device is connected and the buffer has space, with a given timeout
         uint32_t start = HAL_GetTick();
         while (!dev_is_connected || ((UserTxBufPtrIn + 1) & (APP_TX_DATA_SIZE - 1)) == UserTxBufPtrOut) {
@@ -418,9 +461,22 @@ int USBD_CDC_Tx(const uint8_t *buf, uint32_t len, uint32_t timeout) {
             __WFI(); // enter sleep mode, waiting for interrupt
         }
 
-        // Write data to device buffer
-        UserTxBuffer[UserTxBufPtrIn] = buf[i];
-        UserTxBufPtrIn = (UserTxBufPtrIn + 1) & (APP_TX_DATA_SIZE - 1);
+        // Copy as much data as fits in one go, up to the end of the buffer
+        // or to one before the out pointer, which would mean an empty buffer
+        uint32_t ptr_in = UserTxBufPtrIn;
+        uint32_t ptr_out = UserTxBufPtrOut;
+        uint32_t n;
+        if (ptr_in >= ptr_out) {
+            n = APP_TX_DATA_SIZE - ptr_in - (ptr_out == 0);
+        } else {
+            n = ptr_out - ptr_in - 1;
+        }
+        if (n > len - i) {
+            n = len - i;
+        }
+        memcpy(UserTxBuffer + ptr_in, buf + i, n);
+        UserTxBufPtrIn = (ptr_in + n) & (APP_TX_DATA_SIZE - 1);
+        i += n;
     }
 
     // Success, return number of bytes read
@@ -482,7 +538,7 @@ int USBD_CDC_RxNum(void) {
 // Returns number of bytes read from the device.
 int USBD_CDC_Rx(uint8_t *buf, uint32_t len, uint32_t timeout) {
     // loop to read bytes
-    for (uint32_t i = 0; i < len; i++) {
+    for (uint32_t i = 0; i < len;) {
         // Wait until we have at least 1 byte to read
         uint32_t start = HAL_GetTick();
         while (UserRxBufLen == UserRxBufCur) {
@@ -498,8 +554,15 @@ int USBD_CDC_Rx(uint8_t *buf, uint32_t len, uint32_t timeout) {
             __WFI(); // enter sleep mode, waiting for interrupt
         }
 
-        // Copy byte from device to user buffer
-        buf[i] = UserRxBuffer[UserRxBufCur++];
+        // Copy all the bytes available, up to len, from device to user buffer
+        uint32_t n = UserRxBufLen - UserRxBufCur;
+        if (n > len - i) {
+            n = len - i;
+        }
+        memcpy(buf + i, UserRxBuffer + UserRxBufCur, n);
+        UserRxBufCur += n;
+        i += n;
+        cdc_rx_resume();
     }
 
     // Success, return number of bytes read
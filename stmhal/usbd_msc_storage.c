@@ -38,6 +38,7 @@
 
 #include "py/misc.h"
 #include "lib/fatfs/diskio.h"
+#include "extmod/fsusermount.h"
 #include "storage.h"
 #include "sdcard.h"
 
@@ -316,6 +317,10 @@ int8_t SDCARD_STORAGE_Read(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_
   * @retval Status
   */
 int8_t SDCARD_STORAGE_Write(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len) {
+    #if MICROPY_VFS_FAT_IMPORT_CACHE
+    // The host bypasses disk_write here.
+    fat_vfs_import_cache_clear();
+    #endif
     if (sdcard_write_blocks(buf, blk_addr, blk_len) != 0) {
         return -1;
     }
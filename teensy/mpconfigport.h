@@ -13,6 +13,7 @@
 #define MICROPY_LONGINT_IMPL        (MICROPY_LONGINT_IMPL_MPZ)
 #define MICROPY_FLOAT_IMPL          (MICROPY_FLOAT_IMPL_FLOAT)
 #define MICROPY_OPT_COMPUTED_GOTO   (1)
+#define MICROPY_PY_MICROPYTHON_CYCLES (1)
 
 #define MICROPY_PY_IO               (0)
 #define MICROPY_PY_FROZENSET        (1)
@@ -11,6 +11,16 @@ mp_uint_t mp_hal_ticks_ms(void) {
   return millis();
 }
 
+mp_uint_t mp_hal_ticks_cpu(void) {
+  // the DWT cycle counter is started the first time it's read
+  if (!(ARM_DWT_CTRL & ARM_DWT_CTRL_CYCCNTENA)) {
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CYCCNT = 0;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  }
+  return ARM_DWT_CYCCNT;
+}
+
 void mp_hal_delay_ms(mp_uint_t ms) {
   delay(ms);
 }
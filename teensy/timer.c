@@ -143,7 +143,7 @@ STATIC uint32_t compute_pwm_value_from_percent(uint32_t period, mp_obj_t percent
     uint32_t cmp;
     if (0) {
     #if MICROPY_PY_BUILTINS_FLOAT
-    } else if (MP_OBJ_IS_TYPE(percent_in, &mp_type_float)) {
+    } else if (mp_obj_is_float(percent_in)) {
         float percent = mp_obj_get_float(percent_in);
         if (percent <= 0.0) {
             cmp = 0;
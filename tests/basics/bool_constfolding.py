@@ -0,0 +1,36 @@
+# tests folding of comparisons, not, and, or and tuples of constants in compiler
+
+# comparisons
+print(1 < 2, 2 < 1, 1 > 2, 1 == 1, 1 != 1, 1 <= 1, 2 >= 3)
+print(1 < 2 < 3, 1 < 3 < 2, 3 > 2 > 1 == 1)
+print(-1 < 0, 1 << 70 > 1 << 69)
+
+# not
+print(not 0, not 1, not None, not True, not False, not (1 < 2))
+
+# and/or with leading constants
+x = 5
+print(0 and x, 1 and x, 0 or x, 1 or x, None or x, True and x)
+print(1 and 2 and x, 0 or 0 or x, 1 and 0 and x, 0 or 2 or x)
+print(1 and 2, 0 or 0, 1 and 0, x and 0, x or 0)
+
+# conditional expressions
+print('a' if 1 else 'b', 'a' if 0 else 'b', 'a' if 1 < 2 else 'b')
+
+# conditions of statements
+if 2 > 1 and not 0:
+    print('if')
+if 0 or 1 < 0:
+    print('not printed')
+else:
+    print('else')
+while 1 > 2:
+    print('not printed')
+
+# tuples of constants
+t = (1, 'a', None, True, False, (2, (3,)), -4, 1 << 70)
+print(t, len(t))
+print((1,), (x, 1), (1, x), (1, 2) + (3,), (1, 2) == (1, 2))
+print(1 in (1, 2), 3 not in (1, 2))
+for i in (1, 2, 3):
+    print(i)
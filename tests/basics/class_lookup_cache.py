@@ -0,0 +1,67 @@
+# methods found in base classes must follow changes to the classes
+
+class A:
+    def f(self):
+        return 'A.f'
+
+class B(A):
+    pass
+
+class C(B):
+    pass
+
+c = C()
+for i in range(2):
+    print(c.f())
+
+# replace the method in the base
+A.f = lambda self: 'new A.f'
+print(c.f())
+
+# shadow it in an intermediate class
+B.f = lambda self: 'B.f'
+print(c.f())
+
+# and remove that again
+del B.f
+print(c.f())
+
+# an attribute that wasn't found before
+print(hasattr(c, 'g'))
+B.g = 1
+print(c.g)
+
+# special methods
+class D(C):
+    pass
+d = D()
+try:
+    d + 1
+except TypeError:
+    print('TypeError')
+A.__add__ = lambda self, other: other + 1
+print(d + 1)
+
+# __getattr__ added later
+try:
+    d.missing
+except AttributeError:
+    print('AttributeError')
+B.__getattr__ = lambda self, name: name
+print(d.missing)
+
+# super() sees the changes as well
+class E(A):
+    def f(self):
+        return 'E.f ' + super().f()
+e = E()
+print(e.f())
+A.f = lambda self: 'A.f again'
+print(e.f())
+
+# classes created later in place of freed ones
+for i in range(3):
+    class F:
+        def h(self):
+            return i
+    print(F().h())
@@ -0,0 +1,70 @@
+# instances of a class that set the same attributes share their names
+
+class A:
+    def __init__(self, a, b):
+        self.a = a
+        self.b = b
+
+l = [A(i, -i) for i in range(5)]
+print([(o.a, o.b) for o in l])
+
+# attributes set in another order, deleted and added again
+o = A(1, 2)
+del o.a
+print(hasattr(o, 'a'), o.b)
+o.a = 3
+print(o.a, o.b)
+try:
+    del o.a
+    del o.a
+except AttributeError:
+    print('AttributeError')
+
+# extra attributes on some instances only
+o = A(1, 2)
+o.c = 3
+p = A(4, 5)
+print(o.c, hasattr(p, 'c'))
+p.d = 6
+print(sorted(p.__dict__.items()), sorted(o.__dict__.items()))
+print(A(7, 8).b)
+
+# many attributes
+class B:
+    pass
+
+for j in range(3):
+    o = B()
+    for i in range(20):
+        setattr(o, 'x%d' % i, i + j)
+    print(sum(getattr(o, 'x%d' % i) for i in range(20)))
+    del o.x3
+    print(hasattr(o, 'x3'), o.x19)
+
+# a subclass has names of its own
+class C(A):
+    def __init__(self):
+        self.z = 0
+        A.__init__(self, 1, 2)
+
+for i in range(3):
+    o = C()
+    o.z += i
+    print(o.z, o.a, o.b)
+
+# instance attributes in a loop, exercising the VM caches
+class D:
+    def __init__(self):
+        self.n = 0
+    def inc(self):
+        self.n = self.n + 1
+
+ds = [D() for i in range(3)]
+for i in range(10):
+    for d in ds:
+        d.inc()
+ds[1].other = 1
+for i in range(10):
+    for d in ds:
+        d.inc()
+print([d.n for d in ds])
@@ -0,0 +1,80 @@
+# test __slots__
+
+class T:
+    __slots__ = ()
+try:
+    T().a = 1
+    print("SKIP")
+    import sys
+    sys.exit()
+except AttributeError:
+    pass
+
+class A:
+    __slots__ = ('x', 'y')
+    def __init__(self, x):
+        self.x = x
+
+a = A(1)
+print(a.x, hasattr(a, 'y'))
+a.y = 2
+print(a.x + a.y)
+try:
+    a.z = 3
+except AttributeError:
+    print('AttributeError')
+del a.y
+print(hasattr(a, 'y'))
+try:
+    del a.y
+except AttributeError:
+    print('AttributeError')
+
+# a single name
+class B:
+    __slots__ = 'v'
+b = B()
+b.v = 4
+print(b.v)
+try:
+    b.w = 5
+except AttributeError:
+    print('AttributeError')
+
+# slots are inherited
+class C(A):
+    __slots__ = ['z']
+c = C(5)
+c.y = 6
+c.z = 7
+print(c.x, c.y, c.z)
+try:
+    c.w = 8
+except AttributeError:
+    print('AttributeError')
+
+# a subclass without __slots__ can have other attributes
+class D(A):
+    pass
+for i in range(3):
+    d = D(i)
+    d.w = 9
+    print(d.x, d.w)
+
+# '__dict__' in __slots__ allows other attributes
+class E:
+    __slots__ = ('a', '__dict__')
+e = E()
+e.a = 1
+e.b = 2
+print(e.a, e.b)
+
+# class attributes and methods are still found
+class F:
+    __slots__ = ('n',)
+    k = 10
+    def get(self):
+        return self.n + self.k
+f = F()
+f.n = 1
+print(f.get())
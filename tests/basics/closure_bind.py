@@ -0,0 +1,75 @@
+# test closures over variables bound once, and over those bound again
+
+# params and locals bound once, before the closure is made
+def f(a, b):
+    c = a + b
+    def g():
+        return a, c
+    return g
+print(f(1, 2)())
+
+# closed over through a scope that doesn't use the variable
+def deep(a):
+    def m():
+        def n():
+            return a
+        return n
+    return m()()
+print(deep(7))
+
+# bound in a loop, or by a comprehension, so all closures see the last value
+def loop():
+    fs = []
+    for i in range(3):
+        fs.append(lambda: i)
+    return [x() for x in fs]
+print(loop())
+def loop_while():
+    fs = []
+    n = 0
+    while n < 3:
+        v = n * 10
+        fs.append(lambda: v)
+        n += 1
+    return [x() for x in fs]
+print(loop_while())
+print([f() for f in [lambda: i for i in range(3)]])
+
+# bound after the closure is made
+def late():
+    def g():
+        return x
+    x = 5
+    return g()
+print(late())
+def rec():
+    def g(n):
+        return n if n < 1 else g(n - 1)
+    return g(3)
+print(rec())
+def same_stmt():
+    x = lambda: x
+    return x() is x
+print(same_stmt())
+
+# params bound again, before or after the closure is made
+def param_before(a):
+    a = a + 1
+    return lambda: a
+print(param_before(1)())
+def param_after(a):
+    g = lambda: a
+    a = 2
+    return g()
+print(param_after(1))
+
+# bound again through nonlocal
+def nl():
+    x = 1
+    def s():
+        nonlocal x
+        x = 2
+    g = lambda: x
+    s()
+    return g()
+print(nl())
@@ -0,0 +1,46 @@
+# test closures over variables that may be unbound when the closure is made
+
+# bound in only one branch
+def cond(c):
+    if c:
+        x = 1
+    return lambda: x
+print(cond(True)())
+g = cond(False)
+try:
+    g()
+except NameError:
+    print('NameError')
+
+# bound in a try, with or loop else body that doesn't run to the end
+def tr():
+    try:
+        raise ValueError
+        x = 1
+    except ValueError:
+        pass
+    return lambda: x
+def wh(n):
+    while n:
+        n -= 1
+    else:
+        if n:
+            x = 2
+    return lambda: x
+for f in (tr, lambda: wh(0)):
+    g = f()
+    try:
+        g()
+    except NameError:
+        print('NameError')
+
+# deleted
+def dl():
+    x = 1
+    g = lambda: x
+    del x
+    try:
+        g()
+    except NameError:
+        print('NameError')
+dl()
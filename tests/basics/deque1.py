@@ -0,0 +1,70 @@
+try:
+    from collections import deque
+except ImportError:
+    try:
+        from ucollections import deque
+    except ImportError:
+        print("SKIP")
+        import sys
+        sys.exit()
+
+d = deque()
+print(d, len(d), bool(d))
+d.append(1)
+d.append(2)
+d.appendleft(0)
+print(d, len(d), bool(d))
+print(d[0], d[-1], list(d))
+d[1] = 10
+print(d.pop(), d.popleft(), d)
+print(d.pop(), d)
+try:
+    d.pop()
+except IndexError:
+    print('IndexError')
+try:
+    d.popleft()
+except IndexError:
+    print('IndexError')
+
+# as a queue, wrapping around the buffer
+d = deque([1, 2, 3])
+total = 0
+for i in range(100):
+    d.append(i)
+    d.append(-i)
+    total += d.popleft()
+print(len(d), total, d[0], d[-1])
+while len(d) > 2:
+    d.pop()
+print(d)
+
+# extend at both ends
+d = deque('ab')
+d.extend('cd')
+d.extendleft('yz')
+print(d)
+d.clear()
+print(d)
+
+# maxlen evicts from the other end
+d = deque((), 3)
+for i in range(5):
+    d.append(i)
+print(d)
+d.appendleft(-1)
+print(d)
+d = deque(range(10), maxlen=2)
+print(d, list(d))
+d = deque([1, 2], 0)
+d.append(3)
+print(d)
+try:
+    deque((), -1)
+except ValueError:
+    print('ValueError')
+
+try:
+    d[0]
+except IndexError:
+    print('IndexError')
@@ -0,0 +1,54 @@
+# test dicts that grow, shrink and have keys deleted and re-added
+
+# small and large dicts of qstr keys
+for n in (3, 8, 9, 40, 300):
+    d = {}
+    for i in range(n):
+        d['k%d' % i] = i
+    for i in range(0, n, 2):
+        del d['k%d' % i]
+    for i in range(0, n, 4):
+        d['k%d' % i] = -i
+    print(n, len(d), sorted(d.items())[:4], 'k1' in d, 'k2' in d, 'k4' in d)
+
+# repeatedly delete and re-add keys in a full dict
+d = {i: i for i in range(12)}
+for i in range(100):
+    del d[i % 12]
+    d[i % 12] = i
+print(len(d), sorted(d.values()))
+
+# mixed keys, lookups of missing keys, and keys that compare equal
+d = {1: 'a', 'b': 2, (3, 4): 5}
+print(d[1], d['b'], d[(3, 4)], d.get('x'), 5 in d)
+d[True] = 't'
+print(len(d), d[1])
+for k in list(d):
+    del d[k]
+print(d, len(d))
+
+# copies are independent
+d = {i: i for i in range(20)}
+d2 = d.copy()
+del d2[5]
+d2[99] = 0
+print(len(d), len(d2), 5 in d, 99 in d, sorted(d2)[-3:])
+
+# unhashable keys are rejected
+for d in ({}, {1: 2}, {i: i for i in range(20)}):
+    try:
+        d[[1]] = 0
+    except TypeError:
+        print('TypeError')
+
+# a dict with mostly deleted entries is compacted back to a small one
+for n in (8, 12, 20):
+    d = {'a': 1, 'b': 2}
+    for i in range(n):
+        d[i] = i
+    for i in range(n):
+        del d[i]
+    for i in range(n):
+        d[i] = -i
+        del d[i]
+    print(n, sorted(d.items()), 'a' in d, d['b'])
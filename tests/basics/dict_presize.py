@@ -0,0 +1,42 @@
+# dicts and sets presized from the length of their source
+
+# dict from a sized iterable of pairs, with and without keywords
+d = dict([(i, i * i) for i in range(50)])
+print(len(d), d[0], d[49], 50 in d)
+d = dict([(1, 2), (3, 4)], a=5)
+print(sorted(d.items(), key=repr))
+d = dict({i: i for i in range(30)}, x=1)
+print(len(d), d[29], d['x'])
+
+# duplicate keys mean fewer entries than the length of the source
+d = dict([(1, 2)] * 20)
+print(d)
+d[3] = 4
+print(sorted(d.items()))
+
+# set from a sized iterable
+s = set(range(100))
+print(len(s), 0 in s, 99 in s, 100 in s, -1 in s)
+s = set([1] * 50)
+print(s)
+s.add(2)
+print(sorted(s))
+s = frozenset(range(20))
+print(type(s).__name__, len(s), 19 in s)
+s = set("abcabc")
+print(sorted(s))
+
+# dict comprehensions over range with constant arguments
+d = {i: i for i in range(100)}
+print(len(d), d[0], d[99])
+print({i: 0 for i in range(0)})
+print({i: 0 for i in range(5, 1)})
+print(sorted({i: 0 for i in range(10, 0, -3)}))
+print(sorted({i: 0 for i in range(1, 10, 4)}))
+print(sorted({i % 3: i for i in range(10)}.items()))
+print(len({i: i for i in range(2000)}))
+
+# a redefined range only gives a wrong hint, not a wrong result
+def range(n):
+    return [1, 2]
+print({i: i for i in range(100)})
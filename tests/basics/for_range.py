@@ -61,3 +61,62 @@ try:
         print(x)
 except TypeError:
     print('TypeError')
+
+# step that isn't a constant, including negative and zero
+def f(start, stop, step):
+    l = []
+    for x in range(start, stop, step):
+        l.append(x)
+    return l
+print(f(0, 10, 3), f(10, 0, -3), f(0, 0, 1), f(5, 0, 1), f(-5, 5, 5))
+try:
+    f(0, 5, 0)
+except ValueError:
+    print('ValueError')
+
+# arguments that aren't ints
+for args in ((0, 1.5, 1), (0.5, 1, 1), ('a', 1, 1)):
+    try:
+        f(*args)
+    except TypeError:
+        print('TypeError')
+print(f(False, 3, True))
+
+# break, continue and else, and the loop variable afterwards
+for x in range(5):
+    if x == 1:
+        continue
+    if x == 3:
+        break
+    print(x)
+else:
+    print('else')
+print(x)
+for x in range(2, 4):
+    pass
+else:
+    print('else', x)
+
+# nested, and in a generator
+for x in range(-2, 3):
+    for y in range(x, 0, -1):
+        print(x, y)
+def gen(n):
+    for x in range(n):
+        yield x
+print(list(gen(4)))
+
+# values near the limit of small ints, where the next value doesn't fit
+import sys
+m = sys.maxsize >> 1
+print(f(m - 4, m, 3) == [m - 4, m - 1])
+print(f(-m + 2, -m - 1, -2) == [-m + 2, -m])
+
+# long-int bounds, which count with long-int arithmetic
+b = 1 << 62
+for x in range(b - 2, b + 2):
+    print(x)
+for x in range(b + 1, b - 3, -2):
+    print(x)
+for x in range(-b - 1, -b + 1):
+    print(x)
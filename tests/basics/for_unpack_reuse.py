@@ -0,0 +1,60 @@
+# test for loops that unpack the tuples made by enumerate, zip and dict.items
+
+d = {'a': 1, 'b': 2, 'c': 3}
+for k, v in sorted(d.items()):
+    print(k, v)
+acc = []
+for k, v in d.items():
+    acc.append((k, v))
+print(sorted(acc))
+
+# nested, and keeping some of the items
+saved = []
+for i, x in enumerate('abc'):
+    for j, (y, z) in enumerate(zip('de', [[i], [i + 1]])):
+        saved.append((i, x, j, y, z))
+print(saved)
+
+# tuples that are kept are not reused
+kept = [t for t in enumerate('xyz')]
+for i, t in enumerate(kept):
+    print(i, t)
+pairs = list(zip(range(3), range(3, 6)))
+for a, b in pairs:
+    print(a, b, pairs)
+
+# zip of three, and zip that stops part way through making a tuple
+for a, b, c in zip([1, 2], 'pq', (None, True)):
+    print(a, b, c)
+for a, b in zip(range(5), iter([7, 8])):
+    print(a, b)
+for a, b in zip(range(2), range(2)):
+    print((a, b), (b, a))
+
+# unpacking the wrong number of items
+try:
+    for a, b, c in enumerate('ab'):
+        pass
+except ValueError:
+    print('ValueError')
+
+# break and continue
+for i, x in enumerate(range(10, 20)):
+    if i % 2:
+        continue
+    if i > 6:
+        break
+    print(i, x)
+
+# tuples stored in a dict as keys or values belong to the dict
+dk = {(1, 2): 'x', (3, 4): 'y'}
+for a, b in dk.keys():
+    t = (a + 6, b + 6)
+print(sorted(dk.items()))
+dv = {'k': (10, 20), 'l': (30, 40)}
+for a, b in dv.values():
+    t = (a + 1, b + 1)
+print(sorted(dv.items()))
+for k, (a, b) in dv.items():
+    t = (a - 5, b - 5)
+print(sorted(dv.items()))
@@ -33,3 +33,21 @@ try:
     f3(1, 2, 3, 4, a=5)
 except TypeError:
     print("TypeError")
+
+# keyword names given in, out of and partially out of declaration order
+def f4(a, b, c, *, d=4, e=5):
+    print(a, b, c, d, e)
+
+f4(a=1, b=2, c=3)
+f4(c=3, b=2, a=1)
+f4(1, c=3, b=2)
+f4(b=2, c=3, a=1, e=6)
+f4(1, 2, e=6, c=3, d=7)
+try:
+    f4(1, 2, c=3, b=4)
+except TypeError:
+    print("TypeError")
+try:
+    f4(b=2, c=3)
+except TypeError:
+    print("TypeError")
@@ -28,3 +28,13 @@ if hasattr(gc, 'threshold'):
     assert(gc.threshold() == 0)
     assert(gc.threshold(-1) is None)
     assert(gc.threshold() == -1)
+
+if hasattr(gc, 'incremental'):
+    # uPy has this extra function
+    # check execution and returns
+    q = gc.incremental()
+    assert(gc.incremental(16) is None)
+    assert(gc.incremental() == 16)
+    assert(gc.incremental(-1) is None)
+    assert(gc.incremental() == 0)
+    gc.incremental(q)
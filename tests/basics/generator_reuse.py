@@ -0,0 +1,47 @@
+# test that finished generators behave, while new ones are made and run
+
+def gen(n):
+    for i in range(n):
+        yield i
+    return n
+
+# finish generators of the same and of different sizes in turn, each made
+# after the previous one finished
+for i in range(5):
+    print(sum(x for x in range(i)), list(gen(i)), [y * 2 for y in (z for z in 'ab')])
+
+# a finished generator can still be used, after others have run
+g = gen(2)
+print(list(g))
+h = gen(3)
+print(next(h))
+print(list(g))
+for x in h:
+    print(x)
+g.close()
+try:
+    g.send(None)
+except StopIteration:
+    print('StopIteration')
+print(repr(g)[:17])
+
+# generators finished by return, exception and close
+def gen_exc():
+    yield 1
+    raise KeyError(2)
+g1 = gen(1)
+g2 = gen_exc()
+g3 = gen(10)
+next(g1)
+next(g2)
+next(g3)
+try:
+    next(g1)
+except StopIteration as e:
+    print('StopIteration', e.args)
+try:
+    next(g2)
+except KeyError as e:
+    print('KeyError', e.args)
+g3.close()
+print(list(gen(4)), list(g1), list(g2), list(g3))
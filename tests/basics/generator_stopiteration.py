@@ -0,0 +1,49 @@
+# StopIteration on exhaustion, with and without a generator's return value
+
+def gen():
+    yield 1
+    return 42
+
+# iteration drops the return value
+for x in gen():
+    print(x)
+print(list(gen()), tuple(gen()))
+
+# next() and send() keep it
+g = gen()
+print(next(g))
+try:
+    next(g)
+except StopIteration as e:
+    print('value', e.value, e.args)
+try:
+    next(g)
+except StopIteration as e:
+    print('value', e.value, e.args)
+
+g = gen()
+print(g.send(None))
+try:
+    g.send(None)
+except StopIteration as e:
+    print('value', e.value)
+try:
+    g.send(None)
+except StopIteration as e:
+    print('value', e.value, e.args)
+
+# and so does yield from
+def delegate():
+    r = yield from gen()
+    print('return', r)
+print(list(delegate()))
+
+# exhausted iterators that aren't generators
+try:
+    next(iter([]))
+except StopIteration as e:
+    print(repr(e), e.args, e.value)
+try:
+    next(iter(range(0)))
+except StopIteration as e:
+    print(e.args)
@@ -0,0 +1,25 @@
+# test multiplication, pow() with a modulus and conversion to str of large ints
+
+# products large enough to use the fast multiplication algorithm
+a = 7 ** 1500
+b = 3 ** 2000 + 1
+print(a * b % 1000000007)
+print((a * b) // b == a)
+print(-a * b == -(a * b))
+print((a * a) % (10 ** 20))
+print((a * 12345) % 1000000007)
+
+# conversion of large ints to strings
+print(str(a)[:30], str(a)[-30:], len(str(a)))
+print(hex(b)[:30], hex(b)[-30:])
+print(str(-10 ** 50))
+print('{:,}'.format(10 ** 30 + 123))
+
+# 3 arg pow with large values, odd and even moduli
+m = 2 ** 521 - 1
+print(pow(3, m - 1, m))
+print(pow(12345678901234567890, 98765432109876543210, m))
+print(pow(a, 65537, 2 ** 200))
+print(pow(-3, 1001, 10 ** 30 + 7))
+print(pow(5, 0, m))
+print(pow(5, 100, 1))
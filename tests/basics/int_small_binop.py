@@ -0,0 +1,49 @@
+# test binary ops on local small ints, and with small-int constants,
+# including values at the boundaries of the small-int range
+
+def f(a, b):
+    print(a + b, a - b, b - a)
+    print(a < b, a > b, a == b, a <= b, a >= b, a != b)
+    print(a + 1, a - 1, a * 2, a // 3, a % 5, a < 4, a == -1)
+    a += 20
+    a -= 300
+    print(a)
+
+f(1, 2)
+f(-5, 5)
+f(7, 7)
+f(0, -1)
+
+# results that may not fit in a small int on 32- or 64-bit machines
+for a in (0x3fffffff, -0x40000000, 0x3fffffffffffffff, -0x4000000000000000):
+    f(a, 1)
+    f(a, -1)
+    f(1, a)
+    f(a, a)
+
+# other types go through the generic path
+f(1.5, 2)
+f(1, True)
+print([1] + [2], (1,) + (2,) * 2)
+
+def g(x):
+    i = 0
+    while i < x:
+        i += 1
+    return i
+
+print(g(0), g(10))
+
+# two locals loaded together, either one unbound
+def h(n):
+    if n == 0:
+        a = 1
+    if n == 1:
+        b = 2
+    return a + b
+
+for n in range(3):
+    try:
+        h(n)
+    except NameError:
+        print('NameError', n)
@@ -0,0 +1,34 @@
+# lists that grow and shrink a lot
+
+# used as a queue
+q = []
+for i in range(1000):
+    q.append(i)
+    q.append(-i)
+    q.pop(0)
+print(len(q), q[0], q[-1])
+while len(q) > 3:
+    q.pop(0)
+print(q)
+
+# deleting and replacing slices
+l = list(range(100))
+del l[10:95]
+print(l)
+l[2:] = []
+print(l)
+l[1:1] = list(range(50))
+print(len(l), l[:3], l[-2:])
+l[:40] = [0]
+print(len(l), l)
+
+# extend with lists and other iterables
+l = []
+for i in range(20):
+    l.extend([i] * i)
+    l += (i,)
+print(len(l), sum(l))
+
+# list from objects with a length
+print(list(range(5)), list((1, 2)), list('ab'), list({3: 4}))
+print(list(x for x in range(3)))
@@ -0,0 +1,58 @@
+# test that list.sort is stable, and other properties of its merge sort
+
+# equal keys keep their order, also when reversed
+l = [(i % 3, i) for i in range(12)]
+print(sorted(l, key=lambda x: x[0]))
+print(sorted(l, key=lambda x: x[0], reverse=True))
+
+# long lists, so that runs are found and merged
+seed = [1]
+def rnd(n):
+    seed[0] = (seed[0] * 1103515245 + 12345) & 0x7fffffff
+    return seed[0] % n
+
+for n in (33, 64, 100, 300):
+    cases = (
+        [rnd(10) for _ in range(n)],
+        list(range(n)),
+        list(range(n, 0, -1)),
+        list(range(n // 2)) + list(range(n // 2, 0, -1)),
+        [i % 7 for i in range(n)],
+    )
+    for c in cases:
+        pairs = [(v, i) for i, v in enumerate(c)]
+        for rev in (False, True):
+            s = sorted(pairs, key=lambda p: p[0], reverse=rev)
+            ok = all(s[i][0] == s[i + 1][0] and s[i][1] < s[i + 1][1]
+                or (s[i][0] > s[i + 1][0] if rev else s[i][0] < s[i + 1][0])
+                for i in range(len(s) - 1))
+            print(n, rev, ok, sorted(c, reverse=rev) == [p[0] for p in s])
+
+# the key function is called once for each item
+calls = [0]
+def key(x):
+    calls[0] += 1
+    return -x
+l = list(range(50))
+l.sort(key=key)
+print(calls[0], l[:3])
+
+# an exception from a comparison leaves all the items in the list
+class A:
+    n = 0
+    def __init__(self, x):
+        self.x = x
+    def __lt__(self, other):
+        A.n += 1
+        if A.n == A.limit:
+            raise ValueError
+        return self.x < other.x
+for limit in (5, 60, 300):
+    A.n = 0
+    A.limit = limit
+    l = [A(i * 37 % 101) for i in range(101)]
+    try:
+        l.sort()
+    except ValueError:
+        print('ValueError')
+    print(sorted(a.x for a in l) == list(range(101)))
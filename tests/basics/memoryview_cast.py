@@ -0,0 +1,36 @@
+# test memoryview.cast
+try:
+    memoryview(b'').cast
+except (NameError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+import array
+
+# reinterpret bytes in place
+b = bytearray(b'\x01\x00\x02\x00\xff\xff\x00\x80')
+m = memoryview(b).cast('h')
+print(len(m), list(m))
+m[0] = 0x102
+print(b)
+print(list(memoryview(b)[2:].cast('h')))
+print(list(memoryview(b).cast('B')[:2]))
+print(list(memoryview(array.array('h', [1, 2])).cast('b')))
+print(list(memoryview(b'\x01\x02').cast('b')))
+
+# read-only source stays read-only
+m = memoryview(b'\x01\x02').cast('B')
+try:
+    m[0] = 0
+except TypeError:
+    print('TypeError')
+
+# sizes must be a multiple of the new item size
+try:
+    memoryview(b'abc').cast('h')
+except TypeError:
+    print('TypeError')
+try:
+    memoryview(b'ab').cast('x')
+except ValueError:
+    print('ValueError')
@@ -0,0 +1,55 @@
+# test that operations give the right result when the same bytecode sees
+# arguments of different types over time
+
+def add(a, b):
+    return a + b
+
+def lt(a, b):
+    return a < b
+
+def iadd(a, b):
+    a += b
+    return a
+
+for args in ((1, 2), (1, 2), (1.5, 2), ('a', 'b'), (3, 4), (0x3fffffff, 1),
+        (0x3fffffffffffffff, 1), (5, -6), ([1], [2])):
+    print(add(*args), iadd(*args))
+for args in ((1, 2), (2, 1), (1.5, 2), ('b', 'a'), (3, 3), (0x3fffffffffffffff, 1)):
+    print(lt(*args))
+
+# in-place add on a list must still extend it in place
+l = [1]
+for x in (1, 2, [3]):
+    if isinstance(x, list):
+        m = l
+        m = iadd(m, x)
+        print(m is l, l)
+    else:
+        print(iadd(x, x))
+
+class A:
+    c = 'class'
+    def __init__(self, x):
+        self.x = x
+
+class B:
+    x = 'class B'
+
+def get(o):
+    return o.x
+
+for o in (A(1), A(2), B(), A(3), B, A(4)):
+    print(get(o))
+
+# attribute that moves in the members dict
+o = A(5)
+print(get(o))
+for i in range(10):
+    setattr(o, 'y%d' % i, i)
+print(get(o))
+del o.x
+print(get(A(6)))
+try:
+    get(o)
+except AttributeError:
+    print('AttributeError')
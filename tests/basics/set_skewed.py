@@ -0,0 +1,46 @@
+# set operations where one operand is much larger than the other
+
+big = set(range(100))
+small = {3, 50, 200}
+
+print(sorted(big.intersection(small)), sorted(small.intersection(big)))
+print(sorted(big & small), sorted(small & big))
+print(sorted(big.difference(small))[:5], len(big - small))
+print(sorted(small.difference(big)), sorted(small - big))
+print(big.isdisjoint(small), small.isdisjoint(big), small.isdisjoint({7, 8}))
+print(small.issubset(big), {3, 50}.issubset(big), big.issubset(small))
+print(big.issuperset({3, 50}), big >= small, big > {1}, {1} < big, big < small)
+
+# in-place updates filter the smaller set without replacing it
+s = set(range(10))
+s.intersection_update(big)
+print(len(s))
+s.difference_update(big)
+print(s)
+s = set(range(10))
+s.difference_update(set(range(5, 1000)))
+print(sorted(s))
+s.add(7)
+print(sorted(s), 7 in s, 9 in s)
+s = set(range(10))
+s.intersection_update(set(range(5, 1000)))
+print(sorted(s), 4 in s, 5 in s)
+
+# frozensets as operands
+f = frozenset(range(50))
+print(sorted(f & {1, 2, 60}), sorted({1, 2, 60} & f), len(f - {1, 2}))
+print(type(f - {1}).__name__)
+
+# in-place operators mutate a set but not a frozenset
+s = {1, 2, 3}
+t = s
+s |= {4}
+s &= {1, 2, 4, 5}
+s -= {2}
+s ^= {5, 6}
+print(t is s, sorted(t))
+f = frozenset({1, 2, 3})
+g = f
+f |= {4}
+f -= {1}
+print(sorted(g), sorted(f), type(f).__name__)
@@ -0,0 +1,24 @@
+# test searching long strings, which may use a different algorithm
+
+s = "abcd" * 40 + "needle" + "efgh" * 40 + "needle" + "ab" * 30
+print(s.find("needle"), s.rfind("needle"))
+print(s.find("needles"), s.rfind("needles"))
+print(s.find("dabc"), s.rfind("dabc"))
+print(s.find("cdneed"), s.rfind("leef"))
+print(s.count("abcd"), s.count("needle"), s.count("bab"))
+print(s.index("efgh"), s.rindex("efgh"))
+print(s.find("needle", 170), s.rfind("needle", 0, 340))
+print(len(s.split("needle")), len(s.rsplit("needle", 1)))
+print(s.replace("needle", "!").count("!"))
+
+# needles longer than 255 bytes
+n = "x" * 300 + "y"
+t = "x" * 1000 + "y" + "x" * 400
+print(t.find(n), t.rfind(n), t.count(n))
+n = "y" + "x" * 300
+print(t.find(n), t.rfind(n))
+
+b = bytes(range(256)) * 2
+print(b.find(bytes(range(10, 20))), b.rfind(bytes(range(10, 20))))
+print(b.find(b"\xff\x00\x01"), b.rfind(b"\x00\x01\x02\x03"))
+print(bytearray(range(100)) in bytearray(b))
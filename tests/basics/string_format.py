@@ -74,3 +74,9 @@ print("{text:{align}{width}}".format(text="foo", align=">", width=30))
 print("{foo}/foo".format(foo="bar"))
 print("{}".format(123, foo="bar"))
 print("{}-{foo}".format(123, foo="bar"))
+
+# literal text around fields, and a specifier longer than most
+print("a{}b{{c}}d{}e".format(1, 2))
+print("{}{}{}".format("x", [1], (2,)))
+print("{!r}:{!s}:{}".format("a", "b", "c"))
+print("{:>000000000000000000000000000000000000000008}|".format(12))
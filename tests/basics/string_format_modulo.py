@@ -116,3 +116,8 @@ try:
     'a%' % 1
 except ValueError:
     print('ValueError')
+
+# literal text around fields, printed with and without padding
+print("a%sb%%c%rd" % ("x", "y"))
+print("%s|%5s|%-5s|%.1s|" % ([1], "ab", "cd", "ef"))
+print(b"%s-%s" % (b"ab", b"cd"))
@@ -0,0 +1,42 @@
+# test building up str and bytes locals with +=
+
+def f(n):
+    s = ""
+    for i in range(n):
+        s += str(i)
+    return s
+print(f(20))
+print(len(f(1000)))
+
+def g():
+    s = b"a"
+    l = []
+    for i in range(5):
+        s += b"x"
+        l.append(s)
+    t = s
+    s += b"y"
+    print(l, t, s)
+g()
+
+def k():
+    s = ""
+    s += "x"
+    s = 5
+    s += 3
+    print(s)
+    try:
+        del s
+        s += "a"
+    except NameError:
+        print("NameError")
+k()
+
+def m():
+    s = "q"
+    s += s
+    s += s
+    d = {s: 1}
+    s += "z"
+    print(s, d, hash(s) == hash("qqqqz"))
+m()
@@ -0,0 +1,31 @@
+# test long slices of str and bytes, which may share data with the original
+
+s = "the quick brown fox jumps over the lazy dog " * 8
+t = s[4:100]
+u = t[6:80]
+v = u[10:]
+print(t)
+print(u)
+print(v)
+print(len(t), len(u), len(v))
+
+# slices as dict keys and in comparisons
+d = {t: 1, u: 2}
+print(d[s[4:100]], d[s[10:84]])
+print(t == s[4:100], u < t, hash(v) == hash(s[20:84]))
+print(u in s, s.find(v), v.split(" ")[:3])
+
+# a slice used where a C string may be needed
+print(int(("1234567890" * 5)[5:45]))
+print(float(("0.5" + "0" * 40)[0:40]))
+
+b = bytes(range(200))
+c = b[20:180]
+e = c[30:]
+print(c[:4], len(c), e[:4], len(e), e[-1])
+print(bytearray(c)[100:104], b"".join([c[10:50], e[10:50]])[35:45])
+
+# drop the originals and make sure the slices are still intact
+s = t = b = None
+l = [bytes(100) for i in range(100)]
+print(len(u), u[:10], len(e), e[50:54])
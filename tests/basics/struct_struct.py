@@ -0,0 +1,49 @@
+# test struct.Struct and struct.iter_unpack
+try:
+    import ustruct as struct
+except:
+    try:
+        import struct
+    except ImportError:
+        print("SKIP")
+        import sys
+        sys.exit()
+try:
+    struct.Struct
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+s = struct.Struct('<hHb2sI')
+print(s.size, s.format)
+b = s.pack(-2, 3, 4, b'ab', 5)
+print(b)
+print(s.unpack(b))
+print(s.unpack_from(b'xx' + b, 2))
+print(s.unpack_from(b'xx' + b, -s.size))
+
+buf = bytearray(s.size + 1)
+s.pack_into(buf, 1, 1, 2, 3, b'c', 4)
+print(buf)
+
+# native format with alignment
+s = struct.Struct('bi')
+print(s.size == struct.calcsize('bi'))
+print(s.unpack(s.pack(1, 2)))
+
+# iterate over fixed-size records
+data = struct.pack('<4h', 1, 2, 3, 4)
+print(list(struct.Struct('<2h').iter_unpack(data)))
+print(list(struct.iter_unpack('<h', data)))
+print(list(struct.iter_unpack('<h', b'')))
+
+for f in (lambda: struct.Struct('<h').unpack(b'a'),
+          lambda: struct.Struct('<h').pack_into(bytearray(1), 0, 1),
+          lambda: struct.Struct('<h').pack(1, 2),
+          lambda: struct.iter_unpack('<h', b'abc')):
+    try:
+        f()
+    except Exception:
+        # CPython raises struct.error, we raise ValueError
+        print('Error')
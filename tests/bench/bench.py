@@ -1,10 +1,34 @@
-import time
+try:
+    import utime as time
+    ticks_us = time.ticks_us
+    ticks_diff = time.ticks_diff
+except (ImportError, AttributeError):
+    import time
 
+    def ticks_us():
+        return int(time.perf_counter() * 1000000)
 
-ITERS = 20000000
+    def ticks_diff(a, b):
+        return a - b
+
+
+# The number of iterations is doubled until one run takes at least TARGET_US,
+# then scaled so that each of the TRIALS runs takes about that long.
+# run-bench-tests sets these from its options.
+TARGET_US = 100000
+TRIALS = 5
+
+def time_us(f, n):
+    t = ticks_us()
+    f(n)
+    return ticks_diff(ticks_us(), t)
 
 def run(f):
-    t = time.time()
-    f(ITERS)
-    t = time.time() - t
-    print(t)
+    n = 1
+    t = time_us(f, n)
+    while t < TARGET_US // 2:
+        n *= 2
+        t = time_us(f, n)
+    n = max(1, n * TARGET_US // max(1, t))
+    times = [time_us(f, n) for i in range(TRIALS)]
+    print(n, *times)
@@ -0,0 +1,13 @@
+# Dict operation
+# Insert keys into a new dict that stays small
+import bench
+
+KEYS = ["k%d" % i for i in range(8)]
+
+def test(num):
+    for i in iter(range(num // 8)):
+        d = {}
+        for k in KEYS:
+            d[k] = i
+
+bench.run(test)
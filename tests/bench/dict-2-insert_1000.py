@@ -0,0 +1,13 @@
+# Dict operation
+# Insert keys into a new dict that grows to 1000 entries, rehashing on the way
+import bench
+
+KEYS = ["k%d" % i for i in range(1000)]
+
+def test(num):
+    for i in iter(range(num // 1000)):
+        d = {}
+        for k in KEYS:
+            d[k] = i
+
+bench.run(test)
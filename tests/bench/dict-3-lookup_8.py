@@ -0,0 +1,14 @@
+# Dict operation
+# Look up keys in a dict of 8 entries
+import bench
+
+KEYS = ["k%d" % i for i in range(8)]
+D = dict((k, 1) for k in KEYS)
+
+def test(num):
+    d = D
+    for i in iter(range(num // 8)):
+        for k in KEYS:
+            d[k]
+
+bench.run(test)
@@ -0,0 +1,13 @@
+# Dict operation
+# Look up small int keys in a dict of 1000 entries
+import bench
+
+D = dict((i, 1) for i in range(1000))
+
+def test(num):
+    d = D
+    for i in iter(range(num // 1000)):
+        for k in range(1000):
+            d[k]
+
+bench.run(test)
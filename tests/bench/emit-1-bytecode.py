@@ -0,0 +1,10 @@
+# Code emitter
+# A loop doing integer arithmetic, compiled to bytecode
+import bench
+
+def test(num):
+    s = 0
+    for i in range(num):
+        s = (s + i) & 0xffff
+
+bench.run(test)
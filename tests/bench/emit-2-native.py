@@ -0,0 +1,11 @@
+# Code emitter
+# A loop doing integer arithmetic, compiled to machine code
+import bench
+
+@micropython.native
+def test(num):
+    s = 0
+    for i in range(num):
+        s = (s + i) & 0xffff
+
+bench.run(test)
@@ -0,0 +1,13 @@
+# Code emitter
+# A loop doing integer arithmetic, compiled to machine code with native ints
+import bench
+
+@micropython.viper
+def test(num: int):
+    s = 0
+    i = 0
+    while i < num:
+        s = (s + i) & 0xffff
+        i += 1
+
+bench.run(test)
@@ -0,0 +1,19 @@
+# File operation
+# Write a file in 256 byte chunks, one chunk per 10 iterations
+import bench
+try:
+    import uos as os
+except ImportError:
+    import os
+# unix has only unlink
+remove = getattr(os, "remove", None) or os.unlink
+
+BUF = bytes(256)
+
+def test(num):
+    with open("bench.tmp", "wb") as f:
+        for i in iter(range(num // 10)):
+            f.write(BUF)
+    remove("bench.tmp")
+
+bench.run(test)
@@ -0,0 +1,23 @@
+# File operation
+# Read a file of 16k back in 256 byte chunks, one chunk per 10 iterations
+import bench
+try:
+    import uos as os
+except ImportError:
+    import os
+# unix has only unlink
+remove = getattr(os, "remove", None) or os.unlink
+
+with open("bench.tmp", "wb") as f:
+    for i in range(64):
+        f.write(bytes(256))
+
+def test(num):
+    buf = bytearray(256)
+    for i in iter(range(num // 640)):
+        with open("bench.tmp", "rb") as f:
+            while f.readinto(buf):
+                pass
+
+bench.run(test)
+remove("bench.tmp")
@@ -0,0 +1,10 @@
+# GC operation
+# Collect a heap with almost nothing live
+import bench
+import gc
+
+def test(num):
+    for i in iter(range(num // 1000)):
+        gc.collect()
+
+bench.run(test)
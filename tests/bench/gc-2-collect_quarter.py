@@ -0,0 +1,13 @@
+# GC operation
+# Collect a heap with about a quarter of the free memory held by small lists
+import bench
+import gc
+
+gc.collect()
+live = [[i] for i in range(gc.mem_free() // 4 // 64)]
+
+def test(num):
+    for i in iter(range(num // 1000)):
+        gc.collect()
+
+bench.run(test)
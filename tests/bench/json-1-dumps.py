@@ -0,0 +1,15 @@
+# JSON operation
+# Serialise a small document
+import bench
+try:
+    import ujson as json
+except ImportError:
+    import json
+
+DOC = {"name": "sensor", "values": [1, 2, 3, 4.5], "ok": True, "next": None, "nested": {"a": "b"}}
+
+def test(num):
+    for i in iter(range(num // 10)):
+        json.dumps(DOC)
+
+bench.run(test)
@@ -0,0 +1,15 @@
+# JSON operation
+# Parse a small document
+import bench
+try:
+    import ujson as json
+except ImportError:
+    import json
+
+TEXT = '{"name": "sensor", "values": [1, 2, 3, 4.5], "ok": true, "next": null, "nested": {"a": "b"}}'
+
+def test(num):
+    for i in iter(range(num // 10)):
+        json.loads(TEXT)
+
+bench.run(test)
@@ -0,0 +1,9 @@
+# String operation
+# Format a few values with str.format()
+import bench
+
+def test(num):
+    for i in iter(range(num)):
+        "{} is {:>8} ({})".format("x", i, 1.5)
+
+bench.run(test)
@@ -0,0 +1,9 @@
+# String operation
+# Format a few values with the % operator
+import bench
+
+def test(num):
+    for i in iter(range(num)):
+        "%s is %8d (%s)" % ("x", i, 1.5)
+
+bench.run(test)
@@ -0,0 +1,11 @@
+# String operation
+# Join a list of 20 short strings
+import bench
+
+PARTS = ["part%d" % i for i in range(20)]
+
+def test(num):
+    for i in iter(range(num // 20)):
+        ",".join(PARTS)
+
+bench.run(test)
@@ -0,0 +1,11 @@
+# String operation
+# Split a string into 20 parts
+import bench
+
+S = ",".join("part%d" % i for i in range(20))
+
+def test(num):
+    for i in iter(range(num // 20)):
+        S.split(",")
+
+bench.run(test)
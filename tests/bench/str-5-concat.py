@@ -0,0 +1,13 @@
+# String operation
+# Build a string of 20 parts by repeated concatenation
+import bench
+
+PARTS = ["part%d" % i for i in range(20)]
+
+def test(num):
+    for i in iter(range(num // 20)):
+        s = ""
+        for p in PARTS:
+            s += p
+
+bench.run(test)
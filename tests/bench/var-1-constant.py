@@ -1,8 +1,10 @@
 import bench
 
 def test(num):
-    i = 0
-    while i < 20000000:
-        i += 1
+    # the constant can't change with num, so the loop is repeated instead
+    for j in range(num // 1000):
+        i = 0
+        while i < 1000:
+            i += 1
 
 bench.run(test)
@@ -1,8 +1,10 @@
 import bench
 
-ITERS = 20000000
+ITERS = 0
 
 def test(num):
+    global ITERS
+    ITERS = num
     i = 0
     while i < ITERS:
         i += 1
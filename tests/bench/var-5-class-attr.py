@@ -1,9 +1,10 @@
 import bench
 
 class Foo:
-    num = 20000000
+    num = 0
 
 def test(num):
+    Foo.num = num
     i = 0
     while i < Foo.num:
         i += 1
@@ -3,10 +3,11 @@ import bench
 class Foo:
 
     def __init__(self):
-        self.num = 20000000
+        self.num = 0
 
 def test(num):
     o = Foo()
+    o.num = num
     i = 0
     while i < o.num:
         i += 1
@@ -7,10 +7,11 @@ class Foo:
         self.num2 = 0
         self.num3 = 0
         self.num4 = 0
-        self.num = 20000000
+        self.num = 0
 
 def test(num):
     o = Foo()
+    o.num = num
     i = 0
     while i < o.num:
         i += 1
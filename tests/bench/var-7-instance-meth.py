@@ -3,13 +3,14 @@ import bench
 class Foo:
 
     def __init__(self):
-        self._num = 20000000
+        self._num = 0
 
     def num(self):
         return self._num
 
 def test(num):
     o = Foo()
+    o._num = num
     i = 0
     while i < o.num():
         i += 1
@@ -0,0 +1,32 @@
+try:
+    import btree
+    import uio
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+f = uio.BytesIO()
+db = btree.open(f, pagesize=512)
+
+# bulk load of sorted keys
+db.load((("%04d" % i).encode(), ("val%d" % i).encode()) for i in range(1000))
+print(db[b"0000"], db[b"0999"], len(list(db.keys())))
+
+# keys out of order are fine too
+db.load([(b"b", b"2"), (b"a", b"1")])
+print(list(db.keys(b"a", b"c")))
+
+try:
+    db.load([(b"x",)])
+except ValueError:
+    print("ValueError")
+
+# pending changes are written out by flush
+db[b"z"] = b"last"
+print(db.flush())
+db.close()
+
+db = btree.open(f, pagesize=512)
+print(db[b"z"], db[b"0500"])
+db.close()
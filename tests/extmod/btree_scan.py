@@ -0,0 +1,27 @@
+try:
+    import btree
+    import uio
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+f = uio.BytesIO()
+db = btree.open(f, pagesize=512)
+for k in (b"a1", b"b1", b"b2", b"b3", b"c1"):
+    db[k] = k.upper()
+
+# prefix-bounded scans
+print(list(db.keys(b"b", None, btree.PREFIX)))
+print(list(db.items(b"c", None, btree.PREFIX)))
+print(list(db.keys(b"x", None, btree.PREFIX)))
+
+# with REUSE the same objects are returned for each item
+prev = None
+for k, v in db.items(b"b", None, btree.PREFIX | btree.REUSE):
+    print(k, v, prev is None or prev is k)
+    prev = k
+res = [bytes(v) for v in db.values(None, None, btree.REUSE)]
+print(res)
+
+db.close()
@@ -0,0 +1,95 @@
+try:
+    import framebuf
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+def printbuf():
+    print("--8<--")
+    for y in range(h):
+        print(buf[y * w * 2:(y + 1) * w * 2])
+    print("-->8--")
+
+w = 4
+h = 5
+buf = bytearray(w * h * 2)
+fbuf = framebuf.FrameBuffer(buf, w, h, framebuf.RGB565)
+
+# fill
+fbuf.fill(0xffff)
+printbuf()
+fbuf.fill(0x0000)
+printbuf()
+
+# put pixel
+fbuf.pixel(0, 0, 0xeeee)
+fbuf.pixel(3, 0, 0xee00)
+fbuf.pixel(0, 4, 0x00ee)
+fbuf.pixel(3, 4, 0x0ee0)
+printbuf()
+
+# get pixel
+print(fbuf.pixel(0, 4), fbuf.pixel(1, 1))
+
+# scroll
+fbuf.fill(0x0000)
+fbuf.pixel(2, 2, 0xffff)
+printbuf()
+fbuf.scroll(0, 1)
+printbuf()
+fbuf.scroll(1, 0)
+printbuf()
+fbuf.scroll(-1, -2)
+printbuf()
+
+# fill_rect, with clipping
+fbuf.fill(0)
+fbuf.fill_rect(1, 1, 2, 2, 0x1234)
+printbuf()
+fbuf.fill(0)
+fbuf.fill_rect(-2, 3, 5, 10, 0xaaaa)
+printbuf()
+
+# lines and rect
+fbuf.fill(0)
+fbuf.hline(0, 1, 10, 0x1111)
+fbuf.vline(2, -1, 3, 0x2222)
+printbuf()
+fbuf.fill(0)
+fbuf.rect(0, 0, 4, 5, 0x5555)
+printbuf()
+
+# blit, with and without a key, and with clipping
+w2 = 2
+h2 = 3
+buf2 = bytearray(w2 * h2 * 2)
+fbuf2 = framebuf.FrameBuffer(buf2, w2, h2, framebuf.RGB565)
+fbuf2.fill(0)
+fbuf2.pixel(0, 0, 0x0ee0)
+fbuf2.pixel(0, 2, 0xee00)
+fbuf2.pixel(1, 1, 0xeeee)
+fbuf.fill(0xffff)
+fbuf.blit(fbuf2, 3, 3)
+printbuf()
+fbuf.fill(0xffff)
+fbuf.blit(fbuf2, -1, -1, 0)
+printbuf()
+fbuf.fill(0xffff)
+fbuf.blit(fbuf2, 1, 1, 0)
+printbuf()
+
+# blit between formats goes pixel by pixel
+fbuf.fill(0)
+mbuf = bytearray(2)
+mono = framebuf.FrameBuffer(mbuf, 2, 2, framebuf.MONO_HLSB)
+mono.pixel(1, 0, 1)
+mono.pixel(0, 1, 1)
+fbuf.blit(mono, 1, 1)
+printbuf()
+
+# buffer too small
+try:
+    framebuf.FrameBuffer(bytearray(w * h), w, h, framebuf.RGB565)
+except ValueError:
+    print("ValueError")
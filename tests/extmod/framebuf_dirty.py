@@ -0,0 +1,73 @@
+try:
+    import framebuf
+    framebuf.FrameBuffer.dirty
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+w = 16
+h = 10
+buf = bytearray(w * h * 2)
+fbuf = framebuf.FrameBuffer(buf, w, h, framebuf.RGB565)
+
+# a new frame buffer is all dirty, and reading resets it
+print(fbuf.dirty())
+print(fbuf.dirty())
+
+# reading a pixel doesn't change anything
+fbuf.pixel(3, 3)
+print(fbuf.dirty())
+
+# pixels, including out of range ones
+fbuf.pixel(3, 4, 1)
+fbuf.pixel(100, 4, 1)
+print(fbuf.dirty())
+fbuf.pixel(3, 4, 1)
+fbuf.pixel(7, 1, 1)
+print(fbuf.dirty())
+
+# rectangles and lines are clipped
+fbuf.fill_rect(-2, 8, 5, 5, 1)
+print(fbuf.dirty())
+fbuf.hline(14, 0, 10, 1)
+fbuf.vline(0, 5, 1, 1)
+print(fbuf.dirty())
+fbuf.fill_rect(20, 20, 5, 5, 1)
+fbuf.rect(2, 2, 0, 3, 1)
+print(fbuf.dirty())
+
+# fill and scroll change everything
+fbuf.fill(0)
+print(fbuf.dirty())
+fbuf.scroll(1, 0)
+print(fbuf.dirty())
+
+# text, clipped to the buffer
+fbuf.text("ab", 4, -3)
+print(fbuf.dirty())
+fbuf.text("a", 20, 0)
+print(fbuf.dirty())
+
+# blit, clipped to the destination
+src = framebuf.FrameBuffer(bytearray(4 * 4 * 2), 4, 4, framebuf.RGB565)
+fbuf.blit(src, 14, 8)
+print(fbuf.dirty())
+mono = framebuf.FrameBuffer(bytearray(4), 4, 4, framebuf.MONO_HLSB)
+fbuf.blit(mono, -1, 2, 0)
+print(fbuf.dirty())
+
+# marking by hand
+fbuf.dirty(5, 6, 2, 2)
+fbuf.dirty(-5, 0, 6, 1)
+fbuf.dirty(50, 50, 1, 1)
+print(fbuf.dirty())
+try:
+    fbuf.dirty(1, 2)
+except TypeError:
+    print("TypeError")
+
+# other formats
+mono.dirty()
+mono.fill_rect(1, 1, 2, 2, 1)
+print(mono.dirty())
@@ -0,0 +1,89 @@
+try:
+    import framebuf
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+w = 12
+h = 3
+for name, fmt in (("MONO_HLSB", framebuf.MONO_HLSB), ("MONO_HMSB", framebuf.MONO_HMSB)):
+    print(name)
+    buf = bytearray(2 * h)
+    fbuf = framebuf.FrameBuffer(buf, w, h, fmt)
+
+    # fill
+    fbuf.fill(1)
+    print(buf)
+    fbuf.fill(0)
+    print(buf)
+
+    # pixels
+    fbuf.pixel(0, 0, 1)
+    fbuf.pixel(9, 1, 1)
+    fbuf.pixel(11, 2, 1)
+    print(buf)
+    print(fbuf.pixel(9, 1), fbuf.pixel(8, 1), fbuf.pixel(12, 1))
+
+    # fill_rect within one byte, across bytes, and clipped
+    fbuf.fill(0)
+    fbuf.fill_rect(2, 0, 3, 1, 1)
+    fbuf.fill_rect(5, 1, 6, 1, 1)
+    fbuf.fill_rect(-3, 2, 30, 5, 1)
+    print(buf)
+    fbuf.fill_rect(1, 0, 10, 3, 0)
+    print(buf)
+
+    # scroll
+    fbuf.fill(0)
+    fbuf.pixel(1, 0, 1)
+    fbuf.scroll(2, 1)
+    print(buf)
+
+    # text
+    fbuf.fill(0)
+    fbuf.text("-", 2, -2)
+    print(buf)
+
+# GS4_HMSB
+print("GS4_HMSB")
+w = 5
+h = 2
+buf = bytearray(3 * h)
+fbuf = framebuf.FrameBuffer(buf, w, h, framebuf.GS4_HMSB)
+fbuf.fill(0xf)
+print(buf)
+fbuf.fill(0)
+fbuf.pixel(0, 0, 0x3)
+fbuf.pixel(1, 0, 0xa)
+fbuf.pixel(4, 1, 0x7)
+print(buf)
+print(fbuf.pixel(1, 0), fbuf.pixel(4, 1))
+fbuf.fill(0)
+fbuf.fill_rect(1, 0, 4, 2, 0x5)
+print(buf)
+fbuf.fill_rect(0, 1, 2, 1, 0xc)
+print(buf)
+
+# blit with a key
+src = framebuf.FrameBuffer(bytearray(2), 2, 2, framebuf.GS4_HMSB)
+src.fill(0x1)
+src.pixel(0, 0, 0x9)
+fbuf.fill(0)
+fbuf.blit(src, 3, 0, 0x1)
+print(buf)
+
+# MVLSB is also available as MONO_VLSB
+print(framebuf.MVLSB == framebuf.MONO_VLSB)
+buf = bytearray(4)
+fbuf = framebuf.FrameBuffer(buf, 4, 5, framebuf.MONO_VLSB)
+fbuf.fill_rect(1, 1, 2, 3, 1)
+print(buf)
+fbuf.fill_rect(0, 2, 4, 1, 0)
+print(buf)
+
+# invalid format
+try:
+    framebuf.FrameBuffer(buf, 4, 5, 99)
+except ValueError:
+    print("ValueError")
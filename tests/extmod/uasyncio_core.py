@@ -0,0 +1,94 @@
+# test the C event loop core
+try:
+    import _uasyncio
+    import usocket
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+loop = _uasyncio.EventLoop(8)
+
+# round robin between tasks which just yield
+def counter(name, n):
+    for i in range(n):
+        print(name, i)
+        yield
+
+loop.call_soon(counter("a", 3))
+loop.call_soon(counter("b", 2))
+loop.run_forever()
+
+# sleeping tasks wake up in order of their deadline
+def sleeper(name, ms):
+    yield ms
+    print("woke", name)
+
+loop.call_soon(sleeper("slow", 60))
+loop.call_soon(sleeper("fast", 20))
+loop.call_later_ms(40, lambda: print("callback"))
+loop.run_forever()
+
+# run_until_complete returns the value of the main task
+def main():
+    loop.call_soon(counter("c", 4))
+    yield 10
+    return 42
+
+print(loop.run_until_complete(main()))
+
+# stop() from a task
+def stopper():
+    yield
+    loop.stop()
+    print("stop")
+    yield
+
+loop.call_soon(stopper())
+loop.run_forever()
+loop.run_forever()
+
+# waiting for a socket to become readable
+s = usocket.socket(usocket.AF_INET, usocket.SOCK_DGRAM)
+addr = usocket.getaddrinfo("127.0.0.1", 8268)[0][-1]
+s.bind(addr)
+
+def reader():
+    yield loop.wait_read(s)
+    print("read", s.recv(10))
+
+def writer():
+    yield 20
+    yield loop.wait_write(s)
+    s.sendto(b"hello", addr)
+
+loop.call_soon(reader())
+loop.call_soon(writer())
+loop.run_forever()
+s.close()
+
+# exceptions from a task propagate out of the loop
+def bad():
+    yield
+    raise ValueError("bad")
+
+loop.call_soon(bad())
+try:
+    loop.run_forever()
+except ValueError as e:
+    print("ValueError", e)
+
+# the queues have a fixed size
+for i in range(8):
+    loop.call_soon(lambda: None)
+try:
+    loop.call_soon(lambda: None)
+except IndexError:
+    print("IndexError")
+loop.run_forever()
+
+# wait_read is only possible from a running task
+try:
+    loop.wait_read(s)
+except RuntimeError:
+    print("RuntimeError")
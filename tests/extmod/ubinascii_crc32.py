@@ -18,3 +18,9 @@ print(hex(binascii.crc32(b' over the lazy dog', binascii.crc32(b'The quick brown
 print(hex(binascii.crc32(b'\x00' * 16, binascii.crc32(b'\x00' * 16))))
 print(hex(binascii.crc32(b'\xff' * 16, binascii.crc32(b'\xff' * 16))))
 print(hex(binascii.crc32(bytes(range(16, 32)), binascii.crc32(bytes(range(16))))))
+
+# every length and alignment around the steps of the table-driven versions
+data = bytes(range(256)) * 2
+print(hex(binascii.crc32(data)))
+for i in range(10):
+    print(hex(binascii.crc32(memoryview(data)[i:i + 3 * i + 1])))
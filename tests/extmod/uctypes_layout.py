@@ -0,0 +1,46 @@
+try:
+    import uctypes
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+desc = {
+    "s0": uctypes.UINT16 | 0,
+    "b2": uctypes.UINT8 | 2,
+    "sub": (3, {
+        "b0": uctypes.UINT8 | 0,
+    }),
+    "arr": (uctypes.ARRAY | 4, uctypes.UINT8 | 2),
+    "bf1": uctypes.BFUINT8 | 6 | 4 << uctypes.BF_POS | 4 << uctypes.BF_LEN,
+    "bf0": uctypes.BFUINT8 | 6 | 0 << uctypes.BF_POS | 4 << uctypes.BF_LEN,
+}
+
+layout = uctypes.layout(desc)
+print(layout)
+print(uctypes.sizeof(layout))
+
+data = bytearray(b"\x01\x02\x03\x04\x05\x06\x87")
+S = uctypes.struct(uctypes.addressof(data), layout, uctypes.LITTLE_ENDIAN)
+print(hex(S.s0), S.b2, S.sub.b0, S.arr[1], S.bf0, S.bf1)
+
+S.b2 = 0x42
+S.bf1 = 2
+print(data)
+
+try:
+    S.xyz
+except KeyError:
+    print("KeyError")
+
+# batch reads, of all scalars or of given fields
+print(uctypes.unpack(S))
+print(uctypes.unpack(S, ("b2", "s0")))
+# also work on a plain descriptor dict
+S2 = uctypes.struct(uctypes.addressof(data), desc, uctypes.BIG_ENDIAN)
+print(uctypes.unpack(S2))
+
+try:
+    uctypes.layout([1])
+except TypeError:
+    print("TypeError")
@@ -0,0 +1,29 @@
+import sys
+try:
+    import uhashlib as hashlib
+except ImportError:
+    try:
+        import hashlib
+    except ImportError:
+        # This is neither uPy, nor cPy, so must be uPy with
+        # uhashlib module disabled.
+        print("SKIP")
+        sys.exit()
+
+try:
+    hashlib.md5
+except AttributeError:
+    # MD5 is only available on some ports
+    print("SKIP")
+    sys.exit()
+
+md5 = hashlib.md5(b"hello")
+md5.update(b"world")
+print(md5.digest())
+
+# lengths around the block and padding boundaries, fed in pieces
+for n in (55, 56, 64, 65, 200):
+    data = bytes(range(n))
+    md5 = hashlib.md5(data[:7])
+    md5.update(data[7:])
+    print(n, md5.digest())
@@ -0,0 +1,50 @@
+try:
+    import uheapq
+    uheapq.PriorityQueue
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+q = uheapq.PriorityQueue()
+print(len(q), bool(q))
+try:
+    q.pop()
+except IndexError:
+    print("IndexError")
+try:
+    q.peek()
+except IndexError:
+    print("IndexError")
+
+# more than the initial size, to make it grow
+handles = {}
+for i, p in enumerate((5, 3, 8, 1, 9, 2, 7, 4, 6, 0, -4)):
+    handles[i] = q.push(p, "item%d" % i)
+print(len(q), bool(q))
+print(q.peek(), q.peekprio())
+
+# remove one, and change the priority of some
+print(q.remove(handles[4]))
+q.update(handles[2], -10)
+q.update(handles[10], 100)
+l = []
+while q:
+    p = q.peekprio()
+    l.append((p, q.pop()))
+print(l)
+
+# a handle of an entry that's gone, or was never there
+for h in (handles[0], 1000, -1):
+    try:
+        q.remove(h)
+    except ValueError:
+        print("ValueError")
+try:
+    q.update(handles[1], 0)
+except ValueError:
+    print("ValueError")
+
+# handles are reused
+h = q.push(1, None)
+print(h in handles.values(), q.pop())
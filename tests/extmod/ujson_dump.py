@@ -0,0 +1,26 @@
+try:
+    from uio import StringIO
+    import ujson as json
+except:
+    try:
+        from io import StringIO
+        import json
+    except ImportError:
+        print("SKIP")
+        import sys
+        sys.exit()
+
+s = StringIO()
+json.dump(False, s)
+print(s.getvalue())
+
+s = StringIO()
+json.dump({"a": (2, [3, None])}, s)
+print(s.getvalue())
+
+# dump to a stream with existing content, in several writes
+s = StringIO("123")
+s.read()
+json.dump(["string %d \n\"" % i for i in range(30)], s)
+print(s.getvalue())
+print(json.loads(s.getvalue()[3:]) == ["string %d \n\"" % i for i in range(30)])
@@ -0,0 +1,18 @@
+# test ujson.iterencode, which yields the encoding in pieces
+try:
+    import ujson as json
+    json.iterencode
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+print(list(json.iterencode(1)))
+print(list(json.iterencode("a")))
+print(list(json.iterencode([])))
+print(list(json.iterencode([1, "two", [3]])))
+print(list(json.iterencode((None, True))))
+print(list(json.iterencode({"a": [1, {"b": 2}]})))
+
+d = {"k%d" % i: i for i in range(20)}
+print(json.loads("".join(json.iterencode(d))) == d)
@@ -0,0 +1,38 @@
+# test ujson.iterparse, a pull parser giving (event, value) tuples
+try:
+    from uio import StringIO
+    import ujson as json
+    json.iterparse
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+def parse(s):
+    try:
+        for ev in json.iterparse(StringIO(s)):
+            print(ev)
+    except ValueError:
+        print('ValueError')
+
+parse('1')
+parse('"abc"')
+parse('[]')
+parse('{"a": [1, 2.5, "x"], "b": {"c": null}, "d": true, "e": false}')
+parse('[{"k": [[]]}, -3]')
+parse('1 [2] "3"')
+parse('')
+
+# errors
+parse('[1')
+parse('[1}')
+parse('}')
+parse('{1: 2}')
+parse('{[]: 1}')
+parse('tru')
+
+# pick out fields from a file without building the document
+with open('io/data/file.json') as f:
+    for ev, val in json.iterparse(f):
+        if ev == 'key' or ev == 'number':
+            print(val)
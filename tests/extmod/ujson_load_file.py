@@ -0,0 +1,20 @@
+# test ujson.load from a file, which is read a block at a time
+try:
+    import ujson as json
+except ImportError:
+    try:
+        import json
+    except ImportError:
+        print("SKIP")
+        import sys
+        sys.exit()
+
+with open('io/data/file.json') as f:
+    d = json.load(f)
+for k in sorted(d):
+    print(k, d[k])
+
+# the whole stream is consumed
+with open('io/data/file.json') as f:
+    json.load(f)
+    print(f.read())
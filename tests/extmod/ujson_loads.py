@@ -27,6 +27,16 @@ my_print(json.loads('{"a":[], "b":[1], "c":{"3":4}}'))
 # whitespace handling
 my_print(json.loads('{\n\t"a":[]\r\n, "b":[1], "c":{"3":4}     \n\r\t\r\r\r\n}'))
 
+# arrays of records, where each dict shares keys with the one before it
+recs = json.loads('[{"id":1,"name":"a"},{"id":2,"name":"b"},{"name":"c","id":3,"x":[]},{},{"id":4}]')
+for r in recs:
+    my_print(r)
+recs = json.loads('[{"a":{"b":{"c":{"d":{"e":1}}}}},{"a":{"b":{"c":{"d":{"e":2,"f":3}}}}}]')
+print(recs[1]['a']['b']['c']['d']['e'], recs[1]['a']['b']['c']['d']['f'])
+recs = json.loads('[' + ','.join('{"k":%d,"k%d":1,"v":"k"}' % (i, i) for i in range(12)) + ']')
+print([r['k'] for r in recs], [len(r) for r in recs], recs[11]['k11'])
+my_print(json.loads('[{"a":1},[{"a":2}],{"b":3}]')[2])
+
 # loading nothing should raise exception
 try:
     json.loads('')
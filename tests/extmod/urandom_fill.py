@@ -0,0 +1,40 @@
+try:
+    import urandom as random
+except ImportError:
+    import random
+try:
+    random.fill
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+# fills the whole buffer, including a partial word at the end
+for n in (0, 1, 3, 4, 5, 64):
+    b = bytearray(n)
+    random.fill(b)
+    print(n, len(b), n < 16 or b != bytearray(n))
+
+# repeatable from a seed
+random.seed(1)
+a = bytearray(10)
+random.fill(a)
+random.seed(1)
+b = bytearray(10)
+random.fill(b)
+print(a == b)
+
+# fills a slice of an array through a memoryview
+try:
+    import uarray as array
+except ImportError:
+    import array
+arr = array.array('H', [0] * 8)
+random.fill(memoryview(arr)[2:6])
+print(arr[0], arr[1], arr[6], arr[7])
+
+# needs a writable buffer
+try:
+    random.fill(b'1234')
+except TypeError:
+    print('TypeError')
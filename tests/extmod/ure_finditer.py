@@ -0,0 +1,38 @@
+try:
+    import ure as re
+except ImportError:
+    import re
+
+try:
+    re.finditer
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+for m in re.finditer(r"(\w+)=(\d+)", "a=1, bb=22, c=x, ddd=333"):
+    print(m.group(0), m.group(1), m.group(2))
+
+# empty matches
+print([m.group(0) for m in re.finditer("x*", "axxb")])
+print([m.group(0) for m in re.finditer("", "")])
+
+# no matches
+print(list(re.finditer("z", "abc")))
+
+# compiled pattern, iterator can be advanced manually
+r = re.compile("[0-9]")
+it = r.finditer("a1b2")
+print(next(it).group(0))
+print(next(it).group(0))
+try:
+    next(it)
+except StopIteration:
+    print("StopIteration")
+
+# matches stay valid after the iterator moves on
+ms = list(re.finditer("(a)(b)?", "abaab"))
+print([(m.group(0), m.group(1), m.group(2)) for m in ms])
+
+# ^ only matches at the start of the string
+print([m.group(0) for m in re.finditer("^a", "aaa")])
@@ -0,0 +1,42 @@
+# test patterns and subjects which select the linear-time matcher
+try:
+    import ure as re
+except ImportError:
+    import re
+
+def print_groups(match):
+    print('----')
+    try:
+        i = 0
+        while True:
+            print(match.group(i))
+            i += 1
+    except IndexError:
+        pass
+
+# nested repetition and alternation in a loop
+print(re.match(r"(a|aa)*b", "a" * 20))
+print_groups(re.match(r"(a|aa)*b", "a" * 20 + "b"))
+print_groups(re.search(r"x(a+)+y", "zxaaaayz"))
+print(re.search(r"x(a+)+y", "x" + "a" * 20))
+print_groups(re.search(r"(ab|a)(bc|c)+", "--abcbc--"))
+print_groups(re.search(r"((\d+)-)+(\d+)", "tel 12-34-567 ext"))
+
+# long subjects
+log = "2017-03-01 12:00:01 INFO [net] connected to host 192.168.0.1 port 8266\n" * 8
+print_groups(re.search(r"host (\d+)\.(\d+)", log))
+print_groups(re.search(r"port (\d+)$", log.strip()))
+print(re.search(r"ERROR (.*)", log))
+print_groups(re.match(r"(\d+)-(\d+)-(\d+) ([^ ]*)", log))
+line = log.replace("\n", " ")
+print(len(re.search(r"INFO.*8266", line).group(0)))
+print(len(re.search(r"INFO.*?8266", line).group(0)))
+print(len(re.compile("\n").split(log)))
+
+# literal prefix
+print_groups(re.search(r"abc(d*)", "ab abd abcdd"))
+print(re.search(r"abc", "ab abd ab"))
+print(re.match(r"abc", "abd abc"))
+print_groups(re.match(r"ab+", "abbbc"))
+print_groups(re.search(r"^ab", "ab"))
+print(re.search(r"^ab", "cab"))
@@ -0,0 +1,53 @@
+try:
+    import ure as re
+except ImportError:
+    import re
+
+try:
+    re.sub
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+# string replacement, with group references and escapes
+print(re.sub("a", "b", "banana"))
+print(re.sub("(an)", r"<\1>", "banana"))
+print(re.sub("(b)(a)", r"\2\1", "babab"))
+print(re.sub("(n)a", r"\g<1>\g<0>", "banana"))
+print(re.sub("a", r"\\", "banana"))
+print(re.sub("a", r"[\t]", "ba"))
+print(re.sub("(x)?a", r"[\1]", "xaa"))
+print(re.sub("z", "-", "banana"))
+print(re.sub("a", "", "banana"))
+
+# count
+print(re.sub("a", "-", "banana", 2))
+print(re.sub("a", "-", "banana", 0))
+
+# empty matches
+print(re.sub("x*", "-", "abxd"))
+print(re.sub("", "-", "ab"))
+print(re.sub("a*", "-", ""))
+
+# ^ only matches at the start of the string
+print(re.sub("^a", "-", "aaa"))
+print(re.sub("a$", "-", "aaa"))
+
+# callable replacement
+print(re.sub(r"\d+", lambda m: str(int(m.group(0)) * 2), "x1 y22 z333"))
+
+# compiled pattern
+r = re.compile("(\w+)=(\w+)")
+print(r.sub(r"\2=\1", "a=1, b=2, c=3"))
+print(r.sub(r"\2=\1", "a=1, b=2, c=3", 1))
+
+# bytes
+print(re.sub(b"a", b"o", b"banana"))
+
+# bad group reference
+for repl in (r"\2", r"\g<x>", r"\g<1"):
+    try:
+        re.sub("(a)", repl, "a")
+    except Exception:
+        print("Exception")
@@ -0,0 +1,63 @@
+try:
+    import uzlib as zlib
+    import uio as io
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+try:
+    zlib.compress
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+DATA = b"hello world, hello uzlib " * 20 + bytes(range(256)) + b"a" * 300
+
+# one-shot, round-tripped through decompress
+for data in (b"", b"a", b"abc", DATA):
+    for wbits in (10, 9, 15, -9, -12):
+        c = zlib.compress(data, wbits)
+        print(wbits, len(data), zlib.decompress(c, wbits) == data)
+
+# repeated data compresses
+print(len(zlib.compress(DATA)) < len(DATA) // 2)
+
+# zlib header is valid
+c = zlib.compress(b"abc")
+print((c[0] << 8 | c[1]) % 31, c[0] & 0x0f)
+
+# gzip format
+c = zlib.compress(DATA, 16 + 10)
+print(c[:3], zlib.DecompIO(io.BytesIO(c), 16 + 10).read() == DATA)
+
+# streaming with flushes; output so far must be decodable after a flush
+buf = io.BytesIO()
+comp = zlib.CompressIO(buf, -10)
+for i in range(0, len(DATA), 13):
+    comp.write(DATA[i:i + 13])
+    if i % 130 == 0:
+        comp.flush()
+        print(zlib.DecompIO(io.BytesIO(buf.getvalue()), -10).read(i + 1) == DATA[:i + 1])
+comp.close()
+print(zlib.decompress(buf.getvalue(), -10) == DATA)
+
+# context manager, zlib format
+buf = io.BytesIO()
+with zlib.CompressIO(buf) as comp:
+    comp.write(DATA)
+print(zlib.decompress(buf.getvalue()) == DATA)
+
+# writing after close fails
+try:
+    comp.write(b"x")
+except OSError:
+    print("OSError")
+
+# bad wbits
+for wbits in (8, 16, -16, 32):
+    try:
+        zlib.compress(b"", wbits)
+    except ValueError:
+        print("ValueError")
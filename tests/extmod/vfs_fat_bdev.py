@@ -0,0 +1,66 @@
+# test the block device protocol used by VfsFat
+import sys
+import uos
+import uerrno
+try:
+    uos.VfsFat
+except AttributeError:
+    print("SKIP")
+    sys.exit()
+
+
+class RAMBdev:
+
+    SEC_SIZE = 512
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.SEC_SIZE)
+        self.ops = set()
+        self.fail = False
+
+    def readblocks(self, n, buf):
+        if self.fail:
+            return -uerrno.EIO
+        for i in range(len(buf)):
+            buf[i] = self.data[n * self.SEC_SIZE + i]
+
+    def writeblocks(self, n, buf):
+        for i in range(len(buf)):
+            self.data[n * self.SEC_SIZE + i] = buf[i]
+
+    def ioctl(self, op, arg):
+        self.ops.add(op)
+        if op == 4:  # BP_IOCTL_SEC_COUNT
+            return len(self.data) // self.SEC_SIZE
+        if op == 5:  # BP_IOCTL_SEC_SIZE
+            return self.SEC_SIZE
+        if op == 6:  # BP_IOCTL_BLOCK_SIZE
+            return 4
+
+
+try:
+    bdev = RAMBdev(64)
+except MemoryError:
+    print("SKIP")
+    sys.exit()
+
+# mkfs queries the erase block size
+uos.VfsFat.mkfs(bdev)
+print(6 in bdev.ops)
+
+vfs = uos.VfsFat(bdev, "/ramdisk")
+with vfs.open("f", "wb") as f:
+    f.write(bytes(range(256)) * 16)
+
+with vfs.open("f", "rb") as f:
+    buf = bytearray(4096)
+    print(f.readinto(buf), buf[:4], buf[-4:])
+
+# an error returned by readblocks is reported
+with vfs.open("f", "rb") as f:
+    bdev.fail = True
+    try:
+        f.read(10)
+    except OSError as e:
+        print(e.args[0] == uerrno.EIO)
+    bdev.fail = False
@@ -0,0 +1,77 @@
+import sys
+import uos
+try:
+    uos.VfsFat
+except AttributeError:
+    print("SKIP")
+    sys.exit()
+
+
+class RAMFS:
+
+    SEC_SIZE = 512
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.SEC_SIZE)
+
+    def readblocks(self, n, buf):
+        for i in range(len(buf)):
+            buf[i] = self.data[n * self.SEC_SIZE + i]
+
+    def writeblocks(self, n, buf):
+        for i in range(len(buf)):
+            self.data[n * self.SEC_SIZE + i] = buf[i]
+
+    def ioctl(self, op, arg):
+        if op == 4:  # BP_IOCTL_SEC_COUNT
+            return len(self.data) // self.SEC_SIZE
+        if op == 5:  # BP_IOCTL_SEC_SIZE
+            return self.SEC_SIZE
+
+
+try:
+    bdev = RAMFS(64)
+except MemoryError:
+    print("SKIP")
+    sys.exit()
+
+uos.VfsFat.mkfs(bdev)
+vfs = uos.VfsFat(bdev, "/ramdisk")
+
+try:
+    vfs.open("x", "w", fastseek=False).close()
+except TypeError:
+    print("SKIP")
+    sys.exit()
+
+# write two files interleaved, so that both are fragmented
+chunk = 512
+fa = vfs.open("a", "wb")
+fb = vfs.open("b", "wb")
+for i in range(12):
+    fa.write(bytes([i]) * chunk)
+    fb.write(bytes([100 + i]) * chunk)
+fa.close()
+fb.close()
+
+f = vfs.open("a", "rb", fastseek=True)
+for pos in (5000, 0, 3 * chunk - 1, 11 * chunk + 7, 2 * chunk, 700):
+    f.seek(pos)
+    print(pos, f.tell(), f.read(2))
+f.seek(0, 2)
+print(f.tell(), f.read(1))
+f.seek(0)
+print(len(f.read()))
+f.close()
+
+# empty file
+vfs.open("e", "w").close()
+f = vfs.open("e", "r", fastseek=True)
+print(f.read())
+f.close()
+
+# only for read-only files
+try:
+    vfs.open("a", "r+", fastseek=True)
+except ValueError:
+    print("ValueError")
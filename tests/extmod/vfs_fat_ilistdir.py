@@ -0,0 +1,83 @@
+import sys
+import uos
+import uerrno
+try:
+    uos.VfsFat
+except AttributeError:
+    print("SKIP")
+    sys.exit()
+
+
+class RAMFS:
+
+    SEC_SIZE = 512
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.SEC_SIZE)
+
+    def readblocks(self, n, buf):
+        for i in range(len(buf)):
+            buf[i] = self.data[n * self.SEC_SIZE + i]
+
+    def writeblocks(self, n, buf):
+        for i in range(len(buf)):
+            self.data[n * self.SEC_SIZE + i] = buf[i]
+
+    def ioctl(self, op, arg):
+        if op == 4:  # BP_IOCTL_SEC_COUNT
+            return len(self.data) // self.SEC_SIZE
+        if op == 5:  # BP_IOCTL_SEC_SIZE
+            return self.SEC_SIZE
+
+
+try:
+    bdev = RAMFS(48)
+except MemoryError:
+    print("SKIP")
+    sys.exit()
+
+uos.VfsFat.mkfs(bdev)
+vfs = uos.VfsFat(bdev, "/ramdisk")
+
+# empty directory
+print(list(vfs.ilistdir()))
+
+for i in range(5):
+    with vfs.open("file%d.txt" % i, "w") as f:
+        f.write("x" * (i * 100))
+vfs.mkdir("a_long_directory_name")
+with vfs.open("a_long_directory_name/inner.dat", "w") as f:
+    f.write("data")
+
+# entries come back as (name, type, size) tuples
+for entry in sorted(vfs.ilistdir()):
+    print(entry)
+
+# the iterator is lazy and can be stepped by hand
+it = vfs.ilistdir("a_long_directory_name")
+print(next(it))
+try:
+    next(it)
+except StopIteration:
+    print("StopIteration")
+try:
+    next(it)
+except StopIteration:
+    print("StopIteration")
+
+# bytes path gives bytes names
+print(list(vfs.ilistdir(b"a_long_directory_name")))
+
+# names agree with listdir
+print(sorted(e[0] for e in vfs.ilistdir()) == sorted(vfs.listdir()))
+
+# type and size agree with stat
+for name, typ, size in vfs.ilistdir():
+    st = vfs.stat(name)
+    print(name, typ == st[0], size == st[6])
+
+# a missing directory raises when ilistdir is called
+try:
+    vfs.ilistdir("no_such_dir")
+except OSError as e:
+    print(e.args[0] == uerrno.ENOENT)
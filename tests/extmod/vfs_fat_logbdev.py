@@ -0,0 +1,123 @@
+# test uos.LogBdev, a log-structured block device on raw flash, under VfsFat
+import sys
+import uos
+try:
+    uos.VfsFat
+    uos.LogBdev
+except AttributeError:
+    print("SKIP")
+    sys.exit()
+
+
+class RAMFlash:
+    # Simulates NOR flash: programming can only clear bits, and only an
+    # erase of a whole block sets them again.
+
+    BLOCK_SIZE = 4096
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.BLOCK_SIZE)
+        self.blank = b'\xff' * self.BLOCK_SIZE
+        self.erases = [0] * blocks
+        self.writes = 0
+        self.fail_after = -1
+        for i in range(blocks):
+            self.ioctl(7, i)
+        self.erases = [0] * blocks
+
+    def readblocks(self, n, buf, off):
+        addr = n * self.BLOCK_SIZE + off
+        for i in range(len(buf)):
+            buf[i] = self.data[addr + i]
+
+    def writeblocks(self, n, buf, off):
+        addr = n * self.BLOCK_SIZE + off
+        length = len(buf)
+        if self.fail_after == 0:
+            # power lost half way through programming
+            length //= 2
+        for i in range(length):
+            self.data[addr + i] &= buf[i]
+        if length == 512:
+            self.writes += 1
+        if self.fail_after >= 0:
+            if self.fail_after == 0:
+                raise OSError(5)
+            self.fail_after -= 1
+
+    def ioctl(self, op, arg):
+        if op == 4:  # BP_IOCTL_SEC_COUNT
+            return len(self.erases)
+        if op == 5:  # BP_IOCTL_SEC_SIZE
+            return self.BLOCK_SIZE
+        if op == 7:  # BP_IOCTL_BLOCK_ERASE
+            addr = arg * self.BLOCK_SIZE
+            self.data[addr:addr + self.BLOCK_SIZE] = self.blank
+            self.erases[arg] += 1
+
+
+try:
+    flash = RAMFlash(24)
+except MemoryError:
+    print("SKIP")
+    sys.exit()
+
+# 7 pages of 512 bytes per 4k block, and 2 blocks kept spare
+bdev = uos.LogBdev(flash)
+print(bdev.ioctl(4, 0), bdev.ioctl(5, 0))
+
+# never written sectors read as zeros
+buf = bytearray(512)
+bdev.readblocks(10, buf)
+print(buf[0], buf[511])
+
+# rewriting one sector over and over spreads the erases over all blocks,
+# including those holding data that never changes
+for i in range(20):
+    bdev.writeblocks(i, bytes([i]) * 512)
+for i in range(2000):
+    buf[0] = i & 0xff
+    bdev.writeblocks(100, buf)
+print(min(flash.erases) > 0, max(flash.erases) - min(flash.erases) <= 10)
+for i in range(20):
+    bdev.readblocks(i, buf)
+    if buf != bytes([i]) * 512:
+        print("bad sector", i)
+
+# a write torn by power loss leaves the previous copy of the sector
+for fail_after in (0, 1):
+    bdev.writeblocks(100, b'\x11' * 512)
+    flash.fail_after = fail_after
+    try:
+        bdev.writeblocks(100, b'\x22' * 512)
+    except OSError:
+        print("torn")
+    flash.fail_after = -1
+    bdev = uos.LogBdev(flash)
+    bdev.readblocks(100, buf)
+    print(buf[0], buf[511])
+    # and later writes still work
+    bdev.writeblocks(100, b'\x33' * 512)
+    bdev = uos.LogBdev(flash)
+    bdev.readblocks(100, buf)
+    print(buf[0], buf[511])
+
+# append to a log file, one small write at a time
+uos.VfsFat.mkfs(bdev)
+vfs = uos.VfsFat(bdev, "/ramdisk")
+flash.writes = 0
+erases = sum(flash.erases)
+for i in range(100):
+    with vfs.open("log", "a") as f:
+        f.write("line %d\n" % i)
+vfs.umount()
+
+# there is one erase for every 7 sectors written, rather than one each
+print(flash.writes > 100, sum(flash.erases) - erases <= flash.writes // 7 + 2)
+
+# everything is found again after remounting
+bdev = uos.LogBdev(flash)
+vfs = uos.VfsFat(bdev, "/ramdisk")
+with vfs.open("log") as f:
+    lines = f.read().split("\n")
+print(len(lines), lines[0], lines[99])
@@ -0,0 +1,177 @@
+# test uos.SDCard, an SD card over SPI, under VfsFat
+import sys
+import uos
+try:
+    uos.VfsFat
+    uos.SDCard
+except AttributeError:
+    print("SKIP")
+    sys.exit()
+
+
+class Card:
+    # Simulates an SDHC card's side of the SPI bus, one byte at a time.
+
+    def __init__(self, sectors):
+        self.data = bytearray(sectors * 512)
+        self.sectors = sectors
+        self.selected = False
+        self.out = []
+        self.cmd = bytearray()
+        self.idle = True
+        self.app = False
+        self.log = []
+        self.write_addr = None  # waiting for a data token at this block
+        self.multi = False
+        self.rx = None  # data block being received
+        self.read_addr = None  # streaming blocks from here
+
+    def queue_block(self, data):
+        self.out += [0xff, 0xfe] + list(data) + [0x12, 0x34]
+
+    def command(self, cmd, arg):
+        self.log.append(cmd)
+        r1 = 0x01 if self.idle else 0
+        if self.app:
+            self.app = False
+            if cmd == 41:
+                self.idle = False
+                r1 = 0
+            self.out += [r1]
+            return
+        if cmd == 0:
+            self.idle = True
+            self.out += [0x01]
+        elif cmd == 8:
+            self.out += [r1, 0, 0, 1, 0xaa]
+        elif cmd == 55:
+            self.app = True
+            self.out += [r1]
+        elif cmd == 58:
+            self.out += [r1, 0xc0, 0xff, 0x80, 0]
+        elif cmd == 9:
+            c_size = self.sectors // 1024 - 1
+            csd = bytearray(16)
+            csd[0] = 0x40
+            csd[7] = c_size >> 16
+            csd[8] = c_size >> 8 & 0xff
+            csd[9] = c_size & 0xff
+            self.out += [0]
+            self.queue_block(csd)
+        elif cmd == 16:
+            self.out += [0]
+        elif cmd in (17, 18):
+            self.out += [0xff, 0]
+            self.queue_block(self.data[arg * 512:arg * 512 + 512])
+            if cmd == 18:
+                self.read_addr = arg + 1
+        elif cmd == 12:
+            self.read_addr = None
+            self.out = [0xff, 0, 0, 0]
+        elif cmd in (24, 25):
+            self.out += [0]
+            self.write_addr = arg
+            self.multi = cmd == 25
+        else:
+            self.out += [0x04 | r1]
+
+    def byte(self, b):
+        if not self.selected:
+            return 0xff
+        r = self.out.pop(0) if self.out else 0xff
+        if self.rx is not None:
+            self.rx.append(b)
+            if len(self.rx) == 514:
+                a = self.write_addr * 512
+                self.data[a:a + 512] = self.rx[:512]
+                self.rx = None
+                self.write_addr += 1
+                if not self.multi:
+                    self.write_addr = None
+                self.out += [0xe5, 0, 0, 0]
+        elif self.cmd or b & 0xc0 == 0x40:
+            self.cmd.append(b)
+            if len(self.cmd) == 6:
+                c = self.cmd
+                self.cmd = bytearray()
+                self.command(c[0] & 0x3f, c[1] << 24 | c[2] << 16 | c[3] << 8 | c[4])
+        elif self.write_addr is not None and b in (0xfc, 0xfe):
+            self.rx = bytearray()
+        elif self.write_addr is not None and b == 0xfd:
+            self.write_addr = None
+            self.out += [0xff, 0, 0]
+        elif self.read_addr is not None and not self.out:
+            a = self.read_addr * 512
+            self.queue_block(self.data[a:a + 512])
+            self.read_addr += 1
+        return r
+
+
+class SPI:
+    def __init__(self, card):
+        self.card = card
+        self.baudrate = 0
+
+    def init(self, baudrate, polarity, phase):
+        self.baudrate = baudrate
+
+    def write(self, buf):
+        for b in buf:
+            self.card.byte(b)
+
+    def write_readinto(self, out, buf):
+        for i in range(len(out)):
+            buf[i] = self.card.byte(out[i])
+
+
+class Pin:
+    OUT = 1
+
+    def __init__(self, card):
+        self.card = card
+
+    def init(self, mode, value):
+        self.value(value)
+
+    def value(self, v):
+        self.card.selected = not v
+
+
+try:
+    card = Card(1024)
+except MemoryError:
+    print("SKIP")
+    sys.exit()
+spi = SPI(card)
+sd = uos.SDCard(spi, Pin(card), baudrate=400000)
+print(spi.baudrate, card.selected, card.log)
+print(sd.ioctl(4, 0), sd.ioctl(5, 0))
+
+# single and multi-block transfers
+card.log = []
+sd.writeblocks(3, b'\x33' * 512)
+sd.writeblocks(5, b'\x55' * 512 + b'\x66' * 512 + b'\x77' * 512)
+print(card.log, card.data[3 * 512], card.data[6 * 512 + 511], card.data[8 * 512])
+buf = bytearray(4 * 512)
+card.log = []
+print(sd.readblocks(4, buf), card.log)
+print(buf[0], buf[512], buf[1024], buf[1536], buf[2047])
+print(sd.readblocks(3, memoryview(buf)[:512]), buf[0], card.log)
+
+# no card
+try:
+    uos.SDCard(SPI(Card(1024)), Pin(Card(1024)))
+except OSError as e:
+    print(e)
+
+# as a filesystem
+uos.VfsFat.mkfs(sd)
+vfs = uos.VfsFat(sd, "/ramdisk")
+with vfs.open("file", "w") as f:
+    f.write("hello" * 500)
+vfs.umount()
+vfs = uos.VfsFat(sd, "/ramdisk")
+with vfs.open("file") as f:
+    data = f.read()
+print(len(data), data[:10])
+vfs.umount()
@@ -0,0 +1,55 @@
+try:
+    import uio
+    import websocket
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+# build a masked client->server frame
+def frame(opcode, payload, mask):
+    hdr = bytearray([0x80 | opcode])
+    n = len(payload)
+    if n < 126:
+        hdr.append(0x80 | n)
+    else:
+        hdr.append(0x80 | 126)
+        hdr.append(n >> 8)
+        hdr.append(n & 0xff)
+    hdr.extend(mask)
+    data = bytearray(payload)
+    for i in range(n):
+        data[i] ^= mask[i & 3]
+    return bytes(hdr) + bytes(data)
+
+mask = b"\x12\x34\x56\x78"
+
+# payloads of various lengths, so all alignment cases of unmasking are hit
+for n in (0, 1, 3, 7, 8, 17, 125, 126, 300):
+    payload = bytes(i & 0xff for i in range(n))
+    ws = websocket.websocket(uio.BytesIO(frame(2, payload, mask) + frame(2, b"end", mask)))
+    got = ws.read(n) if n else b""
+    print(n, got == payload, ws.read(3))
+
+# reading a frame in several odd-sized pieces keeps the mask phase
+payload = bytes(range(100))
+ws = websocket.websocket(uio.BytesIO(frame(2, payload, mask)))
+buf = b""
+for sz in (1, 5, 11, 2, 81):
+    buf += ws.read(sz)
+print(buf == payload)
+
+# readinto
+ws = websocket.websocket(uio.BytesIO(frame(2, payload, mask)))
+b = bytearray(100)
+print(ws.readinto(b), b == payload)
+
+# unmasked frame
+ws = websocket.websocket(uio.BytesIO(b"\x82\x03abc"))
+print(ws.read(3))
+
+# write produces an unmasked frame
+s = uio.BytesIO()
+ws = websocket.websocket(s)
+ws.write(b"hello")
+print(s.getvalue())
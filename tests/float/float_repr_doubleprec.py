@@ -0,0 +1,39 @@
+# test that repr of a double precision float is the shortest string that
+# reads back as the same float
+
+import sys
+try:
+    import ustruct as struct
+except ImportError:
+    import struct
+
+if repr(0.1 + 0.2) != "0.30000000000000004":
+    print("SKIP")
+    sys.exit()
+
+# shortest digits
+for x in (0.1, 0.2, 0.3, 1 / 3, 2 / 3, 1.1 * 1.1, 100.0, 1e15, 1e16, 1e17,
+          123456789012345.6, 0.0001, 0.00001, 1.5e-5, 5e-324, 2.2250738585072014e-308,
+          1.7976931348623157e+308, 9007199254740993.0, 299792458.0, 6.02214076e23,
+          1e23, 1e21 * 3):
+    print(repr(x), repr(-x))
+
+# exact reading of short decimals
+print(float("0.1") == 1 / 10, float("1e22") == 10.0 ** 22, float("12345e-3") == 12.345)
+print(float("9007199254740993") == 9007199254740992.0)
+print(float("9007199254740995") == 9007199254740996.0)
+
+# halfway between two floats rounds to even
+print(float("1.00000000000000011102230246251565404236316680908203125") == 1.0)
+print(float("2.4703282292062327e-324"), float("2.4703282292062328e-324"))
+print(float("1.7976931348623158e308"), float("1.7976931348623159e308"))
+
+# every float reads back from its repr
+bad = 0
+for i in range(2000):
+    b = struct.pack("<Q", (i * 0x9e3779b97f4a7c15 + 0x7f4a7c15) & 0x7fefffffffffffff)
+    x = struct.unpack("<d", b)[0]
+    if float(repr(x)) != x:
+        print(repr(x))
+        bad += 1
+print(bad)
@@ -0,0 +1,7 @@
+# test importing a module with several kinds of top-level statement
+import import_stmts1 as m
+
+print(m.later())
+print(m.total, m.ok)
+print(m.C().value(), m.C.__name__)
+print(m.decorated())
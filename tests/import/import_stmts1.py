@@ -0,0 +1,33 @@
+# module imported by import_stmts.py
+try:
+    from micropython import const
+except ImportError:
+    const = lambda x: x
+
+_SCALE = const(3)
+OFFSET = const(4)
+
+
+def later():
+    # refers to a name bound by a later statement
+    return value_defined_later * _SCALE + OFFSET
+
+total = 0
+for i in range(4):
+    total += i * _SCALE
+if total > 10: ok = True
+else: ok = False
+
+class C:
+    def value(self):
+        return _SCALE
+
+
+def deco(f):
+    return lambda: f() + 1
+
+@deco
+def decorated():
+    return OFFSET
+
+value_defined_later = 2; x = 1; x += 1
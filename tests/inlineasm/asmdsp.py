@@ -0,0 +1,63 @@
+# test the DSP instructions of Cortex-M4 (ARMv7E-M)
+import array
+
+@micropython.asm_thumb
+def sadd16(r0, r1):
+    sadd16(r0, r0, r1)
+
+@micropython.asm_thumb
+def qadd16(r0, r1):
+    qadd16(r0, r0, r1)
+
+@micropython.asm_thumb
+def uadd8(r0, r1):
+    uadd8(r0, r0, r1)
+
+@micropython.asm_thumb
+def qadd(r0, r1):
+    qadd(r0, r0, r1)
+
+print(hex(sadd16(0x00017fff, 0x00020001)))
+print(hex(qadd16(0x00017fff, 0x00020001)))
+print(hex(uadd8(0x01ff8010, 0x01018010)))
+print(qadd(0x7fffffff, 1), qadd(-0x7fffffff, -10))
+
+@micropython.asm_thumb
+def ssat8(r0):
+    ssat(r0, 8, r0)
+
+@micropython.asm_thumb
+def usat8(r0):
+    usat(r0, 8, r0)
+
+print(ssat8(300), ssat8(-300), ssat8(-5))
+print(usat8(300), usat8(-5), usat8(5))
+
+@micropython.asm_thumb
+def smlad(r0, r1, r2):
+    smlad(r0, r0, r1, r2)
+
+@micropython.asm_thumb
+def smull_hi(r0, r1):
+    smull(r2, r0, r0, r1)
+
+print(smlad(3 << 16 | 2, 5 << 16 | 7, 100))
+print(smull_hi(0x10000, 0x10000), smull_hi(-1, 2))
+
+# dot product of two int16 arrays, two products per instruction
+@micropython.asm_thumb
+def dot(r0, r1, r2):
+    mov(r3, 0)
+    label(loop)
+    ldr(r4, [r0, 0])
+    ldr(r5, [r1, 0])
+    smlad(r3, r4, r5, r3)
+    add(r0, 4)
+    add(r1, 4)
+    sub(r2, 1)
+    bgt(loop)
+    mov(r0, r3)
+
+a = array.array('h', [1, -2, 3, 4, 100, 200])
+b = array.array('h', [5, 6, -7, 8, -1, 3])
+print(dot(a, b, 3))
@@ -0,0 +1,14 @@
+import array
+@micropython.asm_thumb      # test vldm, vstm, vpush, vpop
+def f(r0, r1):
+    vldm(r0, {s0, s1, s2})
+    vadd(s0, s0, s1)
+    vadd(s0, s0, s2)
+    vpush({s0, s1})
+    vpop({s4, s5})
+    vstm(r1, {s4, s5})
+
+a = array.array("f", [1, 2, 3.5])
+b = array.array("f", [0, 0])
+f(a, b)
+print(b)
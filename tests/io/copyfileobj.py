@@ -0,0 +1,46 @@
+# test uio.copyfileobj, which copies between streams without Python buffers
+try:
+    import uio
+    uio.copyfileobj
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+# whole file to an in-memory stream
+f = open("io/data/file1", "rb")
+dst = uio.BytesIO()
+print(uio.copyfileobj(f, dst))
+f.close()
+print(dst.getvalue() == open("io/data/file1", "rb").read())
+
+# data longer than the internal buffer, with different chunk sizes
+data = bytes(range(256)) * 5
+for length in (1, 7, 256, 1000, 2000):
+    src = uio.BytesIO(data)
+    dst = uio.BytesIO()
+    uio.copyfileobj(src, dst, length)
+    print(length, dst.getvalue() == data)
+
+# copying starts from the current position of the source
+src = uio.BytesIO(b"0123456789")
+src.read(4)
+dst = uio.BytesIO()
+uio.copyfileobj(src, dst)
+print(dst.getvalue())
+
+# empty source
+dst = uio.BytesIO()
+uio.copyfileobj(uio.BytesIO(), dst)
+print(dst.getvalue())
+
+# text streams
+dst = uio.StringIO()
+uio.copyfileobj(uio.StringIO("text"), dst)
+print(dst.getvalue())
+
+# both arguments must be streams
+try:
+    uio.copyfileobj(1, dst)
+except OSError:
+    print("OSError")
@@ -0,0 +1,49 @@
+# test writev, writing several buffers at once
+import sys
+try:
+    import uos as os
+except ImportError:
+    import os
+
+if not hasattr(os, "unlink"):
+    print("SKIP")
+    sys.exit()
+
+try:
+    os.unlink("testfile")
+except OSError:
+    pass
+
+f = open("testfile", "wb")
+if not hasattr(f, "writev"):
+    f.close()
+    os.unlink("testfile")
+    print("SKIP")
+    sys.exit()
+
+print(f.writev([b"header ", bytearray(b"payload"), b"", memoryview(b" trailer")]))
+print(f.writev(()))
+# more buffers than are passed to the OS at once
+print(f.writev([b"%d," % i for i in range(40)]))
+f.close()
+
+f = open("testfile", "rb")
+print(f.read())
+f.close()
+
+# text files too
+f = open("testfile", "w")
+print(f.writev(("a", "b")))
+f.close()
+f = open("testfile")
+print(f.read())
+f.close()
+
+try:
+    f = open("testfile", "wb")
+    f.writev([1])
+except TypeError:
+    print("TypeError")
+f.close()
+
+os.unlink("testfile")
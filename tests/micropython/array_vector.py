@@ -0,0 +1,66 @@
+# test native bulk operations on arrays
+try:
+    from array import array
+    array('b').sum
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+# scalar arithmetic, in place and wrapping to the element size
+a = array('h', [1, -2, 3, 30000])
+print(a.mul(2), a)
+a.add(-1)
+print(a)
+a = array('B', [250, 1])
+a.add(10)
+print(a)
+
+# elementwise arithmetic with another array
+a = array('i', [1, 2, 3])
+a.add(array('i', [10, 20, 30]))
+print(a)
+a.mul(a)
+print(a)
+
+# reductions
+a = array('b', [5, -7, 3, 0])
+print(a.sum(), a.min(), a.max(), a.dot(a))
+a = array('L', [1, 2, 3])
+print(a.sum(), a.min(), a.max(), a.dot(array('L', [4, 5, 6])))
+print(array('h').sum())
+b = bytearray(b'\x01\x02\xff')
+print(b.sum(), b.max())
+
+# floats
+f = array('f', [1, 2, 3])
+f.mul(0.5)
+f.add(f)
+print(f, f.sum(), f.min(), f.max(), f.dot(f))
+a = array('h', [3, -5])
+a.mul(1.5)
+print(a)
+
+# conversion between typecodes
+print(array('f', array('h', [1, -2])))
+print(array('h', array('d', [1.75, -2.75])))
+print(array('B', array('h', [-1, 256, 3])))
+print(array('b', memoryview(array('H', [1, 65535]))))
+
+# errors
+try:
+    array('h').min()
+except ValueError:
+    print('ValueError')
+try:
+    array('h', [1]).add(array('h', [1, 2]))
+except ValueError:
+    print('ValueError')
+try:
+    array('h', [1]).dot(array('i', [1]))
+except ValueError:
+    print('ValueError')
+try:
+    array('O', [1]).sum()
+except (TypeError, ValueError):
+    print('TypeError')
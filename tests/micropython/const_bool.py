@@ -0,0 +1,16 @@
+# test const() with bool values and the folding it enables
+
+from micropython import const
+
+DEBUG = const(False)
+_VERBOSE = const(True)
+LEVEL = const(2)
+
+if DEBUG:
+    print('not printed')
+if not DEBUG and _VERBOSE:
+    print('verbose')
+if LEVEL >= 2 or DEBUG:
+    print('level', LEVEL)
+print(DEBUG, _VERBOSE, 'on' if DEBUG else 'off')
+print(globals()['DEBUG'], '_VERBOSE' in globals())
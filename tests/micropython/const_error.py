@@ -13,3 +13,4 @@ test_syntax("a = const(x)")
 
 # redefined constant
 test_syntax("A = const(1); A = const(2)")
+test_syntax("a = const(None)")
@@ -0,0 +1,33 @@
+# test micropython.cycles() and cycle_stats()
+
+import micropython
+
+try:
+    micropython.cycles
+    import utime
+    utime.ticks_diff
+except (AttributeError, ImportError):
+    print('SKIP')
+    import sys
+    sys.exit()
+
+import gc
+
+# the counter moves forward
+t0 = micropython.cycles()
+x = [i for i in range(100)]
+print(type(t0), utime.ticks_diff(micropython.cycles(), t0) > 0)
+
+# each section counts its runs, and the cycles they took
+micropython.cycle_stats(True)
+gc.collect()
+exec('y = 1 + 2')
+stats = micropython.cycle_stats()
+print(sorted(stats.keys()))
+for name in ('gc_collect', 'parse', 'compile'):
+    count, total, longest = stats[name]
+    print(name, count >= 1, total >= longest > 0)
+
+# resetting clears the counts once they are read
+micropython.cycle_stats(True)
+print(micropython.cycle_stats()['compile'])
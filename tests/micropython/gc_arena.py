@@ -0,0 +1,51 @@
+# test arenas, whose objects are released together when the arena is exited
+
+import gc
+
+try:
+    gc.arena
+except AttributeError:
+    print('SKIP')
+    raise SystemExit
+
+def parse(frame, keep):
+    pkt = [(i, str(i), [i] * 3) for i in range(30)]
+    d = {}
+    for t in pkt:
+        d[t[1]] = t[0]
+    if frame % 5 == 0:
+        keep.append(pkt[frame])
+
+# the temporary objects of each frame don't build up on the heap
+keep = []
+gc.collect()
+base = gc.mem_alloc()
+for frame in range(20):
+    with gc.arena(16384):
+        parse(frame, keep)
+print(gc.mem_alloc() - base < 16384)
+print(keep)
+
+# objects that are still referred to outlive the arena
+with gc.arena(1024):
+    l = []
+    for i in range(50):
+        l.append(i * 2)
+    s = 'x%d' % 123
+gc.collect()
+print(sum(l), s)
+
+# arenas nest
+with gc.arena(512):
+    x = [1, 2]
+    with gc.arena(512):
+        y = [x, 3]
+    z = [y, 4]
+gc.collect()
+print(z)
+
+try:
+    with gc.arena(1 << 30):
+        pass
+except MemoryError:
+    print('MemoryError')
@@ -0,0 +1,46 @@
+# test gc.compact, which moves the buffers of bytearray and array objects
+
+import gc
+
+try:
+    gc.compact
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+try:
+    import array
+except ImportError:
+    array = None
+
+# leave garbage below the buffers so they have somewhere to move to
+def make(n):
+    keep = []
+    for i in range(n):
+        junk = bytearray(100)
+        keep.append(bytearray(range(i, i + 40)))
+    return keep
+
+keep = make(50)
+print(gc.compact() > 0)
+print(all(keep[i] == bytearray(range(i, i + 40)) for i in range(50)))
+
+# moved buffers can still grow and shrink
+keep[0].extend(b'xyz')
+print(len(keep[0]), keep[0][-3:])
+keep[1].extend(bytes(100))
+print(len(keep[1]), keep[1][0])
+
+# a buffer used by a memoryview stays shared with it
+m = memoryview(keep[10])
+gc.compact()
+m[0] = 99
+print(keep[10][0])
+
+if array:
+    keep = [array.array('i', range(i, i + 20)) for i in range(20)]
+    gc.compact()
+    print(sum(sum(a) for a in keep))
+else:
+    print(7600)
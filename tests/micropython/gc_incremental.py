@@ -0,0 +1,41 @@
+# test that objects survive an incremental sweep of the heap
+
+import gc
+
+try:
+    gc.incremental
+    gc.threshold
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+q = gc.incremental()
+gc.incremental(4)
+
+# automatic collections leave the sweep pending, to be done from the VM loop
+# while new objects are allocated in the unswept part of the heap
+gc.threshold(2048)
+keep = []
+for i in range(2000):
+    garbage = [i] * 4
+    if i % 10 == 0:
+        keep.append(str(i))
+gc.threshold(-1)
+
+print(len(keep), keep[0], keep[-1])
+print(all(keep[i] == str(i * 10) for i in range(len(keep))))
+
+# allocations that find no room sweep on demand until they find a fit
+for i in range(100):
+    b = bytearray(i * 100)
+    b[-1:] = b'x'
+    keep[i] = b
+print(sum(len(k) for k in keep[:100]))
+
+# an explicit collection still sweeps everything
+keep = None
+gc.collect()
+print(gc.mem_free() > 0)
+
+gc.incremental(q)
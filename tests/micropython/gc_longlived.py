@@ -0,0 +1,32 @@
+# test objects allocated as long-lived, which is the case for the functions,
+# classes and namespaces created by code run in a namespace other than __main__
+
+import gc
+
+src = """
+class A:
+    x = 1
+    def f(self, a=2):
+        return self.x + a
+def g(n):
+    return [A().f(i) for i in range(n)]
+names = {}
+for i in range(20):
+    names['k%d' % i] = lambda i=i: i * i
+"""
+
+# the objects are usable and survive collections
+ns = {}
+exec(src, ns)
+gc.collect()
+print(ns['g'](4), ns['names']['k7'](), sorted(k for k in ns if not k.startswith('_')))
+
+# dropping them frees the memory for other use
+for i in range(20):
+    ns2 = {}
+    exec(src, ns2)
+    ns2['A'].y = bytearray(1000)
+    del ns2
+    gc.collect()
+big = [bytearray(500) for i in range(10)]
+print(len(big), ns['A']().f())
@@ -0,0 +1,31 @@
+# test minor collections, which only reclaim objects in the nursery
+
+import gc
+
+# objects reachable only through objects that survived a major collection
+# must survive a minor one
+old = []
+d = {}
+gc.collect()
+
+def fill():
+    for i in range(20):
+        old.append((i, str(i)))
+        d[i] = [i] * 3
+
+fill()
+gc.collect(0)
+print(old[5], d[7])
+
+# short-lived garbage is reclaimed without disturbing the live objects
+for i in range(1000):
+    t = (i, i + 1)
+    l = [t] * 2
+gc.collect(0)
+print(sum(i for i, _ in old), sum(sum(v) for v in d.values()))
+
+x = [1.5 * i for i in range(50)]
+gc.collect(0)
+gc.collect()
+gc.collect(0)
+print(sum(x), ''.join(s for _, s in old))
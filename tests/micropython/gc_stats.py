@@ -0,0 +1,28 @@
+# test gc.stats(), the counters of collections and allocations
+import gc
+import sys
+try:
+    gc.stats
+except AttributeError:
+    print('SKIP')
+    sys.exit()
+
+s0 = gc.stats()
+print(len(s0), all(isinstance(x, int) and x >= 0 for x in s0))
+
+# an explicit collection is counted and timed, but not as caused by an
+# allocation failing
+gc.collect()
+s1 = gc.stats()
+print(s1[0] > s0[0], s1[1] == s0[1], s1[2] >= s0[2], s1[3] <= s1[2])
+
+# allocations are counted, in bytes and in objects
+l = [bytearray(100) for i in range(10)]
+s2 = gc.stats()
+print(s2[4] - s1[4] >= 1000, s2[5] - s1[5] >= 10)
+
+# filling up the heap makes allocations trigger collections
+for i in range(100000):
+    l = [i, i + 1, i + 2]
+s3 = gc.stats()
+print(s3[1] > s2[1], s3[0] - s2[0] >= s3[1] - s2[1])
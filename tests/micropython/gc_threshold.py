@@ -0,0 +1,34 @@
+# test gc.threshold(), which runs a collection once enough has been allocated
+import gc
+import sys
+try:
+    gc.threshold
+    gc.stats
+except AttributeError:
+    print('SKIP')
+    sys.exit()
+
+print(gc.threshold())
+
+gc.threshold(4096)
+print(gc.threshold())
+gc.collect()
+s0 = gc.stats()
+for i in range(1000):
+    l = [i, i + 1, i + 2]
+s1 = gc.stats()
+# collections were run before the heap filled up
+print(s1[0] - s0[0] > 1, s1[1] == s0[1])
+
+gc.threshold(-1)
+print(gc.threshold())
+
+# no collection while disabled
+gc.disable()
+gc.threshold(4096)
+s0 = gc.stats()
+for i in range(1000):
+    l = [i, i + 1, i + 2]
+print(gc.stats()[0] == s0[0])
+gc.enable()
+gc.threshold(-1)
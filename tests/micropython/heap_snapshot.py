@@ -0,0 +1,21 @@
+# test micropython.heap_snapshot(), a copy of the allocation table
+import micropython
+import sys
+try:
+    micropython.heap_snapshot
+except AttributeError:
+    print('SKIP')
+    sys.exit()
+
+s = micropython.heap_snapshot()
+print(type(s), s[:2])
+block_size = s[2] | s[3] << 8
+n_blocks = s[4] | s[5] << 8 | s[6] << 16 | s[7] << 24
+print(block_size in (16, 32), len(s) == 8 + n_blocks)
+print(all(c in b'.=mTLDSAFBMh' for c in s[8:]))
+
+# a new bytearray shows up as one more head of that kind
+n = s.count(b'A')
+b = bytearray(4 * block_size)
+s = micropython.heap_snapshot()
+print(s.count(b'A') - n)
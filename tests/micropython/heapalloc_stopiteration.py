@@ -0,0 +1,46 @@
+# check that exhausting iterators and generators doesn't allocate heap memory
+
+import gc
+import sys
+try:
+    gc.stats
+except AttributeError:
+    print('SKIP')
+    sys.exit()
+
+def gen():
+    yield 1
+    return 2
+
+def stop_next(it):
+    try:
+        next(it)
+    except StopIteration:
+        pass
+
+def stop_send(g):
+    try:
+        g.send(None)
+    except StopIteration:
+        pass
+
+def test(it, g1, g2):
+    for i in range(10):
+        stop_next(it)
+        stop_send(g2)
+    for x in g1:
+        pass
+
+# create the iterators first, then count the objects allocated while
+# exhausting them, less those allocated by gc.stats() itself
+def measure(it, g1, g2):
+    n0 = gc.stats()[5]
+    n1 = gc.stats()[5]
+    test(it, g1, g2)
+    n2 = gc.stats()[5]
+    print(n2 - n1 - (n1 - n0))
+
+g = gen()
+next(g)
+stop_send(g)
+measure(iter([]), gen(), g)
@@ -0,0 +1,36 @@
+# check that a list can grow into the room made by list_reserve
+
+import micropython
+
+try:
+    micropython.list_reserve
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+l = [1]
+micropython.list_reserve(l, 20)
+print(l)
+
+# appends that fit don't allocate
+i = 0
+micropython.heap_lock()
+while i < 19:
+    l.append(i)
+    i += 1
+micropython.heap_unlock()
+print(len(l), l[-1])
+
+# reserving less than the length does nothing
+micropython.list_reserve(l, 2)
+print(len(l))
+
+try:
+    micropython.list_reserve(l, -1)
+except ValueError:
+    print('ValueError')
+try:
+    micropython.list_reserve((), 1)
+except TypeError:
+    print('TypeError')
@@ -0,0 +1,42 @@
+# test 2D memoryviews made by memoryview.cast (not supported by CPython)
+try:
+    memoryview(b'').cast
+except (NameError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+# 2D views
+fb = bytearray(range(12))
+m = memoryview(fb).cast('B', (3, 4))
+print(len(m), isinstance(m, memoryview))
+print([list(row) for row in m])
+print(m[1, 2], m[-1, -1], list(m[2]), list(m[1, 1:3]))
+m[2, 0] = 100
+print(fb[8])
+
+# sub-rectangles share the buffer, with rows a stride apart
+sub = m[1:3, 1:3]
+print(len(sub), [list(row) for row in sub])
+sub[0, 0] = 200
+print(fb[5])
+print(bytes(m[1:]))
+try:
+    bytes(sub)
+except TypeError:
+    print('TypeError')
+
+try:
+    memoryview(fb).cast('B', (5, 5))
+except TypeError:
+    print('TypeError')
+try:
+    m[3, 0]
+except IndexError:
+    print('IndexError')
+
+# a cast must start on a whole item of the new type
+try:
+    memoryview(b'abcde')[1:].cast('h')
+except ValueError:
+    print('ValueError')
@@ -0,0 +1,97 @@
+# test natively compiled generators
+
+# yield, send and return
+@micropython.native
+def gen(n):
+    for i in range(n):
+        x = yield i
+        if x:
+            print('got', x)
+    return 'done' if n == 3 else None
+print(list(gen(2)))
+g = gen(3)
+print(next(g), g.send(7), next(g))
+try:
+    next(g)
+except StopIteration as e:
+    print('StopIteration', e.args)
+print(repr(gen(1))[:23])
+
+# arguments, closures and many locals
+@micropython.native
+def gen(a, b=2, *args, c, **kw):
+    def inner():
+        return a + b
+    d, e, f, g = 1, 2, 3, 4
+    yield inner()
+    yield args
+    yield c
+    yield sorted(kw.items())
+    yield d + e + f + g
+print(list(gen(1, 5, 6, c=3, d=4)))
+
+# exception thrown into a generator, and closing it
+@micropython.native
+def gen():
+    try:
+        yield 1
+        yield 2
+    except ValueError:
+        print('caught ValueError')
+        yield 3
+    finally:
+        print('finally')
+g = gen()
+print(next(g), g.throw(ValueError))
+g.close()
+
+# exception raised by a generator
+@micropython.native
+def gen():
+    yield 1
+    raise KeyError('k')
+try:
+    for v in gen():
+        print(v)
+except KeyError as e:
+    print('KeyError', e)
+
+class CtxMgr:
+    def __enter__(self):
+        print('enter')
+        return 1
+    def __exit__(self, a, b, c):
+        print('exit', a)
+
+# yield within a with statement
+@micropython.native
+def gen():
+    with CtxMgr() as v:
+        yield v
+        yield v + 1
+g = gen()
+print(next(g))
+g.close()
+print(list(gen()))
+
+# yield from generators and other iterables, passing on exceptions
+@micropython.native
+def sub_gen():
+    try:
+        yield 1
+        yield 2
+    except ValueError as e:
+        print('sub_gen got', e)
+        yield 99
+    return 'ret'
+
+@micropython.native
+def gen():
+    r = yield from sub_gen()
+    print('returned', r)
+    yield from [10, 11]
+print(list(gen()))
+g = gen()
+print(next(g))
+print(g.throw(ValueError('v')))
+print(list(g))
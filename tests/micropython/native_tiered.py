@@ -0,0 +1,49 @@
+# test bytecode functions being recompiled to native code once they are hot
+
+import micropython
+
+try:
+    micropython.native_threshold
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+micropython.native_threshold(3)
+print(micropython.native_threshold())
+
+# only code compiled while a threshold is set can be promoted
+exec("""
+def f(a, b=2, *, c=3):
+    s = 0
+    for i in range(a):
+        s += i * b + c
+    return s
+
+def fib(n):
+    return n if n < 2 else fib(n - 1) + fib(n - 2)
+
+def gen(n):
+    for i in range(n):
+        yield i
+
+def exc(x):
+    try:
+        raise ValueError(x)
+    except ValueError as e:
+        return e.args[0] + 1
+
+def outer(k):
+    def inner(x):
+        return x + k
+    return inner
+
+lam = lambda x: [y * x for y in range(3)]
+""")
+
+for i in range(6):
+    print(i, f(i), f(i, 1), f(i, c=0), fib(i), list(gen(i)), exc(i), outer(i)(1), lam(i))
+
+# promoted functions keep their identity
+print(type(f).__name__, f.__name__)
+
+micropython.native_threshold(0)
@@ -0,0 +1,119 @@
+# test try/except/finally and with statements in natively compiled functions
+
+# exceptions caught, and finally run, on return
+@micropython.native
+def f(x):
+    try:
+        if x:
+            raise ValueError(x)
+        return 1
+    except ValueError as e:
+        print('caught', e)
+        return 2
+    finally:
+        print('finally', x)
+print(f(0), f(5))
+
+# return in finally overrides the pending return
+@micropython.native
+def f():
+    try:
+        return 1
+    finally:
+        return 2
+print(f())
+
+# break and continue run finally blocks
+@micropython.native
+def f():
+    for i in range(5):
+        try:
+            if i == 1:
+                continue
+            if i == 3:
+                break
+            print('body', i)
+        finally:
+            print('finally', i)
+    return i
+print(f())
+
+# nested handlers in a loop, with locals modified in them
+@micropython.native
+def f():
+    s = 0
+    for i in range(100):
+        try:
+            try:
+                if i % 3:
+                    raise ValueError
+                s += i
+            finally:
+                s += 2
+        except ValueError:
+            s -= 1
+    return s
+print(f())
+
+# bare raise re-raises the exception being handled
+@micropython.native
+def f():
+    try:
+        try:
+            raise ValueError('a')
+        except ValueError:
+            try:
+                raise TypeError('b')
+            except TypeError:
+                pass
+            raise
+    except ValueError as e:
+        print('reraised', e)
+f()
+
+# bare raise with no exception being handled
+@micropython.native
+def f():
+    raise
+try:
+    f()
+except RuntimeError:
+    print('RuntimeError')
+
+class CtxMgr:
+    def __init__(self, n):
+        self.n = n
+    def __enter__(self):
+        print('enter', self.n)
+        return self
+    def __exit__(self, a, b, c):
+        print('exit', self.n, a)
+        return self.n == 2
+
+# with statements, with an exception swallowed by __exit__ or not
+@micropython.native
+def f(n):
+    a = 1
+    with CtxMgr(n) as c:
+        a = 2
+        if n:
+            raise KeyError(n)
+    return a
+print(f(0))
+print(f(2))
+try:
+    f(1)
+except KeyError as e:
+    print('KeyError', e)
+
+# leaving with statements by continue and return
+@micropython.native
+def f(l):
+    for x in l:
+        with CtxMgr(x):
+            if x == 1:
+                continue
+            if x == 3:
+                return 'return'
+            print('x', x)
+print(f([0, 1, 3, 4]))
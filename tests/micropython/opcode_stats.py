@@ -0,0 +1,39 @@
+# test micropython.opcode_stats(), the VM's opcode counter
+
+import micropython
+
+try:
+    micropython.opcode_stats
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+MP_BC_JUMP = 0x35
+MP_BC_FOR_ITER = 0x43
+STORE_X = 0xc1 # STORE_FAST_MULTI for x, the second local
+
+def loop(l):
+    for x in l:
+        pass
+
+micropython.opcode_stats(True)
+loop([1] * 100)
+counts, pairs, dropped = micropython.opcode_stats(True)
+print(len(counts), dropped)
+
+# the loop runs FOR_ITER once more than its body
+print(counts[MP_BC_FOR_ITER], counts[MP_BC_JUMP])
+pairs = {(a, b): n for a, b, n in pairs}
+print(pairs[(MP_BC_FOR_ITER, STORE_X)])
+print(pairs[(STORE_X, MP_BC_JUMP)])
+print(pairs[(MP_BC_JUMP, MP_BC_FOR_ITER)])
+
+# the pairs are sorted, most counted first
+counts, pairs, dropped = micropython.opcode_stats()
+print(all(pairs[i][2] >= pairs[i + 1][2] for i in range(len(pairs) - 1)))
+
+# resetting clears the counts once they are read
+micropython.opcode_stats(True)
+counts, pairs, dropped = micropython.opcode_stats()
+print(sum(counts) < 20, len(pairs) < 20)
@@ -0,0 +1,45 @@
+# test micropython.profile(), the sampling profiler
+
+import micropython
+
+try:
+    micropython.profile
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+def busy(n):
+    x = 0
+    for i in range(n):
+        x += i * i
+    return x
+
+def samples():
+    lines, dropped = micropython.profile_stats()
+    return sum(l[0] for l in lines) + dropped
+
+micropython.profile(1)
+for i in range(2000):
+    busy(2000)
+    if i % 10 == 0 and samples() >= 20:
+        break
+micropython.profile(0)
+
+# the loop in busy is where most of the time goes
+lines, dropped = micropython.profile_stats()
+print(dropped)
+count, file, name, line = lines[0]
+print(name, line, file.endswith('profile.py'))
+print(all(lines[i][0] >= lines[i + 1][0] for i in range(len(lines) - 1)))
+
+# the samples are kept once stopped, and cleared when started again
+print(micropython.profile_stats()[0] == lines)
+micropython.profile(1)
+micropython.profile(0)
+print(micropython.profile_stats())
+
+try:
+    micropython.profile(-1)
+except ValueError:
+    print('ValueError')
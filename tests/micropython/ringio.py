@@ -0,0 +1,54 @@
+# test micropython.RingIO
+import micropython
+
+try:
+    micropython.RingIO
+except AttributeError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+r = micropython.RingIO(8)
+print(len(r), bool(r), r.any(), r.free())
+
+# writes only what fits
+print(r.write(b'hello\nworld'))
+print(len(r), bool(r), r.free())
+print(r.readline())
+print(r.read())
+print(r.read())
+
+# wrap around the end of the buffer
+for i in range(5):
+    r.write(b'abcde')
+    print(r.read(3), r.read(3))
+
+# storage given by a buffer, one byte is unused
+b = bytearray(5)
+r = micropython.RingIO(b)
+print(r.write(b'123456'), r.free())
+buf = bytearray(3)
+print(r.readinto(buf), buf)
+r.clear()
+print(r.any())
+
+# iteration by lines
+r = micropython.RingIO(16)
+r.write(b'a\nbc\n')
+print(list(r))
+
+# no allocation once created
+r = micropython.RingIO(16)
+buf = bytearray(4)
+n = 0
+micropython.heap_lock()
+r.write(b'wxyz')
+n = r.readinto(buf)
+micropython.heap_unlock()
+print(n, buf)
+
+for arg in (0, 65535):
+    try:
+        micropython.RingIO(arg)
+    except ValueError:
+        print('ValueError')
@@ -0,0 +1,77 @@
+# test micropython.schedule() function
+
+import micropython
+
+try:
+    micropython.schedule
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+# Basic test of scheduling a function.
+
+def callback(arg):
+    global done
+    print(arg)
+    done = True
+
+done = False
+micropython.schedule(callback, 1)
+while not done:
+    pass
+
+# Test that callbacks run in the order they were scheduled.
+
+done = False
+for i in range(2, 5):
+    micropython.schedule(callback, i)
+while not done:
+    pass
+for i in range(100):
+    pass
+
+# Test that a scheduled function doesn't interrupt another one.
+
+def callback_inner(arg):
+    global done
+    print('inner')
+    done += 1
+
+def callback_outer(arg):
+    global done
+    micropython.schedule(callback_inner, 0)
+    # need a loop so that the VM can check for pending events
+    for i in range(2):
+        pass
+    print('outer')
+    done += 1
+
+done = 0
+micropython.schedule(callback_outer, 0)
+while done != 2:
+    pass
+
+# Test that the queue can fill up.
+
+def callback(arg):
+    global done
+    done += 1
+
+done = 0
+s = micropython.schedule
+try:
+    # no loop here, so nothing is run until the queue is full
+    s(callback, 1)
+    s(callback, 1)
+    s(callback, 1)
+    s(callback, 1)
+    s(callback, 1)
+    s(callback, 1)
+    s(callback, 1)
+    s(callback, 1)
+except RuntimeError:
+    print('RuntimeError')
+while done < 4:
+    pass
+print(done)
@@ -0,0 +1,27 @@
+# test Struct.unpack_into, which writes into an existing list
+try:
+    import ustruct as struct
+    struct.Struct
+except (ImportError, AttributeError):
+    print("SKIP")
+    import sys
+    sys.exit()
+import micropython
+
+s = struct.Struct('<hBb')
+data = s.pack(1000, 200, -5) + s.pack(-1, 2, 3)
+l = [None] * 3
+s.unpack_into(l, data)
+print(l)
+
+# decoding records into a list doesn't allocate
+micropython.heap_lock()
+s.unpack_into(l, data, s.size)
+micropython.heap_unlock()
+print(l)
+
+for args in (([0, 0], data), ((0, 0, 0), data), (l, b'a')):
+    try:
+        s.unpack_into(*args)
+    except (TypeError, ValueError) as e:
+        print(type(e).__name__)
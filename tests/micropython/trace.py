@@ -0,0 +1,51 @@
+# test micropython.trace(), which records calls of Python functions
+
+import micropython
+
+try:
+    micropython.trace
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+def inner(x):
+    return x + 1
+
+def outer(x):
+    return inner(x) * 2
+
+def fail():
+    raise ValueError
+
+micropython.trace(True)
+outer(1)
+try:
+    fail()
+except ValueError:
+    pass
+micropython.trace(False)
+outer(2) # not traced
+
+calls = micropython.trace_calls()
+for name, start, duration, raised in calls:
+    print(name, raised)
+
+# a call ends after the calls it makes
+inner_call, outer_call = calls[0], calls[1]
+print(outer_call[1] <= inner_call[1])
+print(inner_call[1] + inner_call[2] <= outer_call[1] + outer_call[2])
+
+# the ring keeps the latest calls
+micropython.trace(True)
+for i in range(1000):
+    inner(i)
+outer(0)
+micropython.trace(False)
+calls = micropython.trace_calls()
+print(len(calls) < 1000, calls[-2][0], calls[-1][0])
+
+# starting again discards the calls
+micropython.trace(True)
+micropython.trace(False)
+print(micropython.trace_calls())
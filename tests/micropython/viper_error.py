@@ -57,3 +57,7 @@ test("@micropython.viper\ndef f(): raise 1")
 test("@micropython.viper\ndef f(x:int): +x")
 test("@micropython.viper\ndef f(x:int): -x")
 test("@micropython.viper\ndef f(x:int): ~x")
+
+# generators not implemented
+test("@micropython.viper\ndef f(): yield 1")
+test("@micropython.viper\ndef f(): yield from f")
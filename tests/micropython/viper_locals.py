@@ -0,0 +1,85 @@
+# test viper functions with more locals than registers, used in and out of loops
+
+@micropython.viper
+def f4(a:int, b:int, c:int, d:int) -> int:
+    # the arguments are used least, so they don't get registers
+    s = 0
+    i = 0
+    while i < 10:
+        s += i * 3
+        i += 1
+    return a + b + c + d + s
+print(f4(1, 2, 3, 4))
+
+@micropython.viper
+def sums(buf:ptr8, n:int) -> int:
+    s0 = 0
+    s1 = 0
+    s2 = 0
+    s3 = 0
+    s4 = 0
+    s5 = 0
+    s6 = 0
+    for i in range(n):
+        x = buf[i]
+        s0 += x
+        s1 += x * 2
+        s2 ^= x
+        s3 += s0
+        s4 |= x
+        s5 += 1
+        s6 = s6 - x
+    return s0 + s1 + s2 + s3 + s4 + s5 + s6
+print(sums(bytearray(b'\x01\x02\x03\x04\x05\x06\x07\x08'), 8))
+
+@micropython.viper
+def copy(dst:ptr8, src:ptr8, src16:ptr16, dst16:ptr16):
+    n = 3
+    a = 0
+    b = 0
+    c = 0
+    d = 0
+    for i in range(n):
+        a = src[i]
+        b = src16[i]
+        dst[i] = a + 1
+        dst16[i] = b + 1
+        c += a
+        d += b
+    dst[n] = c
+    dst16[n] = d
+dst = bytearray(4)
+dst16 = bytearray(8)
+copy(dst, bytearray(b'\x01\x02\x03'), bytearray(b'\x01\x00\x02\x00\x03\x01'), dst16)
+print(dst, dst16)
+
+# nested loops, with the inner locals weighing most
+@micropython.viper
+def nested(n:int) -> int:
+    t = 0
+    u = 0
+    v = 0
+    for i in range(n):
+        for j in range(n):
+            k = 0
+            while k < j:
+                t += k
+                k += 1
+            u += j
+        v += i
+    return t * 10000 + u * 100 + v
+print(nested(5))
+
+# native functions keep locals in registers too
+@micropython.native
+def nat(l):
+    a = 1
+    b = 2
+    c = 3
+    d = 4
+    e = 5
+    f = 6
+    for x in l:
+        a, b, c, d, e, f = b, c, d, e, f, a + x
+    return a, b, c, d, e, f
+print(nat([10, 20, 30]))
@@ -0,0 +1,37 @@
+# test loading from and storing to ptr16s type
+# only works on little endian machines
+
+try:
+    import array
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+@micropython.viper
+def get(src:ptr16s) -> int:
+    return src[0]
+
+@micropython.viper
+def get1(src:ptr16s) -> int:
+    return src[1]
+
+@micropython.viper
+def memadd(src:ptr16s, n:int) -> int:
+    sum = 0
+    for i in range(n):
+        sum += src[i]
+    return sum
+
+@micropython.viper
+def memneg(buf_in):
+    buf = ptr16s(buf_in)
+    n = int(len(buf_in))
+    for i in range(n):
+        buf[i] = 0 - buf[i]
+
+a = array.array('h', [-1, 32767, -32768, 2])
+print(get(a), get1(a))
+print(memadd(a, 4))
+memneg(a)
+print(a)
@@ -0,0 +1,70 @@
+# test viper ptrf and float types
+
+try:
+    import array
+    array.array('f')
+except (ImportError, ValueError):
+    print("SKIP")
+    import sys
+    sys.exit()
+
+@micropython.viper
+def get(src:ptrf, i:int) -> float:
+    return src[i]
+
+@micropython.viper
+def fill(dst:ptrf, n:int):
+    for i in range(n):
+        dst[i] = i
+
+@micropython.viper
+def scale(buf:ptrf, n:int, k:float):
+    for i in range(n):
+        buf[i] = buf[i] * k + 0.5
+
+@micropython.viper
+def mean(src:ptrf, n:int) -> float:
+    sum = float(0)
+    for i in range(n):
+        sum += src[i]
+    return sum / n
+
+@micropython.viper
+def to_int16(src:ptrf, dst:ptr16s, n:int):
+    for i in range(n):
+        dst[i] = int(src[i])
+
+@micropython.viper
+def compare(a:float, b:float):
+    print(a < b, a > b, a == b, a <= b, a >= b, a != b)
+
+f = array.array('f', [0.5, 1.5])
+print(get(f, 0), get(f, 1))
+f = array.array('f', 4 * [0])
+fill(f, 4)
+print(f)
+scale(f, 4, -2.0)
+print(f)
+print(mean(f, 4))
+h = array.array('h', 4 * [0])
+to_int16(f, h, 4)
+print(h)
+compare(1, 2)
+compare(2.5, 2.5)
+
+try:
+    mean(f, 0)
+except ZeroDivisionError:
+    print("ZeroDivisionError")
+
+# type errors
+def test(code):
+    try:
+        exec(code)
+    except ViperTypeError as e:
+        print(repr(e))
+
+test("@micropython.viper\ndef f(x:float): ptr8(x)")
+test("@micropython.viper\ndef f(x:ptrf, y:ptr): x[0] = y")
+test("@micropython.viper\ndef f(x:ptr16, y:float): x[0] = y")
+test("@micropython.viper\ndef f(x:float): x // 2")
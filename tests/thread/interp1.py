@@ -0,0 +1,93 @@
+# test _interp: interpreters that run in parallel and talk over channels
+
+try:
+    import _interp
+except ImportError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+# each interpreter has its own heap, threads and globals, so this runs the
+# same in all of them and the garbage collectors don't get in each other's way
+src = """
+import _thread
+req, resp = channels
+lock = _thread.allocate_lock()
+total = [0]
+def work(data):
+    l = []
+    for i in range(500):
+        l.append(data * (i % 8))
+        if len(l) > 20:
+            l = []
+    with lock:
+        total[0] += len(data)
+while True:
+    data = req.recv()
+    if data is None:
+        break
+    _thread.start_new_thread(work, (data,))
+    work(data)
+    while total[0] < 2 * len(data):
+        pass
+    resp.send(b'%s %d' % (__name__, total[0]))
+    total[0] = 0
+resp.close()
+"""
+chans = [(_interp.Channel(), _interp.Channel()) for i in range(4)]
+interps = [_interp.start(src, ch, heap_size=32 * 1024) for ch in chans]
+for n in range(3):
+    for req, resp in chans:
+        req.send(bytearray(n + 1))
+    print([resp.recv() for req, resp in chans])
+for req, resp in chans:
+    req.close()
+    print(resp.recv())
+print([i.join() for i in interps])
+
+# the exit status is 1 for an uncaught exception, or given by SystemExit
+print(_interp.start("import sys; sys.exit(3)").join())
+print(_interp.start("import sys; sys.exit()").join())
+
+# nothing is shared, and sys.path is a copy
+import sys
+c = _interp.Channel()
+i = _interp.start("import sys; sys.path.append('x'); channels[0].send(repr(sys.path))", (c,))
+print(c.recv() == bytes(repr(sys.path + ['x']), 'utf8'), i.join())
+print('x' in sys.path)
+
+# messages are copied
+c = _interp.Channel()
+buf = bytearray(b'abc')
+c.send(buf)
+buf[0] = 0
+print(c.recv())
+
+# recv times out, and close ends the stream but what was sent is kept
+try:
+    c.recv(0.01)
+except OSError as er:
+    print('OSError', er.args[0] == 110)
+c.send(b'last')
+c.close()
+print(c.recv(), c.recv())
+try:
+    c.send(b'')
+except OSError:
+    print('OSError')
+
+# bad arguments
+try:
+    _interp.start("", (1,))
+except TypeError:
+    print('TypeError')
+try:
+    _interp.start("", heap_size=10)
+except ValueError:
+    print('ValueError')
+i = _interp.start("")
+i.join()
+try:
+    i.join()
+except ValueError:
+    print('ValueError')
@@ -0,0 +1,73 @@
+# test _thread.Event and _thread.Condition
+
+import _thread
+try:
+    _thread.Event
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+e = _thread.Event()
+print(e.is_set(), e.wait(0.01))
+e.set()
+print(e.is_set(), e.wait(), e.wait(0))
+e.clear()
+print(e.is_set())
+
+# threads waiting on an event are all woken when it's set
+n_thread = 4
+n_woken = 0
+lock = _thread.allocate_lock()
+done = _thread.Event()
+
+def waiter():
+    global n_woken
+    e.wait()
+    with lock:
+        n_woken += 1
+        if n_woken == n_thread:
+            done.set()
+
+for i in range(n_thread):
+    _thread.start_new_thread(waiter, ())
+e.set()
+print(done.wait(10), n_woken)
+
+# a condition must be held to wait on or notify it
+c = _thread.Condition()
+for f in (c.wait, c.notify, c.notify_all, c.release):
+    try:
+        f()
+    except RuntimeError:
+        print('RuntimeError')
+with c:
+    print(c.wait(0.01))
+print(c.acquire(False))
+print(c.acquire(False))
+c.release()
+
+# hand items over one at a time with a condition
+items = []
+n_item = 100
+
+def consumer():
+    got = 0
+    while got < n_item:
+        with c:
+            while not items:
+                c.wait()
+            items.pop()
+            got += 1
+            c.notify()
+    done.set()
+
+done.clear()
+_thread.start_new_thread(consumer, ())
+for i in range(n_item):
+    with c:
+        while items:
+            c.wait()
+        items.append(i)
+        c.notify()
+print(done.wait(10))
@@ -0,0 +1,46 @@
+# test that objects held by threads blocked on a lock or in sleep survive
+# many collections made while they are blocked
+
+import gc
+try:
+    import utime as time
+except ImportError:
+    import time
+import _thread
+
+def thread_entry(i, lock):
+    # keep the only reference to this data on the thread's stack
+    data = bytearray(j & 0xff for j in range(i, i + 256))
+    if i & 1:
+        lock.acquire()
+    else:
+        time.sleep(0.2)
+    ok = list(data) == [j & 0xff for j in range(i, i + 256)]
+    with print_lock:
+        results.append(ok)
+
+print_lock = _thread.allocate_lock()
+results = []
+n_thread = 8
+locks = []
+for i in range(n_thread):
+    lock = _thread.allocate_lock()
+    lock.acquire()
+    locks.append(lock)
+    _thread.start_new_thread(thread_entry, (i, lock))
+
+# churn the heap while the threads are blocked
+time.sleep(0.05)
+for i in range(20):
+    [bytearray(64) for _ in range(50)]
+    gc.collect()
+
+for lock in locks:
+    lock.release()
+
+while True:
+    with print_lock:
+        if len(results) == n_thread:
+            break
+    time.sleep(0.01)
+print(results.count(True) == n_thread)
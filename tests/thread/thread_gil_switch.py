@@ -0,0 +1,28 @@
+# test that a thread which never blocks doesn't starve the others
+
+import _thread
+
+n_thread = 3
+counts = [0] * n_thread
+stop = False
+n_finished = 0
+lock = _thread.allocate_lock()
+
+def thread_entry(i):
+    global n_finished
+    while not stop:
+        counts[i] += 1
+    with lock:
+        n_finished += 1
+
+for i in range(n_thread):
+    _thread.start_new_thread(thread_entry, (i,))
+
+# spin, without blocking, until all the threads got to run for a while
+while min(counts) < 1000:
+    pass
+stop = True
+
+while n_finished < n_thread:
+    pass
+print('done', n_thread)
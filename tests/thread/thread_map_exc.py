@@ -0,0 +1,47 @@
+# test that a map or set is still usable by other threads after an exception
+# is raised by a key while it is being looked up
+
+import _thread
+
+class Key:
+    def __hash__(self):
+        return 1
+    def __eq__(self, other):
+        if isinstance(other, Key):
+            raise ValueError
+        return False
+
+d = {Key(): 1}
+s = {Key()}
+
+# the exceptions are raised while the lookups are in progress
+for i in range(2):
+    try:
+        d[Key()] = 2
+    except ValueError:
+        print('dict ValueError')
+    try:
+        Key() in s
+    except ValueError:
+        print('set ValueError')
+
+def th():
+    for i in range(100):
+        d[i] = i
+        s.add(i)
+    with lock:
+        global n_finished
+        n_finished += 1
+
+lock = _thread.allocate_lock()
+n_thread = 2
+n_finished = 0
+
+for i in range(n_thread):
+    _thread.start_new_thread(th, ())
+
+# busy wait for threads to finish
+while n_finished < n_thread:
+    pass
+
+print(len(d), len(s))
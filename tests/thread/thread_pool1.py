@@ -0,0 +1,65 @@
+# test _thread.Pool and the futures it returns
+
+import _thread
+try:
+    _thread.Pool
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+def add(a, b=0):
+    return a + b
+
+# results come back in the futures they were submitted with
+with _thread.Pool(3) as pool:
+    fs = [pool.submit(add, i, b=i) for i in range(50)]
+    print([f.result() for f in fs] == [2 * i for i in range(50)])
+    print(all(f.done() for f in fs), fs[0].exception())
+
+    # exceptions are raised by result() and returned by exception()
+    f = pool.submit(int, 'x')
+    try:
+        f.result()
+    except ValueError:
+        print('ValueError')
+    print(type(f.exception()))
+
+    # a call that hasn't finished times out
+    e = _thread.Event()
+    f = pool.submit(e.wait)
+    print(f.done())
+    try:
+        f.result(0.01)
+    except OSError:
+        print('timeout')
+    e.set()
+    print(f.result(), f.done())
+
+    # the workers run calls at the same time
+    n = 3
+    lock = _thread.allocate_lock()
+    count = [0]
+    all_in = _thread.Event()
+    def worker():
+        with lock:
+            count[0] += 1
+            if count[0] == n:
+                all_in.set()
+        return all_in.wait(10)
+    print([f.result() for f in [pool.submit(worker) for i in range(n)]])
+
+# queued calls are still made by shutdown() and the pool then refuses more
+pool = _thread.Pool(1)
+fs = [pool.submit(add, i) for i in range(10)]
+pool.shutdown()
+print([f.result() for f in fs])
+try:
+    pool.submit(add, 1)
+except RuntimeError:
+    print('RuntimeError')
+
+try:
+    _thread.Pool(0)
+except ValueError:
+    print('ValueError')
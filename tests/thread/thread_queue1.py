@@ -0,0 +1,64 @@
+# test _thread.Queue passing work between threads
+
+import _thread
+try:
+    _thread.Queue
+except AttributeError:
+    print('SKIP')
+    import sys
+    sys.exit()
+
+# non-blocking and timed operations on a bounded queue
+q = _thread.Queue(2)
+print(q.empty(), q.full(), q.qsize())
+q.put(1)
+q.put(2)
+print(q.empty(), q.full(), q.qsize())
+for kw in ({'block': False}, {'timeout': 0.01}):
+    try:
+        q.put(3, **kw)
+    except OSError:
+        print('full')
+print(q.get(), q.get())
+for kw in ({'block': False}, {'timeout': 0.01}):
+    try:
+        q.get(**kw)
+    except OSError:
+        print('empty')
+
+# the queue grows as needed, keeping the order of the items
+q = _thread.Queue()
+for i in range(5):
+    q.put(i)
+print(q.get(), q.get())
+for i in range(5, 20):
+    q.put(i)
+print([q.get() for i in range(q.qsize())])
+
+# a pipeline of threads, with small queues so producers have to wait
+n_item = 200
+q_in = _thread.Queue(4)
+q_out = _thread.Queue(4)
+
+def worker():
+    while True:
+        x = q_in.get()
+        if x is None:
+            break
+        q_out.put(x * x)
+    q_out.put(None)
+
+def producer():
+    for i in range(n_item):
+        q_in.put(i)
+    q_in.put(None)
+
+_thread.start_new_thread(worker, ())
+_thread.start_new_thread(producer, ())
+total = 0
+while True:
+    x = q_out.get()
+    if x is None:
+        break
+    total += x
+print(total == sum(i * i for i in range(n_item)))
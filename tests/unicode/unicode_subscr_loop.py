@@ -0,0 +1,33 @@
+# index the same str over and over, in different orders, as loops do
+
+def check(s):
+    n = len(s)
+    fwd = ''.join(s[i] for i in range(n))
+    rev = ''.join(s[i] for i in range(n - 1, -1, -1))
+    neg = ''.join(s[-i] for i in range(1, n + 1))
+    jump = ''.join(s[i * 7 % n] for i in range(n))
+    print(fwd == s, rev == ''.join(reversed(fwd)), neg == rev, len(jump) == n)
+    print(','.join(s[i:i + 3] for i in range(0, n, 5)))
+    try:
+        s[n]
+    except IndexError:
+        print('IndexError')
+    print(s[n - 1:n + 10], s[-n - 10:1])
+
+check('abcdefghijklmnopqrstuvwxyz')
+check('aб€😀' * 5)
+check('ascii prefix then ¢пр€ then more ascii')
+
+# indexing two strs in turn, and a str whose len() isn't taken
+a = 'x¢' * 10
+b = 'пр' * 10
+print(''.join(a[i] + b[i] for i in range(0, 20, 3)))
+c = '€a' * 10
+print(c[19], c[0], c[18], c[1], c[-1], c[10])
+
+# a str built up with +=
+s = ''
+for i in range(20):
+    s += 'aé'[i % 2]
+    print(s[i], s[i // 2], end=' ')
+print()
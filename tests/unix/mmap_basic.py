@@ -0,0 +1,63 @@
+# test the unix mmap module on a small temporary file
+try:
+    import mmap
+    import uos
+    import ustruct
+    import ure
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+NAME = "mmap_basic.tmp"
+
+with open(NAME, "wb") as f:
+    f.write(b"hello mmap\x01\x02\x03\x04" + b"." * 4082)
+
+f = open(NAME, "r+b")
+
+# map the whole file
+m = mmap.mmap(f.fileno(), 0)
+print(len(m), m[0], m[0:10], m[-1])
+
+# buffer protocol, with no copy of the file data
+mv = memoryview(m)
+print(mv[6:10] == b"mmap")
+print(ustruct.unpack_from("<I", m, 10))
+print(ure.match(b"hello", m[0:10]) is not None)
+
+# writes go to the file
+m[0] = ord("H")
+mv[1] = ord("E")
+del mv
+m.flush()
+m.madvise(mmap.MADV_SEQUENTIAL)
+m.madvise(mmap.MADV_WILLNEED, 0, 10)
+m.close()
+f.seek(0)
+print(f.read(5))
+
+# closed
+try:
+    m[0]
+except ValueError:
+    print("ValueError")
+
+# read-only mapping, as a context manager
+with mmap.mmap(f.fileno(), 10, access=mmap.ACCESS_READ) as m:
+    print(len(m), bytes(m))
+    try:
+        m[0] = 0
+    except TypeError:
+        print("TypeError")
+
+# private mapping doesn't change the file
+m = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_COPY)
+m[0] = ord("x")
+print(m[0:5])
+m.close()
+f.seek(0)
+print(f.read(5))
+
+f.close()
+uos.unlink(NAME)
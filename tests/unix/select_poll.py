@@ -0,0 +1,44 @@
+# test uselect.poll on unix, using fds which are always ready
+try:
+    import uselect
+    import usocket
+except ImportError:
+    print("SKIP")
+    import sys
+    sys.exit()
+
+p = uselect.poll()
+
+# stdout is always writable
+print(p.register(1, uselect.POLLOUT))
+print(p.register(1, uselect.POLLOUT))
+print(p.poll(0))
+
+# ipoll reuses one tuple for all results
+for fd, ev in p.ipoll(0):
+    print(fd, ev & uselect.POLLOUT)
+print(list(p.ipoll(0)) == [(1, uselect.POLLOUT)])
+
+# a UDP socket becomes readable once a datagram arrives
+s = usocket.socket(usocket.AF_INET, usocket.SOCK_DGRAM)
+addr = usocket.getaddrinfo("127.0.0.1", 8267)[0][-1]
+s.bind(addr)
+p.modify(1, 0)
+p.register(s, uselect.POLLIN)
+print(p.poll(0))
+s.sendto(b"x", addr)
+print(p.poll(1000) == [(s.fileno(), uselect.POLLIN)])
+s.recv(1)
+print(p.poll(0))
+
+# oneshot: the fd is not reported again until modified
+p.modify(1, uselect.POLLOUT)
+print(len(p.poll(0, 1)))
+print(p.poll(0))
+p.modify(1, uselect.POLLOUT)
+print(len(p.poll(0)))
+
+p.unregister(1)
+p.unregister(s)
+print(p.poll(0))
+s.close()
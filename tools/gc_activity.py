@@ -1,5 +1,70 @@
 import sys
 import json
+import struct
+
+# Characters used for a block in heap snapshots and micropython.mem_info(1).
+HEAD_KINDS = "TLDSAFBMh"
+
+def read_snapshots(filename):
+    """Yield the blocks of each snapshot from micropython.heap_snapshot() in
+    the file, as a bytes object of one character per block."""
+    with open(filename, "rb") as f:
+        data = f.read()
+    offset = 0
+    while offset < len(data):
+        magic, block_size, n_blocks = struct.unpack_from("<2sHI", data, offset)
+        if magic != b"GC":
+            raise ValueError("%s: bad snapshot at offset %d" % (filename, offset))
+        offset += 8
+        yield block_size, data[offset:offset + n_blocks]
+        offset += n_blocks
+
+def analyse_snapshot(blocks):
+    free = 0
+    free_runs = 0
+    largest_free = 0
+    run = 0
+    heads = dict.fromkeys(HEAD_KINDS, 0)
+    for c in blocks.decode():
+        if c == ".":
+            free += 1
+            run += 1
+            largest_free = max(largest_free, run)
+            if run == 1:
+                free_runs += 1
+            continue
+        run = 0
+        if c in heads:
+            heads[c] += 1
+    # the part of the free memory that can't be used for one allocation
+    fragmentation = 0 if free == 0 else 1 - largest_free / free
+    return free, free_runs, largest_free, fragmentation, heads
+
+def analyse_snapshots(filenames):
+    print("snapshot  used  free  runs  largest  frag  " + "  ".join("%5s" % k for k in HEAD_KINDS))
+    history = []
+    for filename in filenames:
+        for block_size, blocks in read_snapshots(filename):
+            free, free_runs, largest_free, fragmentation, heads = analyse_snapshot(blocks)
+            used = len(blocks) - free
+            print("%8d %5d %5d %5d %8d %5.2f  " % (len(history), used * block_size, free * block_size,
+                free_runs, largest_free * block_size, fragmentation)
+                + "  ".join("%5d" % heads[k] for k in HEAD_KINDS))
+            history.append({"used": used * block_size, "free": free * block_size, "free_runs": free_runs,
+                            "largest_free": largest_free * block_size, "fragmentation": fragmentation,
+                            "heads": heads})
+    if len(history) > 1:
+        first, last = history[0], history[-1]
+        print()
+        print("largest free block %+d bytes, fragmentation %+.2f over %d snapshots" % (
+            last["largest_free"] - first["largest_free"], last["fragmentation"] - first["fragmentation"],
+            len(history)))
+    with open("fragmentation_history.json", "w") as f:
+        json.dump(history, f)
+
+if sys.argv[1] == "--snapshots":
+    analyse_snapshots(sys.argv[2:])
+    sys.exit()
 
 # Map start block to current allocation info.
 current_heap = {}
@@ -36,6 +36,10 @@ for dirpath, dirnames, filenames in os.walk(root):
         st = os.stat(fullpath)
         modules.append((fullpath[root_len + 1:], st))
 
+# py/frozenmod.c finds modules by binary search, so they're sorted by name
+# as bytes.
+modules.sort(key=lambda m: module_name(m[0]).encode('utf8'))
+
 print("#include <stdint.h>")
 print("const char mp_frozen_str_names[] = {")
 for f, st in modules:
@@ -50,6 +54,19 @@ for f, st in modules:
 
 print("};")
 
+# the number of modules, the offset of each name, then of each module's source
+print("const uint32_t mp_frozen_str_index[] = {")
+print("%d," % len(modules))
+offset = 0
+for f, st in modules:
+    print("%d," % offset)
+    offset += len(module_name(f).encode('utf8')) + 1
+offset = 0
+for f, st in modules:
+    print("%d," % offset)
+    offset += st.st_size + 1
+print("};")
+
 print("const char mp_frozen_str_content[] = {")
 for f, st in modules:
     data = open(sys.argv[1] + "/" + f, "rb").read()
@@ -60,6 +60,7 @@ class Config:
     MICROPY_LONGINT_IMPL_NONE = 0
     MICROPY_LONGINT_IMPL_LONGLONG = 1
     MICROPY_LONGINT_IMPL_MPZ = 2
+    MICROPY_OPT_SUPERINSTRUCTIONS = False
 config = Config()
 
 MP_OPCODE_BYTE = 0
@@ -68,9 +69,12 @@ MP_OPCODE_VAR_UINT = 2
 MP_OPCODE_OFFSET = 3
 
 # extra bytes:
+MP_BC_UNWIND_JUMP = 0x46
 MP_BC_MAKE_CLOSURE = 0x62
 MP_BC_MAKE_CLOSURE_DEFARGS = 0x63
 MP_BC_RAISE_VARARGS = 0x5c
+MP_BC_BINARY_OP_SMALL_INT = 0x47
+MP_BC_LOAD_FAST_2 = 0x48
 # extra byte if caching enabled:
 MP_BC_LOAD_NAME = 0x1c
 MP_BC_LOAD_GLOBAL = 0x1d
@@ -104,8 +108,8 @@ def make_opcode_format():
     OC4(O, O, U, U), # 0x38-0x3b
     OC4(U, O, B, O), # 0x3c-0x3f
     OC4(O, B, B, O), # 0x40-0x43
-    OC4(B, B, O, U), # 0x44-0x47
-    OC4(U, U, U, U), # 0x48-0x4b
+    OC4(B, B, O, V), # 0x44-0x47
+    OC4(B, V, V, O), # 0x48-0x4b
     OC4(U, U, U, U), # 0x4c-0x4f
     OC4(V, V, U, V), # 0x50-0x53
     OC4(B, U, V, V), # 0x54-0x57
@@ -168,9 +172,12 @@ def mp_opcode_format(bytecode, ip, opcode_format=make_opcode_format()):
         ip += 3
     else:
         extra_byte = (
-            opcode == MP_BC_RAISE_VARARGS
+            opcode == MP_BC_UNWIND_JUMP
+            or opcode == MP_BC_RAISE_VARARGS
             or opcode == MP_BC_MAKE_CLOSURE
             or opcode == MP_BC_MAKE_CLOSURE_DEFARGS
+            or opcode == MP_BC_BINARY_OP_SMALL_INT
+            or opcode == MP_BC_LOAD_FAST_2
             or config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE and (
                 opcode == MP_BC_LOAD_NAME
                 or opcode == MP_BC_LOAD_GLOBAL
@@ -215,10 +222,238 @@ def extract_prelude(bytecode):
     # ip2 points to simple_name qstr
     return ip, ip2, (n_state, n_exc_stack, scope_flags, n_pos_args, n_kwonly_args, n_def_pos_args, code_info_size)
 
+# opcodes that the bytecode optimiser needs to know about
+MP_BC_POP_TOP = 0x32
+MP_BC_JUMP = 0x35
+MP_BC_POP_JUMP_IF_TRUE = 0x36
+MP_BC_POP_JUMP_IF_FALSE = 0x37
+MP_BC_JUMP_IF_TRUE_OR_POP = 0x38
+MP_BC_JUMP_IF_FALSE_OR_POP = 0x39
+MP_BC_RETURN_VALUE = 0x5b
+
+# these have a signed offset, all other offsets are unsigned (always forward)
+MP_BC_SIGNED_JUMPS = (
+    MP_BC_JUMP, MP_BC_POP_JUMP_IF_TRUE, MP_BC_POP_JUMP_IF_FALSE,
+    MP_BC_JUMP_IF_TRUE_OR_POP, MP_BC_JUMP_IF_FALSE_OR_POP, MP_BC_UNWIND_JUMP,
+)
+
+# these never continue with the following opcode
+MP_BC_NO_FALL_THROUGH = (MP_BC_JUMP, MP_BC_UNWIND_JUMP, MP_BC_RETURN_VALUE, MP_BC_RAISE_VARARGS)
+
+class Opcode:
+    def __init__(self, offset, code):
+        # offset is relative to the end of the code info, as for the line info
+        self.offset = offset
+        self.code = code
+        self.target = None
+
+def decode_line_info(bytecode, ip):
+    # this mirrors the lookup in py/vm.c: returns the (bc, line) points at which
+    # a new line starts
+    points = []
+    bc = 0
+    line = 1
+    while bytecode[ip]:
+        c = bytecode[ip]
+        if c & 0x80 == 0:
+            # 0b0LLBBBBB encoding
+            bc += c & 0x1f
+            line += c >> 5
+            ip += 1
+        else:
+            # 0b1LLLBBBB 0bLLLLLLLL encoding (l's LSB in second byte)
+            bc += c & 0xf
+            line += ((c << 4) & 0x700) | bytecode[ip + 1]
+            ip += 2
+        points.append((bc, line))
+    return points
+
+def encode_line_info(points):
+    # this mirrors emit_write_code_info_bytes_lines in py/emitbc.c
+    out = bytearray()
+    last_bc = 0
+    last_line = 1
+    for bc, line in points:
+        bytes_to_skip = bc - last_bc
+        lines_to_skip = line - last_line
+        while bytes_to_skip > 0 or lines_to_skip > 0:
+            if lines_to_skip <= 6:
+                b = min(bytes_to_skip, 0x1f)
+                l = min(lines_to_skip, 0x3)
+                out.append(b | (l << 5))
+            else:
+                b = min(bytes_to_skip, 0xf)
+                l = min(lines_to_skip, 0x7ff)
+                out.append(0x80 | b | ((l >> 4) & 0x70))
+                out.append(l & 0xff)
+            bytes_to_skip -= b
+            lines_to_skip -= l
+        last_bc = bc
+        last_line = line
+    out.append(0) # end of line number info
+    return out
+
+def decode_opcodes(bytecode, ip, base):
+    opcodes = []
+    by_offset = {}
+    while ip < len(bytecode):
+        f, sz = mp_opcode_format(bytecode, ip)
+        op = Opcode(ip - base, bytecode[ip:ip + sz])
+        if f == MP_OPCODE_OFFSET:
+            rel = bytecode[ip + 1] | bytecode[ip + 2] << 8
+            if bytecode[ip] in MP_BC_SIGNED_JUMPS:
+                rel -= 0x8000
+            op.target = op.offset + 3 + rel
+        opcodes.append(op)
+        by_offset[op.offset] = op
+        ip += sz
+    for op in opcodes:
+        if op.target is not None:
+            op.target = by_offset[op.target]
+    return opcodes
+
+def thread_jumps(opcodes):
+    # make jumps that land on an unconditional jump go straight to its target
+    changed = False
+    for op in opcodes:
+        if op.target is None or op.code[0] not in MP_BC_SIGNED_JUMPS:
+            continue
+        seen = set()
+        target = op.target
+        while target.code[0] == MP_BC_JUMP and target not in seen:
+            seen.add(target)
+            target = target.target
+        if target is not op.target:
+            op.target = target
+            changed = True
+    return changed
+
+def remove_jumps_to_next(opcodes):
+    # a jump to the following opcode does nothing, and a conditional one only
+    # needs to pop its argument
+    changed = False
+    keep = []
+    for i, op in enumerate(opcodes):
+        next_op = opcodes[i + 1] if i + 1 < len(opcodes) else None
+        if op.target is not None and op.target is next_op:
+            if op.code[0] == MP_BC_JUMP:
+                changed = True
+                continue
+            elif op.code[0] in (MP_BC_POP_JUMP_IF_TRUE, MP_BC_POP_JUMP_IF_FALSE):
+                op.code = bytearray([MP_BC_POP_TOP])
+                op.target = None
+                changed = True
+        keep.append(op)
+    return keep, changed
+
+def remove_unreachable(opcodes):
+    index = dict((op, i) for i, op in enumerate(opcodes))
+    reachable = set()
+    todo = [0]
+    while todo:
+        i = todo.pop()
+        if i >= len(opcodes) or opcodes[i] in reachable:
+            continue
+        op = opcodes[i]
+        reachable.add(op)
+        if op.target is not None:
+            todo.append(index[op.target])
+        if op.code[0] not in MP_BC_NO_FALL_THROUGH:
+            todo.append(i + 1)
+    keep = [op for op in opcodes if op in reachable]
+    return keep, len(keep) != len(opcodes)
+
+def optimize_bytecode(bytecode, strip_lines):
+    ip, ip2, prelude = extract_prelude(bytecode)
+    # the code info starts with its size, after n_state, n_exc_stack and 4 bytes
+    code_info_start, _ = decode_uint(bytecode, 0)
+    code_info_start, _ = decode_uint(bytecode, code_info_start)
+    code_info_start += 4
+    code_info_end = code_info_start + prelude[6]
+    # the opcodes start after the cell variables, which end with 0xff
+    cells = bytecode[code_info_end:ip]
+    opcodes = decode_opcodes(bytecode, ip, code_info_end)
+    points = decode_line_info(bytecode, ip2 + 4)
+
+    # the removal of one opcode can make more of the others redundant
+    changed = True
+    while changed:
+        changed = thread_jumps(opcodes)
+        old_opcodes = opcodes
+        opcodes, removed_jumps = remove_jumps_to_next(opcodes)
+        opcodes, removed_code = remove_unreachable(opcodes)
+        changed |= removed_jumps or removed_code
+        if changed:
+            # jumps to a removed opcode now go to the one that followed it
+            following = {}
+            kept = set(opcodes)
+            next_op = None
+            for op in reversed(old_opcodes):
+                if op in kept:
+                    next_op = op
+                following[op] = next_op
+            for op in opcodes:
+                if op.target is not None:
+                    op.target = following[op.target]
+
+    # lay out the remaining opcodes
+    new_offset = {}
+    offset = len(cells)
+    for op in opcodes:
+        new_offset[op] = offset
+        offset += len(op.code)
+    code = bytearray(cells)
+    for op in opcodes:
+        if op.target is not None:
+            rel = new_offset[op.target] - new_offset[op] - 3
+            if op.code[0] in MP_BC_SIGNED_JUMPS:
+                rel += 0x8000
+            assert 0 <= rel <= 0xffff
+            op.code[1] = rel & 0xff
+            op.code[2] = rel >> 8
+        code += op.code
+
+    # move each line to the first remaining opcode at or after its old start
+    if strip_lines:
+        line_info = encode_line_info([])
+    else:
+        new_points = []
+        i = 0
+        for bc, line in points:
+            if bc < len(cells):
+                new_points.append((bc, line))
+                continue
+            while i < len(opcodes) and opcodes[i].offset < bc:
+                i += 1
+            if i == len(opcodes):
+                break
+            new_bc = new_offset[opcodes[i]]
+            if new_points and new_points[-1][0] == new_bc:
+                new_points[-1] = (new_bc, line)
+            else:
+                new_points.append((new_bc, line))
+        line_info = encode_line_info(new_points)
+
+    # rebuild the code info, whose size includes the bytes that encode it
+    code_info = bytearray(bytecode[ip2:ip2 + 4]) + line_info
+    code_info_size = len(code_info) + 1
+    if code_info_size >= 0x80:
+        code_info_size += 1
+    assert code_info_size < 0x4000
+    out = bytearray(bytecode[:code_info_start])
+    if code_info_size >= 0x80:
+        out.append(0x80 | code_info_size >> 7)
+    out.append(code_info_size & 0x7f)
+    return out + code_info + code
+
 class RawCode:
     # a set of all escaped names, to make sure they are unique
     escaped_names = set()
 
+    # if not None, maps constant objects to the name they were frozen as, so
+    # that equal constants in different raw codes share one definition
+    shared_objs = None
+
     def __init__(self, bytecode, qstrs, objs, raw_codes):
         # set core variables
         self.bytecode = bytecode
@@ -235,6 +470,12 @@ class RawCode:
         qst = self.bytecode[ip] | self.bytecode[ip + 1] << 8
         return global_qstrs[qst]
 
+    def optimize(self, strip_lines):
+        for rc in self.raw_codes:
+            rc.optimize(strip_lines)
+        self.bytecode = optimize_bytecode(self.bytecode, strip_lines)
+        self.ip, self.ip2, self.prelude = extract_prelude(self.bytecode)
+
     def dump(self):
         # dump children first
         for rc in self.raw_codes:
@@ -281,8 +522,16 @@ class RawCode:
         print('};')
 
         # generate constant objects
+        self.obj_names = []
         for i, obj in enumerate(self.objs):
             obj_name = 'const_obj_%s_%u' % (self.escaped_name, i)
+            if RawCode.shared_objs is not None:
+                key = (type(obj).__name__, repr(obj))
+                if key in RawCode.shared_objs:
+                    self.obj_names.append(RawCode.shared_objs[key])
+                    continue
+                RawCode.shared_objs[key] = obj_name
+            self.obj_names.append(obj_name)
             if is_str_type(obj) or is_bytes_type(obj):
                 if is_str_type(obj):
                     obj = bytes_cons(obj, 'utf8')
@@ -335,7 +584,7 @@ class RawCode:
         for i in range(len(self.objs)):
             if type(self.objs[i]) is float:
                 print('#if MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_A || MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_B')
-                print('    (mp_uint_t)&const_obj_%s_%u,' % (self.escaped_name, i))
+                print('    (mp_uint_t)&%s,' % self.obj_names[i])
                 print('#elif MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_C')
                 n = struct.unpack('<I', struct.pack('<f', self.objs[i]))[0]
                 n = ((n & ~0x3) | 2) + 0x80800000
@@ -344,7 +593,7 @@ class RawCode:
                 print('#error "MICROPY_OBJ_REPR_D not supported with floats in frozen mpy files"')
                 print('#endif')
             else:
-                print('    (mp_uint_t)&const_obj_%s_%u,' % (self.escaped_name, i))
+                print('    (mp_uint_t)&%s,' % self.obj_names[i])
         for rc in self.raw_codes:
             print('    (mp_uint_t)&raw_code_%s,' % rc.escaped_name)
         print('};')
@@ -430,17 +679,23 @@ def read_raw_code(f):
     raw_codes = [read_raw_code(f) for _ in range(n_raw_code)]
     return RawCode(bytecode, qstrs, objs, raw_codes)
 
+def read_mpy_header(f):
+    header = bytes_cons(f.read(4))
+    if header[0] != ord('M'):
+        raise Exception('not a valid .mpy file')
+    if header[1] != 0:
+        raise Exception('incompatible version')
+    feature_flags = header[2]
+    config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE = (feature_flags & 1) != 0
+    config.MICROPY_PY_BUILTINS_STR_UNICODE = (feature_flags & 2) != 0
+    # superinstructions are sticky: if any file uses them the target must support them
+    config.MICROPY_OPT_SUPERINSTRUCTIONS |= (feature_flags & 4) != 0
+    config.mp_small_int_bits = header[3]
+    return header
+
 def read_mpy(filename):
     with open(filename, 'rb') as f:
-        header = bytes_cons(f.read(4))
-        if header[0] != ord('M'):
-            raise Exception('not a valid .mpy file')
-        if header[1] != 0:
-            raise Exception('incompatible version')
-        feature_flags = header[2]
-        config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE = (feature_flags & 1) != 0
-        config.MICROPY_PY_BUILTINS_STR_UNICODE = (feature_flags & 2) != 0
-        config.mp_small_int_bits = header[3]
+        read_mpy_header(f)
         return read_raw_code(f)
 
 def dump_mpy(raw_codes):
@@ -468,6 +723,12 @@ def freeze_mpy(base_qstrs, raw_codes):
     print('#endif')
     print()
 
+    if config.MICROPY_OPT_SUPERINSTRUCTIONS:
+        print('#if !MICROPY_OPT_SUPERINSTRUCTIONS')
+        print('#error "frozen mpy files need MICROPY_OPT_SUPERINSTRUCTIONS"')
+        print('#endif')
+        print()
+
     print('#if MICROPY_LONGINT_IMPL != %u' % config.MICROPY_LONGINT_IMPL)
     print('#error "incompatible MICROPY_LONGINT_IMPL"')
     print('#endif')
@@ -522,6 +783,10 @@ def freeze_mpy(base_qstrs, raw_codes):
     for rc in raw_codes:
         rc.freeze(rc.source_file.str.replace('/', '_')[:-3] + '_')
 
+    # py/frozenmod.c finds modules by binary search, so they're sorted by
+    # name as bytes
+    raw_codes = sorted(raw_codes, key=lambda rc: rc.source_file.str.encode('utf8'))
+
     print()
     print('const char mp_frozen_mpy_names[] = {')
     for rc in raw_codes:
@@ -534,6 +799,151 @@ def freeze_mpy(base_qstrs, raw_codes):
         print('    &raw_code_%s,' % rc.escaped_name)
     print('};')
 
+    # the number of modules, then the offset of each name
+    print('const uint32_t mp_frozen_mpy_index[] = {')
+    print('    %u,' % len(raw_codes))
+    offset = 0
+    for rc in raw_codes:
+        print('    %u,' % offset)
+        offset += len(rc.source_file.str.encode('utf8')) + 1
+    print('};')
+
+def write_uint(out, i):
+    b = bytearray([i & 0x7f])
+    i >>= 7
+    while i:
+        b.insert(0, 0x80 | (i & 0x7f))
+        i >>= 7
+    out += b
+
+def bundle_qstr_checksum(base_qstrs):
+    # this must match qstr_link_pool in py/qstr.c
+    checksum = 0
+    for _, _, qstr in sorted(base_qstrs.values(), key=lambda x: x[0]):
+        qbytes = bytes_cons(qstr, 'utf8')
+        qhash = qstrutil.compute_hash(qbytes, config.MICROPY_QSTR_BYTES_IN_HASH)
+        checksum = (checksum * 33 + qhash + (len(qbytes) << 16)) & 0xffffffff
+    return checksum
+
+class BundleLinker:
+    """Copies .mpy files with the qstr ids in their bytecode replaced by those
+    of the firmware, or of new qstrs that the bundle adds after them."""
+
+    def __init__(self, base_qstrs):
+        self.qstr_ids = {}
+        for order, _, qstr in base_qstrs.values():
+            self.qstr_ids[qstr.encode('utf8')] = order + 1
+        self.qstr_base = len(base_qstrs) + 1
+        self.new_qstrs = []
+
+    def qstr_id(self, qbytes):
+        if qbytes not in self.qstr_ids:
+            self.qstr_ids[qbytes] = self.qstr_base + len(self.new_qstrs)
+            self.new_qstrs.append(qbytes)
+        return self.qstr_ids[qbytes]
+
+    def copy_qstr(self, f, out):
+        ln = read_uint(f)
+        qbytes = f.read(ln)
+        write_uint(out, ln)
+        out += qbytes
+        return self.qstr_id(qbytes)
+
+    def copy_qstr_and_link(self, f, out, bytecode, ip):
+        qst = self.copy_qstr(f, out)
+        bytecode[ip] = qst & 0xff
+        bytecode[ip + 1] = qst >> 8
+
+    def link_raw_code(self, f, out):
+        bc_len = read_uint(f)
+        bytecode = bytearray(f.read(bc_len))
+        ip, ip2, prelude = extract_prelude(bytecode)
+        qstrs = bytearray()
+        self.copy_qstr_and_link(f, qstrs, bytecode, ip2) # simple_name
+        self.copy_qstr_and_link(f, qstrs, bytecode, ip2 + 2) # source_file
+        while ip < len(bytecode):
+            fmt, sz = mp_opcode_format(bytecode, ip)
+            if fmt == MP_OPCODE_QSTR:
+                self.copy_qstr_and_link(f, qstrs, bytecode, ip + 1)
+            ip += sz
+        write_uint(out, bc_len)
+        out += bytecode
+        out += qstrs
+        n_obj = read_uint(f)
+        n_raw_code = read_uint(f)
+        write_uint(out, n_obj)
+        write_uint(out, n_raw_code)
+        for _ in range(prelude[3] + prelude[4]):
+            self.copy_qstr(f, out)
+        for _ in range(n_obj):
+            obj_type = f.read(1)
+            out += obj_type
+            if obj_type != b'e':
+                ln = read_uint(f)
+                write_uint(out, ln)
+                out += f.read(ln)
+        for _ in range(n_raw_code):
+            self.link_raw_code(f, out)
+
+    def link_mpy(self, filename):
+        out = bytearray()
+        with open(filename, 'rb') as f:
+            out += read_mpy_header(f)
+            self.link_raw_code(f, out)
+        return out
+
+def bundle_mpy(base_qstrs, filenames, raw_codes):
+    if not base_qstrs:
+        raise FreezeError(raw_codes[0], 'a bundle needs the qstr header of the firmware (-q)')
+    if len(base_qstrs) + 1 >= 0x10000:
+        raise FreezeError(raw_codes[0], 'too many qstrs in the firmware')
+    linker = BundleLinker(base_qstrs)
+    images = [linker.link_mpy(filename) for filename in filenames]
+    if linker.qstr_base + len(linker.new_qstrs) > 0x10000:
+        raise FreezeError(raw_codes[0], 'too many qstrs for the bundle')
+
+    # modules are looked up by binary search, so they're sorted by name
+    modules = sorted(zip((rc.source_file.str.encode('utf8') for rc in raw_codes), images))
+    images = [image for _, image in modules]
+    names_offset = 16 + 4 * len(linker.new_qstrs) + 12 * len(images)
+    name_offsets = []
+    names = bytearray()
+    for name, _ in modules:
+        name_offsets.append(names_offset + len(names))
+        names += name + b'\0'
+    names += b'\0'
+
+    # lay out the qstr data and the images after the header and tables
+    offset = names_offset + len(names)
+    qstr_offsets = []
+    qstr_data = bytearray()
+    for qbytes in linker.new_qstrs:
+        if len(qbytes) >= (1 << (8 * config.MICROPY_QSTR_BYTES_IN_LEN)):
+            raise FreezeError(raw_codes[0], 'qstr is too long: %r' % qbytes)
+        qstr_offsets.append(offset + len(qstr_data))
+        qhash = qstrutil.compute_hash(bytes_cons(qbytes), config.MICROPY_QSTR_BYTES_IN_HASH)
+        for i in range(config.MICROPY_QSTR_BYTES_IN_HASH):
+            qstr_data.append((qhash >> (8 * i)) & 0xff)
+        for i in range(config.MICROPY_QSTR_BYTES_IN_LEN):
+            qstr_data.append((len(qbytes) >> (8 * i)) & 0xff)
+        qstr_data += qbytes + b'\0'
+    offset += len(qstr_data)
+
+    bundle = bytearray(b'MB\1')
+    bundle.append(config.MICROPY_QSTR_BYTES_IN_HASH | config.MICROPY_QSTR_BYTES_IN_LEN << 4)
+    bundle += struct.pack('<HHIHH', linker.qstr_base, len(linker.new_qstrs),
+        bundle_qstr_checksum(base_qstrs), len(images), 0)
+    for qstr_offset in qstr_offsets:
+        bundle += struct.pack('<I', qstr_offset)
+    for image, name_offset in zip(images, name_offsets):
+        bundle += struct.pack('<III', offset, len(image), name_offset)
+        offset += len(image)
+    bundle += names
+    bundle += qstr_data
+    for image in images:
+        bundle += image
+    return bundle
+
 def main():
     import argparse
     cmd_parser = argparse.ArgumentParser(description='A tool to work with MicroPython .mpy files.')
@@ -541,6 +951,14 @@ def main():
         help='dump contents of files')
     cmd_parser.add_argument('-f', '--freeze', action='store_true',
         help='freeze files')
+    cmd_parser.add_argument('-O', '--optimize', action='store_true',
+        help='optimize the bytecode and share equal constants when freezing')
+    cmd_parser.add_argument('--strip-lines', action='store_true',
+        help='drop line number info when optimizing, tracebacks then give line 1')
+    cmd_parser.add_argument('-b', '--bundle', action='store_true',
+        help='link files into a bundle that the firmware can map at runtime')
+    cmd_parser.add_argument('-o', '--output',
+        help='output file for the bundle')
     cmd_parser.add_argument('-q', '--qstr-header',
         help='qstr header file to freeze against')
     cmd_parser.add_argument('-mlongint-impl', choices=['none', 'longlong', 'mpz'], default='mpz',
@@ -574,11 +992,26 @@ def main():
     if args.dump:
         dump_mpy(raw_codes)
     elif args.freeze:
+        if args.optimize:
+            RawCode.shared_objs = {}
+            for rc in raw_codes:
+                rc.optimize(args.strip_lines)
         try:
             freeze_mpy(base_qstrs, raw_codes)
         except FreezeError as er:
             print(er, file=sys.stderr)
             sys.exit(1)
+    elif args.bundle:
+        try:
+            bundle = bundle_mpy(base_qstrs, args.files, raw_codes)
+        except FreezeError as er:
+            print(er, file=sys.stderr)
+            sys.exit(1)
+        if args.output:
+            with open(args.output, 'wb') as f:
+                f.write(bundle)
+        else:
+            getattr(sys.stdout, 'buffer', sys.stdout).write(bundle)
 
 if __name__ == '__main__':
     main()
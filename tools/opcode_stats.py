@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+
+"""Add up the opcode counts of micropython.opcode_stats() over several runs.
+
+Each input is either a file holding the printed result of
+micropython.opcode_stats(), as its last line, or a .py script which is then
+run with the unix port (built with MICROPY_PY_MICROPYTHON_OPCODE_STATS, as
+the coverage build is) to get its counts.  The opcodes are named from
+py/bc0.h, and the most run opcodes and pairs of opcodes are printed.
+"""
+
+import argparse
+import ast
+import json
+import os
+import re
+import subprocess
+import sys
+
+TOP = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+# Printing the counts after the script has run.
+EPILOGUE = "\nimport micropython\nprint(micropython.opcode_stats())\n"
+
+def opcode_names(bc0):
+    """Return a list of 256 names, from the MP_BC_ definitions in bc0."""
+    names = ["0x%02x" % op for op in range(256)]
+    with open(bc0) as f:
+        for line in f:
+            m = re.match(r"#define MP_BC_(\w+)\s+\((0x[0-9a-f]+)\)(?:\s*//\s*\+\s*\w+\((\d+)\))?", line)
+            if not m:
+                continue
+            name, op = m.group(1), int(m.group(2), 16)
+            if m.group(3) is None:
+                names[op] = name
+            else:
+                # a range of opcodes that carry their argument
+                for i in range(int(m.group(3))):
+                    names[op + i] = "%s+%d" % (name, i)
+    return names
+
+def read_stats(filename, micropython):
+    if filename.endswith(".py"):
+        with open(filename) as f:
+            script = f.read() + EPILOGUE
+        out = subprocess.check_output([micropython, "-X", "emit=bytecode", "-c", script],
+            cwd=os.path.dirname(os.path.abspath(filename)))
+        out = out.decode()
+    else:
+        with open(filename) as f:
+            out = f.read()
+    counts, pairs, dropped = ast.literal_eval(out.strip().splitlines()[-1])
+    return counts, pairs, dropped
+
+def main():
+    cmd_parser = argparse.ArgumentParser(description="Add up the opcode counts of several runs.")
+    cmd_parser.add_argument("--micropython", default=os.path.join(TOP, "unix", "micropython_coverage"),
+        help="the unix port to run .py scripts with")
+    cmd_parser.add_argument("-n", type=int, default=30, help="number of opcodes and pairs to print")
+    cmd_parser.add_argument("--json", help="also write all the counts to this file")
+    cmd_parser.add_argument("files", nargs="+", help="scripts, or output of micropython.opcode_stats()")
+    args = cmd_parser.parse_args()
+
+    names = opcode_names(os.path.join(TOP, "py", "bc0.h"))
+    counts = [0] * 256
+    pairs = {}
+    dropped = 0
+    for filename in args.files:
+        try:
+            c, p, d = read_stats(filename, args.micropython)
+        except (OSError, subprocess.CalledProcessError, ValueError, SyntaxError) as e:
+            print("%s: no opcode counts (%s)" % (filename, e), file=sys.stderr)
+            sys.exit(1)
+        for op in range(256):
+            counts[op] += c[op]
+        for first, second, n in p:
+            pairs[(first, second)] = pairs.get((first, second), 0) + n
+        dropped += d
+
+    total = sum(counts)
+    if total == 0:
+        print("no opcodes counted")
+        return
+    print("%d opcodes run" % total)
+    print()
+    print("%12s %6s  %s" % ("count", "%", "opcode"))
+    ranked = sorted(range(256), key=lambda op: -counts[op])
+    for op in ranked[:args.n]:
+        if counts[op] == 0:
+            break
+        print("%12d %6.2f  %s" % (counts[op], 100 * counts[op] / total, names[op]))
+
+    print()
+    print("%12s %6s  %s" % ("count", "%", "pair"))
+    total_pairs = sum(pairs.values()) + dropped
+    for (first, second), n in sorted(pairs.items(), key=lambda e: -e[1])[:args.n]:
+        print("%12d %6.2f  %s, %s" % (n, 100 * n / total_pairs, names[first], names[second]))
+    if dropped:
+        print("%12d %6.2f  (pairs that didn't fit in the table)" % (dropped, 100 * dropped / total_pairs))
+
+    if args.json is not None:
+        with open(args.json, "w") as f:
+            json.dump({
+                "opcodes": {names[op]: counts[op] for op in range(256) if counts[op]},
+                "pairs": [[names[a], names[b], n] for (a, b), n in sorted(pairs.items(), key=lambda e: -e[1])],
+                "dropped": dropped,
+            }, f, indent=1)
+
+if __name__ == "__main__":
+    main()
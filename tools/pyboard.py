@@ -39,6 +39,7 @@ Or:
 
 import sys
 import time
+import struct
 
 try:
     stdout = sys.stdout.buffer
@@ -118,6 +119,7 @@ class TelnetToSerial:
 
 class Pyboard:
     def __init__(self, device, baudrate=115200, user='micro', password='python', wait=0):
+        self.use_raw_paste = True
         if device and device[0].isdigit() and device[-1].isdigit() and device.count('.') == 3:
             # device looks like an IP address
             self.serial = TelnetToSerial(device, user, password, read_timeout=10)
@@ -225,6 +227,21 @@ class Pyboard:
         if not data.endswith(b'>'):
             raise PyboardError('could not enter raw repl')
 
+        if self.use_raw_paste:
+            # try raw-paste mode: ctrl-E, 'A', ctrl-A; firmware without it
+            # just resets the raw REPL and prints the banner
+            self.serial.write(b'\x05A\x01')
+            data = self.serial.read(2)
+            if data == b'R\x01':
+                return self.raw_paste_write(command_bytes)
+            elif data != b'R\x00':
+                data = self.read_until(1, b'w REPL; CTRL-B to exit\r\n>')
+                if not data.endswith(b'w REPL; CTRL-B to exit\r\n>'):
+                    print(data)
+                    raise PyboardError('could not enter raw repl')
+            # don't try raw-paste mode again on this connection
+            self.use_raw_paste = False
+
         # write command
         for i in range(0, len(command_bytes), 256):
             self.serial.write(command_bytes[i:min(i + 256, len(command_bytes))])
@@ -236,6 +253,36 @@ class Pyboard:
         if data != b'OK':
             raise PyboardError('could not exec command')
 
+    def raw_paste_write(self, command_bytes):
+        # the device sends the window size, then a \x01 each time it has
+        # consumed a window of data and another one can be sent
+        data = self.serial.read(2)
+        window_size = struct.unpack('<H', data)[0]
+        window_remain = window_size
+
+        i = 0
+        while i < len(command_bytes):
+            while window_remain == 0 or self.serial.inWaiting():
+                data = self.serial.read(1)
+                if data == b'\x01':
+                    window_remain += window_size
+                elif data == b'\x04':
+                    # device stopped reading early (eg syntax error), acknowledge it
+                    self.serial.write(b'\x04')
+                    return
+                else:
+                    raise PyboardError('unexpected read during raw paste: {}'.format(data))
+            b = command_bytes[i:min(i + window_remain, len(command_bytes))]
+            self.serial.write(b)
+            window_remain -= len(b)
+            i += len(b)
+
+        # indicate end of data and wait for the device to acknowledge it
+        self.serial.write(b'\x04')
+        data = self.read_until(1, b'\x04')
+        if not data.endswith(b'\x04'):
+            raise PyboardError('could not complete raw paste: {}'.format(data))
+
     def exec_raw(self, command, timeout=10, data_consumer=None):
         self.exec_raw_no_follow(command);
         return self.follow(timeout, data_consumer)
@@ -5,6 +5,8 @@
 #include "py/runtime.h"
 #include "py/repl.h"
 #include "py/mpz.h"
+#include "py/gc.h"
+#include "py/compile.h"
 
 #if defined(MICROPY_UNIX_COVERAGE)
 
@@ -12,6 +14,18 @@
 STATIC const mp_obj_str_t str_no_hash_obj = {{&mp_type_str}, 0, 10, (const byte*)"0123456789"};
 STATIC const mp_obj_str_t bytes_no_hash_obj = {{&mp_type_bytes}, 0, 10, (const byte*)"0123456789"};
 
+// allocations for the gc profile test, made while it's profiling
+STATIC void *gc_profile_live_ptr;
+STATIC mp_obj_t gc_profile_allocs(void) {
+    gc_profile_set_rate(1);
+    void *p = gc_alloc(3 * MICROPY_BYTES_PER_GC_BLOCK, false);
+    gc_profile_live_ptr = gc_alloc(1, false);
+    gc_free(p);
+    gc_profile_set_rate(0);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(gc_profile_allocs_obj, gc_profile_allocs);
+
 // function to run extra tests for things that can't be checked by scripts
 STATIC mp_obj_t extra_coverage(void) {
     // mp_printf (used by ports that don't have a native printf)
@@ -114,6 +128,43 @@ STATIC mp_obj_t extra_coverage(void) {
         mp_printf(&mp_plat_print, "%d\n", mpz_as_uint_checked(&mpz, &value));
     }
 
+    // gc allocation profiler
+    {
+        mp_printf(&mp_plat_print, "# gc profile\n");
+        // the site is named after the innermost bytecode frame, so allocate
+        // from within a bytecode function whatever emitter the caller uses
+        static const char src[] = "def gc_profile_site(f):\n    f()\n";
+        mp_obj_dict_t *globals = mp_obj_new_dict(0);
+        mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_string_gt_, src, sizeof(src) - 1, 0);
+        mp_parse_compile_execute(lex, MP_PARSE_FILE_INPUT, globals, globals);
+        mp_obj_t site = mp_obj_dict_get(MP_OBJ_FROM_PTR(globals), MP_OBJ_NEW_QSTR(qstr_from_str("gc_profile_site")));
+        mp_call_function_1(site, MP_OBJ_FROM_PTR(&gc_profile_allocs_obj));
+        mp_gc_profile_entry_t entries[MICROPY_GC_ALLOC_PROFILE_ENTRIES];
+        size_t n = gc_profile_get(entries);
+        mp_printf(&mp_plat_print, "%d\n", (int)n);
+        for (size_t i = 0; i < n; i++) {
+            mp_printf(&mp_plat_print, "%q %d %d\n", entries[i].block_name, (int)entries[i].n_blocks,
+                entries[i].death == 0 ? -1 : (int)(entries[i].death - entries[i].birth));
+        }
+        gc_free(gc_profile_live_ptr);
+    }
+
+    // gc arena
+    {
+        mp_printf(&mp_plat_print, "# gc arena\n");
+        gc_arena_t arena;
+        gc_arena_enter(&arena, 8 * MICROPY_BYTES_PER_GC_BLOCK);
+        byte *p = gc_alloc(2 * MICROPY_BYTES_PER_GC_BLOCK, false);
+        byte *q = gc_alloc(1, false);
+        byte *r = gc_alloc(6 * MICROPY_BYTES_PER_GC_BLOCK, false);
+        gc_free(p);
+        mp_printf(&mp_plat_print, "%d %d %d\n", p == arena.start, q == p + 2 * MICROPY_BYTES_PER_GC_BLOCK,
+            r >= arena.start && r < arena.end);
+        gc_arena_exit(&arena, false);
+        mp_printf(&mp_plat_print, "%d\n", (int)gc_nbytes(p));
+        gc_free(r);
+    }
+
     // return a tuple of data for testing on the Python side
     mp_obj_t items[] = {(mp_obj_t)&str_no_hash_obj, (mp_obj_t)&bytes_no_hash_obj};
     return mp_obj_new_tuple(MP_ARRAY_SIZE(items), items);
@@ -38,4 +38,11 @@ typedef struct _mp_obj_fdfile_t {
 extern const mp_obj_type_t mp_type_fileio;
 extern const mp_obj_type_t mp_type_textio;
 
+#ifndef _WIN32
+// Handle the MP_STREAM_POLL ioctl for an fd, without waiting
+mp_uint_t mp_fdfile_poll(int fd, uintptr_t flags, int *errcode);
+// Handle the MP_STREAM_WRITEV ioctl for an fd, with a single writev()
+mp_uint_t mp_fdfile_writev(int fd, uintptr_t arg, int *errcode);
+#endif
+
 #endif // __MICROPY_INCLUDED_UNIX_FILE_H__
@@ -42,6 +42,9 @@
 
 #ifdef _WIN32
 #define fsync _commit
+#else
+#include <poll.h>
+#include <sys/uio.h>
 #endif
 
 #ifdef MICROPY_CPYTHON_COMPAT
@@ -66,7 +69,9 @@ STATIC void fdfile_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kin
 STATIC mp_uint_t fdfile_read(mp_obj_t o_in, void *buf, mp_uint_t size, int *errcode) {
     mp_obj_fdfile_t *o = MP_OBJ_TO_PTR(o_in);
     check_fd_is_open(o);
+    MP_THREAD_GIL_EXIT();
     mp_int_t r = read(o->fd, buf, size);
+    MP_THREAD_GIL_ENTER();
     if (r == -1) {
         *errcode = errno;
         return MP_STREAM_ERROR;
@@ -83,21 +88,72 @@ STATIC mp_uint_t fdfile_write(mp_obj_t o_in, const void *buf, mp_uint_t size, in
         return size;
     }
     #endif
+    MP_THREAD_GIL_EXIT();
     mp_int_t r = write(o->fd, buf, size);
+    MP_THREAD_GIL_ENTER();
     while (r == -1 && errno == EINTR) {
         if (MP_STATE_VM(mp_pending_exception) != MP_OBJ_NULL) {
             mp_obj_t obj = MP_STATE_VM(mp_pending_exception);
             MP_STATE_VM(mp_pending_exception) = MP_OBJ_NULL;
             nlr_raise(obj);
         }
+        MP_THREAD_GIL_EXIT();
         r = write(o->fd, buf, size);
+        MP_THREAD_GIL_ENTER();
+    }
+    if (r == -1) {
+        *errcode = errno;
+        return MP_STREAM_ERROR;
+    }
+    return r;
+}
+
+#ifndef _WIN32
+mp_uint_t mp_fdfile_poll(int fd, uintptr_t flags, int *errcode) {
+    struct pollfd pfd = {fd, 0, 0};
+    if (flags & MP_STREAM_POLL_RD) {
+        pfd.events |= POLLIN;
+    }
+    if (flags & MP_STREAM_POLL_WR) {
+        pfd.events |= POLLOUT;
+    }
+    if (poll(&pfd, 1, 0) == -1) {
+        *errcode = errno;
+        return MP_STREAM_ERROR;
+    }
+    mp_uint_t ret = 0;
+    if (pfd.revents & POLLIN) {
+        ret |= MP_STREAM_POLL_RD;
+    }
+    if (pfd.revents & POLLOUT) {
+        ret |= MP_STREAM_POLL_WR;
+    }
+    if (pfd.revents & POLLERR) {
+        ret |= MP_STREAM_POLL_ERR;
+    }
+    if (pfd.revents & POLLHUP) {
+        ret |= MP_STREAM_POLL_HUP;
     }
+    return ret;
+}
+
+mp_uint_t mp_fdfile_writev(int fd, uintptr_t arg, int *errcode) {
+    const struct mp_stream_writev_t *w = (const struct mp_stream_writev_t*)arg;
+    struct iovec iov[MP_STREAM_WRITEV_MAX];
+    for (size_t i = 0; i < w->iovcnt; i++) {
+        iov[i].iov_base = (void*)w->iov[i].base;
+        iov[i].iov_len = w->iov[i].len;
+    }
+    MP_THREAD_GIL_EXIT();
+    ssize_t r = writev(fd, iov, w->iovcnt);
+    MP_THREAD_GIL_ENTER();
     if (r == -1) {
         *errcode = errno;
         return MP_STREAM_ERROR;
     }
     return r;
 }
+#endif
 
 STATIC mp_uint_t fdfile_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, int *errcode) {
     mp_obj_fdfile_t *o = MP_OBJ_TO_PTR(o_in);
@@ -113,12 +169,22 @@ STATIC mp_uint_t fdfile_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, i
             s->offset = off;
             return 0;
         }
-        case MP_STREAM_FLUSH:
-            if (fsync(o->fd) < 0) {
+        case MP_STREAM_FLUSH: {
+            MP_THREAD_GIL_EXIT();
+            int r = fsync(o->fd);
+            MP_THREAD_GIL_ENTER();
+            if (r < 0) {
                 *errcode = errno;
                 return MP_STREAM_ERROR;
             }
             return 0;
+        }
+        #ifndef _WIN32
+        case MP_STREAM_POLL:
+            return mp_fdfile_poll(o->fd, arg, errcode);
+        case MP_STREAM_WRITEV:
+            return mp_fdfile_writev(o->fd, arg, errcode);
+        #endif
         default:
             *errcode = EINVAL;
             return MP_STREAM_ERROR;
@@ -223,6 +289,7 @@ STATIC const mp_rom_map_elem_t rawfile_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_readline), MP_ROM_PTR(&mp_stream_unbuffered_readline_obj) },
     { MP_ROM_QSTR(MP_QSTR_readlines), MP_ROM_PTR(&mp_stream_unbuffered_readlines_obj) },
     { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_writev), MP_ROM_PTR(&mp_stream_writev_obj) },
     { MP_ROM_QSTR(MP_QSTR_seek), MP_ROM_PTR(&mp_stream_seek_obj) },
     { MP_ROM_QSTR(MP_QSTR_tell), MP_ROM_PTR(&mp_stream_tell_obj) },
     { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&mp_stream_flush_obj) },
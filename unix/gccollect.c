@@ -25,6 +25,7 @@
  */
 
 #include <stdio.h>
+#include <assert.h>
 
 #include "py/mpstate.h"
 #include "py/gc.h"
@@ -148,8 +149,9 @@ STATIC void gc_helper_get_regs(regs_t arr) {
 
 #endif // MICROPY_GCREGS_SETJMP
 
-// this function is used by mpthreadport.c
+// these functions are used by mpthreadport.c
 void gc_collect_regs_and_stack(void);
+size_t gc_collect_save_regs(void **regs, size_t n);
 
 void gc_collect_regs_and_stack(void) {
     regs_t regs;
@@ -159,6 +161,15 @@ void gc_collect_regs_and_stack(void) {
     gc_collect_root(regs_ptr, ((uintptr_t)MP_STATE_THREAD(stack_top) - (uintptr_t)&regs) / sizeof(uintptr_t));
 }
 
+// Save the registers of the calling thread to regs, which has room for n
+// words, so they can be scanned later; returns the number of words saved
+size_t gc_collect_save_regs(void **regs, size_t n) {
+    assert(sizeof(regs_t) <= n * sizeof(void*));
+    (void)n;
+    gc_helper_get_regs(*(regs_t*)(void*)regs);
+    return sizeof(regs_t) / sizeof(void*);
+}
+
 void gc_collect(void) {
     //gc_dump_info();
 
@@ -74,11 +74,21 @@ typedef struct _mp_obj_ffivar_t {
 //    ffi_type *type;
 } mp_obj_ffivar_t;
 
+// How each argument is converted, worked out once when the function is made
+enum {
+    FFI_ARG_VALUE,  // int, str, buffer, callback or None, depending on the object
+    FFI_ARG_OBJ,    // mp_obj_t passed as is
+    #if MICROPY_PY_BUILTINS_FLOAT
+    FFI_ARG_FLOAT,
+    FFI_ARG_DOUBLE,
+    #endif
+};
+
 typedef struct _mp_obj_ffifunc_t {
     mp_obj_base_t base;
     void *func;
     char rettype;
-    const char *argtypes;
+    const byte *argkinds;
     ffi_cif cif;
     ffi_type *params[];
 } mp_obj_ffifunc_t;
@@ -192,14 +202,24 @@ STATIC mp_obj_t make_func(mp_obj_t rettype_in, void *func, mp_obj_t argtypes_in)
 
     o->func = func;
     o->rettype = *rettype;
-    o->argtypes = argtypes;
 
-    mp_obj_t iterable = mp_getiter(argtypes_in);
-    mp_obj_t item;
-    int i = 0;
-    while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
-        o->params[i++] = get_ffi_type(item);
+    byte *argkinds = m_new(byte, nparams);
+    for (mp_int_t i = 0; i < nparams; i++) {
+        char c = argtypes[i];
+        o->params[i] = char2ffi_type(c);
+        if (o->params[i] == NULL) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError, "Unknown type"));
+        }
+        switch (c) {
+            case 'O': argkinds[i] = FFI_ARG_OBJ; break;
+            #if MICROPY_PY_BUILTINS_FLOAT
+            case 'f': argkinds[i] = FFI_ARG_FLOAT; break;
+            case 'd': argkinds[i] = FFI_ARG_DOUBLE; break;
+            #endif
+            default: argkinds[i] = FFI_ARG_VALUE; break;
+        }
     }
+    o->argkinds = argkinds;
 
     int res = ffi_prep_cif(&o->cif, FFI_DEFAULT_ABI, nparams, char2ffi_type(*rettype), o->params);
     if (res != FFI_OK) {
@@ -348,21 +368,23 @@ STATIC void ffifunc_print(const mp_print_t *print, mp_obj_t self_in, mp_print_ki
 
 STATIC mp_obj_t ffifunc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_obj_ffifunc_t *self = MP_OBJ_TO_PTR(self_in);
-    assert(n_kw == 0);
-    assert(n_args == self->cif.nargs);
+    mp_arg_check_num(n_args, n_kw, self->cif.nargs, self->cif.nargs, false);
 
     ffi_arg values[n_args];
     void *valueptrs[n_args];
-    const char *argtype = self->argtypes;
-    for (uint i = 0; i < n_args; i++, argtype++) {
+    const byte *argkind = self->argkinds;
+    for (uint i = 0; i < n_args; i++, argkind++) {
         mp_obj_t a = args[i];
-        if (*argtype == 'O') {
+        if (*argkind == FFI_ARG_VALUE && MP_OBJ_IS_SMALL_INT(a)) {
+            // the most common case first
+            values[i] = MP_OBJ_SMALL_INT_VALUE(a);
+        } else if (*argkind == FFI_ARG_OBJ) {
             values[i] = (ffi_arg)(intptr_t)a;
         #if MICROPY_PY_BUILTINS_FLOAT
-        } else if (*argtype == 'f') {
+        } else if (*argkind == FFI_ARG_FLOAT) {
             float *p = (float*)&values[i];
             *p = mp_obj_get_float(a);
-        } else if (*argtype == 'd') {
+        } else if (*argkind == FFI_ARG_DOUBLE) {
             double *p = (double*)&values[i];
             *p = mp_obj_get_float(a);
         #endif
@@ -374,9 +396,11 @@ STATIC mp_obj_t ffifunc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const
             const char *s = mp_obj_str_get_str(a);
             values[i] = (ffi_arg)(intptr_t)s;
         } else if (((mp_obj_base_t*)MP_OBJ_TO_PTR(a))->type->buffer_p.get_buffer != NULL) {
+            // bytes, bytearray, array and the like are passed as a pointer to
+            // their data, with no copy, so the C code can also write to them
             mp_obj_base_t *o = (mp_obj_base_t*)MP_OBJ_TO_PTR(a);
             mp_buffer_info_t bufinfo;
-            int ret = o->type->buffer_p.get_buffer(MP_OBJ_FROM_PTR(o), &bufinfo, MP_BUFFER_READ); // TODO: MP_BUFFER_READ?
+            int ret = o->type->buffer_p.get_buffer(MP_OBJ_FROM_PTR(o), &bufinfo, MP_BUFFER_READ);
             if (ret != 0) {
                 goto error;
             }
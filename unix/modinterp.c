@@ -0,0 +1,546 @@
+/*
+ * This file is part of the Micro Python project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// _interp module: starts more interpreters in the process, each in its own
+// thread with its own state, heap and qstr pool.  They share no objects and
+// no garbage collector, so they run in parallel on as many cores as there
+// are.  Interpreters talk through channels, which copy the data sent.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // for CPU_SET and pthread_attr_setaffinity_np
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "py/runtime.h"
+#include "py/compile.h"
+#include "py/gc.h"
+#include "py/objlist.h"
+#include "py/stackctrl.h"
+#include "py/mphal.h"
+#include "py/mperrno.h"
+#include "py/mpthread.h"
+
+#if MICROPY_PY_INTERP
+
+#define INTERP_STACK_SIZE (256 * 1024)
+
+/****************************************************************/
+// Channel
+
+// A message in transit, copied out of the heap of the sender
+typedef struct _interp_msg_t {
+    struct _interp_msg_t *next;
+    size_t len;
+    byte data[];
+} interp_msg_t;
+
+// This is shared by all interpreters, so it's allocated with malloc and not
+// on any heap.  It's freed once all handles on it are gone.
+typedef struct _interp_channel_t {
+    mp_thread_mutex_t mutex;
+    mp_thread_cond_t not_empty;
+    interp_msg_t *head;
+    interp_msg_t *tail;
+    size_t refs;
+    bool closed;
+} interp_channel_t;
+
+typedef struct _mp_obj_interp_channel_t {
+    mp_obj_base_t base;
+    interp_channel_t *chan;
+} mp_obj_interp_channel_t;
+
+STATIC const mp_obj_type_t interp_channel_type;
+
+STATIC void interp_channel_ref(interp_channel_t *chan) {
+    mp_thread_mutex_lock(&chan->mutex, 1);
+    chan->refs += 1;
+    mp_thread_mutex_unlock(&chan->mutex);
+}
+
+STATIC void interp_channel_unref(interp_channel_t *chan) {
+    mp_thread_mutex_lock(&chan->mutex, 1);
+    size_t refs = --chan->refs;
+    mp_thread_mutex_unlock(&chan->mutex);
+    if (refs == 0) {
+        while (chan->head != NULL) {
+            interp_msg_t *msg = chan->head;
+            chan->head = msg->next;
+            free(msg);
+        }
+        pthread_cond_destroy(&chan->not_empty);
+        pthread_mutex_destroy(&chan->mutex);
+        free(chan);
+    }
+}
+
+// Wrap chan in an object on the heap of the running interpreter; the handle
+// that is given owns a reference and drops it when collected
+STATIC mp_obj_t interp_channel_wrap(interp_channel_t *chan, bool owner) {
+    mp_obj_interp_channel_t *o;
+    if (owner) {
+        o = m_new_obj_with_finaliser(mp_obj_interp_channel_t);
+    } else {
+        o = m_new_obj(mp_obj_interp_channel_t);
+    }
+    o->base.type = &interp_channel_type;
+    o->chan = chan;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t interp_channel_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    (void)type;
+    (void)args;
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+    interp_channel_t *chan = malloc(sizeof(interp_channel_t));
+    if (chan == NULL) {
+        mp_raise_OSError(MP_ENOMEM);
+    }
+    mp_thread_mutex_init(&chan->mutex);
+    mp_thread_cond_init(&chan->not_empty);
+    chan->head = NULL;
+    chan->tail = NULL;
+    chan->refs = 1;
+    chan->closed = false;
+    return interp_channel_wrap(chan, true);
+}
+
+STATIC mp_obj_t interp_channel_send(mp_obj_t self_in, mp_obj_t buf_in) {
+    mp_obj_interp_channel_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    interp_msg_t *msg = malloc(sizeof(interp_msg_t) + bufinfo.len);
+    if (msg == NULL) {
+        mp_raise_OSError(MP_ENOMEM);
+    }
+    msg->next = NULL;
+    msg->len = bufinfo.len;
+    memcpy(msg->data, bufinfo.buf, bufinfo.len);
+
+    interp_channel_t *chan = self->chan;
+    mp_thread_mutex_lock(&chan->mutex, 1);
+    if (chan->closed) {
+        mp_thread_mutex_unlock(&chan->mutex);
+        free(msg);
+        mp_raise_OSError(MP_EPIPE);
+    }
+    if (chan->head == NULL) {
+        chan->head = msg;
+    } else {
+        chan->tail->next = msg;
+    }
+    chan->tail = msg;
+    mp_thread_cond_signal(&chan->not_empty);
+    mp_thread_mutex_unlock(&chan->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(interp_channel_send_obj, interp_channel_send);
+
+STATIC mp_obj_t interp_channel_recv(size_t n_args, const mp_obj_t *args) {
+    mp_obj_interp_channel_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t timeout_ms = -1;
+    if (n_args > 1 && args[1] != mp_const_none) {
+        #if MICROPY_PY_BUILTINS_FLOAT
+        timeout_ms = mp_obj_get_float(args[1]) * 1000;
+        #else
+        timeout_ms = mp_obj_get_int(args[1]) * 1000;
+        #endif
+        if (timeout_ms < 0) {
+            timeout_ms = 0;
+        }
+    }
+
+    interp_channel_t *chan = self->chan;
+    mp_thread_mutex_lock(&chan->mutex, 1);
+    mp_uint_t start = mp_hal_ticks_ms();
+    while (chan->head == NULL && !chan->closed) {
+        mp_int_t remain = -1;
+        if (timeout_ms >= 0) {
+            remain = timeout_ms - (mp_int_t)(mp_hal_ticks_ms() - start);
+            if (remain <= 0) {
+                mp_thread_mutex_unlock(&chan->mutex);
+                mp_raise_OSError(MP_ETIMEDOUT);
+            }
+        }
+        MP_THREAD_GIL_EXIT();
+        mp_thread_cond_wait(&chan->not_empty, &chan->mutex, remain);
+        MP_THREAD_GIL_ENTER();
+    }
+    interp_msg_t *msg = chan->head;
+    if (msg != NULL) {
+        chan->head = msg->next;
+    }
+    mp_thread_mutex_unlock(&chan->mutex);
+
+    if (msg == NULL) {
+        // closed, and everything sent has been received
+        return mp_const_none;
+    }
+    // the message must not be lost if the copy can't be allocated
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t ret = mp_obj_new_bytes(msg->data, msg->len);
+        nlr_pop();
+        free(msg);
+        return ret;
+    } else {
+        mp_thread_mutex_lock(&chan->mutex, 1);
+        msg->next = chan->head;
+        if (chan->head == NULL) {
+            chan->tail = msg;
+        }
+        chan->head = msg;
+        mp_thread_mutex_unlock(&chan->mutex);
+        nlr_jump(nlr.ret_val);
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(interp_channel_recv_obj, 1, 2, interp_channel_recv);
+
+STATIC mp_obj_t interp_channel_close(mp_obj_t self_in) {
+    mp_obj_interp_channel_t *self = MP_OBJ_TO_PTR(self_in);
+    interp_channel_t *chan = self->chan;
+    mp_thread_mutex_lock(&chan->mutex, 1);
+    chan->closed = true;
+    mp_thread_cond_broadcast(&chan->not_empty);
+    mp_thread_mutex_unlock(&chan->mutex);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(interp_channel_close_obj, interp_channel_close);
+
+STATIC mp_obj_t interp_channel___del__(mp_obj_t self_in) {
+    mp_obj_interp_channel_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->chan != NULL) {
+        interp_channel_unref(self->chan);
+        self->chan = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(interp_channel___del___obj, interp_channel___del__);
+
+STATIC const mp_rom_map_elem_t interp_channel_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_send), MP_ROM_PTR(&interp_channel_send_obj) },
+    { MP_ROM_QSTR(MP_QSTR_recv), MP_ROM_PTR(&interp_channel_recv_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&interp_channel_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&interp_channel___del___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(interp_channel_locals_dict, interp_channel_locals_dict_table);
+
+STATIC const mp_obj_type_t interp_channel_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Channel,
+    .make_new = interp_channel_make_new,
+    .locals_dict = (mp_obj_dict_t*)&interp_channel_locals_dict,
+};
+
+/****************************************************************/
+// Interpreter
+
+// This is shared by the thread running the interpreter and the handle on it
+// in the interpreter that started it; whichever lets go last frees it.
+typedef struct _interp_t {
+    mp_state_ctx_t ctx;
+    pthread_t id;
+    int refs;
+    int status;
+    char *heap;
+    size_t heap_size;
+    char *source;
+    size_t source_len;
+    char *path; // entries of sys.path, each terminated by a '\0'
+    size_t path_len;
+    size_t n_channels;
+    interp_channel_t *channels[];
+} interp_t;
+
+typedef struct _mp_obj_interp_t {
+    mp_obj_base_t base;
+    interp_t *interp;
+} mp_obj_interp_t;
+
+STATIC void interp_free(interp_t *it) {
+    for (size_t i = 0; i < it->n_channels; ++i) {
+        interp_channel_unref(it->channels[i]);
+    }
+    free(it->heap);
+    free(it->source);
+    free(it->path);
+    free(it);
+}
+
+STATIC void interp_release(interp_t *it) {
+    if (__atomic_sub_fetch(&it->refs, 1, __ATOMIC_SEQ_CST) == 0) {
+        interp_free(it);
+    }
+}
+
+// Set up the new interpreter and run the source in it, returning the exit
+// status.  This is kept out of interp_entry so that the stack top is set
+// above any stack variables that refer to the heap.
+MP_NOINLINE STATIC int interp_main(interp_t *it) {
+    mp_stack_set_limit(INTERP_STACK_SIZE - 16384);
+
+    gc_init(it->heap, it->heap + it->heap_size);
+    mp_init();
+
+    MP_STATE_VM(keyboard_interrupt_obj) = mp_obj_new_exception(&mp_type_KeyboardInterrupt);
+
+    int ret = 0;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        // sys.path is the same as where the interpreter was started
+        size_t path_num = 0;
+        for (size_t i = 0; i < it->path_len; ++i) {
+            path_num += it->path[i] == '\0';
+        }
+        mp_obj_list_init(MP_OBJ_TO_PTR(mp_sys_path), path_num);
+        mp_obj_t *path_items;
+        mp_obj_list_get(mp_sys_path, &path_num, &path_items);
+        const char *p = it->path;
+        for (size_t i = 0; i < path_num; ++i) {
+            size_t len = strlen(p);
+            path_items[i] = MP_OBJ_NEW_QSTR(qstr_from_strn(p, len));
+            p += len + 1;
+        }
+        mp_obj_list_init(MP_OBJ_TO_PTR(mp_sys_argv), 0);
+
+        // the references to the channels are held by it
+        mp_obj_tuple_t *channels = MP_OBJ_TO_PTR(mp_obj_new_tuple(it->n_channels, NULL));
+        for (size_t i = 0; i < it->n_channels; ++i) {
+            channels->items[i] = interp_channel_wrap(it->channels[i], false);
+        }
+        mp_store_global(MP_QSTR_channels, MP_OBJ_FROM_PTR(channels));
+
+        mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_string_gt_, it->source, it->source_len, 0);
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        mp_obj_t module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+        mp_call_function_0(module_fun);
+        nlr_pop();
+    } else {
+        mp_obj_t exc = MP_OBJ_FROM_PTR(nlr.ret_val);
+        if (mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(mp_obj_get_type(exc)), MP_OBJ_FROM_PTR(&mp_type_SystemExit))) {
+            // None is an exit value of 0; an int is its value; anything else is 1
+            mp_obj_t exit_val = mp_obj_exception_get_value(exc);
+            mp_int_t val = 0;
+            if (exit_val != mp_const_none && !mp_obj_get_int_maybe(exit_val, &val)) {
+                val = 1;
+            }
+            ret = val & 255;
+        } else {
+            mp_obj_print_exception(&mp_plat_print, exc);
+            ret = 1;
+        }
+    }
+
+    // the heap is freed once the interpreter is finished, so its threads
+    // must be finished first
+    mp_thread_unix_join_others();
+
+    mp_deinit();
+    return ret;
+}
+
+STATIC void *interp_entry(void *it_in) {
+    interp_t *it = it_in;
+    mp_state_ctx_ptr = &it->ctx;
+    mp_thread_init();
+    mp_stack_ctrl_init();
+    it->status = interp_main(it);
+    mp_thread_finish();
+    interp_release(it);
+    return NULL;
+}
+
+STATIC const mp_obj_type_t interp_type;
+
+STATIC mp_obj_t mod_interp_start(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_source, ARG_channels, ARG_heap_size, ARG_cpu };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_source, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_channels, MP_ARG_OBJ, {.u_obj = mp_const_empty_tuple} },
+        { MP_QSTR_heap_size, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1024 * 1024} },
+        { MP_QSTR_cpu, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_uint_t source_len;
+    const char *source = mp_obj_str_get_data(args[ARG_source].u_obj, &source_len);
+    mp_uint_t n_channels;
+    mp_obj_t *channels;
+    mp_obj_get_array(args[ARG_channels].u_obj, &n_channels, &channels);
+    for (size_t i = 0; i < n_channels; ++i) {
+        if (!MP_OBJ_IS_TYPE(channels[i], &interp_channel_type)) {
+            mp_raise_TypeError("expecting a Channel");
+        }
+    }
+    mp_int_t heap_size = args[ARG_heap_size].u_int;
+    if (heap_size < 4096) {
+        mp_raise_ValueError("heap too small");
+    }
+    mp_int_t cpu = args[ARG_cpu].u_int;
+    #if defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        mp_raise_ValueError("cpu out of range");
+    }
+    #endif
+
+    // copy sys.path, as nothing on this heap can be seen by the interpreter
+    size_t path_num;
+    mp_obj_t *path_items;
+    mp_obj_list_get(mp_sys_path, &path_num, &path_items);
+    size_t path_len = 0;
+    for (size_t i = 0; i < path_num; ++i) {
+        mp_uint_t len;
+        mp_obj_str_get_data(path_items[i], &len);
+        path_len += len + 1;
+    }
+
+    mp_obj_interp_t *o = m_new_obj_with_finaliser(mp_obj_interp_t);
+    o->base.type = &interp_type;
+    o->interp = NULL;
+
+    interp_t *it = calloc(1, sizeof(interp_t) + n_channels * sizeof(interp_channel_t*));
+    if (it == NULL) {
+        mp_raise_OSError(MP_ENOMEM);
+    }
+    it->refs = 2;
+    it->heap = malloc(heap_size);
+    it->heap_size = heap_size;
+    it->source = malloc(source_len);
+    it->source_len = source_len;
+    it->path = malloc(path_len);
+    it->path_len = path_len;
+    if (it->heap == NULL || it->source == NULL || (path_len > 0 && it->path == NULL)) {
+        interp_free(it);
+        mp_raise_OSError(MP_ENOMEM);
+    }
+    memcpy(it->source, source, source_len);
+    char *p = it->path;
+    for (size_t i = 0; i < path_num; ++i) {
+        mp_uint_t len;
+        const char *s = mp_obj_str_get_data(path_items[i], &len);
+        memcpy(p, s, len);
+        p[len] = '\0';
+        p += len + 1;
+    }
+    for (size_t i = 0; i < n_channels; ++i) {
+        mp_obj_interp_channel_t *ch = MP_OBJ_TO_PTR(channels[i]);
+        interp_channel_ref(ch->chan);
+        it->channels[it->n_channels++] = ch->chan;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, INTERP_STACK_SIZE);
+    #if defined(__linux__)
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    }
+    #endif
+    int ret = pthread_create(&it->id, &attr, interp_entry, it);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        interp_free(it);
+        mp_raise_OSError(ret);
+    }
+    o->interp = it;
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_interp_start_obj, 1, mod_interp_start);
+
+STATIC mp_obj_t interp_join(mp_obj_t self_in) {
+    mp_obj_interp_t *self = MP_OBJ_TO_PTR(self_in);
+    interp_t *it = self->interp;
+    if (it == NULL) {
+        mp_raise_ValueError("already joined");
+    }
+    self->interp = NULL;
+    MP_THREAD_GIL_EXIT();
+    pthread_join(it->id, NULL);
+    MP_THREAD_GIL_ENTER();
+    int status = it->status;
+    interp_release(it);
+    return MP_OBJ_NEW_SMALL_INT(status);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(interp_join_obj, interp_join);
+
+STATIC mp_obj_t interp___del__(mp_obj_t self_in) {
+    mp_obj_interp_t *self = MP_OBJ_TO_PTR(self_in);
+    interp_t *it = self->interp;
+    if (it != NULL) {
+        // never joined, so let it run on and clean up after itself
+        self->interp = NULL;
+        pthread_detach(it->id);
+        interp_release(it);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(interp___del___obj, interp___del__);
+
+STATIC const mp_rom_map_elem_t interp_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_join), MP_ROM_PTR(&interp_join_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&interp___del___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(interp_locals_dict, interp_locals_dict_table);
+
+STATIC const mp_obj_type_t interp_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Interp,
+    .locals_dict = (mp_obj_dict_t*)&interp_locals_dict,
+};
+
+STATIC mp_obj_t mod_interp_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return MP_OBJ_NEW_SMALL_INT(n < 1 ? 1 : n);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_interp_cpu_count_obj, mod_interp_cpu_count);
+
+STATIC const mp_rom_map_elem_t mp_module_interp_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR__interp) },
+    { MP_ROM_QSTR(MP_QSTR_start), MP_ROM_PTR(&mod_interp_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cpu_count), MP_ROM_PTR(&mod_interp_cpu_count_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Channel), MP_ROM_PTR(&interp_channel_type) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_interp_globals, mp_module_interp_globals_table);
+
+const mp_obj_module_t mp_module_interp = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_interp_globals,
+};
+
+#endif // MICROPY_PY_INTERP
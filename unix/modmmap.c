@@ -0,0 +1,284 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Paul Sokolovsky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "py/runtime0.h"
+#include "py/runtime.h"
+#include "py/mphal.h"
+
+// Subset of CPython mmap module.  The mapping is used through the buffer
+// protocol, so memoryview, ustruct.unpack_from, ure and the like work on the
+// file data in place, without reading it into the heap.
+
+#define ACCESS_DEFAULT (0)
+#define ACCESS_READ (1)
+#define ACCESS_WRITE (2)
+#define ACCESS_COPY (3)
+
+typedef struct _mp_obj_mmap_t {
+    mp_obj_base_t base;
+    byte *data;
+    size_t len;
+    bool writable;
+} mp_obj_mmap_t;
+
+STATIC const mp_obj_type_t mp_type_mmap;
+
+STATIC mp_obj_mmap_t *mmap_get_open(mp_obj_t self_in) {
+    mp_obj_mmap_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->data == NULL) {
+        mp_raise_ValueError("mmap closed or invalid");
+    }
+    return self;
+}
+
+STATIC mp_obj_t mmap_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_fileno, ARG_length, ARG_flags, ARG_prot, ARG_access, ARG_offset };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_fileno, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_length, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_flags, MP_ARG_INT, {.u_int = MAP_SHARED} },
+        { MP_QSTR_prot, MP_ARG_INT, {.u_int = PROT_READ | PROT_WRITE} },
+        { MP_QSTR_access, MP_ARG_INT, {.u_int = ACCESS_DEFAULT} },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0} },
+    };
+    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
+
+    int fd = vals[ARG_fileno].u_int;
+    mp_int_t length = vals[ARG_length].u_int;
+    mp_int_t offset = vals[ARG_offset].u_int;
+    int flags = vals[ARG_flags].u_int;
+    int prot = vals[ARG_prot].u_int;
+
+    switch (vals[ARG_access].u_int) {
+        case ACCESS_DEFAULT:
+            break;
+        case ACCESS_READ:
+            flags = MAP_SHARED;
+            prot = PROT_READ;
+            break;
+        case ACCESS_WRITE:
+            flags = MAP_SHARED;
+            prot = PROT_READ | PROT_WRITE;
+            break;
+        case ACCESS_COPY:
+            flags = MAP_PRIVATE;
+            prot = PROT_READ | PROT_WRITE;
+            break;
+        default:
+            mp_raise_ValueError("bad access");
+    }
+
+    if (length < 0 || offset < 0) {
+        mp_raise_ValueError("negative length or offset");
+    }
+    if (length == 0) {
+        // map the whole file from offset
+        struct stat st;
+        int res = fstat(fd, &st);
+        RAISE_ERRNO(res, errno);
+        if (offset >= st.st_size) {
+            mp_raise_ValueError("mmap offset is greater than file size");
+        }
+        length = st.st_size - offset;
+    }
+
+    void *data = mmap(NULL, length, prot, flags, fd, offset);
+    if (data == MAP_FAILED) {
+        mp_raise_OSError(errno);
+    }
+
+    mp_obj_mmap_t *o = m_new_obj_with_finaliser(mp_obj_mmap_t);
+    o->base.type = type;
+    o->data = data;
+    o->len = length;
+    o->writable = (prot & PROT_WRITE) != 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC void mmap_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mp_obj_mmap_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<mmap %p len=%u>", self->data, (uint)self->len);
+}
+
+STATIC mp_obj_t mmap_unary_op(mp_uint_t op, mp_obj_t self_in) {
+    mp_obj_mmap_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(self->len != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(self->len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+STATIC mp_obj_t mmap_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
+    mp_obj_mmap_t *self = mmap_get_open(self_in);
+    if (value == MP_OBJ_NULL) {
+        // delete
+        return MP_OBJ_NULL; // op not supported
+    }
+    #if MICROPY_PY_BUILTINS_SLICE
+    if (MP_OBJ_IS_TYPE(index_in, &mp_type_slice)) {
+        if (value != MP_OBJ_SENTINEL) {
+            return MP_OBJ_NULL; // slice assignment not supported
+        }
+        mp_bound_slice_t slice;
+        if (!mp_seq_get_fast_slice_indexes(self->len, index_in, &slice)) {
+            mp_not_implemented("only slices with step=1 (aka None) are supported");
+        }
+        return mp_obj_new_bytes(self->data + slice.start, slice.stop - slice.start);
+    }
+    #endif
+    size_t index = mp_get_index(&mp_type_mmap, self->len, index_in, false);
+    if (value == MP_OBJ_SENTINEL) {
+        // load
+        return MP_OBJ_NEW_SMALL_INT(self->data[index]);
+    } else {
+        // store
+        if (!self->writable) {
+            mp_raise_msg(&mp_type_TypeError, "mmap can't modify a readonly memory map");
+        }
+        self->data[index] = mp_obj_get_int(value);
+        return mp_const_none;
+    }
+}
+
+STATIC mp_int_t mmap_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags) {
+    mp_obj_mmap_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->data == NULL || ((flags & MP_BUFFER_WRITE) && !self->writable)) {
+        return 1;
+    }
+    bufinfo->buf = self->data;
+    bufinfo->len = self->len;
+    bufinfo->typecode = 'B';
+    return 0;
+}
+
+STATIC mp_obj_t mmap_close(mp_obj_t self_in) {
+    mp_obj_mmap_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->data != NULL) {
+        munmap(self->data, self->len);
+        self->data = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mmap_close_obj, mmap_close);
+
+STATIC mp_obj_t mmap___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return mmap_close(args[0]);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mmap___exit___obj, 4, 4, mmap___exit__);
+
+STATIC mp_obj_t mmap_flush(mp_obj_t self_in) {
+    mp_obj_mmap_t *self = mmap_get_open(self_in);
+    int res = msync(self->data, self->len, MS_SYNC);
+    RAISE_ERRNO(res, errno);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mmap_flush_obj, mmap_flush);
+
+// madvise(option[, start[, length]]) tells the kernel how the data is going
+// to be used, eg MADV_SEQUENTIAL for one pass over a large file so that it
+// reads ahead and drops the pages behind.
+STATIC mp_obj_t mmap_madvise(size_t n_args, const mp_obj_t *args) {
+    mp_obj_mmap_t *self = mmap_get_open(args[0]);
+    int option = mp_obj_get_int(args[1]);
+    size_t start = 0;
+    size_t len = self->len;
+    if (n_args > 2) {
+        start = mp_obj_get_int(args[2]);
+        if (start > self->len) {
+            mp_raise_ValueError("madvise start out of bounds");
+        }
+        len = self->len - start;
+        if (n_args > 3) {
+            len = MIN(len, (size_t)mp_obj_get_int(args[3]));
+        }
+    }
+    // the start must be page aligned, so extend the region down to the page
+    size_t page_off = start % sysconf(_SC_PAGESIZE);
+    int res = madvise(self->data + start - page_off, len + page_off, option);
+    RAISE_ERRNO(res, errno);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mmap_madvise_obj, 2, 4, mmap_madvise);
+
+STATIC const mp_rom_map_elem_t mmap_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&mmap_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&mmap_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&mmap_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_madvise), MP_ROM_PTR(&mmap_madvise_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&mp_identity_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&mmap___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mmap_locals_dict, mmap_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_mmap = {
+    { &mp_type_type },
+    .name = MP_QSTR_mmap,
+    .print = mmap_print,
+    .make_new = mmap_make_new,
+    .unary_op = mmap_unary_op,
+    .subscr = mmap_subscr,
+    .buffer_p = { .get_buffer = mmap_get_buffer },
+    .locals_dict = (mp_obj_dict_t*)&mmap_locals_dict,
+};
+
+STATIC const mp_rom_map_elem_t mp_module_mmap_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_mmap) },
+    { MP_ROM_QSTR(MP_QSTR_mmap), MP_ROM_PTR(&mp_type_mmap) },
+
+#define C(name) { MP_ROM_QSTR(MP_QSTR_ ## name), MP_ROM_INT(name) }
+    C(MAP_SHARED),
+    C(MAP_PRIVATE),
+    C(PROT_READ),
+    C(PROT_WRITE),
+    C(ACCESS_DEFAULT),
+    C(ACCESS_READ),
+    C(ACCESS_WRITE),
+    C(ACCESS_COPY),
+    C(MADV_NORMAL),
+    C(MADV_RANDOM),
+    C(MADV_SEQUENTIAL),
+    C(MADV_WILLNEED),
+    C(MADV_DONTNEED),
+#undef C
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_mmap_globals, mp_module_mmap_globals_table);
+
+const mp_obj_module_t mp_module_mmap = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_mmap_globals,
+};
@@ -47,6 +47,8 @@ MP_DECLARE_CONST_FUN_OBJ_KW(fsuser_mount_obj);
 MP_DECLARE_CONST_FUN_OBJ_1(fsuser_umount_obj);
 MP_DECLARE_CONST_FUN_OBJ_KW(fsuser_mkfs_obj);
 extern const mp_obj_type_t mp_fat_vfs_type;
+extern const mp_obj_type_t mp_log_bdev_type;
+extern const mp_obj_type_t mp_sdcard_type;
 
 #ifdef __ANDROID__
 #define USE_STATFS 1
@@ -241,6 +243,12 @@ STATIC const mp_rom_map_elem_t mp_module_os_globals_table[] = {
     #if MICROPY_VFS_FAT
     { MP_ROM_QSTR(MP_QSTR_VfsFat), MP_ROM_PTR(&mp_fat_vfs_type) },
     #endif
+    #if MICROPY_VFS_LOGBDEV
+    { MP_ROM_QSTR(MP_QSTR_LogBdev), MP_ROM_PTR(&mp_log_bdev_type) },
+    #endif
+    #if MICROPY_VFS_SDCARD
+    { MP_ROM_QSTR(MP_QSTR_SDCard), MP_ROM_PTR(&mp_sdcard_type) },
+    #endif
     #if MICROPY_PY_OS_DUPTERM
     { MP_ROM_QSTR(MP_QSTR_dupterm), MP_ROM_PTR(&mp_uos_dupterm_obj) },
     #endif
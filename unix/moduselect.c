@@ -27,11 +27,15 @@
 
 #include "py/mpconfig.h"
 
-#if MICROPY_PY_USELECT
+#if MICROPY_PY_USELECT_POSIX
 
 #include <stdio.h>
 #include <errno.h>
 #include <poll.h>
+#include <unistd.h>
+#if MICROPY_PY_USELECT_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include "py/runtime.h"
 #include "py/obj.h"
@@ -47,13 +51,35 @@ extern const mp_obj_type_t mp_type_socket;
 // Flags for poll()
 #define FLAG_ONESHOT (1)
 
+// A wait is done without the GIL, so the signal that another thread sends to
+// collect garbage can interrupt it; it's then restarted, unless there is an
+// exception to raise.
+#define POLL_INTERRUPTED(r) ((r) == -1 && errno == EINTR && MP_STATE_VM(mp_pending_exception) == MP_OBJ_NULL)
+
 /// \class Poll - poll class
+///
+/// With epoll the kernel keeps the set of registered fds, and a poll only
+/// returns (and we only look at) the fds which are ready.  Fds that epoll
+/// refuses, like regular files, and all fds where there is no epoll, are
+/// kept in a flat pollfd array which is passed to poll() and scanned.
 
 typedef struct _mp_obj_poll_t {
     mp_obj_base_t base;
     unsigned short alloc;
     unsigned short len;
     struct pollfd *entries;
+    #if MICROPY_PY_USELECT_EPOLL
+    int epfd;
+    unsigned short ep_alloc; // size of events, grown with the number of fds
+    unsigned short ep_len; // number of fds registered with epoll
+    struct epoll_event *events;
+    int iter_ep_cnt;
+    #endif
+    // State of ipoll() iteration
+    int iter_flags;
+    int iter_cnt;
+    int iter_idx;
+    mp_obj_tuple_t *ret_tuple;
 } mp_obj_poll_t;
 
 STATIC int get_fd(mp_obj_t fdlike) {
@@ -72,6 +98,15 @@ STATIC int get_fd(mp_obj_t fdlike) {
     return fd;
 }
 
+#if MICROPY_PY_USELECT_EPOLL
+STATIC int poll_epoll_ctl(mp_obj_poll_t *self, int op, int fd, mp_uint_t flags) {
+    struct epoll_event ev;
+    ev.events = flags;
+    ev.data.fd = fd;
+    return epoll_ctl(self->epfd, op, fd, &ev);
+}
+#endif
+
 /// \method register(obj[, eventmask])
 STATIC mp_obj_t poll_register(size_t n_args, const mp_obj_t *args) {
     mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -84,6 +119,26 @@ STATIC mp_obj_t poll_register(size_t n_args, const mp_obj_t *args) {
         flags = POLLIN | POLLOUT;
     }
 
+    #if MICROPY_PY_USELECT_EPOLL
+    if (poll_epoll_ctl(self, EPOLL_CTL_ADD, fd, flags) == 0) {
+        if (self->ep_len >= self->ep_alloc) {
+            self->events = m_renew(struct epoll_event, self->events, self->ep_alloc, self->ep_alloc + 4);
+            self->ep_alloc += 4;
+        }
+        self->ep_len += 1;
+        return mp_const_true;
+    }
+    if (errno == EEXIST) {
+        int res = poll_epoll_ctl(self, EPOLL_CTL_MOD, fd, flags);
+        RAISE_ERRNO(res, errno);
+        return mp_const_false;
+    }
+    if (errno != EPERM) {
+        mp_raise_OSError(errno);
+    }
+    // epoll doesn't support this fd, fall back to the pollfd array
+    #endif
+
     struct pollfd *free_slot = NULL;
 
     struct pollfd *entry = self->entries;
@@ -116,8 +171,16 @@ MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_register_obj, 2, 3, poll_register);
 /// \method unregister(obj)
 STATIC mp_obj_t poll_unregister(mp_obj_t self_in, mp_obj_t obj_in) {
     mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
-    struct pollfd *entries = self->entries;
     int fd = get_fd(obj_in);
+
+    #if MICROPY_PY_USELECT_EPOLL
+    if (poll_epoll_ctl(self, EPOLL_CTL_DEL, fd, 0) == 0) {
+        self->ep_len -= 1;
+        return mp_const_none;
+    }
+    #endif
+
+    struct pollfd *entries = self->entries;
     for (int i = self->len - 1; i >= 0; i--) {
         if (entries->fd == fd) {
             entries->fd = -1;
@@ -134,11 +197,19 @@ MP_DEFINE_CONST_FUN_OBJ_2(poll_unregister_obj, poll_unregister);
 /// \method modify(obj, eventmask)
 STATIC mp_obj_t poll_modify(mp_obj_t self_in, mp_obj_t obj_in, mp_obj_t eventmask_in) {
     mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
-    struct pollfd *entries = self->entries;
     int fd = get_fd(obj_in);
+    mp_uint_t flags = mp_obj_get_int(eventmask_in);
+
+    #if MICROPY_PY_USELECT_EPOLL
+    if (poll_epoll_ctl(self, EPOLL_CTL_MOD, fd, flags) == 0) {
+        return mp_const_none;
+    }
+    #endif
+
+    struct pollfd *entries = self->entries;
     for (int i = self->len - 1; i >= 0; i--) {
         if (entries->fd == fd) {
-            entries->events = mp_obj_get_int(eventmask_in);
+            entries->events = flags;
             break;
         }
         entries++;
@@ -149,9 +220,9 @@ STATIC mp_obj_t poll_modify(mp_obj_t self_in, mp_obj_t obj_in, mp_obj_t eventmas
 }
 MP_DEFINE_CONST_FUN_OBJ_3(poll_modify_obj, poll_modify);
 
-/// \method poll([timeout])
-/// Timeout is in milliseconds.
-STATIC mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args) {
+// Wait for events, common to poll() and ipoll(), and return the number of
+// ready fds.  These are then taken one at a time with poll_next_ready().
+STATIC int poll_poll_internal(size_t n_args, const mp_obj_t *args) {
     mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
 
     // work out timeout (it's given already in ms)
@@ -169,42 +240,161 @@ STATIC mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args) {
         }
     }
 
-    int n_ready = poll(self->entries, self->len, timeout);
+    self->iter_flags = flags;
+    self->iter_idx = 0;
+
+    #if MICROPY_PY_USELECT_EPOLL
+    // Fds that epoll doesn't take (regular files) are always ready, or
+    // never will be, so they are only checked without waiting
+    int n_ready = 0;
+    if (self->len > 0) {
+        n_ready = poll(self->entries, self->len, 0);
+        RAISE_ERRNO(n_ready, errno);
+        if (n_ready > 0) {
+            timeout = 0;
+        }
+    }
+    int n_ep = 0;
+    if (self->ep_len > 0 || n_ready == 0) {
+        do {
+            MP_THREAD_GIL_EXIT();
+            n_ep = epoll_wait(self->epfd, self->events, self->ep_alloc, timeout);
+            MP_THREAD_GIL_ENTER();
+        } while (POLL_INTERRUPTED(n_ep));
+        RAISE_ERRNO(n_ep, errno);
+    }
+    self->iter_ep_cnt = n_ep;
+    self->iter_cnt = n_ready;
+    return n_ep + n_ready;
+    #else
+    int n_ready;
+    do {
+        MP_THREAD_GIL_EXIT();
+        n_ready = poll(self->entries, self->len, timeout);
+        MP_THREAD_GIL_ENTER();
+    } while (POLL_INTERRUPTED(n_ready));
     RAISE_ERRNO(n_ready, errno);
+    self->iter_cnt = n_ready;
+    return n_ready;
+    #endif
+}
+
+// Take the next ready fd and store its events in *revents.  Must only be
+// called as many times as poll_poll_internal() said fds were ready.
+STATIC int poll_next_ready(mp_obj_poll_t *self, mp_uint_t *revents) {
+    #if MICROPY_PY_USELECT_EPOLL
+    if (self->iter_ep_cnt > 0) {
+        struct epoll_event *ev = &self->events[--self->iter_ep_cnt];
+        *revents = ev->events;
+        if (self->iter_flags & FLAG_ONESHOT) {
+            // Don't poll next time, until new event flags will be set explicitly
+            poll_epoll_ctl(self, EPOLL_CTL_MOD, ev->data.fd, 0);
+        }
+        return ev->data.fd;
+    }
+    #endif
+
+    self->iter_cnt -= 1;
+    struct pollfd *entry = &self->entries[self->iter_idx];
+    while (entry->revents == 0) {
+        entry++;
+    }
+    self->iter_idx = entry - self->entries + 1;
+    *revents = entry->revents;
+    if (self->iter_flags & FLAG_ONESHOT) {
+        // Don't poll next time, until new event flags will be set explicitly
+        entry->events = 0;
+    }
+    return entry->fd;
+}
+
+/// \method poll([timeout])
+/// Timeout is in milliseconds.
+STATIC mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    int n_ready = poll_poll_internal(n_args, args);
     if (n_ready == 0) {
         return mp_const_empty_tuple;
     }
 
     mp_obj_list_t *ret_list = MP_OBJ_TO_PTR(mp_obj_new_list(n_ready, NULL));
-    int ret_i = 0;
-    struct pollfd *entries = self->entries;
-    for (int i = 0; i < self->len; i++, entries++) {
-        if (entries->revents != 0) {
-            mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
-            t->items[0] = MP_OBJ_NEW_SMALL_INT(entries->fd);
-            t->items[1] = MP_OBJ_NEW_SMALL_INT(entries->revents);
-            ret_list->items[ret_i++] = MP_OBJ_FROM_PTR(t);
-            if (flags & FLAG_ONESHOT) {
-                entries->events = 0;
-            }
-        }
+    for (int i = 0; i < n_ready; i++) {
+        mp_uint_t revents;
+        int fd = poll_next_ready(self, &revents);
+        mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
+        t->items[0] = MP_OBJ_NEW_SMALL_INT(fd);
+        t->items[1] = MP_OBJ_NEW_SMALL_INT(revents);
+        ret_list->items[i] = MP_OBJ_FROM_PTR(t);
     }
 
     return MP_OBJ_FROM_PTR(ret_list);
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_poll_obj, 1, 3, poll_poll);
 
+/// \method ipoll([timeout[, flags]])
+/// Like poll(), but returns the poll object to iterate over the ready
+/// (fd, events) pairs.  The same tuple is reused for each pair so nothing
+/// is allocated, and it is only valid until the next iteration.
+STATIC mp_obj_t poll_ipoll(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    if (self->ret_tuple == NULL) {
+        self->ret_tuple = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
+    }
+
+    poll_poll_internal(n_args, args);
+    return args[0];
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_ipoll_obj, 1, 3, poll_ipoll);
+
+STATIC mp_obj_t poll_iternext(mp_obj_t self_in) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (self->iter_cnt == 0
+        #if MICROPY_PY_USELECT_EPOLL
+        && self->iter_ep_cnt == 0
+        #endif
+        ) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+
+    mp_uint_t revents;
+    int fd = poll_next_ready(self, &revents);
+    self->ret_tuple->items[0] = MP_OBJ_NEW_SMALL_INT(fd);
+    self->ret_tuple->items[1] = MP_OBJ_NEW_SMALL_INT(revents);
+    return MP_OBJ_FROM_PTR(self->ret_tuple);
+}
+
+#if MICROPY_PY_USELECT_EPOLL
+STATIC mp_obj_t poll_close(mp_obj_t self_in) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->epfd != -1) {
+        close(self->epfd);
+        self->epfd = -1;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(poll_close_obj, poll_close);
+#endif
+
 STATIC const mp_rom_map_elem_t poll_locals_dict_table[] = {
+    #if MICROPY_PY_USELECT_EPOLL
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&poll_close_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_register), MP_ROM_PTR(&poll_register_obj) },
     { MP_ROM_QSTR(MP_QSTR_unregister), MP_ROM_PTR(&poll_unregister_obj) },
     { MP_ROM_QSTR(MP_QSTR_modify), MP_ROM_PTR(&poll_modify_obj) },
     { MP_ROM_QSTR(MP_QSTR_poll), MP_ROM_PTR(&poll_poll_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ipoll), MP_ROM_PTR(&poll_ipoll_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(poll_locals_dict, poll_locals_dict_table);
 
 STATIC const mp_obj_type_t mp_type_poll = {
     { &mp_type_type },
     .name = MP_QSTR_poll,
+    .getiter = mp_identity,
+    .iternext = poll_iternext,
     .locals_dict = (void*)&poll_locals_dict,
 };
 
@@ -213,11 +403,27 @@ STATIC mp_obj_t select_poll(size_t n_args, const mp_obj_t *args) {
     if (n_args > 0) {
         alloc = mp_obj_get_int(args[0]);
     }
+    #if MICROPY_PY_USELECT_EPOLL
+    mp_obj_poll_t *poll = m_new_obj_with_finaliser(mp_obj_poll_t);
+    poll->base.type = &mp_type_poll;
+    poll->epfd = epoll_create1(EPOLL_CLOEXEC);
+    RAISE_ERRNO(poll->epfd, errno);
+    // The size hint is for the fds most likely to be registered: those that
+    // epoll takes.  epoll_wait() needs room for at least one event.
+    poll->ep_alloc = alloc > 0 ? alloc : 1;
+    poll->ep_len = 0;
+    poll->events = m_new(struct epoll_event, poll->ep_alloc);
+    poll->iter_ep_cnt = 0;
+    alloc = 1;
+    #else
     mp_obj_poll_t *poll = m_new_obj(mp_obj_poll_t);
     poll->base.type = &mp_type_poll;
+    #endif
     poll->entries = m_new(struct pollfd, alloc);
     poll->alloc = alloc;
     poll->len = 0;
+    poll->iter_cnt = 0;
+    poll->ret_tuple = NULL;
     return MP_OBJ_FROM_PTR(poll);
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_select_poll_obj, 0, 1, select_poll);
@@ -238,4 +444,4 @@ const mp_obj_module_t mp_module_uselect = {
     .globals = (mp_obj_dict_t*)&mp_module_select_globals,
 };
 
-#endif // MICROPY_PY_USELECT
+#endif // MICROPY_PY_USELECT_POSIX
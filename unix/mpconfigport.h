@@ -43,10 +43,26 @@
 #if !defined(MICROPY_EMIT_ARM) && defined(__arm__) && !defined(__thumb2__)
     #define MICROPY_EMIT_ARM        (1)
 #endif
+#define MICROPY_EMIT_NATIVE_TIERED (MICROPY_EMIT_X64 || MICROPY_EMIT_X86 || MICROPY_EMIT_THUMB || MICROPY_EMIT_ARM)
 #define MICROPY_COMP_MODULE_CONST   (1)
 #define MICROPY_COMP_TRIPLE_TUPLE_ASSIGN (1)
 #define MICROPY_ENABLE_GC           (1)
 #define MICROPY_ENABLE_FINALISER    (1)
+#define MICROPY_GC_FREE_INDEX_CLASSES (8)
+#define MICROPY_GC_INCREMENTAL_SWEEP (1)
+#define MICROPY_GC_NURSERY_BLOCKS   (2048)
+#define MICROPY_GC_ARENA            (1)
+#define MICROPY_GC_LONG_LIVED       (1)
+#define MICROPY_GC_STATS            (1)
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+#define MICROPY_GC_THREAD_ALLOC_BLOCKS (64)
+#endif
+#if MICROPY_PY_THREAD
+#define MICROPY_GC_PARALLEL_MARK    (1)
+#endif
+#if !MICROPY_PY_THREAD || MICROPY_PY_THREAD_GIL
+#define MICROPY_GC_COMPACT          (1)
+#endif
 #define MICROPY_STACK_CHECK         (1)
 #define MICROPY_MALLOC_USES_ALLOCATED_SIZE (1)
 #define MICROPY_MEM_STATS           (1)
@@ -61,27 +77,52 @@
 #define MICROPY_HELPER_LEXER_UNIX   (1)
 #define MICROPY_ENABLE_SOURCE_LINE  (1)
 #define MICROPY_FLOAT_IMPL          (MICROPY_FLOAT_IMPL_DOUBLE)
+#define MICROPY_FLOAT_REPR_SHORTEST (1)
 #define MICROPY_LONGINT_IMPL        (MICROPY_LONGINT_IMPL_MPZ)
 #define MICROPY_STREAMS_NON_BLOCK   (1)
 #define MICROPY_STREAMS_POSIX_API   (1)
 #define MICROPY_OPT_COMPUTED_GOTO   (1)
+#define MICROPY_QSTR_HASH_TABLE     (1)
+#define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (256)
+#define MICROPY_OPT_MAP_COMPACT (1)
+#define MICROPY_OPT_INSTANCE_SHARED_KEYS (1)
+#define MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE (64)
+#define MICROPY_OPT_SUPERINSTRUCTIONS (1)
+#define MICROPY_OPT_QUICKENING (1)
+#define MICROPY_OPT_STR_SEARCH_HORSPOOL (1)
+#define MICROPY_OPT_MPZ_KARATSUBA (1)
+#define MICROPY_OPT_STR_SLICE_VIEW_MIN_LEN (32)
+#define MICROPY_OPT_STR_INDEX_CACHE (1)
+#define MICROPY_OPT_GEN_FRAME_POOL (4)
+#define MICROPY_OPT_TUPLE_POOL (4)
 #ifndef MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (1)
 #endif
+// used instead when the above is disabled for frozen bytecode
+#define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_RAM_SIZE (256)
 #define MICROPY_CAN_OVERRIDE_BUILTINS (1)
 #define MICROPY_PY_FUNCTION_ATTRS   (1)
 #define MICROPY_PY_DESCRIPTORS      (1)
+#define MICROPY_PY_SLOTS            (1)
 #define MICROPY_PY_BUILTINS_STR_UNICODE (1)
 #define MICROPY_PY_BUILTINS_STR_CENTER (1)
 #define MICROPY_PY_BUILTINS_STR_PARTITION (1)
 #define MICROPY_PY_BUILTINS_STR_SPLITLINES (1)
 #define MICROPY_PY_BUILTINS_MEMORYVIEW (1)
+#define MICROPY_PY_BUILTINS_MEMORYVIEW_CAST (1)
 #define MICROPY_PY_BUILTINS_FROZENSET (1)
 #define MICROPY_PY_BUILTINS_COMPILE (1)
 #define MICROPY_PY_BUILTINS_NOTIMPLEMENTED (1)
 #define MICROPY_PY_MICROPYTHON_MEM_INFO (1)
+#define MICROPY_PY_MICROPYTHON_LIST_RESERVE (1)
+#define MICROPY_PY_MICROPYTHON_RINGIO (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE (1)
+#define MICROPY_PY_MICROPYTHON_TRACE (1)
+#define MICROPY_PY_MICROPYTHON_CYCLES (1)
 #define MICROPY_PY_ALL_SPECIAL_METHODS (1)
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN (1)
+#define MICROPY_PY_ARRAY_VECTOR_OPS (1)
+#define MICROPY_PY_STRUCT_STRUCT (1)
 #define MICROPY_PY_BUILTINS_SLICE_ATTRS (1)
 #define MICROPY_PY_SYS_EXIT         (1)
 #if defined(__APPLE__) && defined(__MACH__)
@@ -93,12 +134,17 @@
 #define MICROPY_PY_SYS_STDFILES     (1)
 #define MICROPY_PY_SYS_EXC_INFO     (1)
 #define MICROPY_PY_COLLECTIONS_ORDEREDDICT (1)
+#define MICROPY_PY_COLLECTIONS_DEQUE (1)
 #ifndef MICROPY_PY_MATH_SPECIAL_FUNCTIONS
 #define MICROPY_PY_MATH_SPECIAL_FUNCTIONS (1)
 #endif
 #define MICROPY_PY_CMATH            (1)
 #define MICROPY_PY_IO_FILEIO        (1)
 #define MICROPY_PY_GC_COLLECT_RETVAL (1)
+#define MICROPY_PY_THREAD_SYNC      (1)
+#define MICROPY_PY_THREAD_POOL      (1)
+#define MICROPY_PY_THREAD_GC_SAFEPOINTS (1)
+#define MICROPY_ENABLE_SCHEDULER    (1)
 #define MICROPY_MODULE_FROZEN_STR   (1)
 
 #define MICROPY_STACKLESS           (0)
@@ -110,27 +156,47 @@
 #define MICROPY_PY_UERRNO           (1)
 #define MICROPY_PY_UCTYPES          (1)
 #define MICROPY_PY_UZLIB            (1)
+#define MICROPY_PY_UZLIB_FAST_BITS  (9)
+#define MICROPY_PY_UZLIB_CRC32_TABLES (8)
+#define MICROPY_PY_UZLIB_COMPRESS   (1)
 #define MICROPY_PY_UJSON            (1)
 #define MICROPY_PY_URE              (1)
+#define MICROPY_PY_URE_SUB          (1)
+#define MICROPY_PY_URE_PIKEVM       (1)
+#define MICROPY_PY_URE_PIKEVM_STACK_MAX (8192)
 #define MICROPY_PY_UHEAPQ           (1)
+#define MICROPY_PY_UHEAPQ_PRIORITYQUEUE (1)
+#define MICROPY_PY_UASYNCIO         (1)
 #define MICROPY_PY_UHASHLIB         (1)
-#if MICROPY_PY_USSL && MICROPY_SSL_AXTLS
 #define MICROPY_PY_UHASHLIB_SHA1    (1)
-#endif
+#define MICROPY_PY_UHASHLIB_MD5     (1)
 #define MICROPY_PY_UBINASCII        (1)
 #define MICROPY_PY_UBINASCII_CRC32  (1)
 #define MICROPY_PY_URANDOM          (1)
-#ifndef MICROPY_PY_USELECT
-#define MICROPY_PY_USELECT          (1)
+#define MICROPY_PY_URANDOM_XOSHIRO128 (1)
+#ifndef MICROPY_PY_USELECT_POSIX
+#define MICROPY_PY_USELECT_POSIX    (1)
+#endif
+// Back uselect.poll objects with epoll where the OS has it
+#ifndef MICROPY_PY_USELECT_EPOLL
+#ifdef __linux__
+#define MICROPY_PY_USELECT_EPOLL    (1)
+#else
+#define MICROPY_PY_USELECT_EPOLL    (0)
+#endif
 #endif
 #define MICROPY_PY_WEBSOCKET        (1)
 #define MICROPY_PY_MACHINE          (1)
 #define MICROPY_PY_MACHINE_PULSE    (1)
+#define MICROPY_PY_FRAMEBUF         (1)
+#define MICROPY_PY_FRAMEBUF_DIRTY   (1)
 #define MICROPY_MACHINE_MEM_GET_READ_ADDR   mod_machine_mem_get_addr
 #define MICROPY_MACHINE_MEM_GET_WRITE_ADDR  mod_machine_mem_get_addr
 
 #define MICROPY_FATFS_ENABLE_LFN       (1)
 #define MICROPY_FATFS_RPATH            (2)
+#define MICROPY_FATFS_USE_FASTSEEK     (1)
+#define MICROPY_FATFS_TINY             (0)
 // Can't have less than 3 values because diskio.h uses volume numbers
 // as volume types and PD_USER == 2.
 #define MICROPY_FATFS_VOLUMES          (3)
@@ -164,9 +230,11 @@ extern const struct _mp_obj_module_t mp_module_os;
 extern const struct _mp_obj_module_t mp_module_uselect;
 extern const struct _mp_obj_module_t mp_module_time;
 extern const struct _mp_obj_module_t mp_module_termios;
+extern const struct _mp_obj_module_t mp_module_mmap;
 extern const struct _mp_obj_module_t mp_module_socket;
 extern const struct _mp_obj_module_t mp_module_ffi;
 extern const struct _mp_obj_module_t mp_module_jni;
+extern const struct _mp_obj_module_t mp_module_interp;
 
 #if MICROPY_PY_FFI
 #define MICROPY_PY_FFI_DEF { MP_ROM_QSTR(MP_QSTR_ffi), MP_ROM_PTR(&mp_module_ffi) },
@@ -188,12 +256,22 @@ extern const struct _mp_obj_module_t mp_module_jni;
 #else
 #define MICROPY_PY_TERMIOS_DEF
 #endif
+#if MICROPY_PY_MMAP
+#define MICROPY_PY_MMAP_DEF { MP_ROM_QSTR(MP_QSTR_mmap), MP_ROM_PTR(&mp_module_mmap) },
+#else
+#define MICROPY_PY_MMAP_DEF
+#endif
 #if MICROPY_PY_SOCKET
 #define MICROPY_PY_SOCKET_DEF { MP_ROM_QSTR(MP_QSTR_usocket), MP_ROM_PTR(&mp_module_socket) },
 #else
 #define MICROPY_PY_SOCKET_DEF
 #endif
-#if MICROPY_PY_USELECT
+#if MICROPY_PY_INTERP
+#define MICROPY_PY_INTERP_DEF { MP_ROM_QSTR(MP_QSTR__interp), MP_ROM_PTR(&mp_module_interp) },
+#else
+#define MICROPY_PY_INTERP_DEF
+#endif
+#if MICROPY_PY_USELECT_POSIX
 #define MICROPY_PY_USELECT_DEF { MP_ROM_QSTR(MP_QSTR_uselect), MP_ROM_PTR(&mp_module_uselect) },
 #else
 #define MICROPY_PY_USELECT_DEF
@@ -208,6 +286,8 @@ extern const struct _mp_obj_module_t mp_module_jni;
     { MP_ROM_QSTR(MP_QSTR_uos), MP_ROM_PTR(&mp_module_os) }, \
     MICROPY_PY_USELECT_DEF \
     MICROPY_PY_TERMIOS_DEF \
+    MICROPY_PY_MMAP_DEF \
+    MICROPY_PY_INTERP_DEF \
 
 // type definitions for the specific machine
 
@@ -273,6 +353,14 @@ void mp_unix_mark_exec(void);
     { MP_ROM_QSTR(MP_QSTR_input), MP_ROM_PTR(&mp_builtin_input_obj) }, \
     { MP_ROM_QSTR(MP_QSTR_open), MP_ROM_PTR(&mp_builtin_open_obj) },
 
+#if MICROPY_PY_THREAD
+// Atomic sections are only nested and short, so a recursive mutex will do
+void mp_thread_unix_begin_atomic_section(void);
+void mp_thread_unix_end_atomic_section(void);
+#define MICROPY_BEGIN_ATOMIC_SECTION() (mp_thread_unix_begin_atomic_section(), 0)
+#define MICROPY_END_ATOMIC_SECTION(state) do { (void)(state); mp_thread_unix_end_atomic_section(); } while (0)
+#endif
+
 #define MP_STATE_PORT MP_STATE_VM
 
 #define MICROPY_PORT_ROOT_POINTERS \
@@ -17,9 +17,17 @@ MICROPY_PY_BTREE = 1
 # _thread module using pthreads
 MICROPY_PY_THREAD = 1
 
+# _interp module, for running more interpreters in their own threads; this
+# makes every access to the interpreter state go through a thread-local
+# pointer, which slows down a single interpreter noticeably
+MICROPY_PY_INTERP = 0
+
 # Subset of CPython termios module
 MICROPY_PY_TERMIOS = 1
 
+# Subset of CPython mmap module
+MICROPY_PY_MMAP = 1
+
 # Subset of CPython socket module
 MICROPY_PY_SOCKET = 1
 
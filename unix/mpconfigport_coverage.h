@@ -35,4 +35,11 @@
 #undef MICROPY_VFS_FAT
 #define MICROPY_FSUSERMOUNT            (1)
 #define MICROPY_VFS_FAT                (1)
+#define MICROPY_VFS_LOGBDEV            (1)
+#define MICROPY_VFS_SDCARD             (1)
+#define MICROPY_VFS_FAT_IMPORT_CACHE   (1)
 #define MICROPY_PY_FRAMEBUF            (1)
+#define MICROPY_GC_ALLOC_PROFILE       (1)
+#define MICROPY_PY_MICROPYTHON_OPCODE_STATS (1)
+#define MICROPY_COMP_INCREMENTAL       (1)
+#define MICROPY_EMIT_BC_ONE_PASS       (1)
@@ -32,28 +32,66 @@
 #include "py/runtime.h"
 #include "py/mpthread.h"
 #include "py/gc.h"
+#include "py/mphal.h"
 
 #if MICROPY_PY_THREAD
 
 #include <signal.h>
 #include <sched.h>
+#include <time.h>
+
+#if MICROPY_PY_THREAD_GC_SAFEPOINTS
+// A thread parks while it's blocked, or waiting for the GIL, and publishes
+// its registers and the extent of its stack.  The collector scans a parked
+// thread itself, instead of signalling it, and a thread that wants to run
+// again waits until it's not being scanned.
+#define THREAD_RUNNING (0)
+#define THREAD_PARKED (1)
+#define THREAD_SCANNING (2)
+
+// enough for the registers saved by gc_collect_save_regs on any arch
+#define THREAD_PARK_REGS (64)
+
+size_t gc_collect_save_regs(void **regs, size_t n);
+#endif
 
 // this structure forms a linked list, one node per active thread
 typedef struct _thread_t {
     pthread_t id;           // system id of thread
     int ready;              // whether the thread is ready and running
     void *arg;              // thread Python args, a GC root pointer
+    void *(*entry)(void*);  // function the thread runs
+    #if MICROPY_MULTI_INTERP
+    mp_state_ctx_t *ctx;    // interpreter the thread belongs to
+    #endif
+    #if MICROPY_PY_THREAD_GC_SAFEPOINTS
+    int park;               // THREAD_RUNNING, THREAD_PARKED or THREAD_SCANNING
+    void **park_sp;         // the stack to scan while parked goes from here...
+    void *park_stack_top;   // ...to here
+    size_t park_n_regs;
+    void *park_regs[THREAD_PARK_REGS]; // registers saved when it parked
+    #endif
     struct _thread_t *next;
 } thread_t;
 
+#if MICROPY_PY_THREAD_GC_SAFEPOINTS
+// the entry for the calling thread
+STATIC __thread thread_t *thread_self;
+#endif
+
 STATIC pthread_key_t tls_key;
+STATIC pthread_once_t tls_key_once = PTHREAD_ONCE_INIT;
 
 // the mutex controls access to the linked list
 STATIC pthread_mutex_t thread_mutex = PTHREAD_MUTEX_INITIALIZER;
 STATIC thread_t *thread;
 
+// mutex for MICROPY_BEGIN_ATOMIC_SECTION, which may be nested
+STATIC pthread_mutex_t atomic_mutex;
+
 // this is used to synchronise the signal handler of the thread
 // it's needed because we can't use any pthread calls in a signal handler
+// it counts the threads that have finished scanning
 STATIC volatile int thread_signal_done;
 
 // this signal handler is used to scan the regs and stack of a thread
@@ -67,29 +105,104 @@ STATIC void mp_thread_gc(int signo, siginfo_t *info, void *context) {
         // that we don't need the extra information, enough is captured by the
         // gc_collect_regs_and_stack function above
         //gc_collect_root((void**)context, sizeof(ucontext_t) / sizeof(uintptr_t));
-        thread_signal_done = 1;
+        __atomic_add_fetch(&thread_signal_done, 1, __ATOMIC_SEQ_CST);
     }
 }
 
-void mp_thread_init(void) {
+// set up what is shared by all interpreters in the process
+STATIC void mp_thread_init_once(void) {
     pthread_key_create(&tls_key, NULL);
-    pthread_setspecific(tls_key, &mp_state_ctx.thread);
 
-    // create first entry in linked list of all threads
-    thread = malloc(sizeof(thread_t));
-    thread->id = pthread_self();
-    thread->ready = 1;
-    thread->arg = NULL;
-    thread->next = NULL;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&atomic_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
 
     // enable signal handler for garbage collection
     struct sigaction sa;
-    sa.sa_flags = SA_SIGINFO;
+    // restart system calls of threads blocked without the GIL
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
     sa.sa_sigaction = mp_thread_gc;
     sigemptyset(&sa.sa_mask);
     sigaction(SIGUSR1, &sa, NULL);
 }
 
+// Called by the main thread of an interpreter, before it is started
+void mp_thread_init(void) {
+    pthread_once(&tls_key_once, mp_thread_init_once);
+    pthread_setspecific(tls_key, &mp_state_ctx.thread);
+
+    // add an entry for this thread to the linked list of all threads
+    thread_t *th = malloc(sizeof(thread_t));
+    th->id = pthread_self();
+    th->ready = 1;
+    th->arg = NULL;
+    #if MICROPY_MULTI_INTERP
+    th->ctx = &mp_state_ctx;
+    #endif
+    #if MICROPY_PY_THREAD_GC_SAFEPOINTS
+    th->park = THREAD_RUNNING;
+    thread_self = th;
+    #endif
+    pthread_mutex_lock(&thread_mutex);
+    th->next = thread;
+    thread = th;
+    pthread_mutex_unlock(&thread_mutex);
+}
+
+#if MICROPY_MULTI_INTERP
+#define THREAD_IN_THIS_INTERP(th) ((th)->ctx == &mp_state_ctx)
+#else
+#define THREAD_IN_THIS_INTERP(th) (1)
+#endif
+
+#if MICROPY_PY_THREAD_GC_SAFEPOINTS
+
+void mp_thread_park(void) {
+    thread_t *th = thread_self;
+    if (th == NULL) {
+        return;
+    }
+    th->park_n_regs = gc_collect_save_regs(th->park_regs, THREAD_PARK_REGS);
+    th->park_sp = (void**)__builtin_frame_address(0);
+    th->park_stack_top = MP_STATE_THREAD(stack_top);
+    __atomic_store_n(&th->park, THREAD_PARKED, __ATOMIC_RELEASE);
+}
+
+void mp_thread_unpark(void) {
+    thread_t *th = thread_self;
+    if (th == NULL) {
+        return;
+    }
+    for (;;) {
+        int park = THREAD_PARKED;
+        if (__atomic_compare_exchange_n(&th->park, &park, THREAD_RUNNING, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+            || park == THREAD_RUNNING) {
+            return;
+        }
+        // a collection is scanning this thread
+        sched_yield();
+    }
+}
+
+// Stop a parked thread from running again until it has been scanned
+STATIC bool mp_thread_gc_claim(thread_t *th) {
+    int park = THREAD_PARKED;
+    return __atomic_compare_exchange_n(&th->park, &park, THREAD_SCANNING, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+STATIC void mp_thread_gc_parked(thread_t *th) {
+    gc_collect_root(th->park_regs, th->park_n_regs);
+    gc_collect_root(th->park_sp, ((uintptr_t)th->park_stack_top - (uintptr_t)th->park_sp) / sizeof(uintptr_t));
+    __atomic_store_n(&th->park, THREAD_PARKED, __ATOMIC_RELEASE);
+}
+
+#else
+#define mp_thread_gc_claim(th) (false)
+#define mp_thread_gc_parked(th)
+#endif
+
 // This function scans all pointers that are external to the current thread.
 // It does this by signalling all other threads and getting them to scan their
 // own registers and stack.  Note that there may still be some edge cases left
@@ -98,20 +211,68 @@ void mp_thread_init(void) {
 // garbage collection and tracing these pointers.
 void mp_thread_gc_others(void) {
     pthread_mutex_lock(&thread_mutex);
+    #if MICROPY_GC_PARALLEL_MARK
+    // signal all threads at once so they mark from their stacks in parallel
+    int n_signalled = 0;
     for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (!THREAD_IN_THIS_INTERP(th)) {
+            continue;
+        }
         gc_collect_root(&th->arg, 1);
+    }
+    thread_signal_done = 0;
+    gc_collect_parallel_start();
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (!THREAD_IN_THIS_INTERP(th)) {
+            continue;
+        }
         if (th->id == pthread_self()) {
             continue;
         }
         if (!th->ready) {
             continue;
         }
+        if (mp_thread_gc_claim(th)) {
+            continue;
+        }
+        pthread_kill(th->id, SIGUSR1);
+        n_signalled += 1;
+    }
+    #if MICROPY_PY_THREAD_GC_SAFEPOINTS
+    // scan the parked threads while the others scan themselves
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (th->park == THREAD_SCANNING) {
+            mp_thread_gc_parked(th);
+        }
+    }
+    #endif
+    while (__atomic_load_n(&thread_signal_done, __ATOMIC_SEQ_CST) < n_signalled) {
+        sched_yield();
+    }
+    gc_collect_parallel_end();
+    #else
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (!THREAD_IN_THIS_INTERP(th)) {
+            continue;
+        }
+        gc_collect_root(&th->arg, 1);
+        if (th->id == pthread_self()) {
+            continue;
+        }
+        if (!th->ready) {
+            continue;
+        }
+        if (mp_thread_gc_claim(th)) {
+            mp_thread_gc_parked(th);
+            continue;
+        }
         thread_signal_done = 0;
         pthread_kill(th->id, SIGUSR1);
         while (thread_signal_done == 0) {
             sched_yield();
         }
     }
+    #endif
     pthread_mutex_unlock(&thread_mutex);
 }
 
@@ -134,6 +295,18 @@ void mp_thread_start(void) {
     pthread_mutex_unlock(&thread_mutex);
 }
 
+STATIC void *mp_thread_entry(void *th_in) {
+    thread_t *th = th_in;
+    #if MICROPY_MULTI_INTERP
+    // a new thread runs in the interpreter of the thread that created it
+    mp_state_ctx_ptr = th->ctx;
+    #endif
+    #if MICROPY_PY_THREAD_GC_SAFEPOINTS
+    thread_self = th;
+    #endif
+    return th->entry(th->arg);
+}
+
 void mp_thread_create(void *(*entry)(void*), void *arg, size_t *stack_size) {
     // default stack size is 8k machine-words
     if (*stack_size == 0) {
@@ -156,13 +329,24 @@ void mp_thread_create(void *(*entry)(void*), void *arg, size_t *stack_size) {
         goto er;
     }
 
+    thread_t *th = malloc(sizeof(thread_t));
+    th->ready = 0;
+    th->arg = arg;
+    th->entry = entry;
+    #if MICROPY_MULTI_INTERP
+    th->ctx = &mp_state_ctx;
+    #endif
+    #if MICROPY_PY_THREAD_GC_SAFEPOINTS
+    th->park = THREAD_RUNNING;
+    #endif
+
     pthread_mutex_lock(&thread_mutex);
 
     // create thread
-    pthread_t id;
-    ret = pthread_create(&id, &attr, entry, arg);
+    ret = pthread_create(&th->id, &attr, mp_thread_entry, th);
     if (ret != 0) {
         pthread_mutex_unlock(&thread_mutex);
+        free(th);
         goto er;
     }
 
@@ -171,10 +355,6 @@ void mp_thread_create(void *(*entry)(void*), void *arg, size_t *stack_size) {
     *stack_size -= 8192;
 
     // add thread to linked list of all threads
-    thread_t *th = malloc(sizeof(thread_t));
-    th->id = id;
-    th->ready = 0;
-    th->arg = arg;
     th->next = thread;
     thread = th;
 
@@ -188,16 +368,52 @@ er:
 
 void mp_thread_finish(void) {
     pthread_mutex_lock(&thread_mutex);
-    // TODO unlink from list
-    for (thread_t *th = thread; th != NULL; th = th->next) {
+    for (thread_t **p = &thread; *p != NULL; p = &(*p)->next) {
+        thread_t *th = *p;
         if (th->id == pthread_self()) {
-            th->ready = 0;
+            *p = th->next;
+            free(th);
             break;
         }
     }
+    #if MICROPY_PY_THREAD_GC_SAFEPOINTS
+    thread_self = NULL;
+    #endif
     pthread_mutex_unlock(&thread_mutex);
 }
 
+#if MICROPY_MULTI_INTERP
+// Wait for all other threads of this interpreter to finish, so that its
+// state and heap can go away
+void mp_thread_unix_join_others(void) {
+    for (;;) {
+        bool others = false;
+        pthread_mutex_lock(&thread_mutex);
+        for (thread_t *th = thread; th != NULL; th = th->next) {
+            if (THREAD_IN_THIS_INTERP(th) && th->id != pthread_self()) {
+                others = true;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&thread_mutex);
+        if (!others) {
+            break;
+        }
+        MP_THREAD_GIL_EXIT();
+        mp_hal_delay_ms(1);
+        MP_THREAD_GIL_ENTER();
+    }
+}
+#endif
+
+void mp_thread_unix_begin_atomic_section(void) {
+    pthread_mutex_lock(&atomic_mutex);
+}
+
+void mp_thread_unix_end_atomic_section(void) {
+    pthread_mutex_unlock(&atomic_mutex);
+}
+
 void mp_thread_mutex_init(mp_thread_mutex_t *mutex) {
     pthread_mutex_init(mutex, NULL);
 }
@@ -225,4 +441,41 @@ void mp_thread_mutex_unlock(mp_thread_mutex_t *mutex) {
     // TODO check return value
 }
 
+#if MICROPY_PY_THREAD_SYNC
+
+void mp_thread_cond_init(mp_thread_cond_t *cond) {
+    // use the monotonic clock for timeouts so they aren't upset by changes to the date
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+int mp_thread_cond_wait(mp_thread_cond_t *cond, mp_thread_mutex_t *mutex, mp_int_t timeout_ms) {
+    if (timeout_ms < 0) {
+        pthread_cond_wait(cond, mutex);
+        return 1;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(cond, mutex, &ts) != ETIMEDOUT;
+}
+
+void mp_thread_cond_signal(mp_thread_cond_t *cond) {
+    pthread_cond_signal(cond);
+}
+
+void mp_thread_cond_broadcast(mp_thread_cond_t *cond) {
+    pthread_cond_broadcast(cond);
+}
+
+#endif // MICROPY_PY_THREAD_SYNC
+
 #endif // MICROPY_PY_THREAD
@@ -27,10 +27,15 @@
 #define __MICROPY_INCLUDED_UNIX_MPTHREADPORT_H__
 
 #include <pthread.h>
+#include <sched.h>
 
 typedef pthread_mutex_t mp_thread_mutex_t;
+typedef pthread_cond_t mp_thread_cond_t;
+
+#define MP_THREAD_YIELD() sched_yield()
 
 void mp_thread_init(void);
 void mp_thread_gc_others(void);
+void mp_thread_unix_join_others(void);
 
 #endif // __MICROPY_INCLUDED_UNIX_MPTHREADPORT_H__
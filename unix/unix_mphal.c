@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "py/mpstate.h"
 #include "py/mphal.h"
@@ -57,6 +58,29 @@ STATIC void sighandler(int signum) {
         #endif
     }
 }
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+STATIC void profile_sighandler(int signum) {
+    (void)signum;
+    mp_profile_tick();
+}
+
+void mp_hal_profile_timer(bool enable) {
+    // SIGPROF goes off after each millisecond of CPU time used by the
+    // process, in the thread that is running at the time
+    struct itimerval it = {{0, 0}, {0, 0}};
+    if (enable) {
+        struct sigaction sa;
+        sa.sa_flags = SA_RESTART;
+        sa.sa_handler = profile_sighandler;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGPROF, &sa, NULL);
+        it.it_interval.tv_usec = 1000;
+        it.it_value.tv_usec = 1000;
+    }
+    setitimer(ITIMER_PROF, &it, NULL);
+}
+#endif
 #endif
 
 void mp_hal_set_interrupt_char(char c) {
@@ -159,7 +183,9 @@ int mp_hal_stdin_rx_chr(void) {
     } else {
         main_term:;
 #endif
+        MP_THREAD_GIL_EXIT();
         int ret = read(0, &c, 1);
+        MP_THREAD_GIL_ENTER();
         if (ret == 0) {
             c = 4; // EOF, ctrl-D
         } else if (c == '\n') {
@@ -197,3 +223,17 @@ mp_uint_t mp_hal_ticks_us(void) {
     gettimeofday(&tv, NULL);
     return tv.tv_sec * 1000000 + tv.tv_usec;
 }
+
+mp_uint_t mp_hal_ticks_cpu(void) {
+    #if defined(__i386__) || defined(__x86_64__)
+    // the time stamp counter, which runs at a constant rate on current CPUs
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+    #else
+    // no cycle counter readable from user space, count nanoseconds instead
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (mp_uint_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    #endif
+}